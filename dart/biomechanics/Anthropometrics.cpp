@@ -442,40 +442,175 @@ Anthropometrics::getMarkers(
   return std::make_pair(markerA, markerB);
 }
 
+//==============================================================================
+std::vector<std::pair<
+    std::pair<dynamics::BodyNode*, Eigen::Vector3s>,
+    std::pair<dynamics::BodyNode*, Eigen::Vector3s>>>
+Anthropometrics::getAllMarkers(std::shared_ptr<dynamics::Skeleton> skel)
+{
+  std::vector<std::pair<
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s>,
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s>>>
+      markers;
+  for (int m = 0; m < mMetrics.size(); m++)
+  {
+    markers.emplace_back(
+        std::make_pair(nullptr, Eigen::Vector3s::Zero()),
+        std::make_pair(nullptr, Eigen::Vector3s::Zero()));
+  }
+
+  // This visits the mesh shapes in the same order as getMarkers(), so when
+  // several meshes match a metric the same (last) one wins
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      dynamics::ShapeNode* shapeNode = body->getShapeNode(j);
+      std::shared_ptr<dynamics::Shape> shape = shapeNode->getShape();
+      if (shape->getType() != dynamics::MeshShape::getStaticType())
+        continue;
+
+      dynamics::MeshShape* mesh
+          = static_cast<dynamics::MeshShape*>(shape.get());
+      std::string path = mesh->getMeshPath();
+      int index = path.find_last_of("/");
+      if (index != std::string::npos)
+      {
+        path = path.substr(index + 1);
+      }
+      int dotIndex = path.find_first_of(".");
+      if (dotIndex != std::string::npos)
+      {
+        path = path.substr(0, dotIndex);
+      }
+
+      Eigen::Vector3s bodyScale = body->getScale();
+      Eigen::Vector3s unscaledOffset
+          = shapeNode->getOffset().cwiseQuotient(bodyScale);
+      Eigen::Isometry3s relativeT = Eigen::Isometry3s::Identity();
+      relativeT.linear() = shapeNode->getRelativeRotation();
+      relativeT.translation() = unscaledOffset;
+
+      for (int m = 0; m < mMetrics.size(); m++)
+      {
+        const AnthroMetric& metric = mMetrics[m];
+        if (path.find(metric.meshA) != std::string::npos)
+        {
+          markers[m].first = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
+              body, relativeT * metric.offsetA);
+        }
+        if (path.find(metric.meshB) != std::string::npos)
+        {
+          markers[m].second = std::pair<dynamics::BodyNode*, Eigen::Vector3s>(
+              body, relativeT * metric.offsetB);
+        }
+      }
+    }
+  }
+
+  return markers;
+}
+
 //==============================================================================
 std::map<std::string, s_t> Anthropometrics::measure(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
-  std::map<std::string, s_t> result;
+  const int numMetrics = mMetrics.size();
   Eigen::VectorXs originalPos = skel->getPositions();
-  for (AnthroMetric& metric : mMetrics)
+  auto markers = getAllMarkers(skel);
+
+  // A metric without a BodyPose is measured in whatever pose the last metric
+  // before it left the skeleton in (or the original pose, if none did). This
+  // is the index of the metric whose BodyPose each metric is measured in, or
+  // -1 for the original pose.
+  std::vector<int> poseSource(numMetrics);
+  int lastPose = -1;
+  for (int i = 0; i < numMetrics; i++)
   {
-    setSkelToMetricPose(skel, metric);
-    auto markersPair = getMarkers(skel, metric);
+    if (mMetrics[i].bodyPose.size() != 0)
+      lastPose = i;
+    poseSource[i] = lastPose;
+  }
+  auto samePose = [&](int a, int b) {
+    if (a == -1 || b == -1)
+      return a == b;
+    const Eigen::VectorXs& poseA = mMetrics[a].bodyPose;
+    const Eigen::VectorXs& poseB = mMetrics[b].bodyPose;
+    return poseA.size() == poseB.size() && poseA == poseB;
+  };
+
+  std::vector<s_t> values(numMetrics, 0.0);
+  std::vector<bool> measured(numMetrics, false);
+  for (int i = 0; i < numMetrics; i++)
+  {
+    if (measured[i])
+      continue;
 
-    if (markersPair.first.first == nullptr
-        || markersPair.second.first == nullptr)
+    // Gather every metric measured in the same pose as this one
+    std::vector<int> group;
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> groupMarkers;
+    for (int j = i; j < numMetrics; j++)
     {
-      if (result.count(metric.name) == 0)
+      if (measured[j] || !samePose(poseSource[i], poseSource[j]))
+        continue;
+      measured[j] = true;
+      if (markers[j].first.first == nullptr
+          || markers[j].second.first == nullptr)
+        continue;
+      group.push_back(j);
+      groupMarkers.push_back(markers[j].first);
+      groupMarkers.push_back(markers[j].second);
+    }
+    if (group.size() == 0)
+      continue;
+
+    if (poseSource[i] == -1)
+    {
+      if (skel->getPositions() != originalPos)
       {
-        result[metric.name] = mDist->getMean(metric.name);
+        skel->setPositions(originalPos);
       }
     }
     else
     {
+      setSkelToMetricPose(skel, mMetrics[poseSource[i]]);
+    }
+
+    Eigen::VectorXs worldMarkers = skel->getMarkerWorldPositions(groupMarkers);
+    for (int k = 0; k < group.size(); k++)
+    {
+      const AnthroMetric& metric = mMetrics[group[k]];
+      Eigen::Vector3s diff
+          = worldMarkers.segment<3>(k * 6) - worldMarkers.segment<3>(k * 6 + 3);
       if (metric.axis == Eigen::Vector3s::Zero())
       {
-        result[metric.name] = skel->getDistanceInWorldSpace(
-            markersPair.first, markersPair.second);
+        values[group[k]] = diff.norm();
       }
       else
       {
-        result[metric.name] = skel->getDistanceAlongAxis(
-            markersPair.first, markersPair.second, metric.axis);
+        values[group[k]] = diff.dot(metric.axis);
       }
     }
   }
   skel->setPositions(originalPos);
+
+  std::map<std::string, s_t> result;
+  for (int i = 0; i < numMetrics; i++)
+  {
+    const AnthroMetric& metric = mMetrics[i];
+    if (markers[i].first.first == nullptr || markers[i].second.first == nullptr)
+    {
+      if (result.count(metric.name) == 0)
+      {
+        result[metric.name] = mDist->getMean(metric.name);
+      }
+    }
+    else
+    {
+      result[metric.name] = values[i];
+    }
+  }
   return result;
 }
 
@@ -497,42 +632,32 @@ s_t Anthropometrics::getLogPDF(
 }
 
 //==============================================================================
-Eigen::VectorXs Anthropometrics::getGradientOfLogPDFWrtBodyScales(
-    std::shared_ptr<dynamics::Skeleton> skel)
+Eigen::VectorXs Anthropometrics::getLogPDFBatch(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    const Eigen::MatrixXs& groupScales,
+    bool normalized)
 {
-  Eigen::VectorXs grad = Eigen::VectorXs::Zero(skel->getNumBodyNodes() * 3);
   if (!mDist)
-    return grad;
-
-  std::map<std::string, s_t> gradMap = mDist->convertToMap(
-      mDist->computeLogPDFGrad(mDist->convertFromMap(measure(skel))));
+    return Eigen::VectorXs::Zero(groupScales.cols());
 
-  Eigen::VectorXs originalPos = skel->getPositions();
-  for (AnthroMetric& metric : mMetrics)
+  Eigen::VectorXs originalScales = skel->getGroupScales();
+  Eigen::MatrixXs measurements
+      = Eigen::MatrixXs::Zero(mDist->getMu().size(), groupScales.cols());
+  for (int i = 0; i < groupScales.cols(); i++)
   {
-    setSkelToMetricPose(skel, metric);
-    auto markersPair = getMarkers(skel, metric);
-
-    if (markersPair.first.first != nullptr
-        && markersPair.second.first != nullptr)
-    {
-      if (metric.axis == Eigen::Vector3s::Zero())
-      {
-        grad += gradMap[metric.name]
-                * skel->getGradientOfDistanceWrtBodyScales(
-                    markersPair.first, markersPair.second);
-      }
-      else
-      {
-        grad += gradMap[metric.name]
-                * skel->getGradientOfDistanceAlongAxisWrtBodyScales(
-                    markersPair.first, markersPair.second, metric.axis);
-      }
-    }
+    skel->setGroupScales(groupScales.col(i));
+    measurements.col(i) = mDist->convertFromMap(measure(skel));
   }
-  skel->setPositions(originalPos);
+  skel->setGroupScales(originalScales);
 
-  return grad;
+  return mDist->computeLogPDFBatch(measurements, normalized);
+}
+
+//==============================================================================
+Eigen::VectorXs Anthropometrics::getGradientOfLogPDFWrtBodyScales(
+    std::shared_ptr<dynamics::Skeleton> skel)
+{
+  return getGradientOfLogPDF(skel, false);
 }
 
 //==============================================================================
@@ -568,38 +693,83 @@ Eigen::VectorXs Anthropometrics::finiteDifferenceGradientOfLogPDFWrtBodyScales(
 Eigen::VectorXs Anthropometrics::getGradientOfLogPDFWrtGroupScales(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
-  Eigen::VectorXs grad = Eigen::VectorXs::Zero(skel->getGroupScaleDim());
+  return getGradientOfLogPDF(skel, true);
+}
+
+//==============================================================================
+Eigen::VectorXs Anthropometrics::getGradientOfLogPDF(
+    std::shared_ptr<dynamics::Skeleton> skel, bool wrtGroupScales)
+{
+  Eigen::VectorXs grad = Eigen::VectorXs::Zero(
+      wrtGroupScales ? skel->getGroupScaleDim()
+                     : skel->getNumBodyNodes() * 3);
   if (!mDist)
     return grad;
 
-  std::map<std::string, s_t> gradMap = mDist->convertToMap(
-      mDist->computeLogPDFGrad(mDist->convertFromMap(measure(skel))));
-
+  // This takes the measurements and the gradients of each metric in the same
+  // pass, so each metric only has to pose the skeleton once. The
+  // measurements match measure() exactly.
+  std::map<std::string, s_t> measurements;
+  std::vector<Eigen::VectorXs> metricGrads;
   Eigen::VectorXs originalPos = skel->getPositions();
   for (AnthroMetric& metric : mMetrics)
   {
     setSkelToMetricPose(skel, metric);
-
     auto markersPair = getMarkers(skel, metric);
-    if (markersPair.first.first != nullptr
-        && markersPair.second.first != nullptr)
+
+    if (markersPair.first.first == nullptr
+        || markersPair.second.first == nullptr)
     {
-      if (metric.axis == Eigen::Vector3s::Zero())
+      if (measurements.count(metric.name) == 0)
+      {
+        measurements[metric.name] = mDist->getMean(metric.name);
+      }
+      metricGrads.emplace_back();
+    }
+    else if (metric.axis == Eigen::Vector3s::Zero())
+    {
+      measurements[metric.name] = skel->getDistanceInWorldSpace(
+          markersPair.first, markersPair.second);
+      if (wrtGroupScales)
       {
-        grad += gradMap[metric.name]
-                * skel->getGradientOfDistanceWrtGroupScales(
-                    markersPair.first, markersPair.second);
+        metricGrads.push_back(skel->getGradientOfDistanceWrtGroupScales(
+            markersPair.first, markersPair.second));
       }
       else
       {
-        grad += gradMap[metric.name]
-                * skel->getGradientOfDistanceAlongAxisWrtGroupScales(
-                    markersPair.first, markersPair.second, metric.axis);
+        metricGrads.push_back(skel->getGradientOfDistanceWrtBodyScales(
+            markersPair.first, markersPair.second));
+      }
+    }
+    else
+    {
+      measurements[metric.name] = skel->getDistanceAlongAxis(
+          markersPair.first, markersPair.second, metric.axis);
+      if (wrtGroupScales)
+      {
+        metricGrads.push_back(
+            skel->getGradientOfDistanceAlongAxisWrtGroupScales(
+                markersPair.first, markersPair.second, metric.axis));
+      }
+      else
+      {
+        metricGrads.push_back(skel->getGradientOfDistanceAlongAxisWrtBodyScales(
+            markersPair.first, markersPair.second, metric.axis));
       }
     }
   }
   skel->setPositions(originalPos);
 
+  std::map<std::string, s_t> gradMap = mDist->convertToMap(
+      mDist->computeLogPDFGrad(mDist->convertFromMap(measurements)));
+  for (int i = 0; i < mMetrics.size(); i++)
+  {
+    if (metricGrads[i].size() > 0)
+    {
+      grad += gradMap[mMetrics[i].name] * metricGrads[i];
+    }
+  }
+
   return grad;
 }
 
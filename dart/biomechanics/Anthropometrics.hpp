@@ -78,6 +78,18 @@ public:
       std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
   getMarkers(std::shared_ptr<dynamics::Skeleton> skel, AnthroMetric& metric);
 
+  /// This resolves the markers for every metric, in the same order as the
+  /// metrics, with a single sweep over the skeleton's mesh shapes. Each entry
+  /// matches what getMarkers() returns for that metric.
+  std::vector<std::pair<
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s>,
+      std::pair<dynamics::BodyNode*, Eigen::Vector3s>>>
+  getAllMarkers(std::shared_ptr<dynamics::Skeleton> skel);
+
+  /// This measures every metric on the skeleton. Metrics that are measured in
+  /// the same pose are measured together, so the skeleton only goes through
+  /// forward kinematics once per distinct pose, and all the marker positions
+  /// for that pose are read in one batch.
   std::map<std::string, s_t> measure(std::shared_ptr<dynamics::Skeleton> skel);
 
   s_t getPDF(std::shared_ptr<dynamics::Skeleton> skel);
@@ -85,6 +97,14 @@ public:
   s_t getLogPDF(
       std::shared_ptr<dynamics::Skeleton> skel, bool normalized = true);
 
+  /// This evaluates getLogPDF() for many candidate sets of group scales at
+  /// once, one per column of `groupScales`, with a single batched evaluation
+  /// of the distribution. The skeleton's scales are restored afterwards.
+  Eigen::VectorXs getLogPDFBatch(
+      std::shared_ptr<dynamics::Skeleton> skel,
+      const Eigen::MatrixXs& groupScales,
+      bool normalized = true);
+
   void setSkelToMetricPose(
       std::shared_ptr<dynamics::Skeleton> skel, const AnthroMetric& metric);
 
@@ -101,6 +121,11 @@ public:
       std::shared_ptr<dynamics::Skeleton> skel);
 
 protected:
+  /// This computes the gradient of the log PDF wrt either the group scales or
+  /// the body scales, measuring the skeleton along the way
+  Eigen::VectorXs getGradientOfLogPDF(
+      std::shared_ptr<dynamics::Skeleton> skel, bool wrtGroupScales);
+
   std::vector<AnthroMetric> mMetrics;
   std::shared_ptr<math::MultivariateGaussian> mDist;
 };
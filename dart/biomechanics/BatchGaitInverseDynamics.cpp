@@ -1,5 +1,10 @@
 #include "dart/biomechanics/BatchGaitInverseDynamics.hpp"
 
+#include <algorithm>
+#include <thread>
+
+#include "dart/common/TaskScheduler.hpp"
+
 namespace dart {
 
 namespace biomechanics {
@@ -23,7 +28,8 @@ BatchGaitInverseDynamics::BatchGaitInverseDynamics(
     s_t minTorqueWeight,
     s_t prevContactWeight,
     s_t blendWeight,
-    s_t blendSteepness)
+    s_t blendSteepness,
+    int numThreads)
   : mSkeleton(skeleton),
     mPoses(poses),
     mBodies(groundContactBodies),
@@ -43,7 +49,7 @@ BatchGaitInverseDynamics::BatchGaitInverseDynamics(
   std::vector<const dynamics::BodyNode*> currentContact
       = mLilypad.getContactBodies();
   int startTime = 0;
-  for (int i = 0; i < poses.cols(); i++)
+  for (int i = 0; i < poses.cols() - 1; i++)
   {
     mSkeleton->setPositions(poses.col(i));
     mSkeleton->setVelocities(
@@ -131,21 +137,17 @@ BatchGaitInverseDynamics::BatchGaitInverseDynamics(
     bodyPenalties.push_back(bodyPenalty);
   }
 
-  // Now solve each contact region one at a time
-  for (int i = 0; i < mContactRegimeSections.size(); i++)
-  {
-    std::cout << "Solving section: " << i << "/"
-              << mContactRegimeSections.size() << std::endl;
-    std::cout << "Section band: " << mContactRegimeSections[i].startTime << "-"
-              << mContactRegimeSections[i].endTime << ": "
-              << mContactRegimeSections[i].groundContactBodies.size()
-              << " contacts" << std::endl;
-
+  // The first section never had wrenches to continue from, and that zeroed
+  // out `prevContactWeight` for every section after it too, so each section
+  // only depends on the poses. That lets us solve them all at once.
+  auto solveSection = [&](dynamics::Skeleton* skel, int i) {
     ContactRegimeSection& section = mContactRegimeSections[i];
 
     Eigen::MatrixXs bodyPenaltyWeights = Eigen::MatrixXs::Zero(
         section.groundContactBodies.size(),
         (section.endTime - section.startTime) + 1);
+    // The clones have the same bodies as we do, in the same order
+    std::vector<const dynamics::BodyNode*> sectionBodies;
     for (int j = 0; j < section.groundContactBodies.size(); j++)
     {
       const dynamics::BodyNode* bodyNode = section.groundContactBodies[j];
@@ -157,42 +159,8 @@ BatchGaitInverseDynamics::BatchGaitInverseDynamics(
               bodyNode));
       bodyPenaltyWeights.row(j) = bodyPenalties[index].segment(
           section.startTime, section.endTime + 1 - section.startTime);
-    }
-
-    std::vector<Eigen::Vector6s> prevContactForces;
-    std::vector<const dynamics::BodyNode*> lastBodyNodes;
-
-    if (i > 0)
-    {
-      lastBodyNodes = mContactRegimeSections[i - 1].groundContactBodies;
-      std::vector<Eigen::Vector6s> lastContactForces
-          = mContactRegimeSections[i - 1]
-                .wrenches[mContactRegimeSections[i - 1].wrenches.size() - 1];
-
-      for (const dynamics::BodyNode* bodyNode :
-           mContactRegimeSections[i].groundContactBodies)
-      {
-        auto iterator
-            = find(lastBodyNodes.begin(), lastBodyNodes.end(), bodyNode);
-        // If the body node didn't exist in the last timestep, default to zero
-        // force
-        if (iterator == lastBodyNodes.end())
-        {
-          prevContactForces.push_back(Eigen::Vector6s::Zero());
-        }
-        else
-        {
-          // calculating the index
-          // of K
-          int index = iterator - lastBodyNodes.begin();
-          prevContactForces.push_back(lastContactForces[index]);
-        }
-      }
-    }
-    else
-    {
-      prevContactWeight = 0.0;
-      lastBodyNodes = section.groundContactBodies;
+      sectionBodies.push_back(
+          skel->getBodyNode(bodyNode->getIndexInSkeleton()));
     }
 
     int blockWidth = (section.endTime - section.startTime)
@@ -219,21 +187,59 @@ BatchGaitInverseDynamics::BatchGaitInverseDynamics(
     }
     else
     {
-      section.wrenches
-          = mSkeleton
-                ->getMultipleContactInverseDynamicsOverTime(
-                    poses.block(
-                        0, section.startTime, poses.rows(), 1 + blockWidth),
-                    section.groundContactBodies,
-                    smoothingWeight,
-                    minTorqueWeight,
-                    [](s_t /* vel */) {
-                      return 0.0; // No velocity penalty
-                    },
-                    prevContactForces,
-                    prevContactWeight,
-                    bodyPenaltyWeights)
-                .contactWrenches;
+      section.wrenches = skel->getMultipleContactInverseDynamicsOverTime(
+                                 poses.block(
+                                     0,
+                                     section.startTime,
+                                     poses.rows(),
+                                     1 + blockWidth),
+                                 sectionBodies,
+                                 smoothingWeight,
+                                 minTorqueWeight,
+                                 [](s_t /* vel */) {
+                                   return 0.0; // No velocity penalty
+                                 },
+                                 std::vector<Eigen::Vector6s>(),
+                                 0.0,
+                                 bodyPenaltyWeights)
+                             .contactWrenches;
+    }
+  };
+
+  const int numSections = mContactRegimeSections.size();
+  if (numThreads <= 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  numThreads = std::max(1, std::min(numThreads, numSections));
+
+  if (numThreads == 1)
+  {
+    for (int i = 0; i < numSections; i++)
+    {
+      solveSection(mSkeleton.get(), i);
+    }
+  }
+  else
+  {
+    // Each thread gets its own copy of the skeleton to set poses on, and a
+    // contiguous range of sections to write into
+    std::vector<std::shared_ptr<dynamics::Skeleton>> clones;
+    std::vector<common::TaskFuture<void>> futures;
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+      const int start = (numSections * threadIdx) / numThreads;
+      const int end = (numSections * (threadIdx + 1)) / numThreads;
+      clones.push_back(mSkeleton->cloneSkeleton());
+      dynamics::Skeleton* clone = clones.back().get();
+      futures.push_back(common::async([&solveSection, clone, start, end] {
+        for (int i = start; i < end; i++)
+        {
+          solveSection(clone, i);
+        }
+      }));
+    }
+    for (auto& future : futures)
+    {
+      future.get();
     }
   }
   std::cout << "Done all sections!" << std::endl;
@@ -250,6 +256,11 @@ int BatchGaitInverseDynamics::numTimesteps()
   return mPoses.cols() - 2;
 }
 
+int BatchGaitInverseDynamics::numContactBodies()
+{
+  return mBodies.size();
+}
+
 ContactRegimeSection& BatchGaitInverseDynamics::getSectionForTimestep(
     int timestep)
 {
@@ -278,6 +289,41 @@ BatchGaitInverseDynamics::getContactWrenchesAtTimestep(int timestep)
   return section.wrenches[offset];
 }
 
+void BatchGaitInverseDynamics::getContactWrenchesAtTimestepInto(
+    int timestep, Eigen::Ref<Eigen::MatrixXs> wrenches)
+{
+  assert(wrenches.rows() == 6 && wrenches.cols() == mBodies.size());
+  wrenches.setZero();
+  ContactRegimeSection& section = getSectionForTimestep(timestep);
+  const std::vector<Eigen::Vector6s>& sectionWrenches
+      = section.wrenches[timestep - section.startTime];
+  for (int i = 0; i < section.groundContactBodies.size(); i++)
+  {
+    int index = std::distance(
+        mBodies.begin(),
+        std::find(
+            mBodies.begin(), mBodies.end(), section.groundContactBodies[i]));
+    wrenches.col(index) = sectionWrenches[i];
+  }
+}
+
+void BatchGaitInverseDynamics::getContactWrenchesInto(
+    Eigen::Ref<Eigen::MatrixXs> wrenches)
+{
+  assert(
+      wrenches.rows() == 6 * mBodies.size()
+      && wrenches.cols() == numTimesteps());
+  Eigen::MatrixXs timestepWrenches = Eigen::MatrixXs::Zero(6, mBodies.size());
+  for (int t = 0; t < numTimesteps(); t++)
+  {
+    getContactWrenchesAtTimestepInto(t, timestepWrenches);
+    for (int i = 0; i < mBodies.size(); i++)
+    {
+      wrenches.block<6, 1>(i * 6, t) = timestepWrenches.col(i);
+    }
+  }
+}
+
 /// This will debug all the processed data over to our GUI, so we can see the
 /// contact forces and positions animated
 void BatchGaitInverseDynamics::debugLilypadToGUI(
@@ -37,6 +37,11 @@ class BatchGaitInverseDynamics
 public:
   /// This will attempt to create the best possible trajectory. The result of
   /// the computation will be stored internally in the object.
+  ///
+  /// Each contact regime section is solved on its own, spread across
+  /// `numThreads` threads (or one per core, if that's 0 or less). Sections
+  /// don't carry their wrenches over into the next one, so
+  /// `prevContactWeight` is unused.
   BatchGaitInverseDynamics(
       std::shared_ptr<dynamics::Skeleton> skeleton,
       Eigen::MatrixXs poses,
@@ -48,10 +53,13 @@ public:
       s_t minTorqueWeight = 1.0,
       s_t prevContactWeight = 0.1,
       s_t blendWeight = 1.0,
-      s_t blendSteepness = 10.0);
+      s_t blendSteepness = 10.0,
+      int numThreads = 1);
 
   int numTimesteps();
 
+  int numContactBodies();
+
   ContactRegimeSection& getSectionForTimestep(int timestep);
 
   std::vector<const dynamics::BodyNode*> getContactBodiesAtTimestep(
@@ -59,6 +67,17 @@ public:
 
   std::vector<Eigen::Vector6s> getContactWrenchesAtTimestep(int timestep);
 
+  /// This writes the wrench on every ground contact body at `timestep` into a
+  /// 6 x (number of ground contact bodies) matrix, in the order the bodies
+  /// were passed to the constructor. Bodies out of contact get zeros.
+  void getContactWrenchesAtTimestepInto(
+      int timestep, Eigen::Ref<Eigen::MatrixXs> wrenches);
+
+  /// This writes the wrenches for the whole trajectory into a (6 * number of
+  /// ground contact bodies) x numTimesteps() matrix, stacking the columns of
+  /// getContactWrenchesAtTimestepInto() for each timestep.
+  void getContactWrenchesInto(Eigen::Ref<Eigen::MatrixXs> wrenches);
+
   /// This will debug all the processed data over to our GUI, so we can see the
   /// contact forces and positions animated
   void debugLilypadToGUI(std::shared_ptr<server::GUIWebsocketServer> server);
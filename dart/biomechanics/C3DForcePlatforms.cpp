@@ -7,6 +7,8 @@
 
 #include "dart/biomechanics/C3DForcePlatforms.hpp"
 
+#include <algorithm>
+
 #include <ezc3d_all.h>
 
 namespace dart {
@@ -15,11 +17,42 @@ namespace biomechanics {
 
 const extern int FORCE_PLATFORM_NUM_CONVENTIONS = 2;
 
+namespace {
+
+/// This takes the cross product of each row of `a` with the matching row of
+/// `b`
+math::Vector3Batch crossRows(
+    const math::Vector3Batch& a, const math::Vector3Batch& b)
+{
+  math::Vector3Batch result(a.rows(), 3);
+  result.col(0)
+      = a.col(1).cwiseProduct(b.col(2)) - a.col(2).cwiseProduct(b.col(1));
+  result.col(1)
+      = a.col(2).cwiseProduct(b.col(0)) - a.col(0).cwiseProduct(b.col(2));
+  result.col(2)
+      = a.col(0).cwiseProduct(b.col(1)) - a.col(1).cwiseProduct(b.col(0));
+  return result;
+}
+
+/// This takes the cross product of each row of `a` with `b`
+math::Vector3Batch crossRows(
+    const math::Vector3Batch& a, const Eigen::Vector3s& b)
+{
+  math::Vector3Batch result(a.rows(), 3);
+  result.col(0) = a.col(1) * b(2) - a.col(2) * b(1);
+  result.col(1) = a.col(2) * b(0) - a.col(0) * b(2);
+  result.col(2) = a.col(0) * b(1) - a.col(1) * b(0);
+  return result;
+}
+
+} // namespace
+
 ForcePlatform::ForcePlatform()
 {
 }
 
-ForcePlatform::ForcePlatform(size_t idx, const ezc3d::c3d& c3d, int convention)
+ForcePlatform::ForcePlatform(
+    size_t idx, const ezc3d::c3d& c3d, int convention, size_t downsample)
 {
   _meanCorners.setZero();
   _origin.setZero();
@@ -32,7 +65,8 @@ ForcePlatform::ForcePlatform(size_t idx, const ezc3d::c3d& c3d, int convention)
   extractOrigin(idx, c3d);
   extractCalMatrix(idx, c3d);
   computePfReferenceFrame();
-  extractDataWithConvention(idx, c3d, convention);
+  extractDataWithConvention(
+      idx, c3d, convention, std::max<size_t>(1, downsample));
 }
 
 const std::string& ForcePlatform::forceUnit() const
@@ -87,7 +121,7 @@ void ForcePlatform::extractUnits(const ezc3d::c3d& c3d)
 
 size_t ForcePlatform::nbFrames() const
 {
-  return _F.size();
+  return _F.rows();
 }
 
 size_t ForcePlatform::type() const
@@ -115,22 +149,22 @@ const Eigen::Vector3s& ForcePlatform::origin() const
   return _origin;
 }
 
-const std::vector<Eigen::Vector3s>& ForcePlatform::forces() const
+const math::Vector3Batch& ForcePlatform::forces() const
 {
   return _F;
 }
 
-const std::vector<Eigen::Vector3s>& ForcePlatform::moments() const
+const math::Vector3Batch& ForcePlatform::moments() const
 {
   return _M;
 }
 
-const std::vector<Eigen::Vector3s>& ForcePlatform::CoP() const
+const math::Vector3Batch& ForcePlatform::CoP() const
 {
   return _CoP;
 }
 
-const std::vector<Eigen::Vector3s>& ForcePlatform::Tz() const
+const math::Vector3Batch& ForcePlatform::Tz() const
 {
   return _Tz;
 }
@@ -197,7 +231,8 @@ void ForcePlatform::extractType(size_t idx, const ezc3d::c3d& c3d)
   }
 }
 
-ForcePlatforms::ForcePlatforms(const ezc3d::c3d& c3d, int convention)
+ForcePlatforms::ForcePlatforms(
+    const ezc3d::c3d& c3d, int convention, size_t downsample)
 {
   size_t nbForcePF(c3d.parameters()
                        .group("FORCE_PLATFORM")
@@ -205,7 +240,7 @@ ForcePlatforms::ForcePlatforms(const ezc3d::c3d& c3d, int convention)
                        .valuesAsInt()[0]);
   for (size_t i = 0; i < nbForcePF; ++i)
   {
-    _platforms.push_back(ForcePlatform(i, c3d, convention));
+    _platforms.push_back(ForcePlatform(i, c3d, convention, downsample));
   }
 }
 
@@ -352,7 +387,7 @@ void ForcePlatform::computePfReferenceFrame()
 }
 
 void ForcePlatform::extractDataWithConvention(
-    size_t idx, const ezc3d::c3d& c3d, int convention)
+    size_t idx, const ezc3d::c3d& c3d, int convention, size_t downsample)
 {
   assert(convention >= 0 && convention <= 1);
 
@@ -399,112 +434,113 @@ void ForcePlatform::extractDataWithConvention(
     channel_idx[i] = all_channel_idx[idx * dimensions[0] + i] - 1; // 1-based
   }
 
-  // Get the force and moment from these channel in global reference frame
+  // Copy the channels we need into one [frames x channels] matrix, keeping
+  // only every `downsample`-th analog subframe
   size_t nFramesTotal(c3d.header().nbFrames() * c3d.header().nbAnalogByFrame());
-  _F.resize(nFramesTotal);
-  _M.resize(nFramesTotal);
-  _CoP.resize(nFramesTotal);
-  _Tz.resize(nFramesTotal);
+  Eigen::MatrixXs raw = Eigen::MatrixXs::Zero(
+      (nFramesTotal + downsample - 1) / downsample, nChannels);
   size_t cmp(0);
-  double* ch = new double[8];
+  Eigen::Index row(0);
   for (const auto& frame : c3d.data().frames())
   {
-    for (size_t i = 0; i < frame.analogs().nbSubframes(); ++i)
+    for (size_t i = 0; i < frame.analogs().nbSubframes(); ++i, ++cmp)
     {
+      if (cmp % downsample != 0 || row >= raw.rows())
+      {
+        continue;
+      }
       const auto& subframe(frame.analogs().subframe(i));
-      if (_type == 1)
+      for (size_t j = 0; j < nChannels; ++j)
+      {
+        raw(row, j) = subframe.channel(channel_idx[j]).data();
+      }
+      ++row;
+    }
+  }
+
+  // Get the force and moment from these channels in global reference frame
+  processAnalogs(raw.topRows(row), convention);
+}
+
+void ForcePlatform::processAnalogs(
+    const Eigen::Ref<const Eigen::MatrixXs>& raw, int convention)
+{
+  const Eigen::Index nFrames = raw.rows();
+  // Each row is a frame, so transforming every frame by _refFrame is a
+  // multiply on the right by its transpose
+  const Eigen::Matrix3s refFrameT = _refFrame.transpose();
+  if (_type == 1)
+  {
+    // CalMatrix (the example I have does not have any)
+    math::Vector3Batch cop_raw = math::Vector3Batch::Zero(nFrames, 3);
+    cop_raw.leftCols<2>() = raw.middleCols<2>(3);
+    math::Vector3Batch tz_raw = math::Vector3Batch::Zero(nFrames, 3);
+    tz_raw.col(2) = raw.col(5);
+
+    _F.noalias() = raw.leftCols<3>() * refFrameT;
+    _CoP.noalias() = cop_raw * refFrameT;
+    _Tz.noalias() = tz_raw * refFrameT;
+    _M = crossRows(_F, _CoP) - _Tz;
+    _CoP.rowwise() += _meanCorners.transpose();
+  }
+  else if (_type == 2 || _type == 3 || _type == 4)
+  {
+    math::Vector3Batch force_raw(nFrames, 3);
+    math::Vector3Batch moment_raw(nFrames, 3);
+    if (_type == 3)
+    {
+      // CalMatrix (the example I have does not have any)
+      force_raw.col(0) = raw.col(0) + raw.col(1);
+      force_raw.col(1) = raw.col(2) + raw.col(3);
+      force_raw.col(2) = raw.col(4) + raw.col(5) + raw.col(6) + raw.col(7);
+
+      moment_raw.col(0)
+          = _origin(1) * (raw.col(4) + raw.col(5) - raw.col(6) - raw.col(7));
+      moment_raw.col(1)
+          = _origin(0) * (raw.col(5) + raw.col(6) - raw.col(4) - raw.col(7));
+      moment_raw.col(2) = _origin(1) * (raw.col(1) - raw.col(0))
+                          + _origin(0) * (raw.col(2) - raw.col(3));
+      moment_raw += crossRows(force_raw, Eigen::Vector3s(0, 0, _origin(2)));
+    }
+    else
+    {
+      if (_type == 4)
       {
-        Eigen::Vector3s force_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s cop_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s tz_raw = Eigen::Vector3s::Zero();
-        // CalMatrix (the example I have does not have any)
-
-        for (size_t j = 0; j < 3; ++j)
-        {
-          force_raw(j) = subframe.channel(channel_idx[j]).data();
-          if (j < 2)
-          {
-            cop_raw(j) = subframe.channel(channel_idx[j + 3]).data();
-          }
-          else
-          {
-            tz_raw(j) = subframe.channel(channel_idx[j + 3]).data();
-          }
-        }
-
-        _F[cmp] = _refFrame * force_raw;
-        _CoP[cmp] = _refFrame * cop_raw;
-        _Tz[cmp] = _refFrame * tz_raw;
-        _M[cmp] = _F[cmp].cross(_CoP[cmp]) - _Tz[cmp];
-        _CoP[cmp] += _meanCorners;
-
-        ++cmp;
+        const Eigen::MatrixXs data_raw
+            = raw.leftCols<6>() * _calMatrix.transpose();
+        force_raw = data_raw.leftCols<3>();
+        moment_raw = data_raw.middleCols<3>(3);
       }
-      else if (_type == 2 || _type == 3 || _type == 4)
+      else
       {
-        Eigen::Vector3s force_raw = Eigen::Vector3s::Zero();
-        Eigen::Vector3s moment_raw = Eigen::Vector3s::Zero();
-        if (_type == 3)
-        {
-          for (size_t j = 0; j < 8; ++j)
-          {
-            ch[j] = subframe.channel(channel_idx[j]).data();
-          }
-          // CalMatrix (the example I have does not have any)
-
-          force_raw(0) = ch[0] + ch[1];
-          force_raw(1) = ch[2] + ch[3];
-          force_raw(2) = ch[4] + ch[5] + ch[6] + ch[7];
-
-          moment_raw(0) = _origin(1) * (ch[4] + ch[5] - ch[6] - ch[7]);
-          moment_raw(1) = _origin(0) * (ch[5] + ch[6] - ch[4] - ch[7]);
-          moment_raw(2)
-              = _origin(1) * (ch[1] - ch[0]) + _origin(0) * (ch[2] - ch[3]);
-          moment_raw += force_raw.cross(Eigen::Vector3s(0, 0, _origin(2)));
-        }
-        else
-        {
-          Eigen::Vector6s data_raw = Eigen::Vector6s::Zero();
-          for (size_t j = 0; j < 3; ++j)
-          {
-            data_raw(j) = subframe.channel(channel_idx[j]).data();
-            data_raw(j + 3) = subframe.channel(channel_idx[j + 3]).data();
-          }
-          if (_type == 4)
-          {
-            data_raw = _calMatrix * data_raw;
-          }
-          for (size_t j = 0; j < 3; ++j)
-          {
-            force_raw(j) = data_raw(j);
-            moment_raw(j) = data_raw(j + 3);
-          }
-          if (convention == 1)
-          {
-            moment_raw += force_raw.cross(_origin);
-          }
-        }
-        _F[cmp] = _refFrame * force_raw;
-        _M[cmp] = _refFrame * moment_raw;
-
-        Eigen::Vector3s CoP_raw = Eigen::Vector3s(
-            -moment_raw(1) / force_raw(2), moment_raw(0) / force_raw(2), 0);
-        Eigen::Vector3s originNoVertical = _origin;
-        originNoVertical(2) = 0.0;
-        if (convention == 0)
-        {
-          _CoP[cmp] = _refFrame * (CoP_raw + originNoVertical) + _meanCorners;
-        }
-        if (convention == 1)
-        {
-          _CoP[cmp] = _refFrame * CoP_raw + _meanCorners;
-        }
-        _Tz[cmp] = _refFrame * (moment_raw - force_raw.cross(-1 * CoP_raw));
-        ++cmp;
+        force_raw = raw.leftCols<3>();
+        moment_raw = raw.middleCols<3>(3);
       }
+      if (convention == 1)
+      {
+        moment_raw += crossRows(force_raw, _origin);
+      }
+    }
+    _F.noalias() = force_raw * refFrameT;
+    _M.noalias() = moment_raw * refFrameT;
+
+    math::Vector3Batch CoP_raw = math::Vector3Batch::Zero(nFrames, 3);
+    CoP_raw.col(0) = -moment_raw.col(1).cwiseQuotient(force_raw.col(2));
+    CoP_raw.col(1) = moment_raw.col(0).cwiseQuotient(force_raw.col(2));
+    Eigen::Vector3s originNoVertical = _origin;
+    originNoVertical(2) = 0.0;
+    if (convention == 0)
+    {
+      _CoP.noalias()
+          = (CoP_raw.rowwise() + originNoVertical.transpose()) * refFrameT;
+    }
+    else
+    {
+      _CoP.noalias() = CoP_raw * refFrameT;
     }
+    _CoP.rowwise() += _meanCorners.transpose();
+    _Tz.noalias() = (moment_raw + crossRows(force_raw, CoP_raw)) * refFrameT;
   }
-  delete[] ch;
 }
 
 const std::vector<ForcePlatform>& ForcePlatforms::forcePlatforms() const
@@ -41,8 +41,11 @@ public:
   /// \param c3d A reference to the c3d class
   /// \param method A number referring to the type of method used to resolve the
   /// GRF data frames, between 0 and FORCE_PLATFORM_NUM_METHODS-1
+  /// \param downsample Keep only every `downsample`-th analog subframe. Pass
+  /// the number of analog subframes per frame to get data at the marker rate.
   ///
-  ForcePlatform(size_t idx, const ezc3d::c3d& c3d, int convention);
+  ForcePlatform(
+      size_t idx, const ezc3d::c3d& c3d, int convention, size_t downsample = 1);
 
   //---- UNITS ----//
 protected:
@@ -88,18 +91,18 @@ protected:
   Eigen::Vector3s _origin;   ///< Position of the origin of the force platform
   Eigen::Matrix3s _refFrame; ///< The reference frame of the force plate in the
                              ///< global reference frame
-  std::vector<Eigen::Vector3s>
+  math::Vector3Batch
       _F; ///< Force vectors for all instants (including subframes) in global
-          ///< reference frame
-  std::vector<Eigen::Vector3s>
+          ///< reference frame, one row per instant
+  math::Vector3Batch
       _M; ///< Moment vectors for all instants (including subframes) in global
-          ///< reference frame
-  std::vector<Eigen::Vector3s>
+          ///< reference frame, one row per instant
+  math::Vector3Batch
       _CoP; ///< Center of Pressure vectors for all instants (including
-            ///< subframes) in global reference frame
-  std::vector<Eigen::Vector3s>
+            ///< subframes) in global reference frame, one row per instant
+  math::Vector3Batch
       _Tz; ///< Moment [0, 0, Tz] vectors for all instants (including subframes)
-           ///< expressed at the CoP
+           ///< expressed at the CoP, one row per instant
 
 public:
   ///
@@ -143,28 +146,28 @@ public:
   /// frame \return The force vectors at each frame in the global reference
   /// frame
   ///
-  const std::vector<Eigen::Vector3s>& forces() const;
+  const math::Vector3Batch& forces() const;
 
   ///
   /// \brief Returns the moment vectors at each frame in the global reference
   /// frame at origin \return The moment vectors at each frame in the global
   /// reference frame at origin
   ///
-  const std::vector<Eigen::Vector3s>& moments() const;
+  const math::Vector3Batch& moments() const;
 
   ///
   /// \brief Returns the center of pressure at each frame in the global
   /// reference frame \return The center of pressure at each frame in the global
   /// reference frame at origin
   ///
-  const std::vector<Eigen::Vector3s>& CoP() const;
+  const math::Vector3Batch& CoP() const;
 
   ///
   /// \brief Returns the moments at each frame in the global reference frame at
   /// center of pressure \return The moments at each frame in the global
   /// reference frame at center of pressure
   ///
-  const std::vector<Eigen::Vector3s>& Tz() const;
+  const math::Vector3Batch& Tz() const;
 
 protected:
   ///
@@ -205,8 +208,19 @@ protected:
   /// \brief Extract the platform data from the c3d
   /// \param idx Index of the platform
   /// \param c3d A reference to the c3d
+  /// \param downsample Keep only every `downsample`-th analog subframe
+  ///
+  void extractDataWithConvention(
+      size_t idx, const ezc3d::c3d& c3d, int method, size_t downsample);
+
+  ///
+  /// \brief Convert the raw analog channels of the platform into forces,
+  /// moments and centers of pressure, for every frame at once
+  /// \param raw The channels of the platform, one row per frame
+  /// \param convention The method used to resolve the GRF data frames
   ///
-  void extractDataWithConvention(size_t idx, const ezc3d::c3d& c3d, int method);
+  void processAnalogs(
+      const Eigen::Ref<const Eigen::MatrixXs>& raw, int convention);
 };
 
 ///
@@ -220,8 +234,9 @@ public:
   /// \brief Declare a ForcePlatForm analyse holder
   /// \param method A number referring to the type of method used to resolve the
   /// GRF data frames, between 0 and FORCE_PLATFORM_NUM_METHODS-1
+  /// \param downsample Keep only every `downsample`-th analog subframe
   ///
-  ForcePlatforms(const ezc3d::c3d& c3d, int method);
+  ForcePlatforms(const ezc3d::c3d& c3d, int method, size_t downsample = 1);
 
   //---- DATA ----//
 private:
@@ -1,11 +1,14 @@
 #include "dart/biomechanics/C3DLoader.hpp"
 
 #include <algorithm> // std::sort
+#include <atomic>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <random>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -126,6 +129,47 @@ C3D C3DLoader::loadC3D(const std::string& uri)
   return bestResult;
 }
 
+//==============================================================================
+std::vector<C3D> C3DLoader::loadC3DBatch(
+    const std::vector<std::string>& uris, int numThreads, bool fixupFlips)
+{
+  std::vector<C3D> results(uris.size());
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)uris.size()));
+
+  // Files vary a lot in size, so rather than splitting the list up front,
+  // each thread just grabs the next file nobody has started on yet
+  std::atomic<int> nextFile(0);
+  std::vector<std::future<void>> futures;
+  for (int t = 0; t < numThreads; t++)
+  {
+    futures.push_back(std::async(
+        std::launch::async, [&uris, &results, &nextFile, fixupFlips]() {
+          while (true)
+          {
+            const int i = nextFile++;
+            if (i >= uris.size())
+            {
+              return;
+            }
+            results[i] = loadC3D(uris[i]);
+            if (fixupFlips)
+            {
+              fixupMarkerFlips(&results[i]);
+            }
+          }
+        }));
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+  return results;
+}
+
 //==============================================================================
 C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
 {
@@ -201,7 +245,9 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
   }
 
   // Load in the force platforms
-  ForcePlatforms pf(data, convention);
+  // We only read the analogs at the start of each marker frame, so there's no
+  // need to process the rest
+  ForcePlatforms pf(data, convention, std::max(1, analogFramesPerFrame));
   const std::vector<ForcePlatform>& forcePlatforms = pf.forcePlatforms();
 
   // Force plate data
@@ -344,13 +390,16 @@ C3D C3DLoader::loadC3DWithGRFConvention(const std::string& uri, int convention)
     std::vector<Eigen::Vector9s> thisFrameGRFs;
     for (int j = 0; j < forcePlatforms.size(); j++)
     {
-      int frame = analogFramesPerFrame * (t + startFrame);
+      int frame = t + startFrame;
       result.forcePlates[j].forces.push_back(
-          forcePlatforms[j].forces()[frame] * forcePlateForceScaleFactors[j]);
+          forcePlatforms[j].forces().row(frame).transpose()
+          * forcePlateForceScaleFactors[j]);
       result.forcePlates[j].moments.push_back(
-          forcePlatforms[j].Tz()[frame] * forcePlateMomentScaleFactors[j]);
+          forcePlatforms[j].Tz().row(frame).transpose()
+          * forcePlateMomentScaleFactors[j]);
       result.forcePlates[j].centersOfPressure.push_back(
-          forcePlatforms[j].CoP()[frame] * forcePlatePositionScaleFactors[j]);
+          forcePlatforms[j].CoP().row(frame).transpose()
+          * forcePlatePositionScaleFactors[j]);
     }
   }
 
@@ -43,6 +43,17 @@ public:
 
   static C3D loadC3DWithGRFConvention(const std::string& uri, int convention);
 
+  /// This loads a whole list of C3D files at once, spread across
+  /// `numThreads` threads (values <= 0 mean use all the hardware threads).
+  /// If `fixupFlips` is true, this also runs fixupMarkerFlips() on each file
+  /// on the same thread that loaded it. The results come back in the same
+  /// order as `uris`, and their `markerTimesteps` can be passed straight to
+  /// MarkerFitter::runMultiTrialKinematicsPipeline().
+  static std::vector<C3D> loadC3DBatch(
+      const std::vector<std::string>& uris,
+      int numThreads = -1,
+      bool fixupFlips = true);
+
   /// This will check if markers
   /// obviously "flip" during the trajectory, and unflip them.
   static void fixupMarkerFlips(C3D* c3d);
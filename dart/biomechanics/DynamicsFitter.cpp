@@ -1,13 +1,13 @@
 #include "dart/biomechanics/DynamicsFitter.hpp"
 
 #include <algorithm>
-#include <future>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <ostream>
 #include <queue>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -26,6 +26,7 @@
 #include "dart/biomechanics/MarkerLabeller.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
 #include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/EulerFreeJoint.hpp"
 #include "dart/dynamics/EulerJoint.hpp"
@@ -33,6 +34,7 @@
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/AssignmentMatcher.hpp"
+#include "dart/math/CrossCorrelation.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
@@ -41,6 +43,7 @@
 #include "dart/server/GUIRecording.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/utils/AccelerationSmoother.hpp"
+#include "dart/utils/BufferedWriter.hpp"
 #include "dart/utils/VelocityMinimizingSmoother.hpp"
 
 namespace dart {
@@ -59,6 +62,27 @@ ResidualForceHelper::ResidualForceHelper(
   }
 }
 
+//==============================================================================
+void ResidualForceHelper::prepareThreadSkels(int numThreads)
+{
+  for (int threadIdx = mThreadSkels.size(); threadIdx < numThreads; threadIdx++)
+  {
+    mThreadSkels.push_back(mSkel->cloneSkeleton());
+  }
+  for (int threadIdx = mThreadHelpers.size(); threadIdx < numThreads;
+       threadIdx++)
+  {
+    mThreadHelpers.emplace_back(mThreadSkels[threadIdx], mForceBodies);
+  }
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    mThreadSkels[threadIdx]->setGroupScales(mSkel->getGroupScales());
+    mThreadSkels[threadIdx]->setGroupCOMs(mSkel->getGroupCOMs());
+    mThreadSkels[threadIdx]->setGroupMasses(mSkel->getGroupMasses());
+    mThreadSkels[threadIdx]->setGroupInertias(mSkel->getGroupInertias());
+  }
+}
+
 //==============================================================================
 // Computes the full inverse dynamics vector for a specific timestep
 Eigen::VectorXs ResidualForceHelper::calculateInverseDynamics(
@@ -353,6 +377,195 @@ Eigen::VectorXs ResidualForceHelper::calculateResidualNormGradientWrt(
   }
 }
 
+//==============================================================================
+// Computes the residuals for a whole trajectory in one pass, and optionally
+// their Jacobians and norm gradients wrt q, dq and ddq.
+ResidualTrajectory ResidualForceHelper::calculateResidualTrajectory(
+    Eigen::MatrixXs qs,
+    Eigen::MatrixXs dqs,
+    Eigen::MatrixXs ddqs,
+    Eigen::MatrixXs forces,
+    s_t torquesMultiple,
+    bool useL1,
+    bool computeJacobians,
+    int numThreads)
+{
+  const int dofs = mSkel->getNumDofs();
+  const int numTimesteps = qs.cols();
+
+  ResidualTrajectory result;
+  result.taus = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+  result.residuals = Eigen::MatrixXs::Zero(6, numTimesteps);
+  result.residualNorms = Eigen::VectorXs::Zero(numTimesteps);
+  if (computeJacobians)
+  {
+    result.residualJacobiansWrtPos
+        = Eigen::MatrixXs::Zero(6, dofs * numTimesteps);
+    result.residualJacobiansWrtVel
+        = Eigen::MatrixXs::Zero(6, dofs * numTimesteps);
+    result.residualJacobiansWrtAcc
+        = Eigen::MatrixXs::Zero(6, dofs * numTimesteps);
+    result.residualNormGradientsWrtPos
+        = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+    result.residualNormGradientsWrtVel
+        = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+    result.residualNormGradientsWrtAcc
+        = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+  }
+
+  if (numThreads <= 1)
+  {
+    Eigen::VectorXs originalPos = mSkel->getPositions();
+    Eigen::VectorXs originalVel = mSkel->getVelocities();
+    Eigen::VectorXs originalAcc = mSkel->getAccelerations();
+
+    for (int t = 0; t < numTimesteps; t++)
+    {
+      fillResidualTrajectoryTimestep(
+          result,
+          t,
+          qs.col(t),
+          dqs.col(t),
+          ddqs.col(t),
+          forces.col(t),
+          torquesMultiple,
+          useL1,
+          computeJacobians);
+    }
+
+    mSkel->setPositions(originalPos);
+    mSkel->setVelocities(originalVel);
+    mSkel->setAccelerations(originalAcc);
+    return result;
+  }
+
+  // Every timestep writes its own columns of `result`, so the threads never
+  // touch the same memory
+  prepareThreadSkels(numThreads);
+  std::vector<common::TaskFuture<void>> futures;
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    futures.push_back(common::async([threadIdx,
+                                     numTimesteps,
+                                     numThreads,
+                                     torquesMultiple,
+                                     useL1,
+                                     computeJacobians,
+                                     &qs,
+                                     &dqs,
+                                     &ddqs,
+                                     &forces,
+                                     &result,
+                                     this] {
+      ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
+      for (int t = threadIdx; t < numTimesteps; t += numThreads)
+      {
+        threadHelper.fillResidualTrajectoryTimestep(
+            result,
+            t,
+            qs.col(t),
+            dqs.col(t),
+            ddqs.col(t),
+            forces.col(t),
+            torquesMultiple,
+            useL1,
+            computeJacobians);
+      }
+    }));
+  }
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    futures[threadIdx].get();
+  }
+
+  return result;
+}
+
+//==============================================================================
+// This fills in timestep `t` of `result` for calculateResidualTrajectory(),
+// using mSkel.
+void ResidualForceHelper::fillResidualTrajectoryTimestep(
+    ResidualTrajectory& result,
+    int t,
+    const Eigen::VectorXs& q,
+    const Eigen::VectorXs& dq,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& forcesConcat,
+    s_t torquesMultiple,
+    bool useL1,
+    bool computeJacobians)
+{
+  const int dofs = mSkel->getNumDofs();
+
+  mSkel->setPositions(q);
+  mSkel->setVelocities(dq);
+  mSkel->setAccelerations(ddq);
+
+  // This matches calculateInverseDynamics()
+  Eigen::MatrixXs M = mSkel->getMassMatrix();
+  Eigen::VectorXs C = mSkel->getCoriolisAndGravityForces();
+  Eigen::VectorXs Fs = Eigen::VectorXs::Zero(dofs);
+  for (int i = 0; i < mForces.size(); i++)
+  {
+    Fs += mForces[i].computeTau(forcesConcat.segment<6>(i * 6));
+  }
+  Eigen::VectorXs tau = M * ddq + C - Fs;
+  Eigen::Vector6s residual = tau.head<6>();
+
+  result.taus.col(t) = tau;
+  result.residuals.col(t) = residual;
+
+  // This matches calculateResidualNorm() and the outer weights in
+  // calculateResidualNormGradientWrt()
+  Eigen::Vector6s normGradWrtResidual;
+  if (useL1)
+  {
+    result.residualNorms(t) = residual.head<3>().norm() * torquesMultiple
+                              + residual.tail<3>().norm();
+    normGradWrtResidual = residual;
+    normGradWrtResidual.head<3>().normalize();
+    normGradWrtResidual.head<3>() *= torquesMultiple;
+    normGradWrtResidual.tail<3>().normalize();
+  }
+  else
+  {
+    result.residualNorms(t) = residual.squaredNorm();
+    normGradWrtResidual = 2 * residual;
+  }
+
+  if (!computeJacobians)
+  {
+    return;
+  }
+
+  // This matches calculateResidualJacobianWrt(), but only keeps the 6 rows we
+  // need, and reuses M from above for the acceleration Jacobian
+  Eigen::MatrixXs dFs = Eigen::MatrixXs::Zero(dofs, dofs);
+  for (int i = 0; i < mForces.size(); i++)
+  {
+    dFs += mForces[i].getJacobianOfTauWrt(
+        forcesConcat.segment<6>(i * 6), neural::WithRespectTo::POSITION);
+  }
+  Eigen::MatrixXs jacWrtPos
+      = (mSkel->getJacobianOfM(ddq, neural::WithRespectTo::POSITION)
+         + mSkel->getJacobianOfC(neural::WithRespectTo::POSITION) - dFs)
+            .topRows<6>();
+  Eigen::MatrixXs jacWrtVel
+      = mSkel->getJacobianOfC(neural::WithRespectTo::VELOCITY).topRows<6>();
+  Eigen::MatrixXs jacWrtAcc = M.topRows<6>();
+
+  result.residualJacobiansWrtPos.block(0, t * dofs, 6, dofs) = jacWrtPos;
+  result.residualJacobiansWrtVel.block(0, t * dofs, 6, dofs) = jacWrtVel;
+  result.residualJacobiansWrtAcc.block(0, t * dofs, 6, dofs) = jacWrtAcc;
+
+  result.residualNormGradientsWrtPos.col(t)
+      = jacWrtPos.transpose() * normGradWrtResidual;
+  result.residualNormGradientsWrtVel.col(t)
+      = jacWrtVel.transpose() * normGradWrtResidual;
+  result.residualNormGradientsWrtAcc.col(t)
+      = jacWrtAcc.transpose() * normGradWrtResidual;
+}
+
 //==============================================================================
 // Computes the gradient of the residual norm with respect to `wrt`
 Eigen::VectorXs ResidualForceHelper::finiteDifferenceResidualNormGradientWrt(
@@ -1956,22 +2169,22 @@ ResidualForceHelper::getRootTrajectoryLinearSystem(
   dAcc_dOffsetVels.resize(numTimesteps, Eigen::Matrix6s::Zero());
 
   int numThreads = 16;
-  std::vector<std::future<void>> futures;
+  prepareThreadSkels(numThreads);
+  std::vector<common::TaskFuture<void>> futures;
   for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
   {
-    std::shared_ptr<dynamics::Skeleton> skel = mSkel->cloneSkeleton();
-    futures.push_back(std::async([skel,
-                                  threadIdx,
-                                  numTimesteps,
-                                  numThreads,
-                                  &qs,
-                                  &dqs,
-                                  &ddqs,
-                                  &forces,
-                                  &dAcc_dOffsetPoses,
-                                  &dAcc_dOffsetVels,
-                                  this] {
-      ResidualForceHelper threadHelper(skel, mForceBodies);
+    futures.push_back(common::async([threadIdx,
+                                     numTimesteps,
+                                     numThreads,
+                                     &qs,
+                                     &dqs,
+                                     &ddqs,
+                                     &forces,
+                                     &dAcc_dOffsetPoses,
+                                     &dAcc_dOffsetVels,
+                                     this] {
+      std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
+      ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
       for (int t = 1; t < numTimesteps; t++)
       {
         if ((t - threadIdx) % numThreads == 0)
@@ -3102,42 +3315,27 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
 
   // Make sure there are enough copies of skeletons, and residuals helpers, to
   // fill out all the parallel threads we need.
-  for (int threadIdx = mThreadSkels.size(); threadIdx < numThreads; threadIdx++)
-  {
-    mThreadSkels.push_back(mSkel->cloneSkeleton());
-  }
-  for (int threadIdx = mThreadHelpers.size(); threadIdx < numThreads;
-       threadIdx++)
-  {
-    mThreadHelpers.emplace_back(mThreadSkels[threadIdx], mForceBodies);
-  }
-  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
-  {
-    mThreadSkels[threadIdx]->setGroupScales(mSkel->getGroupScales());
-    mThreadSkels[threadIdx]->setGroupCOMs(mSkel->getGroupCOMs());
-    mThreadSkels[threadIdx]->setGroupMasses(mSkel->getGroupMasses());
-    mThreadSkels[threadIdx]->setGroupInertias(mSkel->getGroupInertias());
-  }
+  prepareThreadSkels(numThreads);
 
-  std::vector<std::future<void>> futures;
+  std::vector<common::TaskFuture<void>> futures;
   for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
   {
     if (useReactionWheels)
     {
-      futures.push_back(std::async([threadIdx,
-                                    numTimesteps,
-                                    numThreads,
-                                    &comOffset,
-                                    &coms,
-                                    &comVelOffset,
-                                    &qs,
-                                    &dqs,
-                                    &ddqs,
-                                    &forces,
-                                    &residualFreeAngularAccs,
-                                    &angAccWrtPoses,
-                                    &angAccWrtVels,
-                                    this] {
+      futures.push_back(common::async([threadIdx,
+                                       numTimesteps,
+                                       numThreads,
+                                       &comOffset,
+                                       &coms,
+                                       &comVelOffset,
+                                       &qs,
+                                       &dqs,
+                                       &ddqs,
+                                       &forces,
+                                       &residualFreeAngularAccs,
+                                       &angAccWrtPoses,
+                                       &angAccWrtVels,
+                                       this] {
         std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
         ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
         s_t reactionWheelMOI = 100.0;
@@ -3176,20 +3374,20 @@ ResidualForceHelper::getLinearTrajectoryLinearSystemParallel(
     }
     else
     {
-      futures.push_back(std::async([threadIdx,
-                                    numTimesteps,
-                                    numThreads,
-                                    &comOffset,
-                                    &coms,
-                                    &comVelOffset,
-                                    &qs,
-                                    &dqs,
-                                    &ddqs,
-                                    &forces,
-                                    &residualFreeAngularAccs,
-                                    &angAccWrtPoses,
-                                    &angAccWrtVels,
-                                    this] {
+      futures.push_back(common::async([threadIdx,
+                                       numTimesteps,
+                                       numThreads,
+                                       &comOffset,
+                                       &coms,
+                                       &comVelOffset,
+                                       &qs,
+                                       &dqs,
+                                       &ddqs,
+                                       &forces,
+                                       &residualFreeAngularAccs,
+                                       &angAccWrtPoses,
+                                       &angAccWrtVels,
+                                       this] {
         std::shared_ptr<dynamics::Skeleton> skel = mThreadSkels[threadIdx];
         ResidualForceHelper& threadHelper = mThreadHelpers[threadIdx];
         for (int t = 0; t < numTimesteps; t++)
@@ -4577,57 +4775,46 @@ DynamicsFitProblem::DynamicsFitProblem(
 
   // 2. Set up the q, dq, ddq, and GRF
 
-  int dofs = skeleton->getNumDofs();
-  for (auto& block : mBlocks)
-  {
-    block.pos = Eigen::MatrixXs::Zero(dofs, block.len);
-    block.vel = Eigen::MatrixXs::Zero(dofs, block.len);
-    block.acc = Eigen::MatrixXs::Zero(dofs, block.len);
-    block.grf
-        = Eigen::MatrixXs::Zero(init->grfTrials[block.trial].rows(), block.len);
-
-    block.dt = init->trialTimesteps[block.trial];
+  loadBlocksFromInit();
 
-    for (int t = 0; t < block.len; t++)
-    {
-      int realT = block.start + t;
-      block.pos.col(t) = init->poseTrials[block.trial].col(realT);
-      block.grf.col(t) = init->grfTrials[block.trial].col(realT);
-      if (realT > 0)
-      {
-        block.vel.col(t) = mSkeleton->getPositionDifferences(
-                               init->poseTrials[block.trial].col(realT),
-                               init->poseTrials[block.trial].col(realT - 1))
-                           / block.dt;
-      }
-      if (realT > 0 && realT < init->poseTrials[block.trial].cols() - 1)
-      {
-        block.acc.col(t) = (mSkeleton->getPositionDifferences(
-                                init->poseTrials[block.trial].col(realT + 1),
-                                init->poseTrials[block.trial].col(realT))
-                            - mSkeleton->getPositionDifferences(
-                                init->poseTrials[block.trial].col(realT),
-                                init->poseTrials[block.trial].col(realT - 1)))
-                           / (block.dt * block.dt);
-      }
-    }
+  mResidualHelper
+      = std::make_shared<ResidualForceHelper>(mSkeleton, mInit->grfBodyIndices);
+  mSpatialNewtonHelper = std::make_shared<SpatialNewtonHelper>(mSkeleton);
 
-    // If this block starts the trial, we need to initialize the first
-    // timestep so that time integration will work for positions and
-    // velocities
-    if (block.start == 0)
+  // 3. Split the blocks into one contiguous range per thread, balanced by the
+  // number of timesteps, and give each thread its own copy of the skeleton.
+  // There's no point in having more threads than blocks.
+  if (mConfig.mNumThreads <= 0)
+  {
+    mConfig.mNumThreads = std::thread::hardware_concurrency();
+  }
+  mConfig.mNumThreads
+      = std::max(1, std::min(mConfig.mNumThreads, (int)mBlocks.size()));
+  int totalBlockTimesteps = 0;
+  for (auto& block : mBlocks)
+  {
+    totalBlockTimesteps += block.len;
+  }
+  mThreadBlockStarts
+      = std::vector<int>(mConfig.mNumThreads + 1, (int)mBlocks.size());
+  mThreadBlockStarts[0] = 0;
+  int blockCursor = 0;
+  int timestepsSoFar = 0;
+  for (int threadIdx = 1; threadIdx < mConfig.mNumThreads; threadIdx++)
+  {
+    // Every thread gets at least one block
+    timestepsSoFar += mBlocks[blockCursor].len;
+    blockCursor++;
+    while (blockCursor < (int)mBlocks.size() - (mConfig.mNumThreads - threadIdx)
+           && timestepsSoFar * mConfig.mNumThreads
+                  < totalBlockTimesteps * threadIdx)
     {
-      block.vel.col(0) = mSkeleton->getPositionDifferences(
-                             block.pos.col(1), block.pos.col(0))
-                         / block.dt;
-      block.acc.col(0).setZero();
+      timestepsSoFar += mBlocks[blockCursor].len;
+      blockCursor++;
     }
+    mThreadBlockStarts[threadIdx] = blockCursor;
   }
 
-  mResidualHelper
-      = std::make_shared<ResidualForceHelper>(mSkeleton, mInit->grfBodyIndices);
-  mSpatialNewtonHelper = std::make_shared<SpatialNewtonHelper>(mSkeleton);
-
   for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
   {
     std::shared_ptr<dynamics::Skeleton> skelClone = mSkeleton->cloneSkeleton();
@@ -4656,6 +4843,67 @@ DynamicsFitProblem::DynamicsFitProblem(
         std::make_shared<SpatialNewtonHelper>(skelClone));
   }
 
+  resetOptimizationState();
+}
+
+//==============================================================================
+// This fills the poses, velocities, accelerations and GRFs of every block from
+// the init object
+void DynamicsFitProblem::loadBlocksFromInit()
+{
+  int dofs = mSkeleton->getNumDofs();
+  for (auto& block : mBlocks)
+  {
+    block.pos = Eigen::MatrixXs::Zero(dofs, block.len);
+    block.vel = Eigen::MatrixXs::Zero(dofs, block.len);
+    block.acc = Eigen::MatrixXs::Zero(dofs, block.len);
+    block.grf = Eigen::MatrixXs::Zero(
+        mInit->grfTrials[block.trial].rows(), block.len);
+
+    block.dt = mInit->trialTimesteps[block.trial];
+
+    for (int t = 0; t < block.len; t++)
+    {
+      int realT = block.start + t;
+      block.pos.col(t) = mInit->poseTrials[block.trial].col(realT);
+      block.grf.col(t) = mInit->grfTrials[block.trial].col(realT);
+      if (realT > 0)
+      {
+        block.vel.col(t) = mSkeleton->getPositionDifferences(
+                               mInit->poseTrials[block.trial].col(realT),
+                               mInit->poseTrials[block.trial].col(realT - 1))
+                           / block.dt;
+      }
+      if (realT > 0 && realT < mInit->poseTrials[block.trial].cols() - 1)
+      {
+        block.acc.col(t) = (mSkeleton->getPositionDifferences(
+                                mInit->poseTrials[block.trial].col(realT + 1),
+                                mInit->poseTrials[block.trial].col(realT))
+                            - mSkeleton->getPositionDifferences(
+                                mInit->poseTrials[block.trial].col(realT),
+                                mInit->poseTrials[block.trial].col(realT - 1)))
+                           / (block.dt * block.dt);
+      }
+    }
+
+    // If this block starts the trial, we need to initialize the first
+    // timestep so that time integration will work for positions and
+    // velocities
+    if (block.start == 0)
+    {
+      block.vel.col(0) = mSkeleton->getPositionDifferences(
+                             block.pos.col(1), block.pos.col(0))
+                         / block.dt;
+      block.acc.col(0).setZero();
+    }
+  }
+}
+
+//==============================================================================
+// This sets the starting point to the current state, and clears the record of
+// the best state found so far
+void DynamicsFitProblem::resetOptimizationState()
+{
   mInitX = flatten();
   // Set all the thread copies to the same values
   unflatten(mInitX);
@@ -4669,6 +4917,92 @@ DynamicsFitProblem::DynamicsFitProblem(
   mBestObjectiveValueIteration = -1;
 }
 
+//==============================================================================
+// This returns true if a problem built from `init` and `config` would have
+// exactly the same decision variables, constraints and sparsity as this one.
+// In that case, IPOPT can re-solve this object with ReOptimizeTNLP(), and keep
+// everything it worked out about the problem's structure.
+bool DynamicsFitProblem::hasSameStructure(
+    std::shared_ptr<DynamicsInitialization> init,
+    DynamicsFitProblemConfig config)
+{
+  // The GRF bodies, joints and markers all come from the init object, so we
+  // only reuse problems built on the same one
+  if (init != mInit)
+    return false;
+  if (init->updatedMarkerMap.size() != mMarkerNames.size())
+    return false;
+  int markerIndex = 0;
+  for (auto& pair : init->updatedMarkerMap)
+  {
+    if (pair.first != mMarkerNames[markerIndex]
+        || pair.second.first != mMarkers[markerIndex].first)
+      return false;
+    markerIndex++;
+  }
+
+  if (config.mIncludeMasses != mConfig.mIncludeMasses
+      || config.mIncludeCOMs != mConfig.mIncludeCOMs
+      || config.mIncludeInertias != mConfig.mIncludeInertias
+      || config.mIncludeBodyScales != mConfig.mIncludeBodyScales
+      || config.mIncludePoses != mConfig.mIncludePoses
+      || config.mIncludeMarkerOffsets != mConfig.mIncludeMarkerOffsets
+      || config.mPoseSubsetStartIndex != mConfig.mPoseSubsetStartIndex
+      || config.mPoseSubsetLen != mConfig.mPoseSubsetLen
+      || config.mConstrainResidualsZero != mConfig.mConstrainResidualsZero
+      || config.mConstrainLinearResiduals != mConfig.mConstrainLinearResiduals
+      || config.mConstrainAngularResiduals
+             != mConfig.mConstrainAngularResiduals)
+    return false;
+
+  // The constructor resolves the number of threads, so compare against the
+  // number this config would resolve to
+  int numThreads = config.mNumThreads;
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)mBlocks.size()));
+  if (numThreads != mConfig.mNumThreads)
+    return false;
+
+  std::vector<struct DynamicsFitProblemBlock> blocks
+      = createBlocks(init, config);
+  if (blocks.size() != mBlocks.size())
+    return false;
+  for (int i = 0; i < blocks.size(); i++)
+  {
+    if (blocks[i].trial != mBlocks[i].trial
+        || blocks[i].start != mBlocks[i].start
+        || blocks[i].len != mBlocks[i].len
+        || blocks[i].constrainToNextBlock != mBlocks[i].constrainToNextBlock)
+      return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// This swaps in `config` (which must pass hasSameStructure()), and reloads the
+// starting point from the init object and the skeleton, as if this were a
+// freshly constructed problem. This keeps the blocks, the thread skeletons and
+// the helpers, so it's much cheaper than building a new one.
+void DynamicsFitProblem::resetFromInit(DynamicsFitProblemConfig config)
+{
+  config.mNumThreads = mConfig.mNumThreads;
+  mConfig = config;
+
+  for (int i = 0; i < mMarkers.size(); i++)
+  {
+    mMarkers[i].second = mInit->updatedMarkerMap.at(mMarkerNames[i]).second;
+    for (auto& threadMarkers : mThreadMarkers)
+    {
+      threadMarkers[i].second = mMarkers[i].second;
+    }
+  }
+  loadBlocksFromInit();
+  resetOptimizationState();
+}
+
 //==============================================================================
 std::vector<struct DynamicsFitProblemBlock> DynamicsFitProblem::createBlocks(
     std::shared_ptr<DynamicsInitialization> init,
@@ -5474,39 +5808,39 @@ s_t DynamicsFitProblem::computeLossParallel(
     }
   }
 
-  std::vector<struct LossExplanation> threadLossExplanations;
-  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+  // Each block keeps its own loss terms, so that we can add them up in block
+  // order below, and get exactly the same answer no matter how many threads
+  // we split the work across
+  std::vector<struct LossExplanation> blockLossExplanations;
+  for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
   {
-    threadLossExplanations.emplace_back();
-    struct LossExplanation& threadLoss = threadLossExplanations[threadIdx];
-    threadLoss.linearNewtonError = 0.0;
-    threadLoss.residualRMS = 0.0;
-    threadLoss.markerRMS = 0.0;
-    threadLoss.poseRegularization = 0.0;
-    threadLoss.accRegularization = 0.0;
-    threadLoss.jointRMS = 0.0;
-    threadLoss.axisRMS = 0.0;
-    threadLoss.markerCount = 0;
+    blockLossExplanations.emplace_back();
+    struct LossExplanation& blockLoss = blockLossExplanations[blockIdx];
+    blockLoss.linearNewtonError = 0.0;
+    blockLoss.residualRMS = 0.0;
+    blockLoss.markerRMS = 0.0;
+    blockLoss.poseRegularization = 0.0;
+    blockLoss.accRegularization = 0.0;
+    blockLoss.jointRMS = 0.0;
+    blockLoss.axisRMS = 0.0;
+    blockLoss.markerCount = 0;
   }
 
-  std::vector<std::future<void>> futures;
+  std::vector<common::TaskFuture<void>> futures;
   for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
   {
-    futures.push_back(std::async([&threadLossExplanations,
-                                  this,
-                                  threadIdx,
-                                  totalAccTimesteps,
-                                  totalTimesteps] {
-      struct LossExplanation& threadLoss = threadLossExplanations[threadIdx];
+    futures.push_back(common::async([&blockLossExplanations,
+                                     this,
+                                     threadIdx,
+                                     totalAccTimesteps,
+                                     totalTimesteps] {
       mThreadSkeletons[threadIdx]->clearExternalForces();
 
-      for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
+      for (int blockIdx = mThreadBlockStarts[threadIdx];
+           blockIdx < mThreadBlockStarts[threadIdx + 1];
+           blockIdx++)
       {
-        if ((blockIdx + threadIdx) % mConfig.mNumThreads != 0)
-        {
-          continue;
-        }
-
+        struct LossExplanation& blockLoss = blockLossExplanations[blockIdx];
         auto& block = mBlocks[blockIdx];
 
         mThreadSkeletons[threadIdx]->setTimeStep(
@@ -5516,7 +5850,6 @@ s_t DynamicsFitProblem::computeLossParallel(
         {
           int realT = block.start + t;
 
-          mSkeleton->setPositions(block.pos.col(t));
           mThreadSkeletons[threadIdx]->setPositions(block.pos.col(t));
 
           // Add force residual RMS errors to all the middle timesteps
@@ -5533,8 +5866,8 @@ s_t DynamicsFitProblem::computeLossParallel(
                                    block.acc.col(t),
                                    block.grf.col(t),
                                    mConfig.mLinearNewtonUseL1);
-              threadLoss.linearNewtonError += cost;
-              assert(!isnan(threadLoss.linearNewtonError));
+              blockLoss.linearNewtonError += cost;
+              assert(!isnan(blockLoss.linearNewtonError));
             }
             if (mConfig.mResidualWeight > 0)
             {
@@ -5547,8 +5880,8 @@ s_t DynamicsFitProblem::computeLossParallel(
                         block.grf.col(t),
                         mConfig.mResidualTorqueMultiple,
                         mConfig.mResidualUseL1);
-              threadLoss.residualRMS += cost;
-              assert(!isnan(threadLoss.residualRMS));
+              blockLoss.residualRMS += cost;
+              assert(!isnan(blockLoss.residualRMS));
             }
             if (mConfig.mRegularizeAcc > 0)
             {
@@ -5560,8 +5893,8 @@ s_t DynamicsFitProblem::computeLossParallel(
                                    block.acc.col(t),
                                    mConfig.mRegularizeAccBodyWeights,
                                    mConfig.mRegularizeAccUseL1);
-              threadLoss.accRegularization += cost;
-              assert(!isnan(threadLoss.accRegularization));
+              blockLoss.accRegularization += cost;
+              assert(!isnan(blockLoss.accRegularization));
             }
           }
 
@@ -5587,9 +5920,9 @@ s_t DynamicsFitProblem::computeLossParallel(
               {
                 thisMarkerCost = diff.squaredNorm();
               }
-              threadLoss.markerRMS += thisMarkerCost;
-              threadLoss.markerCount++;
-              assert(!isnan(threadLoss.markerRMS));
+              blockLoss.markerRMS += thisMarkerCost;
+              blockLoss.markerCount++;
+              assert(!isnan(blockLoss.markerRMS));
             }
           }
 
@@ -5603,7 +5936,7 @@ s_t DynamicsFitProblem::computeLossParallel(
           Eigen::VectorXs jointDiff = jointPoses - jointCenters;
           for (int i = 0; i < mInit->jointWeights.size(); i++)
           {
-            threadLoss.jointRMS += (jointPoses.segment<3>(i * 3)
+            blockLoss.jointRMS += (jointPoses.segment<3>(i * 3)
                                     - jointCenters.segment<3>(i * 3))
                                        .squaredNorm()
                                    * mInit->jointWeights(i);
@@ -5617,17 +5950,17 @@ s_t DynamicsFitProblem::computeLossParallel(
             // Subtract out any component parallel to the axis
             Eigen::Vector3s jointDiff = actualJointPos - axisCenter;
             jointDiff -= jointDiff.dot(axisDir) * axisDir;
-            threadLoss.axisRMS
+            blockLoss.axisRMS
                 += jointDiff.squaredNorm() * mInit->axisWeights(i);
           }
 
           // Add regularization
-          threadLoss.poseRegularization
+          blockLoss.poseRegularization
               += mConfig.mRegularizePoses * (1.0 / totalTimesteps)
                  * (block.pos.col(t)
                     - mInit->regularizePosesTo[block.trial].col(realT))
                        .squaredNorm();
-          assert(!isnan(threadLoss.poseRegularization));
+          assert(!isnan(blockLoss.poseRegularization));
         }
       }
     }));
@@ -5645,16 +5978,16 @@ s_t DynamicsFitProblem::computeLossParallel(
   s_t jointRMS = 0.0;
   s_t axisRMS = 0.0;
   int markerCount = 0;
-  for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
+  for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
   {
-    linearNewtonError += threadLossExplanations[threadIdx].linearNewtonError;
-    residualRMS += threadLossExplanations[threadIdx].residualRMS;
-    markerRMS += threadLossExplanations[threadIdx].markerRMS;
-    poseRegularization += threadLossExplanations[threadIdx].poseRegularization;
-    accRegularization += threadLossExplanations[threadIdx].accRegularization;
-    jointRMS += threadLossExplanations[threadIdx].jointRMS;
-    axisRMS += threadLossExplanations[threadIdx].axisRMS;
-    markerCount += threadLossExplanations[threadIdx].markerCount;
+    linearNewtonError += blockLossExplanations[blockIdx].linearNewtonError;
+    residualRMS += blockLossExplanations[blockIdx].residualRMS;
+    markerRMS += blockLossExplanations[blockIdx].markerRMS;
+    poseRegularization += blockLossExplanations[blockIdx].poseRegularization;
+    accRegularization += blockLossExplanations[blockIdx].accRegularization;
+    jointRMS += blockLossExplanations[blockIdx].jointRMS;
+    axisRMS += blockLossExplanations[blockIdx].axisRMS;
+    markerCount += blockLossExplanations[blockIdx].markerCount;
   }
 
   sum += linearNewtonError;
@@ -6554,34 +6887,44 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
     }
   }
 
+  // Each block's poses have their own disjoint segment of the gradient, so
+  // the threads write those directly. Everything before the poses (masses,
+  // scales, etc) is shared by all the blocks, so each block gets its own copy
+  // of that part, which we add up in block order below. That way we get
+  // exactly the same answer no matter how many threads we use.
   int initialPosesCursor = posesCursor;
-  std::vector<std::future<Eigen::VectorXs>> futures;
-  int gradSize = grad.size();
+  std::vector<int> blockPoseCursors;
+  for (auto& block : mBlocks)
+  {
+    blockPoseCursors.push_back(posesCursor);
+    posesCursor += (2 + block.len) * dims;
+  }
+  assert(posesCursor == grad.size());
+  std::vector<Eigen::VectorXs> blockSharedGrads(
+      mBlocks.size(), Eigen::VectorXs::Zero(initialPosesCursor));
+
+  std::vector<common::TaskFuture<void>> futures;
   for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
   {
-    futures.push_back(std::async([initialPosesCursor,
-                                  this,
-                                  threadIdx,
-                                  dofs,
-                                  start,
-                                  dims,
-                                  gradSize,
-                                  markerCount,
-                                  totalAccTimesteps,
-                                  totalTimesteps] {
-      int posesCursor = initialPosesCursor;
-      Eigen::VectorXs threadGrad = Eigen::VectorXs::Zero(gradSize);
-      for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
+    futures.push_back(common::async([&grad,
+                                     &blockPoseCursors,
+                                     &blockSharedGrads,
+                                     this,
+                                     threadIdx,
+                                     dofs,
+                                     start,
+                                     dims,
+                                     markerCount,
+                                     totalAccTimesteps,
+                                     totalTimesteps] {
+      for (int blockIdx = mThreadBlockStarts[threadIdx];
+           blockIdx < mThreadBlockStarts[threadIdx + 1];
+           blockIdx++)
       {
         auto& block = mBlocks[blockIdx];
         s_t dt = block.dt;
-        const int blockStart = posesCursor;
-
-        if ((blockIdx + threadIdx) % mConfig.mNumThreads != 0)
-        {
-          posesCursor += (2 + block.len) * dims;
-          continue;
-        }
+        const int blockStart = blockPoseCursors[blockIdx];
+        Eigen::VectorXs& blockGrad = blockSharedGrads[blockIdx];
 
         for (int t = 0; t < block.len; t++)
         {
@@ -6651,7 +6994,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
               {
                 if (mConfig.mResidualWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
                          * mThreadResidualHelpers[threadIdx]
                                ->calculateResidualNormGradientWrt(
@@ -6665,7 +7008,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                 }
                 if (mConfig.mLinearNewtonWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
                          * mThreadSpatialNewtonHelpers[threadIdx]
                                ->calculateLinearForceGapNormGradientWrt(
@@ -6701,7 +7044,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
               {
                 if (mConfig.mResidualWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
                          * mThreadResidualHelpers[threadIdx]
                                ->calculateResidualNormGradientWrt(
@@ -6715,7 +7058,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                 }
                 if (mConfig.mLinearNewtonWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
                          * mThreadSpatialNewtonHelpers[threadIdx]
                                ->calculateLinearForceGapNormGradientWrt(
@@ -6728,7 +7071,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                 }
                 if (mConfig.mRegularizeAcc > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
                          * mThreadSpatialNewtonHelpers[threadIdx]
                                ->calculateAccelerationNormGradient(
@@ -6749,7 +7092,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
               {
                 if (mConfig.mResidualWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
                          * mThreadResidualHelpers[threadIdx]
                                ->calculateResidualNormGradientWrt(
@@ -6800,7 +7143,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
               {
                 if (mConfig.mResidualWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mResidualWeight * (1.0 / totalAccTimesteps)
                          * mThreadResidualHelpers[threadIdx]
                                ->calculateResidualNormGradientWrt(
@@ -6814,7 +7157,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                 }
                 if (mConfig.mLinearNewtonWeight > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mLinearNewtonWeight * (1.0 / totalAccTimesteps)
                          * mThreadSpatialNewtonHelpers[threadIdx]
                                ->calculateLinearForceGapNormGradientWrt(
@@ -6827,7 +7170,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                 }
                 if (mConfig.mRegularizeAcc > 0)
                 {
-                  threadGrad.segment(cursor, dim)
+                  blockGrad.segment(cursor, dim)
                       += mConfig.mRegularizeAcc * (1.0 / totalAccTimesteps)
                          * mThreadSpatialNewtonHelpers[threadIdx]
                                ->calculateAccelerationNormGradient(
@@ -6841,14 +7184,14 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
               }
 
               // Record marker gradients
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += MarkerFitter::getMarkerLossGradientWrtGroupScales(
                       mThreadSkeletons[threadIdx],
                       mThreadMarkers[threadIdx],
                       lossGradWrtMarkerError);
 
               // Record joint gradients
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += mThreadSkeletons[threadIdx]
                          ->getJointWorldPositionsJacobianWrtGroupScales(
                              mThreadJoints[threadIdx])
@@ -6860,7 +7203,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
             if (mConfig.mIncludeMarkerOffsets)
             {
               int dim = mThreadMarkers[threadIdx].size() * 3;
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
                       mThreadSkeletons[threadIdx],
                       mThreadMarkers[threadIdx],
@@ -6991,25 +7334,25 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                              .transpose()
                          * jointGrad;
 
-              threadGrad.segment(blockStart, dims)
+              grad.segment(blockStart, dims)
                   += posGrad.segment(start, dims);
-              threadGrad.segment(blockStart + dims, dims)
+              grad.segment(blockStart + dims, dims)
                   += velGrad.segment(start, dims);
               // Initial velocity also has a linear effect on position, so
               // reflect that in the gradients
-              threadGrad.segment(blockStart + dims, dims)
+              grad.segment(blockStart + dims, dims)
                   += posGrad.segment(start, dims) * dt * t;
 
-              threadGrad.segment(blockStart + (dims * (2 + t)), dims)
+              grad.segment(blockStart + (dims * (2 + t)), dims)
                   += accGrad.segment(start, dims);
 
               for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
               {
-                threadGrad.segment(
+                grad.segment(
                     blockStart + (dims * (2 + pastAccStep)), dims)
                     += dt * velGrad.segment(start, dims);
                 int stepsSinceAcc = t - pastAccStep;
-                threadGrad.segment(
+                grad.segment(
                     blockStart + (dims * (2 + pastAccStep)), dims)
                     += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
               }
@@ -7037,13 +7380,13 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
             {
               int dim = mThreadSkeletons[threadIdx]->getGroupScaleDim();
               // Record marker gradients
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += MarkerFitter::getMarkerLossGradientWrtGroupScales(
                       mThreadSkeletons[threadIdx],
                       mThreadMarkers[threadIdx],
                       lossGradWrtMarkerError);
               // Record joint gradients
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += mThreadSkeletons[threadIdx]
                          ->getJointWorldPositionsJacobianWrtGroupScales(
                              mThreadJoints[threadIdx])
@@ -7055,7 +7398,7 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
             if (mConfig.mIncludeMarkerOffsets)
             {
               int dim = mThreadMarkers[threadIdx].size() * 3;
-              threadGrad.segment(cursor, dim)
+              blockGrad.segment(cursor, dim)
                   += MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
                       mThreadSkeletons[threadIdx],
                       mThreadMarkers[threadIdx],
@@ -7081,31 +7424,31 @@ Eigen::VectorXs DynamicsFitProblem::computeGradientParallel(Eigen::VectorXs x)
                              .transpose()
                          * jointGrad;
 
-              threadGrad.segment(blockStart, dims)
+              grad.segment(blockStart, dims)
                   += posGrad.segment(start, dims);
-              threadGrad.segment(blockStart + dims, dims)
+              grad.segment(blockStart + dims, dims)
                   += posGrad.segment(start, dims) * dt * t;
 
               for (int pastAccStep = 0; pastAccStep < t; pastAccStep++)
               {
                 int stepsSinceAcc = t - pastAccStep;
-                threadGrad.segment(
+                grad.segment(
                     blockStart + (dims * (2 + pastAccStep)), dims)
                     += dt * dt * stepsSinceAcc * posGrad.segment(start, dims);
               }
             }
           }
         }
-
-        posesCursor += (2 + block.len) * dims;
       }
-      assert(posesCursor == gradSize);
-      return threadGrad;
     }));
   }
   for (int threadIdx = 0; threadIdx < mConfig.mNumThreads; threadIdx++)
   {
-    grad += futures[threadIdx].get();
+    futures[threadIdx].get();
+  }
+  for (int blockIdx = 0; blockIdx < mBlocks.size(); blockIdx++)
+  {
+    grad.segment(0, initialPosesCursor) += blockSharedGrads[blockIdx];
   }
 
   // // Check against single-threaded
@@ -7770,19 +8113,196 @@ Eigen::MatrixXs DynamicsFitProblem::finiteDifferenceHessian(
 }
 
 //==============================================================================
-bool debugVector(
-    Eigen::VectorXs fd, Eigen::VectorXs analytical, std::string name, s_t tol)
+// This gets the number of entries in the lower triangle of the sparse Hessian
+// of the loss.
+int DynamicsFitProblem::getSparseHessianNonZeros()
 {
-  bool anyError = false;
-  for (int i = 0; i < fd.size(); i++)
+  const int n = getProblemSize();
+  int sharedDim = n;
+  int nnz = 0;
+  if (mConfig.mIncludePoses)
   {
-    bool isError = false;
-    s_t error = 0.0;
-    if (fabs(fd(i)) > 1)
+    const int dofs = mSkeleton->getNumDofs();
+    const int dims = mConfig.mPoseSubsetLen == -1
+                         ? dofs - mConfig.mPoseSubsetStartIndex
+                         : mConfig.mPoseSubsetLen;
+    for (auto& block : mBlocks)
     {
-      // Test relative error for values that are larger than 1
-      if (fabs((fd(i) - analytical(i)) / fd(i)) > tol)
-      {
+      const int blockDim = (2 + block.len) * dims;
+      sharedDim -= blockDim;
+      nnz += blockDim * (blockDim + 1) / 2;
+    }
+  }
+  // The shared variables come first in the flattened vector, so their columns
+  // of the lower triangle run all the way down to the bottom of the matrix
+  nnz += sharedDim * (sharedDim + 1) / 2 + sharedDim * (n - sharedDim);
+  return nnz;
+}
+
+//==============================================================================
+// This gets the (row,col) pairs of the lower triangle of the sparse Hessian of
+// the loss, in the same order that computeSparseHessian() returns them.
+std::vector<std::pair<int, int>> DynamicsFitProblem::getSparseHessianStructure()
+{
+  std::vector<std::pair<int, int>> structure;
+  structure.reserve(getSparseHessianNonZeros());
+
+  const int n = getProblemSize();
+  std::vector<int> blockDims;
+  int sharedDim = n;
+  if (mConfig.mIncludePoses)
+  {
+    const int dofs = mSkeleton->getNumDofs();
+    const int dims = mConfig.mPoseSubsetLen == -1
+                         ? dofs - mConfig.mPoseSubsetStartIndex
+                         : mConfig.mPoseSubsetLen;
+    for (auto& block : mBlocks)
+    {
+      blockDims.push_back((2 + block.len) * dims);
+      sharedDim -= blockDims.back();
+    }
+  }
+
+  for (int col = 0; col < sharedDim; col++)
+  {
+    for (int row = col; row < n; row++)
+    {
+      structure.emplace_back(row, col);
+    }
+  }
+  int blockStart = sharedDim;
+  for (int blockDim : blockDims)
+  {
+    for (int col = 0; col < blockDim; col++)
+    {
+      for (int row = col; row < blockDim; row++)
+      {
+        structure.emplace_back(blockStart + row, blockStart + col);
+      }
+    }
+    blockStart += blockDim;
+  }
+  assert(blockStart == n);
+  assert(structure.size() == getSparseHessianNonZeros());
+
+  return structure;
+}
+
+//==============================================================================
+// This gets the lower triangle of the sparse Hessian of the loss, returning
+// objects with (row,col,value).
+std::vector<std::tuple<int, int, s_t>> DynamicsFitProblem::computeSparseHessian(
+    Eigen::VectorXs x, s_t eps)
+{
+  const int n = getProblemSize();
+  std::vector<int> blockDims;
+  int sharedDim = n;
+  int maxBlockDim = 0;
+  if (mConfig.mIncludePoses)
+  {
+    const int dofs = mSkeleton->getNumDofs();
+    const int dims = mConfig.mPoseSubsetLen == -1
+                         ? dofs - mConfig.mPoseSubsetStartIndex
+                         : mConfig.mPoseSubsetLen;
+    for (auto& block : mBlocks)
+    {
+      blockDims.push_back((2 + block.len) * dims);
+      sharedDim -= blockDims.back();
+      maxBlockDim = std::max(maxBlockDim, blockDims.back());
+    }
+  }
+
+  auto differenceGradient = [&](const Eigen::VectorXs& direction) {
+    Eigen::VectorXs plus = computeGradientParallel(x + eps * direction);
+    Eigen::VectorXs minus = computeGradientParallel(x - eps * direction);
+    return Eigen::VectorXs((plus - minus) / (2 * eps));
+  };
+
+  std::vector<std::tuple<int, int, s_t>> hessian;
+  hessian.reserve(getSparseHessianNonZeros());
+
+  // 1. The shared variables touch every block, so we have to perturb them one
+  // at a time. These columns include every entry of the lower triangle in a
+  // shared variable's column.
+  for (int col = 0; col < sharedDim; col++)
+  {
+    Eigen::VectorXs direction = Eigen::VectorXs::Zero(n);
+    direction(col) = 1.0;
+    Eigen::VectorXs column = differenceGradient(direction);
+    for (int row = col; row < n; row++)
+    {
+      hessian.emplace_back(row, col, column(row));
+    }
+  }
+
+  // 2. The pose variables for each block don't affect the gradient wrt any
+  // other block's poses, so we can perturb the same column in every block at
+  // once and read each block's rows back out separately. The shared rows of
+  // these columns are a sum over blocks, but we already have their transpose
+  // from (1), so we skip them.
+  std::vector<Eigen::MatrixXs> blockHessians;
+  for (int blockDim : blockDims)
+  {
+    blockHessians.push_back(Eigen::MatrixXs::Zero(blockDim, blockDim));
+  }
+  for (int col = 0; col < maxBlockDim; col++)
+  {
+    Eigen::VectorXs direction = Eigen::VectorXs::Zero(n);
+    int blockStart = sharedDim;
+    for (int blockDim : blockDims)
+    {
+      if (col < blockDim)
+      {
+        direction(blockStart + col) = 1.0;
+      }
+      blockStart += blockDim;
+    }
+    Eigen::VectorXs column = differenceGradient(direction);
+    blockStart = sharedDim;
+    for (int b = 0; b < blockDims.size(); b++)
+    {
+      if (col < blockDims[b])
+      {
+        blockHessians[b].col(col) = column.segment(blockStart, blockDims[b]);
+      }
+      blockStart += blockDims[b];
+    }
+  }
+  int blockStart = sharedDim;
+  for (int b = 0; b < blockDims.size(); b++)
+  {
+    for (int col = 0; col < blockDims[b]; col++)
+    {
+      for (int row = col; row < blockDims[b]; row++)
+      {
+        hessian.emplace_back(
+            blockStart + row, blockStart + col, blockHessians[b](row, col));
+      }
+    }
+    blockStart += blockDims[b];
+  }
+  assert(hessian.size() == getSparseHessianNonZeros());
+
+  // Leave the problem in the state we found it
+  unflatten(x);
+
+  return hessian;
+}
+
+//==============================================================================
+bool debugVector(
+    Eigen::VectorXs fd, Eigen::VectorXs analytical, std::string name, s_t tol)
+{
+  bool anyError = false;
+  for (int i = 0; i < fd.size(); i++)
+  {
+    bool isError = false;
+    s_t error = 0.0;
+    if (fabs(fd(i)) > 1)
+    {
+      // Test relative error for values that are larger than 1
+      if (fabs((fd(i) - analytical(i)) / fd(i)) > tol)
+      {
         error = fabs((fd(i) - analytical(i)) / fd(i));
         isError = true;
       }
@@ -8322,7 +8842,7 @@ bool DynamicsFitProblem::get_nlp_info(
   nnz_jac_g = computeSparseConstraintsJacobian().size();
 
   // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  nnz_h_lag = getSparseHessianNonZeros();
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -8547,18 +9067,40 @@ bool DynamicsFitProblem::eval_h(
     Ipopt::Index* _jCol,
     Ipopt::Number* _values)
 {
-  (void)_n;
-  (void)_x;
   (void)_new_x;
-  (void)_obj_factor;
   (void)_m;
-  (void)_lambda;
   (void)_new_lambda;
-  (void)_nele_hess;
-  (void)_iRow;
-  (void)_jCol;
-  (void)_values;
-  return false;
+
+  // Our constraints are linear (unless we're constraining residuals to zero),
+  // so the Hessian of the Lagrangian is just the scaled Hessian of the loss.
+  // We don't include the curvature of the residual constraints, which is a
+  // Gauss-Newton style approximation when those are turned on.
+  (void)_lambda;
+
+  if (nullptr == _x)
+  {
+    std::vector<std::pair<int, int>> structure = getSparseHessianStructure();
+    assert(structure.size() == _nele_hess);
+    for (int i = 0; i < structure.size(); i++)
+    {
+      _iRow[i] = structure[i].first;
+      _jCol[i] = structure[i].second;
+    }
+  }
+  else
+  {
+    Eigen::Map<const Eigen::VectorXd> x(_x, _n);
+    std::vector<std::tuple<int, int, s_t>> sparse
+        = computeSparseHessian(x.cast<s_t>());
+    assert(sparse.size() == _nele_hess);
+    Eigen::Map<Eigen::VectorXd> vals(_values, _nele_hess);
+    for (int i = 0; i < sparse.size(); i++)
+    {
+      vals(i) = _obj_factor * (double)std::get<2>(sparse[i]);
+    }
+  }
+
+  return true;
 }
 
 //==============================================================================
@@ -8705,7 +9247,8 @@ DynamicsFitter::DynamicsFitter(
     mCheckDerivatives(false),
     mPrintFrequency(1),
     mSilenceOutput(false),
-    mDisableLinesearch(false)
+    mDisableLinesearch(false),
+    mUseExactHessian(false)
 {
   mSkeleton->setGroupMasses(mSkeleton->getGroupMasses());
   mSkeleton->setGroupCOMs(mSkeleton->getGroupCOMs());
@@ -8986,7 +9529,7 @@ std::shared_ptr<DynamicsInitialization> DynamicsFitter::createInitialization(
     }
     init->forcePlatesAssignedToContactBody.push_back(assignedToContactBody);
 
-    recomputeGRFs(init, skel, trial);
+    recomputeGRFs(init, skel, trial, -1);
   }
 
   // Make copies of data to report how things change later
@@ -9404,8 +9947,6 @@ std::vector<Eigen::Vector3s> DynamicsFitter::measuredGRFForces(
 void DynamicsFitter::estimateFootGroundContacts(
     std::shared_ptr<DynamicsInitialization> init)
 {
-  Eigen::VectorXs originalPose = mSkeleton->getPositions();
-
   const s_t offForcePlateHeightSafetyMargin = 0.05;
 
   // 0. Expand the set of grf bodies to include any childen that are not
@@ -9441,6 +9982,19 @@ void DynamicsFitter::estimateFootGroundContacts(
     init->contactBodies.push_back(extendedContactBodies);
   }
 
+  // We only ever need the world positions of the contact bodies, so we gather
+  // them up to get their positions on every frame in one pass
+  std::vector<const dynamics::BodyNode*> flatContactBodies;
+  std::vector<int> contactBodyOffsets;
+  for (int b = 0; b < init->contactBodies.size(); b++)
+  {
+    contactBodyOffsets.push_back(flatContactBodies.size());
+    for (dynamics::BodyNode* body : init->contactBodies[b])
+    {
+      flatContactBodies.push_back(body);
+    }
+  }
+
   for (int trial = 0; trial < init->forcePlateTrials.size(); trial++)
   {
     bool noGroundCorners = true;
@@ -9495,6 +10049,11 @@ void DynamicsFitter::estimateFootGroundContacts(
 
     assert(!isnan(groundHeight));
 
+    // 1.3. Run forward kinematics for just the contact bodies, on every frame
+    Eigen::MatrixXs contactBodyPositions
+        = mSkeleton->getBodyWorldPositionsOverTrajectory(
+            flatContactBodies, init->poseTrials[trial]);
+
     // 2.0. Check for the size of the contact spheres to check for contact
     // Since each grf body actually gets a (potentially) extended set of
     // contact bodies attached to it, each grf body gets an array of contact
@@ -9512,8 +10071,6 @@ void DynamicsFitter::estimateFootGroundContacts(
 
     for (int t = 0; t < init->poseTrials[trial].cols(); t++)
     {
-      mSkeleton->setPositions(init->poseTrials[trial].col(t));
-
       for (int b = 0; b < init->grfBodyNodes.size(); b++)
       {
         bool footActive
@@ -9531,8 +10088,8 @@ void DynamicsFitter::estimateFootGroundContacts(
           int closestBody = -1;
           for (int c = 0; c < init->contactBodies[b].size(); c++)
           {
-            auto* body = init->contactBodies[b][c];
-            Eigen::Vector3s worldPos = body->getWorldTransform().translation();
+            Eigen::Vector3s worldPos = contactBodyPositions.block<3, 1>(
+                (contactBodyOffsets[b] + c) * 3, t);
             s_t dist = worldPos(1) - groundHeight;
             if (dist < minDist)
             {
@@ -9656,8 +10213,6 @@ void DynamicsFitter::estimateFootGroundContacts(
     std::vector<bool> trialAnyOffForcePlate;
     for (int t = 0; t < init->poseTrials[trial].cols(); t++)
     {
-      mSkeleton->setPositions(init->poseTrials[trial].col(t));
-
       std::vector<bool> forceActive;
       std::vector<bool> sphereInContact;
       std::vector<bool> offForcePlate;
@@ -9676,8 +10231,8 @@ void DynamicsFitter::estimateFootGroundContacts(
         bool anyInPlate = false;
         for (int c = 0; c < init->contactBodies[b].size(); c++)
         {
-          auto* body = init->contactBodies[b][c];
-          Eigen::Vector3s worldPos = body->getWorldTransform().translation();
+          Eigen::Vector3s worldPos = contactBodyPositions.block<3, 1>(
+              (contactBodyOffsets[b] + c) * 3, t);
 
           // Check if this body is over a force plate
           bool overPlate = false;
@@ -9969,7 +10524,8 @@ void DynamicsFitter::smoothAccelerations(
     }
 
     // 0.05
-    AccelerationSmoother smoother(init->poseTrials[trial].cols(), 1, 0.02);
+    AccelerationSmoother smoother(
+        init->poseTrials[trial].cols(), 1, 0.02, true, false);
 
     init->poseTrials[trial] = smoother.smooth(init->poseTrials[trial]);
 
@@ -10248,6 +10804,148 @@ void DynamicsFitter::moveComsToMinimizeAngularResiduals(
   }
 }
 
+//==============================================================================
+// This builds the linear map from the initial conditions, force plate
+// rotations, missing step delta Vs and total mass of one trial to its COM
+// positions over time, as zeroLinearResidualsOnCOMTrajectory() solves it.
+Eigen::SparseMatrix<s_t> DynamicsFitter::getCOMTrajectoryLinearMap(
+    s_t dt,
+    const std::vector<Eigen::Vector3s>& grfs,
+    const std::vector<ForcePlate>& forcePlates,
+    const std::vector<int>& missingStepIndices,
+    const std::vector<int>& missingStepMappings,
+    int numMissingSteps,
+    s_t regularizeForcePlateRotations,
+    s_t regularizeUnobservedTimesteps)
+{
+  const int numTimesteps = grfs.size();
+  const int numForcePlates = forcePlates.size();
+
+  // This has one col each for start COM positions, start COM velocities,
+  // and total mass. It outputs the physically consistent X, Y, Z
+  // coordinates of COM over time, given those inputs. Additionally, there
+  // are columns to account for small force plate rotation errors (3 angles
+  // per force plate) and for instantaneous COM velocities at time steps with
+  // missing ground reaction force data.
+  //
+  // Most of this map is zero (each row only touches its own axis, and a
+  // missing step's columns only fill in after that step), so we collect
+  // the entries as triplets and keep it sparse. That keeps the cost of
+  // building and solving the system proportional to the non-zeros, rather
+  // than to (timesteps x columns).
+  const int rows
+      = numTimesteps * 3 + (numForcePlates * 3) + (numMissingSteps * 3);
+  const int cols = 6 + (numForcePlates * 3) + (numMissingSteps * 3) + 1;
+  std::vector<Eigen::Triplet<s_t>> entries;
+
+  const int startPosCol = 0;
+  const int startVelCol = 3;
+  const int massCol = cols - 1;
+
+  Eigen::Vector3s forceVelocity = Eigen::Vector3s::Zero();
+  Eigen::Vector3s forceOffset = Eigen::Vector3s::Zero();
+  // For handling small force plate rotations, which can be important to
+  // correct for calibration errors in the force plates.
+  std::vector<Eigen::Vector3s> forcePlateVelocity(
+      numForcePlates, Eigen::Vector3s::Zero());
+  std::vector<Eigen::Vector3s> forcePlateOffset(
+      numForcePlates, Eigen::Vector3s::Zero());
+  // When several missing steps share a bucket, the latest one before the
+  // current timestep sets that bucket's delta V, so we track it as we go
+  std::vector<int> lastMissingIndexInBucket(numMissingSteps, -1);
+  int missingCursor = 0;
+
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      const int row = (t * 3) + axis;
+      entries.emplace_back(row, startPosCol + axis, 1.0);
+      if (t > 0)
+      {
+        entries.emplace_back(row, startVelCol + axis, t * dt);
+      }
+    }
+
+    for (int f = 0; f < numForcePlates; f++)
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        Eigen::Vector3s plateRotAxisOffset
+            = forcePlateOffset[f].cross(Eigen::Vector3s::Unit(axis));
+        const int plateRotAxisCol = 6 + (f * 3) + axis;
+        for (int rowAxis = 0; rowAxis < 3; rowAxis++)
+        {
+          entries.emplace_back(
+              (t * 3) + rowAxis, plateRotAxisCol, plateRotAxisOffset(rowAxis));
+        }
+      }
+    }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+      entries.emplace_back((t * 3) + axis, massCol, forceOffset(axis));
+    }
+
+    // Allow the missing steps to generate arbitrary delta V on each step
+    while (missingCursor < missingStepIndices.size()
+           && missingStepIndices[missingCursor] < t)
+    {
+      lastMissingIndexInBucket[missingStepMappings[missingCursor]]
+          = missingStepIndices[missingCursor];
+      missingCursor++;
+    }
+    for (int mapping = 0; mapping < numMissingSteps; mapping++)
+    {
+      int missingIndex = lastMissingIndexInBucket[mapping];
+      if (missingIndex < 0)
+        continue;
+      int timestepsSinceDv = t - missingIndex;
+      for (int axis = 0; axis < 3; axis++)
+      {
+        entries.emplace_back(
+            (t * 3) + axis,
+            6 + (numForcePlates * 3) + mapping * 3 + axis,
+            dt * timestepsSinceDv);
+      }
+    }
+
+    forceVelocity += grfs[t] * dt;
+    forceOffset += forceVelocity * dt;
+
+    for (int f = 0; f < numForcePlates; f++)
+    {
+      forcePlateVelocity[f] += forcePlates[f].forces[t] * dt;
+      forcePlateOffset[f] += forcePlateVelocity[f] * dt;
+    }
+  }
+
+  // Output the force plate rotations to the output, so we can regularize them
+  for (int j = 0; j < numForcePlates * 3; j++)
+  {
+    entries.emplace_back(
+        (numTimesteps * 3) + j,
+        6 + j,
+        regularizeForcePlateRotations * numTimesteps);
+  }
+
+  // Output the delta V for missing steps to the output, so we can regularize
+  // it
+  for (int j = 0; j < numMissingSteps * 3; j++)
+  {
+    entries.emplace_back(
+        (numTimesteps * 3) + (numForcePlates * 3) + j,
+        6 + (numForcePlates * 3) + j,
+        regularizeUnobservedTimesteps);
+  }
+
+  // Every (row, col) above is written exactly once, so there are no
+  // duplicate triplets to combine
+  Eigen::SparseMatrix<s_t> linearMap(rows, cols);
+  linearMap.setFromTriplets(entries.begin(), entries.end());
+  return linearMap;
+}
+
 //==============================================================================
 // 1. Adjust the total mass of the body, and change the initial positions and
 // velocities of the body to achieve a least-squares closest COM trajectory to
@@ -10341,7 +11039,7 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
 
     const s_t originalMass = mSkeleton->getMass();
 
-    std::vector<Eigen::MatrixXs> trialLinearMaps;
+    std::vector<Eigen::SparseMatrix<s_t>> trialLinearMaps;
     std::vector<Eigen::VectorXs> trialOriginalPositions;
     std::vector<Eigen::VectorXs> trialOriginalGravityOffsets;
 
@@ -10356,7 +11054,6 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
       std::cout
           << "Constructing COM (linear) trajectory linear system for trial "
           << i << "/" << init->poseTrials.size() << std::endl;
-      int numForcePlates = init->forcePlateTrials[i].size();
       int numMissingSteps = 0;
       std::vector<bool> trialProbablyMissing;
       std::vector<int> missingStepIndices;
@@ -10392,15 +11089,16 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
       const s_t dt = init->trialTimesteps[i];
       const int numTimesteps = init->poseTrials[i].cols();
 
-      // This has one col each for start COM positions, start COM velocities,
-      // and total mass. It outputs the physically consistent X, Y, Z
-      // coordinates of COM over time, given those inputs. Additionally, there
-      // are columns to account for small force plate rotation errors (3 angles
-      // per force plate) and for instantaneous COM velocities at time steps with
-      // missing ground reaction force data.
-      Eigen::MatrixXs trialLinearMapToPositions = Eigen::MatrixXs::Zero(
-          numTimesteps * 3 + (numForcePlates * 3) + (numMissingSteps * 3),
-          6 + (numForcePlates * 3) + (numMissingSteps * 3) + 1);
+      Eigen::SparseMatrix<s_t> trialLinearMapToPositions
+          = getCOMTrajectoryLinearMap(
+              dt,
+              trialGRFs[i],
+              init->forcePlateTrials[i],
+              missingStepIndices,
+              missingStepMappings,
+              numMissingSteps,
+              regularizeForcePlateRotations,
+              regularizeUnobservedTimesteps);
       if (i < maxTrialsToSolveMassOver)
       {
         totalSampledColsWithoutMass += trialLinearMapToPositions.cols() - 1;
@@ -10416,92 +11114,12 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
       Eigen::VectorXs comGravityOffset
           = Eigen::VectorXs::Zero(numTimesteps * 3);
 
-      const int startPosXCol = 0;
-      const int startPosYCol = 1;
-      const int startPosZCol = 2;
-      const int startVelXCol = 3;
-      const int startVelYCol = 4;
-      const int startVelZCol = 5;
-      const int massCol = 6 + numForcePlates * 3 + numMissingSteps * 3;
-
-      Eigen::Vector3s forceVelocity = Eigen::Vector3s::Zero();
-      Eigen::Vector3s forceOffset = Eigen::Vector3s::Zero();
       Eigen::Vector3s gravityVelocity = Eigen::Vector3s::Zero();
       Eigen::Vector3s gravityOffset = Eigen::Vector3s::Zero();
-      // For handling small force plate rotations, which can be important to
-      // correct for calibration errors in the force plates.
-      std::vector<Eigen::Vector3s> forcePlateVelocity;
-      std::vector<Eigen::Vector3s> forcePlateOffset;
-      for (int f = 0; f < numForcePlates; f++)
-      {
-        forcePlateVelocity.push_back(Eigen::Vector3s::Zero());
-        forcePlateOffset.push_back(Eigen::Vector3s::Zero());
-      }
 
       for (int t = 0; t < numTimesteps; t++)
       {
-        const int xRow = (t * 3);
-        const int yRow = (t * 3) + 1;
-        const int zRow = (t * 3) + 2;
-
-        trialLinearMapToPositions(xRow, startPosXCol) = 1;
-        trialLinearMapToPositions(yRow, startPosYCol) = 1;
-        trialLinearMapToPositions(zRow, startPosZCol) = 1;
-
-        trialLinearMapToPositions(xRow, startVelXCol) = t * dt;
-        trialLinearMapToPositions(yRow, startVelYCol) = t * dt;
-        trialLinearMapToPositions(zRow, startVelZCol) = t * dt;
-
-        for (int f = 0; f < numForcePlates; f++)
-        {
-          for (int axis = 0; axis < 3; axis++)
-          {
-            Eigen::Vector3s plateRotAxisOffset
-                = forcePlateOffset[f].cross(Eigen::Vector3s::Unit(axis));
-            const int plateRotAxisCol = 6 + (f * 3) + axis;
-            trialLinearMapToPositions(xRow, plateRotAxisCol)
-                = plateRotAxisOffset(0);
-            trialLinearMapToPositions(yRow, plateRotAxisCol)
-                = plateRotAxisOffset(1);
-            trialLinearMapToPositions(zRow, plateRotAxisCol)
-                = plateRotAxisOffset(2);
-          }
-        }
-
-        trialLinearMapToPositions(xRow, massCol) = forceOffset(0);
-        trialLinearMapToPositions(yRow, massCol) = forceOffset(1);
-        trialLinearMapToPositions(zRow, massCol) = forceOffset(2);
-
-        // Allow the missing steps to generate arbitrary delta V on each step
-        for (int j = 0; j < missingStepIndices.size(); j++)
-        {
-          int missingIndex = missingStepIndices[j];
-          if (missingIndex >= t)
-            break;
-          int timestepsSinceDv = t - missingIndex;
-          int mapping = missingStepMappings[j];
-
-          int missingXCol = 6 + mapping * 3;
-          int missingYCol = 6 + mapping * 3 + 1;
-          int missingZCol = 6 + mapping * 3 + 2;
-
-          trialLinearMapToPositions(xRow, missingXCol) = dt * timestepsSinceDv;
-          trialLinearMapToPositions(yRow, missingYCol) = dt * timestepsSinceDv;
-          trialLinearMapToPositions(zRow, missingZCol) = dt * timestepsSinceDv;
-        }
-
-        comGravityOffset(xRow) = gravityOffset(0);
-        comGravityOffset(yRow) = gravityOffset(1);
-        comGravityOffset(zRow) = gravityOffset(2);
-
-        forceVelocity += trialGRFs[i][t] * dt;
-        forceOffset += forceVelocity * dt;
-
-        for (int f = 0; f < numForcePlates; f++)
-        {
-          forcePlateVelocity[f] += init->forcePlateTrials[i][f].forces[t] * dt;
-          forcePlateOffset[f] += forcePlateVelocity[f] * dt;
-        }
+        comGravityOffset.segment<3>(t * 3) = gravityOffset;
 
         gravityVelocity += gravity * dt;
 
@@ -10511,74 +11129,7 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
         }
         gravityOffset += gravityVelocity * dt;
 
-        originalCOMPositions(xRow) = trialOriginalCOMs[i][t](0);
-        originalCOMPositions(yRow) = trialOriginalCOMs[i][t](1);
-        originalCOMPositions(zRow) = trialOriginalCOMs[i][t](2);
-      }
-
-      // Output the force plate rotations to the output, so we can
-      // regularize it
-      for (int j = 0; j < numForcePlates; j++)
-      {
-        int angleXCol = 6 + j * 3;
-        int angleYCol = 6 + j * 3 + 1;
-        int angleZCol = 6 + j * 3 + 2;
-
-        int angleXRow = (numTimesteps * 3) + j * 3;
-        int angleYRow = (numTimesteps * 3) + j * 3 + 1;
-        int angleZRow = (numTimesteps * 3) + j * 3 + 2;
-
-        // Nothing else should've written to these rows at this point
-        if (!trialLinearMapToPositions.row(angleXRow).isZero())
-        {
-          std::cout << "missing X Row (" << angleXRow << ") for missing index "
-                    << j << " is not empty!" << std::endl
-                    << trialLinearMapToPositions.row(angleXRow).transpose()
-                    << std::endl;
-        }
-        assert(trialLinearMapToPositions.row(angleXRow).isZero());
-        assert(trialLinearMapToPositions.row(angleYRow).isZero());
-        assert(trialLinearMapToPositions.row(angleZRow).isZero());
-
-        trialLinearMapToPositions(angleXRow, angleXCol)
-            = regularizeForcePlateRotations * numTimesteps;
-        trialLinearMapToPositions(angleYRow, angleYCol)
-            = regularizeForcePlateRotations * numTimesteps;
-        trialLinearMapToPositions(angleZRow, angleZCol)
-            = regularizeForcePlateRotations * numTimesteps;
-      }
-
-      // Output the delta V for missing steps to the output, so we can
-      // regularize it
-      for (int j = 0; j < numMissingSteps; j++)
-      {
-        int missingXCol = 6 + (numForcePlates * 3) + j * 3;
-        int missingYCol = 6 + (numForcePlates * 3) + j * 3 + 1;
-        int missingZCol = 6 + (numForcePlates * 3) + j * 3 + 2;
-
-        int missingXRow = (numTimesteps * 3) + (numForcePlates * 3) + j * 3;
-        int missingYRow = (numTimesteps * 3) + (numForcePlates * 3) + j * 3 + 1;
-        int missingZRow = (numTimesteps * 3) + (numForcePlates * 3) + j * 3 + 2;
-
-        // Nothing else should've written to these rows at this point
-        if (!trialLinearMapToPositions.row(missingXRow).isZero())
-        {
-          std::cout << "missing X Row (" << missingXRow
-                    << ") for missing index " << j << " is not empty!"
-                    << std::endl
-                    << trialLinearMapToPositions.row(missingXRow).transpose()
-                    << std::endl;
-        }
-        assert(trialLinearMapToPositions.row(missingXRow).isZero());
-        assert(trialLinearMapToPositions.row(missingYRow).isZero());
-        assert(trialLinearMapToPositions.row(missingZRow).isZero());
-
-        trialLinearMapToPositions(missingXRow, missingXCol)
-            = regularizeUnobservedTimesteps;
-        trialLinearMapToPositions(missingYRow, missingYCol)
-            = regularizeUnobservedTimesteps;
-        trialLinearMapToPositions(missingZRow, missingZCol)
-            = regularizeUnobservedTimesteps;
+        originalCOMPositions.segment<3>(t * 3) = trialOriginalCOMs[i][t];
       }
 
       trialLinearMaps.push_back(trialLinearMapToPositions);
@@ -10594,27 +11145,35 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
     // trial separate, but collapses each trial's mass quantity into a single
     // column, so that we can solve them together for a single unified
     // skeleton mass that is least-squares best across all the trials at once.
-    Eigen::MatrixXs unifiedLinearMap = Eigen::MatrixXs::Zero(
-        totalSampledRows, totalSampledColsWithoutMass + 1);
+    std::vector<Eigen::Triplet<s_t>> unifiedLinearMapEntries;
     Eigen::VectorXs unifiedPositions = Eigen::VectorXs::Zero(totalSampledRows);
     Eigen::VectorXs unifiedGravityOffset
         = Eigen::VectorXs::Zero(totalSampledRows);
 
     int rowCursor = 0;
     int colCursor = 0;
-    int massCol = unifiedLinearMap.cols() - 1;
+    int massCol = totalSampledColsWithoutMass;
     for (int trial = 0;
          trial < numTrials && trial < maxTrialsToSolveMassOver; trial++)
     {
       int trialTimestepRows = trialOriginalPositions[trial].size();
       int trialRows = trialLinearMaps[trial].rows();
       int trialCols = trialLinearMaps[trial].cols();
-      // (position,velocity) get their own unique block for each trial
-      unifiedLinearMap.block(rowCursor, colCursor, trialRows, trialCols - 1)
-          = trialLinearMaps[trial].block(0, 0, trialRows, trialCols - 1);
-      // mass all goes into the same column for every trial
-      unifiedLinearMap.block(rowCursor, massCol, trialRows, 1)
-          = trialLinearMaps[trial].block(0, trialCols - 1, trialRows, 1);
+      for (int k = 0; k < trialLinearMaps[trial].outerSize(); k++)
+      {
+        for (Eigen::SparseMatrix<s_t>::InnerIterator it(
+                 trialLinearMaps[trial], k);
+             it;
+             ++it)
+        {
+          // (position,velocity) get their own unique block for each trial,
+          // but mass all goes into the same column for every trial
+          int col
+              = it.col() == trialCols - 1 ? massCol : colCursor + it.col();
+          unifiedLinearMapEntries.emplace_back(
+              rowCursor + it.row(), col, it.value());
+        }
+      }
       // original positions get concatenated together
       unifiedPositions.segment(rowCursor, trialTimestepRows)
           = trialOriginalPositions[trial];
@@ -10624,6 +11183,10 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
       colCursor += trialCols - 1;
     }
     assert(colCursor == totalSampledColsWithoutMass);
+    Eigen::SparseMatrix<s_t> unifiedLinearMap(
+        totalSampledRows, totalSampledColsWithoutMass + 1);
+    unifiedLinearMap.setFromTriplets(
+        unifiedLinearMapEntries.begin(), unifiedLinearMapEntries.end());
 
     std::cout << "Solving unified linear COM trajectory map: size = "
               << unifiedLinearMap.rows() << " x " << unifiedLinearMap.cols()
@@ -10634,7 +11197,7 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
     // Eigen::VectorXs tentativeResult =
     // unifiedLinearMap.householderQr().solve(
     //     unifiedPositions - unifiedGravityOffset);
-    Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> solver;
+    Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
     solver.setTolerance(1e-9);
     solver.setMaxIterations(200 * numTrialsToSolveMassOver);
     solver.compute(unifiedLinearMap);
@@ -10719,11 +11282,12 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
         // Otherwise, we have to solve using our found mass
         std::cout << "Solving trial " << trial
                   << " COM trajectory while holding mass fixed" << std::endl;
-        Eigen::MatrixXs A = trialLinearMaps[trial];
+        const Eigen::SparseMatrix<s_t>& A = trialLinearMaps[trial];
         Eigen::VectorXs b = trialOriginalGravityOffsets[trial];
 
-        Eigen::MatrixXs AFixedMass = A.block(0, 0, A.rows(), A.cols() - 1);
-        Eigen::VectorXs bFixedMass = A.col(A.cols() - 1) * (1.0 / foundMass);
+        Eigen::SparseMatrix<s_t> AFixedMass = A.leftCols(A.cols() - 1);
+        Eigen::VectorXs bFixedMass
+            = Eigen::VectorXs(A.col(A.cols() - 1)) * (1.0 / foundMass);
         bFixedMass.segment(0, b.size()) += b;
 
         Eigen::VectorXs desired = Eigen::VectorXs::Zero(bFixedMass.size());
@@ -10734,7 +11298,7 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
         // Old version, direct solve:
         // Eigen::VectorXs localResult
         //     = AFixedMass.householderQr().solve(desired - bFixedMass);
-        Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> solver;
+        Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
         solver.setTolerance(1e-9);
         solver.setMaxIterations(200);
         solver.compute(AFixedMass);
@@ -10828,8 +11392,7 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
 
         Eigen::VectorXs target
             = Eigen::VectorXs::Zero(trialLength * 3 + numBlurs * 3);
-        Eigen::MatrixXs A = Eigen::MatrixXs::Zero(
-            trialLength * 3 + numBlurs * 3, 6 + numBlurs * 3);
+        std::vector<Eigen::Triplet<s_t>> driftCorrectionEntries;
         Eigen::VectorXs b
             = Eigen::VectorXs::Zero(trialLength * 3 + numBlurs * 3);
         b.segment(0, trialLength * 3)
@@ -10852,15 +11415,23 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
         for (int t = 0; t < trialLength; t++)
         {
           target.segment<3>(t * 3) = trialOriginalCOMs[trial][t];
-          // Initial pos change creates a linear offset of output pos
-          A.block<3, 3>(t * 3, 0) = Eigen::Matrix3s::Identity();
-          // Initial vel change creates a dt * t offset of output pos
-          A.block<3, 3>(t * 3, 3) = Eigen::Matrix3s::Identity() * dt * t;
-          // Now work out how each drift-correcting "blur" changes the final
-          // position
-          for (int f = 0; f < numBlurs; f++)
+          for (int axis = 0; axis < 3; axis++)
           {
-            A.block<3, 3>(t * 3, 6 + f * 3).diagonal() = blurOffset[f];
+            // Initial pos change creates a linear offset of output pos
+            driftCorrectionEntries.emplace_back(t * 3 + axis, axis, 1.0);
+            // Initial vel change creates a dt * t offset of output pos
+            driftCorrectionEntries.emplace_back(t * 3 + axis, 3 + axis, dt * t);
+            // Now work out how each drift-correcting "blur" changes the final
+            // position. Blurs haven't done anything until they first start, so
+            // we leave those entries out.
+            for (int f = 0; f < numBlurs; f++)
+            {
+              if (blurOffset[f](axis) != 0)
+              {
+                driftCorrectionEntries.emplace_back(
+                    t * 3 + axis, 6 + f * 3 + axis, blurOffset[f](axis));
+              }
+            }
           }
 
           // Time integrate the blurs
@@ -10885,12 +11456,20 @@ void DynamicsFitter::zeroLinearResidualsOnCOMTrajectory(
         }
         for (int f = 0; f < numBlurs; f++)
         {
-          A.block<3, 3>(trialLength * 3 + f * 3, 6 + f * 3)
-              .diagonal()
-              .setConstant(regularizeBlurs);
+          for (int axis = 0; axis < 3; axis++)
+          {
+            driftCorrectionEntries.emplace_back(
+                trialLength * 3 + f * 3 + axis,
+                6 + f * 3 + axis,
+                regularizeBlurs);
+          }
         }
+        Eigen::SparseMatrix<s_t> A(
+            trialLength * 3 + numBlurs * 3, 6 + numBlurs * 3);
+        A.setFromTriplets(
+            driftCorrectionEntries.begin(), driftCorrectionEntries.end());
 
-        Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> solver;
+        Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
         solver.setTolerance(1e-9);
         solver.setMaxIterations(200);
         solver.compute(A);
@@ -11080,8 +11659,9 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
       = (totalTimesteps * 3) + (totalMissingSteps * 3) + massCols;
 
   // This is the original (uncentered, unconstrained) consolidated linear
-  // system
-  Eigen::MatrixXs A = Eigen::MatrixXs::Zero(outputDims, inputDims);
+  // system. Each trial only touches its own columns and the shared mass
+  // columns, so we assemble it sparse from triplets.
+  std::vector<Eigen::Triplet<s_t>> AEntries;
   Eigen::VectorXs b = Eigen::VectorXs::Zero(outputDims);
   Eigen::VectorXs target = Eigen::VectorXs::Zero(outputDims);
 
@@ -11131,15 +11711,23 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
 
     int trialOutputDims = linearSystem.first.rows();
     int trialInputDimsWithoutMass = linearSystem.first.cols() - massCols;
-    // Ensure the initial conditions and missing timesteps variables go to
-    // unique colums
-    A.block(rowCursor, colCursor, trialOutputDims, trialInputDimsWithoutMass)
-        = linearSystem.first.block(
-            0, 0, trialOutputDims, trialInputDimsWithoutMass);
-    // Ensure the mass variables all go to the same consolidated columns
-    A.block(rowCursor, A.cols() - massCols, trialOutputDims, massCols)
-        = linearSystem.first.block(
-            0, linearSystem.first.cols() - massCols, trialOutputDims, massCols);
+    for (int col = 0; col < linearSystem.first.cols(); col++)
+    {
+      // Ensure the initial conditions and missing timesteps variables go to
+      // unique colums, and the mass variables all go to the same consolidated
+      // columns
+      int ACol = col < trialInputDimsWithoutMass
+                     ? colCursor + col
+                     : inputDims - massCols + (col - trialInputDimsWithoutMass);
+      for (int row = 0; row < trialOutputDims; row++)
+      {
+        if (linearSystem.first(row, col) != 0)
+        {
+          AEntries.emplace_back(
+              rowCursor + row, ACol, linearSystem.first(row, col));
+        }
+      }
+    }
     // Copy output offsets raw
     b.segment(rowCursor, trialOutputDims) = linearSystem.second;
     // Copy over the target - original root positions
@@ -11151,26 +11739,15 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
     // Add regularization for the residuals
     int trialResidualDims = trialInputDimsWithoutMass - 6;
     assert(trialMissingTimesteps[trial] * 3 == trialResidualDims);
-    A.block(
-        regularizationCursor,
-        colCursor + 6,
-        trialResidualDims,
-        trialResidualDims)
-        = Eigen::MatrixXs::Identity(trialResidualDims, trialResidualDims)
-          * regularizeResiduals;
+    for (int i = 0; i < trialResidualDims; i++)
+    {
+      AEntries.emplace_back(
+          regularizationCursor + i, colCursor + 6 + i, regularizeResiduals);
+    }
     regularizationCursor += trialResidualDims;
 
     rowCursor += trialOutputDims;
     colCursor += trialInputDimsWithoutMass;
-
-#ifndef NDEBUG
-    if (numTrials == 1)
-    {
-      assert(
-          A.block(0, 0, linearSystem.first.rows(), linearSystem.first.cols())
-          == linearSystem.first);
-    }
-#endif
   }
   assert(rowCursor == totalTimesteps * 3);
   assert(
@@ -11181,7 +11758,8 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
   ////////////////////////////////////////////////////////////////////////////
 
   // Regularize overall mass
-  A(regularizationCursor, A.cols() - massCols) = regularizeInverseMass;
+  AEntries.emplace_back(
+      regularizationCursor, inputDims - massCols, regularizeInverseMass);
   regularizationCursor++;
 
   Eigen::VectorXs regularizeIndividualMassPercentages
@@ -11192,15 +11770,18 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
   while (true)
   {
     regularizationCursor = restartableRegularizationCursor;
-    A.block(
-        regularizationCursor,
-        A.cols() - massPercentageCols,
-        massPercentageCols,
-        massPercentageCols)
-        = regularizeIndividualMassPercentages.asDiagonal()
-          * regularizeMassPercentages;
+    std::vector<Eigen::Triplet<s_t>> regularizedAEntries = AEntries;
+    for (int i = 0; i < massPercentageCols; i++)
+    {
+      regularizedAEntries.emplace_back(
+          regularizationCursor + i,
+          inputDims - massPercentageCols + i,
+          regularizeIndividualMassPercentages(i) * regularizeMassPercentages);
+    }
     regularizationCursor += massPercentageCols;
-    assert(regularizationCursor == A.rows());
+    assert(regularizationCursor == outputDims);
+    Eigen::SparseMatrix<s_t> A(outputDims, inputDims);
+    A.setFromTriplets(regularizedAEntries.begin(), regularizedAEntries.end());
 
     // Now offset the system to center mass variables at 0
     Eigen::VectorXs centering = Eigen::VectorXs::Zero(inputDims);
@@ -11227,32 +11808,35 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
       Eigen::MatrixXs projectMassToZeroSum
           = Eigen::MatrixXs::Identity(massPercentageCols, massPercentageCols)
             - projectMassToConstantSum;
-      Eigen::MatrixXs totalProjector
-          = Eigen::MatrixXs::Identity(inputDims, inputDims);
-      totalProjector.block(
-          inputDims - massPercentageCols,
-          inputDims - massPercentageCols,
-          massPercentageCols,
-          massPercentageCols)
-          = projectMassToZeroSum;
-
-      Eigen::MatrixXs totalPerpendicularProjector
-          = Eigen::MatrixXs::Identity(outputDims, inputDims);
-      totalPerpendicularProjector.block(
-          outputDims - massPercentageCols,
-          inputDims - massPercentageCols,
-          massPercentageCols,
-          massPercentageCols)
-          = projectMassToConstantSum;
-
-      Eigen::MatrixXs bottDuffinRHS = (A * totalProjector);
+      // The projector is the identity everywhere except the (small, dense)
+      // mass percentage block, so it stays sparse, and so does A * projector
+      std::vector<Eigen::Triplet<s_t>> totalProjectorEntries;
+      for (int i = 0; i < inputDims - massPercentageCols; i++)
+      {
+        totalProjectorEntries.emplace_back(i, i, 1.0);
+      }
+      for (int col = 0; col < massPercentageCols; col++)
+      {
+        for (int row = 0; row < massPercentageCols; row++)
+        {
+          totalProjectorEntries.emplace_back(
+              inputDims - massPercentageCols + row,
+              inputDims - massPercentageCols + col,
+              projectMassToZeroSum(row, col));
+        }
+      }
+      Eigen::SparseMatrix<s_t> totalProjector(inputDims, inputDims);
+      totalProjector.setFromTriplets(
+          totalProjectorEntries.begin(), totalProjectorEntries.end());
+
+      Eigen::SparseMatrix<s_t> bottDuffinRHS = A * totalProjector;
 
       // Old version, direct solve:
       // Eigen::VectorXs unconstrainedSolution
       //     = bottDuffinRHS.completeOrthogonalDecomposition().solve(
       //         target - offsetB);
 
-      Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> solver;
+      Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
       solver.setTolerance(1e-9);
       solver.setMaxIterations(200);
       solver.compute(bottDuffinRHS);
@@ -11284,7 +11868,7 @@ void DynamicsFitter::multimassZeroLinearResidualsOnCOMTrajectory(
       // Old version, direct solve:
       // centeredSolution
       //     = A.completeOrthogonalDecomposition().solve(target - offsetB);
-      Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> solver;
+      Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
       solver.setTolerance(1e-9);
       solver.setMaxIterations(200);
       solver.compute(A);
@@ -11782,246 +12366,512 @@ std::pair<bool, double> DynamicsFitter::zeroLinearResidualsAndOptimizeAngular(
 }
 
 //==============================================================================
-// 1. This runs a number of zeroLinearResidualsAndOptimizeAngular() pipelines,
-// each with different number of timesteps offset between the force plates and
-// the marker data, and returns the best match (minimum marker error at 0
-// residuals).
-bool DynamicsFitter::timeSyncTrialGRF(
+// This copies entry `trial` of `from` onto the end of `to`, if there is one
+template <typename T>
+static void copyTrialEntry(
+    const std::vector<T>& from, int trial, std::vector<T>& to)
+{
+  if (trial < (int)from.size())
+  {
+    to.push_back(from[trial]);
+  }
+}
+
+//==============================================================================
+// This copies a single trial out of `init`, as the only trial of a new
+// initialization, with its body nodes and joints looked up by name on
+// `skel`. This lets a clone of the Skeleton work on the trial on another
+// thread, without touching the original.
+std::shared_ptr<DynamicsInitialization> DynamicsFitter::copyTrialForSkeleton(
     std::shared_ptr<DynamicsInitialization> init,
     int trial,
-    bool useReactionWheels,
-    int maxShiftGRF,
-    int iterationsPerShift,
-    s_t weightLinear,
-    s_t weightAngular,
-    s_t regularizeLinearResiduals,
-    s_t regularizeAngularResiduals,
-    s_t regularizeCopDriftCompensation,
-    int maxBuckets)
+    std::shared_ptr<dynamics::Skeleton> skel)
 {
-  Eigen::MatrixXs originalGRFTrial = init->grfTrials[trial];
-  Eigen::MatrixXs originalPoseTrial = init->poseTrials[trial];
+  std::shared_ptr<DynamicsInitialization> copy
+      = std::make_shared<DynamicsInitialization>();
 
-  std::vector<std::vector<Eigen::Vector3s>> originalCOPs;
-  std::vector<std::vector<Eigen::Vector3s>> originalForces;
-  std::vector<std::vector<Eigen::Vector3s>> originalMoments;
-  for (auto& originalPlate : init->forcePlateTrials[trial])
+  copyTrialEntry(init->forcePlateTrials, trial, copy->forcePlateTrials);
+  copyTrialEntry(init->originalPoses, trial, copy->originalPoses);
+  copyTrialEntry(
+      init->markerObservationTrials, trial, copy->markerObservationTrials);
+  copyTrialEntry(init->trialTimesteps, trial, copy->trialTimesteps);
+
+  copyTrialEntry(init->grfTrials, trial, copy->grfTrials);
+  copy->grfBodyIndices = init->grfBodyIndices;
+  for (dynamics::BodyNode* body : init->grfBodyNodes)
+  {
+    copy->grfBodyNodes.push_back(skel->getBodyNode(body->getName()));
+  }
+
+  copyTrialEntry(init->perfectGrfTrials, trial, copy->perfectGrfTrials);
+  copyTrialEntry(init->perfectTorques, trial, copy->perfectTorques);
+  copyTrialEntry(
+      init->perfectGrfAsCopTorqueForces,
+      trial,
+      copy->perfectGrfAsCopTorqueForces);
+  copyTrialEntry(
+      init->perfectForcePlateTrials, trial, copy->perfectForcePlateTrials);
+
+  copyTrialEntry(init->groundHeight, trial, copy->groundHeight);
+  copyTrialEntry(init->flatGround, trial, copy->flatGround);
+  if (trial < (int)init->contactBodies.size())
+  {
+    std::vector<dynamics::BodyNode*> contactBodies;
+    for (dynamics::BodyNode* body : init->contactBodies[trial])
+    {
+      contactBodies.push_back(skel->getBodyNode(body->getName()));
+    }
+    copy->contactBodies.push_back(contactBodies);
+  }
+  copyTrialEntry(
+      init->grfBodyContactSphereRadius,
+      trial,
+      copy->grfBodyContactSphereRadius);
+  copyTrialEntry(init->grfBodyForceActive, trial, copy->grfBodyForceActive);
+  copyTrialEntry(
+      init->grfBodySphereInContact, trial, copy->grfBodySphereInContact);
+  copyTrialEntry(
+      init->defaultForcePlateCorners, trial, copy->defaultForcePlateCorners);
+  copyTrialEntry(init->grfBodyOffForcePlate, trial, copy->grfBodyOffForcePlate);
+  copyTrialEntry(init->probablyMissingGRF, trial, copy->probablyMissingGRF);
+  copyTrialEntry(
+      init->forcePlatesAssignedToContactBody,
+      trial,
+      copy->forcePlatesAssignedToContactBody);
+  copyTrialEntry(init->reactionWheels, trial, copy->reactionWheels);
+
+  copy->bodyMasses = init->bodyMasses;
+  copy->groupMasses = init->groupMasses;
+  copy->bodyCom = init->bodyCom;
+  copy->bodyInertia = init->bodyInertia;
+  copy->groupInertias = init->groupInertias;
+
+  copyTrialEntry(init->poseTrials, trial, copy->poseTrials);
+  copy->groupScales = init->groupScales;
+  copy->markerOffsets = init->markerOffsets;
+  copy->trackingMarkers = init->trackingMarkers;
+  for (dynamics::Joint* joint : init->joints)
+  {
+    copy->joints.push_back(skel->getJoint(joint->getName()));
+  }
+  copy->jointsAdjacentMarkers = init->jointsAdjacentMarkers;
+  copy->jointWeights = init->jointWeights;
+  copyTrialEntry(init->jointCenters, trial, copy->jointCenters);
+  copy->axisWeights = init->axisWeights;
+  copyTrialEntry(init->jointAxis, trial, copy->jointAxis);
+  for (auto& pair : init->updatedMarkerMap)
   {
-    std::vector<Eigen::Vector3s> cops;
-    std::vector<Eigen::Vector3s> forces;
-    std::vector<Eigen::Vector3s> moments;
-    for (int t = 0; t < originalPlate.centersOfPressure.size(); t++)
+    copy->updatedMarkerMap[pair.first] = std::make_pair(
+        skel->getBodyNode(pair.second.first->getName()), pair.second.second);
+  }
+
+  copy->initialGroupMasses = init->initialGroupMasses;
+  copy->initialGroupCOMs = init->initialGroupCOMs;
+  copy->initialGroupInertias = init->initialGroupInertias;
+  copy->initialGroupScales = init->initialGroupScales;
+  copy->initialMarkerOffsets = init->initialMarkerOffsets;
+
+  copyTrialEntry(init->regularizePosesTo, trial, copy->regularizePosesTo);
+  copy->regularizeGroupMassesTo = init->regularizeGroupMassesTo;
+  copy->regularizeGroupCOMsTo = init->regularizeGroupCOMsTo;
+  copy->regularizeGroupInertiasTo = init->regularizeGroupInertiasTo;
+  copy->regularizeGroupScalesTo = init->regularizeGroupScalesTo;
+  copy->regularizeMarkerOffsetsTo = init->regularizeMarkerOffsetsTo;
+
+  return copy;
+}
+
+//==============================================================================
+// This makes a quick guess at the GRF shift for a trial, by finding the
+// lag (up to `maxShiftGRF`) with the best FFT cross-correlation between
+// impliedCOMForces() and measuredGRFForces()
+int DynamicsFitter::estimateGRFShift(
+    std::shared_ptr<DynamicsInitialization> init, int trial, int maxShiftGRF)
+{
+  if (maxShiftGRF <= 0 || init->poseTrials[trial].cols() < 3)
+  {
+    return 0;
+  }
+
+  // The implied forces are missing the first and last timesteps, since they
+  // come from finite differenced accelerations
+  std::vector<Eigen::Vector3s> implied = impliedCOMForces(init, trial);
+  std::vector<Eigen::Vector3s> measured = measuredGRFForces(init, trial);
+  const int numTimesteps = implied.size();
+
+  Eigen::MatrixXs impliedMatrix = Eigen::MatrixXs::Zero(3, numTimesteps);
+  Eigen::MatrixXs measuredMatrix = Eigen::MatrixXs::Zero(3, numTimesteps);
+  std::vector<bool> missing(numTimesteps, false);
+  Eigen::Vector3s impliedMean = Eigen::Vector3s::Zero();
+  Eigen::Vector3s measuredMean = Eigen::Vector3s::Zero();
+  int numPresent = 0;
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    impliedMatrix.col(t) = implied[t];
+    measuredMatrix.col(t) = measured[t + 1];
+    missing[t] = init->probablyMissingGRF.size() > trial
+                 && init->probablyMissingGRF[trial][t + 1];
+    if (!missing[t])
     {
-      cops.push_back(originalPlate.centersOfPressure[t]);
-      forces.push_back(originalPlate.forces[t]);
-      moments.push_back(originalPlate.moments[t]);
+      impliedMean += implied[t];
+      measuredMean += measured[t + 1];
+      numPresent++;
     }
-    originalCOPs.push_back(cops);
-    originalForces.push_back(forces);
-    originalMoments.push_back(moments);
   }
-  std::vector<bool> originalProbablyMissingGRF;
-  for (int t = 0; t < init->probablyMissingGRF[trial].size(); t++)
+  if (numPresent == 0)
   {
-    originalProbablyMissingGRF.push_back(init->probablyMissingGRF[trial][t]);
+    return 0;
   }
 
-  bool atLeastOneShiftSucceeded = false;
-  int bestShiftGRF = 0;
-  s_t bestShiftGRFScore = std::numeric_limits<s_t>::infinity();
-  Eigen::MatrixXs bestShiftGRFTrial = originalGRFTrial;
-  Eigen::MatrixXs bestShiftPoseTrial = originalPoseTrial;
-  // Start with the smallest shifts away from zero first, so if we abort early,
-  // we know it's not because we shifted too far to start with.
-  std::vector<int> shifts;
-  shifts.push_back(0);
-  for (int i = 1; i <= maxShiftGRF; ++i)
+  // Frames where we're missing GRF data would look like a mismatch at every
+  // lag, so we flatten them out to the mean, where they don't count for or
+  // against any lag
+  impliedMean /= numPresent;
+  measuredMean /= numPresent;
+  for (int t = 0; t < numTimesteps; t++)
   {
-    shifts.push_back(i);
-    shifts.push_back(-i);
+    if (missing[t])
+    {
+      impliedMatrix.col(t) = impliedMean;
+      measuredMatrix.col(t) = measuredMean;
+    }
+  }
+
+  return math::CrossCorrelation::findBestLag(
+      impliedMatrix, measuredMatrix, maxShiftGRF);
+}
+
+//==============================================================================
+// This is the GRF data for one trial, before it's shifted in time
+struct UnshiftedTrialGRF
+{
+  Eigen::MatrixXs grf;
+  std::vector<std::vector<Eigen::Vector3s>> cops;
+  std::vector<std::vector<Eigen::Vector3s>> forces;
+  std::vector<std::vector<Eigen::Vector3s>> moments;
+  std::vector<bool> probablyMissingGRF;
+};
+
+//==============================================================================
+// This overwrites the GRF data, force plates and missing GRF flags of `trial`
+// with `original` shifted by `shiftGRF` timesteps
+static void applyGRFShift(
+    std::shared_ptr<DynamicsInitialization> init,
+    int trial,
+    const UnshiftedTrialGRF& original,
+    int shiftGRF)
+{
+  Eigen::MatrixXs shiftedGRFTrial = original.grf;
+  for (int t = 0; t < shiftedGRFTrial.cols(); t++)
+  {
+    // We want a shift of "-2" to result in the shiftedGRFTrial having its
+    // entries shifted to the left by 2, so that means grabbing "+2" columns
+    // from the original relative to itself.
+    int originalT = t - shiftGRF;
+    if (originalT < 0 || originalT >= original.grf.cols())
+    {
+      shiftedGRFTrial.col(t).setZero();
+      init->probablyMissingGRF[trial][t] = true;
+    }
+    else
+    {
+      shiftedGRFTrial.col(t) = original.grf.col(originalT);
+      init->probablyMissingGRF[trial][t]
+          = original.probablyMissingGRF[originalT];
+    }
   }
+  init->grfTrials[trial] = shiftedGRFTrial;
 
-  for (int shiftGRF : shifts)
+  for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
   {
-    std::cout << "Attempting GRF shift " << shiftGRF << "." << std::endl;
-    Eigen::MatrixXs shiftedGRFTrial = originalGRFTrial;
+    auto& plate = init->forcePlateTrials[trial][i];
+    std::vector<Eigen::Vector3s> shiftedCOPs;
+    std::vector<Eigen::Vector3s> shiftedForces;
+    std::vector<Eigen::Vector3s> shiftedMoments;
     for (int t = 0; t < shiftedGRFTrial.cols(); t++)
     {
-      // We want a shift of "-2" to result in the shiftedGRFTrial having its
-      // entries shifted to the left by 2, so that means grabbing "+2" columns
-      // from the original relative to itself.
       int originalT = t - shiftGRF;
-      if (originalT < 0 || originalT >= originalGRFTrial.cols())
+      if (originalT < 0 || originalT >= original.grf.cols())
       {
-        shiftedGRFTrial.col(t).setZero();
-        init->probablyMissingGRF[trial][t] = true;
+        shiftedCOPs.push_back(Eigen::Vector3s::Zero());
+        shiftedForces.push_back(Eigen::Vector3s::Zero());
+        shiftedMoments.push_back(Eigen::Vector3s::Zero());
       }
       else
       {
-        shiftedGRFTrial.col(t) = originalGRFTrial.col(originalT);
-        init->probablyMissingGRF[trial][t]
-            = originalProbablyMissingGRF[originalT];
+        shiftedCOPs.push_back(original.cops[i][originalT]);
+        shiftedForces.push_back(original.forces[i][originalT]);
+        shiftedMoments.push_back(original.moments[i][originalT]);
       }
     }
+    plate.centersOfPressure = shiftedCOPs;
+    plate.forces = shiftedForces;
+    plate.moments = shiftedMoments;
+  }
+}
 
-    for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
-    {
-      auto& plate = init->forcePlateTrials[trial][i];
-      std::vector<Eigen::Vector3s> shiftedCOPs;
-      std::vector<Eigen::Vector3s> shiftedForces;
-      std::vector<Eigen::Vector3s> shiftedMoments;
-      for (int t = 0; t < shiftedGRFTrial.cols(); t++)
-      {
-        int originalT = t - shiftGRF;
-        if (originalT < 0 || originalT >= originalGRFTrial.cols())
-        {
-          shiftedCOPs.push_back(Eigen::Vector3s::Zero());
-          shiftedForces.push_back(Eigen::Vector3s::Zero());
-          shiftedMoments.push_back(Eigen::Vector3s::Zero());
-        }
-        else
-        {
-          shiftedCOPs.push_back(originalCOPs[i][originalT]);
-          shiftedForces.push_back(originalForces[i][originalT]);
-          shiftedMoments.push_back(originalMoments[i][originalT]);
-        }
-      }
-      plate.centersOfPressure = shiftedCOPs;
-      plate.forces = shiftedForces;
-      plate.moments = shiftedMoments;
-    }
+//==============================================================================
+// 1. This runs a number of zeroLinearResidualsAndOptimizeAngular() pipelines,
+// each with different number of timesteps offset between the force plates and
+// the marker data, and returns the best match (minimum marker error at 0
+// residuals).
+bool DynamicsFitter::timeSyncTrialGRF(
+    std::shared_ptr<DynamicsInitialization> init,
+    int trial,
+    bool useReactionWheels,
+    int maxShiftGRF,
+    int iterationsPerShift,
+    s_t weightLinear,
+    s_t weightAngular,
+    s_t regularizeLinearResiduals,
+    s_t regularizeAngularResiduals,
+    s_t regularizeCopDriftCompensation,
+    int maxBuckets,
+    int fineShiftRadius)
+{
+  return timeSyncTrialsGRF(
+      init,
+      std::vector<int>{trial},
+      useReactionWheels,
+      maxShiftGRF,
+      iterationsPerShift,
+      weightLinear,
+      weightAngular,
+      regularizeLinearResiduals,
+      regularizeAngularResiduals,
+      regularizeCopDriftCompensation,
+      maxBuckets,
+      fineShiftRadius);
+}
 
-    init->poseTrials[trial] = originalPoseTrial;
-    init->grfTrials[trial] = shiftedGRFTrial;
+//==============================================================================
+// 1. This is the same as timeSyncTrialGRF(), but for several trials at once,
+// with all the shifts of all the trials run in parallel.
+bool DynamicsFitter::timeSyncTrialsGRF(
+    std::shared_ptr<DynamicsInitialization> init,
+    std::vector<int> trials,
+    bool useReactionWheels,
+    int maxShiftGRF,
+    int iterationsPerShift,
+    s_t weightLinear,
+    s_t weightAngular,
+    s_t regularizeLinearResiduals,
+    s_t regularizeAngularResiduals,
+    s_t regularizeCopDriftCompensation,
+    int maxBuckets,
+    int fineShiftRadius)
+{
+  // Reaction wheels make the problem perfectly linear, so we don't need any
+  // iterations if we're using them.
+  if (useReactionWheels)
+  {
+    iterationsPerShift = 1;
+  }
 
-    // Reaction wheels make the problem perfectly linear, so we don't need any
-    // iterations if we're using them.
-    if (useReactionWheels)
-    {
-      iterationsPerShift = 1;
-    }
+  // Each shift gets run on its own copy of the trial, with its own clone of
+  // the Skeleton, so that they can all run at once without sharing any state.
+  struct ShiftAttempt
+  {
+    int trialIndex;
+    int shiftGRF;
+    std::shared_ptr<dynamics::Skeleton> skel;
+    std::vector<dynamics::BodyNode*> footNodes;
+    std::shared_ptr<DynamicsInitialization> init;
+    bool success;
+    s_t score;
+  };
 
-    bool residualMinimizationSuccess = true;
-    s_t previousTotalResidual = std::numeric_limits<s_t>::infinity();
-    for (int i = 0; i < iterationsPerShift; i++)
+  std::vector<UnshiftedTrialGRF> originals;
+  std::vector<std::vector<int>> trialAttempts;
+  std::vector<ShiftAttempt> attempts;
+  for (int trialIndex = 0; trialIndex < trials.size(); trialIndex++)
+  {
+    int trial = trials[trialIndex];
+    UnshiftedTrialGRF original;
+    original.grf = init->grfTrials[trial];
+    for (auto& plate : init->forcePlateTrials[trial])
     {
-      auto output = zeroLinearResidualsAndOptimizeAngular(
-          init,
-          trial,
-          originalPoseTrial,
-          previousTotalResidual,
-          i,
-          useReactionWheels,
-          weightLinear,
-          weightAngular,
-          regularizeLinearResiduals,
-          regularizeAngularResiduals,
-          regularizeCopDriftCompensation,
-          maxBuckets,
-          500,
-          false,
-          false);
-      previousTotalResidual = output.second;
-
-      if (!output.first)
+      std::vector<Eigen::Vector3s> cops;
+      std::vector<Eigen::Vector3s> forces;
+      std::vector<Eigen::Vector3s> moments;
+      for (int t = 0; t < plate.centersOfPressure.size(); t++)
       {
-        std::cout << "Minimizing residuals for shift " << shiftGRF << " failed."
-                  << "Aborting..." << std::endl;
-        residualMinimizationSuccess = false;
-        break;
+        cops.push_back(plate.centersOfPressure[t]);
+        forces.push_back(plate.forces[t]);
+        moments.push_back(plate.moments[t]);
+      }
+      original.cops.push_back(cops);
+      original.forces.push_back(forces);
+      original.moments.push_back(moments);
+    }
+    for (int t = 0; t < init->probablyMissingGRF[trial].size(); t++)
+    {
+      original.probablyMissingGRF.push_back(
+          init->probablyMissingGRF[trial][t]);
+    }
+    originals.push_back(original);
+
+    // Start with the smallest shifts away from our best guess first, so if we
+    // abort early, we know it's not because we shifted too far to start with.
+    int centerShift = 0;
+    int minShift = -maxShiftGRF;
+    int maxShift = maxShiftGRF;
+    if (fineShiftRadius >= 0)
+    {
+      centerShift = estimateGRFShift(init, trial, maxShiftGRF);
+      minShift = std::max(-maxShiftGRF, centerShift - fineShiftRadius);
+      maxShift = std::min(maxShiftGRF, centerShift + fineShiftRadius);
+      std::cout << "Cross-correlation puts the GRF shift for trial " << trial
+                << " at about " << centerShift << " timesteps." << std::endl;
+    }
+    std::vector<int> shifts;
+    shifts.push_back(centerShift);
+    for (int i = 1; i <= maxShift - minShift; ++i)
+    {
+      if (centerShift + i <= maxShift)
+        shifts.push_back(centerShift + i);
+      if (centerShift - i >= minShift)
+        shifts.push_back(centerShift - i);
+    }
+
+    std::vector<int> thisTrialAttempts;
+    for (int shiftGRF : shifts)
+    {
+      ShiftAttempt attempt;
+      attempt.trialIndex = trialIndex;
+      attempt.shiftGRF = shiftGRF;
+      attempt.skel = mSkeleton->cloneSkeleton();
+      attempt.skel->setGroupScales(mSkeleton->getGroupScales());
+      attempt.skel->setGroupMasses(mSkeleton->getGroupMasses());
+      attempt.skel->setGroupCOMs(mSkeleton->getGroupCOMs());
+      attempt.skel->setGroupInertias(mSkeleton->getGroupInertias());
+      attempt.skel->setGravity(mSkeleton->getGravity());
+      attempt.skel->setTimeStep(mSkeleton->getTimeStep());
+      for (dynamics::BodyNode* foot : mFootNodes)
+      {
+        attempt.footNodes.push_back(
+            attempt.skel->getBodyNode(foot->getName()));
+      }
+      attempt.init = copyTrialForSkeleton(init, trial, attempt.skel);
+      applyGRFShift(attempt.init, 0, original, shiftGRF);
+      attempt.success = false;
+      attempt.score = std::numeric_limits<s_t>::infinity();
+      thisTrialAttempts.push_back(attempts.size());
+      attempts.push_back(attempt);
+    }
+    trialAttempts.push_back(thisTrialAttempts);
+  }
+
+  std::vector<common::TaskFuture<void>> futures;
+  for (int i = 0; i < attempts.size(); i++)
+  {
+    futures.push_back(common::async([&attempts,
+                                     i,
+                                     this,
+                                     iterationsPerShift,
+                                     useReactionWheels,
+                                     weightLinear,
+                                     weightAngular,
+                                     regularizeLinearResiduals,
+                                     regularizeAngularResiduals,
+                                     regularizeCopDriftCompensation,
+                                     maxBuckets] {
+      ShiftAttempt& attempt = attempts[i];
+      DynamicsFitter fitter(attempt.skel, attempt.footNodes, mTrackingMarkers);
+      Eigen::MatrixXs originalPoseTrial = attempt.init->poseTrials[0];
+
+      s_t previousTotalResidual = std::numeric_limits<s_t>::infinity();
+      for (int iter = 0; iter < iterationsPerShift; iter++)
+      {
+        auto output = fitter.zeroLinearResidualsAndOptimizeAngular(
+            attempt.init,
+            0,
+            originalPoseTrial,
+            previousTotalResidual,
+            iter,
+            useReactionWheels,
+            weightLinear,
+            weightAngular,
+            regularizeLinearResiduals,
+            regularizeAngularResiduals,
+            regularizeCopDriftCompensation,
+            maxBuckets,
+            500,
+            false,
+            false);
+        previousTotalResidual = output.second;
+        if (!output.first)
+        {
+          return;
+        }
       }
-    }
-
-    // Don't include this trial if residual minimization failed.
-    if (!residualMinimizationSuccess) break;
-
-    // Now score the trial
-    s_t score = 0;
-    atLeastOneShiftSucceeded = true;
-    if (useReactionWheels)
-    {
-      score = computeAverageReactionWheelRMSE(init, trial);
-      std::cout << "Shift " << shiftGRF << " got " << score
-                << "rad (reaction wheel RMSE)" << std::endl;
-    }
-    else
-    {
-      score = computeAverageTrialMarkerRMSE(init, trial);
-      std::cout << "Shift " << shiftGRF << " got " << score << "m RMSE"
-                << std::endl;
-    }
-    if (score < bestShiftGRFScore)
-    {
-      bestShiftGRFScore = score;
-      bestShiftGRF = shiftGRF;
-      bestShiftGRFTrial = init->grfTrials[trial];
-      bestShiftPoseTrial = init->poseTrials[trial];
-    }
-  }
 
-  if (useReactionWheels)
-  {
-    std::cout << "Best shift was: " << bestShiftGRF << " timesteps, with "
-              << bestShiftGRFScore << "rad (reaction wheel RMSE)" << std::endl;
+      attempt.success = true;
+      if (useReactionWheels)
+      {
+        attempt.score = fitter.computeAverageReactionWheelRMSE(attempt.init, 0);
+      }
+      else
+      {
+        attempt.score = fitter.computeAverageTrialMarkerRMSE(attempt.init, 0);
+      }
+    }));
   }
-  else
+  for (int i = 0; i < futures.size(); i++)
   {
-    std::cout << "Best shift was: " << bestShiftGRF << " timesteps, with "
-              << bestShiftGRFScore << "m RMSE" << std::endl;
+    futures[i].get();
   }
-  init->grfTrials[trial] = bestShiftGRFTrial;
-  init->poseTrials[trial] = bestShiftPoseTrial;
 
-  // update force plates to reflect shift
-  for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
+  bool allTrialsSucceeded = true;
+  for (int trialIndex = 0; trialIndex < trials.size(); trialIndex++)
   {
-    auto& plate = init->forcePlateTrials[trial][i];
-    std::vector<Eigen::Vector3s> shiftedCOPs;
-    std::vector<Eigen::Vector3s> shiftedForces;
-    std::vector<Eigen::Vector3s> shiftedMoments;
-    for (int t = 0; t < bestShiftGRFTrial.cols(); t++)
+    int trial = trials[trialIndex];
+
+    // We only trust shifts up to the first one that failed, the same as if
+    // we'd tried them one at a time in order and given up at that point
+    int bestAttempt = -1;
+    for (int i : trialAttempts[trialIndex])
     {
-      // We want a shift of "-2" to result in the shiftedGRFTrial having its
-      // entries shifted to the left by 2, so that means grabbing "+2"
-      // columns from the original relative to itself.
-      int originalT = t - bestShiftGRF;
-      if (originalT < 0 || originalT >= originalGRFTrial.cols())
+      const ShiftAttempt& attempt = attempts[i];
+      if (!attempt.success)
       {
-        shiftedCOPs.push_back(Eigen::Vector3s::Zero());
-        shiftedForces.push_back(Eigen::Vector3s::Zero());
-        shiftedMoments.push_back(Eigen::Vector3s::Zero());
+        std::cout << "Minimizing residuals for shift " << attempt.shiftGRF
+                  << " on trial " << trial << " failed." << std::endl;
+        break;
       }
-      else
+      std::cout << "Shift " << attempt.shiftGRF << " on trial " << trial
+                << " got " << attempt.score
+                << (useReactionWheels ? "rad (reaction wheel RMSE)" : "m RMSE")
+                << std::endl;
+      if (bestAttempt == -1 || attempt.score < attempts[bestAttempt].score)
       {
-        shiftedCOPs.push_back(originalCOPs[i][originalT]);
-        shiftedForces.push_back(originalForces[i][originalT]);
-        shiftedMoments.push_back(originalMoments[i][originalT]);
+        bestAttempt = i;
       }
     }
-    plate.centersOfPressure = shiftedCOPs;
-    plate.forces = shiftedForces;
-    plate.moments = shiftedMoments;
-  }
-  for (int t = 0; t < bestShiftGRFTrial.cols(); t++)
-  {
-    // We want a shift of "-2" to result in the shiftedGRFTrial having its
-    // entries shifted to the left by 2, so that means grabbing "+2"
-    // columns from the original relative to itself.
-    int originalT = t - bestShiftGRF;
-    if (originalT < 0 || originalT >= originalGRFTrial.cols())
+
+    // Return failure if no shifts succeed, and leave the trial as it was
+    if (bestAttempt == -1)
     {
-      init->probablyMissingGRF[trial][t] = true;
+      allTrialsSucceeded = false;
+      continue;
     }
-    else
+
+    const ShiftAttempt& best = attempts[bestAttempt];
+    std::cout << "Best shift for trial " << trial << " was: " << best.shiftGRF
+              << " timesteps, with " << best.score
+              << (useReactionWheels ? "rad (reaction wheel RMSE)" : "m RMSE")
+              << std::endl;
+    // update force plates to reflect shift
+    applyGRFShift(init, trial, originals[trialIndex], best.shiftGRF);
+    init->grfTrials[trial] = best.init->grfTrials[0];
+    init->poseTrials[trial] = best.init->poseTrials[0];
+    if (useReactionWheels)
     {
-      init->probablyMissingGRF[trial][t]
-          = originalProbablyMissingGRF[originalT];
+      init->reactionWheels[trial] = best.init->reactionWheels[0];
     }
   }
 
-  // Return failure if no shifts succeed.
-  if (!atLeastOneShiftSucceeded) return false;
-  return true;
+  return allTrialsSucceeded;
 }
 
 //==============================================================================
@@ -12063,14 +12913,15 @@ bool DynamicsFitter::timeSyncAndInitializePipeline(
   // Attempt to time sync the GRFs relative to the coordinate data.
   if (shiftGRF)
   {
-    bool timeSyncSuccess = true;
+    std::vector<int> trials;
     for (int trial = 0; trial < init->poseTrials.size(); trial++)
     {
-      timeSyncSuccess = timeSyncTrialGRF(
-          init, trial, useReactionWheels, maxShiftGRF, iterationsPerShift);
-      if (!timeSyncSuccess)
-        return false;
+      trials.push_back(trial);
     }
+    bool timeSyncSuccess = timeSyncTrialsGRF(
+        init, trials, useReactionWheels, maxShiftGRF, iterationsPerShift);
+    if (!timeSyncSuccess)
+      return false;
   }
 
   // Reset the pose trials now that we've found the GRF data, and start again
@@ -12931,29 +13782,66 @@ void DynamicsFitter::optimizeMarkerOffsets(
 void DynamicsFitter::recomputeGRFs(
     std::shared_ptr<DynamicsInitialization> init,
     std::shared_ptr<dynamics::Skeleton> skel,
-    int trial)
+    int trial,
+    int numThreads)
 {
-  std::vector<ForcePlate> forcePlates = init->forcePlateTrials[trial];
+  const std::vector<ForcePlate>& forcePlates = init->forcePlateTrials[trial];
 
   Eigen::MatrixXs& poses = init->poseTrials[trial];
 
   init->grfTrials[trial].setZero();
 
-  // Precompute the foot locations over time
-  std::vector<std::vector<Eigen::Vector3s>> footLocations;
-  for (int t = 0; t < poses.cols(); t++)
+  // Precompute the foot locations over time, as columns of 3-vectors
+  const int numFeet = init->grfBodyNodes.size();
+  Eigen::MatrixXs footLocationMatrix
+      = Eigen::MatrixXs::Zero(numFeet * 3, poses.cols());
+  auto fillFootLocations = [&](std::shared_ptr<dynamics::Skeleton> threadSkel,
+                               int start,
+                               int end) {
+    std::vector<dynamics::BodyNode*> feet;
+    for (int i = 0; i < numFeet; i++)
+    {
+      feet.push_back(threadSkel->getBodyNode(init->grfBodyNodes[i]->getName()));
+    }
+    for (int t = start; t < end; t++)
+    {
+      threadSkel->setPositions(poses.col(t));
+      for (int i = 0; i < numFeet; i++)
+      {
+        footLocationMatrix.block<3, 1>(i * 3, t)
+            = feet[i]->getWorldTransform().translation();
+      }
+    }
+  };
+  if (numThreads <= 0)
+  {
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)poses.cols()));
+  if (numThreads == 1)
+  {
+    fillFootLocations(skel, 0, poses.cols());
+  }
+  else
   {
-    skel->setPositions(poses.col(t));
-    std::vector<Eigen::Vector3s> footLocationsThisTimestep;
-    for (int i = 0; i < init->grfBodyNodes.size(); i++)
+    // Each thread gets its own clone of the skeleton, and a contiguous block
+    // of timesteps. The positions are computed exactly as they would be in
+    // serial, so the results don't depend on the number of threads.
+    std::vector<common::TaskFuture<void>> futures;
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
     {
-      Eigen::Vector3s footLoc
-          = skel->getBodyNode(init->grfBodyNodes[i]->getName())
-                ->getWorldTransform()
-                .translation();
-      footLocationsThisTimestep.push_back(footLoc);
+      int start = poses.cols() * threadIdx / numThreads;
+      int end = poses.cols() * (threadIdx + 1) / numThreads;
+      std::shared_ptr<dynamics::Skeleton> threadSkel = skel->cloneSkeleton();
+      futures.push_back(common::async(
+          [&fillFootLocations, threadSkel, start, end] {
+            fillFootLocations(threadSkel, start, end);
+          }));
+    }
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+      futures[threadIdx].get();
     }
-    footLocations.push_back(footLocationsThisTimestep);
   }
 
   for (int i = 0; i < forcePlates.size(); i++)
@@ -13019,7 +13907,8 @@ void DynamicsFitter::recomputeGRFs(
         lastStartedTrack = t;
       for (int b = 0; b < init->grfBodyNodes.size(); b++)
       {
-        sumSquaredDistances(b) += (footLocations[t][b] - cop).squaredNorm();
+        sumSquaredDistances(b)
+            += (footLocationMatrix.block<3, 1>(b * 3, t) - cop).squaredNorm();
       }
     }
 
@@ -13923,20 +14812,41 @@ void DynamicsFitter::runIPOPTOptimization(
   // call this (at least prior to Eigen 3.3)
   Eigen::initParallel();
 
+  // If the last call left behind a problem with the same structure, and the
+  // settings that shape IPOPT's algorithm haven't changed, we re-solve that
+  // same problem object. That lets IPOPT skip re-analyzing the problem's
+  // structure and rebuilding its algorithm.
+  std::tuple<bool, int, bool> algorithmSettings = std::make_tuple(
+      mUseExactHessian, mLBFGSHistoryLength, mCheckDerivatives);
+  const bool reoptimize = IsValid(mIpopt) && IsValid(mIpoptProblem)
+                          && algorithmSettings == mIpoptAlgorithmSettings
+                          && mIpoptProblem->hasSameStructure(init, config);
+  if (!reoptimize)
+  {
+    // Let go of the old problem before we build a new one
+    mIpopt = nullptr;
+    mIpoptProblem = nullptr;
+  }
+
   // Create an instance of the IpoptApplication
   //
   // We are using the factory, since this allows us to compile this
   // example with an Ipopt Windows DLL
-  SmartPtr<Ipopt::IpoptApplication> app = IpoptApplicationFactory();
+  SmartPtr<Ipopt::IpoptApplication> app = mIpopt;
+  if (!reoptimize)
+  {
+    app = IpoptApplicationFactory();
+  }
 
-  // Change some options
+  // Change some options. When we re-solve, IPOPT re-reads these.
   app->Options()->SetNumericValue("tol", static_cast<double>(mTolerance));
   app->Options()->SetStringValue(
       "linear_solver",
       "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
 
   app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
+      "hessian_approximation",
+      mUseExactHessian ? "exact" : "limited-memory"); // limited-memory, exact
 
   /*
   app->Options()->SetStringValue(
@@ -13995,13 +14905,16 @@ void DynamicsFitter::runIPOPTOptimization(
 
   // Initialize the IpoptApplication and process the options
   Ipopt::ApplicationReturnStatus status;
-  status = app->Initialize();
-  if (status != Solve_Succeeded)
+  if (!reoptimize)
   {
-    std::cout << std::endl
-              << std::endl
-              << "*** Error during initialization!" << std::endl;
-    return;
+    status = app->Initialize();
+    if (status != Solve_Succeeded)
+    {
+      std::cout << std::endl
+                << std::endl
+                << "*** Error during initialization!" << std::endl;
+      return;
+    }
   }
 
   // If we're sub-sampling blocks, then save/restore all the trajectory
@@ -14019,8 +14932,16 @@ void DynamicsFitter::runIPOPTOptimization(
   // through `problemPtr`. `problem` NEEDS TO BE ON THE HEAP or it will
   // crash. If you try to leave `problem` on the stack, you'll get invalid
   // free exceptions when IPOpt attempts to free it.
-  DynamicsFitProblem* problem
-      = new DynamicsFitProblem(init, mSkeleton, mTrackingMarkers, config);
+  DynamicsFitProblem* problem = nullptr;
+  if (reoptimize)
+  {
+    problem = GetRawPtr(mIpoptProblem);
+    problem->resetFromInit(config);
+  }
+  else
+  {
+    problem = new DynamicsFitProblem(init, mSkeleton, mTrackingMarkers, config);
+  }
   if (problem->getProblemSize() == 0)
   {
     delete problem;
@@ -14054,7 +14975,17 @@ void DynamicsFitter::runIPOPTOptimization(
   SmartPtr<DynamicsFitProblem> problemPtr(problem);
 
   // This will automatically write results back to `init` on success.
-  status = app->OptimizeTNLP(problemPtr);
+  if (reoptimize)
+  {
+    status = app->ReOptimizeTNLP(problemPtr);
+  }
+  else
+  {
+    status = app->OptimizeTNLP(problemPtr);
+  }
+  mIpopt = app;
+  mIpoptProblem = problemPtr;
+  mIpoptAlgorithmSettings = algorithmSettings;
 
   if (config.mMaxNumBlocksPerTrial > -1)
   {
@@ -14693,268 +15624,317 @@ void DynamicsFitter::runConstantNewtonsMethod(
 //==============================================================================
 // 5. This attempts to perfect the physical consistency of the data
 void DynamicsFitter::computePerfectGRFs(
-    std::shared_ptr<DynamicsInitialization> init)
+    std::shared_ptr<DynamicsInitialization> init, int numThreads)
 {
-#ifndef NDEBUG
-  ResidualForceHelper helper(mSkeleton, init->grfBodyIndices);
-#endif
-  init->perfectGrfTrials.clear();
-  init->perfectForcePlateTrials.clear();
-  init->perfectTorques.clear();
-  init->perfectGrfAsCopTorqueForces.clear();
-  for (int trial = 0; trial < init->poseTrials.size(); trial++)
+  if (numThreads <= 0)
+  {
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  }
+
+  // We write into the existing buffers where we can, which only allocates if
+  // this is the first call, or the trials have changed size since the last
+  // one. Every entry gets overwritten, so the results are the same either way.
+  const int numTrials = init->poseTrials.size();
+  init->perfectGrfTrials.resize(numTrials);
+  init->perfectForcePlateTrials.resize(numTrials);
+  init->perfectTorques.resize(numTrials);
+  init->perfectGrfAsCopTorqueForces.resize(numTrials);
+
+  std::vector<std::shared_ptr<dynamics::Skeleton>> threadSkels;
+  for (int trial = 0; trial < numTrials; trial++)
   {
     mSkeleton->setTimeStep(init->trialTimesteps[trial]);
-    s_t groundHeight = init->groundHeight[trial];
-
-    Eigen::MatrixXs perfectGrfTrial = Eigen::MatrixXs::Zero(
-        init->grfTrials[trial].rows(), init->grfTrials[trial].cols());
-    Eigen::MatrixXs perfectTorques = Eigen::MatrixXs::Zero(
-        mSkeleton->getNumDofs(), init->grfTrials[trial].cols());
-    Eigen::MatrixXs perfectGrfAsCopTorqueForce = Eigen::MatrixXs::Zero(
-        init->grfBodyNodes.size() * 9, init->grfTrials[trial].cols());
-    std::vector<ForcePlate> perfectForcePlates;
+    const int numTimesteps = init->grfTrials[trial].cols();
+
+    init->perfectGrfTrials[trial].resize(
+        init->grfTrials[trial].rows(), numTimesteps);
+    init->perfectGrfTrials[trial].setZero();
+    init->perfectTorques[trial].resize(mSkeleton->getNumDofs(), numTimesteps);
+    init->perfectTorques[trial].setZero();
+    init->perfectGrfAsCopTorqueForces[trial].resize(
+        init->grfBodyNodes.size() * 9, numTimesteps);
+    init->perfectGrfAsCopTorqueForces[trial].setZero();
+
+    // The perfect force plates have an entry for every timestep but the last,
+    // and the first is copied from the original plates
+    const int numPlateTimesteps
+        = std::max(1, (int)init->poseTrials[trial].cols() - 1);
+    std::vector<ForcePlate>& perfectForcePlates
+        = init->perfectForcePlateTrials[trial];
+    perfectForcePlates.resize(init->forcePlateTrials[trial].size());
     for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
     {
       ForcePlate& originalPlate = init->forcePlateTrials[trial][i];
-      perfectForcePlates.emplace_back();
-      ForcePlate& perfectPlate
-          = perfectForcePlates[perfectForcePlates.size() - 1];
+      ForcePlate& perfectPlate = perfectForcePlates[i];
 
-      perfectForcePlates[i].centersOfPressure.push_back(
-          originalPlate.centersOfPressure[0]);
-      perfectForcePlates[i].moments.push_back(originalPlate.moments[0]);
-      perfectForcePlates[i].forces.push_back(originalPlate.forces[0]);
+      perfectPlate.centersOfPressure.resize(numPlateTimesteps);
+      perfectPlate.moments.resize(numPlateTimesteps);
+      perfectPlate.forces.resize(numPlateTimesteps);
+      perfectPlate.centersOfPressure[0] = originalPlate.centersOfPressure[0];
+      perfectPlate.moments[0] = originalPlate.moments[0];
+      perfectPlate.forces[0] = originalPlate.forces[0];
 
       perfectPlate.worldOrigin = originalPlate.worldOrigin;
       perfectPlate.corners = originalPlate.corners;
     }
-    const s_t dt = init->trialTimesteps[trial];
-    for (int t = 1; t < init->poseTrials[trial].cols() - 1; t++)
-    {
-      Eigen::VectorXs q = init->poseTrials[trial].col(t);
-      mSkeleton->setPositions(q);
-      Eigen::VectorXs dq = mSkeleton->getPositionDifferences(
-                               init->poseTrials[trial].col(t),
-                               init->poseTrials[trial].col(t - 1))
-                           / dt;
-      mSkeleton->setVelocities(dq);
-      Eigen::VectorXs nextDq = mSkeleton->getPositionDifferences(
-                                   init->poseTrials[trial].col(t + 1),
-                                   init->poseTrials[trial].col(t))
-                               / dt;
-      Eigen::VectorXs ddq = (mSkeleton->getPositionDifferences(
-                                 init->poseTrials[trial].col(t + 1),
-                                 init->poseTrials[trial].col(t))
-                             - mSkeleton->getPositionDifferences(
-                                 init->poseTrials[trial].col(t),
-                                 init->poseTrials[trial].col(t - 1)))
-                            / (dt * dt);
-      mSkeleton->setAccelerations(ddq);
 
-      int activeFootIndex = -1;
-      bool onlyOneActive = false;
-      for (int i = 0; i < init->grfBodyForceActive[trial][t].size(); i++)
+    const int lastTimestep = init->poseTrials[trial].cols() - 1;
+    int trialThreads = std::max(1, std::min(numThreads, lastTimestep - 1));
+    if (trialThreads == 1)
+    {
+      for (int t = 1; t < lastTimestep; t++)
       {
-        bool active = init->grfBodyForceActive[trial][t][i];
-        if (active)
-        {
-          if (activeFootIndex == -1)
-          {
-            activeFootIndex = i;
-            onlyOneActive = true;
-          }
-          else
-          {
-            onlyOneActive = false;
-          }
-        }
+        computePerfectGRFsTimestep(init, trial, t, mSkeleton);
       }
+      continue;
+    }
 
-      int activeForcePlateIndex = -1;
-      bool onlyOneForcePlateActive = false;
-      for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
-      {
-        if (init->forcePlateTrials[trial][i].forces[t].norm() > 1e-3)
+    // Every timestep writes its own entries of the buffers, so the threads
+    // never touch the same memory. Each thread gets a clone of the skeleton,
+    // which computes exactly what mSkeleton would, so the results don't depend
+    // on the number of threads.
+    for (int threadIdx = threadSkels.size(); threadIdx < trialThreads;
+         threadIdx++)
+    {
+      threadSkels.push_back(mSkeleton->cloneSkeleton());
+    }
+    std::vector<common::TaskFuture<void>> futures;
+    for (int threadIdx = 0; threadIdx < trialThreads; threadIdx++)
+    {
+      std::shared_ptr<dynamics::Skeleton> threadSkel = threadSkels[threadIdx];
+      threadSkel->setGravity(mSkeleton->getGravity());
+      threadSkel->setTimeStep(mSkeleton->getTimeStep());
+      futures.push_back(common::async([this,
+                                       &init,
+                                       trial,
+                                       threadIdx,
+                                       trialThreads,
+                                       lastTimestep,
+                                       threadSkel] {
+        for (int t = 1 + threadIdx; t < lastTimestep; t += trialThreads)
         {
-          if (activeForcePlateIndex == -1)
-          {
-            activeForcePlateIndex = i;
-            onlyOneForcePlateActive = true;
-          }
-          else
-          {
-            onlyOneForcePlateActive = false;
-          }
+          computePerfectGRFsTimestep(init, trial, t, threadSkel);
         }
+      }));
+    }
+    for (int threadIdx = 0; threadIdx < trialThreads; threadIdx++)
+    {
+      futures[threadIdx].get();
+    }
+  }
+}
+
+//==============================================================================
+// This fills in timestep `t` of the perfect GRF buffers for `trial`, which
+// computePerfectGRFs() has already allocated, using `skel`
+void DynamicsFitter::computePerfectGRFsTimestep(
+    std::shared_ptr<DynamicsInitialization> init,
+    int trial,
+    int t,
+    std::shared_ptr<dynamics::Skeleton> skel)
+{
+#ifndef NDEBUG
+  ResidualForceHelper helper(skel, init->grfBodyIndices);
+#endif
+  s_t groundHeight = init->groundHeight[trial];
+  Eigen::MatrixXs& perfectGrfTrial = init->perfectGrfTrials[trial];
+  Eigen::MatrixXs& perfectTorques = init->perfectTorques[trial];
+  Eigen::MatrixXs& perfectGrfAsCopTorqueForce
+      = init->perfectGrfAsCopTorqueForces[trial];
+  std::vector<ForcePlate>& perfectForcePlates
+      = init->perfectForcePlateTrials[trial];
+
+  // The GRF body nodes belong to mSkeleton, so look up the matching ones on
+  // `skel`
+  std::vector<dynamics::BodyNode*> grfBodyNodes;
+  for (dynamics::BodyNode* body : init->grfBodyNodes)
+  {
+    grfBodyNodes.push_back(skel->getBodyNode(body->getIndexInSkeleton()));
+  }
+
+  const s_t dt = init->trialTimesteps[trial];
+  Eigen::VectorXs q = init->poseTrials[trial].col(t);
+  skel->setPositions(q);
+  Eigen::VectorXs dq = skel->getPositionDifferences(
+                           init->poseTrials[trial].col(t),
+                           init->poseTrials[trial].col(t - 1))
+                       / dt;
+  skel->setVelocities(dq);
+  Eigen::VectorXs nextDq = skel->getPositionDifferences(
+                               init->poseTrials[trial].col(t + 1),
+                               init->poseTrials[trial].col(t))
+                           / dt;
+  Eigen::VectorXs ddq = (skel->getPositionDifferences(
+                             init->poseTrials[trial].col(t + 1),
+                             init->poseTrials[trial].col(t))
+                         - skel->getPositionDifferences(
+                             init->poseTrials[trial].col(t),
+                             init->poseTrials[trial].col(t - 1)))
+                        / (dt * dt);
+  skel->setAccelerations(ddq);
+
+  int activeFootIndex = -1;
+  bool onlyOneActive = false;
+  for (int i = 0; i < init->grfBodyForceActive[trial][t].size(); i++)
+  {
+    bool active = init->grfBodyForceActive[trial][t][i];
+    if (active)
+    {
+      if (activeFootIndex == -1)
+      {
+        activeFootIndex = i;
+        onlyOneActive = true;
       }
+      else
+      {
+        onlyOneActive = false;
+      }
+    }
+  }
 
-      if (onlyOneActive && onlyOneForcePlateActive)
+  int activeForcePlateIndex = -1;
+  bool onlyOneForcePlateActive = false;
+  for (int i = 0; i < init->forcePlateTrials[trial].size(); i++)
+  {
+    if (init->forcePlateTrials[trial][i].forces[t].norm() > 1e-3)
+    {
+      if (activeForcePlateIndex == -1)
       {
-        auto result = mSkeleton->getContactInverseDynamics(
-            nextDq, init->grfBodyNodes[activeFootIndex]);
-        perfectTorques.col(t) = result.jointTorques;
-        Eigen::Vector6s worldWrench = math::dAdInvT(
-            init->grfBodyNodes[activeFootIndex]->getWorldTransform(),
-            result.contactWrench);
-        perfectGrfTrial.block<6, 1>(activeFootIndex * 6, t) = worldWrench;
+        activeForcePlateIndex = i;
+        onlyOneForcePlateActive = true;
+      }
+      else
+      {
+        onlyOneForcePlateActive = false;
+      }
+    }
+  }
+
+  if (onlyOneActive && onlyOneForcePlateActive)
+  {
+    auto result = skel->getContactInverseDynamics(
+        nextDq, grfBodyNodes[activeFootIndex]);
+    perfectTorques.col(t) = result.jointTorques;
+    Eigen::Vector6s worldWrench = math::dAdInvT(
+        grfBodyNodes[activeFootIndex]->getWorldTransform(),
+        result.contactWrench);
+    perfectGrfTrial.block<6, 1>(activeFootIndex * 6, t) = worldWrench;
 
 #ifndef NDEBUG
-        Eigen::Vector6s residual
-            = helper.calculateResidual(q, dq, ddq, perfectGrfTrial.col(t));
-        s_t norm = residual.squaredNorm();
-        // std::cout << "Residual norm t=" << t << ": " << norm << std::endl;
-        assert(norm < 1e-10);
+    Eigen::Vector6s residual
+        = helper.calculateResidual(q, dq, ddq, perfectGrfTrial.col(t));
+    s_t norm = residual.squaredNorm();
+    // std::cout << "Residual norm t=" << t << ": " << norm << std::endl;
+    assert(norm < 1e-10);
 #endif
 
-        Eigen::Vector9s copWrench
-            = math::projectWrenchToCoP(worldWrench, groundHeight, 1);
-        perfectGrfAsCopTorqueForce.block<9, 1>(9 * activeFootIndex, t)
-            = copWrench;
-        // add to a force plate
-        for (int i = 0; i < perfectForcePlates.size(); i++)
-        {
-          if (i == activeForcePlateIndex)
-          {
-            perfectForcePlates[i].centersOfPressure.push_back(
-                copWrench.head<3>());
-            perfectForcePlates[i].moments.push_back(copWrench.segment<3>(3));
-            perfectForcePlates[i].forces.push_back(copWrench.segment<3>(6));
-          }
-          else
-          {
-            perfectForcePlates[i].centersOfPressure.push_back(
-                Eigen::Vector3s::Zero());
-            perfectForcePlates[i].forces.push_back(Eigen::Vector3s::Zero());
-            perfectForcePlates[i].moments.push_back(Eigen::Vector3s::Zero());
-          }
-        }
+    Eigen::Vector9s copWrench
+        = math::projectWrenchToCoP(worldWrench, groundHeight, 1);
+    perfectGrfAsCopTorqueForce.block<9, 1>(9 * activeFootIndex, t) = copWrench;
+    // add to a force plate
+    for (int i = 0; i < perfectForcePlates.size(); i++)
+    {
+      if (i == activeForcePlateIndex)
+      {
+        perfectForcePlates[i].centersOfPressure[t] = copWrench.head<3>();
+        perfectForcePlates[i].moments[t] = copWrench.segment<3>(3);
+        perfectForcePlates[i].forces[t] = copWrench.segment<3>(6);
       }
       else
       {
-        Eigen::VectorXs sensorWorldGRF = init->grfTrials[trial].col(t);
-        std::vector<Eigen::Vector6s> localWrenches;
-        std::vector<const dynamics::BodyNode*> constFootNodes;
-        for (int i = 0; i < init->grfBodyNodes.size(); i++)
-        {
-          constFootNodes.push_back(init->grfBodyNodes[i]);
-          localWrenches.push_back(math::dAdT(
-              init->grfBodyNodes[i]->getWorldTransform(),
-              sensorWorldGRF.segment<6>(i * 6)));
-        }
-        auto resultCops = mSkeleton->getMultipleContactInverseDynamicsNearCoP(
-            nextDq,
-            constFootNodes,
-            localWrenches,
-            init->groundHeight[trial],
-            1,
-            0.1,
-            false);
+        perfectForcePlates[i].centersOfPressure[t] = Eigen::Vector3s::Zero();
+        perfectForcePlates[i].forces[t] = Eigen::Vector3s::Zero();
+        perfectForcePlates[i].moments[t] = Eigen::Vector3s::Zero();
+      }
+    }
+  }
+  else
+  {
+    Eigen::VectorXs sensorWorldGRF = init->grfTrials[trial].col(t);
+    std::vector<Eigen::Vector6s> localWrenches;
+    std::vector<const dynamics::BodyNode*> constFootNodes;
+    for (int i = 0; i < grfBodyNodes.size(); i++)
+    {
+      constFootNodes.push_back(grfBodyNodes[i]);
+      localWrenches.push_back(math::dAdT(
+          grfBodyNodes[i]->getWorldTransform(),
+          sensorWorldGRF.segment<6>(i * 6)));
+    }
+    auto resultCops = skel->getMultipleContactInverseDynamicsNearCoP(
+        nextDq,
+        constFootNodes,
+        localWrenches,
+        init->groundHeight[trial],
+        1,
+        0.1,
+        false);
 
-        perfectTorques.col(t) = resultCops.jointTorques;
+    perfectTorques.col(t) = resultCops.jointTorques;
 
-        std::vector<Eigen::Vector6s> worldWrenches;
-        Eigen::VectorXs perfectGRF
-            = Eigen::VectorXs::Zero(init->grfBodyNodes.size() * 6);
-        for (int i = 0; i < init->grfBodyNodes.size(); i++)
-        {
-          Eigen::Vector6s worldWrench = math::dAdInvT(
-              init->grfBodyNodes[i]->getWorldTransform(),
-              resultCops.contactWrenches[i]);
-          worldWrenches.push_back(worldWrench);
-          perfectGRF.segment<6>(i * 6) = worldWrench;
-        }
-        perfectGrfTrial.col(t) = perfectGRF;
+    std::vector<Eigen::Vector6s> worldWrenches;
+    Eigen::VectorXs perfectGRF
+        = Eigen::VectorXs::Zero(grfBodyNodes.size() * 6);
+    for (int i = 0; i < grfBodyNodes.size(); i++)
+    {
+      Eigen::Vector6s worldWrench = math::dAdInvT(
+          grfBodyNodes[i]->getWorldTransform(), resultCops.contactWrenches[i]);
+      worldWrenches.push_back(worldWrench);
+      perfectGRF.segment<6>(i * 6) = worldWrench;
+    }
+    perfectGrfTrial.col(t) = perfectGRF;
 
 #ifndef NDEBUG
-        Eigen::Vector6s residual
-            = helper.calculateResidual(q, dq, ddq, perfectGrfTrial.col(t));
-        s_t norm = residual.squaredNorm();
-        std::cout << "Residual norm t=" << t << ": " << norm << std::endl;
-        assert(norm < 1e-10);
+    Eigen::Vector6s residual
+        = helper.calculateResidual(q, dq, ddq, perfectGrfTrial.col(t));
+    s_t norm = residual.squaredNorm();
+    std::cout << "Residual norm t=" << t << ": " << norm << std::endl;
+    assert(norm < 1e-10);
 #endif
 
-        std::vector<Eigen::Vector3s> forces;
-        std::vector<Eigen::Vector3s> cops;
-        std::vector<Eigen::Vector3s> taus;
+    std::vector<Eigen::Vector3s> forces;
+    std::vector<Eigen::Vector3s> cops;
+    std::vector<Eigen::Vector3s> taus;
+
+    Eigen::MatrixXs platesToFeet = Eigen::MatrixXs::Zero(
+        init->forcePlateTrials[trial].size(), grfBodyNodes.size());
+    for (int i = 0; i < grfBodyNodes.size(); i++)
+    {
+      Eigen::Vector6s worldWrench = worldWrenches[i];
+      Eigen::Vector9s copWrench
+          = math::projectWrenchToCoP(worldWrench, groundHeight, 1);
+      perfectGrfAsCopTorqueForce.block<9, 1>(9 * i, t) = copWrench;
 
-        Eigen::MatrixXs platesToFeet = Eigen::MatrixXs::Zero(
-            init->forcePlateTrials[trial].size(), init->grfBodyNodes.size());
-        for (int i = 0; i < init->grfBodyNodes.size(); i++)
-        {
-          Eigen::Vector6s worldWrench = worldWrenches[i];
-          Eigen::Vector9s copWrench
-              = math::projectWrenchToCoP(worldWrench, groundHeight, 1);
-          perfectGrfAsCopTorqueForce.block<9, 1>(9 * i, t) = copWrench;
-
-          cops.push_back(copWrench.segment<3>(0));
-          taus.push_back(copWrench.segment<3>(3));
-          forces.push_back(copWrench.segment<3>(6));
-
-          /*
-          // Find the center of pressure, using the copy-pasted method from
-          // above in the single-footed case
-          // TODO: factor out into a utility method
-          Eigen::Vector3s worldTau = worldWrench.head<3>();
-          Eigen::Vector3s worldF = worldWrench.tail<3>();
-          Eigen::Matrix3s crossF = math::makeSkewSymmetric(worldF);
-          Eigen::Vector3s rightSide = worldTau - crossF.col(1) * groundHeight;
-          Eigen::Matrix3s leftSide = -crossF;
-          leftSide.col(1) = worldF;
-          Eigen::Vector3s p
-              = leftSide.completeOrthogonalDecomposition().solve(rightSide);
-          s_t k = p(1);
-          p(1) = 0;
-          Eigen::Vector3s expectedTau = worldF * k;
-          Eigen::Vector3s cop = p;
-          cop(1) = groundHeight;
-
-          forces.push_back(worldF);
-          cops.push_back(cop);
-          taus.push_back(expectedTau);
-
-          perfectGrfAsCopTorqueForce.block<3, 1>(9 * i, t) = cop;
-          perfectGrfAsCopTorqueForce.block<3, 1>(9 * i + 3, t) = expectedTau;
-          perfectGrfAsCopTorqueForce.block<3, 1>(9 * i + 6, t) = worldF;
-          */
-
-          Eigen::Vector3s cop = copWrench.segment<3>(0);
-          for (int j = 0; j < init->forcePlateTrials[trial].size(); j++)
-          {
-            platesToFeet(j, i)
-                = 1.0
-                  / (cop
-                     - init->forcePlateTrials[trial][j].centersOfPressure[t])
-                        .norm();
-          }
-        }
-        Eigen::VectorXi platesToFeetAssignment
-            = math::AssignmentMatcher::assignRowsToColumns(platesToFeet);
-        for (int i = 0; i < perfectForcePlates.size(); i++)
-        {
-          if (platesToFeetAssignment(i) == -1)
-          {
-            perfectForcePlates[i].centersOfPressure.push_back(
-                Eigen::Vector3s::Zero());
-            perfectForcePlates[i].forces.push_back(Eigen::Vector3s::Zero());
-            perfectForcePlates[i].moments.push_back(Eigen::Vector3s::Zero());
-          }
-          else if (perfectForcePlates[i].centersOfPressure.size() <= t)
-          {
-            perfectForcePlates[i].centersOfPressure.push_back(
-                cops[platesToFeetAssignment(i)]);
-            perfectForcePlates[i].forces.push_back(
-                forces[platesToFeetAssignment(i)]);
-            perfectForcePlates[i].moments.push_back(
-                taus[platesToFeetAssignment(i)]);
-          }
-        }
+      cops.push_back(copWrench.segment<3>(0));
+      taus.push_back(copWrench.segment<3>(3));
+      forces.push_back(copWrench.segment<3>(6));
+
+      Eigen::Vector3s cop = copWrench.segment<3>(0);
+      for (int j = 0; j < init->forcePlateTrials[trial].size(); j++)
+      {
+        platesToFeet(j, i)
+            = 1.0
+              / (cop - init->forcePlateTrials[trial][j].centersOfPressure[t])
+                    .norm();
+      }
+    }
+    Eigen::VectorXi platesToFeetAssignment
+        = math::AssignmentMatcher::assignRowsToColumns(platesToFeet);
+    for (int i = 0; i < perfectForcePlates.size(); i++)
+    {
+      if (platesToFeetAssignment(i) == -1)
+      {
+        perfectForcePlates[i].centersOfPressure[t] = Eigen::Vector3s::Zero();
+        perfectForcePlates[i].forces[t] = Eigen::Vector3s::Zero();
+        perfectForcePlates[i].moments[t] = Eigen::Vector3s::Zero();
+      }
+      else
+      {
+        perfectForcePlates[i].centersOfPressure[t]
+            = cops[platesToFeetAssignment(i)];
+        perfectForcePlates[i].forces[t] = forces[platesToFeetAssignment(i)];
+        perfectForcePlates[i].moments[t] = taus[platesToFeetAssignment(i)];
       }
     }
-    init->perfectGrfTrials.push_back(perfectGrfTrial);
-    init->perfectTorques.push_back(perfectTorques);
-    init->perfectGrfAsCopTorqueForces.push_back(perfectGrfAsCopTorqueForce);
-    init->perfectForcePlateTrials.push_back(perfectForcePlates);
   }
 }
 
@@ -15107,11 +16087,11 @@ bool DynamicsFitter::checkPhysicalConsistency(
 }
 
 //==============================================================================
-void writeVectorToCSV(std::ofstream& csvFile, Eigen::VectorXs& vec)
+void writeVectorToCSV(utils::BufferedWriter& csvFile, Eigen::VectorXs& vec)
 {
   for (int i = 0; i < vec.size(); i++)
   {
-    csvFile << "," << vec(i);
+    csvFile << "," << (double)vec(i);
   }
 }
 
@@ -15125,8 +16105,7 @@ void DynamicsFitter::writeCSVData(
     bool useAdjustedGRFs)
 {
   // time, pos, vel, acc, [contact] * feet, [cop, wrench] * feet
-  std::ofstream csvFile;
-  csvFile.open(path);
+  utils::BufferedWriter csvFile(path);
 
   csvFile << "time";
   for (int i = 0; i < mSkeleton->getNumDofs(); i++)
@@ -15183,9 +16162,9 @@ void DynamicsFitter::writeCSVData(
 
   for (int t = 1; t < init->poseTrials[trial].cols() - 1; t++)
   {
-    csvFile << std::endl;
+    csvFile << "\n";
 
-    csvFile << time;
+    csvFile << (double)time;
 
     Eigen::VectorXs q = init->poseTrials[trial].col(t);
     Eigen::VectorXs dq
@@ -15223,8 +16202,9 @@ void DynamicsFitter::writeCSVData(
     csvFile << "," << init->probablyMissingGRF[trial][t];
     for (int i = 0; i < mFootNodes.size(); i++)
     {
-      csvFile << "," << init->grfBodyForceActive[trial][t][i]
-          || init->grfBodySphereInContact[trial][t][i];
+      csvFile << ","
+              << (init->grfBodyForceActive[trial][t][i]
+                  || init->grfBodySphereInContact[trial][t][i]);
     }
     writeVectorToCSV(csvFile, footContactData);
 
@@ -15248,9 +16228,9 @@ void DynamicsFitter::writeCSVData(
       }
     }
     rms /= count;
-    csvFile << "," << rms << "," << max;
+    csvFile << "," << (double)rms << "," << (double)max;
     // Write out the residuals
-    csvFile << "," << tau.head<6>().norm();
+    csvFile << "," << (double)tau.head<6>().norm();
 
     time += dt;
   }
@@ -15447,7 +16427,6 @@ Eigen::MatrixXs DynamicsFitter::computeInverseDynamics(
 s_t DynamicsFitter::computeAverageMarkerRMSE(
     std::shared_ptr<DynamicsInitialization> init)
 {
-  Eigen::VectorXs originalPoses = mSkeleton->getPositions();
   Eigen::VectorXs originalScales = mSkeleton->getGroupScales();
   mSkeleton->setGroupScales(init->groupScales);
 
@@ -15455,26 +16434,19 @@ s_t DynamicsFitter::computeAverageMarkerRMSE(
   int count = 0;
   for (int trial = 0; trial < init->poseTrials.size(); trial++)
   {
-    for (int i = 0; i < init->poseTrials[trial].cols(); i++)
-    {
-      mSkeleton->setPositions(init->poseTrials[trial].col(i));
-      auto simulatedMarkers
-          = mSkeleton->getMarkerMapWorldPositions(init->updatedMarkerMap);
-      auto markers = init->markerObservationTrials[trial][i];
-      for (auto pair : simulatedMarkers)
-      {
-        if (markers.count(pair.first))
-        {
-          result += (markers.at(pair.first) - pair.second).norm();
-          count++;
-        }
-      }
-    }
+    int trialCount = 0;
+    s_t trialError = mSkeleton->getMarkerAverageErrorBatch(
+        init->poseTrials[trial],
+        init->updatedMarkerMap,
+        init->markerObservationTrials[trial],
+        -1,
+        &trialCount);
+    result += trialError * trialCount;
+    count += trialCount;
   }
 
   result /= count;
 
-  mSkeleton->setPositions(originalPoses);
   mSkeleton->setGroupScales(originalScales);
 
   return result;
@@ -15485,31 +16457,14 @@ s_t DynamicsFitter::computeAverageMarkerRMSE(
 s_t DynamicsFitter::computeAverageTrialMarkerRMSE(
     std::shared_ptr<DynamicsInitialization> init, int trial)
 {
-  Eigen::VectorXs originalPoses = mSkeleton->getPositions();
   Eigen::VectorXs originalScales = mSkeleton->getGroupScales();
   mSkeleton->setGroupScales(init->groupScales);
 
-  s_t result = 0;
-  int count = 0;
-  for (int i = 0; i < init->poseTrials[trial].cols(); i++)
-  {
-    mSkeleton->setPositions(init->poseTrials[trial].col(i));
-    auto simulatedMarkers
-        = mSkeleton->getMarkerMapWorldPositions(init->updatedMarkerMap);
-    auto markers = init->markerObservationTrials[trial][i];
-    for (auto pair : simulatedMarkers)
-    {
-      if (markers.count(pair.first))
-      {
-        result += (markers.at(pair.first) - pair.second).norm();
-        count++;
-      }
-    }
-  }
-
-  result /= count;
+  s_t result = mSkeleton->getMarkerAverageErrorBatch(
+      init->poseTrials[trial],
+      init->updatedMarkerMap,
+      init->markerObservationTrials[trial]);
 
-  mSkeleton->setPositions(originalPoses);
   mSkeleton->setGroupScales(originalScales);
 
   return result;
@@ -17010,5 +17965,11 @@ void DynamicsFitter::setDisableLinesearch(bool disable)
   mDisableLinesearch = disable;
 }
 
+//==============================================================================
+void DynamicsFitter::setUseExactHessian(bool useExactHessian)
+{
+  mUseExactHessian = useExactHessian;
+}
+
 } // namespace biomechanics
 } // namespace dart
\ No newline at end of file
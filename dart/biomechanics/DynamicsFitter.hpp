@@ -5,6 +5,7 @@
 #include <tuple>
 #include <vector>
 
+#include <Eigen/Sparse>
 #include <coin/IpIpoptApplication.hpp>
 #include <coin/IpTNLP.hpp>
 
@@ -24,6 +25,36 @@
 namespace dart {
 namespace biomechanics {
 
+/**
+ * This holds the output of ResidualForceHelper::calculateResidualTrajectory(),
+ * laid out as a structure of arrays. Column t (or the block of `dofs` columns
+ * starting at t * dofs, for the Jacobians) of every matrix belongs to timestep
+ * t.
+ */
+struct ResidualTrajectory
+{
+  // The full inverse dynamics vector at each timestep, (dofs x T)
+  Eigen::MatrixXs taus;
+  // The root residual at each timestep, which is the top of `taus` (6 x T)
+  Eigen::MatrixXs residuals;
+  // The same as calculateResidualNorm() at each timestep (T)
+  Eigen::VectorXs residualNorms;
+
+  // These are only filled in if Jacobians were requested. Each one is
+  // (6 x (dofs * T)), and holds the Jacobian of the residual at timestep t wrt
+  // q, dq or ddq at that same timestep.
+  Eigen::MatrixXs residualJacobiansWrtPos;
+  Eigen::MatrixXs residualJacobiansWrtVel;
+  Eigen::MatrixXs residualJacobiansWrtAcc;
+
+  // These are only filled in if Jacobians were requested. Each one is
+  // (dofs x T), and matches calculateResidualNormGradientWrt() for q, dq or
+  // ddq at each timestep.
+  Eigen::MatrixXs residualNormGradientsWrtPos;
+  Eigen::MatrixXs residualNormGradientsWrtVel;
+  Eigen::MatrixXs residualNormGradientsWrtAcc;
+};
+
 /**
  * This class factors out the code to deal with calculating residual forces, and
  * the associated Jacobians of residual force with respect to lots of different
@@ -104,6 +135,23 @@ public:
       s_t torquesMultiple,
       bool useL1);
 
+  ///////////////////////////////////////////
+  // Computes the residuals for a whole trajectory in one pass, and optionally
+  // their Jacobians and norm gradients wrt q, dq and ddq. This sets the
+  // skeleton state once per timestep, and reuses the mass matrix from the
+  // inverse dynamics for the acceleration Jacobian, rather than recomputing
+  // everything for each calculateResidual*() call. Timesteps are split across
+  // `numThreads` copies of the skeleton.
+  ResidualTrajectory calculateResidualTrajectory(
+      Eigen::MatrixXs qs,
+      Eigen::MatrixXs dqs,
+      Eigen::MatrixXs ddqs,
+      Eigen::MatrixXs forces,
+      s_t torquesMultiple,
+      bool useL1,
+      bool computeJacobians = true,
+      int numThreads = 1);
+
   ///////////////////////////////////////////
   // Computes the gradient of the residual norm with respect to `wrt`
   Eigen::VectorXs finiteDifferenceResidualNormGradientWrt(
@@ -677,6 +725,25 @@ public:
       int maxBuckets = 16);
 
 protected:
+  // This makes sure there are at least `numThreads` copies of mSkel (and
+  // helpers for them) in mThreadSkels and mThreadHelpers, with the same scales
+  // and inertia as mSkel. The copies are reused across calls, so we only pay
+  // for cloning the skeleton the first time.
+  void prepareThreadSkels(int numThreads);
+
+  // This fills in timestep `t` of `result` for calculateResidualTrajectory(),
+  // using mSkel. It leaves mSkel set to that timestep's state.
+  void fillResidualTrajectoryTimestep(
+      ResidualTrajectory& result,
+      int t,
+      const Eigen::VectorXs& q,
+      const Eigen::VectorXs& dq,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& forcesConcat,
+      s_t torquesMultiple,
+      bool useL1,
+      bool computeJacobians);
+
   std::shared_ptr<dynamics::Skeleton> mSkel;
   std::vector<int> mForceBodies;
   std::vector<neural::DifferentiableExternalForce> mForces;
@@ -919,6 +986,10 @@ public:
   DynamicsFitProblemConfig& setOnlyOneTrial(int value);
   DynamicsFitProblemConfig& setMaxNumBlocksPerTrial(int value);
 
+  /// This sets how many pieces the loss and gradient get split into. The
+  /// pieces run on the shared common::TaskScheduler pool, so the number of
+  /// threads actually running at once is capped by
+  /// common::TaskScheduler::setGlobalMaxConcurrency(), not by this.
   DynamicsFitProblemConfig& setNumThreads(int value);
 
 public:
@@ -1016,6 +1087,20 @@ public:
       std::shared_ptr<DynamicsInitialization> init,
       DynamicsFitProblemConfig config);
 
+  // This returns true if a problem built from `init` and `config` would have
+  // exactly the same decision variables, constraints and sparsity as this one.
+  // In that case, IPOPT can re-solve this object with ReOptimizeTNLP(), and
+  // keep everything it worked out about the problem's structure.
+  bool hasSameStructure(
+      std::shared_ptr<DynamicsInitialization> init,
+      DynamicsFitProblemConfig config);
+
+  // This swaps in `config` (which must pass hasSameStructure()), and reloads
+  // the starting point from the init object and the skeleton, as if this were
+  // a freshly constructed problem. This keeps the blocks, the thread
+  // skeletons and the helpers, so it's much cheaper than building a new one.
+  void resetFromInit(DynamicsFitProblemConfig config);
+
   // This returns the dimension of the decision variables (the length of the
   // flatten() vector), which depends on which variables we choose to include in
   // the optimization problem.
@@ -1085,6 +1170,25 @@ public:
   Eigen::MatrixXs finiteDifferenceHessian(
       Eigen::VectorXs x, bool useRidders = true);
 
+  // This gets the number of entries in the lower triangle of the sparse
+  // Hessian of the loss. The loss is a sum over blocks, and each block only
+  // depends on its own poses plus the shared variables (masses, scales,
+  // offsets, etc), so the Hessian is block diagonal with dense rows and
+  // columns for the shared variables.
+  int getSparseHessianNonZeros();
+
+  // This gets the (row,col) pairs of the lower triangle of the sparse Hessian
+  // of the loss, in the same order that computeSparseHessian() returns them.
+  std::vector<std::pair<int, int>> getSparseHessianStructure();
+
+  // This gets the lower triangle of the sparse Hessian of the loss, returning
+  // objects with (row,col,value). The values come from central differences on
+  // the analytical gradient, perturbing the same pose variable in every block
+  // at once, so this costs 2 * (shared variables + largest block's variables)
+  // gradient evaluations, rather than 2 * getProblemSize().
+  std::vector<std::tuple<int, int, s_t>> computeSparseHessian(
+      Eigen::VectorXs x, s_t eps = 1e-6);
+
   // Print out the errors in a gradient vector in human readable form
   bool debugErrors(Eigen::VectorXs fd, Eigen::VectorXs analytical, s_t tol);
 
@@ -1201,6 +1305,15 @@ public:
       const Ipopt::IpoptData* ip_data,
       Ipopt::IpoptCalculatedQuantities* ip_cq) override;
 
+protected:
+  // This fills the poses, velocities, accelerations and GRFs of every block
+  // from the init object
+  void loadBlocksFromInit();
+
+  // This sets the starting point to the current state, and clears the record
+  // of the best state found so far
+  void resetOptimizationState();
+
 public:
   std::shared_ptr<DynamicsInitialization> mInit;
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
@@ -1221,6 +1334,8 @@ public:
   std::vector<std::vector<dynamics::Joint*>> mThreadJoints;
   std::vector<std::shared_ptr<ResidualForceHelper>> mThreadResidualHelpers;
   std::vector<std::shared_ptr<SpatialNewtonHelper>> mThreadSpatialNewtonHelpers;
+  // Thread i evaluates blocks [mThreadBlockStarts[i], mThreadBlockStarts[i+1])
+  std::vector<int> mThreadBlockStarts;
 
   int mBestObjectiveValueIteration;
   s_t mBestObjectiveValue;
@@ -1348,6 +1463,23 @@ public:
   void moveComsToMinimizeAngularResiduals(
       std::shared_ptr<DynamicsInitialization> init);
 
+  // This builds the sparse linear map that zeroLinearResidualsOnCOMTrajectory()
+  // solves for a single trial. The columns are the start COM position and
+  // velocity, 3 rotation angles per force plate, a delta V for each of the
+  // `numMissingSteps` buckets that `missingStepMappings` sorts the
+  // `missingStepIndices` into, and the total mass. The rows are the COM
+  // position at each timestep, followed by regularization rows for the plate
+  // rotations and the missing step delta Vs.
+  static Eigen::SparseMatrix<s_t> getCOMTrajectoryLinearMap(
+      s_t dt,
+      const std::vector<Eigen::Vector3s>& grfs,
+      const std::vector<ForcePlate>& forcePlates,
+      const std::vector<int>& missingStepIndices,
+      const std::vector<int>& missingStepMappings,
+      int numMissingSteps,
+      s_t regularizeForcePlateRotations,
+      s_t regularizeUnobservedTimesteps);
+
   // 1. Adjust the total mass of the body, and change the initial positions and
   // velocities of the body to achieve a least-squares closest COM trajectory to
   // the current kinematic fit.
@@ -1395,7 +1527,9 @@ public:
   // 1. This runs a number of zeroLinearResidualsAndOptimizeAngular() pipelines,
   // each with different number of timesteps offset between the force plates and
   // the marker data, and returns the best match (minimum marker error at 0
-  // residuals).
+  // residuals). The shifts are tried within `fineShiftRadius` of a coarse
+  // guess from estimateGRFShift(), in parallel. A negative `fineShiftRadius`
+  // skips the coarse guess, and tries every shift up to `maxShiftGRF`.
   bool timeSyncTrialGRF(
       std::shared_ptr<DynamicsInitialization> init,
       int trial,
@@ -1407,7 +1541,40 @@ public:
       s_t regularizeLinearResiduals = 0.5,
       s_t regularizeAngularResiduals = 0.5,
       s_t regularizeCopDriftCompensation = 1.0,
-      int maxBuckets = 16);
+      int maxBuckets = 16,
+      int fineShiftRadius = 2);
+
+  // 1. This is the same as timeSyncTrialGRF(), but for several trials at once,
+  // with all the shifts of all the trials run in parallel. This returns false
+  // if any of the trials failed to sync.
+  bool timeSyncTrialsGRF(
+      std::shared_ptr<DynamicsInitialization> init,
+      std::vector<int> trials,
+      bool useReactionWheels = false,
+      int maxShiftGRF = 4,
+      int iterationsPerShift = 20,
+      s_t weightLinear = 1.0,
+      s_t weightAngular = 1.0,
+      s_t regularizeLinearResiduals = 0.5,
+      s_t regularizeAngularResiduals = 0.5,
+      s_t regularizeCopDriftCompensation = 1.0,
+      int maxBuckets = 16,
+      int fineShiftRadius = 2);
+
+  // This makes a quick guess at the GRF shift for a trial, by finding the
+  // lag (up to `maxShiftGRF`) with the best FFT cross-correlation between
+  // impliedCOMForces() and measuredGRFForces()
+  int estimateGRFShift(
+      std::shared_ptr<DynamicsInitialization> init, int trial, int maxShiftGRF);
+
+  // This copies a single trial out of `init`, as the only trial of a new
+  // initialization, with its body nodes and joints looked up by name on
+  // `skel`. This lets a clone of the Skeleton work on the trial on another
+  // thread, without touching the original.
+  static std::shared_ptr<DynamicsInitialization> copyTrialForSkeleton(
+      std::shared_ptr<DynamicsInitialization> init,
+      int trial,
+      std::shared_ptr<dynamics::Skeleton> skel);
 
   // This runs the initial pipeline, which does an approximate mass optimization
   // and time syncs the GRF data, then re-optimizes the mass and trajectory on
@@ -1457,11 +1624,15 @@ public:
   // This analytically re-centers each marker to minimize marker errors.
   void optimizeMarkerOffsets(std::shared_ptr<DynamicsInitialization> init);
 
-  // This utility recomputes the GRF world wrenches, in case we changed the data
+  // This utility recomputes the GRF world wrenches, in case we changed the
+  // data. The foot positions are computed in blocks of timesteps across
+  // `numThreads` clones of `skel` (<= 0 means one per worker in the global
+  // pool), and the results are the same for any number of threads.
   static void recomputeGRFs(
       std::shared_ptr<DynamicsInitialization> init,
       std::shared_ptr<dynamics::Skeleton> skel,
-      int trial);
+      int trial,
+      int numThreads = 1);
 
   // 1. Shift the COM trajectory by a 3vec offset to minimize the amount of
   // remaining residual
@@ -1533,8 +1704,14 @@ public:
       std::shared_ptr<DynamicsInitialization> init,
       DynamicsFitProblemConfig config);
 
-  // 5. This attempts to perfect the physical consistency of the data
-  void computePerfectGRFs(std::shared_ptr<DynamicsInitialization> init);
+  // 5. This attempts to perfect the physical consistency of the data. The
+  // timesteps are split across `numThreads` clones of the skeleton (<= 0
+  // means one per worker in the global pool), and the results are the same
+  // for any number of threads. This writes into the `perfect*` buffers
+  // already in `init` where they're the right size, rather than building new
+  // ones, so calling this repeatedly doesn't reallocate.
+  void computePerfectGRFs(
+      std::shared_ptr<DynamicsInitialization> init, int numThreads = -1);
 
   // This plays the simulation forward in Nimble, using the existing GRFs and
   // torques, and checks that everything matches what we expect to see
@@ -1652,8 +1829,21 @@ public:
   void setPrintFrequency(int freq);
   void setSilenceOutput(bool silent);
   void setDisableLinesearch(bool disable);
+  // If true, runIPOPTOptimization() gives IPOPT the sparse Hessian of the loss
+  // from DynamicsFitProblem::computeSparseHessian(), instead of having it build
+  // an L-BFGS approximation. Constraint curvature is left out, which is exact
+  // unless config.setConstrainResidualsZero(true).
+  void setUseExactHessian(bool useExactHessian);
 
 protected:
+  // This fills in timestep `t` of the perfect GRF buffers for `trial`, which
+  // computePerfectGRFs() has already allocated, using `skel`
+  void computePerfectGRFsTimestep(
+      std::shared_ptr<DynamicsInitialization> init,
+      int trial,
+      int t,
+      std::shared_ptr<dynamics::Skeleton> skel);
+
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
   std::vector<dynamics::BodyNode*> mFootNodes;
   std::vector<std::string> mTrackingMarkers;
@@ -1665,6 +1855,16 @@ protected:
   int mPrintFrequency;
   bool mSilenceOutput;
   bool mDisableLinesearch;
+  bool mUseExactHessian;
+
+  // The IPOPT application and problem from the last runIPOPTOptimization(),
+  // which we re-solve with ReOptimizeTNLP() if the next call has the same
+  // structure, along with the settings that shaped the application's
+  // algorithm (the Hessian approximation, the L-BFGS history length, and
+  // whether we check derivatives).
+  Ipopt::SmartPtr<Ipopt::IpoptApplication> mIpopt;
+  Ipopt::SmartPtr<DynamicsFitProblem> mIpoptProblem;
+  std::tuple<bool, int, bool> mIpoptAlgorithmSettings;
 };
 
 }; // namespace biomechanics
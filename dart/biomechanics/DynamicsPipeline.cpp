@@ -0,0 +1,754 @@
+#include "dart/biomechanics/DynamicsPipeline.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <utility>
+
+#include "dart/common/Console.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/proto/SerializeEigen.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+// Bump this if the meaning of an existing field in
+// DynamicsInitialization.proto ever changes
+static const int DYNAMICS_CHECKPOINT_VERSION = 1;
+
+//==============================================================================
+static void serializePoints(
+    proto::MatrixXs& proto, const std::vector<Eigen::Vector3s>& points)
+{
+  Eigen::MatrixXs mat = Eigen::MatrixXs::Zero(3, points.size());
+  for (int i = 0; i < points.size(); i++)
+  {
+    mat.col(i) = points[i];
+  }
+  proto::serializeMatrix(proto, mat);
+}
+
+//==============================================================================
+static std::vector<Eigen::Vector3s> deserializePoints(
+    const proto::MatrixXs& proto)
+{
+  Eigen::MatrixXs mat = proto::deserializeMatrix(proto);
+  std::vector<Eigen::Vector3s> points;
+  if (mat.rows() != 3)
+  {
+    return points;
+  }
+  for (int i = 0; i < mat.cols(); i++)
+  {
+    points.push_back(mat.col(i));
+  }
+  return points;
+}
+
+//==============================================================================
+static void serializeNamedPoints(
+    proto::DynamicsNamedPoints& proto,
+    const std::map<std::string, Eigen::Vector3s>& points)
+{
+  Eigen::MatrixXs mat = Eigen::MatrixXs::Zero(3, points.size());
+  int col = 0;
+  for (const auto& pair : points)
+  {
+    proto.add_names(pair.first);
+    mat.col(col++) = pair.second;
+  }
+  proto::serializeMatrix(*proto.mutable_points(), mat);
+}
+
+//==============================================================================
+static std::map<std::string, Eigen::Vector3s> deserializeNamedPoints(
+    const proto::DynamicsNamedPoints& proto)
+{
+  std::map<std::string, Eigen::Vector3s> points;
+  Eigen::MatrixXs mat = proto::deserializeMatrix(proto.points());
+  if (mat.rows() != 3 || mat.cols() != proto.names_size())
+  {
+    return points;
+  }
+  for (int i = 0; i < proto.names_size(); i++)
+  {
+    points[proto.names(i)] = mat.col(i);
+  }
+  return points;
+}
+
+//==============================================================================
+static void serializeForcePlates(
+    proto::DynamicsForcePlateTrial& proto,
+    const std::vector<ForcePlate>& plates)
+{
+  for (const ForcePlate& plate : plates)
+  {
+    proto::DynamicsForcePlate* plateProto = proto.add_plates();
+    proto::serializeVector(
+        *plateProto->mutable_worldorigin(), plate.worldOrigin);
+    serializePoints(*plateProto->mutable_corners(), plate.corners);
+    serializePoints(
+        *plateProto->mutable_centersofpressure(), plate.centersOfPressure);
+    serializePoints(*plateProto->mutable_moments(), plate.moments);
+    serializePoints(*plateProto->mutable_forces(), plate.forces);
+  }
+}
+
+//==============================================================================
+static std::vector<ForcePlate> deserializeForcePlates(
+    const proto::DynamicsForcePlateTrial& proto)
+{
+  std::vector<ForcePlate> plates;
+  for (const proto::DynamicsForcePlate& plateProto : proto.plates())
+  {
+    ForcePlate plate;
+    Eigen::VectorXs origin = proto::deserializeVector(plateProto.worldorigin());
+    plate.worldOrigin = origin.size() == 3 ? Eigen::Vector3s(origin)
+                                           : Eigen::Vector3s::Zero();
+    plate.corners = deserializePoints(plateProto.corners());
+    plate.centersOfPressure = deserializePoints(plateProto.centersofpressure());
+    plate.moments = deserializePoints(plateProto.moments());
+    plate.forces = deserializePoints(plateProto.forces());
+    plates.push_back(plate);
+  }
+  return plates;
+}
+
+//==============================================================================
+template <typename ListProto>
+static void serializeMatrices(
+    ListProto* list, const std::vector<Eigen::MatrixXs>& matrices)
+{
+  for (const Eigen::MatrixXs& mat : matrices)
+  {
+    proto::serializeMatrix(*list->Add(), mat);
+  }
+}
+
+//==============================================================================
+template <typename ListProto>
+static std::vector<Eigen::MatrixXs> deserializeMatrices(const ListProto& list)
+{
+  std::vector<Eigen::MatrixXs> matrices;
+  for (const proto::MatrixXs& mat : list)
+  {
+    matrices.push_back(proto::deserializeMatrix(mat));
+  }
+  return matrices;
+}
+
+//==============================================================================
+/// This writes a [row][column] table into a table proto, converting each
+/// value to the proto's scalar type `P`
+template <typename P, typename T, typename TableProto>
+static void serializeTable(
+    TableProto& proto, const std::vector<std::vector<T>>& table)
+{
+  for (const std::vector<T>& row : table)
+  {
+    auto* rowProto = proto.add_rows();
+    for (int i = 0; i < row.size(); i++)
+    {
+      rowProto->add_values(static_cast<P>(row[i]));
+    }
+  }
+}
+
+//==============================================================================
+template <typename T, typename TableProto>
+static std::vector<std::vector<T>> deserializeTable(const TableProto& proto)
+{
+  std::vector<std::vector<T>> table;
+  for (const auto& rowProto : proto.rows())
+  {
+    std::vector<T> row;
+    for (const auto& value : rowProto.values())
+    {
+      row.push_back(static_cast<T>(value));
+    }
+    table.push_back(row);
+  }
+  return table;
+}
+
+//==============================================================================
+/// This writes the [trial][row][column] tables, one table proto per trial
+template <typename P, typename T, typename ListProto>
+static void serializeTables(
+    ListProto* list, const std::vector<std::vector<std::vector<T>>>& tables)
+{
+  for (const auto& table : tables)
+  {
+    serializeTable<P>(*list->Add(), table);
+  }
+}
+
+//==============================================================================
+template <typename T, typename ListProto>
+static std::vector<std::vector<std::vector<T>>> deserializeTables(
+    const ListProto& list)
+{
+  std::vector<std::vector<std::vector<T>>> tables;
+  for (const auto& table : list)
+  {
+    tables.push_back(deserializeTable<T>(table));
+  }
+  return tables;
+}
+
+//==============================================================================
+DynamicsPipeline::DynamicsPipeline(
+    std::shared_ptr<dynamics::Skeleton> skel, std::string checkpointPath)
+  : mSkeleton(skel), mCheckpointPath(checkpointPath)
+{
+}
+
+//==============================================================================
+/// This adds a stage to the end of the pipeline. Stage names are what the
+/// checkpoint records, so they must be unique, and stable between runs.
+void DynamicsPipeline::addStage(const std::string& name, Stage stage)
+{
+  mStageNames.push_back(name);
+  mStages.push_back(stage);
+}
+
+//==============================================================================
+/// This runs every stage that hasn't already finished, checkpointing after
+/// each one, and returns the final initialization. If there's a checkpoint
+/// from an earlier run of the same stages, `init` is ignored and the fit
+/// resumes from the checkpoint instead. Errors thrown by a stage are passed
+/// on, leaving the checkpoint at the last stage that finished.
+std::shared_ptr<DynamicsInitialization> DynamicsPipeline::run(
+    std::shared_ptr<DynamicsInitialization> init)
+{
+  mCompletedStages.clear();
+
+  proto::DynamicsInitialization checkpoint;
+  if (mCheckpointPath != "" && readCheckpoint(mCheckpointPath, checkpoint))
+  {
+    // Only trust the checkpoint if it came from the start of this pipeline
+    const auto& completedStages = checkpoint.completedstages();
+    bool matches = completedStages.size() <= mStageNames.size();
+    for (int i = 0; matches && i < completedStages.size(); i++)
+    {
+      matches = completedStages[i] == mStageNames[i];
+    }
+    if (!matches)
+    {
+      dtwarn << "[DynamicsPipeline::run] The checkpoint at " << mCheckpointPath
+             << " is from a different list of stages, so we're ignoring it "
+             << "and starting from the beginning\n";
+    }
+    else
+    {
+      std::shared_ptr<DynamicsInitialization> resumed
+          = deserializeInitialization(
+              checkpoint, mSkeleton, &mCompletedStages);
+      if (resumed != nullptr)
+      {
+        init = resumed;
+      }
+    }
+  }
+
+  if (init == nullptr)
+  {
+    dterr << "[DynamicsPipeline::run] Got a null initialization, and there "
+          << "was no checkpoint to resume from\n";
+    return nullptr;
+  }
+
+  for (int i = mCompletedStages.size(); i < mStages.size(); i++)
+  {
+    mStages[i](init);
+    mCompletedStages.push_back(mStageNames[i]);
+    if (mCheckpointPath != "")
+    {
+      saveCheckpoint(mCheckpointPath, mSkeleton, init, mCompletedStages);
+    }
+  }
+
+  return init;
+}
+
+//==============================================================================
+/// This returns the names of the stages that have finished, including
+/// any that were skipped because they finished in an earlier run
+const std::vector<std::string>& DynamicsPipeline::getCompletedStages() const
+{
+  return mCompletedStages;
+}
+
+//==============================================================================
+/// This writes `init` out to a protobuf, along with the Skeleton's current
+/// masses, COMs, inertias and scales, and the list of finished stages.
+void DynamicsPipeline::serializeInitialization(
+    proto::DynamicsInitialization& proto,
+    std::shared_ptr<dynamics::Skeleton> skel,
+    std::shared_ptr<DynamicsInitialization> init,
+    const std::vector<std::string>& completedStages)
+{
+  proto.set_version(DYNAMICS_CHECKPOINT_VERSION);
+  for (const std::string& stage : completedStages)
+  {
+    proto.add_completedstages(stage);
+  }
+
+  proto::serializeVector(
+      *proto.mutable_skeletongroupscales(), skel->getGroupScales());
+  proto::serializeVector(
+      *proto.mutable_skeletonlinkmasses(), skel->getLinkMasses());
+  proto::serializeVector(
+      *proto.mutable_skeletonlinkcoms(), skel->getLinkCOMs());
+  proto::serializeVector(
+      *proto.mutable_skeletonlinkmois(), skel->getLinkMOIs());
+
+  // Inputs from files
+  for (const auto& plates : init->forcePlateTrials)
+  {
+    serializeForcePlates(*proto.add_forceplatetrials(), plates);
+  }
+  serializeMatrices(proto.mutable_originalposes(), init->originalPoses);
+  for (const auto& trial : init->markerObservationTrials)
+  {
+    proto::DynamicsMarkerTrial* trialProto
+        = proto.add_markerobservationtrials();
+    for (const auto& timestep : trial)
+    {
+      serializeNamedPoints(*trialProto->add_timesteps(), timestep);
+    }
+  }
+  for (s_t dt : init->trialTimesteps)
+  {
+    proto.add_trialtimesteps(static_cast<double>(dt));
+  }
+
+  // Assigning GRFs to specific feet
+  serializeMatrices(proto.mutable_grftrials(), init->grfTrials);
+  for (int index : init->grfBodyIndices)
+  {
+    proto.add_grfbodyindices(index);
+  }
+  for (const dynamics::BodyNode* body : init->grfBodyNodes)
+  {
+    proto.add_grfbodynodes(body->getName());
+  }
+
+  // Physically consistent results
+  serializeMatrices(proto.mutable_perfectgrftrials(), init->perfectGrfTrials);
+  serializeMatrices(proto.mutable_perfecttorques(), init->perfectTorques);
+  serializeMatrices(
+      proto.mutable_perfectgrfascoptorqueforces(),
+      init->perfectGrfAsCopTorqueForces);
+  for (const auto& plates : init->perfectForcePlateTrials)
+  {
+    serializeForcePlates(*proto.add_perfectforceplatetrials(), plates);
+  }
+
+  // Foot ground contact
+  for (s_t height : init->groundHeight)
+  {
+    proto.add_groundheight(static_cast<double>(height));
+  }
+  for (bool flat : init->flatGround)
+  {
+    proto.add_flatground(flat);
+  }
+  for (const auto& bodies : init->contactBodies)
+  {
+    proto::DynamicsStringList* list = proto.add_contactbodies();
+    for (const dynamics::BodyNode* body : bodies)
+    {
+      list->add_values(body->getName());
+    }
+  }
+  serializeTables<double>(
+      proto.mutable_grfbodycontactsphereradius(),
+      init->grfBodyContactSphereRadius);
+  serializeTables<bool>(
+      proto.mutable_grfbodyforceactive(), init->grfBodyForceActive);
+  serializeTables<bool>(
+      proto.mutable_grfbodysphereincontact(), init->grfBodySphereInContact);
+  for (const auto& corners : init->defaultForcePlateCorners)
+  {
+    serializePoints(*proto.add_defaultforceplatecorners(), corners);
+  }
+  serializeTables<bool>(
+      proto.mutable_grfbodyoffforceplate(), init->grfBodyOffForcePlate);
+  for (const std::vector<bool>& missing : init->probablyMissingGRF)
+  {
+    proto::DynamicsBoolList* list = proto.add_probablymissinggrf();
+    for (bool value : missing)
+    {
+      list->add_values(value);
+    }
+  }
+  serializeTables<int>(
+      proto.mutable_forceplatesassignedtocontactbody(),
+      init->forcePlatesAssignedToContactBody);
+
+  serializeMatrices(proto.mutable_reactionwheels(), init->reactionWheels);
+
+  // Pure dynamics values
+  proto::serializeVector(*proto.mutable_bodymasses(), init->bodyMasses);
+  proto::serializeVector(*proto.mutable_groupmasses(), init->groupMasses);
+  proto::serializeMatrix(*proto.mutable_bodycom(), init->bodyCom);
+  proto::serializeMatrix(*proto.mutable_bodyinertia(), init->bodyInertia);
+  proto::serializeVector(*proto.mutable_groupinertias(), init->groupInertias);
+
+  // Values from the kinematics fitter
+  serializeMatrices(proto.mutable_posetrials(), init->poseTrials);
+  proto::serializeVector(*proto.mutable_groupscales(), init->groupScales);
+  serializeNamedPoints(*proto.mutable_markeroffsets(), init->markerOffsets);
+  for (const std::string& marker : init->trackingMarkers)
+  {
+    proto.add_trackingmarkers(marker);
+  }
+  for (const dynamics::Joint* joint : init->joints)
+  {
+    proto.add_joints(joint->getName());
+  }
+  for (const auto& markers : init->jointsAdjacentMarkers)
+  {
+    proto::DynamicsStringList* list = proto.add_jointsadjacentmarkers();
+    for (const std::string& marker : markers)
+    {
+      list->add_values(marker);
+    }
+  }
+  proto::serializeVector(*proto.mutable_jointweights(), init->jointWeights);
+  serializeMatrices(proto.mutable_jointcenters(), init->jointCenters);
+  proto::serializeVector(*proto.mutable_axisweights(), init->axisWeights);
+  serializeMatrices(proto.mutable_jointaxis(), init->jointAxis);
+  for (const auto& pair : init->updatedMarkerMap)
+  {
+    proto::DynamicsMarker* marker = proto.add_updatedmarkermap();
+    marker->set_name(pair.first);
+    marker->set_body(pair.second.first->getName());
+    proto::serializeVector(*marker->mutable_offset(), pair.second.second);
+  }
+
+  // Values at initialization, for reporting
+  proto::serializeVector(
+      *proto.mutable_initialgroupmasses(), init->initialGroupMasses);
+  proto::serializeVector(
+      *proto.mutable_initialgroupcoms(), init->initialGroupCOMs);
+  proto::serializeVector(
+      *proto.mutable_initialgroupinertias(), init->initialGroupInertias);
+  proto::serializeVector(
+      *proto.mutable_initialgroupscales(), init->initialGroupScales);
+  serializeNamedPoints(
+      *proto.mutable_initialmarkeroffsets(), init->initialMarkerOffsets);
+
+  // Regularization targets
+  serializeMatrices(proto.mutable_regularizeposesto(), init->regularizePosesTo);
+  proto::serializeVector(
+      *proto.mutable_regularizegroupmassesto(), init->regularizeGroupMassesTo);
+  proto::serializeVector(
+      *proto.mutable_regularizegroupcomsto(), init->regularizeGroupCOMsTo);
+  proto::serializeVector(
+      *proto.mutable_regularizegroupinertiasto(),
+      init->regularizeGroupInertiasTo);
+  proto::serializeVector(
+      *proto.mutable_regularizegroupscalesto(), init->regularizeGroupScalesTo);
+  serializeNamedPoints(
+      *proto.mutable_regularizemarkeroffsetsto(),
+      init->regularizeMarkerOffsetsTo);
+}
+
+//==============================================================================
+/// This reads an initialization back from serializeInitialization(),
+/// resolving body nodes and joints by name on `skel`, and restoring the
+/// Skeleton's saved masses, COMs, inertias and scales. If
+/// `completedStages` isn't null, it's filled with the finished stages.
+/// This returns nullptr, and prints an error, if the proto is from a newer
+/// version or refers to bodies or joints that `skel` doesn't have.
+std::shared_ptr<DynamicsInitialization>
+DynamicsPipeline::deserializeInitialization(
+    const proto::DynamicsInitialization& proto,
+    std::shared_ptr<dynamics::Skeleton> skel,
+    std::vector<std::string>* completedStages)
+{
+  if (proto.version() > DYNAMICS_CHECKPOINT_VERSION)
+  {
+    dterr << "[DynamicsPipeline::deserializeInitialization] This checkpoint "
+          << "was written with version " << proto.version()
+          << ", but we only understand up to version "
+          << DYNAMICS_CHECKPOINT_VERSION << "\n";
+    return nullptr;
+  }
+
+  Eigen::VectorXs groupScales
+      = proto::deserializeVector(proto.skeletongroupscales());
+  Eigen::VectorXs linkMasses
+      = proto::deserializeVector(proto.skeletonlinkmasses());
+  Eigen::VectorXs linkCOMs = proto::deserializeVector(proto.skeletonlinkcoms());
+  Eigen::VectorXs linkMOIs = proto::deserializeVector(proto.skeletonlinkmois());
+  if (groupScales.size() != skel->getGroupScaleDim()
+      || linkMasses.size() != skel->getNumBodyNodes()
+      || linkCOMs.size() != skel->getLinkCOMDims()
+      || linkMOIs.size() != skel->getLinkMOIDims())
+  {
+    dterr << "[DynamicsPipeline::deserializeInitialization] This checkpoint "
+          << "was written for a Skeleton with a different shape than ["
+          << skel->getName() << "]\n";
+    return nullptr;
+  }
+
+  // Look up all the bodies and joints by name first, so we don't touch the
+  // Skeleton if any of them are missing
+  std::map<std::string, dynamics::BodyNode*> bodies;
+  std::map<std::string, dynamics::Joint*> joints;
+  std::vector<std::string> missing;
+  auto findBody = [&](const std::string& name) {
+    if (bodies.count(name) == 0)
+    {
+      bodies[name] = skel->getBodyNode(name);
+      if (bodies[name] == nullptr)
+        missing.push_back(name);
+    }
+    return bodies[name];
+  };
+  auto findJoint = [&](const std::string& name) {
+    if (joints.count(name) == 0)
+    {
+      joints[name] = skel->getJoint(name);
+      if (joints[name] == nullptr)
+        missing.push_back(name);
+    }
+    return joints[name];
+  };
+
+  std::shared_ptr<DynamicsInitialization> init
+      = std::make_shared<DynamicsInitialization>();
+
+  // Inputs from files
+  for (const auto& plates : proto.forceplatetrials())
+  {
+    init->forcePlateTrials.push_back(deserializeForcePlates(plates));
+  }
+  init->originalPoses = deserializeMatrices(proto.originalposes());
+  for (const auto& trialProto : proto.markerobservationtrials())
+  {
+    std::vector<std::map<std::string, Eigen::Vector3s>> trial;
+    for (const auto& timestep : trialProto.timesteps())
+    {
+      trial.push_back(deserializeNamedPoints(timestep));
+    }
+    init->markerObservationTrials.push_back(trial);
+  }
+  for (double dt : proto.trialtimesteps())
+  {
+    init->trialTimesteps.push_back(static_cast<s_t>(dt));
+  }
+
+  // Assigning GRFs to specific feet
+  init->grfTrials = deserializeMatrices(proto.grftrials());
+  init->grfBodyIndices = std::vector<int>(
+      proto.grfbodyindices().begin(), proto.grfbodyindices().end());
+  for (const std::string& name : proto.grfbodynodes())
+  {
+    init->grfBodyNodes.push_back(findBody(name));
+  }
+
+  // Physically consistent results
+  init->perfectGrfTrials = deserializeMatrices(proto.perfectgrftrials());
+  init->perfectTorques = deserializeMatrices(proto.perfecttorques());
+  init->perfectGrfAsCopTorqueForces
+      = deserializeMatrices(proto.perfectgrfascoptorqueforces());
+  for (const auto& plates : proto.perfectforceplatetrials())
+  {
+    init->perfectForcePlateTrials.push_back(deserializeForcePlates(plates));
+  }
+
+  // Foot ground contact
+  for (double height : proto.groundheight())
+  {
+    init->groundHeight.push_back(static_cast<s_t>(height));
+  }
+  init->flatGround = std::vector<bool>(
+      proto.flatground().begin(), proto.flatground().end());
+  for (const auto& list : proto.contactbodies())
+  {
+    std::vector<dynamics::BodyNode*> trialBodies;
+    for (const std::string& name : list.values())
+    {
+      trialBodies.push_back(findBody(name));
+    }
+    init->contactBodies.push_back(trialBodies);
+  }
+  init->grfBodyContactSphereRadius
+      = deserializeTables<s_t>(proto.grfbodycontactsphereradius());
+  init->grfBodyForceActive
+      = deserializeTables<bool>(proto.grfbodyforceactive());
+  init->grfBodySphereInContact
+      = deserializeTables<bool>(proto.grfbodysphereincontact());
+  for (const auto& corners : proto.defaultforceplatecorners())
+  {
+    init->defaultForcePlateCorners.push_back(deserializePoints(corners));
+  }
+  init->grfBodyOffForcePlate
+      = deserializeTables<bool>(proto.grfbodyoffforceplate());
+  for (const auto& list : proto.probablymissinggrf())
+  {
+    init->probablyMissingGRF.push_back(
+        std::vector<bool>(list.values().begin(), list.values().end()));
+  }
+  init->forcePlatesAssignedToContactBody
+      = deserializeTables<int>(proto.forceplatesassignedtocontactbody());
+
+  init->reactionWheels = deserializeMatrices(proto.reactionwheels());
+
+  // Pure dynamics values
+  init->bodyMasses = proto::deserializeVector(proto.bodymasses());
+  init->groupMasses = proto::deserializeVector(proto.groupmasses());
+  init->bodyCom = proto::deserializeMatrix(proto.bodycom());
+  init->bodyInertia = proto::deserializeMatrix(proto.bodyinertia());
+  init->groupInertias = proto::deserializeVector(proto.groupinertias());
+
+  // Values from the kinematics fitter
+  init->poseTrials = deserializeMatrices(proto.posetrials());
+  init->groupScales = proto::deserializeVector(proto.groupscales());
+  init->markerOffsets = deserializeNamedPoints(proto.markeroffsets());
+  init->trackingMarkers = std::vector<std::string>(
+      proto.trackingmarkers().begin(), proto.trackingmarkers().end());
+  for (const std::string& name : proto.joints())
+  {
+    init->joints.push_back(findJoint(name));
+  }
+  for (const auto& list : proto.jointsadjacentmarkers())
+  {
+    init->jointsAdjacentMarkers.push_back(
+        std::vector<std::string>(list.values().begin(), list.values().end()));
+  }
+  init->jointWeights = proto::deserializeVector(proto.jointweights());
+  init->jointCenters = deserializeMatrices(proto.jointcenters());
+  init->axisWeights = proto::deserializeVector(proto.axisweights());
+  init->jointAxis = deserializeMatrices(proto.jointaxis());
+  for (const proto::DynamicsMarker& marker : proto.updatedmarkermap())
+  {
+    Eigen::VectorXs offset = proto::deserializeVector(marker.offset());
+    init->updatedMarkerMap[marker.name()] = std::make_pair(
+        findBody(marker.body()),
+        offset.size() == 3 ? Eigen::Vector3s(offset) : Eigen::Vector3s::Zero());
+  }
+
+  // Values at initialization, for reporting
+  init->initialGroupMasses
+      = proto::deserializeVector(proto.initialgroupmasses());
+  init->initialGroupCOMs = proto::deserializeVector(proto.initialgroupcoms());
+  init->initialGroupInertias
+      = proto::deserializeVector(proto.initialgroupinertias());
+  init->initialGroupScales
+      = proto::deserializeVector(proto.initialgroupscales());
+  init->initialMarkerOffsets
+      = deserializeNamedPoints(proto.initialmarkeroffsets());
+
+  // Regularization targets
+  init->regularizePosesTo = deserializeMatrices(proto.regularizeposesto());
+  init->regularizeGroupMassesTo
+      = proto::deserializeVector(proto.regularizegroupmassesto());
+  init->regularizeGroupCOMsTo
+      = proto::deserializeVector(proto.regularizegroupcomsto());
+  init->regularizeGroupInertiasTo
+      = proto::deserializeVector(proto.regularizegroupinertiasto());
+  init->regularizeGroupScalesTo
+      = proto::deserializeVector(proto.regularizegroupscalesto());
+  init->regularizeMarkerOffsetsTo
+      = deserializeNamedPoints(proto.regularizemarkeroffsetsto());
+
+  if (missing.size() > 0)
+  {
+    dterr << "[DynamicsPipeline::deserializeInitialization] This checkpoint "
+          << "refers to " << missing.size() << " bodies or joints that "
+          << "aren't on Skeleton [" << skel->getName() << "], starting with ["
+          << missing[0] << "]\n";
+    return nullptr;
+  }
+
+  // Scale first, since scaling moves the COMs
+  skel->setGroupScales(groupScales);
+  skel->setLinkMasses(linkMasses);
+  skel->setLinkCOMs(linkCOMs);
+  skel->setLinkMOIs(linkMOIs);
+
+  if (completedStages != nullptr)
+  {
+    *completedStages = std::vector<std::string>(
+        proto.completedstages().begin(), proto.completedstages().end());
+  }
+  return init;
+}
+
+//==============================================================================
+/// This writes a checkpoint file. The file is written next to `path` and
+/// then renamed over it, so a crash mid-write leaves the old checkpoint
+/// intact. This returns false, and prints an error, on failure.
+bool DynamicsPipeline::saveCheckpoint(
+    const std::string& path,
+    std::shared_ptr<dynamics::Skeleton> skel,
+    std::shared_ptr<DynamicsInitialization> init,
+    const std::vector<std::string>& completedStages)
+{
+  proto::DynamicsInitialization proto;
+  serializeInitialization(proto, skel, init, completedStages);
+
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+    if (!file || !proto.SerializeToOstream(&file))
+    {
+      dterr << "[DynamicsPipeline::saveCheckpoint] Failed to write " << tmpPath
+            << "\n";
+      return false;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+  {
+    dterr << "[DynamicsPipeline::saveCheckpoint] Failed to move " << tmpPath
+          << " to " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+/// This reads a checkpoint file from saveCheckpoint(). This returns
+/// nullptr if the file doesn't exist or can't be read.
+std::shared_ptr<DynamicsInitialization> DynamicsPipeline::loadCheckpoint(
+    const std::string& path,
+    std::shared_ptr<dynamics::Skeleton> skel,
+    std::vector<std::string>* completedStages)
+{
+  proto::DynamicsInitialization proto;
+  if (!readCheckpoint(path, proto))
+  {
+    return nullptr;
+  }
+  return deserializeInitialization(proto, skel, completedStages);
+}
+
+//==============================================================================
+/// This reads the raw proto from a checkpoint file, and returns false if the
+/// file doesn't exist or can't be decoded
+bool DynamicsPipeline::readCheckpoint(
+    const std::string& path, proto::DynamicsInitialization& proto)
+{
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  if (!proto.ParseFromIstream(&file))
+  {
+    dterr << "[DynamicsPipeline::readCheckpoint] Failed to decode " << path
+          << "\n";
+    return false;
+  }
+  return true;
+}
+
+} // namespace biomechanics
+} // namespace dart
@@ -0,0 +1,103 @@
+#ifndef BIOMECH_DYNAMICS_PIPELINE
+#define BIOMECH_DYNAMICS_PIPELINE
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dart/biomechanics/DynamicsFitter.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/proto/DynamicsInitialization.pb.h"
+
+namespace dart {
+namespace biomechanics {
+
+/**
+ * A full DynamicsFitter run (timeSyncAndInitializePipeline(),
+ * optimizeSpatialResidualsOnCOMTrajectory(), runIPOPTOptimization(), ...) can
+ * take hours, and if the process dies partway through all that work is lost.
+ * This runs the fit as a list of named stages, and writes the
+ * DynamicsInitialization (and the Skeleton's masses, COMs, inertias and
+ * scales) to a checkpoint file after each one. Running the same pipeline
+ * again with the same checkpoint path skips the stages that already
+ * finished, and carries on from the saved state.
+ */
+class DynamicsPipeline
+{
+public:
+  typedef std::function<void(std::shared_ptr<DynamicsInitialization>)> Stage;
+
+  /// An empty `checkpointPath` runs the stages without checkpointing
+  DynamicsPipeline(
+      std::shared_ptr<dynamics::Skeleton> skel, std::string checkpointPath);
+
+  /// This adds a stage to the end of the pipeline. Stage names are what the
+  /// checkpoint records, so they must be unique, and stable between runs.
+  void addStage(const std::string& name, Stage stage);
+
+  /// This runs every stage that hasn't already finished, checkpointing after
+  /// each one, and returns the final initialization. If there's a checkpoint
+  /// from an earlier run of the same stages, `init` is ignored and the fit
+  /// resumes from the checkpoint instead. Errors thrown by a stage are passed
+  /// on, leaving the checkpoint at the last stage that finished.
+  std::shared_ptr<DynamicsInitialization> run(
+      std::shared_ptr<DynamicsInitialization> init);
+
+  /// This returns the names of the stages that have finished, including
+  /// any that were skipped because they finished in an earlier run
+  const std::vector<std::string>& getCompletedStages() const;
+
+  /// This writes `init` out to a protobuf, along with the Skeleton's current
+  /// masses, COMs, inertias and scales, and the list of finished stages.
+  static void serializeInitialization(
+      proto::DynamicsInitialization& proto,
+      std::shared_ptr<dynamics::Skeleton> skel,
+      std::shared_ptr<DynamicsInitialization> init,
+      const std::vector<std::string>& completedStages
+      = std::vector<std::string>());
+
+  /// This reads an initialization back from serializeInitialization(),
+  /// resolving body nodes and joints by name on `skel`, and restoring the
+  /// Skeleton's saved masses, COMs, inertias and scales. If
+  /// `completedStages` isn't null, it's filled with the finished stages.
+  /// This returns nullptr, and prints an error, if the proto is from a newer
+  /// version or refers to bodies or joints that `skel` doesn't have.
+  static std::shared_ptr<DynamicsInitialization> deserializeInitialization(
+      const proto::DynamicsInitialization& proto,
+      std::shared_ptr<dynamics::Skeleton> skel,
+      std::vector<std::string>* completedStages = nullptr);
+
+  /// This writes a checkpoint file. The file is written next to `path` and
+  /// then renamed over it, so a crash mid-write leaves the old checkpoint
+  /// intact. This returns false, and prints an error, on failure.
+  static bool saveCheckpoint(
+      const std::string& path,
+      std::shared_ptr<dynamics::Skeleton> skel,
+      std::shared_ptr<DynamicsInitialization> init,
+      const std::vector<std::string>& completedStages);
+
+  /// This reads a checkpoint file from saveCheckpoint(). This returns
+  /// nullptr if the file doesn't exist or can't be read.
+  static std::shared_ptr<DynamicsInitialization> loadCheckpoint(
+      const std::string& path,
+      std::shared_ptr<dynamics::Skeleton> skel,
+      std::vector<std::string>* completedStages = nullptr);
+
+protected:
+  /// This reads the raw proto from a checkpoint file, and returns false if the
+  /// file doesn't exist or can't be decoded
+  static bool readCheckpoint(
+      const std::string& path, proto::DynamicsInitialization& proto);
+
+  std::shared_ptr<dynamics::Skeleton> mSkeleton;
+  std::string mCheckpointPath;
+  std::vector<std::string> mStageNames;
+  std::vector<Stage> mStages;
+  std::vector<std::string> mCompletedStages;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
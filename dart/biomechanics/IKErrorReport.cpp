@@ -1,8 +1,13 @@
 #include "dart/biomechanics/IKErrorReport.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <ostream>
+#include <sstream>
 #include <string>
+#include <thread>
+
+#include "dart/common/TaskScheduler.hpp"
 
 namespace dart {
 namespace biomechanics {
@@ -12,7 +17,8 @@ IKErrorReport::IKErrorReport(
     dynamics::MarkerMap markers,
     Eigen::MatrixXs poses,
     std::vector<std::map<std::string, Eigen::Vector3s>> observations,
-    std::shared_ptr<Anthropometrics> anthropometrics)
+    std::shared_ptr<Anthropometrics> anthropometrics,
+    int numThreads)
   : averageRootMeanSquaredError(0.0),
     averageSumSquaredError(0.0),
     averageMaxError(0.0)
@@ -24,102 +30,147 @@ IKErrorReport::IKErrorReport(
   }
 
   // Collect the names of all the observed markers on any timestep into a single
-  // vector
+  // vector, in the order we first see them
+  std::map<std::string, int> markerNameIndices;
   for (int i = 0; i < observations.size(); i++)
   {
     for (auto& pair : observations[i])
     {
-      if (std::find(markerNames.begin(), markerNames.end(), pair.first)
-          == markerNames.end())
+      if (markerNameIndices.emplace(pair.first, markerNames.size()).second)
       {
         markerNames.push_back(pair.first);
       }
     }
   }
 
-  Eigen::VectorXs originalPos = skel->getPositions();
-
-  for (std::string& name : markerNames)
+  // Run forward kinematics for the whole trajectory up front, in parallel
+  std::map<std::string, int> markerMapIndices;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markerList;
+  for (auto& pair : markers)
   {
-    rmseMarkerErrors[name] = 0;
-    numMarkerObservations[name] = 0;
+    markerMapIndices[pair.first] = markerList.size();
+    markerList.push_back(pair.second);
   }
+  const int numTimesteps = observations.size();
+  Eigen::MatrixXs markerPositions = skel->getMarkerWorldPositionsBatch(
+      poses.leftCols(numTimesteps), markerList, numThreads);
 
-  for (int i = 0; i < observations.size(); i++)
-  {
-    skel->setPositions(poses.col(i));
-    std::map<std::string, Eigen::Vector3s> worldMarkers
-        = skel->getMarkerMapWorldPositions(markers);
-
-    s_t thisTotalSquaredError = 0.0;
-    s_t thisMaxError = 0.0;
-    std::string worstMarker = "[NONE]";
-    Eigen::Vector3s worstMarkerError = Eigen::Vector3s::Zero();
-    Eigen::Vector3s worstMarkerReal = Eigen::Vector3s::Zero();
-    Eigen::Vector3s worstMarkerPredicted = Eigen::Vector3s::Zero();
-
-    std::map<std::string, s_t> markerErrorTableEntry;
-    for (std::string& name : markerNames)
-    {
-      markerErrorTableEntry[name] = 0.;
-    }
+  worstMarkers.resize(numTimesteps);
+  worstMarkerErrors.resize(numTimesteps);
+  worstMarkerReals.resize(numTimesteps);
+  worstMarkerPredicteds.resize(numTimesteps);
+  markerErrorTimesteps.resize(numTimesteps);
+  rootMeanSquaredError.resize(numTimesteps);
+  maxError.resize(numTimesteps);
+  sumSquaredError.resize(numTimesteps);
 
-    for (auto pair : observations[i])
+  // Each timestep only writes its own entries, and its own row of the
+  // squared errors, so we can split the timesteps across threads. Unobserved
+  // markers get a squared error of -1.
+  Eigen::MatrixXs squaredErrors
+      = Eigen::MatrixXs::Constant(numTimesteps, markerNames.size(), -1.0);
+  auto reportRange = [&](int start, int end) {
+    for (int i = start; i < end; i++)
     {
-      std::string markerName = pair.first;
-      if (worldMarkers.count(markerName) > 0)
+      s_t thisTotalSquaredError = 0.0;
+      s_t thisMaxError = 0.0;
+      std::string worstMarker = "[NONE]";
+      Eigen::Vector3s worstMarkerError = Eigen::Vector3s::Zero();
+      Eigen::Vector3s worstMarkerReal = Eigen::Vector3s::Zero();
+      Eigen::Vector3s worstMarkerPredicted = Eigen::Vector3s::Zero();
+
+      std::map<std::string, s_t> markerErrorTableEntry;
+      for (std::string& name : markerNames)
       {
-        Eigen::Vector3s diff
-            = observations[i][markerName] - worldMarkers[markerName];
+        markerErrorTableEntry[name] = 0.;
+      }
+
+      for (auto& pair : observations[i])
+      {
+        const std::string& markerName = pair.first;
+        auto markerIt = markerMapIndices.find(markerName);
+        if (markerIt == markerMapIndices.end())
+        {
+          continue;
+        }
+        const Eigen::Vector3s predicted
+            = markerPositions.block<3, 1>(markerIt->second * 3, i);
+        Eigen::Vector3s diff = pair.second - predicted;
         s_t squaredError = diff.squaredNorm();
         markerErrorTableEntry[markerName] = sqrt(squaredError);
-        rmseMarkerErrors[markerName] += squaredError;
-        numMarkerObservations[markerName]++;
+        squaredErrors(i, markerNameIndices.at(markerName)) = squaredError;
         thisTotalSquaredError += squaredError;
         thisMaxError = std::max(thisMaxError, diff.norm());
         if (diff.squaredNorm() > worstMarkerError.squaredNorm())
         {
           worstMarker = markerName;
           worstMarkerError = diff;
-          worstMarkerReal = observations[i][markerName];
-          worstMarkerPredicted = worldMarkers[markerName];
+          worstMarkerReal = pair.second;
+          worstMarkerPredicted = predicted;
         }
       }
+      worstMarkers[i] = worstMarker;
+      worstMarkerErrors[i] = worstMarkerError;
+      worstMarkerReals[i] = worstMarkerReal;
+      worstMarkerPredicteds[i] = worstMarkerPredicted;
+      markerErrorTimesteps[i] = markerErrorTableEntry;
+
+      rootMeanSquaredError[i]
+          = sqrt(thisTotalSquaredError / observations[i].size());
+      maxError[i] = thisMaxError;
+      sumSquaredError[i] = thisTotalSquaredError;
     }
-    worstMarkers.push_back(worstMarker);
-    worstMarkerErrors.push_back(worstMarkerError);
-    worstMarkerReals.push_back(worstMarkerReal);
-    worstMarkerPredicteds.push_back(worstMarkerPredicted);
-    markerErrorTimesteps.push_back(markerErrorTableEntry);
-
-    s_t thisRootMeanSquaredError
-        = sqrt(thisTotalSquaredError / observations[i].size());
-    this->rootMeanSquaredError.push_back(thisRootMeanSquaredError);
-    this->maxError.push_back(thisMaxError);
-    this->sumSquaredError.push_back(thisTotalSquaredError);
-
-    if (isfinite(thisRootMeanSquaredError) && isfinite(thisTotalSquaredError)
-        && isfinite(thisMaxError))
+  };
+
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, numTimesteps));
+  std::vector<common::TaskFuture<void>> futures;
+  for (int t = 0; t < numThreads; t++)
+  {
+    const int start = (numTimesteps * t) / numThreads;
+    const int end = (numTimesteps * (t + 1)) / numThreads;
+    futures.push_back(common::async(
+        [&reportRange, start, end] { reportRange(start, end); }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  // We add everything up in timestep order, so the averages don't depend on
+  // the number of threads
+  for (int i = 0; i < numTimesteps; i++)
+  {
+    if (isfinite(rootMeanSquaredError[i]) && isfinite(sumSquaredError[i])
+        && isfinite(maxError[i]))
     {
-      this->averageRootMeanSquaredError += thisRootMeanSquaredError;
-      this->averageSumSquaredError += thisTotalSquaredError;
-      this->averageMaxError += thisMaxError;
+      this->averageRootMeanSquaredError += rootMeanSquaredError[i];
+      this->averageSumSquaredError += sumSquaredError[i];
+      this->averageMaxError += maxError[i];
     }
   }
   this->averageRootMeanSquaredError /= observations.size();
   this->averageSumSquaredError /= observations.size();
   this->averageMaxError /= observations.size();
 
-  for (std::string& name : markerNames)
+  for (int j = 0; j < markerNames.size(); j++)
   {
-    if (numMarkerObservations[name] > 0)
+    s_t total = 0.0;
+    int count = 0;
+    for (int i = 0; i < numTimesteps; i++)
     {
-      rmseMarkerErrors[name] /= numMarkerObservations[name];
-      rmseMarkerErrors[name] = sqrt(rmseMarkerErrors[name]);
+      if (squaredErrors(i, j) >= 0)
+      {
+        total += squaredErrors(i, j);
+        count++;
+      }
     }
+    numMarkerObservations[markerNames[j]] = count;
+    rmseMarkerErrors[markerNames[j]] = count > 0 ? sqrt(total / count) : 0.0;
   }
-
-  skel->setPositions(originalPos);
 }
 
 void IKErrorReport::printReport(int limitTimesteps)
@@ -161,34 +212,38 @@ void IKErrorReport::printReport(int limitTimesteps)
 
 void IKErrorReport::saveCSVMarkerErrorReport(const std::string& path)
 {
-  std::ofstream errorCSV;
-  errorCSV.open(path);
+  // We build the whole file in memory and write it out in one go, rather
+  // than flushing the file on every row
+  std::ostringstream errorCSV;
 
   errorCSV << "Timestep";
   for (std::string& markerName : markerNames)
   {
     errorCSV << "," << markerName;
   }
-  errorCSV << std::endl;
+  errorCSV << "\n";
 
   errorCSV << "All Timesteps RMSE";
   for (std::string& markerName : markerNames)
   {
     errorCSV << "," << rmseMarkerErrors.at(markerName);
   }
-  errorCSV << std::endl;
+  errorCSV << "\n";
 
   for (int i = 0; i < markerErrorTimesteps.size(); i++)
   {
     errorCSV << i;
+    const std::map<std::string, s_t>& timestep = markerErrorTimesteps.at(i);
     for (std::string& markerName : markerNames)
     {
-      errorCSV << "," << markerErrorTimesteps.at(i).at(markerName);
+      errorCSV << "," << timestep.at(markerName);
     }
-    errorCSV << std::endl;
+    errorCSV << "\n";
   }
 
-  errorCSV.close();
+  std::ofstream file(path);
+  file << errorCSV.str();
+  file.close();
 }
 
 std::vector<std::pair<std::string, s_t>> IKErrorReport::getSortedMarkerRMSE()
@@ -23,12 +23,16 @@ namespace biomechanics {
 class IKErrorReport
 {
 public:
+  /// This computes the errors for every timestep of `poses`, splitting the
+  /// timesteps across up to `numThreads` threads (<= 0 means one per
+  /// hardware thread). `skel` is left where it was.
   IKErrorReport(
       std::shared_ptr<dynamics::Skeleton> skel,
       dynamics::MarkerMap markers,
       Eigen::MatrixXs poses,
       std::vector<std::map<std::string, Eigen::Vector3s>> observations,
-      std::shared_ptr<Anthropometrics> anthropometrics = nullptr);
+      std::shared_ptr<Anthropometrics> anthropometrics = nullptr,
+      int numThreads = -1);
 
   void printReport(int limitTimesteps = -1);
 
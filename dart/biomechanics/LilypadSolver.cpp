@@ -1,5 +1,7 @@
 #include "dart/biomechanics/LilypadSolver.hpp"
 
+#include <functional>
+
 #include <assimp/scene.h>
 #include <math.h>
 
@@ -19,6 +21,13 @@ LilypadCell::LilypadCell()
 {
 }
 
+std::size_t LilypadCellHash::operator()(const std::pair<int, int>& key) const
+{
+  return std::hash<long long>()(
+      (static_cast<long long>(key.first) << 32)
+      ^ static_cast<unsigned int>(key.second));
+}
+
 LilypadSolver::LilypadSolver(
     std::shared_ptr<dynamics::Skeleton> skeleton,
     std::vector<const dynamics::BodyNode*> groundContactBodies,
@@ -42,6 +51,11 @@ LilypadSolver::LilypadSolver(
   }
   mXNormal.normalize();
   mYNormal = mXNormal.cross(groundNormal).normalized();
+
+  for (const dynamics::BodyNode* body : mBodies)
+  {
+    mLocalVertices.push_back(body->getLocalVertices());
+  }
 };
 
 /// Get the body nodes that are in contact with the ground, as we currently
@@ -49,10 +63,11 @@ LilypadSolver::LilypadSolver(
 std::vector<const dynamics::BodyNode*> LilypadSolver::getContactBodies()
 {
   std::vector<const dynamics::BodyNode*> bodies;
-  for (const dynamics::BodyNode* body : mBodies)
+  for (int b = 0; b < mBodies.size(); b++)
   {
+    const dynamics::BodyNode* body = mBodies[b];
     std::vector<BodyNode::MovingVertex> vertices
-        = body->getMovingVerticesInWorldSpace();
+        = body->getMovingVerticesInWorldSpace(mLocalVertices[b]);
     for (BodyNode::MovingVertex& vert : vertices)
     {
       LilypadCell& cell = getCell(vert.pos);
@@ -99,10 +114,11 @@ void LilypadSolver::process(Eigen::MatrixXs poses, int startTime)
     mSkeleton->setPositions(poses.col(i));
     mSkeleton->setVelocities(vel);
     mSkeleton->setAccelerations(accel);
-    for (const dynamics::BodyNode* body : mBodies)
+    for (int b = 0; b < mBodies.size(); b++)
     {
       std::vector<dynamics::BodyNode::MovingVertex> movingVerts
-          = body->getMovingVerticesInWorldSpace(startTime + i);
+          = mBodies[b]->getMovingVerticesInWorldSpace(
+              mLocalVertices[b], startTime + i);
 
       s_t top = -std::numeric_limits<s_t>::infinity();
       s_t bottom = std::numeric_limits<s_t>::infinity();
@@ -1,9 +1,10 @@
 #ifndef DART_NEURAL_LILYPAD_HPP_
 #define DART_NEURAL_LILYPAD_HPP_
 
+#include <cstddef>
 #include <memory>
-// #include <unordered_map>
-#include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -34,6 +35,13 @@ public:
   std::vector<dynamics::BodyNode::MovingVertex> mFastVerts;
 };
 
+/// This hashes the (x, y) tile coordinates of a LilypadCell, so the cells
+/// can live in a sparse hash grid
+struct LilypadCellHash
+{
+  std::size_t operator()(const std::pair<int, int>& key) const;
+};
+
 class LilypadSolver
 {
 public:
@@ -79,6 +87,8 @@ protected:
   s_t lilypadRadius;
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
   std::vector<const dynamics::BodyNode*> mBodies;
+  /// The mesh vertices of each of mBodies, in local space, read once up front
+  std::vector<std::vector<Eigen::Vector3s>> mLocalVertices;
 
   /// These complete a basis of the space
   Eigen::Vector3s mGroundNormal;
@@ -103,7 +113,7 @@ protected:
   /// section.
   s_t mBottomThresholdPercentage;
 
-  std::map<std::pair<int, int>, LilypadCell> mPads;
+  std::unordered_map<std::pair<int, int>, LilypadCell, LilypadCellHash> mPads;
 };
 
 } // namespace biomechanics
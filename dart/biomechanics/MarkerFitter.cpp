@@ -1,6 +1,5 @@
 #include "dart/biomechanics/MarkerFitter.hpp"
 
-#include <future>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -15,6 +14,7 @@
 
 #include "dart/biomechanics/MarkerFixer.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -35,6 +35,117 @@ namespace biomechanics {
 
 using namespace Ipopt;
 
+namespace {
+
+/// This holds the marker world positions, and their Jacobians, for the last
+/// (Skeleton, kinematics version, markers) that this thread asked about. That
+/// way the loss, gradients and Jacobians at a single point all share one pass
+/// over the kinematics. Anything that moves the bodies bumps the Skeleton's
+/// kinematics version, which throws the whole entry out.
+struct MarkerEvaluationCache
+{
+  std::weak_ptr<dynamics::Skeleton> skeleton;
+  std::size_t version = 0;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+
+  bool hasWorldPositions = false;
+  Eigen::VectorXs worldPositions;
+  bool hasJacWrtJoints = false;
+  Eigen::MatrixXs jacWrtJoints;
+  bool hasJacWrtGroupScales = false;
+  Eigen::MatrixXs jacWrtGroupScales;
+  bool hasJacWrtMarkerOffsets = false;
+  Eigen::MatrixXs jacWrtMarkerOffsets;
+};
+
+thread_local MarkerEvaluationCache markerEvaluationCache;
+
+//==============================================================================
+MarkerEvaluationCache& getMarkerEvaluationCache(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  MarkerEvaluationCache& cache = markerEvaluationCache;
+  // Holding a weak_ptr keeps the control block alive, so a new Skeleton can
+  // never be mistaken for an old one that happened to share its address
+  bool sameSkeleton = !cache.skeleton.expired()
+                      && !cache.skeleton.owner_before(skeleton)
+                      && !skeleton.owner_before(cache.skeleton);
+  if (!sameSkeleton || cache.version != skeleton->getKinematicsVersion()
+      || cache.markers != markers)
+  {
+    cache.skeleton = skeleton;
+    cache.version = skeleton->getKinematicsVersion();
+    cache.markers = markers;
+    cache.hasWorldPositions = false;
+    cache.hasJacWrtJoints = false;
+    cache.hasJacWrtGroupScales = false;
+    cache.hasJacWrtMarkerOffsets = false;
+  }
+  return cache;
+}
+
+//==============================================================================
+const Eigen::VectorXs& getCachedMarkerWorldPositions(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  MarkerEvaluationCache& cache = getMarkerEvaluationCache(skeleton, markers);
+  if (!cache.hasWorldPositions)
+  {
+    cache.worldPositions = skeleton->getMarkerWorldPositions(markers);
+    cache.hasWorldPositions = true;
+  }
+  return cache.worldPositions;
+}
+
+//==============================================================================
+const Eigen::MatrixXs& getCachedMarkerJacobianWrtJoints(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  MarkerEvaluationCache& cache = getMarkerEvaluationCache(skeleton, markers);
+  if (!cache.hasJacWrtJoints)
+  {
+    cache.jacWrtJoints
+        = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+    cache.hasJacWrtJoints = true;
+  }
+  return cache.jacWrtJoints;
+}
+
+//==============================================================================
+const Eigen::MatrixXs& getCachedMarkerJacobianWrtGroupScales(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  MarkerEvaluationCache& cache = getMarkerEvaluationCache(skeleton, markers);
+  if (!cache.hasJacWrtGroupScales)
+  {
+    cache.jacWrtGroupScales
+        = skeleton->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
+    cache.hasJacWrtGroupScales = true;
+  }
+  return cache.jacWrtGroupScales;
+}
+
+//==============================================================================
+const Eigen::MatrixXs& getCachedMarkerJacobianWrtMarkerOffsets(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
+{
+  MarkerEvaluationCache& cache = getMarkerEvaluationCache(skeleton, markers);
+  if (!cache.hasJacWrtMarkerOffsets)
+  {
+    cache.jacWrtMarkerOffsets
+        = skeleton->getMarkerWorldPositionsJacobianWrtMarkerOffsets(markers);
+    cache.hasJacWrtMarkerOffsets = true;
+  }
+  return cache.jacWrtMarkerOffsets;
+}
+
+} // anonymous namespace
+
 //==============================================================================
 /// This unflattens an input vector, given some information about the problm
 MarkerFitterState::MarkerFitterState(
@@ -550,8 +661,14 @@ MarkerFitter::MarkerFitter(
     mIterationLimit(500),
     mLBFGSHistoryLength(8),
     mJointFitSGDIterations(500),
+    mJointFitFrameStride(1),
+    mJointFitUseGaussNewton(false),
+    mAdaptiveBilevelSampling(false),
+    mAdaptiveBilevelInitialSamples(20),
+    mAdaptiveBilevelTolerance(1e-3),
     mCheckDerivatives(false),
     mUseParallelIKWarps(false),
+    mWarmStartIK(false),
     mPrintFrequency(1),
     mSilenceOutput(false),
     mDisableLinesearch(false),
@@ -559,6 +676,9 @@ MarkerFitter::MarkerFitter(
     mTrackingMarkerDefaultWeight(0.02)
 {
   mSkeletonBallJoints = mSkeleton->convertSkeletonToBallJoints();
+  mSkeletonClonePool = std::make_shared<dynamics::SkeletonClonePool>(mSkeleton);
+  mSkeletonBallJointsClonePool
+      = std::make_shared<dynamics::SkeletonClonePool>(mSkeletonBallJoints);
 
   // Pre-filter the markers to get rid of artificial joint centers
   dynamics::MarkerMap filteredMarkers;
@@ -1355,7 +1475,9 @@ MarkerInitialization MarkerFitter::runKinematicsPipeline(
 
   // 4. Run bilevel optimization
   std::shared_ptr<BilevelFitResult> bilevelFit
-      = optimizeBilevel(markerObservations, reinit, numSamples);
+      = mAdaptiveBilevelSampling
+            ? optimizeBilevelAdaptively(markerObservations, reinit, numSamples)
+            : optimizeBilevel(markerObservations, reinit, numSamples);
 
   // 5. Fine-tune IK and re-fit all the points
   mSkeleton->setGroupScales(bilevelFit->groupScales);
@@ -2430,6 +2552,26 @@ std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevel(
     int numSamples,
     bool applyInnerProblemGradientConstraints)
 {
+  return optimizeBilevelOnTimesteps(
+      markerObservations,
+      initialization,
+      math::evenlySpacedTimesteps(markerObservations.size(), numSamples),
+      applyInnerProblemGradientConstraints);
+}
+
+//==============================================================================
+/// This is the same as `optimizeBilevel()`, except it fine tunes exactly the
+/// timesteps in `sampleIndices`, rather than evenly spaced ones.
+std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevelOnTimesteps(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    MarkerInitialization& initialization,
+    std::vector<int> sampleIndices,
+    bool applyInnerProblemGradientConstraints)
+{
+  // completeBilevelResult() walks the samples in order
+  std::sort(sampleIndices.begin(), sampleIndices.end());
+
   // Before using Eigen in a multi-threaded environment, we need to explicitly
   // call this (at least prior to Eigen 3.3)
   Eigen::initParallel();
@@ -2512,7 +2654,7 @@ std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevel(
       this,
       markerObservations,
       initialization,
-      numSamples,
+      sampleIndices,
       applyInnerProblemGradientConstraints,
       result);
   result->sampleIndices = problem->getSampleIndices();
@@ -2548,6 +2690,94 @@ std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevel(
   return result;
 }
 
+//==============================================================================
+/// This runs the bilevel optimization on a small set of the most informative
+/// timesteps, then keeps doubling the set (warm starting from the last
+/// solution) until the scales and marker offsets stop moving, or we reach
+/// `maxSamples` timesteps.
+std::shared_ptr<BilevelFitResult> MarkerFitter::optimizeBilevelAdaptively(
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations,
+    MarkerInitialization& initialization,
+    int maxSamples,
+    bool applyInnerProblemGradientConstraints)
+{
+  maxSamples = std::min(maxSamples, (int)markerObservations.size());
+
+  // The root joint only moves the whole body around, which tells us nothing
+  // about the scales or marker offsets, so we leave it out of the pose
+  // diversity
+  int dofs = mSkeleton->getNumDofs();
+  int rootDofs = mSkeleton->getRootJoint()->getNumDofs();
+  Eigen::MatrixXs features = initialization.poses.bottomRows(dofs - rootDofs);
+
+  int numSamples = std::min(mAdaptiveBilevelInitialSamples, maxSamples);
+  std::vector<int> sampleIndices
+      = pickInformativeTimesteps(features, numSamples);
+
+  MarkerInitialization warmStart = initialization;
+  std::shared_ptr<BilevelFitResult> result;
+  while (true)
+  {
+    if (mDebugLoss)
+    {
+      std::cout << "Adaptive bilevel fit on " << sampleIndices.size() << "/"
+                << markerObservations.size() << " timesteps" << std::endl;
+    }
+    std::shared_ptr<BilevelFitResult> last = result;
+    result = optimizeBilevelOnTimesteps(
+        markerObservations,
+        warmStart,
+        sampleIndices,
+        applyInnerProblemGradientConstraints);
+    if ((int)sampleIndices.size() >= maxSamples || result->poses.size() == 0)
+    {
+      break;
+    }
+
+    if (last != nullptr)
+    {
+      s_t scaleChange = (result->groupScales - last->groupScales).norm()
+                        / std::max(last->groupScales.norm(), (s_t)1e-9);
+      s_t offsetChange = 0.0;
+      for (int i = 0; i < result->rawMarkerOffsets.size() / 3; i++)
+      {
+        offsetChange = std::max(
+            offsetChange,
+            (result->rawMarkerOffsets.segment<3>(i * 3)
+             - last->rawMarkerOffsets.segment<3>(i * 3))
+                .norm());
+      }
+      if (mDebugLoss)
+      {
+        std::cout << "Scales changed by " << scaleChange
+                  << ", marker offsets moved by at most " << offsetChange
+                  << "m" << std::endl;
+      }
+      if (scaleChange < mAdaptiveBilevelTolerance
+          && offsetChange < mAdaptiveBilevelTolerance)
+      {
+        break;
+      }
+    }
+
+    // Warm start the next round from where we just finished
+    warmStart.groupScales = result->groupScales;
+    warmStart.markerOffsets = result->markerOffsets;
+    for (int i = 0; i < result->sampleIndices.size(); i++)
+    {
+      warmStart.poses.col(result->sampleIndices[i]) = result->poses[i];
+    }
+
+    numSamples = std::min(numSamples * 2, maxSamples);
+    std::vector<int> added = pickInformativeTimesteps(
+        features, numSamples - (int)sampleIndices.size(), sampleIndices);
+    sampleIndices.insert(sampleIndices.end(), added.begin(), added.end());
+  }
+
+  return result;
+}
+
 //==============================================================================
 /// The bilevel optimization only picks a subset of poses to fine tune. This
 /// method takes those poses as a starting point, and extends each pose
@@ -2581,7 +2811,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
                "between our sampled indices..."
             << std::endl;
 
-  std::vector<std::future<void>> blockFitFutures;
+  std::vector<common::TaskFuture<void>> blockFitFutures;
 
   // 2. Do a forward pass starting at each sample index and guessing forward to
   // the next index
@@ -2648,7 +2878,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         forwardScores.segment(thisIndex, segmentLength),
         false);
         */
-    blockFitFutures.push_back(std::async(
+    blockFitFutures.push_back(common::async(
         &MarkerFitter::fitTrajectory,
         this,
         solution->groupScales,
@@ -2733,7 +2963,7 @@ MarkerInitialization MarkerFitter::completeBilevelResult(
         backwardScores.segment(thisIndex, segmentLength),
         true);
         */
-    blockFitFutures.push_back(std::async(
+    blockFitFutures.push_back(common::async(
         &MarkerFitter::fitTrajectory,
         this,
         solution->groupScales,
@@ -3013,13 +3243,13 @@ MarkerInitialization MarkerFitter::fineTuneIK(
       mSkeleton->getNumDofs(), markerObservations.size());
   result.poseScores = Eigen::VectorXs::Zero(markerObservations.size());
 
-  std::vector<std::future<void>> blockFitFutures;
+  std::vector<common::TaskFuture<void>> blockFitFutures;
   for (int i = 0; i < numBlocks; i++)
   {
     std::cout << "Starting fit for whole block " << i << "/" << numBlocks
               << std::endl;
 
-    blockFitFutures.push_back(std::async(
+    blockFitFutures.push_back(common::async(
         &MarkerFitter::fitTrajectory,
         this,
         result.groupScales,
@@ -3066,7 +3296,7 @@ MarkerInitialization MarkerFitter::smoothOutIK(
   smoothed.observedJoints = initialization.observedJoints;
   smoothed.unobservedJoints = initialization.unobservedJoints;
 
-  std::vector<std::future<void>> ikFutures;
+  std::vector<common::TaskFuture<void>> ikFutures;
 
   // Smooth each trial
   int trialStart = 0;
@@ -3468,7 +3698,7 @@ MarkerInitialization MarkerFitter::getInitialization(
 
   // 2. Find IK+scaling for the beginning of each block independently
   std::vector<ScaleAndFitResult> posesAndScales;
-  std::vector<std::future<ScaleAndFitResult>> posesAndScalesFutures;
+  std::vector<common::TaskFuture<ScaleAndFitResult>> posesAndScalesFutures;
 
   if (params.groupScales.size() > 0)
   {
@@ -3504,7 +3734,7 @@ MarkerInitialization MarkerFitter::getInitialization(
         true));
     exit(1);
     */
-    posesAndScalesFutures.push_back(std::async(
+    posesAndScalesFutures.push_back(common::async(
         &MarkerFitter::scaleAndFit,
         this,
         blocks[i][0],
@@ -3605,7 +3835,7 @@ MarkerInitialization MarkerFitter::getInitialization(
   // most numBlocks times
   for (int k = 0; k < params.numIKTries; k++)
   {
-    std::vector<std::future<void>> blockFitFutures;
+    std::vector<common::TaskFuture<void>> blockFitFutures;
     for (int i = 0; i < numBlocks; i++)
     {
       std::cout << "Starting fit for whole block " << i << "/" << numBlocks
@@ -3613,7 +3843,7 @@ MarkerInitialization MarkerFitter::getInitialization(
 
       if (shouldProcessBlock[i])
       {
-        blockFitFutures.push_back(std::async(
+        blockFitFutures.push_back(common::async(
             &MarkerFitter::fitTrajectory,
             this,
             result.groupScales,
@@ -3638,7 +3868,7 @@ MarkerInitialization MarkerFitter::getInitialization(
       }
       else
       {
-        blockFitFutures.push_back(std::async([]() {}));
+        blockFitFutures.push_back(common::async([]() {}));
       }
     }
     for (int i = 0; i < numBlocks; i++)
@@ -3723,13 +3953,13 @@ MarkerInitialization MarkerFitter::getInitialization(
     std::cout << "Fixing jitters by running a round of single-threaded IK"
               << std::endl;
 
-    std::vector<std::future<void>> trialFitFutures;
+    std::vector<common::TaskFuture<void>> trialFitFutures;
     for (int i = 0; i < numTrials; i++)
     {
       std::cout << "Starting fit for whole trial " << i << "/" << numTrials
                 << std::endl;
 
-      trialFitFutures.push_back(std::async(
+      trialFitFutures.push_back(common::async(
           &MarkerFitter::fitTrajectory,
           this,
           result.groupScales,
@@ -4606,12 +4836,13 @@ void MarkerFitter::fitTrajectory(
 {
   assert(initObservedJoints.size() > 0);
 
-  // 0. To make this thread safe, we're going to clone the fitter skeleton
+  // 0. To make this thread safe, we're going to grab our own copy of the
+  // fitter skeleton
   std::shared_ptr<dynamics::Skeleton> skeleton;
   {
     const std::lock_guard<std::mutex> lock(
         *(const_cast<std::mutex*>(&fitter->mGlobalLock)));
-    skeleton = fitter->mSkeleton->clone();
+    skeleton = fitter->mSkeletonClonePool->acquire();
   }
   skeleton->setGroupScales(groupScales);
 
@@ -4626,9 +4857,14 @@ void MarkerFitter::fitTrajectory(
 
   if (useBallJoints)
   {
-    // 1.1. Convert the skeleton to have any Euler joints as ball joints
-    std::shared_ptr<dynamics::Skeleton> skeletonBallJoints
-        = skeleton->convertSkeletonToBallJoints();
+    // 1.1. Use the version of the skeleton with any Euler joints as ball
+    // joints
+    std::shared_ptr<dynamics::Skeleton> skeletonBallJoints;
+    {
+      const std::lock_guard<std::mutex> lock(
+          *(const_cast<std::mutex*>(&fitter->mGlobalLock)));
+      skeletonBallJoints = fitter->mSkeletonBallJointsClonePool->acquire();
+    }
     skeletonBallJoints->setGroupScales(groupScales);
     std::vector<dynamics::Joint*> jointsForSkeletonBallJoints;
     for (auto joint : joints)
@@ -4647,6 +4883,102 @@ void MarkerFitter::fitTrajectory(
     assert(result.rows() == skeleton->getNumDofs());
     assert(result.cols() == markerObservations.size());
 
+    // 1.4. This fits timesteps [start, end) one after another on the given
+    // skeletons, carrying each solution forward as the guess for the next
+    // timestep
+    auto fitFrames = [&](std::shared_ptr<dynamics::Skeleton> frameSkeleton,
+                         std::shared_ptr<dynamics::Skeleton>
+                             frameSkeletonBallJoints,
+                         const std::vector<dynamics::Joint*>& frameJoints,
+                         const std::vector<dynamics::Joint*>&
+                             frameObservedJoints,
+                         int start,
+                         int end,
+                         Eigen::VectorXs guess) {
+      Eigen::VectorXs lastSolution = guess;
+      Eigen::VectorXs secondToLastSolution = guess;
+      for (int j = start; j < end; j++)
+      {
+        int i = j;
+        if (backwards)
+        {
+          i = markerObservations.size() - 1 - j;
+        }
+
+        // 2.1. Pick a starting point. Consecutive timesteps are usually
+        // nearly identical, so in warm start mode we extrapolate the velocity
+        // from the last two solutions.
+        Eigen::VectorXs frameGuess = lastSolution;
+        if (fitter->mWarmStartIK && j > start + 1)
+        {
+          frameGuess = 2 * lastSolution - secondToLastSolution;
+        }
+
+        // 2.2. Actually run the IK solver
+        s_t finalLoss = fitTrajectoryFrame(
+            fitter,
+            frameSkeleton,
+            frameSkeletonBallJoints,
+            frameJoints,
+            frameObservedJoints,
+            markerObservations[i],
+            markerWeights,
+            markerOffsets,
+            joints,
+            jointCenters[i],
+            jointWeights,
+            jointAxis[i],
+            axisWeights,
+            frameGuess,
+            1);
+
+        // 2.3. If the warm start didn't land somewhere good enough, fall back
+        // to random restarts, and keep whichever solution is better
+        if (fitter->mWarmStartIK
+            && finalLoss > fitter->mInitialIKSatisfactoryLoss)
+        {
+          Eigen::VectorXs warmPose = frameSkeleton->getPositions();
+          Eigen::VectorXs warmBallPose
+              = frameSkeletonBallJoints->getPositions();
+          s_t restartLoss = fitTrajectoryFrame(
+              fitter,
+              frameSkeleton,
+              frameSkeletonBallJoints,
+              frameJoints,
+              frameObservedJoints,
+              markerObservations[i],
+              markerWeights,
+              markerOffsets,
+              joints,
+              jointCenters[i],
+              jointWeights,
+              jointAxis[i],
+              axisWeights,
+              lastSolution,
+              fitter->mInitialIKMaxRestarts);
+          if (restartLoss < finalLoss)
+          {
+            finalLoss = restartLoss;
+          }
+          else
+          {
+            frameSkeleton->setPositions(warmPose);
+            frameSkeletonBallJoints->setPositions(warmBallPose);
+          }
+        }
+
+        // 2.4. Record this outcome
+        result.col(i) = frameSkeleton->getPositions();
+        resultScores(i) = finalLoss;
+
+        // 2.5. Set up for the next iteration, by setting the initial guess to
+        // the current solve
+        secondToLastSolution = lastSolution;
+        lastSolution = frameSkeletonBallJoints->getPositions();
+      }
+      return lastSolution;
+    };
+
     if (fitter->mUseParallelIKWarps)
     {
       int numThreads = 32;
@@ -4659,468 +4991,114 @@ void MarkerFitter::fitTrajectory(
       std::vector<std::shared_ptr<dynamics::Skeleton>> threadSkeletonBallJoints;
       std::vector<std::vector<dynamics::Joint*>>
           threadJointsForSkeletonBallJoints;
+      std::vector<std::vector<dynamics::Joint*>> threadObservedJoints;
+      {
+        const std::lock_guard<std::mutex> lock(
+            *(const_cast<std::mutex*>(&fitter->mGlobalLock)));
+        for (int t = 0; t < numThreads; t++)
+        {
+          threadSkeleton.push_back(fitter->mSkeletonClonePool->acquire());
+          threadSkeletonBallJoints.push_back(
+              fitter->mSkeletonBallJointsClonePool->acquire());
+        }
+      }
       for (int t = 0; t < numThreads; t++)
       {
-        threadSkeleton.push_back(skeleton->cloneSkeleton());
-        threadSkeletonBallJoints.push_back(skeletonBallJoints->cloneSkeleton());
+        threadSkeleton[t]->setGroupScales(groupScales);
+        threadSkeletonBallJoints[t]->setGroupScales(groupScales);
         std::vector<dynamics::Joint*> jointsForThreadSkeletonBallJoints;
         for (auto joint : joints)
         {
           jointsForThreadSkeletonBallJoints.push_back(
-              threadSkeletonBallJoints[threadSkeletonBallJoints.size() - 1]
-                  ->getJoint(joint->getName()));
+              threadSkeletonBallJoints[t]->getJoint(joint->getName()));
         }
         threadJointsForSkeletonBallJoints.push_back(
             jointsForThreadSkeletonBallJoints);
+        std::vector<dynamics::Joint*> observedJointsForThread;
+        for (auto joint : initObservedJoints)
+        {
+          observedJointsForThread.push_back(
+              threadSkeleton[t]->getJoint(joint->getName()));
+        }
+        threadObservedJoints.push_back(observedJointsForThread);
       }
 
-      for (int warp = 0; warp < numWarps; warp++)
+      if (fitter->mWarmStartIK)
       {
-        int warpStart = warp * numThreads;
-        int warpEndExclusive
-            = min((int)(warp + 1) * numThreads, (int)markerObservations.size());
-
-        std::vector<std::future<Eigen::VectorXs>> warpFutures;
-        // 2. Run through each observation in sequence, and do a best fit
-        for (int j = warpStart; j < warpEndExclusive; j++)
+        // 2. Split the trajectory into one contiguous block per thread, and
+        // warm start each block in sequence, in parallel. Only the first
+        // timestep of each block starts cold.
+        int numBlocks = min(numThreads, (int)markerObservations.size());
+        std::vector<common::TaskFuture<Eigen::VectorXs>> blockFutures;
+        for (int b = 0; b < numBlocks; b++)
         {
-          int threadIdx = j - warpStart;
-          int i = j;
-          if (backwards)
-          {
-            i = markerObservations.size() - 1 - j;
-          }
-
-          warpFutures.push_back(std::async([i,
-                                            &markerObservations,
-                                            &jointCenters,
-                                            &jointWeights,
-                                            &jointAxis,
-                                            &axisWeights,
-                                            &markerWeights,
-                                            &markerOffsets,
-                                            &fitter,
-                                            &joints,
-                                            &result,
-                                            &resultScores,
-                                            initialGuess,
-                                            threadIdx,
-                                            &threadSkeleton,
-                                            &threadSkeletonBallJoints,
-                                            &threadJointsForSkeletonBallJoints] {
-            // 2.0. Grab the skeleton copies for this thread
-            std::shared_ptr<dynamics::Skeleton> skeleton
-                = threadSkeleton[threadIdx];
-            std::shared_ptr<dynamics::Skeleton> skeletonBallJoints
-                = threadSkeletonBallJoints[threadIdx];
-            std::vector<dynamics::Joint*> jointsForSkeletonBallJoints
-                = threadJointsForSkeletonBallJoints[threadIdx];
-
-            // 2.1. Linearize the marker names and marker observations. This
-            // needs to be done at each step, because the observed markers can
-            // be different at different steps.
-            Eigen::VectorXs markerPoses
-                = Eigen::VectorXs::Zero(markerObservations[i].size() * 3);
-            Eigen::VectorXs markerWeightsVector
-                = Eigen::VectorXs::Ones(markerObservations[i].size());
-            Eigen::VectorXs centerPoses = jointCenters[i];
-            Eigen::VectorXs axisPoses = jointAxis[i];
-            std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
-                markerVector;
-            std::vector<std::string> outputNames;
-            for (std::pair<std::string, Eigen::Vector3s> pair :
-                 markerObservations[i])
-            {
-              markerPoses.segment<3>(markerVector.size() * 3) = pair.second;
-              if (markerWeights.count(pair.first))
-              {
-                assert(markerWeights.count(pair.first));
-                markerWeightsVector(markerVector.size())
-                    = markerWeights.at(pair.first);
-              }
-              else
-              {
-                markerWeightsVector(markerVector.size())
-                    = fitter->mMarkerIsTracking.at(
-                          fitter->mMarkerIndices.at(pair.first))
-                          ? fitter->mTrackingMarkerDefaultWeight
-                          : fitter->mAnatomicalMarkerDefaultWeight;
-              }
-              assert(fitter->mMarkerMap.count(pair.first));
-              const std::pair<dynamics::BodyNode*, Eigen::Vector3s>&
-                  originalMarker
-                  = fitter->mMarkerMap.at(pair.first);
-              Eigen::Vector3s offset = Eigen::Vector3s::Zero();
-              if (markerOffsets.count(pair.first))
-              {
-                assert(markerOffsets.count(pair.first));
-                offset = markerOffsets.at(pair.first);
-              }
-              markerVector.emplace_back(
-                  skeletonBallJoints->getBodyNode(
-                      originalMarker.first->getName()),
-                  originalMarker.second + offset);
-              Eigen::Vector3s markerPos = originalMarker.second + offset;
-              std::string markerPrefix
-                  = "marker " + originalMarker.first->getName() + " ("
-                    + std::to_string((double)markerPos(0)) + ","
-                    + std::to_string((double)markerPos(1)) + ","
-                    + std::to_string((double)markerPos(2)) + ")";
-              outputNames.push_back(markerPrefix + " X");
-              outputNames.push_back(markerPrefix + " Y");
-              outputNames.push_back(markerPrefix + " Z");
-            }
-            for (int i = 0; i < joints.size(); i++)
-            {
-              std::string jointPrefix = "joint " + joints[i]->getName();
-              outputNames.push_back(jointPrefix + " X");
-              outputNames.push_back(jointPrefix + " Y");
-              outputNames.push_back(jointPrefix + " Z");
-            }
-            std::vector<std::string> inputNames;
-            for (int i = 0; i < skeletonBallJoints->getNumDofs(); i++)
-            {
-              inputNames.push_back(
-                  "dof " + skeletonBallJoints->getDof(i)->getName());
-            }
-
-            assert(markerPoses.size() == markerVector.size() * 3);
-            assert(centerPoses.size() == joints.size() * 3);
-
-            // 2.2. Actually run the IK solver
-            // Initialize at the old config
-
-            const bool ignoreJointLimits = fitter->mIgnoreJointLimits;
-            s_t finalLoss = math::solveIK(
-                initialGuess,
-                skeletonBallJoints->getPositionUpperLimits(),
-                skeletonBallJoints->getPositionLowerLimits(),
-                (markerVector.size() * 3) + (joints.size() * 3),
-                // Set positions
-                [skeletonBallJoints, skeleton, ignoreJointLimits](
-                    /* in*/ const Eigen::VectorXs pos, bool clamp) {
-                  skeletonBallJoints->setPositions(pos);
-                  if (clamp)
-                  {
-                    // 1. Map the position back into eulerian space
-                    skeleton->setPositions(
-                        skeleton->convertPositionsFromBallSpace(pos));
-                    if (!ignoreJointLimits)
-                    {
-                      // 2. Clamp the position to limits
-                      skeleton->clampPositionsToLimits();
-                      // 3. Map the position back into SO3 space
-                      skeletonBallJoints->setPositions(
-                          skeleton->convertPositionsToBallSpace(
-                              skeleton->getPositions()));
-                    }
-                  }
-
-                  // Return the clamped position
-                  return skeletonBallJoints->getPositions();
-                },
-                [skeletonBallJoints,
-                 markerPoses,
-                 markerVector,
-                 markerWeightsVector,
-                 jointsForSkeletonBallJoints,
-                 centerPoses,
-                 jointWeights,
-                 axisPoses,
-                 axisWeights](
-                    /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
-                    /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
-                  assert(
-                      diff.size() == markerPoses.size() + centerPoses.size());
-
-                  diff.segment(0, markerPoses.size())
-                      = skeletonBallJoints->getMarkerWorldPositions(
-                            markerVector)
-                        - markerPoses;
-                  Eigen::VectorXs jointPoses
-                      = skeletonBallJoints->getJointWorldPositions(
-                          jointsForSkeletonBallJoints);
-                  computeJointIKDiff(
-                      diff.segment(markerPoses.size(), centerPoses.size()),
-                      jointPoses,
-                      centerPoses,
-                      jointWeights,
-                      axisPoses,
-                      axisWeights);
-
-                  assert(jac.cols() == skeletonBallJoints->getNumDofs());
-                  assert(
-                      jac.rows()
-                      == (markerVector.size() * 3)
-                             + (jointsForSkeletonBallJoints.size() * 3));
-                  jac.block(
-                      0,
-                      0,
-                      markerVector.size() * 3,
-                      skeletonBallJoints->getNumDofs())
-                      = skeletonBallJoints
-                            ->getMarkerWorldPositionsJacobianWrtJointPositions(
-                                markerVector);
-                  jac.block(
-                      markerVector.size() * 3,
-                      0,
-                      jointsForSkeletonBallJoints.size() * 3,
-                      skeletonBallJoints->getNumDofs())
-                      = skeletonBallJoints
-                            ->getJointWorldPositionsJacobianWrtJointPositions(
-                                jointsForSkeletonBallJoints);
-                  for (int i = 0; i < markerWeightsVector.size(); i++)
-                  {
-                    diff.segment<3>(i * 3) *= markerWeightsVector(i);
-                    jac.block(i * 3, 0, 3, jac.cols())
-                        *= markerWeightsVector(i);
-                  }
-                  rescaleIKJacobianForWeightsAndAxis(
-                      jac.block(
-                          markerVector.size() * 3,
-                          0,
-                          jointsForSkeletonBallJoints.size() * 3,
-                          skeletonBallJoints->getNumDofs()),
-                      jointWeights,
-                      axisPoses,
-                      axisWeights);
-                },
-                [initialGuess](Eigen::Ref<Eigen::VectorXs> val) {
-                  assert(false);
-                  val = initialGuess;
-                },
-                math::IKConfig()
-                    .setMaxStepCount(500)
-                    .setConvergenceThreshold(1e-6)
-                    .setDontExitTranspose(true)
-                    .setLossLowerBound(1e-8)
-                    .setMaxRestarts(1)
-                    .setStartClamped(true)
-                    .setLogOutput(false)
-                    .setInputNames(inputNames)
-                    .setOutputNames(outputNames));
-
-            // 2.3. Record this outcome
-            result.col(i) = skeleton->getPositions();
-            resultScores(i) = finalLoss;
-
-            // 2.4. Set up for the next iteration, by setting the initial guess
-            // to the current solve
-            return skeletonBallJoints->getPositions();
-          }));
+          int blockStart = (b * markerObservations.size()) / numBlocks;
+          int blockEndExclusive
+              = ((b + 1) * markerObservations.size()) / numBlocks;
+          blockFutures.push_back(common::async(
+              [&, b, blockStart, blockEndExclusive]() {
+                return fitFrames(
+                    threadSkeleton[b],
+                    threadSkeletonBallJoints[b],
+                    threadJointsForSkeletonBallJoints[b],
+                    threadObservedJoints[b],
+                    blockStart,
+                    blockEndExclusive,
+                    initialGuess);
+              }));
         }
-
-        // Block until all these warps have finished
-        for (auto& warpFuture : warpFutures)
+        for (auto& blockFuture : blockFutures)
         {
-          initialGuess = warpFuture.get();
+          blockFuture.get();
         }
       }
-    }
-    else
-    {
-      // 2. Run through each observation in sequence, and do a best fit
-      for (int j = 0; j < markerObservations.size(); j++)
+      else
       {
-        int i = j;
-        if (backwards)
-        {
-          i = markerObservations.size() - 1 - j;
-        }
-
-        /*
-        std::cout << "> Fit timestep " << i << "/" << markerObservations.size()
-                  << std::endl;
-        */
-
-        // 2.1. Linearize the marker names and marker observations. This needs
-        // to be done at each step, because the observed markers can be
-        // different at different steps.
-        Eigen::VectorXs markerPoses
-            = Eigen::VectorXs::Zero(markerObservations[i].size() * 3);
-        Eigen::VectorXs markerWeightsVector
-            = Eigen::VectorXs::Ones(markerObservations[i].size());
-        Eigen::VectorXs centerPoses = jointCenters[i];
-        Eigen::VectorXs axisPoses = jointAxis[i];
-        std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
-            markerVector;
-        std::vector<std::string> outputNames;
-        for (std::pair<std::string, Eigen::Vector3s> pair :
-             markerObservations[i])
+        for (int warp = 0; warp < numWarps; warp++)
         {
-          markerPoses.segment<3>(markerVector.size() * 3) = pair.second;
-          if (markerWeights.count(pair.first))
-          {
-            assert(markerWeights.count(pair.first));
-            markerWeightsVector(markerVector.size())
-                = markerWeights.at(pair.first);
-          }
-          else
+          int warpStart = warp * numThreads;
+          int warpEndExclusive = min(
+              (int)(warp + 1) * numThreads, (int)markerObservations.size());
+
+          // 2. Fit every timestep in the warp in parallel, all starting from
+          // the same guess
+          std::vector<common::TaskFuture<Eigen::VectorXs>> warpFutures;
+          for (int j = warpStart; j < warpEndExclusive; j++)
           {
-            markerWeightsVector(markerVector.size())
-                = fitter->mMarkerIsTracking.at(
-                      fitter->mMarkerIndices.at(pair.first))
-                      ? fitter->mTrackingMarkerDefaultWeight
-                      : fitter->mAnatomicalMarkerDefaultWeight;
+            int threadIdx = j - warpStart;
+            warpFutures.push_back(common::async(
+                [&, j, threadIdx, initialGuess]() {
+                  return fitFrames(
+                      threadSkeleton[threadIdx],
+                      threadSkeletonBallJoints[threadIdx],
+                      threadJointsForSkeletonBallJoints[threadIdx],
+                      threadObservedJoints[threadIdx],
+                      j,
+                      j + 1,
+                      initialGuess);
+                }));
           }
-          assert(fitter->mMarkerMap.count(pair.first));
-          const std::pair<dynamics::BodyNode*, Eigen::Vector3s>& originalMarker
-              = fitter->mMarkerMap.at(pair.first);
-          Eigen::Vector3s offset = Eigen::Vector3s::Zero();
-          if (markerOffsets.count(pair.first))
+
+          // Block until all these warps have finished
+          for (auto& warpFuture : warpFutures)
           {
-            assert(markerOffsets.count(pair.first));
-            offset = markerOffsets.at(pair.first);
+            initialGuess = warpFuture.get();
           }
-          markerVector.emplace_back(
-              skeletonBallJoints->getBodyNode(originalMarker.first->getName()),
-              originalMarker.second + offset);
-          Eigen::Vector3s markerPos = originalMarker.second + offset;
-          std::string markerPrefix
-              = "marker " + originalMarker.first->getName() + " ("
-                + std::to_string((double)markerPos(0)) + ","
-                + std::to_string((double)markerPos(1)) + ","
-                + std::to_string((double)markerPos(2)) + ")";
-          outputNames.push_back(markerPrefix + " X");
-          outputNames.push_back(markerPrefix + " Y");
-          outputNames.push_back(markerPrefix + " Z");
-        }
-        for (int i = 0; i < joints.size(); i++)
-        {
-          std::string jointPrefix = "joint " + joints[i]->getName();
-          outputNames.push_back(jointPrefix + " X");
-          outputNames.push_back(jointPrefix + " Y");
-          outputNames.push_back(jointPrefix + " Z");
         }
-        std::vector<std::string> inputNames;
-        for (int i = 0; i < skeletonBallJoints->getNumDofs(); i++)
-        {
-          inputNames.push_back(
-              "dof " + skeletonBallJoints->getDof(i)->getName());
-        }
-
-        assert(markerPoses.size() == markerVector.size() * 3);
-        assert(centerPoses.size() == joints.size() * 3);
-
-        // 2.2. Actually run the IK solver
-        // Initialize at the old config
-
-        const bool ignoreJointLimits = fitter->mIgnoreJointLimits;
-        s_t finalLoss = math::solveIK(
-            initialGuess,
-            skeletonBallJoints->getPositionUpperLimits(),
-            skeletonBallJoints->getPositionLowerLimits(),
-            (markerVector.size() * 3) + (joints.size() * 3),
-            // Set positions
-            [skeletonBallJoints, skeleton, ignoreJointLimits](
-                /* in*/ const Eigen::VectorXs pos, bool clamp) {
-              skeletonBallJoints->setPositions(pos);
-              if (clamp)
-              {
-                // 1. Map the position back into eulerian space
-                skeleton->setPositions(
-                    skeleton->convertPositionsFromBallSpace(pos));
-                if (!ignoreJointLimits)
-                {
-                  // 2. Clamp the position to limits
-                  skeleton->clampPositionsToLimits();
-                  // 3. Map the position back into SO3 space
-                  skeletonBallJoints->setPositions(
-                      skeleton->convertPositionsToBallSpace(
-                          skeleton->getPositions()));
-                }
-              }
-
-              // Return the clamped position
-              return skeletonBallJoints->getPositions();
-            },
-            [skeletonBallJoints,
-             markerPoses,
-             markerVector,
-             markerWeightsVector,
-             jointsForSkeletonBallJoints,
-             centerPoses,
-             jointWeights,
-             axisPoses,
-             axisWeights](
-                /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
-                /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
-              assert(diff.size() == markerPoses.size() + centerPoses.size());
-
-              diff.segment(0, markerPoses.size())
-                  = skeletonBallJoints->getMarkerWorldPositions(markerVector)
-                    - markerPoses;
-              Eigen::VectorXs jointPoses
-                  = skeletonBallJoints->getJointWorldPositions(
-                      jointsForSkeletonBallJoints);
-              computeJointIKDiff(
-                  diff.segment(markerPoses.size(), centerPoses.size()),
-                  jointPoses,
-                  centerPoses,
-                  jointWeights,
-                  axisPoses,
-                  axisWeights);
-
-              assert(jac.cols() == skeletonBallJoints->getNumDofs());
-              assert(
-                  jac.rows()
-                  == (markerVector.size() * 3)
-                         + (jointsForSkeletonBallJoints.size() * 3));
-              jac.block(
-                  0,
-                  0,
-                  markerVector.size() * 3,
-                  skeletonBallJoints->getNumDofs())
-                  = skeletonBallJoints
-                        ->getMarkerWorldPositionsJacobianWrtJointPositions(
-                            markerVector);
-              jac.block(
-                  markerVector.size() * 3,
-                  0,
-                  jointsForSkeletonBallJoints.size() * 3,
-                  skeletonBallJoints->getNumDofs())
-                  = skeletonBallJoints
-                        ->getJointWorldPositionsJacobianWrtJointPositions(
-                            jointsForSkeletonBallJoints);
-              for (int i = 0; i < markerWeightsVector.size(); i++)
-              {
-                diff.segment<3>(i * 3) *= markerWeightsVector(i);
-                jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
-              }
-              rescaleIKJacobianForWeightsAndAxis(
-                  jac.block(
-                      markerVector.size() * 3,
-                      0,
-                      jointsForSkeletonBallJoints.size() * 3,
-                      skeletonBallJoints->getNumDofs()),
-                  jointWeights,
-                  axisPoses,
-                  axisWeights);
-            },
-            [initialGuess](Eigen::Ref<Eigen::VectorXs> val) {
-              assert(false);
-              val = initialGuess;
-            },
-            math::IKConfig()
-                .setMaxStepCount(500)
-                .setConvergenceThreshold(1e-6)
-                .setDontExitTranspose(true)
-                .setLossLowerBound(1e-8)
-                .setMaxRestarts(1)
-                .setStartClamped(true)
-                .setLogOutput(false)
-                .setInputNames(inputNames)
-                .setOutputNames(outputNames));
-
-        // 2.3. Record this outcome
-        result.col(i) = skeleton->getPositions();
-        resultScores(i) = finalLoss;
-
-        // 2.4. Set up for the next iteration, by setting the initial guess to
-        // the current solve
-        initialGuess = skeletonBallJoints->getPositions();
       }
     }
+    else
+    {
+      // 2. Run through each observation in sequence, and do a best fit
+      fitFrames(
+          skeleton,
+          skeletonBallJoints,
+          jointsForSkeletonBallJoints,
+          observedJoints,
+          0,
+          markerObservations.size(),
+          initialGuess);
+    }
   }
   else
   {
@@ -5287,34 +5265,225 @@ void MarkerFitter::fitTrajectory(
 }
 
 //==============================================================================
-/// This solves a bunch of optimization problems, one per joint, to find and
-/// track the joint centers over time. It puts the results back into
-/// `initialization`
-void MarkerFitter::findJointCenters(
-    MarkerInitialization& initialization,
-    const std::vector<bool>& newClip,
-    const std::vector<std::map<std::string, Eigen::Vector3s>>&
-        markerObservations)
+/// This runs IK for a single timestep of fitTrajectory(), on the ball joint
+/// version of the skeleton, starting from `initialGuess` (in ball joint
+/// space). If `maxRestarts` > 1, this also tries random poses for
+/// `observedJoints` until one gets under the satisfactory loss. This leaves
+/// both skeletons at the solution, and returns the final loss.
+s_t MarkerFitter::fitTrajectoryFrame(
+    const MarkerFitter* fitter,
+    std::shared_ptr<dynamics::Skeleton> skeleton,
+    std::shared_ptr<dynamics::Skeleton> skeletonBallJoints,
+    const std::vector<dynamics::Joint*>& jointsForSkeletonBallJoints,
+    const std::vector<dynamics::Joint*>& observedJoints,
+    const std::map<std::string, Eigen::Vector3s>& markerObservations,
+    const std::map<std::string, s_t>& markerWeights,
+    const std::map<std::string, Eigen::Vector3s>& markerOffsets,
+    const std::vector<dynamics::Joint*>& joints,
+    const Eigen::VectorXs& jointCenters,
+    const Eigen::VectorXs& jointWeights,
+    const Eigen::VectorXs& jointAxis,
+    const Eigen::VectorXs& axisWeights,
+    const Eigen::VectorXs& initialGuess,
+    int maxRestarts)
 {
-  // 1. Figure out which joints to find centers for
-  initialization.joints.clear();
-  for (int i = 0; i < mSkeleton->getNumJoints(); i++)
+  // 1. Linearize the marker names and marker observations. This needs to be
+  // done at each step, because the observed markers can be different at
+  // different steps.
+  Eigen::VectorXs markerPoses
+      = Eigen::VectorXs::Zero(markerObservations.size() * 3);
+  Eigen::VectorXs markerWeightsVector
+      = Eigen::VectorXs::Ones(markerObservations.size());
+  Eigen::VectorXs centerPoses = jointCenters;
+  Eigen::VectorXs axisPoses = jointAxis;
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markerVector;
+  std::vector<std::string> outputNames;
+  for (std::pair<std::string, Eigen::Vector3s> pair : markerObservations)
   {
-    if (SphereFitJointCenterProblem::canFitJoint(
-            this, mSkeleton->getJoint(i), markerObservations))
+    markerPoses.segment<3>(markerVector.size() * 3) = pair.second;
+    if (markerWeights.count(pair.first))
     {
-      initialization.joints.push_back(mSkeleton->getJoint(i));
+      markerWeightsVector(markerVector.size()) = markerWeights.at(pair.first);
+    }
+    else
+    {
+      markerWeightsVector(markerVector.size())
+          = fitter->mMarkerIsTracking.at(fitter->mMarkerIndices.at(pair.first))
+                ? fitter->mTrackingMarkerDefaultWeight
+                : fitter->mAnatomicalMarkerDefaultWeight;
+    }
+    assert(fitter->mMarkerMap.count(pair.first));
+    const std::pair<dynamics::BodyNode*, Eigen::Vector3s>& originalMarker
+        = fitter->mMarkerMap.at(pair.first);
+    Eigen::Vector3s offset = Eigen::Vector3s::Zero();
+    if (markerOffsets.count(pair.first))
+    {
+      offset = markerOffsets.at(pair.first);
     }
+    markerVector.emplace_back(
+        skeletonBallJoints->getBodyNode(originalMarker.first->getName()),
+        originalMarker.second + offset);
+    Eigen::Vector3s markerPos = originalMarker.second + offset;
+    std::string markerPrefix = "marker " + originalMarker.first->getName()
+                               + " (" + std::to_string((double)markerPos(0))
+                               + "," + std::to_string((double)markerPos(1))
+                               + "," + std::to_string((double)markerPos(2))
+                               + ")";
+    outputNames.push_back(markerPrefix + " X");
+    outputNames.push_back(markerPrefix + " Y");
+    outputNames.push_back(markerPrefix + " Z");
   }
-  initialization.jointCenters = Eigen::MatrixXs::Zero(
-      initialization.joints.size() * 3, markerObservations.size());
-  assert(
-      initialization.joints.size() * 3 == initialization.jointCenters.rows());
-
-  initialization.jointWeights
-      = Eigen::VectorXs::Ones(initialization.joints.size());
-  initialization.jointLoss
-      = Eigen::VectorXs::Ones(initialization.joints.size());
+  for (int i = 0; i < joints.size(); i++)
+  {
+    std::string jointPrefix = "joint " + joints[i]->getName();
+    outputNames.push_back(jointPrefix + " X");
+    outputNames.push_back(jointPrefix + " Y");
+    outputNames.push_back(jointPrefix + " Z");
+  }
+  std::vector<std::string> inputNames;
+  for (int i = 0; i < skeletonBallJoints->getNumDofs(); i++)
+  {
+    inputNames.push_back("dof " + skeletonBallJoints->getDof(i)->getName());
+  }
+
+  assert(markerPoses.size() == markerVector.size() * 3);
+  assert(centerPoses.size() == joints.size() * 3);
+
+  // 2. Actually run the IK solver
+  const bool ignoreJointLimits = fitter->mIgnoreJointLimits;
+  return math::solveIK(
+      initialGuess,
+      skeletonBallJoints->getPositionUpperLimits(),
+      skeletonBallJoints->getPositionLowerLimits(),
+      (markerVector.size() * 3) + (joints.size() * 3),
+      // Set positions
+      [skeletonBallJoints, skeleton, ignoreJointLimits](
+          /* in*/ const Eigen::VectorXs pos, bool clamp) {
+        skeletonBallJoints->setPositions(pos);
+        if (clamp)
+        {
+          // 1. Map the position back into eulerian space
+          skeleton->setPositions(skeleton->convertPositionsFromBallSpace(pos));
+          if (!ignoreJointLimits)
+          {
+            // 2. Clamp the position to limits
+            skeleton->clampPositionsToLimits();
+            // 3. Map the position back into SO3 space
+            skeletonBallJoints->setPositions(
+                skeleton->convertPositionsToBallSpace(
+                    skeleton->getPositions()));
+          }
+        }
+
+        // Return the clamped position
+        return skeletonBallJoints->getPositions();
+      },
+      [skeletonBallJoints,
+       markerPoses,
+       markerVector,
+       markerWeightsVector,
+       jointsForSkeletonBallJoints,
+       centerPoses,
+       jointWeights,
+       axisPoses,
+       axisWeights](
+          /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+          /*out*/ Eigen::Ref<Eigen::MatrixXs> jac) {
+        assert(diff.size() == markerPoses.size() + centerPoses.size());
+
+        diff.segment(0, markerPoses.size())
+            = skeletonBallJoints->getMarkerWorldPositions(markerVector)
+              - markerPoses;
+        Eigen::VectorXs jointPoses = skeletonBallJoints->getJointWorldPositions(
+            jointsForSkeletonBallJoints);
+        computeJointIKDiff(
+            diff.segment(markerPoses.size(), centerPoses.size()),
+            jointPoses,
+            centerPoses,
+            jointWeights,
+            axisPoses,
+            axisWeights);
+
+        assert(jac.cols() == skeletonBallJoints->getNumDofs());
+        assert(
+            jac.rows()
+            == (markerVector.size() * 3)
+                   + (jointsForSkeletonBallJoints.size() * 3));
+        jac.block(
+            0, 0, markerVector.size() * 3, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getMarkerWorldPositionsJacobianWrtJointPositions(
+                      markerVector);
+        jac.block(
+            markerVector.size() * 3,
+            0,
+            jointsForSkeletonBallJoints.size() * 3,
+            skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtJointPositions(
+                      jointsForSkeletonBallJoints);
+        for (int i = 0; i < markerWeightsVector.size(); i++)
+        {
+          diff.segment<3>(i * 3) *= markerWeightsVector(i);
+          jac.block(i * 3, 0, 3, jac.cols()) *= markerWeightsVector(i);
+        }
+        rescaleIKJacobianForWeightsAndAxis(
+            jac.block(
+                markerVector.size() * 3,
+                0,
+                jointsForSkeletonBallJoints.size() * 3,
+                skeletonBallJoints->getNumDofs()),
+            jointWeights,
+            axisPoses,
+            axisWeights);
+      },
+      // Generate a random restart position
+      [&skeleton, &observedJoints](Eigen::Ref<Eigen::VectorXs> val) {
+        val = skeleton->convertPositionsToBallSpace(
+            skeleton->getRandomPoseForJoints(observedJoints));
+      },
+      math::IKConfig()
+          .setMaxStepCount(500)
+          .setConvergenceThreshold(1e-6)
+          .setDontExitTranspose(true)
+          .setLossLowerBound(
+              maxRestarts > 1 ? fitter->mInitialIKSatisfactoryLoss : 1e-8)
+          .setMaxRestarts(maxRestarts)
+          .setStartClamped(true)
+          .setLogOutput(false)
+          .setInputNames(inputNames)
+          .setOutputNames(outputNames));
+}
+
+//==============================================================================
+/// This solves a bunch of optimization problems, one per joint, to find and
+/// track the joint centers over time. It puts the results back into
+/// `initialization`
+void MarkerFitter::findJointCenters(
+    MarkerInitialization& initialization,
+    const std::vector<bool>& newClip,
+    const std::vector<std::map<std::string, Eigen::Vector3s>>&
+        markerObservations)
+{
+  // 1. Figure out which joints to find centers for
+  initialization.joints.clear();
+  for (int i = 0; i < mSkeleton->getNumJoints(); i++)
+  {
+    if (SphereFitJointCenterProblem::canFitJoint(
+            this, mSkeleton->getJoint(i), markerObservations))
+    {
+      initialization.joints.push_back(mSkeleton->getJoint(i));
+    }
+  }
+  initialization.jointCenters = Eigen::MatrixXs::Zero(
+      initialization.joints.size() * 3, markerObservations.size());
+  assert(
+      initialization.joints.size() * 3 == initialization.jointCenters.rows());
+
+  initialization.jointWeights
+      = Eigen::VectorXs::Ones(initialization.joints.size());
+  initialization.jointLoss
+      = Eigen::VectorXs::Ones(initialization.joints.size());
 
   /*
   // 2. Actually compute the joint centers (single threaded)
@@ -5345,7 +5514,7 @@ void MarkerFitter::findJointCenters(
   }
 
   // 2. Actually compute the joint centers (multi threaded)
-  std::vector<std::future<std::shared_ptr<SphereFitJointCenterProblem>>>
+  std::vector<common::TaskFuture<std::shared_ptr<SphereFitJointCenterProblem>>>
       futures;
   for (int i = 0; i < initialization.joints.size(); i++)
   {
@@ -5364,7 +5533,7 @@ void MarkerFitter::findJointCenters(
                 i * 3, 0, 3, markerObservations.size()));
     initialization.jointsAdjacentMarkers.push_back(problemPtr->mActiveMarkers);
 
-    futures.push_back(std::async(
+    futures.push_back(common::async(
         [this, problemPtr] { return this->findJointCenter(problemPtr); }));
   }
   for (int i = 0; i < futures.size(); i++)
@@ -5385,6 +5554,57 @@ std::shared_ptr<SphereFitJointCenterProblem> MarkerFitter::findJointCenter(
 {
   SphereFitJointCenterProblem* problem = problemPtr.get();
 
+  if (mJointFitUseGaussNewton)
+  {
+    Eigen::VectorXs x = problem->flatten();
+    s_t loss = problem->getLoss();
+    s_t initialLoss = loss;
+    s_t damping = 1e-6;
+    for (int i = 0; i < mJointFitSGDIterations; i++)
+    {
+      Eigen::VectorXs newX = x + problem->getGaussNewtonStep(damping);
+      problem->unflatten(newX);
+      s_t newLoss = problem->getLoss();
+      if (newLoss < loss)
+      {
+        if (logSteps)
+        {
+          std::cout << "[damping=" << damping << "] " << i << ": " << newLoss
+                    << std::endl;
+        }
+        // Once a full step barely moves the loss, we've converged
+        bool converged = loss - newLoss <= 1e-9 * loss;
+        loss = newLoss;
+        x = newX;
+        damping = std::max(damping * 0.1, (s_t)1e-12);
+        if (converged)
+        {
+          break;
+        }
+      }
+      else
+      {
+        if (logSteps)
+        {
+          std::cout << "[bad step, damping=" << damping << "] " << i << ": "
+                    << newLoss << std::endl;
+        }
+        problem->unflatten(x);
+        damping *= 10;
+        if (damping > 1e10)
+        {
+          break;
+        }
+      }
+    }
+    std::cout << "Sphere-fitting (Gauss-Newton) \"" << problemPtr->mJointName
+              << "\""
+              << ": initial loss=" << (initialLoss / problemPtr->mNumTimesteps)
+              << ", final loss=" << (loss / problemPtr->mNumTimesteps)
+              << std::endl;
+    return problemPtr;
+  }
+
   s_t lr = 1.0;
   Eigen::VectorXs x = problem->flatten();
   Eigen::VectorXs accum = Eigen::VectorXs::Ones(x.size()) * 1.0;
@@ -5438,6 +5658,12 @@ std::shared_ptr<SphereFitJointCenterProblem> MarkerFitter::findJointCenter(
       // backtrack
       problem->unflatten(x);
       lr *= 0.5;
+      // Once the step size collapses we've converged, so don't burn the rest
+      // of the iterations
+      if (lr < 1e-10)
+      {
+        break;
+      }
     }
   }
   std::cout << "Sphere-fitting \"" << problemPtr->mJointName << "\""
@@ -5486,7 +5712,7 @@ void MarkerFitter::findAllJointAxis(
   */
 
   // 2. Actually compute the joint centers (multi threaded)
-  std::vector<std::future<std::shared_ptr<CylinderFitJointAxisProblem>>>
+  std::vector<common::TaskFuture<std::shared_ptr<CylinderFitJointAxisProblem>>>
       futures;
   for (int i = 0; i < initialization.joints.size(); i++)
   {
@@ -5506,7 +5732,7 @@ void MarkerFitter::findAllJointAxis(
             initialization.jointAxis.block(
                 i * 6, 0, 6, markerObservations.size()));
 
-    futures.push_back(std::async(
+    futures.push_back(common::async(
         [this, problemPtr] { return this->findJointAxis(problemPtr); }));
   }
   for (int i = 0; i < futures.size(); i++)
@@ -5563,6 +5789,12 @@ std::shared_ptr<CylinderFitJointAxisProblem> MarkerFitter::findJointAxis(
       // backtrack
       problem->unflatten(x);
       lr *= 0.5;
+      // Once the step size collapses we've converged, so don't burn the rest
+      // of the iterations
+      if (lr < 1e-10)
+      {
+        break;
+      }
     }
   }
   std::cout << "Cylinder fitting \"" << problemPtr->mJointName << "\""
@@ -5897,6 +6129,89 @@ std::vector<std::map<std::string, Eigen::Vector3s>> MarkerFitter::pickSubset(
   return result;
 }
 
+//==============================================================================
+/// This greedily picks the `numSamples` columns of `poses` that add the most
+/// information about a model that is linear in the poses (a D-optimal
+/// design), which favors a diverse spread of poses over near duplicates.
+/// Each row is normalized to unit variance first. Columns in
+/// `alreadyPicked` count towards the information, but are never returned
+/// again. The result is sorted.
+std::vector<int> MarkerFitter::pickInformativeTimesteps(
+    const Eigen::MatrixXs& poses,
+    int numSamples,
+    const std::vector<int>& alreadyPicked)
+{
+  const int numTimesteps = poses.cols();
+
+  // 1. Normalize each row, and add a constant row for the offset term
+  Eigen::MatrixXs x = Eigen::MatrixXs::Ones(poses.rows() + 1, numTimesteps);
+  for (int i = 0; i < poses.rows(); i++)
+  {
+    s_t mean = poses.row(i).mean();
+    s_t stddev = sqrt(
+        (poses.row(i).array() - mean).square().sum()
+        / std::max(numTimesteps, 1));
+    if (stddev > 1e-8)
+    {
+      x.row(i + 1) = (poses.row(i).array() - mean) / stddev;
+    }
+    else
+    {
+      x.row(i + 1).setZero();
+    }
+  }
+
+  // 2. Track the leverage x^T M^-1 x of every timestep, where M is the
+  // (slightly regularized) information matrix of the timesteps picked so far.
+  // Each pick is a rank one update of M, so Sherman-Morrison lets us update
+  // M^-1 and all the leverages in O(dims * timesteps).
+  const s_t regularization = 1e-3;
+  Eigen::MatrixXs Minv
+      = Eigen::MatrixXs::Identity(x.rows(), x.rows()) / regularization;
+  Eigen::VectorXs leverage
+      = x.colwise().squaredNorm().transpose() / regularization;
+  std::vector<bool> picked(numTimesteps, false);
+
+  auto addTimestep = [&](int t) {
+    picked[t] = true;
+    Eigen::VectorXs u = Minv * x.col(t);
+    s_t denom = 1.0 + x.col(t).dot(u);
+    Minv -= u * u.transpose() / denom;
+    leverage -= (x.transpose() * u).array().square().matrix() / denom;
+  };
+
+  for (int t : alreadyPicked)
+  {
+    if (t >= 0 && t < numTimesteps && !picked[t])
+    {
+      addTimestep(t);
+    }
+  }
+
+  // 3. Greedily take the timestep we know the least about
+  std::vector<int> result;
+  while ((int)result.size() < numSamples)
+  {
+    int best = -1;
+    for (int t = 0; t < numTimesteps; t++)
+    {
+      if (!picked[t] && (best == -1 || leverage(t) > leverage(best)))
+      {
+        best = t;
+      }
+    }
+    if (best == -1)
+    {
+      break;
+    }
+    addTimestep(best);
+    result.push_back(best);
+  }
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
 //==============================================================================
 /// All markers are either "anatomical" or "tracking". Markers are presumed to
 /// be anamotical markers unless otherwise specified. Tracking markers are
@@ -6022,7 +6337,7 @@ Eigen::VectorXs MarkerFitter::getMarkerError(
       = Eigen::VectorXs::Zero(mMarkers.size() * 3);
 
   Eigen::VectorXs adjustedMarkerWorldPoses
-      = skeleton->getMarkerWorldPositions(markers);
+      = getCachedMarkerWorldPositions(skeleton, markers);
 
   for (auto pair : visibleMarkerWorldPoses)
   {
@@ -6098,12 +6413,44 @@ void MarkerFitter::setIterationLimit(int limit)
 
 //==============================================================================
 /// Sets the number of SGD iterations to run when fitting joint center / axis
-/// problems
+/// problems. This also caps the Gauss-Newton iterations, if
+/// setJointFitUseGaussNewton() is on.
 void MarkerFitter::setJointFitSGDIterations(int iters)
 {
   mJointFitSGDIterations = iters;
 }
 
+//==============================================================================
+/// If true, the joint center (sphere fitting) problems are solved with damped
+/// Gauss-Newton steps instead of SGD.
+void MarkerFitter::setJointFitUseGaussNewton(bool useGaussNewton)
+{
+  mJointFitUseGaussNewton = useGaussNewton;
+}
+
+//==============================================================================
+/// Sets the frame stride for the joint center / axis problems. With a stride
+/// of N, only every Nth frame's markers go into the fit, and the frames in
+/// between just follow along through the smoothing terms. Defaults to 1.
+void MarkerFitter::setJointFitFrameStride(int stride)
+{
+  mJointFitFrameStride = std::max(stride, 1);
+}
+
+//==============================================================================
+/// If set to true, runKinematicsPipeline() uses optimizeBilevelAdaptively()
+/// instead of a fixed set of evenly spaced timesteps. We start with
+/// `initialSamples` timesteps, and stop growing once no scale changes by
+/// more than `tolerance` (relative) and no marker offset moves by more than
+/// `tolerance` meters. Defaults to false.
+void MarkerFitter::setAdaptiveBilevelSampling(
+    bool adaptive, int initialSamples, s_t tolerance)
+{
+  mAdaptiveBilevelSampling = adaptive;
+  mAdaptiveBilevelInitialSamples = std::max(initialSamples, 1);
+  mAdaptiveBilevelTolerance = tolerance;
+}
+
 //==============================================================================
 /// This sets an anthropometric prior which is used by the default loss. If
 /// you've called `setCustomLossAndGrad` then this has no effect.
@@ -6146,8 +6493,7 @@ Eigen::VectorXs MarkerFitter::getMarkerLossGradientWrtJoints(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
     Eigen::VectorXs lossGradWrtMarkerError)
 {
-  return skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers)
-             .transpose()
+  return getCachedMarkerJacobianWrtJoints(skeleton, markers).transpose()
          * lossGradWrtMarkerError;
 }
 
@@ -6196,8 +6542,7 @@ Eigen::VectorXs MarkerFitter::getMarkerLossGradientWrtGroupScales(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
     Eigen::VectorXs lossGradWrtMarkerError)
 {
-  return skeleton->getMarkerWorldPositionsJacobianWrtGroupScales(markers)
-             .transpose()
+  return getCachedMarkerJacobianWrtGroupScales(skeleton, markers).transpose()
          * lossGradWrtMarkerError;
 }
 
@@ -6246,8 +6591,7 @@ Eigen::VectorXs MarkerFitter::getMarkerLossGradientWrtMarkerOffsets(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
     Eigen::VectorXs lossGradWrtMarkerError)
 {
-  return skeleton->getMarkerWorldPositionsJacobianWrtMarkerOffsets(markers)
-             .transpose()
+  return getCachedMarkerJacobianWrtMarkerOffsets(skeleton, markers).transpose()
          * lossGradWrtMarkerError;
 }
 
@@ -6325,7 +6669,7 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtJoints(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs jac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+      = getCachedMarkerJacobianWrtJoints(skeleton, markers);
 
   // Clear out the sections of the Jacobian that were not observed, since
   // those won't change the error
@@ -6337,6 +6681,69 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtJoints(
   return jac;
 }
 
+//==============================================================================
+/// This gets the jacobian of the marker error wrt the joints, as a sparse
+/// matrix. Each marker only depends on the joints between it and the root,
+/// so this only ever computes (and stores) those columns.
+Eigen::SparseMatrix<s_t> MarkerFitter::getSparseMarkerErrorJacobianWrtJoints(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<int>& sparsityMap)
+{
+  std::vector<bool> observed(markers.size(), true);
+  for (int i : sparsityMap)
+  {
+    observed[i] = false;
+  }
+
+  // Markers on the same body share the world screw axes of all the DOFs that
+  // move it, so we only get those once per body
+  std::vector<math::Jacobian> bodyScrews(skeleton->getNumBodyNodes());
+  std::vector<bool> hasBodyScrews(skeleton->getNumBodyNodes(), false);
+
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (int i = 0; i < markers.size(); i++)
+  {
+    if (!observed[i])
+      continue;
+
+    const dynamics::BodyNode* body = markers[i].first;
+    const std::vector<std::size_t>& dofs = body->getDependentGenCoordIndices();
+    const std::size_t bodyIndex = body->getIndexInSkeleton();
+    math::Jacobian& screws = bodyScrews[bodyIndex];
+    if (!hasBodyScrews[bodyIndex])
+    {
+      screws.resize(6, dofs.size());
+      for (int k = 0; k < dofs.size(); k++)
+      {
+        const dynamics::DegreeOfFreedom* dof = skeleton->getDof(dofs[k]);
+        screws.col(k) = dof->getJoint()->getWorldAxisScrewForPosition(
+            dof->getIndexInJoint());
+      }
+      hasBodyScrews[bodyIndex] = true;
+    }
+
+    const Eigen::Vector3s worldPos
+        = body->getWorldTransform()
+          * body->getScale().cwiseProduct(markers[i].second);
+    // This is the linear half of Skeleton::getWorldPositionJacobian(), just
+    // skipping all the DOFs that can't move this body
+    for (int k = 0; k < dofs.size(); k++)
+    {
+      Eigen::Vector3s col = screws.block<3, 1>(3, k)
+                            + screws.block<3, 1>(0, k).cross(worldPos);
+      for (int j = 0; j < 3; j++)
+      {
+        triplets.emplace_back(i * 3 + j, dofs[k], col(j));
+      }
+    }
+  }
+
+  Eigen::SparseMatrix<s_t> jac(markers.size() * 3, skeleton->getNumDofs());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This gets the jacobian of the marker error wrt the joints
 Eigen::MatrixXs MarkerFitter::finiteDifferenceMarkerErrorJacobianWrtJoints(
@@ -6385,9 +6792,6 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtJoints(
     const Eigen::VectorXs& markerError,
     const std::vector<int>& sparsityMap)
 {
-  Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
-
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
 
@@ -6398,13 +6802,18 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtJoints(
             ->getMarkerWorldPositionsSecondJacobianWrtJointWrtJointPositions(
                 markers, markerError);
 
-  // (d/dq markerError) is getMarkerErrorJacobianWrtJoints(...)
+  // (d/dq markerError) is getMarkerErrorJacobianWrtJoints(...), which is
+  // firstOrderJac with the unobserved rows zeroed out, so
+  // firstOrderJac.transpose() * (d/dq markerError) only needs the observed
+  // rows. We use the sparse version, since each marker only touches the
+  // joints up its own kinematic chain.
   // markerError.transpose() * (d/dq firstOrderJac) is secondOrderJac
+  Eigen::SparseMatrix<s_t> observedJac
+      = getSparseMarkerErrorJacobianWrtJoints(skeleton, markers, sparsityMap);
+  Eigen::SparseMatrix<s_t> firstOrderProduct
+      = observedJac.transpose() * observedJac;
 
-  return 2
-         * ((firstOrderJac.transpose()
-             * getMarkerErrorJacobianWrtJoints(skeleton, markers, sparsityMap))
-            + secondOrderJac);
+  return 2 * (Eigen::MatrixXs(firstOrderProduct) + secondOrderJac);
 }
 
 //==============================================================================
@@ -6462,7 +6871,7 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtGroupScales(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs jac
-      = skeleton->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
+      = getCachedMarkerJacobianWrtGroupScales(skeleton, markers);
 
   // Clear out the sections of the Jacobian that were not observed, since
   // those won't change the error
@@ -6474,6 +6883,20 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtGroupScales(
   return jac;
 }
 
+//==============================================================================
+/// This gets the jacobian of the marker error wrt the group scales, as a
+/// sparse matrix, leaving out the rows of markers that weren't observed
+Eigen::SparseMatrix<s_t>
+MarkerFitter::getSparseMarkerErrorJacobianWrtGroupScales(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<int>& sparsityMap)
+{
+  // There are few enough scale groups that building this densely is cheap
+  return getMarkerErrorJacobianWrtGroupScales(skeleton, markers, sparsityMap)
+      .sparseView();
+}
+
 //==============================================================================
 /// This gets the jacobian of the marker error wrt the group scales
 Eigen::MatrixXs MarkerFitter::finiteDifferenceMarkerErrorJacobianWrtGroupScales(
@@ -6523,7 +6946,7 @@ Eigen::MatrixXs MarkerFitter::getIKLossGradientWrtJointsJacobianWrtGroupScales(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+      = getCachedMarkerJacobianWrtJoints(skeleton, markers);
 
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
@@ -6599,7 +7022,7 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtMarkerOffsets(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs jac
-      = skeleton->getMarkerWorldPositionsJacobianWrtMarkerOffsets(markers);
+      = getCachedMarkerJacobianWrtMarkerOffsets(skeleton, markers);
 
   // Clear out the sections of the Jacobian that were not observed, since
   // those won't change the error
@@ -6611,6 +7034,46 @@ Eigen::MatrixXs MarkerFitter::getMarkerErrorJacobianWrtMarkerOffsets(
   return jac;
 }
 
+//==============================================================================
+/// This gets the jacobian of the marker error wrt the marker offsets, as a
+/// sparse matrix. Each marker's offset only moves that marker, so this is
+/// block diagonal, with one 3x3 block per observed marker.
+Eigen::SparseMatrix<s_t>
+MarkerFitter::getSparseMarkerErrorJacobianWrtMarkerOffsets(
+    const std::shared_ptr<dynamics::Skeleton>& skeleton,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    const std::vector<int>& sparsityMap)
+{
+  std::vector<bool> observed(markers.size(), true);
+  for (int i : sparsityMap)
+  {
+    observed[i] = false;
+  }
+
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  triplets.reserve(markers.size() * 9);
+  for (int i = 0; i < markers.size(); i++)
+  {
+    if (!observed[i])
+      continue;
+
+    const Eigen::Matrix3s R = markers[i].first->getWorldTransform().linear();
+    const Eigen::Vector3s scale = markers[i].first->getScale();
+    for (int col = 0; col < 3; col++)
+    {
+      for (int row = 0; row < 3; row++)
+      {
+        triplets.emplace_back(
+            i * 3 + row, i * 3 + col, R(row, col) * scale(col));
+      }
+    }
+  }
+
+  Eigen::SparseMatrix<s_t> jac(markers.size() * 3, markers.size() * 3);
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
 //==============================================================================
 /// This gets the jacobian of the marker error wrt the marker offsets
 Eigen::MatrixXs
@@ -6665,7 +7128,7 @@ MarkerFitter::getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
     const std::vector<int>& sparsityMap)
 {
   Eigen::MatrixXs firstOrderJac
-      = skeleton->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+      = getCachedMarkerJacobianWrtJoints(skeleton, markers);
 
   // First order grad:
   // 2 * markerError.transpose() * firstOrderJac
@@ -6754,6 +7217,12 @@ void MarkerFitter::setParallelIKWarps(bool parallelWarps)
   mUseParallelIKWarps = parallelWarps;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+void MarkerFitter::setWarmStartIK(bool warmStart)
+{
+  mWarmStartIK = warmStart;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 // The SphereFitJointCenterProblem, which maps the sphere-fitting joint-center
 // problem onto a differentiable format.
@@ -6819,9 +7288,6 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
   mRadii = Eigen::VectorXs::Zero(mActiveMarkers.size());
   mCenterPoints = Eigen::VectorXs::Zero(3 * mNumTimesteps);
 
-  Eigen::VectorXi numRadiiObservations
-      = Eigen::VectorXi::Zero(mActiveMarkers.size());
-
   Eigen::VectorXs originalPosition = mFitter->mSkeleton->getPositions();
   std::vector<dynamics::Joint*> jointVec;
   jointVec.push_back(joint);
@@ -6847,24 +7313,29 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
 #endif
         mMarkerPositions.block<3, 1>(j * 3, i) = mMarkerObservations[i][name];
         mMarkerObserved(j, i) = 1;
-        mRadii(j)
-            += (mCenterPoints.segment<3>(i * 3) - mMarkerObservations[i][name])
-                   .norm();
-        numRadiiObservations(j)++;
       }
     }
   }
 
   mFitter->mSkeleton->setPositions(originalPosition);
 
-  for (int j = 0; j < mActiveMarkers.size(); j++)
+  Eigen::VectorXs frameWeights
+      = getFrameWeights(mNumTimesteps, mFitter->mJointFitFrameStride);
+  mMarkerWeights = mMarkerObserved.cast<s_t>()
+                   * frameWeights.asDiagonal();
+  mSmoothingWeights = Eigen::VectorXs::Ones(mNumTimesteps);
+  mSmoothingWeights(0) = 0.0;
+  for (int i = 1; i < mNumTimesteps; i++)
   {
-    if (numRadiiObservations(j) > 0)
-    {
-      mRadii(j) /= numRadiiObservations(j);
-    }
+    if (mNewClip[i])
+      mSmoothingWeights(i) = 0.0;
   }
 
+  // 3. Get a closed-form initial guess, to save SGD iterations later
+
+  fitRadiiToCenterPoints();
+  fitCenterPointsWithLeastSquares();
+
 #ifndef NDEBUG
   if (mRadii.hasNaN())
   {
@@ -6872,12 +7343,101 @@ SphereFitJointCenterProblem::SphereFitJointCenterProblem(
     std::cout << "mCenterPoints.hasNaN(): " << mCenterPoints.hasNaN()
               << std::endl;
     std::cout << "mRadii: " << mRadii << std::endl;
-    std::cout << "numRadiiObservations: " << numRadiiObservations << std::endl;
     exit(1);
   }
 #endif
 }
 
+//==============================================================================
+/// This returns the weight that each frame's marker terms get in the joint
+/// fitting problems. With a stride of N, only every Nth frame is used, and
+/// it's weighted by N so that losses are comparable across strides.
+Eigen::VectorXs SphereFitJointCenterProblem::getFrameWeights(
+    int numTimesteps, int stride)
+{
+  if (stride <= 1)
+    return Eigen::VectorXs::Ones(numTimesteps);
+  Eigen::VectorXs weights = Eigen::VectorXs::Zero(numTimesteps);
+  for (int i = 0; i < numTimesteps; i += stride)
+  {
+    weights(i) = stride;
+  }
+  return weights;
+}
+
+//==============================================================================
+/// This sets each radius to the least-squares optimum for the current center
+/// points, which has a closed form since the loss is quadratic in the squared
+/// radii
+void SphereFitJointCenterProblem::fitRadiiToCenterPoints()
+{
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
+  for (int j = 0; j < mActiveMarkers.size(); j++)
+  {
+    s_t totalWeight = mMarkerWeights.row(j).sum();
+    if (totalWeight == 0)
+      continue;
+    s_t meanSquaredDist
+        = mMarkerWeights.row(j).dot(
+              (centers - mMarkerPositions.middleRows(j * 3, 3))
+                  .colwise()
+                  .squaredNorm())
+          / totalWeight;
+    mRadii(j) = sqrt(meanSquaredDist);
+  }
+}
+
+//==============================================================================
+/// This replaces the center points from IK with a per-frame algebraic sphere
+/// fit, if that gives a lower loss. Subtracting one marker's sphere equation
+/// from the others cancels the quadratic term in the center, which leaves a
+/// small linear least-squares problem on each frame.
+void SphereFitJointCenterProblem::fitCenterPointsWithLeastSquares()
+{
+  // This keeps frames with too few markers (or with markers that are all
+  // coplanar with the center) close to where IK put them
+  const s_t regularization = 1e-4;
+
+  const Eigen::VectorXs ikRadii = mRadii;
+  const Eigen::VectorXs ikCenterPoints = mCenterPoints;
+  const s_t ikLoss = getLoss();
+
+  // This is cheap, so we fit every frame, even the ones that the frame stride
+  // leaves out of the loss
+  for (int i = 0; i < mNumTimesteps; i++)
+  {
+    Eigen::Matrix3s lhs = regularization * Eigen::Matrix3s::Identity();
+    Eigen::Vector3s rhs = regularization * ikCenterPoints.segment<3>(i * 3);
+    int ref = -1;
+    for (int j = 0; j < mActiveMarkers.size(); j++)
+    {
+      if (!mMarkerObserved(j, i))
+        continue;
+      if (ref == -1)
+      {
+        ref = j;
+        continue;
+      }
+      Eigen::Vector3s refMarker = mMarkerPositions.block<3, 1>(ref * 3, i);
+      Eigen::Vector3s marker = mMarkerPositions.block<3, 1>(j * 3, i);
+      Eigen::Vector3s row = 2 * (marker - refMarker);
+      s_t b = marker.squaredNorm() - refMarker.squaredNorm()
+              - mRadii(j) * mRadii(j) + mRadii(ref) * mRadii(ref);
+      lhs += row * row.transpose();
+      rhs += row * b;
+    }
+    mCenterPoints.segment<3>(i * 3) = lhs.ldlt().solve(rhs);
+  }
+  fitRadiiToCenterPoints();
+
+  if (!(getLoss() < ikLoss))
+  {
+    mRadii = ikRadii;
+    mCenterPoints = ikCenterPoints;
+  }
+}
+
 //==============================================================================
 /// This returns true if the given body is the parent of the joint OR if
 /// there's a hierarchy of fixed joints that connect it to the parent
@@ -7012,35 +7572,53 @@ void SphereFitJointCenterProblem::unflatten(Eigen::VectorXs x)
   mCenterPoints = x.segment(mRadii.size(), mCenterPoints.size());
 }
 
+//==============================================================================
+/// This returns the offset from each marker to the center point on each frame,
+/// as a (3 * markers) x timesteps matrix laid out like mMarkerPositions
+Eigen::MatrixXs SphereFitJointCenterProblem::getCenterOffsets()
+{
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
+  return centers.replicate(mActiveMarkers.size(), 1) - mMarkerPositions;
+}
+
+//==============================================================================
+/// This returns the residual (radius^2 - squared distance to the center) of
+/// every marker on every frame, as a markers x timesteps matrix
+Eigen::MatrixXs SphereFitJointCenterProblem::getSphereResiduals(
+    const Eigen::MatrixXs& centerOffsets)
+{
+  const int numMarkers = mActiveMarkers.size();
+  // Column-major storage means the 3-vector for marker j on frame t is column
+  // (t * numMarkers + j) of this view, so the squared norms come out in the
+  // same order as a markers x timesteps matrix
+  Eigen::Map<const Eigen::MatrixXs> offsets(
+      centerOffsets.data(), 3, numMarkers * mNumTimesteps);
+  Eigen::VectorXs squaredDists = offsets.colwise().squaredNorm().transpose();
+  return mRadii.cwiseProduct(mRadii).replicate(1, mNumTimesteps)
+         - Eigen::Map<const Eigen::MatrixXs>(
+             squaredDists.data(), numMarkers, mNumTimesteps);
+}
+
 //==============================================================================
 s_t SphereFitJointCenterProblem::getLoss()
 {
-  s_t loss = 0.0;
+  if (mNumTimesteps == 0 || mCenterPoints.size() == 0)
+    return 0.0;
 
-  for (int i = 0; i < mNumTimesteps; i++)
-  {
-    if (i > 0)
-    {
-      if (!mNewClip[i])
-      {
-        loss += mSmoothingLoss
-                * (mCenterPoints.segment<3>(i * 3)
-                   - mCenterPoints.segment<3>((i - 1) * 3))
-                      .squaredNorm();
-      }
-    }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        s_t diff = mRadii(j) * mRadii(j)
-                   - (mCenterPoints.segment<3>(i * 3)
-                      - mMarkerPositions.block<3, 1>(j * 3, i))
-                         .squaredNorm();
-        loss += diff * diff;
-      }
-    }
-  }
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
+  const int n = mNumTimesteps - 1;
+
+  s_t loss = mSmoothingLoss
+             * mSmoothingWeights.tail(n).dot(
+                 (centers.rightCols(n) - centers.leftCols(n))
+                     .colwise()
+                     .squaredNorm()
+                     .transpose());
+
+  Eigen::MatrixXs residuals = getSphereResiduals(getCenterOffsets());
+  loss += (mMarkerWeights.array() * residuals.array().square()).sum();
 
   return loss;
 }
@@ -7050,42 +7628,137 @@ Eigen::VectorXs SphereFitJointCenterProblem::getGradient()
 {
   Eigen::VectorXs grad
       = Eigen::VectorXs::Zero(mRadii.size() + mCenterPoints.size());
+  if (mNumTimesteps == 0 || mCenterPoints.size() == 0)
+    return grad;
+
+  const int numMarkers = mActiveMarkers.size();
+  Eigen::Map<const Eigen::MatrixXs> centers(
+      mCenterPoints.data(), 3, mNumTimesteps);
+  Eigen::Map<Eigen::MatrixXs> centersGrad(
+      grad.data() + mRadii.size(), 3, mNumTimesteps);
+  const int n = mNumTimesteps - 1;
+
+  Eigen::MatrixXs smoothingGrad
+      = (centers.rightCols(n) - centers.leftCols(n))
+        * (2 * mSmoothingLoss * mSmoothingWeights.tail(n)).asDiagonal();
+  centersGrad.rightCols(n) += smoothingGrad;
+  centersGrad.leftCols(n) -= smoothingGrad;
+
+  Eigen::MatrixXs centerOffsets = getCenterOffsets();
+  Eigen::MatrixXs weightedResiduals
+      = mMarkerWeights.cwiseProduct(getSphereResiduals(centerOffsets));
+  grad.head(numMarkers)
+      += 4 * mRadii.cwiseProduct(weightedResiduals.rowwise().sum());
+
+  // Scale each marker's offset by its weighted residual, then sum the markers
+  // on each frame by multiplying by a row of 3x3 identities
+  Eigen::Map<const Eigen::MatrixXs> offsets(
+      centerOffsets.data(), 3, numMarkers * mNumTimesteps);
+  Eigen::MatrixXs scaledOffsets
+      = offsets
+        * Eigen::Map<const Eigen::VectorXs>(
+              weightedResiduals.data(), numMarkers * mNumTimesteps)
+              .asDiagonal();
+  centersGrad -= 4 * Eigen::MatrixXs::Identity(3, 3).replicate(1, numMarkers)
+                 * Eigen::Map<const Eigen::MatrixXs>(
+                     scaledOffsets.data(), 3 * numMarkers, mNumTimesteps);
 
-  for (int i = 0; i < mNumTimesteps; i++)
-  {
-    if (i > 0)
-    {
-      if (!mNewClip[i])
+  return grad;
+}
+
+//==============================================================================
+/// The loss is a sum of squared residuals, so this returns the Gauss-Newton
+/// step from the current state (to be added to flatten()), damped by adding
+/// `damping` times the identity to the Gauss-Newton approximation of the
+/// Hessian. This is the Levenberg-Marquardt step, which becomes a short
+/// gradient descent step as `damping` grows.
+Eigen::VectorXs SphereFitJointCenterProblem::getGaussNewtonStep(s_t damping)
+{
+  const int numMarkers = mActiveMarkers.size();
+  const int dim = getProblemDim();
+  if (mNumTimesteps == 0 || mCenterPoints.size() == 0)
+    return Eigen::VectorXs::Zero(dim);
+
+  // Each marker residual w * (r_j^2 - |c_t - m_jt|^2)^2 only touches r_j and
+  // c_t, and each smoothing residual only touches c_t and c_{t-1}, so J^T J
+  // is a band of 3x3 blocks over the centers, plus dense rows and columns for
+  // the (few) radii. We put the centers first and the radii last, so the
+  // factorization doesn't fill in the band.
+  const int radiiStart = 3 * mNumTimesteps;
+  Eigen::MatrixXs centerOffsets = getCenterOffsets();
+  Eigen::MatrixXs residuals = getSphereResiduals(centerOffsets);
+
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  triplets.reserve(
+      mNumTimesteps * (9 + 9 + 6 * numMarkers) + numMarkers + radiiStart);
+  Eigen::VectorXs rhs = Eigen::VectorXs::Zero(dim);
+  for (int t = 0; t < mNumTimesteps; t++)
+  {
+    const int c = t * 3;
+    Eigen::Matrix3s centerBlock = Eigen::Matrix3s::Zero();
+    for (int j = 0; j < numMarkers; j++)
+    {
+      s_t w = mMarkerWeights(j, t);
+      if (w == 0)
+        continue;
+      Eigen::Vector3s offset = centerOffsets.block<3, 1>(j * 3, t);
+      // d(residual)/dc_t = -2 * offset, and d(residual)/dr_j = 2 * r_j
+      centerBlock += 4 * w * offset * offset.transpose();
+      for (int k = 0; k < 3; k++)
+      {
+        s_t coupling = -4 * w * mRadii(j) * offset(k);
+        triplets.emplace_back(radiiStart + j, c + k, coupling);
+        triplets.emplace_back(c + k, radiiStart + j, coupling);
+      }
+      triplets.emplace_back(
+          radiiStart + j, radiiStart + j, 4 * w * mRadii(j) * mRadii(j));
+      rhs(radiiStart + j) -= w * residuals(j, t) * 2 * mRadii(j);
+      rhs.segment<3>(c) += w * residuals(j, t) * 2 * offset;
+    }
+    if (t > 0 && mSmoothingWeights(t) != 0)
+    {
+      s_t s = mSmoothingLoss * mSmoothingWeights(t);
+      Eigen::Vector3s diff
+          = mCenterPoints.segment<3>(c) - mCenterPoints.segment<3>(c - 3);
+      centerBlock += s * Eigen::Matrix3s::Identity();
+      for (int k = 0; k < 3; k++)
       {
-        grad.segment<3>(mRadii.size() + i * 3)
-            += 2 * mSmoothingLoss
-               * (mCenterPoints.segment<3>(i * 3)
-                  - mCenterPoints.segment<3>((i - 1) * 3));
-        grad.segment<3>(mRadii.size() + (i - 1) * 3)
-            -= 2 * mSmoothingLoss
-               * (mCenterPoints.segment<3>(i * 3)
-                  - mCenterPoints.segment<3>((i - 1) * 3));
+        triplets.emplace_back(
+            c - 3 + k, c - 3 + k, s);
+        triplets.emplace_back(
+            c + k, c - 3 + k, -s);
+        triplets.emplace_back(
+            c - 3 + k, c + k, -s);
       }
+      rhs.segment<3>(c) -= s * diff;
+      rhs.segment<3>(c - 3) += s * diff;
     }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
+    for (int a = 0; a < 3; a++)
     {
-      if (mMarkerObserved(j, i))
+      for (int b = 0; b < 3; b++)
       {
-        s_t diff = mRadii(j) * mRadii(j)
-                   - (mCenterPoints.segment<3>(i * 3)
-                      - mMarkerPositions.block<3, 1>(j * 3, i))
-                         .squaredNorm();
-        grad(j) += (2 * diff) * (2 * mRadii(j));
-        grad.segment<3>(mRadii.size() + i * 3)
-            += (2 * diff)
-               * (-2
-                  * (mCenterPoints.segment<3>(i * 3)
-                     - mMarkerPositions.block<3, 1>(j * 3, i)));
+        triplets.emplace_back(
+            c + a, c + b, centerBlock(a, b));
       }
     }
   }
+  for (int i = 0; i < dim; i++)
+  {
+    triplets.emplace_back(i, i, damping);
+  }
 
-  return grad;
+  Eigen::SparseMatrix<s_t> normal(dim, dim);
+  normal.setFromTriplets(triplets.begin(), triplets.end());
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<s_t>> solver(normal);
+  Eigen::VectorXs step = solver.solve(rhs);
+  if (solver.info() != Eigen::Success || step.hasNaN())
+    return Eigen::VectorXs::Zero(dim);
+
+  // Put the step back into flatten() order, with the radii first
+  Eigen::VectorXs flatStep = Eigen::VectorXs::Zero(dim);
+  flatStep.head(numMarkers) = step.segment(radiiStart, numMarkers);
+  flatStep.tail(3 * mNumTimesteps) = step.head(radiiStart);
+  return flatStep;
 }
 
 //==============================================================================
@@ -7258,14 +7931,17 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
         mMarkerObserved(j, i) = 1;
         Eigen::Vector3s diff
             = mAxisLines.segment<3>(i * 6) - mMarkerObservations[i][name];
-        // The radius is our distance to the cylinder at the nearest point
-        mPerpendicularRadii(j) += (diff
-                                   - (diff.dot(mAxisLines.segment<3>(i * 6 + 3))
-                                      * mAxisLines.segment<3>(i * 6 + 3)))
-                                      .norm();
+        // The radius is our distance to the cylinder at the nearest point.
+        // We average the squared distances, because the squared radius that
+        // minimizes the loss for these axis lines is their mean.
+        mPerpendicularRadii(j)
+            += (diff
+                - (diff.dot(mAxisLines.segment<3>(i * 6 + 3))
+                   * mAxisLines.segment<3>(i * 6 + 3)))
+                   .squaredNorm();
         mParallelRadii(j) += (diff.dot(mAxisLines.segment<3>(i * 6 + 3))
                               * mAxisLines.segment<3>(i * 6 + 3))
-                                 .norm();
+                                 .squaredNorm();
         numRadiiObservations(j)++;
       }
     }
@@ -7277,10 +7953,23 @@ CylinderFitJointAxisProblem::CylinderFitJointAxisProblem(
   {
     if (numRadiiObservations(j) > 0)
     {
-      mPerpendicularRadii(j) /= numRadiiObservations(j);
-      mParallelRadii(j) /= numRadiiObservations(j);
+      mPerpendicularRadii(j)
+          = sqrt(mPerpendicularRadii(j) / numRadiiObservations(j));
+      mParallelRadii(j) = sqrt(mParallelRadii(j) / numRadiiObservations(j));
     }
   }
+
+  Eigen::VectorXs frameWeights = SphereFitJointCenterProblem::getFrameWeights(
+      mNumTimesteps, mFitter->mJointFitFrameStride);
+  mMarkerWeights = mMarkerObserved.cast<s_t>()
+                   * frameWeights.asDiagonal();
+  mSmoothingWeights = Eigen::VectorXs::Ones(mNumTimesteps);
+  mSmoothingWeights(0) = 0.0;
+  for (int i = 1; i < mNumTimesteps; i++)
+  {
+    if (mNewClip[i])
+      mSmoothingWeights(i) = 0.0;
+  }
 }
 
 //==============================================================================
@@ -7320,78 +8009,49 @@ void CylinderFitJointAxisProblem::unflatten(Eigen::VectorXs x)
 //==============================================================================
 s_t CylinderFitJointAxisProblem::getLoss()
 {
-  s_t loss = 0.0;
+  if (mNumTimesteps == 0 || mAxisLines.size() == 0)
+    return 0.0;
+
+  Eigen::Map<const Eigen::MatrixXs> lines(mAxisLines.data(), 6, mNumTimesteps);
+  auto centers = lines.topRows<3>();
+  auto axis = lines.bottomRows<3>();
+  const int n = mNumTimesteps - 1;
+
+  s_t loss = mKeepCenterLoss
+             * (centers.rightCols(n) - mJointCenters.rightCols(n))
+                   .squaredNorm();
+  loss += mSmoothingCenterLoss
+          * mSmoothingWeights.tail(n).dot(
+              (centers.rightCols(n) - centers.leftCols(n))
+                  .colwise()
+                  .squaredNorm()
+                  .transpose());
+  loss += mSmoothingAxisLoss
+          * mSmoothingWeights.tail(n).dot(
+              (axis.rightCols(n) - axis.leftCols(n))
+                  .colwise()
+                  .squaredNorm()
+                  .transpose());
 
-  for (int i = 0; i < mNumTimesteps; i++)
+  for (int j = 0; j < mActiveMarkers.size(); j++)
   {
-    if (i > 0)
-    {
-      loss += mKeepCenterLoss
-              * (mAxisLines.segment<3>(i * 6) - mJointCenters.col(i))
-                    .squaredNorm();
-      if (!mNewClip[i])
-      {
-        loss += mSmoothingCenterLoss
-                * (mAxisLines.segment<3>(i * 6)
-                   - mAxisLines.segment<3>((i - 1) * 6))
-                      .squaredNorm();
-        loss += mSmoothingAxisLoss
-                * (mAxisLines.segment<3>(i * 6 + 3)
-                   - mAxisLines.segment<3>((i - 1) * 6 + 3))
-                      .squaredNorm();
-      }
-    }
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        Eigen::Vector3s center = mAxisLines.segment<3>(i * 6);
-        Eigen::Vector3s axis = mAxisLines.segment<3>(i * 6 + 3);
-        Eigen::Vector3s jointToCenter
-            = (center - mMarkerPositions.block<3, 1>(j * 3, i));
-        s_t diff = mPerpendicularRadii(j) * mPerpendicularRadii(j)
-                   - (jointToCenter - (jointToCenter.dot(axis) * axis))
-                         .squaredNorm();
-        (void)diff;
-        loss += diff * diff;
-        s_t parallelDiff = mParallelRadii(j) * mParallelRadii(j)
-                           - (jointToCenter.dot(axis) * axis).squaredNorm();
-        (void)parallelDiff;
-        loss += parallelDiff * parallelDiff;
-
-        /*
-        s_t dist = (jointToCenter.dot(axis) * axis).squaredNorm();
-        s_t dist2 = (axis * axis.transpose() * jointToCenter).squaredNorm();
-        s_t dist3 = (jointToCenter.transpose() * axis * axis.transpose())
-                    * (axis * axis.transpose() * jointToCenter);
-        s_t dist4 = jointToCenter.transpose()
-                    * ((axis * axis.transpose()) * (axis * axis.transpose()))
-                    * jointToCenter;
-        s_t dist5 = axis.dot(axis) * jointToCenter.dot(axis)
-                    * jointToCenter.dot(axis);
-        if (abs(dist - dist2) > 1e-14)
-        {
-          std::cout << "Dist1 != dist2: " << dist << ", " << dist2 << std::endl;
-        }
-        if (abs(dist - dist3) > 1e-14)
-        {
-          std::cout << "Dist != dist3: " << dist << ", " << dist3 << std::endl;
-        }
-        if (abs(dist - dist4) > 1e-14)
-        {
-          std::cout << "Dist != dist4: " << dist << ", " << dist4 << std::endl;
-        }
-        if (abs(dist - dist5) > 1e-14)
-        {
-          std::cout << "Dist != dist5: " << dist << ", " << dist5 << std::endl;
-        }
-        // loss += dist * dist;
-
-        // loss += dist4 * dist4;
-        // loss += -2 * jointToCenter.dot(axis) * jointToCenter.dot(axis);
-        */
-      }
-    }
+    Eigen::MatrixXs jointToCenter
+        = centers - mMarkerPositions.middleRows(j * 3, 3);
+    Eigen::VectorXs dots
+        = jointToCenter.cwiseProduct(axis).colwise().sum().transpose();
+    Eigen::MatrixXs alongAxis = axis * dots.asDiagonal();
+    Eigen::VectorXs diff
+        = (mPerpendicularRadii(j) * mPerpendicularRadii(j)
+           - (jointToCenter - alongAxis).colwise().squaredNorm().array())
+              .transpose()
+              .matrix();
+    Eigen::VectorXs parallelDiff
+        = (mParallelRadii(j) * mParallelRadii(j)
+           - alongAxis.colwise().squaredNorm().array())
+              .transpose()
+              .matrix();
+    loss += mMarkerWeights.row(j).dot(
+        diff.cwiseProduct(diff) + parallelDiff.cwiseProduct(parallelDiff));
   }
 
   return loss;
@@ -7402,100 +8062,89 @@ Eigen::VectorXs CylinderFitJointAxisProblem::getGradient()
 {
   Eigen::VectorXs grad = Eigen::VectorXs::Zero(
       mPerpendicularRadii.size() + mParallelRadii.size() + mAxisLines.size());
-
-  int offset = mPerpendicularRadii.size() + mParallelRadii.size();
-  for (int i = 0; i < mNumTimesteps; i++)
+  if (mNumTimesteps == 0 || mAxisLines.size() == 0)
+    return grad;
+
+  const int offset = mPerpendicularRadii.size() + mParallelRadii.size();
+  Eigen::Map<const Eigen::MatrixXs> lines(mAxisLines.data(), 6, mNumTimesteps);
+  auto centers = lines.topRows<3>();
+  auto axis = lines.bottomRows<3>();
+  Eigen::Map<Eigen::MatrixXs> linesGrad(
+      grad.data() + offset, 6, mNumTimesteps);
+  auto centersGrad = linesGrad.topRows<3>();
+  auto axisGrad = linesGrad.bottomRows<3>();
+  const int n = mNumTimesteps - 1;
+
+  centersGrad.rightCols(n)
+      += 2 * mKeepCenterLoss
+         * (centers.rightCols(n) - mJointCenters.rightCols(n));
+
+  Eigen::MatrixXs smoothingGrad
+      = (centers.rightCols(n) - centers.leftCols(n))
+        * (2 * mSmoothingCenterLoss * mSmoothingWeights.tail(n)).asDiagonal();
+  centersGrad.rightCols(n) += smoothingGrad;
+  centersGrad.leftCols(n) -= smoothingGrad;
+  smoothingGrad
+      = (axis.rightCols(n) - axis.leftCols(n))
+        * (2 * mSmoothingAxisLoss * mSmoothingWeights.tail(n)).asDiagonal();
+  axisGrad.rightCols(n) += smoothingGrad;
+  axisGrad.leftCols(n) -= smoothingGrad;
+
+  const Eigen::VectorXs axisDotAxis
+      = axis.colwise().squaredNorm().transpose();
+  for (int j = 0; j < mActiveMarkers.size(); j++)
   {
-    if (i > 0)
-    {
-      grad.segment<3>(offset + i * 6)
-          += 2 * mKeepCenterLoss
-             * (mAxisLines.segment<3>(i * 6) - mJointCenters.col(i));
-
-      if (!mNewClip[i])
-      {
-        grad.segment<3>(offset + i * 6)
-            += 2 * mSmoothingCenterLoss
-               * (mAxisLines.segment<3>(i * 6)
-                  - mAxisLines.segment<3>((i - 1) * 6));
-        grad.segment<3>(offset + (i - 1) * 6)
-            -= 2 * mSmoothingCenterLoss
-               * (mAxisLines.segment<3>(i * 6)
-                  - mAxisLines.segment<3>((i - 1) * 6));
-        grad.segment<3>(offset + i * 6 + 3)
-            += 2 * mSmoothingAxisLoss
-               * (mAxisLines.segment<3>(i * 6 + 3)
-                  - mAxisLines.segment<3>((i - 1) * 6 + 3));
-        grad.segment<3>(offset + (i - 1) * 6 + 3)
-            -= 2 * mSmoothingAxisLoss
-               * (mAxisLines.segment<3>(i * 6 + 3)
-                  - mAxisLines.segment<3>((i - 1) * 6 + 3));
-      }
-    }
-
-    const Eigen::Vector3s center = mAxisLines.segment<3>(i * 6);
-    const Eigen::Vector3s axis = mAxisLines.segment<3>(i * 6 + 3);
-    const s_t axisDotAxis = axis.dot(axis);
-    for (int j = 0; j < mActiveMarkers.size(); j++)
-    {
-      if (mMarkerObserved(j, i))
-      {
-        const Eigen::Vector3s jointToCenter
-            = (center - mMarkerPositions.block<3, 1>(j * 3, i));
-        const s_t jointToCenterDotAxis = jointToCenter.dot(axis);
-        const Eigen::Vector3s jointToCenterAlongAxis
-            = jointToCenterDotAxis * axis;
-        const s_t diff
-            = mPerpendicularRadii(j) * mPerpendicularRadii(j)
-              - (jointToCenter - (jointToCenterAlongAxis)).squaredNorm();
-        const s_t parallelDiff = mParallelRadii(j) * mParallelRadii(j)
-                                 - (jointToCenterAlongAxis).squaredNorm();
-        // Gradient wrt perpendicular radii
-        grad(j) += (2 * diff) * (2 * mPerpendicularRadii(j));
-        // Gradient wrt parallel radii
-        grad(mParallelRadii.size() + j)
-            += (2 * parallelDiff) * (2 * mParallelRadii(j));
-
-        // Gradient wrt the axis center of perpendicular term
-        grad.segment<3>(offset + i * 6)
-            += (2 * diff) * -2
-               * (jointToCenter - axisDotAxis * jointToCenterAlongAxis);
-        // Gradient wrt the axis of perpendicular term
-        grad.segment<3>(offset + i * 6 + 3)
-            += 2 * diff * -1
-               * ((-4 + 2 * axisDotAxis) * jointToCenterDotAxis * jointToCenter
-                  + 2 * jointToCenterDotAxis * jointToCenterDotAxis * axis);
-        // Gradient wrt the axis center of parallel term
-        grad.segment<3>(offset + i * 6)
-            += -2 * parallelDiff * 2 * (axisDotAxis * jointToCenterAlongAxis);
-        // Gradient wrt the axis of parallel term
-        grad.segment<3>(offset + i * 6 + 3)
-            += -2 * parallelDiff
-               * (2 * jointToCenterAlongAxis * jointToCenterDotAxis
-                  + axisDotAxis * 2 * jointToCenterDotAxis * jointToCenter);
-      }
-    }
-
-    // Keep only the portion of the gradient wrt the normal vector that's
-    // perpendicular to the current normal
-    // Operate on the last timestep gradient, since that's now complete
-    if (i > 0)
-    {
-      Eigen::Vector3s axisDir
-          = mAxisLines.segment<3>((i - 1) * 6 + 3).normalized();
-      s_t dot = grad.segment<3>(offset + (i - 1) * 6 + 3).dot(axisDir);
-      grad.segment<3>(offset + (i - 1) * 6 + 3) -= axisDir * dot;
-    }
+    const Eigen::MatrixXs jointToCenter
+        = centers - mMarkerPositions.middleRows(j * 3, 3);
+    const Eigen::VectorXs dots
+        = jointToCenter.cwiseProduct(axis).colwise().sum().transpose();
+    const Eigen::MatrixXs alongAxis = axis * dots.asDiagonal();
+    const Eigen::VectorXs weights = mMarkerWeights.row(j).transpose();
+    const Eigen::VectorXs diff = weights.cwiseProduct(
+        (mPerpendicularRadii(j) * mPerpendicularRadii(j)
+         - (jointToCenter - alongAxis).colwise().squaredNorm().array())
+            .transpose()
+            .matrix());
+    const Eigen::VectorXs parallelDiff = weights.cwiseProduct(
+        (mParallelRadii(j) * mParallelRadii(j)
+         - alongAxis.colwise().squaredNorm().array())
+            .transpose()
+            .matrix());
+
+    // Gradient wrt the perpendicular and parallel radii
+    grad(j) += 4 * mPerpendicularRadii(j) * diff.sum();
+    grad(mParallelRadii.size() + j)
+        += 4 * mParallelRadii(j) * parallelDiff.sum();
+
+    // Gradient wrt the axis center, of the perpendicular and parallel terms
+    centersGrad
+        -= 4
+           * (jointToCenter * diff.asDiagonal()
+              - alongAxis
+                    * diff.cwiseProduct(axisDotAxis).asDiagonal()
+              + alongAxis
+                    * parallelDiff.cwiseProduct(axisDotAxis).asDiagonal());
+    // Gradient wrt the axis, of the perpendicular and parallel terms
+    axisGrad
+        -= jointToCenter
+               * (2 * diff.cwiseProduct(dots).cwiseProduct(
+                      ((2 * axisDotAxis).array() - 4).matrix())
+                  + 4 * parallelDiff.cwiseProduct(dots).cwiseProduct(
+                      axisDotAxis))
+                     .asDiagonal()
+           + axis
+                 * (4 * diff.cwiseProduct(dots).cwiseProduct(dots)
+                    + 4 * parallelDiff.cwiseProduct(dots).cwiseProduct(dots))
+                       .asDiagonal();
   }
 
   // Keep only the portion of the gradient wrt the normal vector that's
   // perpendicular to the current normal
-  // Patch the last timestep gradient, since that never gets patched in the
-  // normal loop
-  Eigen::Vector3s axisDir
-      = mAxisLines.segment<3>((mNumTimesteps - 1) * 6 + 3).normalized();
-  s_t dot = grad.segment<3>(offset + (mNumTimesteps - 1) * 6 + 3).dot(axisDir);
-  grad.segment<3>(offset + (mNumTimesteps - 1) * 6 + 3) -= axisDir * dot;
+  for (int i = 0; i < mNumTimesteps; i++)
+  {
+    Eigen::Vector3s axisDir = axis.col(i).normalized();
+    axisGrad.col(i) -= axisDir * axisGrad.col(i).dot(axisDir);
+  }
 
   return grad;
 }
@@ -7553,7 +8202,7 @@ BilevelFitProblem::BilevelFitProblem(
     const std::vector<std::map<std::string, Eigen::Vector3s>>&
         markerObservations,
     MarkerInitialization& initialization,
-    int numSamples,
+    const std::vector<int>& sampleIndices,
     bool applyInnerProblemGradientConstraints,
     std::shared_ptr<BilevelFitResult>& outResult)
   : mFitter(fitter),
@@ -7562,44 +8211,8 @@ BilevelFitProblem::BilevelFitProblem(
     mApplyInnerProblemGradientConstraints(applyInnerProblemGradientConstraints),
     mBestObjectiveValue(std::numeric_limits<s_t>::infinity())
 {
-  // 1. Select the random indices we'll be using for this problem
-  mSampleIndices
-      = math::evenlySpacedTimesteps(markerObservations.size(), numSamples);
-
-  // if (numSamples >= markerObservations.size())
-  // {
-  //   numSamples = markerObservations.size();
-  //   for (int i = 0; i < numSamples; i++)
-  //   {
-  //     mSampleIndices.push_back(i);
-  //   }
-  // }
-  // else
-  // {
-  //   double stride = (double)markerObservations.size() / numSamples;
-
-  //   for (int i = 0; i < numSamples; i++)
-  //   {
-  //     int index = (int)round(stride * ((double)i + 0.5));
-  //     if (index > markerObservations.size() - 1)
-  //       index = markerObservations.size() - 1;
-  //     if (index < 0)
-  //       index = 0;
-
-  //     mSampleIndices.push_back(index);
-  //   }
-  // }
-
-  // TODO: <remove>
-  std::cout << "Picked " << numSamples << " evenly spaced in [0,"
-            << markerObservations.size() << "]: " << std::endl
-            << "[";
-  for (int i : mSampleIndices)
-  {
-    std::cout << i << ",";
-  }
-  std::cout << "]" << std::endl;
-  // TODO: </remove>
+  // 1. Take the indices we'll be using for this problem
+  mSampleIndices = sampleIndices;
 
   mJointCenters = Eigen::MatrixXs::Zero(
       initialization.jointCenters.rows(), mSampleIndices.size());
@@ -7669,6 +8282,9 @@ BilevelFitProblem::BilevelFitProblem(
     mPerThreadCursor.push_back(cursorIndices);
   }
   assert(cursor == mSampleIndices.size());
+
+  // 6. Work out which entries of the constraint Jacobian can be non-zero
+  computeConstraintsJacobianSparsity();
 }
 
 //==============================================================================
@@ -7826,7 +8442,7 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
     bool multiThreaded = true;
     if (multiThreaded)
     {
-      std::vector<std::future<Eigen::VectorXs>> futures;
+      std::vector<common::TaskFuture<Eigen::VectorXs>> futures;
       for (int k = 0; k < mNumThreads; k++)
       {
         std::vector<int> threadCursors = mPerThreadCursor[k];
@@ -7843,7 +8459,7 @@ Eigen::VectorXs BilevelFitProblem::getConstraints(Eigen::VectorXs x)
         }
 
         futures.push_back(
-            std::async([&, threadCursors, threadSkeleton, threadMarkers]() {
+            common::async([&, threadCursors, threadSkeleton, threadMarkers]() {
               Eigen::VectorXs ikGradLocal
                   = Eigen::VectorXs::Zero(threadSkeleton->getNumDofs());
 
@@ -7951,7 +8567,7 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
     bool multiThreaded = true;
     if (multiThreaded)
     {
-      std::vector<std::future<Eigen::MatrixXs>> futures;
+      std::vector<common::TaskFuture<Eigen::MatrixXs>> futures;
       for (int k = 0; k < mNumThreads; k++)
       {
         std::vector<int> threadCursors = mPerThreadCursor[k];
@@ -7967,10 +8583,10 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
               threadSkeleton->getBodyNode(pair.first->getName()), pair.second);
         }
 
-        futures.push_back(std::async([&,
-                                      threadCursors,
-                                      threadSkeleton,
-                                      threadMarkers]() {
+        futures.push_back(common::async([&,
+                                         threadCursors,
+                                         threadSkeleton,
+                                         threadMarkers]() {
           Eigen::MatrixXs markersAndScalesLocalJac = Eigen::MatrixXs::Zero(
               threadSkeleton->getNumDofs(), scaleGroupDims + markerOffsetDims);
 
@@ -8100,6 +8716,276 @@ Eigen::MatrixXs BilevelFitProblem::getConstraintsJacobian(Eigen::VectorXs x)
   }
 }
 
+//==============================================================================
+/// This evaluates the Jacobian of our constraint vector wrt x, exactly like
+/// getConstraintsJacobian(), but only computes and stores the entries that
+/// can be non-zero (see getConstraintsJacobianSparsity()).
+Eigen::SparseMatrix<s_t> BilevelFitProblem::getSparseConstraintsJacobian(
+    Eigen::VectorXs x)
+{
+  Eigen::VectorXs values = getConstraintsJacobianValues(x);
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  triplets.reserve(mConstraintsJacobianSparsity.size());
+  for (int i = 0; i < mConstraintsJacobianSparsity.size(); i++)
+  {
+    triplets.emplace_back(
+        mConstraintsJacobianSparsity[i].first,
+        mConstraintsJacobianSparsity[i].second,
+        values(i));
+  }
+  Eigen::SparseMatrix<s_t> jac(
+      mFitter->mSkeleton->getNumDofs() + mFitter->mZeroConstraints.size(),
+      x.size());
+  jac.setFromTriplets(triplets.begin(), triplets.end());
+  return jac;
+}
+
+//==============================================================================
+/// This returns the (row, col) of every entry of the constraint Jacobian
+/// that can be non-zero.
+const std::vector<std::pair<int, int>>&
+BilevelFitProblem::getConstraintsJacobianSparsity()
+{
+  return mConstraintsJacobianSparsity;
+}
+
+//==============================================================================
+/// This fills in mConstraintsJacobianSparsity. The inner problem gradient wrt
+/// DOF r is a sum over the markers below r. Each of those terms only changes
+/// with the DOFs and marker offsets that move that marker, so entry (r, c) of
+/// a pose block can only be non-zero if some marker is moved by both r and c.
+void BilevelFitProblem::computeConstraintsJacobianSparsity()
+{
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int scaleGroupDims = mFitter->mSkeleton->getGroupScaleDim();
+  int markerOffsetDims = mFitter->mMarkers.size() * 3;
+  int problemDim = getProblemSize();
+
+  std::vector<std::vector<bool>> related(
+      dofs, std::vector<bool>(dofs, false));
+  mMarkerOffsetJacobianSparsity.clear();
+  mMarkerOffsetJacobianSparsity.resize(dofs);
+  for (int m = 0; m < mFitter->mMarkers.size(); m++)
+  {
+    const std::vector<std::size_t>& chain
+        = mFitter->mMarkers[m].first->getDependentGenCoordIndices();
+    for (std::size_t r : chain)
+    {
+      mMarkerOffsetJacobianSparsity[r].push_back(m);
+      for (std::size_t c : chain)
+      {
+        related[r][c] = true;
+      }
+    }
+  }
+
+  mPoseJacobianSparsity.clear();
+  mPoseJacobianSparsity.resize(dofs);
+  for (int r = 0; r < dofs; r++)
+  {
+    for (int c = 0; c < dofs; c++)
+    {
+      if (related[r][c])
+      {
+        mPoseJacobianSparsity[r].push_back(c);
+      }
+    }
+  }
+
+  mConstraintsJacobianSparsity.clear();
+  if (mApplyInnerProblemGradientConstraints)
+  {
+    // The scales and marker offsets are shared by every pose, so they come
+    // first, summed over all the poses
+    for (int r = 0; r < dofs; r++)
+    {
+      for (int c = 0; c < scaleGroupDims; c++)
+      {
+        mConstraintsJacobianSparsity.emplace_back(r, c);
+      }
+      for (int m : mMarkerOffsetJacobianSparsity[r])
+      {
+        for (int axis = 0; axis < 3; axis++)
+        {
+          mConstraintsJacobianSparsity.emplace_back(
+              r, scaleGroupDims + m * 3 + axis);
+        }
+      }
+    }
+    // Then each pose gets its own block
+    for (int i = 0; i < mMarkerObservations.size(); i++)
+    {
+      int offset = scaleGroupDims + markerOffsetDims + i * dofs;
+      for (int r = 0; r < dofs; r++)
+      {
+        for (int c : mPoseJacobianSparsity[r])
+        {
+          mConstraintsJacobianSparsity.emplace_back(r, offset + c);
+        }
+      }
+    }
+  }
+  // We don't know anything about the structure of the zero constraints
+  for (int k = 0; k < mFitter->mZeroConstraints.size(); k++)
+  {
+    for (int c = 0; c < problemDim; c++)
+    {
+      mConstraintsJacobianSparsity.emplace_back(dofs + k, c);
+    }
+  }
+}
+
+//==============================================================================
+/// This computes the values of the constraint Jacobian at `x`, in the same
+/// order as getConstraintsJacobianSparsity()
+Eigen::VectorXs BilevelFitProblem::getConstraintsJacobianValues(
+    Eigen::VectorXs x)
+{
+  Eigen::VectorXs values
+      = Eigen::VectorXs::Zero(mConstraintsJacobianSparsity.size());
+
+  int dofs = mFitter->mSkeleton->getNumDofs();
+  int scaleGroupDims = mFitter->mSkeleton->getGroupScaleDim();
+  int markerOffsetDims = mFitter->mMarkers.size() * 3;
+  Eigen::VectorXs groupScales = x.segment(0, scaleGroupDims);
+  Eigen::VectorXs markerOffsets = x.segment(scaleGroupDims, markerOffsetDims);
+  Eigen::VectorXs firstPose
+      = x.segment(scaleGroupDims + markerOffsetDims, dofs);
+
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers
+      = mFitter->setConfiguration(
+          mFitter->mSkeleton, firstPose, groupScales, markerOffsets);
+
+  int cursor = 0;
+  if (mApplyInnerProblemGradientConstraints)
+  {
+    int sharedEntries = 0;
+    int poseBlockEntries = 0;
+    for (int r = 0; r < dofs; r++)
+    {
+      sharedEntries
+          += scaleGroupDims + mMarkerOffsetJacobianSparsity[r].size() * 3;
+      poseBlockEntries += mPoseJacobianSparsity[r].size();
+    }
+
+    std::vector<common::TaskFuture<Eigen::MatrixXs>> futures;
+    for (int k = 0; k < mNumThreads; k++)
+    {
+      std::vector<int> threadCursors = mPerThreadCursor[k];
+      std::shared_ptr<dynamics::Skeleton> threadSkeleton
+          = mPerThreadSkeletons[k];
+      threadSkeleton->setGroupScales(mFitter->mSkeleton->getGroupScales());
+
+      std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
+          threadMarkers;
+      for (auto pair : markers)
+      {
+        threadMarkers.emplace_back(
+            threadSkeleton->getBodyNode(pair.first->getName()), pair.second);
+      }
+
+      futures.push_back(common::async([&,
+                                       threadCursors,
+                                       threadSkeleton,
+                                       threadMarkers]() {
+        Eigen::MatrixXs markersAndScalesLocalJac = Eigen::MatrixXs::Zero(
+            dofs, scaleGroupDims + markerOffsetDims);
+
+        for (int i : threadCursors)
+        {
+          int offset = scaleGroupDims + markerOffsetDims + i * dofs;
+          threadSkeleton->setPositions(x.segment(offset, dofs));
+
+          Eigen::VectorXs markerError = mFitter->getMarkerError(
+              threadSkeleton, threadMarkers, mMarkerObservations[i]);
+          std::vector<int> sparsityMap = mFitter->getSparsityMap(
+              threadMarkers, mMarkerObservations[i]);
+
+          // Each pose writes its own disjoint range of the values
+          Eigen::MatrixXs poseJac
+              = mFitter->getIKLossGradientWrtJointsJacobianWrtJoints(
+                    threadSkeleton, threadMarkers, markerError, sparsityMap)
+                * mObservationWeights(i);
+          int valueCursor = sharedEntries + i * poseBlockEntries;
+          for (int r = 0; r < dofs; r++)
+          {
+            for (int c : mPoseJacobianSparsity[r])
+            {
+              values(valueCursor) = poseJac(r, c);
+              valueCursor++;
+            }
+          }
+
+          // Acculumulate loss wrt the global scale groups
+          markersAndScalesLocalJac.block(0, 0, dofs, scaleGroupDims)
+              += mFitter->getIKLossGradientWrtJointsJacobianWrtGroupScales(
+                     threadSkeleton, threadMarkers, markerError, sparsityMap)
+                 * mObservationWeights(i);
+          // Acculumulate loss wrt the global marker offsets
+          markersAndScalesLocalJac.block(
+              0, scaleGroupDims, dofs, markerOffsetDims)
+              += mFitter->getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
+                     threadSkeleton, threadMarkers, markerError, sparsityMap)
+                 * mObservationWeights(i);
+        }
+
+        return markersAndScalesLocalJac;
+      }));
+    }
+
+    // Sum the shared part in a fixed order, so the result doesn't depend on
+    // which thread finishes first
+    Eigen::MatrixXs markersAndScalesJac
+        = Eigen::MatrixXs::Zero(dofs, scaleGroupDims + markerOffsetDims);
+    for (int k = 0; k < mNumThreads; k++)
+    {
+      markersAndScalesJac += futures[k].get();
+    }
+    for (int r = 0; r < dofs; r++)
+    {
+      for (int c = 0; c < scaleGroupDims; c++)
+      {
+        values(cursor) = markersAndScalesJac(r, c);
+        cursor++;
+      }
+      for (int m : mMarkerOffsetJacobianSparsity[r])
+      {
+        for (int axis = 0; axis < 3; axis++)
+        {
+          values(cursor)
+              = markersAndScalesJac(r, scaleGroupDims + m * 3 + axis);
+          cursor++;
+        }
+      }
+    }
+    assert(cursor == sharedEntries);
+    cursor += poseBlockEntries * mMarkerObservations.size();
+  }
+
+  if (mFitter->mZeroConstraints.size() > 0)
+  {
+    MarkerFitterState state(
+        x,
+        mMarkerMapObservations,
+        mInitialization.joints,
+        mJointCenters,
+        mJointWeights,
+        mJointAxis,
+        mAxisWeights,
+        mFitter);
+
+    for (auto pair : mFitter->mZeroConstraints)
+    {
+      pair.second(&state);
+      values.segment(cursor, x.size()) = state.flattenGradient();
+      cursor += x.size();
+    }
+  }
+  assert(cursor == values.size());
+
+  return values;
+}
+
 //==============================================================================
 /// This evaluates the Jacobian of our constraint vector wrt x given a
 /// concatenated vector of all the problem state: [groupSizes, markerOffsets,
@@ -8177,8 +9063,10 @@ bool BilevelFitProblem::get_nlp_info(
   // Set the total number of constraints
   m = mFitter->mSkeleton->getNumDofs() + mFitter->mZeroConstraints.size();
 
-  // Set the number of entries in the constraint Jacobian
-  nnz_jac_g = m * n;
+  // Set the number of entries in the constraint Jacobian. Each pose only
+  // touches the joints along the kinematic chains of its markers, so this is
+  // much smaller than m * n on a full body skeleton.
+  nnz_jac_g = mConstraintsJacobianSparsity.size();
 
   // Set the number of entries in the Hessian
   nnz_h_lag = n * n;
@@ -8364,17 +9252,12 @@ bool BilevelFitProblem::eval_jac_g(
   {
     Eigen::Map<Eigen::VectorXi> rows(_iRow, _nnzj);
     Eigen::Map<Eigen::VectorXi> cols(_jCol, _nnzj);
-    int cursor = 0;
-    for (int col = 0; col < _n; col++)
+    assert(mConstraintsJacobianSparsity.size() == _nnzj);
+    for (int i = 0; i < _nnzj; i++)
     {
-      for (int row = 0; row < _m; row++)
-      {
-        rows(cursor) = row;
-        cols(cursor) = col;
-        cursor++;
-      }
+      rows(i) = mConstraintsJacobianSparsity[i].first;
+      cols(i) = mConstraintsJacobianSparsity[i].second;
     }
-    assert(cursor == _nnzj);
   }
   else
   {
@@ -8382,18 +9265,9 @@ bool BilevelFitProblem::eval_jac_g(
     Eigen::Map<const Eigen::VectorXd> x(_x, _n);
     Eigen::Map<Eigen::VectorXd> vals(_values, _nnzj);
 
-    Eigen::MatrixXs jac = getConstraintsJacobian(x.cast<s_t>());
-
-    int cursor = 0;
-    for (int col = 0; col < jac.cols(); col++)
-    {
-      for (int row = 0; row < jac.rows(); row++)
-      {
-        vals(cursor) = (double)jac(row, col);
-        cursor++;
-      }
-    }
-    assert(cursor == _nnzj);
+    Eigen::VectorXs jacValues = getConstraintsJacobianValues(x.cast<s_t>());
+    assert(jacValues.size() == _nnzj);
+    vals = jacValues.cast<double>();
   }
 
   return true;
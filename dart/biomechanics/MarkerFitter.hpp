@@ -8,6 +8,7 @@
 #include <vector>
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <coin/IpIpoptApplication.hpp>
 #include <coin/IpTNLP.hpp>
 
@@ -19,6 +20,7 @@
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Shape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SkeletonClonePool.hpp"
 #include "dart/math/MathTypes.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
 
@@ -165,6 +167,11 @@ public:
       const std::vector<std::map<std::string, Eigen::Vector3s>>&
           markerObservations);
 
+  /// This returns the weight that each frame's marker terms get in the joint
+  /// fitting problems. With a stride of N, only every Nth frame is used, and
+  /// it's weighted by N so that losses are comparable across strides.
+  static Eigen::VectorXs getFrameWeights(int numTimesteps, int stride);
+
   int getProblemDim();
 
   Eigen::VectorXs flatten();
@@ -177,12 +184,39 @@ public:
 
   Eigen::VectorXs finiteDifferenceGradient();
 
+  /// The loss is a sum of squared residuals, so this returns the Gauss-Newton
+  /// step from the current state (to be added to flatten()), damped by adding
+  /// `damping` times the identity to the Gauss-Newton approximation of the
+  /// Hessian. This is the Levenberg-Marquardt step, which becomes a short
+  /// gradient descent step as `damping` grows.
+  Eigen::VectorXs getGaussNewtonStep(s_t damping);
+
   /// This writes the solution back to the output matrix reference passed in
   /// during initialization. This also returns a loss we achieved, which can be
   /// used as a confidence for downstream tasks.
   s_t saveSolutionBackToInitialization();
 
 protected:
+  /// This returns the offset from each marker to the center point on each
+  /// frame, as a (3 * markers) x timesteps matrix laid out like
+  /// mMarkerPositions
+  Eigen::MatrixXs getCenterOffsets();
+
+  /// This returns the residual (radius^2 - squared distance to the center) of
+  /// every marker on every frame, as a markers x timesteps matrix
+  Eigen::MatrixXs getSphereResiduals(const Eigen::MatrixXs& centerOffsets);
+
+  /// This sets each radius to the least-squares optimum for the current
+  /// center points, which has a closed form since the loss is quadratic in
+  /// the squared radii
+  void fitRadiiToCenterPoints();
+
+  /// This replaces the center points from IK with a per-frame algebraic
+  /// sphere fit, if that gives a lower loss. Subtracting one marker's sphere
+  /// equation from the others cancels the quadratic term in the center, which
+  /// leaves a small linear least-squares problem on each frame.
+  void fitCenterPointsWithLeastSquares();
+
   MarkerFitter* mFitter;
   std::vector<std::map<std::string, Eigen::Vector3s>> mMarkerObservations;
   Eigen::Ref<Eigen::MatrixXs> mOut;
@@ -194,6 +228,10 @@ public:
   int mNumTimesteps;
   Eigen::MatrixXs mMarkerPositions;
   Eigen::MatrixXi mMarkerObserved;
+  // This is mMarkerObserved scaled by the frame weights, one row per marker
+  Eigen::MatrixXs mMarkerWeights;
+  // This is 0 on the first frame of each clip, and 1 elsewhere
+  Eigen::VectorXs mSmoothingWeights;
   Eigen::VectorXs mRadii;
   Eigen::VectorXs mCenterPoints;
   std::string mJointName;
@@ -251,6 +289,10 @@ public:
   Eigen::MatrixXs mJointCenters;
   Eigen::MatrixXs mMarkerPositions;
   Eigen::MatrixXi mMarkerObserved;
+  // This is mMarkerObserved scaled by the frame weights, one row per marker
+  Eigen::MatrixXs mMarkerWeights;
+  // This is 0 on the first frame of each clip, and 1 elsewhere
+  Eigen::VectorXs mSmoothingWeights;
   Eigen::VectorXs mPerpendicularRadii;
   Eigen::VectorXs mParallelRadii;
   Eigen::VectorXs mAxisLines;
@@ -504,6 +546,28 @@ public:
       Eigen::Ref<Eigen::VectorXs> resultScores,
       bool backwards = false);
 
+  /// This runs IK for a single timestep of fitTrajectory(), on the ball joint
+  /// version of the skeleton, starting from `initialGuess` (in ball joint
+  /// space). If `maxRestarts` > 1, this also tries random poses for
+  /// `observedJoints` until one gets under the satisfactory loss. This leaves
+  /// both skeletons at the solution, and returns the final loss.
+  static s_t fitTrajectoryFrame(
+      const MarkerFitter* fitter,
+      std::shared_ptr<dynamics::Skeleton> skeleton,
+      std::shared_ptr<dynamics::Skeleton> skeletonBallJoints,
+      const std::vector<dynamics::Joint*>& jointsForSkeletonBallJoints,
+      const std::vector<dynamics::Joint*>& observedJoints,
+      const std::map<std::string, Eigen::Vector3s>& markerObservations,
+      const std::map<std::string, s_t>& markerWeights,
+      const std::map<std::string, Eigen::Vector3s>& markerOffsets,
+      const std::vector<dynamics::Joint*>& joints,
+      const Eigen::VectorXs& jointCenters,
+      const Eigen::VectorXs& jointWeights,
+      const Eigen::VectorXs& jointAxis,
+      const Eigen::VectorXs& axisWeights,
+      const Eigen::VectorXs& initialGuess,
+      int maxRestarts);
+
   ///////////////////////////////////////////////////////////////////////////
   // Pipeline step 2: Find joint centers
   ///////////////////////////////////////////////////////////////////////////
@@ -623,6 +687,26 @@ public:
       int numSamples,
       bool applyInnerProblemGradientConstraints = true);
 
+  /// This is the same as `optimizeBilevel()`, except it fine tunes exactly the
+  /// timesteps in `sampleIndices`, rather than evenly spaced ones.
+  std::shared_ptr<BilevelFitResult> optimizeBilevelOnTimesteps(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      MarkerInitialization& initialization,
+      std::vector<int> sampleIndices,
+      bool applyInnerProblemGradientConstraints = true);
+
+  /// This runs the bilevel optimization on a small set of the most informative
+  /// timesteps, then keeps doubling the set (warm starting from the last
+  /// solution) until the scales and marker offsets stop moving, or we reach
+  /// `maxSamples` timesteps.
+  std::shared_ptr<BilevelFitResult> optimizeBilevelAdaptively(
+      const std::vector<std::map<std::string, Eigen::Vector3s>>&
+          markerObservations,
+      MarkerInitialization& initialization,
+      int maxSamples,
+      bool applyInnerProblemGradientConstraints = true);
+
   ///////////////////////////////////////////////////////////////////////////
   // Pipeline step 5: Complete the intermittent pose information of the
   // BilevelFitResult by running IK to extend each section.
@@ -680,6 +764,17 @@ public:
           markerObservations,
       int maxSize);
 
+  /// This greedily picks the `numSamples` columns of `poses` that add the most
+  /// information about a model that is linear in the poses (a D-optimal
+  /// design), which favors a diverse spread of poses over near duplicates.
+  /// Each row is normalized to unit variance first. Columns in
+  /// `alreadyPicked` count towards the information, but are never returned
+  /// again. The result is sorted.
+  static std::vector<int> pickInformativeTimesteps(
+      const Eigen::MatrixXs& poses,
+      int numSamples,
+      const std::vector<int>& alreadyPicked = std::vector<int>());
+
   /// All markers are either "anatomical" or "tracking". Markers are presumed to
   /// be anamotical markers unless otherwise specified. Tracking markers are
   /// treated differently - they're not used in the initial scaling and fitting,
@@ -738,7 +833,8 @@ public:
   Eigen::VectorXs getIKLossGradWrtMarkerError(Eigen::VectorXs markerError);
 
   /// This lets us print the components of the loss, to allow easier tuning of
-  /// different weights
+  /// different weights. It also prints the progress of
+  /// optimizeBilevelAdaptively().
   void setDebugLoss(bool debug);
 
   /// During random-restarts on IK, when we find solutions below this loss we'll
@@ -753,6 +849,17 @@ public:
   /// initialization for the whole warp. Defaults to false.
   void setParallelIKWarps(bool parallelWarps);
 
+  /// If true, fitTrajectory() seeds each timestep's IK by extrapolating the
+  /// velocity of the last two solutions, rather than just reusing the last
+  /// solution. Any timestep that still finishes above the
+  /// setInitialIKSatisfactoryLoss() threshold gets re-solved with up to
+  /// setInitialIKMaxRestarts() random restarts, keeping whichever is better.
+  /// When combined with setParallelIKWarps(), the trajectory is split into
+  /// contiguous blocks that are each warm-started in sequence, in parallel,
+  /// rather than starting every timestep in a warp from the same guess.
+  /// Defaults to false.
+  void setWarmStartIK(bool warmStart);
+
   /// This gives us a configuration option to ignore the joint limits in the
   /// uploaded model, and then set them after the fit.
   void setIgnoreJointLimits(bool ignore);
@@ -765,9 +872,30 @@ public:
   void setIterationLimit(int limit);
 
   /// Sets the number of SGD iterations to run when fitting joint center / axis
-  /// problems
+  /// problems. This also caps the Gauss-Newton iterations, if
+  /// setJointFitUseGaussNewton() is on.
   void setJointFitSGDIterations(int iters);
 
+  /// If true, the joint center (sphere fitting) problems are solved with
+  /// damped Gauss-Newton steps instead of SGD. These are small least-squares
+  /// problems, so that usually converges in a handful of iterations, stopping
+  /// as soon as a step stops improving the loss. The joint axis problems still
+  /// use SGD. Defaults to false.
+  void setJointFitUseGaussNewton(bool useGaussNewton);
+
+  /// Sets the frame stride for the joint center / axis problems. With a stride
+  /// of N, only every Nth frame's markers go into the fit, and the frames in
+  /// between just follow along through the smoothing terms. Defaults to 1.
+  void setJointFitFrameStride(int stride);
+
+  /// If set to true, runKinematicsPipeline() uses optimizeBilevelAdaptively()
+  /// instead of a fixed set of evenly spaced timesteps. We start with
+  /// `initialSamples` timesteps, and stop growing once no scale changes by
+  /// more than `tolerance` (relative) and no marker offset moves by more than
+  /// `tolerance` meters. Defaults to false.
+  void setAdaptiveBilevelSampling(
+      bool adaptive, int initialSamples = 20, s_t tolerance = 1e-3);
+
   /// This sets an anthropometric prior which is used by the default loss. If
   /// you've called `setCustomLossAndGrad` then this has no effect.
   void setAnthropometricPrior(
@@ -853,6 +981,15 @@ public:
           markers,
       const std::vector<int>& sparsityMap);
 
+  /// This gets the jacobian of the marker error wrt the joints, as a sparse
+  /// matrix. Each marker only depends on the joints between it and the root,
+  /// so this only ever computes (and stores) those columns.
+  Eigen::SparseMatrix<s_t> getSparseMarkerErrorJacobianWrtJoints(
+      const std::shared_ptr<dynamics::Skeleton>& skeleton,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<int>& sparsityMap);
+
   /// This gets the jacobian of the marker error wrt the joints
   Eigen::MatrixXs finiteDifferenceMarkerErrorJacobianWrtJoints(
       const std::shared_ptr<dynamics::Skeleton>& skeleton,
@@ -886,6 +1023,14 @@ public:
           markers,
       const std::vector<int>& sparsityMap);
 
+  /// This gets the jacobian of the marker error wrt the group scales, as a
+  /// sparse matrix, leaving out the rows of markers that weren't observed
+  Eigen::SparseMatrix<s_t> getSparseMarkerErrorJacobianWrtGroupScales(
+      const std::shared_ptr<dynamics::Skeleton>& skeleton,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<int>& sparsityMap);
+
   /// This gets the jacobian of the marker error wrt the group scales
   Eigen::MatrixXs finiteDifferenceMarkerErrorJacobianWrtGroupScales(
       const std::shared_ptr<dynamics::Skeleton>& skeleton,
@@ -919,6 +1064,15 @@ public:
           markers,
       const std::vector<int>& sparsityMap);
 
+  /// This gets the jacobian of the marker error wrt the marker offsets, as a
+  /// sparse matrix. Each marker's offset only moves that marker, so this is
+  /// block diagonal, with one 3x3 block per observed marker.
+  Eigen::SparseMatrix<s_t> getSparseMarkerErrorJacobianWrtMarkerOffsets(
+      const std::shared_ptr<dynamics::Skeleton>& skeleton,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      const std::vector<int>& sparsityMap);
+
   /// This gets the jacobian of the marker error wrt the marker offsets
   Eigen::MatrixXs finiteDifferenceMarkerErrorJacobianWrtMarkerOffsets(
       const std::shared_ptr<dynamics::Skeleton>& skeleton,
@@ -968,6 +1122,12 @@ protected:
   std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
       mMarkersBallJoints;
 
+  // These hand out recycled copies of mSkeleton and mSkeletonBallJoints to
+  // worker threads, so that we don't clone the whole skeleton every time we
+  // fan out
+  std::shared_ptr<dynamics::SkeletonClonePool> mSkeletonClonePool;
+  std::shared_ptr<dynamics::SkeletonClonePool> mSkeletonBallJointsClonePool;
+
   std::function<s_t(MarkerFitterState*)> mLossAndGrad;
   std::map<std::string, std::function<s_t(MarkerFitterState*)>>
       mZeroConstraints;
@@ -983,6 +1143,7 @@ protected:
   bool mIgnoreJointLimits;
   s_t mMaxMarkerOffset;
   bool mUseParallelIKWarps;
+  bool mWarmStartIK;
 
   // Parameters for joint weighting
   s_t mMinVarianceCutoff;
@@ -1009,6 +1170,12 @@ protected:
   bool mDisableLinesearch;
 
   int mJointFitSGDIterations;
+  int mJointFitFrameStride;
+  bool mJointFitUseGaussNewton;
+
+  bool mAdaptiveBilevelSampling;
+  int mAdaptiveBilevelInitialSamples;
+  s_t mAdaptiveBilevelTolerance;
 };
 
 /*
@@ -1030,7 +1197,7 @@ public:
       const std::vector<std::map<std::string, Eigen::Vector3s>>&
           markerObservations,
       MarkerInitialization& initialization,
-      int numSamples,
+      const std::vector<int>& sampleIndices,
       bool applyInnerProblemGradientConstraints,
       std::shared_ptr<BilevelFitResult>& outResult);
 
@@ -1066,6 +1233,18 @@ public:
   /// q_0, ..., q_N]
   Eigen::MatrixXs getConstraintsJacobian(Eigen::VectorXs x);
 
+  /// This evaluates the Jacobian of our constraint vector wrt x, exactly like
+  /// getConstraintsJacobian(), but only computes and stores the entries that
+  /// can be non-zero (see getConstraintsJacobianSparsity()).
+  Eigen::SparseMatrix<s_t> getSparseConstraintsJacobian(Eigen::VectorXs x);
+
+  /// This returns the (row, col) of every entry of the constraint Jacobian
+  /// that can be non-zero. The inner problem gradient for each pose only
+  /// depends on joints that share a marker's kinematic chain, and on the
+  /// offsets of markers below that joint, so this is much sparser than the
+  /// full Jacobian on a big skeleton.
+  const std::vector<std::pair<int, int>>& getConstraintsJacobianSparsity();
+
   /// This evaluates the Jacobian of our constraint vector wrt x given a
   /// concatenated vector of all the problem state: [groupSizes, markerOffsets,
   /// q_0, ..., q_N]
@@ -1220,6 +1399,23 @@ protected:
   Eigen::VectorXs mLastX;
   Eigen::VectorXs mBestObjectiveValueState;
 
+  /// This fills in mConstraintsJacobianSparsity, and the per-row sparsity
+  /// below it. This only depends on the skeleton's structure and the number
+  /// of samples, so we only need to do it once.
+  void computeConstraintsJacobianSparsity();
+
+  /// This computes the values of the constraint Jacobian at `x`, in the same
+  /// order as getConstraintsJacobianSparsity()
+  Eigen::VectorXs getConstraintsJacobianValues(Eigen::VectorXs x);
+
+  // For each DOF (row of the inner problem gradient), the DOFs of a single
+  // pose that can change it, sorted
+  std::vector<std::vector<int>> mPoseJacobianSparsity;
+  // For each DOF, the markers whose offsets can change its inner problem
+  // gradient, sorted
+  std::vector<std::vector<int>> mMarkerOffsetJacobianSparsity;
+  std::vector<std::pair<int, int>> mConstraintsJacobianSparsity;
+
   // Thread state
 
   int mNumThreads;
@@ -86,18 +86,27 @@ s_t LabeledMarkerTrace::pointToAppendDistance(
   {
     return 0.0;
   }
+  return (point - predictAppendPoint(time, extrapolate)).norm();
+}
+
+//==============================================================================
+/// This gives the point that pointToAppendDistance() measures from: the last
+/// point, or an extrapolation of it to this timestep.
+Eigen::Vector3s LabeledMarkerTrace::predictAppendPoint(
+    int time, bool extrapolate)
+{
+  assert(mPoints.size() > 0);
   Eigen::Vector3s& lastPoint = mPoints.at(mPoints.size() - 1);
   if (extrapolate && mPoints.size() > 1)
   {
     int lastTime = mTimes.at(mTimes.size() - 1);
     Eigen::Vector3s v = (lastPoint - mPoints.at(mPoints.size() - 2))
                         / (lastTime - mTimes.at(mTimes.size() - 2));
-    Eigen::Vector3s projected = lastPoint + (v * (time - lastTime));
-    return (point - projected).norm();
+    return lastPoint + (v * (time - lastTime));
   }
   else
   {
-    return (point - lastPoint).norm();
+    return lastPoint;
   }
 }
 
@@ -321,19 +330,14 @@ std::vector<LabeledMarkerTrace> LabeledMarkerTrace::createRawTraces(
   for (int t = 0; t < markerObservations.size(); t++)
   {
     // 1. Only count as "active" the traces that are within `mergeFrames` of now
-    std::vector<int> tracesToRemove;
-    for (int i = 0; i < activeTraces.size(); i++)
-    {
-      if (traces[activeTraces[i]].lastTimestep() < t - mergeFrames)
-      {
-        // This needs to be deactivated
-        tracesToRemove.push_back(i);
-      }
-    }
-    for (int j = tracesToRemove.size() - 1; j >= 0; j--)
-    {
-      activeTraces.erase(activeTraces.begin() + tracesToRemove[j]);
-    }
+    activeTraces.erase(
+        std::remove_if(
+            activeTraces.begin(),
+            activeTraces.end(),
+            [&traces, t, mergeFrames](int trace) {
+              return traces[trace].lastTimestep() < t - mergeFrames;
+            }),
+        activeTraces.end());
 
     // Bail early on empty frames
     if (markerObservations[t].size() == 0)
@@ -347,29 +351,28 @@ std::vector<LabeledMarkerTrace> LabeledMarkerTrace::createRawTraces(
       markerNames.push_back(pair.first);
     }
 
-    // 2. Compute affinity scores between active traces and points
-    Eigen::MatrixXs weights
-        = Eigen::MatrixXs(markerObservations[t].size(), activeTraces.size());
+    // 2. Compute affinity scores between active traces and points. Only pairs
+    // within `mergeDistance` can match, so we hash the predicted end of each
+    // trace into a grid rather than comparing every point to every trace.
+    std::vector<Eigen::Vector3s> points;
     for (int i = 0; i < markerNames.size(); i++)
     {
-      for (int j = 0; j < activeTraces.size(); j++)
-      {
-        s_t dist = traces[activeTraces[j]].pointToAppendDistance(
-            t, markerObservations[t].at(markerNames[i]), true);
-        if (dist > mergeDistance)
-        {
-          weights(i, j) = -1 * std::numeric_limits<double>::infinity();
-        }
-        else
-        {
-          weights(i, j) = 1.0 / dist;
-        }
-      }
+      points.push_back(markerObservations[t].at(markerNames[i]));
+    }
+    std::vector<Eigen::Vector3s> tracePredictions;
+    for (int j = 0; j < activeTraces.size(); j++)
+    {
+      tracePredictions.push_back(
+          traces[activeTraces[j]].predictAppendPoint(t, true));
     }
+    math::SparseAssignmentProblem problem
+        = math::AssignmentMatcher::createGatedDistanceProblem(
+            points, tracePredictions, mergeDistance);
 
     // 3. Assign points to active traces, or create new traces for unassigned
     // points
-    Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumns(weights);
+    Eigen::VectorXi map
+        = math::AssignmentMatcher::assignRowsToColumnsSparse(problem);
     for (int i = 0; i < map.size(); i++)
     {
       if (map(i) == -1)
@@ -588,10 +591,13 @@ RippleReductionProblem::smooth(MarkersErrorReport* report)
     int duration = (lastObserved - firstObserved) + 1;
 
     // Smooth only the window during which we observed the marker (don't smooth
-    // to the 0's on frames where we weren't observing the marker)
-    AccelerationSmoother smoother(duration, 0.3, 1.0);
-    mMarkers[markerName].block(0, firstObserved, 3, duration) = smoother.smooth(
-        mMarkers[markerName].block(0, firstObserved, 3, duration));
+    // to the 0's on frames where we weren't observing the marker). This works
+    // in bounded memory, no matter how long the recording is.
+    mMarkers[markerName].block(0, firstObserved, 3, duration)
+        = AccelerationSmoother::smoothWindowed(
+            mMarkers[markerName].block(0, firstObserved, 3, duration),
+            0.3,
+            1.0);
   }
 
   std::vector<std::map<std::string, Eigen::Vector3s>> markers;
@@ -52,6 +52,11 @@ public:
   /// timestep of the last point, of order up to 2)
   s_t pointToAppendDistance(int time, Eigen::Vector3s point, bool extrapolate);
 
+  /// This gives the point that pointToAppendDistance() measures from: the last
+  /// point, or an extrapolation of it to this timestep. The trace must not be
+  /// empty.
+  Eigen::Vector3s predictAppendPoint(int time, bool extrapolate);
+
   /// This merges point clouds over time, to create a set of raw MarkerTraces
   /// over time. These traces can then be intelligently merged using any desired
   /// algorithm.
@@ -1,5 +1,7 @@
 #include "dart/biomechanics/MarkerLabeller.hpp"
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <limits>
 #include <string>
@@ -75,18 +77,26 @@ s_t MarkerTrace::pointToAppendDistance(
   {
     return 0.0;
   }
+  return (point - predictAppendPoint(time, extrapolate)).norm();
+}
+
+//==============================================================================
+/// This gives the point that pointToAppendDistance() measures from: the last
+/// point, or an extrapolation of it to this timestep.
+Eigen::Vector3s MarkerTrace::predictAppendPoint(int time, bool extrapolate)
+{
+  assert(mPoints.size() > 0);
   Eigen::Vector3s& lastPoint = mPoints.at(mPoints.size() - 1);
   if (extrapolate && mPoints.size() > 1)
   {
     int lastTime = mTimes.at(mTimes.size() - 1);
     Eigen::Vector3s v = (lastPoint - mPoints.at(mPoints.size() - 2))
                         / (lastTime - mTimes.at(mTimes.size() - 2));
-    Eigen::Vector3s projected = lastPoint + (v * (time - lastTime));
-    return (point - projected).norm();
+    return lastPoint + (v * (time - lastTime));
   }
   else
   {
-    return (point - lastPoint).norm();
+    return lastPoint;
   }
 }
 
@@ -103,69 +113,79 @@ std::vector<MarkerTrace> MarkerTrace::createRawTraces(
   std::vector<int> activeTraces;
   for (int t = 0; t < pointClouds.size(); t++)
   {
-    // 1. Only count as "active" the traces that are within `mergeFrames` of now
-    std::vector<int> tracesToRemove;
-    for (int i = 0; i < activeTraces.size(); i++)
-    {
-      if (traces[activeTraces[i]].lastTimestep() < t - mergeFrames)
-      {
-        // This needs to be deactivated
-        tracesToRemove.push_back(i);
-      }
-    }
-    for (int j = tracesToRemove.size() - 1; j >= 0; j--)
-    {
-      activeTraces.erase(activeTraces.begin() + tracesToRemove[j]);
-    }
+    appendPointCloud(
+        traces, activeTraces, t, pointClouds[t], mergeDistance, mergeFrames);
+  }
 
-    // Bail early on empty frames
-    if (pointClouds[t].size() == 0)
-    {
-      continue;
-    }
+  return traces;
+}
 
-    // 2. Compute affinity scores between active traces and points
-    Eigen::MatrixXs weights
-        = Eigen::MatrixXs(pointClouds[t].size(), activeTraces.size());
-    for (int i = 0; i < pointClouds[t].size(); i++)
+//==============================================================================
+/// This adds one more point cloud onto a set of traces that's being built up
+/// over time, which is one step of createRawTraces(). `activeTraces` holds
+/// the indices of the traces that could still be extended, and is updated in
+/// place. This returns the index of the trace each point was added to.
+std::vector<int> MarkerTrace::appendPointCloud(
+    std::vector<MarkerTrace>& traces,
+    std::vector<int>& activeTraces,
+    int t,
+    const std::vector<Eigen::Vector3s>& pointCloud,
+    s_t mergeDistance,
+    int mergeFrames)
+{
+  // 1. Only count as "active" the traces that are within `mergeFrames` of now
+  activeTraces.erase(
+      std::remove_if(
+          activeTraces.begin(),
+          activeTraces.end(),
+          [&traces, t, mergeFrames](int trace) {
+            return traces[trace].lastTimestep() < t - mergeFrames;
+          }),
+      activeTraces.end());
+
+  // Bail early on empty frames
+  std::vector<int> pointTraces;
+  if (pointCloud.size() == 0)
+  {
+    return pointTraces;
+  }
+
+  // 2. Compute affinity scores between active traces and points. Only pairs
+  // within `mergeDistance` can match, so we hash the predicted end of each
+  // trace into a grid rather than comparing every point to every trace.
+  std::vector<Eigen::Vector3s> tracePredictions;
+  for (int j = 0; j < activeTraces.size(); j++)
+  {
+    tracePredictions.push_back(
+        traces[activeTraces[j]].predictAppendPoint(t, true));
+  }
+  math::SparseAssignmentProblem problem
+      = math::AssignmentMatcher::createGatedDistanceProblem(
+          pointCloud, tracePredictions, mergeDistance);
+
+  // 3. Assign points to active traces, or create new traces for unassigned
+  // points
+  Eigen::VectorXi map
+      = math::AssignmentMatcher::assignRowsToColumnsSparse(problem);
+  for (int i = 0; i < map.size(); i++)
+  {
+    if (map(i) == -1)
     {
-      for (int j = 0; j < activeTraces.size(); j++)
-      {
-        s_t dist = traces[activeTraces[j]].pointToAppendDistance(
-            t, pointClouds[t][i], true);
-        if (dist > mergeDistance)
-        {
-          weights(i, j) = -1 * std::numeric_limits<double>::infinity();
-        }
-        else
-        {
-          weights(i, j) = 1.0 / dist;
-        }
-      }
+      traces.emplace_back(t, pointCloud[i]);
+      assert(traces.at(traces.size() - 1).mPoints.size() == 1);
+      activeTraces.push_back(traces.size() - 1);
+      assert(
+          traces.at(activeTraces.at(activeTraces.size() - 1)).mPoints.size()
+          == 1);
+      pointTraces.push_back(traces.size() - 1);
     }
-
-    // 3. Assign points to active traces, or create new traces for unassigned
-    // points
-    Eigen::VectorXi map = math::AssignmentMatcher::assignRowsToColumns(weights);
-    for (int i = 0; i < map.size(); i++)
+    else
     {
-      if (map(i) == -1)
-      {
-        traces.emplace_back(t, pointClouds[t][i]);
-        assert(traces.at(traces.size() - 1).mPoints.size() == 1);
-        activeTraces.push_back(traces.size() - 1);
-        assert(
-            traces.at(activeTraces.at(activeTraces.size() - 1)).mPoints.size()
-            == 1);
-      }
-      else
-      {
-        traces[activeTraces[map(i)]].appendPoint(t, pointClouds[t][i]);
-      }
+      traces[activeTraces[map(i)]].appendPoint(t, pointCloud[i]);
+      pointTraces.push_back(activeTraces[map(i)]);
     }
   }
-
-  return traces;
+  return pointTraces;
 }
 
 //==============================================================================
@@ -465,164 +485,12 @@ LabelledMarkers MarkerLabeller::labelPointClouds(
   // centers at that frame.
   std::vector<Eigen::VectorXs> poses;
   std::vector<Eigen::VectorXs> scales;
-
-  // 3.1. Convert the skeleton to have any Euler joints as ball joints
-  std::shared_ptr<dynamics::Skeleton> skeletonBallJoints
-      = mSkeleton->convertSkeletonToBallJoints();
-
-  // 3.2. Calculate problem size
-  int problemDim = skeletonBallJoints->getNumDofs()
-                   + skeletonBallJoints->getGroupScaleDim();
-
-  // 3.3. Set our initial guess for IK to whatever the current pose of the
-  // skeleton is
-  Eigen::VectorXs initialPos = Eigen::VectorXs::Ones(problemDim);
-  Eigen::VectorXs lowerBound = Eigen::VectorXs::Zero(problemDim);
-  Eigen::VectorXs upperBound = Eigen::VectorXs::Zero(problemDim);
-  initialPos.segment(0, skeletonBallJoints->getNumDofs())
-      = skeletonBallJoints->convertPositionsToBallSpace(
-          skeletonBallJoints->getPositions());
-  lowerBound.segment(0, skeletonBallJoints->getNumDofs())
-      = skeletonBallJoints->getPositionLowerLimits();
-  upperBound.segment(0, skeletonBallJoints->getNumDofs())
-      = skeletonBallJoints->getPositionUpperLimits();
-  initialPos.segment(
-      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
-      = skeletonBallJoints->getGroupScales();
-  lowerBound.segment(
-      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
-      = skeletonBallJoints->getGroupScalesLowerBound();
-  upperBound.segment(
-      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
-      = skeletonBallJoints->getGroupScalesUpperBound();
-
-  // 3.4. Linearize the joint center guesses
-  Eigen::VectorXs jointCenterVec
-      = Eigen::VectorXs::Zero(mJointToSkelJointNames.size() * 3);
-  std::vector<std::string> jointNames;
-  std::vector<dynamics::Joint*> ballSkelJoints;
-  std::vector<dynamics::Joint*> skelJoints;
-  for (auto& pair : mJointToSkelJointNames)
-  {
-    jointNames.push_back(pair.first);
-    skelJoints.push_back(mSkeleton->getJoint(pair.second));
-    ballSkelJoints.push_back(skeletonBallJoints->getJoint(pair.second));
-  }
-
-  // 3.5. Perform IK on each timestep
+  JointCenterFit fit = createJointCenterFit();
   for (int t = 0; t < jointCenters.size(); t++)
   {
-    // 3.5.1. Copy this frame's joint center guesses over
-    for (int j = 0; j < jointNames.size(); j++)
-    {
-      jointCenterVec.segment<3>(j * 3) = jointCenters[t][jointNames[j]];
-    }
-
-    // 3.5. Actually solve the IK
-    s_t result = math::solveIK(
-        initialPos,
-        upperBound,
-        lowerBound,
-        jointCenterVec.size(),
-        // Set positions
-        [&skeletonBallJoints, this](const Eigen::VectorXs pos, bool clamp) {
-          skeletonBallJoints->setPositions(
-              pos.segment(0, skeletonBallJoints->getNumDofs()));
-
-          if (clamp)
-          {
-            // 1. Map the position back into eulerian space
-            mSkeleton->setPositions(mSkeleton->convertPositionsFromBallSpace(
-                pos.segment(0, skeletonBallJoints->getNumDofs())));
-            // 2. Clamp the position to limits
-            mSkeleton->clampPositionsToLimits();
-            // 3. Map the position back into SO3 space
-            skeletonBallJoints->setPositions(
-                mSkeleton->convertPositionsToBallSpace(
-                    mSkeleton->getPositions()));
-          }
-
-          // Set scales
-          Eigen::VectorXs newScales = pos.segment(
-              skeletonBallJoints->getNumDofs(),
-              skeletonBallJoints->getGroupScaleDim());
-          Eigen::VectorXs scalesUpperBound
-              = skeletonBallJoints->getGroupScalesUpperBound();
-          Eigen::VectorXs scalesLowerBound
-              = skeletonBallJoints->getGroupScalesLowerBound();
-          newScales = newScales.cwiseMax(scalesLowerBound);
-          newScales = newScales.cwiseMin(scalesUpperBound);
-          mSkeleton->setGroupScales(newScales);
-          skeletonBallJoints->setGroupScales(newScales);
-
-          // Return the clamped position
-          Eigen::VectorXs clampedPos = Eigen::VectorXs::Zero(pos.size());
-          clampedPos.segment(0, skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints->getPositions();
-          clampedPos.segment(
-              skeletonBallJoints->getNumDofs(),
-              skeletonBallJoints->getGroupScaleDim())
-              = newScales;
-          return clampedPos;
-        },
-        // Compute the Jacobian
-        [&skeletonBallJoints, &jointCenterVec, &ballSkelJoints](
-            Eigen::Ref<Eigen::VectorXs> diff, Eigen::Ref<Eigen::MatrixXs> jac) {
-          Eigen::VectorXs jointPoses
-              = skeletonBallJoints->getJointWorldPositions(ballSkelJoints);
-          diff = jointPoses - jointCenterVec;
-
-          assert(
-              jac.cols()
-              == skeletonBallJoints->getNumDofs()
-                     + skeletonBallJoints->getGroupScaleDim());
-          assert(jac.rows() == jointCenterVec.size());
-          jac.setZero();
-
-          jac.block(
-              0, 0, jointCenterVec.size(), skeletonBallJoints->getNumDofs())
-              = skeletonBallJoints
-                    ->getJointWorldPositionsJacobianWrtJointPositions(
-                        ballSkelJoints);
-          jac.block(
-              0,
-              skeletonBallJoints->getNumDofs(),
-              jointCenterVec.size(),
-              skeletonBallJoints->getGroupScaleDim())
-              = skeletonBallJoints
-                    ->getJointWorldPositionsJacobianWrtGroupScales(
-                        ballSkelJoints);
-        },
-        // Generate a random restart position
-        [&skeletonBallJoints, &skelJoints, this](
-            Eigen::Ref<Eigen::VectorXs> val) {
-          val.segment(0, skeletonBallJoints->getNumDofs())
-              = mSkeleton->convertPositionsToBallSpace(
-                  mSkeleton->getRandomPoseForJoints(skelJoints));
-          val.segment(
-                 skeletonBallJoints->getNumDofs(),
-                 skeletonBallJoints->getGroupScaleDim())
-              .setConstant(1.0);
-        },
-        math::IKConfig()
-            .setMaxStepCount(t == 0 ? 150 : 50)
-            .setConvergenceThreshold(1e-10)
-            .setLossLowerBound(1e-8)
-            // .setLossLowerBound(0.001)
-            .setMaxRestarts(t == 0 ? 10 : 1)
-            .setLogOutput(false));
-    (void)result;
-    // std::cout << "Best result: " << result << std::endl;
-
-    poses.push_back(mSkeleton->getPositions());
-    scales.push_back(mSkeleton->getGroupScales());
-
-    initialPos.segment(0, skeletonBallJoints->getNumDofs())
-        = mSkeleton->convertPositionsToBallSpace(mSkeleton->getPositions());
-    initialPos.segment(
-        skeletonBallJoints->getNumDofs(),
-        skeletonBallJoints->getGroupScaleDim())
-        = mSkeleton->getGroupScales();
+    poses.emplace_back();
+    scales.emplace_back();
+    fitJointCenters(fit, jointCenters[t], poses.back(), scales.back());
   }
 
   // 4. Compute fingerprints on each body, based on the results of IK
@@ -639,57 +507,10 @@ LabelledMarkers MarkerLabeller::labelPointClouds(
   // yet have enough information to determine that.
   std::map<std::string, std::pair<std::string, Eigen::Vector3s>> markers;
 
-  for (MarkerTrace& trace : traces)
+  for (int i = 0; i < traces.size(); i++)
   {
-    std::pair<std::string, Eigen::Vector3s> bestMarker = trace.getBestMarker();
-
-    // 4.2. Check if there's already a marker for this body and offset, and
-    // if so, if that marker is already assigned during our trace
-    bool foundMarker = false;
-
-    for (auto markerPair : markers)
-    {
-      std::string markerName = markerPair.first;
-      std::string bodyName = markerPair.second.first;
-      if (bodyName == bestMarker.first)
-      {
-        Eigen::Vector3s offset = markerPair.second.second;
-        s_t dist = (offset - bestMarker.second).norm();
-        if (dist < mergeMarkersThreshold)
-        {
-          // 4.2.1. We've got a hit! Check whether this marker is already
-          // assigned to any traces that overlap this one
-          bool anyOverlap = false;
-          for (MarkerTrace& otherTrace : traces)
-          {
-            if (&trace == &otherTrace)
-              continue;
-            if (otherTrace.mMarkerLabel == markerName
-                && trace.overlap(otherTrace))
-            {
-              anyOverlap = true;
-              break;
-            }
-          }
-
-          // 4.2.2. We're clear to merge this marker in!
-          if (!anyOverlap)
-          {
-            foundMarker = true;
-            trace.mMarkerLabel = markerName;
-            break;
-          }
-        }
-      }
-    }
-
-    if (!foundMarker)
-    {
-      // Create a new marker
-      std::string markerName = std::to_string(markers.size());
-      markers[markerName] = bestMarker;
-      trace.mMarkerLabel = markerName;
-    }
+    assignMarkerLabel(
+        i, traces, traces[i].getBestMarker(), markers, mergeMarkersThreshold);
   }
 
   // 5. Now we can ditch the traces, and reconstruct labeled point clouds
@@ -726,6 +547,271 @@ LabelledMarkers MarkerLabeller::labelPointClouds(
   return result;
 }
 
+//==============================================================================
+/// This sets up everything we need to fit our skeleton to joint center
+/// guesses, starting from the current pose of the skeleton
+MarkerLabeller::JointCenterFit MarkerLabeller::createJointCenterFit()
+{
+  JointCenterFit fit;
+
+  // 1. Convert the skeleton to have any Euler joints as ball joints
+  fit.skeletonBallJoints = mSkeleton->convertSkeletonToBallJoints();
+  std::shared_ptr<dynamics::Skeleton>& skeletonBallJoints
+      = fit.skeletonBallJoints;
+
+  // 2. Calculate problem size
+  int problemDim = skeletonBallJoints->getNumDofs()
+                   + skeletonBallJoints->getGroupScaleDim();
+
+  // 3. Set our initial guess for IK to whatever the current pose of the
+  // skeleton is
+  fit.initialPos = Eigen::VectorXs::Ones(problemDim);
+  fit.lowerBound = Eigen::VectorXs::Zero(problemDim);
+  fit.upperBound = Eigen::VectorXs::Zero(problemDim);
+  fit.initialPos.segment(0, skeletonBallJoints->getNumDofs())
+      = skeletonBallJoints->convertPositionsToBallSpace(
+          skeletonBallJoints->getPositions());
+  fit.lowerBound.segment(0, skeletonBallJoints->getNumDofs())
+      = skeletonBallJoints->getPositionLowerLimits();
+  fit.upperBound.segment(0, skeletonBallJoints->getNumDofs())
+      = skeletonBallJoints->getPositionUpperLimits();
+  fit.initialPos.segment(
+      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
+      = skeletonBallJoints->getGroupScales();
+  fit.lowerBound.segment(
+      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
+      = skeletonBallJoints->getGroupScalesLowerBound();
+  fit.upperBound.segment(
+      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
+      = skeletonBallJoints->getGroupScalesUpperBound();
+
+  // 4. Linearize the joint center guesses
+  fit.jointCenterVec = Eigen::VectorXs::Zero(mJointToSkelJointNames.size() * 3);
+  for (auto& pair : mJointToSkelJointNames)
+  {
+    fit.jointNames.push_back(pair.first);
+    fit.skelJoints.push_back(mSkeleton->getJoint(pair.second));
+    fit.ballSkelJoints.push_back(skeletonBallJoints->getJoint(pair.second));
+  }
+  fit.numFramesFit = 0;
+
+  return fit;
+}
+
+//==============================================================================
+/// This runs IK+scaling to match one frame of joint center guesses, warm
+/// starting from the last frame `fit` was used on, and writes the resulting
+/// pose and group scales of our skeleton into `pose` and `scale`.
+void MarkerLabeller::fitJointCenters(
+    JointCenterFit& fit,
+    const std::map<std::string, Eigen::Vector3s>& jointCenters,
+    Eigen::VectorXs& pose,
+    Eigen::VectorXs& scale)
+{
+  std::shared_ptr<dynamics::Skeleton>& skeletonBallJoints
+      = fit.skeletonBallJoints;
+  Eigen::VectorXs& jointCenterVec = fit.jointCenterVec;
+  std::vector<dynamics::Joint*>& ballSkelJoints = fit.ballSkelJoints;
+  std::vector<dynamics::Joint*>& skelJoints = fit.skelJoints;
+  // The first frame has no good warm start, so we search harder
+  const bool coldStart = fit.numFramesFit == 0;
+
+  // 1. Copy this frame's joint center guesses over
+  for (int j = 0; j < fit.jointNames.size(); j++)
+  {
+    auto center = jointCenters.find(fit.jointNames[j]);
+    jointCenterVec.segment<3>(j * 3) = center == jointCenters.end()
+                                           ? Eigen::Vector3s::Zero()
+                                           : center->second;
+  }
+
+  // 2. Actually solve the IK
+  s_t result = math::solveIK(
+      fit.initialPos,
+      fit.upperBound,
+      fit.lowerBound,
+      fit.jointCenterVec.size(),
+      // Set positions
+      [&skeletonBallJoints, this](const Eigen::VectorXs pos, bool clamp) {
+        skeletonBallJoints->setPositions(
+            pos.segment(0, skeletonBallJoints->getNumDofs()));
+
+        if (clamp)
+        {
+          // 1. Map the position back into eulerian space
+          mSkeleton->setPositions(mSkeleton->convertPositionsFromBallSpace(
+              pos.segment(0, skeletonBallJoints->getNumDofs())));
+          // 2. Clamp the position to limits
+          mSkeleton->clampPositionsToLimits();
+          // 3. Map the position back into SO3 space
+          skeletonBallJoints->setPositions(
+              mSkeleton->convertPositionsToBallSpace(
+                  mSkeleton->getPositions()));
+        }
+
+        // Set scales
+        Eigen::VectorXs newScales = pos.segment(
+            skeletonBallJoints->getNumDofs(),
+            skeletonBallJoints->getGroupScaleDim());
+        Eigen::VectorXs scalesUpperBound
+            = skeletonBallJoints->getGroupScalesUpperBound();
+        Eigen::VectorXs scalesLowerBound
+            = skeletonBallJoints->getGroupScalesLowerBound();
+        newScales = newScales.cwiseMax(scalesLowerBound);
+        newScales = newScales.cwiseMin(scalesUpperBound);
+        mSkeleton->setGroupScales(newScales);
+        skeletonBallJoints->setGroupScales(newScales);
+
+        // Return the clamped position
+        Eigen::VectorXs clampedPos = Eigen::VectorXs::Zero(pos.size());
+        clampedPos.segment(0, skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints->getPositions();
+        clampedPos.segment(
+            skeletonBallJoints->getNumDofs(),
+            skeletonBallJoints->getGroupScaleDim())
+            = newScales;
+        return clampedPos;
+      },
+      // Compute the Jacobian
+      [&skeletonBallJoints, &jointCenterVec, &ballSkelJoints](
+          Eigen::Ref<Eigen::VectorXs> diff, Eigen::Ref<Eigen::MatrixXs> jac) {
+        Eigen::VectorXs jointPoses
+            = skeletonBallJoints->getJointWorldPositions(ballSkelJoints);
+        diff = jointPoses - jointCenterVec;
+
+        assert(
+            jac.cols()
+            == skeletonBallJoints->getNumDofs()
+                   + skeletonBallJoints->getGroupScaleDim());
+        assert(jac.rows() == jointCenterVec.size());
+        jac.setZero();
+
+        jac.block(
+            0, 0, jointCenterVec.size(), skeletonBallJoints->getNumDofs())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtJointPositions(
+                      ballSkelJoints);
+        jac.block(
+            0,
+            skeletonBallJoints->getNumDofs(),
+            jointCenterVec.size(),
+            skeletonBallJoints->getGroupScaleDim())
+            = skeletonBallJoints
+                  ->getJointWorldPositionsJacobianWrtGroupScales(
+                      ballSkelJoints);
+      },
+      // Generate a random restart position
+      [&skeletonBallJoints, &skelJoints, this](
+          Eigen::Ref<Eigen::VectorXs> val) {
+        val.segment(0, skeletonBallJoints->getNumDofs())
+            = mSkeleton->convertPositionsToBallSpace(
+                mSkeleton->getRandomPoseForJoints(skelJoints));
+        val.segment(
+               skeletonBallJoints->getNumDofs(),
+               skeletonBallJoints->getGroupScaleDim())
+            .setConstant(1.0);
+      },
+      math::IKConfig()
+          .setMaxStepCount(coldStart ? 150 : 50)
+          .setConvergenceThreshold(1e-10)
+          .setLossLowerBound(1e-8)
+          // .setLossLowerBound(0.001)
+          .setMaxRestarts(coldStart ? 10 : 1)
+          .setLogOutput(false));
+  (void)result;
+  // std::cout << "Best result: " << result << std::endl;
+
+  pose = mSkeleton->getPositions();
+  scale = mSkeleton->getGroupScales();
+
+  fit.initialPos.segment(0, skeletonBallJoints->getNumDofs())
+      = mSkeleton->convertPositionsToBallSpace(mSkeleton->getPositions());
+  fit.initialPos.segment(
+      skeletonBallJoints->getNumDofs(), skeletonBallJoints->getGroupScaleDim())
+      = mSkeleton->getGroupScales();
+  fit.numFramesFit++;
+}
+
+//==============================================================================
+/// This picks a label for `traces[traceIndex]`, given the best marker for it.
+/// If there's already a marker on the same body within
+/// `mergeMarkersThreshold` of it, and no other trace that overlaps this one in
+/// time already has that label, we reuse that label. Otherwise we create a
+/// new marker in `markers`.
+void MarkerLabeller::assignMarkerLabel(
+    int traceIndex,
+    std::vector<MarkerTrace>& traces,
+    const std::pair<std::string, Eigen::Vector3s>& bestMarker,
+    std::map<std::string, std::pair<std::string, Eigen::Vector3s>>& markers,
+    s_t mergeMarkersThreshold)
+{
+  MarkerTrace& trace = traces[traceIndex];
+
+  // 1. Check if there's already a marker for this body and offset, and if so,
+  // if that marker is already assigned during our trace
+  for (auto markerPair : markers)
+  {
+    std::string markerName = markerPair.first;
+    std::string bodyName = markerPair.second.first;
+    if (bodyName == bestMarker.first)
+    {
+      Eigen::Vector3s offset = markerPair.second.second;
+      s_t dist = (offset - bestMarker.second).norm();
+      if (dist < mergeMarkersThreshold)
+      {
+        // 1.1. We've got a hit! Check whether this marker is already assigned
+        // to any traces that overlap this one
+        bool anyOverlap = false;
+        for (MarkerTrace& otherTrace : traces)
+        {
+          if (&trace == &otherTrace)
+            continue;
+          if (otherTrace.mMarkerLabel == markerName
+              && trace.overlap(otherTrace))
+          {
+            anyOverlap = true;
+            break;
+          }
+        }
+
+        // 1.2. We're clear to merge this marker in!
+        if (!anyOverlap)
+        {
+          trace.mMarkerLabel = markerName;
+          return;
+        }
+      }
+    }
+  }
+
+  // 2. Create a new marker
+  std::string markerName = std::to_string(markers.size());
+  markers[markerName] = bestMarker;
+  trace.mMarkerLabel = markerName;
+}
+
+//==============================================================================
+/// This guesses the joint centers for just the last of a window of recent
+/// point clouds, which are the frames up to and including `timestep` in a
+/// stream. By default this runs guessJointLocations() over the whole window.
+std::map<std::string, Eigen::Vector3s>
+MarkerLabeller::guessLatestJointLocations(
+    const std::vector<std::vector<Eigen::Vector3s>>& recentPointClouds,
+    int timestep)
+{
+  (void)timestep;
+  std::vector<std::map<std::string, Eigen::Vector3s>> jointCenters
+      = guessJointLocations(recentPointClouds);
+  assert(jointCenters.size() > 0);
+  return jointCenters.back();
+}
+
+//==============================================================================
+std::shared_ptr<dynamics::Skeleton> MarkerLabeller::getSkeleton()
+{
+  return mSkeleton;
+}
+
 //==============================================================================
 /// This takes in a set of labeled point clouds over time, and runs the
 /// labeller over unlabeled copies of those point clouds, and then scores the
@@ -1038,6 +1124,19 @@ MarkerLabellerMock::guessJointLocations(
   return mJointsOverTime;
 }
 
+//==============================================================================
+std::map<std::string, Eigen::Vector3s>
+MarkerLabellerMock::guessLatestJointLocations(
+    const std::vector<std::vector<Eigen::Vector3s>>& recentPointClouds,
+    int timestep)
+{
+  (void)recentPointClouds;
+  // This is a mock, so we just return the mocked value
+  if (timestep < 0 || timestep >= mJointsOverTime.size())
+    return std::map<std::string, Eigen::Vector3s>();
+  return mJointsOverTime[timestep];
+}
+
 //==============================================================================
 void MarkerLabellerMock::setMockJointLocations(
     std::vector<std::map<std::string, Eigen::Vector3s>> jointsOverTime)
@@ -1045,5 +1144,259 @@ void MarkerLabellerMock::setMockJointLocations(
   mJointsOverTime = jointsOverTime;
 }
 
+//==============================================================================
+StreamingMarkerLabeller::StreamingMarkerLabeller(
+    MarkerLabeller& labeller,
+    int latency,
+    int lookback,
+    s_t mergeDistance,
+    int mergeFrames,
+    s_t mergeMarkersThreshold)
+  : mLabeller(&labeller),
+    mLatency(std::max(0, latency)),
+    mLookback(std::max(lookback, std::max(0, latency) + 1)),
+    mMergeDistance(mergeDistance),
+    mMergeFrames(mergeFrames),
+    mMergeMarkersThreshold(mergeMarkersThreshold),
+    mFit(labeller.createJointCenterFit()),
+    mNextTimestep(0),
+    mNextEmitTimestep(0)
+{
+}
+
+//==============================================================================
+/// This adds the next frame of the stream. Labels for a frame are final once
+/// `latency` more frames have arrived after it, so this returns the frames
+/// that just became final, oldest first. That's one frame once the stream
+/// has filled up, and none before then.
+std::vector<std::map<std::string, Eigen::Vector3s>>
+StreamingMarkerLabeller::pushFrame(
+    const std::vector<Eigen::Vector3s>& pointCloud)
+{
+  const int t = mNextTimestep++;
+
+  // 1. Extend the traces with this frame's points
+  Frame frame;
+  frame.timestep = t;
+  frame.points = pointCloud;
+  frame.traces = MarkerTrace::appendPointCloud(
+      mTraces,
+      mActiveTraces,
+      t,
+      pointCloud,
+      mMergeDistance,
+      mMergeFrames);
+
+  // 2. Fit the skeleton to this frame's joint centers, guessed from the
+  // frames we still have in the window
+  std::vector<std::vector<Eigen::Vector3s>> recentPointClouds;
+  for (const Frame& recent : mFrames)
+  {
+    recentPointClouds.push_back(recent.points);
+  }
+  recentPointClouds.push_back(pointCloud);
+  mLabeller->fitJointCenters(
+      mFit,
+      mLabeller->guessLatestJointLocations(recentPointClouds, t),
+      frame.pose,
+      frame.scale);
+  mFrames.push_back(frame);
+
+  // 3. Emit every frame that's now `latency` frames old
+  std::vector<std::map<std::string, Eigen::Vector3s>> labelled;
+  while (mNextEmitTimestep <= t - mLatency)
+  {
+    labelled.push_back(emitFrame());
+  }
+
+  // 4. Forget everything that's fallen out of the lookback window
+  dropStaleData();
+
+  return labelled;
+}
+
+//==============================================================================
+/// This labels and returns every frame that's still waiting out its latency,
+/// for when the stream ends.
+std::vector<std::map<std::string, Eigen::Vector3s>>
+StreamingMarkerLabeller::flush()
+{
+  std::vector<std::map<std::string, Eigen::Vector3s>> labelled;
+  while (mNextEmitTimestep < mNextTimestep)
+  {
+    labelled.push_back(emitFrame());
+  }
+  dropStaleData();
+  return labelled;
+}
+
+//==============================================================================
+/// This returns the body and offset of every marker we've created so far
+const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+StreamingMarkerLabeller::getMarkerOffsets() const
+{
+  return mMarkers;
+}
+
+//==============================================================================
+/// This returns the number of traces we're still holding on to
+int StreamingMarkerLabeller::getNumTraces() const
+{
+  return mTraces.size();
+}
+
+//==============================================================================
+/// This returns the number of frames we're still holding on to
+int StreamingMarkerLabeller::getNumBufferedFrames() const
+{
+  return mFrames.size();
+}
+
+//==============================================================================
+/// This labels the oldest frame that we haven't emitted yet
+std::map<std::string, Eigen::Vector3s> StreamingMarkerLabeller::emitFrame()
+{
+  const int t = mNextEmitTimestep++;
+  assert(mFrames.size() > 0);
+  const Frame& frame = mFrames[t - mFrames.front().timestep];
+  assert(frame.timestep == t);
+
+  std::map<std::string, Eigen::Vector3s> labelled;
+  for (int i = 0; i < frame.traces.size(); i++)
+  {
+    MarkerTrace& trace = mTraces[frame.traces[i]];
+    // Once a trace has a label, it keeps it for as long as it lasts
+    if (trace.mMarkerLabel == "")
+    {
+      labelTrace(frame.traces[i]);
+    }
+    labelled[trace.mMarkerLabel] = frame.points[i];
+  }
+  return labelled;
+}
+
+//==============================================================================
+/// This picks a label for a trace, using the part of it inside the window
+void StreamingMarkerLabeller::labelTrace(int traceIndex)
+{
+  const MarkerTrace& trace = mTraces[traceIndex];
+  const int windowStart = mFrames.front().timestep;
+
+  // computeBodyMarkerStats() wants the poses indexed from 0, so we shift the
+  // windowed trace to match
+  std::vector<Eigen::VectorXs> poses;
+  std::vector<Eigen::VectorXs> scales;
+  for (const Frame& frame : mFrames)
+  {
+    poses.push_back(frame.pose);
+    scales.push_back(frame.scale);
+  }
+  std::unique_ptr<MarkerTrace> window;
+  for (int i = 0; i < trace.mTimes.size(); i++)
+  {
+    if (trace.mTimes[i] < windowStart)
+      continue;
+    if (window == nullptr)
+    {
+      window = std::make_unique<MarkerTrace>(
+          trace.mTimes[i] - windowStart, trace.mPoints[i]);
+    }
+    else
+    {
+      window->appendPoint(trace.mTimes[i] - windowStart, trace.mPoints[i]);
+    }
+  }
+  assert(window != nullptr);
+  window->computeBodyMarkerStats(mLabeller->getSkeleton(), poses, scales);
+
+  MarkerLabeller::assignMarkerLabel(
+      traceIndex,
+      mTraces,
+      window->getBestMarker(),
+      mMarkers,
+      mMergeMarkersThreshold);
+}
+
+//==============================================================================
+/// This forgets frames that are both emitted and out of the lookback window,
+/// traces that are finished, and trace points from before the window.
+void StreamingMarkerLabeller::dropStaleData()
+{
+  while (mFrames.size() > mLookback
+         && mFrames.front().timestep < mNextEmitTimestep)
+  {
+    mFrames.pop_front();
+  }
+  const int windowStart = mFrames.size() > 0 ? mFrames.front().timestep
+                                             : mNextEmitTimestep;
+
+  // 1. Compact the traces we still need to the front of `mTraces`
+  std::vector<int> newIndices(mTraces.size(), -1);
+  std::vector<bool> active(mTraces.size(), false);
+  for (int trace : mActiveTraces)
+  {
+    active[trace] = true;
+  }
+  int numKept = 0;
+  for (int i = 0; i < mTraces.size(); i++)
+  {
+    // Once a trace can't be extended and all its points are emitted, it ends
+    // before any trace we have left to label begins, so it can't stop them
+    // from sharing its label
+    if (!active[i] && mTraces[i].lastTimestep() < mNextEmitTimestep)
+    {
+      continue;
+    }
+    newIndices[i] = numKept;
+    if (numKept != i)
+    {
+      mTraces[numKept] = std::move(mTraces[i]);
+    }
+    numKept++;
+  }
+  if (numKept == mTraces.size())
+  {
+    trimTracePoints(windowStart);
+    return;
+  }
+  mTraces.erase(mTraces.begin() + numKept, mTraces.end());
+
+  // 2. Point everything that refers to traces at their new indices
+  for (int& trace : mActiveTraces)
+  {
+    trace = newIndices[trace];
+  }
+  for (Frame& frame : mFrames)
+  {
+    for (int& trace : frame.traces)
+    {
+      trace = newIndices[trace];
+    }
+  }
+  trimTracePoints(windowStart);
+}
+
+//==============================================================================
+/// This drops the points of long traces that come before the window. We keep
+/// the last two points regardless, so the trace can still extrapolate.
+void StreamingMarkerLabeller::trimTracePoints(int windowStart)
+{
+  for (MarkerTrace& trace : mTraces)
+  {
+    int numStale = 0;
+    while (numStale < (int)trace.mTimes.size() - 2
+           && trace.mTimes[numStale] < windowStart)
+    {
+      numStale++;
+    }
+    if (numStale > 0)
+    {
+      trace.mTimes.erase(trace.mTimes.begin(), trace.mTimes.begin() + numStale);
+      trace.mPoints.erase(
+          trace.mPoints.begin(), trace.mPoints.begin() + numStale);
+    }
+  }
+}
+
 } // namespace biomechanics
 } // namespace dart
\ No newline at end of file
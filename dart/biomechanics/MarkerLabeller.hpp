@@ -1,6 +1,7 @@
 #ifndef DART_BIOMECH_MARKERLABELLER_HPP_
 #define DART_BIOMECH_MARKERLABELLER_HPP_
 
+#include <deque>
 #include <functional>
 #include <memory>
 // #include <unordered_map>
@@ -59,6 +60,11 @@ public:
   /// timestep of the last point, of order up to 2)
   s_t pointToAppendDistance(int time, Eigen::Vector3s point, bool extrapolate);
 
+  /// This gives the point that pointToAppendDistance() measures from: the last
+  /// point, or an extrapolation of it to this timestep. The trace must not be
+  /// empty.
+  Eigen::Vector3s predictAppendPoint(int time, bool extrapolate);
+
   /// This merges point clouds over time, to create a set of raw MarkerTraces
   /// over time. These traces can then be intelligently merged using any desired
   /// algorithm.
@@ -67,6 +73,18 @@ public:
       s_t mergeDistance = 0.01,
       int mergeFrames = 5);
 
+  /// This adds one more point cloud onto a set of traces that's being built up
+  /// over time, which is one step of createRawTraces(). `activeTraces` holds
+  /// the indices of the traces that could still be extended, and is updated
+  /// in place. This returns the index of the trace each point was added to.
+  static std::vector<int> appendPointCloud(
+      std::vector<MarkerTrace>& traces,
+      std::vector<int>& activeTraces,
+      int t,
+      const std::vector<Eigen::Vector3s>& pointCloud,
+      s_t mergeDistance = 0.01,
+      int mergeFrames = 5);
+
   /// Each possible combination of (trace, body) can create a marker. So we can
   /// compute some summary statistics for each body we could assign this trace
   /// to.
@@ -109,6 +127,21 @@ struct LabelledMarkers
 class MarkerLabeller
 {
 public:
+  /// This holds everything we need to fit our skeleton to joint center
+  /// guesses one frame at a time, warm starting each frame from the last
+  struct JointCenterFit
+  {
+    std::shared_ptr<dynamics::Skeleton> skeletonBallJoints;
+    Eigen::VectorXs initialPos;
+    Eigen::VectorXs lowerBound;
+    Eigen::VectorXs upperBound;
+    Eigen::VectorXs jointCenterVec;
+    std::vector<std::string> jointNames;
+    std::vector<dynamics::Joint*> ballSkelJoints;
+    std::vector<dynamics::Joint*> skelJoints;
+    int numFramesFit;
+  };
+
   virtual ~MarkerLabeller();
 
   virtual std::vector<std::map<std::string, Eigen::Vector3s>>
@@ -116,6 +149,13 @@ public:
       const std::vector<std::vector<Eigen::Vector3s>>& pointClouds)
       = 0;
 
+  /// This guesses the joint centers for just the last of a window of recent
+  /// point clouds, which are the frames up to and including `timestep` in a
+  /// stream. By default this runs guessJointLocations() over the whole window.
+  virtual std::map<std::string, Eigen::Vector3s> guessLatestJointLocations(
+      const std::vector<std::vector<Eigen::Vector3s>>& recentPointClouds,
+      int timestep);
+
   /// This labels a sequence of unlabeled point clouds, using our joint center
   /// prediction.
   LabelledMarkers labelPointClouds(
@@ -124,6 +164,33 @@ public:
 
   void setSkeleton(std::shared_ptr<dynamics::Skeleton> skeleton);
 
+  std::shared_ptr<dynamics::Skeleton> getSkeleton();
+
+  /// This sets up everything we need to fit our skeleton to joint center
+  /// guesses, starting from the current pose of the skeleton
+  JointCenterFit createJointCenterFit();
+
+  /// This runs IK+scaling to match one frame of joint center guesses, warm
+  /// starting from the last frame `fit` was used on, and writes the resulting
+  /// pose and group scales of our skeleton into `pose` and `scale`.
+  void fitJointCenters(
+      JointCenterFit& fit,
+      const std::map<std::string, Eigen::Vector3s>& jointCenters,
+      Eigen::VectorXs& pose,
+      Eigen::VectorXs& scale);
+
+  /// This picks a label for `traces[traceIndex]`, given the best marker for
+  /// it. If there's already a marker on the same body within
+  /// `mergeMarkersThreshold` of it, and no other trace that overlaps this one
+  /// in time already has that label, we reuse that label. Otherwise we create
+  /// a new marker in `markers`.
+  static void assignMarkerLabel(
+      int traceIndex,
+      std::vector<MarkerTrace>& traces,
+      const std::pair<std::string, Eigen::Vector3s>& bestMarker,
+      std::map<std::string, std::pair<std::string, Eigen::Vector3s>>& markers,
+      s_t mergeMarkersThreshold);
+
   void matchUpJointToSkeletonJoint(
       std::string jointName, std::string skeletonJointName);
 
@@ -170,6 +237,10 @@ public:
   guessJointLocations(
       const std::vector<std::vector<Eigen::Vector3s>>& pointClouds);
 
+  virtual std::map<std::string, Eigen::Vector3s> guessLatestJointLocations(
+      const std::vector<std::vector<Eigen::Vector3s>>& recentPointClouds,
+      int timestep);
+
   void setMockJointLocations(
       std::vector<std::map<std::string, Eigen::Vector3s>> jointsOverTime);
 
@@ -177,6 +248,89 @@ protected:
   std::vector<std::map<std::string, Eigen::Vector3s>> mJointsOverTime;
 };
 
+/// This labels point clouds as they arrive, one frame at a time, rather than
+/// needing the whole sequence up front like
+/// MarkerLabeller::labelPointClouds(). Each frame's labels come out `latency`
+/// frames after it goes in, which gives new traces some frames to show which
+/// body they belong to. We only hold on to the last `lookback` frames, and
+/// the traces that still touch them, so memory stays bounded on long
+/// sessions.
+class StreamingMarkerLabeller
+{
+public:
+  /// The `labeller` must have its skeleton and joints set up already, and
+  /// must outlive this object.
+  StreamingMarkerLabeller(
+      MarkerLabeller& labeller,
+      int latency = 30,
+      int lookback = 120,
+      s_t mergeDistance = 0.01,
+      int mergeFrames = 5,
+      s_t mergeMarkersThreshold = 0.01);
+
+  /// This adds the next frame of the stream. Labels for a frame are final
+  /// once `latency` more frames have arrived after it, so this returns the
+  /// frames that just became final, oldest first. That's one frame once the
+  /// stream has filled up, and none before then.
+  std::vector<std::map<std::string, Eigen::Vector3s>> pushFrame(
+      const std::vector<Eigen::Vector3s>& pointCloud);
+
+  /// This labels and returns every frame that's still waiting out its
+  /// latency, for when the stream ends.
+  std::vector<std::map<std::string, Eigen::Vector3s>> flush();
+
+  /// This returns the body and offset of every marker we've created so far
+  const std::map<std::string, std::pair<std::string, Eigen::Vector3s>>&
+  getMarkerOffsets() const;
+
+  /// This returns the number of traces we're still holding on to
+  int getNumTraces() const;
+
+  /// This returns the number of frames we're still holding on to
+  int getNumBufferedFrames() const;
+
+protected:
+  struct Frame
+  {
+    int timestep;
+    std::vector<Eigen::Vector3s> points;
+    // The index in mTraces of the trace each point belongs to
+    std::vector<int> traces;
+    Eigen::VectorXs pose;
+    Eigen::VectorXs scale;
+  };
+
+  /// This labels the oldest frame that we haven't emitted yet
+  std::map<std::string, Eigen::Vector3s> emitFrame();
+
+  /// This picks a label for a trace, using the part of it inside the window
+  void labelTrace(int traceIndex);
+
+  /// This forgets frames that are both emitted and out of the lookback
+  /// window, traces that are finished, and trace points from before the
+  /// window.
+  void dropStaleData();
+
+  /// This drops the points of long traces that come before the window. We
+  /// keep the last two points regardless, so the trace can still extrapolate.
+  void trimTracePoints(int windowStart);
+
+  MarkerLabeller* mLabeller;
+  int mLatency;
+  int mLookback;
+  s_t mMergeDistance;
+  int mMergeFrames;
+  s_t mMergeMarkersThreshold;
+  MarkerLabeller::JointCenterFit mFit;
+
+  std::deque<Frame> mFrames;
+  std::vector<MarkerTrace> mTraces;
+  std::vector<int> mActiveTraces;
+  std::map<std::string, std::pair<std::string, Eigen::Vector3s>> mMarkers;
+  int mNextTimestep;
+  int mNextEmitTimestep;
+};
+
 } // namespace biomechanics
 } // namespace dart
 
@@ -1,5 +1,7 @@
 #include "dart/biomechanics/MarkerOffsetPrior.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "dart/math/Geometry.hpp"
@@ -105,20 +107,143 @@ void MarkerMovementSpace::debugToGUI(
   server->createSphere(mMarkerName, 0.01, bodyTransform * mMarkerOffset, color);
 }
 
+//==============================================================================
+MarkerOffsetKdTree::MarkerOffsetKdTree(
+    std::vector<std::pair<std::string, Eigen::Vector3s>> points)
+  : mPoints(points), mRoot(-1)
+{
+  std::vector<int> indices;
+  for (int i = 0; i < mPoints.size(); i++)
+  {
+    indices.push_back(i);
+  }
+  mNodes.reserve(mPoints.size());
+  mRoot = build(indices, 0, indices.size(), 0);
+}
+
+//==============================================================================
+/// This returns the name of the point closest to `query`, along with its
+/// distance from `query`. If the tree is empty, this returns an empty name
+/// and an infinite distance.
+std::pair<std::string, s_t> MarkerOffsetKdTree::findNearest(
+    const Eigen::Vector3s& query) const
+{
+  int best = -1;
+  s_t bestSquaredDist = std::numeric_limits<s_t>::infinity();
+  search(mRoot, query, best, bestSquaredDist);
+  if (best == -1)
+  {
+    return std::make_pair("", std::numeric_limits<s_t>::infinity());
+  }
+  return std::make_pair(mPoints[best].first, sqrt(bestSquaredDist));
+}
+
+//==============================================================================
+/// This returns the number of points in the tree
+int MarkerOffsetKdTree::getNumPoints() const
+{
+  return mPoints.size();
+}
+
+//==============================================================================
+/// This builds a subtree over `indices[begin, end)`, splitting on the median
+/// along `depth % 3`, and returns the index of its root in mNodes
+int MarkerOffsetKdTree::build(
+    std::vector<int>& indices, int begin, int end, int depth)
+{
+  if (begin >= end)
+    return -1;
+
+  int axis = depth % 3;
+  int mid = begin + (end - begin) / 2;
+  std::nth_element(
+      indices.begin() + begin,
+      indices.begin() + mid,
+      indices.begin() + end,
+      [&](int a, int b) {
+        return mPoints[a].second(axis) < mPoints[b].second(axis);
+      });
+
+  int node = mNodes.size();
+  mNodes.push_back(Node{indices[mid], axis, -1, -1});
+  int left = build(indices, begin, mid, depth + 1);
+  int right = build(indices, mid + 1, end, depth + 1);
+  // mNodes may have reallocated while building the children
+  mNodes[node].left = left;
+  mNodes[node].right = right;
+  return node;
+}
+
+//==============================================================================
+/// This updates `best` and `bestSquaredDist` with anything in the subtree at
+/// `node` closer to `query`, skipping subtrees that can't be closer
+void MarkerOffsetKdTree::search(
+    int node,
+    const Eigen::Vector3s& query,
+    int& best,
+    s_t& bestSquaredDist) const
+{
+  if (node == -1)
+    return;
+
+  const Node& n = mNodes[node];
+  const Eigen::Vector3s& point = mPoints[n.point].second;
+  s_t squaredDist = (point - query).squaredNorm();
+  if (squaredDist < bestSquaredDist)
+  {
+    bestSquaredDist = squaredDist;
+    best = n.point;
+  }
+
+  // Search the side of the split the query is on first, and then the other
+  // side only if the splitting plane is closer than the best point so far
+  s_t planeDist = query(n.axis) - point(n.axis);
+  int nearSide = planeDist < 0 ? n.left : n.right;
+  int farSide = planeDist < 0 ? n.right : n.left;
+  search(nearSide, query, best, bestSquaredDist);
+  if (planeDist * planeDist < bestSquaredDist)
+  {
+    search(farSide, query, best, bestSquaredDist);
+  }
+}
+
 //==============================================================================
 MarkerOffsetPrior::MarkerOffsetPrior(
     std::shared_ptr<dynamics::Skeleton> skeleton,
     dynamics::MarkerMap markersMap)
   : mSkeleton(skeleton), mMarkersMap(markersMap)
 {
+  std::map<std::string, std::vector<std::pair<std::string, Eigen::Vector3s>>>
+      bodyMarkers;
   for (auto& pair : markersMap)
   {
     mMarkerMovementSpaces.emplace(
         pair.first,
         MarkerMovementSpace(pair.first, pair.second.first, pair.second.second));
+    bodyMarkers[pair.second.first->getName()].emplace_back(
+        pair.first, pair.second.second);
+  }
+
+  for (auto& pair : bodyMarkers)
+  {
+    mBodyMarkerTrees.emplace(pair.first, MarkerOffsetKdTree(pair.second));
   }
 };
 
+//==============================================================================
+/// This returns the name of the prior's marker on `bodyNode` whose offset is
+/// closest to `offset` (in body space), along with how far away it is.
+std::pair<std::string, s_t> MarkerOffsetPrior::getNearestPriorMarker(
+    const dynamics::BodyNode* bodyNode, const Eigen::Vector3s& offset) const
+{
+  auto tree = mBodyMarkerTrees.find(bodyNode->getName());
+  if (tree == mBodyMarkerTrees.end())
+  {
+    return std::make_pair("", std::numeric_limits<s_t>::infinity());
+  }
+  return tree->second.findNearest(offset);
+}
+
 //==============================================================================
 /// This renders out the skeleton to the GUI, along with shapes representing
 /// the various inferred skin surfaces that the marker offset prior uses
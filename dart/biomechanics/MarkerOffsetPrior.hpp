@@ -5,6 +5,8 @@
 // #include <unordered_map>
 #include <map>
 #include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -58,6 +60,52 @@ public:
   Eigen::Vector3s mMarkerOffset;
 };
 
+/// This is a k-d tree over a set of named points, which the prior uses to
+/// find the closest of its markers on a body to a candidate offset without
+/// scanning every marker on that body
+class MarkerOffsetKdTree
+{
+public:
+  MarkerOffsetKdTree(
+      std::vector<std::pair<std::string, Eigen::Vector3s>> points);
+
+  /// This returns the name of the point closest to `query`, along with its
+  /// distance from `query`. If the tree is empty, this returns an empty name
+  /// and an infinite distance.
+  std::pair<std::string, s_t> findNearest(const Eigen::Vector3s& query) const;
+
+  /// This returns the number of points in the tree
+  int getNumPoints() const;
+
+protected:
+  struct Node
+  {
+    /// The index into mPoints of the point this node splits on
+    int point;
+    /// The axis this node splits on
+    int axis;
+    /// The indices into mNodes of the children, or -1 if there isn't one
+    int left;
+    int right;
+  };
+
+  /// This builds a subtree over `indices[begin, end)`, splitting on the
+  /// median along `depth % 3`, and returns the index of its root in mNodes
+  int build(std::vector<int>& indices, int begin, int end, int depth);
+
+  /// This updates `best` and `bestSquaredDist` with anything in the subtree
+  /// at `node` closer to `query`, skipping subtrees that can't be closer
+  void search(
+      int node,
+      const Eigen::Vector3s& query,
+      int& best,
+      s_t& bestSquaredDist) const;
+
+  std::vector<std::pair<std::string, Eigen::Vector3s>> mPoints;
+  std::vector<Node> mNodes;
+  int mRoot;
+};
+
 class MarkerOffsetPrior
 {
 public:
@@ -69,10 +117,20 @@ public:
   /// the various inferred skin surfaces that the marker offset prior uses
   void debugToGUI(std::shared_ptr<server::GUIWebsocketServer> server);
 
+  /// This returns the name of the prior's marker on `bodyNode` whose offset
+  /// is closest to `offset` (in body space), along with how far away it is.
+  /// This takes time logarithmic in the number of markers on the body. If the
+  /// prior has no markers on `bodyNode`, this returns an empty name and an
+  /// infinite distance.
+  std::pair<std::string, s_t> getNearestPriorMarker(
+      const dynamics::BodyNode* bodyNode, const Eigen::Vector3s& offset) const;
+
 protected:
   std::shared_ptr<dynamics::Skeleton> mSkeleton;
   dynamics::MarkerMap mMarkersMap;
   std::map<std::string, MarkerMovementSpace> mMarkerMovementSpaces;
+  /// The prior's markers on each body, keyed by body name
+  std::map<std::string, MarkerOffsetKdTree> mBodyMarkerTrees;
 };
 
 }; // namespace biomechanics
@@ -1,13 +1,20 @@
 #include "dart/biomechanics/OpenSimParser.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -49,6 +56,8 @@
 #include "dart/math/PiecewiseLinearFunction.hpp"
 #include "dart/math/PolynomialFunction.hpp"
 #include "dart/math/SimmSpline.hpp"
+#include "dart/utils/BufferedWriter.hpp"
+#include "dart/utils/CSVParser.hpp"
 #include "dart/utils/CompositeResourceRetriever.hpp"
 #include "dart/utils/DartResourceRetriever.hpp"
 #include "dart/utils/MJCFExporter.hpp"
@@ -142,6 +151,43 @@ common::ResourceRetrieverPtr ensureRetriever(
   }
 }
 
+//==============================================================================
+/// This calls `loadFile(i)` for every i in [0, numFiles), spread across
+/// `numThreads` threads. Files vary a lot in size, so rather than splitting
+/// the list up front, each thread just grabs the next file nobody has started
+/// on yet.
+void loadFilesInParallel(
+    int numFiles, int numThreads, const std::function<void(int)>& loadFile)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, numFiles));
+
+  std::atomic<int> nextFile(0);
+  std::vector<std::future<void>> futures;
+  for (int t = 0; t < numThreads; t++)
+  {
+    futures.push_back(
+        std::async(std::launch::async, [numFiles, &nextFile, &loadFile]() {
+          while (true)
+          {
+            const int i = nextFile++;
+            if (i >= numFiles)
+            {
+              return;
+            }
+            loadFile(i);
+          }
+        }));
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+}
+
 //==============================================================================
 Eigen::Vector2s readVec2(tinyxml2::XMLElement* elem)
 {
@@ -260,6 +306,90 @@ Eigen::Vector3s getAxisFlips(std::vector<Eigen::Vector3s> axisList)
   return vec;
 }
 
+namespace {
+
+/// This is a model that parseOsim() has already parsed. We keep the full file
+/// contents around, rather than trusting the hash alone, so that a hash
+/// collision can never hand back the wrong model.
+struct ParsedOsimCacheEntry
+{
+  std::string content;
+  std::string geometryFolder;
+  /// Models parsed without loading their meshes shouldn't be handed back to
+  /// callers that expect loaded meshes, and vice versa
+  dynamics::MeshShape::LoadingMode loadingMode;
+  OpenSimFile file;
+};
+
+const std::size_t MAX_PARSED_OSIM_CACHE_ENTRIES = 32;
+
+std::mutex gParsedOsimCacheMutex;
+bool gParsedOsimCacheEnabled = true;
+std::unordered_multimap<std::size_t, ParsedOsimCacheEntry> gParsedOsimCache;
+
+/// This makes a copy of a parsed file that doesn't share any mutable state
+/// with the original, so that callers can't change what's in the cache.
+OpenSimFile cloneParsedOsim(const OpenSimFile& file)
+{
+  OpenSimFile copy = file;
+  copy.skeleton = file.skeleton->cloneSkeleton();
+
+  // Scaling a body scales its meshes in place, so each clone needs its own
+  // shapes. The mesh data itself is immutable, and stays shared.
+  for (int i = 0; i < copy.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = copy.skeleton->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      dynamics::ShapeNode* shapeNode = body->getShapeNode(j);
+      shapeNode->setShape(shapeNode->getShape()->clone());
+    }
+  }
+
+  for (auto& pair : copy.markersMap)
+  {
+    pair.second.first
+        = copy.skeleton->getBodyNode(pair.second.first->getName());
+  }
+  return copy;
+}
+
+/// This adds the URI of every mesh under `element` to `uris`, resolved the
+/// same way readOsim30() and readOsim40() resolve them, so they can all be
+/// loaded in parallel before we build the skeleton. That covers <Mesh>
+/// elements (OpenSim 4) and <DisplayGeometry> elements (OpenSim 3).
+void collectGeometryUris(
+    tinyxml2::XMLElement* element,
+    const std::string& geometryFolder,
+    std::vector<std::string>& uris)
+{
+  for (tinyxml2::XMLElement* child = element->FirstChildElement();
+       child != nullptr;
+       child = child->NextSiblingElement())
+  {
+    const std::string name = child->Name();
+    tinyxml2::XMLElement* fileElement = nullptr;
+    if (name == "Mesh")
+      fileElement = child->FirstChildElement("mesh_file");
+    else if (name == "DisplayGeometry")
+      fileElement = child->FirstChildElement("geometry_file");
+
+    if (fileElement != nullptr && fileElement->GetText() != nullptr)
+    {
+      uris.push_back(common::Uri::createFromRelativeUri(
+                         geometryFolder,
+                         "./" + std::string(fileElement->GetText()) + ".ply")
+                         .toString());
+    }
+    else
+    {
+      collectGeometryUris(child, geometryFolder, uris);
+    }
+  }
+}
+
+} // namespace
+
 //==============================================================================
 OpenSimFile OpenSimParser::parseOsim(
     const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
@@ -271,11 +401,11 @@ OpenSimFile OpenSimParser::parseOsim(
   null_file.skeleton = nullptr;
 
   //--------------------------------------------------------------------------
-  // Load xml and create Document
-  tinyxml2::XMLDocument osimFile;
+  // Load the raw file, so we can check if we've already parsed it
+  std::string content;
   try
   {
-    openXMLFile(osimFile, uri, retriever);
+    content = retriever->readAll(uri);
   }
   catch (std::exception const& e)
   {
@@ -286,7 +416,86 @@ OpenSimFile OpenSimParser::parseOsim(
 
   common::Uri geometryURI
       = common::Uri::createFromRelativeUri(uri.toString(), "./Geometry/");
-  return parseOsim(osimFile, uri.toString(), geometryURI.toString(), retriever);
+  const std::string geometryFolder = geometryURI.toString();
+  const std::size_t hash = std::hash<std::string>()(content);
+
+  {
+    std::lock_guard<std::mutex> lock(gParsedOsimCacheMutex);
+    if (gParsedOsimCacheEnabled)
+    {
+      auto range = gParsedOsimCache.equal_range(hash);
+      for (auto it = range.first; it != range.second; ++it)
+      {
+        if (it->second.geometryFolder == geometryFolder
+            && it->second.loadingMode
+                   == dynamics::MeshShape::getDefaultLoadingMode()
+            && it->second.content == content)
+        {
+          return cloneParsedOsim(it->second.file);
+        }
+      }
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  // Create Document
+  tinyxml2::XMLDocument osimFile;
+  if (osimFile.Parse(content.c_str(), content.size()) != tinyxml2::XML_SUCCESS)
+  {
+    std::cout << "LoadFile [" << uri.toString()
+              << "] Fails: Failed parsing XML." << std::endl;
+    return null_file;
+  }
+
+  OpenSimFile result
+      = parseOsim(osimFile, uri.toString(), geometryFolder, retriever);
+  if (result.skeleton == nullptr)
+  {
+    return result;
+  }
+
+  std::lock_guard<std::mutex> lock(gParsedOsimCacheMutex);
+  if (gParsedOsimCacheEnabled)
+  {
+    if (gParsedOsimCache.size() >= MAX_PARSED_OSIM_CACHE_ENTRIES)
+    {
+      gParsedOsimCache.clear();
+    }
+    ParsedOsimCacheEntry entry;
+    entry.content = std::move(content);
+    entry.geometryFolder = geometryFolder;
+    entry.loadingMode = dynamics::MeshShape::getDefaultLoadingMode();
+    entry.file = cloneParsedOsim(result);
+    gParsedOsimCache.emplace(hash, std::move(entry));
+  }
+  return result;
+}
+
+//==============================================================================
+OpenSimFile OpenSimParser::parseOsimWithoutGeometry(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& retriever)
+{
+  dynamics::MeshShape::ScopedLoadingMode placeholders(
+      dynamics::MeshShape::LAZY);
+  return parseOsim(uri, retriever);
+}
+
+//==============================================================================
+void OpenSimParser::setParsedModelCacheEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(gParsedOsimCacheMutex);
+  gParsedOsimCacheEnabled = enabled;
+  if (!enabled)
+  {
+    gParsedOsimCache.clear();
+  }
+}
+
+//==============================================================================
+void OpenSimParser::clearParsedModelCache()
+{
+  std::lock_guard<std::mutex> lock(gParsedOsimCacheMutex);
+  gParsedOsimCache.clear();
 }
 
 //==============================================================================
@@ -321,6 +530,12 @@ OpenSimFile OpenSimParser::parseOsim(
   }
   tinyxml2::XMLElement* jointSet = modelElement->FirstChildElement("JointSet");
 
+  // Load all the meshes at once, so that building the skeleton below finds
+  // them already loaded
+  std::vector<std::string> geometryUris;
+  collectGeometryUris(modelElement, geometryFolder, geometryUris);
+  const dynamics::MeshPrefetch prefetch(geometryUris, geometryRetriever);
+
   OpenSimFile result;
   if (jointSet != nullptr)
   {
@@ -1989,7 +2204,10 @@ OpenSimTRC OpenSimParser::loadTRC(
       = ensureRetriever(nullOrRetriever);
 
   OpenSimTRC result;
-  const std::string content = retriever->readAll(uri);
+  // Map the file rather than reading it into a string, and then walk it with
+  // string_views, so we don't allocate for every line and token.
+  const utils::CSVParser::MappedFile file(uri, retriever);
+  const std::string_view content = file.getContents();
   double unitsMultiplier = 1.0;
 
   std::vector<std::string> markerNames;
@@ -2000,7 +2218,7 @@ OpenSimTRC OpenSimParser::loadTRC(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    std::string_view line = content.substr(start, end - start);
 
     std::map<std::string, Eigen::Vector3s> markerPositions;
     double timestamp = 0.0;
@@ -2011,7 +2229,8 @@ OpenSimTRC OpenSimParser::loadTRC(
     while (tokenStart != std::string::npos)
     {
       auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-      std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
+      std::string_view token
+          = line.substr(tokenStart, tokenEnd - tokenStart);
 
       /////////////////////////////////////////////////////////
       // Process the token, given tokenNumber and lineNumber
@@ -2037,13 +2256,13 @@ OpenSimTRC OpenSimParser::loadTRC(
       }
       else if (lineNumber == 3 && tokenNumber > 1)
       {
-        markerNames.push_back(token);
+        markerNames.emplace_back(token);
       }
       else if (lineNumber > 5)
       {
         if (tokenNumber == 1)
         {
-          timestamp = atof(token.c_str());
+          timestamp = utils::CSVParser::parseNumber(token);
         }
         else if (tokenNumber > 1)
         {
@@ -2051,7 +2270,8 @@ OpenSimTRC OpenSimParser::loadTRC(
               = tokenNumber - 2; // first two cols are "frame #" and "time"
           int markerNumber = (int)floor((double)offset / 3);
           int axisNumber = offset - (markerNumber * 3);
-          markerSwapSpace(axisNumber) = atof(token.c_str()) * unitsMultiplier;
+          markerSwapSpace(axisNumber)
+              = utils::CSVParser::parseNumber(token) * unitsMultiplier;
           if (axisNumber == 2)
           {
             if (!markerSwapSpace.hasNaN())
@@ -2124,7 +2344,8 @@ Frame#	Time	RASI			LASI			RPSI			LPSI			RLKN			RMKN			RTH1			RTH2			RTH3			LLKN
 void OpenSimParser::saveTRC(
     const std::string& outputPath,
     const std::vector<double>& timestamps,
-    const std::vector<std::map<std::string, Eigen::Vector3s>>& markerTimesteps)
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& markerTimesteps,
+    int numThreads)
 {
   std::vector<std::string> markerNames;
   for (auto& pair : markerTimesteps[0])
@@ -2132,8 +2353,7 @@ void OpenSimParser::saveTRC(
     markerNames.push_back(pair.first);
   }
 
-  std::ofstream trcFile;
-  trcFile.open(outputPath);
+  utils::BufferedWriter trcFile(outputPath);
   trcFile << "PathFileType\t4\t(X/Y/Z)\t" << outputPath << "\n";
   trcFile << "DataRate\tCameraRate\tNumFrames\tNumMarkers\tUnits\tOrigDataRate"
              "\tOrigDataStartFrame\tOrigNumFrames\n";
@@ -2156,22 +2376,23 @@ void OpenSimParser::saveTRC(
   }
   trcFile << "\n\n";
 
-  for (int t = 0; t < timestamps.size(); t++)
-  {
-    trcFile << (t + 1) << "\t";
-    trcFile << timestamps[t];
-    for (int i = 0; i < markerNames.size(); i++)
-    {
-      // We default to meters internally
-      Eigen::Vector3s p = markerTimesteps[t].count(markerNames[i]) > 0
-                              ? markerTimesteps[t].at(markerNames[i])
-                              : Eigen::Vector3s::Ones() * NAN;
-      trcFile << "\t" << p(0) << "\t" << p(1) << "\t" << p(2);
-    }
-    trcFile << "\n";
-  }
-
-  trcFile.close();
+  trcFile.writeRows(
+      timestamps.size(),
+      [&](int t, utils::TextBuffer& row) {
+        row << (t + 1) << "\t";
+        row << timestamps[t];
+        for (int i = 0; i < markerNames.size(); i++)
+        {
+          // We default to meters internally
+          auto marker = markerTimesteps[t].find(markerNames[i]);
+          Eigen::Vector3s p = marker != markerTimesteps[t].end()
+                                  ? marker->second
+                                  : Eigen::Vector3s::Ones() * NAN;
+          row << "\t" << p(0) << "\t" << p(1) << "\t" << p(2);
+        }
+        row << "\n";
+      },
+      numThreads);
 }
 
 //==============================================================================
@@ -2187,7 +2408,10 @@ OpenSimMot OpenSimParser::loadMot(
       = ensureRetriever(nullOrRetriever);
 
   OpenSimTRC result;
-  const std::string content = retriever->readAll(uri);
+  // Map the file rather than reading it into a string, and then walk it with
+  // string_views, so we don't allocate for every line and token.
+  const utils::CSVParser::MappedFile file(uri, retriever);
+  const std::string_view content = file.getContents();
   std::vector<int> columnToDof;
   std::vector<bool> rotationalDof;
 
@@ -2203,12 +2427,12 @@ OpenSimMot OpenSimParser::loadMot(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    std::string_view line = content.substr(start, end - start);
 
     // Trim '\r', in case this file was saved on a Windows machine
     if (line.size() > 0 && line[line.size() - 1] == '\r')
     {
-      line = line.substr(0, line.size() - 1);
+      line.remove_suffix(1);
     }
 
     if (inHeader)
@@ -2222,8 +2446,8 @@ OpenSimMot OpenSimParser::loadMot(
       auto tokenEnd = line.find("=");
       if (tokenEnd != std::string::npos)
       {
-        std::string variable = line.substr(0, tokenEnd);
-        std::string value
+        std::string_view variable = line.substr(0, tokenEnd);
+        std::string_view value
             = line.substr(tokenEnd + 1, line.size() - tokenEnd - 1);
         if (variable == "inDegrees")
         {
@@ -2241,7 +2465,8 @@ OpenSimMot OpenSimParser::loadMot(
       while (tokenStart != std::string::npos)
       {
         auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-        std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
+        std::string_view token
+            = line.substr(tokenStart, tokenEnd - tokenStart);
 
         /////////////////////////////////////////////////////////
         // Process the token, given tokenNumber and lineNumber
@@ -2252,7 +2477,7 @@ OpenSimMot OpenSimParser::loadMot(
           {
             // This means we're on the row defining the names of the joints
             // we're recording positions of
-            dynamics::DegreeOfFreedom* dof = skel->getDof(token);
+            dynamics::DegreeOfFreedom* dof = skel->getDof(std::string(token));
             bool isRotationalJoint = true;
             if (dof != nullptr)
             {
@@ -2282,7 +2507,7 @@ OpenSimMot OpenSimParser::loadMot(
         }
         else
         {
-          double value = atof(token.c_str());
+          double value = utils::CSVParser::parseNumber(token);
           if (tokenNumber == 0)
           {
             timestamp = value;
@@ -2415,10 +2640,10 @@ void OpenSimParser::saveMot(
     std::shared_ptr<dynamics::Skeleton> skel,
     const std::string& outputPath,
     const std::vector<double>& timestamps,
-    const Eigen::MatrixXs& poses)
+    const Eigen::MatrixXs& poses,
+    int numThreads)
 {
-  std::ofstream motFile;
-  motFile.open(outputPath);
+  utils::BufferedWriter motFile(outputPath);
   motFile << "Coordinates\n";
   motFile << "version=1\n";
   motFile << "nRows=" << timestamps.size() << "\n";
@@ -2439,17 +2664,18 @@ void OpenSimParser::saveMot(
   }
   motFile << "\n";
 
-  for (int t = 0; t < timestamps.size(); t++)
-  {
-    motFile << timestamps[t];
-    for (int i = 0; i < skel->getNumDofs(); i++)
-    {
-      motFile << "\t" << poses(i, t);
-    }
-    motFile << "\n";
-  }
-
-  motFile.close();
+  const int numDofs = skel->getNumDofs();
+  motFile.writeRows(
+      timestamps.size(),
+      [&](int t, utils::TextBuffer& row) {
+        row << timestamps[t];
+        for (int i = 0; i < numDofs; i++)
+        {
+          row << "\t" << poses(i, t);
+        }
+        row << "\n";
+      },
+      numThreads);
 }
 
 //==============================================================================
@@ -2459,10 +2685,10 @@ void OpenSimParser::saveIDMot(
     std::shared_ptr<dynamics::Skeleton> skel,
     const std::string& outputPath,
     const std::vector<double>& timestamps,
-    const Eigen::MatrixXs& controlForces)
+    const Eigen::MatrixXs& controlForces,
+    int numThreads)
 {
-  std::ofstream motFile;
-  motFile.open(outputPath);
+  utils::BufferedWriter motFile(outputPath);
   motFile << "Coordinates\n";
   motFile << "version=1\n";
   motFile << "nRows=" << timestamps.size() << "\n";
@@ -2491,17 +2717,18 @@ void OpenSimParser::saveIDMot(
   }
   motFile << "\n";
 
-  for (int t = 0; t < timestamps.size(); t++)
-  {
-    motFile << timestamps[t];
-    for (int i = 0; i < skel->getNumDofs(); i++)
-    {
-      motFile << "\t" << controlForces(i, t);
-    }
-    motFile << "\n";
-  }
-
-  motFile.close();
+  const int numDofs = skel->getNumDofs();
+  motFile.writeRows(
+      timestamps.size(),
+      [&](int t, utils::TextBuffer& row) {
+        row << timestamps[t];
+        for (int i = 0; i < numDofs; i++)
+        {
+          row << "\t" << controlForces(i, t);
+        }
+        row << "\n";
+      },
+      numThreads);
 }
 
 //==============================================================================
@@ -2520,10 +2747,10 @@ double zeroIfNan(double n)
 void OpenSimParser::saveRawGRFMot(
     const std::string& outputPath,
     const std::vector<double>& timestamps,
-    const std::vector<biomechanics::ForcePlate> forcePlates)
+    const std::vector<biomechanics::ForcePlate> forcePlates,
+    int numThreads)
 {
-  std::ofstream motFile;
-  motFile.open(outputPath);
+  utils::BufferedWriter motFile(outputPath);
   motFile << "nColumns=" << (9 * forcePlates.size()) + 1 << "\n";
   motFile << "nRows=" << timestamps.size() << "\n";
   motFile << "DataType=double\n";
@@ -2556,28 +2783,26 @@ void OpenSimParser::saveRawGRFMot(
   }
   motFile << "\n";
 
-  for (int t = 0; t < timestamps.size(); t++)
-  {
-    motFile << timestamps[t];
-    for (int i = 0; i < forcePlates.size(); i++)
-    {
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].forces[t](0));
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].forces[t](1));
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].forces[t](2));
-      motFile << "\t"
-              << zeroIfNan((double)forcePlates[i].centersOfPressure[t](0));
-      motFile << "\t"
-              << zeroIfNan((double)forcePlates[i].centersOfPressure[t](1));
-      motFile << "\t"
-              << zeroIfNan((double)forcePlates[i].centersOfPressure[t](2));
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].moments[t](0));
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].moments[t](1));
-      motFile << "\t" << zeroIfNan((double)forcePlates[i].moments[t](2));
-    }
-    motFile << "\n";
-  }
-
-  motFile.close();
+  motFile.writeRows(
+      timestamps.size(),
+      [&](int t, utils::TextBuffer& row) {
+        row << timestamps[t];
+        for (int i = 0; i < forcePlates.size(); i++)
+        {
+          const ForcePlate& plate = forcePlates[i];
+          row << "\t" << zeroIfNan((double)plate.forces[t](0));
+          row << "\t" << zeroIfNan((double)plate.forces[t](1));
+          row << "\t" << zeroIfNan((double)plate.forces[t](2));
+          row << "\t" << zeroIfNan((double)plate.centersOfPressure[t](0));
+          row << "\t" << zeroIfNan((double)plate.centersOfPressure[t](1));
+          row << "\t" << zeroIfNan((double)plate.centersOfPressure[t](2));
+          row << "\t" << zeroIfNan((double)plate.moments[t](0));
+          row << "\t" << zeroIfNan((double)plate.moments[t](1));
+          row << "\t" << zeroIfNan((double)plate.moments[t](2));
+        }
+        row << "\n";
+      },
+      numThreads);
 }
 
 //==============================================================================
@@ -2588,10 +2813,10 @@ void OpenSimParser::saveProcessedGRFMot(
     const std::vector<double>& timestamps,
     const std::vector<dynamics::BodyNode*> contactBodies,
     s_t groundHeight,
-    const Eigen::MatrixXs wrenches)
+    const Eigen::MatrixXs wrenches,
+    int numThreads)
 {
-  std::ofstream motFile;
-  motFile.open(outputPath);
+  utils::BufferedWriter motFile(outputPath);
   motFile << "nColumns=" << (9 * contactBodies.size()) + 1 << "\n";
   motFile << "nRows=" << timestamps.size() << "\n";
   motFile << "DataType=double\n";
@@ -2624,40 +2849,40 @@ void OpenSimParser::saveProcessedGRFMot(
   }
   motFile << "\n";
 
-  for (int t = 0; t < timestamps.size(); t++)
-  {
-    motFile << timestamps[t];
-    for (int i = 0; i < contactBodies.size(); i++)
-    {
-      Eigen::Vector6s worldWrench = wrenches.block<6, 1>(i * 6, t);
-      Eigen::Vector3s worldTau = worldWrench.head<3>();
-      Eigen::Vector3s worldF = worldWrench.tail<3>();
-      Eigen::Matrix3s crossF = math::makeSkewSymmetric(worldF);
-      Eigen::Vector3s rightSide = worldTau - crossF.col(1) * groundHeight;
-      Eigen::Matrix3s leftSide = -crossF;
-      leftSide.col(1) = worldF;
-      Eigen::Vector3s p
-          = leftSide.completeOrthogonalDecomposition().solve(rightSide);
-      s_t k = p(1);
-      p(1) = 0;
-      Eigen::Vector3s expectedTau = worldF * k;
-      Eigen::Vector3s cop = p;
-      cop(1) = groundHeight;
-
-      motFile << "\t" << zeroIfNan((double)worldF(0));
-      motFile << "\t" << zeroIfNan((double)worldF(1));
-      motFile << "\t" << zeroIfNan((double)worldF(2));
-      motFile << "\t" << zeroIfNan((double)cop(0));
-      motFile << "\t" << zeroIfNan((double)cop(1));
-      motFile << "\t" << zeroIfNan((double)cop(2));
-      motFile << "\t" << zeroIfNan((double)expectedTau(0));
-      motFile << "\t" << zeroIfNan((double)expectedTau(1));
-      motFile << "\t" << zeroIfNan((double)expectedTau(2));
-    }
-    motFile << "\n";
-  }
-
-  motFile.close();
+  motFile.writeRows(
+      timestamps.size(),
+      [&](int t, utils::TextBuffer& row) {
+        row << timestamps[t];
+        for (int i = 0; i < contactBodies.size(); i++)
+        {
+          Eigen::Vector6s worldWrench = wrenches.block<6, 1>(i * 6, t);
+          Eigen::Vector3s worldTau = worldWrench.head<3>();
+          Eigen::Vector3s worldF = worldWrench.tail<3>();
+          Eigen::Matrix3s crossF = math::makeSkewSymmetric(worldF);
+          Eigen::Vector3s rightSide = worldTau - crossF.col(1) * groundHeight;
+          Eigen::Matrix3s leftSide = -crossF;
+          leftSide.col(1) = worldF;
+          Eigen::Vector3s p
+              = leftSide.completeOrthogonalDecomposition().solve(rightSide);
+          s_t k = p(1);
+          p(1) = 0;
+          Eigen::Vector3s expectedTau = worldF * k;
+          Eigen::Vector3s cop = p;
+          cop(1) = groundHeight;
+
+          row << "\t" << zeroIfNan((double)worldF(0));
+          row << "\t" << zeroIfNan((double)worldF(1));
+          row << "\t" << zeroIfNan((double)worldF(2));
+          row << "\t" << zeroIfNan((double)cop(0));
+          row << "\t" << zeroIfNan((double)cop(1));
+          row << "\t" << zeroIfNan((double)cop(2));
+          row << "\t" << zeroIfNan((double)expectedTau(0));
+          row << "\t" << zeroIfNan((double)expectedTau(1));
+          row << "\t" << zeroIfNan((double)expectedTau(2));
+        }
+        row << "\n";
+      },
+      numThreads);
 }
 
 //==============================================================================
@@ -2770,6 +2995,35 @@ void OpenSimParser::saveMarkerLocationsMot(
   motFile.close();
 }
 
+//==============================================================================
+/// This loads a whole list of TRC files at once, spread across threads
+std::vector<OpenSimTRC> OpenSimParser::loadTRCBatch(
+    const std::vector<common::Uri>& uris,
+    int numThreads,
+    const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  std::vector<OpenSimTRC> results(uris.size());
+  loadFilesInParallel(uris.size(), numThreads, [&](int i) {
+    results[i] = loadTRC(uris[i], nullOrRetriever);
+  });
+  return results;
+}
+
+//==============================================================================
+/// This loads a whole list of GRF *.mot files at once, spread across threads
+std::vector<std::vector<ForcePlate>> OpenSimParser::loadGRFBatch(
+    const std::vector<common::Uri>& uris,
+    int targetFramesPerSecond,
+    int numThreads,
+    const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  std::vector<std::vector<ForcePlate>> results(uris.size());
+  loadFilesInParallel(uris.size(), numThreads, [&](int i) {
+    results[i] = loadGRF(uris[i], targetFramesPerSecond, nullOrRetriever);
+  });
+  return results;
+}
+
 //==============================================================================
 /// This grabs the GRF forces from a *.mot file
 std::vector<ForcePlate> OpenSimParser::loadGRF(
@@ -2781,7 +3035,10 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
       = ensureRetriever(nullOrRetriever);
 
   OpenSimGRF result;
-  const std::string content = retriever->readAll(uri);
+  // Map the file rather than reading it into a string, and then walk it with
+  // string_views, so we don't allocate for every line and token.
+  const utils::CSVParser::MappedFile file(uri, retriever);
+  const std::string_view content = file.getContents();
 
   bool inHeader = true;
 
@@ -2800,12 +3057,12 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
   auto end = content.find("\n");
   while (end != std::string::npos)
   {
-    std::string line = content.substr(start, end - start);
+    std::string_view line = content.substr(start, end - start);
 
     // Trim '\r', in case this file was saved on a Windows machine
     if (line.size() > 0 && line[line.size() - 1] == '\r')
     {
-      line = line.substr(0, line.size() - 1);
+      line.remove_suffix(1);
     }
 
     if (inHeader)
@@ -2819,8 +3076,8 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
       auto tokenEnd = line.find("=");
       if (tokenEnd != std::string::npos)
       {
-        std::string variable = line.substr(0, tokenEnd);
-        std::string value
+        std::string_view variable = line.substr(0, tokenEnd);
+        std::string_view value
             = line.substr(tokenEnd + 1, line.size() - tokenEnd - 1);
         // Currently we don't read anything from the variables
         (void)variable;
@@ -2846,18 +3103,19 @@ std::vector<ForcePlate> OpenSimParser::loadGRF(
       while (tokenStart != std::string::npos)
       {
         auto tokenEnd = line.find_first_of(whitespace, tokenStart + 1);
-        std::string token = line.substr(tokenStart, tokenEnd - tokenStart);
+        std::string_view token
+            = line.substr(tokenStart, tokenEnd - tokenStart);
 
         /////////////////////////////////////////////////////////
         // Process the token, given tokenNumber and lineNumber
 
         if (lineNumber == 0)
         {
-          colNames.push_back(token);
+          colNames.emplace_back(token);
         }
         else
         {
-          double value = atof(token.c_str());
+          double value = utils::CSVParser::parseNumber(token);
           if (tokenNumber == 0)
           {
             timestamp = value;
@@ -3269,6 +3527,10 @@ bool OpenSimParser::convertOsimToSDF(
     const std::string& outputPath,
     std::map<std::string, std::string> mergeBodiesInto)
 {
+  // We only write out references to the mesh files, so there's no need to
+  // load (and decode) the meshes themselves
+  dynamics::MeshShape::ScopedLoadingMode referenceMeshes(
+      dynamics::MeshShape::LAZY);
   OpenSimFile file = parseOsim(uri);
 
   std::shared_ptr<dynamics::Skeleton> simplified
@@ -3294,6 +3556,10 @@ bool OpenSimParser::convertOsimToMJCF(
     const std::string& outputPath,
     std::map<std::string, std::string> mergeBodiesInto)
 {
+  // We only write out references to the mesh files, so there's no need to
+  // load (and decode) the meshes themselves
+  dynamics::MeshShape::ScopedLoadingMode referenceMeshes(
+      dynamics::MeshShape::LAZY);
   OpenSimFile file = parseOsim(uri);
 
   std::shared_ptr<dynamics::Skeleton> simplified
@@ -3342,15 +3608,11 @@ void readAttachedGeometry(
 
     common::Uri meshUri = common::Uri::createFromRelativeUri(
         geometryFolder, "./" + mesh_file + ".ply");
-    std::shared_ptr<dynamics::SharedMeshWrapper> meshPtr
-        = dynamics::MeshShape::loadMesh(meshUri, geometryRetriever);
+    std::shared_ptr<dynamics::MeshShape> meshShape
+        = dynamics::MeshShape::createFromUri(scale, meshUri, geometryRetriever);
 
-    if (meshPtr)
+    if (meshShape)
     {
-      std::shared_ptr<dynamics::MeshShape> meshShape
-          = std::make_shared<dynamics::MeshShape>(
-              scale, meshPtr, meshUri, geometryRetriever);
-
       dynamics::ShapeNode* meshShapeNode
           = childBody->createShapeNodeWith<dynamics::VisualAspect>(meshShape);
 
@@ -4336,15 +4598,12 @@ std::pair<dynamics::Joint*, dynamics::BodyNode*> createJoint(
 
           common::Uri meshUri = common::Uri::createFromRelativeUri(
               geometryFolder, "./" + mesh_file + ".ply");
-          std::shared_ptr<dynamics::SharedMeshWrapper> meshPtr
-              = dynamics::MeshShape::loadMesh(meshUri, geometryRetriever);
+          std::shared_ptr<dynamics::MeshShape> meshShape
+              = dynamics::MeshShape::createFromUri(
+                  scale, meshUri, geometryRetriever);
 
-          if (meshPtr)
+          if (meshShape)
           {
-            std::shared_ptr<dynamics::MeshShape> meshShape
-                = std::make_shared<dynamics::MeshShape>(
-                    scale, meshPtr, meshUri, geometryRetriever);
-
             dynamics::ShapeNode* meshShapeNode
                 = childBody->createShapeNodeWith<dynamics::VisualAspect>(
                     meshShape);
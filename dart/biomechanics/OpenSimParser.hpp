@@ -75,10 +75,33 @@ class OpenSimParser
 {
 public:
   /// Read Skeleton from *.osim file
+  ///
+  /// Parsing a model is slow, so results are cached in memory, keyed on the
+  /// exact contents of the file and the Geometry folder. A repeat load of the
+  /// same model returns a fresh clone of the cached skeleton (with its own
+  /// copies of the shapes, so it can be scaled independently), and the
+  /// markers re-pointed at the clone's bodies.
   static OpenSimFile parseOsim(
       const common::Uri& uri,
       const common::ResourceRetrieverPtr& retriever = nullptr);
 
+  /// Same as parseOsim(uri, retriever), but without loading any of the
+  /// model's meshes. Each MeshShape is left as a placeholder holding just its
+  /// URI, which loads its mesh the first time anything needs it, like
+  /// rendering it to the GUI or asking for its bounding box. MarkerFitter and
+  /// DynamicsFitter never touch the geometry, so this is a much faster and
+  /// smaller way to load a model that's only going to be fit.
+  static OpenSimFile parseOsimWithoutGeometry(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This turns the parsed model cache used by parseOsim() on or off. It's on
+  /// by default. Turning it off also clears it.
+  static void setParsedModelCacheEnabled(bool enabled);
+
+  /// This drops every model in the parsed model cache used by parseOsim()
+  static void clearParsedModelCache();
+
   /// Read Skeleton from *.osim file
   static OpenSimFile parseOsim(
       tinyxml2::XMLDocument& osimFile,
@@ -196,12 +219,24 @@ public:
       const common::Uri& uri,
       const common::ResourceRetrieverPtr& retriever = nullptr);
 
-  /// This saves the *.trc file from a motion for the skeleton
+  /// This loads a whole list of TRC files at once, spread across
+  /// `numThreads` threads (values <= 0 mean use all the hardware threads).
+  /// The results come back in the same order as `uris`.
+  static std::vector<OpenSimTRC> loadTRCBatch(
+      const std::vector<common::Uri>& uris,
+      int numThreads = -1,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This saves the *.trc file from a motion for the skeleton. Like the other
+  /// save*() methods for tables, rows are formatted across `numThreads`
+  /// threads (or one per core, if that's 0 or less), and written through a
+  /// utils::BufferedWriter.
   static void saveTRC(
       const std::string& outputPath,
       const std::vector<double>& timestamps,
       const std::vector<std::map<std::string, Eigen::Vector3s>>&
-          markerTimesteps);
+          markerTimesteps,
+      int numThreads = -1);
 
   /// This grabs the joint angles from a *.mot file
   static OpenSimMot loadMot(
@@ -226,7 +261,8 @@ public:
       std::shared_ptr<dynamics::Skeleton> skel,
       const std::string& outputPath,
       const std::vector<double>& timestamps,
-      const Eigen::MatrixXs& poses);
+      const Eigen::MatrixXs& poses,
+      int numThreads = -1);
 
   /// This saves the *.mot file from the inverse dynamics solved for the
   /// skeleton
@@ -234,14 +270,16 @@ public:
       std::shared_ptr<dynamics::Skeleton> skel,
       const std::string& outputPath,
       const std::vector<double>& timestamps,
-      const Eigen::MatrixXs& controlForces);
+      const Eigen::MatrixXs& controlForces,
+      int numThreads = -1);
 
   /// This saves the *.mot file for the ground reaction forces we've read from
   /// a C3D file
   static void saveRawGRFMot(
       const std::string& outputPath,
       const std::vector<double>& timestamps,
-      const std::vector<biomechanics::ForcePlate> forcePlates);
+      const std::vector<biomechanics::ForcePlate> forcePlates,
+      int numThreads = -1);
 
   /// This saves the *.mot file for the ground reaction forces we've processed
   /// through our dynamics fitter.
@@ -250,7 +288,8 @@ public:
       const std::vector<double>& timestamps,
       const std::vector<dynamics::BodyNode*> contactBodies,
       s_t groundLevel,
-      const Eigen::MatrixXs wrenches);
+      const Eigen::MatrixXs wrenches,
+      int numThreads = -1);
 
   /// This saves the *.mot file with 3 columns for each body. This is
   /// basically only used for verifying consistency between Nimble and OpenSim.
@@ -275,6 +314,15 @@ public:
       int targetFramesPerSecond = 100,
       const common::ResourceRetrieverPtr& retriever = nullptr);
 
+  /// This loads a whole list of GRF *.mot files at once, spread across
+  /// `numThreads` threads (values <= 0 mean use all the hardware threads).
+  /// The results come back in the same order as `uris`.
+  static std::vector<std::vector<ForcePlate>> loadGRFBatch(
+      const std::vector<common::Uri>& uris,
+      int targetFramesPerSecond = 100,
+      int numThreads = -1,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
   /// When people finish preparing their model in OpenSim, they save a *.osim
   /// file with all the scales and offsets baked in. This is a utility to go
   /// through and get out the scales and offsets in terms of a standard
@@ -286,6 +334,8 @@ public:
   /// This does its best to convert a *.osim file to an SDF file. It will
   /// simplify the skeleton by merging any bodies that are requested, and
   /// deleting any joints linking those bodies.
+  /// Meshes are written out as references to their files, so this never
+  /// loads them.
   static bool convertOsimToSDF(
       const common::Uri& uri,
       const std::string& outputPath,
@@ -294,6 +344,8 @@ public:
   /// This does its best to convert a *.osim file to an MJCF file. It will
   /// simplify the skeleton by merging any bodies that are requested, and
   /// deleting any joints linking those bodies.
+  /// Meshes are written out as references to their files, so this never
+  /// loads them.
   static bool convertOsimToMJCF(
       const common::Uri& uri,
       const std::string& outputPath,
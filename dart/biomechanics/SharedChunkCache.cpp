@@ -0,0 +1,393 @@
+#include "dart/biomechanics/SharedChunkCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dart {
+namespace biomechanics {
+
+namespace {
+
+/// Written last when a segment is created, so other processes know it's ready
+constexpr uint64_t SEGMENT_MAGIC = 0x4e494d4243484b31ULL;
+
+/// The number of slots in each set
+constexpr std::size_t SET_WAYS = 8;
+
+/// Slots are cache line aligned, so writers to neighbouring slots don't fight
+constexpr std::size_t ALIGNMENT = 64;
+
+/// How long to wait for another process to finish creating a segment
+constexpr int CREATE_TIMEOUT_MS = 10000;
+
+std::size_t roundUp(std::size_t bytes, std::size_t multiple)
+{
+  return ((bytes + multiple - 1) / multiple) * multiple;
+}
+
+/// This is FNV-1a, continuing from `hash`
+uint64_t hashBytes(uint64_t hash, const void* data, std::size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+/// This is the splitmix64 finalizer, which spreads FNV's weak low bits out
+uint64_t mix(uint64_t hash)
+{
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+} // namespace
+
+struct SharedChunkCache::SegmentHeader
+{
+  std::atomic<uint64_t> magic;
+  uint64_t numSlots;
+  uint64_t slotBytes;
+  std::atomic<uint64_t> clock;
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+};
+
+struct SharedChunkCache::SlotHeader
+{
+  // Odd while a writer owns the slot
+  std::atomic<uint64_t> sequence;
+  std::atomic<uint64_t> hash1;
+  std::atomic<uint64_t> hash2;
+  // 0 if the slot has never held anything
+  std::atomic<uint64_t> numValues;
+  // The segment's clock when this slot was last written or read
+  std::atomic<uint64_t> lastUsed;
+};
+
+static_assert(
+    std::atomic<uint64_t>::is_always_lock_free,
+    "SharedChunkCache needs lock free 64-bit atomics to share them between "
+    "processes");
+
+/// This opens the segment called `name`, creating it if it doesn't exist yet
+SharedChunkCache::SharedChunkCache(
+    const std::string& name, std::size_t sizeBytes, std::size_t slotBytes)
+  : mName(name),
+    mData(nullptr),
+    mMappedBytes(0),
+    mHeader(nullptr),
+    mSlotStride(0)
+{
+  const std::size_t headerBytes = roundUp(sizeof(SegmentHeader), ALIGNMENT);
+  bool created = true;
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd == -1 && errno == EEXIST)
+  {
+    created = false;
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+  }
+  if (fd == -1)
+  {
+    std::cout << "SharedChunkCache failed to open shared memory segment "
+              << name << ": " << strerror(errno)
+              << ". Nothing will be cached." << std::endl;
+    return;
+  }
+
+  std::size_t totalBytes = 0;
+  if (created)
+  {
+    slotBytes = roundUp(std::max<std::size_t>(slotBytes, 1), ALIGNMENT);
+    const std::size_t stride
+        = roundUp(sizeof(SlotHeader), ALIGNMENT) + slotBytes;
+    const std::size_t numSlots
+        = roundUp(std::max<std::size_t>(sizeBytes / stride, 1), SET_WAYS);
+    totalBytes = headerBytes + numSlots * stride;
+    // The new pages are all zeros, which is an empty slot
+    if (ftruncate(fd, totalBytes) == -1)
+    {
+      std::cout << "SharedChunkCache failed to size shared memory segment "
+                << name << " to " << totalBytes << " bytes: "
+                << strerror(errno) << ". Nothing will be cached."
+                << std::endl;
+      close(fd);
+      shm_unlink(name.c_str());
+      return;
+    }
+  }
+  else
+  {
+    // The creator sizes the segment right after creating it, so wait for that
+    auto start = std::chrono::steady_clock::now();
+    struct stat info;
+    info.st_size = 0;
+    while (fstat(fd, &info) == 0 && info.st_size == 0
+           && std::chrono::steady_clock::now() - start
+                  < std::chrono::milliseconds(CREATE_TIMEOUT_MS))
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    totalBytes = info.st_size;
+    if (totalBytes < headerBytes)
+    {
+      std::cout << "SharedChunkCache found shared memory segment " << name
+                << " was never set up. Nothing will be cached." << std::endl;
+      close(fd);
+      return;
+    }
+  }
+
+  void* data
+      = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the segment is closed
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    std::cout << "SharedChunkCache failed to map shared memory segment "
+              << name << ". Nothing will be cached." << std::endl;
+    return;
+  }
+  mData = static_cast<char*>(data);
+  mMappedBytes = totalBytes;
+  mHeader = reinterpret_cast<SegmentHeader*>(mData);
+
+  if (created)
+  {
+    mHeader->slotBytes = slotBytes;
+    mHeader->numSlots
+        = (totalBytes - headerBytes)
+          / (roundUp(sizeof(SlotHeader), ALIGNMENT) + slotBytes);
+    mHeader->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+  }
+  else
+  {
+    auto start = std::chrono::steady_clock::now();
+    while (mHeader->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC)
+    {
+      if (std::chrono::steady_clock::now() - start
+          > std::chrono::milliseconds(CREATE_TIMEOUT_MS))
+      {
+        std::cout << "SharedChunkCache found shared memory segment " << name
+                  << " was never set up. Nothing will be cached."
+                  << std::endl;
+        munmap(mData, mMappedBytes);
+        mData = nullptr;
+        mHeader = nullptr;
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  mSlotStride = roundUp(sizeof(SlotHeader), ALIGNMENT) + mHeader->slotBytes;
+}
+
+/// This unmaps the segment, but leaves it in place for other processes
+SharedChunkCache::~SharedChunkCache()
+{
+  if (mData != nullptr)
+  {
+    munmap(mData, mMappedBytes);
+  }
+}
+
+/// This removes the segment called `name`
+bool SharedChunkCache::unlink(const std::string& name)
+{
+  return shm_unlink(name.c_str()) == 0;
+}
+
+/// This returns the key for one chunk of one trial of a file
+SharedChunkCache::Key SharedChunkCache::makeKey(
+    const std::string& path,
+    int trial,
+    int chunk,
+    const std::vector<std::string>& channels)
+{
+  // The two hashes start from different offsets, so they're independent
+  auto hashKey = [&](uint64_t hash) {
+    hash = hashBytes(hash, path.data(), path.size() + 1);
+    hash = hashBytes(hash, &trial, sizeof(trial));
+    hash = hashBytes(hash, &chunk, sizeof(chunk));
+    for (const std::string& channel : channels)
+    {
+      hash = hashBytes(hash, channel.data(), channel.size() + 1);
+    }
+    return mix(hash);
+  };
+
+  Key key;
+  key.hash1 = hashKey(0xcbf29ce484222325ULL);
+  key.hash2 = hashKey(0x84222325cbf29ce4ULL);
+  return key;
+}
+
+/// Returns false if the segment couldn't be opened
+bool SharedChunkCache::isOpen() const
+{
+  return mHeader != nullptr;
+}
+
+/// This copies the chunk stored under `key` into `values`, if it's cached
+bool SharedChunkCache::get(const Key& key, std::vector<double>& values)
+{
+  if (mHeader == nullptr)
+  {
+    return false;
+  }
+
+  const std::size_t setStart = getSetStart(key);
+  for (std::size_t way = 0; way < SET_WAYS; way++)
+  {
+    SlotHeader* slot = getSlot(setStart + way);
+    const uint64_t before = slot->sequence.load(std::memory_order_acquire);
+    if (before % 2 == 1
+        || slot->hash1.load(std::memory_order_relaxed) != key.hash1
+        || slot->hash2.load(std::memory_order_relaxed) != key.hash2)
+    {
+      continue;
+    }
+    const uint64_t numValues = slot->numValues.load(std::memory_order_relaxed);
+    if (numValues == 0 || numValues * sizeof(double) > mHeader->slotBytes)
+    {
+      continue;
+    }
+
+    std::vector<double> copied(numValues);
+    std::memcpy(
+        copied.data(),
+        reinterpret_cast<const char*>(slot)
+            + roundUp(sizeof(SlotHeader), ALIGNMENT),
+        numValues * sizeof(double));
+    // If a writer claimed the slot while we were copying, what we have may be
+    // torn, so throw it away
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->sequence.load(std::memory_order_relaxed) != before)
+    {
+      continue;
+    }
+
+    slot->lastUsed.store(
+        mHeader->clock.fetch_add(1, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    mHeader->hits.fetch_add(1, std::memory_order_relaxed);
+    values.swap(copied);
+    return true;
+  }
+
+  mHeader->misses.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+/// This stores `numValues` doubles under `key`, if there's room
+bool SharedChunkCache::put(
+    const Key& key, const double* values, std::size_t numValues)
+{
+  if (mHeader == nullptr || numValues == 0
+      || numValues * sizeof(double) > mHeader->slotBytes)
+  {
+    return false;
+  }
+
+  // Pick an empty slot if there is one, or else the least recently used
+  const std::size_t setStart = getSetStart(key);
+  SlotHeader* victim = nullptr;
+  uint64_t victimLastUsed = 0;
+  for (std::size_t way = 0; way < SET_WAYS; way++)
+  {
+    SlotHeader* slot = getSlot(setStart + way);
+    if (slot->hash1.load(std::memory_order_relaxed) == key.hash1
+        && slot->hash2.load(std::memory_order_relaxed) == key.hash2
+        && slot->numValues.load(std::memory_order_relaxed) > 0)
+    {
+      return false;
+    }
+    if (slot->numValues.load(std::memory_order_relaxed) == 0)
+    {
+      victim = slot;
+      break;
+    }
+    const uint64_t lastUsed = slot->lastUsed.load(std::memory_order_relaxed);
+    if (victim == nullptr || lastUsed < victimLastUsed)
+    {
+      victim = slot;
+      victimLastUsed = lastUsed;
+    }
+  }
+
+  uint64_t sequence = victim->sequence.load(std::memory_order_relaxed);
+  if (sequence % 2 == 1
+      || !victim->sequence.compare_exchange_strong(
+          sequence, sequence + 1, std::memory_order_acquire))
+  {
+    return false;
+  }
+
+  victim->hash1.store(key.hash1, std::memory_order_relaxed);
+  victim->hash2.store(key.hash2, std::memory_order_relaxed);
+  victim->numValues.store(numValues, std::memory_order_relaxed);
+  std::memcpy(
+      reinterpret_cast<char*>(victim) + roundUp(sizeof(SlotHeader), ALIGNMENT),
+      values,
+      numValues * sizeof(double));
+  victim->lastUsed.store(
+      mHeader->clock.fetch_add(1, std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  victim->sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+/// This returns the number of slots in the segment
+std::size_t SharedChunkCache::getNumSlots() const
+{
+  return mHeader == nullptr ? 0 : mHeader->numSlots;
+}
+
+/// This returns the largest number of bytes a single chunk can take up
+std::size_t SharedChunkCache::getSlotBytes() const
+{
+  return mHeader == nullptr ? 0 : mHeader->slotBytes;
+}
+
+/// This returns the number of calls to get() that found their chunk
+uint64_t SharedChunkCache::getNumHits() const
+{
+  return mHeader == nullptr ? 0 : mHeader->hits.load();
+}
+
+/// This returns the number of calls to get() that didn't find their chunk
+uint64_t SharedChunkCache::getNumMisses() const
+{
+  return mHeader == nullptr ? 0 : mHeader->misses.load();
+}
+
+/// This returns the header of slot `slot`
+SharedChunkCache::SlotHeader* SharedChunkCache::getSlot(std::size_t slot) const
+{
+  return reinterpret_cast<SlotHeader*>(
+      mData + roundUp(sizeof(SegmentHeader), ALIGNMENT) + slot * mSlotStride);
+}
+
+/// This returns the index of the first slot in the set `key` belongs to
+std::size_t SharedChunkCache::getSetStart(const Key& key) const
+{
+  return (key.hash1 % (mHeader->numSlots / SET_WAYS)) * SET_WAYS;
+}
+
+} // namespace biomechanics
+} // namespace dart
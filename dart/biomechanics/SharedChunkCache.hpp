@@ -0,0 +1,112 @@
+#ifndef BIOMECH_SHARED_CHUNK_CACHE
+#define BIOMECH_SHARED_CHUNK_CACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dart {
+namespace biomechanics {
+
+/**
+ * This is a cache of decoded chunks that lives in a named POSIX shared memory
+ * segment, so every process on a machine that opens the same name shares it.
+ * That's meant for PyTorch DataLoader workers, which otherwise each decode
+ * (and hold in memory) their own copy of the same chunks.
+ *
+ * The segment is split into fixed size slots, grouped into small sets. A
+ * chunk can only live in one set (picked by hashing its key), and replaces
+ * the least recently used slot in that set. Nothing ever takes a lock: each
+ * slot has a sequence number that's odd while someone is writing it, readers
+ * check it didn't change while they copied the slot out, and a writer that
+ * loses the race to claim a slot just doesn't cache its chunk. If a process
+ * dies part way through writing a slot, that slot stays unusable until the
+ * segment is unlinked.
+ *
+ * Chunks bigger than a slot are never cached.
+ */
+class SharedChunkCache
+{
+public:
+  /// A chunk is identified by two independent 64-bit hashes, so collisions
+  /// aren't worth worrying about
+  struct Key
+  {
+    uint64_t hash1;
+    uint64_t hash2;
+  };
+
+  /// This opens the segment called `name` (which should start with a "/"),
+  /// creating it with room for `sizeBytes` of slots of `slotBytes` each if it
+  /// doesn't exist yet. If it does exist, the sizes it was created with are
+  /// used instead. If the segment can't be opened, this prints an error, and
+  /// the cache never holds anything.
+  SharedChunkCache(
+      const std::string& name,
+      std::size_t sizeBytes = (std::size_t)1 << 30,
+      std::size_t slotBytes = (std::size_t)1 << 20);
+
+  /// This unmaps the segment, but leaves it in place for other processes
+  ~SharedChunkCache();
+
+  SharedChunkCache(const SharedChunkCache&) = delete;
+  SharedChunkCache& operator=(const SharedChunkCache&) = delete;
+
+  /// This removes the segment called `name`. Processes that already have it
+  /// open keep using it, and it's freed once they've all closed it. Returns
+  /// false if there was no such segment.
+  static bool unlink(const std::string& name);
+
+  /// This returns the key for the chunk `chunk` of `trial` in the file at
+  /// `path`, read with `channels`
+  static Key makeKey(
+      const std::string& path,
+      int trial,
+      int chunk,
+      const std::vector<std::string>& channels);
+
+  /// Returns false if the segment couldn't be opened
+  bool isOpen() const;
+
+  /// This copies the chunk stored under `key` into `values`, and returns
+  /// true, or returns false (leaving `values` alone) if it isn't cached
+  bool get(const Key& key, std::vector<double>& values);
+
+  /// This stores `numValues` doubles under `key`. Returns false if the chunk
+  /// didn't get cached, because it's too big for a slot, it's already cached,
+  /// or another process was writing the slot it would have gone in.
+  bool put(const Key& key, const double* values, std::size_t numValues);
+
+  /// This returns the number of slots in the segment
+  std::size_t getNumSlots() const;
+
+  /// This returns the largest number of bytes a single chunk can take up
+  std::size_t getSlotBytes() const;
+
+  /// These return the number of calls to get() that found (or didn't find)
+  /// their chunk, summed over every process using the segment
+  uint64_t getNumHits() const;
+  uint64_t getNumMisses() const;
+
+protected:
+  struct SegmentHeader;
+  struct SlotHeader;
+
+  /// This returns the header of slot `slot`
+  SlotHeader* getSlot(std::size_t slot) const;
+
+  /// This returns the index of the first slot in the set `key` belongs to
+  std::size_t getSetStart(const Key& key) const;
+
+  std::string mName;
+  char* mData;
+  std::size_t mMappedBytes;
+  SegmentHeader* mHeader;
+  std::size_t mSlotStride;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -1,8 +1,11 @@
 #include "dart/biomechanics/SkeletonConverter.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 
 namespace dart {
@@ -449,6 +452,278 @@ Eigen::MatrixXs SkeletonConverter::convertMotion(
   return sourceMotion;
 }
 
+//==============================================================================
+/// This converts a motion from the target skeleton to the source skeleton,
+/// like convertMotion(), but splits the motion into chunks of `chunkSize`
+/// frames and converts the chunks in parallel.
+Eigen::MatrixXs SkeletonConverter::convertMotionParallel(
+    Eigen::MatrixXs targetMotion,
+    int chunkSize,
+    int numThreads,
+    bool useLinearization,
+    s_t linearizationTolerance,
+    bool logProgress,
+    ////// IK options
+    s_t convergenceThreshold,
+    int maxStepCount,
+    s_t leastSquaresDamping,
+    bool lineSearch,
+    bool logOutput)
+{
+  const int numFrames = targetMotion.cols();
+  Eigen::MatrixXs sourceMotion
+      = Eigen::MatrixXs::Zero(mSourceSkeleton->getNumDofs(), numFrames);
+  if (numFrames == 0)
+  {
+    return sourceMotion;
+  }
+  if (logProgress)
+  {
+    std::cout << "Converting " << numFrames << " timesteps..." << std::endl;
+  }
+
+  chunkSize = std::max(1, chunkSize);
+  const int numChunks = (numFrames + chunkSize - 1) / chunkSize;
+  if (numThreads <= 0)
+  {
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, numChunks));
+
+  Eigen::VectorXs originalSource = mSourceSkeleton->getPositions();
+  Eigen::VectorXs originalTarget = mTargetSkeleton->getPositions();
+
+  // Get a starting point for each chunk. This is the only serial part, and
+  // each fit is warm started from the chunk before it.
+  Eigen::MatrixXs chunkStarts
+      = Eigen::MatrixXs::Zero(mSourceSkeleton->getNumDofs(), numChunks);
+  for (int chunk = 0; chunk < numChunks; chunk++)
+  {
+    mTargetSkeleton->setPositions(targetMotion.col(chunk * chunkSize));
+    fitSourceToTarget(
+        convergenceThreshold,
+        maxStepCount,
+        leastSquaresDamping,
+        lineSearch,
+        logOutput);
+    chunkStarts.col(chunk) = mSourceSkeleton->getPositions();
+  }
+
+  auto convertChunks = [&](SkeletonConverter* converter, int threadIdx) {
+    for (int chunk = threadIdx; chunk < numChunks; chunk += numThreads)
+    {
+      int start = chunk * chunkSize;
+      int end = std::min(numFrames, start + chunkSize);
+      converter->mSourceSkeleton->setPositions(chunkStarts.col(chunk));
+      converter->convertMotionChunk(
+          targetMotion,
+          start,
+          end,
+          sourceMotion,
+          useLinearization,
+          linearizationTolerance,
+          convergenceThreshold,
+          maxStepCount,
+          leastSquaresDamping,
+          lineSearch,
+          logOutput);
+      if (logProgress)
+      {
+        std::cout << "Converted frames [" << start << "," << end << ")"
+                  << std::endl;
+      }
+    }
+  };
+
+  if (numThreads == 1)
+  {
+    convertChunks(this, 0);
+  }
+  else
+  {
+    // Each thread gets its own copy of the converter, which we have to make
+    // here on the main thread, since cloning reads from our skeletons
+    std::vector<std::shared_ptr<SkeletonConverter>> converters;
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+      converters.push_back(cloneForThread());
+    }
+    std::vector<common::TaskFuture<void>> futures;
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+      SkeletonConverter* converter = converters[threadIdx].get();
+      futures.push_back(
+          common::async([&convertChunks, converter, threadIdx] {
+            convertChunks(converter, threadIdx);
+          }));
+    }
+    for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+    {
+      futures[threadIdx].get();
+    }
+  }
+
+  mSourceSkeleton->setPositions(originalSource);
+  mTargetSkeleton->setPositions(originalTarget);
+
+  if (logProgress)
+  {
+    std::cout << "Finished converting " << numFrames << " timesteps!"
+              << std::endl;
+  }
+
+  return sourceMotion;
+}
+
+//==============================================================================
+/// This creates a copy of this converter that runs on clones of our
+/// skeletons, so that it can run IK on another thread without touching our
+/// skeletons.
+std::shared_ptr<SkeletonConverter> SkeletonConverter::cloneForThread() const
+{
+  std::shared_ptr<SkeletonConverter> clone
+      = std::make_shared<SkeletonConverter>(
+          mSourceSkeleton->cloneSkeleton(), mTargetSkeleton->cloneSkeleton());
+  // The ball joint skeleton is converted fresh from the (scaled) source, so
+  // we need to carry over the scales, like rescaleAndPrepTarget() does
+  for (int i = 0; i < mSourceSkeleton->getNumBodyNodes(); i++)
+  {
+    clone->mSourceSkeletonBallJoints->getBodyNode(i)->setScale(
+        mSourceSkeleton->getBodyNode(i)->getScale());
+  }
+
+  for (int i = 0; i < mSourceJoints.size(); i++)
+  {
+    clone->linkJoints(
+        clone->mSourceSkeleton->getJoint(
+            mSourceJoints[i]->getJointIndexInSkeleton()),
+        clone->mTargetSkeleton->getJoint(
+            mTargetJoints[i]->getJointIndexInSkeleton()));
+  }
+
+  auto remapMarkers
+      = [](const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+               markers,
+           const dynamics::SkeletonPtr& skel) {
+          std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> remapped;
+          for (auto& pair : markers)
+          {
+            remapped.emplace_back(
+                skel->getBodyNode(pair.first->getIndexInSkeleton()),
+                pair.second);
+          }
+          return remapped;
+        };
+  clone->mSourceMarkers = remapMarkers(mSourceMarkers, clone->mSourceSkeleton);
+  clone->mSourceMarkersBallJoints = remapMarkers(
+      mSourceMarkersBallJoints, clone->mSourceSkeletonBallJoints);
+  clone->mTargetMarkers = remapMarkers(mTargetMarkers, clone->mTargetSkeleton);
+  clone->mMarkerWeights = mMarkerWeights;
+  return clone;
+}
+
+//==============================================================================
+/// This returns the weighted sum of squared distances between the source and
+/// target markers, at the current positions of the source ball-joint skeleton
+/// and the target skeleton.
+s_t SkeletonConverter::getBallJointMarkerError()
+{
+  Eigen::VectorXs diff = mSourceSkeletonBallJoints->getMarkerWorldPositions(
+                             mSourceMarkersBallJoints)
+                         - getTargetMarkerWorldPositions();
+  s_t error = 0.0;
+  for (int i = 0; i < mSourceMarkersBallJoints.size(); i++)
+  {
+    error += mMarkerWeights(i) * diff.segment<3>(i * 3).squaredNorm();
+  }
+  return error;
+}
+
+//==============================================================================
+/// This converts frames [start, end) of `targetMotion` into the matching
+/// columns of `sourceMotion`, tracking from the source skeleton's current
+/// positions.
+void SkeletonConverter::convertMotionChunk(
+    const Eigen::MatrixXs& targetMotion,
+    int start,
+    int end,
+    Eigen::MatrixXs& sourceMotion,
+    bool useLinearization,
+    s_t linearizationTolerance,
+    ////// IK options
+    s_t convergenceThreshold,
+    int maxStepCount,
+    s_t leastSquaresDamping,
+    bool lineSearch,
+    bool logOutput)
+{
+  // The point we linearized around, and the map from changes in target
+  // positions to changes in source ball-joint positions
+  Eigen::VectorXs anchorTarget;
+  Eigen::VectorXs anchorSourceBalls;
+  Eigen::MatrixXs linearMap;
+  s_t anchorError = 0.0;
+
+  for (int i = start; i < end; i++)
+  {
+    mTargetSkeleton->setPositions(targetMotion.col(i));
+
+    if (useLinearization && linearMap.size() > 0)
+    {
+      Eigen::VectorXs predicted = anchorSourceBalls
+                                  + linearMap
+                                        * (targetMotion.col(i) - anchorTarget);
+      mSourceSkeletonBallJoints->setPositions(predicted);
+      if (getBallJointMarkerError() <= anchorError + linearizationTolerance)
+      {
+        mSourceSkeleton->setPositions(
+            mSourceSkeleton->convertPositionsFromBallSpace(predicted));
+        sourceMotion.col(i) = mSourceSkeleton->getPositions();
+        continue;
+      }
+      // The prediction drifted too far, so warm start IK from it
+      mSourceSkeleton->setPositions(
+          mSourceSkeleton->convertPositionsFromBallSpace(predicted));
+    }
+
+    fitSourceToTarget(
+        convergenceThreshold,
+        maxStepCount,
+        leastSquaresDamping,
+        lineSearch,
+        logOutput);
+    sourceMotion.col(i) = mSourceSkeleton->getPositions();
+
+    if (useLinearization)
+    {
+      // fitSourceToTarget() leaves the ball-joint skeleton at the fit, so we
+      // can linearize both skeletons' markers right here. The map is the
+      // damped, weighted least-squares solution to J_source * dq_source =
+      // J_target * dq_target.
+      anchorError = getBallJointMarkerError();
+      anchorTarget = targetMotion.col(i);
+      anchorSourceBalls = mSourceSkeletonBallJoints->getPositions();
+      Eigen::MatrixXs sourceJac
+          = mSourceSkeletonBallJoints
+                ->getMarkerWorldPositionsJacobianWrtJointPositions(
+                    mSourceMarkersBallJoints);
+      Eigen::MatrixXs targetJac
+          = mTargetSkeleton->getMarkerWorldPositionsJacobianWrtJointPositions(
+              mTargetMarkers);
+      Eigen::VectorXs weights = Eigen::VectorXs::Zero(sourceJac.rows());
+      for (int j = 0; j < mSourceMarkersBallJoints.size(); j++)
+      {
+        weights.segment<3>(j * 3).setConstant(mMarkerWeights(j));
+      }
+      Eigen::MatrixXs weightedJacT
+          = sourceJac.transpose() * weights.asDiagonal();
+      Eigen::MatrixXs normal = weightedJacT * sourceJac;
+      normal.diagonal().array() += leastSquaresDamping;
+      linearMap = normal.ldlt().solve(weightedJacT * targetJac);
+    }
+  }
+}
+
 //==============================================================================
 /// This will display the state of the linkages between the two skeletons into
 /// the provided GUI.
@@ -72,6 +72,35 @@ public:
       bool lineSearch = true,
       bool logIKOutput = false);
 
+  /// This converts a motion from the target skeleton to the source skeleton,
+  /// like convertMotion(), but splits the motion into chunks of `chunkSize`
+  /// frames and converts the chunks in parallel. The first frame of each
+  /// chunk is fit in a quick serial pass, warm started from the previous
+  /// chunk's first frame, and then each chunk is tracked frame-by-frame on
+  /// its own thread from there. If `numThreads` is <= 0, this uses the global
+  /// thread pool's concurrency.
+  ///
+  /// If `useLinearization` is true, each chunk precomputes a linear map from
+  /// changes in target joint positions to changes in source joint positions
+  /// at its first frame, and uses that instead of running IK on the frames
+  /// that follow. A frame falls back to IK (and becomes the new point of
+  /// linearization) whenever the predicted pose's marker error is worse than
+  /// the last IK fit's by more than `linearizationTolerance`. This is much
+  /// faster for small motions, but will track less tightly than full IK.
+  Eigen::MatrixXs convertMotionParallel(
+      Eigen::MatrixXs targetMotion,
+      int chunkSize = 50,
+      int numThreads = -1,
+      bool useLinearization = false,
+      s_t linearizationTolerance = 1e-4,
+      bool logProgress = true,
+      // IK Options
+      s_t convergenceThreshold = 1e-7,
+      int maxStepCount = 100,
+      s_t leastSquaresDamping = 0.01,
+      bool lineSearch = true,
+      bool logIKOutput = false);
+
   /// This returns the concatenated 3-vectors for world positions of each joint
   /// in 3D world space, for the registered target joints.
   Eigen::VectorXs getSourceJointWorldPositions();
@@ -103,6 +132,32 @@ public:
   getTargetMarkers() const;
 
 protected:
+  /// This creates a copy of this converter that runs on clones of our
+  /// skeletons, so that it can run IK on another thread without touching
+  /// our skeletons.
+  std::shared_ptr<SkeletonConverter> cloneForThread() const;
+
+  /// This returns the weighted sum of squared distances between the source
+  /// and target markers, at the current positions of the source ball-joint
+  /// skeleton and the target skeleton.
+  s_t getBallJointMarkerError();
+
+  /// This converts frames [start, end) of `targetMotion` into the matching
+  /// columns of `sourceMotion`, tracking from the source skeleton's current
+  /// positions. See convertMotionParallel() for `useLinearization`.
+  void convertMotionChunk(
+      const Eigen::MatrixXs& targetMotion,
+      int start,
+      int end,
+      Eigen::MatrixXs& sourceMotion,
+      bool useLinearization,
+      s_t linearizationTolerance,
+      s_t convergenceThreshold,
+      int maxStepCount,
+      s_t leastSquaresDamping,
+      bool lineSearch,
+      bool logOutput);
+
   dynamics::SkeletonPtr mSourceSkeleton;
   dynamics::SkeletonPtr mSourceSkeletonBallJoints;
   dynamics::SkeletonPtr mTargetSkeleton;
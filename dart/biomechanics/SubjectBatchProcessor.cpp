@@ -0,0 +1,287 @@
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "dart/common/TaskScheduler.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+//==============================================================================
+SubjectBatchJob::SubjectBatchJob() : numBilevelSamples(20), memoryBytes(0)
+{
+}
+
+//==============================================================================
+SubjectBatchProgress::SubjectBatchProgress()
+  : numQueued(0),
+    numRunning(0),
+    numSucceeded(0),
+    numFailed(0),
+    memoryInUseBytes(0),
+    elapsedSeconds(0),
+    meanSecondsPerSubject(0),
+    jobSeconds(0)
+{
+}
+
+//==============================================================================
+SubjectBatchProcessor::SubjectBatchProcessor(
+    int maxConcurrentSubjects, std::size_t memoryBudgetBytes)
+  : mMaxConcurrentSubjects(maxConcurrentSubjects),
+    mMemoryBudgetBytes(memoryBudgetBytes),
+    mNumRunning(0),
+    mNumActiveTasks(0),
+    mNumSucceeded(0),
+    mNumFailed(0),
+    mMemoryInUseBytes(0),
+    mTotalJobSeconds(0),
+    mStartTime(std::chrono::steady_clock::now())
+{
+}
+
+//==============================================================================
+SubjectBatchProcessor::~SubjectBatchProcessor()
+{
+  waitForAll();
+}
+
+//==============================================================================
+/// This adds a job to the back of the queue, and starts it right away if
+/// there's room
+void SubjectBatchProcessor::enqueue(SubjectBatchJob job)
+{
+  if (job.memoryBytes == 0)
+  {
+    job.memoryBytes = estimateMemoryBytes(job);
+  }
+
+  std::vector<SubjectBatchProgress> updates;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.push_back(std::move(job));
+    startJobsLocked(updates);
+  }
+  sendUpdates(updates);
+}
+
+//==============================================================================
+/// This blocks until the queue is empty and nothing is running. Don't call
+/// this from a task running on the global pool.
+void SubjectBatchProcessor::waitForAll()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mFinished.wait(
+      lock, [this]() { return mQueue.empty() && mNumActiveTasks == 0; });
+}
+
+//==============================================================================
+/// This sets a function to call (from whichever thread started or finished
+/// a subject) with a fresh snapshot every time a subject starts or stops
+void SubjectBatchProcessor::setProgressCallback(
+    std::function<void(const SubjectBatchProgress&)> callback)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mProgressCallback = callback;
+}
+
+//==============================================================================
+/// This returns a snapshot of the current state of the batch
+SubjectBatchProgress SubjectBatchProcessor::getProgress()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return getProgressLocked();
+}
+
+//==============================================================================
+/// This guesses how much memory the kinematics pipeline needs for a
+/// subject: a fixed overhead for the model, plus a cost per marker
+/// observation for the poses, joint centers and problem state.
+std::size_t SubjectBatchProcessor::estimateMemoryBytes(
+    const SubjectBatchJob& job)
+{
+  // These are rough, and err on the high side
+  const std::size_t modelBytes = 128 * 1024 * 1024;
+  const std::size_t bytesPerMarkerObservation = 2 * 1024;
+
+  std::size_t numMarkerObservations = 0;
+  for (const auto& trial : job.markerTrials)
+  {
+    for (const auto& timestep : trial)
+    {
+      numMarkerObservations += timestep.size();
+    }
+  }
+  return modelBytes + numMarkerObservations * bytesPerMarkerObservation;
+}
+
+//==============================================================================
+/// This runs a single subject, on a pool thread. Errors are reported by
+/// throwing.
+void SubjectBatchProcessor::runJob(SubjectBatchJob& job)
+{
+  // The fitters never use the model's meshes, so we only load them if
+  // something renders the model
+  OpenSimFile model = OpenSimParser::parseOsimWithoutGeometry(job.osimPath);
+  if (model.skeleton == nullptr)
+  {
+    throw std::runtime_error("Couldn't load the model at " + job.osimPath);
+  }
+
+  MarkerFitter fitter(model.skeleton, model.markersMap);
+  if (job.configureFitter)
+  {
+    job.configureFitter(fitter);
+  }
+
+  std::vector<MarkerInitialization> kinematics
+      = fitter.runMultiTrialKinematicsPipeline(
+          job.markerTrials, job.markerFitParams, job.numBilevelSamples);
+
+  if (job.onKinematicsFinished)
+  {
+    job.onKinematicsFinished(model, fitter, kinematics);
+  }
+}
+
+//==============================================================================
+/// This starts as many queued jobs as the admission limits allow. The
+/// caller must hold mMutex, and any progress updates to send are appended
+/// to `updates`.
+void SubjectBatchProcessor::startJobsLocked(
+    std::vector<SubjectBatchProgress>& updates)
+{
+  int maxConcurrentSubjects
+      = mMaxConcurrentSubjects > 0
+            ? mMaxConcurrentSubjects
+            : common::TaskScheduler::getGlobalMaxConcurrency();
+
+  auto it = mQueue.begin();
+  while (it != mQueue.end() && mNumRunning < maxConcurrentSubjects)
+  {
+    // Anything fits when nothing else is running, so that a job bigger than
+    // the whole budget can't get stuck
+    bool fits = mMemoryBudgetBytes == 0 || mNumRunning == 0
+                || mMemoryInUseBytes + it->memoryBytes <= mMemoryBudgetBytes;
+    if (!fits)
+    {
+      ++it;
+      continue;
+    }
+
+    SubjectBatchJob job = std::move(*it);
+    it = mQueue.erase(it);
+    mNumRunning++;
+    mNumActiveTasks++;
+    mMemoryInUseBytes += job.memoryBytes;
+
+    SubjectBatchProgress update = getProgressLocked();
+    update.jobName = job.name;
+    update.jobStatus = "started";
+    updates.push_back(update);
+
+    common::async(
+        [this](SubjectBatchJob job) { runAndFinish(std::move(job)); },
+        std::move(job));
+  }
+}
+
+//==============================================================================
+/// This runs a job and does the bookkeeping around it
+void SubjectBatchProcessor::runAndFinish(SubjectBatchJob job)
+{
+  auto startTime = std::chrono::steady_clock::now();
+  bool succeeded = true;
+  std::string error;
+  try
+  {
+    runJob(job);
+  }
+  catch (const std::exception& e)
+  {
+    succeeded = false;
+    error = e.what();
+  }
+  catch (...)
+  {
+    succeeded = false;
+    error = "Unknown error";
+  }
+  s_t seconds = std::chrono::duration<s_t>(
+                    std::chrono::steady_clock::now() - startTime)
+                    .count();
+
+  std::vector<SubjectBatchProgress> updates;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mNumRunning--;
+    mMemoryInUseBytes -= job.memoryBytes;
+    if (succeeded)
+      mNumSucceeded++;
+    else
+      mNumFailed++;
+    mTotalJobSeconds += seconds;
+
+    SubjectBatchProgress update = getProgressLocked();
+    update.jobName = job.name;
+    update.jobStatus = succeeded ? "succeeded" : "failed";
+    update.jobError = error;
+    update.jobSeconds = seconds;
+    updates.push_back(update);
+
+    startJobsLocked(updates);
+  }
+  sendUpdates(updates);
+
+  // This has to come last, since once it's done the processor may be
+  // destroyed
+  std::lock_guard<std::mutex> lock(mMutex);
+  mNumActiveTasks--;
+  mFinished.notify_all();
+}
+
+//==============================================================================
+/// This builds a snapshot. The caller must hold mMutex.
+SubjectBatchProgress SubjectBatchProcessor::getProgressLocked()
+{
+  SubjectBatchProgress progress;
+  progress.numQueued = mQueue.size();
+  progress.numRunning = mNumRunning;
+  progress.numSucceeded = mNumSucceeded;
+  progress.numFailed = mNumFailed;
+  progress.memoryInUseBytes = mMemoryInUseBytes;
+  progress.elapsedSeconds = std::chrono::duration<s_t>(
+                                std::chrono::steady_clock::now() - mStartTime)
+                                .count();
+  int numFinished = mNumSucceeded + mNumFailed;
+  if (numFinished > 0)
+  {
+    progress.meanSecondsPerSubject = mTotalJobSeconds / numFinished;
+  }
+  return progress;
+}
+
+//==============================================================================
+/// This sends progress updates, without holding mMutex
+void SubjectBatchProcessor::sendUpdates(
+    const std::vector<SubjectBatchProgress>& updates)
+{
+  std::function<void(const SubjectBatchProgress&)> callback;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    callback = mProgressCallback;
+  }
+  if (!callback)
+  {
+    return;
+  }
+  for (const SubjectBatchProgress& update : updates)
+  {
+    callback(update);
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
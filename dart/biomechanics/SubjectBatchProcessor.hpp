@@ -0,0 +1,177 @@
+#ifndef BIOMECH_SUBJECT_BATCH_PROCESSOR
+#define BIOMECH_SUBJECT_BATCH_PROCESSOR
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/// This is one subject's worth of work for a SubjectBatchProcessor: the
+/// unscaled model, the marker data for every trial, and how to fit them.
+struct SubjectBatchJob
+{
+  /// This is only used to label progress updates
+  std::string name;
+
+  /// The unscaled model. It's loaded through OpenSimParser::parseOsim(), so
+  /// subjects that share a model only parse it (and its geometry) once.
+  std::string osimPath;
+
+  /// The marker observations, one entry per trial
+  std::vector<std::vector<std::map<std::string, Eigen::Vector3s>>>
+      markerTrials;
+
+  InitialMarkerFitParams markerFitParams;
+  int numBilevelSamples;
+
+  /// The most memory we expect this subject to need at once, in bytes. If
+  /// this is 0, SubjectBatchProcessor::estimateMemoryBytes() fills it in.
+  std::size_t memoryBytes;
+
+  /// If set, this gets to configure the MarkerFitter (marker weights,
+  /// anthropometric priors, etc) before the kinematics pipeline runs
+  std::function<void(MarkerFitter&)> configureFitter;
+
+  /// If set, this runs on the same thread once the kinematics pipeline
+  /// finishes, and is where the rest of the processing goes: running the
+  /// DynamicsFitter and writing the results out with
+  /// SubjectOnDisk::writeSubject(), for example.
+  std::function<void(
+      OpenSimFile& model,
+      MarkerFitter& fitter,
+      std::vector<MarkerInitialization>& kinematics)>
+      onKinematicsFinished;
+
+  SubjectBatchJob();
+};
+
+/// This is a snapshot of how a SubjectBatchProcessor is getting on, which is
+/// passed to the progress callback every time a subject starts or stops.
+struct SubjectBatchProgress
+{
+  int numQueued;
+  int numRunning;
+  int numSucceeded;
+  int numFailed;
+  /// The summed memory estimates of the subjects that are running
+  std::size_t memoryInUseBytes;
+  s_t elapsedSeconds;
+  /// The mean wall time of the subjects that have finished, or 0 if none
+  /// have yet
+  s_t meanSecondsPerSubject;
+
+  /// The subject this update is about, and what happened to it: "started",
+  /// "succeeded" or "failed"
+  std::string jobName;
+  std::string jobStatus;
+  /// For "failed" updates, the error message
+  std::string jobError;
+  /// For "succeeded" and "failed" updates, how long the subject took
+  s_t jobSeconds;
+
+  SubjectBatchProgress();
+};
+
+/**
+ * This is a long-lived driver for pushing lots of subjects through the
+ * processing pipeline in one process, rather than starting a fresh process
+ * (and reloading everything) per subject. Models and their geometry stay in
+ * OpenSimParser's parsed model cache, and all the work runs on the global
+ * common::TaskScheduler, so the threads stay warm and the parallel loops
+ * inside each subject share the same cores as the other subjects.
+ *
+ * Jobs are started in the order they were queued, subject to two admission
+ * limits: the number of subjects running at once, and the summed memory
+ * estimates of the running subjects. When the next job doesn't fit in the
+ * memory that's left, later jobs that do fit may start ahead of it. A job
+ * that's bigger than the whole budget still runs, but only on its own.
+ */
+class SubjectBatchProcessor
+{
+public:
+  /// Values of `maxConcurrentSubjects` <= 0 mean one subject per worker in
+  /// the global pool. A `memoryBudgetBytes` of 0 means no memory limit.
+  SubjectBatchProcessor(
+      int maxConcurrentSubjects = -1, std::size_t memoryBudgetBytes = 0);
+
+  /// This waits for every queued job to finish
+  virtual ~SubjectBatchProcessor();
+
+  /// This adds a job to the back of the queue, and starts it right away if
+  /// there's room
+  void enqueue(SubjectBatchJob job);
+
+  /// This blocks until the queue is empty and nothing is running. Don't call
+  /// this from a task running on the global pool.
+  void waitForAll();
+
+  /// This sets a function to call (from whichever thread started or finished
+  /// a subject) with a fresh snapshot every time a subject starts or stops
+  void setProgressCallback(
+      std::function<void(const SubjectBatchProgress&)> callback);
+
+  /// This returns a snapshot of the current state of the batch
+  SubjectBatchProgress getProgress();
+
+  /// This guesses how much memory the kinematics pipeline needs for a
+  /// subject: a fixed overhead for the model, plus a cost per marker
+  /// observation for the poses, joint centers and problem state.
+  static std::size_t estimateMemoryBytes(const SubjectBatchJob& job);
+
+protected:
+  /// This runs a single subject, on a pool thread. Errors are reported by
+  /// throwing. Subclasses that override this must call waitForAll() in their
+  /// own destructor, since jobs may still be running when ours is called.
+  virtual void runJob(SubjectBatchJob& job);
+
+  /// This starts as many queued jobs as the admission limits allow. The
+  /// caller must hold mMutex, and any progress updates to send are appended
+  /// to `updates`.
+  void startJobsLocked(std::vector<SubjectBatchProgress>& updates);
+
+  /// This runs a job and does the bookkeeping around it
+  void runAndFinish(SubjectBatchJob job);
+
+  /// This builds a snapshot. The caller must hold mMutex.
+  SubjectBatchProgress getProgressLocked();
+
+  /// This sends progress updates, without holding mMutex
+  void sendUpdates(const std::vector<SubjectBatchProgress>& updates);
+
+  int mMaxConcurrentSubjects;
+  std::size_t mMemoryBudgetBytes;
+
+  std::mutex mMutex;
+  std::condition_variable mFinished;
+  std::list<SubjectBatchJob> mQueue;
+  // Subjects that count against the admission limits
+  int mNumRunning;
+  // Pool tasks that haven't returned yet, which can outlive their subject
+  // while they send progress updates
+  int mNumActiveTasks;
+  int mNumSucceeded;
+  int mNumFailed;
+  std::size_t mMemoryInUseBytes;
+  s_t mTotalJobSeconds;
+  std::chrono::steady_clock::time_point mStartTime;
+  std::function<void(const SubjectBatchProgress&)> mProgressCallback;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
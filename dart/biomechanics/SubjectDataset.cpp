@@ -0,0 +1,543 @@
+#include "dart/biomechanics/SubjectDataset.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <random>
+
+namespace dart {
+namespace biomechanics {
+
+SubjectDataset::WindowRequest::WindowRequest(
+    int subject, int trial, int startFrame)
+  : subject(subject), trial(trial), startFrame(startFrame)
+{
+}
+
+SubjectDataset::SubjectDataset(
+    const std::vector<std::string>& paths,
+    int windowLen,
+    const std::vector<std::string>& channels,
+    int numThreads,
+    std::size_t cacheBudgetBytes)
+  : mPaths(paths),
+    mWindowLen(windowLen),
+    mChannels(channels),
+    mCacheBudgetBytes(cacheBudgetBytes),
+    mSubjects(paths.size()),
+    mCacheSizeBytes(0),
+    mNumCacheHits(0),
+    mNumCacheMisses(0),
+    mShuttingDown(false)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(numThreads, 1);
+  for (int i = 0; i < numThreads; i++)
+  {
+    mWorkers.emplace_back([this]() { prefetchWorker(); });
+  }
+}
+
+/// This stops the background threads, dropping anything still queued
+SubjectDataset::~SubjectDataset()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mShuttingDown = true;
+    mQueue.clear();
+  }
+  mQueueChanged.notify_all();
+  for (std::thread& worker : mWorkers)
+  {
+    worker.join();
+  }
+}
+
+/// This returns the number of subject files in the dataset
+int SubjectDataset::getNumSubjects()
+{
+  return mPaths.size();
+}
+
+/// This returns the subject, opening its file first if this is the first time
+/// anyone has asked for it
+std::shared_ptr<SubjectOnDisk> SubjectDataset::getSubject(int subject)
+{
+  if (subject < 0 || subject >= mPaths.size())
+  {
+    std::cout << "SubjectDataset::getSubject() got out of bounds subject "
+              << subject << ". Returning null." << std::endl;
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mSubjectsMutex);
+    if (mSubjects[subject])
+    {
+      return mSubjects[subject];
+    }
+  }
+
+  // Opening the file reads its header, which can be slow on a network
+  // filesystem, so don't hold up everyone else while we do it
+  std::shared_ptr<SubjectOnDisk> opened
+      = std::make_shared<SubjectOnDisk>(mPaths[subject]);
+
+  std::lock_guard<std::mutex> lock(mSubjectsMutex);
+  // If another thread beat us to it, use theirs
+  if (!mSubjects[subject])
+  {
+    mSubjects[subject] = opened;
+  }
+  return mSubjects[subject];
+}
+
+/// This queues up windows to read in the background.
+void SubjectDataset::prefetch(const std::vector<WindowRequest>& requests)
+{
+  std::vector<ChunkKey> keys;
+  for (const WindowRequest& request : requests)
+  {
+    if (checkRequest(request))
+    {
+      getChunkKeys(request, keys);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const ChunkKey& key : keys)
+    {
+      if (mCache.count(key) == 0 && mInFlight.count(key) == 0)
+      {
+        mQueue.push_back(key);
+      }
+    }
+  }
+  mQueueChanged.notify_all();
+}
+
+/// This returns one (channelDim x windowLen) matrix per channel, reading
+/// anything that isn't already cached.
+///
+/// On OOB access, prints an error and returns an empty vector.
+std::vector<Eigen::MatrixXd> SubjectDataset::readWindow(
+    const WindowRequest& request)
+{
+  std::vector<Eigen::MatrixXd> result;
+  if (!checkRequest(request))
+  {
+    return result;
+  }
+
+  std::vector<ChunkKey> keys;
+  getChunkKeys(request, keys);
+
+  std::vector<ChunkData> chunks;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (const ChunkKey& key : keys)
+    {
+      bool missed = false;
+      while (true)
+      {
+        auto cached = mCache.find(key);
+        if (cached != mCache.end())
+        {
+          mLru.splice(mLru.begin(), mLru, cached->second.lruPosition);
+          chunks.push_back(cached->second.data);
+          break;
+        }
+
+        missed = true;
+        if (mInFlight.count(key) > 0)
+        {
+          // A background thread is part way through reading this chunk
+          mChunkLoaded.wait(lock);
+          continue;
+        }
+
+        // Nobody has this chunk, so read it ourselves
+        mInFlight.insert(key);
+        lock.unlock();
+        ChunkData data;
+        try
+        {
+          data = readChunk(key);
+        }
+        catch (...)
+        {
+          lock.lock();
+          mInFlight.erase(key);
+          mChunkLoaded.notify_all();
+          throw;
+        }
+        lock.lock();
+        mInFlight.erase(key);
+        insertChunk(key, data);
+        mChunkLoaded.notify_all();
+        chunks.push_back(data);
+        break;
+      }
+      if (missed)
+      {
+        mNumCacheMisses++;
+      }
+      else
+      {
+        mNumCacheHits++;
+      }
+    }
+  }
+
+  // Copy the overlapping parts of each chunk into the window
+  const int chunkFrames
+      = getSubject(request.subject)->getChunkFrames(request.trial);
+  for (int i = 0; i < chunks.size(); i++)
+  {
+    const std::vector<Eigen::MatrixXd>& chunk = *chunks[i];
+    if (chunk.size() != mChannels.size())
+    {
+      std::cout << "SubjectDataset::readWindow() failed to read the channels "
+                   "for subject "
+                << request.subject << ". Returning empty vector." << std::endl;
+      return std::vector<Eigen::MatrixXd>();
+    }
+    if (i == 0)
+    {
+      for (int k = 0; k < chunk.size(); k++)
+      {
+        result.push_back(Eigen::MatrixXd::Zero(chunk[k].rows(), mWindowLen));
+      }
+    }
+
+    const int chunkStart = std::get<2>(keys[i]) * chunkFrames;
+    for (int k = 0; k < chunk.size(); k++)
+    {
+      const int copyStart = std::max(request.startFrame, chunkStart);
+      const int copyEnd = std::min(
+          request.startFrame + mWindowLen, chunkStart + (int)chunk[k].cols());
+      if (copyEnd > copyStart)
+      {
+        result[k].middleCols(
+            copyStart - request.startFrame, copyEnd - copyStart)
+            = chunk[k].middleCols(copyStart - chunkStart, copyEnd - copyStart);
+      }
+    }
+  }
+
+  return result;
+}
+
+/// This drops everything still waiting in the prefetch queue
+void SubjectDataset::clearPrefetchQueue()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mQueue.clear();
+}
+
+/// This returns the statistics of each of the dataset's channels, merged over
+/// every frame of every subject
+std::vector<ChannelStats> SubjectDataset::getChannelStats(int numThreads)
+{
+  openAllSubjects(numThreads);
+  std::vector<ChannelStats> stats(mChannels.size());
+  for (int i = 0; i < mPaths.size(); i++)
+  {
+    std::shared_ptr<SubjectOnDisk> subject = getSubject(i);
+    for (int k = 0; k < mChannels.size(); k++)
+    {
+      stats[k].merge(subject->getChannelStats(mChannels[k]));
+    }
+  }
+  return stats;
+}
+
+/// This returns a request for every `stride`th frame of every trial of every
+/// subject, shuffled with `seed`
+std::vector<SubjectDataset::WindowRequest> SubjectDataset::getShuffledIndex(
+    unsigned int seed, int stride, bool skipProbablyMissingGRF, int numThreads)
+{
+  stride = std::max(stride, 1);
+  openAllSubjects(numThreads);
+  std::vector<WindowRequest> index;
+  for (int i = 0; i < mPaths.size(); i++)
+  {
+    std::shared_ptr<SubjectOnDisk> subject = getSubject(i);
+    for (int trial = 0; trial < subject->getNumTrials(); trial++)
+    {
+      std::vector<bool> missingGRF;
+      if (skipProbablyMissingGRF)
+      {
+        missingGRF = subject->getProbablyMissingGRF(trial);
+      }
+      const int length = subject->getTrialLength(trial);
+      for (int t = 0; t < length; t += stride)
+      {
+        if (t < missingGRF.size() && missingGRF[t])
+        {
+          continue;
+        }
+        index.emplace_back(i, trial, t);
+      }
+    }
+  }
+  std::mt19937 rng(seed);
+  std::shuffle(index.begin(), index.end(), rng);
+  return index;
+}
+
+/// This sets a cache shared with other processes, or null to stop using one
+void SubjectDataset::setSharedCache(std::shared_ptr<SharedChunkCache> cache)
+{
+  std::atomic_store(&mSharedCache, cache);
+}
+
+/// This returns the number of bytes of decoded data in the cache
+std::size_t SubjectDataset::getCacheSizeBytes()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mCacheSizeBytes;
+}
+
+/// This returns the number of chunks readWindow() found already cached
+int SubjectDataset::getNumCacheHits()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumCacheHits;
+}
+
+/// This returns the number of chunks readWindow() had to wait for, or read
+/// itself
+int SubjectDataset::getNumCacheMisses()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumCacheMisses;
+}
+
+/// This checks that a request is in bounds, and prints an error if it isn't
+bool SubjectDataset::checkRequest(const WindowRequest& request)
+{
+  if (request.subject < 0 || request.subject >= mPaths.size())
+  {
+    std::cout << "SubjectDataset got out of bounds subject " << request.subject
+              << std::endl;
+    return false;
+  }
+  std::shared_ptr<SubjectOnDisk> subject = getSubject(request.subject);
+  if (request.trial < 0 || request.trial >= subject->getNumTrials()
+      || request.startFrame < 0
+      || request.startFrame >= subject->getTrialLength(request.trial)
+      || mWindowLen <= 0)
+  {
+    std::cout << "SubjectDataset got out of bounds trial " << request.trial
+              << " frame " << request.startFrame << " for subject "
+              << request.subject << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// This opens every subject that hasn't been opened yet, across `numThreads`
+/// threads
+void SubjectDataset::openAllSubjects(int numThreads)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)mPaths.size()));
+
+  // Opening a file is mostly waiting on the filesystem, so each thread just
+  // takes the next subject until there are none left
+  std::atomic<int> next(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; i++)
+  {
+    threads.emplace_back([this, &next]() {
+      for (int subject = next++; subject < mPaths.size(); subject = next++)
+      {
+        try
+        {
+          getSubject(subject);
+        }
+        catch (...)
+        {
+          // The caller opens the subject again on its own thread, and reports
+          // the problem there
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+/// This appends the keys of the chunks that a window overlaps to `keys`
+void SubjectDataset::getChunkKeys(
+    const WindowRequest& request, std::vector<ChunkKey>& keys)
+{
+  std::shared_ptr<SubjectOnDisk> subject = getSubject(request.subject);
+  const int chunkFrames = subject->getChunkFrames(request.trial);
+  const int lastFrame = std::min(
+                            request.startFrame + mWindowLen,
+                            subject->getTrialLength(request.trial))
+                        - 1;
+  for (int chunk = request.startFrame / chunkFrames;
+       chunk <= lastFrame / chunkFrames;
+       chunk++)
+  {
+    keys.emplace_back(request.subject, request.trial, chunk);
+  }
+}
+
+/// This reads a chunk out of the shared cache, or off disk (and into the
+/// shared cache) if it isn't there, without touching our own cache
+SubjectDataset::ChunkData SubjectDataset::readChunk(const ChunkKey& key)
+{
+  std::shared_ptr<SubjectOnDisk> subject = getSubject(std::get<0>(key));
+  const int trial = std::get<1>(key);
+  const int chunk = std::get<2>(key);
+  const int chunkFrames = subject->getChunkFrames(trial);
+
+  std::shared_ptr<SharedChunkCache> sharedCache
+      = std::atomic_load(&mSharedCache);
+  if (!sharedCache)
+  {
+    return std::make_shared<const std::vector<Eigen::MatrixXd>>(
+        subject->readChannelWindow(
+            trial, chunk * chunkFrames, chunkFrames, mChannels));
+  }
+
+  // The shared cache stores the channels one after another, each column-major
+  const SharedChunkCache::Key sharedKey = SharedChunkCache::makeKey(
+      mPaths[std::get<0>(key)], trial, chunk, mChannels);
+  std::vector<double> values;
+  if (sharedCache->get(sharedKey, values))
+  {
+    std::vector<int> dims;
+    int frameDim = 0;
+    for (const std::string& channel : mChannels)
+    {
+      dims.push_back(subject->getChannelDim(channel));
+      frameDim += dims.back();
+    }
+    if (frameDim > 0 && values.size() % frameDim == 0)
+    {
+      const int frames = values.size() / frameDim;
+      std::vector<Eigen::MatrixXd> channels;
+      const double* start = values.data();
+      for (int dim : dims)
+      {
+        channels.push_back(
+            Eigen::Map<const Eigen::MatrixXd>(start, dim, frames));
+        start += (std::size_t)dim * frames;
+      }
+      return std::make_shared<const std::vector<Eigen::MatrixXd>>(channels);
+    }
+  }
+
+  std::vector<Eigen::MatrixXd> channels = subject->readChannelWindow(
+      trial, chunk * chunkFrames, chunkFrames, mChannels);
+  if (!channels.empty())
+  {
+    values.clear();
+    for (const Eigen::MatrixXd& channel : channels)
+    {
+      values.insert(
+          values.end(), channel.data(), channel.data() + channel.size());
+    }
+    sharedCache->put(sharedKey, values.data(), values.size());
+  }
+  return std::make_shared<const std::vector<Eigen::MatrixXd>>(channels);
+}
+
+/// This puts a chunk in the cache, evicting the least recently used chunks to
+/// stay under budget. This needs mMutex to be held.
+void SubjectDataset::insertChunk(const ChunkKey& key, const ChunkData& data)
+{
+  if (mCache.count(key) > 0)
+  {
+    return;
+  }
+
+  std::size_t bytes = 0;
+  for (const Eigen::MatrixXd& channel : *data)
+  {
+    bytes += channel.size() * sizeof(double);
+  }
+
+  mLru.push_front(key);
+  CacheEntry entry;
+  entry.data = data;
+  entry.bytes = bytes;
+  entry.lruPosition = mLru.begin();
+  mCache[key] = entry;
+  mCacheSizeBytes += bytes;
+
+  // Always keep the chunk we just read, even if it's over budget on its own
+  while (mCacheSizeBytes > mCacheBudgetBytes && mLru.size() > 1)
+  {
+    auto evicted = mCache.find(mLru.back());
+    mCacheSizeBytes -= evicted->second.bytes;
+    mCache.erase(evicted);
+    mLru.pop_back();
+  }
+}
+
+/// This is what each background thread runs
+void SubjectDataset::prefetchWorker()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true)
+  {
+    mQueueChanged.wait(
+        lock, [this]() { return mShuttingDown || !mQueue.empty(); });
+    if (mShuttingDown)
+    {
+      return;
+    }
+
+    ChunkKey key = mQueue.front();
+    mQueue.pop_front();
+    if (mCache.count(key) > 0 || mInFlight.count(key) > 0)
+    {
+      continue;
+    }
+    mInFlight.insert(key);
+    lock.unlock();
+
+    ChunkData data;
+    try
+    {
+      data = readChunk(key);
+    }
+    catch (std::exception* e)
+    {
+      // If anyone actually reads this chunk, readWindow() will try again on
+      // its own thread, and report the problem there
+      delete e;
+    }
+    catch (...)
+    {
+      // Same as above
+    }
+
+    lock.lock();
+    mInFlight.erase(key);
+    if (data)
+    {
+      insertChunk(key, data);
+    }
+    mChunkLoaded.notify_all();
+  }
+}
+
+} // namespace biomechanics
+} // namespace dart
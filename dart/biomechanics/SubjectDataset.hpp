@@ -0,0 +1,196 @@
+#ifndef BIOMECH_SUBJECT_DATASET
+#define BIOMECH_SUBJECT_DATASET
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/biomechanics/SharedChunkCache.hpp"
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+
+namespace dart {
+namespace biomechanics {
+
+/**
+ * This is a view of lots of SubjectOnDisk files at once, built for random
+ * access training, where reading is bound by I/O latency (especially on
+ * network filesystems) rather than bandwidth. The caller submits the windows
+ * it's going to want next with prefetch(), background threads read and decode
+ * them ahead of time, and readWindow() then (hopefully) just copies them out
+ * of memory.
+ *
+ * Data is read and cached a chunk at a time (see
+ * SubjectOnDisk::getChunkFrames()), for just the channels this dataset was
+ * made with. Recently used chunks stay in an LRU cache, capped at a number of
+ * bytes, so overlapping windows don't get decoded twice.
+ *
+ * Subject files are only opened the first time something asks for them, so
+ * making a dataset over tens of thousands of files is cheap.
+ *
+ * When several processes read the same files (like DataLoader workers), they
+ * can also share a SharedChunkCache, which sits behind each process's own LRU
+ * cache, so a chunk only has to be decoded once per machine.
+ */
+class SubjectDataset
+{
+public:
+  struct WindowRequest
+  {
+    int subject;
+    int trial;
+    int startFrame;
+
+    WindowRequest(int subject = 0, int trial = 0, int startFrame = 0);
+  };
+
+  /// `channels` are named as in SubjectOnDisk::readChannelWindow(). Values of
+  /// `numThreads` <= 0 mean use all the hardware threads.
+  SubjectDataset(
+      const std::vector<std::string>& paths,
+      int windowLen,
+      const std::vector<std::string>& channels,
+      int numThreads = 4,
+      std::size_t cacheBudgetBytes = 256 * 1024 * 1024);
+
+  /// This stops the background threads, dropping anything still queued
+  ~SubjectDataset();
+
+  /// This returns the number of subject files in the dataset
+  int getNumSubjects();
+
+  /// This returns the subject, opening its file first if this is the first
+  /// time anyone has asked for it
+  std::shared_ptr<SubjectOnDisk> getSubject(int subject);
+
+  /// This queues up windows to read in the background. Requests for data
+  /// that's already cached or on its way are cheap no-ops, so it's fine to
+  /// submit the same window more than once.
+  void prefetch(const std::vector<WindowRequest>& requests);
+
+  /// This returns one (channelDim x windowLen) matrix per channel, in the
+  /// order the dataset was made with. Anything not already cached is read
+  /// right away on the calling thread, and anything a background thread is
+  /// part way through reading is waited for. Windows that run off the end of
+  /// their trial are padded with zeros.
+  ///
+  /// On OOB access, prints an error and returns an empty vector.
+  std::vector<Eigen::MatrixXd> readWindow(const WindowRequest& request);
+
+  /// This drops everything still waiting in the prefetch queue
+  void clearPrefetchQueue();
+
+  /// This returns the statistics of each of the dataset's channels, merged
+  /// over every frame of every subject. Files written by SubjectWriter store
+  /// their statistics, so this only reads their headers (and a few bytes at
+  /// the end), opening them across `numThreads` threads (values <= 0 mean use
+  /// all the hardware threads). Files without stored statistics have to be
+  /// read in full.
+  std::vector<ChannelStats> getChannelStats(int numThreads = -1);
+
+  /// This returns a request for every `stride`th frame of every trial of
+  /// every subject, shuffled with `seed`, so the same seed always gives the
+  /// same order. If `skipProbablyMissingGRF` is true, frames flagged as
+  /// probably missing ground reaction forces are left out. Only the headers
+  /// and trial metadata are read, opening files across `numThreads` threads.
+  std::vector<WindowRequest> getShuffledIndex(
+      unsigned int seed,
+      int stride = 1,
+      bool skipProbablyMissingGRF = false,
+      int numThreads = -1);
+
+  /// This sets a cache shared with other processes, which gets checked for
+  /// chunks before reading them off disk, and gets every chunk we do read off
+  /// disk. Pass null to stop using it.
+  void setSharedCache(std::shared_ptr<SharedChunkCache> cache);
+
+  /// This returns the number of bytes of decoded data in the cache
+  std::size_t getCacheSizeBytes();
+
+  /// This returns the number of chunks readWindow() found already cached
+  int getNumCacheHits();
+
+  /// This returns the number of chunks readWindow() had to wait for, or read
+  /// itself
+  int getNumCacheMisses();
+
+protected:
+  // (subject, trial, chunk)
+  typedef std::tuple<int, int, int> ChunkKey;
+  typedef std::shared_ptr<const std::vector<Eigen::MatrixXd>> ChunkData;
+
+  struct CacheEntry
+  {
+    ChunkData data;
+    std::size_t bytes;
+    std::list<ChunkKey>::iterator lruPosition;
+  };
+
+  /// This checks that a request is in bounds, and prints an error if it isn't
+  bool checkRequest(const WindowRequest& request);
+
+  /// This opens every subject that hasn't been opened yet, across
+  /// `numThreads` threads
+  void openAllSubjects(int numThreads);
+
+  /// This appends the keys of the chunks that a window overlaps to `keys`
+  void getChunkKeys(
+      const WindowRequest& request, std::vector<ChunkKey>& keys);
+
+  /// This reads a chunk out of the shared cache, or off disk (and into the
+  /// shared cache) if it isn't there, without touching our own cache
+  ChunkData readChunk(const ChunkKey& key);
+
+  /// This puts a chunk in the cache, evicting the least recently used chunks
+  /// to stay under budget. This needs mMutex to be held.
+  void insertChunk(const ChunkKey& key, const ChunkData& data);
+
+  /// This is what each background thread runs
+  void prefetchWorker();
+
+  std::vector<std::string> mPaths;
+  int mWindowLen;
+  std::vector<std::string> mChannels;
+  std::size_t mCacheBudgetBytes;
+  // Null if we aren't sharing a cache. This is only ever accessed through
+  // std::atomic_load() and std::atomic_store().
+  std::shared_ptr<SharedChunkCache> mSharedCache;
+
+  // Null until the subject is first used
+  std::vector<std::shared_ptr<SubjectOnDisk>> mSubjects;
+  std::mutex mSubjectsMutex;
+
+  // Everything below here is guarded by mMutex
+  std::mutex mMutex;
+  // Signalled when there's something new in mQueue, or when we're shutting
+  // down
+  std::condition_variable mQueueChanged;
+  // Signalled whenever a chunk finishes loading
+  std::condition_variable mChunkLoaded;
+  std::deque<ChunkKey> mQueue;
+  std::set<ChunkKey> mInFlight;
+  std::map<ChunkKey, CacheEntry> mCache;
+  // Most recently used at the front
+  std::list<ChunkKey> mLru;
+  std::size_t mCacheSizeBytes;
+  int mNumCacheHits;
+  int mNumCacheMisses;
+  bool mShuttingDown;
+
+  std::vector<std::thread> mWorkers;
+};
+
+} // namespace biomechanics
+} // namespace dart
+
+#endif
@@ -1,14 +1,22 @@
 #include "dart/biomechanics/SubjectOnDisk.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <exception>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <tinyxml2.h>
+#include <unistd.h>
 
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
@@ -35,9 +43,280 @@ struct FileHeader
 };
 }
 
+// The channels that every file has, before the custom values: pos, vel, acc,
+// tau, ground contact wrenches, and ground contact CoP-torque-force
+#define NUM_FIXED_CHANNELS 6
+
+namespace {
+
+// Version 2 chunks are either stored as raw doubles, or run through a small
+// lossless codec that does well on smooth motion data. We XOR each value with
+// the same value on the previous frame, which zeros out the sign, exponent and
+// top of the mantissa when a value barely changes. Then we regroup the bytes
+// so the (mostly zero) high bytes of every value sit together, and run-length
+// encode the runs of zeros.
+enum ChunkCodec
+{
+  CHUNK_CODEC_RAW = 0,
+  CHUNK_CODEC_XOR_SHUFFLE_RLE = 1
+};
+
+// Version 2 files written with channel statistics end with the offset of the
+// statistics (an int64), 4 zero bytes, and then this. Files without them end
+// with the chunk index, whose last 4 bytes are a codec, which is never this.
+#define CHANNEL_STATS_TRAILER_MAGIC 0x53544154
+
+// In the run-length encoding, a control byte below this starts a literal run
+// of (control + 1) bytes, and a control byte at or above it stands for
+// (control - 127) zero bytes
+#define CHUNK_RLE_ZERO_RUN 128
+
+std::vector<uint8_t> encodeChunk(const double* values, int dim, int numFrames)
+{
+  const std::size_t n = (std::size_t)dim * numFrames;
+  std::vector<uint8_t> shuffled(n * sizeof(uint64_t));
+  for (std::size_t i = 0; i < n; i++)
+  {
+    uint64_t bits;
+    memcpy(&bits, values + i, sizeof(uint64_t));
+    if (i >= (std::size_t)dim)
+    {
+      uint64_t previous;
+      memcpy(&previous, values + i - dim, sizeof(uint64_t));
+      bits ^= previous;
+    }
+    // High bytes first
+    for (int k = 0; k < 8; k++)
+    {
+      shuffled[k * n + i] = (uint8_t)(bits >> (8 * (7 - k)));
+    }
+  }
+
+  std::vector<uint8_t> encoded;
+  std::size_t i = 0;
+  while (i < shuffled.size())
+  {
+    std::size_t zeros = 0;
+    while (i + zeros < shuffled.size() && shuffled[i + zeros] == 0
+           && zeros < CHUNK_RLE_ZERO_RUN)
+    {
+      zeros++;
+    }
+    if (zeros >= 2)
+    {
+      encoded.push_back((uint8_t)(CHUNK_RLE_ZERO_RUN - 1 + zeros));
+      i += zeros;
+      continue;
+    }
+
+    // Take literal bytes up to the next run of zeros
+    std::size_t literals = 0;
+    while (i + literals < shuffled.size() && literals < CHUNK_RLE_ZERO_RUN
+           && !(shuffled[i + literals] == 0
+                && i + literals + 1 < shuffled.size()
+                && shuffled[i + literals + 1] == 0))
+    {
+      literals++;
+    }
+    encoded.push_back((uint8_t)(literals - 1));
+    encoded.insert(
+        encoded.end(),
+        shuffled.begin() + i,
+        shuffled.begin() + i + literals);
+    i += literals;
+  }
+  return encoded;
+}
+
+bool decodeChunk(
+    const uint8_t* data,
+    std::size_t size,
+    int dim,
+    int numFrames,
+    double* values)
+{
+  const std::size_t n = (std::size_t)dim * numFrames;
+  std::vector<uint8_t> shuffled(n * sizeof(uint64_t));
+  std::size_t in = 0;
+  std::size_t out = 0;
+  while (in < size)
+  {
+    const uint8_t control = data[in++];
+    if (control >= CHUNK_RLE_ZERO_RUN)
+    {
+      const std::size_t zeros = control - (CHUNK_RLE_ZERO_RUN - 1);
+      if (out + zeros > shuffled.size())
+        return false;
+      memset(shuffled.data() + out, 0, zeros);
+      out += zeros;
+    }
+    else
+    {
+      const std::size_t literals = control + 1;
+      if (in + literals > size || out + literals > shuffled.size())
+        return false;
+      memcpy(shuffled.data() + out, data + in, literals);
+      in += literals;
+      out += literals;
+    }
+  }
+  if (out != shuffled.size())
+    return false;
+
+  for (std::size_t i = 0; i < n; i++)
+  {
+    uint64_t bits = 0;
+    for (int k = 0; k < 8; k++)
+    {
+      bits = (bits << 8) | shuffled[k * n + i];
+    }
+    if (i >= (std::size_t)dim)
+    {
+      uint64_t previous;
+      memcpy(&previous, values + i - dim, sizeof(uint64_t));
+      bits ^= previous;
+    }
+    memcpy(values + i, &bits, sizeof(uint64_t));
+  }
+  return true;
+}
+
+/// This reads a length-prefixed string, starting at the current position in
+/// `file`, and throws if the length is negative or longer than `maxLen`
+std::string readString(
+    FILE* file, const std::string& path, int maxLen, const std::string& what)
+{
+  int32_t len;
+  int read_items = fread(&len, sizeof(int32_t), 1, file);
+  if (len < 0 || len > maxLen || read_items != 1)
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << path << ": bad string len for " << what << " = " << len
+              << std::endl;
+    throw new std::exception();
+  }
+  std::string result(len, ' ');
+  read_items = fread(&result[0], sizeof(char), len, file);
+  if (read_items != len)
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << path << ": bad string len for " << what << " = " << len
+              << ". Only read " << read_items << "/" << len << " chars"
+              << std::endl;
+    throw new std::exception();
+  }
+  return result;
+}
+
+/// This reads the whole OpenSim file in as a string
+std::string readOpenSimFile(const std::string& openSimFilePath)
+{
+  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
+  newRetriever->addSchemaRetriever(
+      "file", std::make_shared<common::LocalResourceRetriever>());
+  newRetriever->addSchemaRetriever(
+      "dart", utils::DartResourceRetriever::create());
+  return newRetriever->readAll(openSimFilePath);
+}
+
+} // namespace
+
+ChannelStats::ChannelStats(int dim)
+  : count(Eigen::VectorXd::Zero(dim)),
+    mean(Eigen::VectorXd::Zero(dim)),
+    m2(Eigen::VectorXd::Zero(dim))
+{
+}
+
+/// This adds a (dim x numFrames) block of frames
+void ChannelStats::addFrames(const Eigen::MatrixXd& frames)
+{
+  // We get the statistics of the block on its own, and then merge them in,
+  // which is both faster and more accurate than adding one value at a time
+  ChannelStats block(frames.rows());
+  for (int i = 0; i < frames.rows(); i++)
+  {
+    double sum = 0;
+    for (int t = 0; t < frames.cols(); t++)
+    {
+      if (std::isfinite(frames(i, t)))
+      {
+        block.count(i) += 1;
+        sum += frames(i, t);
+      }
+    }
+    if (block.count(i) == 0)
+    {
+      continue;
+    }
+    block.mean(i) = sum / block.count(i);
+    for (int t = 0; t < frames.cols(); t++)
+    {
+      if (std::isfinite(frames(i, t)))
+      {
+        const double diff = frames(i, t) - block.mean(i);
+        block.m2(i) += diff * diff;
+      }
+    }
+  }
+  merge(block);
+}
+
+/// This adds in statistics gathered over other frames
+void ChannelStats::merge(const ChannelStats& other)
+{
+  if (count.size() == 0)
+  {
+    *this = other;
+    return;
+  }
+  if (other.count.size() != count.size())
+  {
+    std::cout << "ChannelStats::merge() got stats with dimension "
+              << other.count.size() << " instead of " << count.size()
+              << ". Ignoring call." << std::endl;
+    return;
+  }
+  for (int i = 0; i < count.size(); i++)
+  {
+    const double total = count(i) + other.count(i);
+    if (other.count(i) == 0)
+    {
+      continue;
+    }
+    const double delta = other.mean(i) - mean(i);
+    mean(i) += delta * other.count(i) / total;
+    m2(i) += other.m2(i) + delta * delta * count(i) * other.count(i) / total;
+    count(i) = total;
+  }
+}
+
+/// This returns the variance of each dimension, or 0 where there were no
+/// values
+Eigen::VectorXd ChannelStats::getVariance() const
+{
+  Eigen::VectorXd variance = Eigen::VectorXd::Zero(count.size());
+  for (int i = 0; i < count.size(); i++)
+  {
+    if (count(i) > 0)
+    {
+      variance(i) = m2(i) / count(i);
+    }
+  }
+  return variance;
+}
+
+/// This returns the standard deviation of each dimension
+Eigen::VectorXd ChannelStats::getStd() const
+{
+  return getVariance().cwiseSqrt();
+}
+
 SubjectOnDisk::SubjectOnDisk(
     const std::string& path, bool printDebuggingDetails)
-  : mPath(path)
+  : mPath(path),
+    mPrintDebuggingDetails(printDebuggingDetails),
+    mChannelStatsOffset(-1)
 {
   FILE* file = fopen(path.c_str(), "r");
   if (file == nullptr)
@@ -55,108 +334,62 @@ SubjectOnDisk::SubjectOnDisk(
               << path << ": bad header.magic = " << header.magic << std::endl;
     throw new std::exception();
   }
-  if (header.version != 1)
+  if (header.version != 1 && header.version != 2)
   {
     std::cout << "SubjectOnDisk attempting to read a binary file with "
                  "unsupported version "
-              << header.version << " (currently only support version 1)"
+              << header.version << " (currently only support versions 1 and 2)"
               << std::endl;
     throw new std::exception();
   }
 
+  mFormatVersion = header.version;
   mNumDofs = header.numDofs;
   mNumTrials = header.numTrials;
-
-  // Read the href
-  int32_t hrefLen;
-  read_items = fread(&hrefLen, sizeof(int32_t), 1, file);
-  if (hrefLen < 0 || hrefLen > 2000 || read_items != 1)
+  if (mNumTrials < 0 || mNumTrials > 100000)
   {
     std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
-              << path << ": bad string len for href = " << hrefLen << std::endl;
+              << path << ": bad number of trials = " << mNumTrials << std::endl;
     throw new std::exception();
   }
-  char* hrefRaw = (char*)malloc(sizeof(char) * (hrefLen + 1));
-  read_items = fread(hrefRaw, sizeof(char), hrefLen, file);
-  (void)read_items;
-  hrefRaw[hrefLen] = 0;
-  mHref = std::string(hrefRaw);
-  free(hrefRaw);
 
-  // Read the notes
-  int32_t notesLen;
-  read_items = fread(&notesLen, sizeof(int32_t), 1, file);
-  if (notesLen < 0 || notesLen > 100000 || read_items != 1)
-  {
-    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
-              << path << ": bad string len for notes = " << notesLen
-              << std::endl;
-    throw new std::exception();
-  }
-  char* notesRaw = (char*)malloc(sizeof(char) * (notesLen + 1));
-  read_items = fread(notesRaw, sizeof(char), notesLen, file);
-  (void)read_items;
-  notesRaw[notesLen] = 0;
-  mNotes = std::string(notesRaw);
-  free(notesRaw);
+  mProbablyMissingGRF.resize(mNumTrials);
+  mChunkIndex.resize(mNumTrials);
+  mTrialLoaded.reset(new std::once_flag[mNumTrials]);
 
-  // Read trial names
-  for (int i = 0; i < mNumTrials; i++)
+  if (mFormatVersion == 2)
   {
-    int32_t len;
-    read_items = fread(&len, sizeof(int32_t), 1, file);
-    if (len < 0 || len > 255 || read_items != 1)
+    // Version 2 files have a table of where each section starts right after
+    // the header, so we can skip straight to the few things every read needs,
+    // and leave everything else until someone asks for it
+    read_items = fread(&mSectionOffsets, sizeof(SectionOffsets), 1, file);
+    if (read_items != 1)
     {
       std::cout
           << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": bad string len for trial [" << i << "] name = " << len
-          << std::endl;
-      throw new std::exception();
-    }
-    char* rawTrialName = (char*)malloc(sizeof(char) * (len + 1));
-    read_items = fread(rawTrialName, sizeof(char), len, file);
-    if (read_items != len) {
-      std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": bad string len for trial [" << i << "] name = " << len
-          << ". Only read " << read_items << "/" << len << " chars" << std::endl;
+          << path << ": section table suddenly reached EOF" << std::endl;
       throw new std::exception();
     }
-    rawTrialName[len] = 0;
-    std::string trialName(rawTrialName);
-    mTrialNames.push_back(trialName);
-    if (printDebuggingDetails)
-    {
-      std::cout << "Read trial name: " << trialName << std::endl;
-    }
-    free(rawTrialName);
+    fseek(file, mSectionOffsets.contactBodies, SEEK_SET);
+  }
+  else
+  {
+    mHref = readString(file, path, 2000, "href");
+    mNotes = readString(file, path, 100000, "notes");
+    readTrialNames(file);
   }
 
   // Read contact body names
   int32_t numContactBodies = header.numGroundContactBodies;
   for (int i = 0; i < numContactBodies; i++)
   {
-    int32_t len;
-    read_items = fread(&len, sizeof(int32_t), 1, file);
-    if (len < 0 || len > 255 || read_items != 1)
-    {
-      std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": bad string len for contact body [" << i
-          << "] name = " << len << std::endl;
-      throw new std::exception();
-    }
-    char* body = (char*)malloc(sizeof(char) * (len + 1));
-    read_items = fread(body, sizeof(char), len, file);
-    (void)read_items;
-    body[len] = 0;
-    std::string bodyName(body);
+    std::string bodyName = readString(
+        file, path, 255, "contact body [" + std::to_string(i) + "] name");
     mGroundContactBodies.push_back(bodyName);
     if (printDebuggingDetails)
     {
       std::cout << "Read contact body name: " << bodyName << std::endl;
     }
-    free(body);
   }
 
   // Read custom value names and sizes
@@ -175,21 +408,8 @@ SubjectOnDisk::SubjectOnDisk(
       throw new std::exception();
     }
     customValuesTotalDim += dataLen;
-    int32_t strLen;
-    read_items = fread(&strLen, sizeof(int32_t), 1, file);
-    if (strLen < 0 || strLen > 512 || read_items != 1)
-    {
-      std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": bad string length for custom value [" << i
-          << "] name = " << strLen << std::endl;
-      throw new std::exception();
-    }
-    char* custom = (char*)malloc(sizeof(char) * (strLen + 1));
-    read_items = fread(custom, sizeof(char), strLen, file);
-    (void)read_items;
-    custom[strLen] = 0;
-    std::string customValue(custom);
+    std::string customValue = readString(
+        file, path, 512, "custom value [" + std::to_string(i) + "] name");
     mCustomValues.push_back(customValue);
     mCustomValueLengths.push_back(dataLen);
     if (printDebuggingDetails)
@@ -197,102 +417,1075 @@ SubjectOnDisk::SubjectOnDisk(
       std::cout << "Read custom value: " << customValue
                 << " with length = " << dataLen << std::endl;
     }
-    free(custom);
   }
 
-  // Read trial lengths
-  for (int i = 0; i < mNumTrials; i++)
+  if (mFormatVersion == 2)
+  {
+    mModelLength = mSectionOffsets.modelLength;
+    mModelSectionStart = mSectionOffsets.model;
+    mDataSectionStart = mSectionOffsets.chunkFrames;
+  }
+  else
+  {
+    readTrialLengths(file);
+    readTrialTimesteps(file);
+    for (int i = 0; i < mNumTrials; i++)
+    {
+      readProbablyMissingGRF(file, i);
+    }
+
+    int32_t modelLen;
+    read_items = fread(&modelLen, sizeof(int32_t), 1, file);
+    if (read_items != 1)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << path << ": model length section suddenly reached EOF"
+          << std::endl;
+      throw new std::exception();
+    }
+    mModelLength = modelLen;
+    mModelSectionStart = ftell(file);
+    mDataSectionStart = mModelSectionStart + modelLen;
+  }
+
+  // Magic number, pos, vel, acc, tau, contact wrenches, and custom values
+  mFrameSize = sizeof(int32_t)
+               + (((mNumDofs * 4) + (mGroundContactBodies.size() * 6)
+                   + (mGroundContactBodies.size() * 9) + customValuesTotalDim)
+                  * sizeof(float64_t));
+
+  fseek(file, 0, SEEK_END);
+  mFileSize = ftell(file);
+
+  if (mFormatVersion == 2
+      && mFileSize >= sizeof(struct FileHeader) + sizeof(SectionOffsets)
+                          + 2 * sizeof(int64_t))
+  {
+    int64_t trailer[2];
+    fseek(file, mFileSize - sizeof(trailer), SEEK_SET);
+    read_items = fread(trailer, sizeof(trailer), 1, file);
+    int32_t magic;
+    memcpy(&magic, reinterpret_cast<char*>(trailer) + 12, sizeof(int32_t));
+    if (read_items == 1 && magic == CHANNEL_STATS_TRAILER_MAGIC
+        && trailer[0] > 0 && trailer[0] < (int64_t)mFileSize)
+    {
+      mChannelStatsOffset = trailer[0];
+    }
+  }
+
+  fclose(file);
+}
+
+/// This reads the metadata for all the trials (names, lengths, timesteps and
+/// chunk lengths), along with the href and notes, the first time it's called
+/// on a version 2 file. Version 1 files read all that in the constructor, so
+/// this does nothing on those.
+void SubjectOnDisk::loadMetadata()
+{
+  if (mFormatVersion == 1)
+  {
+    return;
+  }
+  std::call_once(mMetadataLoaded, [this]() {
+    FILE* file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to open file that deos not exist: "
+          << mPath << std::endl;
+      throw new std::exception();
+    }
+
+    fseek(file, mSectionOffsets.href, SEEK_SET);
+    mHref = readString(file, mPath, 2000, "href");
+    fseek(file, mSectionOffsets.notes, SEEK_SET);
+    mNotes = readString(file, mPath, 100000, "notes");
+    fseek(file, mSectionOffsets.trialNames, SEEK_SET);
+    readTrialNames(file);
+    fseek(file, mSectionOffsets.trialLengths, SEEK_SET);
+    readTrialLengths(file);
+    fseek(file, mSectionOffsets.trialTimesteps, SEEK_SET);
+    readTrialTimesteps(file);
+
+    fseek(file, mSectionOffsets.chunkFrames, SEEK_SET);
+    int32_t magic;
+    int read_items = fread(&magic, sizeof(int32_t), 1, file);
+    if (magic != 424242 || read_items != 1)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << mPath << ": before the chunk index, got bad magic = " << magic
+          << std::endl;
+      throw new std::exception();
+    }
+    for (int i = 0; i < mNumTrials; i++)
+    {
+      int32_t chunkFrames;
+      read_items = fread(&chunkFrames, sizeof(int32_t), 1, file);
+      if (chunkFrames <= 0 || read_items != 1)
+      {
+        std::cout
+            << "SubjectOnDisk attempting to read a corrupted binary file at "
+            << mPath << ": bad chunk length for trial [" << i
+            << "] = " << chunkFrames << std::endl;
+        throw new std::exception();
+      }
+      mChunkFrames.push_back(chunkFrames);
+    }
+
+    fclose(file);
+
+    // Work out where each trial's part of the per-trial sections starts
+    const int numChannels = NUM_FIXED_CHANNELS + mCustomValues.size();
+    long probablyMissingGRFOffset = mSectionOffsets.probablyMissingGRF;
+    long chunkIndexOffset = mSectionOffsets.chunkIndex;
+    for (int i = 0; i < mNumTrials; i++)
+    {
+      mProbablyMissingGRFOffsets.push_back(probablyMissingGRFOffset);
+      mChunkIndexOffsets.push_back(chunkIndexOffset);
+      probablyMissingGRFOffset += sizeof(int32_t) + mTrialLength[i];
+      const int numChunks
+          = (mTrialLength[i] + mChunkFrames[i] - 1) / mChunkFrames[i];
+      chunkIndexOffset += numChunks * numChannels * sizeof(ChunkLocation);
+    }
+  });
+}
+
+/// This reads the probablyMissingGRF flags and chunk index of a trial the
+/// first time it's called for that trial on a version 2 file. Version 1 files
+/// read all that in the constructor, so this does nothing on those.
+void SubjectOnDisk::loadTrial(int trial)
+{
+  if (mFormatVersion == 1)
+  {
+    return;
+  }
+  loadMetadata();
+  std::call_once(mTrialLoaded[trial], [this, trial]() {
+    FILE* file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to open file that deos not exist: "
+          << mPath << std::endl;
+      throw new std::exception();
+    }
+
+    fseek(file, mProbablyMissingGRFOffsets[trial], SEEK_SET);
+    readProbablyMissingGRF(file, trial);
+
+    const int numChannels = NUM_FIXED_CHANNELS + mCustomValues.size();
+    const int numChunks = (mTrialLength[trial] + mChunkFrames[trial] - 1)
+                          / mChunkFrames[trial];
+    std::vector<ChunkLocation> chunks(numChunks * numChannels);
+    fseek(file, mChunkIndexOffsets[trial], SEEK_SET);
+    int read_items = 0;
+    if (chunks.size() > 0)
+    {
+      read_items
+          = fread(chunks.data(), sizeof(ChunkLocation), chunks.size(), file);
+    }
+    if (read_items != chunks.size())
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << mPath << ": chunk index suddenly reached EOF" << std::endl;
+      throw new std::exception();
+    }
+    mChunkIndex[trial] = chunks;
+
+    fclose(file);
+  });
+}
+
+/// This reads the trial names section, starting at the current position in
+/// `file`
+void SubjectOnDisk::readTrialNames(FILE* file)
+{
+  for (int i = 0; i < mNumTrials; i++)
+  {
+    std::string trialName = readString(
+        file, mPath, 255, "trial [" + std::to_string(i) + "] name");
+    mTrialNames.push_back(trialName);
+    if (mPrintDebuggingDetails)
+    {
+      std::cout << "Read trial name: " << trialName << std::endl;
+    }
+  }
+}
+
+/// This reads the trial lengths section, starting at the current position in
+/// `file`
+void SubjectOnDisk::readTrialLengths(FILE* file)
+{
+  for (int i = 0; i < mNumTrials; i++)
+  {
+    int32_t len;
+    int read_items = fread(&len, sizeof(int32_t), 1, file);
+    if (len < 0 || len > 10000000 || read_items != 1)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << mPath << ": bad trial len for trial [" << i << "] = " << len
+          << std::endl;
+      throw new std::exception();
+    }
+    if (mPrintDebuggingDetails)
+    {
+      std::cout << "Read trial " << i << " len = " << len << std::endl;
+    }
+    mTrialLength.push_back((int)len);
+  }
+}
+
+/// This reads the trial timesteps section, starting at the current position
+/// in `file`
+void SubjectOnDisk::readTrialTimesteps(FILE* file)
+{
+  for (int i = 0; i < mNumTrials; i++)
+  {
+    double timestep;
+    int read_items = fread(&timestep, sizeof(double), 1, file);
+    if (read_items != 1)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << mPath << ": trial timesteps suddenly reached EOF" << std::endl;
+      throw new std::exception();
+    }
+    if (mPrintDebuggingDetails)
+    {
+      std::cout << "Read trial " << i << " timestep = " << timestep
+                << std::endl;
+    }
+    mTrialTimesteps.push_back(timestep);
+  }
+}
+
+/// This reads the probablyMissingGRF flags for one trial, starting at the
+/// current position in `file`
+void SubjectOnDisk::readProbablyMissingGRF(FILE* file, int trial)
+{
+  // Read a magic header, to make sure we don't get lost
+  int32_t magic;
+  int read_items = fread(&magic, sizeof(int32_t), 1, file);
+  if (magic != 424242 || read_items != 1)
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << mPath << ": before the probablyMissingGRF array for trial "
+              << trial << ", got bad magic = " << magic << std::endl;
+    throw new std::exception();
+  }
+
+  // Read the whole trial's flags in one go, rather than a byte at a time
+  std::vector<int8_t> raw(mTrialLength[trial]);
+  read_items = 0;
+  if (raw.size() > 0)
+  {
+    read_items = fread(raw.data(), sizeof(int8_t), raw.size(), file);
+  }
+  if (read_items != raw.size())
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << mPath << ": probablyMissingGRF section suddenly reached EOF"
+              << std::endl;
+    throw new std::exception();
+  }
+  mProbablyMissingGRF[trial] = std::vector<bool>(raw.begin(), raw.end());
+}
+
+FrameView::FrameView(
+    const std::shared_ptr<const char>& mapping,
+    const double* data,
+    int numDofs,
+    int numGroundContactBodies)
+  : pos(data, numDofs),
+    vel(data + numDofs, numDofs),
+    acc(data + 2 * numDofs, numDofs),
+    tau(data + 3 * numDofs, numDofs),
+    groundContactWrenches(data + 4 * numDofs, 6, numGroundContactBodies),
+    groundContactCenterOfPressure(
+        data + 4 * numDofs + 6 * numGroundContactBodies,
+        3,
+        numGroundContactBodies,
+        Eigen::OuterStride<>(9)),
+    groundContactTorque(
+        data + 4 * numDofs + 6 * numGroundContactBodies + 3,
+        3,
+        numGroundContactBodies,
+        Eigen::OuterStride<>(9)),
+    groundContactForce(
+        data + 4 * numDofs + 6 * numGroundContactBodies + 6,
+        3,
+        numGroundContactBodies,
+        Eigen::OuterStride<>(9)),
+    mapping(mapping)
+{
+  // Do nothing
+}
+
+/// This returns the memory-mapped contents of our file, mapping it first if
+/// this is the first time anyone has asked
+std::shared_ptr<const char> SubjectOnDisk::getMapping()
+{
+  std::shared_ptr<const char> mapping = std::atomic_load(&mMapping);
+  if (mapping)
+    return mapping;
+
+  int fd = open(mPath.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    std::cout << "SubjectOnDisk attempting to map file that deos not exist: "
+              << mPath << std::endl;
+    throw new std::exception();
+  }
+  void* data = mmap(nullptr, mFileSize, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the file is closed
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    std::cout << "SubjectOnDisk failed to memory-map file " << mPath
+              << std::endl;
+    throw new std::exception();
+  }
+
+  const std::size_t size = mFileSize;
+  mapping = std::shared_ptr<const char>(
+      static_cast<const char*>(data),
+      [size](const char* ptr) { munmap(const_cast<char*>(ptr), size); });
+
+  // If another thread beat us to it, use their mapping, and let ours go
+  std::shared_ptr<const char> expected;
+  if (!std::atomic_compare_exchange_strong(&mMapping, &expected, mapping))
+    return expected;
+  return mapping;
+}
+
+/// This is the zero-copy version of readFrames(), which reads frames straight
+/// out of a memory-mapped copy of the file.
+///
+/// On OOB access, prints an error and returns an empty vector.
+std::vector<FrameView> SubjectOnDisk::readFrameViews(
+    int trial, int startFrame, int numFramesToRead)
+{
+  std::vector<FrameView> result;
+
+  if (trial < 0 || trial >= mNumTrials || startFrame < 0)
+  {
+    std::cout << "SubjectOnDisk::readFrameViews() got out of bounds trial "
+              << trial << " frame " << startFrame << ". Returning empty vector."
+              << std::endl;
+    return result;
+  }
+
+  if (mFormatVersion != 1)
+  {
+    std::cout << "SubjectOnDisk::readFrameViews() only works on version 1 "
+                 "files, but "
+              << mPath << " is version " << mFormatVersion
+              << ". Use readChannelWindow() instead. Returning empty vector."
+              << std::endl;
+    return result;
+  }
+
+  int linearFrameStart = 0;
+  for (int i = 0; i < trial; i++)
+  {
+    linearFrameStart += mTrialLength[i];
+  }
+  linearFrameStart += startFrame;
+
+  int remainingFrames = mTrialLength[trial] - startFrame;
+  if (remainingFrames < numFramesToRead)
+  {
+    numFramesToRead = remainingFrames;
+  }
+
+  if (numFramesToRead <= 0)
+  {
+    // return an empty result
+    return result;
+  }
+
+  const std::size_t firstFrameOffset
+      = mDataSectionStart + (std::size_t)mFrameSize * linearFrameStart;
+  if (firstFrameOffset + (std::size_t)mFrameSize * numFramesToRead
+      > mFileSize)
+  {
+    std::cout << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << mPath << ": frame data for frame " << startFrame
+              << " runs past the end of the file" << std::endl;
+    throw new std::exception();
+  }
+
+  std::shared_ptr<const char> mapping = getMapping();
+  result.reserve(numFramesToRead);
+  for (int i = 0; i < numFramesToRead; i++)
+  {
+    const char* frameStart
+        = mapping.get() + firstFrameOffset + (std::size_t)mFrameSize * i;
+
+    int32_t magic;
+    memcpy(&magic, frameStart, sizeof(int32_t));
+    if (magic != 424242)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to read a corrupted binary file at "
+          << mPath << ": before frame " << linearFrameStart + i << " (trial "
+          << trial << " frame " << startFrame + i
+          << "), got bad magic = " << magic << std::endl;
+      throw new std::exception();
+    }
+
+    // The frame data isn't 8-byte aligned, because of the magic number, but
+    // Eigen::Map doesn't assume alignment, and x86 and ARM both handle
+    // unaligned loads of doubles
+    const double* data
+        = reinterpret_cast<const double*>(frameStart + sizeof(int32_t));
+    result.emplace_back(
+        mapping, data, mNumDofs, (int)mGroundContactBodies.size());
+    FrameView& frame = result.back();
+    frame.trial = trial;
+    frame.t = startFrame + i;
+    frame.dt = mTrialTimesteps[trial];
+    frame.probablyMissingGRF = mProbablyMissingGRF[trial][frame.t];
+
+    const double* custom
+        = data + 4 * mNumDofs + 15 * mGroundContactBodies.size();
+    frame.customValues.reserve(mCustomValues.size());
+    for (int b = 0; b < mCustomValues.size(); b++)
+    {
+      frame.customValues.emplace_back(custom, mCustomValueLengths[b]);
+      custom += mCustomValueLengths[b];
+    }
+  }
+
+  return result;
+}
+
+/// This returns the number of bytes from the start of one frame on disk to the
+/// start of the next.
+int SubjectOnDisk::getFrameSizeBytes()
+{
+  return mFrameSize;
+}
+
+/// This reads just the requested channels for a run of frames, and returns one
+/// (channelDim x numFrames) matrix per channel, in the order asked for.
+///
+/// On OOB access or an unknown channel name, prints an error and returns an
+/// empty vector.
+std::vector<Eigen::MatrixXd> SubjectOnDisk::readChannelWindow(
+    int trial,
+    int startFrame,
+    int numFramesToRead,
+    const std::vector<std::string>& channels)
+{
+  std::vector<int> channelIndices;
+  for (const std::string& channel : channels)
+  {
+    int index = getChannelIndex(channel);
+    if (index == -1)
+    {
+      std::cout << "SubjectOnDisk::readChannelWindow() got unknown channel \""
+                << channel << "\". Returning empty vector." << std::endl;
+      return std::vector<Eigen::MatrixXd>();
+    }
+    channelIndices.push_back(index);
+  }
+  return readChannels(trial, startFrame, numFramesToRead, channelIndices);
+}
+
+/// This is readChannelWindow(), but takes channel indices instead of names,
+/// and optionally an already open file to read from.
+std::vector<Eigen::MatrixXd> SubjectOnDisk::readChannels(
+    int trial,
+    int startFrame,
+    int numFramesToRead,
+    const std::vector<int>& channels,
+    FILE* file)
+{
+  std::vector<Eigen::MatrixXd> result;
+
+  if (trial < 0 || trial >= mNumTrials || startFrame < 0)
+  {
+    std::cout << "SubjectOnDisk::readChannelWindow() got out of bounds trial "
+              << trial << " frame " << startFrame << ". Returning empty vector."
+              << std::endl;
+    return result;
+  }
+  loadTrial(trial);
+
+  int remainingFrames = mTrialLength[trial] - startFrame;
+  if (remainingFrames < numFramesToRead)
+  {
+    numFramesToRead = remainingFrames;
+  }
+
+  if (numFramesToRead <= 0)
+  {
+    // return an empty result
+    return result;
+  }
+
+  for (int channel : channels)
+  {
+    result.push_back(Eigen::MatrixXd(getChannelDim(channel), numFramesToRead));
+  }
+
+  const bool ownsFile = file == nullptr;
+  if (ownsFile)
+  {
+    file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to open file that deos not exist: "
+          << mPath << std::endl;
+      throw new std::exception();
+    }
+  }
+
+  int read_items;
+
+  if (mFormatVersion == 1)
+  {
+    // Version 1 files interleave the channels within each frame, so we have
+    // to seek to each channel of each frame in turn
+    const int numChannels = NUM_FIXED_CHANNELS + mCustomValues.size();
+    std::vector<long> channelOffsets;
+    long offset = sizeof(int32_t);
+    for (int c = 0; c < numChannels; c++)
+    {
+      channelOffsets.push_back(offset);
+      offset += getChannelDim(c) * sizeof(float64_t);
+    }
+
+    int linearFrameStart = 0;
+    for (int i = 0; i < trial; i++)
+    {
+      linearFrameStart += mTrialLength[i];
+    }
+    linearFrameStart += startFrame;
+
+    for (int i = 0; i < numFramesToRead; i++)
+    {
+      const long frameStart
+          = mDataSectionStart + (long)mFrameSize * (linearFrameStart + i);
+      for (int k = 0; k < channels.size(); k++)
+      {
+        const int dim = result[k].rows();
+        fseek(file, frameStart + channelOffsets[channels[k]], SEEK_SET);
+        read_items
+            = fread(result[k].col(i).data(), sizeof(float64_t), dim, file);
+        if (read_items != dim)
+        {
+          std::cout
+              << "SubjectOnDisk attempting to read a corrupted binary file at "
+              << mPath << ": frame data for frame " << (startFrame + i)
+              << " had unexpected EOF" << std::endl;
+          throw new std::exception();
+        }
+      }
+    }
+
+    if (ownsFile)
+    {
+      fclose(file);
+    }
+    return result;
+  }
+
+  // Version 2 files keep each channel in its own chunks, so we only read the
+  // chunks of the channels we were asked for that overlap the window
+  const int numChannels = NUM_FIXED_CHANNELS + mCustomValues.size();
+  const int chunkFrames = mChunkFrames[trial];
+  const int firstChunk = startFrame / chunkFrames;
+  const int lastChunk = (startFrame + numFramesToRead - 1) / chunkFrames;
+  std::vector<uint8_t> compressed;
+  std::vector<double> decoded;
+  for (int chunk = firstChunk; chunk <= lastChunk; chunk++)
+  {
+    const int chunkStart = chunk * chunkFrames;
+    const int framesInChunk
+        = std::min(chunkFrames, mTrialLength[trial] - chunkStart);
+    const int copyStart = std::max(startFrame, chunkStart);
+    const int copyEnd
+        = std::min(startFrame + numFramesToRead, chunkStart + framesInChunk);
+
+    for (int k = 0; k < channels.size(); k++)
+    {
+      const int dim = result[k].rows();
+      const ChunkLocation& location
+          = mChunkIndex[trial][chunk * numChannels + channels[k]];
+
+      compressed.resize(location.size);
+      fseek(file, location.offset, SEEK_SET);
+      read_items
+          = fread(compressed.data(), sizeof(uint8_t), location.size, file);
+      if (read_items != location.size)
+      {
+        std::cout
+            << "SubjectOnDisk attempting to read a corrupted binary file at "
+            << mPath << ": chunk " << chunk << " of trial " << trial
+            << " had unexpected EOF" << std::endl;
+        throw new std::exception();
+      }
+
+      decoded.resize((std::size_t)dim * framesInChunk);
+      bool decodedOk = false;
+      if (location.codec == CHUNK_CODEC_RAW)
+      {
+        decodedOk = location.size == decoded.size() * sizeof(float64_t);
+        if (decodedOk)
+        {
+          memcpy(decoded.data(), compressed.data(), location.size);
+        }
+      }
+      else if (location.codec == CHUNK_CODEC_XOR_SHUFFLE_RLE)
+      {
+        decodedOk = decodeChunk(
+            compressed.data(),
+            compressed.size(),
+            dim,
+            framesInChunk,
+            decoded.data());
+      }
+      if (!decodedOk)
+      {
+        std::cout
+            << "SubjectOnDisk attempting to read a corrupted binary file at "
+            << mPath << ": chunk " << chunk << " of trial " << trial
+            << " with codec " << location.codec << " failed to decode"
+            << std::endl;
+        throw new std::exception();
+      }
+
+      result[k].middleCols(copyStart - startFrame, copyEnd - copyStart)
+          = Eigen::Map<const Eigen::MatrixXd>(
+                decoded.data(), dim, framesInChunk)
+                .middleCols(copyStart - chunkStart, copyEnd - copyStart);
+    }
+  }
+
+  if (ownsFile)
+  {
+    fclose(file);
+  }
+  return result;
+}
+
+/// This reads a whole minibatch of windows in one call, straight into
+/// preallocated [batch, window, channelDim] output buffers, across threads.
+///
+/// On OOB access or an unknown channel name, prints an error, returns false,
+/// and doesn't touch the outputs.
+bool SubjectOnDisk::readWindowsBatch(
+    const std::vector<std::pair<int, int>>& requests,
+    int windowLen,
+    const std::vector<std::string>& channels,
+    const std::vector<double*>& outputs,
+    int numThreads)
+{
+  loadMetadata();
+
+  if (outputs.size() != channels.size())
+  {
+    std::cout << "SubjectOnDisk::readWindowsBatch() got " << channels.size()
+              << " channels but " << outputs.size() << " outputs" << std::endl;
+    return false;
+  }
+  if (windowLen <= 0)
+  {
+    std::cout << "SubjectOnDisk::readWindowsBatch() got bad window length "
+              << windowLen << std::endl;
+    return false;
+  }
+
+  std::vector<int> channelIndices;
+  std::vector<int> channelDims;
+  for (const std::string& channel : channels)
+  {
+    int index = getChannelIndex(channel);
+    if (index == -1)
+    {
+      std::cout << "SubjectOnDisk::readWindowsBatch() got unknown channel \""
+                << channel << "\"" << std::endl;
+      return false;
+    }
+    channelIndices.push_back(index);
+    channelDims.push_back(getChannelDim(index));
+  }
+
+  // Check everything up front, so we don't leave the outputs half filled in
+  for (int r = 0; r < requests.size(); r++)
+  {
+    const int trial = requests[r].first;
+    const int startFrame = requests[r].second;
+    if (trial < 0 || trial >= mNumTrials || startFrame < 0
+        || startFrame >= mTrialLength[trial])
+    {
+      std::cout << "SubjectOnDisk::readWindowsBatch() got out of bounds trial "
+                << trial << " frame " << startFrame << " for request " << r
+                << std::endl;
+      return false;
+    }
+  }
+
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)requests.size()));
+
+  // Each thread reads a contiguous run of the requests, through its own file
+  // handle, and writes to its own rows of the outputs
+  auto readRequests = [&](int begin, int end) {
+    FILE* file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
+    {
+      std::cout
+          << "SubjectOnDisk attempting to open file that deos not exist: "
+          << mPath << std::endl;
+      throw new std::exception();
+    }
+    for (int r = begin; r < end; r++)
+    {
+      std::vector<Eigen::MatrixXd> windows = readChannels(
+          requests[r].first,
+          requests[r].second,
+          windowLen,
+          channelIndices,
+          file);
+      for (int k = 0; k < channelIndices.size(); k++)
+      {
+        const int dim = channelDims[k];
+        double* out = outputs[k] + (std::size_t)r * windowLen * dim;
+        const int framesRead = windows[k].cols();
+        // Column-major (dim x frames) is the same layout as row-major
+        // (frames x dim)
+        if (framesRead > 0)
+        {
+          memcpy(
+              out,
+              windows[k].data(),
+              sizeof(double) * (std::size_t)dim * framesRead);
+        }
+        memset(
+            out + (std::size_t)dim * framesRead,
+            0,
+            sizeof(double) * (std::size_t)dim * (windowLen - framesRead));
+      }
+    }
+    fclose(file);
+  };
+
+  if (numThreads == 1)
+  {
+    readRequests(0, requests.size());
+    return true;
+  }
+
+  std::vector<std::future<void>> futures;
+  const int requestsPerThread = requests.size() / numThreads;
+  const int remainder = requests.size() % numThreads;
+  int cursor = 0;
+  for (int i = 0; i < numThreads; i++)
+  {
+    const int begin = cursor;
+    const int end = begin + requestsPerThread + (i < remainder ? 1 : 0);
+    cursor = end;
+    futures.push_back(std::async(
+        std::launch::async,
+        [&readRequests, begin, end]() { readRequests(begin, end); }));
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+
+  return true;
+}
+
+/// This returns the number of values per frame in the named channel, or 0 if
+/// there's no such channel
+int SubjectOnDisk::getChannelDim(const std::string& channel)
+{
+  int index = getChannelIndex(channel);
+  if (index == -1)
+  {
+    return 0;
+  }
+  return getChannelDim(index);
+}
+
+/// This reads frames out of a version 2 file, by way of readChannelWindow()
+std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFramesFromChunks(
+    int trial, int startFrame, int numFramesToRead)
+{
+  std::vector<std::shared_ptr<Frame>> result;
+
+  std::vector<int> channels;
+  for (int c = 0; c < NUM_FIXED_CHANNELS + mCustomValues.size(); c++)
+  {
+    channels.push_back(c);
+  }
+  std::vector<Eigen::MatrixXd> data
+      = readChannels(trial, startFrame, numFramesToRead, channels);
+  if (data.size() == 0)
+  {
+    return result;
+  }
+
+  for (int i = 0; i < data[0].cols(); i++)
+  {
+    result.push_back(std::make_shared<Frame>());
+    std::shared_ptr<Frame>& frame = result.at(result.size() - 1);
+    frame->trial = trial;
+    frame->t = startFrame + i;
+    frame->dt = mTrialTimesteps[trial];
+    frame->probablyMissingGRF = mProbablyMissingGRF[trial][frame->t];
+    frame->pos = data[0].col(i);
+    frame->vel = data[1].col(i);
+    frame->acc = data[2].col(i);
+    frame->tau = data[3].col(i);
+    for (int b = 0; b < mGroundContactBodies.size(); b++)
+    {
+      frame->groundContactWrenches.emplace_back(
+          mGroundContactBodies[b], data[4].col(i).segment<6>(b * 6));
+      frame->groundContactCenterOfPressure.emplace_back(
+          mGroundContactBodies[b], data[5].col(i).segment<3>(b * 9));
+      frame->groundContactTorque.emplace_back(
+          mGroundContactBodies[b], data[5].col(i).segment<3>(b * 9 + 3));
+      frame->groundContactForce.emplace_back(
+          mGroundContactBodies[b], data[5].col(i).segment<3>(b * 9 + 6));
+    }
+    for (int b = 0; b < mCustomValues.size(); b++)
+    {
+      frame->customValues.emplace_back(
+          mCustomValues[b], data[NUM_FIXED_CHANNELS + b].col(i));
+    }
+  }
+
+  return result;
+}
+
+/// This reads the same data as readFrames(), but as a single FrameBatch, with
+/// one contiguous matrix per channel
+std::shared_ptr<FrameBatch> SubjectOnDisk::readFrameBatch(
+    int trial, int startFrame, int numFramesToRead)
+{
+  std::shared_ptr<FrameBatch> batch = std::make_shared<FrameBatch>();
+  batch->trial = trial;
+  batch->startFrame = startFrame;
+  batch->numFrames = 0;
+  batch->dt = 0;
+  batch->groundContactBodies = mGroundContactBodies;
+  batch->customValueNames = mCustomValues;
+
+  std::vector<int> channels;
+  for (int c = 0; c < NUM_FIXED_CHANNELS + mCustomValues.size(); c++)
+  {
+    channels.push_back(c);
+  }
+  std::vector<Eigen::MatrixXd> data
+      = readChannels(trial, startFrame, numFramesToRead, channels);
+  if (data.size() == 0)
+  {
+    return batch;
+  }
+
+  // readChannels() gives us one column per frame, and we want one row per
+  // frame, so the row-major transpose has the same memory layout
+  const int numFrames = data[0].cols();
+  const int numBodies = mGroundContactBodies.size();
+  batch->numFrames = numFrames;
+  batch->dt = mTrialTimesteps[trial];
+  batch->probablyMissingGRF.resize(numFrames);
+  for (int i = 0; i < numFrames; i++)
   {
-    int32_t len;
-    read_items = fread(&len, sizeof(int32_t), 1, file);
-    if (len < 0 || len > 10000000 || read_items != 1)
+    batch->probablyMissingGRF(i) = mProbablyMissingGRF[trial][startFrame + i];
+  }
+  batch->pos = data[0].transpose();
+  batch->vel = data[1].transpose();
+  batch->acc = data[2].transpose();
+  batch->tau = data[3].transpose();
+  batch->groundContactWrenches = data[4].transpose();
+  batch->groundContactCenterOfPressure.resize(numFrames, numBodies * 3);
+  batch->groundContactTorque.resize(numFrames, numBodies * 3);
+  batch->groundContactForce.resize(numFrames, numBodies * 3);
+  for (int b = 0; b < numBodies; b++)
+  {
+    batch->groundContactCenterOfPressure.block(0, b * 3, numFrames, 3)
+        = data[5].block(b * 9, 0, 3, numFrames).transpose();
+    batch->groundContactTorque.block(0, b * 3, numFrames, 3)
+        = data[5].block(b * 9 + 3, 0, 3, numFrames).transpose();
+    batch->groundContactForce.block(0, b * 3, numFrames, 3)
+        = data[5].block(b * 9 + 6, 0, 3, numFrames).transpose();
+  }
+  for (int b = 0; b < mCustomValues.size(); b++)
+  {
+    batch->customValues.push_back(data[NUM_FIXED_CHANNELS + b].transpose());
+  }
+
+  return batch;
+}
+
+/// This returns the index of the named channel, or -1 if there's no such
+/// channel.
+int SubjectOnDisk::getChannelIndex(const std::string& channel)
+{
+  static const std::vector<std::string> fixedChannels{
+      "pos",
+      "vel",
+      "acc",
+      "tau",
+      "groundContactWrenches",
+      "groundContactCopTorqueForce"};
+  for (int i = 0; i < fixedChannels.size(); i++)
+  {
+    if (fixedChannels[i] == channel)
     {
-      std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": bad trial len for trial [" << i << "] = " << len
-          << std::endl;
-      throw new std::exception();
+      return i;
     }
-    if (printDebuggingDetails)
+  }
+  for (int i = 0; i < mCustomValues.size(); i++)
+  {
+    if (mCustomValues[i] == channel)
     {
-      std::cout << "Read trial " << i << " len = " << len << std::endl;
+      return NUM_FIXED_CHANNELS + i;
     }
-    mTrialLength.push_back((int)len);
   }
+  return -1;
+}
+
+/// This returns the number of values per frame in a channel
+int SubjectOnDisk::getChannelDim(int channel)
+{
+  if (channel < 4)
+  {
+    return mNumDofs;
+  }
+  if (channel == 4)
+  {
+    return mGroundContactBodies.size() * 6;
+  }
+  if (channel == 5)
+  {
+    return mGroundContactBodies.size() * 9;
+  }
+  return mCustomValueLengths[channel - NUM_FIXED_CHANNELS];
+}
 
-  // Read trial timesteps
-  for (int i = 0; i < mNumTrials; i++)
+/// This returns the number of frames in each chunk of a trial. Version 1 files
+/// don't have chunks, so for those this returns about a second of frames.
+int SubjectOnDisk::getChunkFrames(int trial)
+{
+  if (trial < 0 || trial >= mNumTrials)
   {
-    double timestep;
-    read_items = fread(&timestep, sizeof(double), 1, file);
-    if (read_items != 1)
+    return 0;
+  }
+  loadMetadata();
+  if (mFormatVersion == 2)
+  {
+    return mChunkFrames[trial];
+  }
+  s_t dt = mTrialTimesteps[trial];
+  int frames = dt > 0 ? (int)std::round(1.0 / dt) : 100;
+  return std::max(frames, 1);
+}
+
+/// This returns the version of the binary format of this file.
+int SubjectOnDisk::getFormatVersion()
+{
+  return mFormatVersion;
+}
+
+/// This returns the statistics of the named channel over every frame of every
+/// trial.
+///
+/// On an unknown channel name, prints an error and returns empty stats.
+ChannelStats SubjectOnDisk::getChannelStats(const std::string& channel)
+{
+  const int index = getChannelIndex(channel);
+  if (index == -1)
+  {
+    std::cout << "SubjectOnDisk::getChannelStats() got unknown channel \""
+              << channel << "\". Returning empty stats." << std::endl;
+    return ChannelStats();
+  }
+  loadChannelStats();
+  return mChannelStats[index];
+}
+
+/// This returns true if this file has channel statistics stored in it
+bool SubjectOnDisk::hasStoredChannelStats()
+{
+  return mChannelStatsOffset != -1;
+}
+
+/// This reads (or works out) the statistics of every channel, the first time
+/// it's called.
+void SubjectOnDisk::loadChannelStats()
+{
+  std::call_once(mChannelStatsLoaded, [this]() {
+    const int numChannels = NUM_FIXED_CHANNELS + mCustomValues.size();
+    FILE* file = fopen(mPath.c_str(), "r");
+    if (file == nullptr)
     {
       std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": trial timesteps suddenly reached EOF" << std::endl;
+          << "SubjectOnDisk attempting to open file that deos not exist: "
+          << mPath << std::endl;
       throw new std::exception();
     }
-    (void)read_items;
-    if (printDebuggingDetails)
+
+    if (mChannelStatsOffset != -1)
     {
-      std::cout << "Read trial " << i << " timestep = " << timestep
+      fseek(file, mChannelStatsOffset, SEEK_SET);
+      int32_t header[2];
+      bool ok = fread(header, sizeof(int32_t), 2, file) == 2
+                && header[0] == 424242 && header[1] == numChannels;
+      for (int c = 0; ok && c < numChannels; c++)
+      {
+        int32_t dim;
+        ok = fread(&dim, sizeof(int32_t), 1, file) == 1
+             && dim == getChannelDim(c);
+        ChannelStats stats(ok ? dim : 0);
+        ok = ok && fread(stats.count.data(), sizeof(double), dim, file) == dim
+             && fread(stats.mean.data(), sizeof(double), dim, file) == dim
+             && fread(stats.m2.data(), sizeof(double), dim, file) == dim;
+        mChannelStats.push_back(stats);
+      }
+      if (ok)
+      {
+        fclose(file);
+        return;
+      }
+      std::cout << "SubjectOnDisk found corrupted channel statistics in "
+                << mPath << ", so working them out from the frames instead"
                 << std::endl;
+      mChannelStats.clear();
     }
-    mTrialTimesteps.push_back(timestep);
-  }
 
-  // Read the `probablyMissingGrf` data
-  for (int i = 0; i < mNumTrials; i++)
-  {
-    // Read a magic header, to make sure we don't get lost
-    int32_t magic;
-    read_items = fread(&magic, sizeof(int32_t), 1, file);
-    if (magic != 424242 || read_items != 1)
+    // Without stored statistics, we have to go through every frame
+    std::vector<int> channels;
+    for (int c = 0; c < numChannels; c++)
     {
-      std::cout
-          << "SubjectOnDisk attempting to read a corrupted binary file at "
-          << path << ": before the probablyMissingGRF array for trial " << i
-          << ", got bad magic = " << magic << std::endl;
-      throw new std::exception();
+      channels.push_back(c);
+      mChannelStats.emplace_back(getChannelDim(c));
     }
-
-    std::vector<bool> probablyMissingGRF;
-    for (int t = 0; t < mTrialLength[i]; t++)
+    for (int trial = 0; trial < mNumTrials; trial++)
     {
-      int8_t b;
-      read_items = fread(&b, sizeof(int8_t), 1, file);
-      if (read_items != 1)
+      std::vector<Eigen::MatrixXd> values
+          = readChannels(trial, 0, getTrialLength(trial), channels, file);
+      for (int c = 0; c < values.size(); c++)
       {
-        std::cout
-            << "SubjectOnDisk attempting to read a corrupted binary file at "
-            << path << ": probablyMissingGRF section suddenly reached EOF" << std::endl;
-        throw new std::exception();
+        mChannelStats[c].addFrames(values[c]);
       }
-      probablyMissingGRF.push_back(b);
     }
-    mProbablyMissingGRF.push_back(probablyMissingGRF);
-  }
-
-  int32_t modelLen;
-  read_items = fread(&modelLen, sizeof(int32_t), 1, file);
-  if (read_items != 1)
-  {
-    std::cout
-        << "SubjectOnDisk attempting to read a corrupted binary file at "
-        << path << ": model length section suddenly reached EOF" << std::endl;
-    throw new std::exception();
-  }
-  mModelLength = modelLen;
-  mModelSectionStart = ftell(file);
-  mDataSectionStart = mModelSectionStart + modelLen;
-
-  // Magic number, pos, vel, acc, tau, contact wrenches, and custom values
-  mFrameSize = sizeof(int32_t)
-               + (((mNumDofs * 4) + (mGroundContactBodies.size() * 6)
-                   + (mGroundContactBodies.size() * 9) + customValuesTotalDim)
-                  * sizeof(float64_t));
-
-  fclose(file);
+    fclose(file);
+  });
 }
 
 /// This will read the skeleton from the binary, and optionally use the passed
@@ -347,6 +1540,11 @@ std::vector<std::shared_ptr<Frame>> SubjectOnDisk::readFrames(
   (void)startFrame;
   (void)numFramesToRead;
 
+  if (mFormatVersion == 2)
+  {
+    return readFramesFromChunks(trial, startFrame, numFramesToRead);
+  }
+
   std::vector<std::shared_ptr<Frame>> result;
 
   FILE* file = fopen(mPath.c_str(), "r");
@@ -541,7 +1739,8 @@ void SubjectOnDisk::writeSubject(
     // came from after its been aggregated
     std::vector<std::string> trialNames,
     const std::string& sourceHref,
-    const std::string& notes)
+    const std::string& notes,
+    int formatVersion)
 {
   (void)outputPath;
   (void)openSimFilePath;
@@ -557,13 +1756,57 @@ void SubjectOnDisk::writeSubject(
   (void)customValueNames;
   (void)customValues;
 
-  // Read the whole OpenSim file in as a string
-  auto newRetriever = std::make_shared<utils::CompositeResourceRetriever>();
-  newRetriever->addSchemaRetriever(
-      "file", std::make_shared<common::LocalResourceRetriever>());
-  newRetriever->addSchemaRetriever(
-      "dart", utils::DartResourceRetriever::create());
-  const std::string openSimRawXML = newRetriever->readAll(openSimFilePath);
+  if (formatVersion != 1 && formatVersion != 2)
+  {
+    std::cout << "SubjectOnDisk::writeSubject() got unsupported version "
+              << formatVersion << " (currently only support versions 1 and 2)"
+              << std::endl;
+    return;
+  }
+
+  if (formatVersion == 2)
+  {
+    std::vector<int> customValueDims;
+    for (int i = 0; i < customValueNames.size(); i++)
+    {
+      customValueDims.push_back(customValues[0][i].rows());
+    }
+    SubjectWriter writer(
+        outputPath,
+        openSimFilePath,
+        groundForceBodies,
+        customValueNames,
+        customValueDims,
+        sourceHref,
+        notes);
+    for (int trial = 0; trial < trialPoses.size(); trial++)
+    {
+      writer.startTrial(
+          trialNames.size() > trial ? trialNames[trial] : "",
+          trialTimesteps[trial]);
+      for (int t = 0; t < trialPoses[trial].cols(); t++)
+      {
+        std::vector<Eigen::VectorXs> frameCustomValues;
+        for (int i = 0; i < customValueNames.size(); i++)
+        {
+          frameCustomValues.push_back(customValues[trial][i].col(t));
+        }
+        writer.appendFrame(
+            trialPoses[trial].col(t),
+            trialVels[trial].col(t),
+            trialAccs[trial].col(t),
+            trialTaus[trial].col(t),
+            trialGroundBodyWrenches[trial].col(t),
+            trialGroundBodyCopTorqueForce[trial].col(t),
+            frameCustomValues,
+            probablyMissingGRF[trial][t]);
+      }
+    }
+    writer.close();
+    return;
+  }
+
+  const std::string openSimRawXML = readOpenSimFile(openSimFilePath);
 
   FILE* file = fopen(outputPath.c_str(), "w");
   if (file == nullptr)
@@ -731,6 +1974,345 @@ void SubjectOnDisk::writeSubject(
   fclose(file);
 }
 
+SubjectWriter::SubjectWriter(
+    const std::string& outputPath,
+    const std::string& openSimFilePath,
+    const std::vector<std::string>& groundForceBodies,
+    const std::vector<std::string>& customValueNames,
+    const std::vector<int>& customValueDims,
+    const std::string& sourceHref,
+    const std::string& notes)
+  : mFile(nullptr),
+    mPath(outputPath),
+    mGroundForceBodies(groundForceBodies),
+    mCustomValueNames(customValueNames),
+    mCustomValueDims(customValueDims),
+    mHref(sourceHref),
+    mNotes(notes),
+    mNumDofs(-1),
+    mBufferedFrames(0)
+{
+  memset(&mOffsets, 0, sizeof(SubjectOnDisk::SectionOffsets));
+
+  if (customValueDims.size() != customValueNames.size())
+  {
+    std::cout << "SubjectWriter got " << customValueNames.size()
+              << " custom value names but " << customValueDims.size()
+              << " custom value dims" << std::endl;
+    return;
+  }
+
+  const std::string openSimRawXML = readOpenSimFile(openSimFilePath);
+
+  mFile = fopen(outputPath.c_str(), "w");
+  if (mFile == nullptr)
+  {
+    std::cout << "SubjectWriter failed to open " << outputPath << std::endl;
+    return;
+  }
+
+  // Leave room for the header and the section table, which we fill in once
+  // we know what's in the file
+  struct FileHeader header;
+  memset(&header, 0, sizeof(struct FileHeader));
+  fwrite(&header, sizeof(struct FileHeader), 1, mFile);
+  fwrite(&mOffsets, sizeof(SubjectOnDisk::SectionOffsets), 1, mFile);
+
+  // Embed the model file XML directly in the binary
+  int32_t modelLen = openSimRawXML.size();
+  fwrite(&modelLen, sizeof(int32_t), 1, mFile);
+  mOffsets.modelLength = modelLen;
+  mOffsets.model = ftell(mFile);
+  fwrite(openSimRawXML.c_str(), sizeof(char), modelLen, mFile);
+}
+
+/// This closes the file, if close() hasn't been called already
+SubjectWriter::~SubjectWriter()
+{
+  close();
+}
+
+/// This starts a new trial, finishing off the previous one (if any)
+void SubjectWriter::startTrial(const std::string& name, s_t timestep)
+{
+  if (mFile == nullptr)
+  {
+    return;
+  }
+  flushChunk();
+
+  mTrialNames.push_back(name);
+  mTrialTimesteps.push_back(timestep);
+  mTrialLengths.push_back(0);
+  int32_t frames = timestep > 0 ? (int32_t)std::round(1.0 / timestep) : 100;
+  mChunkFrames.push_back(std::max(frames, 1));
+  mProbablyMissingGRF.emplace_back();
+  mChunkIndex.emplace_back();
+  mChunkBuffers.clear();
+}
+
+/// This appends a frame to the current trial.
+bool SubjectWriter::appendFrame(
+    const Eigen::VectorXs& pos,
+    const Eigen::VectorXs& vel,
+    const Eigen::VectorXs& acc,
+    const Eigen::VectorXs& tau,
+    const Eigen::VectorXs& groundBodyWrenches,
+    const Eigen::VectorXs& groundBodyCopTorqueForce,
+    const std::vector<Eigen::VectorXs>& customValues,
+    bool probablyMissingGRF)
+{
+  if (mFile == nullptr)
+  {
+    return false;
+  }
+  if (mTrialNames.size() == 0)
+  {
+    std::cout << "SubjectWriter::appendFrame() called before startTrial()"
+              << std::endl;
+    return false;
+  }
+  if (mNumDofs == -1)
+  {
+    mNumDofs = pos.size();
+  }
+
+  bool sizesOk = pos.size() == mNumDofs && vel.size() == mNumDofs
+                 && acc.size() == mNumDofs && tau.size() == mNumDofs
+                 && groundBodyWrenches.size() == mGroundForceBodies.size() * 6
+                 && groundBodyCopTorqueForce.size()
+                        == mGroundForceBodies.size() * 9
+                 && customValues.size() == mCustomValueDims.size();
+  for (int i = 0; sizesOk && i < customValues.size(); i++)
+  {
+    sizesOk = customValues[i].size() == mCustomValueDims[i];
+  }
+  if (!sizesOk)
+  {
+    std::cout << "SubjectWriter::appendFrame() got a frame with the wrong "
+                 "sizes for trial "
+              << mTrialNames.size() - 1 << " frame " << mTrialLengths.back()
+              << ", skipping it" << std::endl;
+    return false;
+  }
+
+  if (mChunkBuffers.size() == 0)
+  {
+    const int chunkFrames = mChunkFrames.back();
+    for (int i = 0; i < 4; i++)
+    {
+      mChunkBuffers.emplace_back(mNumDofs, chunkFrames);
+    }
+    mChunkBuffers.emplace_back(mGroundForceBodies.size() * 6, chunkFrames);
+    mChunkBuffers.emplace_back(mGroundForceBodies.size() * 9, chunkFrames);
+    for (int dim : mCustomValueDims)
+    {
+      mChunkBuffers.emplace_back(dim, chunkFrames);
+    }
+  }
+
+  mChunkBuffers[0].col(mBufferedFrames) = pos.cast<float64_t>();
+  mChunkBuffers[1].col(mBufferedFrames) = vel.cast<float64_t>();
+  mChunkBuffers[2].col(mBufferedFrames) = acc.cast<float64_t>();
+  mChunkBuffers[3].col(mBufferedFrames) = tau.cast<float64_t>();
+  mChunkBuffers[4].col(mBufferedFrames) = groundBodyWrenches.cast<float64_t>();
+  mChunkBuffers[5].col(mBufferedFrames)
+      = groundBodyCopTorqueForce.cast<float64_t>();
+  for (int i = 0; i < customValues.size(); i++)
+  {
+    mChunkBuffers[NUM_FIXED_CHANNELS + i].col(mBufferedFrames)
+        = customValues[i].cast<float64_t>();
+  }
+  mProbablyMissingGRF.back().push_back(probablyMissingGRF);
+  mTrialLengths.back()++;
+  mBufferedFrames++;
+
+  if (mBufferedFrames == mChunkFrames.back())
+  {
+    flushChunk();
+  }
+  return true;
+}
+
+/// This compresses and writes out whatever frames are buffered for the
+/// current trial
+void SubjectWriter::flushChunk()
+{
+  if (mBufferedFrames == 0)
+  {
+    return;
+  }
+
+  if (mChannelStats.size() == 0)
+  {
+    for (const Eigen::MatrixXd& buffer : mChunkBuffers)
+    {
+      mChannelStats.emplace_back(buffer.rows());
+    }
+  }
+
+  for (int channel = 0; channel < mChunkBuffers.size(); channel++)
+  {
+    Eigen::MatrixXd raw = mChunkBuffers[channel].leftCols(mBufferedFrames);
+    mChannelStats[channel].addFrames(raw);
+    std::vector<uint8_t> encoded
+        = encodeChunk(raw.data(), raw.rows(), mBufferedFrames);
+
+    SubjectOnDisk::ChunkLocation location;
+    location.offset = ftell(mFile);
+    // Data that doesn't compress (like noise) is just stored raw
+    if (encoded.size() < raw.size() * sizeof(float64_t))
+    {
+      location.codec = CHUNK_CODEC_XOR_SHUFFLE_RLE;
+      location.size = encoded.size();
+      fwrite(encoded.data(), sizeof(uint8_t), encoded.size(), mFile);
+    }
+    else
+    {
+      location.codec = CHUNK_CODEC_RAW;
+      location.size = raw.size() * sizeof(float64_t);
+      fwrite(raw.data(), sizeof(float64_t), raw.size(), mFile);
+    }
+    mChunkIndex.back().push_back(location);
+  }
+
+  mBufferedFrames = 0;
+}
+
+/// This finishes the last trial, writes out all the metadata, the chunk index
+/// and the channel statistics, fills in the header, and closes the file.
+void SubjectWriter::close()
+{
+  if (mFile == nullptr)
+  {
+    return;
+  }
+  flushChunk();
+
+  auto writeString = [this](const std::string& str) {
+    int32_t len = str.length();
+    fwrite(&len, sizeof(int32_t), 1, mFile);
+    fwrite(str.c_str(), sizeof(char), len, mFile);
+  };
+
+  // Write the href and notes
+  mOffsets.href = ftell(mFile);
+  writeString(mHref);
+  mOffsets.notes = ftell(mFile);
+  writeString(mNotes);
+
+  // Write trial names
+  mOffsets.trialNames = ftell(mFile);
+  for (const std::string& name : mTrialNames)
+  {
+    writeString(name);
+  }
+
+  // Write contact body names
+  mOffsets.contactBodies = ftell(mFile);
+  for (const std::string& body : mGroundForceBodies)
+  {
+    writeString(body);
+  }
+
+  // Write custom value names and lengths
+  mOffsets.customValues = ftell(mFile);
+  for (int i = 0; i < mCustomValueNames.size(); i++)
+  {
+    int32_t dataLen = mCustomValueDims[i];
+    fwrite(&dataLen, sizeof(int32_t), 1, mFile);
+    writeString(mCustomValueNames[i]);
+  }
+
+  // Write trial lengths
+  mOffsets.trialLengths = ftell(mFile);
+  for (int i = 0; i < mTrialLengths.size(); i++)
+  {
+    int32_t len = mTrialLengths[i];
+    fwrite(&len, sizeof(int32_t), 1, mFile);
+  }
+
+  // Write trial timesteps
+  mOffsets.trialTimesteps = ftell(mFile);
+  for (int i = 0; i < mTrialTimesteps.size(); i++)
+  {
+    double timestep = mTrialTimesteps[i];
+    fwrite(&timestep, sizeof(double), 1, mFile);
+  }
+
+  // Write the `probablyMissingGrf` data
+  mOffsets.probablyMissingGRF = ftell(mFile);
+  for (int i = 0; i < mProbablyMissingGRF.size(); i++)
+  {
+    // Write a magic header, to make sure we don't get lost
+    int32_t magic = 424242;
+    fwrite(&magic, sizeof(int32_t), 1, mFile);
+    std::vector<int8_t> raw(
+        mProbablyMissingGRF[i].begin(), mProbablyMissingGRF[i].end());
+    if (raw.size() > 0)
+    {
+      fwrite(raw.data(), sizeof(int8_t), raw.size(), mFile);
+    }
+  }
+
+  // Write the chunk lengths, and then the chunk index
+  mOffsets.chunkFrames = ftell(mFile);
+  int32_t magic = 424242;
+  fwrite(&magic, sizeof(int32_t), 1, mFile);
+  for (int i = 0; i < mChunkFrames.size(); i++)
+  {
+    int32_t frames = mChunkFrames[i];
+    fwrite(&frames, sizeof(int32_t), 1, mFile);
+  }
+  mOffsets.chunkIndex = ftell(mFile);
+  for (int i = 0; i < mChunkIndex.size(); i++)
+  {
+    if (mChunkIndex[i].size() > 0)
+    {
+      fwrite(
+          mChunkIndex[i].data(),
+          sizeof(SubjectOnDisk::ChunkLocation),
+          mChunkIndex[i].size(),
+          mFile);
+    }
+  }
+
+  // Write the channel statistics, and the trailer that points to them. We
+  // don't have these if no frames were written.
+  if (mChannelStats.size() > 0)
+  {
+    int64_t statsOffset = ftell(mFile);
+    int32_t statsHeader[2] = {424242, (int32_t)mChannelStats.size()};
+    fwrite(statsHeader, sizeof(int32_t), 2, mFile);
+    for (const ChannelStats& stats : mChannelStats)
+    {
+      int32_t dim = stats.count.size();
+      fwrite(&dim, sizeof(int32_t), 1, mFile);
+      fwrite(stats.count.data(), sizeof(double), dim, mFile);
+      fwrite(stats.mean.data(), sizeof(double), dim, mFile);
+      fwrite(stats.m2.data(), sizeof(double), dim, mFile);
+    }
+    int32_t trailer[2] = {0, CHANNEL_STATS_TRAILER_MAGIC};
+    fwrite(&statsOffset, sizeof(int64_t), 1, mFile);
+    fwrite(trailer, sizeof(int32_t), 2, mFile);
+  }
+
+  // Now go back and fill in the header and the section table
+  struct FileHeader header;
+  header.magic = 424242;
+  header.version = 2;
+  header.numDofs = std::max(mNumDofs, 0);
+  header.numTrials = mTrialNames.size();
+  header.numGroundContactBodies = mGroundForceBodies.size();
+  header.numCustomValues = mCustomValueNames.size();
+  fseek(mFile, 0, SEEK_SET);
+  fwrite(&header, sizeof(struct FileHeader), 1, mFile);
+  fwrite(&mOffsets, sizeof(SubjectOnDisk::SectionOffsets), 1, mFile);
+
+  fclose(mFile);
+  mFile = nullptr;
+}
+
 /// This returns the number of trials on the subject
 int SubjectOnDisk::getNumTrials()
 {
@@ -744,6 +2326,7 @@ int SubjectOnDisk::getTrialLength(int trial)
   {
     return 0;
   }
+  loadMetadata();
   return mTrialLength[trial];
 }
 
@@ -762,6 +2345,7 @@ std::vector<bool> SubjectOnDisk::getProbablyMissingGRF(int trial)
   {
     return std::vector<bool>();
   }
+  loadTrial(trial);
   return mProbablyMissingGRF[trial];
 }
 
@@ -805,18 +2389,21 @@ std::string SubjectOnDisk::getTrialName(int trial)
   {
     return "";
   }
+  loadMetadata();
   return mTrialNames[trial];
 }
 
 /// This gets the href link associated with the subject, if there is one.
 std::string SubjectOnDisk::getHref()
 {
+  loadMetadata();
   return mHref;
 }
 
 /// This gets the notes associated with the subject, if there are any.
 std::string SubjectOnDisk::getNotes()
 {
+  loadMetadata();
   return mNotes;
 }
 
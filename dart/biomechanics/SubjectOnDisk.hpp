@@ -1,8 +1,12 @@
 #ifndef BIOMECH_SUBJECT_ON_DISK
 #define BIOMECH_SUBJECT_ON_DISK
 
+#include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -38,6 +42,120 @@ struct Frame
   std::vector<std::pair<std::string, Eigen::VectorXd>> customValues;
 };
 
+/// This is a read-only view of a single frame, pointing straight into a
+/// memory-mapped SubjectOnDisk file, so making one doesn't copy or allocate
+/// any of the frame data. The view keeps the file mapped for as long as it's
+/// alive, even if the SubjectOnDisk that made it goes away.
+struct FrameView
+{
+  int trial;
+  int t;
+  bool probablyMissingGRF;
+  s_t dt;
+
+  Eigen::Map<const Eigen::VectorXd> pos;
+  Eigen::Map<const Eigen::VectorXd> vel;
+  Eigen::Map<const Eigen::VectorXd> acc;
+  Eigen::Map<const Eigen::VectorXd> tau;
+  // One column per ground contact body, in the order of
+  // getGroundContactBodies()
+  Eigen::Map<const Eigen::Matrix<double, 6, Eigen::Dynamic>>
+      groundContactWrenches;
+  // The CoP, torque and force of each body are interleaved on disk, so these
+  // are strided views, one column per ground contact body
+  Eigen::Map<
+      const Eigen::Matrix<double, 3, Eigen::Dynamic>,
+      0,
+      Eigen::OuterStride<>>
+      groundContactCenterOfPressure;
+  Eigen::Map<
+      const Eigen::Matrix<double, 3, Eigen::Dynamic>,
+      0,
+      Eigen::OuterStride<>>
+      groundContactTorque;
+  Eigen::Map<
+      const Eigen::Matrix<double, 3, Eigen::Dynamic>,
+      0,
+      Eigen::OuterStride<>>
+      groundContactForce;
+  // In the order of getCustomValues()
+  std::vector<Eigen::Map<const Eigen::VectorXd>> customValues;
+
+  // This keeps the file mapped
+  std::shared_ptr<const char> mapping;
+
+  FrameView(
+      const std::shared_ptr<const char>& mapping,
+      const double* data,
+      int numDofs,
+      int numGroundContactBodies);
+};
+
+/// This is a structure-of-arrays version of a run of Frame objects from one
+/// trial. Each channel is a single contiguous matrix with one row per frame,
+/// so a whole window can be handed to NumPy or an ML framework without
+/// walking a list of Frame objects, and the body and custom value names are
+/// stored once for the whole batch, rather than once per frame.
+struct FrameBatch
+{
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      Channel;
+
+  int trial;
+  int startFrame;
+  int numFrames;
+  // The timestep we used during this trial
+  s_t dt;
+  // One entry per frame
+  Eigen::Matrix<bool, Eigen::Dynamic, 1> probablyMissingGRF;
+
+  // These are all [numFrames x numDofs]
+  Channel pos;
+  Channel vel;
+  Channel acc;
+  Channel tau;
+  // This is [numFrames x 6 * groundContactBodies.size()], with the wrench of
+  // each body in order of groundContactBodies
+  Channel groundContactWrenches;
+  // These are [numFrames x 3 * groundContactBodies.size()], in world space
+  Channel groundContactCenterOfPressure;
+  Channel groundContactTorque;
+  Channel groundContactForce;
+  std::vector<std::string> groundContactBodies;
+
+  // One [numFrames x dim] matrix per entry in customValueNames
+  std::vector<std::string> customValueNames;
+  std::vector<Channel> customValues;
+};
+
+/// These are running statistics of each dimension of one channel, which can
+/// be built up a batch of frames at a time and merged with the statistics of
+/// other trials or files, without ever going back to the frames. Values that
+/// aren't finite are left out.
+struct ChannelStats
+{
+  /// The number of values seen in each dimension
+  Eigen::VectorXd count;
+  Eigen::VectorXd mean;
+  /// The sum of the squared differences from the mean in each dimension
+  Eigen::VectorXd m2;
+
+  ChannelStats(int dim = 0);
+
+  /// This adds a (dim x numFrames) block of frames
+  void addFrames(const Eigen::MatrixXd& frames);
+
+  /// This adds in statistics gathered over other frames
+  void merge(const ChannelStats& other);
+
+  /// This returns the variance of each dimension, or 0 where there were no
+  /// values
+  Eigen::VectorXd getVariance() const;
+
+  /// This returns the standard deviation of each dimension
+  Eigen::VectorXd getStd() const;
+};
+
 /**
  * This is for doing ML and large-scale data analysis. The idea here is to
  * create a lazy-loadable view of a subject, where everything remains on disk
@@ -47,6 +165,10 @@ struct Frame
 class SubjectOnDisk
 {
 public:
+  /// Opening a version 2 file only reads the header, the table of where each
+  /// section starts, and the names of the contact bodies and custom values,
+  /// so it takes the same time no matter how big the file is. Everything
+  /// about the trials is read the first time anything needs it.
   SubjectOnDisk(const std::string& path, bool printDebuggingDetails = false);
 
   /// This will read the skeleton from the binary, and optionally use the passed
@@ -61,6 +183,103 @@ public:
   std::vector<std::shared_ptr<Frame>> readFrames(
       int trial, int startFrame, int numFramesToRead = 1);
 
+  /// This is the zero-copy version of readFrames(). The first call maps the
+  /// file into memory, and keeps it mapped, and every call after that is just
+  /// pointer arithmetic, so this is the one to use from tight data loading
+  /// loops. The OS pages the file in lazily, so mapping a large file doesn't
+  /// cost any memory until frames are actually read.
+  ///
+  /// Version 2 files are compressed, so there's nothing on disk to point a
+  /// view at. On those, this prints an error and returns an empty vector, and
+  /// you should use readChannelWindow() instead.
+  ///
+  /// On OOB access, prints an error and returns an empty vector.
+  std::vector<FrameView> readFrameViews(
+      int trial, int startFrame, int numFramesToRead = 1);
+
+  /// This reads the same data as readFrames(), but as a single FrameBatch,
+  /// with one contiguous matrix per channel. This works on both version 1 and
+  /// version 2 files.
+  ///
+  /// On OOB access, prints an error and returns an empty batch.
+  std::shared_ptr<FrameBatch> readFrameBatch(
+      int trial, int startFrame, int numFramesToRead = 1);
+
+  /// This returns the number of bytes from the start of one frame on disk to
+  /// the start of the next. Each of the vectors in consecutive FrameViews is
+  /// this many bytes after the same vector in the previous frame, which lets
+  /// you view a field across a run of frames as one strided array.
+  ///
+  /// This is only meaningful for version 1 files.
+  int getFrameSizeBytes();
+
+  /// This reads just the requested channels for a run of frames, and returns
+  /// one (channelDim x numFrames) matrix per channel, in the order asked for.
+  /// The channels are named "pos", "vel", "acc", "tau",
+  /// "groundContactWrenches" (6 per contact body) and
+  /// "groundContactCopTorqueForce" (9 per contact body), plus the names in
+  /// getCustomValues().
+  ///
+  /// On version 2 files, each channel is stored in its own chunks, so this
+  /// only reads (and decompresses) the chunks of the channels asked for that
+  /// overlap the window. On version 1 files this still works, but has to
+  /// seek through the interleaved frames.
+  ///
+  /// On OOB access or an unknown channel name, prints an error and returns an
+  /// empty vector.
+  std::vector<Eigen::MatrixXd> readChannelWindow(
+      int trial,
+      int startFrame,
+      int numFramesToRead,
+      const std::vector<std::string>& channels);
+
+  /// This reads a whole minibatch of windows in one call, straight into
+  /// preallocated output buffers, spreading the reading and decoding of the
+  /// windows across `numThreads` threads (values <= 0 mean use all the
+  /// hardware threads).
+  ///
+  /// Each request is a (trial, startFrame) pair. For each of `channels` (named
+  /// as in readChannelWindow()), `outputs` has a pointer to room for
+  /// requests.size() * windowLen * channelDim doubles, which get filled in as
+  /// a row-major [batch, window, channelDim] tensor. Windows that run off the
+  /// end of their trial are padded with zeros.
+  ///
+  /// On OOB access or an unknown channel name, prints an error, returns false,
+  /// and doesn't touch the outputs.
+  bool readWindowsBatch(
+      const std::vector<std::pair<int, int>>& requests,
+      int windowLen,
+      const std::vector<std::string>& channels,
+      const std::vector<double*>& outputs,
+      int numThreads = -1);
+
+  /// This returns the number of values per frame in the named channel (see
+  /// readChannelWindow()), or 0 if there's no such channel
+  int getChannelDim(const std::string& channel);
+
+  /// This returns the number of frames in each chunk of a trial, which is the
+  /// natural unit to read and cache data in. Version 1 files don't have
+  /// chunks, so for those this returns about a second of frames.
+  int getChunkFrames(int trial);
+
+  /// This returns the statistics of the named channel (see
+  /// readChannelWindow()) over every frame of every trial. SubjectWriter
+  /// stores these at the end of version 2 files, so this only has to read a
+  /// few bytes. For files without them, the first call reads every frame of
+  /// the file to work them out.
+  ///
+  /// On an unknown channel name, prints an error and returns empty stats.
+  ChannelStats getChannelStats(const std::string& channel);
+
+  /// This returns true if this file has channel statistics stored in it, so
+  /// getChannelStats() doesn't need to read any frames
+  bool hasStoredChannelStats();
+
+  /// This returns the version of the binary format of this file. Version 1
+  /// files store whole frames one after another, and version 2 files store
+  /// each channel in compressed chunks of about a second each.
+  int getFormatVersion();
+
   /// This writes a subject out to disk in a compressed and random-seekable
   /// binary format.
   static void writeSubject(
@@ -88,7 +307,13 @@ public:
       // came from after its been aggregated
       std::vector<std::string> trialNames,
       const std::string& sourceHref = "",
-      const std::string& notes = "");
+      const std::string& notes = "",
+      // Version 1 stores whole frames one after another, and is what the
+      // memory-mapped readFrameViews() needs. Version 2 stores each channel
+      // in compressed chunks of about a second each, which is smaller and
+      // much faster to read a few channels at a time from. Version 2 files
+      // are written with a SubjectWriter.
+      int formatVersion = 1);
 
   /// This returns the number of trials on the subject
   int getNumTrials();
@@ -123,7 +348,84 @@ public:
   std::string getNotes();
 
 protected:
+  /// This is where each section of a version 2 file starts, which is stored in
+  /// a table right after the header, so we can open files without reading
+  /// any more of them than we need to
+  struct SectionOffsets
+  {
+    int64_t href;
+    int64_t notes;
+    int64_t trialNames;
+    int64_t contactBodies;
+    int64_t customValues;
+    int64_t trialLengths;
+    int64_t trialTimesteps;
+    int64_t probablyMissingGRF;
+    int64_t modelLength;
+    int64_t model;
+    int64_t chunkFrames;
+    int64_t chunkIndex;
+  };
+
+  /// This reads the metadata for all the trials, along with the href and
+  /// notes, the first time it's called on a version 2 file. It's safe to call
+  /// from multiple threads.
+  void loadMetadata();
+
+  /// This reads the probablyMissingGRF flags and chunk index of a trial, the
+  /// first time it's called for that trial on a version 2 file. It's safe to
+  /// call from multiple threads.
+  void loadTrial(int trial);
+
+  /// These each read a section of the file, starting at the current position
+  /// in `file`
+  void readTrialNames(FILE* file);
+  void readTrialLengths(FILE* file);
+  void readTrialTimesteps(FILE* file);
+  void readProbablyMissingGRF(FILE* file, int trial);
+
+  /// This is where one chunk of one channel lives in a version 2 file
+  struct ChunkLocation
+  {
+    int64_t offset;
+    int32_t size;
+    int32_t codec;
+  };
+
+  /// This is readChannelWindow(), but takes channel indices (see
+  /// getChannelIndex()) instead of names. If `file` is null, this opens (and
+  /// closes) the file itself, otherwise it reads from `file`, which lets
+  /// callers doing lots of reads only open the file once.
+  std::vector<Eigen::MatrixXd> readChannels(
+      int trial,
+      int startFrame,
+      int numFramesToRead,
+      const std::vector<int>& channels,
+      FILE* file = nullptr);
+
+  /// This reads frames out of a version 2 file, by way of
+  /// readChannelWindow()
+  std::vector<std::shared_ptr<Frame>> readFramesFromChunks(
+      int trial, int startFrame, int numFramesToRead);
+
+  /// This returns the index of the named channel, or -1 if there's no such
+  /// channel. Indices 0 to 5 are pos, vel, acc, tau, groundContactWrenches and
+  /// groundContactCopTorqueForce, and the custom values come after that.
+  int getChannelIndex(const std::string& channel);
+
+  /// This returns the number of values per frame in a channel
+  int getChannelDim(int channel);
+
+  /// This returns the memory-mapped contents of our file, mapping it first if
+  /// this is the first time anyone has asked
+  std::shared_ptr<const char> getMapping();
+
+  /// This reads (or works out) the statistics of every channel, the first
+  /// time it's called. It's safe to call from multiple threads.
+  void loadChannelStats();
+
   std::string mPath;
+  bool mPrintDebuggingDetails;
   // We cache some very basic data about the accessible bounds of on-disk data,
   // so we don't have to look that up every time.
   int mNumDofs;
@@ -147,6 +449,126 @@ protected:
   std::string mHref;
   // Any text-based notes on the subject data, like citations etc
   std::string mNotes;
+  // The whole file, mapped into memory by getMapping(), or null if nobody has
+  // asked for it yet. This is only ever accessed through std::atomic_load()
+  // and std::atomic_store(), so it's safe to map from multiple threads.
+  std::shared_ptr<const char> mMapping;
+  // The size of the file, in bytes
+  std::size_t mFileSize;
+  // The version of the binary format
+  int mFormatVersion;
+  // For version 2 files, where each section starts
+  SectionOffsets mSectionOffsets;
+  // For version 2 files, the metadata and each trial are only read the first
+  // time anyone needs them, and these make sure that happens exactly once
+  std::once_flag mMetadataLoaded;
+  std::unique_ptr<std::once_flag[]> mTrialLoaded;
+  // For version 2 files, where each trial's part of the probablyMissingGRF
+  // section and of the chunk index starts
+  std::vector<long> mProbablyMissingGRFOffsets;
+  std::vector<long> mChunkIndexOffsets;
+  // For version 2 files, the number of frames in each chunk of each trial
+  std::vector<int> mChunkFrames;
+  // For version 2 files, mChunkIndex[trial][chunk * numChannels + channel] is
+  // where that chunk of that channel lives in the file
+  std::vector<std::vector<ChunkLocation>> mChunkIndex;
+  // Where the channel statistics start, or -1 if the file doesn't have any
+  int64_t mChannelStatsOffset;
+  // The statistics of every channel, in channel index order, which are only
+  // read the first time anyone needs them
+  std::once_flag mChannelStatsLoaded;
+  std::vector<ChannelStats> mChannelStats;
+
+  friend class SubjectWriter;
+};
+
+/**
+ * This writes a version 2 SubjectOnDisk file a frame at a time, so you never
+ * have to hold whole trials in memory. Only the frames of the chunk currently
+ * being filled (about a second's worth) get buffered. Everything else that
+ * depends on the size of the trials, like the trial lengths and the chunk
+ * index, gets written out at the end of the file by close(), which then goes
+ * back and fills in the header.
+ *
+ * Usage is to call startTrial(), then appendFrame() for each frame of that
+ * trial, repeat for each trial, and then close().
+ */
+class SubjectWriter
+{
+public:
+  SubjectWriter(
+      const std::string& outputPath,
+      // The OpenSim file XML gets copied into our binary bundle
+      const std::string& openSimFilePath,
+      // These are the bodies that have 6-dof wrenches applied to them
+      // (generally by foot-ground contact, though other things too)
+      const std::vector<std::string>& groundForceBodies,
+      // We include this to allow the binary format to store/load a bunch of
+      // new types of values while remaining backwards compatible.
+      const std::vector<std::string>& customValueNames,
+      const std::vector<int>& customValueDims,
+      // The provenance info, optional, for investigating where training data
+      // came from after its been aggregated
+      const std::string& sourceHref = "",
+      const std::string& notes = "");
+
+  /// This closes the file, if close() hasn't been called already
+  ~SubjectWriter();
+
+  /// This starts a new trial, finishing off the previous one (if any)
+  void startTrial(const std::string& name, s_t timestep);
+
+  /// This appends a frame to the current trial. `groundBodyWrenches` has 6
+  /// values per ground force body, and `groundBodyCopTorqueForce` has 9.
+  ///
+  /// If there's no current trial or any of the sizes are wrong, this prints
+  /// an error, skips the frame and returns false.
+  bool appendFrame(
+      const Eigen::VectorXs& pos,
+      const Eigen::VectorXs& vel,
+      const Eigen::VectorXs& acc,
+      const Eigen::VectorXs& tau,
+      const Eigen::VectorXs& groundBodyWrenches,
+      const Eigen::VectorXs& groundBodyCopTorqueForce,
+      const std::vector<Eigen::VectorXs>& customValues,
+      bool probablyMissingGRF);
+
+  /// This finishes the last trial, writes out all the metadata, the chunk
+  /// index and the channel statistics, fills in the header, and closes the
+  /// file. Calling this more than once does nothing.
+  void close();
+
+protected:
+  /// This compresses and writes out whatever frames are buffered for the
+  /// current trial
+  void flushChunk();
+
+  FILE* mFile;
+  std::string mPath;
+  std::vector<std::string> mGroundForceBodies;
+  std::vector<std::string> mCustomValueNames;
+  std::vector<int> mCustomValueDims;
+  std::string mHref;
+  std::string mNotes;
+  // This is -1 until we see the first frame
+  int mNumDofs;
+  SubjectOnDisk::SectionOffsets mOffsets;
+
+  // The per-trial metadata, which is small enough to keep until close()
+  std::vector<std::string> mTrialNames;
+  std::vector<s_t> mTrialTimesteps;
+  std::vector<int> mTrialLengths;
+  std::vector<int> mChunkFrames;
+  std::vector<std::vector<bool>> mProbablyMissingGRF;
+  std::vector<std::vector<SubjectOnDisk::ChunkLocation>> mChunkIndex;
+
+  // One (channelDim x chunkFrames) buffer per channel, for the chunk we're
+  // currently filling
+  std::vector<Eigen::MatrixXd> mChunkBuffers;
+  int mBufferedFrames;
+
+  // The statistics of every channel over the chunks written so far
+  std::vector<ChannelStats> mChannelStats;
 };
 
 } // namespace biomechanics
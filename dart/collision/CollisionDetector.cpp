@@ -69,6 +69,63 @@ bool CollisionDetector::raycast(
   return false;
 }
 
+//==============================================================================
+std::size_t CollisionDetector::raycastBatch(
+    CollisionGroup* group,
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    const RaycastOption& option,
+    RaycastBatchResult* result)
+{
+  if (origins.cols() != 3 || directions.cols() != 3
+      || origins.rows() != directions.rows())
+  {
+    dterr << "[CollisionDetector::raycastBatch] origins and directions must "
+          << "both be Nx3 matrices with the same number of rows, but got "
+          << origins.rows() << "x" << origins.cols() << " and "
+          << directions.rows() << "x" << directions.cols()
+          << ". Ignoring call.\n";
+    return 0;
+  }
+
+  if (result)
+    result->clear(origins.rows());
+
+  RaycastOption closestOption = option;
+  closestOption.mEnableAllHits = false;
+
+  std::size_t numHits = 0;
+  RaycastResult rayResult;
+  for (int i = 0; i < origins.rows(); i++)
+  {
+    rayResult.clear();
+    const Eigen::Vector3s from = origins.row(i).transpose();
+    const Eigen::Vector3s to = from + directions.row(i).transpose();
+    if (!raycast(group, from, to, closestOption, &rayResult)
+        || rayResult.mRayHits.empty())
+      continue;
+
+    numHits++;
+    if (!result)
+      continue;
+
+    // Some detectors may hand back more than one hit even when we only ask
+    // for the closest, so we pick it out ourselves
+    const RayHit* closest = &rayResult.mRayHits[0];
+    for (const RayHit& hit : rayResult.mRayHits)
+    {
+      if (hit.mFraction < closest->mFraction)
+        closest = &hit;
+    }
+    result->mDistances(i) = closest->mFraction * directions.row(i).norm();
+    result->mNormals.row(i) = closest->mNormal.transpose();
+    result->mPoints.row(i) = closest->mPoint.transpose();
+    result->mCollisionObjects[i] = closest->mCollisionObject;
+  }
+
+  return numHits;
+}
+
 //==============================================================================
 std::shared_ptr<CollisionObject> CollisionDetector::claimCollisionObject(
     const dynamics::ShapeFrame* shapeFrame)
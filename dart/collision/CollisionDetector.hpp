@@ -173,6 +173,30 @@ public:
       const RaycastOption& option = RaycastOption(),
       RaycastResult* result = nullptr);
 
+  /// Performs a batch of raycasts to a collision group, keeping only the
+  /// closest hit for each ray.
+  ///
+  /// \param[in] group The collision group the rays will be casted onto.
+  /// \param[in] origins The (Nx3) start points of the rays in world
+  /// coordinates.
+  /// \param[in] directions The (Nx3) directions of the rays in world
+  /// coordinates. Each ray runs from origins.row(i) to origins.row(i) +
+  /// directions.row(i), so the length of each direction is the range of the
+  /// ray.
+  /// \param[in] option The raycast option. Only the closest hit of each ray
+  /// is reported, regardless of RaycastOption::mEnableAllHits.
+  /// \param[out] result The closest hit of each ray.
+  /// \return The number of rays that hit an collision object.
+  ///
+  /// By default, this calls raycast() once per ray. Collision detectors that
+  /// can handle rays in parallel override this.
+  virtual std::size_t raycastBatch(
+      CollisionGroup* group,
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      const RaycastOption& option,
+      RaycastBatchResult* result);
+
 protected:
 
   class CollisionObjectManager;
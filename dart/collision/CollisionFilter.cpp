@@ -33,6 +33,7 @@
 #include "dart/collision/CollisionFilter.hpp"
 
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
 #include "dart/collision/CollisionObject.hpp"
 
 namespace dart {
@@ -109,61 +110,42 @@ bool BodyNodeCollisionFilter::ignoresCollision(
   if (object1 == object2)
     return true;
 
-  auto shapeNode1 = object1->getShapeFrame()->asShapeNode();
-  auto shapeNode2 = object2->getShapeFrame()->asShapeNode();
+  // This reads everything from the raw pointers the objects cached when they
+  // were last updated, since this runs for every pair that makes it through
+  // the broadphase
+  const dynamics::BodyNode* bodyNode1 = object1->getBodyNode();
+  const dynamics::BodyNode* bodyNode2 = object2->getBodyNode();
 
   // We don't filter out for non-ShapeNode because this class shouldn't have the
   // authority to make decisions about filtering any ShapeFrames that aren't
   // attached to a BodyNode. So here we just return false. In order to decide
   // whether the non-ShapeNode should be ignored, please use other collision
   // filters.
-  if (!shapeNode1 || !shapeNode2)
+  if (!bodyNode1 || !bodyNode2)
     return false;
 
-  auto bodyNode1 = shapeNode1->getBodyNodePtr();
-  auto bodyNode2 = shapeNode2->getBodyNodePtr();
-
   if (bodyNode1 == bodyNode2)
     return true;
 
   if (!bodyNode1->isCollidable() || !bodyNode2->isCollidable())
     return true;
 
-  const auto& skel1 = bodyNode1->getSkeleton();
-  const auto& skel2 = bodyNode2->getSkeleton();
+  const dynamics::Skeleton* skel1 = object1->getSkeleton();
+  const dynamics::Skeleton* skel2 = object2->getSkeleton();
 
-  if ( !skel1->isMobile() && !skel2->isMobile() )
+  // Sleeping skeletons can't move, so they only need checking against awake
+  // ones
+  if ((!skel1->isMobile() || skel1->isAsleep())
+      && (!skel2->isMobile() || skel2->isAsleep()))
     return true;
 
-  if (skel1 == skel2)
-  {
-    if (!skel1->isEnabledSelfCollisionCheck())
-      return true;
-
-    if (!skel1->isEnabledAdjacentBodyCheck())
-    {
-      if (areAdjacentBodies(bodyNode1, bodyNode2))
-        return true;
-    }
-  }
-
-  if (mBodyNodeBlackList.contains(bodyNode1, bodyNode2))
+  if (skel1 == skel2
+      && skel1->isSelfCollisionIgnored(
+          bodyNode1->getIndexInSkeleton(), bodyNode2->getIndexInSkeleton()))
     return true;
 
-  return false;
-}
-
-//==============================================================================
-bool BodyNodeCollisionFilter::areAdjacentBodies(
-    const dynamics::BodyNode* bodyNode1,
-    const dynamics::BodyNode* bodyNode2) const
-{
-  if ((bodyNode1->getParentBodyNode() == bodyNode2)
-      || (bodyNode2->getParentBodyNode() == bodyNode1))
-  {
-    assert(bodyNode1->getSkeleton() == bodyNode2->getSkeleton());
+  if (mBodyNodeBlackList.contains(bodyNode1, bodyNode2))
     return true;
-  }
 
   return false;
 }
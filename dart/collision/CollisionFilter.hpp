@@ -108,12 +108,6 @@ public:
       const CollisionObject* object2) const override;
 
 private:
-  /// Returns true if the two BodyNodes are adjacent BodyNodes (i.e., the two
-  /// BodyNodes are connected by a Joint).
-  bool areAdjacentBodies(
-      const dynamics::BodyNode* bodyNode1,
-      const dynamics::BodyNode* bodyNode2) const;
-
   /// List of pairs to be ignored in the collision detection.
   detail::UnorderedPairs<dynamics::BodyNode> mBodyNodeBlackList;
 };
@@ -233,6 +233,20 @@ bool CollisionGroup::raycast(
   return mCollisionDetector->raycast(this, from, to, option, result);
 }
 
+//==============================================================================
+std::size_t CollisionGroup::raycastBatch(
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    const RaycastOption& option,
+    RaycastBatchResult* result)
+{
+  if(mUpdateAutomatically)
+    update();
+
+  return mCollisionDetector->raycastBatch(
+      this, origins, directions, option, result);
+}
+
 //==============================================================================
 void CollisionGroup::setAutomaticUpdate(const bool automatic)
 {
@@ -302,7 +316,10 @@ void CollisionGroup::removeDeletedShapeFrames()
 void CollisionGroup::updateEngineData()
 {
   for (const auto& info : mObjectInfoList)
+  {
+    info->mObject->updateFilterData();
     info->mObject->updateEngineData();
+  }
 
   updateCollisionGroupEngineData();
 }
@@ -283,6 +283,22 @@ public:
       const RaycastOption& option = RaycastOption(),
       RaycastResult* result = nullptr);
 
+  /// Performs a batch of raycasts to this collision group, keeping only the
+  /// closest hit for each ray.
+  ///
+  /// \param[in] origins The (Nx3) start points of the rays in world
+  /// coordinates.
+  /// \param[in] directions The (Nx3) directions of the rays in world
+  /// coordinates. The length of each direction is the range of its ray.
+  /// \param[in] option The raycast option.
+  /// \param[out] result The closest hit of each ray.
+  /// \return The number of rays that hit an collision object.
+  std::size_t raycastBatch(
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      const RaycastOption& option = RaycastOption(),
+      RaycastBatchResult* result = nullptr);
+
   /// Set whether this CollisionGroup will automatically check for updates.
   void setAutomaticUpdate(bool automatic = true);
 
@@ -33,7 +33,9 @@
 #include "dart/collision/CollisionObject.hpp"
 
 #include "dart/collision/CollisionDetector.hpp"
+#include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/ShapeFrame.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
 
 namespace dart {
 namespace collision {
@@ -68,15 +70,67 @@ const Eigen::Isometry3s& CollisionObject::getTransform() const
   return mShapeFrame->getWorldTransform();
 }
 
+//==============================================================================
+const dynamics::BodyNode* CollisionObject::getBodyNode() const
+{
+  return mBodyNode;
+}
+
+//==============================================================================
+const dynamics::Skeleton* CollisionObject::getSkeleton() const
+{
+  return mSkeleton;
+}
+
+//==============================================================================
+std::uint32_t CollisionObject::getCollisionLayers() const
+{
+  return mCollisionLayers;
+}
+
+//==============================================================================
+std::uint32_t CollisionObject::getCollisionMask() const
+{
+  return mCollisionMask;
+}
+
+//==============================================================================
+bool CollisionObject::collisionMasksMatch(const CollisionObject* other) const
+{
+  return (mCollisionLayers & other->mCollisionMask) != 0u
+         && (other->mCollisionLayers & mCollisionMask) != 0u;
+}
+
 //==============================================================================
 CollisionObject::CollisionObject(
     CollisionDetector* collisionDetector,
     const dynamics::ShapeFrame* shapeFrame)
   : mCollisionDetector(collisionDetector),
-    mShapeFrame(shapeFrame)
+    mShapeFrame(shapeFrame),
+    mBodyNode(nullptr),
+    mSkeleton(nullptr),
+    mCollisionLayers(1u),
+    mCollisionMask(0xFFFFFFFFu)
 {
   assert(mCollisionDetector);
   assert(mShapeFrame);
+
+  updateFilterData();
+}
+
+//==============================================================================
+void CollisionObject::updateFilterData()
+{
+  const dynamics::ShapeNode* shapeNode = mShapeFrame->asShapeNode();
+  mBodyNode = shapeNode ? shapeNode->getBodyNodePtr().get() : nullptr;
+  mSkeleton = mBodyNode ? mBodyNode->getSkeleton().get() : nullptr;
+
+  const dynamics::CollisionAspect* aspect = mShapeFrame->getCollisionAspect();
+  if (aspect)
+  {
+    mCollisionLayers = aspect->getCollisionLayers();
+    mCollisionMask = aspect->getCollisionMask();
+  }
 }
 
 }  // namespace collision
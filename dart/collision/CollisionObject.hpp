@@ -33,6 +33,8 @@
 #ifndef DART_COLLISION_COLLISIONOBJECT_HPP_
 #define DART_COLLISION_COLLISIONOBJECT_HPP_
 
+#include <cstdint>
+
 #include <Eigen/Dense>
 
 #include "dart/collision/SmartPointer.hpp"
@@ -65,6 +67,24 @@ public:
   /// Return the transformation of this CollisionObject in world coordinates
   const Eigen::Isometry3s& getTransform() const;
 
+  /// Return the BodyNode that the ShapeFrame is attached to, or nullptr if the
+  /// ShapeFrame isn't a ShapeNode
+  const dynamics::BodyNode* getBodyNode() const;
+
+  /// Return the Skeleton of getBodyNode(), or nullptr if there's no BodyNode
+  const dynamics::Skeleton* getSkeleton() const;
+
+  /// Return the collision layers of the ShapeFrame's CollisionAspect
+  std::uint32_t getCollisionLayers() const;
+
+  /// Return the collision mask of the ShapeFrame's CollisionAspect
+  std::uint32_t getCollisionMask() const;
+
+  /// Return true if the collision layers and masks of the two objects allow
+  /// them to collide. That's just two ANDs, so collision detectors can check
+  /// this in the broadphase, before any other filtering.
+  bool collisionMasksMatch(const CollisionObject* other) const;
+
 protected:
   /// Contructor
   CollisionObject(
@@ -76,12 +96,32 @@ protected:
   /// CollisionGroup.
   virtual void updateEngineData() = 0;
 
+  /// This copies everything collision filters need from the ShapeFrame, so
+  /// that filtering a pair of objects only follows raw pointers and reads a
+  /// few bits. CollisionGroup calls this ahead of every collision check,
+  /// which is once per object, rather than once per pair.
+  void updateFilterData();
+
 protected:
   /// Collision detector
   CollisionDetector* mCollisionDetector;
 
   /// ShapeFrame
   const dynamics::ShapeFrame* mShapeFrame;
+
+  /// The BodyNode the ShapeFrame is attached to, as of the last
+  /// updateFilterData()
+  const dynamics::BodyNode* mBodyNode;
+
+  /// The Skeleton of mBodyNode, as of the last updateFilterData()
+  const dynamics::Skeleton* mSkeleton;
+
+  /// The collision layers of the ShapeFrame, as of the last
+  /// updateFilterData()
+  std::uint32_t mCollisionLayers;
+
+  /// The collision mask of the ShapeFrame, as of the last updateFilterData()
+  std::uint32_t mCollisionMask;
 };
 
 } // namespace collision
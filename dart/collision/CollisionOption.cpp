@@ -42,11 +42,15 @@ CollisionOption::CollisionOption(
     bool enableContact,
     std::size_t maxNumContacts,
     const std::shared_ptr<CollisionFilter>& collisionFilter,
-    s_t contactClippingDepth)
+    s_t contactClippingDepth,
+    std::size_t maxNumContactsPerPair,
+    s_t continuousCollisionTimeStep)
   : enableContact(enableContact),
     maxNumContacts(maxNumContacts),
     collisionFilter(collisionFilter),
-    contactClippingDepth(contactClippingDepth)
+    contactClippingDepth(contactClippingDepth),
+    maxNumContactsPerPair(maxNumContactsPerPair),
+    continuousCollisionTimeStep(continuousCollisionTimeStep)
 {
   // Do nothing
 }
@@ -60,6 +60,21 @@ struct CollisionOption
   /// The maximum depth, beyond which we clip collisions.
   s_t contactClippingDepth;
 
+  /// If this is non-zero, we keep at most this many contacts for each pair of
+  /// colliding objects, picking the ones that cover the largest area (see
+  /// reduceContacts()). This keeps the size of the LCP, and of its gradients,
+  /// bounded when meshes or boxes rest flat on each other. 4 is enough to
+  /// hold up a resting face. The default is 0, which keeps every contact.
+  std::size_t maxNumContactsPerPair;
+
+  /// If this is positive, the DART collision detector also looks this far
+  /// ahead in time, moving each object at the current velocity of its frame,
+  /// and adds a contact for any pair of spheres, capsules and boxes that
+  /// would run into each other before then. Set this to the time step to
+  /// stop thin or fast objects from tunneling through each other at large
+  /// time steps. The default is 0, which only checks the current positions.
+  s_t continuousCollisionTimeStep;
+
   /// CollisionFilter
   std::shared_ptr<CollisionFilter> collisionFilter;
 
@@ -68,7 +83,9 @@ struct CollisionOption
       bool enableContact = true,
       std::size_t maxNumContacts = 1000u,
       const std::shared_ptr<CollisionFilter>& collisionFilter = nullptr,
-      s_t contactClippingDepth = 0.03);
+      s_t contactClippingDepth = 0.03,
+      std::size_t maxNumContactsPerPair = 0u,
+      s_t continuousCollisionTimeStep = 0.0);
 };
 
 } // namespace collision
@@ -0,0 +1,167 @@
+#include "dart/collision/ContactReduction.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace dart {
+namespace collision {
+
+//==============================================================================
+std::vector<Contact> reduceContacts(
+    const std::vector<Contact>& contacts, std::size_t maxNumContacts)
+{
+  if (contacts.size() <= maxNumContacts)
+    return contacts;
+  if (maxNumContacts == 0)
+    return std::vector<Contact>();
+
+  // Anything smaller than this (in squared meters) counts as no area at all
+  const s_t eps = 1e-12;
+  const int n = contacts.size();
+
+  std::vector<int> kept;
+  std::vector<bool> isKept(n, false);
+  auto keep = [&](int i) {
+    kept.push_back(i);
+    isKept[i] = true;
+  };
+
+  // 1. The deepest contact
+  int deepest = 0;
+  for (int i = 1; i < n; i++)
+  {
+    if (contacts[i].penetrationDepth > contacts[deepest].penetrationDepth)
+      deepest = i;
+  }
+  keep(deepest);
+
+  // Everything after this works in the plane of the deepest contact
+  const Eigen::Vector3s& p0 = contacts[deepest].point;
+  Eigen::Vector3s normal = contacts[deepest].normal;
+  if (normal.squaredNorm() > 0)
+    normal.normalize();
+  auto projected = [&](int i) -> Eigen::Vector3s {
+    const Eigen::Vector3s d = contacts[i].point - p0;
+    return d - normal * normal.dot(d);
+  };
+
+  // 2. The contact furthest from the deepest one
+  if (kept.size() < maxNumContacts)
+  {
+    int best = -1;
+    s_t bestDist = eps;
+    for (int i = 0; i < n; i++)
+    {
+      if (isKept[i])
+        continue;
+      const s_t dist = projected(i).squaredNorm();
+      if (dist > bestDist)
+      {
+        best = i;
+        bestDist = dist;
+      }
+    }
+    if (best == -1)
+      return std::vector<Contact>{contacts[deepest]};
+    keep(best);
+  }
+
+  // 3. The contact that makes the biggest triangle with the first two
+  s_t winding = 1;
+  if (kept.size() < maxNumContacts)
+  {
+    const Eigen::Vector3s edge = projected(kept[1]);
+    int best = -1;
+    s_t bestArea = eps;
+    for (int i = 0; i < n; i++)
+    {
+      if (isKept[i])
+        continue;
+      const s_t area = edge.cross(projected(i)).dot(normal);
+      if (std::abs(area) > bestArea)
+      {
+        best = i;
+        bestArea = std::abs(area);
+        winding = area > 0 ? 1 : -1;
+      }
+    }
+    if (best != -1)
+      keep(best);
+  }
+
+  // 4. The contact that adds the most area outside that triangle
+  if (kept.size() == 3 && kept.size() < maxNumContacts)
+  {
+    const Eigen::Vector3s corners[3]
+        = {projected(kept[0]), projected(kept[1]), projected(kept[2])};
+    int best = -1;
+    s_t bestArea = eps;
+    for (int i = 0; i < n; i++)
+    {
+      if (isKept[i])
+        continue;
+      const Eigen::Vector3s q = projected(i);
+      for (int e = 0; e < 3; e++)
+      {
+        const Eigen::Vector3s& a = corners[e];
+        const Eigen::Vector3s& b = corners[(e + 1) % 3];
+        // This is positive when q is outside edge (a, b)
+        const s_t area = -winding * (b - a).cross(q - a).dot(normal);
+        if (area > bestArea)
+        {
+          best = i;
+          bestArea = area;
+        }
+      }
+    }
+    if (best != -1)
+      keep(best);
+  }
+
+  // 5. Past four, the contacts furthest from everything we've kept
+  if (maxNumContacts > 4)
+  {
+    std::vector<s_t> closest(n, std::numeric_limits<s_t>::infinity());
+    for (int i = 0; i < n; i++)
+    {
+      for (int k : kept)
+      {
+        closest[i] = std::min(
+            closest[i],
+            (contacts[i].point - contacts[k].point).squaredNorm());
+      }
+    }
+    while (kept.size() < maxNumContacts)
+    {
+      int best = -1;
+      s_t bestDist = eps;
+      for (int i = 0; i < n; i++)
+      {
+        if (!isKept[i] && closest[i] > bestDist)
+        {
+          best = i;
+          bestDist = closest[i];
+        }
+      }
+      if (best == -1)
+        break;
+      keep(best);
+      for (int i = 0; i < n; i++)
+      {
+        closest[i] = std::min(
+            closest[i],
+            (contacts[i].point - contacts[best].point).squaredNorm());
+      }
+    }
+  }
+
+  std::sort(kept.begin(), kept.end());
+  std::vector<Contact> reduced;
+  reduced.reserve(kept.size());
+  for (int i : kept)
+    reduced.push_back(contacts[i]);
+  return reduced;
+}
+
+} // namespace collision
+} // namespace dart
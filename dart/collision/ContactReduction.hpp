@@ -0,0 +1,38 @@
+#ifndef DART_COLLISION_CONTACTREDUCTION_HPP_
+#define DART_COLLISION_CONTACTREDUCTION_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "dart/collision/Contact.hpp"
+
+namespace dart {
+namespace collision {
+
+/// This picks at most `maxNumContacts` of the contacts between a single pair
+/// of objects, trying to keep the ones that best describe the patch the two
+/// objects are touching over. Box-box and mesh-mesh collisions can produce
+/// dozens of contacts that are nearly on top of each other, and each one adds
+/// rows to the LCP (and to the gradients) without making the contact any more
+/// stable. Four well spread out contacts are enough to hold up a face.
+///
+/// We always keep the deepest contact. After that, projecting onto the plane
+/// of its normal, we add the contact furthest from it, then the contact that
+/// makes the largest triangle with those two, then the contact that adds the
+/// most area outside that triangle. Past four, we keep adding whichever
+/// contact is furthest from everything we've kept so far. Contacts that
+/// wouldn't add any area (or distance) to what we've kept are dropped even if
+/// that leaves us with fewer than `maxNumContacts`.
+///
+/// The contacts we keep come back in the order they were passed in.
+///
+/// Selecting contacts is a discrete choice, so small movements can change
+/// which contacts we keep. Gradients of the contacts we keep are still
+/// correct, but finite differencing across a change in the selection isn't.
+std::vector<Contact> reduceContacts(
+    const std::vector<Contact>& contacts, std::size_t maxNumContacts);
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_CONTACTREDUCTION_HPP_
@@ -39,9 +39,11 @@ namespace collision {
 DistanceOption::DistanceOption(
     bool enableNearestPoints,
     double minDistance,
-    const std::shared_ptr<DistanceFilter>& distanceFilter)
+    const std::shared_ptr<DistanceFilter>& distanceFilter,
+    double distanceUpperBound)
   : enableNearestPoints(enableNearestPoints),
     distanceLowerBound(minDistance),
+    distanceUpperBound(distanceUpperBound),
     distanceFilter(distanceFilter)
 {
   // Do nothing
@@ -34,6 +34,7 @@
 #define DART_COLLISION_DISTANCE_OPTION_HPP_
 
 #include <cstddef>
+#include <limits>
 #include <memory>
 
 namespace dart {
@@ -59,6 +60,16 @@ struct DistanceOption
   /// The default value is 0.0.
   double distanceLowerBound;
 
+  /// Shape pairs further apart than this are skipped.
+  ///
+  /// Collision detectors that support this (currently DARTCollisionDetector)
+  /// use it to skip every pair whose bounding boxes are already further apart
+  /// than this, without looking at their shapes. If no pair is this close,
+  /// DistanceResult::found() returns false.
+  ///
+  /// The default value is inf, which checks every pair.
+  double distanceUpperBound;
+
   /// Distance filter for excluding ShapeFrame pairs from distance calculation
   /// in broadphase.
   ///
@@ -70,7 +81,8 @@ struct DistanceOption
   DistanceOption(
       bool enableNearestPoints = false,
       double distanceLowerBound = 0.0,
-      const std::shared_ptr<DistanceFilter>& distanceFilter = nullptr);
+      const std::shared_ptr<DistanceFilter>& distanceFilter = nullptr,
+      double distanceUpperBound = std::numeric_limits<double>::infinity());
 };
 
 } // namespace collision
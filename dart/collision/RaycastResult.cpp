@@ -32,6 +32,8 @@
 
 #include "dart/collision/RaycastResult.hpp"
 
+#include <limits>
+
 namespace dart {
 namespace collision {
 
@@ -53,5 +55,33 @@ bool RaycastResult::hasHit() const
   return !mRayHits.empty();
 }
 
+//==============================================================================
+RaycastBatchResult::RaycastBatchResult()
+{
+  clear();
+}
+
+//==============================================================================
+void RaycastBatchResult::clear(std::size_t numRays)
+{
+  mDistances = Eigen::VectorXs::Constant(
+      numRays, std::numeric_limits<s_t>::infinity());
+  mNormals = Eigen::MatrixXs::Zero(numRays, 3);
+  mPoints = Eigen::MatrixXs::Zero(numRays, 3);
+  mCollisionObjects.assign(numRays, nullptr);
+}
+
+//==============================================================================
+std::size_t RaycastBatchResult::getNumHits() const
+{
+  std::size_t numHits = 0;
+  for (const CollisionObject* object : mCollisionObjects)
+  {
+    if (object != nullptr)
+      numHits++;
+  }
+  return numHits;
+}
+
 } // namespace collision
 } // namespace dart
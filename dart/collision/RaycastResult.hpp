@@ -33,6 +33,7 @@
 #ifndef DART_COLLISION_RAYCASTRESULT_HPP_
 #define DART_COLLISION_RAYCASTRESULT_HPP_
 
+#include <cstddef>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -75,6 +76,34 @@ struct RaycastResult
   std::vector<RayHit> mRayHits;
 };
 
+/// This holds the closest hit for each ray in a batch, as dense arrays so
+/// that large batches can be handed to Python without building an object per
+/// ray. Row i of each array belongs to ray i of the batch.
+struct RaycastBatchResult
+{
+  /// Constructor
+  RaycastBatchResult();
+
+  /// This sizes the result for `numRays` rays, and marks them all as misses
+  void clear(std::size_t numRays = 0);
+
+  /// Returns the number of rays that hit something
+  std::size_t getNumHits() const;
+
+  /// The distance from the origin of each ray to its closest hit, in world
+  /// units, or infinity if the ray didn't hit anything
+  Eigen::VectorXs mDistances;
+
+  /// The (Nx3) world-space normal at each hit point, or zero on a miss
+  Eigen::MatrixXs mNormals;
+
+  /// The (Nx3) world-space hit points, or zero on a miss
+  Eigen::MatrixXs mPoints;
+
+  /// The object each ray hit, or nullptr on a miss
+  std::vector<const CollisionObject*> mCollisionObjects;
+};
+
 } // namespace collision
 } // namespace dart
 
@@ -0,0 +1,231 @@
+#include "dart/collision/dart/ContactCache.hpp"
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/Shape.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+thread_local ContactCache* activeContactCache = nullptr;
+
+} // anonymous namespace
+
+//==============================================================================
+ContactCache::PairEntry::PairEntry()
+  : dir(ccd_vec3_t()),
+    pos(ccd_vec3_t()),
+    distanceDirection(Eigen::Vector3s::Zero()),
+    distanceSupportHint1(-1),
+    distanceSupportHint2(-1),
+    shapeId1(0),
+    shapeId2(0),
+    shapeVersion1(0),
+    shapeVersion2(0),
+    hasContacts(false),
+    transform1(Eigen::Isometry3s::Identity()),
+    transform2(Eigen::Isometry3s::Identity()),
+    enableContact(true),
+    maxNumContacts(0)
+{
+}
+
+//==============================================================================
+ContactCache::ContactCache()
+  : mManifoldReuseTolerance(0), mNumReusedManifolds(0)
+{
+}
+
+//==============================================================================
+ContactCache::ContactCache(const ContactCache& other)
+  : mManifoldReuseTolerance(other.mManifoldReuseTolerance),
+    mNumReusedManifolds(0)
+{
+}
+
+//==============================================================================
+ContactCache& ContactCache::operator=(const ContactCache& other)
+{
+  if (this != &other)
+  {
+    mEntries.clear();
+    mManifoldReuseTolerance = other.mManifoldReuseTolerance;
+    mNumReusedManifolds = 0;
+  }
+  return *this;
+}
+
+//==============================================================================
+ContactCache::PairEntry& ContactCache::getEntry(
+    CollisionObject* o1, CollisionObject* o2)
+{
+  // We only insert when the entry is missing, so that looking up existing
+  // entries never modifies the map
+  const auto key = std::make_pair(o1, o2);
+  auto it = mEntries.find(key);
+  if (it == mEntries.end())
+    it = mEntries.emplace(key, PairEntry()).first;
+  PairEntry& entry = it->second;
+
+  const dynamics::ConstShapePtr& shape1 = o1->getShape();
+  const dynamics::ConstShapePtr& shape2 = o2->getShape();
+  if (entry.shapeId1 != shape1->getID() || entry.shapeId2 != shape2->getID())
+  {
+    // This is either a new entry, or a stale one left behind by objects that
+    // used to live at these addresses, so we start over
+    entry = PairEntry();
+    entry.shapeId1 = shape1->getID();
+    entry.shapeId2 = shape2->getID();
+    entry.shapeVersion1 = shape1->getVersion();
+    entry.shapeVersion2 = shape2->getVersion();
+  }
+  else if (
+      entry.shapeVersion1 != shape1->getVersion()
+      || entry.shapeVersion2 != shape2->getVersion())
+  {
+    // The shapes were resized, so the old contacts are no good, but the old
+    // search direction is still a decent place to start from
+    entry.hasContacts = false;
+    entry.contacts.clear();
+    entry.shapeVersion1 = shape1->getVersion();
+    entry.shapeVersion2 = shape2->getVersion();
+  }
+
+  return entry;
+}
+
+//==============================================================================
+bool ContactCache::getCachedContacts(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const CollisionOption& option,
+    CollisionResult& result)
+{
+  if (mManifoldReuseTolerance < 0)
+    return false;
+
+  PairEntry& entry = getEntry(o1, o2);
+  if (!entry.hasContacts || entry.enableContact != option.enableContact
+      || entry.maxNumContacts != option.maxNumContacts)
+    return false;
+
+  if (!isWithinTolerance(
+          entry.transform1, o1->getTransform(), mManifoldReuseTolerance)
+      || !isWithinTolerance(
+          entry.transform2, o2->getTransform(), mManifoldReuseTolerance))
+    return false;
+
+  for (const Contact& contact : entry.contacts)
+    result.addContact(contact);
+  mNumReusedManifolds++;
+  return true;
+}
+
+//==============================================================================
+void ContactCache::setCachedContacts(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const CollisionOption& option,
+    const CollisionResult& result)
+{
+  PairEntry& entry = getEntry(o1, o2);
+  entry.hasContacts = true;
+  entry.transform1 = o1->getTransform();
+  entry.transform2 = o2->getTransform();
+  entry.enableContact = option.enableContact;
+  entry.maxNumContacts = option.maxNumContacts;
+  entry.contacts = result.getContacts();
+}
+
+//==============================================================================
+void ContactCache::removeObject(const CollisionObject* object)
+{
+  for (auto it = mEntries.begin(); it != mEntries.end();)
+  {
+    if (it->first.first == object || it->first.second == object)
+      it = mEntries.erase(it);
+    else
+      ++it;
+  }
+}
+
+//==============================================================================
+void ContactCache::clear()
+{
+  mEntries.clear();
+}
+
+//==============================================================================
+std::size_t ContactCache::getNumEntries() const
+{
+  return mEntries.size();
+}
+
+//==============================================================================
+void ContactCache::setManifoldReuseTolerance(s_t tolerance)
+{
+  mManifoldReuseTolerance = tolerance;
+  for (auto& pair : mEntries)
+  {
+    pair.second.hasContacts = false;
+    pair.second.contacts.clear();
+  }
+}
+
+//==============================================================================
+s_t ContactCache::getManifoldReuseTolerance() const
+{
+  return mManifoldReuseTolerance;
+}
+
+//==============================================================================
+std::size_t ContactCache::getNumReusedManifolds() const
+{
+  return mNumReusedManifolds;
+}
+
+//==============================================================================
+ContactCache* ContactCache::getActive()
+{
+  return activeContactCache;
+}
+
+//==============================================================================
+ContactCache::ScopedActivation::ScopedActivation(ContactCache* cache)
+  : mPrevious(activeContactCache)
+{
+  activeContactCache = cache;
+}
+
+//==============================================================================
+ContactCache::ScopedActivation::~ScopedActivation()
+{
+  activeContactCache = mPrevious;
+}
+
+//==============================================================================
+std::size_t ContactCache::PairHash::operator()(
+    const std::pair<const CollisionObject*, const CollisionObject*>& pair) const
+{
+  const std::size_t h1 = std::hash<const CollisionObject*>()(pair.first);
+  const std::size_t h2 = std::hash<const CollisionObject*>()(pair.second);
+  return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+}
+
+//==============================================================================
+bool ContactCache::isWithinTolerance(
+    const Eigen::Isometry3s& a, const Eigen::Isometry3s& b, s_t tolerance)
+{
+  if (tolerance == 0)
+    return a.matrix() == b.matrix();
+
+  if ((a.translation() - b.translation()).norm() > tolerance)
+    return false;
+  const Eigen::Matrix3s R = a.linear().transpose() * b.linear();
+  return math::logMap(R).norm() <= tolerance;
+}
+
+} // namespace collision
+} // namespace dart
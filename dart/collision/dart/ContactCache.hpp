@@ -0,0 +1,185 @@
+#ifndef DART_COLLISION_DART_CONTACTCACHE_HPP_
+#define DART_COLLISION_DART_CONTACTCACHE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <ccd/ccd.h>
+#include <ccd/vec3.h>
+
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/Contact.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace collision {
+
+class CollisionObject;
+
+/// This holds on to the narrowphase state for each pair of objects in a
+/// DARTCollisionGroup from one collision check to the next. That's three
+/// things:
+///
+/// 1. The `dir` and `pos` vectors we hand to libccd for MPR, so that each
+///    query starts from the answer we found for that pair on the last step.
+///
+/// 2. The contacts we found for that pair on the last step, along with the
+///    world transforms of both objects at the time. If neither object has
+///    moved (by more than getManifoldReuseTolerance()) and neither shape has
+///    changed, we return the old contacts instead of running the narrowphase
+///    again. This is the common case for objects resting on the ground.
+///
+/// 3. The closest features GJK found for that pair on the last distance
+///    query, which the next distance query starts from.
+///
+/// Entries are keyed on the (ordered) pair of CollisionObject pointers, and
+/// also record the IDs and versions of both shapes, so an entry left behind by
+/// an object that was freed is never mistaken for a new object that happens to
+/// be allocated at the same address.
+///
+/// A ContactCache can be shared by several threads, as long as every pair
+/// they'll look up already has an entry (see getEntry()) and no two threads
+/// work on the same pair at once. Copying a
+/// ContactCache copies its settings but not its entries, since those are only
+/// meaningful for the CollisionObjects of the group they came from. That's
+/// what happens on World::clone(), where the new world re-creates all its
+/// collision objects, and so starts with a cold cache that warms back up
+/// after a single step.
+class ContactCache
+{
+public:
+  struct PairEntry
+  {
+    PairEntry();
+
+    /// The MPR search direction and position for this pair, from the last
+    /// time we ran the narrowphase on it
+    ccd_vec3_t dir;
+    ccd_vec3_t pos;
+
+    /// The GJK search direction, and the hull vertices each object's support
+    /// walk ended on, from the last distance query on this pair
+    Eigen::Vector3s distanceDirection;
+    int distanceSupportHint1;
+    int distanceSupportHint2;
+
+    /// The shapes this entry was computed for
+    std::size_t shapeId1;
+    std::size_t shapeId2;
+    std::size_t shapeVersion1;
+    std::size_t shapeVersion2;
+
+    /// True if `contacts` holds a valid result from the last narrowphase
+    bool hasContacts;
+    Eigen::Isometry3s transform1;
+    Eigen::Isometry3s transform2;
+    bool enableContact;
+    std::size_t maxNumContacts;
+    std::vector<Contact> contacts;
+  };
+
+  ContactCache();
+
+  /// This only copies the settings of `other`, not its entries
+  ContactCache(const ContactCache& other);
+
+  /// This only copies the settings of `other`, not its entries
+  ContactCache& operator=(const ContactCache& other);
+
+  /// Returns the entry for the pair (o1, o2), creating it if it doesn't exist
+  /// yet. If the entry was made for different shapes than o1 and o2 have now,
+  /// it's reset first.
+  PairEntry& getEntry(CollisionObject* o1, CollisionObject* o2);
+
+  /// If we have contacts for (o1, o2) from the last step that are still
+  /// valid, this adds them to `result` and returns true. Otherwise, this
+  /// returns false and leaves `result` untouched.
+  bool getCachedContacts(
+      CollisionObject* o1,
+      CollisionObject* o2,
+      const CollisionOption& option,
+      CollisionResult& result);
+
+  /// This records `result` as the narrowphase result for (o1, o2) at their
+  /// current transforms
+  void setCachedContacts(
+      CollisionObject* o1,
+      CollisionObject* o2,
+      const CollisionOption& option,
+      const CollisionResult& result);
+
+  /// This drops every entry that involves `object`
+  void removeObject(const CollisionObject* object);
+
+  /// This drops every entry
+  void clear();
+
+  /// Returns the number of pairs we're currently holding entries for
+  std::size_t getNumEntries() const;
+
+  /// This sets how far (in meters, and radians) each object is allowed to
+  /// move before we stop reusing the contacts from the last step. The
+  /// default is 0, which only reuses contacts when neither object has moved
+  /// at all, which gives exactly the same results as running the narrowphase.
+  /// A negative tolerance turns off contact reuse entirely, but still
+  /// warm-starts MPR.
+  void setManifoldReuseTolerance(s_t tolerance);
+
+  /// Returns how far (in meters, and radians) each object is allowed to move
+  /// before we stop reusing the contacts from the last step
+  s_t getManifoldReuseTolerance() const;
+
+  /// Returns the number of times getCachedContacts() returned true
+  std::size_t getNumReusedManifolds() const;
+
+  /// This is the cache that getCachedCcdPos() and getCachedCcdDir() read
+  /// from on the calling thread, or nullptr if there isn't one, in which
+  /// case they fall back to the per-thread global cache
+  static ContactCache* getActive();
+
+  /// This makes `cache` the active cache on the calling thread for as long as
+  /// it's in scope
+  class ScopedActivation
+  {
+  public:
+    ScopedActivation(ContactCache* cache);
+    ~ScopedActivation();
+
+  protected:
+    ContactCache* mPrevious;
+  };
+
+protected:
+  struct PairHash
+  {
+    std::size_t operator()(
+        const std::pair<const CollisionObject*, const CollisionObject*>& pair)
+        const;
+  };
+
+  /// Returns true if `a` and `b` are within `tolerance` of each other, in
+  /// both translation and rotation
+  static bool isWithinTolerance(
+      const Eigen::Isometry3s& a, const Eigen::Isometry3s& b, s_t tolerance);
+
+  std::unordered_map<
+      std::pair<const CollisionObject*, const CollisionObject*>,
+      PairEntry,
+      PairHash>
+      mEntries;
+
+  s_t mManifoldReuseTolerance;
+
+  std::atomic<std::size_t> mNumReusedManifolds;
+};
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_CONTACTCACHE_HPP_
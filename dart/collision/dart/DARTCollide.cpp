@@ -32,16 +32,22 @@
 
 #include "dart/collision/dart/DARTCollide.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <thread>
 
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/dart/ContactCache.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
 #include "dart/dynamics/CylinderShape.hpp"
 #include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/HeightmapShape.hpp"
 #include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
 #include "dart/dynamics/SphereShape.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
@@ -1950,20 +1956,33 @@ void ccdSupportMesh(const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
   s_t maxDot = -std::numeric_limits<s_t>::infinity();
   Eigen::Vector3s maxDotPoint = Eigen::Vector3s::Zero();
 
-  for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
+  if (mesh->hull != nullptr)
   {
-    aiMesh* m = mesh->mesh->mMeshes[i];
-    for (int k = 0; k < m->mNumVertices; k++)
+    // MPR asks for support points in directions that change only a little
+    // from one query to the next, so starting from the last answer means we
+    // usually only walk a step or two
+    mesh->supportHint
+        = mesh->hull->getSupportIndex(localDir, mesh->supportHint);
+    if (mesh->supportHint >= 0)
+      maxDotPoint = mesh->hull->getVertices()[mesh->supportHint];
+  }
+  else
+  {
+    for (int i = 0; i < mesh->mesh->mNumMeshes; i++)
     {
-      s_t dot = m->mVertices[k].x * localDir(0)
-                + m->mVertices[k].y * localDir(1)
-                + m->mVertices[k].z * localDir(2);
-      if (dot > maxDot)
+      aiMesh* m = mesh->mesh->mMeshes[i];
+      for (int k = 0; k < m->mNumVertices; k++)
       {
-        maxDot = dot;
-        maxDotPoint(0) = m->mVertices[k].x;
-        maxDotPoint(1) = m->mVertices[k].y;
-        maxDotPoint(2) = m->mVertices[k].z;
+        s_t dot = m->mVertices[k].x * localDir(0)
+                  + m->mVertices[k].y * localDir(1)
+                  + m->mVertices[k].z * localDir(2);
+        if (dot > maxDot)
+        {
+          maxDot = dot;
+          maxDotPoint(0) = m->mVertices[k].x;
+          maxDotPoint(1) = m->mVertices[k].y;
+          maxDotPoint(2) = m->mVertices[k].z;
+        }
       }
     }
   }
@@ -1979,6 +1998,34 @@ void ccdSupportMesh(const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
   _out->v[2] = static_cast<ccd_real_t>(out(2));
 }
 
+/// Returns the cached convex hull of the mesh for `object`, if we should use it
+const math::ConvexHull* getCcdMeshHull(
+    CollisionObject* object, const aiScene* mesh)
+{
+  // Below this many vertices, checking every vertex is about as fast as
+  // walking the hull, and it keeps small meshes (like boxes, which have lots
+  // of ties between vertices) giving exactly the same answers they always
+  // have
+  const unsigned int minVerticesForHull = 64;
+
+  const dynamics::Shape* shape = object->getShape().get();
+  if (shape == nullptr || !shape->is<dynamics::MeshShape>())
+    return nullptr;
+  const dynamics::MeshShape* meshShape
+      = static_cast<const dynamics::MeshShape*>(shape);
+  if (meshShape->getMesh() != mesh || mesh == nullptr)
+    return nullptr;
+
+  unsigned int numVertices = 0;
+  for (unsigned int i = 0; i < mesh->mNumMeshes; i++)
+    numVertices += mesh->mMeshes[i]->mNumVertices;
+  if (numVertices < minVerticesForHull)
+    return nullptr;
+
+  // The MeshShape keeps the hull alive for as long as the mesh is around
+  return meshShape->getConvexHull().get();
+}
+
 /// libccd support function for a capsule
 void ccdSupportCapsule(
     const void* _obj, const ccd_vec3_t* _dir, ccd_vec3_t* _out)
@@ -3870,6 +3917,10 @@ bool get2DLineIntersection(
 // Get the `pos` vec for CCD for this pair of objects
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 {
+  ContactCache* cache = ContactCache::getActive();
+  if (cache)
+    return cache->getEntry(o1, o2).pos;
+
   long key = (long)o1 ^ (long)o2;
   const std::thread::id tid = std::this_thread::get_id();
   ccd_vec3_t& pos = _ccdPosCache[tid][key];
@@ -3879,6 +3930,10 @@ ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2)
 // Get the `dir` vec for CCD for this pair of objects
 ccd_vec3_t& getCachedCcdDir(CollisionObject* o1, CollisionObject* o2)
 {
+  ContactCache* cache = ContactCache::getActive();
+  if (cache)
+    return cache->getEntry(o1, o2).dir;
+
   long key = (long)o1 ^ (long)o2;
   const std::thread::id tid = std::this_thread::get_id();
   ccd_vec3_t& dir = _ccdDirCache[tid][key];
@@ -3956,6 +4011,7 @@ int collideMeshBox(
   mesh1.mesh = mesh0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = getCcdMeshHull(o1, mesh0);
 
   ccdBox box2;
   box2.size = &size1;
@@ -4008,6 +4064,7 @@ int collideBoxMesh(
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = getCcdMeshHull(o2, m1);
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -4052,6 +4109,7 @@ int collideMeshSphere(
   mesh.mesh = mesh0;
   mesh.transform = &c0;
   mesh.scale = &size0;
+  mesh.hull = getCcdMeshHull(o1, mesh0);
 
   ccdSphere sphere;
   sphere.radius = r1;
@@ -4104,6 +4162,7 @@ int collideSphereMesh(
   mesh.mesh = mesh1;
   mesh.transform = &c1;
   mesh.scale = &size1;
+  mesh.hull = getCcdMeshHull(o2, mesh1);
 
   // set up ccd_t struct
   ccd.support1 = ccdSupportSphere; // support function for first object
@@ -4155,11 +4214,13 @@ int collideMeshMesh(
   mesh1.mesh = m0;
   mesh1.transform = &c0;
   mesh1.scale = &size0;
+  mesh1.hull = getCcdMeshHull(o1, m0);
 
   ccdMesh mesh2;
   mesh2.mesh = m1;
   mesh2.transform = &c1;
   mesh2.scale = &size1;
+  mesh2.hull = getCcdMeshHull(o2, m1);
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -4669,6 +4730,7 @@ int collideMeshCapsule(
   mesh1.mesh = m0;
   mesh1.transform = &T0;
   mesh1.scale = &size0;
+  mesh1.hull = getCcdMeshHull(o1, m0);
 
   ccdCapsule capsule2;
   capsule2.height = height1;
@@ -4782,6 +4844,7 @@ int collideCapsuleMesh(
   mesh2.mesh = m1;
   mesh2.scale = &size1;
   mesh2.transform = &T1;
+  mesh2.hull = getCcdMeshHull(o2, m1);
 
   ccd_real_t depth;
   ccd_vec3_t& dir = getCachedCcdDir(o1, o2);
@@ -5025,6 +5088,768 @@ int collideCylinderPlane(
   return 0;
 }
 
+//==============================================================================
+// Heightmaps
+//
+// The vertex in row i and column j of a HeightmapShape sits at
+//
+//   x = (j - (width - 1) / 2) * scale.x
+//   y = ((depth - 1) / 2 - i) * scale.y
+//   z = height(i, j) * scale.z
+//
+// in the shape's frame, so the grid is centered on the origin with rows
+// running along -y, as HeightmapShape documents. Each cell is split into two
+// triangles along its (i, j) -> (i + 1, j + 1) diagonal, and everything below
+// the surface is solid. Because the grid is regular, we can go straight from
+// a point to the cell under it, so these routines only ever visit the cells
+// under the other shape's footprint, however big the terrain is.
+//
+// HeightmapShape is templated on the type of its heights, so these live here
+// (where collide() instantiates them) rather than in the header.
+
+namespace {
+
+/// Which feature of a triangle closestPointOnTriangle() landed on
+enum TriangleFeature
+{
+  TRIANGLE_VERTEX,
+  TRIANGLE_EDGE,
+  TRIANGLE_FACE
+};
+
+/// Returns the closest point to p on the triangle (a, b, c), from Ericson's
+/// "Real-Time Collision Detection", section 5.1.5. If that's on an edge, this
+/// also returns the ends of the edge.
+Eigen::Vector3s closestPointOnTriangle(
+    const Eigen::Vector3s& p,
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& b,
+    const Eigen::Vector3s& c,
+    TriangleFeature& feature,
+    Eigen::Vector3s& edgeStart,
+    Eigen::Vector3s& edgeEnd)
+{
+  const Eigen::Vector3s ab = b - a;
+  const Eigen::Vector3s ac = c - a;
+  const Eigen::Vector3s ap = p - a;
+  const s_t d1 = ab.dot(ap);
+  const s_t d2 = ac.dot(ap);
+  feature = TRIANGLE_VERTEX;
+  if (d1 <= 0 && d2 <= 0)
+    return a;
+
+  const Eigen::Vector3s bp = p - b;
+  const s_t d3 = ab.dot(bp);
+  const s_t d4 = ac.dot(bp);
+  if (d3 >= 0 && d4 <= d3)
+    return b;
+
+  const Eigen::Vector3s cp = p - c;
+  const s_t d5 = ab.dot(cp);
+  const s_t d6 = ac.dot(cp);
+  if (d6 >= 0 && d5 <= d6)
+    return c;
+
+  feature = TRIANGLE_EDGE;
+  const s_t vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0)
+  {
+    edgeStart = a;
+    edgeEnd = b;
+    return a + ab * (d1 / (d1 - d3));
+  }
+
+  const s_t vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0)
+  {
+    edgeStart = a;
+    edgeEnd = c;
+    return a + ac * (d2 / (d2 - d6));
+  }
+
+  const s_t va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+  {
+    edgeStart = b;
+    edgeEnd = c;
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+
+  feature = TRIANGLE_FACE;
+  const s_t denom = 1.0 / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/// A view of the grid of a HeightmapShape<S>, in the shape's frame
+template <typename S>
+class HeightmapGrid
+{
+public:
+  explicit HeightmapGrid(const dynamics::HeightmapShape<S>* shape)
+    : mHeights(shape->getHeightField()),
+      mScale(shape->getScale().template cast<s_t>()),
+      mHalfWidth(0.5 * (static_cast<s_t>(mHeights.cols()) - 1.0)),
+      mHalfDepth(0.5 * (static_cast<s_t>(mHeights.rows()) - 1.0)),
+      mMaxZ(static_cast<s_t>(shape->getMaxHeight()) * mScale.z())
+  {
+    // Do nothing
+  }
+
+  /// Returns the highest point on the surface
+  s_t getMaxZ() const
+  {
+    return mMaxZ;
+  }
+
+  /// Returns the vertex in row i and column j
+  Eigen::Vector3s getVertex(int i, int j) const
+  {
+    return Eigen::Vector3s(
+        (j - mHalfWidth) * mScale.x(),
+        (mHalfDepth - i) * mScale.y(),
+        static_cast<s_t>(mHeights(i, j)) * mScale.z());
+  }
+
+  /// Returns the corners of triangle 0 or 1 of the cell whose top-left
+  /// vertex is (i, j). Both are wound so that their normals point up.
+  void getTriangle(int i, int j, int triangle, Eigen::Vector3s* corners) const
+  {
+    corners[0] = getVertex(i, j);
+    corners[1] = triangle == 0 ? getVertex(i + 1, j) : getVertex(i + 1, j + 1);
+    corners[2] = triangle == 0 ? getVertex(i + 1, j + 1) : getVertex(i, j + 1);
+  }
+
+  /// Finds the cells under the rectangle spanned by the x and y of min and
+  /// max, as inclusive ranges of their top-left vertex. Returns false if the
+  /// rectangle misses the grid.
+  bool getCells(
+      const Eigen::Vector3s& min,
+      const Eigen::Vector3s& max,
+      int& rowStart,
+      int& rowEnd,
+      int& colStart,
+      int& colEnd) const
+  {
+    const int lastRow = static_cast<int>(mHeights.rows()) - 2;
+    const int lastCol = static_cast<int>(mHeights.cols()) - 2;
+    if (lastRow < 0 || lastCol < 0)
+      return false;
+
+    // Columns grow along x, and rows grow along -y
+    colStart = toCell(min.x() / mScale.x() + mHalfWidth, lastCol);
+    colEnd = toCell(max.x() / mScale.x() + mHalfWidth, lastCol);
+    rowStart = toCell(mHalfDepth - max.y() / mScale.y(), lastRow);
+    rowEnd = toCell(mHalfDepth - min.y() / mScale.y(), lastRow);
+    if (colStart > lastCol || colEnd < 0 || rowStart > lastRow || rowEnd < 0)
+      return false;
+
+    colStart = std::max(colStart, 0);
+    colEnd = std::min(colEnd, lastCol);
+    rowStart = std::max(rowStart, 0);
+    rowEnd = std::min(rowEnd, lastRow);
+    return true;
+  }
+
+  /// Finds the triangle directly above or below p, and returns false if p is
+  /// off the grid
+  bool getTriangleUnder(const Eigen::Vector3s& p, Eigen::Vector3s* corners)
+      const
+  {
+    const s_t col = p.x() / mScale.x() + mHalfWidth;
+    const s_t row = mHalfDepth - p.y() / mScale.y();
+    const int lastRow = static_cast<int>(mHeights.rows()) - 2;
+    const int lastCol = static_cast<int>(mHeights.cols()) - 2;
+    if (lastRow < 0 || lastCol < 0 || col < 0 || row < 0
+        || col > lastCol + 1 || row > lastRow + 1)
+      return false;
+
+    const int j = std::min(static_cast<int>(std::floor(col)), lastCol);
+    const int i = std::min(static_cast<int>(std::floor(row)), lastRow);
+    // Triangle 0 covers the half of the cell below the diagonal
+    getTriangle(i, j, (row - i) >= (col - j) ? 0 : 1, corners);
+    return true;
+  }
+
+protected:
+  /// Turns a fractional row or column into the index of the cell it's in.
+  /// Anything off the grid gets clamped to just past it, so that we don't
+  /// overflow casting to int.
+  static int toCell(s_t index, int last)
+  {
+    if (!(index >= 0.0))
+      return index < 0.0 ? -1 : last + 1;
+    if (index > last + 1)
+      return last + 1;
+    return std::min(static_cast<int>(std::floor(index)), last);
+  }
+
+  const typename dynamics::HeightmapShape<S>::HeightField& mHeights;
+
+  Eigen::Vector3s mScale;
+
+  s_t mHalfWidth;
+
+  s_t mHalfDepth;
+
+  s_t mMaxZ;
+};
+
+/// Returns the unit normal of a triangle from HeightmapGrid::getTriangle()
+Eigen::Vector3s getTriangleNormal(const Eigen::Vector3s* corners)
+{
+  return (corners[1] - corners[0]).cross(corners[2] - corners[0]).normalized();
+}
+
+/// Finds the deepest point where a sphere (given in the heightmap's frame)
+/// dips into the heightmap. If it does, this fills in the contact in the
+/// heightmap's frame, with the normal pointing out of the terrain, and
+/// returns true.
+template <typename S>
+bool findSphereHeightmapContact(
+    const HeightmapGrid<S>& grid,
+    const Eigen::Vector3s& center,
+    s_t radius,
+    Contact& contact)
+{
+  if (center.z() - radius > grid.getMaxZ())
+    return false;
+
+  int rowStart, rowEnd, colStart, colEnd;
+  const Eigen::Vector3s extents = Eigen::Vector3s::Constant(radius);
+  if (!grid.getCells(
+          center - extents,
+          center + extents,
+          rowStart,
+          rowEnd,
+          colStart,
+          colEnd))
+    return false;
+
+  bool found = false;
+  Eigen::Vector3s corners[3];
+  for (int i = rowStart; i <= rowEnd; i++)
+  {
+    for (int j = colStart; j <= colEnd; j++)
+    {
+      for (int triangle = 0; triangle < 2; triangle++)
+      {
+        grid.getTriangle(i, j, triangle, corners);
+        TriangleFeature feature;
+        Eigen::Vector3s edgeStart;
+        Eigen::Vector3s edgeEnd;
+        const Eigen::Vector3s closest = closestPointOnTriangle(
+            center,
+            corners[0],
+            corners[1],
+            corners[2],
+            feature,
+            edgeStart,
+            edgeEnd);
+        const Eigen::Vector3s faceNormal = getTriangleNormal(corners);
+        const s_t height = faceNormal.dot(center - corners[0]);
+
+        Eigen::Vector3s normal;
+        s_t depth;
+        if (height < 0)
+        {
+          // If the center is under this triangle, we're deep in the terrain.
+          // If it's only under the triangle's plane, some other triangle is
+          // the one above the center, so we skip this one.
+          const Eigen::Vector3s projected = center - height * faceNormal;
+          if ((projected - closest).squaredNorm()
+              > DART_COLLISION_EPS * DART_COLLISION_EPS)
+            continue;
+          feature = TRIANGLE_FACE;
+          normal = faceNormal;
+          depth = radius - height;
+        }
+        else
+        {
+          const Eigen::Vector3s diff = center - closest;
+          const s_t dist = diff.norm();
+          if (dist >= radius)
+            continue;
+          normal = dist > DART_COLLISION_EPS ? Eigen::Vector3s(diff / dist)
+                                             : faceNormal;
+          depth = radius - dist;
+        }
+
+        if (found && depth <= contact.penetrationDepth)
+          continue;
+        found = true;
+        contact.normal = normal;
+        contact.penetrationDepth = depth;
+        // These follow the same conventions as the sphere-mesh contacts, so
+        // that the contact gradients can treat them the same way
+        if (feature == TRIANGLE_FACE)
+        {
+          contact.type = SPHERE_FACE;
+          contact.point = center - normal * radius;
+        }
+        else if (feature == TRIANGLE_EDGE)
+        {
+          contact.type = SPHERE_EDGE;
+          contact.point = closest;
+          contact.edgeAFixedPoint = edgeStart;
+          contact.edgeAClosestPoint = closest;
+          contact.edgeADir = (edgeEnd - edgeStart).normalized();
+        }
+        else
+        {
+          contact.type = SPHERE_VERTEX;
+          contact.point = closest;
+          contact.vertexPoint = closest;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+/// Moves a contact found by findSphereHeightmapContact() into the world
+/// frame, and flips it around if the heightmap is the first object
+void finishHeightmapContact(
+    Contact& contact,
+    const Eigen::Isometry3s& heightmapTransform,
+    bool heightmapIsFirst)
+{
+  contact.point = heightmapTransform * contact.point;
+  contact.normal = heightmapTransform.linear() * contact.normal;
+  contact.vertexPoint = heightmapTransform * contact.vertexPoint;
+  contact.sphereCenter = heightmapTransform * contact.sphereCenter;
+  contact.edgeAFixedPoint = heightmapTransform * contact.edgeAFixedPoint;
+  contact.edgeAClosestPoint = heightmapTransform * contact.edgeAClosestPoint;
+  contact.edgeADir = heightmapTransform.linear() * contact.edgeADir;
+  if (heightmapIsFirst)
+  {
+    contact.normal = -contact.normal;
+    if (contact.type == SPHERE_VERTEX)
+      contact.type = VERTEX_SPHERE;
+    else if (contact.type == SPHERE_EDGE)
+      contact.type = EDGE_SPHERE;
+    else if (contact.type == SPHERE_FACE)
+      contact.type = FACE_SPHERE;
+    else if (contact.type == VERTEX_FACE)
+      contact.type = FACE_VERTEX;
+    else if (contact.type == FACE_VERTEX)
+      contact.type = VERTEX_FACE;
+  }
+}
+
+} // namespace
+
+//==============================================================================
+template <typename S>
+int collideSphereHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const s_t& r0,
+    const Eigen::Isometry3s& c0,
+    const dynamics::HeightmapShape<S>* heightmap1,
+    const Eigen::Isometry3s& c1,
+    const CollisionOption& option,
+    CollisionResult& result,
+    bool heightmapIsFirst = false)
+{
+  const HeightmapGrid<S> grid(heightmap1);
+  const Eigen::Vector3s center = c1.inverse() * c0.translation();
+
+  Contact contact;
+  if (!findSphereHeightmapContact(grid, center, r0, contact))
+    return 0;
+  if (contact.penetrationDepth > option.contactClippingDepth)
+    return 0;
+
+  contact.collisionObject1 = heightmapIsFirst ? o2 : o1;
+  contact.collisionObject2 = heightmapIsFirst ? o1 : o2;
+  contact.sphereCenter = center;
+  contact.sphereRadius = r0;
+  finishHeightmapContact(contact, c1, heightmapIsFirst);
+  result.addContact(contact);
+  return 1;
+}
+
+//==============================================================================
+template <typename S>
+int collideCapsuleHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const s_t& height0,
+    const s_t& radius0,
+    const Eigen::Isometry3s& c0,
+    const dynamics::HeightmapShape<S>* heightmap1,
+    const Eigen::Isometry3s& c1,
+    const CollisionOption& option,
+    CollisionResult& result,
+    bool heightmapIsFirst = false)
+{
+  const HeightmapGrid<S> grid(heightmap1);
+  const Eigen::Isometry3s capsuleInMap = c1.inverse() * c0;
+  const Eigen::Vector3s top = capsuleInMap * Eigen::Vector3s(0, 0, height0 / 2);
+  const Eigen::Vector3s bottom
+      = capsuleInMap * Eigen::Vector3s(0, 0, -height0 / 2);
+
+  // We treat the capsule as a row of spheres down its axis, no more than a
+  // radius apart, so a bump can't poke in between two of them by more than
+  // about an eighth of the radius
+  const s_t spacing = std::max(radius0, static_cast<s_t>(1e-3));
+  const int numSpheres
+      = 1 + std::max(1, static_cast<int>(std::ceil(height0 / spacing)));
+
+  int numContacts = 0;
+  for (int k = 0; k < numSpheres; k++)
+  {
+    const s_t t = static_cast<s_t>(k) / (numSpheres - 1);
+    const Eigen::Vector3s center = (1.0 - t) * bottom + t * top;
+
+    Contact contact;
+    if (!findSphereHeightmapContact(grid, center, radius0, contact))
+      continue;
+    if (contact.penetrationDepth > option.contactClippingDepth)
+      continue;
+
+    contact.collisionObject1 = heightmapIsFirst ? o2 : o1;
+    contact.collisionObject2 = heightmapIsFirst ? o1 : o2;
+    // Each sphere is rigidly attached to the capsule, so the sphere contact
+    // gradients hold for all of them, not just the end caps
+    contact.sphereCenter = center;
+    contact.sphereRadius = radius0;
+    finishHeightmapContact(contact, c1, heightmapIsFirst);
+    result.addContact(contact);
+    numContacts++;
+  }
+  return numContacts;
+}
+
+//==============================================================================
+template <typename S>
+int collideBoxHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const Eigen::Vector3s& size0,
+    const Eigen::Isometry3s& c0,
+    const dynamics::HeightmapShape<S>* heightmap1,
+    const Eigen::Isometry3s& c1,
+    const CollisionOption& option,
+    CollisionResult& result,
+    bool heightmapIsFirst = false)
+{
+  const HeightmapGrid<S> grid(heightmap1);
+  const Eigen::Isometry3s boxInMap = c1.inverse() * c0;
+  const Eigen::Vector3s halfSize = 0.5 * size0;
+
+  Eigen::Vector3s corners[8];
+  Eigen::Vector3s min = Eigen::Vector3s::Constant(
+      std::numeric_limits<s_t>::infinity());
+  Eigen::Vector3s max = -min;
+  for (int k = 0; k < 8; k++)
+  {
+    corners[k] = boxInMap
+                 * Eigen::Vector3s(
+                     (k & 1) ? halfSize.x() : -halfSize.x(),
+                     (k & 2) ? halfSize.y() : -halfSize.y(),
+                     (k & 4) ? halfSize.z() : -halfSize.z());
+    min = min.cwiseMin(corners[k]);
+    max = max.cwiseMax(corners[k]);
+  }
+  if (min.z() > grid.getMaxZ())
+    return 0;
+
+  auto addContact = [&](const Eigen::Vector3s& point,
+                        const Eigen::Vector3s& normal,
+                        s_t depth,
+                        ContactType type) {
+    if (depth > option.contactClippingDepth)
+      return;
+    Contact contact;
+    contact.collisionObject1 = heightmapIsFirst ? o2 : o1;
+    contact.collisionObject2 = heightmapIsFirst ? o1 : o2;
+    contact.point = point;
+    contact.normal = normal;
+    contact.penetrationDepth = depth;
+    contact.vertexPoint = point;
+    contact.type = type;
+    finishHeightmapContact(contact, c1, heightmapIsFirst);
+    result.addContact(contact);
+  };
+  const std::size_t numContactsBefore = result.getNumContacts();
+
+  // Box corners that are under the surface
+  Eigen::Vector3s triangle[3];
+  for (int k = 0; k < 8; k++)
+  {
+    if (!grid.getTriangleUnder(corners[k], triangle))
+      continue;
+    const Eigen::Vector3s normal = getTriangleNormal(triangle);
+    const s_t depth = normal.dot(triangle[0] - corners[k]);
+    if (depth > 0)
+      addContact(corners[k], normal, depth, VERTEX_FACE);
+  }
+
+  // Terrain vertices that are inside the box. These push against whichever
+  // face of the box is facing most directly down into the terrain. Where the
+  // terrain is flatter than the box, the corners already hold the box up, so
+  // we only want the vertices that poke in deeper than any of the corners.
+  s_t deepestCorner = 0.0;
+  for (std::size_t k = numContactsBefore; k < result.getNumContacts(); k++)
+  {
+    deepestCorner = std::max(
+        deepestCorner, result.getContact(k).penetrationDepth);
+  }
+  int rowStart, rowEnd, colStart, colEnd;
+  if (grid.getCells(min, max, rowStart, rowEnd, colStart, colEnd))
+  {
+    const Eigen::Matrix3s R = boxInMap.linear();
+    int axis;
+    R.row(2).cwiseAbs().maxCoeff(&axis);
+    const s_t sign = R(2, axis) > 0 ? -1.0 : 1.0;
+    // This points from the terrain into the box
+    const Eigen::Vector3s normal = -sign * R.col(axis);
+
+    for (int i = rowStart; i <= rowEnd + 1; i++)
+    {
+      for (int j = colStart; j <= colEnd + 1; j++)
+      {
+        const Eigen::Vector3s vertex = grid.getVertex(i, j);
+        if (vertex.z() < min.z())
+          continue;
+        const Eigen::Vector3s local = boxInMap.inverse() * vertex;
+        if ((local.cwiseAbs().array() >= halfSize.array()).any())
+          continue;
+        const s_t depth = halfSize(axis) - sign * local(axis);
+        if (depth > deepestCorner + DART_COLLISION_EPS)
+          addContact(vertex, normal, depth, FACE_VERTEX);
+      }
+    }
+  }
+
+  return static_cast<int>(result.getNumContacts() - numContactsBefore);
+}
+
+//==============================================================================
+/// Collides a heightmap with the shape of the other object, which is the
+/// first object unless heightmapIsFirst. Returns -1 if we don't support that
+/// kind of shape against a heightmap.
+template <typename S>
+int collideWithHeightmap(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::Shape* shape0,
+    const Eigen::Isometry3s& c0,
+    const dynamics::HeightmapShape<S>* heightmap1,
+    const Eigen::Isometry3s& c1,
+    const CollisionOption& option,
+    CollisionResult& result,
+    bool heightmapIsFirst)
+{
+  const auto& shapeType0 = shape0->getType();
+  if (dynamics::SphereShape::getStaticType() == shapeType0)
+  {
+    const auto* sphere0 = static_cast<const dynamics::SphereShape*>(shape0);
+
+    return collideSphereHeightmap(
+        o1,
+        o2,
+        sphere0->getRadius(),
+        c0,
+        heightmap1,
+        c1,
+        option,
+        result,
+        heightmapIsFirst);
+  }
+  else if (dynamics::EllipsoidShape::getStaticType() == shapeType0)
+  {
+    const auto* ellipsoid0
+        = static_cast<const dynamics::EllipsoidShape*>(shape0);
+
+    return collideSphereHeightmap(
+        o1,
+        o2,
+        ellipsoid0->getRadii()[0],
+        c0,
+        heightmap1,
+        c1,
+        option,
+        result,
+        heightmapIsFirst);
+  }
+  else if (dynamics::BoxShape::getStaticType() == shapeType0)
+  {
+    const auto* box0 = static_cast<const dynamics::BoxShape*>(shape0);
+
+    return collideBoxHeightmap(
+        o1,
+        o2,
+        box0->getSize(),
+        c0,
+        heightmap1,
+        c1,
+        option,
+        result,
+        heightmapIsFirst);
+  }
+  else if (dynamics::CapsuleShape::getStaticType() == shapeType0)
+  {
+    const auto* capsule0 = static_cast<const dynamics::CapsuleShape*>(shape0);
+
+    return collideCapsuleHeightmap(
+        o1,
+        o2,
+        capsule0->getHeight(),
+        capsule0->getRadius(),
+        c0,
+        heightmap1,
+        c1,
+        option,
+        result,
+        heightmapIsFirst);
+  }
+
+  return -1;
+}
+
+//==============================================================================
+/// Collides a point cloud with the shape of the other object, which is the
+/// first object unless cloudIsFirst. Each point is a ball with a diameter of
+/// the cloud's visual size, and we only look at the points the cloud's index
+/// finds near the other shape. Returns -1 if we don't support that kind of
+/// shape against a point cloud.
+int collideWithPointCloud(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const dynamics::Shape* shape0,
+    const Eigen::Isometry3s& c0,
+    const dynamics::PointCloudShape* cloud1,
+    const Eigen::Isometry3s& c1,
+    const CollisionOption& option,
+    CollisionResult& result,
+    bool cloudIsFirst)
+{
+  const auto& shapeType0 = shape0->getType();
+  const bool isSphere
+      = dynamics::SphereShape::getStaticType() == shapeType0
+        || dynamics::EllipsoidShape::getStaticType() == shapeType0;
+  if (!isSphere && dynamics::BoxShape::getStaticType() != shapeType0
+      && dynamics::CapsuleShape::getStaticType() != shapeType0
+      && dynamics::MeshShape::getStaticType() != shapeType0)
+    return -1;
+
+  // Find the points near the other shape's bounding box, in the cloud's frame
+  const Eigen::Isometry3s shapeInCloud = c1.inverse() * c0;
+  const math::BoundingBox& box = shape0->getBoundingBox();
+  const Eigen::Vector3s center = shapeInCloud * box.computeCenter();
+  const Eigen::Vector3s extents
+      = shapeInCloud.linear().cwiseAbs() * box.computeHalfExtents();
+  const std::vector<std::size_t> points
+      = cloud1->getPointsInBox(center - extents, center + extents);
+
+  const s_t radius1 = cloud1->getVisualSize() / 2;
+  int numContacts = 0;
+  for (std::size_t i : points)
+  {
+    Eigen::Isometry3s pointTransform = c1;
+    pointTransform.translation() = c1 * cloud1->getPoints()[i];
+
+    // These keep the objects in their original order, so the contacts come
+    // out the right way around
+    if (isSphere)
+    {
+      const s_t radius0
+          = dynamics::SphereShape::getStaticType() == shapeType0
+                ? static_cast<const dynamics::SphereShape*>(shape0)->getRadius()
+                : static_cast<const dynamics::EllipsoidShape*>(shape0)
+                      ->getRadii()[0];
+      if (cloudIsFirst)
+      {
+        numContacts += collideSphereSphere(
+            o2, o1, radius1, pointTransform, radius0, c0, option, result);
+      }
+      else
+      {
+        numContacts += collideSphereSphere(
+            o1, o2, radius0, c0, radius1, pointTransform, option, result);
+      }
+    }
+    else if (dynamics::BoxShape::getStaticType() == shapeType0)
+    {
+      const Eigen::Vector3s& size0
+          = static_cast<const dynamics::BoxShape*>(shape0)->getSize();
+      if (cloudIsFirst)
+      {
+        numContacts += collideSphereBox(
+            o2, o1, radius1, pointTransform, size0, c0, option, result);
+      }
+      else
+      {
+        numContacts += collideBoxSphere(
+            o1, o2, size0, c0, radius1, pointTransform, option, result);
+      }
+    }
+    else if (dynamics::CapsuleShape::getStaticType() == shapeType0)
+    {
+      const auto* capsule0 = static_cast<const dynamics::CapsuleShape*>(shape0);
+      if (cloudIsFirst)
+      {
+        numContacts += collideSphereCapsule(
+            o2,
+            o1,
+            radius1,
+            pointTransform,
+            capsule0->getHeight(),
+            capsule0->getRadius(),
+            c0,
+            option,
+            result);
+      }
+      else
+      {
+        numContacts += collideCapsuleSphere(
+            o1,
+            o2,
+            capsule0->getHeight(),
+            capsule0->getRadius(),
+            c0,
+            radius1,
+            pointTransform,
+            option,
+            result);
+      }
+    }
+    else
+    {
+      const auto* mesh0 = static_cast<const dynamics::MeshShape*>(shape0);
+      if (cloudIsFirst)
+      {
+        numContacts += collideSphereMesh(
+            o2,
+            o1,
+            radius1,
+            pointTransform,
+            mesh0->getMesh(),
+            mesh0->getScale(),
+            c0,
+            option,
+            result);
+      }
+      else
+      {
+        numContacts += collideMeshSphere(
+            o1,
+            o2,
+            mesh0->getMesh(),
+            mesh0->getScale(),
+            c0,
+            radius1,
+            pointTransform,
+            option,
+            result);
+      }
+    }
+  }
+  return numContacts;
+}
+
 //==============================================================================
 int collide(
     CollisionObject* o1,
@@ -5044,6 +5869,95 @@ int collide(
   const Eigen::Isometry3s& T1 = o1->getTransform();
   const Eigen::Isometry3s& T2 = o2->getTransform();
 
+  // Heightmaps come with either float or s_t heights, and can be on either
+  // side of the pair, so we sort them out before everything else
+  int heightmapContacts = -1;
+  if (dynamics::HeightmapShapef::getStaticType() == shapeType2)
+  {
+    heightmapContacts = collideWithHeightmap(
+        o1,
+        o2,
+        shape1.get(),
+        T1,
+        static_cast<const dynamics::HeightmapShapef*>(shape2.get()),
+        T2,
+        option,
+        result,
+        false);
+  }
+  else if (dynamics::HeightmapShaped::getStaticType() == shapeType2)
+  {
+    heightmapContacts = collideWithHeightmap(
+        o1,
+        o2,
+        shape1.get(),
+        T1,
+        static_cast<const dynamics::HeightmapShaped*>(shape2.get()),
+        T2,
+        option,
+        result,
+        false);
+  }
+  else if (dynamics::HeightmapShapef::getStaticType() == shapeType1)
+  {
+    heightmapContacts = collideWithHeightmap(
+        o2,
+        o1,
+        shape2.get(),
+        T2,
+        static_cast<const dynamics::HeightmapShapef*>(shape1.get()),
+        T1,
+        option,
+        result,
+        true);
+  }
+  else if (dynamics::HeightmapShaped::getStaticType() == shapeType1)
+  {
+    heightmapContacts = collideWithHeightmap(
+        o2,
+        o1,
+        shape2.get(),
+        T2,
+        static_cast<const dynamics::HeightmapShaped*>(shape1.get()),
+        T1,
+        option,
+        result,
+        true);
+  }
+  if (heightmapContacts >= 0)
+    return heightmapContacts;
+
+  // Point clouds can also be on either side
+  int pointCloudContacts = -1;
+  if (dynamics::PointCloudShape::getStaticType() == shapeType2)
+  {
+    pointCloudContacts = collideWithPointCloud(
+        o1,
+        o2,
+        shape1.get(),
+        T1,
+        static_cast<const dynamics::PointCloudShape*>(shape2.get()),
+        T2,
+        option,
+        result,
+        false);
+  }
+  else if (dynamics::PointCloudShape::getStaticType() == shapeType1)
+  {
+    pointCloudContacts = collideWithPointCloud(
+        o2,
+        o1,
+        shape2.get(),
+        T2,
+        static_cast<const dynamics::PointCloudShape*>(shape1.get()),
+        T1,
+        option,
+        result,
+        true);
+  }
+  if (pointCloudContacts >= 0)
+    return pointCloudContacts;
+
   if (dynamics::SphereShape::getStaticType() == shapeType1)
   {
     const auto* sphere0
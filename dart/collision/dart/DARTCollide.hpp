@@ -43,6 +43,7 @@
 #include <ccd/vec3.h>
 
 #include "dart/collision/CollisionDetector.hpp"
+#include "dart/math/ConvexHull.hpp"
 
 namespace dart {
 namespace collision {
@@ -295,7 +296,9 @@ int collideCylinderPlane(
 // Interface with libccd:
 /////////////////////////////////////////////////////////////////////
 
-// Get the `pos` vec for CCD for this pair of objects
+// Get the `pos` vec for CCD for this pair of objects. This comes from the
+// thread's active ContactCache if there is one, and otherwise from a global
+// per-thread cache.
 ccd_vec3_t& getCachedCcdPos(CollisionObject* o1, CollisionObject* o2);
 
 // Get the `dir` vec for CCD for this pair of objects
@@ -320,8 +323,20 @@ struct ccdMesh
   const aiScene* mesh;
   const Eigen::Isometry3s* transform;
   const Eigen::Vector3s* scale;
+  // If this is set, support queries walk the convex hull of the mesh instead
+  // of checking every vertex
+  const math::ConvexHull* hull = nullptr;
+  // The hull vertex we found on the last support query, which is where we
+  // start walking from on the next one
+  int supportHint = -1;
 };
 
+/// This returns the cached convex hull of `mesh` if it belongs to the
+/// MeshShape of `object`, and is big enough that walking the hull beats
+/// checking every vertex. Otherwise, this returns nullptr.
+const math::ConvexHull* getCcdMeshHull(
+    CollisionObject* object, const aiScene* mesh);
+
 struct ccdCapsule
 {
   s_t radius;
@@ -32,15 +32,25 @@
 
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
 
+#include <algorithm>
+#include <future>
+#include <thread>
+
 #include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/DistanceFilter.hpp"
+#include "dart/collision/ContactReduction.hpp"
 #include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/collision/dart/DARTContinuousCollision.hpp"
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 #include "dart/collision/dart/DARTCollisionObject.hpp"
+#include "dart/collision/dart/DARTDistance.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/CapsuleShape.hpp"
 #include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/HeightmapShape.hpp"
 #include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
 #include "dart/dynamics/ShapeFrame.hpp"
 #include "dart/dynamics/SphereShape.hpp"
 
@@ -49,11 +59,45 @@ namespace collision {
 
 namespace {
 
+using ObjectPairs = std::vector<std::pair<CollisionObject*, CollisionObject*>>;
+
+/// A pair of objects to find the distance between, along with a lower bound
+/// on that distance from their bounding boxes
+struct DistancePair
+{
+  s_t lowerBound;
+  CollisionObject* o1;
+  CollisionObject* o2;
+};
+
+using DistancePairs = std::vector<DistancePair>;
+
+bool checkPairs(
+    const ObjectPairs& pairs,
+    const CollisionOption& option,
+    CollisionResult* result,
+    ContactCache* cache,
+    int numThreads);
+
 bool checkPair(
     CollisionObject* o1,
     CollisionObject* o2,
     const CollisionOption& option,
-    CollisionResult* result = nullptr);
+    CollisionResult* result = nullptr,
+    ContactCache* cache = nullptr);
+
+void narrowphase(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const CollisionOption& option,
+    CollisionResult& pairResult,
+    ContactCache* cache);
+
+double checkDistancePairs(
+    DistancePairs& pairs,
+    const DistanceOption& option,
+    DistanceResult* result,
+    ContactCache* cache);
 
 bool isClose(
     const Eigen::Vector3s& pos1, const Eigen::Vector3s& pos2, double tol);
@@ -144,38 +188,33 @@ bool DARTCollisionDetector::collide(
   if (objects.empty())
     return false;
 
-  auto collisionFound = false;
-  const auto& filter = option.collisionFilter;
+  // Broadphase: only pairs with overlapping bounding boxes go on to the
+  // narrowphase
+  casted->mSweepTimeStep = option.continuousCollisionTimeStep;
+  casted->updateEngineData();
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  casted->getOverlappingPairs(pairs);
 
-  for (auto i = 0u; i < objects.size() - 1; ++i)
+  const auto& filter = option.collisionFilter;
+  ObjectPairs objectPairs;
+  objectPairs.reserve(pairs.size());
+  for (const auto& pair : pairs)
   {
-    auto* collObj1 = objects[i];
-
-    for (auto j = i + 1u; j < objects.size(); ++j)
-    {
-      auto* collObj2 = objects[j];
-
-      if (filter && filter->ignoresCollision(collObj1, collObj2))
-        continue;
+    auto* collObj1 = objects[pair.first];
+    auto* collObj2 = objects[pair.second];
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+    if (filter && filter->ignoresCollision(collObj1, collObj2))
+      continue;
 
-      if (result)
-      {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
-      }
-    }
+    objectPairs.emplace_back(collObj1, collObj2);
   }
 
-  // Either no collision found or not reached the maximum number of contacts
-  return collisionFound;
+  return checkPairs(
+      objectPairs,
+      option,
+      result,
+      &casted->mContactCache,
+      mNumCollisionThreads);
 }
 
 //==============================================================================
@@ -206,9 +245,14 @@ bool DARTCollisionDetector::collide(
   if (objects1.empty() || objects2.empty())
     return false;
 
-  auto collisionFound = false;
-  const auto& filter = option.collisionFilter;
+  casted1->mSweepTimeStep = option.continuousCollisionTimeStep;
+  casted2->mSweepTimeStep = option.continuousCollisionTimeStep;
+  casted1->updateEngineData();
+  casted2->updateEngineData();
 
+  // Pairs across two groups are cached on the first group
+  const auto& filter = option.collisionFilter;
+  ObjectPairs objectPairs;
   for (auto i = 0u; i < objects1.size(); ++i)
   {
     auto* collObj1 = objects1[i];
@@ -217,58 +261,285 @@ bool DARTCollisionDetector::collide(
     {
       auto* collObj2 = objects2[j];
 
+      // Broadphase: skip pairs whose bounding boxes don't overlap
+      if (!casted1->overlaps(i, casted2, j))
+        continue;
+
       if (filter && filter->ignoresCollision(collObj1, collObj2))
         continue;
 
-      collisionFound = checkPair(collObj1, collObj2, option, result);
+      objectPairs.emplace_back(collObj1, collObj2);
+    }
+  }
+
+  return checkPairs(
+      objectPairs,
+      option,
+      result,
+      &casted1->mContactCache,
+      mNumCollisionThreads);
+}
+
+//==============================================================================
+double DARTCollisionDetector::distance(
+    CollisionGroup* group, const DistanceOption& option, DistanceResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group))
+    return 0.0;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  const auto& objects = casted->mCollisionObjects;
+
+  casted->mSweepTimeStep = 0;
+  casted->updateEngineData();
+
+  const auto& filter = option.distanceFilter;
+  DistancePairs pairs;
+  for (auto i = 0u; i < objects.size(); ++i)
+  {
+    for (auto j = i + 1; j < objects.size(); ++j)
+    {
+      // Broadphase: skip pairs whose bounding boxes are already too far apart
+      const s_t lowerBound = casted->getAabbDistance(i, casted, j);
+      if (lowerBound > option.distanceUpperBound)
+        continue;
+
+      if (filter && !filter->needDistance(objects[i], objects[j]))
+        continue;
+
+      pairs.push_back({lowerBound, objects[i], objects[j]});
+    }
+  }
+
+  return checkDistancePairs(pairs, option, result, &casted->mContactCache);
+}
+
+//==============================================================================
+double DARTCollisionDetector::distance(
+    CollisionGroup* group1,
+    CollisionGroup* group2,
+    const DistanceOption& option,
+    DistanceResult* result)
+{
+  if (result)
+    result->clear();
+
+  if (!checkGroupValidity(this, group1))
+    return 0.0;
+
+  if (!checkGroupValidity(this, group2))
+    return 0.0;
+
+  auto casted1 = static_cast<DARTCollisionGroup*>(group1);
+  auto casted2 = static_cast<DARTCollisionGroup*>(group2);
+
+  const auto& objects1 = casted1->mCollisionObjects;
+  const auto& objects2 = casted2->mCollisionObjects;
+
+  casted1->mSweepTimeStep = 0;
+  casted2->mSweepTimeStep = 0;
+  casted1->updateEngineData();
+  casted2->updateEngineData();
+
+  // Pairs across two groups are cached on the first group
+  const auto& filter = option.distanceFilter;
+  DistancePairs pairs;
+  for (auto i = 0u; i < objects1.size(); ++i)
+  {
+    for (auto j = 0u; j < objects2.size(); ++j)
+    {
+      // Broadphase: skip pairs whose bounding boxes are already too far apart
+      const s_t lowerBound = casted1->getAabbDistance(i, casted2, j);
+      if (lowerBound > option.distanceUpperBound)
+        continue;
+
+      if (filter && !filter->needDistance(objects1[i], objects2[j]))
+        continue;
+
+      pairs.push_back({lowerBound, objects1[i], objects2[j]});
+    }
+  }
+
+  return checkDistancePairs(pairs, option, result, &casted1->mContactCache);
+}
+
+//==============================================================================
+bool DARTCollisionDetector::raycast(
+    CollisionGroup* group,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    const RaycastOption& option,
+    RaycastResult* result)
+{
+  if (result)
+  {
+    result->clear();
+    result->mHasHit = false;
+  }
+
+  if (!checkGroupValidity(this, group))
+    return false;
+
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  casted->updateEngineData();
+
+  if (!option.mEnableAllHits)
+  {
+    RayHit hit;
+    if (!casted->raycastClosest(from, to, hit))
+      return false;
+    if (result)
+    {
+      result->mRayHits.push_back(hit);
+      result->mHasHit = true;
+    }
+    return true;
+  }
+
+  std::vector<RayHit> hits;
+  casted->raycastAll(from, to, hits);
+  if (hits.empty())
+    return false;
+
+  if (option.mSortByClosest)
+  {
+    std::stable_sort(
+        hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) {
+          return a.mFraction < b.mFraction;
+        });
+  }
+  if (result)
+  {
+    result->mRayHits = hits;
+    result->mHasHit = true;
+  }
+  return true;
+}
+
+//==============================================================================
+std::size_t DARTCollisionDetector::raycastBatch(
+    CollisionGroup* group,
+    const Eigen::MatrixXs& origins,
+    const Eigen::MatrixXs& directions,
+    const RaycastOption& /* option */,
+    RaycastBatchResult* result)
+{
+  if (origins.cols() != 3 || directions.cols() != 3
+      || origins.rows() != directions.rows())
+  {
+    dterr << "[DARTCollisionDetector::raycastBatch] origins and directions "
+          << "must both be Nx3 matrices with the same number of rows, but got "
+          << origins.rows() << "x" << origins.cols() << " and "
+          << directions.rows() << "x" << directions.cols()
+          << ". Ignoring call.\n";
+    return 0;
+  }
+
+  const int numRays = origins.rows();
+  if (result)
+    result->clear(numRays);
+
+  if (!checkGroupValidity(this, group))
+    return 0;
+
+  // We refresh the bounding boxes once up front, so that every thread below
+  // only reads from the group
+  auto casted = static_cast<DARTCollisionGroup*>(group);
+  casted->updateEngineData();
+
+  auto castRange = [&](int start, int end) -> std::size_t {
+    std::size_t numHits = 0;
+    RayHit hit;
+    for (int i = start; i < end; i++)
+    {
+      const Eigen::Vector3s from = origins.row(i).transpose();
+      const Eigen::Vector3s to = from + directions.row(i).transpose();
+      if (!casted->raycastClosest(from, to, hit))
+        continue;
 
+      numHits++;
       if (result)
       {
-        if (result->getNumContacts() >= option.maxNumContacts)
-          return true;
-      }
-      else
-      {
-        // If no result is passed, stop checking when the first contact is found
-        if (collisionFound)
-          return true;
+        result->mDistances(i) = hit.mFraction * directions.row(i).norm();
+        result->mNormals.row(i) = hit.mNormal.transpose();
+        result->mPoints.row(i) = hit.mPoint.transpose();
+        result->mCollisionObjects[i] = hit.mCollisionObject;
       }
     }
+    return numHits;
+  };
+
+  // Below this many rays per thread, it's not worth the overhead of
+  // launching the thread
+  const int minRaysPerChunk = 256;
+  int numChunks = std::min(mNumRaycastThreads, numRays / minRaysPerChunk);
+  if (numChunks <= 1)
+    return castRange(0, numRays);
+
+  std::vector<std::future<std::size_t>> futures;
+  int chunkSize = numRays / numChunks;
+  int remainder = numRays % numChunks;
+  int cursor = 0;
+  for (int chunk = 0; chunk < numChunks; chunk++)
+  {
+    int start = cursor;
+    int end = start + chunkSize + (chunk < remainder ? 1 : 0);
+    cursor = end;
+    futures.push_back(std::async(
+        std::launch::async, [&castRange, start, end]() -> std::size_t {
+          return castRange(start, end);
+        }));
   }
-
-  // Either no collision found or not reached the maximum number of contacts
-  return collisionFound;
+  std::size_t numHits = 0;
+  for (int i = 0; i < futures.size(); i++)
+  {
+    numHits += futures[i].get();
+  }
+  return numHits;
 }
 
 //==============================================================================
-double DARTCollisionDetector::distance(
-    CollisionGroup* /*group*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+void DARTCollisionDetector::setNumRaycastThreads(int numThreads)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  // hardware_concurrency() is allowed to return 0 if it can't tell
+  mNumRaycastThreads = std::max(numThreads, 1);
+}
 
-  return 0.0;
+//==============================================================================
+int DARTCollisionDetector::getNumRaycastThreads() const
+{
+  return mNumRaycastThreads;
 }
 
 //==============================================================================
-double DARTCollisionDetector::distance(
-    CollisionGroup* /*group1*/,
-    CollisionGroup* /*group2*/,
-    const DistanceOption& /*option*/,
-    DistanceResult* /*result*/)
+void DARTCollisionDetector::setNumCollisionThreads(int numThreads)
 {
-  dtwarn << "[DARTCollisionDetector::distance] This collision detector does "
-         << "not support (signed) distance queries. Returning 0.0.\n";
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  mNumCollisionThreads = std::max(numThreads, 1);
+}
 
-  return 0.0;
+//==============================================================================
+int DARTCollisionDetector::getNumCollisionThreads() const
+{
+  return mNumCollisionThreads;
 }
 
 //==============================================================================
 DARTCollisionDetector::DARTCollisionDetector() : CollisionDetector()
 {
   mCollisionObjectManager.reset(new ManagerForSharableCollisionObjects(this));
+  setNumRaycastThreads(0);
+  setNumCollisionThreads(1);
 }
 
 //==============================================================================
@@ -292,6 +563,13 @@ void warnUnsupportedShapeType(const dynamics::ShapeFrame* shapeFrame)
   if (shapeType == dynamics::CapsuleShape::getStaticType())
     return;
 
+  if (shapeType == dynamics::HeightmapShapef::getStaticType()
+      || shapeType == dynamics::HeightmapShaped::getStaticType())
+    return;
+
+  if (shapeType == dynamics::PointCloudShape::getStaticType())
+    return;
+
   if (shapeType == dynamics::EllipsoidShape::getStaticType())
   {
     const auto& ellipsoid
@@ -305,7 +583,8 @@ void warnUnsupportedShapeType(const dynamics::ShapeFrame* shapeFrame)
         << shapeType << "] that is not supported "
         << "by DARTCollisionDetector. Currently, only BoxShape and "
         << "EllipsoidShape (only when all the radii are equal) and SphereShape "
-           "and MeshShape and CapsuleShape are "
+           "and MeshShape and CapsuleShape and HeightmapShape and "
+           "PointCloudShape are "
         << "supported. This shape will always get penetrated by other "
         << "objects.\n";
 }
@@ -328,17 +607,120 @@ void DARTCollisionDetector::refreshCollisionObject(CollisionObject* /*object*/)
 
 namespace {
 
+//==============================================================================
+bool checkPairs(
+    const ObjectPairs& pairs,
+    const CollisionOption& option,
+    CollisionResult* result,
+    ContactCache* cache,
+    int numThreads)
+{
+  ContactCache::ScopedActivation activation(cache);
+
+  // Below this many pairs per thread, it's not worth the overhead of
+  // launching the thread
+  const int minPairsPerChunk = 16;
+  const int numPairs = pairs.size();
+  const int numChunks = std::min(numThreads, numPairs / minPairsPerChunk);
+
+  auto collisionFound = false;
+
+  if (numChunks <= 1)
+  {
+    for (const auto& pair : pairs)
+    {
+      collisionFound
+          = checkPair(pair.first, pair.second, option, result, cache);
+
+      if (result)
+      {
+        if (result->getNumContacts() >= option.maxNumContacts)
+          return true;
+      }
+      else
+      {
+        // If no result is passed, stop checking when the first contact is
+        // found
+        if (collisionFound)
+          return true;
+      }
+    }
+
+    // Either no collision found or not reached the maximum number of contacts
+    return collisionFound;
+  }
+
+  // Every pair gets its cache entry up front, so that the threads below only
+  // ever touch the entries of their own pairs, and never insert into the
+  // cache. The group has already brought every world transform (and, for the
+  // continuous check, every velocity) up to date when it refreshed its
+  // bounding boxes, so reading them is safe too.
+  if (cache)
+  {
+    for (const auto& pair : pairs)
+      cache->getEntry(pair.first, pair.second);
+  }
+
+  std::vector<CollisionResult> pairResults(numPairs);
+  auto checkRange = [&](int start, int end) {
+    ContactCache::ScopedActivation threadActivation(cache);
+    for (int i = start; i < end; i++)
+    {
+      narrowphase(
+          pairs[i].first, pairs[i].second, option, pairResults[i], cache);
+    }
+  };
+
+  std::vector<std::future<void>> futures;
+  int chunkSize = numPairs / numChunks;
+  int remainder = numPairs % numChunks;
+  int cursor = 0;
+  for (int chunk = 0; chunk < numChunks; chunk++)
+  {
+    int start = cursor;
+    int end = start + chunkSize + (chunk < remainder ? 1 : 0);
+    cursor = end;
+    futures.push_back(std::async(
+        std::launch::async,
+        [&checkRange, start, end]() { checkRange(start, end); }));
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+
+  // We merge in pair order, exactly as the serial loop above would have, so
+  // the contacts (and so the LCP) don't depend on the number of threads
+  for (int i = 0; i < numPairs; i++)
+  {
+    collisionFound = pairResults[i].isCollision();
+
+    if (result)
+    {
+      postProcess(
+          pairs[i].first, pairs[i].second, option, *result, pairResults[i]);
+      if (result->getNumContacts() >= option.maxNumContacts)
+        return true;
+    }
+    else if (collisionFound)
+    {
+      return true;
+    }
+  }
+
+  return collisionFound;
+}
+
 //==============================================================================
 bool checkPair(
     CollisionObject* o1,
     CollisionObject* o2,
     const CollisionOption& option,
-    CollisionResult* result)
+    CollisionResult* result,
+    ContactCache* cache)
 {
   CollisionResult pairResult;
-
-  // Perform narrow-phase detection
-  collide(o1, o2, option, pairResult);
+  narrowphase(o1, o2, option, pairResult, cache);
 
   // Early return for binary check
   if (!result)
@@ -349,6 +731,102 @@ bool checkPair(
   return pairResult.isCollision();
 }
 
+//==============================================================================
+void narrowphase(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    const CollisionOption& option,
+    CollisionResult& pairResult,
+    ContactCache* cache)
+{
+  // Perform narrow-phase detection, unless neither object has moved since the
+  // last time we checked this pair
+  if (!cache || !cache->getCachedContacts(o1, o2, option, pairResult))
+  {
+    collide(o1, o2, option, pairResult);
+    if (cache)
+      cache->setCachedContacts(o1, o2, option, pairResult);
+  }
+
+  // Pairs that aren't touching yet might still run into each other before
+  // the next check. This depends on the velocities, which the cache doesn't
+  // track, so we never cache it.
+  if (option.continuousCollisionTimeStep > 0 && !pairResult.isCollision())
+    collideContinuous(o1, o2, option.continuousCollisionTimeStep, pairResult);
+}
+
+//==============================================================================
+double checkDistancePairs(
+    DistancePairs& pairs,
+    const DistanceOption& option,
+    DistanceResult* result,
+    ContactCache* cache)
+{
+  ContactCache::ScopedActivation activation(cache);
+
+  // We check the pairs with the closest bounding boxes first. Once the boxes
+  // are further apart than the closest pair we've found, so is every pair
+  // after them, and we can stop.
+  std::sort(
+      pairs.begin(),
+      pairs.end(),
+      [](const DistancePair& a, const DistancePair& b) {
+        return a.lowerBound < b.lowerBound;
+      });
+
+  bool found = false;
+  s_t minDistance = option.distanceUpperBound;
+  const DistancePair* closest = nullptr;
+  Eigen::Vector3s nearestPoint1;
+  Eigen::Vector3s nearestPoint2;
+  for (const DistancePair& pair : pairs)
+  {
+    if (pair.lowerBound > minDistance
+        || (found && pair.lowerBound >= minDistance))
+      break;
+
+    ContactCache::PairEntry* entry
+        = cache ? &cache->getEntry(pair.o1, pair.o2) : nullptr;
+    s_t distance;
+    Eigen::Vector3s point1;
+    Eigen::Vector3s point2;
+    if (!computeDistance(pair.o1, pair.o2, distance, point1, point2, entry))
+      continue;
+
+    if (distance > minDistance || (found && distance >= minDistance))
+      continue;
+
+    found = true;
+    minDistance = distance;
+    closest = &pair;
+    nearestPoint1 = point1;
+    nearestPoint2 = point2;
+
+    if (minDistance <= option.distanceLowerBound)
+      break;
+  }
+
+  if (!found)
+    return 0.0;
+
+  const double unclampedMinDistance = static_cast<double>(minDistance);
+  const double clampedMinDistance
+      = std::max(unclampedMinDistance, option.distanceLowerBound);
+  if (result)
+  {
+    result->minDistance = clampedMinDistance;
+    result->unclampedMinDistance = unclampedMinDistance;
+    result->shapeFrame1 = closest->o1->getShapeFrame();
+    result->shapeFrame2 = closest->o2->getShapeFrame();
+    if (option.enableNearestPoints)
+    {
+      result->nearestPoint1 = nearestPoint1;
+      result->nearestPoint2 = nearestPoint2;
+    }
+  }
+  return clampedMinDistance;
+}
+
 //==============================================================================
 bool isClose(
     const Eigen::Vector3s& pos1, const Eigen::Vector3s& pos2, double tol)
@@ -367,10 +845,20 @@ void postProcess(
   if (!pairResult.isCollision())
     return;
 
+  const std::vector<Contact>* pairContacts = &pairResult.getContacts();
+  std::vector<Contact> reducedContacts;
+  if (option.maxNumContactsPerPair > 0u
+      && pairContacts->size() > option.maxNumContactsPerPair)
+  {
+    reducedContacts
+        = reduceContacts(*pairContacts, option.maxNumContactsPerPair);
+    pairContacts = &reducedContacts;
+  }
+
   // Don't add repeated points
   const auto tol = 3.0e-12;
 
-  for (auto pairContact : pairResult.getContacts())
+  for (auto pairContact : *pairContacts)
   {
     auto foundClose = false;
 
@@ -74,7 +74,10 @@ public:
       const CollisionOption& option = CollisionOption(false, 1u, nullptr),
       CollisionResult* result = nullptr) override;
 
-  // Documentation inherited
+  /// This finds the signed distance between the closest pair of objects in
+  /// the group. Spheres, capsules, boxes and meshes (as their convex hulls)
+  /// get exact distances. Pairs involving any other shape are only counted
+  /// once they touch, with minus their penetration depth.
   double distance(
       CollisionGroup* group,
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
@@ -87,6 +90,42 @@ public:
       const DistanceOption& option = DistanceOption(false, 0.0, nullptr),
       DistanceResult* result = nullptr) override;
 
+  // Documentation inherited
+  bool raycast(
+      CollisionGroup* group,
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      const RaycastOption& option = RaycastOption(),
+      RaycastResult* result = nullptr) override;
+
+  /// This casts the rays in parallel, over getNumRaycastThreads() threads.
+  /// Each ray only checks the shapes of objects whose bounding boxes it
+  /// passes through.
+  std::size_t raycastBatch(
+      CollisionGroup* group,
+      const Eigen::MatrixXs& origins,
+      const Eigen::MatrixXs& directions,
+      const RaycastOption& option,
+      RaycastBatchResult* result) override;
+
+  /// This sets the number of threads raycastBatch() splits its rays over. If
+  /// `numThreads` is <= 0, we use std::thread::hardware_concurrency(), which
+  /// is the default.
+  void setNumRaycastThreads(int numThreads);
+
+  /// Returns the number of threads raycastBatch() splits its rays over
+  int getNumRaycastThreads() const;
+
+  /// This sets the number of threads collide() splits the narrowphase over.
+  /// The contacts are always merged back together in the order of the object
+  /// pairs, so the result is the same no matter how many threads we use. If
+  /// `numThreads` is <= 0, we use std::thread::hardware_concurrency(). The
+  /// default is 1, which runs the narrowphase serially on the calling thread.
+  void setNumCollisionThreads(int numThreads);
+
+  /// Returns the number of threads collide() splits the narrowphase over
+  int getNumCollisionThreads() const;
+
 protected:
 
   /// Constructor
@@ -99,6 +138,12 @@ protected:
   // Documentation inherited
   void refreshCollisionObject(CollisionObject* object) override;
 
+  /// The number of threads raycastBatch() splits its rays over
+  int mNumRaycastThreads;
+
+  /// The number of threads collide() splits the narrowphase over
+  int mNumCollisionThreads;
+
 private:
   static Registrar<DARTCollisionDetector> mRegistrar;
 };
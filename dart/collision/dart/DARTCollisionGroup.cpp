@@ -32,7 +32,14 @@
 
 #include "dart/collision/dart/DARTCollisionGroup.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/dart/DARTContinuousCollision.hpp"
+#include "dart/collision/dart/DARTRaycast.hpp"
+#include "dart/dynamics/Shape.hpp"
 
 namespace dart {
 namespace collision {
@@ -40,11 +47,23 @@ namespace collision {
 //==============================================================================
 DARTCollisionGroup::DARTCollisionGroup(
     const CollisionDetectorPtr& collisionDetector)
-  : CollisionGroup(collisionDetector)
+  : CollisionGroup(collisionDetector), mSweepTimeStep(0.0), mSweepAxis(0)
 {
   // Do nothing
 }
 
+//==============================================================================
+ContactCache& DARTCollisionGroup::getContactCache()
+{
+  return mContactCache;
+}
+
+//==============================================================================
+const ContactCache& DARTCollisionGroup::getContactCache() const
+{
+  return mContactCache;
+}
+
 //==============================================================================
 void DARTCollisionGroup::initializeEngineData()
 {
@@ -58,6 +77,7 @@ void DARTCollisionGroup::addCollisionObjectToEngine(CollisionObject* object)
       == mCollisionObjects.end())
   {
     mCollisionObjects.push_back(object);
+    mSweepOrder.clear();
   }
 }
 
@@ -75,18 +95,207 @@ void DARTCollisionGroup::removeCollisionObjectFromEngine(
 {
   mCollisionObjects.erase(
       std::remove(mCollisionObjects.begin(), mCollisionObjects.end(), object));
+  mSweepOrder.clear();
+  mContactCache.removeObject(object);
 }
 
 //==============================================================================
 void DARTCollisionGroup::removeAllCollisionObjectsFromEngine()
 {
   mCollisionObjects.clear();
+  mSweepOrder.clear();
+  mContactCache.clear();
 }
 
 //==============================================================================
 void DARTCollisionGroup::updateCollisionGroupEngineData()
 {
-  // Do nothing
+  // The narrowphase reports touching contacts with zero penetration, so we pad
+  // the boxes a little to make sure those pairs always make it through
+  const s_t margin = 1e-3;
+  const s_t inf = std::numeric_limits<s_t>::infinity();
+
+  const std::size_t n = mCollisionObjects.size();
+  mAabbMins.resize(n);
+  mAabbMaxs.resize(n);
+  mCollisionLayers.resize(n);
+  mCollisionMasks.resize(n);
+  Eigen::Vector3s centerSum = Eigen::Vector3s::Zero();
+  Eigen::Vector3s centerSquaredSum = Eigen::Vector3s::Zero();
+  std::size_t numBounded = 0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const CollisionObject* object = mCollisionObjects[i];
+    mCollisionLayers[i] = object->getCollisionLayers();
+    mCollisionMasks[i] = object->getCollisionMask();
+
+    const math::BoundingBox& localBox = object->getShape()->getBoundingBox();
+    const Eigen::Isometry3s& T = object->getTransform();
+
+    const Eigen::Vector3s center = T * localBox.computeCenter();
+    const Eigen::Vector3s halfExtents
+        = T.linear().cwiseAbs() * localBox.computeHalfExtents()
+          + Eigen::Vector3s::Constant(margin);
+    mAabbMins[i] = center - halfExtents;
+    mAabbMaxs[i] = center + halfExtents;
+    if (mSweepTimeStep > 0)
+      sweepAabb(object, mSweepTimeStep, mAabbMins[i], mAabbMaxs[i]);
+
+    if (!mAabbMins[i].allFinite() || !mAabbMaxs[i].allFinite())
+    {
+      // Don't risk culling anything we can't bound
+      mAabbMins[i] = Eigen::Vector3s::Constant(-inf);
+      mAabbMaxs[i] = Eigen::Vector3s::Constant(inf);
+      continue;
+    }
+    centerSum += center;
+    centerSquaredSum += center.cwiseProduct(center);
+    numBounded++;
+  }
+
+  // Sweep along whichever axis the objects are most spread out along
+  int axis = mSweepAxis;
+  if (numBounded > 0)
+  {
+    const Eigen::Vector3s mean = centerSum / numBounded;
+    const Eigen::Vector3s variance
+        = centerSquaredSum / numBounded - mean.cwiseProduct(mean);
+    variance.maxCoeff(&axis);
+  }
+
+  if (mSweepOrder.size() != n || axis != mSweepAxis)
+  {
+    mSweepAxis = axis;
+    mSweepOrder.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      mSweepOrder[i] = i;
+    std::sort(
+        mSweepOrder.begin(),
+        mSweepOrder.end(),
+        [this](std::size_t a, std::size_t b) {
+          return mAabbMins[a](mSweepAxis) < mAabbMins[b](mSweepAxis);
+        });
+    return;
+  }
+
+  // Insertion sort, which is fast when we're already nearly sorted
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    const std::size_t index = mSweepOrder[i];
+    const s_t key = mAabbMins[index](mSweepAxis);
+    std::size_t j = i;
+    while (j > 0 && mAabbMins[mSweepOrder[j - 1]](mSweepAxis) > key)
+    {
+      mSweepOrder[j] = mSweepOrder[j - 1];
+      --j;
+    }
+    mSweepOrder[j] = index;
+  }
+}
+
+//==============================================================================
+void DARTCollisionGroup::getOverlappingPairs(
+    std::vector<std::pair<std::size_t, std::size_t>>& pairs) const
+{
+  pairs.clear();
+  for (std::size_t a = 0; a < mSweepOrder.size(); ++a)
+  {
+    const std::size_t i = mSweepOrder[a];
+    const s_t upperBound = mAabbMaxs[i](mSweepAxis);
+    for (std::size_t b = a + 1; b < mSweepOrder.size(); ++b)
+    {
+      const std::size_t j = mSweepOrder[b];
+      // Everything past here starts after we end along the sweep axis
+      if (mAabbMins[j](mSweepAxis) > upperBound)
+        break;
+      if ((mCollisionLayers[i] & mCollisionMasks[j]) == 0u
+          || (mCollisionLayers[j] & mCollisionMasks[i]) == 0u)
+        continue;
+      if ((mAabbMins[i].array() <= mAabbMaxs[j].array()).all()
+          && (mAabbMins[j].array() <= mAabbMaxs[i].array()).all())
+      {
+        pairs.emplace_back(std::min(i, j), std::max(i, j));
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end());
+}
+
+//==============================================================================
+bool DARTCollisionGroup::overlaps(
+    std::size_t i, const DARTCollisionGroup* otherGroup, std::size_t j) const
+{
+  if ((mCollisionLayers[i] & otherGroup->mCollisionMasks[j]) == 0u
+      || (otherGroup->mCollisionLayers[j] & mCollisionMasks[i]) == 0u)
+    return false;
+  return (mAabbMins[i].array() <= otherGroup->mAabbMaxs[j].array()).all()
+         && (otherGroup->mAabbMins[j].array() <= mAabbMaxs[i].array()).all();
+}
+
+//==============================================================================
+s_t DARTCollisionGroup::getAabbDistance(
+    std::size_t i, const DARTCollisionGroup* otherGroup, std::size_t j) const
+{
+  const Eigen::Vector3s gap
+      = (otherGroup->mAabbMins[j] - mAabbMaxs[i])
+            .cwiseMax(mAabbMins[i] - otherGroup->mAabbMaxs[j])
+            .cwiseMax(Eigen::Vector3s::Zero());
+  return gap.norm();
+}
+
+//==============================================================================
+bool DARTCollisionGroup::raycastClosest(
+    const Eigen::Vector3s& from, const Eigen::Vector3s& to, RayHit& hit) const
+{
+  bool found = false;
+  s_t best = 1;
+  Eigen::Vector3s normal;
+  for (std::size_t i = 0; i < mCollisionObjects.size(); ++i)
+  {
+    if (i < mAabbMins.size()
+        && !raycastAabb(from, to, mAabbMins[i], mAabbMaxs[i], best))
+      continue;
+
+    s_t fraction;
+    if (raycastObject(mCollisionObjects[i], from, to, best, fraction, normal))
+    {
+      found = true;
+      best = fraction;
+      hit.mCollisionObject = mCollisionObjects[i];
+      hit.mNormal = normal;
+      hit.mFraction = static_cast<double>(fraction);
+    }
+  }
+
+  if (found)
+    hit.mPoint = from + best * (to - from);
+  return found;
+}
+
+//==============================================================================
+void DARTCollisionGroup::raycastAll(
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    std::vector<RayHit>& hits) const
+{
+  Eigen::Vector3s normal;
+  for (std::size_t i = 0; i < mCollisionObjects.size(); ++i)
+  {
+    if (i < mAabbMins.size()
+        && !raycastAabb(from, to, mAabbMins[i], mAabbMaxs[i], 1))
+      continue;
+
+    s_t fraction;
+    if (raycastObject(mCollisionObjects[i], from, to, 1, fraction, normal))
+    {
+      RayHit hit;
+      hit.mCollisionObject = mCollisionObjects[i];
+      hit.mNormal = normal;
+      hit.mPoint = from + fraction * (to - from);
+      hit.mFraction = static_cast<double>(fraction);
+      hits.push_back(hit);
+    }
+  }
 }
 
 }  // namespace collision
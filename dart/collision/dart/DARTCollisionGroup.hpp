@@ -33,7 +33,15 @@
 #ifndef DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 #define DART_COLLISION_DART_DARTCOLLISIONGROUP_HPP_
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
 #include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/RaycastResult.hpp"
+#include "dart/collision/dart/ContactCache.hpp"
 
 namespace dart {
 namespace collision {
@@ -52,6 +60,14 @@ public:
   /// Destructor
   virtual ~DARTCollisionGroup() = default;
 
+  /// Returns the cache of narrowphase results we keep for pairs of objects in
+  /// this group from one collision check to the next
+  ContactCache& getContactCache();
+
+  /// Returns the cache of narrowphase results we keep for pairs of objects in
+  /// this group from one collision check to the next
+  const ContactCache& getContactCache() const;
+
 protected:
 
   // Documentation inherited
@@ -73,11 +89,84 @@ protected:
   // Documentation inherited
   void updateCollisionGroupEngineData() override;
 
+  /// This fills `pairs` with the indices (i, j), i < j, into
+  /// mCollisionObjects of every pair of objects whose world-space bounding
+  /// boxes overlap, and whose collision layers and masks allow them to
+  /// collide, as of the last updateCollisionGroupEngineData(). The pairs
+  /// are in the same order as a nested loop over i and then j would visit
+  /// them, so results don't depend on the broadphase.
+  void getOverlappingPairs(
+      std::vector<std::pair<std::size_t, std::size_t>>& pairs) const;
+
+  /// Returns true if the world-space bounding boxes of mCollisionObjects[i]
+  /// and otherGroup->mCollisionObjects[j] overlap, and their collision layers
+  /// and masks allow them to collide, as of the last
+  /// updateCollisionGroupEngineData() on both groups
+  bool overlaps(
+      std::size_t i, const DARTCollisionGroup* otherGroup, std::size_t j) const;
+
+  /// Returns how far apart the world-space bounding boxes of
+  /// mCollisionObjects[i] and otherGroup->mCollisionObjects[j] are, or 0 if
+  /// they overlap, as of the last updateCollisionGroupEngineData() on both
+  /// groups. The objects themselves are never closer than this.
+  s_t getAabbDistance(
+      std::size_t i, const DARTCollisionGroup* otherGroup, std::size_t j) const;
+
+  /// This finds the closest object the ray from `from` to `to` hits, as of
+  /// the last updateCollisionGroupEngineData(). Objects whose bounding boxes
+  /// the ray misses are skipped without checking their shapes. This doesn't
+  /// modify the group, so it's safe to call from many threads at once.
+  bool raycastClosest(
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      RayHit& hit) const;
+
+  /// This finds every object the ray from `from` to `to` hits, as of the last
+  /// updateCollisionGroupEngineData(), in the order they appear in
+  /// mCollisionObjects
+  void raycastAll(
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      std::vector<RayHit>& hits) const;
+
 protected:
 
   /// CollisionObjects added to this DARTCollisionGroup
   std::vector<CollisionObject*> mCollisionObjects;
 
+  /// The world-space bounding boxes of mCollisionObjects, in the same order,
+  /// padded by a small margin
+  std::vector<Eigen::Vector3s> mAabbMins;
+  std::vector<Eigen::Vector3s> mAabbMaxs;
+
+  /// The collision layers and masks of mCollisionObjects, in the same order,
+  /// kept next to the bounding boxes so that the broadphase can reject pairs
+  /// without following any pointers
+  std::vector<std::uint32_t> mCollisionLayers;
+  std::vector<std::uint32_t> mCollisionMasks;
+
+  /// If this is positive, the bounding boxes also cover everywhere each object
+  /// could move over this much time, so that the broadphase passes along
+  /// pairs for the continuous collision check. DARTCollisionDetector sets
+  /// this from CollisionOption::continuousCollisionTimeStep before each
+  /// update.
+  s_t mSweepTimeStep;
+
+  /// The axis we sweep along to find overlapping pairs. We pick whichever
+  /// axis the objects are most spread out along.
+  int mSweepAxis;
+
+  /// Indices into mCollisionObjects, sorted by the lower bound of their
+  /// bounding boxes along mSweepAxis. We keep this sorted across updates with
+  /// an insertion sort, which is close to linear time when things have only
+  /// moved a little since the last update. This is cleared whenever objects
+  /// are added or removed.
+  std::vector<std::size_t> mSweepOrder;
+
+  /// The warm-start state and contacts from the last collision check, for
+  /// each pair of objects we ran the narrowphase on
+  ContactCache mContactCache;
+
 };
 
 }  // namespace collision
@@ -0,0 +1,163 @@
+#include "dart/collision/dart/DARTContinuousCollision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/dart/DARTDistance.hpp"
+#include "dart/dynamics/ShapeFrame.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// The most times we'll step the objects forward before giving up on finding
+/// the time of impact
+const int maxNumAdvancements = 32;
+
+/// Once the objects are this close, we count them as touching
+const s_t touchingTolerance = 1e-4;
+
+/// Where a shape is now, and how fast it's moving
+struct SweptShape
+{
+  /// The shape at its current transform
+  ConvexCore core;
+
+  Eigen::Vector3s linearVelocity;
+
+  Eigen::Vector3s angularVelocity;
+
+  /// Returns where the shape will be after moving at its current velocity for
+  /// time t
+  Eigen::Isometry3s getTransformAt(s_t t) const
+  {
+    Eigen::Isometry3s T = core.transform;
+    T.linear() = math::expMapRot(angularVelocity * t) * core.transform.linear();
+    T.translation() += linearVelocity * t;
+    return T;
+  }
+};
+
+//==============================================================================
+bool getSweptShape(const CollisionObject* object, SweptShape& swept)
+{
+  if (!getConvexCore(object, swept.core))
+    return false;
+
+  const dynamics::ShapeFrame* frame = object->getShapeFrame();
+  swept.linearVelocity = frame->getLinearVelocity();
+  swept.angularVelocity = frame->getAngularVelocity();
+  return true;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+bool collideContinuous(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t timeStep,
+    CollisionResult& result)
+{
+  SweptShape a;
+  SweptShape b;
+  if (timeStep <= 0 || !getSweptShape(o1, a) || !getSweptShape(o2, b))
+    return false;
+
+  // No point on either shape can move along the line between them faster
+  // than the relative velocity of their frames, plus however fast spinning
+  // can move the point furthest from the origin of each frame
+  const Eigen::Vector3s relativeVelocity = a.linearVelocity - b.linearVelocity;
+  const s_t spinSpeed = a.angularVelocity.norm() * a.core.boundingRadius
+                        + b.angularVelocity.norm() * b.core.boundingRadius;
+
+  // We step copies of the cores forward, so that the originals remember
+  // where the objects are now
+  ConvexCore coreA = a.core;
+  ConvexCore coreB = b.core;
+  s_t t = 0;
+  Eigen::Vector3s pointA;
+  Eigen::Vector3s pointB;
+  Eigen::Vector3s direction = Eigen::Vector3s::Zero();
+  Eigen::Vector3s normal;
+  for (int i = 0;; i++)
+  {
+    if (i == maxNumAdvancements)
+      return false;
+
+    coreA.transform = a.getTransformAt(t);
+    coreB.transform = b.getTransformAt(t);
+    if (!computeClosestPoints(coreA, coreB, pointA, pointB, direction))
+      return false;
+
+    normal = pointA - pointB;
+    const s_t distance = normal.norm();
+    normal /= distance;
+    const s_t gap = distance - coreA.radius - coreB.radius;
+
+    // Objects that are already touching are up to the discrete check
+    if (t == 0 && gap <= 0)
+      return false;
+
+    const s_t closingSpeed = spinSpeed - relativeVelocity.dot(normal);
+    if (closingSpeed <= 0)
+      return false;
+
+    if (gap <= touchingTolerance)
+      break;
+
+    // This is the soonest the objects could possibly touch
+    t += gap / closingSpeed;
+    if (t > timeStep)
+      return false;
+  }
+
+  // Move the points where the surfaces first touch back to where the objects
+  // are now
+  const Eigen::Vector3s surfaceA
+      = a.core.transform
+        * (coreA.transform.inverse() * (pointA - normal * coreA.radius));
+  const Eigen::Vector3s surfaceB
+      = b.core.transform
+        * (coreB.transform.inverse() * (pointB + normal * coreB.radius));
+
+  Contact contact;
+  contact.collisionObject1 = o1;
+  contact.collisionObject2 = o2;
+  contact.point = (surfaceA + surfaceB) / 2;
+  contact.normal = normal;
+  contact.penetrationDepth
+      = -std::max(static_cast<s_t>(0), normal.dot(surfaceA - surfaceB));
+  result.addContact(contact);
+  return true;
+}
+
+//==============================================================================
+void sweepAabb(
+    const CollisionObject* object,
+    s_t timeStep,
+    Eigen::Vector3s& lower,
+    Eigen::Vector3s& upper)
+{
+  const dynamics::ShapeFrame* frame = object->getShapeFrame();
+  const math::BoundingBox& localBox = object->getShape()->getBoundingBox();
+
+  // Spinning by an angle moves each point of the shape by at most that angle
+  // times its distance from the origin of the frame
+  const s_t boundingRadius = localBox.getMin()
+                                 .cwiseAbs()
+                                 .cwiseMax(localBox.getMax().cwiseAbs())
+                                 .norm();
+  const s_t spin
+      = frame->getAngularVelocity().norm() * timeStep * boundingRadius;
+  const Eigen::Vector3s shift = frame->getLinearVelocity() * timeStep;
+
+  lower = lower.cwiseMin(lower + shift) - Eigen::Vector3s::Constant(spin);
+  upper = upper.cwiseMax(upper + shift) + Eigen::Vector3s::Constant(spin);
+}
+
+} // namespace collision
+} // namespace dart
@@ -0,0 +1,49 @@
+#ifndef DART_COLLISION_DART_DARTCONTINUOUSCOLLISION_HPP_
+#define DART_COLLISION_DART_DARTCONTINUOUSCOLLISION_HPP_
+
+#include <Eigen/Dense>
+
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace collision {
+
+class CollisionObject;
+
+/// This checks whether two objects that aren't touching now will run into
+/// each other within the next `timeStep`, if they keep moving at the current
+/// velocities of their frames. That's what catches thin or fast objects that
+/// would otherwise pass right through each other between two steps.
+///
+/// We find the time of impact by conservative advancement: we step both
+/// objects forward by the distance between them, divided by a bound on how
+/// fast they can close that distance, until they touch or we run out of time.
+/// Only spheres, capsules, boxes and meshes (as their convex hulls) are
+/// supported. Every other pair returns false.
+///
+/// If the objects would collide, this adds a single contact to `result`,
+/// placed where they first touch but moved back to where the objects are now.
+/// The normal pushes o1 away from o2, as usual, and the penetration depth is
+/// minus the gap between the objects along the normal. That's enough for the
+/// constraint solver to stop the objects from closing the gap this step,
+/// without pulling them together.
+bool collideContinuous(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t timeStep,
+    CollisionResult& result);
+
+/// This grows the world bounding box [lower, upper] of `object` to cover
+/// everywhere the object could be over the next `timeStep`, moving at the
+/// current velocity of its frame
+void sweepAabb(
+    const CollisionObject* object,
+    s_t timeStep,
+    Eigen::Vector3s& lower,
+    Eigen::Vector3s& upper);
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_DARTCONTINUOUSCOLLISION_HPP_
@@ -0,0 +1,407 @@
+#include "dart/collision/dart/DARTDistance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/ConvexHull.hpp"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+/// The most support points GJK will add before settling for the closest
+/// points it's found so far
+const int maxNumGjkIterations = 64;
+
+/// If GJK gets this close to the origin, we count the shapes as overlapping
+const s_t overlapTolerance = 1e-6;
+
+/// A vertex of the GJK simplex, on the Minkowski difference of the two
+/// shapes, along with the points on each shape that it came from
+struct SimplexVertex
+{
+  Eigen::Vector3s w;
+  Eigen::Vector3s a;
+  Eigen::Vector3s b;
+};
+
+//==============================================================================
+/// Returns the closest point to the origin on the triangle (a, b, c), from
+/// Ericson's "Real-Time Collision Detection", section 5.1.5, along with its
+/// barycentric weights
+Eigen::Vector3s closestPointOnTriangle(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& b,
+    const Eigen::Vector3s& c,
+    Eigen::Vector3s& weights)
+{
+  const Eigen::Vector3s ab = b - a;
+  const Eigen::Vector3s ac = c - a;
+
+  const s_t d1 = -ab.dot(a);
+  const s_t d2 = -ac.dot(a);
+  if (d1 <= 0 && d2 <= 0)
+  {
+    weights << 1, 0, 0;
+    return a;
+  }
+
+  const s_t d3 = -ab.dot(b);
+  const s_t d4 = -ac.dot(b);
+  if (d3 >= 0 && d4 <= d3)
+  {
+    weights << 0, 1, 0;
+    return b;
+  }
+
+  const s_t vc = d1 * d4 - d3 * d2;
+  if (vc <= 0 && d1 >= 0 && d3 <= 0)
+  {
+    const s_t v = d1 / (d1 - d3);
+    weights << 1 - v, v, 0;
+    return a + v * ab;
+  }
+
+  const s_t d5 = -ab.dot(c);
+  const s_t d6 = -ac.dot(c);
+  if (d6 >= 0 && d5 <= d6)
+  {
+    weights << 0, 0, 1;
+    return c;
+  }
+
+  const s_t vb = d5 * d2 - d1 * d6;
+  if (vb <= 0 && d2 >= 0 && d6 <= 0)
+  {
+    const s_t w = d2 / (d2 - d6);
+    weights << 1 - w, 0, w;
+    return a + w * ac;
+  }
+
+  const s_t va = d3 * d6 - d5 * d4;
+  if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+  {
+    const s_t w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    weights << 0, 1 - w, w;
+    return b + w * (c - b);
+  }
+
+  const s_t denom = 1.0 / (va + vb + vc);
+  const s_t v = vb * denom;
+  const s_t w = vc * denom;
+  weights << 1 - v - w, v, w;
+  return a + v * ab + w * ac;
+}
+
+//==============================================================================
+/// This replaces the simplex with the smallest part of it that holds its
+/// closest point to the origin, and returns that point in `v`, along with the
+/// points on each shape it came from. This returns false if the simplex
+/// encloses the origin, which means the shapes overlap.
+bool reduceSimplex(
+    SimplexVertex* simplex,
+    int& n,
+    Eigen::Vector3s& v,
+    Eigen::Vector3s& pointA,
+    Eigen::Vector3s& pointB)
+{
+  Eigen::Vector4s weights = Eigen::Vector4s::Zero();
+  if (n == 1)
+  {
+    weights(0) = 1;
+  }
+  else if (n == 2)
+  {
+    const Eigen::Vector3s ab = simplex[1].w - simplex[0].w;
+    const s_t lengthSquared = ab.squaredNorm();
+    s_t t = 0;
+    if (lengthSquared > 0)
+      t = std::min(
+          static_cast<s_t>(1),
+          std::max(static_cast<s_t>(0), -simplex[0].w.dot(ab) / lengthSquared));
+    weights(0) = 1 - t;
+    weights(1) = t;
+  }
+  else if (n == 3)
+  {
+    Eigen::Vector3s triangleWeights;
+    closestPointOnTriangle(
+        simplex[0].w, simplex[1].w, simplex[2].w, triangleWeights);
+    weights.head<3>() = triangleWeights;
+  }
+  else
+  {
+    // The closest point is on whichever face the origin is outside of that's
+    // closest. If the origin isn't outside any of them, it's inside.
+    static const int faces[4][4]
+        = {{0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+    bool outside = false;
+    s_t bestDistance = 0;
+    for (const auto& face : faces)
+    {
+      const Eigen::Vector3s& a = simplex[face[0]].w;
+      const Eigen::Vector3s& b = simplex[face[1]].w;
+      const Eigen::Vector3s& c = simplex[face[2]].w;
+      const Eigen::Vector3s& opposite = simplex[face[3]].w;
+      const Eigen::Vector3s normal = (b - a).cross(c - a);
+      if (normal.dot(-a) * normal.dot(opposite - a) > 0)
+        continue;
+
+      Eigen::Vector3s triangleWeights;
+      const s_t distance
+          = closestPointOnTriangle(a, b, c, triangleWeights).squaredNorm();
+      if (!outside || distance < bestDistance)
+      {
+        outside = true;
+        bestDistance = distance;
+        weights.setZero();
+        for (int i = 0; i < 3; i++)
+          weights(face[i]) = triangleWeights(i);
+      }
+    }
+    if (!outside)
+      return false;
+  }
+
+  v.setZero();
+  pointA.setZero();
+  pointB.setZero();
+  int numKept = 0;
+  for (int i = 0; i < n; i++)
+  {
+    if (weights(i) <= 0)
+      continue;
+    v += weights(i) * simplex[i].w;
+    pointA += weights(i) * simplex[i].a;
+    pointB += weights(i) * simplex[i].b;
+    simplex[numKept++] = simplex[i];
+  }
+  n = numKept;
+  return true;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+Eigen::Vector3s ConvexCore::getSupportPoint(const Eigen::Vector3s& dir) const
+{
+  const Eigen::Vector3s localDir = transform.linear().transpose() * dir;
+  if (hull != nullptr)
+  {
+    // Scaling the hull scales every vertex's dot product with the direction
+    // the same way as scaling the direction does
+    supportHint
+        = hull->getSupportIndex(scale.cwiseProduct(localDir), supportHint);
+    return transform * scale.cwiseProduct(hull->getVertices()[supportHint]);
+  }
+
+  Eigen::Vector3s corner;
+  for (int i = 0; i < 3; i++)
+    corner(i) = localDir(i) >= 0 ? halfExtents(i) : -halfExtents(i);
+  return transform * corner;
+}
+
+//==============================================================================
+bool getConvexCore(const CollisionObject* object, ConvexCore& core)
+{
+  const dynamics::Shape* shape = object->getShape().get();
+  if (shape == nullptr)
+    return false;
+
+  core.halfExtents.setZero();
+  core.hull = nullptr;
+  core.scale.setOnes();
+  core.radius = 0;
+  core.supportHint = -1;
+  if (shape->is<dynamics::SphereShape>())
+  {
+    const auto* sphere = static_cast<const dynamics::SphereShape*>(shape);
+    core.radius = sphere->getRadius();
+  }
+  else if (shape->is<dynamics::EllipsoidShape>())
+  {
+    const auto* ellipsoid = static_cast<const dynamics::EllipsoidShape*>(shape);
+    if (!ellipsoid->isSphere())
+      return false;
+    core.radius = ellipsoid->getRadii()(0);
+  }
+  else if (shape->is<dynamics::CapsuleShape>())
+  {
+    const auto* capsule = static_cast<const dynamics::CapsuleShape*>(shape);
+    core.halfExtents(2) = capsule->getHeight() / 2;
+    core.radius = capsule->getRadius();
+  }
+  else if (shape->is<dynamics::BoxShape>())
+  {
+    const auto* box = static_cast<const dynamics::BoxShape*>(shape);
+    core.halfExtents = box->getSize() / 2;
+  }
+  else if (shape->is<dynamics::MeshShape>())
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape);
+    if (mesh->getMesh() == nullptr)
+      return false;
+    core.hull = mesh->getConvexHull().get();
+    if (core.hull == nullptr || core.hull->getVertices().empty())
+      return false;
+    core.scale = mesh->getScale();
+  }
+  else
+  {
+    return false;
+  }
+
+  const math::BoundingBox& localBox = shape->getBoundingBox();
+  core.boundingRadius = localBox.getMin()
+                            .cwiseAbs()
+                            .cwiseMax(localBox.getMax().cwiseAbs())
+                            .norm();
+  core.transform = object->getTransform();
+  return true;
+}
+
+//==============================================================================
+bool computeClosestPoints(
+    const ConvexCore& a,
+    const ConvexCore& b,
+    Eigen::Vector3s& pointA,
+    Eigen::Vector3s& pointB,
+    Eigen::Vector3s& direction)
+{
+  auto getSupport = [&](const Eigen::Vector3s& dir) {
+    SimplexVertex vertex;
+    vertex.a = a.getSupportPoint(dir);
+    vertex.b = b.getSupportPoint(-dir);
+    vertex.w = vertex.a - vertex.b;
+    return vertex;
+  };
+
+  Eigen::Vector3s v = direction;
+  if (v.squaredNorm() == 0)
+    v = a.transform.translation() - b.transform.translation();
+  if (v.squaredNorm() == 0)
+    v = Eigen::Vector3s::UnitX();
+
+  SimplexVertex simplex[4];
+  simplex[0] = getSupport(-v);
+  int n = 1;
+  v = simplex[0].w;
+  pointA = simplex[0].a;
+  pointB = simplex[0].b;
+
+  bool separated = true;
+  for (int iter = 0; iter < maxNumGjkIterations; iter++)
+  {
+    const s_t distanceSquared = v.squaredNorm();
+    if (distanceSquared < overlapTolerance * overlapTolerance)
+    {
+      separated = false;
+      break;
+    }
+
+    // Stop once the next support point can't get us meaningfully closer
+    const SimplexVertex next = getSupport(-v);
+    if (distanceSquared - v.dot(next.w) <= 1e-10 * distanceSquared)
+      break;
+
+    simplex[n++] = next;
+    if (!reduceSimplex(simplex, n, v, pointA, pointB))
+    {
+      separated = false;
+      break;
+    }
+  }
+
+  direction = v;
+  return separated;
+}
+
+//==============================================================================
+bool computeDistance(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2,
+    ContactCache::PairEntry* entry)
+{
+  ConvexCore a;
+  ConvexCore b;
+  const bool supported = getConvexCore(o1, a) && getConvexCore(o2, b);
+  Eigen::Vector3s pointA = o1->getTransform().translation();
+  Eigen::Vector3s pointB = o2->getTransform().translation();
+  if (supported)
+  {
+    Eigen::Vector3s direction = Eigen::Vector3s::Zero();
+    if (entry)
+    {
+      direction = entry->distanceDirection;
+      a.supportHint = entry->distanceSupportHint1;
+      b.supportHint = entry->distanceSupportHint2;
+    }
+
+    const bool separated
+        = computeClosestPoints(a, b, pointA, pointB, direction);
+
+    if (entry)
+    {
+      entry->distanceDirection = direction;
+      entry->distanceSupportHint1 = a.supportHint;
+      entry->distanceSupportHint2 = b.supportHint;
+    }
+
+    if (separated)
+    {
+      Eigen::Vector3s normal = pointA - pointB;
+      const s_t coreDistance = normal.norm();
+      normal /= coreDistance;
+      distance = coreDistance - a.radius - b.radius;
+      if (distance >= 0)
+      {
+        point1 = pointA - normal * a.radius;
+        point2 = pointB + normal * b.radius;
+        return true;
+      }
+    }
+  }
+
+  // The objects overlap, so we fall back on the collision routines for the
+  // penetration depth, without clipping it
+  CollisionOption option(
+      true, 1000u, nullptr, std::numeric_limits<s_t>::infinity());
+  CollisionResult result;
+  collide(o1, o2, option, result);
+  if (!result.isCollision())
+  {
+    // The objects are just barely touching
+    distance = 0;
+    point1 = pointA;
+    point2 = pointB;
+    return supported;
+  }
+
+  const Contact* deepest = &result.getContact(0);
+  for (const Contact& contact : result.getContacts())
+  {
+    if (contact.penetrationDepth > deepest->penetrationDepth)
+      deepest = &contact;
+  }
+  distance = -deepest->penetrationDepth;
+  point1 = deepest->point - deepest->normal * deepest->penetrationDepth / 2;
+  point2 = deepest->point + deepest->normal * deepest->penetrationDepth / 2;
+  return true;
+}
+
+} // namespace collision
+} // namespace dart
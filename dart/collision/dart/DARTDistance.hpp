@@ -0,0 +1,92 @@
+#ifndef DART_COLLISION_DART_DARTDISTANCE_HPP_
+#define DART_COLLISION_DART_DARTDISTANCE_HPP_
+
+#include <Eigen/Dense>
+
+#include "dart/collision/dart/ContactCache.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace math {
+class ConvexHull;
+} // namespace math
+
+namespace collision {
+
+class CollisionObject;
+
+/// Every shape we can run GJK on is everything within `radius` of a convex
+/// core. The core is either a box with `halfExtents`, centered on the origin
+/// of the shape's frame, or the convex hull of a mesh. Spheres have a box of
+/// zero size, and capsules have a box that only extends along Z.
+struct ConvexCore
+{
+  /// Where the shape is in the world
+  Eigen::Isometry3s transform;
+
+  Eigen::Vector3s halfExtents;
+
+  /// The hull of the mesh, or nullptr if the core is a box. The MeshShape
+  /// keeps this alive.
+  const math::ConvexHull* hull;
+
+  /// The scale of the mesh, which the hull doesn't include
+  Eigen::Vector3s scale;
+
+  s_t radius;
+
+  /// How far any point on the shape is from the origin of its frame
+  s_t boundingRadius;
+
+  /// The hull vertex that was furthest along the last direction we asked
+  /// for, which is where we start walking the hull for the next one
+  mutable int supportHint;
+
+  /// Returns the point on the core (not counting `radius`) that's furthest
+  /// along the world direction `dir`
+  Eigen::Vector3s getSupportPoint(const Eigen::Vector3s& dir) const;
+};
+
+/// This fills in `core` for the shape of `object`, at its current transform.
+/// Only spheres, capsules, boxes and meshes are supported. This returns false
+/// for every other shape.
+bool getConvexCore(const CollisionObject* object, ConvexCore& core);
+
+/// This finds the closest points between the cores of `a` and `b` (not
+/// counting their radii) with GJK, and returns false if the cores overlap.
+///
+/// `direction` is where we start searching from. Passing in the direction
+/// this left behind for the same pair on an earlier query (or the zero
+/// vector, if there isn't one) warm-starts the search, which usually only
+/// takes one or two iterations when the shapes haven't moved much.
+bool computeClosestPoints(
+    const ConvexCore& a,
+    const ConvexCore& b,
+    Eigen::Vector3s& pointA,
+    Eigen::Vector3s& pointB,
+    Eigen::Vector3s& direction);
+
+/// This finds the signed distance between o1 and o2, and the points on each
+/// of them that are closest to each other, in world coordinates. If the
+/// objects overlap, the distance is minus the deepest penetration our
+/// collision routines find between them, and the points are the deepest
+/// points of each object inside the other.
+///
+/// If `entry` isn't nullptr, we warm-start GJK from the closest features we
+/// found for this pair the last time, and record the ones we find now.
+///
+/// This returns false if we don't support the shapes, and they aren't
+/// overlapping.
+bool computeDistance(
+    CollisionObject* o1,
+    CollisionObject* o2,
+    s_t& distance,
+    Eigen::Vector3s& point1,
+    Eigen::Vector3s& point2,
+    ContactCache::PairEntry* entry = nullptr);
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_DARTDISTANCE_HPP_
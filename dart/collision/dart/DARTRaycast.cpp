@@ -0,0 +1,357 @@
+#include "dart/collision/dart/DARTRaycast.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/EllipsoidShape.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/PointCloudShape.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+
+namespace dart {
+namespace collision {
+
+namespace {
+
+// Each of these casts the ray a + t * d, t in [0, maxT], against a shape
+// sitting at the origin of the local frame, and returns the smallest t at
+// which the ray enters the shape, along with the local normal there.
+
+//==============================================================================
+bool raycastLocalSphere(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& d,
+    s_t radius,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  const s_t A = d.dot(d);
+  const s_t B = 2 * a.dot(d);
+  const s_t C = a.dot(a) - radius * radius;
+  // Rays that start inside don't hit
+  if (C <= 0 || A <= 0)
+    return false;
+  const s_t discriminant = B * B - 4 * A * C;
+  if (discriminant < 0)
+    return false;
+  const s_t hit = (-B - std::sqrt(discriminant)) / (2 * A);
+  if (hit < 0 || hit > maxT)
+    return false;
+  t = hit;
+  normal = (a + t * d) / radius;
+  return true;
+}
+
+//==============================================================================
+bool raycastLocalEllipsoid(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& d,
+    const Eigen::Vector3s& radii,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  // Squash everything so the ellipsoid is a unit sphere. That doesn't change
+  // where along the ray the hit is.
+  Eigen::Vector3s unitNormal;
+  if (!raycastLocalSphere(
+          a.cwiseQuotient(radii),
+          d.cwiseQuotient(radii),
+          1,
+          maxT,
+          t,
+          unitNormal))
+    return false;
+  const Eigen::Vector3s point = a + t * d;
+  normal = point.cwiseQuotient(radii.cwiseProduct(radii)).normalized();
+  return true;
+}
+
+//==============================================================================
+bool raycastLocalBox(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& d,
+    const Eigen::Vector3s& halfSize,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  if ((a.cwiseAbs() - halfSize).maxCoeff() <= 0)
+    return false;
+
+  s_t enter = -std::numeric_limits<s_t>::infinity();
+  s_t exit = std::numeric_limits<s_t>::infinity();
+  int enterAxis = -1;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (d(axis) == 0)
+    {
+      if (std::abs(a(axis)) > halfSize(axis))
+        return false;
+      continue;
+    }
+    s_t t1 = (-halfSize(axis) - a(axis)) / d(axis);
+    s_t t2 = (halfSize(axis) - a(axis)) / d(axis);
+    if (t1 > t2)
+      std::swap(t1, t2);
+    if (t1 > enter)
+    {
+      enter = t1;
+      enterAxis = axis;
+    }
+    exit = std::min(exit, t2);
+  }
+  if (enterAxis == -1 || enter > exit || enter < 0 || enter > maxT)
+    return false;
+
+  t = enter;
+  normal.setZero();
+  normal(enterAxis) = d(enterAxis) > 0 ? -1 : 1;
+  return true;
+}
+
+//==============================================================================
+bool raycastLocalCapsule(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& d,
+    s_t radius,
+    s_t height,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  const s_t halfHeight = height / 2;
+
+  // Rays that start inside don't hit
+  Eigen::Vector3s closestOnAxis(
+      0, 0, std::max(-halfHeight, std::min(halfHeight, a(2))));
+  if ((a - closestOnAxis).norm() <= radius)
+    return false;
+
+  bool found = false;
+  s_t best = maxT;
+
+  // The side of the cylinder
+  const s_t A = d(0) * d(0) + d(1) * d(1);
+  if (A > 0)
+  {
+    const s_t B = 2 * (a(0) * d(0) + a(1) * d(1));
+    const s_t C = a(0) * a(0) + a(1) * a(1) - radius * radius;
+    const s_t discriminant = B * B - 4 * A * C;
+    if (discriminant >= 0)
+    {
+      const s_t hit = (-B - std::sqrt(discriminant)) / (2 * A);
+      const s_t z = a(2) + hit * d(2);
+      if (hit >= 0 && hit <= best && std::abs(z) <= halfHeight)
+      {
+        found = true;
+        best = hit;
+        normal
+            = Eigen::Vector3s(a(0) + hit * d(0), a(1) + hit * d(1), 0) / radius;
+      }
+    }
+  }
+
+  // The two end caps, which only count on their outer halves
+  for (s_t side : {1.0, -1.0})
+  {
+    const Eigen::Vector3s center(0, 0, side * halfHeight);
+    s_t hit;
+    Eigen::Vector3s capNormal;
+    if (raycastLocalSphere(a - center, d, radius, best, hit, capNormal)
+        && side * capNormal(2) >= 0)
+    {
+      found = true;
+      best = hit;
+      normal = capNormal;
+    }
+  }
+
+  if (found)
+    t = best;
+  return found;
+}
+
+//==============================================================================
+bool raycastLocalMesh(
+    const Eigen::Vector3s& a,
+    const Eigen::Vector3s& d,
+    const aiScene* scene,
+    const Eigen::Vector3s& scale,
+    s_t maxT,
+    s_t& t,
+    Eigen::Vector3s& normal)
+{
+  if (scene == nullptr)
+    return false;
+
+  bool found = false;
+  s_t best = maxT;
+  for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+  {
+    const aiMesh* mesh = scene->mMeshes[i];
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++)
+    {
+      const aiFace& face = mesh->mFaces[f];
+      if (face.mNumIndices != 3)
+        continue;
+      const aiVector3D& p0 = mesh->mVertices[face.mIndices[0]];
+      const aiVector3D& p1 = mesh->mVertices[face.mIndices[1]];
+      const aiVector3D& p2 = mesh->mVertices[face.mIndices[2]];
+      const Eigen::Vector3s v0
+          = scale.cwiseProduct(Eigen::Vector3s(p0.x, p0.y, p0.z));
+      const Eigen::Vector3s v1
+          = scale.cwiseProduct(Eigen::Vector3s(p1.x, p1.y, p1.z));
+      const Eigen::Vector3s v2
+          = scale.cwiseProduct(Eigen::Vector3s(p2.x, p2.y, p2.z));
+
+      // Moller-Trumbore
+      const Eigen::Vector3s e1 = v1 - v0;
+      const Eigen::Vector3s e2 = v2 - v0;
+      const Eigen::Vector3s p = d.cross(e2);
+      const s_t det = e1.dot(p);
+      if (det == 0)
+        continue;
+      const s_t invDet = 1.0 / det;
+      const Eigen::Vector3s s = a - v0;
+      const s_t u = s.dot(p) * invDet;
+      if (u < 0 || u > 1)
+        continue;
+      const Eigen::Vector3s q = s.cross(e1);
+      const s_t v = d.dot(q) * invDet;
+      if (v < 0 || u + v > 1)
+        continue;
+      const s_t hit = e2.dot(q) * invDet;
+      if (hit < 0 || hit > best)
+        continue;
+
+      found = true;
+      best = hit;
+      normal = e1.cross(e2).normalized();
+      if (normal.dot(d) > 0)
+        normal = -normal;
+    }
+  }
+
+  if (found)
+    t = best;
+  return found;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+bool raycastObject(
+    const CollisionObject* object,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    s_t maxFraction,
+    s_t& fraction,
+    Eigen::Vector3s& normal)
+{
+  const dynamics::Shape* shape = object->getShape().get();
+  if (shape == nullptr)
+    return false;
+
+  // Rigid transforms don't change how far along the ray a hit is, so we can
+  // do everything in the frame of the shape
+  const Eigen::Isometry3s& T = object->getTransform();
+  const Eigen::Vector3s a = T.inverse() * from;
+  const Eigen::Vector3s d = T.linear().transpose() * (to - from);
+
+  bool hit = false;
+  Eigen::Vector3s localNormal;
+  if (shape->is<dynamics::SphereShape>())
+  {
+    const auto* sphere = static_cast<const dynamics::SphereShape*>(shape);
+    hit = raycastLocalSphere(
+        a, d, sphere->getRadius(), maxFraction, fraction, localNormal);
+  }
+  else if (shape->is<dynamics::BoxShape>())
+  {
+    const auto* box = static_cast<const dynamics::BoxShape*>(shape);
+    hit = raycastLocalBox(
+        a, d, box->getSize() / 2, maxFraction, fraction, localNormal);
+  }
+  else if (shape->is<dynamics::EllipsoidShape>())
+  {
+    const auto* ellipsoid = static_cast<const dynamics::EllipsoidShape*>(shape);
+    hit = raycastLocalEllipsoid(
+        a, d, ellipsoid->getRadii(), maxFraction, fraction, localNormal);
+  }
+  else if (shape->is<dynamics::CapsuleShape>())
+  {
+    const auto* capsule = static_cast<const dynamics::CapsuleShape*>(shape);
+    hit = raycastLocalCapsule(
+        a,
+        d,
+        capsule->getRadius(),
+        capsule->getHeight(),
+        maxFraction,
+        fraction,
+        localNormal);
+  }
+  else if (shape->is<dynamics::MeshShape>())
+  {
+    const auto* mesh = static_cast<const dynamics::MeshShape*>(shape);
+    hit = raycastLocalMesh(
+        a,
+        d,
+        mesh->getMesh(),
+        mesh->getScale(),
+        maxFraction,
+        fraction,
+        localNormal);
+  }
+  else if (shape->is<dynamics::PointCloudShape>())
+  {
+    // The cloud walks its own voxel index, so this doesn't have to test
+    // every point
+    const auto* cloud = static_cast<const dynamics::PointCloudShape*>(shape);
+    std::size_t point;
+    hit = cloud->raycast(a, a + d, maxFraction, fraction, localNormal, point);
+  }
+
+  if (hit)
+    normal = T.linear() * localNormal;
+  return hit;
+}
+
+//==============================================================================
+bool raycastAabb(
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    const Eigen::Vector3s& lower,
+    const Eigen::Vector3s& upper,
+    s_t maxFraction)
+{
+  const Eigen::Vector3s d = to - from;
+  s_t enter = 0;
+  s_t exit = maxFraction;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (d(axis) == 0)
+    {
+      if (from(axis) < lower(axis) || from(axis) > upper(axis))
+        return false;
+      continue;
+    }
+    s_t t1 = (lower(axis) - from(axis)) / d(axis);
+    s_t t2 = (upper(axis) - from(axis)) / d(axis);
+    if (t1 > t2)
+      std::swap(t1, t2);
+    enter = std::max(enter, t1);
+    exit = std::min(exit, t2);
+    if (enter > exit)
+      return false;
+  }
+  return true;
+}
+
+} // namespace collision
+} // namespace dart
@@ -0,0 +1,43 @@
+#ifndef DART_COLLISION_DART_DARTRAYCAST_HPP_
+#define DART_COLLISION_DART_DARTRAYCAST_HPP_
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace collision {
+
+class CollisionObject;
+
+/// This casts the ray from `from` to `to` (in world coordinates) against a
+/// single object. If the ray hits the object before `maxFraction` of the way
+/// along, this returns true and fills in `fraction` (how far along the ray the
+/// hit is, from 0 to 1) and the world `normal` at the hit.
+///
+/// Rays only hit convex shapes from the outside, so a ray that starts inside
+/// a box, sphere, ellipsoid or capsule doesn't hit it. Meshes are hit on
+/// either side of each triangle, and the normal always faces back along the
+/// ray. Point clouds are hit on the balls around their points.
+bool raycastObject(
+    const CollisionObject* object,
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    s_t maxFraction,
+    s_t& fraction,
+    Eigen::Vector3s& normal);
+
+/// Returns true if the ray from `from` to `to` passes through the axis
+/// aligned box between `lower` and `upper` before `maxFraction` of the way
+/// along. Rays that start inside the box count as passing through it.
+bool raycastAabb(
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    const Eigen::Vector3s& lower,
+    const Eigen::Vector3s& upper,
+    s_t maxFraction);
+
+} // namespace collision
+} // namespace dart
+
+#endif // DART_COLLISION_DART_DARTRAYCAST_HPP_
@@ -34,6 +34,8 @@
 
 #include <cassert>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 #include "dart/common/Console.hpp"
 
@@ -287,22 +289,46 @@ void Composite::removeFromComposite(Aspect* aspect)
 //==============================================================================
 void Composite::_set(std::type_index type_idx, const Aspect* aspect)
 {
+  std::unique_ptr<Aspect>& entry = mAspectMap[type_idx];
+  registerAspectSlot(getAspectSlotIndex(type_idx), entry);
   if (aspect)
   {
-    mAspectMap[type_idx] = aspect->cloneAspect();
-    addToComposite(mAspectMap[type_idx].get());
+    entry = aspect->cloneAspect();
+    addToComposite(entry.get());
   }
   else
   {
-    mAspectMap[type_idx] = nullptr;
+    entry = nullptr;
   }
 }
 
 //==============================================================================
 void Composite::_set(std::type_index type_idx, std::unique_ptr<Aspect> aspect)
 {
-  mAspectMap[type_idx] = std::move(aspect);
-  addToComposite(mAspectMap[type_idx].get());
+  std::unique_ptr<Aspect>& entry = mAspectMap[type_idx];
+  registerAspectSlot(getAspectSlotIndex(type_idx), entry);
+  entry = std::move(aspect);
+  addToComposite(entry.get());
+}
+
+//==============================================================================
+std::size_t Composite::getAspectSlotIndex(const std::type_index& type)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::type_index, std::size_t> indices;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return indices.emplace(type, indices.size()).first->second;
+}
+
+//==============================================================================
+void Composite::registerAspectSlot(
+    std::size_t index, std::unique_ptr<Aspect>& entry)
+{
+  if (index >= mAspectSlots.size())
+    mAspectSlots.resize(index + 1, nullptr);
+
+  mAspectSlots[index] = &entry;
 }
 
 } // namespace common
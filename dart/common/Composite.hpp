@@ -33,6 +33,8 @@
 #ifndef DART_COMMON_COMPOSITE_HPP_
 #define DART_COMMON_COMPOSITE_HPP_
 
+#include <vector>
+
 #include "dart/common/detail/CompositeData.hpp"
 
 namespace dart {
@@ -42,12 +44,12 @@ namespace common {
 /// that wants to be able to manage Aspects.
 ///
 /// The base Composite class is completely agnostic to what kind of Aspects it
-/// is given. Aspects are stored in a std::map, so access to its Aspects happens
-/// on average in log(N) time. Most often, a class that accepts Aspects will have
-/// certain Aspect types that it will need to access frequently, and it would be
-/// beneficial to have constant-time access to those Aspect types. To get
-/// constant-time access to specific Aspect types, you can use the templated
-/// class SpecializedForAspect.
+/// is given. Aspects are stored in a std::map, but every Aspect type is also
+/// given a dense index the first time any Composite sees it, and each
+/// Composite keeps a flat array from those indices to its map entries. That
+/// makes has() and get() an array lookup rather than a walk down the map.
+/// Specific Aspect types can still get direct access, without even the index
+/// lookup, with the templated class SpecializedForAspect.
 class Composite
 {
 public:
@@ -178,9 +180,27 @@ protected:
   /// Non-templated version of set(std::unqiue_ptr<T>&&)
   void _set(std::type_index type_idx, std::unique_ptr<Aspect> aspect);
 
+  /// Returns the dense index of the Aspect type T, for mAspectSlots
+  template <class T>
+  static std::size_t getAspectSlotIndex();
+
+  /// Returns the dense index of the Aspect type `type`, for mAspectSlots,
+  /// handing out the next free one if this type has never had one before
+  static std::size_t getAspectSlotIndex(const std::type_index& type);
+
+  /// Point the slot `index` of mAspectSlots at `entry`, which must be the
+  /// entry of mAspectMap for the Aspect type with that index. Entries never
+  /// leave mAspectMap (removing an Aspect just empties its entry), so the
+  /// slot stays valid for the life of the Composite.
+  void registerAspectSlot(std::size_t index, std::unique_ptr<Aspect>& entry);
+
   /// A map that relates the type of Aspect to its pointer
   AspectMap mAspectMap;
 
+  /// For each Aspect type index, the entry of mAspectMap for that type, or
+  /// nullptr if mAspectMap doesn't have one
+  std::vector<std::unique_ptr<Aspect>*> mAspectSlots;
+
   /// A set containing type information for Aspects which are not allowed to
   /// leave this composite.
   RequiredAspectSet mRequiredAspects;
@@ -35,6 +35,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 
 namespace dart {
 namespace common {
@@ -147,6 +148,9 @@ public:
   const std::string& getManagerName() const;
 
 protected:
+  /// Combine a base name and a duplication number according to the pattern
+  std::string composeName(const std::string& _name, std::size_t _number) const;
+
   /// Name of this NameManager. This is used to report errors.
   std::string mManagerName;
 
@@ -172,6 +176,13 @@ protected:
 
   /// The chunk of text that gets appended to a duplicate name
   std::string mAffix;
+
+  /// For each base name that issueNewName() has had to resolve, the lowest
+  /// duplication number that might still be free. Every number below it is
+  /// known to be taken, so issuing a name doesn't have to probe them all
+  /// again. Adding names can't invalidate this, so we only clear it when a
+  /// name gets removed or the pattern changes.
+  mutable std::unordered_map<std::string, std::size_t> mNextNumbers;
 };
 
 } // namespace common
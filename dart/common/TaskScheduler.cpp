@@ -0,0 +1,269 @@
+#include "dart/common/TaskScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace dart {
+namespace common {
+
+namespace {
+
+// Which pool (if any) the current thread is a worker of, and which worker it
+// is, so that pushes and pops from inside a task go to that worker's queue
+thread_local TaskScheduler* tCurrentScheduler = nullptr;
+thread_local int tCurrentWorker = -1;
+
+} // namespace
+
+//==============================================================================
+TaskScheduler::TaskScheduler(int maxConcurrency)
+  : mEpoch(0), mStopping(false), mNumQueued(0)
+{
+  startWorkers(maxConcurrency);
+}
+
+//==============================================================================
+TaskScheduler::~TaskScheduler()
+{
+  while (runOneTask())
+  {
+    // Help finish off whatever is still queued
+  }
+  stopWorkers();
+  // Anything the workers queued up on their way out is left for us
+  while (runOneTask())
+  {
+  }
+}
+
+//==============================================================================
+TaskScheduler& TaskScheduler::getGlobal()
+{
+  static TaskScheduler global;
+  return global;
+}
+
+//==============================================================================
+void TaskScheduler::setGlobalMaxConcurrency(int maxConcurrency)
+{
+  getGlobal().setMaxConcurrency(maxConcurrency);
+}
+
+//==============================================================================
+int TaskScheduler::getGlobalMaxConcurrency()
+{
+  return getGlobal().getMaxConcurrency();
+}
+
+//==============================================================================
+void TaskScheduler::setMaxConcurrency(int maxConcurrency)
+{
+  stopWorkers();
+  startWorkers(maxConcurrency);
+}
+
+//==============================================================================
+int TaskScheduler::getMaxConcurrency() const
+{
+  return mWorkers.size();
+}
+
+//==============================================================================
+bool TaskScheduler::runOneTask()
+{
+  std::function<void()> task;
+  if (!pop(task))
+  {
+    return false;
+  }
+  // Any exception is caught by the std::packaged_task, and handed to whoever
+  // calls get() on the TaskFuture
+  task();
+  notifyChange();
+  return true;
+}
+
+//==============================================================================
+void TaskScheduler::waitForChange(std::size_t epoch)
+{
+  std::unique_lock<std::mutex> lock(mChangeMutex);
+  // The timeout is just a backstop, we should always get woken up
+  mChanged.wait_for(lock, std::chrono::milliseconds(10), [this, epoch]() {
+    return mEpoch != epoch || mStopping;
+  });
+}
+
+//==============================================================================
+std::size_t TaskScheduler::getEpoch()
+{
+  std::lock_guard<std::mutex> lock(mChangeMutex);
+  return mEpoch;
+}
+
+//==============================================================================
+void TaskScheduler::push(std::function<void()>&& task)
+{
+  WorkerQueue* queue = &mSharedQueue;
+  if (tCurrentScheduler == this && tCurrentWorker >= 0)
+  {
+    queue = mWorkerQueues[tCurrentWorker].get();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->tasks.push_back(std::move(task));
+  }
+  mNumQueued++;
+  notifyChange();
+}
+
+//==============================================================================
+bool TaskScheduler::pop(std::function<void()>& task)
+{
+  if (mNumQueued.load() <= 0)
+  {
+    return false;
+  }
+
+  int self = -1;
+  if (tCurrentScheduler == this)
+  {
+    self = tCurrentWorker;
+  }
+
+  // 1. Take the newest task off our own queue
+  if (self >= 0)
+  {
+    WorkerQueue& queue = *mWorkerQueues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      mNumQueued--;
+      return true;
+    }
+  }
+
+  // 2. Take the oldest task off the shared queue
+  {
+    std::lock_guard<std::mutex> lock(mSharedQueue.mutex);
+    if (!mSharedQueue.tasks.empty())
+    {
+      task = std::move(mSharedQueue.tasks.front());
+      mSharedQueue.tasks.pop_front();
+      mNumQueued--;
+      return true;
+    }
+  }
+
+  // 3. Steal the oldest task from someone else's queue, starting with our
+  // neighbor so that thieves spread out
+  const int numQueues = mWorkerQueues.size();
+  for (int i = 1; i <= numQueues; i++)
+  {
+    const int victim = (std::max(self, 0) + i) % numQueues;
+    if (victim == self)
+    {
+      continue;
+    }
+    WorkerQueue& queue = *mWorkerQueues[victim];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      mNumQueued--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//==============================================================================
+void TaskScheduler::notifyChange()
+{
+  {
+    std::lock_guard<std::mutex> lock(mChangeMutex);
+    mEpoch++;
+  }
+  mChanged.notify_all();
+}
+
+//==============================================================================
+void TaskScheduler::startWorkers(int count)
+{
+  if (count <= 0)
+  {
+    count = std::thread::hardware_concurrency();
+  }
+  count = std::max(count, 1);
+
+  {
+    std::lock_guard<std::mutex> lock(mChangeMutex);
+    mStopping = false;
+  }
+  for (int i = 0; i < count; i++)
+  {
+    mWorkerQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+  }
+  for (int i = 0; i < count; i++)
+  {
+    mWorkers.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+//==============================================================================
+void TaskScheduler::stopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(mChangeMutex);
+    mStopping = true;
+  }
+  mChanged.notify_all();
+  for (std::thread& worker : mWorkers)
+  {
+    worker.join();
+  }
+  mWorkers.clear();
+
+  std::lock_guard<std::mutex> lock(mSharedQueue.mutex);
+  for (std::unique_ptr<WorkerQueue>& queue : mWorkerQueues)
+  {
+    for (std::function<void()>& task : queue->tasks)
+    {
+      mSharedQueue.tasks.push_back(std::move(task));
+    }
+  }
+  mWorkerQueues.clear();
+}
+
+//==============================================================================
+void TaskScheduler::workerLoop(int index)
+{
+  tCurrentScheduler = this;
+  tCurrentWorker = index;
+
+  while (true)
+  {
+    const std::size_t epoch = getEpoch();
+    if (runOneTask())
+    {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mChangeMutex);
+      if (mStopping)
+      {
+        break;
+      }
+    }
+    waitForChange(epoch);
+  }
+
+  tCurrentScheduler = nullptr;
+  tCurrentWorker = -1;
+}
+
+} // namespace common
+} // namespace dart
@@ -0,0 +1,171 @@
+#ifndef DART_COMMON_TASKSCHEDULER_HPP_
+#define DART_COMMON_TASKSCHEDULER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dart {
+namespace common {
+
+class TaskScheduler;
+
+/// This is the type a task returns, when it's launched as
+/// `async(task, args...)`
+template <typename Function, typename... Args>
+using TaskResult = typename std::result_of<typename std::decay<Function>::type(
+    typename std::decay<Args>::type...)>::type;
+
+/// This is the handle to a task running on a TaskScheduler. It works like a
+/// std::future, except that a thread blocked in get() or wait() runs other
+/// queued tasks while it waits, rather than sitting idle. That's what makes
+/// it safe for tasks to launch (and wait on) tasks of their own: the waiting
+/// threads keep the pool busy, so nesting can't deadlock or oversubscribe.
+template <typename T>
+class TaskFuture
+{
+public:
+  TaskFuture();
+
+  TaskFuture(std::future<T>&& future, TaskScheduler* scheduler);
+
+  /// This waits for the task to finish, then returns its result (or rethrows
+  /// whatever it threw). Like std::future, this can only be called once.
+  T get();
+
+  /// This waits for the task to finish, running other tasks in the meantime
+  void wait();
+
+  /// Returns true if this refers to a task whose result hasn't been taken yet
+  bool valid() const;
+
+protected:
+  std::future<T> mFuture;
+  TaskScheduler* mScheduler;
+};
+
+/// This is a work-stealing pool of threads, built so that the many places we
+/// parallelize (marker fitting, dynamics fitting, etc) share one fixed set of
+/// threads rather than each spawning their own. That keeps the total number
+/// of running threads under a single global limit, even when parallel code
+/// calls other parallel code, or several subjects are being processed at once
+/// in the same process.
+///
+/// Each worker thread keeps its own queue. Tasks launched from a worker go on
+/// the back of that worker's queue, and the worker takes from the back, so
+/// nested work stays hot in cache. Idle workers steal from the front of other
+/// workers' queues. Tasks launched from outside the pool go on a shared queue.
+///
+/// Tasks shouldn't hold a lock while they wait on another task, since the
+/// waiting thread may pick up some other task that wants the same lock.
+class TaskScheduler
+{
+public:
+  /// This creates a pool with `maxConcurrency` worker threads. Values <= 0
+  /// mean use all the hardware threads.
+  TaskScheduler(int maxConcurrency = -1);
+
+  /// This waits for any queued tasks to finish, then stops the workers
+  ~TaskScheduler();
+
+  /// This returns the pool shared by everything in the library
+  static TaskScheduler& getGlobal();
+
+  /// This sets the number of worker threads in the global pool, which is the
+  /// most threads that will ever run tasks at once (aside from threads that
+  /// are waiting on a TaskFuture, which help out while they wait). Values
+  /// <= 0 mean use all the hardware threads. This should only be called when
+  /// nothing is running on the pool.
+  static void setGlobalMaxConcurrency(int maxConcurrency);
+
+  /// This returns the number of worker threads in the global pool
+  static int getGlobalMaxConcurrency();
+
+  /// This changes the number of worker threads. This should only be called
+  /// when nothing is running on the pool. Any tasks still queued are kept,
+  /// and run on the new workers.
+  void setMaxConcurrency(int maxConcurrency);
+
+  /// This returns the number of worker threads
+  int getMaxConcurrency() const;
+
+  /// This queues up `task(args...)` to run on the pool, and returns a handle
+  /// to its result. Like std::async(), `task` and `args` are copied (or
+  /// moved) up front, so use std::ref() to pass something by reference.
+  template <typename Function, typename... Args>
+  TaskFuture<TaskResult<Function, Args...>> async(
+      Function&& task, Args&&... args);
+
+  /// This runs one queued task on the calling thread, if there are any, and
+  /// returns true if it did
+  bool runOneTask();
+
+  /// This blocks until either a task is queued or a task finishes, or a short
+  /// timeout passes, whichever comes first. `epoch` should come from
+  /// getEpoch(), read before checking whatever the caller is waiting on, so
+  /// that no wakeup gets missed.
+  void waitForChange(std::size_t epoch);
+
+  /// This returns a counter that goes up every time a task is queued or
+  /// finishes
+  std::size_t getEpoch();
+
+protected:
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  /// This puts a task on the right queue for the calling thread
+  void push(std::function<void()>&& task);
+
+  /// This takes the next task for the calling thread to run, and returns
+  /// false if there isn't one anywhere
+  bool pop(std::function<void()>& task);
+
+  /// This bumps the epoch, and wakes up anyone waiting for a change
+  void notifyChange();
+
+  /// This starts `count` workers
+  void startWorkers(int count);
+
+  /// This stops and joins all the workers, moving anything left in their
+  /// queues onto the shared queue
+  void stopWorkers();
+
+  /// This is what each worker thread runs
+  void workerLoop(int index);
+
+  std::vector<std::unique_ptr<WorkerQueue>> mWorkerQueues;
+  std::vector<std::thread> mWorkers;
+  WorkerQueue mSharedQueue;
+
+  std::mutex mChangeMutex;
+  std::condition_variable mChanged;
+  std::size_t mEpoch;
+  bool mStopping;
+
+  // The number of tasks that are queued but not yet started
+  std::atomic<int> mNumQueued;
+};
+
+/// This queues up `task(args...)` to run on the global pool. This is meant as
+/// a drop-in for std::async().
+template <typename Function, typename... Args>
+TaskFuture<TaskResult<Function, Args...>> async(
+    Function&& task, Args&&... args);
+
+} // namespace common
+} // namespace dart
+
+#include "dart/common/detail/TaskScheduler-impl.hpp"
+
+#endif // DART_COMMON_TASKSCHEDULER_HPP_
@@ -58,11 +58,11 @@ bool Composite::has() const
 template <class T>
 T* Composite::get()
 {
-  AspectMap::iterator it = mAspectMap.find( typeid(T) );
-  if(mAspectMap.end() == it)
+  const std::size_t index = getAspectSlotIndex<T>();
+  if(index >= mAspectSlots.size() || nullptr == mAspectSlots[index])
     return nullptr;
 
-  return static_cast<T*>(it->second.get());
+  return static_cast<T*>(mAspectSlots[index]->get());
 }
 
 //==============================================================================
@@ -91,7 +91,9 @@ template <class T, typename ...Args>
 T* Composite::createAspect(Args&&... args)
 {
   T* aspect = new T(std::forward<Args>(args)...);
-  mAspectMap[typeid(T)] = std::unique_ptr<T>(aspect);
+  std::unique_ptr<Aspect>& entry = mAspectMap[typeid(T)];
+  entry = std::unique_ptr<T>(aspect);
+  registerAspectSlot(getAspectSlotIndex<T>(), entry);
   addToComposite(aspect);
 
   return aspect;
@@ -126,6 +128,16 @@ std::unique_ptr<T> Composite::releaseAspect()
   return extraction;
 }
 
+//==============================================================================
+template <class T>
+std::size_t Composite::getAspectSlotIndex()
+{
+  // Every shared library that instantiates this gets its own copy of the
+  // static, but they all look up the same index
+  static const std::size_t index = getAspectSlotIndex(typeid(T));
+  return index;
+}
+
 //==============================================================================
 template <class T>
 constexpr bool Composite::isSpecializedFor()
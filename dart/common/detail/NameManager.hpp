@@ -77,6 +77,7 @@ bool NameManager<T>::setPattern(const std::string& _newPattern)
   mPrefix = _newPattern.substr(0, prefix_end);
   mInfix = _newPattern.substr(prefix_end + 2, infix_end - prefix_end - 2);
   mAffix = _newPattern.substr(infix_end + 2);
+  mNextNumbers.clear();
 
   return true;
 }
@@ -88,17 +89,12 @@ std::string NameManager<T>::issueNewName(const std::string& _name) const
   if (!hasName(_name))
     return _name;
 
-  int count = 1;
-  std::string newName;
-  do
-  {
-    std::stringstream ss;
-    if (mNameBeforeNumber)
-      ss << mPrefix << _name << mInfix << count++ << mAffix;
-    else
-      ss << mPrefix << count++ << mInfix << _name << mAffix;
-    newName = ss.str();
-  } while (hasName(newName));
+  // We leave the number we issue as the hint, since the caller might not end
+  // up adding it
+  std::size_t& number = mNextNumbers.emplace(_name, 1).first->second;
+  std::string newName = composeName(_name, number);
+  while (hasName(newName))
+    newName = composeName(_name, ++number);
 
   /*
   dtmsg << "[NameManager::issueNewName] (" << mManagerName << ") The name ["
@@ -132,14 +128,13 @@ bool NameManager<T>::addName(const std::string& _name, const T& _obj)
     return false;
   }
 
-  if (hasName(_name))
+  if (!mMap.insert(std::pair<std::string, T>(_name, _obj)).second)
   {
     dtwarn << "[NameManager::addName] (" << mManagerName << ") The name ["
            << _name << "] already exists!\n";
     return false;
   }
 
-  mMap.insert(std::pair<std::string, T>(_name, _obj));
   mReverseMap.insert(std::pair<T, std::string>(_obj, _name));
 
   assert(mReverseMap.size() == mMap.size());
@@ -165,6 +160,7 @@ bool NameManager<T>::removeName(const std::string& _name)
     mReverseMap.erase(rit);
 
   mMap.erase(it);
+  mNextNumbers.clear();
 
   return true;
 }
@@ -185,6 +181,7 @@ bool NameManager<T>::removeObject(const T& _obj)
     mMap.erase(it);
 
   mReverseMap.erase(rit);
+  mNextNumbers.clear();
 
   return true;
 }
@@ -203,6 +200,7 @@ void NameManager<T>::clear()
 {
   mMap.clear();
   mReverseMap.clear();
+  mNextNumbers.clear();
 }
 
 //==============================================================================
@@ -271,6 +269,19 @@ std::string NameManager<T>::changeObjectName(
   return issueNewNameAndAdd(_newName, _obj);
 }
 
+//==============================================================================
+template <class T>
+std::string NameManager<T>::composeName(
+    const std::string& _name, std::size_t _number) const
+{
+  std::stringstream ss;
+  if (mNameBeforeNumber)
+    ss << mPrefix << _name << mInfix << _number << mAffix;
+  else
+    ss << mPrefix << _number << mInfix << _name << mAffix;
+  return ss.str();
+}
+
 //==============================================================================
 template <class T>
 void NameManager<T>::setDefaultName(const std::string& _defaultName)
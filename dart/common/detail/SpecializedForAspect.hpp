@@ -52,6 +52,8 @@ SpecializedForAspect<SpecAspect>::SpecializedForAspect()
   mSpecAspectIterator = mAspectMap.insert(
         std::make_pair<std::type_index, std::unique_ptr<Aspect>>(
           typeid(SpecAspect), nullptr)).first;
+  registerAspectSlot(
+        getAspectSlotIndex<SpecAspect>(), mSpecAspectIterator->second);
 }
 
 //==============================================================================
@@ -0,0 +1,115 @@
+#ifndef DART_COMMON_DETAIL_TASKSCHEDULER_IMPL_HPP_
+#define DART_COMMON_DETAIL_TASKSCHEDULER_IMPL_HPP_
+
+#include "dart/common/TaskScheduler.hpp"
+
+#include <chrono>
+#include <tuple>
+#include <utility>
+
+namespace dart {
+namespace common {
+
+//==============================================================================
+template <typename T>
+TaskFuture<T>::TaskFuture() : mScheduler(nullptr)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename T>
+TaskFuture<T>::TaskFuture(std::future<T>&& future, TaskScheduler* scheduler)
+  : mFuture(std::move(future)), mScheduler(scheduler)
+{
+  // Do nothing
+}
+
+//==============================================================================
+template <typename T>
+T TaskFuture<T>::get()
+{
+  wait();
+  return mFuture.get();
+}
+
+//==============================================================================
+template <typename T>
+void TaskFuture<T>::wait()
+{
+  while (true)
+  {
+    // Read the epoch before checking, so that if the task finishes right
+    // after we check, waitForChange() returns immediately
+    const std::size_t epoch = mScheduler->getEpoch();
+    if (mFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+      return;
+    }
+    if (!mScheduler->runOneTask())
+    {
+      mScheduler->waitForChange(epoch);
+    }
+  }
+}
+
+//==============================================================================
+template <typename T>
+bool TaskFuture<T>::valid() const
+{
+  return mFuture.valid();
+}
+
+namespace detail {
+
+//==============================================================================
+/// This calls the first element of `call` with the rest as its arguments,
+/// moving them all in, the way std::async() does
+template <typename Call, std::size_t... Indices>
+auto invokeTask(Call& call, std::index_sequence<Indices...>)
+    -> decltype(std::move(std::get<0>(call))(
+        std::move(std::get<Indices + 1>(call))...))
+{
+  return std::move(std::get<0>(call))(
+      std::move(std::get<Indices + 1>(call))...);
+}
+
+} // namespace detail
+
+//==============================================================================
+template <typename Function, typename... Args>
+TaskFuture<TaskResult<Function, Args...>> TaskScheduler::async(
+    Function&& task, Args&&... args)
+{
+  typedef TaskResult<Function, Args...> Result;
+  typedef std::tuple<
+      typename std::decay<Function>::type,
+      typename std::decay<Args>::type...>
+      Call;
+  // std::function needs to be copyable, and std::packaged_task isn't, so we
+  // hold it by pointer
+  std::shared_ptr<Call> call = std::make_shared<Call>(
+      std::forward<Function>(task), std::forward<Args>(args)...);
+  std::shared_ptr<std::packaged_task<Result()>> packaged
+      = std::make_shared<std::packaged_task<Result()>>([call]() -> Result {
+          return detail::invokeTask(
+              *call, std::index_sequence_for<Args...>());
+        });
+  TaskFuture<Result> future(packaged->get_future(), this);
+  push([packaged]() { (*packaged)(); });
+  return future;
+}
+
+//==============================================================================
+template <typename Function, typename... Args>
+TaskFuture<TaskResult<Function, Args...>> async(
+    Function&& task, Args&&... args)
+{
+  return TaskScheduler::getGlobal().async(
+      std::forward<Function>(task), std::forward<Args>(args)...);
+}
+
+} // namespace common
+} // namespace dart
+
+#endif // DART_COMMON_DETAIL_TASKSCHEDULER_IMPL_HPP_
@@ -33,11 +33,13 @@
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 
 #include <cassert>
+#include <unordered_map>
 #ifndef NDEBUG
 #include <iomanip>
 #include <iostream>
 #endif
 
+#include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
 #include "dart/common/Console.hpp"
 #include "dart/constraint/ConstraintBase.hpp"
@@ -45,6 +47,9 @@
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 #include "dart/constraint/LCPUtils.hpp"
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
 #include "dart/external/odelcpsolver/lcp.h"
 #include "dart/lcpsolver/Lemke.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
@@ -88,7 +93,13 @@ BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
 //==============================================================================
 BoxedLcpConstraintSolver::BoxedLcpConstraintSolver(
     BoxedLcpSolverPtr boxedLcpSolver, BoxedLcpSolverPtr secondaryBoxedLcpSolver)
-  : ConstraintSolver()
+  : ConstraintSolver(),
+    mJacobianAssemblyEnabled(false),
+    mSmallBoxedLcpSolver(std::make_shared<SmallBoxedLcpSolver>()),
+    mSmallLcpSolverEnabled(false),
+    mIterativeRefinementEnabled(false),
+    mContactWarmStartEnabled(false),
+    mContactWarmStartRadius(0.01)
 {
   if (boxedLcpSolver)
   {
@@ -128,7 +139,8 @@ void BoxedLcpConstraintSolver::setBoxedLcpSolver(BoxedLcpSolverPtr lcpSolver)
 //==============================================================================
 /// This is pretty much only useful for Finite Difference testing with very
 /// complex collisions. This replaces the standard LCP solver with a PGS
-/// algorithm dialed up to super-duper-accurate max settings.
+/// algorithm dialed up to super-duper-accurate max settings. For solutions
+/// accurate to round-off, see also setIterativeRefinementEnabled().
 void BoxedLcpConstraintSolver::makeHyperAccurateAndVerySlow()
 {
   std::shared_ptr<PgsBoxedLcpSolver> accurateAndSlowSolver
@@ -186,6 +198,188 @@ void BoxedLcpConstraintSolver::setCachedLCPSolution(Eigen::VectorXs X)
   mX = X;
 }
 
+//==============================================================================
+void BoxedLcpConstraintSolver::setJacobianAssemblyEnabled(bool enabled)
+{
+  mJacobianAssemblyEnabled = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getJacobianAssemblyEnabled() const
+{
+  return mJacobianAssemblyEnabled;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setSmallLcpSolverEnabled(bool enabled)
+{
+  mSmallLcpSolverEnabled = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getSmallLcpSolverEnabled() const
+{
+  return mSmallLcpSolverEnabled;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setIterativeRefinementEnabled(bool enabled)
+{
+  mIterativeRefinementEnabled = enabled;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getIterativeRefinementEnabled() const
+{
+  return mIterativeRefinementEnabled;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setContactWarmStartEnabled(bool enabled)
+{
+  mContactWarmStartEnabled = enabled;
+  if (!enabled)
+    mPreviousContactImpulses = nullptr;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::getContactWarmStartEnabled() const
+{
+  return mContactWarmStartEnabled;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::setContactWarmStartRadius(s_t radius)
+{
+  mContactWarmStartRadius = radius;
+}
+
+//==============================================================================
+s_t BoxedLcpConstraintSolver::getContactWarmStartRadius() const
+{
+  return mContactWarmStartRadius;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::solveConstrainedGroups()
+{
+  ConstraintSolver::solveConstrainedGroups();
+  if (!mContactWarmStartEnabled)
+    return;
+
+  // Every contact that got solved has had its impulse applied by now, which
+  // leaves it in the contact's force (in the world frame)
+  std::shared_ptr<ContactImpulseMap> impulses
+      = std::make_shared<ContactImpulseMap>();
+  for (ConstrainedGroup& group : mConstrainedGroups)
+  {
+    for (std::size_t i = 0; i < group.getNumConstraints(); ++i)
+    {
+      const ConstraintBasePtr& constraint = group.getConstraint(i);
+      if (!constraint->isContactConstraint())
+        continue;
+      const collision::Contact& contact
+          = static_cast<ContactConstraint*>(constraint.get())->getContact();
+      const collision::CollisionObject* first = contact.collisionObject1;
+      const collision::CollisionObject* second = contact.collisionObject2;
+      Eigen::Vector3s impulse = contact.force * mTimeStep;
+      if (std::less<const void*>()(second, first))
+      {
+        std::swap(first, second);
+        impulse = -impulse;
+      }
+      ContactImpulse record;
+      record.localPoint = first->getTransform().inverse() * contact.point;
+      record.impulse = impulse;
+      (*impulses)[std::make_pair(first, second)].push_back(record);
+    }
+  }
+  mPreviousContactImpulses = impulses;
+}
+
+//==============================================================================
+bool BoxedLcpConstraintSolver::lookupContactImpulse(
+    ContactConstraint& constraint, int dim, s_t* x) const
+{
+  const collision::Contact& contact = constraint.getContact();
+  const collision::CollisionObject* first = contact.collisionObject1;
+  const collision::CollisionObject* second = contact.collisionObject2;
+  s_t sign = 1.0;
+  if (std::less<const void*>()(second, first))
+  {
+    std::swap(first, second);
+    sign = -1.0;
+  }
+  auto it = mPreviousContactImpulses->find(std::make_pair(first, second));
+  if (it == mPreviousContactImpulses->end())
+    return false;
+
+  const Eigen::Vector3s localPoint
+      = first->getTransform().inverse() * contact.point;
+  const ContactImpulse* closest = nullptr;
+  s_t closestDistance = mContactWarmStartRadius * mContactWarmStartRadius;
+  for (const ContactImpulse& candidate : it->second)
+  {
+    s_t distance = (candidate.localPoint - localPoint).squaredNorm();
+    if (distance <= closestDistance)
+    {
+      closest = &candidate;
+      closestDistance = distance;
+    }
+  }
+  if (closest == nullptr)
+    return false;
+
+  // The normal and tangent directions may have turned a little since last
+  // step, so we project the old impulse onto the new ones
+  const Eigen::Vector3s impulse = sign * closest->impulse;
+  x[0] = std::max((s_t)0.0, contact.normal.dot(impulse));
+  if (dim == 3)
+  {
+    const Eigen::MatrixXs D
+        = constraint.getTangentBasisMatrixODE(contact.normal);
+    x[1] = D.col(0).dot(impulse);
+    x[2] = D.col(1).dot(impulse);
+  }
+  return true;
+}
+
+//==============================================================================
+std::shared_ptr<ConstraintSolver>
+BoxedLcpConstraintSolver::createGroupSolverWorker()
+{
+  BoxedLcpSolverPtr boxedLcpSolver = mBoxedLcpSolver->clone();
+  if (!boxedLcpSolver)
+    return nullptr;
+
+  BoxedLcpSolverPtr secondaryBoxedLcpSolver = nullptr;
+  if (mSecondaryBoxedLcpSolver)
+  {
+    secondaryBoxedLcpSolver = mSecondaryBoxedLcpSolver->clone();
+    if (!secondaryBoxedLcpSolver)
+      return nullptr;
+  }
+
+  return std::make_shared<BoxedLcpConstraintSolver>(
+      boxedLcpSolver, secondaryBoxedLcpSolver);
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::syncGroupSolverWorker(
+    ConstraintSolver& worker) const
+{
+  ConstraintSolver::syncGroupSolverWorker(worker);
+  auto* boxedWorker = static_cast<BoxedLcpConstraintSolver*>(&worker);
+  boxedWorker->mJacobianAssemblyEnabled = mJacobianAssemblyEnabled;
+  boxedWorker->mSmallLcpSolverEnabled = mSmallLcpSolverEnabled;
+  boxedWorker->mIterativeRefinementEnabled = mIterativeRefinementEnabled;
+  boxedWorker->mContactWarmStartEnabled = mContactWarmStartEnabled;
+  boxedWorker->mContactWarmStartRadius = mContactWarmStartRadius;
+  boxedWorker->mPreviousContactImpulses = mPreviousContactImpulses;
+  boxedWorker->mSmallBoxedLcpSolver->setOption(
+      mSmallBoxedLcpSolver->getOption());
+}
+
 //==============================================================================
 LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
 {
@@ -206,6 +400,14 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
     mX.resize(n);
     mX.setZero();
   }
+  const bool warmStartContacts
+      = mContactWarmStartEnabled && mPreviousContactImpulses != nullptr;
+  if (warmStartContacts)
+  {
+    // Each contact gets filled in once we know its offset, below
+    mX.setZero();
+    shouldReinitializeMx = true;
+  }
   mB.resize(n);
   mW.setZero(n); // set w to 0
   mLo.resize(n);
@@ -222,6 +424,9 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
     mOffset[i] = mOffset[i - 1] + constraint->getDimension();
   }
 
+  const bool useJacobians
+      = mJacobianAssemblyEnabled && canAssembleFromJacobians(group);
+
   // For each constraint
   ConstraintInfo constInfo;
   constInfo.invTimeStep = 1.0 / mTimeStep;
@@ -239,6 +444,15 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
     // Fill vectors: lo, hi, b, w
     constraint->getInformation(&constInfo);
 
+    if (warmStartContacts && constraint->isContactConstraint()
+        && lookupContactImpulse(
+            *static_cast<ContactConstraint*>(constraint.get()),
+            constraint->getDimension(),
+            mX.data() + mOffset[i]))
+    {
+      shouldReinitializeMx = false;
+    }
+
     // Register this constraint with our gradient matrices. It's important that
     // this be called _after_ the getInformation() call, because it relies on
     // state being filled from that call.
@@ -247,6 +461,17 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
       group.getGradientConstraintMatrices()->registerConstraint(constraint);
     }
 
+    if (useJacobians)
+    {
+      // Adjust findex for global index
+      for (std::size_t j = 0; j < constraint->getDimension(); ++j)
+      {
+        if (mFIndex[mOffset[i] + j] >= 0)
+          mFIndex[mOffset[i] + j] += mOffset[i];
+      }
+      continue;
+    }
+
     // Fill a matrix by impulse tests: A
     constraint->excite();
 
@@ -327,6 +552,11 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
     constraint->unexcite();
   }
 
+  if (useJacobians)
+  {
+    assembleFromJacobians(group);
+  }
+
   assert(isSymmetric(n, mA.data()));
 
   // If we just zeroed out the mX vector, let's re-initialize it with a
@@ -348,6 +578,172 @@ LcpInputs BoxedLcpConstraintSolver::buildLcpInputs(ConstrainedGroup& group)
   return lcpInputs;
 }
 
+//==============================================================================
+bool BoxedLcpConstraintSolver::canAssembleFromJacobians(
+    ConstrainedGroup& group) const
+{
+  for (std::size_t i = 0; i < group.getNumConstraints(); ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    if (!constraint->isContactConstraint()
+        || dynamic_cast<ContactConstraint*>(constraint.get()) == nullptr)
+      return false;
+
+    // Motion prescribed joints don't move in response to impulses, which the
+    // inverse mass matrix doesn't know about
+    for (const dynamics::SkeletonPtr& skel : constraint->getSkeletons())
+    {
+      for (std::size_t j = 0; j < skel->getNumJoints(); ++j)
+      {
+        if (!skel->getJoint(j)->isDynamic())
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+void BoxedLcpConstraintSolver::assembleFromJacobians(ConstrainedGroup& group)
+{
+  const std::size_t numConstraints = group.getNumConstraints();
+
+  // Only constraints that share a skeleton can affect each other, so we
+  // build J one skeleton at a time. skelRows[s] lists the rows of the LCP
+  // that act on skeleton s, and skelJacobians[s] holds those rows of J
+  // restricted to the DOFs of skeleton s.
+  std::unordered_map<const dynamics::Skeleton*, std::size_t> skelIndices;
+  std::vector<dynamics::SkeletonPtr> skels;
+  std::vector<std::vector<std::size_t>> skelRows;
+  std::vector<Eigen::MatrixXs> skelJacobians;
+
+  // For each constraint, the skeletons it acts on, paired with where its rows
+  // start in that skeleton's block of J
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>>
+      constraintBlocks(numConstraints);
+
+  for (std::size_t i = 0; i < numConstraints; ++i)
+  {
+    const ConstraintBasePtr& constraint = group.getConstraint(i);
+    for (const dynamics::SkeletonPtr& skel : constraint->getSkeletons())
+    {
+      auto it = skelIndices.find(skel.get());
+      std::size_t s;
+      if (it == skelIndices.end())
+      {
+        s = skels.size();
+        skelIndices[skel.get()] = s;
+        skels.push_back(skel);
+        skelRows.emplace_back();
+      }
+      else
+      {
+        s = it->second;
+      }
+
+      // Self collisions list the same skeleton twice
+      bool alreadyAdded = false;
+      for (const auto& block : constraintBlocks[i])
+        alreadyAdded = alreadyAdded || block.first == s;
+      if (alreadyAdded)
+        continue;
+
+      constraintBlocks[i].emplace_back(s, skelRows[s].size());
+      for (std::size_t j = 0; j < constraint->getDimension(); ++j)
+        skelRows[s].push_back(mOffset[i] + j);
+    }
+  }
+
+  skelJacobians.resize(skels.size());
+  for (std::size_t s = 0; s < skels.size(); ++s)
+  {
+    skelJacobians[s].setZero(skelRows[s].size(), skels[s]->getNumDofs());
+  }
+
+  for (std::size_t i = 0; i < numConstraints; ++i)
+  {
+    ContactConstraint* contact
+        = static_cast<ContactConstraint*>(group.getConstraint(i).get());
+    const std::size_t dim = contact->getDimension();
+
+    const dynamics::BodyNode* bodies[2]
+        = {contact->getBodyNodeA(), contact->getBodyNodeB()};
+    const Eigen::MatrixXs normals[2]
+        = {contact->getSpatialNormalA(), contact->getSpatialNormalB()};
+    for (int side = 0; side < 2; ++side)
+    {
+      const dynamics::BodyNode* body = bodies[side];
+      if (!body->isReactive())
+        continue;
+
+      const std::size_t s = skelIndices[body->getSkeleton().get()];
+      std::size_t rowStart = 0;
+      for (const auto& block : constraintBlocks[i])
+      {
+        if (block.first == s)
+          rowStart = block.second;
+      }
+
+      // The spatial normals are in the body frame, like the body Jacobian
+      const Eigen::MatrixXs bodyJ
+          = normals[side].transpose() * body->getJacobian();
+      for (std::size_t k = 0; k < body->getNumDependentGenCoords(); ++k)
+      {
+        skelJacobians[s]
+            .block(rowStart, body->getDependentGenCoordIndex(k), dim, 1)
+            += bodyJ.col(k);
+      }
+    }
+  }
+
+  mA.setZero();
+  std::vector<Eigen::MatrixXs> skelVelocityChanges(skels.size());
+  for (std::size_t s = 0; s < skels.size(); ++s)
+  {
+    // The augmented mass matrix includes the implicit joint damping and
+    // springs, which is what the impulse tests see
+    skelVelocityChanges[s]
+        = skels[s]->getInvAugMassMatrix() * skelJacobians[s].transpose();
+    const Eigen::MatrixXs block = skelJacobians[s] * skelVelocityChanges[s];
+    const std::vector<std::size_t>& rows = skelRows[s];
+    for (std::size_t a = 0; a < rows.size(); ++a)
+    {
+      for (std::size_t b = 0; b < rows.size(); ++b)
+      {
+        mA(rows[a], rows[b]) += block(a, b);
+      }
+    }
+  }
+
+  // Record the velocity changes, in the same order the impulse tests would
+  // have
+  if (group.getGradientConstraintMatrices())
+  {
+    for (std::size_t i = 0; i < numConstraints; ++i)
+    {
+      const ConstraintBasePtr& constraint = group.getConstraint(i);
+      const std::vector<dynamics::SkeletonPtr> constraintSkels
+          = constraint->getSkeletons();
+      for (std::size_t j = 0; j < constraint->getDimension(); ++j)
+      {
+        std::vector<Eigen::VectorXs> velocityChanges;
+        for (const dynamics::SkeletonPtr& skel : constraintSkels)
+        {
+          const std::size_t s = skelIndices[skel.get()];
+          for (const auto& block : constraintBlocks[i])
+          {
+            if (block.first == s)
+              velocityChanges.push_back(
+                  skelVelocityChanges[s].col(block.second + j));
+          }
+        }
+        group.getGradientConstraintMatrices()->measureConstraintImpulse(
+            constraint, j, velocityChanges);
+      }
+    }
+  }
+}
+
 //==============================================================================
 std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     LcpInputs lcpInputs, ConstrainedGroup& group)
@@ -481,16 +877,36 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
         reducedAPadded = Eigen::MatrixXs::Zero(reducedN, dPAD(reducedN));
     reducedAPadded.block(0, 0, reducedN, reducedN) = mAReduced;
 
-    success = mBoxedLcpSolver->solve(
-        reducedN,
-        reducedAPadded.data(),
-        mXReduced.data(),
-        mBReduced.data(),
-        0,
-        mLoReduced.data(),
-        mHiReduced.data(),
-        mFIndexReduced.data(),
-        earlyTermination);
+    // Small problems get a quick direct solve first. This leaves all its
+    // inputs untouched if it fails, so the primary solver can take over.
+    if (mSmallLcpSolverEnabled
+        && reducedN <= SmallBoxedLcpSolver::getMaxDimension())
+    {
+      success = mSmallBoxedLcpSolver->solve(
+          reducedN,
+          reducedAPadded.data(),
+          mXReduced.data(),
+          mBReduced.data(),
+          0,
+          mLoReduced.data(),
+          mHiReduced.data(),
+          mFIndexReduced.data(),
+          earlyTermination);
+    }
+
+    if (!success)
+    {
+      success = mBoxedLcpSolver->solve(
+          reducedN,
+          reducedAPadded.data(),
+          mXReduced.data(),
+          mBReduced.data(),
+          0,
+          mLoReduced.data(),
+          mHiReduced.data(),
+          mFIndexReduced.data(),
+          earlyTermination);
+    }
 
     if (success)
     {
@@ -686,6 +1102,21 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
     mX.setZero();
   }
 
+  // Polish the solution in extended precision. This leaves mX alone if the
+  // refined solution isn't a better one. When we had to drop friction, mX no
+  // longer solves the LCP in the backups, so there's nothing to refine.
+  if (mIterativeRefinementEnabled && !shortCircuitLCP
+      && !hadToIgnoreFrictionToSolve)
+  {
+    LCPUtils::refineSolution(
+        aGradientBackup,
+        mX,
+        bGradientBackup,
+        hiGradientBackup,
+        loGradientBackup,
+        fIndexGradientBackup);
+  }
+
   // Print LCP formulation
   /*
   dtdbg << "After solve:" << std::endl;
@@ -792,8 +1223,13 @@ std::vector<s_t*> BoxedLcpConstraintSolver::solveLcp(
 std::vector<s_t*> BoxedLcpConstraintSolver::solveConstrainedGroup(
     ConstrainedGroup& group)
 {
+  const uint64_t constructionStart = getTimingClock();
   LcpInputs lcpInputs = buildLcpInputs(group);
-  return solveLcp(lcpInputs, group);
+  const uint64_t solveStart = getTimingClock();
+  mTimings.lcpConstructionNs += solveStart - constructionStart;
+  std::vector<s_t*> impulses = solveLcp(lcpInputs, group);
+  mTimings.lcpSolveNs += getTimingClock() - solveStart;
+  return impulses;
 }
 
 //==============================================================================
@@ -33,8 +33,14 @@
 #ifndef DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 #define DART_CONSTRAINT_BOXEDLCPCONSTRAINTSOLVER_HPP_
 
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "dart/constraint/BoxedLcpSolver.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/constraint/SmallBoxedLcpSolver.hpp"
 #include "dart/constraint/SmartPointer.hpp"
 
 namespace dart {
@@ -90,7 +96,8 @@ public:
 
   /// This is pretty much only useful for Finite Difference testing with very
   /// complex collisions. This replaces the standard LCP solver with a PGS
-  /// algorithm dialed up to super-duper-accurate max settings.
+  /// algorithm dialed up to super-duper-accurate max settings. For solutions
+  /// accurate to round-off, see also setIterativeRefinementEnabled().
   void makeHyperAccurateAndVerySlow();
 
   /// Returns boxed LCP (BLCP) solver
@@ -119,10 +126,122 @@ public:
   /// Build the inputs to the LCP from the constraint group.
   LcpInputs buildLcpInputs(ConstrainedGroup& group);
 
+  /// When this is enabled, buildLcpInputs() builds the A matrix as
+  /// J * M^-1 * J^T straight from each constraint's Jacobian and each
+  /// skeleton's (augmented) inverse mass matrix, one skeleton at a time, so
+  /// pairs of constraints that don't share a skeleton cost nothing. When it's
+  /// disabled, we build A the classic way, by applying a unit impulse to each
+  /// constraint dimension in turn and measuring the velocity change at every
+  /// other constraint, which gets slow for groups with lots of contacts.
+  ///
+  /// This only applies to groups made up entirely of contact constraints
+  /// between skeletons whose joints are all dynamic. Other groups always
+  /// fall back to impulse tests. This is disabled by default.
+  void setJacobianAssemblyEnabled(bool enabled);
+
+  /// Returns true if we build A from constraint Jacobians where we can. See
+  /// setJacobianAssemblyEnabled().
+  bool getJacobianAssemblyEnabled() const;
+
+  /// When this is enabled, LCPs with at most
+  /// SmallBoxedLcpSolver::getMaxDimension() rows (after removing duplicate
+  /// columns) are first handed to a SmallBoxedLcpSolver, which guesses the
+  /// active set and solves it directly, without the fixed overhead of the
+  /// primary solver. If that doesn't find a solution, we carry on with the
+  /// primary solver as usual. This is disabled by default.
+  void setSmallLcpSolverEnabled(bool enabled);
+
+  /// Returns true if small LCPs are tried with a SmallBoxedLcpSolver before
+  /// the primary solver. See setSmallLcpSolverEnabled().
+  bool getSmallLcpSolverEnabled() const;
+
+  /// When this is enabled, every LCP solution gets polished by
+  /// LCPUtils::refineSolution(), which keeps the solver's choice of which
+  /// constraints are clamping, but recomputes the residuals in extended
+  /// precision and corrects the clamping forces until they stop improving.
+  /// That's a handful of extra matrix-vector products and one factorization
+  /// per LCP, and it brings the error down from the solver's tolerance to
+  /// round-off, which is useful when finite differencing through contact.
+  /// This is disabled by default.
+  void setIterativeRefinementEnabled(bool enabled);
+
+  /// Returns true if LCP solutions are polished with mixed precision iterative
+  /// refinement. See setIterativeRefinementEnabled().
+  bool getIterativeRefinementEnabled() const;
+
+  /// When this is enabled, we remember the impulse every contact got at the
+  /// end of each step, and start each contact in the next step's LCPs from
+  /// the impulse of the matching contact last step. Contacts match if they're
+  /// between the same pair of collision objects, at points within
+  /// setContactWarmStartRadius() of each other in the first object's frame.
+  /// Unlike getCachedLCPSolution() / setCachedLCPSolution(), which only help
+  /// if the whole set of constraints comes out the same size, this still
+  /// warm starts the contacts that persist when others come and go.
+  ///
+  /// While this is enabled, constraints that aren't contacts start from zero,
+  /// and the whole-vector cache is ignored. If no contact in a group matches,
+  /// we fall back to LCPUtils::guessSolution(). This is disabled by default.
+  void setContactWarmStartEnabled(bool enabled);
+
+  /// Returns true if contacts are warm started individually. See
+  /// setContactWarmStartEnabled().
+  bool getContactWarmStartEnabled() const;
+
+  /// Sets how far (in meters) a contact point can move relative to the first
+  /// collision object and still count as the same contact. Defaults to 0.01.
+  void setContactWarmStartRadius(s_t radius);
+
+  /// Returns the radius used to match contacts between steps. See
+  /// setContactWarmStartRadius().
+  s_t getContactWarmStartRadius() const;
+
+  // Documentation inherited. This also records each contact's impulse for
+  // warm starting the next step, if that's enabled.
+  void solveConstrainedGroups() override;
+
   /// Setup and solve an LCP to enforce the constraints on the ConstrainedGroup.
   std::vector<s_t*> solveLcp(LcpInputs lcpInputs, ConstrainedGroup& group);
 
 protected:
+  // Documentation inherited. The worker gets clones of our LCP solvers, so
+  // this returns nullptr if either of them doesn't support clone().
+  std::shared_ptr<ConstraintSolver> createGroupSolverWorker() override;
+
+  // Documentation inherited.
+  void syncGroupSolverWorker(ConstraintSolver& worker) const override;
+
+  /// This is what we remember about each contact for warm starting
+  struct ContactImpulse
+  {
+    /// The contact point, in the frame of the first collision object of the
+    /// pair
+    Eigen::Vector3s localPoint;
+    /// The world frame impulse on the first collision object of the pair
+    Eigen::Vector3s impulse;
+  };
+
+  /// The contacts from one step, by (ordered) pair of collision objects
+  using ContactImpulseMap = std::map<
+      std::pair<const void*, const void*>,
+      std::vector<ContactImpulse>>;
+
+  /// This fills the first `dim` entries of `x` with the impulse of the contact
+  /// in mPreviousContactImpulses that matches `contact`, expressed in that
+  /// contact's normal and tangent directions, and returns true. If nothing
+  /// matches, this returns false and leaves `x` alone.
+  bool lookupContactImpulse(ContactConstraint& contact, int dim, s_t* x) const;
+
+  /// Returns true if every constraint in the group is a contact between
+  /// skeletons whose joints are all dynamic, which is when the A matrix from
+  /// J * M^-1 * J^T exactly matches the one from impulse tests.
+  bool canAssembleFromJacobians(ConstrainedGroup& group) const;
+
+  /// This fills in the first n columns of mA with J * M^-1 * J^T, and
+  /// registers the velocity changes from the unit impulses with the group's
+  /// gradient matrices, if there are any. This expects mOffset to already be
+  /// filled in.
+  void assembleFromJacobians(ConstrainedGroup& group);
+
   /// Boxed LCP solver
   BoxedLcpSolverPtr mBoxedLcpSolver;
   // TODO(JS): Hold as unique_ptr because there is no reason to share. Make this
@@ -175,6 +294,28 @@ protected:
   /// Cache data for boxed LCP formulation
   Eigen::VectorXi mOffset;
 
+  /// If true, we build A from constraint Jacobians rather than impulse tests
+  /// where we can
+  bool mJacobianAssemblyEnabled;
+
+  /// Direct solver that gets first try at small LCPs, if
+  /// mSmallLcpSolverEnabled is true
+  std::shared_ptr<SmallBoxedLcpSolver> mSmallBoxedLcpSolver;
+
+  /// If true, small LCPs are tried with mSmallBoxedLcpSolver first
+  bool mSmallLcpSolverEnabled;
+
+  /// If true, LCP solutions are polished with LCPUtils::refineSolution()
+  bool mIterativeRefinementEnabled;
+
+  /// See setContactWarmStartEnabled()
+  bool mContactWarmStartEnabled;
+  s_t mContactWarmStartRadius;
+
+  /// The contact impulses from the last step. This is never modified once
+  /// it's made, so group solver workers can share it.
+  std::shared_ptr<const ContactImpulseMap> mPreviousContactImpulses;
+
 #ifndef NDEBUG
 private:
   /// Return true if the matrix is symmetric
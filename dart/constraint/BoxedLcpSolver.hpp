@@ -33,6 +33,7 @@
 #ifndef DART_CONSTRAINT_BOXEDLCPSOLVER_HPP_
 #define DART_CONSTRAINT_BOXEDLCPSOLVER_HPP_
 
+#include <memory>
 #include <string>
 
 #include <Eigen/Core>
@@ -97,6 +98,15 @@ public:
   template <typename BoxedLcpSolverT>
   bool is() const;
 
+  /// Returns a new solver of the same type, with the same settings but none
+  /// of this solver's working memory, so that the two can solve at the same
+  /// time on different threads. Returns nullptr if the solver doesn't support
+  /// this, which is the default.
+  virtual std::shared_ptr<BoxedLcpSolver> clone() const
+  {
+    return nullptr;
+  }
+
   /// Solves constriant impulses for a constrained group. The LCP formulation
   /// setting that this function solve is A*x = b + w where each x[i], w[i]
   /// satisfies one of
@@ -0,0 +1,399 @@
+#include "dart/constraint/ColoredPgsBoxedLcpSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+#include <Eigen/Dense>
+
+#include "dart/external/odelcpsolver/matrix.h"
+
+// The fewest blocks we'll hand to a single thread. Below this, just spinning
+// up the thread costs more than the work.
+#define COLORED_PGS_MIN_BLOCKS_PER_CHUNK 64
+
+namespace dart {
+namespace constraint {
+
+//==============================================================================
+ColoredPgsBoxedLcpSolver::Option::Option(
+    int maxIteration, s_t tolerance, s_t epsilonForDivision, int numThreads)
+  : mMaxIteration(maxIteration),
+    mTolerance(tolerance),
+    mEpsilonForDivision(epsilonForDivision),
+    mNumThreads(numThreads)
+{
+  // Do nothing
+}
+
+//==============================================================================
+ColoredPgsBoxedLcpSolver::ColoredPgsBoxedLcpSolver(const Option& option)
+  : mOption(option), mLastNumIterations(0), mLastResidual(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+const std::string& ColoredPgsBoxedLcpSolver::getType() const
+{
+  return getStaticType();
+}
+
+//==============================================================================
+std::shared_ptr<BoxedLcpSolver> ColoredPgsBoxedLcpSolver::clone() const
+{
+  return std::make_shared<ColoredPgsBoxedLcpSolver>(mOption);
+}
+
+//==============================================================================
+const std::string& ColoredPgsBoxedLcpSolver::getStaticType()
+{
+  static const std::string type = "ColoredPgsBoxedLcpSolver";
+  return type;
+}
+
+//==============================================================================
+bool ColoredPgsBoxedLcpSolver::solve(
+    int n,
+    s_t* A,
+    s_t* x,
+    s_t* b,
+    int nub,
+    s_t* lo,
+    s_t* hi,
+    int* findex,
+    bool /*earlyTermination*/)
+{
+  mLastNumIterations = 0;
+  mLastResidual = 0;
+  mLastResidualHistory.clear();
+
+  if (n == 0)
+  {
+    mBlockRows.clear();
+    mColorOffsets.assign(1, 0);
+    return true;
+  }
+
+  const int nskip = dPAD(n);
+
+  // If all the variables are unbounded then we can just factor, solve, and
+  // return.
+  if (nub >= n)
+  {
+    Eigen::Map<const Eigen::Matrix<
+        s_t,
+        Eigen::Dynamic,
+        Eigen::Dynamic,
+        Eigen::RowMajor>,
+        0,
+        Eigen::OuterStride<>>
+        mappedA(A, n, n, Eigen::OuterStride<>(nskip));
+    Eigen::Map<Eigen::VectorXs> mappedX(x, n);
+    mappedX = Eigen::MatrixXs(mappedA).ldlt().solve(
+        Eigen::Map<const Eigen::VectorXs>(b, n));
+    mBlockRows.clear();
+    mColorOffsets.assign(1, 0);
+    return true;
+  }
+
+  buildColoring(n, A, findex);
+
+  int numThreads = mOption.mNumThreads;
+  if (numThreads <= 0)
+    numThreads = static_cast<int>(std::thread::hardware_concurrency());
+  numThreads = std::max(numThreads, 1);
+
+  bool converged = false;
+  for (int iter = 0; iter < mOption.mMaxIteration; ++iter)
+  {
+    s_t residual = 0;
+    for (std::size_t color = 0; color + 1 < mColorOffsets.size(); ++color)
+    {
+      const std::size_t begin = mColorOffsets[color];
+      const std::size_t end = mColorOffsets[color + 1];
+      const std::size_t numBlocks = end - begin;
+
+      const std::size_t numChunks = std::min(
+          static_cast<std::size_t>(numThreads),
+          numBlocks / COLORED_PGS_MIN_BLOCKS_PER_CHUNK);
+      if (numChunks <= 1)
+      {
+        residual = std::max(
+            residual, sweepBlocks(begin, end, x, b, lo, hi, findex));
+        continue;
+      }
+
+      // Blocks of the same color never read each other's rows of x, so it's
+      // safe to update them all at once
+      const std::size_t chunkSize = numBlocks / numChunks;
+      const std::size_t remainder = numBlocks % numChunks;
+      std::vector<std::future<s_t>> futures;
+      std::size_t cursor = begin;
+      for (std::size_t chunk = 0; chunk < numChunks; ++chunk)
+      {
+        const std::size_t chunkBegin = cursor;
+        const std::size_t chunkEnd
+            = chunkBegin + chunkSize + (chunk < remainder ? 1 : 0);
+        cursor = chunkEnd;
+        futures.push_back(std::async(
+            std::launch::async,
+            [this, chunkBegin, chunkEnd, x, b, lo, hi, findex]() {
+              return sweepBlocks(chunkBegin, chunkEnd, x, b, lo, hi, findex);
+            }));
+      }
+      for (int i = 0; i < futures.size(); i++)
+      {
+        residual = std::max(residual, futures[i].get());
+      }
+    }
+
+    mLastNumIterations = iter + 1;
+    mLastResidual = residual;
+    mLastResidualHistory.push_back(residual);
+    if (residual <= mOption.mTolerance)
+    {
+      converged = true;
+      break;
+    }
+  }
+
+  return converged;
+}
+
+//==============================================================================
+void ColoredPgsBoxedLcpSolver::buildColoring(
+    int n, const s_t* A, const int* findex)
+{
+  const int nskip = dPAD(n);
+
+  // Compress the rows of A, pre-divided by the diagonal
+  mInvDiagonal.resize(n);
+  mRowOffsets.resize(n + 1);
+  mRowColumns.clear();
+  mRowValues.clear();
+  for (int i = 0; i < n; ++i)
+  {
+    mRowOffsets[i] = mRowColumns.size();
+    const s_t* A_ptr = A + nskip * i;
+    const s_t diagonal = A_ptr[i];
+    if (diagonal < mOption.mEpsilonForDivision)
+    {
+      mInvDiagonal[i] = 0.0;
+      continue;
+    }
+    mInvDiagonal[i] = 1.0 / diagonal;
+    for (int j = 0; j < n; ++j)
+    {
+      if (j != i && A_ptr[j] != 0.0)
+      {
+        mRowColumns.push_back(j);
+        mRowValues.push_back(A_ptr[j] * mInvDiagonal[i]);
+      }
+    }
+  }
+  mRowOffsets[n] = mRowColumns.size();
+
+  // Each friction row joins the block of its normal row
+  std::vector<int> rowBlock(n, -1);
+  mBlockRows.clear();
+  for (int i = 0; i < n; ++i)
+  {
+    if (findex[i] >= 0 && findex[i] != i)
+      continue;
+    rowBlock[i] = mBlockRows.size();
+    mBlockRows.emplace_back(1, i);
+  }
+  for (int i = 0; i < n; ++i)
+  {
+    if (rowBlock[i] != -1)
+      continue;
+    // Friction rows should always point right at a normal row, but follow
+    // the chain just in case, so every row a block reads through findex is
+    // in that block
+    int normal = findex[i];
+    for (int steps = 0; steps < n && rowBlock[normal] == -1; ++steps)
+    {
+      if (findex[normal] < 0 || findex[normal] == normal)
+        break;
+      normal = findex[normal];
+    }
+    if (rowBlock[normal] == -1)
+    {
+      // This is a cycle of friction rows, which is nonsense, so just treat
+      // the row as if it were a normal row
+      rowBlock[i] = mBlockRows.size();
+      mBlockRows.emplace_back(1, i);
+      continue;
+    }
+    rowBlock[i] = rowBlock[normal];
+    mBlockRows[rowBlock[i]].push_back(i);
+  }
+
+  // Greedily color the blocks, so that no two blocks that share a non-zero in
+  // A get the same color
+  const int numBlocks = mBlockRows.size();
+  std::vector<int> blockColor(numBlocks, -1);
+  std::vector<int> colorLastUsedBy;
+  int numColors = 0;
+  for (int block = 0; block < numBlocks; ++block)
+  {
+    for (int row : mBlockRows[block])
+    {
+      for (std::size_t k = mRowOffsets[row]; k < mRowOffsets[row + 1]; ++k)
+      {
+        const int neighborColor = blockColor[rowBlock[mRowColumns[k]]];
+        if (neighborColor != -1)
+          colorLastUsedBy[neighborColor] = block;
+      }
+      // A is symmetric in practice, but the coloring is only safe if we
+      // also catch rows that read this block, so check the column too
+      for (int other = 0; other < n; ++other)
+      {
+        if (A[nskip * other + row] != 0.0 && rowBlock[other] != block)
+        {
+          const int neighborColor = blockColor[rowBlock[other]];
+          if (neighborColor != -1)
+            colorLastUsedBy[neighborColor] = block;
+        }
+      }
+    }
+
+    int color = 0;
+    while (color < numColors && colorLastUsedBy[color] == block)
+      color++;
+    if (color == numColors)
+    {
+      numColors++;
+      colorLastUsedBy.push_back(-1);
+    }
+    blockColor[block] = color;
+  }
+
+  // Sort the blocks by color
+  mColorOffsets.assign(numColors + 1, 0);
+  for (int block = 0; block < numBlocks; ++block)
+    mColorOffsets[blockColor[block] + 1]++;
+  for (int color = 0; color < numColors; ++color)
+    mColorOffsets[color + 1] += mColorOffsets[color];
+  mBlocksByColor.resize(numBlocks);
+  std::vector<std::size_t> cursor(
+      mColorOffsets.begin(), mColorOffsets.end() - 1);
+  for (int block = 0; block < numBlocks; ++block)
+    mBlocksByColor[cursor[blockColor[block]]++] = block;
+}
+
+//==============================================================================
+s_t ColoredPgsBoxedLcpSolver::sweepBlocks(
+    std::size_t begin,
+    std::size_t end,
+    s_t* x,
+    const s_t* b,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex) const
+{
+  s_t maxDelta = 0;
+  for (std::size_t k = begin; k < end; ++k)
+  {
+    for (int i : mBlockRows[mBlocksByColor[k]])
+    {
+      const s_t old_x = x[i];
+      if (mInvDiagonal[i] == 0.0)
+      {
+        x[i] = 0.0;
+        maxDelta = std::max(maxDelta, std::abs(old_x));
+        continue;
+      }
+
+      const std::size_t rowBegin = mRowOffsets[i];
+      const std::size_t rowEnd = mRowOffsets[i + 1];
+      const int* columns = mRowColumns.data();
+      const s_t* values = mRowValues.data();
+      s_t sum = 0;
+      for (std::size_t j = rowBegin; j < rowEnd; ++j)
+        sum += values[j] * x[columns[j]];
+      s_t new_x = b[i] * mInvDiagonal[i] - sum;
+
+      s_t lower = lo[i];
+      s_t upper = hi[i];
+      if (findex[i] >= 0 && findex[i] != i)
+      {
+        upper = hi[i] * x[findex[i]];
+        lower = -upper;
+      }
+      new_x = std::max(lower, std::min(upper, new_x));
+
+      x[i] = new_x;
+      maxDelta = std::max(maxDelta, std::abs(new_x - old_x));
+    }
+  }
+  return maxDelta;
+}
+
+#ifndef NDEBUG
+//==============================================================================
+bool ColoredPgsBoxedLcpSolver::canSolve(int n, const s_t* A)
+{
+  const int nskip = dPAD(n);
+
+  // Return false if A has zero-diagonal or A is nonsymmetric matrix
+  for (auto i = 0; i < n; ++i)
+  {
+    if (A[nskip * i + i] < mOption.mEpsilonForDivision)
+      return false;
+
+    for (auto j = 0; j < n; ++j)
+    {
+      if (std::abs(A[nskip * i + j] - A[nskip * j + i])
+          > mOption.mEpsilonForDivision)
+        return false;
+    }
+  }
+
+  return true;
+}
+#endif
+
+//==============================================================================
+void ColoredPgsBoxedLcpSolver::setOption(
+    const ColoredPgsBoxedLcpSolver::Option& option)
+{
+  mOption = option;
+}
+
+//==============================================================================
+const ColoredPgsBoxedLcpSolver::Option& ColoredPgsBoxedLcpSolver::getOption()
+    const
+{
+  return mOption;
+}
+
+//==============================================================================
+int ColoredPgsBoxedLcpSolver::getLastNumIterations() const
+{
+  return mLastNumIterations;
+}
+
+//==============================================================================
+s_t ColoredPgsBoxedLcpSolver::getLastResidual() const
+{
+  return mLastResidual;
+}
+
+//==============================================================================
+const std::vector<s_t>& ColoredPgsBoxedLcpSolver::getLastResidualHistory()
+    const
+{
+  return mLastResidualHistory;
+}
+
+//==============================================================================
+int ColoredPgsBoxedLcpSolver::getLastNumColors() const
+{
+  return static_cast<int>(mColorOffsets.size()) - 1;
+}
+
+} // namespace constraint
+} // namespace dart
@@ -0,0 +1,145 @@
+#ifndef DART_CONSTRAINT_COLOREDPGSBOXEDLCPSOLVER_HPP_
+#define DART_CONSTRAINT_COLOREDPGSBOXEDLCPSOLVER_HPP_
+
+#include <vector>
+
+#include "dart/constraint/BoxedLcpSolver.hpp"
+
+namespace dart {
+namespace constraint {
+
+/// This is a projected Gauss-Seidel (PGS) LCP solver built for throughput on
+/// big, contact-rich problems, where an approximate answer is fine.
+///
+/// Before iterating, we group each normal row with its friction rows (via
+/// findex) into a block, and color the blocks so that no two blocks of the
+/// same color touch each other in A. Blocks of the same color don't depend on
+/// each other, so we can update them all at once, across threads, and still
+/// get exactly the answer a sequential Gauss-Seidel sweep in color order
+/// would give. That also means the answer doesn't depend on how many threads
+/// we use.
+///
+/// Each row of A is stored compressed, as just its non-zero entries laid out
+/// contiguously, so a row update only touches the constraints it's actually
+/// coupled to.
+class ColoredPgsBoxedLcpSolver : public BoxedLcpSolver
+{
+public:
+  struct Option
+  {
+    /// The most sweeps we'll do over all the rows
+    int mMaxIteration;
+
+    /// We stop once no element of x changes by more than this in a sweep
+    s_t mTolerance;
+
+    /// Rows with a diagonal smaller than this are skipped, and set to 0
+    s_t mEpsilonForDivision;
+
+    /// The number of threads to update blocks of the same color on. Values
+    /// <= 0 mean use all the hardware threads.
+    int mNumThreads;
+
+    Option(
+        int maxIteration = 50,
+        s_t tolerance = 1e-6,
+        s_t epsilonForDivision = 1e-9,
+        int numThreads = 1);
+  };
+
+  /// Constructor
+  ColoredPgsBoxedLcpSolver(const Option& option = Option());
+
+  // Documentation inherited.
+  const std::string& getType() const override;
+
+  /// Returns type for this class
+  static const std::string& getStaticType();
+
+  // Documentation inherited.
+  std::shared_ptr<BoxedLcpSolver> clone() const override;
+
+  // Documentation inherited.
+  bool solve(
+      int n,
+      s_t* A,
+      s_t* x,
+      s_t* b,
+      int nub,
+      s_t* lo,
+      s_t* hi,
+      int* findex,
+      bool earlyTermination) override;
+
+#ifndef NDEBUG
+  // Documentation inherited.
+  bool canSolve(int n, const s_t* A) override;
+#endif
+
+  /// Sets options
+  void setOption(const Option& option);
+
+  /// Returns options.
+  const Option& getOption() const;
+
+  /// Returns the number of sweeps the last solve() took
+  int getLastNumIterations() const;
+
+  /// Returns the largest change in any element of x during the last sweep of
+  /// the last solve()
+  s_t getLastResidual() const;
+
+  /// Returns the largest change in any element of x during each sweep of the
+  /// last solve(), which is handy for checking how fast we're converging
+  const std::vector<s_t>& getLastResidualHistory() const;
+
+  /// Returns the number of colors the blocks of the last solve() needed
+  int getLastNumColors() const;
+
+protected:
+  /// This groups rows into blocks, colors the blocks, and compresses the
+  /// rows of A, filling in all our caches below.
+  void buildColoring(int n, const s_t* A, const int* findex);
+
+  /// This runs one Gauss-Seidel pass over the blocks from `begin` to `end` in
+  /// mBlocksByColor, and returns the largest change in x.
+  s_t sweepBlocks(
+      std::size_t begin,
+      std::size_t end,
+      s_t* x,
+      const s_t* b,
+      const s_t* lo,
+      const s_t* hi,
+      const int* findex) const;
+
+  Option mOption;
+
+  int mLastNumIterations;
+  s_t mLastResidual;
+  std::vector<s_t> mLastResidualHistory;
+
+  /// The rows of each block, with the normal row first
+  std::vector<std::vector<int>> mBlockRows;
+
+  /// Block indices, sorted by color
+  std::vector<int> mBlocksByColor;
+
+  /// mBlocksByColor[mColorOffsets[c]] is the first block of color c, and
+  /// mColorOffsets has one extra entry at the end
+  std::vector<std::size_t> mColorOffsets;
+
+  /// The off-diagonal non-zeros of row i of A, divided by the diagonal, are
+  /// mRowValues[mRowOffsets[i]] to mRowValues[mRowOffsets[i + 1] - 1], and
+  /// their columns are at the same spots in mRowColumns
+  std::vector<std::size_t> mRowOffsets;
+  std::vector<int> mRowColumns;
+  std::vector<s_t> mRowValues;
+
+  /// 1 / A(i, i), or 0 for rows we skip
+  std::vector<s_t> mInvDiagonal;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_COLOREDPGSBOXEDLCPSOLVER_HPP_
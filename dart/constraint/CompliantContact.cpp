@@ -0,0 +1,178 @@
+#include "dart/constraint/CompliantContact.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dart/collision/CollisionObject.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace constraint {
+
+namespace {
+
+dynamics::BodyNode* getBodyNode(const collision::CollisionObject* object)
+{
+  auto shapeFrame = const_cast<dynamics::ShapeFrame*>(object->getShapeFrame());
+  return shapeFrame->asShapeNode()->getBodyNodePtr().get();
+}
+
+} // namespace
+
+//==============================================================================
+CompliantContact::Option::Option(
+    s_t stiffness, s_t damping, s_t frictionSmoothingVelocity)
+  : mStiffness(stiffness),
+    mDamping(damping),
+    mFrictionSmoothingVelocity(frictionSmoothingVelocity)
+{
+  // Do nothing
+}
+
+//==============================================================================
+CompliantContact::CompliantContact(const collision::Contact& contact)
+  : mBodyNodeA(getBodyNode(contact.collisionObject1)),
+    mBodyNodeB(getBodyNode(contact.collisionObject2)),
+    mPoint(contact.point),
+    mNormal(contact.normal),
+    mPenetrationDepth(contact.penetrationDepth),
+    mFrictionCoeff(std::min(
+        mBodyNodeA->getFrictionCoeff(), mBodyNodeB->getFrictionCoeff())),
+    mRelativeVelocity(Eigen::Vector3s::Zero()),
+    mNormalForce(0.0),
+    mForce(Eigen::Vector3s::Zero()),
+    mForceVelocityJacobian(Eigen::Matrix3s::Zero()),
+    mForceDepthJacobian(Eigen::Vector3s::Zero())
+{
+  // Do nothing
+}
+
+//==============================================================================
+void CompliantContact::update(const Option& option)
+{
+  mRelativeVelocity
+      = mBodyNodeA->getLinearVelocity(
+            mBodyNodeA->getWorldTransform().inverse() * mPoint)
+        - mBodyNodeB->getLinearVelocity(
+            mBodyNodeB->getWorldTransform().inverse() * mPoint);
+
+  const s_t normalVel = mNormal.dot(mRelativeVelocity);
+  mNormalForce
+      = option.mStiffness * mPenetrationDepth - option.mDamping * normalVel;
+  if (mNormalForce <= 0.0)
+  {
+    mNormalForce = 0.0;
+    mForce.setZero();
+    mForceVelocityJacobian.setZero();
+    mForceDepthJacobian.setZero();
+    return;
+  }
+
+  const Eigen::Matrix3s I = Eigen::Matrix3s::Identity();
+  const Eigen::Vector3s slip = mRelativeVelocity - normalVel * mNormal;
+  const s_t eps = option.mFrictionSmoothingVelocity;
+  const s_t slipNorm = std::sqrt(slip.squaredNorm() + eps * eps);
+  const Eigen::Vector3s slipDir = slip / slipNorm;
+  const Eigen::Vector3s direction = mNormal - mFrictionCoeff * slipDir;
+  mForce = mNormalForce * direction;
+
+  // d(slipDir)/d(slip) = (I - slipDir * slipDir^T) / slipNorm, and the slip
+  // is the tangent projection of the relative velocity
+  const Eigen::Matrix3s dSlipDir = (I - slipDir * slipDir.transpose())
+                                   * (I - mNormal * mNormal.transpose())
+                                   / slipNorm;
+  mForceVelocityJacobian
+      = -option.mDamping * direction * mNormal.transpose()
+        - mFrictionCoeff * mNormalForce * dSlipDir;
+  mForceDepthJacobian = option.mStiffness * direction;
+}
+
+//==============================================================================
+bool CompliantContact::isActive() const
+{
+  return mNormalForce > 0.0;
+}
+
+//==============================================================================
+void CompliantContact::applyImpulse(s_t timeStep)
+{
+  if (!isActive())
+    return;
+
+  const Eigen::Vector3s impulse = timeStep * mForce;
+  if (mBodyNodeA->isReactive())
+  {
+    mBodyNodeA->addConstraintImpulse(impulse, mPoint, false, false);
+    mBodyNodeA->getSkeleton()->setImpulseApplied(true);
+  }
+  if (mBodyNodeB->isReactive())
+  {
+    mBodyNodeB->addConstraintImpulse(-impulse, mPoint, false, false);
+    mBodyNodeB->getSkeleton()->setImpulseApplied(true);
+  }
+}
+
+//==============================================================================
+dynamics::BodyNode* CompliantContact::getBodyNodeA() const
+{
+  return mBodyNodeA;
+}
+
+//==============================================================================
+dynamics::BodyNode* CompliantContact::getBodyNodeB() const
+{
+  return mBodyNodeB;
+}
+
+//==============================================================================
+const Eigen::Vector3s& CompliantContact::getPoint() const
+{
+  return mPoint;
+}
+
+//==============================================================================
+const Eigen::Vector3s& CompliantContact::getNormal() const
+{
+  return mNormal;
+}
+
+//==============================================================================
+s_t CompliantContact::getPenetrationDepth() const
+{
+  return mPenetrationDepth;
+}
+
+//==============================================================================
+s_t CompliantContact::getFrictionCoeff() const
+{
+  return mFrictionCoeff;
+}
+
+//==============================================================================
+const Eigen::Vector3s& CompliantContact::getRelativeVelocity() const
+{
+  return mRelativeVelocity;
+}
+
+//==============================================================================
+const Eigen::Vector3s& CompliantContact::getForce() const
+{
+  return mForce;
+}
+
+//==============================================================================
+const Eigen::Matrix3s& CompliantContact::getForceVelocityJacobian() const
+{
+  return mForceVelocityJacobian;
+}
+
+//==============================================================================
+const Eigen::Vector3s& CompliantContact::getForceDepthJacobian() const
+{
+  return mForceDepthJacobian;
+}
+
+} // namespace constraint
+} // namespace dart
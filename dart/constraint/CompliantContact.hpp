@@ -0,0 +1,131 @@
+#ifndef DART_CONSTRAINT_COMPLIANTCONTACT_HPP_
+#define DART_CONSTRAINT_COMPLIANTCONTACT_HPP_
+
+#include <Eigen/Dense>
+
+#include "dart/collision/Contact.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace dynamics {
+class BodyNode;
+} // namespace dynamics
+
+namespace constraint {
+
+/// CompliantContact resolves a contact with a closed-form spring-damper
+/// force, rather than as rows of the LCP. This trades the rigid
+/// non-penetration of ContactConstraint for a force that's a smooth function
+/// of the state, which is cheap to compute (each contact is independent of
+/// every other) and cheap to differentiate.
+///
+/// The force on body A (the body the normal points towards) is
+///
+///   f_n = max(0, k * depth - c * (n . v))
+///   f   = f_n * (n - mu * v_t / sqrt(|v_t|^2 + eps^2))
+///
+/// where v is the velocity of the contact point on A relative to B, and v_t
+/// is its component tangent to the contact. The friction term is a smoothed
+/// Coulomb cone: it reaches mu * f_n once the slip is large compared to eps.
+/// Body B gets -f.
+class CompliantContact
+{
+public:
+  struct Option
+  {
+    /// The spring constant k, in N/m of penetration
+    s_t mStiffness;
+
+    /// The damping constant c, in N/(m/s) of approach velocity
+    s_t mDamping;
+
+    /// The slip velocity eps below which friction fades out smoothly, rather
+    /// than flipping direction
+    s_t mFrictionSmoothingVelocity;
+
+    Option(
+        s_t stiffness = 1e4,
+        s_t damping = 1e2,
+        s_t frictionSmoothingVelocity = 1e-2);
+  };
+
+  /// Constructor
+  explicit CompliantContact(const collision::Contact& contact);
+
+  /// This computes the force (and its derivatives) from the current
+  /// velocities of the bodies. This only reads from the bodies, so contacts
+  /// can be updated concurrently, as long as the bodies' transforms and
+  /// velocities have already been computed.
+  void update(const Option& option);
+
+  /// Returns true if the last update() found a force pushing the bodies
+  /// apart. Contacts that are separating faster than the spring can push
+  /// don't apply any force.
+  bool isActive() const;
+
+  /// Applies timeStep times the force from the last update() to both bodies
+  /// as constraint impulses
+  void applyImpulse(s_t timeStep);
+
+  /// Returns the first body, which the force pushes along the normal
+  dynamics::BodyNode* getBodyNodeA() const;
+
+  /// Returns the second body, which the force pushes against the normal
+  dynamics::BodyNode* getBodyNodeB() const;
+
+  /// Returns the contact point in world coordinates
+  const Eigen::Vector3s& getPoint() const;
+
+  /// Returns the contact normal in world coordinates, from B to A
+  const Eigen::Vector3s& getNormal() const;
+
+  /// Returns how deep the bodies are inter-penetrating
+  s_t getPenetrationDepth() const;
+
+  /// Returns the friction coefficient mu
+  s_t getFrictionCoeff() const;
+
+  /// Returns the velocity of the contact point on A relative to B, in world
+  /// coordinates, as of the last update()
+  const Eigen::Vector3s& getRelativeVelocity() const;
+
+  /// Returns the force on A, in world coordinates, as of the last update()
+  const Eigen::Vector3s& getForce() const;
+
+  /// Returns the Jacobian of getForce() with respect to
+  /// getRelativeVelocity()
+  const Eigen::Matrix3s& getForceVelocityJacobian() const;
+
+  /// Returns the derivative of getForce() with respect to
+  /// getPenetrationDepth()
+  const Eigen::Vector3s& getForceDepthJacobian() const;
+
+protected:
+  dynamics::BodyNode* mBodyNodeA;
+
+  dynamics::BodyNode* mBodyNodeB;
+
+  Eigen::Vector3s mPoint;
+
+  Eigen::Vector3s mNormal;
+
+  s_t mPenetrationDepth;
+
+  s_t mFrictionCoeff;
+
+  Eigen::Vector3s mRelativeVelocity;
+
+  s_t mNormalForce;
+
+  Eigen::Vector3s mForce;
+
+  Eigen::Matrix3s mForceVelocityJacobian;
+
+  Eigen::Vector3s mForceDepthJacobian;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_COMPLIANTCONTACT_HPP_
@@ -32,12 +32,17 @@
 
 #include "dart/constraint/ConstraintSolver.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
 #include "dart/collision/CollisionFilter.hpp"
 #include "dart/collision/CollisionGroup.hpp"
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
 #include "dart/collision/dart/DARTCollisionDetector.hpp"
 #include "dart/common/Console.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/constraint/ContactConstraint.hpp"
 #include "dart/constraint/JointCoulombFrictionConstraint.hpp"
@@ -252,6 +257,24 @@ std::size_t ConstraintSolver::getNumConstrainedGroups() const
   return mConstrainedGroups.size();
 }
 
+//==============================================================================
+std::size_t ConstraintSolver::getNumConstrainedGroupRebuilds() const
+{
+  return mNumConstrainedGroupRebuilds;
+}
+
+//==============================================================================
+void ConstraintSolver::setNumGroupSolverThreads(int numThreads)
+{
+  mNumGroupSolverThreads = numThreads;
+}
+
+//==============================================================================
+int ConstraintSolver::getNumGroupSolverThreads() const
+{
+  return mNumGroupSolverThreads;
+}
+
 //==============================================================================
 void ConstraintSolver::clearLastCollisionResult()
 {
@@ -411,6 +434,9 @@ void ConstraintSolver::enforceContactAndJointAndCustomConstraintsWithLcp()
 
   // Solve constrained groups
   solveConstrainedGroups();
+
+  // Apply compliant contact forces
+  solveCompliantContacts();
 }
 
 //==============================================================================
@@ -480,6 +506,83 @@ s_t ConstraintSolver::getContactClippingDepth()
   return mContactClippingDepth;
 }
 
+//==============================================================================
+void ConstraintSolver::setMaxNumContactsPerPair(std::size_t maxNumContacts)
+{
+  mCollisionOption.maxNumContactsPerPair = maxNumContacts;
+}
+
+//==============================================================================
+std::size_t ConstraintSolver::getMaxNumContactsPerPair() const
+{
+  return mCollisionOption.maxNumContactsPerPair;
+}
+
+//==============================================================================
+void ConstraintSolver::setContinuousCollisionTimeStep(s_t timeStep)
+{
+  mCollisionOption.continuousCollisionTimeStep = timeStep;
+}
+
+//==============================================================================
+s_t ConstraintSolver::getContinuousCollisionTimeStep() const
+{
+  return mCollisionOption.continuousCollisionTimeStep;
+}
+
+//==============================================================================
+void ConstraintSolver::setCompliantContactEnabled(bool enabled)
+{
+  mCompliantContactEnabled = enabled;
+}
+
+//==============================================================================
+bool ConstraintSolver::getCompliantContactEnabled() const
+{
+  return mCompliantContactEnabled;
+}
+
+//==============================================================================
+void ConstraintSolver::setCompliantContactOption(
+    const CompliantContact::Option& option)
+{
+  mCompliantContactOption = option;
+}
+
+//==============================================================================
+const CompliantContact::Option& ConstraintSolver::getCompliantContactOption()
+    const
+{
+  return mCompliantContactOption;
+}
+
+//==============================================================================
+const std::vector<CompliantContact>& ConstraintSolver::getCompliantContacts()
+    const
+{
+  return mCompliantContacts;
+}
+
+//==============================================================================
+const ConstraintSolverTimings& ConstraintSolver::getTimings() const
+{
+  return mTimings;
+}
+
+//==============================================================================
+void ConstraintSolver::resetTimings()
+{
+  mTimings = ConstraintSolverTimings();
+}
+
+//==============================================================================
+uint64_t ConstraintSolver::getTimingClock()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
 //==============================================================================
 bool ConstraintSolver::containSkeleton(const ConstSkeletonPtr& _skeleton) const
 {
@@ -560,7 +663,9 @@ void ConstraintSolver::updateConstraints()
   //----------------------------------------------------------------------------
   mCollisionResult.clear();
 
+  const uint64_t collisionStart = getTimingClock();
   mCollisionGroup->collide(mCollisionOption, &mCollisionResult);
+  mTimings.collisionDetectionNs += getTimingClock() - collisionStart;
 
   // Destroy previous contact constraints
   mContactConstraints.clear();
@@ -568,6 +673,9 @@ void ConstraintSolver::updateConstraints()
   // Destroy previous soft contact constraints
   mSoftContactConstraints.clear();
 
+  // Destroy previous compliant contacts
+  mCompliantContacts.clear();
+
   // Create new contact constraints
   for (auto i = 0u; i < mCollisionResult.getNumContacts(); ++i)
   {
@@ -605,6 +713,10 @@ void ConstraintSolver::updateConstraints()
       mSoftContactConstraints.push_back(
           std::make_shared<SoftContactConstraint>(contact, mTimeStep));
     }
+    else if (mCompliantContactEnabled)
+    {
+      mCompliantContacts.emplace_back(contact);
+    }
     else
     {
       mContactConstraints.push_back(std::make_shared<ContactConstraint>(
@@ -642,6 +754,15 @@ void ConstraintSolver::updateConstraints()
   // Create new joint constraints
   for (const auto& skel : mSkeletons)
   {
+    // Only joints that are at a limit need a JointLimitConstraint, and the
+    // skeleton can find those for us without visiting every joint
+    skel->getJointsAtPositionLimits(mJointsAtPositionLimits);
+    for (dynamics::Joint* joint : mJointsAtPositionLimits)
+    {
+      mJointLimitConstraints.push_back(
+          std::make_shared<JointLimitConstraint>(joint));
+    }
+
     const std::size_t numJoints = skel->getNumJoints();
     for (std::size_t i = 0; i < numJoints; i++)
     {
@@ -661,12 +782,6 @@ void ConstraintSolver::updateConstraints()
         }
       }
 
-      if (joint->isPositionLimitEnforced())
-      {
-        mJointLimitConstraints.push_back(
-            std::make_shared<JointLimitConstraint>(joint));
-      }
-
       if (joint->getActuatorType() == dynamics::Joint::SERVO)
       {
         mServoMotorConstraints.push_back(
@@ -722,8 +837,6 @@ void ConstraintSolver::updateConstraints()
 //==============================================================================
 void ConstraintSolver::buildConstrainedGroups()
 {
-  // Clear constrained groups
-  mConstrainedGroups.clear();
   if (mGradientEnabled)
   {
     for (const auto& skel : mSkeletons)
@@ -734,7 +847,14 @@ void ConstraintSolver::buildConstrainedGroups()
 
   // Exit if there is no active constraint
   if (mActiveConstraints.empty())
+  {
+    if (!mConstrainedGroups.empty())
+    {
+      mConstrainedGroups.clear();
+      mNumConstrainedGroupRebuilds++;
+    }
     return;
+  }
 
   //----------------------------------------------------------------------------
   // Unite skeletons according to constraints's relationships
@@ -743,29 +863,47 @@ void ConstraintSolver::buildConstrainedGroups()
     activeConstraint->uniteSkeletons();
 
   //----------------------------------------------------------------------------
-  // Build constraint groups
+  // Find the root skeleton of each group, in order of first appearance
   //----------------------------------------------------------------------------
+  const std::size_t unassigned = std::numeric_limits<std::size_t>::max();
+  for (const auto& activeConstraint : mActiveConstraints)
+    activeConstraint->getRootSkeleton()->mUnionIndex = unassigned;
+
+  mConstrainedGroupRoots.clear();
   for (const auto& activeConstraint : mActiveConstraints)
   {
-    bool found = false;
     const auto& skel = activeConstraint->getRootSkeleton();
-
-    for (const auto& constrainedGroup : mConstrainedGroups)
-    {
-      if (constrainedGroup.mRootSkeleton == skel)
-      {
-        found = true;
-        break;
-      }
-    }
-
-    if (found)
+    if (skel->mUnionIndex != unassigned)
       continue;
+    skel->mUnionIndex = mConstrainedGroupRoots.size();
+    mConstrainedGroupRoots.push_back(skel);
+  }
 
-    ConstrainedGroup newConstGroup;
-    newConstGroup.mRootSkeleton = skel;
-    skel->mUnionIndex = mConstrainedGroups.size();
-    mConstrainedGroups.push_back(newConstGroup);
+  //----------------------------------------------------------------------------
+  // Build constraint groups
+  //----------------------------------------------------------------------------
+  // With a persistent set of contacts, the grouping is usually the same as
+  // last step, in which case we keep the groups (and their storage) and only
+  // refill their constraints
+  bool sameGrouping
+      = mConstrainedGroups.size() == mConstrainedGroupRoots.size();
+  for (std::size_t i = 0; sameGrouping && i < mConstrainedGroupRoots.size();
+       i++)
+  {
+    sameGrouping
+        = mConstrainedGroups[i].mRootSkeleton == mConstrainedGroupRoots[i];
+  }
+  if (!sameGrouping)
+  {
+    mConstrainedGroups.resize(mConstrainedGroupRoots.size());
+    for (std::size_t i = 0; i < mConstrainedGroupRoots.size(); i++)
+      mConstrainedGroups[i].mRootSkeleton = mConstrainedGroupRoots[i];
+    mNumConstrainedGroupRebuilds++;
+  }
+  for (auto& constrainedGroup : mConstrainedGroups)
+  {
+    constrainedGroup.removeAllConstraints();
+    constrainedGroup.mGradientConstraintMatrices = nullptr;
   }
 
   // Add active constraints to constrained groups
@@ -795,6 +933,37 @@ void ConstraintSolver::buildConstrainedGroups()
 //==============================================================================
 void ConstraintSolver::solveConstrainedGroups()
 {
+  int numThreads = mNumGroupSolverThreads;
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+
+  if (numThreads > 1)
+  {
+    // There's no point in having more threads than groups to solve
+    int numGroupsToSolve = 0;
+    for (const auto& constraintGroup : mConstrainedGroups)
+    {
+      if (constraintGroup.getTotalDimension() > 0u)
+        numGroupsToSolve++;
+    }
+    numThreads = std::min(numThreads, numGroupsToSolve);
+
+    while (static_cast<int>(mGroupSolverWorkers.size()) < numThreads)
+    {
+      std::shared_ptr<ConstraintSolver> worker = createGroupSolverWorker();
+      if (!worker)
+        break;
+      mGroupSolverWorkers.push_back(worker);
+    }
+
+    if (numThreads > 1
+        && static_cast<int>(mGroupSolverWorkers.size()) >= numThreads)
+    {
+      solveConstrainedGroupsInParallel(numThreads);
+      return;
+    }
+  }
+
   for (auto& constraintGroup : mConstrainedGroups)
   {
     // Build LCP terms by aggregating them from constraints
@@ -809,6 +978,109 @@ void ConstraintSolver::solveConstrainedGroups()
   }
 }
 
+//==============================================================================
+void ConstraintSolver::solveConstrainedGroupsInParallel(int numThreads)
+{
+  const std::size_t numGroups = mConstrainedGroups.size();
+
+  // The cost of solving an LCP grows at least with the square of its size, so
+  // we use that as our estimate of the work in each group. We hand out the
+  // biggest groups first, each to the thread with the least work so far, with
+  // ties broken by index so the schedule is the same every step.
+  std::vector<std::size_t> work(numGroups);
+  std::vector<std::size_t> order;
+  order.reserve(numGroups);
+  for (std::size_t i = 0; i < numGroups; ++i)
+  {
+    const std::size_t n = mConstrainedGroups[i].getTotalDimension();
+    work[i] = n * n;
+    if (n > 0u)
+      order.push_back(i);
+  }
+  std::stable_sort(
+      order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return work[a] > work[b];
+      });
+
+  std::vector<std::vector<std::size_t>> assignments(numThreads);
+  std::vector<std::size_t> load(numThreads, 0u);
+  for (std::size_t i : order)
+  {
+    const std::size_t thread
+        = std::min_element(load.begin(), load.end()) - load.begin();
+    assignments[thread].push_back(i);
+    load[thread] += work[i];
+  }
+
+  // The impulses each worker returns point into its own LCP buffers, which
+  // get overwritten by its next solve, so we copy them out as we go
+  std::vector<std::vector<Eigen::VectorXs>> impulses(numGroups);
+
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(numThreads);
+  for (int thread = 0; thread < numThreads; ++thread)
+  {
+    ConstraintSolver* worker = mGroupSolverWorkers[thread].get();
+    syncGroupSolverWorker(*worker);
+    const std::vector<std::size_t>& groups = assignments[thread];
+    futures.push_back(common::async([this, worker, &groups, &impulses] {
+      for (std::size_t i : groups)
+      {
+        ConstrainedGroup& group = mConstrainedGroups[i];
+        std::vector<s_t*> groupImpulses = worker->solveConstrainedGroup(group);
+        std::vector<Eigen::VectorXs>& copies = impulses[i];
+        copies.resize(group.getNumConstraints());
+        for (std::size_t j = 0; j < copies.size(); ++j)
+        {
+          copies[j] = Eigen::Map<Eigen::VectorXs>(
+              groupImpulses[j], group.getConstraint(j)->getDimension());
+        }
+      }
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+
+  for (int thread = 0; thread < numThreads; ++thread)
+  {
+    ConstraintSolver* worker = mGroupSolverWorkers[thread].get();
+    mTimings.lcpConstructionNs += worker->mTimings.lcpConstructionNs;
+    mTimings.lcpSolveNs += worker->mTimings.lcpSolveNs;
+    worker->mTimings = ConstraintSolverTimings();
+  }
+
+  // Groups don't share any skeletons, so we could apply these in any order,
+  // but we stick to group order to match the single threaded solve
+  for (std::size_t i = 0; i < numGroups; ++i)
+  {
+    if (impulses[i].empty())
+      continue;
+
+    std::vector<s_t*> groupImpulses;
+    groupImpulses.reserve(impulses[i].size());
+    for (Eigen::VectorXs& impulse : impulses[i])
+      groupImpulses.push_back(impulse.data());
+    applyConstraintImpulses(
+        mConstrainedGroups[i].getConstraints(), groupImpulses);
+  }
+}
+
+//==============================================================================
+std::shared_ptr<ConstraintSolver> ConstraintSolver::createGroupSolverWorker()
+{
+  return nullptr;
+}
+
+//==============================================================================
+void ConstraintSolver::syncGroupSolverWorker(ConstraintSolver& worker) const
+{
+  worker.mTimeStep = mTimeStep;
+  worker.mGradientEnabled = mGradientEnabled;
+  worker.mPenetrationCorrectionEnabled = mPenetrationCorrectionEnabled;
+  worker.mFallbackConstraintForceMixingConstant
+      = mFallbackConstraintForceMixingConstant;
+}
+
 //==============================================================================
 void ConstraintSolver::applyConstraintImpulses(
     std::vector<ConstraintBasePtr> constraints, std::vector<s_t*> impulses)
@@ -822,6 +1094,58 @@ void ConstraintSolver::applyConstraintImpulses(
   }
 }
 
+//==============================================================================
+void ConstraintSolver::solveCompliantContacts()
+{
+  const std::size_t numContacts = mCompliantContacts.size();
+  if (numContacts == 0u)
+    return;
+
+  int numThreads = mNumGroupSolverThreads;
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  // Each contact is only a few dozen flops, so it's not worth a task unless
+  // it gets a decent sized batch of them
+  const std::size_t minContactsPerThread = 32u;
+  numThreads = static_cast<int>(std::min<std::size_t>(
+      std::max(numThreads, 1), numContacts / minContactsPerThread));
+
+  if (numThreads <= 1)
+  {
+    for (CompliantContact& contact : mCompliantContacts)
+      contact.update(mCompliantContactOption);
+  }
+  else
+  {
+    // Bodies compute their transforms and velocities lazily, so we make sure
+    // they're up to date here, and then the contacts only read from them
+    for (const CompliantContact& contact : mCompliantContacts)
+    {
+      contact.getBodyNodeA()->getWorldTransform();
+      contact.getBodyNodeA()->getSpatialVelocity();
+      contact.getBodyNodeB()->getWorldTransform();
+      contact.getBodyNodeB()->getSpatialVelocity();
+    }
+
+    std::vector<common::TaskFuture<void>> futures;
+    futures.reserve(numThreads);
+    for (int thread = 0; thread < numThreads; ++thread)
+    {
+      const std::size_t begin = numContacts * thread / numThreads;
+      const std::size_t end = numContacts * (thread + 1) / numThreads;
+      futures.push_back(common::async([this, begin, end] {
+        for (std::size_t i = begin; i < end; ++i)
+          mCompliantContacts[i].update(mCompliantContactOption);
+      }));
+    }
+    for (auto& future : futures)
+      future.get();
+  }
+
+  for (CompliantContact& contact : mCompliantContacts)
+    contact.applyImpulse(mTimeStep);
+}
+
 //==============================================================================
 bool ConstraintSolver::isSoftContact(const collision::Contact& contact) const
 {
@@ -33,6 +33,7 @@
 #ifndef DART_CONSTRAINT_CONSTRAINTSOVER_HPP_
 #define DART_CONSTRAINT_CONSTRAINTSOVER_HPP_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -40,6 +41,7 @@
 
 #include "dart/collision/CollisionDetector.hpp"
 #include "dart/common/Deprecated.hpp"
+#include "dart/constraint/CompliantContact.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/constraint/ConstraintBase.hpp"
 #include "dart/constraint/SmartPointer.hpp"
@@ -52,12 +54,22 @@ class World;
 }
 
 namespace dynamics {
+class Joint;
 class Skeleton;
 class ShapeNodeCollisionObject;
 } // namespace dynamics
 
 namespace constraint {
 
+/// Cumulative wall-clock time the constraint solver has spent in each phase,
+/// in nanoseconds, since the last ConstraintSolver::resetTimings()
+struct ConstraintSolverTimings
+{
+  uint64_t collisionDetectionNs = 0;
+  uint64_t lcpConstructionNs = 0;
+  uint64_t lcpSolveNs = 0;
+};
+
 /// ConstraintSolver manages constraints and computes constraint impulses
 class ConstraintSolver
 {
@@ -203,7 +215,7 @@ public:
   void buildConstrainedGroups();
 
   /// Solve constrained groups
-  void solveConstrainedGroups();
+  virtual void solveConstrainedGroups();
 
   // Solve for constraint impulses to apply to each constraint in group.
   virtual std::vector<s_t*> solveConstrainedGroup(ConstrainedGroup& group) = 0;
@@ -218,6 +230,35 @@ public:
   /// Get number of constrained groups.
   std::size_t getNumConstrainedGroups() const;
 
+  /// Get the number of steps where the constrained groups had to be rebuilt,
+  /// because the grouping of skeletons changed. On every other step with
+  /// active constraints, the groups from the last step are reused, and only
+  /// their constraint lists are refilled.
+  std::size_t getNumConstrainedGroupRebuilds() const;
+
+  /// Defaults to 1. If this is more than 1, and there's more than one
+  /// constrained group with constraints in it, solveConstrainedGroups()
+  /// solves the groups concurrently on this many threads, each with its own
+  /// copy of the LCP workspace. The impulses are still applied one group at a
+  /// time, in group order, once every group is solved, so the results don't
+  /// depend on the thread count. Pass a number <= 0 to use
+  /// common::TaskScheduler::getGlobalMaxConcurrency().
+  ///
+  /// Solvers that don't support creating workers (see
+  /// createGroupSolverWorker()) always solve the groups one at a time.
+  ///
+  /// When gradients are enabled, each group's gradient matrices are built as
+  /// part of its solve, so they're built on these threads too. This is also
+  /// how many threads compliant contacts are evaluated on (see
+  /// setCompliantContactEnabled()), and how many threads
+  /// BackpropSnapshot::backprop() splits the groups across when it's asked to
+  /// explore alternate strategies.
+  void setNumGroupSolverThreads(int numThreads);
+
+  /// Returns the number of threads solveConstrainedGroups() may use. See
+  /// setNumGroupSolverThreads().
+  int getNumGroupSolverThreads() const;
+
   /// Sets this constraint solver using other constraint solver. All the
   /// properties and registered skeletons and constraints will be copied over.
   virtual void setFromOtherConstraintSolver(const ConstraintSolver& other);
@@ -266,7 +307,71 @@ public:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t getContactClippingDepth();
 
+  /// If this is non-zero, collision detection keeps at most this many
+  /// contacts between each pair of colliding shapes. See
+  /// collision::CollisionOption::maxNumContactsPerPair.
+  void setMaxNumContactsPerPair(std::size_t maxNumContacts);
+
+  /// Returns the most contacts collision detection keeps between each pair of
+  /// colliding shapes, or 0 if it keeps every contact
+  std::size_t getMaxNumContactsPerPair() const;
+
+  /// If this is positive, collision detection also adds contacts for objects
+  /// that would run into each other within this much time. See
+  /// collision::CollisionOption::continuousCollisionTimeStep.
+  void setContinuousCollisionTimeStep(s_t timeStep);
+
+  /// Returns how far ahead collision detection looks for objects running
+  /// into each other, or 0 if it only checks the current positions
+  s_t getContinuousCollisionTimeStep() const;
+
+  /// False by default. If this is true, contacts between rigid bodies are
+  /// resolved with the closed-form spring-damper forces of CompliantContact,
+  /// rather than as ContactConstraints in the LCP. Joint limits, motors and
+  /// manually added constraints still go through the LCP.
+  void setCompliantContactEnabled(bool enabled);
+
+  /// Returns true if contacts are resolved with CompliantContact forces
+  bool getCompliantContactEnabled() const;
+
+  /// Sets the stiffness, damping and friction smoothing for compliant
+  /// contacts
+  void setCompliantContactOption(const CompliantContact::Option& option);
+
+  /// Returns the stiffness, damping and friction smoothing for compliant
+  /// contacts
+  const CompliantContact::Option& getCompliantContactOption() const;
+
+  /// Returns the compliant contacts from the last solve(), with the forces
+  /// they applied. This is empty unless getCompliantContactEnabled().
+  const std::vector<CompliantContact>& getCompliantContacts() const;
+
+  /// Returns how long this solver has spent on collision detection, building
+  /// LCPs and solving them since the last resetTimings(). These counters are
+  /// always on, since they cost a couple of clock reads per phase.
+  const ConstraintSolverTimings& getTimings() const;
+
+  /// Zeros the counters returned by getTimings()
+  void resetTimings();
+
 protected:
+  /// A monotonic clock, in nanoseconds, for the timing counters
+  static uint64_t getTimingClock();
+
+  /// This returns a new solver that can solve constrained groups on another
+  /// thread at the same time as this one, with no working memory in common,
+  /// or nullptr if this solver can't do that. The default returns nullptr.
+  virtual std::shared_ptr<ConstraintSolver> createGroupSolverWorker();
+
+  /// This copies over whatever settings affect solveConstrainedGroup() to a
+  /// worker made by createGroupSolverWorker(), before each parallel solve.
+  virtual void syncGroupSolverWorker(ConstraintSolver& worker) const;
+
+  /// This solves the constrained groups concurrently, on `numThreads` of the
+  /// workers in mGroupSolverWorkers, and then applies the impulses in group
+  /// order.
+  void solveConstrainedGroupsInParallel(int numThreads);
+
   /// Check if the skeleton is contained in this solver
   bool containSkeleton(const dynamics::ConstSkeletonPtr& skeleton) const;
 
@@ -282,6 +387,11 @@ protected:
   /// Return true if at least one of colliding body is soft body
   bool isSoftContact(const collision::Contact& contact) const;
 
+  /// This computes the force at each of mCompliantContacts, and applies it as
+  /// an impulse. This needs to run after the constrained groups are solved,
+  /// because building their LCPs clears the constraint impulses on the bodies.
+  void solveCompliantContacts();
+
   using CollisionDetector = collision::CollisionDetector;
 
   /// Collision detector
@@ -296,6 +406,9 @@ protected:
   /// Last collision checking result
   collision::CollisionResult mCollisionResult;
 
+  /// Cumulative time spent in each phase, see getTimings()
+  ConstraintSolverTimings mTimings;
+
   /// Time step
   s_t mTimeStep;
 
@@ -308,9 +421,24 @@ protected:
   /// Soft contact constraints those are automatically created
   std::vector<SoftContactConstraintPtr> mSoftContactConstraints;
 
+  /// True if rigid contacts become mCompliantContacts, rather than
+  /// mContactConstraints
+  bool mCompliantContactEnabled = false;
+
+  /// See setCompliantContactOption()
+  CompliantContact::Option mCompliantContactOption;
+
+  /// Compliant contacts those are automatically created
+  std::vector<CompliantContact> mCompliantContacts;
+
   /// Joint limit constraints those are automatically created
   std::vector<JointLimitConstraintPtr> mJointLimitConstraints;
 
+  /// The joints at their position limits in the skeleton we're currently
+  /// creating joint constraints for. This is kept between steps only to save
+  /// reallocating it.
+  std::vector<dynamics::Joint*> mJointsAtPositionLimits;
+
   /// Servo motor constraints those are automatically created
   std::vector<ServoMotorConstraintPtr> mServoMotorConstraints;
 
@@ -330,6 +458,21 @@ protected:
   /// Constraint group list
   std::vector<ConstrainedGroup> mConstrainedGroups;
 
+  /// The root skeleton of each group this step, in the same order as
+  /// mConstrainedGroups once they're built. This is kept between steps only
+  /// to save reallocating it.
+  std::vector<dynamics::SkeletonPtr> mConstrainedGroupRoots;
+
+  /// The number of times buildConstrainedGroups() changed the grouping
+  std::size_t mNumConstrainedGroupRebuilds = 0;
+
+  /// See setNumGroupSolverThreads()
+  int mNumGroupSolverThreads = 1;
+
+  /// Solvers for each thread of a parallel solveConstrainedGroups(), made by
+  /// createGroupSolverWorker() the first time we need them
+  std::vector<std::shared_ptr<ConstraintSolver>> mGroupSolverWorkers;
+
   /// The type of gradients we want to use for backprop
   bool mGradientEnabled;
 
@@ -32,17 +32,46 @@
 
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/constraint/LCPUtils.hpp"
 #include "dart/external/odelcpsolver/lcp.h"
 
 namespace dart {
 namespace constraint {
 
+//==============================================================================
+DantzigBoxedLcpSolver::DantzigBoxedLcpSolver()
+  : mWorkspace(new dLCPWorkspace()),
+    mWarmStartEnabled(true),
+    mNumSolves(0),
+    mNumWarmStarts(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+DantzigBoxedLcpSolver::~DantzigBoxedLcpSolver() = default;
+
 //==============================================================================
 const std::string& DantzigBoxedLcpSolver::getType() const
 {
   return getStaticType();
 }
 
+//==============================================================================
+std::shared_ptr<BoxedLcpSolver> DantzigBoxedLcpSolver::clone() const
+{
+  auto solver = std::make_shared<DantzigBoxedLcpSolver>();
+  solver->setWarmStartEnabled(mWarmStartEnabled);
+  return solver;
+}
+
 //==============================================================================
 const std::string& DantzigBoxedLcpSolver::getStaticType()
 {
@@ -62,9 +91,17 @@ bool DantzigBoxedLcpSolver::solve(
     int* findex,
     bool earlyTermination)
 {
+  mNumSolves++;
+  if (mWarmStartEnabled && solveFromGuess(n, A, x, b, lo, hi, findex))
+  {
+    mNumWarmStarts++;
+    return true;
+  }
+
   try
   {
-#ifdef DART_USE_ARBITRARY_PRECISION
+#if defined(DART_USE_ARBITRARY_PRECISION) || defined(DART_USE_FLOAT32)
+    // The ODE solver only works in double precision
     int nSkip = dPAD(n);
     double* A_d = new double[n * nSkip];
     double* x_d = new double[n];
@@ -83,7 +120,17 @@ bool DantzigBoxedLcpSolver::solve(
       hi_d[i] = static_cast<double>(hi[i]);
     }
     bool ret = dSolveLCP(
-        n, A_d, x_d, b_d, nullptr, 0, lo_d, hi_d, findex, earlyTermination);
+        n,
+        A_d,
+        x_d,
+        b_d,
+        nullptr,
+        0,
+        lo_d,
+        hi_d,
+        findex,
+        earlyTermination,
+        mWorkspace.get());
     for (int i = 0; i < n; i++)
     {
       x[i] = static_cast<s_t>(x_d[i]);
@@ -95,7 +142,18 @@ bool DantzigBoxedLcpSolver::solve(
     delete[] hi_d;
     return ret;
 #else
-    return dSolveLCP(n, A, x, b, nullptr, 0, lo, hi, findex, earlyTermination);
+    return dSolveLCP(
+        n,
+        A,
+        x,
+        b,
+        nullptr,
+        0,
+        lo,
+        hi,
+        findex,
+        earlyTermination,
+        mWorkspace.get());
 #endif
   }
   catch (...)
@@ -115,5 +173,167 @@ bool DantzigBoxedLcpSolver::canSolve(int /*n*/, const s_t* /*A*/)
 }
 #endif
 
+//==============================================================================
+void DantzigBoxedLcpSolver::setWarmStartEnabled(bool enabled)
+{
+  mWarmStartEnabled = enabled;
+}
+
+//==============================================================================
+bool DantzigBoxedLcpSolver::getWarmStartEnabled() const
+{
+  return mWarmStartEnabled;
+}
+
+//==============================================================================
+std::size_t DantzigBoxedLcpSolver::getNumSolves() const
+{
+  return mNumSolves;
+}
+
+//==============================================================================
+std::size_t DantzigBoxedLcpSolver::getNumWarmStarts() const
+{
+  return mNumWarmStarts;
+}
+
+//==============================================================================
+bool DantzigBoxedLcpSolver::solveFromGuess(
+    int n,
+    const s_t* A,
+    s_t* x,
+    const s_t* b,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex) const
+{
+  if (n <= 0 || findex == nullptr)
+    return false;
+
+  // A is row major, and padded out to dPAD(n) columns
+  const Eigen::Map<
+      const Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+      0,
+      Eigen::OuterStride<>>
+      mapA(A, n, n, Eigen::OuterStride<>(dPAD(n)));
+  const Eigen::Map<const Eigen::VectorXs> mapB(b, n);
+  const Eigen::Map<const Eigen::VectorXs> mapLo(lo, n);
+  const Eigen::Map<const Eigen::VectorXs> mapHi(hi, n);
+  Eigen::Map<Eigen::VectorXs> mapX(x, n);
+  if (!mapX.allFinite())
+    return false;
+
+  const s_t tol = 1e-6;
+  const s_t inf = std::numeric_limits<s_t>::infinity();
+  auto isFriction = [&](int i) { return findex[i] >= 0 && findex[i] != i; };
+
+  // Each x(i) is either clamped, which makes it one of our unknowns, or is
+  // pinned to one of its bounds. For friction, the bounds are multiples of
+  // the normal force, which may itself be an unknown.
+  std::vector<int> clamped;
+  std::vector<int> column(n, -1);
+  Eigen::VectorXs pinned = Eigen::VectorXs::Zero(n);
+  std::vector<std::pair<int, s_t>> pinnedFriction;
+
+  for (int i = 0; i < n; i++)
+  {
+    if (isFriction(i))
+      continue;
+    if (lo[i] > -inf && x[i] <= lo[i] + tol)
+      pinned(i) = lo[i];
+    else if (hi[i] < inf && x[i] >= hi[i] - tol)
+      pinned(i) = hi[i];
+    else
+    {
+      column[i] = clamped.size();
+      clamped.push_back(i);
+    }
+  }
+  for (int i = 0; i < n; i++)
+  {
+    if (!isFriction(i))
+      continue;
+    const int normal = findex[i];
+    if (normal >= n || isFriction(normal))
+      return false;
+    const s_t upper = hi[i] * x[normal];
+    const s_t lower = lo[i] * x[normal];
+    if (upper - lower <= tol)
+    {
+      // No normal force, so no friction either
+      continue;
+    }
+    else if (x[i] >= upper - tol)
+      pinnedFriction.emplace_back(i, hi[i]);
+    else if (x[i] <= lower + tol)
+      pinnedFriction.emplace_back(i, lo[i]);
+    else
+    {
+      column[i] = clamped.size();
+      clamped.push_back(i);
+    }
+  }
+
+  // Friction pinned to a normal force that's pinned itself is a constant
+  for (const auto& friction : pinnedFriction)
+  {
+    const int normal = findex[friction.first];
+    if (column[normal] == -1)
+      pinned(friction.first) = friction.second * pinned(normal);
+  }
+
+  // Solve A(C, :) * x = b(C), substituting in x = pinned for everything that
+  // isn't clamped, and folding friction pinned to a clamped normal force into
+  // the column for that normal force
+  const int k = clamped.size();
+  Eigen::VectorXs guess = pinned;
+  if (k > 0)
+  {
+    Eigen::MatrixXs M(k, k);
+    Eigen::VectorXs rhs(k);
+    for (int row = 0; row < k; row++)
+    {
+      const int i = clamped[row];
+      for (int col = 0; col < k; col++)
+        M(row, col) = mapA(i, clamped[col]);
+      rhs(row) = b[i] - mapA.row(i).dot(pinned);
+    }
+    for (const auto& friction : pinnedFriction)
+    {
+      const int col = column[findex[friction.first]];
+      if (col == -1)
+        continue;
+      for (int row = 0; row < k; row++)
+        M(row, col) += friction.second * mapA(clamped[row], friction.first);
+    }
+
+    // The contact A matrix is often rank deficient (four contacts on the face
+    // of a box is twelve constraints on six degrees of freedom), so we want a
+    // decomposition that's happy with that
+    const Eigen::VectorXs y = M.completeOrthogonalDecomposition().solve(rhs);
+    for (int row = 0; row < k; row++)
+      guess(clamped[row]) = y(row);
+    for (const auto& friction : pinnedFriction)
+    {
+      const int col = column[findex[friction.first]];
+      if (col != -1)
+        guess(friction.first) = friction.second * y(col);
+    }
+  }
+  if (!guess.allFinite())
+    return false;
+
+  // LCPUtils marks normal forces with -1 in findex
+  Eigen::VectorXi fIndex(n);
+  for (int i = 0; i < n; i++)
+    fIndex(i) = isFriction(i) ? findex[i] : -1;
+  if (!LCPUtils::isLCPSolutionValid(
+          mapA, guess, mapB, mapHi, mapLo, fIndex, false))
+    return false;
+
+  mapX = guess;
+  return true;
+}
+
 } // namespace constraint
 } // namespace dart
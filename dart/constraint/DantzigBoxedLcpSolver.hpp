@@ -33,20 +33,48 @@
 #ifndef DART_CONSTRAINT_DANTZIGBOXEDLCPSOLVER_HPP_
 #define DART_CONSTRAINT_DANTZIGBOXEDLCPSOLVER_HPP_
 
+#include <cstddef>
+#include <memory>
+
 #include "dart/constraint/BoxedLcpSolver.hpp"
 
+struct dLCPWorkspace;
+
 namespace dart {
 namespace constraint {
 
+/// This solves boxed LCPs with the Dantzig pivoting solver from ODE.
+///
+/// The working memory for the pivoting is kept between calls, sized to the
+/// largest problem we've seen so far, so once the simulation settles into a
+/// steady number of contacts we stop allocating.
+///
+/// We also treat the `x` passed in to solve() as a guess at the solution,
+/// which BoxedLcpConstraintSolver fills with the solution from the last
+/// timestep. Before pivoting, we assume that every constraint is in the same
+/// state it was in for the guess (clamped between its bounds, or sitting at
+/// one of them), solve for the forces on the clamped constraints with a
+/// single factorization, and keep that answer if it's a valid solution to
+/// the LCP. For objects resting in steady contact that's almost always the
+/// case. If it isn't, we fall back to pivoting from scratch.
 class DantzigBoxedLcpSolver : public BoxedLcpSolver
 {
 public:
+  /// Constructor
+  DantzigBoxedLcpSolver();
+
+  /// Destructor
+  ~DantzigBoxedLcpSolver() override;
+
   // Documentation inherited.
   const std::string& getType() const override;
 
   /// Returns type for this class
   static const std::string& getStaticType();
 
+  // Documentation inherited.
+  std::shared_ptr<BoxedLcpSolver> clone() const override;
+
   // Documentation inherited.
   bool solve(
       int n,
@@ -63,6 +91,44 @@ public:
   // Documentation inherited.
   bool canSolve(int n, const s_t* A) override;
 #endif
+
+  /// This turns on or off trying the clamping set of the initial `x` before
+  /// pivoting. This is on by default.
+  void setWarmStartEnabled(bool enabled);
+
+  /// Returns true if we try the clamping set of the initial `x` before
+  /// pivoting
+  bool getWarmStartEnabled() const;
+
+  /// Returns the number of times solve() has been called
+  std::size_t getNumSolves() const;
+
+  /// Returns the number of times solve() was able to use the clamping set of
+  /// the initial `x`, and so didn't have to pivot
+  std::size_t getNumWarmStarts() const;
+
+protected:
+  /// This guesses which constraints are clamped from `x`, and solves for the
+  /// forces assuming that's right. If the result is a valid solution to the
+  /// LCP, this writes it to `x` and returns true. Otherwise this leaves `x`
+  /// untouched and returns false. This never modifies `A`, `b`, `lo` or `hi`.
+  bool solveFromGuess(
+      int n,
+      const s_t* A,
+      s_t* x,
+      const s_t* b,
+      const s_t* lo,
+      const s_t* hi,
+      const int* findex) const;
+
+  /// The working memory for the pivoting solver
+  std::unique_ptr<dLCPWorkspace> mWorkspace;
+
+  bool mWarmStartEnabled;
+
+  std::size_t mNumSolves;
+
+  std::size_t mNumWarmStarts;
 };
 
 } // namespace constraint
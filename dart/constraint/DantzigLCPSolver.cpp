@@ -175,7 +175,8 @@ void DantzigLCPSolver::solve(ConstrainedGroup* _group)
   //  std::cout << std::endl;
 
   // Solve LCP using ODE's Dantzig algorithm
-#ifdef DART_USE_ARBITRARY_PRECISION
+#if defined(DART_USE_ARBITRARY_PRECISION) || defined(DART_USE_FLOAT32)
+  // The ODE solver only works in double precision
   double* A_d = new double[n * nSkip];
   double* x_d = new double[n];
   double* b_d = new double[n];
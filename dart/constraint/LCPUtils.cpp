@@ -1,10 +1,76 @@
 #include "dart/constraint/LCPUtils.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #define MERGE_THRESHOLD 1e-4
 
+namespace {
+
+// The precision we compute residuals and accumulate refined solutions in. An
+// arbitrary precision s_t is already more accurate than anything we could
+// offer.
+#ifdef DART_USE_ARBITRARY_PRECISION
+typedef s_t ext_t;
+#else
+typedef long double ext_t;
+#endif
+typedef Eigen::Matrix<ext_t, Eigen::Dynamic, 1> VectorXext;
+typedef Eigen::Matrix<ext_t, Eigen::Dynamic, Eigen::Dynamic> MatrixXext;
+
+enum RefineClass
+{
+  REFINE_CLAMPING,
+  REFINE_AT_LO,
+  REFINE_AT_HI
+};
+
+/// This returns how badly `x` violates the LCP conditions, given the class of
+/// each index, all in extended precision
+ext_t getLCPViolation(
+    const MatrixXext& A,
+    const VectorXext& x,
+    const VectorXext& b,
+    const VectorXext& hi,
+    const VectorXext& lo,
+    const Eigen::VectorXi& fIndex,
+    const std::vector<RefineClass>& classes)
+{
+  const VectorXext w = A * x - b;
+  ext_t violation = 0;
+  for (int i = 0; i < x.size(); i++)
+  {
+    ext_t upper = hi(i);
+    ext_t lower = lo(i);
+    if (fIndex(i) != -1)
+    {
+      upper *= x(fIndex(i));
+      lower *= x(fIndex(i));
+    }
+    ext_t error = 0;
+    if (classes[i] == REFINE_CLAMPING)
+    {
+      error = std::max(
+          std::abs(w(i)), std::max(lower - x(i), x(i) - upper));
+    }
+    else if (classes[i] == REFINE_AT_LO)
+    {
+      error = std::max(-w(i), std::abs(x(i) - lower));
+    }
+    else
+    {
+      error = std::max(w(i), std::abs(x(i) - upper));
+    }
+    violation = std::max(violation, error);
+  }
+  return violation;
+}
+
+} // namespace
+
 namespace dart {
 namespace constraint {
 
@@ -79,6 +145,189 @@ bool LCPUtils::isLCPSolutionValid(
   return true;
 }
 
+//==============================================================================
+/// This polishes an approximate solution with mixed precision iterative
+/// refinement. Returns true if `mX` was replaced.
+bool LCPUtils::refineSolution(
+    const Eigen::MatrixXs& mA,
+    Eigen::VectorXs& mX,
+    const Eigen::VectorXs& mB,
+    const Eigen::VectorXs& mHi,
+    const Eigen::VectorXs& mLo,
+    const Eigen::VectorXi& mFIndex,
+    int maxIterations)
+{
+  const int n = mX.size();
+  if (n == 0 || mX.hasNaN())
+  {
+    return false;
+  }
+  // Friction has to be bounded by a normal force, and not by more friction
+  for (int i = 0; i < n; i++)
+  {
+    if (mFIndex(i) != -1 && mFIndex(mFIndex(i)) != -1)
+    {
+      return false;
+    }
+  }
+
+  const MatrixXext A = mA.block(0, 0, n, n).cast<ext_t>();
+  const VectorXext b = mB.cast<ext_t>();
+  const VectorXext hi = mHi.cast<ext_t>();
+  const VectorXext lo = mLo.cast<ext_t>();
+  const VectorXext x = mX.cast<ext_t>();
+  const VectorXext w = A * x - b;
+
+  // The original solver's errors are far bigger than ours, so we classify
+  // with a tolerance relative to the size of the problem
+  const ext_t scale = std::max<ext_t>(
+      1, std::max(b.cwiseAbs().maxCoeff(), x.cwiseAbs().maxCoeff()));
+  const ext_t tol = 1e-6 * scale;
+
+  std::vector<RefineClass> classes(n, REFINE_CLAMPING);
+  for (int i = 0; i < n; i++)
+  {
+    ext_t upper = hi(i);
+    ext_t lower = lo(i);
+    if (mFIndex(i) != -1)
+    {
+      upper *= x(mFIndex(i));
+      lower *= x(mFIndex(i));
+    }
+    // Friction on a (near) zero normal force is pinned to it
+    if (std::abs(lower) < tol && std::abs(upper) < tol
+        && std::abs(x(i)) < tol)
+    {
+      classes[i] = REFINE_AT_LO;
+    }
+    // A clearly non-zero velocity means the force is pressed against a bound,
+    // even if the original solver left it a little way off (Dantzig fixes
+    // friction bounds from a stale guess at the normal force, for instance)
+    else if (w(i) > tol)
+    {
+      classes[i] = REFINE_AT_LO;
+    }
+    else if (w(i) < -tol && std::isfinite((double)upper))
+    {
+      classes[i] = REFINE_AT_HI;
+    }
+    else if (std::abs(x(i) - lower) < tol)
+    {
+      classes[i] = REFINE_AT_LO;
+    }
+    else if (std::abs(x(i) - upper) < tol)
+    {
+      classes[i] = REFINE_AT_HI;
+    }
+  }
+  // We write the solution as x = E * z + c, where z are the clamping forces.
+  // Forces at a bound are constants, except friction, which is a multiple of
+  // its normal force.
+  std::vector<int> clamping;
+  std::vector<int> clampingIndex(n, -1);
+  for (int i = 0; i < n; i++)
+  {
+    if (classes[i] == REFINE_CLAMPING)
+    {
+      clampingIndex[i] = clamping.size();
+      clamping.push_back(i);
+    }
+  }
+  const int numClamping = clamping.size();
+  MatrixXext E = MatrixXext::Zero(n, numClamping);
+  VectorXext c = VectorXext::Zero(n);
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      // Normal forces go first, so friction can look at them
+      if ((pass == 0) != (mFIndex(i) == -1))
+      {
+        continue;
+      }
+      if (classes[i] == REFINE_CLAMPING)
+      {
+        E(i, clampingIndex[i]) = 1;
+        continue;
+      }
+      const ext_t bound = classes[i] == REFINE_AT_LO ? lo(i) : hi(i);
+      if (mFIndex(i) == -1)
+      {
+        c(i) = bound;
+      }
+      else
+      {
+        E.row(i) = bound * E.row(mFIndex(i));
+        c(i) = bound * c(mFIndex(i));
+      }
+    }
+  }
+
+  VectorXext z = VectorXext::Zero(numClamping);
+  for (int k = 0; k < numClamping; k++)
+  {
+    z(k) = x(clamping[k]);
+  }
+
+  if (numClamping > 0)
+  {
+    // The correction only needs to be roughly right, so we factor once in s_t
+    const MatrixXext AE = A * E;
+    Eigen::MatrixXs M(numClamping, numClamping);
+    for (int k = 0; k < numClamping; k++)
+    {
+      for (int j = 0; j < numClamping; j++)
+      {
+        M(k, j) = (s_t)AE(clamping[k], j);
+      }
+    }
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXs> factored(M);
+
+    ext_t lastResidual = std::numeric_limits<ext_t>::infinity();
+    for (int iteration = 0; iteration < maxIterations; iteration++)
+    {
+      const VectorXext full = A * (E * z + c) - b;
+      VectorXext residual(numClamping);
+      for (int k = 0; k < numClamping; k++)
+      {
+        residual(k) = -full(clamping[k]);
+      }
+      const ext_t residualNorm = residual.cwiseAbs().maxCoeff();
+      if (residualNorm == 0 || residualNorm >= lastResidual)
+      {
+        break;
+      }
+      lastResidual = residualNorm;
+      Eigen::VectorXs rhs(numClamping);
+      for (int k = 0; k < numClamping; k++)
+      {
+        rhs(k) = (s_t)residual(k);
+      }
+      const Eigen::VectorXs step = factored.solve(rhs);
+      if (step.hasNaN())
+      {
+        return false;
+      }
+      z += step.cast<ext_t>();
+    }
+  }
+
+  const VectorXext refined = E * z + c;
+  const ext_t before = getLCPViolation(A, x, b, hi, lo, mFIndex, classes);
+  const ext_t after = getLCPViolation(A, refined, b, hi, lo, mFIndex, classes);
+  // If we guessed the classes wrong, the refined solution will have pushed
+  // some force out of its bounds, or some velocity the wrong way
+  if (!(after <= tol) || !(after <= before))
+  {
+    return false;
+  }
+  for (int i = 0; i < n; i++)
+  {
+    mX(i) = (s_t)refined(i);
+  }
+  return true;
+}
+
 //==============================================================================
 /// This applies a simple algorithm to guess the solution to the LCP problem.
 /// It's not guaranteed to be correct, but it often can be if there is no
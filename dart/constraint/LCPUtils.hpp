@@ -22,6 +22,26 @@ public:
       const Eigen::VectorXi& mFIndex,
       bool ignoreFrictionIndices);
 
+  /// This polishes an approximate solution `mX` (say, from Dantzig or PGS
+  /// running in s_t) with mixed precision iterative refinement. We classify
+  /// each index as clamping or at one of its bounds using the residual
+  /// A*x - b computed in extended precision, then repeatedly compute the
+  /// residual of the clamping rows in extended precision and correct the
+  /// clamping forces with a solve in s_t, accumulating the result in extended
+  /// precision. Friction bounds follow their normal forces throughout.
+  ///
+  /// The refined solution only replaces `mX` if it keeps the same
+  /// classification and violates the LCP conditions by no more than the
+  /// original. Returns true if `mX` was replaced.
+  static bool refineSolution(
+      const Eigen::MatrixXs& mA,
+      Eigen::VectorXs& mX,
+      const Eigen::VectorXs& mB,
+      const Eigen::VectorXs& mHi,
+      const Eigen::VectorXs& mLo,
+      const Eigen::VectorXi& mFIndex,
+      int maxIterations = 5);
+
   /// This applies a simple algorithm to guess the solution to the LCP problem.
   /// It's not guaranteed to be correct, but it often can be if there is no
   /// sliding friction on this timestep.
@@ -68,6 +68,14 @@ const std::string& PgsBoxedLcpSolver::getType() const
   return getStaticType();
 }
 
+//==============================================================================
+std::shared_ptr<BoxedLcpSolver> PgsBoxedLcpSolver::clone() const
+{
+  auto solver = std::make_shared<PgsBoxedLcpSolver>();
+  solver->setOption(mOption);
+  return solver;
+}
+
 //==============================================================================
 const std::string& PgsBoxedLcpSolver::getStaticType()
 {
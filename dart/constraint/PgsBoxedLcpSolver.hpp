@@ -66,6 +66,9 @@ public:
   /// Returns type for this class
   static const std::string& getStaticType();
 
+  // Documentation inherited.
+  std::shared_ptr<BoxedLcpSolver> clone() const override;
+
   // Documentation inherited.
   bool solve(
       int n,
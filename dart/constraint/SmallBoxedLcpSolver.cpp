@@ -0,0 +1,352 @@
+#include "dart/constraint/SmallBoxedLcpSolver.hpp"
+
+#include <array>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include "dart/external/odelcpsolver/matrix.h"
+
+// The biggest problem we'll take. Past this, the fixed-size types get big
+// enough that a general solver is just as fast.
+#define SMALL_LCP_MAX_DIMENSION 16
+
+namespace dart {
+namespace constraint {
+
+namespace {
+
+/// Which side of complementarity we're guessing a row is on
+enum RowState
+{
+  ROW_FREE,
+  ROW_AT_LO,
+  ROW_AT_HI
+};
+
+} // namespace
+
+//==============================================================================
+SmallBoxedLcpSolver::Option::Option(int maxIteration, s_t tolerance)
+  : mMaxIteration(maxIteration), mTolerance(tolerance)
+{
+  // Do nothing
+}
+
+//==============================================================================
+SmallBoxedLcpSolver::SmallBoxedLcpSolver(const Option& option)
+  : mOption(option), mLastNumIterations(0)
+{
+  // Do nothing
+}
+
+//==============================================================================
+const std::string& SmallBoxedLcpSolver::getType() const
+{
+  return getStaticType();
+}
+
+//==============================================================================
+const std::string& SmallBoxedLcpSolver::getStaticType()
+{
+  static const std::string type = "SmallBoxedLcpSolver";
+  return type;
+}
+
+//==============================================================================
+std::shared_ptr<BoxedLcpSolver> SmallBoxedLcpSolver::clone() const
+{
+  return std::make_shared<SmallBoxedLcpSolver>(mOption);
+}
+
+//==============================================================================
+bool SmallBoxedLcpSolver::solve(
+    int n,
+    s_t* A,
+    s_t* x,
+    s_t* b,
+    int nub,
+    s_t* lo,
+    s_t* hi,
+    int* findex,
+    bool /*earlyTermination*/)
+{
+  mLastNumIterations = 0;
+
+  switch (n)
+  {
+    case 0:
+      return true;
+    case 1:
+      return solveFixedSize<1>(A, x, b, nub, lo, hi, findex);
+    case 2:
+      return solveFixedSize<2>(A, x, b, nub, lo, hi, findex);
+    case 3:
+      return solveFixedSize<3>(A, x, b, nub, lo, hi, findex);
+    case 4:
+      return solveFixedSize<4>(A, x, b, nub, lo, hi, findex);
+    case 5:
+      return solveFixedSize<5>(A, x, b, nub, lo, hi, findex);
+    case 6:
+      return solveFixedSize<6>(A, x, b, nub, lo, hi, findex);
+    case 7:
+      return solveFixedSize<7>(A, x, b, nub, lo, hi, findex);
+    case 8:
+      return solveFixedSize<8>(A, x, b, nub, lo, hi, findex);
+    case 9:
+      return solveFixedSize<9>(A, x, b, nub, lo, hi, findex);
+    case 10:
+      return solveFixedSize<10>(A, x, b, nub, lo, hi, findex);
+    case 11:
+      return solveFixedSize<11>(A, x, b, nub, lo, hi, findex);
+    case 12:
+      return solveFixedSize<12>(A, x, b, nub, lo, hi, findex);
+    case 13:
+      return solveFixedSize<13>(A, x, b, nub, lo, hi, findex);
+    case 14:
+      return solveFixedSize<14>(A, x, b, nub, lo, hi, findex);
+    case 15:
+      return solveFixedSize<15>(A, x, b, nub, lo, hi, findex);
+    case 16:
+      return solveFixedSize<16>(A, x, b, nub, lo, hi, findex);
+    default:
+      return false;
+  }
+}
+
+//==============================================================================
+template <int N>
+bool SmallBoxedLcpSolver::solveFixedSize(
+    const s_t* A,
+    s_t* x,
+    const s_t* b,
+    int nub,
+    const s_t* lo,
+    const s_t* hi,
+    const int* findex)
+{
+  static_assert(N <= SMALL_LCP_MAX_DIMENSION, "N is too big");
+
+  using MatrixN = Eigen::Matrix<s_t, N, N>;
+  using VectorN = Eigen::Matrix<s_t, N, 1>;
+  // These hold the free rows, so they're dynamically sized, but never bigger
+  // than N, which keeps them on the stack
+  using ReducedMatrix
+      = Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, 0, N, N>;
+  using ReducedVector = Eigen::Matrix<s_t, Eigen::Dynamic, 1, 0, N, 1>;
+  using ExpansionMatrix = Eigen::Matrix<s_t, N, Eigen::Dynamic, 0, N, N>;
+
+  const int nskip = dPAD(N);
+  const s_t tol = mOption.mTolerance;
+
+  MatrixN fullA;
+  VectorN fullB;
+  VectorN guess;
+  for (int i = 0; i < N; i++)
+  {
+    for (int j = 0; j < N; j++)
+      fullA(i, j) = A[nskip * i + j];
+    fullB(i) = b[i];
+    guess(i) = x[i];
+  }
+
+  // If we've been handed a warm start, guess that every row is on the same
+  // side as it was there. Otherwise guess that every row is free, which is
+  // right for contacts that are resting and sticking.
+  std::array<RowState, N> state;
+  state.fill(ROW_FREE);
+  if (!guess.isZero(0))
+  {
+    for (int i = nub; i < N; i++)
+    {
+      s_t rowLo = lo[i];
+      s_t rowHi = hi[i];
+      if (findex[i] >= 0)
+      {
+        rowLo *= guess(findex[i]);
+        rowHi *= guess(findex[i]);
+      }
+      if (guess(i) <= rowLo + tol && std::isfinite(rowLo))
+        state[i] = ROW_AT_LO;
+      else if (guess(i) >= rowHi - tol && std::isfinite(rowHi))
+        state[i] = ROW_AT_HI;
+    }
+  }
+
+  for (int iter = 0; iter < mOption.mMaxIteration; iter++)
+  {
+    mLastNumIterations = iter + 1;
+
+    std::array<int, N> freeIndex;
+    int numFree = 0;
+    for (int i = 0; i < N; i++)
+      freeIndex[i] = state[i] == ROW_FREE ? numFree++ : -1;
+
+    // Write x = E * z + c, where z is the free rows. Rows held at a bound are
+    // constant, unless they're friction rows whose bound scales with a free
+    // normal row.
+    ExpansionMatrix E = ExpansionMatrix::Zero(N, numFree);
+    VectorN c = VectorN::Zero();
+    bool symmetric = true;
+    for (int i = 0; i < N; i++)
+    {
+      if (state[i] == ROW_FREE)
+        E(i, freeIndex[i]) = 1.0;
+      else if (findex[i] < 0)
+        c(i) = state[i] == ROW_AT_LO ? lo[i] : hi[i];
+    }
+    for (int i = 0; i < N; i++)
+    {
+      if (state[i] == ROW_FREE || findex[i] < 0)
+        continue;
+      const s_t scale = state[i] == ROW_AT_LO ? lo[i] : hi[i];
+      const int normal = findex[i];
+      if (state[normal] == ROW_FREE)
+      {
+        E(i, freeIndex[normal]) = scale;
+        symmetric = false;
+      }
+      else
+      {
+        c(i) = scale * c(normal);
+      }
+    }
+
+    // Every free row needs w = A * x - b = 0
+    ReducedMatrix M(numFree, numFree);
+    ReducedVector rhs(numFree);
+    for (int i = 0; i < N; i++)
+    {
+      if (state[i] != ROW_FREE)
+        continue;
+      M.row(freeIndex[i]) = fullA.row(i) * E;
+      rhs(freeIndex[i]) = fullB(i) - fullA.row(i).dot(c);
+    }
+
+    VectorN nextX = c;
+    if (numFree > 0)
+    {
+      ReducedVector z;
+      if (symmetric)
+      {
+        // With redundant contacts, M is only semidefinite. LDLT reports that
+        // as a numerical issue, but its solve() still gives us a solution
+        // whenever there is one, which we check for below.
+        z = Eigen::LDLT<ReducedMatrix>(M).solve(rhs);
+      }
+      else
+      {
+        z = Eigen::PartialPivLU<ReducedMatrix>(M).solve(rhs);
+      }
+
+      // If M was singular, and this guess asks for something out of its
+      // range, there's no solution to this guess, so we leave the problem to
+      // a more careful solver
+      if (!z.allFinite()
+          || (M * z - rhs).norm() > tol * (1.0 + rhs.norm()) * N)
+        return false;
+
+      nextX += E * z;
+    }
+    const VectorN w = fullA * nextX - fullB;
+
+    // Flip every row whose guess broke complementarity
+    bool changed = false;
+    for (int i = nub; i < N; i++)
+    {
+      s_t rowLo = lo[i];
+      s_t rowHi = hi[i];
+      if (findex[i] >= 0)
+      {
+        rowLo *= nextX(findex[i]);
+        rowHi *= nextX(findex[i]);
+      }
+
+      if (state[i] == ROW_FREE)
+      {
+        if (nextX(i) < rowLo - tol)
+        {
+          state[i] = ROW_AT_LO;
+          changed = true;
+        }
+        else if (nextX(i) > rowHi + tol)
+        {
+          state[i] = ROW_AT_HI;
+          changed = true;
+        }
+      }
+      // A row pinned between two bounds of 0 (like friction with no normal
+      // force) is allowed to have velocity in either direction
+      else if (std::abs(rowLo) < tol && std::abs(rowHi) < tol)
+      {
+        continue;
+      }
+      else if (
+          (state[i] == ROW_AT_LO && w(i) < -tol)
+          || (state[i] == ROW_AT_HI && w(i) > tol))
+      {
+        state[i] = ROW_FREE;
+        changed = true;
+      }
+    }
+
+    if (!changed)
+    {
+      for (int i = 0; i < N; i++)
+        x[i] = nextX(i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+#ifndef NDEBUG
+//==============================================================================
+bool SmallBoxedLcpSolver::canSolve(int n, const s_t* A)
+{
+  const int nskip = dPAD(n);
+
+  // Return false if A is too big, or nonsymmetric
+  if (n > SMALL_LCP_MAX_DIMENSION)
+    return false;
+
+  for (auto i = 0; i < n; ++i)
+  {
+    for (auto j = 0; j < n; ++j)
+    {
+      if (std::abs(A[nskip * i + j] - A[nskip * j + i]) > mOption.mTolerance)
+        return false;
+    }
+  }
+
+  return true;
+}
+#endif
+
+//==============================================================================
+int SmallBoxedLcpSolver::getMaxDimension()
+{
+  return SMALL_LCP_MAX_DIMENSION;
+}
+
+//==============================================================================
+void SmallBoxedLcpSolver::setOption(const SmallBoxedLcpSolver::Option& option)
+{
+  mOption = option;
+}
+
+//==============================================================================
+const SmallBoxedLcpSolver::Option& SmallBoxedLcpSolver::getOption() const
+{
+  return mOption;
+}
+
+//==============================================================================
+int SmallBoxedLcpSolver::getLastNumIterations() const
+{
+  return mLastNumIterations;
+}
+
+} // namespace constraint
+} // namespace dart
@@ -0,0 +1,103 @@
+#ifndef DART_CONSTRAINT_SMALLBOXEDLCPSOLVER_HPP_
+#define DART_CONSTRAINT_SMALLBOXEDLCPSOLVER_HPP_
+
+#include "dart/constraint/BoxedLcpSolver.hpp"
+
+namespace dart {
+namespace constraint {
+
+/// This is a direct LCP solver for small problems, like the handful of rows
+/// from a couple of foot contacts, where the fixed overhead of Dantzig
+/// pivoting dominates.
+///
+/// Rather than pivoting one row at a time, we guess which rows are free
+/// (w = 0) and which are held at one of their bounds, solve for all the free
+/// rows at once with a single Cholesky (LDLT) factorization, and then check
+/// complementarity. Every row whose guess turned out wrong gets flipped, and
+/// we try again. When friction rows are held at a bound that scales with a
+/// free normal row, the reduced system isn't symmetric anymore, so we fall
+/// back to an LU factorization for that guess.
+///
+/// Each problem size up to getMaxDimension() gets its own fixed-size Eigen
+/// types, so a solve never touches the heap. Bigger problems, and problems
+/// where the guesses don't settle within the iteration limit, return false
+/// with x untouched, so this is meant to be tried ahead of a general solver.
+class SmallBoxedLcpSolver : public BoxedLcpSolver
+{
+public:
+  struct Option
+  {
+    /// The most guesses at the active set we'll try before giving up
+    int mMaxIteration;
+
+    /// How far x can be outside its bounds, or w can be on the wrong side of
+    /// 0, before we count it as breaking complementarity
+    s_t mTolerance;
+
+    Option(int maxIteration = 10, s_t tolerance = 1e-9);
+  };
+
+  /// Constructor
+  SmallBoxedLcpSolver(const Option& option = Option());
+
+  // Documentation inherited.
+  const std::string& getType() const override;
+
+  /// Returns type for this class
+  static const std::string& getStaticType();
+
+  // Documentation inherited.
+  std::shared_ptr<BoxedLcpSolver> clone() const override;
+
+  // Documentation inherited.
+  bool solve(
+      int n,
+      s_t* A,
+      s_t* x,
+      s_t* b,
+      int nub,
+      s_t* lo,
+      s_t* hi,
+      int* findex,
+      bool earlyTermination) override;
+
+#ifndef NDEBUG
+  // Documentation inherited.
+  bool canSolve(int n, const s_t* A) override;
+#endif
+
+  /// Returns the biggest n that solve() will attempt
+  static int getMaxDimension();
+
+  /// Sets options
+  void setOption(const Option& option);
+
+  /// Returns options.
+  const Option& getOption() const;
+
+  /// Returns the number of guesses the last solve() took, or 0 if it didn't
+  /// attempt the problem
+  int getLastNumIterations() const;
+
+protected:
+  /// This solves a problem of exactly N rows. A is padded the same way as it
+  /// is for solve().
+  template <int N>
+  bool solveFixedSize(
+      const s_t* A,
+      s_t* x,
+      const s_t* b,
+      int nub,
+      const s_t* lo,
+      const s_t* hi,
+      const int* findex);
+
+  Option mOption;
+
+  int mLastNumIterations;
+};
+
+} // namespace constraint
+} // namespace dart
+
+#endif // DART_CONSTRAINT_SMALLBOXEDLCPSOLVER_HPP_
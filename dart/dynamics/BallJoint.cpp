@@ -312,7 +312,16 @@ void BallJoint::integratePositions(s_t dt)
   const Eigen::Vector3s& q = getPositionsStatic();
   const Eigen::Vector3s& dq = getVelocitiesStatic();
 
-  setPositionsStatic(integratePositionsExplicit(q, dq, dt));
+  // This matches integratePositionsExplicit(), but stays in fixed-size types
+#ifdef DART_USE_IDENTITY_JACOBIAN
+  const Eigen::Matrix3s Rnext
+      = convertToRotation(q) * convertToRotation(dq * dt);
+#else
+  const Eigen::Matrix3s S = math::so3RightJacobian(q);
+  const Eigen::Matrix3s Rnext
+      = convertToRotation(q) * convertToRotation(S * dq * dt);
+#endif
+  setPositionsStatic(convertToPositions(Rnext));
 }
 
 //==============================================================================
@@ -516,6 +516,12 @@ void BodyNode::setScale(Eigen::Vector3s newScale, bool silentlyClamp)
     }
   }
 
+  // The fitters call this for every body on every iteration, usually with
+  // only a few scales actually changing, so don't touch the joints or shapes
+  // (and dirty their caches) unless we have to
+  if (newScale == mScale)
+    return;
+
   Eigen::Vector3s ratio = newScale.cwiseQuotient(mScale);
 
   // Rescale inertia, COM, mass
@@ -1263,18 +1269,33 @@ BodyNode::MovingVertex::MovingVertex(
 std::vector<BodyNode::MovingVertex> BodyNode::getMovingVerticesInWorldSpace(
     int timestep) const
 {
-  std::vector<BodyNode::MovingVertex> movingVertices;
-  std::vector<Eigen::Vector3s> vertices = getLocalVertices();
+  return getMovingVerticesInWorldSpace(getLocalVertices(), timestep);
+}
 
-  for (int i = 0; i < vertices.size(); i++)
+//==============================================================================
+/// This is getMovingVerticesInWorldSpace(), but for vertices that the caller
+/// already got from getLocalVertices(), which saves re-reading the meshes
+/// when this is called on every frame of a trajectory
+std::vector<BodyNode::MovingVertex> BodyNode::getMovingVerticesInWorldSpace(
+    const std::vector<Eigen::Vector3s>& localVertices, int timestep) const
+{
+  // This is getLinearVelocity() and getLinearAcceleration() at each vertex,
+  // but only looks up the body's transform, velocity and acceleration once
+  const Eigen::Isometry3s& T = getWorldTransform();
+  const Eigen::Matrix3s R = T.linear();
+  const Eigen::Vector6s& V = getSpatialVelocity();
+  const Eigen::Vector6s& A = getSpatialAcceleration();
+  const Eigen::Vector3s w = V.head<3>();
+
+  std::vector<BodyNode::MovingVertex> movingVertices;
+  movingVertices.reserve(localVertices.size());
+  for (const Eigen::Vector3s& vert : localVertices)
   {
-    Eigen::Vector3s vert = vertices[i];
-    Eigen::Vector3s worldPos = getWorldTransform() * vert;
-    Eigen::Vector3s worldVel
-        = getLinearVelocity(vert, Frame::World(), Frame::World());
-    Eigen::Vector3s worldAccel
-        = getLinearAcceleration(vert, Frame::World(), Frame::World());
-    movingVertices.emplace_back(worldPos, worldVel, worldAccel, this, timestep);
+    Eigen::Vector3s localVel = V.tail<3>() + w.cross(vert);
+    Eigen::Vector3s localAccel
+        = A.tail<3>() + A.head<3>().cross(vert) + w.cross(localVel);
+    movingVertices.emplace_back(
+        T * vert, R * localVel, R * localAccel, this, timestep);
   }
 
   return movingVertices;
@@ -1928,7 +1949,11 @@ void BodyNode::dirtyArticulatedInertia()
 {
   const SkeletonPtr& skel = getSkeleton();
   if (skel)
-    skel->dirtyArticulatedInertia(mTreeIndex);
+  {
+    // Every change to our inertia comes through here
+    skel->mInertiaVersion++;
+    skel->dirtySubtreeArticulatedInertia(this);
+  }
 }
 
 //==============================================================================
@@ -2434,10 +2459,9 @@ void BodyNode::aggregateGravityForceVector(
   std::size_t nGenCoords = mParentJoint->getNumDofs();
   if (nGenCoords > 0)
   {
-    Eigen::VectorXs g
-        = -(mParentJoint->getRelativeJacobian().transpose() * mG_F);
     std::size_t iStart = mParentJoint->getIndexInTree(0);
-    _g.segment(iStart, nGenCoords) = g;
+    _g.segment(iStart, nGenCoords).noalias()
+        = -(mParentJoint->getRelativeJacobian().transpose() * mG_F);
   }
 }
 
@@ -2488,10 +2512,9 @@ void BodyNode::aggregateCombinedVector(
   std::size_t nGenCoords = mParentJoint->getNumDofs();
   if (nGenCoords > 0)
   {
-    Eigen::VectorXs Cg
-        = mParentJoint->getRelativeJacobian().transpose() * mCg_F;
     std::size_t iStart = mParentJoint->getIndexInTree(0);
-    _Cg.segment(iStart, nGenCoords) = Cg;
+    _Cg.segment(iStart, nGenCoords).noalias()
+        = mParentJoint->getRelativeJacobian().transpose() * mCg_F;
   }
 }
 
@@ -2511,10 +2534,9 @@ void BodyNode::aggregateExternalForces(Eigen::VectorXs& _Fext)
   std::size_t nGenCoords = mParentJoint->getNumDofs();
   if (nGenCoords > 0)
   {
-    Eigen::VectorXs Fext
-        = mParentJoint->getRelativeJacobian().transpose() * mFext_F;
     std::size_t iStart = mParentJoint->getIndexInTree(0);
-    _Fext.segment(iStart, nGenCoords) = Fext;
+    _Fext.segment(iStart, nGenCoords).noalias()
+        = mParentJoint->getRelativeJacobian().transpose() * mFext_F;
   }
 }
 
@@ -2551,8 +2573,10 @@ void BodyNode::updateMassMatrix()
   std::size_t dof = mParentJoint->getNumDofs();
   if (dof > 0)
   {
-    mM_dV.noalias() += mParentJoint->getRelativeJacobian()
-                       * mParentJoint->getAccelerations();
+    // Go one column at a time, since getAccelerations() would allocate
+    const math::Jacobian& J = mParentJoint->getRelativeJacobian();
+    for (std::size_t i = 0; i < dof; i++)
+      mM_dV.noalias() += J.col(i) * mParentJoint->getAcceleration(i);
     assert(!math::isNan(mM_dV));
   }
   if (mParentBodyNode)
@@ -673,6 +673,13 @@ public:
   std::vector<MovingVertex> getMovingVerticesInWorldSpace(
       int timestep = -1) const;
 
+  /// This is getMovingVerticesInWorldSpace(), but for vertices that the caller
+  /// already got from getLocalVertices(), which saves re-reading the meshes
+  /// when this is called on every frame of a trajectory
+  std::vector<MovingVertex> getMovingVerticesInWorldSpace(
+      const std::vector<Eigen::Vector3s>& localVertices,
+      int timestep = -1) const;
+
   DART_BAKE_SPECIALIZED_NODE_DECLARATIONS(EndEffector)
 
   /// Create an EndEffector attached to this BodyNode. Pass an
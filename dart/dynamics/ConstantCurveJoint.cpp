@@ -585,6 +585,212 @@ ConstantCurveJoint::getRelativeJacobianDerivWrtPositionStatic(
   return J_dFirst;
 }
 
+//==============================================================================
+Eigen::Matrix<s_t, 6, 4> ConstantCurveJoint::getRelativeJacobianTimeDerivStatic(
+    const Eigen::Vector4s& rawPos, const Eigen::Vector4s& vel) const
+{
+  // This follows getRelativeJacobianDerivWrtPositionStatic() exactly, except
+  // that every "_dFirst" term there is replaced by its velocity-weighted sum
+  // over all four DOFs (the "_dt" terms here), so we only walk the formulas
+  // once instead of once per DOF.
+
+  Eigen::Vector4s pos = rawPos + mNeutralPos;
+
+  Eigen::Isometry3s rot = EulerJoint::convertToTransform(
+      pos.head<3>(), EulerJoint::AxisOrder::XZY, mFlipAxisMap.head<3>());
+
+  Eigen::Isometry3s identity = Eigen::Isometry3s::Identity();
+  Eigen::Matrix<s_t, 6, 4> J = Eigen::Matrix<s_t, 6, 4>::Zero();
+  J.block<6, 3>(0, 0) = EulerJoint::computeRelativeJacobianStatic(
+      pos.head<3>(),
+      EulerJoint::AxisOrder::XZY,
+      mFlipAxisMap.head<3>(),
+      identity);
+  Eigen::Matrix<s_t, 6, 4> dJ = Eigen::Matrix<s_t, 6, 4>::Zero();
+  dJ.block<6, 3>(0, 0) = EulerJoint::computeRelativeJacobianTimeDerivStatic(
+      pos.head<3>(),
+      vel.head<3>(),
+      EulerJoint::AxisOrder::XZY,
+      mFlipAxisMap.head<3>(),
+      identity);
+
+  s_t scale = this->getChildScale()(1);
+  s_t d = pos(3) * scale;
+  s_t d_dt = vel(3) * scale;
+
+  // Remember, this is X,*Z*,Y
+
+  s_t cx = cos(pos(0));
+  s_t sx = sin(pos(0));
+  s_t cz = cos(pos(1));
+  s_t sz = sin(pos(1));
+
+  Eigen::Vector3s linearAngle = Eigen::Vector3s(-sz, cx * cz, cz * sx);
+
+  Eigen::Matrix<s_t, 3, 4> dLinearAngle = Eigen::Matrix<s_t, 3, 4>::Zero();
+  dLinearAngle.col(0) = Eigen::Vector3s(0, -sx * cz, cz * cx);
+  dLinearAngle.col(1) = Eigen::Vector3s(-cz, -cx * sz, -sz * sx);
+
+  Eigen::Vector3s linearAngle_dt = dLinearAngle * vel;
+  Eigen::Matrix<s_t, 3, 4> dLinearAngle_dt = Eigen::Matrix<s_t, 3, 4>::Zero();
+  dLinearAngle_dt.col(0) = vel(0) * Eigen::Vector3s(0, -cx * cz, cz * -sx)
+                           + vel(1) * Eigen::Vector3s(0, -sx * -sz, -sz * cx);
+  dLinearAngle_dt.col(1) = vel(0) * Eigen::Vector3s(0, sx * sz, -sz * cx)
+                           + vel(1) * Eigen::Vector3s(sz, -cx * cz, -cz * sx);
+
+  s_t sinTheta
+      = sqrt(linearAngle(0) * linearAngle(0) + linearAngle(2) * linearAngle(2));
+
+  if (sinTheta < 0.001)
+  {
+    // Near very vertical angles, don't worry about the bend, just approximate
+    // with an euler joint
+    Eigen::Isometry3s bentRod = Eigen::Isometry3s::Identity();
+    bentRod.translation() = Eigen::Vector3s::UnitY() * d;
+    bentRod = rot * bentRod;
+
+    // The length column normalizes each DOF's translation derivative
+    // separately, so that one has to be summed DOF by DOF
+    Eigen::Vector3s translation_dt = Eigen::Vector3s::Zero();
+    Eigen::Vector3s lengthCol_dt = Eigen::Vector3s::Zero();
+    for (int i = 0; i < 3; i++)
+    {
+      Eigen::Vector3s translation_di
+          = rot.linear() * J.block<3, 1>(0, i).cross(bentRod.translation());
+      translation_dt += vel(i) * translation_di;
+      if (translation_di.norm() > 0.003)
+      {
+        lengthCol_dt += vel(i) * translation_di.normalized() * scale;
+      }
+    }
+    translation_dt
+        += vel(3) * rot.linear() * bentRod.translation().normalized() * scale;
+
+    for (int i = 0; i < 3; i++)
+    {
+      dJ.block<3, 1>(3, i)
+          = 0.5
+            * (dJ.block<3, 1>(0, i).cross(bentRod.translation())
+               + J.block<3, 1>(0, i).cross(translation_dt));
+    }
+    dJ.block<3, 1>(3, 3) = lengthCol_dt;
+  }
+  else
+  {
+    Eigen::Matrix3s rot_dt = Eigen::Matrix3s::Zero();
+    for (int i = 0; i < 3; i++)
+    {
+      rot_dt += vel(i) * math::eulerXZYToMatrixGrad(pos.head<3>(), i);
+    }
+
+    s_t sumSq
+        = linearAngle(0) * linearAngle(0) + linearAngle(2) * linearAngle(2);
+    s_t sumSq_dt = 2 * linearAngle(0) * linearAngle_dt(0)
+                   + 2 * linearAngle(2) * linearAngle_dt(2);
+    s_t part1 = 0.5 / sqrt(sumSq);
+    s_t part1_dt = (-0.25 / pow(sumSq, 1.5)) * sumSq_dt;
+
+    Eigen::Vector4s dSinTheta = Eigen::Vector4s::Zero();
+    Eigen::Vector4s dSinTheta_dt = Eigen::Vector4s::Zero();
+    for (int i = 0; i < 3; i++)
+    {
+      s_t part2 = (2 * linearAngle(0) * dLinearAngle(0, i)
+                   + 2 * linearAngle(2) * dLinearAngle(2, i));
+      dSinTheta(i) = part1 * part2;
+
+      s_t part2_dt = (2 * linearAngle(0) * dLinearAngle_dt(0, i)
+                      + 2 * linearAngle_dt(0) * dLinearAngle(0, i)
+                      + 2 * linearAngle(2) * dLinearAngle_dt(2, i)
+                      + 2 * linearAngle_dt(2) * dLinearAngle(2, i));
+      dSinTheta_dt(i) = part1_dt * part2 + part1 * part2_dt;
+    }
+    s_t sinTheta_dt = part1 * sumSq_dt;
+
+    // Compute the bend as a function of the angle from vertical
+    s_t theta = asin(sinTheta);
+    s_t cosTheta = cos(theta);
+    s_t sinThetaExact = sin(theta);
+    s_t invCos = 1.0 / sqrt(1.0 - (sinTheta * sinTheta));
+    s_t theta_dt = invCos * sinTheta_dt;
+
+    Eigen::Vector4s dTheta = invCos * dSinTheta;
+    Eigen::Vector4s dTheta_dt
+        = (1.0 / pow(1.0 - (sinTheta * sinTheta), 1.5)) * sinTheta
+              * sinTheta_dt * dSinTheta
+          + invCos * dSinTheta_dt;
+
+    s_t r = (d / theta);
+    s_t r_dt = (-d / (theta * theta)) * theta_dt + (d_dt / theta);
+
+    Eigen::Vector4s dR = Eigen::Vector4s::Zero();
+    dR.segment<3>(0) = (-d / (theta * theta)) * dTheta.segment<3>(0);
+    dR(3) = 1.0 / theta;
+
+    Eigen::Vector4s dR_dt = Eigen::Vector4s::Zero();
+    dR_dt.segment<3>(0)
+        = (-d_dt / (theta * theta)) * dTheta.segment<3>(0)
+          + (2 * d / (theta * theta * theta)) * theta_dt * dTheta.segment<3>(0)
+          + (-d / (theta * theta)) * dTheta_dt.segment<3>(0);
+    dR_dt(3) = -theta_dt / (theta * theta);
+
+    s_t horizontalDist = r - r * cosTheta;
+    s_t horizontalDist_dt
+        = r_dt - (r_dt * cosTheta - r * sinThetaExact * theta_dt);
+
+    Eigen::Vector4s dHorizontalDist
+        = dR + r * sinThetaExact * dTheta - dR * cosTheta;
+    Eigen::Vector4s dHorizontalDist_dt
+        = dR_dt
+          + (r_dt * sinThetaExact * dTheta + r * cosTheta * theta_dt * dTheta
+             + r * sinThetaExact * dTheta_dt)
+          - (dR_dt * cosTheta - dR * sinThetaExact * theta_dt);
+
+    Eigen::Vector4s dVerticalDist = r * cosTheta * dTheta + dR * sinTheta;
+    Eigen::Vector4s dVerticalDist_dt
+        = (r_dt * cosTheta * dTheta - r * sinThetaExact * theta_dt * dTheta
+           + r * cosTheta * dTheta_dt)
+          + (dR_dt * sinTheta + dR * sinTheta_dt);
+
+    // Rows 0 and 2 of the translation have the same form, just with different
+    // components of the linear angle
+    Eigen::Matrix<s_t, 3, 4> dTranslation = Eigen::Matrix<s_t, 3, 4>::Zero();
+    Eigen::Matrix<s_t, 3, 4> dTranslation_dt
+        = Eigen::Matrix<s_t, 3, 4>::Zero();
+    const s_t invSin = 1.0 / sinTheta;
+    const s_t invSin2 = invSin * invSin;
+    for (int row = 0; row < 3; row += 2)
+    {
+      const s_t a = linearAngle(row);
+      const s_t a_dt = linearAngle_dt(row);
+      dTranslation.row(row)
+          = (a * invSin) * dHorizontalDist.transpose()
+            + (horizontalDist * invSin) * dLinearAngle.row(row)
+            + (horizontalDist * a) * (-invSin2) * dSinTheta.transpose();
+      dTranslation_dt.row(row)
+          = ((a_dt * invSin) * dHorizontalDist.transpose()
+             - (a * invSin2) * sinTheta_dt * dHorizontalDist.transpose()
+             + (a * invSin) * dHorizontalDist_dt.transpose())
+            + ((horizontalDist_dt * invSin) * dLinearAngle.row(row)
+               - (horizontalDist * invSin2) * sinTheta_dt
+                     * dLinearAngle.row(row)
+               + (horizontalDist * invSin) * dLinearAngle_dt.row(row))
+            + ((horizontalDist_dt * a + horizontalDist * a_dt) * (-invSin2)
+                   * dSinTheta.transpose()
+               + (horizontalDist * a) * (2.0 * sinTheta_dt * invSin2 * invSin)
+                     * dSinTheta.transpose()
+               + (horizontalDist * a) * (-invSin2) * dSinTheta_dt.transpose());
+    }
+    dTranslation.row(1) = dVerticalDist;
+    dTranslation_dt.row(1) = dVerticalDist_dt;
+
+    dJ.block<3, 4>(3, 0) = rot.linear().transpose() * dTranslation_dt
+                           + rot_dt.transpose() * dTranslation;
+  }
+
+  // Finally, take into account the transform to the child body node
+  return math::AdTJacFixed(getTransformFromChildBodyNode(), dJ);
+}
+
 //==============================================================================
 Eigen::Matrix<s_t, 6, 4>
 ConstantCurveJoint::getRelativeJacobianDerivWrtSegmentLengthStatic(
@@ -2790,18 +2996,8 @@ void ConstantCurveJoint::updateRelativeJacobian(bool) const
 //==============================================================================
 void ConstantCurveJoint::updateRelativeJacobianTimeDeriv() const
 {
-  Eigen::VectorXs pos = this->getPositionsStatic();
-  Eigen::VectorXs vel = this->getVelocitiesStatic();
-
-  Eigen::Matrix<s_t, 6, 4> dJ = Eigen::Matrix<s_t, 6, 4>::Zero();
-  for (int i = 0; i < 4; i++)
-  {
-    // getRelativeJacobianDerivWrtPositionStatic
-    Eigen::Matrix<s_t, 6, 4> J_di
-        = getRelativeJacobianDerivWrtPositionStatic(i);
-    dJ += J_di * vel(i);
-  }
-  this->mJacobianDeriv = dJ;
+  this->mJacobianDeriv = getRelativeJacobianTimeDerivStatic(
+      this->getPositionsStatic(), this->getVelocitiesStatic());
 }
 
 //==============================================================================
@@ -102,6 +102,13 @@ public:
   JacobianMatrix getRelativeJacobianDerivWrtPositionStatic(
       std::size_t index) const override;
 
+  /// This computes the time derivative of the relative Jacobian in a single
+  /// pass. It's equivalent to summing
+  /// getRelativeJacobianDerivWrtPositionStatic(i) * velocities(i) over all the
+  /// DOFs, but shares all the intermediate terms between the DOFs.
+  JacobianMatrix getRelativeJacobianTimeDerivStatic(
+      const Vector& positions, const Vector& velocities) const;
+
   static JacobianMatrix getRelativeJacobianDerivWrtSegmentLengthStatic(
       s_t len,
       s_t dLen,
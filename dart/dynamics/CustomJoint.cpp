@@ -31,6 +31,8 @@ CustomJoint<Dimension>::CustomJoint(
   for (int i = 0; i < 6; i++)
   {
     mFunctions.push_back(std::make_shared<math::ConstantFunction>(0));
+    mCompiledFunctions.push_back(
+        math::CompiledCustomFunction::compile(*mFunctions.back()));
     mFunctionDrivenByDof.push_back(0);
   }
 }
@@ -44,6 +46,7 @@ void CustomJoint<Dimension>::setCustomFunction(
 {
   assert(fn.get() != nullptr);
   mFunctions[i] = fn;
+  mCompiledFunctions[i] = math::CompiledCustomFunction::compile(*fn);
   mFunctionDrivenByDof[i] = drivenByDof;
   this->notifyPositionUpdated();
 }
@@ -51,7 +54,7 @@ void CustomJoint<Dimension>::setCustomFunction(
 //==============================================================================
 template <std::size_t Dimension>
 std::shared_ptr<math::CustomFunction> CustomJoint<Dimension>::getCustomFunction(
-    std::size_t i)
+    std::size_t i) const
 {
   assert(mFunctions[i].get() != nullptr);
   return mFunctions[i];
@@ -123,11 +126,44 @@ void CustomJoint<Dimension>::zeroTranslationInCustomFunctions()
 
 //==============================================================================
 template <std::size_t Dimension>
-int CustomJoint<Dimension>::getCustomFunctionDrivenByDof(std::size_t i)
+int CustomJoint<Dimension>::getCustomFunctionDrivenByDof(std::size_t i) const
 {
   return mFunctionDrivenByDof[i];
 }
 
+//==============================================================================
+template <std::size_t Dimension>
+s_t CustomJoint<Dimension>::evalCustomFunction(std::size_t i, s_t x) const
+{
+  if (mCompiledFunctions[i])
+    return mCompiledFunctions[i]->calcValue(x);
+  return mFunctions[i]->calcValue(x);
+}
+
+//==============================================================================
+template <std::size_t Dimension>
+s_t CustomJoint<Dimension>::evalCustomFunctionDerivative(
+    std::size_t i, int order, s_t x) const
+{
+  if (mCompiledFunctions[i])
+    return mCompiledFunctions[i]->calcDerivative(order, x);
+  return mFunctions[i]->calcDerivative(order, x);
+}
+
+//==============================================================================
+template <std::size_t Dimension>
+Eigen::Vector4s CustomJoint<Dimension>::evalCustomFunctionAndDerivatives(
+    std::size_t i, s_t x) const
+{
+  if (mCompiledFunctions[i])
+    return mCompiledFunctions[i]->calcValueAndDerivatives(x);
+  return Eigen::Vector4s(
+      mFunctions[i]->calcValue(x),
+      mFunctions[i]->calcDerivative(1, x),
+      mFunctions[i]->calcDerivative(2, x),
+      mFunctions[i]->calcDerivative(3, x));
+}
+
 //==============================================================================
 /// This gets the Jacobian of the mapping functions. That is, for every
 /// epsilon change in x, how does each custom function change?
@@ -139,7 +175,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionGradientAt(
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = mFunctionDrivenByDof[i];
-    df(i, drivenByDof) = mFunctions[i]->calcDerivative(1, x(drivenByDof));
+    df(i, drivenByDof) = evalCustomFunctionDerivative(i, 1, x(drivenByDof));
   }
   return df;
 }
@@ -155,7 +191,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionGradientAtTimeDeriv(
   {
     int drivenByDof = mFunctionDrivenByDof[i];
     dfdt(i, drivenByDof)
-        = mFunctions[i]->calcDerivative(2, x(drivenByDof)) * dx(drivenByDof);
+        = evalCustomFunctionDerivative(i, 2, x(drivenByDof)) * dx(drivenByDof);
   }
   return dfdt;
 }
@@ -223,10 +259,8 @@ CustomJoint<Dimension>::getCustomFunctionGradientAtTimeDerivPosDeriv(
     int drivenByDof = mFunctionDrivenByDof[i];
     if (drivenByDof == index)
     {
-      dfdt(i, drivenByDof)
-          = mFunctions[i]->calcDerivative(2, x(drivenByDof)) * ddx(drivenByDof)
-            + mFunctions[i]->calcDerivative(3, x(drivenByDof))
-                  * dx(drivenByDof);
+      Eigen::Vector4s f = evalCustomFunctionAndDerivatives(i, x(drivenByDof));
+      dfdt(i, drivenByDof) = f(2) * ddx(drivenByDof) + f(3) * dx(drivenByDof);
     }
   }
   return dfdt;
@@ -278,10 +312,11 @@ CustomJoint<Dimension>::getCustomFunctionGradientAtTimeDerivVelDeriv(
     int drivenByDof = mFunctionDrivenByDof[i];
     if (drivenByDof == index)
     {
-      dfdt(i, drivenByDof) = mFunctions[i]->calcDerivative(2, x(drivenByDof));
+      dfdt(i, drivenByDof) = evalCustomFunctionDerivative(i, 2, x(drivenByDof));
       /*
       dfdt(i, drivenByDof)
-          = mFunctions[i]->calcDerivative(2, x(drivenByDof)) * dx(drivenByDof);
+          = evalCustomFunctionDerivative(i, 2, x(drivenByDof))
+            * dx(drivenByDof);
           */
     }
   }
@@ -327,7 +362,7 @@ math::Jacobian CustomJoint<Dimension>::getCustomFunctionSecondGradientAt(
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = mFunctionDrivenByDof[i];
-    ddf(i, drivenByDof) = mFunctions[i]->calcDerivative(2, x(drivenByDof));
+    ddf(i, drivenByDof) = evalCustomFunctionDerivative(i, 2, x(drivenByDof));
   }
   return ddf;
 }
@@ -342,7 +377,7 @@ Eigen::Vector6s CustomJoint<Dimension>::getCustomFunctionPositions(
   Eigen::Vector6s pos = Eigen::Vector6s::Zero();
   for (int i = 0; i < 6; i++)
   {
-    pos(i) = mFunctions[i]->calcValue(x(mFunctionDrivenByDof[i]));
+    pos(i) = evalCustomFunction(i, x(mFunctionDrivenByDof[i]));
   }
   return pos;
 }
@@ -373,15 +408,13 @@ Eigen::Vector6s CustomJoint<Dimension>::getCustomFunctionAccelerations(
     const Eigen::VectorXs& dx,
     const Eigen::VectorXs& ddx) const
 {
-  math::Jacobian ddf = getCustomFunctionGradientAt(x);
   Eigen::Vector6s acc;
 
   for (int i = 0; i < 6; i++)
   {
     int drivenByDof = this->mFunctionDrivenByDof[i];
-    acc(i)
-        = ddf(i, drivenByDof) * ddx(drivenByDof)
-          + mFunctions[i]->calcDerivative(2, x(drivenByDof)) * dx(drivenByDof);
+    Eigen::Vector4s f = evalCustomFunctionAndDerivatives(i, x(drivenByDof));
+    acc(i) = f(1) * ddx(drivenByDof) + f(2) * dx(drivenByDof);
   }
 
   return acc;
@@ -449,7 +482,7 @@ CustomJoint<Dimension>::getCustomFunctionAccelerationsDerivativeWrtPos(
         = ddx(drivenBy) * ddf_dx(i, drivenBy)
           // Most custom functions will have a 0 third derivative, but this is
           // here just in case
-          + mFunctions[i]->calcDerivative(3, x(drivenBy)) * dx(drivenBy);
+          + evalCustomFunctionDerivative(i, 3, x(drivenBy)) * dx(drivenBy);
   }
 
   return jac;
@@ -492,7 +525,7 @@ CustomJoint<Dimension>::getCustomFunctionAccelerationsDerivativeWrtVel(
   for (int i = 0; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    jac(i, drivenBy) = mFunctions[i]->calcDerivative(2, x(drivenBy));
+    jac(i, drivenBy) = evalCustomFunctionDerivative(i, 2, x(drivenBy));
   }
   return jac;
 }
@@ -531,7 +564,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerPositions(
   for (int i = 0; i < 3; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    pos(i) = mFunctions[i]->calcValue(x(drivenBy));
+    pos(i) = evalCustomFunction(i, x(drivenBy));
   }
   return pos;
 }
@@ -546,7 +579,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerVelocities(
   for (int i = 0; i < 3; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    vel(i) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * dx(drivenBy);
+    vel(i) = evalCustomFunctionDerivative(i, 1, x(drivenBy)) * dx(drivenBy);
   }
   return vel;
 }
@@ -563,8 +596,8 @@ Eigen::Vector3s CustomJoint<Dimension>::getEulerAccelerations(
   for (int i = 0; i < 3; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    acc(i) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * ddx(drivenBy)
-             + mFunctions[i]->calcDerivative(2, x(drivenBy)) * dx(drivenBy);
+    Eigen::Vector4s f = evalCustomFunctionAndDerivatives(i, x(drivenBy));
+    acc(i) = f(1) * ddx(drivenBy) + f(2) * dx(drivenBy);
   }
   return acc;
 }
@@ -579,7 +612,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationPositions(
   for (int i = 3; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    pos(i - 3) = mFunctions[i]->calcValue(x(drivenBy));
+    pos(i - 3) = evalCustomFunction(i, x(drivenBy));
   }
   return pos;
 }
@@ -594,7 +627,7 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationVelocities(
   for (int i = 3; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    vel(i - 3) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * dx(drivenBy);
+    vel(i - 3) = evalCustomFunctionDerivative(i, 1, x(drivenBy)) * dx(drivenBy);
   }
   return vel;
 }
@@ -611,8 +644,8 @@ Eigen::Vector3s CustomJoint<Dimension>::getTranslationAccelerations(
   for (int i = 3; i < 6; i++)
   {
     int drivenBy = this->mFunctionDrivenByDof[i];
-    acc(i - 3) = mFunctions[i]->calcDerivative(1, x(drivenBy)) * ddx(drivenBy)
-                 + mFunctions[i]->calcDerivative(2, x(drivenBy)) * dx(drivenBy);
+    Eigen::Vector4s f = evalCustomFunctionAndDerivatives(i, x(drivenBy));
+    acc(i - 3) = f(1) * ddx(drivenBy) + f(2) * dx(drivenBy);
   }
   return acc;
 }
@@ -683,6 +716,7 @@ dart::dynamics::Joint* CustomJoint<Dimension>::clone() const
   CustomJoint<Dimension>* joint
       = new CustomJoint<Dimension>(this->getJointProperties());
   joint->mFunctions = mFunctions;
+  joint->mCompiledFunctions = mCompiledFunctions;
   joint->mFunctionDrivenByDof = mFunctionDrivenByDof;
   joint->copyTransformsFrom(this);
   joint->setFlipAxisMap(getFlipAxisMap());
@@ -1375,11 +1409,10 @@ Eigen::VectorXs CustomJoint<Dimension>::getNearestPositionToDesiredRotation(
     for (int i = 0; i < 3; i++)
     {
       int drivenByDof = mFunctionDrivenByDof[i];
-      s_t value = mFunctions[i]->calcValue(x(drivenByDof));
-      s_t diff = eulerAngles(i) - value;
+      Eigen::Vector4s f = evalCustomFunctionAndDerivatives(i, x(drivenByDof));
+      s_t diff = eulerAngles(i) - f(0);
       loss += diff * diff;
-      grad(drivenByDof)
-          += 2 * diff * mFunctions[i]->calcDerivative(1, x(drivenByDof));
+      grad(drivenByDof) += 2 * diff * f(1);
     }
     s_t improvement = lastLoss - loss;
     if (improvement < 1e-12)
@@ -39,6 +39,7 @@
 
 #include "dart/dynamics/EulerJoint.hpp"
 #include "dart/dynamics/GenericJoint.hpp"
+#include "dart/math/CompiledCustomFunction.hpp"
 #include "dart/math/ConfigurationSpace.hpp"
 #include "dart/math/CustomFunction.hpp"
 #include "dart/math/MathTypes.hpp"
@@ -76,11 +77,13 @@ public:
           props);
 
   /// This sets a custom function to map our single input degree of freedom to
-  /// the wrapped Euler joint's degree of freedom and index i
+  /// the wrapped Euler joint's degree of freedom and index i. Functions that
+  /// can be are compiled into a flat table here, so if you change `fn` after
+  /// this, call setCustomFunction() again.
   void setCustomFunction(
       std::size_t i, std::shared_ptr<math::CustomFunction> fn, int drivenByDof);
 
-  std::shared_ptr<math::CustomFunction> getCustomFunction(std::size_t i);
+  std::shared_ptr<math::CustomFunction> getCustomFunction(std::size_t i) const;
 
   /// There is an annoying tendency for custom joints to encode the linear
   /// offset of the bone in their custom functions. We don't want that, so we
@@ -88,7 +91,7 @@ public:
   /// parent transform.
   void zeroTranslationInCustomFunctions();
 
-  int getCustomFunctionDrivenByDof(std::size_t i);
+  int getCustomFunctionDrivenByDof(std::size_t i) const;
 
   /// This gets the Jacobian of the mapping functions. That is, for every
   /// epsilon change in dof=x, how does each custom function change?
@@ -319,9 +322,25 @@ protected:
   /// input axis.
   Eigen::Vector3s mFlipAxisMap;
 
+  /// This evaluates custom function `i` at `x`, through its compiled table if
+  /// it has one
+  s_t evalCustomFunction(std::size_t i, s_t x) const;
+
+  /// This evaluates a derivative of custom function `i` at `x`, through its
+  /// compiled table if it has one
+  s_t evalCustomFunctionDerivative(std::size_t i, int order, s_t x) const;
+
+  /// This returns the value and the first three derivatives of custom
+  /// function `i` at `x`
+  Eigen::Vector4s evalCustomFunctionAndDerivatives(std::size_t i, s_t x) const;
+
   // There should be 6 of these, one for each axis of the wrapped Euler joint
   std::vector<std::shared_ptr<math::CustomFunction>> mFunctions;
 
+  // The compiled forms of mFunctions, or nullptr for the ones that couldn't be
+  // compiled
+  std::vector<std::shared_ptr<math::CompiledCustomFunction>> mCompiledFunctions;
+
   // Each function is driven by a single degree of freedom
   std::vector<int> mFunctionDrivenByDof;
 };
@@ -308,6 +308,56 @@ EllipsoidJoint::getRelativeJacobianDerivWrtPositionStatic(
   return dJ;
 }
 
+//==============================================================================
+Eigen::Matrix<s_t, 6, 3> EllipsoidJoint::getRelativeJacobianTimeDerivStatic(
+    const Eigen::Vector3s& pos, const Eigen::Vector3s& vel) const
+{
+  Eigen::Matrix<s_t, 6, 3> J = Eigen::Matrix<s_t, 6, 3>::Zero();
+  Eigen::Matrix<s_t, 6, 3> dJ = Eigen::Matrix<s_t, 6, 3>::Zero();
+
+  // The Euler joint already knows how to compute its own time derivative in
+  // one pass, which is the velocity-weighted sum of its position derivatives
+  Eigen::Isometry3s identity = Eigen::Isometry3s::Identity();
+  Eigen::Matrix<s_t, 6, 3> eulerJ = EulerJoint::computeRelativeJacobianStatic(
+      pos, mAxisOrder, mFlipAxisMap, identity);
+  Eigen::Matrix<s_t, 6, 3> euler_dJ
+      = EulerJoint::computeRelativeJacobianTimeDerivStatic(
+          pos, vel, mAxisOrder, mFlipAxisMap, identity);
+  Eigen::Matrix3s eulerR = Eigen::Matrix3s::Zero();
+  eulerR(1, 0) = -1.0;
+  eulerR(0, 1) = 1.0;
+  eulerR(2, 2) = 1.0;
+  dJ.block<3, 3>(0, 0) = eulerR.transpose() * euler_dJ.topRows(3);
+  J.block<3, 3>(0, 0) = eulerR.transpose() * eulerJ.topRows(3);
+
+  const Eigen::Vector3s localSphericalOffset = Eigen::Vector3s::UnitZ();
+  for (int i = 0; i < 3; i++)
+  {
+    dJ.block<3, 1>(3, i) = dJ.block<3, 1>(0, i).cross(localSphericalOffset);
+    J.block<3, 1>(3, i) = J.block<3, 1>(0, i).cross(localSphericalOffset);
+  }
+
+  Eigen::Matrix3s rot
+      = EulerJoint::convertToTransform(pos, mAxisOrder, mFlipAxisMap).linear();
+  rot = eulerR.transpose() * rot * eulerR;
+  const Eigen::Vector3s parentScale = getParentScale();
+  const Eigen::Matrix3s radii
+      = (mEllipsoidRadii.cwiseProduct(parentScale)).asDiagonal();
+  const Eigen::Matrix3s scaleInParentSpace = rot.transpose() * radii * rot;
+
+  // d(rot)/dq_i = rot * [J_i], so summing over the velocities collapses to a
+  // single skew matrix of the angular velocity
+  const Eigen::Vector3s w = J.block<3, 3>(0, 0) * vel;
+  Eigen::Matrix3s dScaleInParentSpace
+      = (rot * math::makeSkewSymmetric(w)).transpose() * radii * rot;
+  dScaleInParentSpace += dScaleInParentSpace.transpose().eval();
+  dJ.block<3, 3>(3, 0) = scaleInParentSpace * dJ.block<3, 3>(3, 0)
+                         + dScaleInParentSpace * J.block<3, 3>(3, 0);
+
+  // Finally, take into account the transform to the child body node
+  return math::AdTJacFixed(getTransformFromChildBodyNode(), dJ);
+}
+
 //==============================================================================
 Eigen::Matrix<s_t, 6, 3>
 EllipsoidJoint::getRelativeJacobianDerivWrtPositionDerivWrtPositionStatic(
@@ -672,15 +722,8 @@ void EllipsoidJoint::updateRelativeJacobian(bool) const
 //==============================================================================
 void EllipsoidJoint::updateRelativeJacobianTimeDeriv() const
 {
-  Eigen::VectorXs pos = this->getPositionsStatic();
-  Eigen::VectorXs vel = this->getVelocitiesStatic();
-
-  Eigen::Matrix<s_t, 6, 3> dJ = Eigen::Matrix<s_t, 6, 3>::Zero();
-  for (int i = 0; i < pos.size(); i++)
-  {
-    dJ += getRelativeJacobianDerivWrtPositionStatic(i) * vel(i);
-  }
-  this->mJacobianDeriv = dJ;
+  this->mJacobianDeriv = getRelativeJacobianTimeDerivStatic(
+      this->getPositionsStatic(), this->getVelocitiesStatic());
 }
 
 //==============================================================================
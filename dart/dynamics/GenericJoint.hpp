@@ -508,7 +508,7 @@ public:
   //----------------------------------------------------------------------------
 
   // Documentation inherited
-  const math::Jacobian getRelativeJacobian() const override;
+  const math::Jacobian& getRelativeJacobian() const override;
 
   /// Fixed-size version of getRelativeJacobian()
   const typename GenericJoint<ConfigSpaceT>::JacobianMatrix&
@@ -531,7 +531,7 @@ public:
       const Vector& positions) const = 0;
 
   // Documentation inherited
-  const math::Jacobian getRelativeJacobianTimeDeriv() const override;
+  const math::Jacobian& getRelativeJacobianTimeDeriv() const override;
 
   /// Fixed-size version of getRelativeJacobianTimeDeriv()
   const JacobianMatrix& getRelativeJacobianTimeDerivStatic() const;
@@ -545,7 +545,7 @@ public:
   /// generally the same as the getRelativeJacobian() for the `dq` vector space,
   /// because `q` and `dq` are generally in the same vector space. However, for
   /// BallJoint and FreeJoint these are different values.
-  virtual const math::Jacobian getRelativeJacobianInPositionSpace()
+  virtual const math::Jacobian& getRelativeJacobianInPositionSpace()
       const override;
 
   /// Fixed-size version of getRelativeJacobianInPositionSpace(positions)
@@ -777,6 +777,14 @@ protected:
   /// this quantity
   mutable JacobianMatrix mJacobianDeriv;
 
+  /// Dynamic-size copies of mJacobian, mJacobianInPositionSpace and
+  /// mJacobianDeriv, handed out through the Joint interface. They are sized
+  /// once at construction, and only refreshed when the matching cache is
+  /// recomputed, so reading a clean joint never writes to them.
+  mutable math::Jacobian mJacobianDynamic;
+  mutable math::Jacobian mJacobianInPositionSpaceDynamic;
+  mutable math::Jacobian mJacobianDerivDynamic;
+
   /// Inverse of projected articulated inertia
   ///
   /// Do not use directly! Use getInvProjArtInertia() to get this quantity
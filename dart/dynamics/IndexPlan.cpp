@@ -0,0 +1,119 @@
+#include "dart/dynamics/IndexPlan.hpp"
+
+#include "dart/common/Console.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/MetaSkeleton.hpp"
+
+namespace dart {
+namespace dynamics {
+
+//==============================================================================
+IndexPlan::IndexPlan(
+    MetaSkeleton* skel, const std::vector<std::size_t>& indices)
+  : mNumDofs(indices.size())
+{
+  for (std::size_t i = 0; i < indices.size(); ++i)
+  {
+    DegreeOfFreedom* dof
+        = indices[i] < skel->getNumDofs() ? skel->getDof(indices[i]) : nullptr;
+    if (dof == nullptr)
+    {
+      dterr << "[IndexPlan] DegreeOfFreedom #" << indices[i] << " (entry #"
+            << i << " in indices) of the MetaSkeleton named ["
+            << skel->getName() << "] (" << skel << ") is out of bounds or "
+            << "has expired. Reading it will give zero, and writing it will "
+            << "do nothing.\n";
+      assert(false);
+      mRuns.push_back(Run{nullptr, 0, i, 1, false});
+      continue;
+    }
+
+    Joint* joint = dof->getJoint();
+    const std::size_t indexInJoint = dof->getIndexInJoint();
+    if (!mRuns.empty())
+    {
+      Run& last = mRuns.back();
+      if (last.joint == joint
+          && last.indexInJoint + last.numDofs == indexInJoint)
+      {
+        last.numDofs++;
+        continue;
+      }
+    }
+    mRuns.push_back(Run{joint, indexInJoint, i, 1, false});
+  }
+
+  for (Run& run : mRuns)
+  {
+    run.wholeJoint = run.joint != nullptr && run.indexInJoint == 0
+                     && run.numDofs == run.joint->getNumDofs();
+  }
+}
+
+//==============================================================================
+std::size_t IndexPlan::getNumDofs() const
+{
+  return mNumDofs;
+}
+
+//==============================================================================
+std::size_t IndexPlan::getNumRuns() const
+{
+  return mRuns.size();
+}
+
+//==============================================================================
+void IndexPlan::gather(
+    Eigen::VectorXs (Joint::*get)() const,
+    Eigen::Ref<Eigen::VectorXs> out) const
+{
+  assert(static_cast<std::size_t>(out.size()) == mNumDofs);
+  for (const Run& run : mRuns)
+  {
+    if (run.joint == nullptr)
+    {
+      out.segment(run.indexInPlan, run.numDofs).setZero();
+      continue;
+    }
+
+    out.segment(run.indexInPlan, run.numDofs)
+        = (run.joint->*get)().segment(run.indexInJoint, run.numDofs);
+  }
+}
+
+//==============================================================================
+void IndexPlan::scatter(
+    Eigen::VectorXs (Joint::*get)() const,
+    void (Joint::*set)(const Eigen::VectorXs&),
+    const Eigen::VectorXs& values) const
+{
+  if (static_cast<std::size_t>(values.size()) != mNumDofs)
+  {
+    dterr << "[IndexPlan::scatter] Mismatch between the number of DOFs in the "
+          << "plan (" << mNumDofs << ") and the number of values ("
+          << values.size() << "). Nothing will be set!\n";
+    assert(false);
+    return;
+  }
+
+  for (const Run& run : mRuns)
+  {
+    if (run.joint == nullptr)
+      continue;
+
+    if (run.wholeJoint)
+    {
+      (run.joint->*set)(values.segment(run.indexInPlan, run.numDofs));
+      continue;
+    }
+
+    Eigen::VectorXs jointValues = (run.joint->*get)();
+    jointValues.segment(run.indexInJoint, run.numDofs)
+        = values.segment(run.indexInPlan, run.numDofs);
+    (run.joint->*set)(jointValues);
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,83 @@
+#ifndef DART_DYNAMICS_INDEX_PLAN_HPP_
+#define DART_DYNAMICS_INDEX_PLAN_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Joint;
+class MetaSkeleton;
+
+/// An IndexPlan is a subset of the DOFs of a MetaSkeleton, compiled down to
+/// runs of DOFs that sit next to each other in the same Joint. Reading or
+/// writing state through a plan costs one virtual call and one block copy per
+/// run, instead of looking up every DOF and going through it one value at a
+/// time, which is what MetaSkeleton::getPositions(indices) and friends do on
+/// every call. That's worth it when you read and write the same subset of
+/// DOFs over and over.
+///
+/// Pass a plan to the MetaSkeleton overloads that take one, like
+/// MetaSkeleton::getPositions(const IndexPlan&). The plan holds on to the
+/// Joints it was compiled against, so compile a new one after any structural
+/// change to the Skeleton (or after calling update() on a
+/// ReferentialSkeleton).
+class IndexPlan
+{
+public:
+  /// Compile a plan for the DOFs of `skel` at `indices`, in that order
+  IndexPlan(MetaSkeleton* skel, const std::vector<std::size_t>& indices);
+
+  /// Returns the number of DOFs in the plan, which is the size of the vectors
+  /// it reads and writes
+  std::size_t getNumDofs() const;
+
+  /// Returns the number of runs of neighboring DOFs the plan was compiled to
+  std::size_t getNumRuns() const;
+
+  /// This reads the values `get` returns for every Joint in the plan into
+  /// `out`, which must have getNumDofs() entries
+  void gather(
+      Eigen::VectorXs (Joint::*get)() const,
+      Eigen::Ref<Eigen::VectorXs> out) const;
+
+  /// This writes `values`, which must have getNumDofs() entries, with `set`.
+  /// Joints that only have some of their DOFs in the plan get the rest of
+  /// theirs read with `get` and written back unchanged.
+  void scatter(
+      Eigen::VectorXs (Joint::*get)() const,
+      void (Joint::*set)(const Eigen::VectorXs&),
+      const Eigen::VectorXs& values) const;
+
+protected:
+  /// Some DOFs that are next to each other in both the plan and their Joint
+  struct Run
+  {
+    Joint* joint;
+
+    /// The index within the Joint of the first DOF in the run
+    std::size_t indexInJoint;
+
+    /// The index within the plan of the first DOF in the run
+    std::size_t indexInPlan;
+
+    std::size_t numDofs;
+
+    /// True if the run covers every DOF of its Joint, so writes don't need to
+    /// read the Joint's other values first
+    bool wholeJoint;
+  };
+
+  std::vector<Run> mRuns;
+
+  std::size_t mNumDofs;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
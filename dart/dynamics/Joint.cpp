@@ -222,7 +222,11 @@ const std::string& Joint::getName() const
 //==============================================================================
 void Joint::setActuatorType(Joint::ActuatorType _actuatorType)
 {
+  if (mAspectProperties.mActuatorType == _actuatorType)
+    return;
+
   mAspectProperties.mActuatorType = _actuatorType;
+  incrementVersion();
 }
 
 //==============================================================================
@@ -1365,7 +1369,11 @@ Eigen::Vector6s Joint::finiteDifferenceScrewAxisGradientWrtParentBodyScale(
 //==============================================================================
 void Joint::setPositionLimitEnforced(bool _isPositionLimitEnforced)
 {
+  if (mAspectProperties.mIsPositionLimitEnforced == _isPositionLimitEnforced)
+    return;
+
   mAspectProperties.mIsPositionLimitEnforced = _isPositionLimitEnforced;
+  incrementVersion();
 }
 
 //==============================================================================
@@ -1661,13 +1669,6 @@ void Joint::notifyPositionUpdate()
 //==============================================================================
 void Joint::notifyPositionUpdated()
 {
-  if (mChildBodyNode)
-  {
-    mChildBodyNode->dirtyTransform();
-    mChildBodyNode->dirtyJacobian();
-    mChildBodyNode->dirtyJacobianDeriv();
-  }
-
   mIsRelativeJacobianDirty = true;
   mIsRelativeJacobianInPositionSpaceDirty = true;
   mIsRelativeJacobianTimeDerivDirty = true;
@@ -1678,10 +1679,29 @@ void Joint::notifyPositionUpdated()
   mNeedSpatialAccelerationUpdate = true;
 
   SkeletonPtr skel = getSkeleton();
+  if (skel && skel->mPositionUpdatesDepth > 0)
+  {
+    // The Skeleton will call us again from endPositionUpdates()
+    std::size_t index = mChildBodyNode->getIndexInSkeleton();
+    if (index < skel->mPendingPositionUpdates.size())
+    {
+      skel->mPendingPositionUpdates[index] = true;
+      return;
+    }
+  }
+
+  if (mChildBodyNode)
+  {
+    mChildBodyNode->dirtyTransform();
+    mChildBodyNode->dirtyJacobian();
+    mChildBodyNode->dirtyJacobianDeriv();
+  }
+
   if (skel)
   {
+    skel->mKinematicsVersion++;
     std::size_t tree = mChildBodyNode->mTreeIndex;
-    skel->dirtyArticulatedInertia(tree);
+    skel->dirtySubtreeArticulatedInertia(mChildBodyNode);
     skel->mTreeCache[tree].mDirty.mExternalForces = true;
     skel->mSkelCache.mDirty.mExternalForces = true;
   }
@@ -713,8 +713,9 @@ public:
   const Eigen::Vector6s& getRelativePrimaryAcceleration() const;
 
   /// Get spatial Jacobian of the child BodyNode relative to the parent BodyNode
-  /// expressed in the child BodyNode frame
-  virtual const math::Jacobian getRelativeJacobian() const = 0;
+  /// expressed in the child BodyNode frame. The reference stays valid for as
+  /// long as this Joint does, and is refreshed by the next call.
+  virtual const math::Jacobian& getRelativeJacobian() const = 0;
 
   /// Get spatial Jacobian of the child BodyNode relative to the parent BodyNode
   /// expressed in the child BodyNode frame
@@ -759,7 +760,7 @@ public:
 
   /// Get time derivative of spatial Jacobian of the child BodyNode relative to
   /// the parent BodyNode expressed in the child BodyNode frame
-  virtual const math::Jacobian getRelativeJacobianTimeDeriv() const = 0;
+  virtual const math::Jacobian& getRelativeJacobianTimeDeriv() const = 0;
 
   /// Computes derivative of time derivative of Jacobian w.r.t. position.
   virtual math::Jacobian getRelativeJacobianTimeDerivDerivWrtPosition(
@@ -862,7 +863,7 @@ public:
   /// generally the same as the getRelativeJacobian() for the `dq` vector space,
   /// because `q` and `dq` are generally in the same vector space. However, for
   /// BallJoint and FreeJoint these are different values.
-  virtual const math::Jacobian getRelativeJacobianInPositionSpace() const = 0;
+  virtual const math::Jacobian& getRelativeJacobianInPositionSpace() const = 0;
 
   /// Get spatial Jacobian of the child BodyNode relative to the parent BodyNode
   /// expressed in the child BodyNode frame, in the `q` vector space. This is
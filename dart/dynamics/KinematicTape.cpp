@@ -0,0 +1,189 @@
+#include "dart/dynamics/KinematicTape.hpp"
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+//==============================================================================
+KinematicTape::KinematicTape(const Skeleton* skel)
+{
+  const int numBodies = skel->getNumBodyNodes();
+  const int numDofs = skel->getNumDofs();
+  mOps.resize(numBodies);
+  mRootParentTransforms.resize(numBodies, Eigen::Isometry3s::Identity());
+  mBodyDofs.resize(numBodies);
+  mRelativeJacobians = Eigen::Matrix<s_t, 6, Eigen::Dynamic>::Zero(6, numDofs);
+  mWorldTwists = Eigen::Matrix<s_t, 6, Eigen::Dynamic>::Zero(6, numDofs);
+  mWorldTransforms.resize(numBodies, Eigen::Isometry3s::Identity());
+  mPositions = skel->getPositions();
+
+  // Bodies always come after their parents in the Skeleton, so visiting them
+  // in index order is a topological order
+  for (int i = 0; i < numBodies; i++)
+  {
+    const BodyNode* body = skel->getBodyNode(i);
+    const Joint* joint = body->getParentJoint();
+    Op& op = mOps[i];
+
+    const BodyNode* parent = body->getParentBodyNode();
+    op.parent = parent == nullptr ? -1 : parent->getIndexInSkeleton();
+    assert(op.parent < i);
+    if (parent == nullptr)
+      mRootParentTransforms[i] = body->getParentFrame()->getWorldTransform();
+
+    op.numDofs = joint->getNumDofs();
+    op.firstDof = op.numDofs > 0 ? joint->getIndexInSkeleton(0) : 0;
+    op.parentToJoint = joint->getTransformFromParentBodyNode();
+    op.jointToChild = joint->getTransformFromChildBodyNode().inverse();
+    op.axis.setZero();
+    op.joint = nullptr;
+    if (joint->getType() == WeldJoint::getStaticType())
+    {
+      op.type = WELD;
+      op.parentToJoint = op.parentToJoint * op.jointToChild;
+    }
+    else if (joint->getType() == RevoluteJoint::getStaticType())
+    {
+      op.type = REVOLUTE;
+      op.axis = static_cast<const RevoluteJoint*>(joint)->getAxis();
+    }
+    else if (joint->getType() == PrismaticJoint::getStaticType())
+    {
+      op.type = PRISMATIC;
+      op.axis = static_cast<const PrismaticJoint*>(joint)->getAxis();
+    }
+    else
+    {
+      op.type = GENERIC;
+      if (!mClone)
+        mClone = skel->cloneSkeleton();
+      op.joint = mClone->getJoint(i);
+    }
+
+    // The relative Jacobians of weld, revolute and prismatic joints don't
+    // depend on the joint positions, so we only need to read them once
+    if (op.type != GENERIC && op.numDofs > 0)
+      mRelativeJacobians.middleCols(op.firstDof, op.numDofs)
+          = joint->getRelativeJacobian();
+
+    for (std::size_t dof : body->getDependentGenCoordIndices())
+      mBodyDofs[i].push_back(dof);
+  }
+
+  evaluate(mPositions);
+}
+
+//==============================================================================
+int KinematicTape::getNumDofs() const
+{
+  return mPositions.size();
+}
+
+//==============================================================================
+int KinematicTape::getNumBodyNodes() const
+{
+  return mOps.size();
+}
+
+//==============================================================================
+void KinematicTape::evaluate(const Eigen::VectorXs& positions)
+{
+  assert(positions.size() == mPositions.size());
+  mPositions = positions;
+
+  for (std::size_t i = 0; i < mOps.size(); i++)
+  {
+    const Op& op = mOps[i];
+    Eigen::Isometry3s relative;
+    switch (op.type)
+    {
+      case WELD:
+        relative = op.parentToJoint;
+        break;
+      case REVOLUTE:
+        relative = op.parentToJoint
+                   * math::expAngular(op.axis * positions(op.firstDof))
+                   * op.jointToChild;
+        break;
+      case PRISMATIC:
+        relative = op.parentToJoint
+                   * Eigen::Translation3s(op.axis * positions(op.firstDof))
+                   * op.jointToChild;
+        break;
+      case GENERIC:
+        op.joint->setPositions(positions.segment(op.firstDof, op.numDofs));
+        relative = op.joint->getRelativeTransform();
+        mRelativeJacobians.middleCols(op.firstDof, op.numDofs)
+            = op.joint->getRelativeJacobian();
+        break;
+    }
+
+    if (op.parent < 0)
+      mWorldTransforms[i] = mRootParentTransforms[i] * relative;
+    else
+      mWorldTransforms[i] = mWorldTransforms[op.parent] * relative;
+    const Eigen::Isometry3s& T = mWorldTransforms[i];
+
+    // Move each DOF's twist from the child body frame out to world
+    // coordinates, measuring the linear part at the world origin, so that
+    // every body downstream can read off its Jacobian with one cross product
+    for (int d = op.firstDof; d < op.firstDof + op.numDofs; d++)
+    {
+      const Eigen::Vector3s w
+          = T.linear() * mRelativeJacobians.block<3, 1>(0, d);
+      const Eigen::Vector3s v
+          = T.linear() * mRelativeJacobians.block<3, 1>(3, d);
+      mWorldTwists.block<3, 1>(0, d) = w;
+      mWorldTwists.block<3, 1>(3, d) = v + T.translation().cross(w);
+    }
+  }
+}
+
+//==============================================================================
+const Eigen::VectorXs& KinematicTape::getPositions() const
+{
+  return mPositions;
+}
+
+//==============================================================================
+const Eigen::Isometry3s& KinematicTape::getWorldTransform(int bodyIndex) const
+{
+  return mWorldTransforms[bodyIndex];
+}
+
+//==============================================================================
+const std::vector<Eigen::Isometry3s>& KinematicTape::getWorldTransforms() const
+{
+  return mWorldTransforms;
+}
+
+//==============================================================================
+math::Jacobian KinematicTape::getWorldJacobian(
+    int bodyIndex, const Eigen::Vector3s& offset) const
+{
+  const Eigen::Vector3s point = mWorldTransforms[bodyIndex] * offset;
+  math::Jacobian jac = math::Jacobian::Zero(6, mPositions.size());
+  for (int d : mBodyDofs[bodyIndex])
+  {
+    const Eigen::Vector3s w = mWorldTwists.block<3, 1>(0, d);
+    jac.block<3, 1>(0, d) = w;
+    jac.block<3, 1>(3, d) = mWorldTwists.block<3, 1>(3, d) + w.cross(point);
+  }
+  return jac;
+}
+
+//==============================================================================
+void KinematicTape::syncToSkeleton(Skeleton* skel) const
+{
+  skel->setPositionsAndWorldTransforms(mPositions, mWorldTransforms);
+}
+
+} // namespace dynamics
+} // namespace dart
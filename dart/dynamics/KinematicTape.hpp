@@ -0,0 +1,136 @@
+#ifndef DART_DYNAMICS_KINEMATIC_TAPE_HPP_
+#define DART_DYNAMICS_KINEMATIC_TAPE_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/dynamics/SmartPointer.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class Joint;
+
+/// A KinematicTape is forward kinematics for one Skeleton, compiled down to a
+/// flat list of joint operations in topological order. Evaluating it on a
+/// pose computes the world transform of every body, and the world Jacobians,
+/// in one loop over plain arrays, without any of the virtual dispatch, Frame
+/// notifications or dirty flags that Skeleton::setPositions() and
+/// BodyNode::getWorldTransform() go through. That's worth it when you run FK
+/// on the same skeleton over and over, with different poses.
+///
+/// Weld, revolute and prismatic joints get their own operations. Every other
+/// type of joint is evaluated by calling into a private clone of the
+/// skeleton, which is slower, but never touches the skeleton the tape was
+/// compiled from.
+///
+/// The tape is a snapshot: it bakes in the joint offsets (and so the body
+/// scales) the skeleton had when it was compiled. If those change, compile a
+/// new tape. A tape isn't safe to evaluate from several threads at once, but
+/// separate tapes are.
+class KinematicTape
+{
+public:
+  /// This compiles a tape for the current properties of `skel`
+  explicit KinematicTape(const Skeleton* skel);
+
+  /// Returns the number of DOFs the tape takes as input
+  int getNumDofs() const;
+
+  /// Returns the number of bodies the tape computes transforms for
+  int getNumBodyNodes() const;
+
+  /// This computes the world transform of every body, and the world twist of
+  /// every DOF, at `positions`
+  void evaluate(const Eigen::VectorXs& positions);
+
+  /// Returns the positions of the last evaluate()
+  const Eigen::VectorXs& getPositions() const;
+
+  /// Returns the world transform of the body with index `bodyIndex` in its
+  /// Skeleton, as of the last evaluate()
+  const Eigen::Isometry3s& getWorldTransform(int bodyIndex) const;
+
+  /// Returns the world transforms of every body, in Skeleton order, as of the
+  /// last evaluate()
+  const std::vector<Eigen::Isometry3s>& getWorldTransforms() const;
+
+  /// Returns the same thing as Skeleton::getWorldJacobian() for the point at
+  /// `offset` (in body coordinates) on body `bodyIndex`, as of the last
+  /// evaluate(): angular velocity on top, linear velocity of the point below,
+  /// both in world coordinates, with a column for every DOF in the Skeleton.
+  math::Jacobian getWorldJacobian(
+      int bodyIndex,
+      const Eigen::Vector3s& offset = Eigen::Vector3s::Zero()) const;
+
+  /// This writes the last evaluate() back to `skel`, which must be the
+  /// skeleton the tape was compiled from (or a clone of it). This sets its
+  /// positions, and seeds the world transforms of its bodies with the ones we
+  /// computed, so reading them doesn't run forward kinematics again.
+  void syncToSkeleton(Skeleton* skel) const;
+
+protected:
+  enum OpType
+  {
+    WELD,
+    REVOLUTE,
+    PRISMATIC,
+    GENERIC
+  };
+
+  /// One entry on the tape: how to get a body's transform from its parent's
+  struct Op
+  {
+    OpType type;
+
+    /// The index of the parent body, or -1 if this is a root
+    int parent;
+
+    int firstDof;
+
+    int numDofs;
+
+    /// The joint's transform from the parent body, and the inverse of its
+    /// transform from the child body. For welds, the first is the whole
+    /// relative transform.
+    Eigen::Isometry3s parentToJoint;
+    Eigen::Isometry3s jointToChild;
+
+    Eigen::Vector3s axis;
+
+    /// For GENERIC operations, the joint on mClone we call into
+    Joint* joint;
+  };
+
+  std::vector<Op> mOps;
+
+  /// The world transform of the frame each root body is attached to
+  std::vector<Eigen::Isometry3s> mRootParentTransforms;
+
+  /// The DOFs that move each body, in increasing order
+  std::vector<std::vector<int>> mBodyDofs;
+
+  /// The relative Jacobian of each DOF, in the frame of the body its joint
+  /// moves. These only change from one evaluate() to the next for GENERIC
+  /// joints.
+  Eigen::Matrix<s_t, 6, Eigen::Dynamic> mRelativeJacobians;
+
+  /// The twist of each DOF in world coordinates, as of the last evaluate(),
+  /// with the linear part being the velocity of the point at the world origin
+  Eigen::Matrix<s_t, 6, Eigen::Dynamic> mWorldTwists;
+
+  std::vector<Eigen::Isometry3s> mWorldTransforms;
+
+  Eigen::VectorXs mPositions;
+
+  /// A private clone of the skeleton, which GENERIC operations run on. This
+  /// is nullptr if there aren't any.
+  SkeletonPtr mClone;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
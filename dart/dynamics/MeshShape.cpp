@@ -32,8 +32,10 @@
 
 #include "dart/dynamics/MeshShape.hpp"
 
+#include <chrono>
 #include <limits>
 #include <string>
+#include <unordered_map>
 
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/Importer.hpp>
@@ -44,6 +46,7 @@
 
 #include "dart/common/Console.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/config.hpp"
 #include "dart/dynamics/AssimpInputResourceAdaptor.hpp"
@@ -160,6 +163,27 @@ SharedMeshWrapper::~SharedMeshWrapper()
   aiReleaseImport(mesh);
 }
 
+//==============================================================================
+std::shared_ptr<const math::ConvexHull> SharedMeshWrapper::getConvexHull()
+{
+  std::lock_guard<std::mutex> lock(mConvexHullMutex);
+  if (!mConvexHull && mesh != nullptr)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    for (int s = 0; s < mesh->mNumMeshes; s++)
+    {
+      const aiMesh* m = mesh->mMeshes[s];
+      for (int v = 0; v < m->mNumVertices; v++)
+      {
+        aiVector3D vec = m->mVertices[v];
+        vertices.emplace_back(vec.x, vec.y, vec.z);
+      }
+    }
+    mConvexHull = std::make_shared<const math::ConvexHull>(vertices);
+  }
+  return mConvexHull;
+}
+
 //==============================================================================
 MeshShape::MeshShape(
     const Eigen::Vector3s& scale,
@@ -168,6 +192,7 @@ MeshShape::MeshShape(
     common::ResourceRetrieverPtr resourceRetriever,
     bool dontFreeMesh)
   : Shape(MESH),
+    mHasPendingMesh(false),
     mDisplayList(0),
     mColorMode(MATERIAL_COLOR),
     mAlphaMode(BLEND),
@@ -185,16 +210,34 @@ MeshShape::MeshShape(
     common::ResourceRetrieverPtr resourceRetriever,
     bool dontFreeMesh)
   : Shape(MESH),
+    mHasPendingMesh(false),
     mDisplayList(0),
     mColorMode(MATERIAL_COLOR),
     mAlphaMode(BLEND),
     mColorIndex(0),
     mDontFreeMesh(dontFreeMesh)
 {
-  setMesh(
-      resourceRetriever ? loadMesh(path, resourceRetriever) : loadMesh(path),
-      path,
-      std::move(resourceRetriever));
+  const LoadingMode mode = getDefaultLoadingMode();
+  if (mode == EAGER)
+  {
+    setMesh(
+        resourceRetriever ? loadMesh(path, resourceRetriever) : loadMesh(path),
+        path,
+        std::move(resourceRetriever));
+  }
+  else
+  {
+    auto load = [path, resourceRetriever]() {
+      return resourceRetriever ? loadMesh(path, resourceRetriever)
+                               : loadMesh(path);
+    };
+    setPendingMesh(
+        common::Uri(path),
+        std::async(
+            mode == ASYNC ? std::launch::async : std::launch::deferred, load)
+            .share(),
+        std::move(resourceRetriever));
+  }
   setScale(scale);
 }
 
@@ -203,6 +246,150 @@ MeshShape::~MeshShape()
 {
 }
 
+//==============================================================================
+std::shared_ptr<MeshShape> MeshShape::createFromUri(
+    const Eigen::Vector3s& scale,
+    const common::Uri& uri,
+    common::ResourceRetrieverPtr resourceRetriever)
+{
+  const LoadingMode mode = getDefaultLoadingMode();
+  if (mode == EAGER)
+  {
+    std::shared_ptr<SharedMeshWrapper> mesh
+        = loadMesh(uri, resourceRetriever);
+    if (!mesh)
+      return nullptr;
+    return std::make_shared<MeshShape>(
+        scale, mesh, uri, std::move(resourceRetriever));
+  }
+
+  // We can't know whether the mesh will parse without parsing it, but we can
+  // at least skip files that aren't there, like the eager path would.
+  if (!resourceRetriever || !resourceRetriever->exists(uri))
+    return nullptr;
+
+  std::shared_ptr<MeshShape> shape = std::make_shared<MeshShape>(
+      scale, std::shared_ptr<SharedMeshWrapper>(), uri, resourceRetriever);
+  auto load = [uri, resourceRetriever]() {
+    return loadMesh(uri, resourceRetriever);
+  };
+  shape->setPendingMesh(
+      uri,
+      std::async(
+          mode == ASYNC ? std::launch::async : std::launch::deferred, load)
+          .share(),
+      std::move(resourceRetriever));
+  return shape;
+}
+
+//==============================================================================
+namespace {
+
+std::atomic<MeshShape::LoadingMode> gDefaultLoadingMode(MeshShape::EAGER);
+
+/// The mode of the innermost ScopedLoadingMode on this thread, or -1 if there
+/// isn't one
+thread_local int gLoadingModeOverride = -1;
+
+} // namespace
+
+//==============================================================================
+void MeshShape::setDefaultLoadingMode(LoadingMode mode)
+{
+  gDefaultLoadingMode = mode;
+}
+
+//==============================================================================
+MeshShape::LoadingMode MeshShape::getDefaultLoadingMode()
+{
+  if (gLoadingModeOverride != -1)
+    return static_cast<LoadingMode>(gLoadingModeOverride);
+  return gDefaultLoadingMode;
+}
+
+//==============================================================================
+MeshShape::ScopedLoadingMode::ScopedLoadingMode(LoadingMode mode)
+  : mPrevious(gLoadingModeOverride)
+{
+  gLoadingModeOverride = mode;
+}
+
+//==============================================================================
+MeshShape::ScopedLoadingMode::~ScopedLoadingMode()
+{
+  gLoadingModeOverride = mPrevious;
+}
+
+//==============================================================================
+bool MeshShape::isMeshLoaded() const
+{
+  if (!mHasPendingMesh)
+    return true;
+  std::lock_guard<std::mutex> lock(mPendingMeshMutex);
+  if (!mHasPendingMesh)
+    return true;
+  // Lazy loads never finish on their own, so this only turns true for
+  // asynchronous loads that are done.
+  return mPendingMesh.wait_for(std::chrono::seconds(0))
+         == std::future_status::ready;
+}
+
+//==============================================================================
+void MeshShape::setPendingMesh(
+    const common::Uri& uri,
+    std::shared_future<std::shared_ptr<SharedMeshWrapper>> pendingMesh,
+    common::ResourceRetrieverPtr resourceRetriever)
+{
+  {
+    std::lock_guard<std::mutex> lock(mPendingMeshMutex);
+    mMesh = nullptr;
+    mPendingMesh = std::move(pendingMesh);
+    mHasPendingMesh = true;
+  }
+
+  mMeshUri = uri;
+  if (resourceRetriever)
+    mMeshPath = resourceRetriever->getFilePath(uri);
+  else
+    mMeshPath = uri.getFilesystemPath();
+  mResourceRetriever = std::move(resourceRetriever);
+
+  mIsBoundingBoxDirty = true;
+  mIsVolumeDirty = true;
+  incrementVersion();
+}
+
+//==============================================================================
+void MeshShape::resolvePendingMesh() const
+{
+  if (!mHasPendingMesh)
+    return;
+  std::lock_guard<std::mutex> lock(mPendingMeshMutex);
+  if (!mHasPendingMesh)
+    return;
+  mMesh = mPendingMesh.get();
+  mPendingMesh = std::shared_future<std::shared_ptr<SharedMeshWrapper>>();
+  mHasPendingMesh = false;
+}
+
+//==============================================================================
+void MeshShape::resolvePendingMeshes(
+    const std::vector<const MeshShape*>& shapes)
+{
+  std::vector<common::TaskFuture<void>> futures;
+  for (const MeshShape* shape : shapes)
+  {
+    if (shape == nullptr || !shape->mHasPendingMesh)
+      continue;
+    futures.push_back(
+        common::async([shape]() { shape->resolvePendingMesh(); }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+}
+
 //==============================================================================
 const std::string& MeshShape::getType() const
 {
@@ -236,9 +423,21 @@ std::vector<Eigen::Vector3s> MeshShape::getVertices() const
 //==============================================================================
 const aiScene* MeshShape::getMesh() const
 {
+  resolvePendingMesh();
+  if (!mMesh)
+    return nullptr;
   return mMesh->mesh;
 }
 
+//==============================================================================
+std::shared_ptr<const math::ConvexHull> MeshShape::getConvexHull() const
+{
+  resolvePendingMesh();
+  if (!mMesh)
+    return nullptr;
+  return mMesh->getConvexHull();
+}
+
 //==============================================================================
 std::string MeshShape::getMeshUri() const
 {
@@ -284,7 +483,12 @@ void MeshShape::setMesh(
     const common::Uri& uri,
     common::ResourceRetrieverPtr resourceRetriever)
 {
-  mMesh = mesh;
+  {
+    std::lock_guard<std::mutex> lock(mPendingMeshMutex);
+    mPendingMesh = std::shared_future<std::shared_ptr<SharedMeshWrapper>>();
+    mHasPendingMesh = false;
+    mMesh = mesh;
+  }
 
   if (!mMesh)
   {
@@ -384,8 +588,16 @@ Eigen::Matrix3s MeshShape::computeInertia(s_t _mass) const
 /// belonging to different skeletons
 ShapePtr MeshShape::clone() const
 {
+  std::lock_guard<std::mutex> lock(mPendingMeshMutex);
   std::shared_ptr<MeshShape> shape
       = std::make_shared<MeshShape>(mScale, mMesh, mMeshUri, nullptr, true);
+  if (mHasPendingMesh)
+  {
+    // Share the load that's already pending, rather than starting another
+    shape->mMeshUri = mMeshUri;
+    shape->mPendingMesh = mPendingMesh;
+    shape->mHasPendingMesh = true;
+  }
   shape->mMeshPath = mMeshPath;
   return shape;
 }
@@ -393,6 +605,7 @@ ShapePtr MeshShape::clone() const
 //==============================================================================
 void MeshShape::updateBoundingBox() const
 {
+  resolvePendingMesh();
   if (!mMesh)
   {
     mBoundingBox.setMin(Eigen::Vector3s::Zero());
@@ -444,7 +657,24 @@ void MeshShape::updateVolume() const
 }
 
 //==============================================================================
-std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
+namespace {
+
+struct MeshRegistry
+{
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<SharedMeshWrapper>> meshes;
+  std::atomic<bool> enabled{true};
+};
+
+MeshRegistry& getMeshRegistry()
+{
+  static MeshRegistry registry;
+  return registry;
+}
+
+/// This does the actual work of loadMesh(), without going through the
+/// registry.
+std::shared_ptr<SharedMeshWrapper> importMesh(
     const std::string& _uri, const common::ResourceRetrieverPtr& retriever)
 {
   // Remove points and lines from the import.
@@ -528,6 +758,146 @@ std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
   return std::make_shared<SharedMeshWrapper>(scene);
 }
 
+/// This loads a mesh through the registry, if it's enabled, without checking
+/// for a MeshPrefetch.
+std::shared_ptr<SharedMeshWrapper> loadRegisteredMesh(
+    const std::string& _uri, const common::ResourceRetrieverPtr& retriever)
+{
+  MeshRegistry& registry = getMeshRegistry();
+
+  // Key on the resolved file path, so different URIs for the same file share
+  // a mesh. URIs that don't resolve to a file (like in-memory retrievers)
+  // aren't shared, because the URI alone doesn't tell us what's behind them.
+  std::string key;
+  if (registry.enabled && retriever)
+    key = retriever->getFilePath(common::Uri(_uri));
+  if (key.empty())
+    return importMesh(_uri, retriever);
+
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.meshes.find(key);
+    if (it != registry.meshes.end())
+    {
+      std::shared_ptr<SharedMeshWrapper> mesh = it->second.lock();
+      if (mesh)
+        return mesh;
+    }
+  }
+
+  // Import without holding the lock, so different meshes can load in parallel
+  std::shared_ptr<SharedMeshWrapper> mesh = importMesh(_uri, retriever);
+  if (!mesh)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::weak_ptr<SharedMeshWrapper>& entry = registry.meshes[key];
+  std::shared_ptr<SharedMeshWrapper> existing = entry.lock();
+  // Another thread may have finished loading the same file while we were
+  if (existing)
+    return existing;
+  entry = mesh;
+
+  // Drop the entries for meshes that nobody is using anymore
+  for (auto it = registry.meshes.begin(); it != registry.meshes.end();)
+  {
+    if (it->second.expired())
+      it = registry.meshes.erase(it);
+    else
+      ++it;
+  }
+  return mesh;
+}
+
+/// The innermost MeshPrefetch alive on this thread, if any
+thread_local MeshPrefetch* gInnermostPrefetch = nullptr;
+
+} // namespace
+
+//==============================================================================
+std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
+    const std::string& _uri, const common::ResourceRetrieverPtr& retriever)
+{
+  std::shared_ptr<SharedMeshWrapper> mesh;
+  if (MeshPrefetch::find(_uri, retriever, mesh))
+    return mesh;
+
+  return loadRegisteredMesh(_uri, retriever);
+}
+
+//==============================================================================
+std::vector<std::shared_ptr<SharedMeshWrapper>> MeshShape::loadMeshes(
+    const std::vector<std::string>& uris,
+    const common::ResourceRetrieverPtr& retriever)
+{
+  // With the registry on, copies of the same URI would all end up sharing
+  // one mesh anyway, so only load each of them once
+  const bool shared = isMeshRegistryEnabled();
+  std::unordered_map<std::string, std::size_t> firstTasks;
+  std::vector<std::size_t> tasks(uris.size());
+  std::vector<common::TaskFuture<std::shared_ptr<SharedMeshWrapper>>> futures;
+  for (std::size_t i = 0; i < uris.size(); i++)
+  {
+    if (shared)
+    {
+      const auto inserted = firstTasks.emplace(uris[i], futures.size());
+      if (!inserted.second)
+      {
+        tasks[i] = inserted.first->second;
+        continue;
+      }
+    }
+
+    tasks[i] = futures.size();
+    const std::string& uri = uris[i];
+    futures.push_back(common::async(
+        [&uri, &retriever] { return loadRegisteredMesh(uri, retriever); }));
+  }
+
+  std::vector<std::shared_ptr<SharedMeshWrapper>> loaded;
+  loaded.reserve(futures.size());
+  for (auto& future : futures)
+    loaded.push_back(future.get());
+
+  std::vector<std::shared_ptr<SharedMeshWrapper>> meshes;
+  meshes.reserve(uris.size());
+  for (std::size_t task : tasks)
+    meshes.push_back(loaded[task]);
+  return meshes;
+}
+
+//==============================================================================
+void MeshShape::setMeshRegistryEnabled(bool enabled)
+{
+  MeshRegistry& registry = getMeshRegistry();
+  registry.enabled = enabled;
+  if (!enabled)
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.meshes.clear();
+  }
+}
+
+//==============================================================================
+bool MeshShape::isMeshRegistryEnabled()
+{
+  return getMeshRegistry().enabled;
+}
+
+//==============================================================================
+std::size_t MeshShape::getNumRegisteredMeshes()
+{
+  MeshRegistry& registry = getMeshRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::size_t count = 0;
+  for (const auto& pair : registry.meshes)
+  {
+    if (!pair.second.expired())
+      count++;
+  }
+  return count;
+}
+
 //==============================================================================
 std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
     const common::Uri& uri, const common::ResourceRetrieverPtr& retriever)
@@ -543,5 +913,57 @@ std::shared_ptr<SharedMeshWrapper> MeshShape::loadMesh(
   return loadMesh("file://" + filePath, retriever);
 }
 
+//==============================================================================
+MeshPrefetch::MeshPrefetch(
+    const std::vector<std::string>& uris,
+    const common::ResourceRetrieverPtr& retriever)
+  : mRetriever(retriever),
+    mShared(MeshShape::isMeshRegistryEnabled()),
+    mPrevious(gInnermostPrefetch)
+{
+  gInnermostPrefetch = this;
+
+  if (MeshShape::getDefaultLoadingMode() != MeshShape::EAGER)
+    return;
+
+  const std::vector<std::shared_ptr<SharedMeshWrapper>> meshes
+      = MeshShape::loadMeshes(uris, retriever);
+  for (std::size_t i = 0; i < uris.size(); i++)
+  {
+    std::deque<std::shared_ptr<SharedMeshWrapper>>& entry = mMeshes[uris[i]];
+    if (!mShared || entry.empty())
+      entry.push_back(meshes[i]);
+  }
+}
+
+//==============================================================================
+MeshPrefetch::~MeshPrefetch()
+{
+  // Prefetches are scoped, so they always come off in the reverse order they
+  // went on
+  assert(gInnermostPrefetch == this);
+  gInnermostPrefetch = mPrevious;
+}
+
+//==============================================================================
+bool MeshPrefetch::find(
+    const std::string& uri,
+    const common::ResourceRetrieverPtr& retriever,
+    std::shared_ptr<SharedMeshWrapper>& mesh)
+{
+  MeshPrefetch* prefetch = gInnermostPrefetch;
+  if (prefetch == nullptr || prefetch->mRetriever != retriever)
+    return false;
+
+  const auto it = prefetch->mMeshes.find(uri);
+  if (it == prefetch->mMeshes.end() || it->second.empty())
+    return false;
+
+  mesh = it->second.front();
+  if (!prefetch->mShared)
+    it->second.pop_front();
+  return true;
+}
+
 } // namespace dynamics
 } // namespace dart
\ No newline at end of file
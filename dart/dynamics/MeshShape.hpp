@@ -33,13 +33,20 @@
 #ifndef DART_DYNAMICS_MESHSHAPE_HPP_
 #define DART_DYNAMICS_MESHSHAPE_HPP_
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <assimp/scene.h>
 
 #include "dart/common/ResourceRetriever.hpp"
 #include "dart/dynamics/Shape.hpp"
+#include "dart/math/ConvexHull.hpp"
 
 namespace dart {
 namespace dynamics {
@@ -50,6 +57,15 @@ struct SharedMeshWrapper
   ~SharedMeshWrapper();
 
   const aiScene* mesh;
+
+  /// This returns the convex hull of the vertices of `mesh`, building it the
+  /// first time it's asked for. Clones of a MeshShape share their
+  /// SharedMeshWrapper, so they also share the hull.
+  std::shared_ptr<const math::ConvexHull> getConvexHull();
+
+protected:
+  std::mutex mConvexHullMutex;
+  std::shared_ptr<const math::ConvexHull> mConvexHull;
 };
 
 class MeshShape : public Shape
@@ -85,6 +101,22 @@ public:
     SHAPE_ALPHA
   };
 
+  /// How a MeshShape that's given a URI (rather than an already loaded mesh)
+  /// gets its mesh.
+  enum LoadingMode
+  {
+    /// Load the mesh in the constructor. This is the default.
+    EAGER = 0,
+
+    /// Load the mesh on the calling thread the first time it's needed, which
+    /// is usually the first render or the first collision query.
+    LAZY,
+
+    /// Start loading the mesh on a background thread in the constructor, and
+    /// block on it the first time it's needed.
+    ASYNC
+  };
+
   /// Constructor.
   MeshShape(
       const Eigen::Vector3s& scale,
@@ -102,6 +134,49 @@ public:
   /// Destructor.
   ~MeshShape() override;
 
+  /// This creates a MeshShape for the mesh at `uri`, loading it according to
+  /// getDefaultLoadingMode(). This returns nullptr if the mesh fails to load
+  /// eagerly, or if it doesn't exist when loading lazily or asynchronously.
+  static std::shared_ptr<MeshShape> createFromUri(
+      const Eigen::Vector3s& scale,
+      const common::Uri& uri,
+      common::ResourceRetrieverPtr resourceRetriever);
+
+  /// Sets how MeshShapes constructed from a URI load their meshes from now
+  /// on. Shapes that already exist are unaffected.
+  static void setDefaultLoadingMode(LoadingMode mode);
+
+  /// Returns how MeshShapes constructed from a URI load their meshes. That's
+  /// the mode of the innermost ScopedLoadingMode on this thread, if there is
+  /// one, or else the mode passed to setDefaultLoadingMode().
+  static LoadingMode getDefaultLoadingMode();
+
+  /// While one of these is alive, MeshShapes constructed from a URI on the
+  /// current thread load their meshes with `mode`, without changing the
+  /// default for other threads. These can be nested.
+  class ScopedLoadingMode
+  {
+  public:
+    ScopedLoadingMode(LoadingMode mode);
+    ~ScopedLoadingMode();
+
+    ScopedLoadingMode(const ScopedLoadingMode&) = delete;
+    ScopedLoadingMode& operator=(const ScopedLoadingMode&) = delete;
+
+  protected:
+    /// The override this one replaced, or -1 if there wasn't one
+    int mPrevious;
+  };
+
+  /// Returns false if this shape's mesh is still waiting to be loaded lazily
+  /// or asynchronously.
+  bool isMeshLoaded() const;
+
+  /// This finishes loading the mesh of every shape in `shapes` that's still
+  /// waiting to be loaded lazily or asynchronously, in parallel, rather than
+  /// one at a time as each one is first used.
+  static void resolvePendingMeshes(const std::vector<const MeshShape*>& shapes);
+
   // Documentation inherited.
   const std::string& getType() const override;
 
@@ -112,6 +187,12 @@ public:
 
   std::vector<Eigen::Vector3s> getVertices() const;
 
+  /// Returns the convex hull of the (unscaled) vertices of this mesh, which
+  /// is what the DART collision detector actually collides against. This is
+  /// built the first time it's asked for and then cached, so the vertices of
+  /// the mesh must not change after that. Returns nullptr if there's no mesh.
+  std::shared_ptr<const math::ConvexHull> getConvexHull() const;
+
   /// Updates positions of the vertices or the elements. By default, this does
   /// nothing; you must extend the MeshShape class and implement your own
   /// version of this function if you want the mesh data to get updated before
@@ -179,6 +260,29 @@ public:
   static std::shared_ptr<SharedMeshWrapper> loadMesh(
       const common::Uri& uri, const common::ResourceRetrieverPtr& retriever);
 
+  /// This loads every mesh in `uris` at once, on the global TaskScheduler,
+  /// and returns them in the same order, with nullptr for any that fail to
+  /// load. While the registry is enabled, each distinct URI is only loaded
+  /// once.
+  static std::vector<std::shared_ptr<SharedMeshWrapper>> loadMeshes(
+      const std::vector<std::string>& uris,
+      const common::ResourceRetrieverPtr& retriever);
+
+  /// By default, loadMesh() keeps a registry of every mesh that's currently
+  /// alive, keyed by the file path that its URI resolves to, and returns the
+  /// already loaded mesh when the same file is asked for again. This lets
+  /// many skeletons that share the same geometry share a single aiScene.
+  /// Entries are dropped as soon as the last MeshShape using them goes away,
+  /// so turn this off if you need to pick up changes to a mesh file while an
+  /// older copy of it is still in use.
+  static void setMeshRegistryEnabled(bool enabled);
+
+  /// Returns whether loadMesh() is sharing meshes through the registry.
+  static bool isMeshRegistryEnabled();
+
+  /// Returns the number of distinct meshes currently alive in the registry.
+  static std::size_t getNumRegisteredMeshes();
+
   // Documentation inherited.
   Eigen::Matrix3s computeInertia(s_t mass) const override;
 
@@ -193,7 +297,27 @@ protected:
   // Documentation inherited.
   void updateVolume() const override;
 
-  std::shared_ptr<SharedMeshWrapper> mMesh;
+  /// Sets this shape up to take the mesh at `uri` from `pendingMesh` the
+  /// first time it's needed.
+  void setPendingMesh(
+      const common::Uri& uri,
+      std::shared_future<std::shared_ptr<SharedMeshWrapper>> pendingMesh,
+      common::ResourceRetrieverPtr resourceRetriever);
+
+  /// If there's a mesh waiting to be loaded, this waits for it and moves it
+  /// into mMesh.
+  void resolvePendingMesh() const;
+
+  mutable std::shared_ptr<SharedMeshWrapper> mMesh;
+
+  /// The mesh that's still loading, lazily or asynchronously, if any
+  mutable std::shared_future<std::shared_ptr<SharedMeshWrapper>> mPendingMesh;
+
+  /// This is checked before taking mPendingMeshMutex, so that shapes that
+  /// have already loaded their meshes don't pay for a lock on every query.
+  mutable std::atomic<bool> mHasPendingMesh;
+
+  mutable std::mutex mPendingMeshMutex;
 
   /// URI the mesh, if available).
   common::Uri mMeshUri;
@@ -224,6 +348,56 @@ protected:
   bool mDontFreeMesh;
 };
 
+/// A MeshPrefetch is for parsers, which find the meshes a model uses one at a
+/// time as they walk the model tree. A parser can collect the URIs of all of
+/// them first, and hand them to a MeshPrefetch, which loads them in parallel
+/// with MeshShape::loadMeshes(). For as long as the MeshPrefetch is alive,
+/// MeshShape::loadMesh() calls on the same thread, with the same retriever,
+/// return the meshes it loaded (including any failures, as nullptr) instead
+/// of loading them again. So the parser can attach its shapes exactly the way
+/// it did before, and end up with the same result.
+///
+/// Since parsing is what it's meant to speed up, this does nothing unless the
+/// default loading mode is EAGER; the other modes already keep mesh loading
+/// off of the parser's path.
+class MeshPrefetch
+{
+public:
+  MeshPrefetch(
+      const std::vector<std::string>& uris,
+      const common::ResourceRetrieverPtr& retriever);
+
+  ~MeshPrefetch();
+
+  MeshPrefetch(const MeshPrefetch&) = delete;
+  MeshPrefetch& operator=(const MeshPrefetch&) = delete;
+
+  /// If the innermost MeshPrefetch alive on this thread loaded `uri` with
+  /// `retriever`, this sets `mesh` to the result and returns true. Otherwise
+  /// this returns false.
+  static bool find(
+      const std::string& uri,
+      const common::ResourceRetrieverPtr& retriever,
+      std::shared_ptr<SharedMeshWrapper>& mesh);
+
+protected:
+  common::ResourceRetrieverPtr mRetriever;
+
+  /// The meshes we loaded for each URI. While the registry is enabled there's
+  /// just one per URI. Otherwise there's one for every time the URI was
+  /// listed, and find() hands them out in turn, so that every shape still
+  /// gets its own copy, like it would have without us.
+  std::unordered_map<
+      std::string,
+      std::deque<std::shared_ptr<SharedMeshWrapper>>>
+      mMeshes;
+
+  bool mShared;
+
+  /// The MeshPrefetch that was innermost on this thread before this one
+  MeshPrefetch* mPrevious;
+};
+
 } // namespace dynamics
 } // namespace dart
 
@@ -35,6 +35,8 @@
 #include <algorithm>
 #include "dart/common/Console.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/IndexPlan.hpp"
+#include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/JacobianNode.hpp"
 
 namespace dart {
@@ -202,11 +204,21 @@ static Eigen::VectorXs getValuesFromVector(
 
 //==============================================================================
 template <s_t (DegreeOfFreedom::*getValue)() const>
-static Eigen::VectorXs getValuesFromAllDofs(
-    const MetaSkeleton* skel, const std::string& _fname)
+static void getValuesFromAllDofsInto(
+    const MetaSkeleton* skel,
+    Eigen::Ref<Eigen::VectorXs> values,
+    const std::string& _fname)
 {
   std::size_t nDofs = skel->getNumDofs();
-  Eigen::VectorXs values(nDofs);
+  if(static_cast<std::size_t>(values.size()) != nDofs)
+  {
+    dterr << "[MetaSkeleton::" << _fname << "] Output has size ("
+          << values.size() << "), but the Skeleton named [" << skel->getName()
+          << "] (" << skel << ") has " << nDofs << " DOFs. Nothing will be "
+          << "written!\n";
+    assert(false);
+    return;
+  }
 
   for(std::size_t i=0; i<nDofs; ++i)
   {
@@ -225,7 +237,15 @@ static Eigen::VectorXs getValuesFromAllDofs(
       assert(false);
     }
   }
+}
 
+//==============================================================================
+template <s_t (DegreeOfFreedom::*getValue)() const>
+static Eigen::VectorXs getValuesFromAllDofs(
+    const MetaSkeleton* skel, const std::string& _fname)
+{
+  Eigen::VectorXs values(skel->getNumDofs());
+  getValuesFromAllDofsInto<getValue>(skel, values, _fname);
   return values;
 }
 
@@ -407,6 +427,13 @@ Eigen::VectorXs MetaSkeleton::getPositions() const
         this, "getPositions");
 }
 
+//==============================================================================
+void MetaSkeleton::getPositionsInto(Eigen::Ref<Eigen::VectorXs> out) const
+{
+  getValuesFromAllDofsInto<&DegreeOfFreedom::getPosition>(
+        this, out, "getPositionsInto");
+}
+
 //==============================================================================
 Eigen::VectorXs MetaSkeleton::getPositions(const std::vector<std::size_t>& _indices) const
 {
@@ -414,6 +441,21 @@ Eigen::VectorXs MetaSkeleton::getPositions(const std::vector<std::size_t>& _indi
         this, _indices, "getPositions");
 }
 
+//==============================================================================
+void MetaSkeleton::setPositions(
+    const IndexPlan& plan, const Eigen::VectorXs& _positions)
+{
+  plan.scatter(&Joint::getPositions, &Joint::setPositions, _positions);
+}
+
+//==============================================================================
+Eigen::VectorXs MetaSkeleton::getPositions(const IndexPlan& plan) const
+{
+  Eigen::VectorXs values(plan.getNumDofs());
+  plan.gather(&Joint::getPositions, values);
+  return values;
+}
+
 //==============================================================================
 void MetaSkeleton::resetPositions()
 {
@@ -546,6 +588,13 @@ Eigen::VectorXs MetaSkeleton::getVelocities() const
         this, "getVelocities");
 }
 
+//==============================================================================
+void MetaSkeleton::getVelocitiesInto(Eigen::Ref<Eigen::VectorXs> out) const
+{
+  getValuesFromAllDofsInto<&DegreeOfFreedom::getVelocity>(
+        this, out, "getVelocitiesInto");
+}
+
 //==============================================================================
 Eigen::VectorXs MetaSkeleton::getVelocities(const std::vector<std::size_t>& _indices) const
 {
@@ -553,6 +602,21 @@ Eigen::VectorXs MetaSkeleton::getVelocities(const std::vector<std::size_t>& _ind
         this, _indices, "getVelocities");
 }
 
+//==============================================================================
+void MetaSkeleton::setVelocities(
+    const IndexPlan& plan, const Eigen::VectorXs& _velocities)
+{
+  plan.scatter(&Joint::getVelocities, &Joint::setVelocities, _velocities);
+}
+
+//==============================================================================
+Eigen::VectorXs MetaSkeleton::getVelocities(const IndexPlan& plan) const
+{
+  Eigen::VectorXs values(plan.getNumDofs());
+  plan.gather(&Joint::getVelocities, values);
+  return values;
+}
+
 //==============================================================================
 void MetaSkeleton::resetVelocities()
 {
@@ -683,6 +747,13 @@ Eigen::VectorXs MetaSkeleton::getAccelerations() const
         this, "getAccelerations");
 }
 
+//==============================================================================
+void MetaSkeleton::getAccelerationsInto(Eigen::Ref<Eigen::VectorXs> out) const
+{
+  getValuesFromAllDofsInto<&DegreeOfFreedom::getAcceleration>(
+        this, out, "getAccelerationsInto");
+}
+
 //==============================================================================
 Eigen::VectorXs MetaSkeleton::getAccelerations(
     const std::vector<std::size_t>& _indices) const
@@ -691,6 +762,22 @@ Eigen::VectorXs MetaSkeleton::getAccelerations(
         this, _indices, "getAccelerations");
 }
 
+//==============================================================================
+void MetaSkeleton::setAccelerations(
+    const IndexPlan& plan, const Eigen::VectorXs& _accelerations)
+{
+  plan.scatter(
+      &Joint::getAccelerations, &Joint::setAccelerations, _accelerations);
+}
+
+//==============================================================================
+Eigen::VectorXs MetaSkeleton::getAccelerations(const IndexPlan& plan) const
+{
+  Eigen::VectorXs values(plan.getNumDofs());
+  plan.gather(&Joint::getAccelerations, values);
+  return values;
+}
+
 //==============================================================================
 void MetaSkeleton::resetAccelerations()
 {
@@ -827,6 +914,13 @@ Eigen::VectorXs MetaSkeleton::getControlForces() const
         this, "getControlForces");
 }
 
+//==============================================================================
+void MetaSkeleton::getControlForcesInto(Eigen::Ref<Eigen::VectorXs> out) const
+{
+  getValuesFromAllDofsInto<&DegreeOfFreedom::getControlForce>(
+        this, out, "getControlForcesInto");
+}
+
 //==============================================================================
 Eigen::VectorXs MetaSkeleton::getControlForces(const std::vector<std::size_t>& _indices) const
 {
@@ -834,6 +928,21 @@ Eigen::VectorXs MetaSkeleton::getControlForces(const std::vector<std::size_t>& _
         this, _indices, "getControlForces");
 }
 
+//==============================================================================
+void MetaSkeleton::setControlForces(
+    const IndexPlan& plan, const Eigen::VectorXs& _forces)
+{
+  plan.scatter(&Joint::getControlForces, &Joint::setControlForces, _forces);
+}
+
+//==============================================================================
+Eigen::VectorXs MetaSkeleton::getControlForces(const IndexPlan& plan) const
+{
+  Eigen::VectorXs values(plan.getNumDofs());
+  plan.gather(&Joint::getControlForces, values);
+  return values;
+}
+
 //==============================================================================
 void MetaSkeleton::resetGeneralizedForces()
 {
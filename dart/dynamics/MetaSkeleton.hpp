@@ -53,6 +53,7 @@ class SoftBodyNode;
 class PointMass;
 class Joint;
 class DegreeOfFreedom;
+class IndexPlan;
 class Marker;
 
 /// MetaSkeleton is a pure abstract base class that provides a common interface
@@ -265,18 +266,31 @@ public:
   s_t getPosition(std::size_t _index) const;
 
   /// Set the positions for all generalized coordinates
-  void setPositions(const Eigen::VectorXs& _positions);
+  virtual void setPositions(const Eigen::VectorXs& _positions);
 
   /// Set the positions for a subset of the generalized coordinates
-  void setPositions(const std::vector<std::size_t>& _indices,
-                    const Eigen::VectorXs& _positions);
+  virtual void setPositions(const std::vector<std::size_t>& _indices,
+                            const Eigen::VectorXs& _positions);
 
   /// Get the positions for all generalized coordinates
   Eigen::VectorXs getPositions() const;
 
+  /// Same as getPositions(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getPositionsInto(Eigen::Ref<Eigen::VectorXs> out) const;
+
   /// Get the positions for a subset of the generalized coordinates
   Eigen::VectorXs getPositions(const std::vector<std::size_t>& _indices) const;
 
+  /// Set the positions of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  virtual void setPositions(
+      const IndexPlan& plan, const Eigen::VectorXs& _positions);
+
+  /// Get the positions of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  Eigen::VectorXs getPositions(const IndexPlan& plan) const;
+
   /// Set all positions to zero
   void resetPositions();
 
@@ -342,9 +356,22 @@ public:
   /// Get the velocities for all generalized coordinates
   Eigen::VectorXs getVelocities() const;
 
+  /// Same as getVelocities(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getVelocitiesInto(Eigen::Ref<Eigen::VectorXs> out) const;
+
   /// Get the velocities for a subset of the generalized coordinates
   Eigen::VectorXs getVelocities(const std::vector<std::size_t>& _indices) const;
 
+  /// Set the velocities of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  void setVelocities(
+      const IndexPlan& plan, const Eigen::VectorXs& _velocities);
+
+  /// Get the velocities of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  Eigen::VectorXs getVelocities(const IndexPlan& plan) const;
+
   /// Set all velocities to zero
   void resetVelocities();
 
@@ -414,9 +441,22 @@ public:
   /// Get the accelerations for all generalized coordinates
   Eigen::VectorXs getAccelerations() const;
 
+  /// Same as getAccelerations(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getAccelerationsInto(Eigen::Ref<Eigen::VectorXs> out) const;
+
   /// Get the accelerations for a subset of the generalized coordinates
   Eigen::VectorXs getAccelerations(const std::vector<std::size_t>& _indices) const;
 
+  /// Set the accelerations of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  void setAccelerations(
+      const IndexPlan& plan, const Eigen::VectorXs& _accelerations);
+
+  /// Get the accelerations of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  Eigen::VectorXs getAccelerations(const IndexPlan& plan) const;
+
   /// Set all accelerations to zero
   void resetAccelerations();
 
@@ -486,9 +526,21 @@ public:
   /// Get the forces for all generalized coordinates
   Eigen::VectorXs getControlForces() const;
 
+  /// Same as getControlForces(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getControlForcesInto(Eigen::Ref<Eigen::VectorXs> out) const;
+
   /// Get the forces for a subset of the generalized coordinates
   Eigen::VectorXs getControlForces(const std::vector<std::size_t>& _indices) const;
 
+  /// Set the forces of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  void setControlForces(const IndexPlan& plan, const Eigen::VectorXs& _forces);
+
+  /// Get the forces of the DOFs in `plan`, which must have been compiled
+  /// for this MetaSkeleton
+  Eigen::VectorXs getControlForces(const IndexPlan& plan) const;
+
   /// Set all forces of the generalized coordinates to zero
   void resetGeneralizedForces();
 
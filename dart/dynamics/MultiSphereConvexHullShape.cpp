@@ -32,6 +32,11 @@
 
 #include "dart/dynamics/MultiSphereConvexHullShape.hpp"
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+
 #include "dart/common/Console.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/math/Helpers.hpp"
@@ -39,6 +44,21 @@
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+//==============================================================================
+std::vector<Eigen::Vector3s> getCenters(
+    const MultiSphereConvexHullShape::Spheres& spheres)
+{
+  std::vector<Eigen::Vector3s> centers;
+  centers.reserve(spheres.size());
+  for (const auto& sphere : spheres)
+    centers.push_back(sphere.second);
+  return centers;
+}
+
+} // anonymous namespace
+
 //==============================================================================
 MultiSphereConvexHullShape::MultiSphereConvexHullShape(const Spheres& spheres)
   : Shape(MULTISPHERE)
@@ -70,6 +90,7 @@ void MultiSphereConvexHullShape::addSpheres(
     const MultiSphereConvexHullShape::Spheres& spheres)
 {
   mSpheres.insert(mSpheres.end(), spheres.begin(), spheres.end());
+  dirtySupportCache();
 
   mIsBoundingBoxDirty = true;
   mIsVolumeDirty = true;
@@ -82,6 +103,7 @@ void MultiSphereConvexHullShape::addSphere(
     const MultiSphereConvexHullShape::Sphere& sphere)
 {
   mSpheres.push_back(sphere);
+  dirtySupportCache();
 
   mIsBoundingBoxDirty = true;
   mIsVolumeDirty = true;
@@ -100,6 +122,7 @@ void MultiSphereConvexHullShape::addSphere(
 void MultiSphereConvexHullShape::removeAllSpheres()
 {
   mSpheres.clear();
+  dirtySupportCache();
 
   mIsBoundingBoxDirty = true;
   mIsVolumeDirty = true;
@@ -120,6 +143,82 @@ MultiSphereConvexHullShape::getSpheres() const
   return mSpheres;
 }
 
+//==============================================================================
+int MultiSphereConvexHullShape::getSupportSphereIndex(
+    const Eigen::Vector3s& dir, int hint) const
+{
+  if (mSpheres.empty())
+    return -1;
+
+  const s_t dirNorm = dir.norm();
+  auto score = [&](int sphere) {
+    return mSpheres[sphere].second.dot(dir) + mSpheres[sphere].first * dirNorm;
+  };
+
+  const std::shared_ptr<const SupportCache> cache = getSupportCache();
+  if (cache->hull.isDegenerate())
+  {
+    int best = 0;
+    for (int i = 1; i < static_cast<int>(mSpheres.size()); i++)
+      if (score(i) > score(best))
+        best = i;
+    return best;
+  }
+
+  int hintVertex = -1;
+  if (hint >= 0 && hint < static_cast<int>(cache->sphereVertices.size()))
+    hintVertex = cache->sphereVertices[hint];
+  const int top = cache->hull.getSupportIndex(dir, hintVertex);
+
+  // A sphere on another hull vertex can only beat the one on `top` if its
+  // center is less than the radius spread behind `top`. The vertices that
+  // close to the top form a connected patch of the hull, so we flood out
+  // from `top` to find them. With equal radii, that's just `top`.
+  const std::vector<Eigen::Vector3s>& vertices = cache->hull.getVertices();
+  const s_t threshold
+      = vertices[top].dot(dir) - cache->radiusSpread * dirNorm;
+  int best = cache->vertexSpheres[top];
+  std::vector<int> open{top};
+  std::vector<int> visited{top};
+  while (!open.empty())
+  {
+    const int vertex = open.back();
+    open.pop_back();
+    for (int neighbor : cache->hull.getNeighbors(vertex))
+    {
+      if (std::find(visited.begin(), visited.end(), neighbor) != visited.end())
+        continue;
+      visited.push_back(neighbor);
+      if (vertices[neighbor].dot(dir) < threshold)
+        continue;
+      open.push_back(neighbor);
+      if (score(cache->vertexSpheres[neighbor]) > score(best))
+        best = cache->vertexSpheres[neighbor];
+    }
+  }
+
+  for (int sphere : cache->interiorSpheres)
+    if (score(sphere) > score(best))
+      best = sphere;
+
+  return best;
+}
+
+//==============================================================================
+Eigen::Vector3s MultiSphereConvexHullShape::getSupport(
+    const Eigen::Vector3s& dir, int hint) const
+{
+  const int index = getSupportSphereIndex(dir, hint);
+  if (index < 0)
+    return Eigen::Vector3s::Zero();
+
+  const Sphere& sphere = mSpheres[index];
+  const s_t dirNorm = dir.norm();
+  if (dirNorm == 0)
+    return sphere.second;
+  return sphere.second + sphere.first * dir / dirNorm;
+}
+
 //==============================================================================
 Eigen::Matrix3s MultiSphereConvexHullShape::computeInertia(s_t mass) const
 {
@@ -165,5 +264,67 @@ void MultiSphereConvexHullShape::updateVolume() const
   mIsVolumeDirty = false;
 }
 
+//==============================================================================
+MultiSphereConvexHullShape::SupportCache::SupportCache(const Spheres& spheres)
+  : hull(getCenters(spheres)), radiusSpread(0)
+{
+  const std::vector<Eigen::Vector3s>& vertices = hull.getVertices();
+  std::map<std::array<s_t, 3>, int> vertexIndices;
+  for (int v = 0; v < static_cast<int>(vertices.size()); v++)
+    vertexIndices[{vertices[v](0), vertices[v](1), vertices[v](2)}] = v;
+
+  // The hull keeps exact copies of the input points, so every sphere
+  // centered on a vertex finds it here
+  vertexSpheres.resize(vertices.size(), -1);
+  sphereVertices.resize(spheres.size(), -1);
+  for (int i = 0; i < static_cast<int>(spheres.size()); i++)
+  {
+    const Eigen::Vector3s& center = spheres[i].second;
+    const auto it = vertexIndices.find({center(0), center(1), center(2)});
+    if (it == vertexIndices.end())
+      continue;
+
+    const int v = it->second;
+    sphereVertices[i] = v;
+    if (vertexSpheres[v] < 0
+        || spheres[i].first > spheres[vertexSpheres[v]].first)
+      vertexSpheres[v] = i;
+  }
+
+  s_t minRadius = std::numeric_limits<s_t>::infinity();
+  s_t maxRadius = -std::numeric_limits<s_t>::infinity();
+  for (int sphere : vertexSpheres)
+  {
+    minRadius = std::min(minRadius, spheres[sphere].first);
+    maxRadius = std::max(maxRadius, spheres[sphere].first);
+  }
+  if (!vertexSpheres.empty())
+    radiusSpread = maxRadius - minRadius;
+
+  // Any other sphere has its center inside the hull, so it's no further
+  // along any direction than the furthest vertex. If it's no bigger than the
+  // smallest vertex sphere either, it can never stick out past them.
+  for (int i = 0; i < static_cast<int>(spheres.size()); i++)
+    if (sphereVertices[i] < 0 && spheres[i].first > minRadius)
+      interiorSpheres.push_back(i);
+}
+
+//==============================================================================
+std::shared_ptr<const MultiSphereConvexHullShape::SupportCache>
+MultiSphereConvexHullShape::getSupportCache() const
+{
+  std::lock_guard<std::mutex> lock(mSupportCacheMutex);
+  if (!mSupportCache)
+    mSupportCache = std::make_shared<const SupportCache>(mSpheres);
+  return mSupportCache;
+}
+
+//==============================================================================
+void MultiSphereConvexHullShape::dirtySupportCache()
+{
+  std::lock_guard<std::mutex> lock(mSupportCacheMutex);
+  mSupportCache.reset();
+}
+
 } // namespace dynamics
 } // namespace dart
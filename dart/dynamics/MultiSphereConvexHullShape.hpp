@@ -33,9 +33,12 @@
 #ifndef DART_DYNAMICS_MULTISPHERECONVEXHULLSHAPE_HPP_
 #define DART_DYNAMICS_MULTISPHERECONVEXHULLSHAPE_HPP_
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "dart/dynamics/Shape.hpp"
+#include "dart/math/ConvexHull.hpp"
 
 namespace dart {
 namespace dynamics {
@@ -78,6 +81,23 @@ public:
   /// Get the set of spheres
   const Spheres& getSpheres() const;
 
+  /// Returns the index of a sphere whose surface reaches furthest along
+  /// `dir`, or -1 if there aren't any spheres. The support point of the shape
+  /// along `dir` is on that sphere.
+  ///
+  /// Rather than checking every sphere, this walks the convex hull of the
+  /// sphere centers (built the first time it's needed, and cached until the
+  /// spheres change) the same way math::ConvexHull::getSupportIndex() does,
+  /// and then only checks the spheres whose bigger radius could make up for
+  /// their centers being further back. If `hint` is the answer to a recent
+  /// query along a similar direction, the walk starts from there, which
+  /// usually makes it only a step or two.
+  int getSupportSphereIndex(const Eigen::Vector3s& dir, int hint = -1) const;
+
+  /// Returns a point on the shape that is furthest along `dir`. See
+  /// getSupportSphereIndex() for what `hint` means.
+  Eigen::Vector3s getSupport(const Eigen::Vector3s& dir, int hint = -1) const;
+
   /// Compute the inertia of this MultiSphereConvexHullShape.
   ///
   /// \note The return value is an approximated inertia that is the inertia of
@@ -98,9 +118,41 @@ protected:
   /// the axis-alinged bounding box of this MultiSphereConvexHullShape.
   void updateVolume() const override;
 
+  /// What getSupportSphereIndex() needs to know about the sphere centers
+  struct SupportCache
+  {
+    /// The convex hull of the sphere centers
+    math::ConvexHull hull;
+
+    /// For each hull vertex, the biggest sphere centered there
+    std::vector<int> vertexSpheres;
+
+    /// For each sphere, the hull vertex it's centered on, or -1
+    std::vector<int> sphereVertices;
+
+    /// The spheres that aren't centered on a hull vertex, but are bigger than
+    /// the smallest of the vertexSpheres, so could still stick out furthest
+    std::vector<int> interiorSpheres;
+
+    /// The biggest radius of the vertexSpheres minus the smallest one
+    s_t radiusSpread;
+
+    explicit SupportCache(const Spheres& spheres);
+  };
+
+  /// Returns the SupportCache for the current spheres, building it if needed
+  std::shared_ptr<const SupportCache> getSupportCache() const;
+
+  /// Forget the SupportCache, because the spheres changed
+  void dirtySupportCache();
+
 private:
   /// Spheres
   Spheres mSpheres;
+
+  mutable std::shared_ptr<const SupportCache> mSupportCache;
+
+  mutable std::mutex mSupportCacheMutex;
 };
 
 DART_DEPRECATED(6.2)
@@ -32,11 +32,31 @@
 
 #include "dart/dynamics/PointCloudShape.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
 #include "dart/common/Console.hpp"
 
 namespace dart {
 namespace dynamics {
 
+namespace {
+
+//==============================================================================
+/// Packs voxel coordinates into one key. Each coordinate gets 21 bits, which
+/// is enough for a million voxels either side of the origin.
+std::uint64_t packVoxel(const Eigen::Vector3i& voxel)
+{
+  const std::uint64_t mask = (1ull << 21) - 1;
+  return ((static_cast<std::uint64_t>(voxel.x()) & mask) << 42)
+         | ((static_cast<std::uint64_t>(voxel.y()) & mask) << 21)
+         | (static_cast<std::uint64_t>(voxel.z()) & mask);
+}
+
+} // namespace
+
 #if HAVE_OCTOMAP
 
 namespace {
@@ -56,7 +76,8 @@ PointCloudShape::PointCloudShape(s_t visualSize)
   : Shape(),
     mPointShapeType(BOX),
     mColorMode(USE_SHAPE_COLOR),
-    mVisualSize(visualSize)
+    mVisualSize(visualSize),
+    mIndexVoxelSize(0.1)
 {
   // Do nothing
 }
@@ -90,6 +111,8 @@ void PointCloudShape::reserve(std::size_t size)
 void PointCloudShape::addPoint(const Eigen::Vector3s& point)
 {
   mPoints.emplace_back(point);
+  indexPoint(mPoints.size() - 1);
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 
@@ -98,7 +121,11 @@ void PointCloudShape::addPoint(const std::vector<Eigen::Vector3s>& points)
 {
   mPoints.reserve(mPoints.size() + points.size());
   for (const auto& point : points)
+  {
     mPoints.emplace_back(point);
+    indexPoint(mPoints.size() - 1);
+  }
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 
@@ -106,6 +133,8 @@ void PointCloudShape::addPoint(const std::vector<Eigen::Vector3s>& points)
 void PointCloudShape::setPoint(const std::vector<Eigen::Vector3s>& points)
 {
   mPoints = points;
+  rebuildIndex();
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 
@@ -116,6 +145,8 @@ void PointCloudShape::setPoints(octomap::Pointcloud& pointCloud)
   mPoints.resize(pointCloud.size());
   for (auto i = 0u; i < mPoints.size(); ++i)
     mPoints[i] = toVector3s(pointCloud[i]);
+  rebuildIndex();
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 
@@ -124,7 +155,11 @@ void PointCloudShape::addPoints(octomap::Pointcloud& pointCloud)
 {
   mPoints.reserve(mPoints.size() + pointCloud.size());
   for (const auto& point : pointCloud)
+  {
     mPoints.emplace_back(toVector3s(point));
+    indexPoint(mPoints.size() - 1);
+  }
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 #endif
@@ -145,6 +180,8 @@ std::size_t PointCloudShape::getNumPoints() const
 void PointCloudShape::removeAllPoints()
 {
   mPoints.clear();
+  mVoxels.clear();
+  mIsBoundingBoxDirty = true;
 }
 
 //==============================================================================
@@ -223,6 +260,8 @@ PointCloudShape::getColors() const
 void PointCloudShape::setVisualSize(s_t size)
 {
   mVisualSize = size;
+  rebuildIndex();
+  mIsBoundingBoxDirty = true;
   incrementVersion();
 }
 
@@ -232,12 +271,240 @@ s_t PointCloudShape::getVisualSize() const
   return mVisualSize;
 }
 
+//==============================================================================
+void PointCloudShape::setIndexVoxelSize(s_t size)
+{
+  assert(size > 0);
+  mIndexVoxelSize = size;
+  rebuildIndex();
+}
+
+//==============================================================================
+s_t PointCloudShape::getIndexVoxelSize() const
+{
+  return mIndexVoxelSize;
+}
+
+//==============================================================================
+std::vector<std::size_t> PointCloudShape::getPointsInBox(
+    const Eigen::Vector3s& min, const Eigen::Vector3s& max) const
+{
+  std::vector<std::size_t> indices;
+  if (mPoints.empty())
+    return indices;
+
+  // There's nothing outside the bounding box, so we don't need to look at any
+  // voxels out there
+  const math::BoundingBox& bounds = getBoundingBox();
+  const Eigen::Vector3s lowerCorner = min.cwiseMax(bounds.getMin());
+  const Eigen::Vector3s upperCorner = max.cwiseMin(bounds.getMax());
+  if ((lowerCorner.array() > upperCorner.array()).any())
+    return indices;
+
+  const Eigen::Vector3i lower = getVoxel(lowerCorner);
+  const Eigen::Vector3i upper = getVoxel(upperCorner);
+  const s_t numVoxels = static_cast<s_t>(upper.x() - lower.x() + 1)
+                        * (upper.y() - lower.y() + 1)
+                        * (upper.z() - lower.z() + 1);
+  if (numVoxels > mPoints.size())
+  {
+    // The box covers more voxels than there are points, so it's quicker to
+    // just check every point
+    for (std::size_t i = 0; i < mPoints.size(); i++)
+      indices.push_back(i);
+  }
+  else
+  {
+    Eigen::Vector3i voxel;
+    for (voxel.x() = lower.x(); voxel.x() <= upper.x(); voxel.x()++)
+    {
+      for (voxel.y() = lower.y(); voxel.y() <= upper.y(); voxel.y()++)
+      {
+        for (voxel.z() = lower.z(); voxel.z() <= upper.z(); voxel.z()++)
+        {
+          const auto it = mVoxels.find(packVoxel(voxel));
+          if (it != mVoxels.end())
+          {
+            indices.insert(
+                indices.end(), it->second.begin(), it->second.end());
+          }
+        }
+      }
+    }
+    // Points can be in more than one voxel
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  }
+
+  const s_t radius = mVisualSize / 2;
+  indices.erase(
+      std::remove_if(
+          indices.begin(),
+          indices.end(),
+          [&](std::size_t i) {
+            const Eigen::Vector3s& point = mPoints[i];
+            const Eigen::Vector3s closest = point.cwiseMax(min).cwiseMin(max);
+            return (point - closest).squaredNorm() > radius * radius;
+          }),
+      indices.end());
+  return indices;
+}
+
+//==============================================================================
+bool PointCloudShape::raycast(
+    const Eigen::Vector3s& from,
+    const Eigen::Vector3s& to,
+    s_t maxFraction,
+    s_t& fraction,
+    Eigen::Vector3s& normal,
+    std::size_t& point) const
+{
+  if (mPoints.empty())
+    return false;
+
+  // Clip the ray to the bounding box, so we only step through the voxels
+  // that could have points in them
+  const Eigen::Vector3s d = to - from;
+  const math::BoundingBox& bounds = getBoundingBox();
+  s_t enter = 0;
+  s_t exit = maxFraction;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (d(axis) == 0)
+    {
+      if (from(axis) < bounds.getMin()(axis)
+          || from(axis) > bounds.getMax()(axis))
+        return false;
+      continue;
+    }
+    s_t t1 = (bounds.getMin()(axis) - from(axis)) / d(axis);
+    s_t t2 = (bounds.getMax()(axis) - from(axis)) / d(axis);
+    if (t1 > t2)
+      std::swap(t1, t2);
+    enter = std::max(enter, t1);
+    exit = std::min(exit, t2);
+    if (enter > exit)
+      return false;
+  }
+
+  // Step through the voxels along the ray in order (Amanatides and Woo). A
+  // point's ball is in every voxel it overlaps, so once we have a hit inside
+  // the voxel we're in, nothing further along can be any closer.
+  Eigen::Vector3i voxel = getVoxel(from + enter * d);
+  Eigen::Vector3i step;
+  Eigen::Vector3s nextBoundary;
+  Eigen::Vector3s boundarySpacing;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    if (d(axis) > 0)
+    {
+      step(axis) = 1;
+      nextBoundary(axis)
+          = ((voxel(axis) + 1) * mIndexVoxelSize - from(axis)) / d(axis);
+      boundarySpacing(axis) = mIndexVoxelSize / d(axis);
+    }
+    else if (d(axis) < 0)
+    {
+      step(axis) = -1;
+      nextBoundary(axis)
+          = (voxel(axis) * mIndexVoxelSize - from(axis)) / d(axis);
+      boundarySpacing(axis) = -mIndexVoxelSize / d(axis);
+    }
+    else
+    {
+      step(axis) = 0;
+      nextBoundary(axis) = std::numeric_limits<s_t>::infinity();
+      boundarySpacing(axis) = std::numeric_limits<s_t>::infinity();
+    }
+  }
+
+  const s_t radius = mVisualSize / 2;
+  const s_t A = d.dot(d);
+  bool found = false;
+  s_t best = maxFraction;
+  while (true)
+  {
+    const auto it = mVoxels.find(packVoxel(voxel));
+    if (it != mVoxels.end())
+    {
+      for (std::size_t i : it->second)
+      {
+        const Eigen::Vector3s a = from - mPoints[i];
+        const s_t B = 2 * a.dot(d);
+        const s_t C = a.dot(a) - radius * radius;
+        if (C <= 0)
+          continue;
+        const s_t discriminant = B * B - 4 * A * C;
+        if (discriminant < 0)
+          continue;
+        const s_t hit = (-B - std::sqrt(discriminant)) / (2 * A);
+        if (hit < 0 || hit > best)
+          continue;
+        found = true;
+        best = hit;
+        point = i;
+        normal = (a + hit * d) / radius;
+      }
+    }
+
+    int axis;
+    const s_t voxelExit = nextBoundary.minCoeff(&axis);
+    if ((found && best <= voxelExit) || voxelExit > exit)
+      break;
+    voxel(axis) += step(axis);
+    nextBoundary(axis) += boundarySpacing(axis);
+  }
+
+  if (found)
+    fraction = best;
+  return found;
+}
+
+//==============================================================================
+std::vector<Eigen::Vector3s> PointCloudShape::getDownsampledPoints(
+    s_t voxelSize) const
+{
+  std::unordered_map<std::uint64_t, std::size_t> slots;
+  std::vector<Eigen::Vector3s> sums;
+  std::vector<int> counts;
+  for (const auto& point : mPoints)
+  {
+    const Eigen::Vector3i voxel
+        = (point / voxelSize).array().floor().cast<int>();
+    const auto inserted = slots.emplace(packVoxel(voxel), sums.size());
+    if (inserted.second)
+    {
+      sums.push_back(Eigen::Vector3s::Zero());
+      counts.push_back(0);
+    }
+    sums[inserted.first->second] += point;
+    counts[inserted.first->second]++;
+  }
+
+  for (std::size_t i = 0; i < sums.size(); i++)
+    sums[i] /= counts[i];
+  return sums;
+}
+
 //==============================================================================
 void PointCloudShape::notifyColorUpdated(const Eigen::Vector4s& /*color*/)
 {
   incrementVersion();
 }
 
+//==============================================================================
+ShapePtr PointCloudShape::clone() const
+{
+  auto cloud = std::make_shared<PointCloudShape>(mVisualSize);
+  cloud->mIndexVoxelSize = mIndexVoxelSize;
+  cloud->mPoints = mPoints;
+  cloud->mVoxels = mVoxels;
+  cloud->mPointShapeType = mPointShapeType;
+  cloud->mColorMode = mColorMode;
+  cloud->mColors = mColors;
+  return cloud;
+}
+
 //==============================================================================
 void PointCloudShape::updateVolume() const
 {
@@ -245,6 +512,37 @@ void PointCloudShape::updateVolume() const
   mIsVolumeDirty = false;
 }
 
+//==============================================================================
+void PointCloudShape::indexPoint(std::size_t index)
+{
+  const Eigen::Vector3s extents = Eigen::Vector3s::Constant(mVisualSize / 2);
+  const Eigen::Vector3i lower = getVoxel(mPoints[index] - extents);
+  const Eigen::Vector3i upper = getVoxel(mPoints[index] + extents);
+  Eigen::Vector3i voxel;
+  for (voxel.x() = lower.x(); voxel.x() <= upper.x(); voxel.x()++)
+  {
+    for (voxel.y() = lower.y(); voxel.y() <= upper.y(); voxel.y()++)
+    {
+      for (voxel.z() = lower.z(); voxel.z() <= upper.z(); voxel.z()++)
+        mVoxels[packVoxel(voxel)].push_back(index);
+    }
+  }
+}
+
+//==============================================================================
+void PointCloudShape::rebuildIndex()
+{
+  mVoxels.clear();
+  for (std::size_t i = 0; i < mPoints.size(); i++)
+    indexPoint(i);
+}
+
+//==============================================================================
+Eigen::Vector3i PointCloudShape::getVoxel(const Eigen::Vector3s& point) const
+{
+  return (point / mIndexVoxelSize).array().floor().cast<int>();
+}
+
 //==============================================================================
 void PointCloudShape::updateBoundingBox() const
 {
@@ -267,8 +565,10 @@ void PointCloudShape::updateBoundingBox() const
     max = max.cwiseMax(vertex);
   }
 
-  mBoundingBox.setMin(min);
-  mBoundingBox.setMax(max);
+  // Cover the balls around the points, not just their centers
+  const Eigen::Vector3s extents = Eigen::Vector3s::Constant(mVisualSize / 2);
+  mBoundingBox.setMin(min - extents);
+  mBoundingBox.setMax(max + extents);
 
   mIsBoundingBoxDirty = false;
 }
@@ -33,6 +33,10 @@
 #ifndef DART_DYNAMICS_POINTCLOUDSHAPE_HPP_
 #define DART_DYNAMICS_POINTCLOUDSHAPE_HPP_
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
 #include "dart/dynamics/Shape.hpp"
 
 #if HAVE_OCTOMAP
@@ -43,6 +47,12 @@ namespace dart {
 namespace dynamics {
 
 /// The PointCloudShape represents point cloud data.
+///
+/// For collision and raycasting, each point is a ball with a diameter of
+/// getVisualSize(). The points are kept in a hash of voxels (see
+/// setIndexVoxelSize()), which is updated as points are added, so those
+/// queries only look at the points near them rather than every point in the
+/// cloud.
 class PointCloudShape : public Shape
 {
 public:
@@ -149,9 +159,47 @@ public:
   /// Returns size of visual object that represents each point.
   s_t getVisualSize() const;
 
+  /// Sets the edge length of the voxels that index the points. Smaller voxels
+  /// mean fewer points to test per query, but more voxels to step through and
+  /// more memory. Voxels should be no smaller than getVisualSize(), since
+  /// each point is indexed in every voxel its ball overlaps. This rebuilds
+  /// the index.
+  void setIndexVoxelSize(s_t size);
+
+  /// Returns the edge length of the voxels that index the points.
+  s_t getIndexVoxelSize() const;
+
+  /// Returns the indices of the points whose balls overlap the axis aligned
+  /// box between \c min and \c max, in the frame of this shape, in
+  /// increasing order.
+  std::vector<std::size_t> getPointsInBox(
+      const Eigen::Vector3s& min, const Eigen::Vector3s& max) const;
+
+  /// Casts the ray from \c from to \c to, in the frame of this shape, against
+  /// the balls of the points. If it hits one before \c maxFraction of the way
+  /// along, this returns true and fills in \c fraction (how far along the ray
+  /// the hit is, from 0 to 1), the \c normal at the hit, and the index of the
+  /// \c point that was hit. Rays that start inside a ball don't hit it.
+  bool raycast(
+      const Eigen::Vector3s& from,
+      const Eigen::Vector3s& to,
+      s_t maxFraction,
+      s_t& fraction,
+      Eigen::Vector3s& normal,
+      std::size_t& point) const;
+
+  /// Returns one point for every voxel of edge length \c voxelSize that has
+  /// any points in it, at the centroid of those points. This is meant for
+  /// showing (or streaming) a cloud that's too big to send in full.
+  std::vector<Eigen::Vector3s> getDownsampledPoints(s_t voxelSize) const;
+
   // Documentation inherited.
   void notifyColorUpdated(const Eigen::Vector4s& color) override;
 
+  /// Allow us to clone shapes, to avoid race conditions when scaling shapes
+  /// belonging to different skeletons
+  ShapePtr clone() const override;
+
 protected:
   // Documentation inherited.
   void updateVolume() const override;
@@ -174,6 +222,22 @@ protected:
 
   /// The size of visual object that represents each point.
   s_t mVisualSize;
+
+  /// Adds mPoints[index] to every voxel its ball overlaps
+  void indexPoint(std::size_t index);
+
+  /// Rebuilds mVoxels from scratch
+  void rebuildIndex();
+
+  /// Returns the voxel of edge mIndexVoxelSize that \c point is in
+  Eigen::Vector3i getVoxel(const Eigen::Vector3s& point) const;
+
+  /// The edge length of the voxels in mVoxels
+  s_t mIndexVoxelSize;
+
+  /// Maps packed voxel coordinates to the indices of the points whose balls
+  /// overlap that voxel
+  std::unordered_map<std::uint64_t, std::vector<std::size_t>> mVoxels;
 };
 
 } // namespace dynamics
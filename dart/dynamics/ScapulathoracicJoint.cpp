@@ -358,6 +358,86 @@ ScapulathoracicJoint::getRelativeJacobianDerivWrtPositionStatic(
   return dJ;
 }
 
+//==============================================================================
+Eigen::Matrix<s_t, 6, 4>
+ScapulathoracicJoint::getRelativeJacobianTimeDerivStatic(
+    const Eigen::Vector4s& pos, const Eigen::Vector4s& vel) const
+{
+  Eigen::Matrix<s_t, 6, 4> J = Eigen::Matrix<s_t, 6, 4>::Zero();
+  Eigen::Matrix<s_t, 6, 4> dJ = Eigen::Matrix<s_t, 6, 4>::Zero();
+
+  // The Euler joint already knows how to compute its own time derivative in
+  // one pass, which is the velocity-weighted sum of its position derivatives
+  Eigen::Isometry3s identity = Eigen::Isometry3s::Identity();
+  Eigen::Matrix<s_t, 6, 3> eulerJ = EulerJoint::computeRelativeJacobianStatic(
+      pos.head<3>(), mAxisOrder, mFlipAxisMap.head<3>(), identity);
+  Eigen::Matrix<s_t, 6, 3> euler_dJ
+      = EulerJoint::computeRelativeJacobianTimeDerivStatic(
+          pos.head<3>(),
+          vel.head<3>(),
+          mAxisOrder,
+          mFlipAxisMap.head<3>(),
+          identity);
+  Eigen::Matrix3s eulerR = Eigen::Matrix3s::Zero();
+  eulerR(1, 0) = -1.0;
+  eulerR(0, 1) = 1.0;
+  eulerR(2, 2) = 1.0;
+  dJ.block<3, 3>(0, 0) = eulerR.transpose() * euler_dJ.topRows(3);
+  J.block<3, 3>(0, 0) = eulerR.transpose() * eulerJ.topRows(3);
+
+  const Eigen::Vector3s localSphericalOffset = Eigen::Vector3s::UnitZ();
+  for (int i = 0; i < 3; i++)
+  {
+    dJ.block<3, 1>(3, i) = dJ.block<3, 1>(0, i).cross(localSphericalOffset);
+    J.block<3, 1>(3, i) = J.block<3, 1>(0, i).cross(localSphericalOffset);
+  }
+
+  Eigen::Matrix3s rot = EulerJoint::convertToTransform(
+                            pos.head<3>(), mAxisOrder, mFlipAxisMap.head<3>())
+                            .linear();
+  rot = eulerR.transpose() * rot * eulerR;
+  const Eigen::Matrix3s scaleInParentSpace
+      = rot.transpose() * mEllipsoidRadii.asDiagonal() * rot;
+
+  // d(rot)/dq_i = rot * [J_i], so summing over the velocities collapses to a
+  // single skew matrix of the angular velocity
+  const Eigen::Vector3s w = J.block<3, 3>(0, 0) * vel.head<3>();
+  Eigen::Matrix3s dScaleInParentSpace
+      = (rot * math::makeSkewSymmetric(w)).transpose()
+        * mEllipsoidRadii.asDiagonal() * rot;
+  dScaleInParentSpace += dScaleInParentSpace.transpose().eval();
+  dJ.block<3, 3>(3, 0) = scaleInParentSpace * dJ.block<3, 3>(3, 0)
+                         + dScaleInParentSpace * J.block<3, 3>(3, 0);
+  J.block<3, 3>(3, 0) = scaleInParentSpace * J.block<3, 3>(3, 0);
+
+  // Winging, which is the same as in getRelativeJacobianStatic()
+  Eigen::Vector3s wingDirection = Eigen::Vector3s(
+      -sin(mWingingAxisDirection), cos(mWingingAxisDirection), 0);
+  Eigen::Vector3s wingOriginInIntermediateFrame
+      = Eigen::Vector3s(mWingingAxisOffset(0), mWingingAxisOffset(1), 0);
+  Eigen::Isometry3s wingAxisT = Eigen::Isometry3s::Identity();
+  wingAxisT.translation() = wingOriginInIntermediateFrame;
+  Eigen::Isometry3s winging = Eigen::Isometry3s::Identity();
+  winging.linear() = math::expMapRot(wingDirection * pos(3) * mFlipAxisMap(3));
+  winging = wingAxisT * winging * wingAxisT.inverse();
+  const Eigen::Isometry3s wingingInv = winging.inverse();
+
+  J.block<3, 1>(0, 3) = wingDirection;
+  J.block<3, 1>(3, 3) = wingOriginInIntermediateFrame.cross(wingDirection);
+  J = math::AdTJacFixed(wingingInv, J);
+  dJ = math::AdTJacFixed(wingingInv, dJ);
+
+  // The winging DOF only contributes through the Lie bracket with its own
+  // screw axis
+  for (int i = 0; i < 3; i++)
+  {
+    dJ.col(i) += vel(3) * math::ad(J.col(i), J.col(3));
+  }
+
+  // Finally, take into account the transform to the child body node
+  return math::AdTJacFixed(getTransformFromChildBodyNode(), dJ);
+}
+
 //==============================================================================
 Eigen::Matrix<s_t, 6, 4>
 ScapulathoracicJoint::getRelativeJacobianDerivWrtPositionDerivWrtPositionStatic(
@@ -679,15 +759,8 @@ void ScapulathoracicJoint::updateRelativeJacobian(bool) const
 //==============================================================================
 void ScapulathoracicJoint::updateRelativeJacobianTimeDeriv() const
 {
-  Eigen::VectorXs pos = this->getPositionsStatic();
-  Eigen::VectorXs vel = this->getVelocitiesStatic();
-
-  Eigen::Matrix<s_t, 6, 4> dJ = Eigen::Matrix<s_t, 6, 4>::Zero();
-  for (int i = 0; i < pos.size(); i++)
-  {
-    dJ += getRelativeJacobianDerivWrtPositionStatic(i) * vel(i);
-  }
-  this->mJacobianDeriv = dJ;
+  this->mJacobianDeriv = getRelativeJacobianTimeDerivStatic(
+      this->getPositionsStatic(), this->getVelocitiesStatic());
 }
 
 //==============================================================================
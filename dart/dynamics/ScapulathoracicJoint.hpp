@@ -120,6 +120,13 @@ public:
   JacobianMatrix getRelativeJacobianDerivWrtPositionStatic(
       std::size_t index) const override;
 
+  /// This computes the time derivative of the relative Jacobian in a single
+  /// pass. It's equivalent to summing
+  /// getRelativeJacobianDerivWrtPositionStatic(i) * velocities(i) over all the
+  /// DOFs, but shares all the intermediate terms between the DOFs.
+  JacobianMatrix getRelativeJacobianTimeDerivStatic(
+      const Vector& positions, const Vector& velocities) const;
+
   JacobianMatrix getRelativeJacobianDerivWrtPositionDerivWrtPositionStatic(
       std::size_t firstIndex, std::size_t secondIndex) const;
 
@@ -52,8 +52,13 @@ VisualAspectProperties::VisualAspectProperties(
 }
 
 //==============================================================================
-CollisionAspectProperties::CollisionAspectProperties(const bool collidable)
-  : mCollidable(collidable)
+CollisionAspectProperties::CollisionAspectProperties(
+    const bool collidable,
+    const std::uint32_t collisionLayers,
+    const std::uint32_t collisionMask)
+  : mCollidable(collidable),
+    mCollisionLayers(collisionLayers),
+    mCollisionMask(collisionMask)
 {
   // Do nothing
 }
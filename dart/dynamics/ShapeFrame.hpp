@@ -131,6 +131,14 @@ public:
 
   /// Return true if this body can collide with others bodies
   bool isCollidable() const;
+
+  DART_COMMON_SET_GET_ASPECT_PROPERTY(std::uint32_t, CollisionLayers)
+  // void setCollisionLayers(const std::uint32_t& value);
+  // const std::uint32_t& getCollisionLayers() const;
+
+  DART_COMMON_SET_GET_ASPECT_PROPERTY(std::uint32_t, CollisionMask)
+  // void setCollisionMask(const std::uint32_t& value);
+  // const std::uint32_t& getCollisionMask() const;
 };
 
 //==============================================================================
@@ -137,6 +137,181 @@ void SimpleFeatherstone::forwardDynamics(
   }
 }
 
+// This computes the forces required to produce `accelerations`, using RNEA
+void SimpleFeatherstone::inverseDynamics(
+    s_t* pos,
+    s_t* vel,
+    s_t* accelerations,
+    /* OUT */ s_t* forces)
+{
+  // Forward pass
+  for (int i = 0; i < len(); i++)
+  {
+    const JointAndBody& joint = mJointsAndBodies[i];
+    FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+    scratch.transformFromParent = joint.transformFromParent
+                                  * math::expMap(joint.axis * pos[i])
+                                  * joint.transformFromChildren;
+    if (joint.parentIndex != -1)
+    {
+      const FeatherstoneScratchSpace& parent = mScratchSpace[joint.parentIndex];
+      scratch.spatialVelocity
+          = math::AdInvT(scratch.transformFromParent, parent.spatialVelocity)
+            + joint.axis * vel[i];
+      scratch.spatialAcceleration
+          = math::AdInvT(
+                scratch.transformFromParent, parent.spatialAcceleration)
+            + joint.axis * accelerations[i];
+    }
+    else
+    {
+      scratch.spatialVelocity = joint.axis * vel[i];
+      scratch.spatialAcceleration = joint.axis * accelerations[i];
+    }
+    scratch.partialAcceleration
+        = math::ad(scratch.spatialVelocity, joint.axis * vel[i]);
+    scratch.spatialAcceleration += scratch.partialAcceleration;
+    scratch.bodyForce
+        = joint.inertia * scratch.spatialAcceleration
+          - math::dad(
+              scratch.spatialVelocity, joint.inertia * scratch.spatialVelocity);
+  }
+  // Backward pass
+  for (int i = len() - 1; i >= 0; i--)
+  {
+    const JointAndBody& joint = mJointsAndBodies[i];
+    forces[i] = joint.axis.dot(mScratchSpace[i].bodyForce);
+    if (joint.parentIndex != -1)
+    {
+      mScratchSpace[joint.parentIndex].bodyForce += math::dAdInvT(
+          mScratchSpace[i].transformFromParent, mScratchSpace[i].bodyForce);
+    }
+  }
+}
+
+// This computes the Jacobians of forwardDynamics() with respect to pos, vel and
+// force, in O(n^2)
+void SimpleFeatherstone::forwardDynamicsDerivatives(
+    s_t* pos,
+    s_t* vel,
+    s_t* force,
+    /* OUT */ Eigen::MatrixXs& accWrtPos,
+    /* OUT */ Eigen::MatrixXs& accWrtVel,
+    /* OUT */ Eigen::MatrixXs& accWrtForce)
+{
+  const int n = len();
+  accWrtPos.resize(n, n);
+  accWrtVel.resize(n, n);
+  accWrtForce.resize(n, n);
+
+  // Get the accelerations, and then run RNEA at those accelerations to fill in
+  // the transforms, velocities, accelerations and body forces in the scratch
+  // space. The derivatives are taken around that point.
+  std::vector<s_t> acc(n);
+  std::vector<s_t> buffer(n);
+  forwardDynamics(pos, vel, force, acc.data());
+  inverseDynamics(pos, vel, acc.data(), buffer.data());
+
+  for (int i = 0; i < n; i++)
+  {
+    // T(q) = A * exp(axis * q) * B, so dT/dq = T * [Ad(B^{-1}) axis]
+    mScratchSpace[i].positionTwist = math::AdInvT(
+        mJointsAndBodies[i].transformFromChildren, mJointsAndBodies[i].axis);
+  }
+
+  // Forward-mode derivatives of RNEA, holding the accelerations fixed. Each
+  // column k is one O(n) sweep. We store dID/dq in accWrtPos and dID/dv in
+  // accWrtVel for now, and convert them below.
+  std::vector<Eigen::Vector6s> dV(n);
+  std::vector<Eigen::Vector6s> dA(n);
+  std::vector<Eigen::Vector6s> dF(n);
+  for (int wrtVel = 0; wrtVel <= 1; wrtVel++)
+  {
+    Eigen::MatrixXs& idWrt = wrtVel ? accWrtVel : accWrtPos;
+    for (int k = 0; k < n; k++)
+    {
+      for (int i = 0; i < n; i++)
+      {
+        const JointAndBody& joint = mJointsAndBodies[i];
+        const FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+        const Eigen::Isometry3s& T = scratch.transformFromParent;
+        if (joint.parentIndex != -1)
+        {
+          dV[i] = math::AdInvT(T, dV[joint.parentIndex]);
+          dA[i] = math::AdInvT(T, dA[joint.parentIndex]);
+        }
+        else
+        {
+          dV[i].setZero();
+          dA[i].setZero();
+        }
+        if (i == k)
+        {
+          if (wrtVel)
+          {
+            dV[i] += joint.axis;
+            dA[i] += math::ad(scratch.spatialVelocity, joint.axis);
+          }
+          else if (joint.parentIndex != -1)
+          {
+            const FeatherstoneScratchSpace& parent
+                = mScratchSpace[joint.parentIndex];
+            dV[i] += math::ad(
+                math::AdInvT(T, parent.spatialVelocity), scratch.positionTwist);
+            dA[i] += math::ad(
+                math::AdInvT(T, parent.spatialAcceleration),
+                scratch.positionTwist);
+          }
+        }
+        dA[i] += math::ad(dV[i], joint.axis * vel[i]);
+        dF[i] = joint.inertia * dA[i]
+                - math::dad(dV[i], joint.inertia * scratch.spatialVelocity)
+                - math::dad(scratch.spatialVelocity, joint.inertia * dV[i]);
+      }
+      for (int i = n - 1; i >= 0; i--)
+      {
+        const JointAndBody& joint = mJointsAndBodies[i];
+        const FeatherstoneScratchSpace& scratch = mScratchSpace[i];
+        idWrt(i, k) = joint.axis.dot(dF[i]);
+        if (joint.parentIndex == -1)
+          continue;
+        dF[joint.parentIndex]
+            += math::dAdInvT(scratch.transformFromParent, dF[i]);
+        if (i == k && !wrtVel)
+        {
+          dF[joint.parentIndex] -= math::dAdInvT(
+              scratch.transformFromParent,
+              math::dad(scratch.positionTwist, scratch.bodyForce));
+        }
+      }
+    }
+  }
+
+  // Since ID(q, v, FD(q, v, f)) = f, we have d(FD)/dx = -Minv * d(ID)/dx, and
+  // d(FD)/df = Minv. SimpleFeatherstone has no gravity, so forward dynamics
+  // with zero velocity is exactly Minv * force, which gets us each column of
+  // those products with one more O(n) sweep.
+  std::vector<s_t> zeros(n, 0.0);
+  for (int k = 0; k < n; k++)
+  {
+    Eigen::Map<Eigen::VectorXs>(buffer.data(), n) = -accWrtPos.col(k);
+    forwardDynamics(pos, zeros.data(), buffer.data(), acc.data());
+    accWrtPos.col(k) = Eigen::Map<Eigen::VectorXs>(acc.data(), n);
+
+    Eigen::Map<Eigen::VectorXs>(buffer.data(), n) = -accWrtVel.col(k);
+    forwardDynamics(pos, zeros.data(), buffer.data(), acc.data());
+    accWrtVel.col(k) = Eigen::Map<Eigen::VectorXs>(acc.data(), n);
+
+    Eigen::Map<Eigen::VectorXs>(buffer.data(), n).setZero();
+    buffer[k] = 1.0;
+    forwardDynamics(pos, zeros.data(), buffer.data(), acc.data());
+    accWrtForce.col(k) = Eigen::Map<Eigen::VectorXs>(acc.data(), n);
+  }
+
+  // Leave the scratch space describing the real state, like forwardDynamics()
+  forwardDynamics(pos, vel, force, acc.data());
+}
+
 // This gets the values from a DART skeleton to populate our Featherstone
 // implementation
 void SimpleFeatherstone::populateFromSkeleton(
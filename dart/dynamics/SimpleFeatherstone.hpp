@@ -44,6 +44,13 @@ struct FeatherstoneScratchSpace
   s_t totalForce;
   Eigen::Vector6s partialAcceleration; // = eta
   Eigen::Matrix6s phi;
+
+  // The net spatial force transmitted through the parent joint, used by
+  // inverseDynamics()
+  Eigen::Vector6s bodyForce;
+  // The twist of this body's transform when its joint position changes,
+  // expressed in this body's frame, used by the derivative passes
+  Eigen::Vector6s positionTwist;
 };
 
 class SimpleFeatherstone
@@ -64,6 +71,31 @@ public:
       s_t* force,
       /* OUT */ s_t* accelerations);
 
+  // This computes the forces required to produce `accelerations`, using the
+  // recursive Newton-Euler algorithm. This is the exact inverse of
+  // forwardDynamics(). All the pointer arguments are assumed to point to
+  // arrays of length len()
+  void inverseDynamics(
+      s_t* pos,
+      s_t* vel,
+      s_t* accelerations,
+      /* OUT */ s_t* forces);
+
+  // This computes the Jacobians of the accelerations from forwardDynamics()
+  // with respect to pos, vel and force, analytically. It takes forward-mode
+  // derivatives of the recursive Newton-Euler algorithm, which is O(n) per DOF,
+  // and then multiplies the results by -Minv, which is also O(n) per DOF using
+  // the articulated body algorithm, so the whole thing is O(n^2). We never form
+  // the mass matrix, or any other dense (n x n) intermediate product. The
+  // pointer arguments are assumed to point to arrays of length len()
+  void forwardDynamicsDerivatives(
+      s_t* pos,
+      s_t* vel,
+      s_t* force,
+      /* OUT */ Eigen::MatrixXs& accWrtPos,
+      /* OUT */ Eigen::MatrixXs& accWrtVel,
+      /* OUT */ Eigen::MatrixXs& accWrtForce);
+
   // This gets the values from a DART skeleton to populate our Featherstone
   // implementation
   void populateFromSkeleton(
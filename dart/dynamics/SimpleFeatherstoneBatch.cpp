@@ -0,0 +1,444 @@
+#include "dart/dynamics/SimpleFeatherstoneBatch.hpp"
+
+#include <cassert>
+#include <iostream>
+
+#include "dart/dynamics/SimpleFeatherstone.hpp"
+#include "dart/math/Geometry.hpp"
+
+namespace dart {
+namespace dynamics {
+
+namespace {
+
+typedef FeatherstoneLanes Lanes;
+typedef FeatherstoneLanes3 Lanes3;
+typedef FeatherstoneLanes6 Lanes6;
+typedef FeatherstoneLanes33 Lanes33;
+typedef FeatherstoneLanes66 Lanes66;
+
+template <std::size_t N>
+void resizeLanes(std::array<Lanes, N>& lanes, int batchSize)
+{
+  for (std::size_t i = 0; i < N; i++)
+  {
+    lanes[i].resize(batchSize);
+  }
+}
+
+template <std::size_t N>
+void setZero(std::array<Lanes, N>& lanes)
+{
+  for (std::size_t i = 0; i < N; i++)
+  {
+    lanes[i].setZero();
+  }
+}
+
+// out = a x b, or out += a x b if `accumulate`
+void cross(
+    const Lanes* a, const Lanes* b, /* OUT */ Lanes* out, bool accumulate)
+{
+  if (accumulate)
+  {
+    out[0] += a[1] * b[2] - a[2] * b[1];
+    out[1] += a[2] * b[0] - a[0] * b[2];
+    out[2] += a[0] * b[1] - a[1] * b[0];
+  }
+  else
+  {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+  }
+}
+
+// Lane-wise math::AdInvT(T, V) = [R^T w; R^T (v - p x w)]
+void adInvT(
+    const Lanes33& R,
+    const Lanes3& p,
+    const Lanes6& V,
+    /* OUT */ Lanes3& tmp,
+    /* OUT */ Lanes6& out)
+{
+  cross(p.data(), V.data(), tmp.data(), false);
+  for (int i = 0; i < 3; i++)
+  {
+    tmp[i] = V[3 + i] - tmp[i];
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    out[i] = R[3 * i] * V[0] + R[1 + 3 * i] * V[1] + R[2 + 3 * i] * V[2];
+    out[3 + i]
+        = R[3 * i] * tmp[0] + R[1 + 3 * i] * tmp[1] + R[2 + 3 * i] * tmp[2];
+  }
+}
+
+// Lane-wise math::dAdInvT(T, F) = [R m + p x (R f); R f]
+void dAdInvT(
+    const Lanes33& R,
+    const Lanes3& p,
+    const Lanes6& F,
+    /* OUT */ Lanes6& out)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    out[i] = R[i] * F[0] + R[i + 3] * F[1] + R[i + 6] * F[2];
+    out[3 + i] = R[i] * F[3] + R[i + 3] * F[4] + R[i + 6] * F[5];
+  }
+  cross(p.data(), out.data() + 3, out.data(), true);
+}
+
+// Lane-wise math::ad(V, W) = [w1 x w2; w1 x v2 + v1 x w2]
+void ad(const Lanes6& V, const Lanes6& W, /* OUT */ Lanes6& out)
+{
+  cross(V.data(), W.data(), out.data(), false);
+  cross(V.data(), W.data() + 3, out.data() + 3, false);
+  cross(V.data() + 3, W.data(), out.data() + 3, true);
+}
+
+// Lane-wise math::dad(V, F) = [m x w + f x v; f x w]
+void dad(const Lanes6& V, const Lanes6& F, /* OUT */ Lanes6& out)
+{
+  cross(F.data(), V.data(), out.data(), false);
+  cross(F.data() + 3, V.data() + 3, out.data(), true);
+  cross(F.data() + 3, V.data(), out.data() + 3, false);
+}
+
+// out = M * x, for a per-lane M
+void multiply(const Lanes66& M, const Lanes6& x, /* OUT */ Lanes6& out)
+{
+  for (int r = 0; r < 6; r++)
+  {
+    out[r] = M[r] * x[0];
+    for (int c = 1; c < 6; c++)
+    {
+      out[r] += M[r + 6 * c] * x[c];
+    }
+  }
+}
+
+// out = M * x, for a constant M
+void multiply(const Eigen::Matrix6s& M, const Lanes6& x, /* OUT */ Lanes6& out)
+{
+  for (int r = 0; r < 6; r++)
+  {
+    out[r] = M(r, 0) * x[0];
+    for (int c = 1; c < 6; c++)
+    {
+      out[r] += M(r, c) * x[c];
+    }
+  }
+}
+
+// out = axis^T * x, returned for convenience
+const Lanes& dot(
+    const Eigen::Vector6s& axis, const Lanes6& x, /* OUT */ Lanes& out)
+{
+  out = axis(0) * x[0];
+  for (int i = 1; i < 6; i++)
+  {
+    out += axis(i) * x[i];
+  }
+  return out;
+}
+
+} // namespace
+
+//==============================================================================
+SimpleFeatherstoneBatch::SimpleFeatherstoneBatch(
+    const SimpleFeatherstone& model)
+  : mBatchSize(0)
+{
+  mJoints.reserve(model.mJointsAndBodies.size());
+  for (const JointAndBody& joint : model.mJointsAndBodies)
+  {
+    BatchJointConstants constants;
+    constants.axis = joint.axis;
+    constants.inertia = joint.inertia;
+    constants.parentIndex = joint.parentIndex;
+
+    Eigen::Vector3s w = joint.axis.head<3>();
+    Eigen::Vector3s v = joint.axis.tail<3>();
+    Eigen::Matrix3s K = Eigen::Matrix3s::Zero();
+    Eigen::Vector3s a = v;
+    if (w.norm() > 1e-12)
+    {
+      constants.thetaScale = w.norm();
+      K = math::makeSkewSymmetric(w / w.norm());
+      a = v / w.norm();
+    }
+    else
+    {
+      constants.thetaScale = 1.0;
+    }
+    Eigen::Matrix3s K2 = K * K;
+    Eigen::Vector3s b = K * a;
+    Eigen::Vector3s c = K2 * a;
+
+    const Eigen::Matrix3s RA = joint.transformFromParent.linear();
+    const Eigen::Vector3s pA = joint.transformFromParent.translation();
+    const Eigen::Matrix3s RB = joint.transformFromChildren.linear();
+    const Eigen::Vector3s pB = joint.transformFromChildren.translation();
+
+    // With exp(axis * q) = (I + sin(theta) K + (1 - cos(theta)) K^2,
+    //     theta a + (1 - cos(theta)) b + (theta - sin(theta)) c)
+    // multiply out A * exp(axis * q) * B, and collect terms
+    constants.R0 = RA * RB;
+    constants.R1 = RA * K * RB;
+    constants.R2 = RA * K2 * RB;
+    constants.p0 = pA + RA * pB;
+    constants.p1 = RA * (a + c);
+    constants.p2 = RA * (K * pB - c);
+    constants.p3 = RA * (K2 * pB + b);
+
+    mJoints.push_back(constants);
+  }
+  mScratchSpace.resize(mJoints.size());
+}
+
+//==============================================================================
+int SimpleFeatherstoneBatch::len() const
+{
+  return mJoints.size();
+}
+
+//==============================================================================
+void SimpleFeatherstoneBatch::resize(int batchSize)
+{
+  if (batchSize == mBatchSize)
+    return;
+  mBatchSize = batchSize;
+  for (BatchJointScratchSpace& scratch : mScratchSpace)
+  {
+    resizeLanes(scratch.R, batchSize);
+    resizeLanes(scratch.p, batchSize);
+    resizeLanes(scratch.spatialVelocity, batchSize);
+    resizeLanes(scratch.spatialAcceleration, batchSize);
+    resizeLanes(scratch.partialAcceleration, batchSize);
+    resizeLanes(scratch.articulatedInertia, batchSize);
+    resizeLanes(scratch.articulatedBiasForce, batchSize);
+    scratch.psi.resize(batchSize);
+    scratch.totalForce.resize(batchSize);
+  }
+}
+
+//==============================================================================
+void SimpleFeatherstoneBatch::forwardDynamics(
+    const Eigen::MatrixXs& pos,
+    const Eigen::MatrixXs& vel,
+    const Eigen::MatrixXs& force,
+    /* OUT */ Eigen::MatrixXs& accelerations)
+{
+  const int n = len();
+  const int batchSize = pos.cols();
+  if (pos.rows() != n || vel.rows() != n || force.rows() != n
+      || vel.cols() != batchSize || force.cols() != batchSize)
+  {
+    std::cerr << "SimpleFeatherstoneBatch::forwardDynamics() called with "
+                 "inputs that aren't all ("
+              << n << " x batchSize). Ignoring call." << std::endl;
+    return;
+  }
+  resize(batchSize);
+  accelerations.resize(n, batchSize);
+
+  // Temporaries, allocated once per call and reused across joints
+  Lanes theta(batchSize);
+  Lanes sinTheta(batchSize);
+  Lanes oneMinusCosTheta(batchSize);
+  Lanes q(batchSize);
+  Lanes dq(batchSize);
+  Lanes f(batchSize);
+  Lanes scalar(batchSize);
+  Lanes3 tmp3;
+  Lanes6 Sdq;
+  Lanes6 tmp6a;
+  Lanes6 tmp6b;
+  Lanes6 AIS;
+  Lanes66 PI;
+  resizeLanes(tmp3, batchSize);
+  resizeLanes(Sdq, batchSize);
+  resizeLanes(tmp6a, batchSize);
+  resizeLanes(tmp6b, batchSize);
+  resizeLanes(AIS, batchSize);
+  resizeLanes(PI, batchSize);
+
+  // Forward pass
+  for (int i = 0; i < n; i++)
+  {
+    const BatchJointConstants& joint = mJoints[i];
+    BatchJointScratchSpace& scratch = mScratchSpace[i];
+
+    q = pos.row(i).transpose().array();
+    dq = vel.row(i).transpose().array();
+    theta = joint.thetaScale * q;
+    sinTheta = theta.sin();
+    oneMinusCosTheta = 1.0 - theta.cos();
+    for (int k = 0; k < 9; k++)
+    {
+      const int r = k % 3;
+      const int c = k / 3;
+      scratch.R[k] = joint.R0(r, c) + joint.R1(r, c) * sinTheta
+                     + joint.R2(r, c) * oneMinusCosTheta;
+    }
+    for (int r = 0; r < 3; r++)
+    {
+      scratch.p[r] = joint.p0(r) + joint.p1(r) * theta
+                     + joint.p2(r) * sinTheta + joint.p3(r) * oneMinusCosTheta;
+    }
+
+    for (int k = 0; k < 6; k++)
+    {
+      Sdq[k] = joint.axis(k) * dq;
+    }
+    if (joint.parentIndex != -1)
+    {
+      adInvT(
+          scratch.R,
+          scratch.p,
+          mScratchSpace[joint.parentIndex].spatialVelocity,
+          tmp3,
+          scratch.spatialVelocity);
+      for (int k = 0; k < 6; k++)
+      {
+        scratch.spatialVelocity[k] += Sdq[k];
+      }
+    }
+    else
+    {
+      scratch.spatialVelocity = Sdq;
+    }
+    ad(scratch.spatialVelocity, Sdq, scratch.partialAcceleration);
+
+    // Zero out scratch space to prepare for sums in backwards pass
+    setZero(scratch.articulatedInertia);
+    setZero(scratch.articulatedBiasForce);
+  }
+
+  // Backward pass
+  for (int i = n - 1; i >= 0; i--)
+  {
+    const BatchJointConstants& joint = mJoints[i];
+    BatchJointScratchSpace& scratch = mScratchSpace[i];
+
+    for (int k = 0; k < 36; k++)
+    {
+      scratch.articulatedInertia[k] += joint.inertia(k % 6, k / 6);
+    }
+    multiply(joint.inertia, scratch.spatialVelocity, tmp6a);
+    dad(scratch.spatialVelocity, tmp6a, tmp6b);
+    for (int k = 0; k < 6; k++)
+    {
+      scratch.articulatedBiasForce[k] -= tmp6b[k];
+    }
+
+    for (int r = 0; r < 6; r++)
+    {
+      AIS[r] = scratch.articulatedInertia[r] * joint.axis(0);
+      for (int c = 1; c < 6; c++)
+      {
+        AIS[r] += scratch.articulatedInertia[r + 6 * c] * joint.axis(c);
+      }
+    }
+    scratch.psi = 1.0 / dot(joint.axis, AIS, scalar);
+
+    f = force.row(i).transpose().array();
+    multiply(
+        scratch.articulatedInertia, scratch.partialAcceleration, tmp6a);
+    for (int k = 0; k < 6; k++)
+    {
+      tmp6a[k] += scratch.articulatedBiasForce[k];
+    }
+    scratch.totalForce = f - dot(joint.axis, tmp6a, scalar);
+
+    if (joint.parentIndex == -1)
+      continue;
+    BatchJointScratchSpace& parent = mScratchSpace[joint.parentIndex];
+
+    // Sum into our parents, see SimpleFeatherstone::forwardDynamics()
+    for (int r = 0; r < 6; r++)
+    {
+      for (int c = 0; c < 6; c++)
+      {
+        PI[r + 6 * c] = scratch.articulatedInertia[r + 6 * c]
+                        - AIS[r] * scratch.psi * AIS[c];
+      }
+    }
+    // parentAI += Ad(T^{-1})^T * PI * Ad(T^{-1}), one column at a time
+    for (int c = 0; c < 6; c++)
+    {
+      for (int k = 0; k < 6; k++)
+      {
+        tmp6b[k].setConstant(k == c ? 1.0 : 0.0);
+      }
+      adInvT(scratch.R, scratch.p, tmp6b, tmp3, tmp6a);
+      multiply(PI, tmp6a, tmp6b);
+      dAdInvT(scratch.R, scratch.p, tmp6b, tmp6a);
+      for (int r = 0; r < 6; r++)
+      {
+        parent.articulatedInertia[r + 6 * c] += tmp6a[r];
+      }
+    }
+
+    // beta = AB + AI * (eta + axis * psi * totalForce)
+    scalar = scratch.psi * scratch.totalForce;
+    for (int k = 0; k < 6; k++)
+    {
+      tmp6b[k] = scratch.partialAcceleration[k] + joint.axis(k) * scalar;
+    }
+    multiply(scratch.articulatedInertia, tmp6b, tmp6a);
+    for (int k = 0; k < 6; k++)
+    {
+      tmp6a[k] += scratch.articulatedBiasForce[k];
+    }
+    dAdInvT(scratch.R, scratch.p, tmp6a, tmp6b);
+    for (int k = 0; k < 6; k++)
+    {
+      parent.articulatedBiasForce[k] += tmp6b[k];
+    }
+  }
+
+  // Last forward pass
+  for (int i = 0; i < n; i++)
+  {
+    const BatchJointConstants& joint = mJoints[i];
+    BatchJointScratchSpace& scratch = mScratchSpace[i];
+
+    // tmp6a = AdInvT(T, parentAcceleration) + eta
+    if (joint.parentIndex != -1)
+    {
+      adInvT(
+          scratch.R,
+          scratch.p,
+          mScratchSpace[joint.parentIndex].spatialAcceleration,
+          tmp3,
+          tmp6a);
+      for (int k = 0; k < 6; k++)
+      {
+        tmp6a[k] += scratch.partialAcceleration[k];
+      }
+    }
+    else
+    {
+      tmp6a = scratch.partialAcceleration;
+    }
+
+    f = force.row(i).transpose().array();
+    multiply(scratch.articulatedInertia, tmp6a, tmp6b);
+    for (int k = 0; k < 6; k++)
+    {
+      tmp6b[k] += scratch.articulatedBiasForce[k];
+    }
+    q = scratch.psi * (f - dot(joint.axis, tmp6b, scalar));
+    accelerations.row(i) = q.matrix().transpose();
+
+    for (int k = 0; k < 6; k++)
+    {
+      scratch.spatialAcceleration[k] = joint.axis(k) * q + tmp6a[k];
+    }
+  }
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,102 @@
+#ifndef DART_DYNAMICS_SIMPLE_FEATHERSTONE_BATCH_HPP_
+#define DART_DYNAMICS_SIMPLE_FEATHERSTONE_BATCH_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace dynamics {
+
+class SimpleFeatherstone;
+
+// Each "lane" is one environment in the batch. Storing every scalar of the
+// spatial algebra as an array over lanes (structure-of-arrays) means that all
+// the arithmetic below runs as straight-line Eigen array ops across the batch,
+// which Eigen vectorizes with whatever SIMD instruction set we're compiled for
+// (SSE, AVX2, AVX-512).
+typedef Eigen::Array<s_t, Eigen::Dynamic, 1> FeatherstoneLanes;
+typedef std::array<FeatherstoneLanes, 3> FeatherstoneLanes3;
+typedef std::array<FeatherstoneLanes, 6> FeatherstoneLanes6;
+// Column-major, so entry (row, col) is at [row + 3 * col]
+typedef std::array<FeatherstoneLanes, 9> FeatherstoneLanes33;
+// Column-major, so entry (row, col) is at [row + 6 * col]
+typedef std::array<FeatherstoneLanes, 36> FeatherstoneLanes66;
+
+// The constants for a single joint, precomputed so that the transform from
+// the parent for joint position q is:
+//
+//   R(q) = R0 + sin(theta) * R1 + (1 - cos(theta)) * R2
+//   p(q) = p0 + theta * p1 + sin(theta) * p2 + (1 - cos(theta)) * p3
+//
+// where theta = thetaScale * q. This is the closed form of
+// transformFromParent * expMap(axis * q) * transformFromChildren.
+struct BatchJointConstants
+{
+  Eigen::Vector6s axis;
+  Eigen::Matrix6s inertia;
+  int parentIndex;
+
+  s_t thetaScale;
+  Eigen::Matrix3s R0;
+  Eigen::Matrix3s R1;
+  Eigen::Matrix3s R2;
+  Eigen::Vector3s p0;
+  Eigen::Vector3s p1;
+  Eigen::Vector3s p2;
+  Eigen::Vector3s p3;
+};
+
+struct BatchJointScratchSpace
+{
+  FeatherstoneLanes33 R;
+  FeatherstoneLanes3 p;
+  FeatherstoneLanes6 spatialVelocity;
+  FeatherstoneLanes6 spatialAcceleration;
+  FeatherstoneLanes6 partialAcceleration;
+  FeatherstoneLanes66 articulatedInertia;
+  FeatherstoneLanes6 articulatedBiasForce;
+  FeatherstoneLanes psi;
+  FeatherstoneLanes totalForce;
+};
+
+// This runs SimpleFeatherstone::forwardDynamics() on many independent copies
+// of the same skeleton at once, one per lane. This is meant for RL workloads
+// with hundreds of identical robots, where this gets much better per-core
+// throughput than looping over a SimpleFeatherstone for each robot.
+//
+// Like SimpleFeatherstone, this supports skeletons where every joint has a
+// single DOF, which covers revolute, prismatic and screw joints.
+class SimpleFeatherstoneBatch
+{
+public:
+  // This copies the model out of `model`, which must already be populated
+  SimpleFeatherstoneBatch(const SimpleFeatherstone& model);
+
+  // The number of joints in the skeleton
+  int len() const;
+
+  // This computes accelerations for every environment in the batch. All the
+  // arguments are (len() x batchSize), with one column per environment.
+  void forwardDynamics(
+      const Eigen::MatrixXs& pos,
+      const Eigen::MatrixXs& vel,
+      const Eigen::MatrixXs& force,
+      /* OUT */ Eigen::MatrixXs& accelerations);
+
+protected:
+  // This (re)allocates the scratch space, if the batch size changed
+  void resize(int batchSize);
+
+  std::vector<BatchJointConstants> mJoints;
+  std::vector<BatchJointScratchSpace> mScratchSpace;
+  int mBatchSize;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
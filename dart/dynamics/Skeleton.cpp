@@ -37,32 +37,56 @@
 #include <limits>
 #include <queue>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "dart/common/Console.hpp"
 #include "dart/common/Deprecated.hpp"
+#include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/StlHelpers.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/ConstantCurveIncompressibleJoint.hpp"
 #include "dart/dynamics/CustomJoint.hpp"
+#include "dart/dynamics/CylinderShape.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/EllipsoidJoint.hpp"
+#include "dart/dynamics/EllipsoidShape.hpp"
 #include "dart/dynamics/EndEffector.hpp"
 #include "dart/dynamics/EulerFreeJoint.hpp"
+#include "dart/dynamics/EulerJoint.hpp"
 #include "dart/dynamics/Frame.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/Marker.hpp"
 #include "dart/dynamics/MeshShape.hpp"
 #include "dart/dynamics/PointMass.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/ScapulathoracicJoint.hpp"
+#include "dart/dynamics/ScrewJoint.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
 #include "dart/dynamics/SoftBodyNode.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/UniversalJoint.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/ConstantFunction.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
+#include "dart/math/LinearFunction.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/PiecewiseLinearFunction.hpp"
+#include "dart/math/PolynomialFunction.hpp"
+#include "dart/math/SimmSpline.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/WithRespectTo.hpp"
+#include "dart/proto/SerializeEigen.hpp"
+#include "dart/proto/Skeleton.pb.h"
 
 #define SET_ALL_FLAGS(X)                                                       \
   for (auto& cache : mTreeCache)                                               \
@@ -482,12 +506,14 @@ SkeletonPtr Skeleton::cloneSkeleton(const std::string& cloneName) const
     // Identify the original parent BodyNode
     const BodyNode* originalParent = getBodyNode(i)->getParentBodyNode();
 
-    // Grab the parent BodyNode clone (using its name, which is guaranteed to be
-    // unique), or use nullptr if this is a root BodyNode
+    // Grab the parent BodyNode clone, or use nullptr if this is a root
+    // BodyNode. The clone registers its BodyNodes in the same order we do, and
+    // parents always come first, so the parent's clone has the same index as
+    // the parent and is already there. That saves a name lookup per BodyNode.
     BodyNode* parentClone
         = (originalParent == nullptr)
               ? nullptr
-              : skelClone->getBodyNode(originalParent->getName());
+              : skelClone->getBodyNode(originalParent->getIndexInSkeleton());
 
     if ((nullptr != originalParent) && (nullptr == parentClone))
     {
@@ -510,7 +536,8 @@ SkeletonPtr Skeleton::cloneSkeleton(const std::string& cloneName) const
     for (const auto& node : nodeType.second)
     {
       const BodyNode* originalBn = node->getBodyNodePtr();
-      BodyNode* newBn = skelClone->getBodyNode(originalBn->getName());
+      BodyNode* newBn
+          = skelClone->getBodyNode(originalBn->getIndexInSkeleton());
       node->cloneNode(newBn)->attach();
     }
   }
@@ -624,53 +651,1016 @@ SkeletonPtr Skeleton::simplifySkeleton(
   skelClone->setName(cloneName);
   skelClone->setState(getState());
 
-  // Fix mimic joint references
-  for (std::size_t i = 0; i < getNumJoints(); ++i)
+  // Fix mimic joint references
+  for (std::size_t i = 0; i < getNumJoints(); ++i)
+  {
+    Joint* joint = skelClone->getJoint(i);
+    if (joint->getActuatorType() == Joint::MIMIC)
+    {
+      const Joint* mimicJoint
+          = skelClone->getJoint(joint->getMimicJoint()->getName());
+      if (mimicJoint)
+      {
+        joint->setMimicJoint(
+            mimicJoint, joint->getMimicMultiplier(), joint->getMimicOffset());
+      }
+      else
+      {
+        dterr << "[Skeleton::clone] Failed to clone mimic joint successfully: "
+              << "Unable to find the mimic joint ["
+              << joint->getMimicJoint()->getName()
+              << "] in the cloned Skeleton. Please report this as a bug!\n";
+      }
+    }
+  }
+
+  // Fix the scale groups
+  for (auto group : mBodyScaleGroups)
+  {
+    if (group.nodes.size() > 0)
+    {
+      for (int i = 1; i < group.nodes.size(); i++)
+      {
+        skelClone->mergeScaleGroups(
+            skelClone->getBodyNode(group.nodes[0]->getName()),
+            skelClone->getBodyNode(group.nodes[i]->getName()));
+      }
+      skelClone->setScaleGroupUniformScaling(
+          skelClone->getBodyNode(group.nodes[0]->getName()),
+          group.uniformScaling);
+    }
+  }
+
+  return skelClone;
+}
+
+//==============================================================================
+MetaSkeletonPtr Skeleton::cloneMetaSkeleton(const std::string& cloneName) const
+{
+  return cloneSkeleton(cloneName);
+}
+
+//==============================================================================
+/// Bump this when the meaning of an existing field in Skeleton.proto changes
+static const int SKELETON_SERIALIZATION_VERSION = 1;
+
+//==============================================================================
+static void serializeTransform(
+    proto::MatrixXs& proto,
+    const Eigen::Isometry3s& T,
+    const Eigen::Vector3s& translation)
+{
+  Eigen::Isometry3s unscaled = T;
+  unscaled.translation() = translation;
+  proto::serializeMatrix(proto, unscaled.matrix());
+}
+
+//==============================================================================
+static Eigen::Isometry3s deserializeTransform(const proto::MatrixXs& proto)
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  Eigen::MatrixXs matrix = proto::deserializeMatrix(proto);
+  if (matrix.rows() == 4 && matrix.cols() == 4)
+  {
+    T.matrix() = matrix;
+  }
+  return T;
+}
+
+//==============================================================================
+static Eigen::Vector3s deserializeVector3(
+    const proto::VectorXs& proto, const Eigen::Vector3s& defaultValue)
+{
+  Eigen::VectorXs vec = proto::deserializeVector(proto);
+  if (vec.size() != 3)
+  {
+    return defaultValue;
+  }
+  return vec;
+}
+
+//==============================================================================
+static bool serializeCustomFunction(
+    proto::SkeletonCustomFunction& proto,
+    const std::shared_ptr<math::CustomFunction>& fn)
+{
+  if (auto constant = std::dynamic_pointer_cast<math::ConstantFunction>(fn))
+  {
+    proto.set_type("ConstantFunction");
+    proto.add_coeffs(static_cast<double>(constant->mValue));
+  }
+  else if (auto linear = std::dynamic_pointer_cast<math::LinearFunction>(fn))
+  {
+    proto.set_type("LinearFunction");
+    proto.add_coeffs(static_cast<double>(linear->mSlope));
+    proto.add_coeffs(static_cast<double>(linear->mYIntercept));
+  }
+  else if (
+      auto polynomial
+      = std::dynamic_pointer_cast<math::PolynomialFunction>(fn))
+  {
+    proto.set_type("PolynomialFunction");
+    for (s_t coeff : polynomial->mCoeffs)
+    {
+      proto.add_coeffs(static_cast<double>(coeff));
+    }
+  }
+  else if (auto spline = std::dynamic_pointer_cast<math::SimmSpline>(fn))
+  {
+    proto.set_type("SimmSpline");
+    for (int i = 0; i < spline->getSize(); i++)
+    {
+      proto.add_x(static_cast<double>(spline->getX(i)));
+      proto.add_y(static_cast<double>(spline->getY(i)));
+    }
+  }
+  else if (
+      auto piecewise
+      = std::dynamic_pointer_cast<math::PiecewiseLinearFunction>(fn))
+  {
+    proto.set_type("PiecewiseLinearFunction");
+    for (int i = 0; i < piecewise->getSize(); i++)
+    {
+      proto.add_x(static_cast<double>(piecewise->getX(i)));
+      proto.add_y(static_cast<double>(piecewise->getY(i)));
+    }
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+static std::shared_ptr<math::CustomFunction> deserializeCustomFunction(
+    const proto::SkeletonCustomFunction& proto)
+{
+  std::vector<s_t> coeffs(proto.coeffs().begin(), proto.coeffs().end());
+  std::vector<s_t> x(proto.x().begin(), proto.x().end());
+  std::vector<s_t> y(proto.y().begin(), proto.y().end());
+  if (proto.type() == "ConstantFunction" && coeffs.size() == 1)
+  {
+    return std::make_shared<math::ConstantFunction>(coeffs[0]);
+  }
+  else if (proto.type() == "LinearFunction" && coeffs.size() == 2)
+  {
+    return std::make_shared<math::LinearFunction>(coeffs[0], coeffs[1]);
+  }
+  else if (proto.type() == "PolynomialFunction")
+  {
+    return std::make_shared<math::PolynomialFunction>(coeffs);
+  }
+  else if (proto.type() == "SimmSpline")
+  {
+    return std::make_shared<math::SimmSpline>(x, y);
+  }
+  else if (proto.type() == "PiecewiseLinearFunction")
+  {
+    return std::make_shared<math::PiecewiseLinearFunction>(x, y);
+  }
+  return nullptr;
+}
+
+//==============================================================================
+template <std::size_t Dimension>
+static bool serializeCustomJoint(
+    proto::SkeletonJoint& proto, const Joint* joint)
+{
+  if (joint->getType() != CustomJoint<Dimension>::getStaticType())
+  {
+    return false;
+  }
+  const CustomJoint<Dimension>* customJoint
+      = static_cast<const CustomJoint<Dimension>*>(joint);
+  proto.set_axisorder(static_cast<int>(customJoint->getAxisOrder()));
+  proto::serializeVector(
+      *proto.mutable_flipaxismap(), customJoint->getFlipAxisMap());
+  for (int i = 0; i < 6; i++)
+  {
+    if (!serializeCustomFunction(
+            *proto.add_customfunctions(), customJoint->getCustomFunction(i)))
+    {
+      dterr << "[Skeleton::serialize] CustomJoint [" << joint->getName()
+            << "] uses a custom function type that we can't serialize\n";
+      return false;
+    }
+    proto.add_customfunctiondrivenbydof(
+        customJoint->getCustomFunctionDrivenByDof(i));
+  }
+  return true;
+}
+
+//==============================================================================
+static bool serializeJoint(proto::SkeletonJoint& proto, const Joint* joint)
+{
+  const std::string& type = joint->getType();
+  proto.set_type(type);
+  proto.set_name(joint->getName());
+  serializeTransform(
+      *proto.mutable_transformfromparent(),
+      joint->getTransformFromParentBodyNode(),
+      joint->getOriginalTransformFromParentBodyNode());
+  serializeTransform(
+      *proto.mutable_transformfromchild(),
+      joint->getTransformFromChildBodyNode(),
+      joint->getOriginalTransformFromChildBodyNode());
+  proto::serializeVector(*proto.mutable_parentscale(), joint->getParentScale());
+  proto::serializeVector(*proto.mutable_childscale(), joint->getChildScale());
+  proto.set_actuatortype(static_cast<int>(joint->getActuatorType()));
+  proto.set_positionlimitenforced(joint->isPositionLimitEnforced());
+
+  const int dofs = joint->getNumDofs();
+  Eigen::VectorXs springStiffness = Eigen::VectorXs::Zero(dofs);
+  Eigen::VectorXs restPositions = Eigen::VectorXs::Zero(dofs);
+  Eigen::VectorXs dampingCoefficients = Eigen::VectorXs::Zero(dofs);
+  Eigen::VectorXs coulombFriction = Eigen::VectorXs::Zero(dofs);
+  for (int i = 0; i < dofs; i++)
+  {
+    proto.add_dofnames(joint->getDofName(i));
+    springStiffness(i) = joint->getSpringStiffness(i);
+    restPositions(i) = joint->getRestPosition(i);
+    dampingCoefficients(i) = joint->getDampingCoefficient(i);
+    coulombFriction(i) = joint->getCoulombFriction(i);
+  }
+  proto::serializeVector(*proto.mutable_positions(), joint->getPositions());
+  proto::serializeVector(*proto.mutable_velocities(), joint->getVelocities());
+  proto::serializeVector(
+      *proto.mutable_positionlowerlimits(), joint->getPositionLowerLimits());
+  proto::serializeVector(
+      *proto.mutable_positionupperlimits(), joint->getPositionUpperLimits());
+  proto::serializeVector(
+      *proto.mutable_velocitylowerlimits(), joint->getVelocityLowerLimits());
+  proto::serializeVector(
+      *proto.mutable_velocityupperlimits(), joint->getVelocityUpperLimits());
+  proto::serializeVector(
+      *proto.mutable_controlforcelowerlimits(),
+      joint->getControlForceLowerLimits());
+  proto::serializeVector(
+      *proto.mutable_controlforceupperlimits(),
+      joint->getControlForceUpperLimits());
+  proto::serializeVector(*proto.mutable_springstiffness(), springStiffness);
+  proto::serializeVector(*proto.mutable_restpositions(), restPositions);
+  proto::serializeVector(
+      *proto.mutable_dampingcoefficients(), dampingCoefficients);
+  proto::serializeVector(*proto.mutable_coulombfriction(), coulombFriction);
+
+  if (type == WeldJoint::getStaticType() || type == BallJoint::getStaticType()
+      || type == FreeJoint::getStaticType()
+      || type == TranslationalJoint::getStaticType())
+  {
+    // Nothing else to save
+  }
+  else if (type == RevoluteJoint::getStaticType())
+  {
+    proto::serializeVector(
+        *proto.mutable_axis(),
+        static_cast<const RevoluteJoint*>(joint)->getAxis());
+  }
+  else if (type == PrismaticJoint::getStaticType())
+  {
+    proto::serializeVector(
+        *proto.mutable_axis(),
+        static_cast<const PrismaticJoint*>(joint)->getAxis());
+  }
+  else if (type == ScrewJoint::getStaticType())
+  {
+    const ScrewJoint* screwJoint = static_cast<const ScrewJoint*>(joint);
+    proto::serializeVector(*proto.mutable_axis(), screwJoint->getAxis());
+    proto.set_pitch(static_cast<double>(screwJoint->getPitch()));
+  }
+  else if (type == UniversalJoint::getStaticType())
+  {
+    const UniversalJoint* universalJoint
+        = static_cast<const UniversalJoint*>(joint);
+    proto::serializeVector(*proto.mutable_axis(), universalJoint->getAxis1());
+    proto::serializeVector(*proto.mutable_axis2(), universalJoint->getAxis2());
+  }
+  else if (type == EulerJoint::getStaticType())
+  {
+    const EulerJoint* eulerJoint = static_cast<const EulerJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(eulerJoint->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), eulerJoint->getFlipAxisMap());
+  }
+  else if (type == EulerFreeJoint::getStaticType())
+  {
+    const EulerFreeJoint* eulerFreeJoint
+        = static_cast<const EulerFreeJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(eulerFreeJoint->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), eulerFreeJoint->getFlipAxisMap());
+  }
+  else if (type == EllipsoidJoint::getStaticType())
+  {
+    const EllipsoidJoint* ellipsoidJoint
+        = static_cast<const EllipsoidJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(ellipsoidJoint->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), ellipsoidJoint->getFlipAxisMap());
+    proto::serializeVector(
+        *proto.mutable_ellipsoidradii(), ellipsoidJoint->getEllipsoidRadii());
+  }
+  else if (type == ScapulathoracicJoint::getStaticType())
+  {
+    const ScapulathoracicJoint* scapulaJoint
+        = static_cast<const ScapulathoracicJoint*>(joint);
+    proto.set_axisorder(static_cast<int>(scapulaJoint->getAxisOrder()));
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), scapulaJoint->getFlipAxisMap());
+    proto::serializeVector(
+        *proto.mutable_ellipsoidradii(), scapulaJoint->getEllipsoidRadii());
+    proto::serializeVector(
+        *proto.mutable_wingingaxisoffset(),
+        scapulaJoint->getWingingAxisOffset());
+    proto.set_wingingaxisdirection(
+        static_cast<double>(scapulaJoint->getWingingAxisDirection()));
+  }
+  else if (type == ConstantCurveIncompressibleJoint::getStaticType())
+  {
+    const ConstantCurveIncompressibleJoint* curveJoint
+        = static_cast<const ConstantCurveIncompressibleJoint*>(joint);
+    proto::serializeVector(
+        *proto.mutable_flipaxismap(), curveJoint->getFlipAxisMap());
+    proto::serializeVector(
+        *proto.mutable_neutralpos(), curveJoint->getNeutralPos());
+    proto.set_length(static_cast<double>(curveJoint->getLength()));
+  }
+  else if (
+      !serializeCustomJoint<1>(proto, joint)
+      && !serializeCustomJoint<2>(proto, joint)
+      && !serializeCustomJoint<3>(proto, joint)
+      && !serializeCustomJoint<4>(proto, joint)
+      && !serializeCustomJoint<5>(proto, joint)
+      && !serializeCustomJoint<6>(proto, joint))
+  {
+    dterr << "[Skeleton::serialize] Joint [" << joint->getName()
+          << "] has type [" << type << "], which we can't serialize\n";
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+static void serializeShapeNode(
+    proto::SkeletonShape& proto, const ShapeNode* shapeNode)
+{
+  const ConstShapePtr& shape = shapeNode->getShape();
+  const std::string& type = shape->getType();
+  proto.set_type(type);
+  proto.set_name(shapeNode->getName());
+  proto::serializeMatrix(
+      *proto.mutable_relativetransform(),
+      shapeNode->getRelativeTransform().matrix());
+
+  Eigen::VectorXs size;
+  if (type == BoxShape::getStaticType())
+  {
+    size = static_cast<const BoxShape*>(shape.get())->getSize();
+  }
+  else if (type == SphereShape::getStaticType())
+  {
+    size = Eigen::VectorXs::Constant(
+        1, static_cast<const SphereShape*>(shape.get())->getRadius());
+  }
+  else if (type == CapsuleShape::getStaticType())
+  {
+    const CapsuleShape* capsule = static_cast<const CapsuleShape*>(shape.get());
+    size = Eigen::Vector2s(capsule->getRadius(), capsule->getHeight());
+  }
+  else if (type == CylinderShape::getStaticType())
+  {
+    const CylinderShape* cylinder
+        = static_cast<const CylinderShape*>(shape.get());
+    size = Eigen::Vector2s(cylinder->getRadius(), cylinder->getHeight());
+  }
+  else if (type == EllipsoidShape::getStaticType())
+  {
+    size = static_cast<const EllipsoidShape*>(shape.get())->getDiameters();
+  }
+  else if (type == MeshShape::getStaticType())
+  {
+    const MeshShape* mesh = static_cast<const MeshShape*>(shape.get());
+    size = mesh->getScale();
+    proto.set_meshuri(mesh->getMeshUri());
+  }
+  proto::serializeVector(*proto.mutable_size(), size);
+
+  const VisualAspect* visual = shapeNode->getVisualAspect();
+  if (visual != nullptr)
+  {
+    proto.set_hasvisualaspect(true);
+    proto::serializeVector(*proto.mutable_rgba(), visual->getRGBA());
+    proto.set_hidden(visual->isHidden());
+  }
+  const CollisionAspect* collision = shapeNode->getCollisionAspect();
+  if (collision != nullptr)
+  {
+    proto.set_hascollisionaspect(true);
+    proto.set_collidable(collision->isCollidable());
+  }
+  const DynamicsAspect* dynamics = shapeNode->getDynamicsAspect();
+  if (dynamics != nullptr)
+  {
+    proto.set_hasdynamicsaspect(true);
+    proto.set_frictioncoeff(static_cast<double>(dynamics->getFrictionCoeff()));
+    proto.set_restitutioncoeff(
+        static_cast<double>(dynamics->getRestitutionCoeff()));
+  }
+}
+
+//==============================================================================
+static ShapePtr deserializeShape(
+    const proto::SkeletonShape& proto,
+    const common::ResourceRetrieverPtr& retriever)
+{
+  const std::string& type = proto.type();
+  Eigen::VectorXs size = proto::deserializeVector(proto.size());
+  if (type == BoxShape::getStaticType() && size.size() == 3)
+  {
+    return std::make_shared<BoxShape>(size);
+  }
+  else if (type == SphereShape::getStaticType() && size.size() == 1)
+  {
+    return std::make_shared<SphereShape>(size(0));
+  }
+  else if (type == CapsuleShape::getStaticType() && size.size() == 2)
+  {
+    return std::make_shared<CapsuleShape>(size(0), size(1));
+  }
+  else if (type == CylinderShape::getStaticType() && size.size() == 2)
+  {
+    return std::make_shared<CylinderShape>(size(0), size(1));
+  }
+  else if (type == EllipsoidShape::getStaticType() && size.size() == 3)
+  {
+    return std::make_shared<EllipsoidShape>(size);
+  }
+  else if (type == MeshShape::getStaticType() && size.size() == 3)
+  {
+    common::Uri meshUri(proto.meshuri());
+    std::shared_ptr<SharedMeshWrapper> mesh
+        = MeshShape::loadMesh(meshUri, retriever);
+    if (!mesh)
+    {
+      dtwarn << "[Skeleton::deserialize] Failed to load mesh ["
+             << proto.meshuri() << "], so we're skipping that shape\n";
+      return nullptr;
+    }
+    return std::make_shared<MeshShape>(size, mesh, meshUri, retriever);
+  }
+  dtwarn << "[Skeleton::deserialize] Skipping a shape of type [" << type
+         << "], which we can't deserialize\n";
+  return nullptr;
+}
+
+//==============================================================================
+template <class JointType>
+static Joint* createSerializedJoint(
+    Skeleton* skel,
+    BodyNode* parent,
+    const std::string& jointName,
+    const BodyNode::Properties& bodyProps)
+{
+  typename JointType::Properties props;
+  props.mName = jointName;
+  return skel->createJointAndBodyNodePair<JointType>(parent, props, bodyProps)
+      .first;
+}
+
+//==============================================================================
+template <std::size_t Dimension>
+static Joint* createSerializedCustomJoint(
+    Skeleton* skel,
+    BodyNode* parent,
+    const proto::SkeletonJoint& proto,
+    const BodyNode::Properties& bodyProps)
+{
+  if (proto.customfunctions_size() != 6
+      || proto.customfunctiondrivenbydof_size() != 6)
+  {
+    return nullptr;
+  }
+  std::vector<std::shared_ptr<math::CustomFunction>> functions;
+  for (int i = 0; i < 6; i++)
+  {
+    functions.push_back(deserializeCustomFunction(proto.customfunctions(i)));
+    if (!functions.back())
+    {
+      return nullptr;
+    }
+  }
+
+  CustomJoint<Dimension>* joint = static_cast<CustomJoint<Dimension>*>(
+      createSerializedJoint<CustomJoint<Dimension>>(
+          skel, parent, proto.name(), bodyProps));
+  joint->setAxisOrder(
+      static_cast<EulerJoint::AxisOrder>(proto.axisorder()), false);
+  joint->setFlipAxisMap(
+      deserializeVector3(proto.flipaxismap(), Eigen::Vector3s::Ones()));
+  for (int i = 0; i < 6; i++)
+  {
+    joint->setCustomFunction(
+        i, functions[i], proto.customfunctiondrivenbydof(i));
+  }
+  return joint;
+}
+
+//==============================================================================
+static Joint* createSerializedJointAndBodyNode(
+    Skeleton* skel,
+    BodyNode* parent,
+    const proto::SkeletonJoint& proto,
+    const BodyNode::Properties& bodyProps)
+{
+  const std::string& type = proto.type();
+  const std::string& name = proto.name();
+  Eigen::Vector3s flips
+      = deserializeVector3(proto.flipaxismap(), Eigen::Vector3s::Ones());
+  EulerJoint::AxisOrder axisOrder
+      = static_cast<EulerJoint::AxisOrder>(proto.axisorder());
+
+  if (type == WeldJoint::getStaticType())
+  {
+    return createSerializedJoint<WeldJoint>(skel, parent, name, bodyProps);
+  }
+  else if (type == BallJoint::getStaticType())
+  {
+    return createSerializedJoint<BallJoint>(skel, parent, name, bodyProps);
+  }
+  else if (type == FreeJoint::getStaticType())
+  {
+    return createSerializedJoint<FreeJoint>(skel, parent, name, bodyProps);
+  }
+  else if (type == TranslationalJoint::getStaticType())
+  {
+    return createSerializedJoint<TranslationalJoint>(
+        skel, parent, name, bodyProps);
+  }
+  else if (type == RevoluteJoint::getStaticType())
+  {
+    RevoluteJoint* joint = static_cast<RevoluteJoint*>(
+        createSerializedJoint<RevoluteJoint>(skel, parent, name, bodyProps));
+    joint->setAxis(
+        deserializeVector3(proto.axis(), Eigen::Vector3s::UnitZ()));
+    return joint;
+  }
+  else if (type == PrismaticJoint::getStaticType())
+  {
+    PrismaticJoint* joint = static_cast<PrismaticJoint*>(
+        createSerializedJoint<PrismaticJoint>(skel, parent, name, bodyProps));
+    joint->setAxis(
+        deserializeVector3(proto.axis(), Eigen::Vector3s::UnitZ()));
+    return joint;
+  }
+  else if (type == ScrewJoint::getStaticType())
+  {
+    ScrewJoint* joint = static_cast<ScrewJoint*>(
+        createSerializedJoint<ScrewJoint>(skel, parent, name, bodyProps));
+    joint->setAxis(
+        deserializeVector3(proto.axis(), Eigen::Vector3s::UnitZ()));
+    joint->setPitch(proto.pitch());
+    return joint;
+  }
+  else if (type == UniversalJoint::getStaticType())
+  {
+    UniversalJoint* joint = static_cast<UniversalJoint*>(
+        createSerializedJoint<UniversalJoint>(skel, parent, name, bodyProps));
+    joint->setAxis1(
+        deserializeVector3(proto.axis(), Eigen::Vector3s::UnitX()));
+    joint->setAxis2(
+        deserializeVector3(proto.axis2(), Eigen::Vector3s::UnitY()));
+    return joint;
+  }
+  else if (type == EulerJoint::getStaticType())
+  {
+    EulerJoint* joint = static_cast<EulerJoint*>(
+        createSerializedJoint<EulerJoint>(skel, parent, name, bodyProps));
+    joint->setAxisOrder(axisOrder, false);
+    joint->setFlipAxisMap(flips);
+    return joint;
+  }
+  else if (type == EulerFreeJoint::getStaticType())
+  {
+    EulerFreeJoint* joint = static_cast<EulerFreeJoint*>(
+        createSerializedJoint<EulerFreeJoint>(skel, parent, name, bodyProps));
+    joint->setAxisOrder(axisOrder, false);
+    joint->setFlipAxisMap(flips);
+    return joint;
+  }
+  else if (type == EllipsoidJoint::getStaticType())
+  {
+    EllipsoidJoint* joint = static_cast<EllipsoidJoint*>(
+        createSerializedJoint<EllipsoidJoint>(skel, parent, name, bodyProps));
+    joint->setAxisOrder(axisOrder, false);
+    joint->setFlipAxisMap(flips);
+    joint->setEllipsoidRadii(
+        deserializeVector3(proto.ellipsoidradii(), Eigen::Vector3s::Ones()));
+    return joint;
+  }
+  else if (type == ScapulathoracicJoint::getStaticType())
+  {
+    ScapulathoracicJoint* joint = static_cast<ScapulathoracicJoint*>(
+        createSerializedJoint<ScapulathoracicJoint>(
+            skel, parent, name, bodyProps));
+    joint->setAxisOrder(axisOrder, false);
+    Eigen::VectorXs scapulaFlips
+        = proto::deserializeVector(proto.flipaxismap());
+    if (scapulaFlips.size() == 4)
+    {
+      joint->setFlipAxisMap(scapulaFlips);
+    }
+    joint->setEllipsoidRadii(
+        deserializeVector3(proto.ellipsoidradii(), Eigen::Vector3s::Ones()));
+    Eigen::VectorXs wingingOffset
+        = proto::deserializeVector(proto.wingingaxisoffset());
+    if (wingingOffset.size() == 2)
+    {
+      joint->setWingingAxisOffset(wingingOffset);
+    }
+    joint->setWingingAxisDirection(proto.wingingaxisdirection());
+    return joint;
+  }
+  else if (type == ConstantCurveIncompressibleJoint::getStaticType())
+  {
+    ConstantCurveIncompressibleJoint* joint
+        = static_cast<ConstantCurveIncompressibleJoint*>(
+            createSerializedJoint<ConstantCurveIncompressibleJoint>(
+                skel, parent, name, bodyProps));
+    joint->setFlipAxisMap(flips);
+    joint->setNeutralPos(
+        deserializeVector3(proto.neutralpos(), Eigen::Vector3s::Zero()));
+    joint->setLength(proto.length());
+    return joint;
+  }
+  else if (type == CustomJoint<1>::getStaticType())
+  {
+    return createSerializedCustomJoint<1>(skel, parent, proto, bodyProps);
+  }
+  else if (type == CustomJoint<2>::getStaticType())
+  {
+    return createSerializedCustomJoint<2>(skel, parent, proto, bodyProps);
+  }
+  else if (type == CustomJoint<3>::getStaticType())
+  {
+    return createSerializedCustomJoint<3>(skel, parent, proto, bodyProps);
+  }
+  else if (type == CustomJoint<4>::getStaticType())
+  {
+    return createSerializedCustomJoint<4>(skel, parent, proto, bodyProps);
+  }
+  else if (type == CustomJoint<5>::getStaticType())
+  {
+    return createSerializedCustomJoint<5>(skel, parent, proto, bodyProps);
+  }
+  else if (type == CustomJoint<6>::getStaticType())
+  {
+    return createSerializedCustomJoint<6>(skel, parent, proto, bodyProps);
+  }
+  return nullptr;
+}
+
+//==============================================================================
+/// This sets everything on a Joint that all the joint types have in common
+static void deserializeJointProperties(
+    Joint* joint, const proto::SkeletonJoint& proto)
+{
+  joint->setTransformFromParentBodyNode(
+      deserializeTransform(proto.transformfromparent()));
+  joint->setTransformFromChildBodyNode(
+      deserializeTransform(proto.transformfromchild()));
+  joint->setParentScale(
+      deserializeVector3(proto.parentscale(), Eigen::Vector3s::Ones()));
+  joint->setChildScale(
+      deserializeVector3(proto.childscale(), Eigen::Vector3s::Ones()));
+  joint->setActuatorType(
+      static_cast<Joint::ActuatorType>(proto.actuatortype()));
+  joint->setPositionLimitEnforced(proto.positionlimitenforced());
+
+  const int dofs = joint->getNumDofs();
+  if (proto.dofnames_size() != dofs)
+  {
+    dtwarn << "[Skeleton::deserialize] Joint [" << joint->getName()
+           << "] has " << dofs << " DOFs, but the proto has "
+           << proto.dofnames_size() << ". Leaving the DOFs at defaults.\n";
+    return;
+  }
+  for (int i = 0; i < dofs; i++)
+  {
+    joint->setDofName(i, proto.dofnames(i));
+  }
+
+  // Fields from older messages may be missing, so only set what's the right
+  // size
+  auto setIfSized = [dofs](
+                        const proto::VectorXs& vecProto,
+                        const std::function<void(const Eigen::VectorXs&)>& fn) {
+    Eigen::VectorXs vec = proto::deserializeVector(vecProto);
+    if (vec.size() == dofs)
+    {
+      fn(vec);
+    }
+  };
+  setIfSized(proto.positionlowerlimits(), [joint](const Eigen::VectorXs& v) {
+    joint->setPositionLowerLimits(v);
+  });
+  setIfSized(proto.positionupperlimits(), [joint](const Eigen::VectorXs& v) {
+    joint->setPositionUpperLimits(v);
+  });
+  setIfSized(proto.velocitylowerlimits(), [joint](const Eigen::VectorXs& v) {
+    joint->setVelocityLowerLimits(v);
+  });
+  setIfSized(proto.velocityupperlimits(), [joint](const Eigen::VectorXs& v) {
+    joint->setVelocityUpperLimits(v);
+  });
+  setIfSized(
+      proto.controlforcelowerlimits(), [joint](const Eigen::VectorXs& v) {
+        joint->setControlForceLowerLimits(v);
+      });
+  setIfSized(
+      proto.controlforceupperlimits(), [joint](const Eigen::VectorXs& v) {
+        joint->setControlForceUpperLimits(v);
+      });
+  setIfSized(proto.springstiffness(), [joint](const Eigen::VectorXs& v) {
+    for (int i = 0; i < v.size(); i++)
+      joint->setSpringStiffness(i, v(i));
+  });
+  setIfSized(proto.restpositions(), [joint](const Eigen::VectorXs& v) {
+    for (int i = 0; i < v.size(); i++)
+      joint->setRestPosition(i, v(i));
+  });
+  setIfSized(proto.dampingcoefficients(), [joint](const Eigen::VectorXs& v) {
+    for (int i = 0; i < v.size(); i++)
+      joint->setDampingCoefficient(i, v(i));
+  });
+  setIfSized(proto.coulombfriction(), [joint](const Eigen::VectorXs& v) {
+    for (int i = 0; i < v.size(); i++)
+      joint->setCoulombFriction(i, v(i));
+  });
+  setIfSized(proto.positions(), [joint](const Eigen::VectorXs& v) {
+    joint->setPositions(v);
+  });
+  setIfSized(proto.velocities(), [joint](const Eigen::VectorXs& v) {
+    joint->setVelocities(v);
+  });
+}
+
+//==============================================================================
+bool Skeleton::serialize(proto::Skeleton& proto, const MarkerMap& markers) const
+{
+  proto.set_version(SKELETON_SERIALIZATION_VERSION);
+  proto.set_name(getName());
+  proto::serializeVector(*proto.mutable_gravity(), getGravity());
+  proto.set_mobile(isMobile());
+  proto.set_selfcollisioncheck(getSelfCollisionCheck());
+  proto.set_adjacentbodycheck(getAdjacentBodyCheck());
+
+  for (std::size_t i = 0; i < getNumBodyNodes(); i++)
+  {
+    const BodyNode* body = getBodyNode(i);
+    proto::SkeletonBodyNode* bodyProto = proto.add_bodies();
+    bodyProto->set_name(body->getName());
+    const BodyNode* parent = body->getParentBodyNode();
+    bodyProto->set_parent(
+        parent == nullptr ? -1
+                          : static_cast<int>(parent->getIndexInSkeleton()));
+    if (!serializeJoint(
+            *bodyProto->mutable_parentjoint(), body->getParentJoint()))
+    {
+      return false;
+    }
+
+    const Inertia& inertia = body->getInertia();
+    bodyProto->set_mass(static_cast<double>(inertia.getMass()));
+    proto::serializeVector(*bodyProto->mutable_com(), inertia.getLocalCOM());
+    proto::serializeMatrix(*bodyProto->mutable_moment(), inertia.getMoment());
+    proto::serializeVector(*bodyProto->mutable_scale(), body->getScale());
+    proto::serializeVector(
+        *bodyProto->mutable_scalelowerbound(), body->getScaleLowerBound());
+    proto::serializeVector(
+        *bodyProto->mutable_scaleupperbound(), body->getScaleUpperBound());
+
+    for (std::size_t j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      serializeShapeNode(*bodyProto->add_shapes(), body->getShapeNode(j));
+    }
+  }
+
+  for (const BodyScaleGroup& group : mBodyScaleGroups)
+  {
+    proto::SkeletonScaleGroup* groupProto = proto.add_scalegroups();
+    for (int i = 0; i < group.nodes.size(); i++)
+    {
+      groupProto->add_bodies(group.nodes[i]->getIndexInSkeleton());
+      for (int axis = 0; axis < 3; axis++)
+      {
+        groupProto->add_flipaxis(static_cast<double>(group.flipAxis[i](axis)));
+      }
+    }
+    groupProto->set_uniformscaling(group.uniformScaling);
+  }
+
+  for (const auto& pair : markers)
+  {
+    const BodyNode* body = pair.second.first;
+    if (body == nullptr || body->getSkeleton().get() != this)
+    {
+      dtwarn << "[Skeleton::serialize] Skipping marker [" << pair.first
+             << "], which isn't attached to this Skeleton\n";
+      continue;
+    }
+    proto::SkeletonMarker* markerProto = proto.add_markers();
+    markerProto->set_name(pair.first);
+    markerProto->set_body(body->getIndexInSkeleton());
+    proto::serializeVector(*markerProto->mutable_offset(), pair.second.second);
+  }
+
+  return true;
+}
+
+//==============================================================================
+std::string Skeleton::serialize(const MarkerMap& markers) const
+{
+  proto::Skeleton proto;
+  if (!serialize(proto, markers))
+  {
+    return "";
+  }
+  return proto.SerializeAsString();
+}
+
+//==============================================================================
+SkeletonPtr Skeleton::deserialize(
+    const proto::Skeleton& proto,
+    MarkerMap* markers,
+    const common::ResourceRetrieverPtr& nullOrRetriever)
+{
+  if (proto.version() > SKELETON_SERIALIZATION_VERSION)
+  {
+    dterr << "[Skeleton::deserialize] This Skeleton was serialized with "
+          << "version " << proto.version() << ", but we only understand up to "
+          << "version " << SKELETON_SERIALIZATION_VERSION << "\n";
+    return nullptr;
+  }
+  const common::ResourceRetrieverPtr retriever
+      = nullOrRetriever ? nullOrRetriever
+                        : std::make_shared<common::LocalResourceRetriever>();
+
+  SkeletonPtr skel = Skeleton::create(proto.name());
+  Eigen::VectorXs gravity = proto::deserializeVector(proto.gravity());
+  if (gravity.size() == 3)
+  {
+    skel->setGravity(gravity);
+  }
+  skel->setMobile(proto.mobile());
+  skel->setSelfCollisionCheck(proto.selfcollisioncheck());
+  skel->setAdjacentBodyCheck(proto.adjacentbodycheck());
+
+  for (int i = 0; i < proto.bodies_size(); i++)
+  {
+    const proto::SkeletonBodyNode& bodyProto = proto.bodies(i);
+    if (bodyProto.parent() >= i)
+    {
+      dterr << "[Skeleton::deserialize] Body [" << bodyProto.name()
+            << "] comes before its parent\n";
+      return nullptr;
+    }
+    BodyNode* parent = bodyProto.parent() < 0
+                           ? nullptr
+                           : skel->getBodyNode(bodyProto.parent());
+
+    BodyNode::Properties bodyProps;
+    bodyProps.mName = bodyProto.name();
+    Eigen::MatrixXs moment = proto::deserializeMatrix(bodyProto.moment());
+    bodyProps.mInertia = Inertia(
+        bodyProto.mass(),
+        deserializeVector3(bodyProto.com(), Eigen::Vector3s::Zero()),
+        moment.rows() == 3 && moment.cols() == 3
+            ? Eigen::Matrix3s(moment)
+            : Eigen::Matrix3s::Identity());
+
+    Joint* joint = createSerializedJointAndBodyNode(
+        skel.get(), parent, bodyProto.parentjoint(), bodyProps);
+    if (joint == nullptr)
+    {
+      dterr << "[Skeleton::deserialize] Couldn't create joint ["
+            << bodyProto.parentjoint().name() << "] of type ["
+            << bodyProto.parentjoint().type() << "]\n";
+      return nullptr;
+    }
+    deserializeJointProperties(joint, bodyProto.parentjoint());
+
+    // The shapes and inertia are already scaled, so we set the scale
+    // directly, rather than through setScale(), which would scale them again
+    BodyNode* body = joint->getChildBodyNode();
+    body->mScale
+        = deserializeVector3(bodyProto.scale(), Eigen::Vector3s::Ones());
+    body->mScaleLowerBound = deserializeVector3(
+        bodyProto.scalelowerbound(), body->mScaleLowerBound);
+    body->mScaleUpperBound = deserializeVector3(
+        bodyProto.scaleupperbound(), body->mScaleUpperBound);
+
+    for (const proto::SkeletonShape& shapeProto : bodyProto.shapes())
+    {
+      ShapePtr shape = deserializeShape(shapeProto, retriever);
+      if (!shape)
+      {
+        continue;
+      }
+      ShapeNode* shapeNode = body->createShapeNode(shape, shapeProto.name());
+      shapeNode->setRelativeTransform(
+          deserializeTransform(shapeProto.relativetransform()));
+      if (shapeProto.hasvisualaspect())
+      {
+        VisualAspect* visual = shapeNode->createVisualAspect();
+        Eigen::VectorXs rgba = proto::deserializeVector(shapeProto.rgba());
+        if (rgba.size() == 4)
+        {
+          visual->setRGBA(rgba);
+        }
+        visual->setHidden(shapeProto.hidden());
+      }
+      if (shapeProto.hascollisionaspect())
+      {
+        shapeNode->createCollisionAspect()->setCollidable(
+            shapeProto.collidable());
+      }
+      if (shapeProto.hasdynamicsaspect())
+      {
+        DynamicsAspect* dynamics = shapeNode->createDynamicsAspect();
+        dynamics->setFrictionCoeff(shapeProto.frictioncoeff());
+        dynamics->setRestitutionCoeff(shapeProto.restitutioncoeff());
+      }
+    }
+  }
+
+  if (proto.scalegroups_size() > 0)
   {
-    Joint* joint = skelClone->getJoint(i);
-    if (joint->getActuatorType() == Joint::MIMIC)
+    skel->mBodyScaleGroups.clear();
+    for (const proto::SkeletonScaleGroup& groupProto : proto.scalegroups())
     {
-      const Joint* mimicJoint
-          = skelClone->getJoint(joint->getMimicJoint()->getName());
-      if (mimicJoint)
+      BodyScaleGroup group;
+      for (int i = 0; i < groupProto.bodies_size(); i++)
       {
-        joint->setMimicJoint(
-            mimicJoint, joint->getMimicMultiplier(), joint->getMimicOffset());
-      }
-      else
-      {
-        dterr << "[Skeleton::clone] Failed to clone mimic joint successfully: "
-              << "Unable to find the mimic joint ["
-              << joint->getMimicJoint()->getName()
-              << "] in the cloned Skeleton. Please report this as a bug!\n";
+        const int index = groupProto.bodies(i);
+        if (index < 0 || index >= skel->getNumBodyNodes())
+        {
+          dterr << "[Skeleton::deserialize] Scale group refers to body "
+                << index << ", which doesn't exist\n";
+          return nullptr;
+        }
+        group.nodes.push_back(skel->getBodyNode(index));
+        Eigen::Vector3s flips = Eigen::Vector3s::Ones();
+        if (groupProto.flipaxis_size() == 3 * groupProto.bodies_size())
+        {
+          for (int axis = 0; axis < 3; axis++)
+          {
+            flips(axis) = groupProto.flipaxis(i * 3 + axis);
+          }
+        }
+        group.flipAxis.push_back(flips);
       }
+      group.uniformScaling = groupProto.uniformscaling();
+      skel->mBodyScaleGroups.push_back(group);
     }
+    skel->updateGroupScaleIndices();
   }
 
-  // Fix the scale groups
-  for (auto group : mBodyScaleGroups)
+  if (markers != nullptr)
   {
-    if (group.nodes.size() > 0)
+    markers->clear();
+    for (const proto::SkeletonMarker& markerProto : proto.markers())
     {
-      for (int i = 1; i < group.nodes.size(); i++)
+      if (markerProto.body() < 0
+          || markerProto.body() >= skel->getNumBodyNodes())
       {
-        skelClone->mergeScaleGroups(
-            skelClone->getBodyNode(group.nodes[0]->getName()),
-            skelClone->getBodyNode(group.nodes[i]->getName()));
+        dtwarn << "[Skeleton::deserialize] Skipping marker ["
+               << markerProto.name() << "], which refers to a body that "
+               << "doesn't exist\n";
+        continue;
       }
-      skelClone->setScaleGroupUniformScaling(
-          skelClone->getBodyNode(group.nodes[0]->getName()),
-          group.uniformScaling);
+      (*markers)[markerProto.name()] = std::make_pair(
+          skel->getBodyNode(markerProto.body()),
+          deserializeVector3(markerProto.offset(), Eigen::Vector3s::Zero()));
     }
   }
 
-  return skelClone;
+  return skel;
 }
 
 //==============================================================================
-MetaSkeletonPtr Skeleton::cloneMetaSkeleton(const std::string& cloneName) const
+SkeletonPtr Skeleton::deserialize(
+    const std::string& bytes,
+    MarkerMap* markers,
+    const common::ResourceRetrieverPtr& retriever)
 {
-  return cloneSkeleton(cloneName);
+  proto::Skeleton proto;
+  if (!proto.ParseFromString(bytes))
+  {
+    dterr << "[Skeleton::deserialize] Failed to decode the Skeleton proto\n";
+    return nullptr;
+  }
+  return deserialize(proto, markers, retriever);
 }
 
 //==============================================================================
@@ -866,6 +1856,7 @@ void Skeleton::disableSelfCollision()
 void Skeleton::setSelfCollisionCheck(bool enable)
 {
   mAspectProperties.mEnabledSelfCollisionCheck = enable;
+  mIgnoredBodyPairsDirty = true;
 }
 
 //==============================================================================
@@ -896,6 +1887,7 @@ bool Skeleton::isEnabledSelfCollisionCheck() const
 void Skeleton::setAdjacentBodyCheck(bool enable)
 {
   mAspectProperties.mEnabledAdjacentBodyCheck = enable;
+  mIgnoredBodyPairsDirty = true;
 }
 
 //==============================================================================
@@ -922,6 +1914,41 @@ bool Skeleton::isEnabledAdjacentBodyCheck() const
   return getAdjacentBodyCheck();
 }
 
+//==============================================================================
+bool Skeleton::isSelfCollisionIgnored(
+    std::size_t bodyNodeIndex1, std::size_t bodyNodeIndex2) const
+{
+  if (mIgnoredBodyPairsDirty)
+  {
+    const std::size_t n = getNumBodyNodes();
+    mIgnoredBodyPairsRowWords = (n + 63) / 64;
+    const std::uint64_t fill
+        = isEnabledSelfCollisionCheck() ? 0u : ~static_cast<std::uint64_t>(0);
+    mIgnoredBodyPairs.assign(n * mIgnoredBodyPairsRowWords, fill);
+
+    if (isEnabledSelfCollisionCheck() && !isEnabledAdjacentBodyCheck())
+    {
+      for (std::size_t i = 0; i < n; i++)
+      {
+        const BodyNode* parent = mSkelCache.mBodyNodes[i]->getParentBodyNode();
+        if (parent == nullptr)
+          continue;
+        const std::size_t j = parent->getIndexInSkeleton();
+        const std::uint64_t one = 1;
+        const std::size_t ij = i * mIgnoredBodyPairsRowWords * 64 + j;
+        const std::size_t ji = j * mIgnoredBodyPairsRowWords * 64 + i;
+        mIgnoredBodyPairs[ij / 64] |= one << (ij % 64);
+        mIgnoredBodyPairs[ji / 64] |= one << (ji % 64);
+      }
+    }
+    mIgnoredBodyPairsDirty = false;
+  }
+
+  const std::size_t bit
+      = bodyNodeIndex1 * mIgnoredBodyPairsRowWords * 64 + bodyNodeIndex2;
+  return (mIgnoredBodyPairs[bit / 64] >> (bit % 64)) & 1u;
+}
+
 //==============================================================================
 void Skeleton::setMobile(bool _isMobile)
 {
@@ -934,6 +1961,18 @@ bool Skeleton::isMobile() const
   return mAspectProperties.mIsMobile;
 }
 
+//==============================================================================
+void Skeleton::setAsleep(bool asleep)
+{
+  mIsAsleep = asleep;
+}
+
+//==============================================================================
+bool Skeleton::isAsleep() const
+{
+  return mIsAsleep;
+}
+
 //==============================================================================
 void Skeleton::setTimeStep(s_t _timeStep)
 {
@@ -989,6 +2028,42 @@ std::size_t Skeleton::getNumTrees() const
   return mTreeCache.size();
 }
 
+//==============================================================================
+template <typename Update>
+void Skeleton::updateTrees(Update update) const
+{
+  const std::size_t numTrees = mTreeCache.size();
+  int numThreads = mNumTreeThreads;
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  numThreads = static_cast<int>(
+      std::min<std::size_t>(std::max(numThreads, 1), numTrees));
+
+  if (numThreads <= 1)
+  {
+    for (std::size_t tree = 0; tree < numTrees; ++tree)
+      update(tree);
+    return;
+  }
+
+  // Each thread takes a contiguous range of trees. The trees don't share any
+  // BodyNodes, Joints or DOFs, so as long as `update` only touches the ones
+  // in its own tree (and that tree's entry in mTreeCache), they can't race.
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(numThreads);
+  for (int thread = 0; thread < numThreads; ++thread)
+  {
+    const std::size_t begin = numTrees * thread / numThreads;
+    const std::size_t end = numTrees * (thread + 1) / numThreads;
+    futures.push_back(common::async([&update, begin, end] {
+      for (std::size_t tree = begin; tree < end; ++tree)
+        update(tree);
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+}
+
 //==============================================================================
 BodyNode* Skeleton::getRootBodyNode(std::size_t _treeIdx)
 {
@@ -2236,6 +3311,66 @@ Eigen::MatrixXs Skeleton::getJacobianOfFD(neural::WithRespectTo* wrt)
   return DMinv_Dp - Minv * DC_Dp - Minv * D_damp_spring;
 }
 
+//==============================================================================
+Eigen::MatrixXs Skeleton::getJacobianOfFD_ID(neural::WithRespectTo* wrt)
+{
+  const int dofs = static_cast<int>(getNumDofs());
+  if (dofs == 0)
+  {
+    return Eigen::MatrixXs::Zero(0, wrt->dim(this));
+  }
+  if (wrt != neural::WithRespectTo::POSITION
+      && wrt != neural::WithRespectTo::VELOCITY
+      && wrt != neural::WithRespectTo::FORCE)
+  {
+    return getJacobianOfFD(wrt);
+  }
+
+  bool hasAnyZeroDof = false;
+  for (int i = 0; i < getNumJoints(); i++)
+  {
+    if (getJoint(i)->getNumDofs() == 0)
+    {
+      hasAnyZeroDof = true;
+      break;
+    }
+  }
+
+  // This is the same as dID/dtau, and lets FORCE share the code below
+  Eigen::MatrixXs DID_Dp = -Eigen::MatrixXs::Identity(dofs, dofs);
+  if (wrt != neural::WithRespectTo::FORCE)
+  {
+    // The accelerations that the forward dynamics would give us right now
+    Eigen::VectorXs f = getControlForces() - getCoriolisAndGravityForces()
+                        - getDampingForce() - getSpringForce();
+    Eigen::VectorXs ddq;
+    if (hasAnyZeroDof)
+    {
+      ddq = getInvMassMatrix() * f;
+    }
+    else
+    {
+      ddq = multiplyByImplicitInvMassMatrix(f);
+    }
+
+    DID_Dp = getJacobianOfM(ddq, wrt) + getJacobianOfC(wrt)
+             + getJacobianOfDampSpring(wrt);
+  }
+
+  // Our implicit multiply doesn't support zero-DOF joints yet
+  if (hasAnyZeroDof)
+  {
+    return -getInvMassMatrix() * DID_Dp;
+  }
+
+  Eigen::MatrixXs DFD_Dp(dofs, dofs);
+  for (int i = 0; i < dofs; i++)
+  {
+    DFD_Dp.col(i) = -multiplyByImplicitInvMassMatrix(DID_Dp.col(i));
+  }
+  return DFD_Dp;
+}
+
 //==============================================================================
 Eigen::MatrixXs Skeleton::getUnconstrainedVelJacobianWrt(
     s_t dt, neural::WithRespectTo* wrt)
@@ -3185,6 +4320,60 @@ Eigen::VectorXs Skeleton::getPositionLowerLimits()
   return limits;
 }
 
+//==============================================================================
+void Skeleton::getJointsAtPositionLimits(std::vector<Joint*>& joints)
+{
+  joints.clear();
+
+  const std::size_t n = getNumDofs();
+  if (mPackedPositionLimitsVersion != getVersion()
+      || static_cast<std::size_t>(mPackedPositionLowerLimits.size()) != n)
+  {
+    mPackedPositionLowerLimits.resize(n);
+    mPackedPositionUpperLimits.resize(n);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      DegreeOfFreedom* dof = getDof(i);
+      const Joint* joint = dof->getJoint();
+      if (joint->isPositionLimitEnforced() && !joint->isKinematic())
+      {
+        mPackedPositionLowerLimits(i) = dof->getPositionLowerLimit();
+        mPackedPositionUpperLimits(i) = dof->getPositionUpperLimit();
+      }
+      else
+      {
+        mPackedPositionLowerLimits(i) = -std::numeric_limits<s_t>::infinity();
+        mPackedPositionUpperLimits(i) = std::numeric_limits<s_t>::infinity();
+      }
+    }
+    mPackedPositionLimitsVersion = getVersion();
+  }
+
+  if (n == 0)
+    return;
+
+  const Eigen::VectorXs positions = getPositions();
+  if (((positions.array() > mPackedPositionLowerLimits.array())
+       && (positions.array() < mPackedPositionUpperLimits.array()))
+          .all())
+  {
+    return;
+  }
+
+  for (std::size_t i = 0; i < n; i++)
+  {
+    if (positions(i) > mPackedPositionLowerLimits(i)
+        && positions(i) < mPackedPositionUpperLimits(i))
+      continue;
+
+    // A joint's DOFs are contiguous, so we only need to check the last joint
+    // we added for duplicates
+    Joint* joint = getDof(i)->getJoint();
+    if (joints.empty() || joints.back() != joint)
+      joints.push_back(joint);
+  }
+}
+
 //==============================================================================
 Eigen::VectorXs Skeleton::getVelocityUpperLimits()
 {
@@ -4104,6 +5293,8 @@ BodyScaleGroupAndIndex::BodyScaleGroupAndIndex(BodyScaleGroup& group, int axis)
 /// getGroupScaleIndexDetails()
 void Skeleton::updateGroupScaleIndices()
 {
+  mKinematicsVersion++;
+  mInertiaVersion++;
   mGroupScaleIndices.clear();
   // Find the group and axis we're talking about
   for (int i = 0; i < mBodyScaleGroups.size(); i++)
@@ -4472,6 +5663,166 @@ Eigen::Vector3s Skeleton::finiteDifferenceGroupScaleMovementOnJointInWorldSpace(
   return result;
 }
 
+//==============================================================================
+/// This adds `bodyScaleJac`, the motion of a point per unit change of each of
+/// a body's scale axes (one per column), to the columns of that body's group
+/// scale in rows `row` to `row + 2` of `jac`
+static void addBodyScaleJacobianToGroupScales(
+    Eigen::MatrixXs& jac,
+    int row,
+    int column,
+    bool uniform,
+    const Eigen::Matrix3s& bodyScaleJac)
+{
+  // This body isn't in any group
+  if (column == -1)
+    return;
+  if (uniform)
+  {
+    jac.block<3, 1>(row, column) += bodyScaleJac.rowwise().sum();
+  }
+  else
+  {
+    jac.block<3, 3>(row, column) += bodyScaleJac;
+  }
+}
+
+//==============================================================================
+/// This adds the motion of `node` due to scaling each of its ancestor bodies,
+/// which stretches the offset between the joint into the ancestor and the
+/// joint out of it towards `node`
+static void addGroupScaleMovementFromAncestors(
+    Eigen::MatrixXs& jac,
+    int row,
+    BodyNode* node,
+    const std::vector<int>& columns,
+    const std::vector<bool>& uniform)
+{
+  while (node->getParentBodyNode() != nullptr)
+  {
+    BodyNode* parent = node->getParentBodyNode();
+    Eigen::Vector3s localT
+        = node->getParentJoint()->getOriginalTransformFromParentBodyNode()
+          - parent->getParentJoint()->getOriginalTransformFromChildBodyNode();
+    int index = parent->getIndexInSkeleton();
+    addBodyScaleJacobianToGroupScales(
+        jac,
+        row,
+        columns[index],
+        uniform[index],
+        parent->getWorldTransform().linear() * localT.asDiagonal());
+    node = parent;
+  }
+}
+
+//==============================================================================
+/// This returns getGroupScaleMovementOnBodyInWorldSpace() for every group
+/// scale and body at once, as a (3 * bodies) x getGroupScaleDim() matrix.
+Eigen::MatrixXs Skeleton::getGroupScaleMovementOnBodiesInWorldSpace()
+{
+  std::vector<int> columns;
+  std::vector<bool> uniform;
+  getBodyGroupScaleColumns(columns, uniform);
+
+  Eigen::MatrixXs result
+      = Eigen::MatrixXs::Zero(getNumBodyNodes() * 3, getGroupScaleDim());
+  for (int i = 0; i < getNumBodyNodes(); i++)
+  {
+    BodyNode* target = getBodyNode(i);
+    // Scaling the target itself moves its center along the offset to its
+    // parent joint
+    Eigen::Vector3s localT
+        = -target->getParentJoint()->getOriginalTransformFromChildBodyNode();
+    addBodyScaleJacobianToGroupScales(
+        result,
+        i * 3,
+        columns[i],
+        uniform[i],
+        target->getWorldTransform().linear() * localT.asDiagonal());
+    addGroupScaleMovementFromAncestors(result, i * 3, target, columns, uniform);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns getGroupScaleMovementOnJointInWorldSpace() for every group
+/// scale and joint at once, as a (3 * joints) x getGroupScaleDim() matrix.
+Eigen::MatrixXs Skeleton::getGroupScaleMovementOnJointsInWorldSpace()
+{
+  std::vector<int> columns;
+  std::vector<bool> uniform;
+  getBodyGroupScaleColumns(columns, uniform);
+
+  Eigen::MatrixXs result
+      = Eigen::MatrixXs::Zero(getNumJoints() * 3, getGroupScaleDim());
+  for (int i = 0; i < getNumJoints(); i++)
+  {
+    // A joint doesn't move when its child body scales, so only the ancestors
+    // of the child body matter
+    addGroupScaleMovementFromAncestors(
+        result, i * 3, getJoint(i)->getChildBodyNode(), columns, uniform);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This fills `columns` with the index of the first column of each body's
+/// scale group in the group scales vector (or -1 if it isn't in one), and
+/// `uniform` with whether that group scales uniformly, so only has one column
+void Skeleton::getBodyGroupScaleColumns(
+    std::vector<int>& columns, std::vector<bool>& uniform)
+{
+  ensureBodyScaleGroups();
+  columns.assign(getNumBodyNodes(), -1);
+  uniform.assign(getNumBodyNodes(), false);
+
+  int cursor = 0;
+  for (int i = 0; i < mBodyScaleGroups.size(); i++)
+  {
+    for (dynamics::BodyNode* node : mBodyScaleGroups[i].nodes)
+    {
+      columns[node->getIndexInSkeleton()] = cursor;
+      uniform[node->getIndexInSkeleton()] = mBodyScaleGroups[i].uniformScaling;
+    }
+    if (mBodyScaleGroups[i].uniformScaling)
+    {
+      cursor++;
+    }
+    else
+    {
+      cursor += 3;
+    }
+  }
+}
+
+//==============================================================================
+/// This fills `childScaleMotion` with how far each body moves in world space
+/// per unit change of each of its own scale axes (one per column), and
+/// `parentScaleMotion` with how far each body moves per unit change of each of
+/// its parent body's scale axes.
+void Skeleton::getBodyScaleMotions(
+    std::vector<Eigen::Matrix3s>& childScaleMotion,
+    std::vector<Eigen::Matrix3s>& parentScaleMotion)
+{
+  childScaleMotion.assign(getNumBodyNodes(), Eigen::Matrix3s::Zero());
+  parentScaleMotion.assign(getNumBodyNodes(), Eigen::Matrix3s::Zero());
+  for (int i = 0; i < getNumBodyNodes(); i++)
+  {
+    BodyNode* node = getBodyNode(i);
+    dynamics::Joint* joint = node->getParentJoint();
+    for (int axis = 0; axis < 3; axis++)
+    {
+      childScaleMotion[i].col(axis)
+          = joint->getWorldTranslationOfChildBodyWrtChildScale(axis);
+      if (node->getParentBodyNode() != nullptr)
+      {
+        parentScaleMotion[i].col(axis)
+            = joint->getWorldTranslationOfChildBodyWrtParentScale(axis);
+      }
+    }
+  }
+}
+
 //==============================================================================
 /// This sets the scales of all the body nodes according to their group
 /// membership. The `scale` vector is expected to be 3 times the size of the
@@ -4526,6 +5877,25 @@ Eigen::VectorXs Skeleton::getGroupScales()
   return groups;
 }
 
+//==============================================================================
+/// This counts changes to anything that moves the bodies of this Skeleton
+/// around: joint positions, joint transforms, body scales and the scale
+/// groups. Callers can compare it against a saved value to tell when
+/// kinematic results they've cached have gone stale.
+std::size_t Skeleton::getKinematicsVersion() const
+{
+  return mKinematicsVersion;
+}
+
+//==============================================================================
+/// This counts changes to the mass, COM or moment of inertia (or their
+/// bounds) of any BodyNode in this Skeleton, and to which BodyNodes and
+/// scale groups there are.
+std::size_t Skeleton::getInertiaVersion() const
+{
+  return mInertiaVersion;
+}
+
 //==============================================================================
 /// This converts a map of body scales back into group scales, interpreting
 /// everything as gradients.
@@ -5311,8 +6681,51 @@ Eigen::MatrixXs Skeleton::convertBodyScalesJacobianToGroupScales(
 Eigen::MatrixXs Skeleton::getJointWorldPositionsJacobianWrtGroupScales(
     const std::vector<dynamics::Joint*>& joints)
 {
-  return convertBodyScalesJacobianToGroupScales(
-      getJointWorldPositionsJacobianWrtBodyScales(joints));
+  // This is getJointWorldPositionsJacobianWrtBodyScales() followed by
+  // convertBodyScalesJacobianToGroupScales(), except that each joint only
+  // visits the bodies it's actually downstream of, and adds straight into the
+  // group columns.
+  std::vector<int> columns;
+  std::vector<bool> uniform;
+  getBodyGroupScaleColumns(columns, uniform);
+  std::vector<Eigen::Matrix3s> childScaleMotion;
+  std::vector<Eigen::Matrix3s> parentScaleMotion;
+  getBodyScaleMotions(childScaleMotion, parentScaleMotion);
+
+  Eigen::MatrixXs jac
+      = Eigen::MatrixXs::Zero(joints.size() * 3, getGroupScaleDim());
+  for (int j = 0; j < joints.size(); j++)
+  {
+    BodyNode* node = joints[j]->getChildBodyNode();
+    int index = node->getIndexInSkeleton();
+
+    // Ignore any translation of the child body due to simply scaling the child
+    // offset, since the joint isn't attached to the child offset
+    Eigen::Matrix3s selfMotion = childScaleMotion[index];
+    for (int axis = 0; axis < 3; axis++)
+    {
+      selfMotion.col(axis)
+          -= joints[j]->Joint::getWorldTranslationOfChildBodyWrtChildScale(
+              axis);
+    }
+    addBodyScaleJacobianToGroupScales(
+        jac, j * 3, columns[index], uniform[index], selfMotion);
+
+    while (node->getParentBodyNode() != nullptr)
+    {
+      int parentIndex = node->getParentBodyNode()->getIndexInSkeleton();
+      addBodyScaleJacobianToGroupScales(
+          jac,
+          j * 3,
+          columns[parentIndex],
+          uniform[parentIndex],
+          childScaleMotion[parentIndex]
+              + parentScaleMotion[node->getIndexInSkeleton()]);
+      node = node->getParentBodyNode();
+    }
+  }
+
+  return jac;
 }
 
 //==============================================================================
@@ -5352,8 +6765,46 @@ Skeleton::finiteDifferenceJointWorldPositionsJacobianWrtGroupScales(
 Eigen::MatrixXs Skeleton::getMarkerWorldPositionsJacobianWrtGroupScales(
     const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers)
 {
-  return convertBodyScalesJacobianToGroupScales(
-      getMarkerWorldPositionsJacobianWrtBodyScales(markers));
+  // This is getMarkerWorldPositionsJacobianWrtBodyScales() followed by
+  // convertBodyScalesJacobianToGroupScales(), except that each marker only
+  // visits the bodies it's actually downstream of, and adds straight into the
+  // group columns.
+  std::vector<int> columns;
+  std::vector<bool> uniform;
+  getBodyGroupScaleColumns(columns, uniform);
+  std::vector<Eigen::Matrix3s> childScaleMotion;
+  std::vector<Eigen::Matrix3s> parentScaleMotion;
+  getBodyScaleMotions(childScaleMotion, parentScaleMotion);
+
+  Eigen::MatrixXs jac
+      = Eigen::MatrixXs::Zero(markers.size() * 3, getGroupScaleDim());
+  for (int j = 0; j < markers.size(); j++)
+  {
+    BodyNode* node = markers[j].first;
+    int index = node->getIndexInSkeleton();
+
+    // The marker is directly attached to this body, so its offset scales too
+    Eigen::Matrix3s selfMotion = node->getWorldTransform().linear()
+                                     * markers[j].second.asDiagonal();
+    selfMotion += childScaleMotion[index];
+    addBodyScaleJacobianToGroupScales(
+        jac, j * 3, columns[index], uniform[index], selfMotion);
+
+    while (node->getParentBodyNode() != nullptr)
+    {
+      int parentIndex = node->getParentBodyNode()->getIndexInSkeleton();
+      addBodyScaleJacobianToGroupScales(
+          jac,
+          j * 3,
+          columns[parentIndex],
+          uniform[parentIndex],
+          childScaleMotion[parentIndex]
+              + parentScaleMotion[node->getIndexInSkeleton()]);
+      node = node->getParentBodyNode();
+    }
+  }
+
+  return jac;
 }
 
 //==============================================================================
@@ -5845,8 +7296,86 @@ std::map<std::string, Eigen::Vector3s> Skeleton::getJointWorldPositionsMap()
   std::map<std::string, Eigen::Vector3s> result;
   for (int i = 0; i < getNumJoints(); i++)
   {
-    result[getJoint(i)->getName()] = getJointWorldPosition(i);
+    result[getJoint(i)->getName()] = getJointWorldPosition(i);
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the world positions of the origins of `bodies` on every
+/// frame of `poses`, as a (3 * bodies.size()) x poses.cols() matrix. This
+/// only runs forward kinematics along the joints between the root and
+/// `bodies`, which is much cheaper than setPositions() and
+/// getWorldTransform() on every frame when `bodies` are a small part of the
+/// Skeleton. The Skeleton's positions are left unchanged.
+Eigen::MatrixXs Skeleton::getBodyWorldPositionsOverTrajectory(
+    const std::vector<const BodyNode*>& bodies, const Eigen::MatrixXs& poses)
+{
+  // Collect the bodies along the chains to each of `bodies`, with every
+  // parent ahead of its children
+  std::vector<int> chain;
+  std::vector<int> chainIndex(getNumBodyNodes(), -1);
+  for (const BodyNode* body : bodies)
+  {
+    std::vector<const BodyNode*> path;
+    for (const BodyNode* cursor = body;
+         cursor != nullptr && chainIndex[cursor->getIndexInSkeleton()] == -1;
+         cursor = cursor->getParentBodyNode())
+    {
+      path.push_back(cursor);
+    }
+    for (int i = path.size() - 1; i >= 0; i--)
+    {
+      chainIndex[path[i]->getIndexInSkeleton()] = chain.size();
+      chain.push_back(path[i]->getIndexInSkeleton());
+    }
+  }
+  std::vector<int> parentInChain;
+  for (int index : chain)
+  {
+    const BodyNode* parent = getBodyNode(index)->getParentBodyNode();
+    parentInChain.push_back(
+        parent == nullptr ? -1 : chainIndex[parent->getIndexInSkeleton()]);
+  }
+
+  Eigen::VectorXs originalPositions = getPositions();
+
+  Eigen::MatrixXs result
+      = Eigen::MatrixXs::Zero(bodies.size() * 3, poses.cols());
+  std::vector<Eigen::Isometry3s> worldTransforms(chain.size());
+  for (int t = 0; t < poses.cols(); t++)
+  {
+    for (int i = 0; i < chain.size(); i++)
+    {
+      Joint* joint = getBodyNode(chain[i])->getParentJoint();
+      int dofs = joint->getNumDofs();
+      if (dofs > 0)
+      {
+        joint->setPositions(
+            poses.col(t).segment(joint->getIndexInSkeleton(0), dofs));
+      }
+      // Composing the joint transforms ourselves leaves the BodyNode caches
+      // dirty, so after the first frame setting a joint's positions doesn't
+      // have to walk the whole subtree below it to dirty them again
+      if (parentInChain[i] == -1)
+      {
+        worldTransforms[i] = joint->getRelativeTransform();
+      }
+      else
+      {
+        worldTransforms[i] = worldTransforms[parentInChain[i]]
+                             * joint->getRelativeTransform();
+      }
+    }
+    for (int b = 0; b < bodies.size(); b++)
+    {
+      result.block<3, 1>(b * 3, t)
+          = worldTransforms[chainIndex[bodies[b]->getIndexInSkeleton()]]
+                .translation();
+    }
   }
+
+  setPositions(originalPositions);
   return result;
 }
 
@@ -6129,6 +7658,144 @@ Eigen::VectorXs Skeleton::getMarkerWorldPositions(
   return positions;
 }
 
+//==============================================================================
+/// This splits `numPoses` timesteps into contiguous chunks, and calls
+/// solveRange(clone, start, end) for each chunk, on its own clone of `skel`,
+/// on up to `numThreads` threads (<= 0 means one per hardware thread). Each
+/// chunk only ever touches its own clone, so the threads never share state,
+/// and keeping the chunks contiguous means each clone only moves a small
+/// distance between consecutive timesteps.
+template <typename SolveRange>
+static void solvePoseChunks(
+    const Skeleton* skel,
+    int numPoses,
+    int numThreads,
+    const SolveRange& solveRange)
+{
+  if (numPoses == 0)
+    return;
+
+  if (numThreads <= 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  numThreads = std::min(numThreads, numPoses);
+
+  std::vector<SkeletonPtr> clones;
+  std::vector<common::TaskFuture<void>> futures;
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    const int start = (numPoses * threadIdx) / numThreads;
+    const int end = (numPoses * (threadIdx + 1)) / numThreads;
+    clones.push_back(skel->cloneSkeleton());
+    Skeleton* clone = clones.back().get();
+    if (numThreads == 1)
+    {
+      solveRange(clone, start, end);
+    }
+    else
+    {
+      futures.push_back(common::async(
+          [&solveRange, clone, start, end] { solveRange(clone, start, end); }));
+    }
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+Eigen::MatrixXs Skeleton::getMarkerWorldPositionsBatch(
+    const Eigen::MatrixXs& poses,
+    const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>& markers,
+    int numThreads)
+{
+  const int numPoses = poses.cols();
+  assert(poses.rows() == getNumDofs());
+
+  // The clones have the same bodies as we do, in the same order
+  std::vector<std::size_t> bodyIndices;
+  for (const auto& marker : markers)
+  {
+    assert(marker.first->getSkeleton().get() == this);
+    bodyIndices.push_back(marker.first->getIndexInSkeleton());
+  }
+
+  Eigen::MatrixXs positions
+      = Eigen::MatrixXs::Zero(markers.size() * 3, numPoses);
+  auto solveRange = [&](Skeleton* skel, int start, int end) {
+    std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> cloneMarkers;
+    for (int i = 0; i < markers.size(); i++)
+      cloneMarkers.emplace_back(
+          skel->getBodyNode(bodyIndices[i]), markers[i].second);
+
+    for (int t = start; t < end; t++)
+    {
+      skel->setPositions(poses.col(t));
+      positions.col(t) = skel->getMarkerWorldPositions(cloneMarkers);
+    }
+  };
+  solvePoseChunks(this, numPoses, numThreads, solveRange);
+
+  return positions;
+}
+
+//==============================================================================
+s_t Skeleton::getMarkerAverageErrorBatch(
+    const Eigen::MatrixXs& poses,
+    const MarkerMap& markers,
+    const std::vector<std::map<std::string, Eigen::Vector3s>>& observations,
+    int numThreads,
+    int* numObserved)
+{
+  const int numPoses = poses.cols();
+  assert(poses.rows() == getNumDofs());
+  assert(observations.size() == numPoses);
+
+  std::vector<std::string> names;
+  std::vector<std::size_t> bodyIndices;
+  std::vector<Eigen::Vector3s> offsets;
+  for (const auto& pair : markers)
+  {
+    assert(pair.second.first->getSkeleton().get() == this);
+    names.push_back(pair.first);
+    bodyIndices.push_back(pair.second.first->getIndexInSkeleton());
+    offsets.push_back(pair.second.second);
+  }
+
+  // Each timestep gets its own slot, and we add them up in order afterwards,
+  // so the result doesn't depend on the number of threads
+  Eigen::VectorXs errors = Eigen::VectorXs::Zero(numPoses);
+  Eigen::VectorXi counts = Eigen::VectorXi::Zero(numPoses);
+  auto solveRange = [&](Skeleton* skel, int start, int end) {
+    for (int t = start; t < end; t++)
+    {
+      skel->setPositions(poses.col(t));
+      const std::map<std::string, Eigen::Vector3s>& observed = observations[t];
+      for (int i = 0; i < names.size(); i++)
+      {
+        auto it = observed.find(names[i]);
+        if (it == observed.end())
+          continue;
+
+        const BodyNode* body = skel->getBodyNode(bodyIndices[i]);
+        const Eigen::Vector3s position
+            = body->getWorldTransform()
+              * body->getScale().cwiseProduct(offsets[i]);
+        errors(t) += (it->second - position).norm();
+        counts(t)++;
+      }
+    }
+  };
+  solvePoseChunks(this, numPoses, numThreads, solveRange);
+
+  const int count = counts.sum();
+  if (numObserved != nullptr)
+    *numObserved = count;
+  if (count == 0)
+    return 0.0;
+  return errors.sum() / count;
+}
+
 //==============================================================================
 /// This returns the Jacobian relating changes in source skeleton joint
 /// positions to changes in source joint world positions.
@@ -6138,13 +7805,49 @@ Eigen::MatrixXs Skeleton::getMarkerWorldPositionsJacobianWrtJointPositions(
 {
   Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(markers.size() * 3, getNumDofs());
 
+  // Every marker on a body is moved by the same DOFs (the body's dependent
+  // generalized coordinates), along the same world screw axes. Only the
+  // marker's offset from those axes differs. So we get the screws once per
+  // body, and then each marker only costs a cross product per DOF.
+  std::vector<math::Jacobian> bodyScrews(getNumBodyNodes());
+  std::vector<bool> hasBodyScrews(getNumBodyNodes(), false);
+
   for (int i = 0; i < markers.size(); i++)
   {
-    math::Jacobian bodyJac = getWorldPositionJacobian(
-        markers[i].first,
-        markers[i].first->getScale().cwiseProduct(markers[i].second));
-    jac.block(3 * i, 0, 3, bodyJac.cols())
-        = bodyJac.block(3, 0, 3, bodyJac.cols());
+    const BodyNode* body = markers[i].first;
+    if (body->getSkeleton().get() != this)
+    {
+      dterr << "[Skeleton::getMarkerWorldPositionsJacobianWrtJointPositions] "
+            << "Marker " << i << " is attached to BodyNode ["
+            << body->getName() << "], which isn't in Skeleton [" << getName()
+            << "]. Leaving its rows of the Jacobian as zeros.\n";
+      continue;
+    }
+
+    const std::vector<std::size_t>& dofs = body->getDependentGenCoordIndices();
+    const std::size_t bodyIndex = body->getIndexInSkeleton();
+    math::Jacobian& screws = bodyScrews[bodyIndex];
+    if (!hasBodyScrews[bodyIndex])
+    {
+      screws.resize(6, dofs.size());
+      for (int k = 0; k < dofs.size(); k++)
+      {
+        const DegreeOfFreedom* dof = getDof(dofs[k]);
+        screws.col(k) = dof->getJoint()->getWorldAxisScrewForPosition(
+            dof->getIndexInJoint());
+      }
+      hasBodyScrews[bodyIndex] = true;
+    }
+
+    const Eigen::Vector3s worldPos
+        = body->getWorldTransform()
+          * body->getScale().cwiseProduct(markers[i].second);
+    for (int k = 0; k < dofs.size(); k++)
+    {
+      jac.block<3, 1>(3 * i, dofs[k])
+          = screws.block<3, 1>(3, k)
+            + screws.block<3, 1>(0, k).cross(worldPos);
+    }
   }
 
   return jac;
@@ -9909,6 +11612,76 @@ const Eigen::MatrixXs& Skeleton::getInvAugMassMatrix() const
   return mSkelCache.mInvAugM;
 }
 
+//==============================================================================
+Eigen::SparseMatrix<s_t> Skeleton::getSparseMassMatrix() const
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
+  {
+    const std::vector<DegreeOfFreedom*>& treeDofs = mTreeCache[tree].mDofs;
+    std::size_t nTreeDofs = treeDofs.size();
+    if (nTreeDofs == 0)
+    {
+      continue;
+    }
+
+    const Eigen::MatrixXs& treeM = getMassMatrix(tree);
+    for (std::size_t i = 0; i < nTreeDofs; ++i)
+    {
+      const BodyNode* bodyI = treeDofs[i]->getChildBodyNode();
+      std::size_t ki = treeDofs[i]->getIndexInSkeleton();
+      for (std::size_t j = 0; j < nTreeDofs; ++j)
+      {
+        const BodyNode* bodyJ = treeDofs[j]->getChildBodyNode();
+        // DOFs on different branches of the tree never couple
+        if (bodyI != bodyJ && !bodyI->descendsFrom(bodyJ)
+            && !bodyJ->descendsFrom(bodyI))
+        {
+          continue;
+        }
+        std::size_t kj = treeDofs[j]->getIndexInSkeleton();
+        triplets.emplace_back(ki, kj, treeM(i, j));
+      }
+    }
+  }
+
+  std::size_t dof = mSkelCache.mDofs.size();
+  Eigen::SparseMatrix<s_t> M(dof, dof);
+  M.setFromTriplets(triplets.begin(), triplets.end());
+  return M;
+}
+
+//==============================================================================
+Eigen::SparseMatrix<s_t> Skeleton::getSparseInvMassMatrix() const
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
+  {
+    const std::vector<DegreeOfFreedom*>& treeDofs = mTreeCache[tree].mDofs;
+    std::size_t nTreeDofs = treeDofs.size();
+    if (nTreeDofs == 0)
+    {
+      continue;
+    }
+
+    const Eigen::MatrixXs& treeMinv = getInvMassMatrix(tree);
+    for (std::size_t i = 0; i < nTreeDofs; ++i)
+    {
+      std::size_t ki = treeDofs[i]->getIndexInSkeleton();
+      for (std::size_t j = 0; j < nTreeDofs; ++j)
+      {
+        std::size_t kj = treeDofs[j]->getIndexInSkeleton();
+        triplets.emplace_back(ki, kj, treeMinv(i, j));
+      }
+    }
+  }
+
+  std::size_t dof = mSkelCache.mDofs.size();
+  Eigen::SparseMatrix<s_t> Minv(dof, dof);
+  Minv.setFromTriplets(triplets.begin(), triplets.end());
+  return Minv;
+}
+
 //==============================================================================
 Eigen::VectorXs Skeleton::multiplyByImplicitMassMatrix(Eigen::VectorXs x)
 {
@@ -10206,7 +11979,17 @@ const Eigen::VectorXs& Skeleton::getConstraintForces() const
 
 //==============================================================================
 Skeleton::Skeleton(const AspectPropertiesData& properties)
-  : mTotalMass(0.0), mIsImpulseApplied(false), mUnionSize(1)
+  : mTotalMass(0.0),
+    mIsImpulseApplied(false),
+    mIsAsleep(false),
+    mKinematicsVersion(0),
+    mInertiaVersion(0),
+    mPositionUpdatesDepth(0),
+    mPackedPositionLimitsVersion(std::numeric_limits<std::size_t>::max()),
+    mIgnoredBodyPairsRowWords(0),
+    mIgnoredBodyPairsDirty(true),
+    mNumTreeThreads(1),
+    mUnionSize(1)
 {
   createAspect<Aspect>(properties);
   createAspect<detail::BodyNodeVectorProxyAspect>();
@@ -10244,6 +12027,9 @@ void Skeleton::constructNewTree()
 //==============================================================================
 void Skeleton::registerBodyNode(BodyNode* _newBodyNode)
 {
+  mIgnoredBodyPairsDirty = true;
+  mInertiaVersion++;
+
 #ifndef NDEBUG // Debug mode
   std::vector<BodyNode*>::iterator repeat = std::find(
       mSkelCache.mBodyNodes.begin(), mSkelCache.mBodyNodes.end(), _newBodyNode);
@@ -10450,6 +12236,9 @@ void Skeleton::destructOldTree(std::size_t tree)
 //==============================================================================
 void Skeleton::unregisterBodyNode(BodyNode* _oldBodyNode)
 {
+  mIgnoredBodyPairsDirty = true;
+  mInertiaVersion++;
+
   unregisterJoint(_oldBodyNode->getParentJoint());
 
   BodyNode::NodeMap& nodeMap = _oldBodyNode->mNodeMap;
@@ -10856,6 +12645,8 @@ void Skeleton::updateCacheDimensions(Skeleton::DataCache& _cache)
   _cache.mCg = Eigen::VectorXs::Zero(dof);
   _cache.mFext = Eigen::VectorXs::Zero(dof);
   _cache.mFc = Eigen::VectorXs::Zero(dof);
+  _cache.mDirty.mMassMatrixBodies.assign(_cache.mBodyNodes.size(), false);
+  _cache.mDirty.mAugMassMatrixBodies.assign(_cache.mBodyNodes.size(), false);
 }
 
 //==============================================================================
@@ -10895,6 +12686,56 @@ void Skeleton::updateArticulatedInertia() const
   mSkelCache.mDirty.mArticulatedInertia = false;
 }
 
+//==============================================================================
+bool Skeleton::findDirtyMassMatrixColumns(
+    const DataCache& _cache,
+    bool _allColumns,
+    const std::vector<bool>& _dirtyBodies,
+    std::vector<bool>& _columns) const
+{
+  std::size_t numBodies = _cache.mBodyNodes.size();
+  if (_allColumns || _dirtyBodies.size() != numBodies)
+    return false;
+
+  // The entry M(i, j) only depends on the BodyNodes below the deeper of DOF i
+  // and DOF j, and on the joints on the path between them, so it can only
+  // change if one of those was dirtied. That means the columns for BodyNodes
+  // that are neither ancestors nor descendants of any dirty BodyNode are left
+  // untouched.
+  //
+  // BodyNodes are stored parents-first, so we can find all the descendants
+  // with a forward pass, and all the ancestors with a backward pass.
+  std::vector<bool> descendsFromDirty(numBodies, false);
+  for (std::size_t i = 0; i < numBodies; ++i)
+  {
+    const BodyNode* parent = _cache.mBodyNodes[i]->getParentBodyNode();
+    descendsFromDirty[i]
+        = _dirtyBodies[i]
+          || (parent != nullptr && descendsFromDirty[parent->getIndexInTree()]);
+  }
+  std::vector<bool> ancestorOfDirty(numBodies, false);
+  for (std::size_t i = numBodies; i-- > 0;)
+  {
+    const BodyNode* parent = _cache.mBodyNodes[i]->getParentBodyNode();
+    if (parent != nullptr && (_dirtyBodies[i] || ancestorOfDirty[i]))
+      ancestorOfDirty[parent->getIndexInTree()] = true;
+  }
+
+  _columns.assign(_cache.mDofs.size(), false);
+  bool anyClean = false;
+  for (std::size_t i = 0; i < numBodies; ++i)
+  {
+    bool dirty = descendsFromDirty[i] || ancestorOfDirty[i];
+    const Joint* joint = _cache.mBodyNodes[i]->getParentJoint();
+    for (std::size_t k = 0; k < joint->getNumDofs(); ++k)
+    {
+      _columns[joint->getIndexInTree(k)] = dirty;
+      anyClean = anyClean || !dirty;
+    }
+  }
+  return anyClean;
+}
+
 //==============================================================================
 void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
 {
@@ -10909,10 +12750,23 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
     return;
   }
 
-  cache.mM.setZero();
-
-  // Backup the original internal force
-  Eigen::VectorXs originalGenAcceleration = getAccelerations();
+  // If only some of the columns can have changed, we leave the rest of the
+  // matrix alone. Every column we do recompute overwrites its whole lower
+  // triangle, so we don't need to zero anything out first.
+  std::vector<bool> dirtyColumns;
+  bool partial = findDirtyMassMatrixColumns(
+      cache,
+      cache.mDirty.mAllMassMatrixColumns,
+      cache.mDirty.mMassMatrixBodies,
+      dirtyColumns);
+  if (!partial)
+    cache.mM.setZero();
+
+  // Backup the original accelerations of this tree. We only touch the DOFs
+  // of this tree, so that other trees can be updated at the same time.
+  std::vector<s_t> originalGenAcceleration(dof);
+  for (std::size_t i = 0; i < dof; ++i)
+    originalGenAcceleration[i] = cache.mDofs[i]->getAcceleration();
 
   // Clear out the accelerations of the dofs in this tree so that we can set
   // them to 1.0 one at a time to build up the mass matrix
@@ -10921,6 +12775,9 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
 
   for (std::size_t j = 0; j < dof; ++j)
   {
+    if (partial && !dirtyColumns[j])
+      continue;
+
     // Set the acceleration of this DOF to 1.0 while all the rest are 0.0
     cache.mDofs[j]->setAcceleration(1.0);
 
@@ -10955,8 +12812,13 @@ void Skeleton::updateMassMatrix(std::size_t _treeIdx) const
   cache.mM.triangularView<Eigen::StrictlyUpper>() = cache.mM.transpose();
 
   // Restore the original generalized accelerations
-  const_cast<Skeleton*>(this)->setAccelerations(originalGenAcceleration);
+  for (std::size_t i = 0; i < dof; ++i)
+    cache.mDofs[i]->setAcceleration(originalGenAcceleration[i]);
 
+  std::fill(
+      cache.mDirty.mMassMatrixBodies.begin(),
+      cache.mDirty.mMassMatrixBodies.end(),
+      false);
   cache.mDirty.mMassMatrix = false;
 }
 
@@ -10973,6 +12835,9 @@ void Skeleton::updateMassMatrix() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees([this](std::size_t tree) { getMassMatrix(tree); });
+
   mSkelCache.mM.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11009,10 +12874,21 @@ void Skeleton::updateAugMassMatrix(std::size_t _treeIdx) const
     return;
   }
 
-  cache.mAugM.setZero();
+  // See updateMassMatrix()
+  std::vector<bool> dirtyColumns;
+  bool partial = findDirtyMassMatrixColumns(
+      cache,
+      cache.mDirty.mAllAugMassMatrixColumns,
+      cache.mDirty.mAugMassMatrixBodies,
+      dirtyColumns);
+  if (!partial)
+    cache.mAugM.setZero();
 
-  // Backup the origianl internal force
-  Eigen::VectorXs originalGenAcceleration = getAccelerations();
+  // Backup the original accelerations of this tree. We only touch the DOFs
+  // of this tree, so that other trees can be updated at the same time.
+  std::vector<s_t> originalGenAcceleration(dof);
+  for (std::size_t i = 0; i < dof; ++i)
+    originalGenAcceleration[i] = cache.mDofs[i]->getAcceleration();
 
   // Clear out the accelerations of the DOFs in this tree so that we can set
   // them to 1.0 one at a time to build up the augmented mass matrix
@@ -11021,6 +12897,9 @@ void Skeleton::updateAugMassMatrix(std::size_t _treeIdx) const
 
   for (std::size_t j = 0; j < dof; ++j)
   {
+    if (partial && !dirtyColumns[j])
+      continue;
+
     // Set the acceleration of this DOF to 1.0 while all the rest are 0.0
     cache.mDofs[j]->setAcceleration(1.0);
 
@@ -11055,9 +12934,14 @@ void Skeleton::updateAugMassMatrix(std::size_t _treeIdx) const
   }
   cache.mAugM.triangularView<Eigen::StrictlyUpper>() = cache.mAugM.transpose();
 
-  // Restore the origianl internal force
-  const_cast<Skeleton*>(this)->setAccelerations(originalGenAcceleration);
+  // Restore the original generalized accelerations
+  for (std::size_t i = 0; i < dof; ++i)
+    cache.mDofs[i]->setAcceleration(originalGenAcceleration[i]);
 
+  std::fill(
+      cache.mDirty.mAugMassMatrixBodies.begin(),
+      cache.mDirty.mAugMassMatrixBodies.end(),
+      false);
   cache.mDirty.mAugMassMatrix = false;
 }
 
@@ -11074,6 +12958,9 @@ void Skeleton::updateAugMassMatrix() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees([this](std::size_t tree) { getAugMassMatrix(tree); });
+
   mSkelCache.mAugM.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11137,8 +13024,11 @@ void Skeleton::updateInvMassMatrix(std::size_t _treeIdx) const
   // We don't need to set mInvM as zero matrix as long as the below is correct
   // cache.mInvM.setZero();
 
-  // Backup the origianl internal force
-  Eigen::VectorXs originalInternalForce = getControlForces();
+  // Backup the original internal forces of this tree. We only touch the DOFs
+  // of this tree, so that other trees can be updated at the same time.
+  std::vector<s_t> originalInternalForce(dof);
+  for (std::size_t i = 0; i < dof; ++i)
+    originalInternalForce[i] = cache.mDofs[i]->getControlForce();
 
   // Clear out the forces of the dofs in this tree so that we can set them to
   // 1.0 one at a time to build up the inverse mass matrix
@@ -11181,7 +13071,8 @@ void Skeleton::updateInvMassMatrix(std::size_t _treeIdx) const
   cache.mInvM.triangularView<Eigen::StrictlyLower>() = cache.mInvM.transpose();
 
   // Restore the original internal force
-  const_cast<Skeleton*>(this)->setControlForces(originalInternalForce);
+  for (std::size_t i = 0; i < dof; ++i)
+    cache.mDofs[i]->setControlForce(originalInternalForce[i]);
 
   cache.mDirty.mInvMassMatrix = false;
 }
@@ -11199,6 +13090,9 @@ void Skeleton::updateInvMassMatrix() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees([this](std::size_t tree) { getInvMassMatrix(tree); });
+
   mSkelCache.mInvM.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11238,8 +13132,11 @@ void Skeleton::updateInvAugMassMatrix(std::size_t _treeIdx) const
   // We don't need to set mInvM as zero matrix as long as the below is correct
   // mInvM.setZero();
 
-  // Backup the origianl internal force
-  Eigen::VectorXs originalInternalForce = getControlForces();
+  // Backup the original internal forces of this tree. We only touch the DOFs
+  // of this tree, so that other trees can be updated at the same time.
+  std::vector<s_t> originalInternalForce(dof);
+  for (std::size_t i = 0; i < dof; ++i)
+    originalInternalForce[i] = cache.mDofs[i]->getControlForce();
 
   // Clear out the forces of the dofs in this tree so that we can set them to
   // 1.0 one at a time to build up the inverse augmented mass matrix
@@ -11284,7 +13181,8 @@ void Skeleton::updateInvAugMassMatrix(std::size_t _treeIdx) const
       = cache.mInvAugM.transpose();
 
   // Restore the original internal force
-  const_cast<Skeleton*>(this)->setControlForces(originalInternalForce);
+  for (std::size_t i = 0; i < dof; ++i)
+    cache.mDofs[i]->setControlForce(originalInternalForce[i]);
 
   cache.mDirty.mInvAugMassMatrix = false;
 }
@@ -11302,6 +13200,9 @@ void Skeleton::updateInvAugMassMatrix() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees([this](std::size_t tree) { getInvAugMassMatrix(tree); });
+
   mSkelCache.mInvAugM.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11367,6 +13268,9 @@ void Skeleton::updateCoriolisForces() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees([this](std::size_t tree) { getCoriolisForces(tree); });
+
   mSkelCache.mCvec.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11480,6 +13384,10 @@ void Skeleton::updateCoriolisAndGravityForces() const
     return;
   }
 
+  // Bring every tree up to date first, since they can go in parallel
+  updateTrees(
+      [this](std::size_t tree) { getCoriolisAndGravityForces(tree); });
+
   mSkelCache.mCg.setZero();
 
   for (std::size_t tree = 0; tree < mTreeCache.size(); ++tree)
@@ -11819,25 +13727,40 @@ void Skeleton::computeForwardKinematics(
   }
 }
 
+//==============================================================================
+void Skeleton::setNumTreeThreads(int numThreads)
+{
+  mNumTreeThreads = numThreads;
+}
+
+//==============================================================================
+int Skeleton::getNumTreeThreads() const
+{
+  return mNumTreeThreads;
+}
+
 //==============================================================================
 void Skeleton::computeForwardDynamics()
 {
   // Note: Articulated Inertias will be updated automatically when
   // getArtInertiaImplicit() is called in BodyNode::updateBiasForce()
 
-  for (auto it = mSkelCache.mBodyNodes.rbegin();
-       it != mSkelCache.mBodyNodes.rend();
-       ++it)
-    (*it)->updateBiasForce(
-        mAspectProperties.mGravity, mAspectProperties.mTimeStep);
+  // Trees don't depend on each other, so we run both recursions over one
+  // tree at a time
+  updateTrees([this](std::size_t tree) {
+    const std::vector<BodyNode*>& bodyNodes = mTreeCache[tree].mBodyNodes;
+    for (auto it = bodyNodes.rbegin(); it != bodyNodes.rend(); ++it)
+      (*it)->updateBiasForce(
+          mAspectProperties.mGravity, mAspectProperties.mTimeStep);
 
-  // Forward recursion
-  for (auto& bodyNode : mSkelCache.mBodyNodes)
-  {
-    bodyNode->updateAccelerationFD();
-    bodyNode->updateTransmittedForceFD();
-    bodyNode->updateJointForceFD(mAspectProperties.mTimeStep, true, true);
-  }
+    // Forward recursion
+    for (BodyNode* bodyNode : bodyNodes)
+    {
+      bodyNode->updateAccelerationFD();
+      bodyNode->updateTransmittedForceFD();
+      bodyNode->updateJointForceFD(mAspectProperties.mTimeStep, true, true);
+    }
+  });
 }
 
 //==============================================================================
@@ -11860,6 +13783,97 @@ void Skeleton::computeInverseDynamics(
   }
 }
 
+//==============================================================================
+void Skeleton::setPositions(const Eigen::VectorXs& positions)
+{
+  ScopedPositionUpdates batch(this);
+  MetaSkeleton::setPositions(positions);
+}
+
+//==============================================================================
+void Skeleton::setPositions(
+    const std::vector<std::size_t>& indices, const Eigen::VectorXs& positions)
+{
+  ScopedPositionUpdates batch(this);
+  MetaSkeleton::setPositions(indices, positions);
+}
+
+//==============================================================================
+void Skeleton::setPositions(
+    const IndexPlan& plan, const Eigen::VectorXs& positions)
+{
+  ScopedPositionUpdates batch(this);
+  MetaSkeleton::setPositions(plan, positions);
+}
+
+//==============================================================================
+void Skeleton::setPositionsAndWorldTransforms(
+    const Eigen::VectorXs& positions,
+    const std::vector<Eigen::Isometry3s>& worldTransforms)
+{
+  assert(worldTransforms.size() == getNumBodyNodes());
+  setPositions(positions);
+
+  // setPositions() has already flagged every child Frame of the bodies, so
+  // those still pick up the new transforms on their own
+  for (std::size_t i = 0; i < mSkelCache.mBodyNodes.size(); i++)
+  {
+    BodyNode* body = mSkelCache.mBodyNodes[i];
+    body->mWorldTransform = worldTransforms[i];
+    body->mNeedTransformUpdate = false;
+  }
+}
+
+//==============================================================================
+Eigen::MatrixXs Skeleton::computeInverseDynamicsBatch(
+    const Eigen::MatrixXs& poses,
+    const Eigen::MatrixXs& vels,
+    const Eigen::MatrixXs& accs,
+    const Eigen::MatrixXs& externalWrenches,
+    int numThreads)
+{
+  const int dofs = getNumDofs();
+  const int numBodies = getNumBodyNodes();
+  const int numTimesteps = poses.cols();
+  assert(poses.rows() == dofs && vels.rows() == dofs && accs.rows() == dofs);
+  assert(vels.cols() == numTimesteps && accs.cols() == numTimesteps);
+  const bool useWrenches = externalWrenches.size() > 0;
+  assert(
+      !useWrenches
+      || (externalWrenches.rows() == numBodies * 6
+          && externalWrenches.cols() == numTimesteps));
+
+  Eigen::MatrixXs taus = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+  if (dofs == 0)
+    return taus;
+
+  // Each chunk writes its own columns of `taus`, so the threads never touch
+  // the same memory
+  auto solveRange = [&](Skeleton* skel, int start, int end) {
+    for (int t = start; t < end; t++)
+    {
+      skel->setPositions(poses.col(t));
+      skel->setVelocities(vels.col(t));
+      skel->setAccelerations(accs.col(t));
+      if (useWrenches)
+      {
+        for (int i = 0; i < numBodies; i++)
+        {
+          BodyNode* body = skel->getBodyNode(i);
+          body->setExtWrench(math::dAdT(
+              body->getWorldTransform(),
+              externalWrenches.block<6, 1>(i * 6, t)));
+        }
+      }
+      skel->computeInverseDynamics(useWrenches);
+      taus.col(t) = skel->getControlForces();
+    }
+  };
+  solvePoseChunks(this, numTimesteps, numThreads, solveRange);
+
+  return taus;
+}
+
 //==============================================================================
 void Skeleton::clearExternalForces()
 {
@@ -11891,6 +13905,71 @@ void Skeleton::dirtyArticulatedInertia(std::size_t _treeIdx)
   SET_FLAG(_treeIdx, mCoriolisForces);
   SET_FLAG(_treeIdx, mGravityForces);
   SET_FLAG(_treeIdx, mCoriolisAndGravityForces);
+  mTreeCache[_treeIdx].mDirty.mAllMassMatrixColumns = true;
+  mTreeCache[_treeIdx].mDirty.mAllAugMassMatrixColumns = true;
+}
+
+//==============================================================================
+void Skeleton::dirtySubtreeArticulatedInertia(const BodyNode* _bodyNode)
+{
+  std::size_t treeIdx = _bodyNode->getTreeIndex();
+  std::size_t indexInTree = _bodyNode->getIndexInTree();
+  DirtyFlags& dirty = mTreeCache[treeIdx].mDirty;
+
+  // We can only get away with a partial update if the mass matrix was either
+  // clean, or already only partially dirty. We have to check this before
+  // dirtyArticulatedInertia() marks every column dirty.
+  bool partialMassMatrix = !dirty.mMassMatrix || !dirty.mAllMassMatrixColumns;
+  bool partialAugMassMatrix
+      = !dirty.mAugMassMatrix || !dirty.mAllAugMassMatrixColumns;
+
+  dirtyArticulatedInertia(treeIdx);
+
+  if (partialMassMatrix && indexInTree < dirty.mMassMatrixBodies.size())
+  {
+    dirty.mMassMatrixBodies[indexInTree] = true;
+    dirty.mAllMassMatrixColumns = false;
+  }
+  if (partialAugMassMatrix && indexInTree < dirty.mAugMassMatrixBodies.size())
+  {
+    dirty.mAugMassMatrixBodies[indexInTree] = true;
+    dirty.mAllAugMassMatrixColumns = false;
+  }
+}
+
+//==============================================================================
+void Skeleton::beginPositionUpdates()
+{
+  if (mPositionUpdatesDepth++ == 0)
+    mPendingPositionUpdates.assign(getNumBodyNodes(), false);
+}
+
+//==============================================================================
+void Skeleton::endPositionUpdates()
+{
+  assert(mPositionUpdatesDepth > 0);
+  if (--mPositionUpdatesDepth > 0)
+    return;
+
+  // BodyNodes always come after their parents, so this is topological order
+  for (std::size_t i = 0; i < mPendingPositionUpdates.size(); ++i)
+  {
+    if (mPendingPositionUpdates[i])
+      mSkelCache.mBodyNodes[i]->getParentJoint()->notifyPositionUpdated();
+  }
+}
+
+//==============================================================================
+Skeleton::ScopedPositionUpdates::ScopedPositionUpdates(Skeleton* skel)
+  : mSkel(skel)
+{
+  mSkel->beginPositionUpdates();
+}
+
+//==============================================================================
+Skeleton::ScopedPositionUpdates::~ScopedPositionUpdates()
+{
+  mSkel->endPositionUpdates();
 }
 
 //==============================================================================
@@ -12341,6 +14420,8 @@ Skeleton::DirtyFlags::DirtyFlags()
   : mArticulatedInertia(true),
     mMassMatrix(true),
     mAugMassMatrix(true),
+    mAllMassMatrixColumns(true),
+    mAllAugMassMatrixColumns(true),
     mInvMassMatrix(true),
     mInvAugMassMatrix(true),
     mGravityForces(true),
@@ -33,11 +33,15 @@
 #ifndef DART_DYNAMICS_SKELETON_HPP_
 #define DART_DYNAMICS_SKELETON_HPP_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 
+#include <Eigen/Sparse>
+
 #include "dart/common/NameManager.hpp"
+#include "dart/common/ResourceRetriever.hpp"
 #include "dart/common/VersionCounter.hpp"
 #include "dart/dynamics/EndEffector.hpp"
 #include "dart/dynamics/Joint.hpp"
@@ -58,6 +62,10 @@ namespace neural {
 class ConstrainedGroupGradientMatrices;
 }
 
+namespace proto {
+class Skeleton;
+}
+
 namespace dynamics {
 
 typedef std::map<std::string, std::pair<dynamics::BodyNode*, Eigen::Vector3s>>
@@ -231,6 +239,36 @@ public:
   MetaSkeletonPtr cloneMetaSkeleton(
       const std::string& cloneName) const override;
 
+  /// This writes this Skeleton out to a protobuf: the joints, bodies, shapes
+  /// (with meshes stored by URI), scale groups and current state, along with
+  /// any of `markers` that are attached to this Skeleton. Reading that back
+  /// with deserialize() is much faster than parsing any of the text formats,
+  /// and the bytes can be sent to other processes. This returns false, and
+  /// prints an error, if the Skeleton uses a joint type or custom function
+  /// that we don't know how to serialize.
+  bool serialize(
+      proto::Skeleton& proto, const MarkerMap& markers = MarkerMap()) const;
+
+  /// This is serialize(), but returns the encoded bytes, or an empty string
+  /// on failure.
+  std::string serialize(const MarkerMap& markers = MarkerMap()) const;
+
+  /// This builds a new Skeleton from the output of serialize(). Meshes are
+  /// loaded from their URIs using `retriever`, or from local files if that's
+  /// null. If `markers` isn't null, it's filled with the serialized markers,
+  /// attached to the new Skeleton. This returns nullptr, and prints an error,
+  /// if the proto is malformed or from a newer version.
+  static SkeletonPtr deserialize(
+      const proto::Skeleton& proto,
+      MarkerMap* markers = nullptr,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  /// This is deserialize(), but reads the encoded bytes from serialize()
+  static SkeletonPtr deserialize(
+      const std::string& bytes,
+      MarkerMap* markers = nullptr,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
   /// \}
 
   //----------------------------------------------------------------------------
@@ -329,6 +367,14 @@ public:
   /// Return true if self-collision check is enabled including adjacent bodies.
   bool isEnabledAdjacentBodyCheck() const;
 
+  /// Returns true if collision checking skips the pair of BodyNodes with
+  /// these indices, either because self-collision checking is off, or because
+  /// they're connected by a Joint and adjacent body checking is off. This is a
+  /// single lookup in a bitset of every pair, which is only rebuilt when
+  /// BodyNodes are added or removed, or those two options change.
+  bool isSelfCollisionIgnored(
+      std::size_t bodyNodeIndex1, std::size_t bodyNodeIndex2) const;
+
   /// Set whether this skeleton will be updated by forward dynamics.
   /// \param[in] _isMobile True if this skeleton is mobile.
   void setMobile(bool _isMobile);
@@ -337,6 +383,15 @@ public:
   /// \return True if this skeleton is mobile.
   bool isMobile() const;
 
+  /// Puts this skeleton to sleep, or wakes it up. A sleeping skeleton is
+  /// skipped by World::step() like an immobile one, until something touches
+  /// it. This is normally managed by the World, see
+  /// World::setSleepingEnabled().
+  void setAsleep(bool asleep);
+
+  /// Returns true if this skeleton is asleep. See setAsleep().
+  bool isAsleep() const;
+
   /// Set time step. This timestep is used for implicit joint damping
   /// force.
   void setTimeStep(s_t _timeStep);
@@ -714,6 +769,16 @@ public:
   /// @warning SLOW: Only for testing
   Eigen::MatrixXs getJacobianOfFD(neural::WithRespectTo* wrt);
 
+  /// This gives the same Jacobian as getJacobianOfFD(), using the derivative
+  /// of the inverse dynamics evaluated at the forward dynamics accelerations:
+  /// d(ddq)/dx = -Minv * dID/dx. dID/dx comes from the recursive passes behind
+  /// getJacobianOfM() and getJacobianOfC(), and each column is multiplied by
+  /// Minv with an articulated body pass, so Minv is never formed and this is
+  /// O(n^2) instead of O(n^3). Skeletons with zero-DOF joints fall back to
+  /// forming Minv, and anything other than POSITION, VELOCITY or FORCE falls
+  /// back to getJacobianOfFD().
+  Eigen::MatrixXs getJacobianOfFD_ID(neural::WithRespectTo* wrt);
+
   /// This gives the jacobian of damping and spring forces
   /// @warning SLOW: Only for testing
   Eigen::MatrixXs getJacobianOfDampSpring(neural::WithRespectTo* wrt);
@@ -832,6 +897,15 @@ public:
   // skeleton
   Eigen::VectorXs getPositionLowerLimits();
 
+  /// This finds every joint that enforces its position limits, isn't
+  /// kinematic, and has at least one DOF at or past one of its limits, and
+  /// writes them to `joints`, in DOF order. The limits are kept packed in one
+  /// pair of arrays for the whole skeleton, which are only rebuilt when the
+  /// joints change (see getVersion()), so finding the DOFs at their limits is
+  /// a single vectorized comparison against the positions. In the usual case,
+  /// where nothing is at a limit, this doesn't touch the joints at all.
+  void getJointsAtPositionLimits(std::vector<Joint*>& joints);
+
   // This gives the vector of velocity upper limits for all the DOFs in this
   // skeleton
   Eigen::VectorXs getVelocityUpperLimits();
@@ -1060,14 +1134,39 @@ public:
   Eigen::Vector3s finiteDifferenceGroupScaleMovementOnJointInWorldSpace(
       int groupIdx, int bodyIdx);
 
+  /// This returns getGroupScaleMovementOnBodyInWorldSpace() for every group
+  /// scale and body at once, as a (3 * bodies) x getGroupScaleDim() matrix.
+  /// Rather than checking every body of every group against every other body,
+  /// this walks once up the tree from each body.
+  Eigen::MatrixXs getGroupScaleMovementOnBodiesInWorldSpace();
+
+  /// This returns getGroupScaleMovementOnJointInWorldSpace() for every group
+  /// scale and joint at once, as a (3 * joints) x getGroupScaleDim() matrix.
+  /// Rather than checking every body of every group against every other joint,
+  /// this walks once up the tree from each joint.
+  Eigen::MatrixXs getGroupScaleMovementOnJointsInWorldSpace();
+
   /// This sets the scales of all the body nodes according to their group
   /// membership. The `scale` vector is expected to be the same size as the
-  /// number of groups.
+  /// number of groups. Bodies whose scale doesn't change are left untouched,
+  /// so this is cheap when only a few groups have moved.
   void setGroupScales(Eigen::VectorXs scale, bool silentlyClamp = false);
 
   /// This gets the scales of the first body in each scale group.
   Eigen::VectorXs getGroupScales();
 
+  /// This counts changes to anything that moves the bodies of this Skeleton
+  /// around: joint positions, joint transforms, body scales and the scale
+  /// groups. Callers can compare it against a saved value to tell when
+  /// kinematic results they've cached have gone stale.
+  std::size_t getKinematicsVersion() const;
+
+  /// This counts changes to the mass, COM or moment of inertia (or their
+  /// bounds) of any BodyNode in this Skeleton, and to which BodyNodes and
+  /// scale groups there are. World uses it to tell when the mass and inertia
+  /// vectors it has cached have gone stale.
+  std::size_t getInertiaVersion() const;
+
   /// This converts a map of body scales back into group scales, interpreting
   /// everything as gradients.
   Eigen::VectorXs getGroupScaleGradientsFromMap(
@@ -1324,6 +1423,15 @@ public:
   /// name
   std::map<std::string, Eigen::Vector3s> getJointWorldPositionsMap() const;
 
+  /// This returns the world positions of the origins of `bodies` on every
+  /// frame of `poses`, as a (3 * bodies.size()) x poses.cols() matrix. This
+  /// only runs forward kinematics along the joints between the root and
+  /// `bodies`, which is much cheaper than setPositions() and
+  /// getWorldTransform() on every frame when `bodies` are a small part of the
+  /// Skeleton. The Skeleton's positions are left unchanged.
+  Eigen::MatrixXs getBodyWorldPositionsOverTrajectory(
+      const std::vector<const BodyNode*>& bodies, const Eigen::MatrixXs& poses);
+
   /// This returns the concatenated 3-vectors for world angle of each joint's
   /// child space in 3D world space, for the registered joints.
   Eigen::VectorXs getJointWorldAngles(
@@ -1377,6 +1485,36 @@ public:
       const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
           markers);
 
+  /// This computes getMarkerWorldPositions() for a whole trajectory at once,
+  /// where each column of `poses` is one timestep, and returns the marker
+  /// positions with one column per timestep.
+  ///
+  /// Like computeInverseDynamicsBatch(), the timesteps are split into
+  /// contiguous chunks, each of which runs on its own clone of this Skeleton,
+  /// on up to `numThreads` threads (<= 0 means one per hardware thread). The
+  /// state of this Skeleton is left unchanged.
+  Eigen::MatrixXs getMarkerWorldPositionsBatch(
+      const Eigen::MatrixXs& poses,
+      const std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>>&
+          markers,
+      int numThreads = -1);
+
+  /// This returns the average distance, over a whole trajectory, between
+  /// where `markers` are when the Skeleton is at each column of `poses`, and
+  /// where they were observed on that timestep. Markers that weren't
+  /// observed on a timestep are skipped. If `numObserved` isn't nullptr, it
+  /// gets the number of marker observations we averaged over.
+  ///
+  /// This runs on clones, the same way as getMarkerWorldPositionsBatch(), but
+  /// sums up the errors as it goes, rather than building the whole matrix of
+  /// marker positions.
+  s_t getMarkerAverageErrorBatch(
+      const Eigen::MatrixXs& poses,
+      const MarkerMap& markers,
+      const std::vector<std::map<std::string, Eigen::Vector3s>>& observations,
+      int numThreads = -1,
+      int* numObserved = nullptr);
+
   /// This returns the Jacobian relating changes in joint
   /// positions to changes in marker world positions.
   Eigen::MatrixXs getMarkerWorldPositionsJacobianWrtJointPositions(
@@ -1980,10 +2118,45 @@ public:
       bool _updateVels = true,
       bool _updateAccs = true);
 
+  /// These are the same as MetaSkeleton::setPositions(), except that every
+  /// BodyNode whose parent Joint moves is only notified once, after all the
+  /// DOFs have been set, instead of once per DOF. See beginPositionUpdates().
+  void setPositions(const Eigen::VectorXs& positions) override;
+
+  void setPositions(
+      const std::vector<std::size_t>& indices,
+      const Eigen::VectorXs& positions) override;
+
+  void setPositions(
+      const IndexPlan& plan, const Eigen::VectorXs& positions) override;
+
+  /// This sets the positions, like setPositions(), and then hands every
+  /// BodyNode its world transform from `worldTransforms` (in getBodyNode()
+  /// order), so that reading them doesn't run forward kinematics again. The
+  /// transforms must be the ones `positions` produces, as computed by a
+  /// KinematicTape compiled from this Skeleton.
+  void setPositionsAndWorldTransforms(
+      const Eigen::VectorXs& positions,
+      const std::vector<Eigen::Isometry3s>& worldTransforms);
+
   //----------------------------------------------------------------------------
   // Dynamics algorithms
   //----------------------------------------------------------------------------
 
+  /// Set how many threads computeForwardDynamics() and the whole-Skeleton
+  /// mass matrix, inverse mass matrix and Coriolis force updates may spread
+  /// the trees of this Skeleton across. Separate trees don't share any
+  /// BodyNodes or DOFs, so each one can be computed on its own, which pays off
+  /// for Skeletons made up of many independent trees. 1 (the default)
+  /// computes the trees one after another on the calling thread, and values
+  /// <= 0 mean use the whole global TaskScheduler. The results are the same
+  /// either way. This isn't part of the Properties, so it isn't copied by
+  /// clone().
+  void setNumTreeThreads(int numThreads);
+
+  /// Returns the number of threads set by setNumTreeThreads()
+  int getNumTreeThreads() const;
+
   /// Compute forward dynamics
   void computeForwardDynamics();
 
@@ -1993,6 +2166,23 @@ public:
       bool _withDampingForces = false,
       bool _withSpringForces = false);
 
+  /// Compute inverse dynamics over a whole trajectory at once, where each
+  /// column of `poses`, `vels` and `accs` is one timestep. If it isn't empty,
+  /// `externalWrenches` has 6 rows per BodyNode (in getBodyNode() order), each
+  /// holding the spatial wrench (torque first) applied to that body at that
+  /// timestep, expressed in world coordinates. This returns the joint forces
+  /// needed to produce `accs`, with one column per timestep.
+  ///
+  /// The timesteps are split into contiguous chunks, each of which runs on its
+  /// own clone of this Skeleton, on up to `numThreads` threads (<= 0 means one
+  /// per hardware thread). The state of this Skeleton is left unchanged.
+  Eigen::MatrixXs computeInverseDynamicsBatch(
+      const Eigen::MatrixXs& poses,
+      const Eigen::MatrixXs& vels,
+      const Eigen::MatrixXs& accs,
+      const Eigen::MatrixXs& externalWrenches = Eigen::MatrixXs::Zero(0, 0),
+      int numThreads = -1);
+
   //----------------------------------------------------------------------------
   // Impulse-based dynamics algorithms
   //----------------------------------------------------------------------------
@@ -2187,6 +2377,17 @@ public:
   // Documentation inherited
   const Eigen::MatrixXs& getInvAugMassMatrix() const override;
 
+  /// Get the mass matrix as a sparse matrix. Entry (i, j) can only be non-zero
+  /// if the DOFs i and j are on the same path to the root of a tree, so for
+  /// branching skeletons (like humans) and skeletons with several trees this
+  /// stores far fewer entries than getMassMatrix().
+  Eigen::SparseMatrix<s_t> getSparseMassMatrix() const;
+
+  /// Get the inverse mass matrix as a sparse matrix. Each tree's inverse mass
+  /// matrix is generally dense, but separate trees never couple, so this is
+  /// block diagonal by tree.
+  Eigen::SparseMatrix<s_t> getSparseInvMassMatrix() const;
+
   // Returns the value of M*x, left multiplying x by the mass matrix. This is
   // O(n) compared with O(n^2) to form the complete mass matrix and then
   // multiply.
@@ -2258,6 +2459,13 @@ public:
   /// needs to be updated
   void dirtyArticulatedInertia(std::size_t _treeIdx);
 
+  /// Notify that the inertia of _bodyNode, or the position of its parent
+  /// joint, has changed. This dirties everything that dirtyArticulatedInertia()
+  /// does for the tree of _bodyNode, but the next getMassMatrix() and
+  /// getAugMassMatrix() only recompute the columns for DOFs that belong to
+  /// ancestors or descendants of _bodyNode, since the rest can't have changed.
+  void dirtySubtreeArticulatedInertia(const BodyNode* _bodyNode);
+
   /// Notify that the support polygon of a tree needs to be updated
   DART_DEPRECATED(6.2)
   void notifySupportUpdate(std::size_t _treeIdx);
@@ -2360,6 +2568,52 @@ public:
 protected:
   struct DataCache;
 
+  /// Until the matching endPositionUpdates(), Joints whose positions change
+  /// only mark their child BodyNode as pending, instead of notifying it (and
+  /// dirtying its whole subtree) right away. Skeleton::setPositions() wraps
+  /// its loop over the DOFs in these (through a ScopedPositionUpdates), so a
+  /// multi-DOF Joint notifies once instead of once per DOF. These calls nest.
+  void beginPositionUpdates();
+
+  /// This notifies every BodyNode marked since beginPositionUpdates(), in
+  /// topological order. Notifying a BodyNode dirties its whole subtree, so
+  /// by the time we reach its descendants their flags are already set, and
+  /// notifying them stops right away. That dirties every affected BodyNode
+  /// exactly once.
+  void endPositionUpdates();
+
+  /// This calls beginPositionUpdates() when it's created and
+  /// endPositionUpdates() when it's destroyed, so the pending updates still
+  /// get flushed if setting a position throws.
+  class ScopedPositionUpdates
+  {
+  public:
+    explicit ScopedPositionUpdates(Skeleton* skel);
+    ~ScopedPositionUpdates();
+
+    ScopedPositionUpdates(const ScopedPositionUpdates&) = delete;
+    ScopedPositionUpdates& operator=(const ScopedPositionUpdates&) = delete;
+
+  private:
+    Skeleton* mSkel;
+  };
+
+  /// This fills `columns` with the index of the first column of each body's
+  /// scale group in the group scales vector (or -1 if it isn't in one), and
+  /// `uniform` with whether that group scales uniformly, so only has one column
+  void getBodyGroupScaleColumns(
+      std::vector<int>& columns, std::vector<bool>& uniform);
+
+  /// This fills `childScaleMotion` with how far each body moves in world space
+  /// per unit change of each of its own scale axes (one per column), through
+  /// its parent joint's offset from the body. `parentScaleMotion` gets how far
+  /// each body moves per unit change of each of its parent body's scale axes,
+  /// through its parent joint's offset from the parent body. The root bodies'
+  /// entries in `parentScaleMotion` are left at zero.
+  void getBodyScaleMotions(
+      std::vector<Eigen::Matrix3s>& childScaleMotion,
+      std::vector<Eigen::Matrix3s>& parentScaleMotion);
+
   /// Constructor called by create()
   Skeleton(const AspectPropertiesData& _properties);
 
@@ -2461,12 +2715,28 @@ protected:
   /// Update the articulated inertias of the skeleton
   void updateArticulatedInertia() const;
 
+  /// This fills _columns with whether each DOF in the tree needs its column
+  /// of the mass matrix recomputed, given the BodyNodes flagged in
+  /// _dirtyBodies. Those are the DOFs of BodyNodes that are an ancestor or
+  /// descendant of (or are) a dirty BodyNode. This returns false if every
+  /// column needs recomputing anyways.
+  bool findDirtyMassMatrixColumns(
+      const DataCache& _cache,
+      bool _allColumns,
+      const std::vector<bool>& _dirtyBodies,
+      std::vector<bool>& _columns) const;
+
   /// Update the mass matrix of a tree
   void updateMassMatrix(std::size_t _treeIdx) const;
 
   /// Update mass matrix of the skeleton.
   void updateMassMatrix() const;
 
+  /// Call `update` with the index of every tree, spread across
+  /// mNumTreeThreads threads if there's more than one tree
+  template <typename Update>
+  void updateTrees(Update update) const;
+
   void updateAugMassMatrix(std::size_t _treeIdx) const;
 
   /// Update augmented mass matrix of the skeleton.
@@ -2569,6 +2839,17 @@ protected:
     /// Dirty flag for the mass matrix.
     bool mAugMassMatrix;
 
+    /// When mMassMatrix is set and this is not, only the columns for DOFs
+    /// related to a BodyNode flagged in mMassMatrixBodies (indexed by
+    /// BodyNode::getIndexInTree()) need to be recomputed. See
+    /// dirtySubtreeArticulatedInertia().
+    bool mAllMassMatrixColumns;
+    std::vector<bool> mMassMatrixBodies;
+
+    /// The same as the above, but for mAugMassMatrix
+    bool mAllAugMassMatrixColumns;
+    std::vector<bool> mAugMassMatrixBodies;
+
     /// Dirty flag for the inverse of mass matrix.
     bool mInvMassMatrix;
 
@@ -2692,6 +2973,43 @@ protected:
   /// Flag for status of impulse testing.
   bool mIsImpulseApplied;
 
+  /// See setAsleep()
+  bool mIsAsleep;
+
+  /// See getKinematicsVersion()
+  std::size_t mKinematicsVersion;
+
+  /// See getInertiaVersion()
+  std::size_t mInertiaVersion;
+
+  /// How many beginPositionUpdates() haven't been matched by an
+  /// endPositionUpdates() yet
+  int mPositionUpdatesDepth;
+
+  /// For each BodyNode, whether its parent Joint has moved since
+  /// beginPositionUpdates() without notifying it
+  std::vector<bool> mPendingPositionUpdates;
+
+  /// The position limits of every DOF, for getJointsAtPositionLimits(). DOFs
+  /// whose limits aren't enforced get limits of -inf and +inf.
+  Eigen::VectorXs mPackedPositionLowerLimits;
+  Eigen::VectorXs mPackedPositionUpperLimits;
+
+  /// The getVersion() that the packed position limits were built at
+  std::size_t mPackedPositionLimitsVersion;
+
+  /// One bit for every pair of BodyNodes, for isSelfCollisionIgnored(). Each
+  /// row is mIgnoredBodyPairsRowWords words long.
+  mutable std::vector<std::uint64_t> mIgnoredBodyPairs;
+
+  mutable std::size_t mIgnoredBodyPairsRowWords;
+
+  /// True if mIgnoredBodyPairs needs to be rebuilt
+  mutable bool mIgnoredBodyPairsDirty;
+
+  /// See setNumTreeThreads()
+  int mNumTreeThreads;
+
   mutable std::mutex mMutex;
 
 public:
@@ -0,0 +1,123 @@
+#include "dart/dynamics/SkeletonClonePool.hpp"
+
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+namespace dart {
+namespace dynamics {
+
+//==============================================================================
+SkeletonClonePool::SkeletonClonePool(SkeletonPtr source, int maxPooled)
+  : mSource(source), mMaxPooled(maxPooled), mNumAllocated(0)
+{
+}
+
+//==============================================================================
+SkeletonPtr SkeletonClonePool::acquire()
+{
+  SkeletonPtr clone;
+  {
+    // We hold the lock while we read from the source, so that workers
+    // acquiring clones in parallel don't race each other on the source's
+    // caches
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFree.empty())
+    {
+      clone = std::move(mFree.back());
+      mFree.pop_back();
+    }
+    else
+    {
+      clone = mSource->cloneSkeleton();
+      mNumAllocated++;
+    }
+    syncFromSource(clone.get());
+  }
+
+  // Skeletons keep a weak_ptr to themselves, so we can't hand out a
+  // shared_ptr with a fresh control block. Instead, the handle we return keeps
+  // the real shared_ptr alive in its deleter, and gives it back to us when the
+  // handle is released.
+  std::weak_ptr<SkeletonClonePool> weakPool = shared_from_this();
+  return SkeletonPtr(clone.get(), [weakPool, clone](Skeleton* /* ptr */) {
+    std::shared_ptr<SkeletonClonePool> pool = weakPool.lock();
+    if (pool)
+    {
+      pool->release(clone);
+    }
+  });
+}
+
+//==============================================================================
+void SkeletonClonePool::reserve(std::size_t count)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  while (mFree.size() < count)
+  {
+    mFree.push_back(mSource->cloneSkeleton());
+    mNumAllocated++;
+  }
+}
+
+//==============================================================================
+void SkeletonClonePool::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFree.clear();
+}
+
+//==============================================================================
+std::size_t SkeletonClonePool::getNumPooled()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFree.size();
+}
+
+//==============================================================================
+std::size_t SkeletonClonePool::getNumAllocated()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumAllocated;
+}
+
+//==============================================================================
+SkeletonPtr SkeletonClonePool::getSource()
+{
+  return mSource;
+}
+
+//==============================================================================
+void SkeletonClonePool::syncFromSource(Skeleton* clone)
+{
+  // Scaling a body also rescales its joint offsets and every attached shape,
+  // so we only touch the bodies whose scale actually changed
+  for (std::size_t i = 0; i < mSource->getNumBodyNodes(); i++)
+  {
+    Eigen::Vector3s scale = mSource->getBodyNode(i)->getScale();
+    if (clone->getBodyNode(i)->getScale() != scale)
+    {
+      clone->getBodyNode(i)->setScale(scale);
+    }
+  }
+  clone->setLinkMasses(mSource->getLinkMasses());
+  clone->setLinkCOMs(mSource->getLinkCOMs());
+  clone->setLinkMOIs(mSource->getLinkMOIs());
+
+  clone->setPositions(mSource->getPositions());
+  clone->setVelocities(mSource->getVelocities());
+}
+
+//==============================================================================
+void SkeletonClonePool::release(SkeletonPtr clone)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mMaxPooled >= 0 && mFree.size() >= static_cast<std::size_t>(mMaxPooled))
+  {
+    // The pool is full, the last reference to `clone` frees it on the way out
+    return;
+  }
+  mFree.push_back(clone);
+}
+
+} // namespace dynamics
+} // namespace dart
@@ -0,0 +1,76 @@
+#ifndef DART_DYNAMICS_SKELETON_CLONE_POOL_HPP_
+#define DART_DYNAMICS_SKELETON_CLONE_POOL_HPP_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dart/dynamics/SmartPointer.hpp"
+
+namespace dart {
+namespace dynamics {
+
+/// This hands out clones of a source Skeleton for use on worker threads, and
+/// recycles them once every shared_ptr to them has been released, instead of
+/// freeing them. Each clone has its own positions, velocities and kinematic
+/// caches, so workers can re-pose their clone without stepping on each other's
+/// toes, but we only pay for Skeleton::cloneSkeleton() the first time a clone
+/// is needed. After that, handing out a clone only costs copying the source's
+/// state into it, which is linear in the number of DOFs and bodies.
+///
+/// This is meant for code like MarkerFitter and DynamicsFitter, which fan out
+/// the same skeleton over many std::async workers, many times over.
+class SkeletonClonePool : public std::enable_shared_from_this<SkeletonClonePool>
+{
+public:
+  /// If more than `maxPooled` clones are released back to us at once, the
+  /// excess ones are freed. A `maxPooled` of -1 means the pool is unbounded.
+  SkeletonClonePool(SkeletonPtr source, int maxPooled = -1);
+
+  /// This returns a clone of the source skeleton, taken from the pool if
+  /// possible. Before it's returned, the clone's positions, velocities, body
+  /// scales, masses, COMs and moments of inertia are all set to match the
+  /// source. The source must not be modified concurrently with this call.
+  ///
+  /// The topology of the source must not change over the lifetime of the
+  /// pool. Any Joint* or BodyNode* you used on the source needs to be looked
+  /// up again by name on the clone.
+  SkeletonPtr acquire();
+
+  /// This clones the source until there are at least `count` clones sitting
+  /// in the pool ready to be handed out.
+  void reserve(std::size_t count);
+
+  /// This frees all the clones currently sitting in the pool. Clones that are
+  /// still checked out are unaffected, and will still be returned to the pool
+  /// when they're released.
+  void clear();
+
+  /// Returns the number of clones currently sitting in the pool, ready to be
+  /// handed out.
+  std::size_t getNumPooled();
+
+  /// Returns the number of clones this pool has made over its lifetime.
+  std::size_t getNumAllocated();
+
+  /// Returns the skeleton we're cloning
+  SkeletonPtr getSource();
+
+protected:
+  /// This copies the state of the source skeleton over to `clone`
+  void syncFromSource(Skeleton* clone);
+
+  /// This puts the clone back in the pool, or frees it if the pool is full
+  void release(SkeletonPtr clone);
+
+  std::mutex mMutex;
+  SkeletonPtr mSource;
+  std::vector<SkeletonPtr> mFree;
+  int mMaxPooled;
+  std::size_t mNumAllocated;
+};
+
+} // namespace dynamics
+} // namespace dart
+
+#endif
@@ -32,11 +32,13 @@
 
 #include "dart/dynamics/SoftBodyNode.hpp"
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "dart/common/Console.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/PointMass.hpp"
 #include "dart/dynamics/Shape.hpp"
@@ -247,6 +249,66 @@ const std::vector<PointMass*>& SoftBodyNode::getPointMasses() const
   return mPointMasses;
 }
 
+//==============================================================================
+void SoftBodyNode::setNumPointMassThreads(int numThreads)
+{
+  mNumPointMassThreads = numThreads;
+}
+
+//==============================================================================
+int SoftBodyNode::getNumPointMassThreads() const
+{
+  return mNumPointMassThreads;
+}
+
+//==============================================================================
+template <typename Update>
+void SoftBodyNode::updatePointMasses(Update update) const
+{
+  const std::size_t numPointMasses = mPointMasses.size();
+  if (numPointMasses == 0u)
+    return;
+
+  int numThreads = mNumPointMassThreads;
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  // Each point mass is only a few dozen flops, so it's not worth a task
+  // unless it gets a decent sized batch of them
+  const std::size_t minPointMassesPerThread = 128u;
+  numThreads = static_cast<int>(std::min<std::size_t>(
+      std::max(numThreads, 1), numPointMasses / minPointMassesPerThread));
+
+  if (numThreads <= 1)
+  {
+    for (PointMass* pointMass : mPointMasses)
+      update(pointMass);
+    return;
+  }
+
+  // The point masses read this body's transform and velocity, and their own
+  // velocities and accelerations, all of which are computed lazily for the
+  // whole body at once. Updating the first point mass here triggers any of
+  // that which is due, so the rest can go in parallel, only reading from
+  // those caches and writing to their own point mass.
+  update(mPointMasses[0]);
+
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(numThreads);
+  for (int thread = 0; thread < numThreads; ++thread)
+  {
+    const std::size_t begin
+        = 1 + (numPointMasses - 1) * thread / numThreads;
+    const std::size_t end
+        = 1 + (numPointMasses - 1) * (thread + 1) / numThreads;
+    futures.push_back(common::async([this, &update, begin, end] {
+      for (std::size_t i = begin; i < end; ++i)
+        update(mPointMasses[i]);
+    }));
+  }
+  for (auto& future : futures)
+    future.get();
+}
+
 //==============================================================================
 SoftBodyNode::SoftBodyNode(
     BodyNode* _parentBodyNode,
@@ -255,7 +317,8 @@ SoftBodyNode::SoftBodyNode(
   : Entity(Frame::World(), false),
     Frame(Frame::World()),
     Base(std::make_tuple(_parentBodyNode, _parentJoint, _properties)),
-    mSoftShapeNode(nullptr)
+    mSoftShapeNode(nullptr),
+    mNumPointMassThreads(1)
 {
   createSoftBodyAspect();
   mNotifier = new PointMassNotifier(this, getName() + "_PointMassNotifier");
@@ -589,8 +652,9 @@ void SoftBodyNode::updateTransmittedForceID(
 {
   const Eigen::Matrix6s& mI
       = BodyNode::mAspectProperties.mInertia.getSpatialTensor();
-  for (auto& pointMass : mPointMasses)
+  updatePointMasses([&](PointMass* pointMass) {
     pointMass->updateTransmittedForceID(_gravity, _withExternalForces);
+  });
 
   // Gravity force
   if (BodyNode::mAspectProperties.mGravityMode == true)
@@ -639,9 +703,10 @@ void SoftBodyNode::updateTransmittedForceID(
 void SoftBodyNode::updateJointForceID(
     s_t _timeStep, bool _withDampingForces, bool _withSpringForces)
 {
-  for (std::size_t i = 0; i < mPointMasses.size(); ++i)
-    mPointMasses.at(i)->updateJointForceID(
+  updatePointMasses([&](PointMass* pointMass) {
+    pointMass->updateJointForceID(
         _timeStep, _withDampingForces, _withSpringForces);
+  });
 
   BodyNode::updateJointForceID(
       _timeStep, _withDampingForces, _withSpringForces);
@@ -712,8 +777,9 @@ void SoftBodyNode::updateBiasForce(
 {
   const Eigen::Matrix6s& mI
       = BodyNode::mAspectProperties.mInertia.getSpatialTensor();
-  for (auto& pointMass : mPointMasses)
+  updatePointMasses([&](PointMass* pointMass) {
     pointMass->updateBiasForceFD(_timeStep, _gravity);
+  });
 
   // Gravity force
   if (BodyNode::mAspectProperties.mGravityMode == true)
@@ -786,15 +852,15 @@ void SoftBodyNode::updateTransmittedForceFD()
 {
   BodyNode::updateTransmittedForceFD();
 
-  for (auto& pointMass : mPointMasses)
-    pointMass->updateTransmittedForce();
+  updatePointMasses(
+      [](PointMass* pointMass) { pointMass->updateTransmittedForce(); });
 }
 
 //==============================================================================
 void SoftBodyNode::updateBiasImpulse()
 {
-  for (auto& pointMass : mPointMasses)
-    pointMass->updateBiasImpulseFD();
+  updatePointMasses(
+      [](PointMass* pointMass) { pointMass->updateBiasImpulseFD(); });
 
   // Update impulsive bias force
   mBiasImpulse = -mConstraintImpulse;
@@ -829,8 +895,8 @@ void SoftBodyNode::updateVelocityChangeFD()
 {
   BodyNode::updateVelocityChangeFD();
 
-  for (auto& pointMass : mPointMasses)
-    pointMass->updateVelocityChangeFD();
+  updatePointMasses(
+      [](PointMass* pointMass) { pointMass->updateVelocityChangeFD(); });
 }
 
 //==============================================================================
@@ -838,8 +904,8 @@ void SoftBodyNode::updateTransmittedImpulse()
 {
   BodyNode::updateTransmittedImpulse();
 
-  for (auto& pointMass : mPointMasses)
-    pointMass->updateTransmittedImpulse();
+  updatePointMasses(
+      [](PointMass* pointMass) { pointMass->updateTransmittedImpulse(); });
 }
 
 //==============================================================================
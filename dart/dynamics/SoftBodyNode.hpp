@@ -136,6 +136,19 @@ public:
   /// Return all the point masses in this SoftBodyNode
   const std::vector<PointMass*>& getPointMasses() const;
 
+  /// Set how many threads the per-point-mass stages of the articulated body
+  /// recursion may spread across. 1 (the default) updates every point mass
+  /// on the calling thread, and values <= 0 mean use the whole global
+  /// TaskScheduler. Only bodies with a few hundred point masses or more are
+  /// worth splitting up, so smaller ones always stay on one thread. Results
+  /// are the same either way, since every point mass only writes to itself,
+  /// and their contributions are still summed up in order. This isn't part
+  /// of the Properties, so it isn't copied by clone().
+  void setNumPointMassThreads(int numThreads);
+
+  /// Returns the number of threads set by setNumPointMassThreads()
+  int getNumPointMassThreads() const;
+
   /// \brief
   void connectPointMasses(std::size_t _idx1, std::size_t _idx2);
 
@@ -314,7 +327,15 @@ protected:
   ///
   math::Inertia mArtInertiaImplicit2;
 
+  /// See setNumPointMassThreads()
+  int mNumPointMassThreads;
+
 private:
+  /// Call `update` on every point mass, spread across mNumPointMassThreads
+  /// threads if there are enough of them
+  template <typename Update>
+  void updatePointMasses(Update update) const;
+
   /// \brief
   void _addPiToArtInertia(const Eigen::Vector3s& _p, s_t _Pi) const;
 
@@ -729,9 +729,10 @@ Eigen::Vector6s ZeroDofJoint::getBodyConstraintWrench() const
 }
 
 //==============================================================================
-const math::Jacobian ZeroDofJoint::getRelativeJacobian() const
+const math::Jacobian& ZeroDofJoint::getRelativeJacobian() const
 {
-  return Eigen::Matrix<s_t, 6, 0>();
+  static const math::Jacobian emptyJacobian(6, 0);
+  return emptyJacobian;
 }
 
 //==============================================================================
@@ -749,9 +750,9 @@ math::Jacobian ZeroDofJoint::getRelativeJacobianDerivWrtPosition(
 }
 
 //==============================================================================
-const math::Jacobian ZeroDofJoint::getRelativeJacobianTimeDeriv() const
+const math::Jacobian& ZeroDofJoint::getRelativeJacobianTimeDeriv() const
 {
-  return Eigen::Matrix<s_t, 6, 0>();
+  return getRelativeJacobian();
 }
 
 //==============================================================================
@@ -773,7 +774,7 @@ Eigen::Vector6s ZeroDofJoint::getWorldAxisScrewForVelocity(int /* dof */) const
 }
 
 //==============================================================================
-const math::Jacobian ZeroDofJoint::getRelativeJacobianInPositionSpace() const
+const math::Jacobian& ZeroDofJoint::getRelativeJacobianInPositionSpace() const
 {
   return getRelativeJacobian();
 }
@@ -426,7 +426,7 @@ protected:
   //----------------------------------------------------------------------------
 
   // Documentation inherited
-  const math::Jacobian getRelativeJacobian() const override;
+  const math::Jacobian& getRelativeJacobian() const override;
 
   // Documentation inherited
   math::Jacobian getRelativeJacobian(
@@ -437,7 +437,7 @@ protected:
       std::size_t index) const override;
 
   // Documentation inherited
-  const math::Jacobian getRelativeJacobianTimeDeriv() const override;
+  const math::Jacobian& getRelativeJacobianTimeDeriv() const override;
 
   // Documentation inherited
   Eigen::Vector6s getWorldAxisScrewForPosition(int dof) const override;
@@ -446,7 +446,7 @@ protected:
   Eigen::Vector6s getWorldAxisScrewForVelocity(int dof) const override;
 
   // Documentation inherited
-  const math::Jacobian getRelativeJacobianInPositionSpace() const override;
+  const math::Jacobian& getRelativeJacobianInPositionSpace() const override;
 
   // Documentation inherited
   math::Jacobian getRelativeJacobianInPositionSpace(
@@ -1611,9 +1611,12 @@ s_t GenericJoint<ConfigSpaceT>::computePotentialEnergy() const
 
 //==============================================================================
 template <class ConfigSpaceT>
-const math::Jacobian GenericJoint<ConfigSpaceT>::getRelativeJacobian() const
+const math::Jacobian& GenericJoint<ConfigSpaceT>::getRelativeJacobian() const
 {
-  return getRelativeJacobianStatic();
+  // The dynamic copy is only refreshed when the cache is recomputed, so
+  // concurrent reads of a clean joint don't write to shared state
+  getRelativeJacobianStatic();
+  return mJacobianDynamic;
 }
 
 //==============================================================================
@@ -1625,6 +1628,7 @@ GenericJoint<ConfigSpaceT>::getRelativeJacobianStatic() const
   {
     this->updateRelativeJacobian(false);
     this->mIsRelativeJacobianDirty = false;
+    mJacobianDynamic = mJacobian;
   }
 
   assert(mJacobian.norm() != 0.0);
@@ -1659,10 +1663,11 @@ math::Jacobian GenericJoint<ConfigSpaceT>::getRelativeJacobian(
 
 //==============================================================================
 template <class ConfigSpaceT>
-const math::Jacobian GenericJoint<ConfigSpaceT>::getRelativeJacobianTimeDeriv()
-    const
+const math::Jacobian&
+GenericJoint<ConfigSpaceT>::getRelativeJacobianTimeDeriv() const
 {
-  return getRelativeJacobianTimeDerivStatic();
+  getRelativeJacobianTimeDerivStatic();
+  return mJacobianDerivDynamic;
 }
 
 //==============================================================================
@@ -1674,6 +1679,7 @@ GenericJoint<ConfigSpaceT>::getRelativeJacobianTimeDerivStatic() const
   {
     this->updateRelativeJacobianTimeDeriv();
     this->mIsRelativeJacobianTimeDerivDirty = false;
+    mJacobianDerivDynamic = mJacobianDeriv;
   }
 
   return mJacobianDeriv;
@@ -1688,6 +1694,7 @@ GenericJoint<ConfigSpaceT>::getRelativeJacobianInPositionSpaceStatic() const
   {
     this->updateRelativeJacobianInPositionSpace(false);
     this->mIsRelativeJacobianInPositionSpaceDirty = false;
+    mJacobianInPositionSpaceDynamic = mJacobianInPositionSpace;
   }
 
   return mJacobianInPositionSpace;
@@ -1695,10 +1702,11 @@ GenericJoint<ConfigSpaceT>::getRelativeJacobianInPositionSpaceStatic() const
 
 //==============================================================================
 template <class ConfigSpaceT>
-const math::Jacobian
+const math::Jacobian&
 GenericJoint<ConfigSpaceT>::getRelativeJacobianInPositionSpace() const
 {
-  return getRelativeJacobianInPositionSpaceStatic();
+  getRelativeJacobianInPositionSpaceStatic();
+  return mJacobianInPositionSpaceDynamic;
 }
 
 //==============================================================================
@@ -1738,6 +1746,9 @@ GenericJoint<ConfigSpaceT>::GenericJoint(const Properties& properties)
     mConstraintImpulses(Vector::Zero()),
     mJacobian(JacobianMatrix::Zero()),
     mJacobianDeriv(JacobianMatrix::Zero()),
+    mJacobianDynamic(math::Jacobian::Zero(6, NumDofs)),
+    mJacobianInPositionSpaceDynamic(math::Jacobian::Zero(6, NumDofs)),
+    mJacobianDerivDynamic(math::Jacobian::Zero(6, NumDofs)),
     mInvProjArtInertia(Matrix::Zero()),
     mInvProjArtInertiaImplicit(Matrix::Zero()),
     mTotalForce(Vector::Zero()),
@@ -33,6 +33,8 @@
 #ifndef DART_DYNAMICS_DETAIL_SHAPEFRAMEASPECT_HPP_
 #define DART_DYNAMICS_DETAIL_SHAPEFRAMEASPECT_HPP_
 
+#include <cstdint>
+
 #include <Eigen/Core>
 
 #include "dart/common/EmbeddedAspect.hpp"
@@ -83,8 +85,19 @@ struct CollisionAspectProperties
   /// This object is collidable if true
   bool mCollidable;
 
+  /// The collision layers this object is on, one layer per bit
+  std::uint32_t mCollisionLayers;
+
+  /// The collision layers this object collides with, one layer per bit. Two
+  /// objects are only checked against each other if each one is on at least
+  /// one of the layers that the other collides with.
+  std::uint32_t mCollisionMask;
+
   /// Constructor
-  CollisionAspectProperties(const bool collidable = true);
+  CollisionAspectProperties(
+      const bool collidable = true,
+      const std::uint32_t collisionLayers = 1u,
+      const std::uint32_t collisionMask = 0xFFFFFFFFu);
 
   /// Destructor
   virtual ~CollisionAspectProperties() = default;
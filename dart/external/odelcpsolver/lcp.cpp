@@ -774,11 +774,36 @@ void dLCP::unpermute()
 #endif // dLCP_FAST
 
 
+//***************************************************************************
+// working arrays for dSolveLCP(), kept around between calls
+
+dLCPWorkspace::dLCPWorkspace() : capacity(0)
+{
+}
+
+void dLCPWorkspace::reserve (int n)
+{
+  if (n <= capacity) return;
+  capacity = n;
+  L.resize (n*dPAD(n));
+  d.resize (n);
+  w.resize (n);
+  delta_w.resize (n);
+  delta_x.resize (n);
+  Dell.resize (n);
+  ell.resize (n);
+  Arows.resize (n);
+  p.resize (n);
+  C.resize (n);
+  state.reset (new bool[n]);
+}
+
 //***************************************************************************
 // an optimized Dantzig LCP driver routine for the lo-hi LCP problem.
 
 bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
-                dReal *outer_w/*=nullptr*/, int nub, dReal *lo, dReal *hi, int *findex, bool earlyTermination)
+                dReal *outer_w/*=nullptr*/, int nub, dReal *lo, dReal *hi, int *findex, bool earlyTermination,
+                dLCPWorkspace *workspace/*=nullptr*/)
 {
   dAASSERT (n>0 && A && x && b && lo && hi && nub >= 0 && nub <= n);
 # ifndef dNODEBUG
@@ -788,11 +813,14 @@ bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
   }
 # endif
 
+  dLCPWorkspace local_workspace;
+  if (!workspace) workspace = &local_workspace;
+  workspace->reserve (n);
 
   // if all the variables are unbounded then we can just factor, solve,
   // and return
   if (nub >= n) {
-    dReal *d = new dReal[n];
+    dReal *d = workspace->d.data();
     dSetZero (d, n);
 
     int nskip = dPAD(n);
@@ -800,28 +828,27 @@ bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
     dSolveLDLT (A, d, b, n, nskip);
     memcpy (x, b, n*sizeof(dReal));
 
-    delete[] d;
     return true;
   }
 
   const int nskip = dPAD(n);
-  dReal *L = new dReal[ (n*nskip)];
-  dReal *d = new dReal[ (n)];
-  dReal *w = outer_w ? outer_w : (new dReal[n]);
-  dReal *delta_w = new dReal[ (n)];
-  dReal *delta_x = new dReal[ (n)];
-  dReal *Dell = new dReal[ (n)];
-  dReal *ell = new dReal[ (n)];
+  dReal *L = workspace->L.data();
+  dReal *d = workspace->d.data();
+  dReal *w = outer_w ? outer_w : workspace->w.data();
+  dReal *delta_w = workspace->delta_w.data();
+  dReal *delta_x = workspace->delta_x.data();
+  dReal *Dell = workspace->Dell.data();
+  dReal *ell = workspace->ell.data();
 #ifdef ROWPTRS
-  dReal **Arows = new dReal* [n];
+  dReal **Arows = workspace->Arows.data();
 #else
   dReal **Arows = nullptr;
 #endif
-  int *p = new int[n];
-  int *C = new int[n];
+  int *p = workspace->p.data();
+  int *C = workspace->C.data();
 
   // for i in N, state[i] is 0 if x(i)==lo(i) or 1 if x(i)==hi(i)
-  bool *state = new bool[n];
+  bool *state = workspace->state.get();
 
   // create LCP object. note that tmp is set to delta_w to save space, this
   // optimization relies on knowledge of how tmp is used, so be careful!
@@ -1007,22 +1034,6 @@ bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
         if (s <= REAL(0.0)) {
 
           if (earlyTermination) {
-            if (!outer_w)
-              delete[] w;
-            delete[] L;
-            delete[] d;
-            delete[] delta_w;
-            delete[] delta_x;
-            delete[] Dell;
-            delete[] ell;
-          #ifdef ROWPTRS
-            delete[] Arows;
-          #endif
-            delete[] p;
-            delete[] C;
-
-            delete[] state;
-
             return false;
           }
 
@@ -1094,22 +1105,6 @@ bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b,
 
   lcp.unpermute();
 
-  if (!outer_w)
-	  delete[] w;
-  delete[] L;
-  delete[] d;
-  delete[] delta_w;
-  delete[] delta_x;
-  delete[] Dell;
-  delete[] ell;
-#ifdef ROWPTRS
-  delete[] Arows;
-#endif
-  delete[] p;
-  delete[] C;
-
-  delete[] state;
-
   return true;
 }
 
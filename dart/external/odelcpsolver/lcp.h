@@ -53,12 +53,33 @@ to be implemented. the first `nub' variables are assumed to have findex < 0.
 #include <stdlib.h>
 #include <stdio.h>
 #include <cassert>
+#include <memory>
+#include <vector>
 
 #include "dart/external/odelcpsolver/odeconfig.h"
 #include "dart/external/odelcpsolver/common.h"
 
+// the working arrays for dSolveLCP(). passing the same workspace to every
+// call saves reallocating them each time. a workspace only ever grows, so
+// after the largest problem it has seen it never allocates again. a
+// workspace must not be used by two calls at once.
+struct dLCPWorkspace {
+  dLCPWorkspace();
+
+  // make sure the arrays are big enough for an n*n problem
+  void reserve (int n);
+
+  int capacity;
+  std::vector<dReal> L, d, w, delta_w, delta_x, Dell, ell;
+  std::vector<dReal*> Arows;
+  std::vector<int> p, C;
+  std::unique_ptr<bool[]> state;
+};
+
+// if `workspace' is null, the working arrays are allocated just for this call
 bool dSolveLCP (int n, dReal *A, dReal *x, dReal *b, dReal *w,
-  int nub, dReal *lo, dReal *hi, int *findex, bool earlyTermination = false);
+  int nub, dReal *lo, dReal *hi, int *findex, bool earlyTermination = false,
+  dLCPWorkspace *workspace = nullptr);
 
 size_t dEstimateSolveLCPMemoryReq(int n, bool outer_w_avail);
 
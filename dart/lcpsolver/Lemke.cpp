@@ -32,8 +32,10 @@
 
 #include "dart/lcpsolver/Lemke.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <vector>
 
 #include "dart/math/Helpers.hpp"
@@ -57,120 +59,137 @@ namespace lcpsolver {
 //  return temp;
 // }
 
+// These are the tolerances Lemke() has always used
+#define LEMKE_ZERO_TOLERANCE 1e-5
+#define LEMKE_PIVOT_TOLERANCE 1e-8
+#define LEMKE_MAX_ITERATIONS 1000
+
+// Once this many column replacements pile up on top of a factorization,
+// applying them costs about as much as just refactoring
+#define LEMKE_MIN_ETAS_BEFORE_REFACTOR 8
+
 //==============================================================================
-int Lemke(
-    const Eigen::MatrixXs& _M, const Eigen::VectorXs& _q, Eigen::VectorXs* _z)
+LemkeSolver::LemkeSolver()
+  : mWarmStartEnabled(true), mNumWarmStarts(0), mLastNumPivots(0)
 {
-  int n = _q.size();
+  // Do nothing
+}
 
-  const s_t zer_tol = 1e-5;
-  const s_t piv_tol = 1e-8;
-  int maxiter = 1000;
-  int err = 0;
+//==============================================================================
+int LemkeSolver::solve(
+    const Eigen::MatrixXs& M, const Eigen::VectorXs& q, Eigen::VectorXs* z)
+{
+  const int n = q.size();
+  mLastNumPivots = 0;
 
-  if (_q.minCoeff() >= 0)
+  if (q.minCoeff() >= 0)
   {
     // LOG(INFO) << "Trivial solution exists.";
-    *_z = Eigen::VectorXs::Zero(n);
-    return err;
+    *z = Eigen::VectorXs::Zero(n);
+    return 0;
   }
 
-  // solve trivial case for n=1
-  //   if (n==1){
-  //     if (_M(0)>0){
-  //         *_z = (- _q(0)/_M(0) )*Eigen::VectorXs::Ones(n);
-  //         return err;
-  //     } else {
-  //         *_z = Eigen::VectorXs::Zero(n);
-  //         err = 4; // no solution
-  //         return err;
-  //     }
-  //   }
-
-  *_z = Eigen::VectorXs::Zero(2 * n);
-  int iter = 0;
-  // s_t theta = 0;
-  s_t ratio = 0;
-  int leaving = 0;
-  Eigen::VectorXs Be = Eigen::VectorXs::Constant(n, 1);
-  Eigen::VectorXs x = _q;
-  std::vector<int> bas;
-  std::vector<int> nonbas;
-
-  int t = 2 * n;
-  int entering = t;
+  if (static_cast<int>(mLastBasicZ.size()) != n)
+    mLastBasicZ.assign(n, false);
 
-  bas.clear();
-  nonbas.clear();
+  const bool warmStart
+      = mWarmStartEnabled
+        && std::find(mLastBasicZ.begin(), mLastBasicZ.end(), true)
+               != mLastBasicZ.end();
+  if (warmStart)
+  {
+    mStartBasicZ = mLastBasicZ;
+    const int err = solveFromBasis(M, q, z);
+    if (err == 0)
+      return err;
+  }
 
   // TODO: here suppose initial guess z0 is [0,0,0,...], this contradicts to
   // ODE's w always initilized as 0
-  for (int i = 0; i < n; ++i)
-  {
-    nonbas.push_back(i);
-  }
+  mStartBasicZ.assign(n, false);
+  return solveFromBasis(M, q, z);
+}
 
-  Eigen::MatrixXs B = -Eigen::MatrixXs::Identity(n, n);
+//==============================================================================
+int LemkeSolver::solveFromBasis(
+    const Eigen::MatrixXs& M, const Eigen::VectorXs& q, Eigen::VectorXs* z)
+{
+  const int n = q.size();
+  const s_t zer_tol = LEMKE_ZERO_TOLERANCE;
+  const s_t piv_tol = LEMKE_PIVOT_TOLERANCE;
+  const int maxiter = LEMKE_MAX_ITERATIONS;
+  int err = 0;
 
-  if (!bas.empty())
+  // Resizing to the size we already are doesn't allocate, so after the first
+  // solve of a given size, none of this touches the heap
+  mBasis.resize(n, n);
+  mEtaColumns.resize(n, std::max(n, LEMKE_MIN_ETAS_BEFORE_REFACTOR));
+  mBasic.resize(n);
+  mX.resize(n);
+  mD.resize(n);
+  mBe.resize(n);
+  mU.resize(n);
+
+  bool startsCold = true;
+  for (int i = 0; i < n; ++i)
   {
-    Eigen::MatrixXs B_copy = B;
-    for (std::size_t i = 0; i < bas.size(); ++i)
+    if (mStartBasicZ[i])
     {
-      B.col(i) = _M.col(bas[i]);
+      mBasis.col(i) = M.col(i);
+      mBasic[i] = i;
+      startsCold = false;
     }
-    for (std::size_t i = 0; i < nonbas.size(); ++i)
+    else
     {
-      B.col(bas.size() + i) = B_copy.col(nonbas[i]);
+      mBasis.col(i).setZero();
+      mBasis(i, i) = -1;
+      mBasic[i] = n + i;
     }
-    // TODO: check the condition number to return err = 3
-    Eigen::JacobiSVD<Eigen::MatrixXs> svd(B);
-    s_t cond = svd.singularValues()(0)
-               / svd.singularValues()(svd.singularValues().size() - 1);
-    if (cond > 1e16)
-    {
-      (*_z) = Eigen::VectorXs::Zero(n);
-      err = 3;
-      return err;
-    }
-    x = -B.householderQr().solve(_q);
   }
 
-  // Check if initial basis provides solution
-  if (x.minCoeff() >= 0)
+  if (!factorBasis())
+  {
+    // The warm start basis is singular, so it's no use to us
+    *z = Eigen::VectorXs::Zero(n);
+    return 3;
+  }
+  solveBasis(-q, mX);
+
+  // Check if initial basis provides solution. The all-w basis never does,
+  // since we've already checked for q >= 0.
+  if (!startsCold && mX.minCoeff() >= -piv_tol)
   {
-    Eigen::VectorXs __z = Eigen::VectorXs::Zero(2 * n);
-    for (std::size_t i = 0; i < bas.size(); ++i)
+    *z = Eigen::VectorXs::Zero(n);
+    for (int i = 0; i < n; ++i)
     {
-      (__z).row(bas[i]) = x.row(i);
+      if (mBasic[i] < n)
+        (*z)[mBasic[i]] = std::max(mX[i], static_cast<s_t>(0));
+    }
+    if (validate(M, *z, q))
+    {
+      mNumWarmStarts++;
+      return err;
     }
-    (*_z) = __z.head(n);
-    return err;
   }
 
   // Determine initial leaving variable
-  Eigen::VectorXs minuxX = -x;
   int lvindex;
-  s_t tval = minuxX.maxCoeff(&lvindex);
-  for (std::size_t i = 0; i < nonbas.size(); ++i)
-  {
-    bas.push_back(nonbas[i] + n);
-  }
-  leaving = bas[lvindex];
-
-  bas[lvindex] = t; // pivoting in the artificial variable
+  s_t tval = (-mX).maxCoeff(&lvindex);
+  const int t = 2 * n;
+  int leaving = mBasic[lvindex];
+  int entering = t;
+  mBasic[lvindex] = t; // pivoting in the artificial variable
 
-  Eigen::VectorXs U = Eigen::VectorXs::Zero(n);
   for (int i = 0; i < n; ++i)
-  {
-    if (x[i] < 0)
-      U[i] = 1;
-  }
-  Be = -(B * U);
-  x += tval * U;
-  x[lvindex] = tval;
-  B.col(lvindex) = Be;
+    mU[i] = mX[i] < 0 ? 1 : 0;
+  mBe = -(mBasis * mU);
+  mX += tval * mU;
+  mX[lvindex] = tval;
+  // This is B^-1 * Be, since Be = -B * U
+  mD = -mU;
+  replaceBasisColumn(lvindex, mBe, mD);
 
+  int iter = 0;
   for (iter = 0; iter < maxiter; ++iter)
   {
     if (leaving == t)
@@ -180,64 +199,47 @@ int Lemke(
     else if (leaving < n)
     {
       entering = n + leaving;
-      Be = Eigen::VectorXs::Zero(n);
-      Be[leaving] = -1;
+      mBe.setZero();
+      mBe[leaving] = -1;
     }
     else
     {
       entering = leaving - n;
-      Be = _M.col(entering);
+      mBe = M.col(entering);
     }
 
-    Eigen::VectorXs d = B.householderQr().solve(Be);
+    solveBasis(mBe, mD);
 
     // Find new leaving variable
-    std::vector<int> j;
+    mCandidates.clear();
     for (int i = 0; i < n; ++i)
     {
-      if (d[i] > piv_tol)
-        j.push_back(i);
+      if (mD[i] > piv_tol)
+        mCandidates.push_back(i);
     }
-    if (j.empty()) // no new pivots - ray termination
+    if (mCandidates.empty()) // no new pivots - ray termination
     {
       err = 2;
       break;
     }
 
-    std::size_t jSize = j.size();
-    Eigen::VectorXs minRatio(jSize);
-    for (std::size_t i = 0; i < jSize; ++i)
-    {
-      minRatio[i] = (x[j[i]] + zer_tol) / d[j[i]];
-    }
-    s_t theta = minRatio.minCoeff();
+    s_t theta = std::numeric_limits<s_t>::infinity();
+    for (int j : mCandidates)
+      theta = std::min(theta, (mX[j] + zer_tol) / mD[j]);
 
-    std::vector<int> tmpJ;
-    std::vector<s_t> tmpd;
-    for (std::size_t i = 0; i < jSize; ++i)
+    std::size_t numKept = 0;
+    mCandidateD.clear();
+    for (int j : mCandidates)
     {
-      if (x[j[i]] / d[j[i]] <= theta)
+      if (mX[j] / mD[j] <= theta)
       {
-        tmpJ.push_back(j[i]);
-        tmpd.push_back(d[j[i]]);
+        mCandidates[numKept++] = j;
+        mCandidateD.push_back(mD[j]);
       }
     }
+    mCandidates.resize(numKept);
 
-    //    if (tmpJ.empty())
-    //    {
-    //      LOG(WARNING) << "tmpJ should never be empty!!!";
-    //      LOG(WARNING) << "dumping data:";
-    //      LOG(WARNING) << "theta:" << theta;
-    //      for (int i = 0; i < jSize; ++i)
-    //      {
-    //        LOG(WARNING) << "x(" << j[i] << "): " << x[j[i]] << "d: " <<
-    //        d[j[i]];
-    //      }
-    //    }
-
-    j = tmpJ;
-    jSize = j.size();
-    if (jSize == 0)
+    if (mCandidates.empty())
     {
       err = 4;
       break;
@@ -245,52 +247,41 @@ int Lemke(
     lvindex = -1;
 
     // Check if artificial among these
-    for (std::size_t i = 0; i < jSize; ++i)
+    for (std::size_t i = 0; i < mCandidates.size(); ++i)
     {
-      if (bas[j[i]] == t)
+      if (mBasic[mCandidates[i]] == t)
         lvindex = i;
     }
 
     if (lvindex != -1)
     {
-      lvindex = j[lvindex]; // Always use artificial if possible
+      lvindex = mCandidates[lvindex]; // Always use artificial if possible
     }
     else
     {
-      theta = tmpd[0];
+      theta = mCandidateD[0];
       lvindex = 0;
-      for (std::size_t i = 0; i < jSize; ++i)
+      for (std::size_t i = 0; i < mCandidates.size(); ++i)
       {
-        if (tmpd[i] - theta > piv_tol)
+        if (mCandidateD[i] - theta > piv_tol)
         { // Bubble sorting
-          theta = tmpd[i];
+          theta = mCandidateD[i];
           lvindex = i;
         }
       }
-      lvindex = j[lvindex]; // choose the first if there are multiple
+      lvindex = mCandidates[lvindex]; // choose the first if there are multiple
     }
 
-    leaving = bas[lvindex];
+    leaving = mBasic[lvindex];
 
-    ratio = x[lvindex] / d[lvindex];
-
-    //    bool bDiverged = false;
-    //    for (int i = 0; i < n; ++i) {
-    //      if (isnan(x[i]) || isinf(x[i])) {
-    //        bDiverged = true;
-    //        break;
-    //      }
-    //    }
-    //    if (bDiverged) {
-    //      err = 4;
-    //      break;
-    //    }
+    const s_t ratio = mX[lvindex] / mD[lvindex];
 
     // Perform pivot
-    x = x - ratio * d;
-    x[lvindex] = ratio;
-    B.col(lvindex) = Be;
-    bas[lvindex] = entering;
+    mX -= ratio * mD;
+    mX[lvindex] = ratio;
+    replaceBasisColumn(lvindex, mBe, mD);
+    mBasic[lvindex] = entering;
+    mLastNumPivots++;
   }
 
   if (iter >= maxiter && leaving != t)
@@ -300,18 +291,14 @@ int Lemke(
 
   if (err == 0)
   {
-    for (std::size_t i = 0; i < bas.size(); ++i)
+    *z = Eigen::VectorXs::Zero(n);
+    for (int i = 0; i < n; ++i)
     {
-      if (bas[i] < _z->size())
-      {
-        (*_z)[bas[i]] = x[i];
-      }
+      if (mBasic[i] < n)
+        (*z)[mBasic[i]] = mX[i];
     }
 
-    Eigen::VectorXs __z = _z->head(n);
-    *_z = __z;
-
-    if (!validate(_M, *_z, _q))
+    if (!validate(M, *z, q))
     {
       // _z = VectorXs::Zero(n);
       err = 3;
@@ -319,7 +306,19 @@ int Lemke(
   }
   else
   {
-    *_z = Eigen::VectorXs::Zero(n); // solve failed, return a 0 vector
+    *z = Eigen::VectorXs::Zero(n); // solve failed, return a 0 vector
+  }
+
+  if (err == 0)
+  {
+    // The artificial variable has left, so exactly one of z[i] and w[i] is
+    // basic for every i, which is where we'll start next time
+    mLastBasicZ.assign(n, false);
+    for (int i = 0; i < n; ++i)
+    {
+      if (mBasic[i] < n)
+        mLastBasicZ[mBasic[i]] = true;
+    }
   }
 
   //  if (err == 1)
@@ -335,6 +334,91 @@ int Lemke(
   return err;
 }
 
+//==============================================================================
+bool LemkeSolver::factorBasis()
+{
+  mEtaIndices.clear();
+  mBasisLU.compute(mBasis);
+  if (mBasis.rows() == 0)
+    return true;
+
+  // Partial pivoting picks the largest entry left in each column as its
+  // pivot, so a pivot that's tiny next to the largest one means a column was
+  // (numerically) a combination of the columns before it. The threshold is
+  // the one Eigen's FullPivLU uses by default to decide rank.
+  const Eigen::VectorXs pivots = mBasisLU.matrixLU().diagonal().cwiseAbs();
+  const s_t maxPivot = pivots.maxCoeff();
+  const s_t threshold = maxPivot * static_cast<s_t>(mBasis.rows())
+                        * Eigen::NumTraits<s_t>::epsilon();
+  return maxPivot > 0 && pivots.minCoeff() > threshold;
+}
+
+//==============================================================================
+void LemkeSolver::solveBasis(
+    const Eigen::VectorXs& rhs, Eigen::VectorXs& out) const
+{
+  out = mBasisLU.solve(rhs);
+
+  // Each eta replaced column r of the basis B with a column c, which is the
+  // same as B' = B * E, where E is the identity except column r is
+  // d = B^-1 * c. So to solve with B', we solve with B, and then undo each E
+  // in the order they were applied.
+  for (std::size_t k = 0; k < mEtaIndices.size(); ++k)
+  {
+    const int r = mEtaIndices[k];
+    const s_t yr = out[r] / mEtaColumns(r, k);
+    out -= yr * mEtaColumns.col(k);
+    out[r] = yr;
+  }
+}
+
+//==============================================================================
+void LemkeSolver::replaceBasisColumn(
+    int index, const Eigen::VectorXs& column, const Eigen::VectorXs& d)
+{
+  mBasis.col(index) = column;
+  if (static_cast<int>(mEtaIndices.size()) >= mEtaColumns.cols())
+  {
+    factorBasis();
+    return;
+  }
+  mEtaColumns.col(mEtaIndices.size()) = d;
+  mEtaIndices.push_back(index);
+}
+
+//==============================================================================
+void LemkeSolver::setWarmStartEnabled(bool enabled)
+{
+  mWarmStartEnabled = enabled;
+}
+
+//==============================================================================
+bool LemkeSolver::getWarmStartEnabled() const
+{
+  return mWarmStartEnabled;
+}
+
+//==============================================================================
+std::size_t LemkeSolver::getNumWarmStarts() const
+{
+  return mNumWarmStarts;
+}
+
+//==============================================================================
+int LemkeSolver::getLastNumPivots() const
+{
+  return mLastNumPivots;
+}
+
+//==============================================================================
+int Lemke(
+    const Eigen::MatrixXs& _M, const Eigen::VectorXs& _q, Eigen::VectorXs* _z)
+{
+  LemkeSolver solver;
+  solver.setWarmStartEnabled(false);
+  return solver.solve(_M, _q, _z);
+}
+
 //==============================================================================
 bool validate(
     const Eigen::MatrixXs& _M,
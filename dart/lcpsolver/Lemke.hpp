@@ -33,6 +33,8 @@
 #ifndef DART_LCPSOLVER_LEMKE_HPP_
 #define DART_LCPSOLVER_LEMKE_HPP_
 
+#include <vector>
+
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
@@ -40,7 +42,102 @@
 namespace dart {
 namespace lcpsolver {
 
-/// \brief
+/// This solves LCPs of the form w = M * z + q, w >= 0, z >= 0, w^T z = 0 with
+/// Lemke's algorithm. Unlike the Lemke() function, this keeps its workspace
+/// between solves, so solving a stream of problems of the same size doesn't
+/// allocate.
+///
+/// Rather than redoing a dense factorization at every pivot, we factor the
+/// basis once, and then record each pivot as a column replacement (an eta
+/// vector) on top of that factorization, which costs O(n) to apply. We
+/// refactor from scratch once enough of these pile up.
+///
+/// With warm starting enabled, each solve starts from the basis the last
+/// successful solve of the same size ended on. If the problem hasn't changed
+/// much, like between nearby timesteps or iterations of an optimizer, that
+/// basis often solves the new problem outright, with no pivots at all.
+class LemkeSolver
+{
+public:
+  LemkeSolver();
+
+  /// This solves the LCP, writing the solution to `z`. This returns the same
+  /// error codes as Lemke(): 0 on success, 1 if we ran out of iterations, 2
+  /// on ray termination, 3 if the solution failed validate(), and 4 if the
+  /// pivoting broke down. On failure, `z` is set to 0.
+  int solve(
+      const Eigen::MatrixXs& M, const Eigen::VectorXs& q, Eigen::VectorXs* z);
+
+  /// Defaults to true. If this is true, we start from the basis the last
+  /// successful solve ended on, rather than the all-w basis, whenever the
+  /// problem size hasn't changed. If that doesn't pan out, we still fall back
+  /// to a cold start.
+  void setWarmStartEnabled(bool enabled);
+
+  /// Returns true if we start from the last solve's basis. See
+  /// setWarmStartEnabled().
+  bool getWarmStartEnabled() const;
+
+  /// Returns the number of solves where the last basis solved the problem
+  /// outright, without any pivots
+  std::size_t getNumWarmStarts() const;
+
+  /// Returns the number of pivots the last solve() took
+  int getLastNumPivots() const;
+
+protected:
+  /// This runs Lemke's algorithm, starting from the basis where z is basic
+  /// for the rows in mStartBasicZ, and w is basic for the rest
+  int solveFromBasis(
+      const Eigen::MatrixXs& M, const Eigen::VectorXs& q, Eigen::VectorXs* z);
+
+  /// This factors mBasis from scratch, and clears the eta file. This returns
+  /// false if mBasis is singular.
+  bool factorBasis();
+
+  /// This sets `out` to mBasis^-1 * `rhs`
+  void solveBasis(const Eigen::VectorXs& rhs, Eigen::VectorXs& out) const;
+
+  /// This replaces column `index` of mBasis with `column`, where
+  /// `d` = mBasis^-1 * `column` from before the replacement
+  void replaceBasisColumn(
+      int index, const Eigen::VectorXs& column, const Eigen::VectorXs& d);
+
+  bool mWarmStartEnabled;
+  std::size_t mNumWarmStarts;
+  int mLastNumPivots;
+
+  /// For each row, true if z (rather than w) was basic at the end of the
+  /// last successful solve
+  std::vector<bool> mLastBasicZ;
+
+  /// For each row, true if z should be basic in the starting basis
+  std::vector<bool> mStartBasicZ;
+
+  /// The current basis, and its factorization as of the last factorBasis()
+  Eigen::MatrixXs mBasis;
+  Eigen::PartialPivLU<Eigen::MatrixXs> mBasisLU;
+
+  /// The eta file: each column replacement since the last factorBasis(), as
+  /// the replaced column index and mBasis^-1 * the new column at the time
+  std::vector<int> mEtaIndices;
+  Eigen::MatrixXs mEtaColumns;
+
+  /// The variable that's basic in each column of mBasis. Variables 0 to n-1
+  /// are z, n to 2n-1 are w, and 2n is the artificial variable.
+  std::vector<int> mBasic;
+
+  // Scratch space for each pivot
+  Eigen::VectorXs mX;
+  Eigen::VectorXs mD;
+  Eigen::VectorXs mBe;
+  Eigen::VectorXs mU;
+  std::vector<int> mCandidates;
+  std::vector<s_t> mCandidateD;
+};
+
+/// \brief This solves the LCP with a fresh LemkeSolver, with no warm start.
+/// Use a LemkeSolver directly to reuse the workspace across solves.
 int Lemke(
     const Eigen::MatrixXs& _M, const Eigen::VectorXs& _q, Eigen::VectorXs* _z);
 
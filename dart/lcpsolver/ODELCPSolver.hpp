@@ -35,6 +35,7 @@
 
 #include <Eigen/Dense>
 
+#include "dart/lcpsolver/Lemke.hpp"
 #include "dart/math/MathTypes.hpp"
 
 namespace dart {
@@ -82,6 +83,10 @@ private:
       const Eigen::MatrixXs& _A,
       const Eigen::VectorXs& _b,
       const Eigen::VectorXs& _x);
+
+  /// This keeps its workspace, and warm starts, between calls to Solve() that
+  /// don't use the ODE solver
+  LemkeSolver mLemkeSolver;
 };
 
 } // namespace lcpsolver
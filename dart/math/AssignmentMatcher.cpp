@@ -1,5 +1,13 @@
 #include "dart/math/AssignmentMatcher.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+
+#include "dart/common/TaskScheduler.hpp"
+
 namespace dart {
 namespace math {
 
@@ -8,56 +16,200 @@ namespace math {
 Eigen::VectorXi AssignmentMatcher::assignRowsToColumns(
     const Eigen::MatrixXs& weights)
 {
-  std::vector<int> rowsNeedAssignments;
-  std::vector<int> colsNeedAssignments;
+  // Entries of -infinity (or NaN) can never be picked, so they're left out
+  SparseAssignmentProblem problem;
+  problem.numRows = weights.rows();
+  problem.numCols = weights.cols();
+  for (int row = 0; row < weights.rows(); row++)
+  {
+    for (int col = 0; col < weights.cols(); col++)
+    {
+      s_t score = weights(row, col);
+      if (score > -1 * std::numeric_limits<double>::infinity())
+      {
+        problem.weights.emplace_back(row, col, score);
+      }
+    }
+  }
+  return assignRowsToColumnsSparse(problem);
+}
 
-  for (int i = 0; i < weights.rows(); i++)
+/// This is the same as assignRowsToColumns(), but only looks at the listed
+/// entries, as though every other entry in the matrix was -infinity.
+Eigen::VectorXi AssignmentMatcher::assignRowsToColumnsSparse(
+    const SparseAssignmentProblem& problem)
+{
+  // TODO: this is a greedy algorithm that does not return optimal assignments.
+  // We should eventually implement the Hungarian method here.
+  //
+  // The greedy algorithm repeatedly takes the highest scoring (row, col) pair
+  // where neither the row nor the column has been assigned yet, breaking ties
+  // by the lowest row, then the lowest column. That's the same as sorting all
+  // the entries in that order once, and sweeping through them.
+  std::vector<int> order;
+  order.reserve(problem.weights.size());
+  for (int i = 0; i < problem.weights.size(); i++)
   {
-    rowsNeedAssignments.push_back(i);
+    if (problem.weights[i].value()
+        > -1 * std::numeric_limits<double>::infinity())
+    {
+      order.push_back(i);
+    }
   }
-  for (int i = 0; i < weights.cols(); i++)
+  std::sort(order.begin(), order.end(), [&problem](int a, int b) {
+    const Eigen::Triplet<s_t>& x = problem.weights[a];
+    const Eigen::Triplet<s_t>& y = problem.weights[b];
+    if (x.value() != y.value())
+    {
+      return x.value() > y.value();
+    }
+    if (x.row() != y.row())
+    {
+      return x.row() < y.row();
+    }
+    return x.col() < y.col();
+  });
+
+  Eigen::VectorXi mapping = -1 * Eigen::VectorXi::Ones(problem.numRows);
+  std::vector<bool> colAssigned(problem.numCols, false);
+  int numAssigned = 0;
+  const int maxAssigned = std::min(problem.numRows, problem.numCols);
+  for (int i : order)
   {
-    colsNeedAssignments.push_back(i);
+    if (numAssigned >= maxAssigned)
+    {
+      break;
+    }
+    int row = problem.weights[i].row();
+    int col = problem.weights[i].col();
+    if (mapping(row) == -1 && !colAssigned[col])
+    {
+      mapping(row) = col;
+      colAssigned[col] = true;
+      numAssigned++;
+    }
   }
 
-  Eigen::VectorXi mapping = -1 * Eigen::VectorXi::Ones(weights.rows());
+  return mapping;
+}
 
-  // TODO: this is a greedy algorithm that does not return optimal assignments.
-  // We should eventually implement the Hungarian method here.
-  while (rowsNeedAssignments.size() > 0 && colsNeedAssignments.size() > 0)
+/// This solves a batch of independent assignment problems, spread across
+/// `numThreads` threads
+std::vector<Eigen::VectorXi> AssignmentMatcher::assignRowsToColumnsBatch(
+    const std::vector<SparseAssignmentProblem>& problems, int numThreads)
+{
+  std::vector<Eigen::VectorXi> results(problems.size());
+  if (numThreads <= 0)
   {
-    int maxRowIndex = -1;
-    int maxColIndex = -1;
-    s_t maxScore = -1 * std::numeric_limits<double>::infinity();
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)problems.size()));
 
-    for (int row = 0; row < rowsNeedAssignments.size(); row++)
-    {
-      for (int col = 0; col < colsNeedAssignments.size(); col++)
+  // Each thread takes a contiguous range of problems, and writes only its
+  // own entries of `results`
+  std::vector<common::TaskFuture<void>> futures;
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    const int start = (problems.size() * threadIdx) / numThreads;
+    const int end = (problems.size() * (threadIdx + 1)) / numThreads;
+    futures.push_back(common::async([start, end, &problems, &results] {
+      for (int i = start; i < end; i++)
       {
-        s_t score = weights(rowsNeedAssignments[row], colsNeedAssignments[col]);
-        if (score > maxScore)
-        {
-          maxScore = score;
-          maxRowIndex = row;
-          maxColIndex = col;
-        }
+        results[i] = assignRowsToColumnsSparse(problems[i]);
       }
+    }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  return results;
+}
+
+/// This builds the sparse weights for matching `rowPoints` to `colPoints`,
+/// where each pair within `maxDistance` of each other gets a weight of
+/// 1/distance
+SparseAssignmentProblem AssignmentMatcher::createGatedDistanceProblem(
+    const std::vector<Eigen::Vector3s>& rowPoints,
+    const std::vector<Eigen::Vector3s>& colPoints,
+    s_t maxDistance)
+{
+  SparseAssignmentProblem problem;
+  problem.numRows = rowPoints.size();
+  problem.numCols = colPoints.size();
+
+  auto addIfInRange = [&](int row, int col) {
+    s_t dist = (rowPoints[row] - colPoints[col]).norm();
+    if (dist <= maxDistance)
+    {
+      problem.weights.emplace_back(row, col, 1.0 / dist);
     }
+  };
 
-    if (maxRowIndex == -1 || maxColIndex == -1)
+  // Without a sensible cell size, fall back to comparing every pair
+  if (!(maxDistance > 0) || !std::isfinite((double)maxDistance))
+  {
+    for (int row = 0; row < rowPoints.size(); row++)
     {
-      break;
+      for (int col = 0; col < colPoints.size(); col++)
+      {
+        addIfInRange(row, col);
+      }
     }
+    return problem;
+  }
 
-    int row = rowsNeedAssignments[maxRowIndex];
-    int col = colsNeedAssignments[maxColIndex];
-    mapping(row) = col;
+  // Bucket the columns into cubes `maxDistance` on a side, so every column in
+  // range of a row is in the row's cell, or one of the 26 around it
+  auto cellOf = [maxDistance](const Eigen::Vector3s& point) {
+    return Eigen::Vector3i(
+        (int)std::floor((double)(point(0) / maxDistance)),
+        (int)std::floor((double)(point(1) / maxDistance)),
+        (int)std::floor((double)(point(2) / maxDistance)));
+  };
+  auto cellKey = [](const Eigen::Vector3i& cell) {
+    return ((std::int64_t)cell(0) * 73856093)
+           ^ ((std::int64_t)cell(1) * 19349663)
+           ^ ((std::int64_t)cell(2) * 83492791);
+  };
+  std::unordered_map<std::int64_t, std::vector<int>> grid;
+  for (int col = 0; col < colPoints.size(); col++)
+  {
+    grid[cellKey(cellOf(colPoints[col]))].push_back(col);
+  }
 
-    rowsNeedAssignments.erase(rowsNeedAssignments.begin() + maxRowIndex);
-    colsNeedAssignments.erase(colsNeedAssignments.begin() + maxColIndex);
+  for (int row = 0; row < rowPoints.size(); row++)
+  {
+    Eigen::Vector3i cell = cellOf(rowPoints[row]);
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          auto bucket
+              = grid.find(cellKey(cell + Eigen::Vector3i(dx, dy, dz)));
+          if (bucket == grid.end())
+          {
+            continue;
+          }
+          for (int col : bucket->second)
+          {
+            // Hash collisions can put far away columns in the same bucket,
+            // but the distance check filters those out. Make sure we only
+            // see each column once per row though.
+            if (cellOf(colPoints[col]) == cell + Eigen::Vector3i(dx, dy, dz))
+            {
+              addIfInRange(row, col);
+            }
+          }
+        }
+      }
+    }
   }
 
-  return mapping;
+  return problem;
 }
 
 std::map<std::string, std::string> AssignmentMatcher::assignKeysToKeys(
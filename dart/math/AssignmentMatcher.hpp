@@ -1,12 +1,26 @@
 #ifndef MATH_ASSIGNMENT_MATCHER_H_
 #define MATH_ASSIGNMENT_MATCHER_H_
 
+#include <vector>
+
+#include <Eigen/Sparse>
+
 #include "dart/math/CustomFunction.hpp"
 #include "dart/math/MathTypes.hpp"
 
 namespace dart {
 namespace math {
 
+/// This is one assignment problem, where only the (row, col) pairs listed in
+/// `weights` are allowed to be matched. Rows and columns that aren't in any
+/// entry can't be matched to anything.
+struct SparseAssignmentProblem
+{
+  int numRows = 0;
+  int numCols = 0;
+  std::vector<Eigen::Triplet<s_t>> weights;
+};
+
 class AssignmentMatcher
 {
 public:
@@ -14,6 +28,30 @@ public:
   /// unassigned rows get assigned to -1
   static Eigen::VectorXi assignRowsToColumns(const Eigen::MatrixXs& weights);
 
+  /// This is the same as assignRowsToColumns(), but only looks at the listed
+  /// entries, as though every other entry in the matrix was -infinity. It runs
+  /// in O(E log E) for E entries, rather than scanning the whole matrix on
+  /// every assignment.
+  static Eigen::VectorXi assignRowsToColumnsSparse(
+      const SparseAssignmentProblem& problem);
+
+  /// This solves a batch of independent assignment problems (for example,
+  /// many frames of a point cloud), spread across `numThreads` threads (<= 0
+  /// means one per hardware thread).
+  static std::vector<Eigen::VectorXi> assignRowsToColumnsBatch(
+      const std::vector<SparseAssignmentProblem>& problems,
+      int numThreads = -1);
+
+  /// This builds the sparse weights for matching `rowPoints` to `colPoints`,
+  /// where each pair within `maxDistance` of each other gets a weight of
+  /// 1/distance, and pairs further apart can't be matched. The candidates are
+  /// found with a uniform grid, so this is roughly linear in the number of
+  /// points, rather than comparing every pair.
+  static SparseAssignmentProblem createGatedDistanceProblem(
+      const std::vector<Eigen::Vector3s>& rowPoints,
+      const std::vector<Eigen::Vector3s>& colPoints,
+      s_t maxDistance);
+
   static std::map<std::string, std::string> assignKeysToKeys(
       std::vector<std::string> source,
       std::vector<std::string> target,
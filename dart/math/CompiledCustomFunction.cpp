@@ -0,0 +1,122 @@
+#include "dart/math/CompiledCustomFunction.hpp"
+
+#include <cassert>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+std::shared_ptr<CompiledCustomFunction> CompiledCustomFunction::compile(
+    const CustomFunction& fn)
+{
+  std::vector<s_t> knots;
+  std::vector<s_t> coeffs;
+  int degree = 0;
+  if (!fn.toPiecewisePolynomial(knots, coeffs, degree) || knots.empty())
+    return nullptr;
+  return std::make_shared<CompiledCustomFunction>(
+      std::move(knots), std::move(coeffs), degree);
+}
+
+//==============================================================================
+CompiledCustomFunction::CompiledCustomFunction(
+    std::vector<s_t> knots, std::vector<s_t> coeffs, int degree)
+  : mKnots(std::move(knots)), mCoeffs(std::move(coeffs)), mDegree(degree)
+{
+  assert(!mKnots.empty());
+  assert(mDegree >= 0);
+  assert(mCoeffs.size() == mKnots.size() * (mDegree + 1));
+}
+
+//==============================================================================
+s_t CompiledCustomFunction::calcValue(s_t x) const
+{
+  const int segment = findSegment(x);
+  const s_t* c = &mCoeffs[segment * (mDegree + 1)];
+  const s_t dx = x - mKnots[segment];
+  s_t value = c[mDegree];
+  for (int j = mDegree - 1; j >= 0; j--)
+    value = value * dx + c[j];
+  return value;
+}
+
+//==============================================================================
+s_t CompiledCustomFunction::calcDerivative(int order, s_t x) const
+{
+  if (order == 0)
+    return calcValue(x);
+  if (order > mDegree)
+    return 0.0;
+
+  const int segment = findSegment(x);
+  const s_t* c = &mCoeffs[segment * (mDegree + 1)];
+  const s_t dx = x - mKnots[segment];
+
+  // The order-th derivative of c_j * dx^j is j!/(j-order)! * c_j *
+  // dx^(j-order), which we sum up with Horner's method from the top down
+  s_t value = 0.0;
+  for (int j = mDegree; j >= order; j--)
+  {
+    s_t multiple = 1.0;
+    for (int k = 0; k < order; k++)
+      multiple *= (j - k);
+    value = value * dx + multiple * c[j];
+  }
+  return value;
+}
+
+//==============================================================================
+Eigen::Vector4s CompiledCustomFunction::calcValueAndDerivatives(s_t x) const
+{
+  const int segment = findSegment(x);
+  const s_t* c = &mCoeffs[segment * (mDegree + 1)];
+  const s_t dx = x - mKnots[segment];
+
+  // This is Horner's method carried along for the first three derivatives.
+  // At the end, d1, d2 and d3 are the Taylor coefficients at dx, so the
+  // derivatives are d1, 2 * d2 and 6 * d3.
+  s_t value = 0.0;
+  s_t d1 = 0.0;
+  s_t d2 = 0.0;
+  s_t d3 = 0.0;
+  for (int j = mDegree; j >= 0; j--)
+  {
+    d3 = d3 * dx + d2;
+    d2 = d2 * dx + d1;
+    d1 = d1 * dx + value;
+    value = value * dx + c[j];
+  }
+  return Eigen::Vector4s(value, d1, 2.0 * d2, 6.0 * d3);
+}
+
+//==============================================================================
+int CompiledCustomFunction::getNumSegments() const
+{
+  return mKnots.size();
+}
+
+//==============================================================================
+int CompiledCustomFunction::getDegree() const
+{
+  return mDegree;
+}
+
+//==============================================================================
+int CompiledCustomFunction::findSegment(s_t x) const
+{
+  // This is a binary search where every step is a conditional move rather
+  // than a branch, so it takes the same (short) path for every x. A NaN
+  // compares false everywhere, and lands on the first segment.
+  const s_t* base = mKnots.data();
+  std::size_t n = mKnots.size();
+  while (n > 1)
+  {
+    const std::size_t half = n / 2;
+    base = (base[half] <= x) ? base + half : base;
+    n -= half;
+  }
+  return base - mKnots.data();
+}
+
+} // namespace math
+} // namespace dart
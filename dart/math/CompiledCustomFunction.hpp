@@ -0,0 +1,59 @@
+#ifndef DART_MATH_COMPILEDCUSTOMFUNCTION_HPP_
+#define DART_MATH_COMPILEDCUSTOMFUNCTION_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "dart/math/CustomFunction.hpp"
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is a CustomFunction flattened into a single table of polynomial
+/// segments. Evaluating it is one binary search over the knots, with no
+/// virtual calls and no branches that depend on the data, followed by
+/// Horner's method on the segment. CustomJoint evaluates its coupling
+/// functions this way, because they sit right in the middle of forward
+/// kinematics and all of its derivatives.
+///
+/// The table is a snapshot, so if the function it was compiled from changes
+/// afterwards, it has to be compiled again.
+class CompiledCustomFunction
+{
+public:
+  /// This returns nullptr if `fn` can't be written as piecewise polynomials
+  /// (see CustomFunction::toPiecewisePolynomial()).
+  static std::shared_ptr<CompiledCustomFunction> compile(
+      const CustomFunction& fn);
+
+  CompiledCustomFunction(
+      std::vector<s_t> knots, std::vector<s_t> coeffs, int degree);
+
+  s_t calcValue(s_t x) const;
+
+  s_t calcDerivative(int order, s_t x) const;
+
+  /// This returns the value and the first, second and third derivatives at
+  /// `x`, all from a single segment lookup.
+  Eigen::Vector4s calcValueAndDerivatives(s_t x) const;
+
+  int getNumSegments() const;
+
+  int getDegree() const;
+
+protected:
+  /// Returns the index of the last knot that's <= x, or 0 if x is below all
+  /// of them.
+  int findSegment(s_t x) const;
+
+  std::vector<s_t> mKnots;
+  /// (mDegree + 1) coefficients per segment, lowest order first
+  std::vector<s_t> mCoeffs;
+  int mDegree;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -24,5 +24,14 @@ std::shared_ptr<CustomFunction> ConstantFunction::offsetBy(s_t y) const
   return std::make_shared<ConstantFunction>(mValue + y);
 }
 
+bool ConstantFunction::toPiecewisePolynomial(
+    std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const
+{
+  knots.assign(1, 0.0);
+  coeffs.assign(1, mValue);
+  degree = 0;
+  return true;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "dart/math/ConvexHull.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+namespace dart {
+namespace math {
+
+namespace {
+
+struct HullFace
+{
+  int v[3];
+  Eigen::Vector3s normal;
+  s_t offset;
+  std::vector<int> outside;
+  bool alive;
+};
+
+inline std::uint64_t edgeKey(int a, int b)
+{
+  return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b);
+}
+
+} // anonymous namespace
+
+//==============================================================================
+ConvexHull::ConvexHull(const std::vector<Eigen::Vector3s>& points)
+  : mIsDegenerate(true)
+{
+  // Sort and remove duplicates, since meshes usually repeat each vertex once
+  // for every face that uses it
+  std::vector<Eigen::Vector3s> unique = points;
+  auto lexicographic = [](const Eigen::Vector3s& a, const Eigen::Vector3s& b) {
+    if (a(0) != b(0))
+      return a(0) < b(0);
+    if (a(1) != b(1))
+      return a(1) < b(1);
+    return a(2) < b(2);
+  };
+  std::sort(unique.begin(), unique.end(), lexicographic);
+  unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+  mIsDegenerate = !build(unique);
+  if (mIsDegenerate)
+  {
+    mVertices = unique;
+    mFaces.clear();
+    mNeighbors.clear();
+  }
+
+  mStartVertices.clear();
+  if (mVertices.empty())
+    return;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    int maxIndex = 0;
+    int minIndex = 0;
+    for (int i = 1; i < static_cast<int>(mVertices.size()); i++)
+    {
+      if (mVertices[i](axis) > mVertices[maxIndex](axis))
+        maxIndex = i;
+      if (mVertices[i](axis) < mVertices[minIndex](axis))
+        minIndex = i;
+    }
+    mStartVertices.push_back(maxIndex);
+    mStartVertices.push_back(minIndex);
+  }
+}
+
+//==============================================================================
+int ConvexHull::getSupportIndex(const Eigen::Vector3s& dir, int hint) const
+{
+  if (mVertices.empty())
+    return -1;
+
+  if (mIsDegenerate)
+  {
+    int best = 0;
+    s_t bestDot = mVertices[0].dot(dir);
+    for (int i = 1; i < static_cast<int>(mVertices.size()); i++)
+    {
+      s_t dot = mVertices[i].dot(dir);
+      if (dot > bestDot)
+      {
+        bestDot = dot;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  int current = hint;
+  if (current < 0 || current >= static_cast<int>(mVertices.size()))
+  {
+    current = mStartVertices[0];
+    for (int start : mStartVertices)
+    {
+      if (mVertices[start].dot(dir) > mVertices[current].dot(dir))
+        current = start;
+    }
+  }
+
+  // The support function is linear, so on a convex polytope any vertex that
+  // none of its neighbors beat is a global maximum. Each step strictly
+  // increases the dot product, so this always terminates.
+  s_t currentDot = mVertices[current].dot(dir);
+  while (true)
+  {
+    int next = current;
+    for (int neighbor : mNeighbors[current])
+    {
+      s_t dot = mVertices[neighbor].dot(dir);
+      if (dot > currentDot)
+      {
+        currentDot = dot;
+        next = neighbor;
+      }
+    }
+    if (next == current)
+      break;
+    current = next;
+  }
+  return current;
+}
+
+//==============================================================================
+const Eigen::Vector3s& ConvexHull::getSupport(const Eigen::Vector3s& dir) const
+{
+  return mVertices[getSupportIndex(dir)];
+}
+
+//==============================================================================
+const std::vector<Eigen::Vector3s>& ConvexHull::getVertices() const
+{
+  return mVertices;
+}
+
+//==============================================================================
+const std::vector<Eigen::Vector3i>& ConvexHull::getFaces() const
+{
+  return mFaces;
+}
+
+//==============================================================================
+const std::vector<int>& ConvexHull::getNeighbors(int vertex) const
+{
+  static const std::vector<int> none;
+  if (mIsDegenerate)
+    return none;
+  return mNeighbors[vertex];
+}
+
+//==============================================================================
+bool ConvexHull::isDegenerate() const
+{
+  return mIsDegenerate;
+}
+
+//==============================================================================
+bool ConvexHull::build(const std::vector<Eigen::Vector3s>& points)
+{
+  const int n = static_cast<int>(points.size());
+  if (n < 4)
+    return false;
+
+  // Scale our tolerance to the size of the point cloud
+  Eigen::Vector3s lower = points[0];
+  Eigen::Vector3s upper = points[0];
+  for (const Eigen::Vector3s& point : points)
+  {
+    lower = lower.cwiseMin(point);
+    upper = upper.cwiseMax(point);
+  }
+  const s_t eps = std::max((upper - lower).norm(), (s_t)1.0) * 1e-10;
+
+  // 1. Find a starting tetrahedron, from the two furthest apart axis-extreme
+  // points, the point furthest from the line between them, and the point
+  // furthest from the plane through all three.
+  std::vector<int> extremes;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    int maxIndex = 0;
+    int minIndex = 0;
+    for (int i = 1; i < n; i++)
+    {
+      if (points[i](axis) > points[maxIndex](axis))
+        maxIndex = i;
+      if (points[i](axis) < points[minIndex](axis))
+        minIndex = i;
+    }
+    extremes.push_back(maxIndex);
+    extremes.push_back(minIndex);
+  }
+  int i0 = extremes[0];
+  int i1 = extremes[1];
+  for (int a : extremes)
+  {
+    for (int b : extremes)
+    {
+      if ((points[a] - points[b]).squaredNorm()
+          > (points[i0] - points[i1]).squaredNorm())
+      {
+        i0 = a;
+        i1 = b;
+      }
+    }
+  }
+  if ((points[i0] - points[i1]).norm() < eps)
+    return false;
+
+  const Eigen::Vector3s lineDir = (points[i1] - points[i0]).normalized();
+  int i2 = -1;
+  s_t bestLineDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    Eigen::Vector3s offset = points[i] - points[i0];
+    s_t dist = (offset - lineDir * lineDir.dot(offset)).norm();
+    if (dist > bestLineDist)
+    {
+      bestLineDist = dist;
+      i2 = i;
+    }
+  }
+  if (i2 == -1)
+    return false;
+
+  const Eigen::Vector3s planeNormal
+      = (points[i1] - points[i0]).cross(points[i2] - points[i0]).normalized();
+  int i3 = -1;
+  s_t bestPlaneDist = eps;
+  for (int i = 0; i < n; i++)
+  {
+    s_t dist = std::abs(planeNormal.dot(points[i] - points[i0]));
+    if (dist > bestPlaneDist)
+    {
+      bestPlaneDist = dist;
+      i3 = i;
+    }
+  }
+  if (i3 == -1)
+    return false;
+
+  std::vector<HullFace> faces;
+  std::unordered_map<std::uint64_t, int> edgeToFace;
+
+  auto addFace = [&](int a, int b, int c) {
+    HullFace face;
+    face.v[0] = a;
+    face.v[1] = b;
+    face.v[2] = c;
+    face.normal
+        = (points[b] - points[a]).cross(points[c] - points[a]).normalized();
+    face.offset = face.normal.dot(points[a]);
+    face.alive = true;
+    const int index = static_cast<int>(faces.size());
+    faces.push_back(face);
+    edgeToFace[edgeKey(a, b)] = index;
+    edgeToFace[edgeKey(b, c)] = index;
+    edgeToFace[edgeKey(c, a)] = index;
+    return index;
+  };
+  auto distance = [&](const HullFace& face, int point) {
+    return face.normal.dot(points[point]) - face.offset;
+  };
+
+  // Wind every face of the tetrahedron so that it faces away from the
+  // centroid
+  const Eigen::Vector3s centroid
+      = (points[i0] + points[i1] + points[i2] + points[i3]) / 4;
+  const int tetrahedron[4][3]
+      = {{i0, i1, i2}, {i0, i1, i3}, {i0, i2, i3}, {i1, i2, i3}};
+  for (const auto& tri : tetrahedron)
+  {
+    Eigen::Vector3s normal = (points[tri[1]] - points[tri[0]])
+                                 .cross(points[tri[2]] - points[tri[0]]);
+    if (normal.dot(centroid - points[tri[0]]) > 0)
+      addFace(tri[0], tri[2], tri[1]);
+    else
+      addFace(tri[0], tri[1], tri[2]);
+  }
+
+  // Every other point goes in the outside set of the first face it's in
+  // front of. Points that aren't in front of any face are inside the hull,
+  // and we can forget about them.
+  for (int i = 0; i < n; i++)
+  {
+    if (i == i0 || i == i1 || i == i2 || i == i3)
+      continue;
+    for (HullFace& face : faces)
+    {
+      if (distance(face, i) > eps)
+      {
+        face.outside.push_back(i);
+        break;
+      }
+    }
+  }
+
+  // 2. Repeatedly take the furthest outside point of some face, knock out
+  // every face it can see, and patch the hole with a fan of faces from the
+  // horizon to the point
+  // visibility[i] is only meaningful if visibilityStamp[i] matches the current
+  // iteration, which saves us from clearing it every time around
+  std::vector<int> visibility;
+  std::vector<std::size_t> visibilityStamp;
+  for (std::size_t f = 0; f < faces.size(); f++)
+  {
+    if (!faces[f].alive || faces[f].outside.empty())
+      continue;
+
+    int eye = faces[f].outside[0];
+    s_t eyeDist = distance(faces[f], eye);
+    for (int point : faces[f].outside)
+    {
+      s_t dist = distance(faces[f], point);
+      if (dist > eyeDist)
+      {
+        eyeDist = dist;
+        eye = point;
+      }
+    }
+
+    // Flood out from `f` to find every face `eye` can see. 0 means we haven't
+    // checked the face yet, 1 means it's visible, and 2 means it isn't.
+    visibility.resize(faces.size(), 0);
+    visibilityStamp.resize(faces.size(), faces.size());
+    auto visibilityOf = [&](int index) -> int& {
+      if (visibilityStamp[index] != f)
+      {
+        visibilityStamp[index] = f;
+        visibility[index] = 0;
+      }
+      return visibility[index];
+    };
+    std::vector<int> visible;
+    std::vector<std::pair<int, int>> horizon;
+    visibilityOf(f) = 1;
+    visible.push_back(static_cast<int>(f));
+    for (std::size_t k = 0; k < visible.size(); k++)
+    {
+      const HullFace& face = faces[visible[k]];
+      for (int e = 0; e < 3; e++)
+      {
+        int a = face.v[e];
+        int b = face.v[(e + 1) % 3];
+        auto twin = edgeToFace.find(edgeKey(b, a));
+        if (twin == edgeToFace.end())
+          return false;
+        int neighbor = twin->second;
+        int& state = visibilityOf(neighbor);
+        if (state == 0)
+        {
+          state = distance(faces[neighbor], eye) > eps ? 1 : 2;
+          if (state == 1)
+            visible.push_back(neighbor);
+        }
+        if (state == 2)
+          horizon.emplace_back(a, b);
+      }
+    }
+
+    std::vector<int> orphans;
+    for (int index : visible)
+    {
+      HullFace& face = faces[index];
+      face.alive = false;
+      for (int point : face.outside)
+      {
+        if (point != eye)
+          orphans.push_back(point);
+      }
+      face.outside.clear();
+      for (int e = 0; e < 3; e++)
+      {
+        auto edge = edgeToFace.find(edgeKey(face.v[e], face.v[(e + 1) % 3]));
+        if (edge != edgeToFace.end() && edge->second == index)
+          edgeToFace.erase(edge);
+      }
+    }
+
+    const int firstNewFace = static_cast<int>(faces.size());
+    for (const auto& edge : horizon)
+      addFace(edge.first, edge.second, eye);
+
+    for (int point : orphans)
+    {
+      for (int index = firstNewFace; index < static_cast<int>(faces.size());
+           index++)
+      {
+        if (distance(faces[index], point) > eps)
+        {
+          faces[index].outside.push_back(point);
+          break;
+        }
+      }
+    }
+
+    // The faces we just added come after `f`, so the loop will get to them
+  }
+
+  // 3. Make sure we ended up with a closed surface, and pull out the vertices
+  // and their neighbors
+  std::vector<int> remap(n, -1);
+  mVertices.clear();
+  mFaces.clear();
+  for (std::size_t f = 0; f < faces.size(); f++)
+  {
+    const HullFace& face = faces[f];
+    if (!face.alive)
+      continue;
+    Eigen::Vector3i tri;
+    for (int e = 0; e < 3; e++)
+    {
+      int a = face.v[e];
+      int b = face.v[(e + 1) % 3];
+      auto twin = edgeToFace.find(edgeKey(b, a));
+      if (twin == edgeToFace.end() || !faces[twin->second].alive)
+        return false;
+      if (remap[a] == -1)
+      {
+        remap[a] = static_cast<int>(mVertices.size());
+        mVertices.push_back(points[a]);
+      }
+      tri(e) = remap[a];
+    }
+    mFaces.push_back(tri);
+  }
+
+  mNeighbors.assign(mVertices.size(), std::vector<int>());
+  for (const Eigen::Vector3i& tri : mFaces)
+  {
+    for (int e = 0; e < 3; e++)
+    {
+      // Each edge shows up in two faces, so this records every neighbor
+      // twice, and we dedupe below
+      mNeighbors[tri(e)].push_back(tri((e + 1) % 3));
+      mNeighbors[tri((e + 1) % 3)].push_back(tri(e));
+    }
+  }
+  for (std::vector<int>& neighbors : mNeighbors)
+  {
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(
+        std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+  }
+
+  return true;
+}
+
+} // namespace math
+} // namespace dart
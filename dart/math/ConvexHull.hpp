@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DART_MATH_CONVEXHULL_HPP_
+#define DART_MATH_CONVEXHULL_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+/// This is the 3D convex hull of a point cloud, set up for fast support
+/// queries. Finding the point furthest along a direction by brute force is
+/// linear in the number of points, but on a convex hull we can instead walk
+/// from vertex to neighboring vertex, always moving further along the
+/// direction, until no neighbor is any better. That's only as many steps as
+/// it takes to cross the hull, which for detailed meshes is a tiny fraction
+/// of the vertex count.
+///
+/// The hull is built once, with Quickhull, so this is meant to be built once
+/// per mesh and then queried many times.
+class ConvexHull
+{
+public:
+  /// This builds the hull of `points`. Duplicate points are fine.
+  ConvexHull(const std::vector<Eigen::Vector3s>& points);
+
+  /// Returns the index into getVertices() of a vertex that is furthest along
+  /// `dir`. If `hint` is the index of a vertex that is close to the answer
+  /// (for example, the answer to the last query, if the direction hasn't
+  /// changed much), we start the walk from there, otherwise we start from
+  /// whichever of the axis-extreme vertices is furthest along `dir`.
+  int getSupportIndex(const Eigen::Vector3s& dir, int hint = -1) const;
+
+  /// Returns a vertex that is furthest along `dir`
+  const Eigen::Vector3s& getSupport(const Eigen::Vector3s& dir) const;
+
+  /// Returns the vertices of the hull. If the hull is degenerate, this
+  /// returns all the (distinct) input points.
+  const std::vector<Eigen::Vector3s>& getVertices() const;
+
+  /// Returns the triangles of the hull, as indices into getVertices(), wound
+  /// counter-clockwise when seen from outside the hull. This is empty if the
+  /// hull is degenerate.
+  const std::vector<Eigen::Vector3i>& getFaces() const;
+
+  /// Returns the indices of the vertices that share an edge of the hull with
+  /// `vertex`. This is empty if the hull is degenerate.
+  const std::vector<int>& getNeighbors(int vertex) const;
+
+  /// This is true if the points were all (nearly) coplanar, or if building
+  /// the hull ran into numerical trouble. In that case we don't have a hull
+  /// to walk on, so support queries fall back to checking every point.
+  bool isDegenerate() const;
+
+protected:
+  /// This runs Quickhull on `points`, which must not contain duplicates, and
+  /// fills in our vertices, faces and neighbors. Returns false if the points
+  /// are degenerate.
+  bool build(const std::vector<Eigen::Vector3s>& points);
+
+  std::vector<Eigen::Vector3s> mVertices;
+  std::vector<Eigen::Vector3i> mFaces;
+
+  /// For each vertex, the indices of the vertices it shares an edge with
+  std::vector<std::vector<int>> mNeighbors;
+
+  /// The vertices that are furthest along +X, -X, +Y, -Y, +Z and -Z, which
+  /// make good places to start the walk from
+  std::vector<int> mStartVertices;
+
+  bool mIsDegenerate;
+};
+
+} // namespace math
+} // namespace dart
+
+#endif // DART_MATH_CONVEXHULL_HPP_
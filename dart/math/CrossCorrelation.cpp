@@ -0,0 +1,163 @@
+#include "dart/math/CrossCorrelation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace dart {
+namespace math {
+
+//==============================================================================
+/// This runs an in-place radix-2 FFT over `data`, whose size must be a
+/// power of two. If `inverse` is true, this runs the inverse transform,
+/// including the 1/N scaling.
+void CrossCorrelation::fft(std::vector<std::complex<s_t>>& data, bool inverse)
+{
+  const int n = data.size();
+  if (n <= 1)
+    return;
+
+  // Put the entries in bit-reversed order, so the butterflies can run in
+  // place
+  for (int i = 1, j = 0; i < n; i++)
+  {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+    {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j)
+    {
+      std::swap(data[i], data[j]);
+    }
+  }
+
+  const s_t pi = 3.14159265358979323846;
+  for (int len = 2; len <= n; len <<= 1)
+  {
+    s_t angle = 2 * pi / len * (inverse ? 1 : -1);
+    std::complex<s_t> step(std::cos(angle), std::sin(angle));
+    for (int i = 0; i < n; i += len)
+    {
+      std::complex<s_t> w(1, 0);
+      for (int k = 0; k < len / 2; k++)
+      {
+        std::complex<s_t> u = data[i + k];
+        std::complex<s_t> v = data[i + k + len / 2] * w;
+        data[i + k] = u + v;
+        data[i + k + len / 2] = u - v;
+        w *= step;
+      }
+    }
+  }
+
+  if (inverse)
+  {
+    for (std::complex<s_t>& x : data)
+    {
+      x /= (s_t)n;
+    }
+  }
+}
+
+//==============================================================================
+/// This returns the cross-correlation of two multi-channel signals, where
+/// each row is a channel and each column is a timestep, for every lag in
+/// [-maxLag, maxLag]. Entry `lag + maxLag` is the sum over channels and
+/// timesteps of a(t) * b(t - lag), divided by the number of overlapping
+/// timesteps.
+Eigen::VectorXs CrossCorrelation::crossCorrelate(
+    const Eigen::MatrixXs& a, const Eigen::MatrixXs& b, int maxLag)
+{
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(2 * maxLag + 1);
+  const int channels = std::min(a.rows(), b.rows());
+  const int lenA = a.cols();
+  const int lenB = b.cols();
+  if (channels == 0 || lenA == 0 || lenB == 0)
+    return result;
+
+  // Pad out far enough that the circular correlation doesn't wrap around
+  int n = 1;
+  while (n < lenA + lenB - 1)
+  {
+    n <<= 1;
+  }
+
+  // Correlation is linear, so we can sum the channels in the frequency domain
+  // and only run one inverse transform
+  std::vector<std::complex<s_t>> sum(n, std::complex<s_t>(0, 0));
+  std::vector<std::complex<s_t>> fa(n);
+  std::vector<std::complex<s_t>> fb(n);
+  for (int c = 0; c < channels; c++)
+  {
+    std::fill(fa.begin(), fa.end(), std::complex<s_t>(0, 0));
+    std::fill(fb.begin(), fb.end(), std::complex<s_t>(0, 0));
+    for (int t = 0; t < lenA; t++)
+    {
+      fa[t] = a(c, t);
+    }
+    for (int t = 0; t < lenB; t++)
+    {
+      fb[t] = b(c, t);
+    }
+    fft(fa);
+    fft(fb);
+    for (int i = 0; i < n; i++)
+    {
+      sum[i] += fa[i] * std::conj(fb[i]);
+    }
+  }
+  fft(sum, true);
+
+  // Entry m of the inverse is sum_t a(t + m) * b(t), with negative m wrapped
+  // around to the end
+  for (int lag = -maxLag; lag <= maxLag; lag++)
+  {
+    int overlap = std::min(lenA, lenB + lag) - std::max(0, lag);
+    if (overlap <= 0 || lag >= n || -lag >= n)
+      continue;
+    int index = lag >= 0 ? lag : n + lag;
+    result(lag + maxLag) = sum[index].real() / overlap;
+  }
+  return result;
+}
+
+//==============================================================================
+/// This returns the lag in [-maxLag, maxLag] that best lines `b` up with
+/// `a`, which is how far `b` would need to be shifted forward in time to
+/// match. This returns 0 if no lag is positively correlated.
+int CrossCorrelation::findBestLag(
+    const Eigen::MatrixXs& a, const Eigen::MatrixXs& b, int maxLag)
+{
+  Eigen::MatrixXs centeredA = a;
+  Eigen::MatrixXs centeredB = b;
+  if (a.cols() > 0)
+  {
+    centeredA.colwise() -= a.rowwise().mean();
+  }
+  if (b.cols() > 0)
+  {
+    centeredB.colwise() -= b.rowwise().mean();
+  }
+
+  Eigen::VectorXs correlation = crossCorrelate(centeredA, centeredB, maxLag);
+  int bestLag = 0;
+  s_t bestScore = 0;
+  // Ties go to the smallest shift
+  for (int i = 0; i <= maxLag; i++)
+  {
+    for (int lag : {i, -i})
+    {
+      if (correlation(lag + maxLag) > bestScore)
+      {
+        bestScore = correlation(lag + maxLag);
+        bestLag = lag;
+      }
+    }
+  }
+  return bestLag;
+}
+
+} // namespace math
+} // namespace dart
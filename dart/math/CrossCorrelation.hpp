@@ -0,0 +1,44 @@
+#ifndef MATH_CROSS_CORRELATION_H_
+#define MATH_CROSS_CORRELATION_H_
+
+#include <complex>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace math {
+
+class CrossCorrelation
+{
+public:
+  /// This runs an in-place radix-2 FFT over `data`, whose size must be a
+  /// power of two. If `inverse` is true, this runs the inverse transform,
+  /// including the 1/N scaling.
+  static void fft(std::vector<std::complex<s_t>>& data, bool inverse = false);
+
+  /// This returns the cross-correlation of two multi-channel signals, where
+  /// each row is a channel and each column is a timestep, for every lag in
+  /// [-maxLag, maxLag]. Entry `lag + maxLag` is the sum over channels and
+  /// timesteps of a(t) * b(t - lag), divided by the number of overlapping
+  /// timesteps, so a positive lag means `b` is running behind `a`. This is
+  /// computed with FFTs, so it's O(N log N) in the length of the signals,
+  /// rather than O(N * maxLag).
+  static Eigen::VectorXs crossCorrelate(
+      const Eigen::MatrixXs& a, const Eigen::MatrixXs& b, int maxLag);
+
+  /// This returns the lag in [-maxLag, maxLag] that best lines `b` up with
+  /// `a`, which is how far `b` would need to be shifted forward in time to
+  /// match. Each channel has its mean taken out first, so constant offsets
+  /// (like gravity) don't swamp the match. This returns 0 if no lag is
+  /// positively correlated.
+  static int findBestLag(
+      const Eigen::MatrixXs& a, const Eigen::MatrixXs& b, int maxLag);
+};
+
+} // namespace math
+} // namespace dart
+
+#endif
@@ -34,5 +34,13 @@ s_t CustomFunction::finiteDifferenceDerivative(int order, s_t x) const
   return result;
 }
 
+bool CustomFunction::toPiecewisePolynomial(
+    std::vector<s_t>& /* knots */,
+    std::vector<s_t>& /* coeffs */,
+    int& /* degree */) const
+{
+  return false;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef MATH_CUSTOMFN_H_
 #define MATH_CUSTOMFN_H_
 
+#include <memory>
+#include <vector>
+
 #include "dart/math/MathTypes.hpp"
 
 //=============================================================================
@@ -17,6 +20,16 @@ public:
   virtual s_t calcDerivative(int order, s_t x) const = 0;
   virtual std::shared_ptr<CustomFunction> offsetBy(s_t y) const = 0;
   s_t finiteDifferenceDerivative(int order, s_t x) const;
+
+  /// This writes this function out as a piecewise polynomial, if it can be
+  /// written that way, and returns false if it can't. Segment `i` starts at
+  /// `knots[i]`, and is the polynomial with the `degree + 1` coefficients
+  /// starting at `coeffs[i * (degree + 1)]`, lowest order first, in powers of
+  /// (x - knots[i]). The first segment also covers everything below
+  /// `knots[0]`, and the last one everything above its knot. This is what
+  /// CompiledCustomFunction is built from.
+  virtual bool toPiecewisePolynomial(
+      std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const;
 };
 
 } // namespace math
@@ -3,12 +3,50 @@
 #include <array>
 #include <exception>
 #include <iostream>
+#include <vector>
+
+#include "dart/common/TaskScheduler.hpp"
 
 using namespace dart;
 
 namespace dart {
 namespace math {
 
+//==============================================================================
+/// Runs central differences for the column `dof` of `result`
+void centralDifferenceColumn(
+    const std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)>& getPerturbed,
+    int dof,
+    Eigen::MatrixXs& result,
+    s_t eps)
+{
+  s_t epsPos = eps;
+  Eigen::VectorXs perturbedPlus;
+  // Get perturbed result with smaller and smaller eps until valid
+  while (!getPerturbed(epsPos, dof, perturbedPlus))
+  {
+    epsPos *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  s_t epsNeg = eps;
+  Eigen::VectorXs perturbedMinus;
+  while (!getPerturbed(-epsNeg, dof, perturbedMinus))
+  {
+    epsNeg *= 0.5;
+    if (abs(epsPos) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
+
+  // if this point is reached, getPerturbed should have produced valid results
+  Eigen::VectorXs grad = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
+  result.col(dof).noalias() = grad;
+}
+
 //==============================================================================
 void centralDifference(
     std::function<bool(
@@ -24,28 +62,7 @@ void centralDifference(
   // Run central differences for every column of the result separately
   for (std::size_t dof = 0; dof < result.cols(); dof++)
   {
-    s_t epsPos = eps;
-    Eigen::VectorXs perturbedPlus;
-    // Get perturbed result with smaller and smaller eps until valid
-    while (!getPerturbed(epsPos, dof, perturbedPlus))
-    {
-      epsPos *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    s_t epsNeg = eps;
-    Eigen::VectorXs perturbedMinus;
-    while (!getPerturbed(-epsNeg, dof, perturbedMinus))
-    {
-      epsNeg *= 0.5;
-      if (abs(epsPos) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
-
-    // if this point is reached, getPerturbed should have produced valid results
-    Eigen::VectorXs grad = (perturbedPlus - perturbedMinus) / (epsPos + epsNeg);
-    result.col(dof).noalias() = grad;
+    centralDifferenceColumn(getPerturbed, dof, result, eps);
   }
 
   return;
@@ -164,87 +181,100 @@ void centralDifference(
 }
 
 //==============================================================================
-void riddersMethod(
-    std::function<bool(
+/// Runs Ridders' method for the column `dof` of `result`. If a perturbation
+/// of `originalStepSize` is rejected, this shrinks it for later columns too.
+void riddersMethodColumn(
+    const std::function<bool(
         /* in*/ s_t eps,
         /* in*/ int dof,
-        /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
+        /*out*/ Eigen::VectorXs& perturbed)>& getPerturbed,
+    int dof,
     Eigen::MatrixXs& result,
-    s_t eps)
+    s_t& originalStepSize)
 {
-  if (result.size() == 0)
-    return;
-
-  s_t originalStepSize = eps;
   const s_t con = 1.4, con2 = (con * con);
   const s_t safeThreshold = 2.0;
   const int tabSize = 10;
 
-  // Run central differences for every column of the result separately
-  for (std::size_t dof = 0; dof < result.cols(); dof++)
+  // Neville tableau of finite difference results
+  std::array<std::array<Eigen::VectorXs, tabSize>, tabSize> tab;
+
+  // Get perturbed result with smaller and smaller eps until valid
+  // For Ridders we want the pos and neg epsilons to be the same.
+  Eigen::VectorXs perturbedPlus, perturbedMinus;
+  while (!getPerturbed(originalStepSize, dof, perturbedPlus)
+         || !getPerturbed(-originalStepSize, dof, perturbedMinus))
   {
-    // Neville tableau of finite difference results
-    std::array<std::array<Eigen::VectorXs, tabSize>, tabSize> tab;
+    originalStepSize *= 0.5;
+    if (abs(originalStepSize) <= 1e-20)
+      throw non_differentiable_point_exception();
+  }
 
-    // Get perturbed result with smaller and smaller eps until valid
-    // For Ridders we want the pos and neg epsilons to be the same.
-    Eigen::VectorXs perturbedPlus, perturbedMinus;
-    while (!getPerturbed(originalStepSize, dof, perturbedPlus)
-           || !getPerturbed(-originalStepSize, dof, perturbedMinus))
-    {
-      originalStepSize *= 0.5;
-      if (abs(originalStepSize) <= 1e-20)
-        throw non_differentiable_point_exception();
-    }
+  // if this point is reached, getPerturbed should have produced valid results
+  tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
 
-    // if this point is reached, getPerturbed should have produced valid results
-    tab[0][0] = (perturbedPlus - perturbedMinus) / (2 * originalStepSize);
+  s_t stepSize = originalStepSize;
+  s_t bestError = std::numeric_limits<s_t>::max();
 
-    s_t stepSize = originalStepSize;
-    s_t bestError = std::numeric_limits<s_t>::max();
+  // Iterate over smaller and smaller step sizes
+  for (int iTab = 1; iTab < tabSize; iTab++)
+  {
+    stepSize /= con;
 
-    // Iterate over smaller and smaller step sizes
-    for (int iTab = 1; iTab < tabSize; iTab++)
+    if (!getPerturbed(stepSize, dof, perturbedPlus)
+        || !getPerturbed(-stepSize, dof, perturbedMinus))
     {
-      stepSize /= con;
-
-      if (!getPerturbed(stepSize, dof, perturbedPlus)
-          || !getPerturbed(-stepSize, dof, perturbedMinus))
-      {
-        throw ridders_invalid_state_exception();
-      }
+      throw ridders_invalid_state_exception();
+    }
 
-      tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
+    tab[0][iTab] = (perturbedPlus - perturbedMinus) / (2 * stepSize);
 
-      s_t fac = con2;
-      // Compute extrapolations of increasing orders, requiring no new
-      // evaluations
-      for (int jTab = 1; jTab <= iTab; jTab++)
+    s_t fac = con2;
+    // Compute extrapolations of increasing orders, requiring no new
+    // evaluations
+    for (int jTab = 1; jTab <= iTab; jTab++)
+    {
+      tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
+                        / (fac - 1.0);
+      fac = con2 * fac;
+      s_t currError = max(
+          (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
+          (tab[jTab][iTab] - tab[jTab - 1][iTab - 1]).array().abs().maxCoeff());
+      if (currError < bestError)
       {
-        tab[jTab][iTab] = (tab[jTab - 1][iTab] * fac - tab[jTab - 1][iTab - 1])
-                          / (fac - 1.0);
-        fac = con2 * fac;
-        s_t currError = max(
-            (tab[jTab][iTab] - tab[jTab - 1][iTab]).array().abs().maxCoeff(),
-            (tab[jTab][iTab] - tab[jTab - 1][iTab - 1])
-                .array()
-                .abs()
-                .maxCoeff());
-        if (currError < bestError)
-        {
-          bestError = currError;
-          result.col(dof).noalias() = tab[jTab][iTab];
-        }
+        bestError = currError;
+        result.col(dof).noalias() = tab[jTab][iTab];
       }
+    }
 
-      // If higher order is worse by a significant factor, quit early.
-      if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
-          >= safeThreshold * bestError)
-      {
-        break;
-      }
+    // If higher order is worse by a significant factor, quit early.
+    if ((tab[iTab][iTab] - tab[iTab - 1][iTab - 1]).array().abs().maxCoeff()
+        >= safeThreshold * bestError)
+    {
+      break;
     }
   }
+}
+
+//==============================================================================
+void riddersMethod(
+    std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
+    Eigen::MatrixXs& result,
+    s_t eps)
+{
+  if (result.size() == 0)
+    return;
+
+  s_t originalStepSize = eps;
+
+  // Run central differences for every column of the result separately
+  for (std::size_t dof = 0; dof < result.cols(); dof++)
+  {
+    riddersMethodColumn(getPerturbed, dof, result, originalStepSize);
+  }
 
   return;
 }
@@ -515,6 +545,81 @@ void finiteDifference(
   return;
 }
 
+//==============================================================================
+void parallelFiniteDifference(
+    std::function<std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)>()> makeGetPerturbed,
+    Eigen::MatrixXs& result,
+    s_t eps,
+    bool useRidders,
+    int numThreads)
+{
+  if (result.size() == 0)
+    return;
+
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  const int numCols = result.cols();
+  numThreads = std::max(1, std::min(numThreads, numCols));
+
+  if (numThreads == 1)
+  {
+    finiteDifference(makeGetPerturbed(), result, eps, useRidders);
+    return;
+  }
+
+  // Making the getPerturbed functions usually means cloning state, which we
+  // don't assume is safe to do from several threads at once
+  std::vector<std::function<bool(s_t, int, Eigen::VectorXs&)>> getPerturbed;
+  getPerturbed.reserve(numThreads);
+  for (int thread = 0; thread < numThreads; thread++)
+    getPerturbed.push_back(makeGetPerturbed());
+
+  // Each thread writes its own contiguous block of columns
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(numThreads);
+  for (int thread = 0; thread < numThreads; thread++)
+  {
+    const int begin = numCols * thread / numThreads;
+    const int end = numCols * (thread + 1) / numThreads;
+    futures.push_back(common::async([&, thread, begin, end]() {
+      s_t originalStepSize = eps;
+      for (int dof = begin; dof < end; dof++)
+      {
+        if (useRidders)
+        {
+          riddersMethodColumn(
+              getPerturbed[thread], dof, result, originalStepSize);
+        }
+        else
+        {
+          centralDifferenceColumn(getPerturbed[thread], dof, result, eps);
+        }
+      }
+    }));
+  }
+
+  // Wait on every thread before rethrowing, since they all refer to our
+  // locals
+  std::exception_ptr error;
+  for (common::TaskFuture<void>& future : futures)
+  {
+    try
+    {
+      future.get();
+    }
+    catch (...)
+    {
+      if (!error)
+        error = std::current_exception();
+    }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
 //==============================================================================
 template <class T>
 void finiteDifference(
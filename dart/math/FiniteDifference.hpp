@@ -26,6 +26,27 @@ void finiteDifference(
     s_t eps = 1e-7,
     bool useRidders = false);
 
+/// Finite differences a vector function like the version above, but splits
+/// the columns of `result` across up to `numThreads` threads (<= 0 means as
+/// many as the global common::TaskScheduler has). Perturbing usually mutates
+/// some shared state (a World, say), so rather than one getPerturbed this
+/// takes `makeGetPerturbed`, which is called once per thread, on the calling
+/// thread, and must return a getPerturbed that only touches state of its own.
+///
+/// Every column goes through exactly the same steps as it would serially, so
+/// the results are identical. The one exception is that when a perturbation
+/// is rejected and Ridders' method shrinks its step, the smaller step only
+/// carries on to later columns on the same thread.
+void parallelFiniteDifference(
+    std::function<std::function<bool(
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)>()> makeGetPerturbed,
+    Eigen::MatrixXs& result,
+    s_t eps = 1e-7,
+    bool useRidders = false,
+    int numThreads = 0);
+
 /// Finite differences a scalar function, iterating and perturbing
 /// the partial derivatives w.r.t the input DOFs one by one.
 /// Note that if using Ridders, epsilon should be very large, >=1e-4
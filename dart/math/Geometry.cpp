@@ -3511,6 +3511,305 @@ Eigen::Vector6s dad(const Eigen::Vector6s& _s, const Eigen::Vector6s& _t)
   return res;
 }
 
+//==============================================================================
+using BatchArray = Eigen::Array<s_t, Eigen::Dynamic, 1>;
+
+/// This fills the first 9 columns of _out with the rotation part of expMap()
+/// or expAngular(), given the coefficients computed for each element
+template <typename W, typename Out>
+static void fillExpMapRotationBatch(
+    const W& w0,
+    const W& w1,
+    const W& w2,
+    const BatchArray& alpha,
+    const BatchArray& beta,
+    const BatchArray& cos_t,
+    Out& _out)
+{
+  _out.col(0).array() = beta * w0.square() + cos_t;
+  _out.col(1).array() = beta * w0 * w1 + alpha * w2;
+  _out.col(2).array() = beta * w2 * w0 - alpha * w1;
+
+  _out.col(3).array() = beta * w0 * w1 - alpha * w2;
+  _out.col(4).array() = beta * w1.square() + cos_t;
+  _out.col(5).array() = beta * w1 * w2 + alpha * w0;
+
+  _out.col(6).array() = beta * w2 * w0 + alpha * w1;
+  _out.col(7).array() = beta * w1 * w2 - alpha * w0;
+  _out.col(8).array() = beta * w2.square() + cos_t;
+}
+
+/// This is the rotation part shared by expAngularBatch() and
+/// expMapDartBatch(), which read the angular part from columns 0-2 of _s
+template <typename In, typename Out>
+static void expAngularBatchImpl(const In& _s, Out& _out)
+{
+  const auto w0 = _s.col(0).array();
+  const auto w1 = _s.col(1).array();
+  const auto w2 = _s.col(2).array();
+
+  const BatchArray theta2 = w0.square() + w1.square() + w2.square();
+  const BatchArray theta = theta2.sqrt();
+  const BatchArray cos_t = theta.cos();
+  const auto big = theta > DART_EPSILON;
+  const BatchArray alpha = big.select(theta.sin() / theta, 1.0 - theta2 / 6.0);
+  const BatchArray beta
+      = big.select((1.0 - cos_t) / theta2, 0.5 - theta2 / 24.0);
+
+  fillExpMapRotationBatch(w0, w1, w2, alpha, beta, cos_t, _out);
+}
+
+//==============================================================================
+void expMapBatch(const TwistBatch& _S, TransformBatch& _out)
+{
+  _out.resize(_S.rows(), 12);
+
+  const auto w0 = _S.col(0).array();
+  const auto w1 = _S.col(1).array();
+  const auto w2 = _S.col(2).array();
+  const auto v0 = _S.col(3).array();
+  const auto v1 = _S.col(4).array();
+  const auto v2 = _S.col(5).array();
+
+  const BatchArray theta2 = w0.square() + w1.square() + w2.square();
+  const BatchArray theta = theta2.sqrt();
+  const BatchArray cos_t = theta.cos();
+  const BatchArray sin_t = theta.sin();
+  const BatchArray wv = w0 * v0 + w1 * v1 + w2 * v2;
+  const auto big = theta > DART_EPSILON;
+  const BatchArray alpha = big.select(sin_t / theta, 1.0 - theta2 / 6.0);
+  const BatchArray beta
+      = big.select((1.0 - cos_t) / theta2, 0.5 - theta2 / 24.0);
+  const BatchArray gamma = big.select(
+      wv * (theta - sin_t) / (theta2 * theta), wv / 6.0 - theta2 / 120.0);
+
+  fillExpMapRotationBatch(w0, w1, w2, alpha, beta, cos_t, _out);
+
+  _out.col(9).array() = alpha * v0 + beta * (w1 * v2 - w2 * v1) + gamma * w0;
+  _out.col(10).array() = alpha * v1 + beta * (w2 * v0 - w0 * v2) + gamma * w1;
+  _out.col(11).array() = alpha * v2 + beta * (w0 * v1 - w1 * v0) + gamma * w2;
+}
+
+//==============================================================================
+void expAngularBatch(const Vector3Batch& _s, RotationBatch& _out)
+{
+  _out.resize(_s.rows(), 9);
+  expAngularBatchImpl(_s, _out);
+}
+
+//==============================================================================
+void expMapDartBatch(const TwistBatch& _S, TransformBatch& _out)
+{
+  _out.resize(_S.rows(), 12);
+  expAngularBatchImpl(_S, _out);
+  _out.rightCols<3>() = _S.rightCols<3>();
+}
+
+//==============================================================================
+void eulerXYZToMatrixBatch(const Vector3Batch& _angle, RotationBatch& _out)
+{
+  _out.resize(_angle.rows(), 9);
+
+  // See eulerXYZToMatrix()
+  const BatchArray cx = _angle.col(0).array().cos();
+  const BatchArray sx = _angle.col(0).array().sin();
+  const BatchArray cy = _angle.col(1).array().cos();
+  const BatchArray sy = _angle.col(1).array().sin();
+  const BatchArray cz = _angle.col(2).array().cos();
+  const BatchArray sz = _angle.col(2).array().sin();
+
+  _out.col(0).array() = cy * cz;
+  _out.col(1).array() = cx * sz + cz * sx * sy;
+  _out.col(2).array() = sx * sz - cx * cz * sy;
+
+  _out.col(3).array() = -cy * sz;
+  _out.col(4).array() = cx * cz - sx * sy * sz;
+  _out.col(5).array() = cz * sx + cx * sy * sz;
+
+  _out.col(6).array() = sy;
+  _out.col(7).array() = -cy * sx;
+  _out.col(8).array() = cx * cy;
+}
+
+//==============================================================================
+void eulerXYZToMatrixGradBatch(
+    const Vector3Batch& _angle, int index, RotationBatch& _out)
+{
+  _out.resize(_angle.rows(), 9);
+
+  // See eulerXYZToMatrixGrad()
+  const BatchArray cx = _angle.col(0).array().cos();
+  const BatchArray sx = _angle.col(0).array().sin();
+  const BatchArray cy = _angle.col(1).array().cos();
+  const BatchArray sy = _angle.col(1).array().sin();
+  const BatchArray cz = _angle.col(2).array().cos();
+  const BatchArray sz = _angle.col(2).array().sin();
+
+  if (index == 0)
+  {
+    _out.col(0).setZero();
+    _out.col(1).array() = -sx * sz + cz * cx * sy;
+    _out.col(2).array() = cx * sz + sx * cz * sy;
+
+    _out.col(3).setZero();
+    _out.col(4).array() = -sx * cz - cx * sy * sz;
+    _out.col(5).array() = cz * cx - sx * sy * sz;
+
+    _out.col(6).setZero();
+    _out.col(7).array() = -cy * cx;
+    _out.col(8).array() = -sx * cy;
+  }
+  else if (index == 1)
+  {
+    _out.col(0).array() = -sy * cz;
+    _out.col(1).array() = cz * sx * cy;
+    _out.col(2).array() = -cx * cz * cy;
+
+    _out.col(3).array() = sy * sz;
+    _out.col(4).array() = -sx * cy * sz;
+    _out.col(5).array() = cx * cy * sz;
+
+    _out.col(6).array() = cy;
+    _out.col(7).array() = sy * sx;
+    _out.col(8).array() = -cx * sy;
+  }
+  else if (index == 2)
+  {
+    _out.col(0).array() = -cy * sz;
+    _out.col(1).array() = cx * cz - sz * sx * sy;
+    _out.col(2).array() = sx * cz + cx * sz * sy;
+
+    _out.col(3).array() = -cy * cz;
+    _out.col(4).array() = -cx * sz - sx * sy * cz;
+    _out.col(5).array() = -sz * sx + cx * sy * cz;
+
+    _out.col(6).setZero();
+    _out.col(7).setZero();
+    _out.col(8).setZero();
+  }
+}
+
+//==============================================================================
+void AdTBatch(const TransformBatch& _T, const TwistBatch& _V, TwistBatch& _out)
+{
+  assert(_T.rows() == _V.rows());
+
+  // See AdT(). R(r, c) lives in column r + 3 * c of _T.
+  const auto R = [&_T](int r, int c) { return _T.col(r + 3 * c).array(); };
+  const auto p0 = _T.col(9).array();
+  const auto p1 = _T.col(10).array();
+  const auto p2 = _T.col(11).array();
+  const auto w0 = _V.col(0).array();
+  const auto w1 = _V.col(1).array();
+  const auto w2 = _V.col(2).array();
+  const auto v0 = _V.col(3).array();
+  const auto v1 = _V.col(4).array();
+  const auto v2 = _V.col(5).array();
+
+  // Work in temporaries, so that _out may alias _V
+  const BatchArray Rw0 = R(0, 0) * w0 + R(0, 1) * w1 + R(0, 2) * w2;
+  const BatchArray Rw1 = R(1, 0) * w0 + R(1, 1) * w1 + R(1, 2) * w2;
+  const BatchArray Rw2 = R(2, 0) * w0 + R(2, 1) * w1 + R(2, 2) * w2;
+  const BatchArray Rv0 = R(0, 0) * v0 + R(0, 1) * v1 + R(0, 2) * v2;
+  const BatchArray Rv1 = R(1, 0) * v0 + R(1, 1) * v1 + R(1, 2) * v2;
+  const BatchArray Rv2 = R(2, 0) * v0 + R(2, 1) * v1 + R(2, 2) * v2;
+
+  _out.resize(_T.rows(), 6);
+  _out.col(0).array() = Rw0;
+  _out.col(1).array() = Rw1;
+  _out.col(2).array() = Rw2;
+  _out.col(3).array() = Rv0 + p1 * Rw2 - p2 * Rw1;
+  _out.col(4).array() = Rv1 + p2 * Rw0 - p0 * Rw2;
+  _out.col(5).array() = Rv2 + p0 * Rw1 - p1 * Rw0;
+}
+
+//==============================================================================
+void dAdTBatch(const TransformBatch& _T, const TwistBatch& _F, TwistBatch& _out)
+{
+  assert(_T.rows() == _F.rows());
+
+  // See dAdT(). R(r, c) lives in column r + 3 * c of _T.
+  const auto R = [&_T](int r, int c) { return _T.col(r + 3 * c).array(); };
+  const auto p0 = _T.col(9).array();
+  const auto p1 = _T.col(10).array();
+  const auto p2 = _T.col(11).array();
+  const auto f0 = _F.col(3).array();
+  const auto f1 = _F.col(4).array();
+  const auto f2 = _F.col(5).array();
+
+  // m + f x p
+  const BatchArray m0 = _F.col(0).array() + f1 * p2 - f2 * p1;
+  const BatchArray m1 = _F.col(1).array() + f2 * p0 - f0 * p2;
+  const BatchArray m2 = _F.col(2).array() + f0 * p1 - f1 * p0;
+  // R^T * f, computed before _out is written in case it aliases _F
+  const BatchArray Rf0 = R(0, 0) * f0 + R(1, 0) * f1 + R(2, 0) * f2;
+  const BatchArray Rf1 = R(0, 1) * f0 + R(1, 1) * f1 + R(2, 1) * f2;
+  const BatchArray Rf2 = R(0, 2) * f0 + R(1, 2) * f1 + R(2, 2) * f2;
+
+  _out.resize(_T.rows(), 6);
+  _out.col(0).array() = R(0, 0) * m0 + R(1, 0) * m1 + R(2, 0) * m2;
+  _out.col(1).array() = R(0, 1) * m0 + R(1, 1) * m1 + R(2, 1) * m2;
+  _out.col(2).array() = R(0, 2) * m0 + R(1, 2) * m1 + R(2, 2) * m2;
+  _out.col(3).array() = Rf0;
+  _out.col(4).array() = Rf1;
+  _out.col(5).array() = Rf2;
+}
+
+//==============================================================================
+void adBatch(const TwistBatch& _X, const TwistBatch& _Y, TwistBatch& _out)
+{
+  assert(_X.rows() == _Y.rows());
+
+  // See ad()
+  const auto a0 = _X.col(0).array();
+  const auto a1 = _X.col(1).array();
+  const auto a2 = _X.col(2).array();
+  const auto b0 = _X.col(3).array();
+  const auto b1 = _X.col(4).array();
+  const auto b2 = _X.col(5).array();
+  const auto c0 = _Y.col(0).array();
+  const auto c1 = _Y.col(1).array();
+  const auto c2 = _Y.col(2).array();
+  const auto d0 = _Y.col(3).array();
+  const auto d1 = _Y.col(4).array();
+  const auto d2 = _Y.col(5).array();
+
+  // Work in temporaries, so that _out may alias _X or _Y
+  const BatchArray w0 = a1 * c2 - a2 * c1;
+  const BatchArray w1 = a2 * c0 - a0 * c2;
+  const BatchArray w2 = a0 * c1 - a1 * c0;
+  const BatchArray v0 = a1 * d2 - a2 * d1 + b1 * c2 - b2 * c1;
+  const BatchArray v1 = a2 * d0 - a0 * d2 + b2 * c0 - b0 * c2;
+  const BatchArray v2 = a0 * d1 - a1 * d0 + b0 * c1 - b1 * c0;
+
+  _out.resize(_X.rows(), 6);
+  _out.col(0).array() = w0;
+  _out.col(1).array() = w1;
+  _out.col(2).array() = w2;
+  _out.col(3).array() = v0;
+  _out.col(4).array() = v1;
+  _out.col(5).array() = v2;
+}
+
+//==============================================================================
+Eigen::Isometry3s getBatchTransform(const TransformBatch& _T, int i)
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  for (int k = 0; k < 9; k++)
+    T.linear()(k % 3, k / 3) = _T(i, k);
+  T.translation() = _T.row(i).tail<3>().transpose();
+  return T;
+}
+
+//==============================================================================
+void setBatchTransform(
+    TransformBatch& _batch, int i, const Eigen::Isometry3s& _T)
+{
+  for (int k = 0; k < 9; k++)
+    _batch(i, k) = _T.linear()(k % 3, k / 3);
+  _batch.row(i).tail<3>() = _T.translation().transpose();
+}
+
 Inertia transformInertia(const Eigen::Isometry3s& _T, const Inertia& _I)
 {
   // operation count: multiplication = 186, addition = 117, subtract = 21
@@ -687,6 +687,46 @@ Eigen::Matrix6s adMatrix(const Eigen::Vector6s& X);
 /// , where @f$F=(m,f)@in se^{@,*}(3), @quad V=(w,v)@in se(3) @f$.
 Eigen::Vector6s dad(const Eigen::Vector6s& _s, const Eigen::Vector6s& _t);
 
+//------------------------------------------------------------------------------
+// Batched kernels. These compute the same thing as the functions above for a
+// whole batch at once, using Eigen array expressions over each coordinate so
+// that sin(), cos() and the arithmetic run in SIMD lanes. The outputs are
+// resized to match the inputs.
+//------------------------------------------------------------------------------
+
+/// Batched expMap()
+void expMapBatch(const TwistBatch& _S, TransformBatch& _out);
+
+/// Batched expAngular()
+void expAngularBatch(const Vector3Batch& _s, RotationBatch& _out);
+
+/// Batched expMapDart()
+void expMapDartBatch(const TwistBatch& _S, TransformBatch& _out);
+
+/// Batched eulerXYZToMatrix()
+void eulerXYZToMatrixBatch(const Vector3Batch& _angle, RotationBatch& _out);
+
+/// Batched eulerXYZToMatrixGrad()
+void eulerXYZToMatrixGradBatch(
+    const Vector3Batch& _angle, int index, RotationBatch& _out);
+
+/// Batched AdT(), where row i of _V is transformed by row i of _T
+void AdTBatch(const TransformBatch& _T, const TwistBatch& _V, TwistBatch& _out);
+
+/// Batched dAdT(), where row i of _F is transformed by row i of _T
+void dAdTBatch(
+    const TransformBatch& _T, const TwistBatch& _F, TwistBatch& _out);
+
+/// Batched ad(), applied row by row
+void adBatch(const TwistBatch& _X, const TwistBatch& _Y, TwistBatch& _out);
+
+/// Reads row i of a TransformBatch back into an Isometry3s
+Eigen::Isometry3s getBatchTransform(const TransformBatch& _T, int i);
+
+/// Writes _T into row i of a TransformBatch
+void setBatchTransform(
+    TransformBatch& _batch, int i, const Eigen::Isometry3s& _T);
+
 /// \brief
 Inertia transformInertia(const Eigen::Isometry3s& _T, const Inertia& _AI);
 
@@ -2,13 +2,17 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/math/MathTypes.hpp"
@@ -23,6 +27,7 @@ IKConfig::IKConfig()
     leastSquaresDamping(0.01),
     maxRestarts(5),
     lossLowerBound(1e-10),
+    restartPruneRatio(0),
     startClamped(false),
     lineSearch(true),
     logOutput(false)
@@ -59,6 +64,12 @@ IKConfig& IKConfig::setLossLowerBound(s_t v)
   return *this;
 }
 
+IKConfig& IKConfig::setRestartPruneRatio(s_t v)
+{
+  restartPruneRatio = v;
+  return *this;
+}
+
 IKConfig& IKConfig::setStartClamped(bool v)
 {
   startClamped = v;
@@ -95,6 +106,35 @@ IKConfig& IKConfig::setOutputNames(const std::vector<std::string>& v)
   return *this;
 }
 
+namespace {
+
+// The random restarts only get this many steps each, to gauge which one seems
+// most promising
+constexpr int kRestartTrialSteps = 20;
+
+// This is refineIK(), except that `shouldAbandon(step, loss)` gets called on
+// every step, and the search stops as soon as it returns true
+IKResult refineIKWithEarlyExit(
+    const Eigen::VectorXs& initialPos,
+    int targetSize,
+    const std::function<Eigen::VectorXs(const Eigen::VectorXs&, bool)>&
+        setPosAndClamp,
+    const std::function<void(
+        Eigen::Ref<Eigen::VectorXs>, Eigen::Ref<Eigen::MatrixXs>)>& eval,
+    const IKConfig& config,
+    const std::function<bool(int, s_t)>& shouldAbandon);
+
+// This returns true if a restart at `step` of its trial steps, with loss
+// `loss`, is hopeless compared to the best loss found so far
+bool isRestartHopeless(
+    const IKConfig& config, int step, s_t loss, s_t bestError)
+{
+  return config.restartPruneRatio > 0 && step >= kRestartTrialSteps / 2
+         && loss > config.restartPruneRatio * bestError;
+}
+
+} // namespace
+
 void verifyJacobian(
     const Eigen::VectorXs& originalPos,
     const Eigen::VectorXs& upperBound,
@@ -221,8 +261,8 @@ s_t solveIK(
 
   Eigen::VectorXs pos = setPosAndClamp(initialPos, config.startClamped);
 
-  // For each of the restarts, only do 20 steps, to gauge which one seems most
-  // promising
+  // For each of the restarts, only do a few steps, to gauge which one seems
+  // most promising
   for (int k = 0; k < config.maxRestarts; k++)
   {
     if (k > 0)
@@ -236,14 +276,15 @@ s_t solveIK(
       }
     }
 
-    IKResult result = refineIK(
+    IKResult result = refineIKWithEarlyExit(
         pos,
-        upperBound,
-        lowerBound,
         targetSize,
         setPosAndClamp,
         eval,
-        IKConfig(config).setMaxStepCount(20));
+        IKConfig(config).setMaxStepCount(kRestartTrialSteps),
+        [&config, &bestError](int step, s_t loss) {
+          return isRestartHopeless(config, step, loss, bestError);
+        });
 
     if (result.loss < bestError && result.clamped)
     {
@@ -285,6 +326,135 @@ s_t solveIK(
   return bestError;
 }
 
+s_t solveIKParallel(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    std::function<IKCallbacks(int worker)> createCallbacks,
+    int numThreads,
+    IKConfig config)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::max(1, std::min(numThreads, config.maxRestarts));
+
+  std::vector<IKCallbacks> workers;
+  for (int i = 0; i < numThreads; i++)
+  {
+    workers.push_back(createCallbacks(i));
+  }
+
+  // Everything below is shared between the workers. Restarts are handed out
+  // in order from `nextRestart`, and the best result so far is guarded by
+  // `bestMutex`.
+  std::mutex bestMutex;
+  s_t bestError = std::numeric_limits<s_t>::infinity();
+  int bestRestart = -1;
+  Eigen::VectorXs bestResult = initialPos;
+  std::atomic<int> nextRestart(0);
+  std::atomic<bool> satisfied(false);
+
+  auto readBestError = [&bestMutex, &bestError]() {
+    std::lock_guard<std::mutex> lock(bestMutex);
+    return bestError;
+  };
+
+  auto runWorker = [&](int workerIdx) {
+    IKCallbacks& callbacks = workers[workerIdx];
+    Eigen::VectorXs pos = initialPos;
+    while (!satisfied)
+    {
+      int k = nextRestart++;
+      if (k >= config.maxRestarts)
+      {
+        break;
+      }
+      if (k == 0)
+      {
+        pos = callbacks.setPosAndClamp(initialPos, config.startClamped);
+      }
+      else
+      {
+        callbacks.getRandomRestart(pos);
+        pos = callbacks.setPosAndClamp(pos, true);
+      }
+
+      IKResult result = refineIKWithEarlyExit(
+          pos,
+          targetSize,
+          callbacks.setPosAndClamp,
+          callbacks.eval,
+          IKConfig(config)
+              .setMaxStepCount(kRestartTrialSteps)
+              .setLogOutput(false),
+          [&config, &satisfied, &readBestError](int step, s_t loss) {
+            return satisfied
+                   || (config.restartPruneRatio > 0
+                       && isRestartHopeless(
+                           config, step, loss, readBestError()));
+          });
+
+      std::lock_guard<std::mutex> lock(bestMutex);
+      // Break ties towards earlier restarts, so that the result doesn't
+      // depend on thread timing unless we terminate early
+      if (result.clamped
+          && (result.loss < bestError
+              || (result.loss == bestError && k < bestRestart)))
+      {
+        bestError = result.loss;
+        bestRestart = k;
+        bestResult = result.pos;
+        if (result.loss <= config.lossLowerBound)
+        {
+          satisfied = true;
+        }
+      }
+    }
+  };
+
+  std::vector<common::TaskFuture<void>> futures;
+  for (int i = 1; i < numThreads; i++)
+  {
+    futures.push_back(common::async(runWorker, i));
+  }
+  runWorker(0);
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  if (config.logOutput && satisfied)
+  {
+    std::cout << "Terminating random restarts early, because restart "
+              << bestRestart << " found a loss " << bestError
+              << " <= " << config.lossLowerBound
+              << " that satisfies or exceeds the loss lower-bound we were "
+                 "expecting."
+              << std::endl;
+  }
+
+  // For the best restart, run the remainder of the steps to further refine the
+  // IK solution
+  workers[0].setPosAndClamp(bestResult, true);
+  refineIK(
+      bestResult,
+      upperBound,
+      lowerBound,
+      targetSize,
+      workers[0].setPosAndClamp,
+      workers[0].eval,
+      config);
+
+  if (config.logOutput)
+  {
+    std::cout << "Finished IK search with loss: " << bestError << std::endl;
+  }
+  return bestError;
+}
+
 IKResult refineIK(
     const Eigen::VectorXs& initialPos,
     const Eigen::VectorXs& upperBound,
@@ -300,6 +470,22 @@ IKResult refineIK(
   (void)upperBound;
   (void)lowerBound;
 
+  return refineIKWithEarlyExit(
+      initialPos, targetSize, setPosAndClamp, eval, config, nullptr);
+}
+
+namespace {
+
+IKResult refineIKWithEarlyExit(
+    const Eigen::VectorXs& initialPos,
+    int targetSize,
+    const std::function<Eigen::VectorXs(const Eigen::VectorXs&, bool)>&
+        setPosAndClamp,
+    const std::function<void(
+        Eigen::Ref<Eigen::VectorXs>, Eigen::Ref<Eigen::MatrixXs>)>& eval,
+    const IKConfig& config,
+    const std::function<bool(int, s_t)>& shouldAbandon)
+{
   Eigen::VectorXs pos = initialPos;
 
   // Allocate these values once, to re-use in the inner loop
@@ -429,6 +615,16 @@ IKResult refineIK(
 
     lastError = currentError;
 
+    if (shouldAbandon && shouldAbandon(i, currentError))
+    {
+      if (config.logOutput)
+      {
+        std::cout << "Abandoning IK search after " << i
+                  << " iterations with loss: " << currentError << std::endl;
+      }
+      break;
+    }
+
     /////////////////////////////////////////////////////////////////////////////
     // Do the actual IK update
     /////////////////////////////////////////////////////////////////////////////
@@ -482,5 +678,7 @@ IKResult refineIK(
   return result;
 }
 
+} // namespace
+
 } // namespace math
 } // namespace dart
@@ -21,6 +21,7 @@ struct IKConfig
   IKConfig& setLeastSquaresDamping(s_t v);
   IKConfig& setMaxRestarts(int v);
   IKConfig& setLossLowerBound(s_t v);
+  IKConfig& setRestartPruneRatio(s_t v);
   IKConfig& setStartClamped(bool v);
   IKConfig& setDontExitTranspose(bool v);
   IKConfig& setLineSearch(bool v);
@@ -33,6 +34,10 @@ struct IKConfig
   s_t leastSquaresDamping = 0.01;
   int maxRestarts = 5;
   s_t lossLowerBound = 0;
+  // If this is > 0, a random restart gets abandoned part way through its
+  // trial steps if its loss is still worse than this multiple of the best
+  // loss any restart has found so far
+  s_t restartPruneRatio = 0;
   bool startClamped = false;
   bool dontExitTranspose = false;
   bool lineSearch = true;
@@ -48,6 +53,22 @@ struct IKResult
   bool clamped;
 };
 
+/// These are the callbacks for running IK on one copy of the problem. For
+/// solveIKParallel(), each worker thread gets its own set, so that they can
+/// each pose their own copy of the skeleton (or whatever else is being fit).
+struct IKCallbacks
+{
+  std::function<Eigen::VectorXs(
+      /* in*/ const Eigen::VectorXs& pos, bool clamp)>
+      setPosAndClamp;
+  std::function<void(
+      /*out*/ Eigen::Ref<Eigen::VectorXs> diff,
+      /*out*/ Eigen::Ref<Eigen::MatrixXs> jac)>
+      eval;
+  std::function<void(/*out*/ Eigen::Ref<Eigen::VectorXs> pos)>
+      getRandomRestart;
+};
+
 void verifyJacobian(
     const Eigen::VectorXs& atPos,
     const Eigen::VectorXs& upperBound,
@@ -74,6 +95,22 @@ s_t solveIK(
         getRandomRestart,
     IKConfig config = IKConfig());
 
+/// This is the same search as solveIK(), except that the random restarts are
+/// run concurrently on `numThreads` workers (<= 0 means one per hardware
+/// thread). `createCallbacks(i)` is called once per worker, on the calling
+/// thread, before any work starts. As soon as any restart reaches
+/// `config.lossLowerBound`, the rest are cancelled. The final refinement of
+/// the best restart runs on worker 0's callbacks, so that's the copy of the
+/// problem that's left posed at the solution.
+s_t solveIKParallel(
+    const Eigen::VectorXs& initialPos,
+    const Eigen::VectorXs& upperBound,
+    const Eigen::VectorXs& lowerBound,
+    int targetSize,
+    std::function<IKCallbacks(int worker)> createCallbacks,
+    int numThreads = -1,
+    IKConfig config = IKConfig());
+
 IKResult refineIK(
     const Eigen::VectorXs& initialPos,
     const Eigen::VectorXs& upperBound,
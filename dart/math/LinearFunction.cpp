@@ -27,5 +27,14 @@ std::shared_ptr<CustomFunction> LinearFunction::offsetBy(s_t y) const
   return std::make_shared<LinearFunction>(mSlope, mYIntercept + y);
 }
 
+bool LinearFunction::toPiecewisePolynomial(
+    std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const
+{
+  knots.assign(1, 0.0);
+  coeffs = {mYIntercept, mSlope};
+  degree = 1;
+  return true;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
@@ -15,6 +15,10 @@ public:
   s_t calcValue(s_t x) const override;
   s_t calcDerivative(int order, s_t x) const override;
   std::shared_ptr<CustomFunction> offsetBy(s_t y) const override;
+  bool toPiecewisePolynomial(
+      std::vector<s_t>& knots,
+      std::vector<s_t>& coeffs,
+      int& degree) const override;
 
 public:
   s_t mSlope;
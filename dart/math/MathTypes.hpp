@@ -50,7 +50,11 @@
 #include "mpreal.h"
 typedef mpfr::mpreal s_t;
 #else
+#ifdef DART_USE_FLOAT32
+typedef float s_t;
+#else
 typedef double s_t;
+#endif
 using std::abs;
 using std::acos;
 using std::asin;
@@ -160,6 +164,15 @@ using LinearJacobian = Eigen::Matrix<s_t, 3, Eigen::Dynamic>;
 using AngularJacobian = Eigen::Matrix<s_t, 3, Eigen::Dynamic>;
 using Jacobian = Eigen::Matrix<s_t, 6, Eigen::Dynamic>;
 
+/// Batches for the *Batch() kernels in Geometry.hpp. Row i holds element i of
+/// the batch, so (since Eigen is column-major) each coordinate is contiguous
+/// in memory across the whole batch. Transforms store the column-major 3x3
+/// rotation followed by the translation, and rotations just the first 9.
+using Vector3Batch = Eigen::Matrix<s_t, Eigen::Dynamic, 3>;
+using TwistBatch = Eigen::Matrix<s_t, Eigen::Dynamic, 6>;
+using RotationBatch = Eigen::Matrix<s_t, Eigen::Dynamic, 9>;
+using TransformBatch = Eigen::Matrix<s_t, Eigen::Dynamic, 12>;
+
 } // namespace math
 } // namespace dart
 
@@ -17,20 +17,19 @@ MultivariateGaussian::MultivariateGaussian(
   s_t logTwoPiExp = logTwoPi * (((s_t)mVars.size()) / 2);
   mCovInv = Eigen::LLT<Eigen::MatrixXs>(mCov);
 
-  // Compute the log-determinant
-  auto& U = mCovInv.matrixL();
+  // Compute the log-determinant from the diagonal of the Cholesky factor,
+  // which is much cheaper (and less prone to overflow) than determinant()
+  const Eigen::MatrixXs& L = mCovInv.matrixLLT();
   s_t logDet = 0.0;
   for (unsigned i = 0; i < mCov.rows(); ++i)
-    logDet += log(U(i, i));
+    logDet += log(L(i, i));
   logDet *= 2;
+  mLogDeterminant = logDet;
 
   s_t logSqrtDet = logDet * 0.5;
 
   mLogNormalizationConstant = -1 * (logSqrtDet + logTwoPiExp);
-
-  s_t det = mCov.determinant();
-  s_t twoPiExp = pow(twoPi, mVars.size());
-  mNormalizationConstant = 1. / (sqrt(twoPiExp * det));
+  mNormalizationConstant = exp(mLogNormalizationConstant);
 }
 
 void MultivariateGaussian::debugToStdout()
@@ -61,6 +60,11 @@ s_t MultivariateGaussian::getLogNormalizationConstant()
   return mLogNormalizationConstant;
 }
 
+s_t MultivariateGaussian::getLogDeterminant()
+{
+  return mLogDeterminant;
+}
+
 s_t MultivariateGaussian::getMean(std::string variable)
 {
   for (int i = 0; i < mVars.size(); i++)
@@ -103,9 +107,12 @@ s_t MultivariateGaussian::computePDF(Eigen::VectorXs x)
 
 s_t MultivariateGaussian::computeLogPDF(Eigen::VectorXs x, bool normalized)
 {
+  // diff^T * cov^-1 * diff = |L^-1 * diff|^2, which only needs one triangular
+  // solve instead of the two that mCovInv.solve() would do
   Eigen::VectorXs diff = x - mMu;
+  mCovInv.matrixL().solveInPlace(diff);
   return (normalized ? mLogNormalizationConstant : 0)
-         + (-0.5 * diff.transpose() * mCovInv.solve(diff));
+         + (-0.5 * diff.squaredNorm());
 }
 
 Eigen::VectorXs MultivariateGaussian::computeLogPDFGrad(Eigen::VectorXs x)
@@ -114,6 +121,26 @@ Eigen::VectorXs MultivariateGaussian::computeLogPDFGrad(Eigen::VectorXs x)
   return -mCovInv.solve(diff);
 }
 
+Eigen::VectorXs MultivariateGaussian::computeLogPDFBatch(
+    const Eigen::MatrixXs& xs, bool normalized)
+{
+  Eigen::MatrixXs diffs = xs.colwise() - mMu;
+  mCovInv.matrixL().solveInPlace(diffs);
+  Eigen::VectorXs result = -0.5 * diffs.colwise().squaredNorm().transpose();
+  if (normalized)
+  {
+    result.array() += mLogNormalizationConstant;
+  }
+  return result;
+}
+
+Eigen::MatrixXs MultivariateGaussian::computeLogPDFGradBatch(
+    const Eigen::MatrixXs& xs)
+{
+  Eigen::MatrixXs diffs = xs.colwise() - mMu;
+  return -mCovInv.solve(diffs);
+}
+
 Eigen::VectorXs MultivariateGaussian::finiteDifferenceLogPDFGrad(
     Eigen::VectorXs x)
 {
@@ -175,32 +202,51 @@ std::shared_ptr<MultivariateGaussian> MultivariateGaussian::condition(
     observedVector(i) = observedValues.at(mVars[observedIndices[i]]);
   }
 
-  // 3. Get all the sub-blocks of the Gaussian
-  Eigen::VectorXs mu_1 = getMuSubset(unobservedIndices);
-  Eigen::VectorXs mu_2 = getMuSubset(observedIndices);
-  Eigen::MatrixXs cov_11 = getCovSubset(unobservedIndices, unobservedIndices);
-  Eigen::MatrixXs cov_12 = getCovSubset(unobservedIndices, observedIndices);
-  Eigen::MatrixXs cov_21 = getCovSubset(observedIndices, unobservedIndices);
-  Eigen::MatrixXs cov_22 = getCovSubset(observedIndices, observedIndices);
+  // 3. Get the blocks that only depend on which variables are observed, from
+  // the cache if we've conditioned on these variables before
+  auto cached = mConditionCache.find(observedIndices);
+  if (cached == mConditionCache.end())
+  {
+    ConditionedBlocks blocks;
+    blocks.unobservedMu = getMuSubset(unobservedIndices);
+    blocks.observedMu = getMuSubset(observedIndices);
+    Eigen::MatrixXs cov_11 = getCovSubset(unobservedIndices, unobservedIndices);
+    Eigen::MatrixXs cov_12 = getCovSubset(unobservedIndices, observedIndices);
+    Eigen::MatrixXs cov_22 = getCovSubset(observedIndices, observedIndices);
+
+    // cov_22 is symmetric, so cov_12 * cov_22^-1 = (cov_22^-1 * cov_21)^T
+    Eigen::LLT<Eigen::MatrixXs> cov_22_LLT(cov_22);
+    blocks.gain = cov_22_LLT.solve(cov_12.transpose()).transpose();
+
+    std::vector<std::string> subNames;
+    for (int i = 0; i < unobservedIndices.size(); i++)
+    {
+      subNames.push_back(mVars[unobservedIndices[i]]);
+    }
+    Eigen::MatrixXs subCov = cov_11 - blocks.gain * cov_12.transpose();
+    blocks.conditioned = std::make_shared<MultivariateGaussian>(
+        subNames, blocks.unobservedMu, subCov);
+
+    cached = mConditionCache.emplace(observedIndices, blocks).first;
+  }
+  const ConditionedBlocks& blocks = cached->second;
 
   std::cout << "Coniditioning Multivariate Gaussion on:" << std::endl;
   for (int i = 0; i < observedIndices.size(); i++)
   {
     std::cout << getVariableNameAtIndex(observedIndices[i])
-              << " (mu=" << mu_2(i) << "): " << observedVector(i) << std::endl;
+              << " (mu=" << blocks.observedMu(i) << "): " << observedVector(i)
+              << std::endl;
   }
 
-  Eigen::MatrixXs cov_22_Inv = cov_22.inverse();
-
-  std::vector<std::string> subNames;
-  for (int i = 0; i < unobservedIndices.size(); i++)
-  {
-    subNames.push_back(mVars[unobservedIndices[i]]);
-  }
-  Eigen::VectorXs subMu = mu_1 + cov_12 * cov_22_Inv * (observedVector - mu_2);
-  Eigen::MatrixXs subCov = cov_11 - cov_12 * cov_22_Inv * cov_21;
-
-  return std::make_shared<MultivariateGaussian>(subNames, subMu, subCov);
+  // 4. Copy the cached distribution, and only shift its mean. The mean
+  // doesn't enter the Cholesky factor or the normalization constant, so those
+  // carry over as-is.
+  std::shared_ptr<MultivariateGaussian> result
+      = std::make_shared<MultivariateGaussian>(*blocks.conditioned);
+  result->mMu = blocks.unobservedMu
+                + blocks.gain * (observedVector - blocks.observedMu);
+  return result;
 }
 
 std::vector<int> MultivariateGaussian::getObservedIndices(
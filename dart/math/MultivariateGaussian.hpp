@@ -22,6 +22,10 @@ public:
 
   s_t getLogNormalizationConstant();
 
+  /// This returns log(det(cov)), which is computed once from the Cholesky
+  /// factor when the distribution is created
+  s_t getLogDeterminant();
+
   s_t getMean(std::string variable);
 
   Eigen::VectorXs convertFromMap(const std::map<std::string, s_t>& values);
@@ -36,12 +40,28 @@ public:
 
   Eigen::VectorXs computeLogPDFGrad(Eigen::VectorXs x);
 
+  /// This evaluates computeLogPDF() for every column of `xs` at once, which
+  /// turns the per-point triangular solves into a single solve against a
+  /// matrix, and returns one entry per column.
+  Eigen::VectorXs computeLogPDFBatch(
+      const Eigen::MatrixXs& xs, bool normalized = true);
+
+  /// This evaluates computeLogPDFGrad() for every column of `xs` at once, and
+  /// returns the gradients as the columns of the result.
+  Eigen::MatrixXs computeLogPDFGradBatch(const Eigen::MatrixXs& xs);
+
   Eigen::VectorXs finiteDifferenceLogPDFGrad(Eigen::VectorXs x);
 
   std::vector<std::string> getVariableNames();
 
   std::string getVariableNameAtIndex(int i);
 
+  /// This returns the distribution over the remaining variables, given the
+  /// observed values. Everything that doesn't depend on the observed values
+  /// (the conditional covariance, its Cholesky factor, and the gain from the
+  /// observations to the mean) is cached by which variables are observed, so
+  /// conditioning again on the same variables only costs a matrix-vector
+  /// product.
   std::shared_ptr<MultivariateGaussian> condition(
       const std::map<std::string, s_t>& observedValues);
 
@@ -65,9 +85,24 @@ protected:
   std::vector<std::string> mVars;
   Eigen::VectorXs mMu;
   Eigen::MatrixXs mCov;
+  // The Cholesky factorization of mCov, so that we never need to form the
+  // inverse explicitly
   Eigen::LLT<Eigen::MatrixXs> mCovInv;
+  s_t mLogDeterminant;
   s_t mNormalizationConstant;
   s_t mLogNormalizationConstant;
+
+  struct ConditionedBlocks
+  {
+    Eigen::VectorXs unobservedMu;
+    Eigen::VectorXs observedMu;
+    /// cov_12 * cov_22^-1
+    Eigen::MatrixXs gain;
+    /// The conditioned distribution, with its mean set to `unobservedMu`
+    std::shared_ptr<MultivariateGaussian> conditioned;
+  };
+  /// This is keyed by the (sorted) indices of the observed variables
+  std::map<std::vector<int>, ConditionedBlocks> mConditionCache;
 };
 
 } // namespace math
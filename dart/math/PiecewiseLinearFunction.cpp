@@ -175,7 +175,7 @@ void PiecewiseLinearFunction::calcCoefficients()
   if (n < 2)
     return;
 
-  _b.reserve(n);
+  _b.resize(n);
 
   for (int i = 0; i < n - 1; i++)
   {
@@ -281,5 +281,25 @@ std::shared_ptr<CustomFunction> PiecewiseLinearFunction::offsetBy(
   return std::make_shared<PiecewiseLinearFunction>(_x, newY);
 }
 
+bool PiecewiseLinearFunction::toPiecewisePolynomial(
+    std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const
+{
+  int n = _x.size();
+  if (n < 2)
+    return false;
+
+  // The last point doesn't need a segment of its own, because the slope past
+  // it is the same as the slope of the segment before it
+  knots.assign(_x.begin(), _x.end() - 1);
+  coeffs.resize(2 * (n - 1));
+  for (int i = 0; i < n - 1; i++)
+  {
+    coeffs[2 * i] = _y[i];
+    coeffs[2 * i + 1] = _b[i];
+  }
+  degree = 1;
+  return true;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
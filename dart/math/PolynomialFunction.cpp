@@ -45,5 +45,16 @@ std::shared_ptr<CustomFunction> PolynomialFunction::offsetBy(s_t y) const
   return std::make_shared<PolynomialFunction>(newCoeffs);
 }
 
+bool PolynomialFunction::toPiecewisePolynomial(
+    std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const
+{
+  knots.assign(1, 0.0);
+  coeffs = mCoeffs;
+  if (coeffs.empty())
+    coeffs.push_back(0.0);
+  degree = coeffs.size() - 1;
+  return true;
+}
+
 } // namespace math
 } // namespace dart
\ No newline at end of file
@@ -452,6 +452,30 @@ std::shared_ptr<CustomFunction> SimmSpline::offsetBy(s_t offset) const
   return std::make_shared<SimmSpline>(_x, newY);
 }
 
+bool SimmSpline::toPiecewisePolynomial(
+    std::vector<s_t>& knots, std::vector<s_t>& coeffs, int& degree) const
+{
+  int n = _x.size();
+  if (n < 2)
+    return false;
+
+  // With only two points, calcValue() always uses the first segment
+  if (n < 3)
+    n = 1;
+
+  knots.assign(_x.begin(), _x.begin() + n);
+  coeffs.resize(4 * n);
+  for (int i = 0; i < n; i++)
+  {
+    coeffs[4 * i] = _y[i];
+    coeffs[4 * i + 1] = _b[i];
+    coeffs[4 * i + 2] = _c[i];
+    coeffs[4 * i + 3] = _d[i];
+  }
+  degree = 3;
+  return true;
+}
+
 s_t SimmSpline::finiteDifferenceFirstDerivative(s_t x, bool useRidders)
 {
   s_t result = 0.;
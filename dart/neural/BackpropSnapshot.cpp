@@ -2,8 +2,10 @@
 
 #include <array>
 #include <chrono>
+#include <future>
 #include <iostream>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/constraint/ConstraintSolver.hpp"
 #include "dart/dynamics/DegreeOfFreedom.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -18,7 +20,9 @@
 // Make production builds happy with asserts
 #define _unused(x) ((void)(x))
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+#endif
 
 using namespace dart;
 using namespace math;
@@ -45,6 +49,62 @@ BackpropSnapshot::BackpropSnapshot(
     mNumUpperBound(0),
     mNumBouncing(0)
 {
+  reset(
+      world,
+      preStepPosition,
+      preStepVelocity,
+      preStepTorques,
+      preConstraintVelocities,
+      preStepLCPCache);
+}
+
+//==============================================================================
+BackpropSnapshot::BackpropSnapshot()
+  : mUseFDOverride(false),
+    mSlowDebugResultsAgainstFD(false),
+    mTimeStep(0),
+    mNumDOFs(0),
+    mNumConstraintDim(0),
+    mNumClamping(0),
+    mNumUpperBound(0),
+    mNumBouncing(0),
+    mCachedPosPosDirty(true),
+    mCachedPosVelDirty(true),
+    mCachedBounceApproximationDirty(true),
+    mCachedVelPosDirty(true),
+    mCachedVelVelDirty(true),
+    mCachedForcePosDirty(true),
+    mCachedForceVelDirty(true),
+    mCachedMassVelDirty(true),
+    mCachedPosCDirty(true),
+    mCachedVelCDirty(true)
+{
+}
+
+//==============================================================================
+/// This re-initializes this snapshot in place from a new forward pass. This
+/// has the same semantics as the constructor, but it re-uses any buffers we
+/// already have (including the cached Jacobians), so it doesn't hit the
+/// allocator if the world dimensions haven't changed.
+void BackpropSnapshot::reset(
+    WorldPtr world,
+    const Eigen::VectorXs& preStepPosition,
+    const Eigen::VectorXs& preStepVelocity,
+    const Eigen::VectorXs& preStepTorques,
+    const Eigen::VectorXs& preConstraintVelocities,
+    const Eigen::VectorXs& preStepLCPCache)
+{
+  mUseFDOverride = world->getUseFDOverride();
+  mSlowDebugResultsAgainstFD = world->getSlowDebugResultsAgainstFD();
+  mNumDOFs = 0;
+  mNumConstraintDim = 0;
+  mNumClamping = 0;
+  mNumUpperBound = 0;
+  mNumBouncing = 0;
+  mGradientMatrices.clear();
+  mSkeletonOffset.clear();
+  mSkeletonDofs.clear();
+
   mTimeStep = world->getTimeStep();
   mPreStepPosition = preStepPosition;
   mPreStepVelocity = preStepVelocity;
@@ -55,6 +115,15 @@ BackpropSnapshot::BackpropSnapshot(
   mPostStepVelocity = world->getVelocities();
   mPostStepTorques = world->getControlForces();
 
+  // Only the compliant contacts that actually pushed have any gradient
+  mCompliantContacts.clear();
+  for (const constraint::CompliantContact& contact :
+       world->getConstraintSolver()->getCompliantContacts())
+  {
+    if (contact.isActive())
+      mCompliantContacts.push_back(contact);
+  }
+
   // Reset the world to the initial state before finalizing all the gradient
   // matrices
 
@@ -117,6 +186,23 @@ BackpropSnapshot::BackpropSnapshot(
   */
 }
 
+//==============================================================================
+void BackpropSnapshot::reserveJacobians(
+    std::size_t numDofs, std::size_t massDims)
+{
+  mCachedPosPos.resize(numDofs, numDofs);
+  mCachedPosVel.resize(numDofs, numDofs);
+  mCachedBounceApproximation.resize(numDofs, numDofs);
+  mCachedVelPos.resize(numDofs, numDofs);
+  mCachedVelVel.resize(numDofs, numDofs);
+  mCachedForcePos.resize(numDofs, numDofs);
+  mCachedForceVel.resize(numDofs, numDofs);
+  mCachedMassVel.resize(numDofs, massDims);
+  mCachedPosC.resize(numDofs, numDofs);
+  mCachedVelC.resize(numDofs, numDofs);
+  mScratchMinv.resize(numDofs, numDofs);
+}
+
 //==============================================================================
 void BackpropSnapshot::backprop(
     WorldPtr world,
@@ -133,9 +219,6 @@ void BackpropSnapshot::backprop(
   }
 #endif
 
-  LossGradient groupThisTimestepLoss;
-  LossGradient groupNextTimestepLoss;
-
   // Set the state of the world back to what it was during the forward pass, so
   // that implicit mass matrix computations work correctly.
 
@@ -156,32 +239,19 @@ void BackpropSnapshot::backprop(
   // using ConstrainedGroups directly. Currently it's redundant to construct
   // Jacobians _both_ in the ConstrainedGroups and in the BackpropSnapshot, so
   // it's better overall to just use one.
-  if (exploreAlternateStrategies == false)
+  // The constrained groups don't know about compliant contacts, so those always
+  // go through backpropWrt()
+  if (exploreAlternateStrategies == false || !mCompliantContacts.empty())
   {
-    const Eigen::MatrixXs& posPos = getPosPosJacobian(world, thisLog);
-    const Eigen::MatrixXs& posVel = getPosVelJacobian(world, thisLog);
-    const Eigen::MatrixXs& velPos = getVelPosJacobian(world, thisLog);
-    const Eigen::MatrixXs& velVel = getVelVelJacobian(world, thisLog);
-    const Eigen::MatrixXs& forceVel
-        = getControlForceVelJacobian(world, thisLog);
-    const Eigen::MatrixXs& massVel = getMassVelJacobian(world, thisLog);
-
-    thisTimestepLoss.lossWrtPosition
-        = posPos.transpose() * nextTimestepLoss.lossWrtPosition
-          + posVel.transpose() * nextTimestepLoss.lossWrtVelocity;
-    thisTimestepLoss.lossWrtVelocity
-        = velPos.transpose() * nextTimestepLoss.lossWrtPosition
-          + velVel.transpose() * nextTimestepLoss.lossWrtVelocity;
-    thisTimestepLoss.lossWrtTorque
-        = forceVel.transpose() * nextTimestepLoss.lossWrtVelocity;
-    thisTimestepLoss.lossWrtMass
-        = massVel.transpose() * nextTimestepLoss.lossWrtVelocity;
-
-    clipLossGradientsToBounds(
-        world,
-        thisTimestepLoss.lossWrtPosition,
-        thisTimestepLoss.lossWrtVelocity,
-        thisTimestepLoss.lossWrtTorque);
+    std::vector<WithRespectTo*> wrts;
+    wrts.push_back(WithRespectTo::POSITION);
+    wrts.push_back(WithRespectTo::VELOCITY);
+    wrts.push_back(WithRespectTo::FORCE);
+    if (world->getWrtMass())
+    {
+      wrts.push_back(world->getWrtMass().get());
+    }
+    backpropWrt(world, thisTimestepLoss, nextTimestepLoss, wrts, thisLog);
 
 #ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
     if (thisLog != nullptr)
@@ -204,19 +274,47 @@ void BackpropSnapshot::backprop(
   thisTimestepLoss.lossWrtMass
       = massVel.transpose() * nextTimestepLoss.lossWrtVelocity;
 
-  // Actually run the backprop
+  // Keep track of which skeletons have been covered by constraint groups. Each
+  // skeleton belongs to at most one group, which is what lets us backprop
+  // through the groups independently below.
 
   std::unordered_map<std::string, bool> skeletonsVisited;
-
-  for (std::shared_ptr<ConstrainedGroupGradientMatrices> group :
-       mGradientMatrices)
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> groupSegments;
+  groupSegments.resize(mGradientMatrices.size());
+  for (std::size_t i = 0; i < mGradientMatrices.size(); i++)
   {
+    const std::vector<std::string>& skelNames
+        = mGradientMatrices[i]->getSkeletonNames();
+    for (std::size_t j = 0; j < skelNames.size(); j++)
+    {
+      bool skelAlreadyVisited
+          = (skeletonsVisited.find(skelNames[j]) != skeletonsVisited.end());
+      DART_UNUSED(skelAlreadyVisited);
+      assert(!skelAlreadyVisited);
+      skeletonsVisited[skelNames[j]] = true;
+
+      // Record (world offset, num dofs) for each skeleton in the group
+      groupSegments[i].emplace_back(
+          mSkeletonOffset[skelNames[j]],
+          world->getSkeleton(skelNames[j])->getNumDofs());
+    }
+  }
+
+  // Actually run the backprop. Each group only reads its own segments of
+  // `nextTimestepLoss` and writes to its own entry in `groupLosses`.
+
+  std::vector<LossGradient> groupLosses(mGradientMatrices.size());
+  auto backpropGroup = [&](std::size_t i) {
+    std::shared_ptr<ConstrainedGroupGradientMatrices> group
+        = mGradientMatrices[i];
     std::size_t groupDofs = group->getNumDOFs();
 
     // Instantiate the vectors with plenty of DOFs
 
+    LossGradient groupNextTimestepLoss;
     groupNextTimestepLoss.lossWrtPosition = Eigen::VectorXs::Zero(groupDofs);
     groupNextTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Zero(groupDofs);
+    LossGradient& groupThisTimestepLoss = groupLosses[i];
     groupThisTimestepLoss.lossWrtPosition = Eigen::VectorXs::Zero(groupDofs);
     groupThisTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Zero(groupDofs);
     groupThisTimestepLoss.lossWrtTorque = Eigen::VectorXs::Zero(groupDofs);
@@ -224,25 +322,15 @@ void BackpropSnapshot::backprop(
     // Set up next timestep loss as a map of the real values
 
     std::size_t cursor = 0;
-    for (std::size_t j = 0; j < group->getSkeletonNames().size(); j++)
+    for (const auto& segment : groupSegments[i])
     {
-      SkeletonPtr skel = world->getSkeleton(group->getSkeletonNames()[j]);
-      std::size_t dofCursorWorld = mSkeletonOffset[skel->getName()];
-      std::size_t dofs = skel->getNumDofs();
-
-      // Keep track of which skeletons have been covered by constraint groups
-      bool skelAlreadyVisited
-          = (skeletonsVisited.find(skel->getName()) != skeletonsVisited.end());
-      DART_UNUSED(skelAlreadyVisited);
-      assert(!skelAlreadyVisited);
-      skeletonsVisited[skel->getName()] = true;
-
-      groupNextTimestepLoss.lossWrtPosition.segment(cursor, dofs)
-          = nextTimestepLoss.lossWrtPosition.segment(dofCursorWorld, dofs);
-      groupNextTimestepLoss.lossWrtVelocity.segment(cursor, dofs)
-          = nextTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs);
-
-      cursor += dofs;
+      groupNextTimestepLoss.lossWrtPosition.segment(cursor, segment.second)
+          = nextTimestepLoss.lossWrtPosition.segment(
+              segment.first, segment.second);
+      groupNextTimestepLoss.lossWrtVelocity.segment(cursor, segment.second)
+          = nextTimestepLoss.lossWrtVelocity.segment(
+              segment.first, segment.second);
+      cursor += segment.second;
     }
 
     // Now actually run the backprop
@@ -252,24 +340,59 @@ void BackpropSnapshot::backprop(
         groupThisTimestepLoss,
         groupNextTimestepLoss,
         exploreAlternateStrategies);
-
-    // Read the values back out of the group backprop
-
-    cursor = 0;
-    for (std::size_t j = 0; j < group->getSkeletonNames().size(); j++)
+  };
+
+  int numGroups = mGradientMatrices.size();
+  int numThreads = world->getConstraintSolver()->getNumGroupSolverThreads();
+  if (numThreads <= 0)
+    numThreads = common::TaskScheduler::getGlobalMaxConcurrency();
+  int numChunks = std::min(numThreads, numGroups);
+  if (numChunks <= 1)
+  {
+    for (int i = 0; i < numGroups; i++)
     {
-      SkeletonPtr skel = world->getSkeleton(group->getSkeletonNames()[j]);
-      std::size_t dofCursorWorld = mSkeletonOffset[skel->getName()];
-      std::size_t dofs = skel->getNumDofs();
+      backpropGroup(i);
+    }
+  }
+  else
+  {
+    std::vector<std::future<void>> futures;
+    int chunkSize = numGroups / numChunks;
+    int remainder = numGroups % numChunks;
+    int start = 0;
+    for (int chunk = 0; chunk < numChunks; chunk++)
+    {
+      int end = start + chunkSize + (chunk < remainder ? 1 : 0);
+      futures.push_back(
+          std::async(std::launch::async, [&backpropGroup, start, end]() {
+            for (int i = start; i < end; i++)
+            {
+              backpropGroup(i);
+            }
+          }));
+      start = end;
+    }
+    for (int i = 0; i < futures.size(); i++)
+    {
+      futures[i].get();
+    }
+  }
 
-      thisTimestepLoss.lossWrtPosition.segment(dofCursorWorld, dofs)
-          = groupThisTimestepLoss.lossWrtPosition.segment(cursor, dofs);
-      thisTimestepLoss.lossWrtVelocity.segment(dofCursorWorld, dofs)
-          = groupThisTimestepLoss.lossWrtVelocity.segment(cursor, dofs);
-      thisTimestepLoss.lossWrtTorque.segment(dofCursorWorld, dofs)
-          = groupThisTimestepLoss.lossWrtTorque.segment(cursor, dofs);
+  // Read the values back out of the group backprops, in group order, so the
+  // result doesn't depend on how the work was split across threads
 
-      cursor += dofs;
+  for (std::size_t i = 0; i < mGradientMatrices.size(); i++)
+  {
+    std::size_t cursor = 0;
+    for (const auto& segment : groupSegments[i])
+    {
+      thisTimestepLoss.lossWrtPosition.segment(segment.first, segment.second)
+          = groupLosses[i].lossWrtPosition.segment(cursor, segment.second);
+      thisTimestepLoss.lossWrtVelocity.segment(segment.first, segment.second)
+          = groupLosses[i].lossWrtVelocity.segment(cursor, segment.second);
+      thisTimestepLoss.lossWrtTorque.segment(segment.first, segment.second)
+          = groupLosses[i].lossWrtTorque.segment(cursor, segment.second);
+      cursor += segment.second;
     }
   }
 
@@ -376,6 +499,181 @@ void BackpropSnapshot::backprop(
 #endif
 }
 
+//==============================================================================
+void BackpropSnapshot::backpropWrt(
+    simulation::WorldPtr world,
+    LossGradient& thisTimestepLoss,
+    const LossGradient& nextTimestepLoss,
+    const std::vector<WithRespectTo*>& wrts,
+    PerformanceLog* perfLog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (perfLog != nullptr)
+  {
+    thisLog = perfLog->startRun("BackpropSnapshot.backpropWrt");
+  }
+#endif
+
+  WithRespectTo* wrtMass = world->getWrtMass().get();
+  bool wantPos = false;
+  bool wantVel = false;
+  bool wantForce = false;
+  bool wantMass = false;
+  for (WithRespectTo* wrt : wrts)
+  {
+    if (wrt == WithRespectTo::POSITION)
+      wantPos = true;
+    else if (wrt == WithRespectTo::VELOCITY)
+      wantVel = true;
+    else if (wrt == WithRespectTo::FORCE)
+      wantForce = true;
+    else if (wrt != nullptr && wrt == wrtMass)
+      wantMass = true;
+    else
+      std::cerr << "BackpropSnapshot::backpropWrt() doesn't know how to "
+                   "backprop to a WithRespectTo that isn't POSITION, VELOCITY, "
+                   "FORCE, or world->getWrtMass(). Ignoring it."
+                << std::endl;
+  }
+  std::size_t massDims = wantMass ? world->getMassDims() : 0;
+  if (massDims == 0)
+  {
+    wantMass = false;
+  }
+
+  // Set the state of the world back to what it was during the forward pass, so
+  // that implicit mass matrix computations work correctly. This is a no-op if
+  // we were called from backprop(), which has already done this.
+
+  RestorableSnapshot snapshot(world);
+  world->setPositions(mPreStepPosition);
+  world->setVelocities(mPreStepVelocity);
+  world->setControlForces(mPreStepTorques);
+  world->setCachedLCPSolution(mPreStepLCPCache);
+
+  thisTimestepLoss.lossWrtPosition = Eigen::VectorXs::Zero(mNumDOFs);
+  thisTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Zero(mNumDOFs);
+  thisTimestepLoss.lossWrtTorque = Eigen::VectorXs::Zero(mNumDOFs);
+  thisTimestepLoss.lossWrtMass = Eigen::VectorXs::Zero(massDims);
+
+  // Any incoming gradient that's exactly zero can't contribute anything, so we
+  // can skip forming the Jacobians that would multiply it.
+  const bool hasPosGrad = nextTimestepLoss.lossWrtPosition.size() > 0
+                          && !nextTimestepLoss.lossWrtPosition.isZero(0);
+  const bool hasVelGrad = nextTimestepLoss.lossWrtVelocity.size() > 0
+                          && !nextTimestepLoss.lossWrtVelocity.isZero(0);
+
+  // If nothing is clamping, v_{t+1} is an unconstrained function of p_t, v_t
+  // and f_t, and we can get the force and velocity VJPs with a single implicit
+  // multiply by Minv, instead of forming Minv and the dense Jacobians.
+  // Immobile skeletons are left out of the implicit multiply, so we only take
+  // this path if everything is mobile.
+  bool matrixFree = !mUseFDOverride && !mSlowDebugResultsAgainstFD
+                    && mNumClamping == 0 && mNumUpperBound == 0
+                    && mNumBouncing == 0 && mCompliantContacts.empty();
+  for (std::size_t i = 0; matrixFree && i < world->getNumSkeletons(); i++)
+  {
+    if (!world->getSkeleton(i)->isMobile())
+      matrixFree = false;
+  }
+
+  if (hasVelGrad && (wantVel || wantForce))
+  {
+    if (matrixFree)
+    {
+      // Minv is symmetric, so Minv^T * g == Minv * g
+      Eigen::VectorXs MinvGrad = implicitMultiplyByInvMassMatrix(
+          world, nextTimestepLoss.lossWrtVelocity);
+      if (wantForce)
+      {
+        thisTimestepLoss.lossWrtTorque = mTimeStep * MinvGrad;
+      }
+      if (wantVel)
+      {
+        // vel-vel = I - dt*Minv*D - dt^2*Minv*K - dt*Minv*dC/dvel
+        Eigen::VectorXs ddamp = getDampingVector(world);
+        Eigen::VectorXs springStiffs = getSpringStiffVector(world);
+        thisTimestepLoss.lossWrtVelocity
+            = nextTimestepLoss.lossWrtVelocity
+              - mTimeStep * ddamp.cwiseProduct(MinvGrad)
+              - mTimeStep * mTimeStep * springStiffs.cwiseProduct(MinvGrad)
+              - mTimeStep * getVelCJacobian(world).transpose() * MinvGrad;
+      }
+    }
+    else
+    {
+      if (wantForce)
+      {
+        const Eigen::MatrixXs& forceVel
+            = getControlForceVelJacobian(world, thisLog);
+        thisTimestepLoss.lossWrtTorque
+            = forceVel.transpose() * nextTimestepLoss.lossWrtVelocity;
+      }
+      if (wantVel)
+      {
+        const Eigen::MatrixXs& velVel = getVelVelJacobian(world, thisLog);
+        thisTimestepLoss.lossWrtVelocity
+            = velVel.transpose() * nextTimestepLoss.lossWrtVelocity;
+      }
+    }
+  }
+  if (wantVel && hasPosGrad)
+  {
+    const Eigen::MatrixXs& velPos = getVelPosJacobian(world, thisLog);
+    thisTimestepLoss.lossWrtVelocity
+        += velPos.transpose() * nextTimestepLoss.lossWrtPosition;
+  }
+  if (wantPos && hasPosGrad)
+  {
+    const Eigen::MatrixXs& posPos = getPosPosJacobian(world, thisLog);
+    thisTimestepLoss.lossWrtPosition
+        = posPos.transpose() * nextTimestepLoss.lossWrtPosition;
+  }
+  if (wantPos && hasVelGrad)
+  {
+    const Eigen::MatrixXs& posVel = getPosVelJacobian(world, thisLog);
+    thisTimestepLoss.lossWrtPosition
+        += posVel.transpose() * nextTimestepLoss.lossWrtVelocity;
+  }
+  if (wantMass && hasVelGrad)
+  {
+    if (matrixFree)
+    {
+      // With nothing clamping, M * (v_{t+1} - v_t) = dt * (tau - C - ...) and
+      // only M and C depend on the masses, so mass-vel = -dt * Minv * dID/dm,
+      // with the inverse dynamics evaluated at this step's acceleration. The
+      // WRT can give us the VJP with dID/dm without forming it.
+      Eigen::VectorXs ddq = (mPostStepVelocity - mPreStepVelocity) / mTimeStep;
+      Eigen::VectorXs MinvGrad = implicitMultiplyByInvMassMatrix(
+          world, nextTimestepLoss.lossWrtVelocity);
+      thisTimestepLoss.lossWrtMass
+          = -mTimeStep * wrtMass->vjp(world.get(), ddq, MinvGrad);
+    }
+    else
+    {
+      const Eigen::MatrixXs& massVel = getMassVelJacobian(world, thisLog);
+      thisTimestepLoss.lossWrtMass
+          = massVel.transpose() * nextTimestepLoss.lossWrtVelocity;
+    }
+  }
+
+  clipLossGradientsToBounds(
+      world,
+      thisTimestepLoss.lossWrtPosition,
+      thisTimestepLoss.lossWrtVelocity,
+      thisTimestepLoss.lossWrtTorque);
+
+  snapshot.restore();
+
+#ifdef LOG_PERFORMANCE_BACKPROP_SNAPSHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This computes backprop in the high-level RL API's space, use `state` and
 /// `action` as the primitives we're taking gradients wrt to.
@@ -512,19 +810,20 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
     }
     else
     {
-      Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
-      Eigen::MatrixXs Minv = getInvMassMatrix(world);
-
       // If there are no clamping constraints, then force-vel is just the
       // mTimeStep
       // * Minv
-      if (A_c.size() == 0)
+      if (mNumClamping == 0 || mNumDOFs == 0)
       {
-        mCachedForceVel = mTimeStep * Minv;
+        assembleBlockDiagonalMatrixInto(
+            world,
+            BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS,
+            mScratchMinv);
+        mCachedForceVel = mTimeStep * mScratchMinv;
       }
       else
       {
-        mCachedForceVel = getVelJacobianWrt(world, WithRespectTo::FORCE);
+        getVelJacobianWrt(world, WithRespectTo::FORCE, mCachedForceVel);
 
         /*
         Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
@@ -545,6 +844,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getControlForceVelJacobian(
         }
         */
       }
+
+      if (!mCompliantContacts.empty())
+      {
+        mCachedForceVel
+            += getCompliantContactVelJacobianWrt(world, WithRespectTo::FORCE);
+      }
     }
 
     if (mSlowDebugResultsAgainstFD)
@@ -611,7 +916,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getMassVelJacobian(
     }
     else
     {
-      mCachedMassVel = getVelJacobianWrt(world, world->getWrtMass().get());
+      getVelJacobianWrt(world, world->getWrtMass().get(), mCachedMassVel);
+      if (!mCompliantContacts.empty())
+      {
+        mCachedMassVel += getCompliantContactVelJacobianWrt(
+            world, world->getWrtMass().get());
+      }
     }
 
     if (mSlowDebugResultsAgainstFD)
@@ -676,23 +986,28 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelVelJacobian(
     {
       Eigen::VectorXs ddamp = getDampingVector(world);
       Eigen::VectorXs spring_stiffs = getSpringStiffVector(world);
-      Eigen::MatrixXs Minv = getInvMassMatrix(world);
       s_t dt = world->getTimeStep();
-      Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
 
       // If there are no clamping constraints, then vel-vel is just the identity
-      if (A_c.size() == 0)
+      if (mNumClamping == 0 || mNumDOFs == 0)
       {
-        mCachedVelVel = Eigen::MatrixXs::Identity(mNumDOFs, mNumDOFs)
-                        - dt * Minv * ddamp.asDiagonal()
-                        - dt * dt * Minv * spring_stiffs.asDiagonal()
-                        - dt * Minv * getVelCJacobian(world);
+        assembleBlockDiagonalMatrixInto(
+            world,
+            BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS,
+            mScratchMinv);
+        const Eigen::MatrixXs& Minv = mScratchMinv;
+        mCachedVelVel.setIdentity(mNumDOFs, mNumDOFs);
+        mCachedVelVel.noalias() -= dt * Minv * ddamp.asDiagonal();
+        mCachedVelVel.noalias() -= dt * dt * Minv * spring_stiffs.asDiagonal();
+        mCachedVelVel.noalias() -= dt * Minv * getVelCJacobian(world);
       }
       else
       {
-        mCachedVelVel = getVelJacobianWrt(world, WithRespectTo::VELOCITY)
-                        - dt * Minv * ddamp.asDiagonal()
-                        - dt * dt * Minv * spring_stiffs.asDiagonal();
+        getVelJacobianWrt(world, WithRespectTo::VELOCITY, mCachedVelVel);
+        // getVelJacobianWrt() leaves Minv in mScratchMinv
+        const Eigen::MatrixXs& Minv = mScratchMinv;
+        mCachedVelVel.noalias() -= dt * Minv * ddamp.asDiagonal();
+        mCachedVelVel.noalias() -= dt * dt * Minv * spring_stiffs.asDiagonal();
 
         /*
         Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
@@ -732,6 +1047,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getVelVelJacobian(
                    << std::endl;
          */
       }
+
+      if (!mCompliantContacts.empty())
+      {
+        mCachedVelVel += getCompliantContactVelJacobianWrt(
+            world, WithRespectTo::VELOCITY);
+      }
     }
 
     if (mSlowDebugResultsAgainstFD)
@@ -793,7 +1114,12 @@ const Eigen::MatrixXs& BackpropSnapshot::getPosVelJacobian(
     }
     else
     {
-      mCachedPosVel = getVelJacobianWrt(world, WithRespectTo::POSITION);
+      getVelJacobianWrt(world, WithRespectTo::POSITION, mCachedPosVel);
+      if (!mCompliantContacts.empty())
+      {
+        mCachedPosVel += getCompliantContactVelJacobianWrt(
+            world, WithRespectTo::POSITION);
+      }
     }
 
     if (mSlowDebugResultsAgainstFD)
@@ -979,11 +1305,23 @@ Eigen::MatrixXs BackpropSnapshot::getScratchFiniteDifference(
 //==============================================================================
 Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
     simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  Eigen::MatrixXs result;
+  getVelJacobianWrt(world, wrt, result);
+  return result;
+}
+
+//==============================================================================
+/// This is the same as getVelJacobianWrt(), except that it writes into
+/// `result`, which doesn't allocate if `result` is already the right size.
+void BackpropSnapshot::getVelJacobianWrt(
+    simulation::WorldPtr world, WithRespectTo* wrt, Eigen::MatrixXs& result)
 {
   int wrtDim = wrt->dim(world.get());
   if (wrtDim == 0)
   {
-    return Eigen::MatrixXs::Zero(world->getNumDofs(), 0);
+    result.resize(world->getNumDofs(), 0);
+    return;
   }
   /*
   RestorableSnapshot snapshot(world);
@@ -993,10 +1331,17 @@ Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
   world->setCachedLCPSolution(mPreStepLCPCache);
   */
 
-  Eigen::MatrixXs A_c = getClampingConstraintMatrix(world);
-  Eigen::MatrixXs A_ub = getUpperBoundConstraintMatrix(world);
+  // The constraint matrices and Minv go into scratch buffers owned by this
+  // snapshot, which get reused across steps when the snapshot is pooled
+  assembleMatrixInto(world, MatrixToAssemble::CLAMPING, mScratchA_c);
+  assembleMatrixInto(world, MatrixToAssemble::UPPER_BOUND, mScratchA_ub);
   Eigen::MatrixXs E = getUpperBoundMappingMatrix();
-  Eigen::MatrixXs A_c_ub_E = A_c + A_ub * E;
+  mScratchA_c_ub_E = mScratchA_c;
+  if (mScratchA_ub.cols() > 0)
+  {
+    mScratchA_c_ub_E.noalias() += mScratchA_ub * E;
+  }
+  const Eigen::MatrixXs& A_c_ub_E = mScratchA_c_ub_E;
 
   Eigen::VectorXs tau = world->getControlForces();
   Eigen::VectorXs C = world->getCoriolisAndGravityAndExternalForces();
@@ -1015,7 +1360,14 @@ Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
       dt * (tau - C - damping_force - spring_force) + A_c_ub_E * f_c,
       wrt);
 
-  Eigen::MatrixXs Minv = world->getInvMassMatrix();
+  // This is the same as world->getInvMassMatrix(), since we don't move the
+  // world first
+  assembleBlockDiagonalMatrixInto(
+      world,
+      BackpropSnapshot::BlockDiagonalMatrixToAssemble::INV_MASS,
+      mScratchMinv,
+      true);
+  const Eigen::MatrixXs& Minv = mScratchMinv;
 
   Eigen::MatrixXs dF_c = getJacobianOfConstraintForce(world, wrt);
 
@@ -1036,11 +1388,13 @@ Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
               << std::endl;
     */
     // snapshot.restore();
-    return Minv
-           * ((A_c_ub_E * dF_c)
-              + (dt
-                 * Eigen::MatrixXs::Identity(
-                     world->getNumDofs(), world->getNumDofs())));
+    result.noalias()
+        = Minv
+          * ((A_c_ub_E * dF_c)
+             + (dt
+                * Eigen::MatrixXs::Identity(
+                    world->getNumDofs(), world->getNumDofs())));
+    return;
   }
 
   Eigen::MatrixXs dC = getJacobianOfC(world, wrt);
@@ -1048,21 +1402,23 @@ Eigen::MatrixXs BackpropSnapshot::getVelJacobianWrt(
   if (wrt == WithRespectTo::VELOCITY)
   {
     // snapshot.restore();
-    return Eigen::MatrixXs::Identity(world->getNumDofs(), world->getNumDofs())
-           + Minv * (A_c_ub_E * dF_c - dt * dC);
+    result.setIdentity(world->getNumDofs(), world->getNumDofs());
+    result.noalias() += Minv * (A_c_ub_E * dF_c - dt * dC);
   }
   else if (wrt == WithRespectTo::POSITION)
   {
     Eigen::MatrixXs dA_c = getJacobianOfClampingConstraints(world, f_c);
     Eigen::MatrixXs dA_ubE = getJacobianOfUpperBoundConstraints(world, E * f_c);
     // snapshot.restore();
-    return dM + Minv * (A_c_ub_E * dF_c + dA_c + dA_ubE - dt * dC)
-           - Minv * dt * spring_stiffs.asDiagonal();
+    result = dM;
+    result.noalias() += Minv * (A_c_ub_E * dF_c + dA_c + dA_ubE - dt * dC);
+    result.noalias() -= Minv * dt * spring_stiffs.asDiagonal();
   }
   else
   {
     // snapshot.restore();
-    return dM + Minv * (A_c_ub_E * dF_c - dt * dC);
+    result = dM;
+    result.noalias() += Minv * (A_c_ub_E * dF_c - dt * dC);
   }
 
   // std::cout << "dA_c: " << std::endl << dA_c << std::endl;
@@ -1127,6 +1483,118 @@ Eigen::MatrixXs BackpropSnapshot::getPosJacobianWrt(
   }
 }
 
+//==============================================================================
+Eigen::MatrixXs BackpropSnapshot::getCompliantContactVelJacobianWrt(
+    simulation::WorldPtr world, WithRespectTo* wrt)
+{
+  const int wrtDim = wrt->dim(world.get());
+  if (mCompliantContacts.empty() || wrtDim == 0)
+  {
+    return Eigen::MatrixXs::Zero(mNumDOFs, wrtDim);
+  }
+
+  const s_t dt = world->getTimeStep();
+  const Eigen::MatrixXs Minv = world->getInvMassMatrix();
+  const Eigen::MatrixXs J = getCompliantContactJacobian(world);
+  const std::size_t numContacts = mCompliantContacts.size();
+
+  // Collect df/dv (block diagonal), df/dq (block diagonal, through the depth,
+  // which shrinks as A moves along the normal) and the contact forces
+  Eigen::MatrixXs dForceDVel = Eigen::MatrixXs::Zero(J.rows(), J.rows());
+  Eigen::MatrixXs dForceDPos = Eigen::MatrixXs::Zero(J.rows(), J.rows());
+  Eigen::VectorXs forces = Eigen::VectorXs::Zero(J.rows());
+  for (std::size_t i = 0; i < numContacts; i++)
+  {
+    const constraint::CompliantContact& contact = mCompliantContacts[i];
+    dForceDVel.block<3, 3>(i * 3, i * 3) = contact.getForceVelocityJacobian();
+    dForceDPos.block<3, 3>(i * 3, i * 3)
+        = -contact.getForceDepthJacobian() * contact.getNormal().transpose();
+    forces.segment<3>(i * 3) = contact.getForce();
+  }
+  const Eigen::MatrixXs MinvJT = dt * Minv * J.transpose();
+
+  // The contact forces depend on v*, so first we need the Jacobian of the
+  // unconstrained step v* = v + dt * Minv * (tau - C - damping - springs)
+  Eigen::MatrixXs unconstrained;
+  if (wrt == WithRespectTo::FORCE)
+  {
+    unconstrained = dt * Minv;
+  }
+  else if (wrt == WithRespectTo::VELOCITY)
+  {
+    Eigen::VectorXs ddamp = getDampingVector(world);
+    Eigen::VectorXs springStiffs = getSpringStiffVector(world);
+    unconstrained = Eigen::MatrixXs::Identity(mNumDOFs, mNumDOFs)
+                    - dt * Minv * ddamp.asDiagonal()
+                    - dt * dt * Minv * springStiffs.asDiagonal()
+                    - dt * Minv * getVelCJacobian(world);
+  }
+  else
+  {
+    Eigen::VectorXs tau = world->getControlForces();
+    Eigen::VectorXs C = world->getCoriolisAndGravityAndExternalForces();
+    Eigen::VectorXs ddamp = getDampingVector(world);
+    Eigen::VectorXs springStiffs = getSpringStiffVector(world);
+    Eigen::VectorXs p_rest = getRestPositions(world);
+    Eigen::VectorXs v_t = world->getVelocities();
+    Eigen::VectorXs p_t = world->getPositions();
+    Eigen::VectorXs springForce
+        = springStiffs.asDiagonal() * (p_t - p_rest + dt * v_t);
+    Eigen::VectorXs dampingForce = ddamp.asDiagonal() * v_t;
+    unconstrained
+        = getJacobianOfMinv(
+              world, dt * (tau - C - dampingForce - springForce), wrt)
+          - dt * Minv * getJacobianOfC(world, wrt);
+    if (wrt == WithRespectTo::POSITION)
+    {
+      unconstrained -= dt * Minv * springStiffs.asDiagonal();
+    }
+  }
+
+  Eigen::MatrixXs result = MinvJT * (dForceDVel * (J * unconstrained));
+
+  // Position and mass also change the impulse directly, through the depth and
+  // through Minv
+  if (wrt == WithRespectTo::POSITION)
+  {
+    result += MinvJT * (dForceDPos * J);
+  }
+  if (wrt != WithRespectTo::FORCE && wrt != WithRespectTo::VELOCITY)
+  {
+    result += getJacobianOfMinv(world, dt * J.transpose() * forces, wrt);
+  }
+
+  return result;
+}
+
+//==============================================================================
+Eigen::MatrixXs BackpropSnapshot::getCompliantContactJacobian(
+    simulation::WorldPtr world)
+{
+  Eigen::MatrixXs J
+      = Eigen::MatrixXs::Zero(3 * mCompliantContacts.size(), mNumDOFs);
+  for (std::size_t i = 0; i < mCompliantContacts.size(); i++)
+  {
+    const constraint::CompliantContact& contact = mCompliantContacts[i];
+    const dynamics::BodyNode* bodies[2]
+        = {contact.getBodyNodeA(), contact.getBodyNodeB()};
+    for (int side = 0; side < 2; side++)
+    {
+      // Bodies that can't move don't get pushed in the forward pass either
+      const dynamics::BodyNode* body = bodies[side];
+      if (!body->isReactive())
+        continue;
+
+      const dynamics::ConstSkeletonPtr skel = body->getSkeleton();
+      const math::Jacobian bodyJac = skel->getWorldJacobian(
+          body, body->getWorldTransform().inverse() * contact.getPoint());
+      J.block(i * 3, mSkeletonOffset[skel->getName()], 3, skel->getNumDofs())
+          += (side == 0 ? 1.0 : -1.0) * bodyJac.bottomRows<3>();
+    }
+  }
+  return J;
+}
+
 //==============================================================================
 const Eigen::MatrixXs& BackpropSnapshot::getBounceApproximationJacobian(
     simulation::WorldPtr world, PerformanceLog* perfLog)
@@ -2052,10 +2520,12 @@ void BackpropSnapshot::benchmarkJacobians(
     for (auto contact : getClampingConstraints())
     {
       contact->mWorldConstraintJacCacheDirty = true;
+      contact->mContactGradientsCache.clear();
     }
     for (auto contact : getUpperBoundConstraints())
     {
       contact->mWorldConstraintJacCacheDirty = true;
+      contact->mContactGradientsCache.clear();
     }
 
     ////////////////////////////////////////////////////////////////////
@@ -2259,6 +2729,52 @@ void BackpropSnapshot::benchmarkJacobians(
             << std::endl;
 }
 
+//==============================================================================
+void BackpropSnapshot::finiteDifferenceInWorld(
+    WorldPtr world,
+    std::function<bool(
+        /* in*/ WorldPtr world,
+        /* in*/ s_t eps,
+        /* in*/ int dof,
+        /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
+    Eigen::MatrixXs& result,
+    s_t eps,
+    bool useRidders)
+{
+  if (world->getNumFDThreads() <= 1)
+  {
+    finiteDifference(
+        [&](s_t eps, int dof, Eigen::VectorXs& perturbed) {
+          return getPerturbed(world, eps, dof, perturbed);
+        },
+        result,
+        eps,
+        useRidders);
+    return;
+  }
+
+  math::parallelFiniteDifference(
+      [&]() -> std::function<bool(s_t, int, Eigen::VectorXs&)> {
+        // World::clone() doesn't carry over the state we perturb around, or
+        // the settings the callers temporarily change, so copy those by hand
+        WorldPtr clone = world->clone();
+        clone->setPositions(world->getPositions());
+        clone->setVelocities(world->getVelocities());
+        clone->setControlForces(world->getControlForces());
+        clone->setCachedLCPSolution(world->getCachedLCPSolution());
+        clone->getConstraintSolver()->setGradientEnabled(
+            world->getConstraintSolver()->getGradientEnabled());
+        return [getPerturbed, clone](
+                   s_t eps, int dof, Eigen::VectorXs& perturbed) {
+          return getPerturbed(clone, eps, dof, perturbed);
+        };
+      },
+      result,
+      eps,
+      useRidders,
+      world->getNumFDThreads());
+}
+
 //==============================================================================
 Eigen::MatrixXs BackpropSnapshot::finiteDifferenceVelVelJacobian(
     WorldPtr world, bool useRidders)
@@ -2271,8 +2787,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferenceVelVelJacobian(
   s_t eps = useRidders ? 1e-4 : 1e-7;
   try
   {
-    finiteDifference(
-        [&](/* in*/ s_t eps,
+    finiteDifferenceInWorld(
+        world,
+        [&](/* in*/ WorldPtr world,
+            /* in*/ s_t eps,
             /* in*/ int dof,
             /*out*/ Eigen::VectorXs& perturbed) {
           world->setPositions(mPreStepPosition);
@@ -2323,8 +2841,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferencePosVelJacobian(
 #endif
   try
   {
-    finiteDifference(
-        [&](/* in*/ s_t eps,
+    finiteDifferenceInWorld(
+        world,
+        [&](/* in*/ WorldPtr world,
+            /* in*/ s_t eps,
             /* in*/ int dof,
             /*out*/ Eigen::VectorXs& perturbed) {
           world->setControlForces(mPreStepTorques);
@@ -2370,8 +2890,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferenceForceVelJacobian(
   s_t eps = useRidders ? 1e-4 : 1e-7;
   try
   {
-    finiteDifference(
-        [&](/* in*/ s_t eps,
+    finiteDifferenceInWorld(
+        world,
+        [&](/* in*/ WorldPtr world,
+            /* in*/ s_t eps,
             /* in*/ int dof,
             /*out*/ Eigen::VectorXs& perturbed) {
           world->setPositions(mPreStepPosition);
@@ -2415,8 +2937,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferenceMassVelJacobian(
   Eigen::MatrixXs result(mNumDOFs, originalMass.size());
 
   s_t eps = useRidders ? 1e-3 : 1e-7;
-  finiteDifference(
-      [&](/* in*/ s_t eps,
+  finiteDifferenceInWorld(
+      world,
+      [&](/* in*/ WorldPtr world,
+          /* in*/ s_t eps,
           /* in*/ int dof,
           /*out*/ Eigen::VectorXs& perturbed) {
         world->setPositions(mPreStepPosition);
@@ -2449,8 +2973,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferencePosPosJacobian(
                        : ((subdivisions > 1) ? (1e-2 / subdivisions) : 1e-6);
   s_t oldTimestep = world->getTimeStep();
   world->setTimeStep(oldTimestep / subdivisions);
-  finiteDifference(
-      [&](/* in*/ s_t eps,
+  finiteDifferenceInWorld(
+      world,
+      [&](/* in*/ WorldPtr world,
+          /* in*/ s_t eps,
           /* in*/ int dof,
           /*out*/ Eigen::VectorXs& perturbed) {
         world->setVelocities(mPreStepVelocity);
@@ -2486,8 +3012,10 @@ Eigen::MatrixXs BackpropSnapshot::finiteDifferenceVelPosJacobian(
                        : ((subdivisions > 1) ? (1e-2 / subdivisions) : 1e-6);
   s_t oldTimestep = world->getTimeStep();
   world->setTimeStep(oldTimestep / subdivisions);
-  finiteDifference(
-      [&](/* in*/ s_t eps,
+  finiteDifferenceInWorld(
+      world,
+      [&](/* in*/ WorldPtr world,
+          /* in*/ s_t eps,
           /* in*/ int dof,
           /*out*/ Eigen::VectorXs& perturbed) {
         world->setPositions(mPreStepPosition);
@@ -2688,17 +3216,7 @@ Eigen::MatrixXs BackpropSnapshot::getProjectionIntoClampsMatrix(
 Eigen::VectorXs BackpropSnapshot::implicitMultiplyByMassMatrix(
     simulation::WorldPtr world, const Eigen::VectorXs& x)
 {
-  Eigen::VectorXs result = x;
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(i);
-    std::size_t dofs = skel->getNumDofs();
-    result.segment(cursor, dofs)
-        = skel->multiplyByImplicitMassMatrix(x.segment(cursor, dofs));
-    cursor += dofs;
-  }
-  return result;
+  return world->multiplyByImplicitMassMatrix(x);
 }
 
 /// This return the result of Minv*x, without explicitly
@@ -2706,17 +3224,7 @@ Eigen::VectorXs BackpropSnapshot::implicitMultiplyByMassMatrix(
 Eigen::VectorXs BackpropSnapshot::implicitMultiplyByInvMassMatrix(
     simulation::WorldPtr world, const Eigen::VectorXs& x)
 {
-  Eigen::VectorXs result = x;
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
-  {
-    SkeletonPtr skel = world->getSkeleton(i);
-    std::size_t dofs = skel->getNumDofs();
-    result.segment(cursor, dofs)
-        = skel->multiplyByImplicitInvMassMatrix(x.segment(cursor, dofs));
-    cursor += dofs;
-  }
-  return result;
+  return world->multiplyByImplicitInvMassMatrix(x);
 }
 
 //==============================================================================
@@ -4214,6 +4722,15 @@ BackpropSnapshot::finiteDifferenceJacobianOfEstimatedConstraintForce(
 //==============================================================================
 Eigen::MatrixXs BackpropSnapshot::assembleMatrix(
     WorldPtr world, MatrixToAssemble whichMatrix)
+{
+  Eigen::MatrixXs matrix;
+  assembleMatrixInto(world, whichMatrix, matrix);
+  return matrix;
+}
+
+//==============================================================================
+void BackpropSnapshot::assembleMatrixInto(
+    WorldPtr world, MatrixToAssemble whichMatrix, Eigen::MatrixXs& matrix)
 {
   std::size_t numCols = 0;
   if (whichMatrix == MatrixToAssemble::CLAMPING
@@ -4226,22 +4743,24 @@ Eigen::MatrixXs BackpropSnapshot::assembleMatrix(
   else if (whichMatrix == MatrixToAssemble::BOUNCING)
     numCols = mNumBouncing;
 
-  Eigen::MatrixXs matrix = Eigen::MatrixXs::Zero(mNumDOFs, numCols);
+  matrix.setZero(mNumDOFs, numCols);
   std::size_t constraintCursor = 0;
   for (std::size_t i = 0; i < mGradientMatrices.size(); i++)
   {
-    Eigen::MatrixXs groupMatrix;
+    const ConstrainedGroupGradientMatrices& group = *mGradientMatrices[i];
+    const Eigen::MatrixXs* groupMatrixPtr = nullptr;
 
     if (whichMatrix == MatrixToAssemble::CLAMPING)
-      groupMatrix = mGradientMatrices[i]->getClampingConstraintMatrix();
+      groupMatrixPtr = &group.getClampingConstraintMatrix();
     else if (whichMatrix == MatrixToAssemble::MASSED_CLAMPING)
-      groupMatrix = mGradientMatrices[i]->getMassedClampingConstraintMatrix();
+      groupMatrixPtr = &group.getMassedClampingConstraintMatrix();
     else if (whichMatrix == MatrixToAssemble::UPPER_BOUND)
-      groupMatrix = mGradientMatrices[i]->getUpperBoundConstraintMatrix();
+      groupMatrixPtr = &group.getUpperBoundConstraintMatrix();
     else if (whichMatrix == MatrixToAssemble::MASSED_UPPER_BOUND)
-      groupMatrix = mGradientMatrices[i]->getMassedUpperBoundConstraintMatrix();
-    else if (whichMatrix == MatrixToAssemble::BOUNCING)
-      groupMatrix = mGradientMatrices[i]->getBouncingConstraintMatrix();
+      groupMatrixPtr = &group.getMassedUpperBoundConstraintMatrix();
+    else
+      groupMatrixPtr = &group.getBouncingConstraintMatrix();
+    const Eigen::MatrixXs& groupMatrix = *groupMatrixPtr;
 
     // shuffle the clamps into the main matrix
     std::size_t dofCursorGroup = 0;
@@ -4276,7 +4795,6 @@ Eigen::MatrixXs BackpropSnapshot::assembleMatrix(
 
     constraintCursor += groupMatrix.cols();
   }
-  return matrix;
 }
 
 Eigen::MatrixXs BackpropSnapshot::assembleBlockDiagonalMatrix(
@@ -4284,7 +4802,19 @@ Eigen::MatrixXs BackpropSnapshot::assembleBlockDiagonalMatrix(
     BackpropSnapshot::BlockDiagonalMatrixToAssemble whichMatrix,
     bool forFiniteDifferencing)
 {
-  Eigen::MatrixXs J = Eigen::MatrixXs::Zero(mNumDOFs, mNumDOFs);
+  Eigen::MatrixXs J;
+  assembleBlockDiagonalMatrixInto(world, whichMatrix, J, forFiniteDifferencing);
+  return J;
+}
+
+//==============================================================================
+void BackpropSnapshot::assembleBlockDiagonalMatrixInto(
+    simulation::WorldPtr world,
+    BackpropSnapshot::BlockDiagonalMatrixToAssemble whichMatrix,
+    Eigen::MatrixXs& J,
+    bool forFiniteDifferencing)
+{
+  J.setZero(mNumDOFs, mNumDOFs);
 
   // If we're not finite differencing, then set the state of the world back to
   // what it was during the forward pass, so that implicit mass matrix
@@ -4337,8 +4867,6 @@ Eigen::MatrixXs BackpropSnapshot::assembleBlockDiagonalMatrix(
     world->setPositions(oldPositions);
     world->setVelocities(oldVelocities);
   }
-
-  return J;
 }
 
 //==============================================================================
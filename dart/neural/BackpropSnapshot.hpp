@@ -6,6 +6,7 @@
 
 #include <Eigen/Dense>
 
+#include "dart/constraint/CompliantContact.hpp"
 #include "dart/neural/DifferentiableContactConstraint.hpp"
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -19,9 +20,12 @@ using namespace performance;
 
 namespace neural {
 
+class SnapshotPool;
+
 class BackpropSnapshot
 {
   friend class MappedBackpropSnapshot;
+  friend class SnapshotPool;
 
 public:
   /// This saves a snapshot from a forward pass, with all the info we need in
@@ -36,11 +40,40 @@ public:
       Eigen::VectorXs preConstraintVelocities,
       Eigen::VectorXs preStepLCPCache);
 
+  /// This re-initializes this snapshot in place from a new forward pass. This
+  /// has the same semantics as the constructor, but it re-uses any buffers we
+  /// already have (including the cached Jacobians), so it doesn't hit the
+  /// allocator if the world dimensions haven't changed. This is what
+  /// SnapshotPool uses to recycle snapshots.
+  void reset(
+      simulation::WorldPtr world,
+      const Eigen::VectorXs& preStepPosition,
+      const Eigen::VectorXs& preStepVelocity,
+      const Eigen::VectorXs& preStepTorques,
+      const Eigen::VectorXs& preConstraintVelocities,
+      const Eigen::VectorXs& preStepLCPCache);
+
+  /// This allocates the storage for all the cached Jacobians up front, sized
+  /// for a world with `numDofs` DOFs and `massDims` tunable mass dimensions.
+  /// The analytical pos-vel, vel-vel, force-vel and mass-vel Jacobians are
+  /// then written into the existing buffers, along with the Minv and
+  /// constraint matrices they're built from (those last only stay put while
+  /// the number of constraints doesn't change). The intermediate Jacobians
+  /// inside those computations, and the finite differenced Jacobians, are
+  /// still allocated fresh.
+  void reserveJacobians(std::size_t numDofs, std::size_t massDims);
+
   /// This computes the implicit backprop without forming intermediate
   /// Jacobians. It takes a LossGradient with the position and velocity vectors
   /// filled it, though the loss with respect to torque is ignored and can be
   /// null. It returns a LossGradient with all three values filled in, position,
   /// velocity, and torque.
+  ///
+  /// If `exploreAlternateStrategies` is true, this backprops through each
+  /// constrained group separately, on as many threads as the world's
+  /// constraint solver solves groups on (see
+  /// ConstraintSolver::setNumGroupSolverThreads()). Otherwise it goes through
+  /// backpropWrt() on the calling thread.
   void backprop(
       simulation::WorldPtr world,
       LossGradient& thisTimestepLoss,
@@ -48,6 +81,25 @@ public:
       PerformanceLog* perfLog = nullptr,
       bool exploreAlternateStrategies = false);
 
+  /// This is a demand-driven version of backprop(). It only fills in the
+  /// components of `thisTimestepLoss` listed in `wrts` (any of
+  /// WithRespectTo::POSITION, WithRespectTo::VELOCITY, WithRespectTo::FORCE,
+  /// and world->getWrtMass()), and leaves the others as zero vectors. It also
+  /// skips any terms where the incoming gradient in `nextTimestepLoss` is all
+  /// zeros, so that (for example) a loss that only depends on velocity never
+  /// forms the pos-pos or vel-pos Jacobians.
+  ///
+  /// If there are no clamping contacts this step, the force, velocity and mass
+  /// gradients are computed matrix-free, using implicit multiplication by
+  /// Minv and WithRespectTo::vjp(), rather than by forming the dense
+  /// Jacobians.
+  void backpropWrt(
+      simulation::WorldPtr world,
+      LossGradient& thisTimestepLoss,
+      const LossGradient& nextTimestepLoss,
+      const std::vector<WithRespectTo*>& wrts,
+      PerformanceLog* perfLog = nullptr);
+
   /// This computes backprop in the high-level RL API's space, use `state` and
   /// `action` as the primitives we're taking gradients wrt to.
   LossGradientHighLevelAPI backpropState(
@@ -295,12 +347,34 @@ public:
   Eigen::MatrixXs getVelJacobianWrt(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
+  /// This is the same as getVelJacobianWrt(), except that it writes into
+  /// `result`, which doesn't allocate if `result` is already the right size.
+  void getVelJacobianWrt(
+      simulation::WorldPtr world, WithRespectTo* wrt, Eigen::MatrixXs& result);
+
   /// This computes and returns the whole wrt-pos jacobian. For backprop, you
   /// don't actually need this matrix, you can compute backprop directly. This
   /// is here if you want access to the full Jacobian for some reason.
   Eigen::MatrixXs getPosJacobianWrt(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
+  /// When compliant contacts are enabled (see
+  /// World::setCompliantContactEnabled()), the contacts add
+  /// dt * Minv * J^T * f(J * v*, depth) to v*, the velocities after the
+  /// unconstrained step. This returns the Jacobian of that term with respect
+  /// to `wrt`, including through v*, which gets added to the vel-vel, pos-vel,
+  /// force-vel and mass-vel Jacobians.
+  ///
+  /// With respect to position, we hold the contact points, normals and J
+  /// fixed, so we only capture the change in penetration depth and in Minv.
+  Eigen::MatrixXs getCompliantContactVelJacobianWrt(
+      simulation::WorldPtr world, WithRespectTo* wrt);
+
+  /// This returns the Jacobian of the relative velocity at each active
+  /// compliant contact with respect to the world's velocities, with 3 rows
+  /// per contact
+  Eigen::MatrixXs getCompliantContactJacobian(simulation::WorldPtr world);
+
   /// This returns the jacobian of constraint force, holding everyhing constant
   /// except the value of WithRespectTo
   Eigen::MatrixXs getJacobianOfConstraintForce(
@@ -653,6 +727,25 @@ public:
       std::shared_ptr<simulation::World> world, int numSamples);
 
 protected:
+  /// This creates an empty snapshot, which must be reset() before use. This is
+  /// only used by SnapshotPool, to allocate snapshots ahead of time.
+  BackpropSnapshot();
+
+  /// This finite differences `result` one column at a time, handing
+  /// `getPerturbed` the World to perturb. If world->getNumFDThreads() is more
+  /// than 1, the columns are split across that many threads, each perturbing
+  /// its own clone of `world`, which starts out in the same state.
+  void finiteDifferenceInWorld(
+      std::shared_ptr<simulation::World> world,
+      std::function<bool(
+          /* in*/ std::shared_ptr<simulation::World> world,
+          /* in*/ s_t eps,
+          /* in*/ int dof,
+          /*out*/ Eigen::VectorXs& perturbed)> getPerturbed,
+      Eigen::MatrixXs& result,
+      s_t eps,
+      bool useRidders);
+
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
   /// bug in the analytical Jacobians that's causing learning to not converge.
@@ -716,6 +809,9 @@ protected:
   /// The torques on all the DOFs of the world AFTER the timestep
   Eigen::VectorXs mPostStepTorques;
 
+  /// The compliant contacts that pushed on the bodies during the timestep
+  std::vector<constraint::CompliantContact> mCompliantContacts;
+
 private:
   /// These are mCached versions of the various Jacobians
   bool mCachedPosPosDirty;
@@ -739,6 +835,13 @@ private:
   bool mCachedVelCDirty;
   Eigen::MatrixXs mCachedVelC;
 
+  /// These are scratch buffers for getVelJacobianWrt(), kept around so that
+  /// pooled snapshots don't reallocate them every step
+  Eigen::MatrixXs mScratchMinv;
+  Eigen::MatrixXs mScratchA_c;
+  Eigen::MatrixXs mScratchA_ub;
+  Eigen::MatrixXs mScratchA_c_ub_E;
+
   Eigen::VectorXs scratch(simulation::WorldPtr world);
 
   enum MatrixToAssemble
@@ -753,6 +856,11 @@ private:
   Eigen::MatrixXs assembleMatrix(
       simulation::WorldPtr world, MatrixToAssemble whichMatrix);
 
+  void assembleMatrixInto(
+      simulation::WorldPtr world,
+      MatrixToAssemble whichMatrix,
+      Eigen::MatrixXs& matrix);
+
   enum BlockDiagonalMatrixToAssemble
   {
     MASS,
@@ -766,6 +874,12 @@ private:
       BlockDiagonalMatrixToAssemble whichMatrix,
       bool forFiniteDifferencing = false);
 
+  void assembleBlockDiagonalMatrixInto(
+      simulation::WorldPtr world,
+      BlockDiagonalMatrixToAssemble whichMatrix,
+      Eigen::MatrixXs& J,
+      bool forFiniteDifferencing = false);
+
   enum VectorToAssemble
   {
     CONTACT_CONSTRAINT_IMPULSES,
@@ -22,7 +22,9 @@ using namespace dynamics;
 using namespace simulation;
 
 #define CLAMPING_THRESHOLD 1e-6
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_CONSTRAINED_GROUP
+#endif
 
 namespace dart {
 namespace neural {
@@ -30,7 +32,10 @@ namespace neural {
 //==============================================================================
 ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
     constraint::ConstrainedGroup& group, s_t timeStep)
-  : mFinalized(false), mDeliberatelyIgnoreFriction(false)
+  : mFinalized(false),
+    mDeliberatelyIgnoreFriction(false),
+    mNumQFactorizations(0),
+    mNumQFactorizationReuses(0)
 {
   mTimeStep = timeStep;
   assert(mClampingConstraints.size() == 0);
@@ -98,6 +103,8 @@ ConstrainedGroupGradientMatrices::ConstrainedGroupGradientMatrices(
   mNumDOFs = numDofs;
   mNumConstraintDim = numConstraintDim;
   mTimeStep = timeStep;
+  mNumQFactorizations = 0;
+  mNumQFactorizationReuses = 0;
 
   mMassedImpulseTests.reserve(mNumConstraintDim);
 }
@@ -166,6 +173,26 @@ void ConstrainedGroupGradientMatrices::measureConstraintImpulse(
   mMassedImpulseTests.push_back(massedImpulseTest);
 }
 
+//==============================================================================
+void ConstrainedGroupGradientMatrices::measureConstraintImpulse(
+    const constraint::ConstraintBasePtr& constraint,
+    std::size_t /* constraintIndex */,
+    const std::vector<Eigen::VectorXs>& velocityChanges)
+{
+  std::vector<SkeletonPtr> skels = constraint->getSkeletons();
+  assert(skels.size() == velocityChanges.size());
+
+  Eigen::VectorXs massedImpulseTest = Eigen::VectorXs::Zero(mNumDOFs);
+  for (std::size_t i = 0; i < skels.size(); i++)
+  {
+    std::size_t offset = mSkeletonOffset[skels[i]->getName()];
+    std::size_t dofs = skels[i]->getNumDofs();
+
+    massedImpulseTest.segment(offset, dofs) = velocityChanges[i];
+  }
+  mMassedImpulseTests.push_back(massedImpulseTest);
+}
+
 //==============================================================================
 void ConstrainedGroupGradientMatrices::mockMeasureConstraintImpulse(
     Eigen::VectorXs massedImpulseTest)
@@ -277,7 +304,7 @@ bool ConstrainedGroupGradientMatrices::opportunisticallyStandardizeResults(
   mStabilizationQ = Q;
   mStabilizationB = b;
 
-  Eigen::VectorXs f_c = Q.completeOrthogonalDecomposition().solve(b);
+  Eigen::VectorXs f_c = getFactoredQ(Q)->solve(b);
   Eigen::VectorXs originalF_c = getClampingConstraintImpulses();
 
   bool anyNewlyNotClamping = false;
@@ -1367,6 +1394,41 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getVelJacobianWrt(
   }
 }
 
+//==============================================================================
+/// This returns a factorization of Q, the LCP matrix restricted to the
+/// clamping constraints. If Q is exactly the same as the last Q we were asked
+/// to factor, we reuse that factorization.
+std::shared_ptr<const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>
+ConstrainedGroupGradientMatrices::getFactoredQ(const Eigen::MatrixXs& Q)
+{
+  std::lock_guard<std::mutex> lock(mFactoredQMutex);
+  if (mFactoredQ && mFactoredQMatrix.rows() == Q.rows()
+      && mFactoredQMatrix.cols() == Q.cols() && mFactoredQMatrix == Q)
+  {
+    mNumQFactorizationReuses++;
+    return mFactoredQ;
+  }
+  mFactoredQMatrix = Q;
+  mFactoredQ = std::make_shared<
+      const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>(Q);
+  mNumQFactorizations++;
+  return mFactoredQ;
+}
+
+//==============================================================================
+std::size_t ConstrainedGroupGradientMatrices::getNumQFactorizations() const
+{
+  std::lock_guard<std::mutex> lock(mFactoredQMutex);
+  return mNumQFactorizations;
+}
+
+//==============================================================================
+std::size_t ConstrainedGroupGradientMatrices::getNumQFactorizationReuses() const
+{
+  std::lock_guard<std::mutex> lock(mFactoredQMutex);
+  return mNumQFactorizationReuses;
+}
+
 //==============================================================================
 /// This returns the jacobian of constraint force, holding everyhing constant
 /// except the value of WithRespectTo
@@ -1387,8 +1449,10 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::getJacobianOfConstraintForce(
   Eigen::MatrixXs Q = A_c.transpose() * Minv * A_c_ub_E;
   Q.diagonal() += getConstraintForceMixingDiagonal();
 
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfac
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>
+      QfacPtr = getFactoredQ(Q);
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfac
+      = *QfacPtr;
 
   Eigen::MatrixXs dB = getJacobianOfLCPOffsetClampingSubset(world, wrt);
 
@@ -1499,8 +1563,10 @@ Eigen::MatrixXs ConstrainedGroupGradientMatrices::
   Eigen::MatrixXs Minv = getInvMassMatrix(world);
   Eigen::MatrixXs Q = A_c.transpose() * Minv * (A_c + A_ub * E);
   Q.diagonal() += getConstraintForceMixingDiagonal();
-  Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs> Qfactored
-      = Q.completeOrthogonalDecomposition();
+  std::shared_ptr<const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>
+      QfactoredPtr = getFactoredQ(Q);
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>& Qfactored
+      = *QfactoredPtr;
 
   Eigen::VectorXs Qinv_b = Qfactored.solve(b);
 
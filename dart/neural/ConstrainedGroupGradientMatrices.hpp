@@ -2,6 +2,7 @@
 #define DART_NEURAL_CONSTRAINT_MATRICES_HPP_
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -70,6 +71,16 @@ public:
       const std::shared_ptr<constraint::ConstraintBase>& constraint,
       std::size_t constraintIndex);
 
+  /// This is the same as measureConstraintImpulse(), except that the velocity
+  /// changes were already computed some other way (for example, from the
+  /// constraint's Jacobian) instead of by applying an impulse.
+  /// `velocityChanges` holds the velocity change of each of the constraint's
+  /// skeletons, in the order that constraint->getSkeletons() returns them.
+  void measureConstraintImpulse(
+      const std::shared_ptr<constraint::ConstraintBase>& constraint,
+      std::size_t constraintIndex,
+      const std::vector<Eigen::VectorXs>& velocityChanges);
+
   /// This will attempt to quickly solve an LCP by exploiting locality in the
   /// solution. Assuming we were initialized at the last solution, there's
   /// actually a good chance that we're still in all the same force categories.
@@ -216,6 +227,23 @@ public:
   Eigen::MatrixXs getJacobianOfConstraintForce(
       simulation::WorldPtr world, WithRespectTo* wrt);
 
+  /// This returns a factorization of Q, the LCP matrix restricted to the
+  /// clamping constraints. Every Jacobian of the constraint forces (one per
+  /// WithRespectTo) needs to solve against the same Q, so we hold on to the
+  /// last factorization we did, and hand it back instead of refactoring if
+  /// we're asked for the same Q again. The factorization we return is never
+  /// modified afterwards, so it's safe to keep using even if another thread
+  /// asks for a different Q.
+  std::shared_ptr<const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>
+  getFactoredQ(const Eigen::MatrixXs& Q);
+
+  /// Returns the number of times getFactoredQ() actually had to factor Q
+  std::size_t getNumQFactorizations() const;
+
+  /// Returns the number of times getFactoredQ() was able to reuse the last
+  /// factorization
+  std::size_t getNumQFactorizationReuses() const;
+
   /// This returns the analytical expression for the Jacobian of Q*b, holding b
   /// constant, if there are some upper-bound indices
   Eigen::MatrixXs dQ_WithUB(
@@ -616,6 +644,14 @@ public:
   Eigen::MatrixXs mStabilizationQ;
   Eigen::VectorXs mStabilizationB;
 
+  /// This is the last Q that getFactoredQ() factored, and its factorization
+  Eigen::MatrixXs mFactoredQMatrix;
+  std::shared_ptr<const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXs>>
+      mFactoredQ;
+  std::size_t mNumQFactorizations;
+  std::size_t mNumQFactorizationReuses;
+  mutable std::mutex mFactoredQMutex;
+
   /// This holds the outputs of the impulse tests we run to create the
   /// constraint matrices. We shuffle these vectors into the columns of
   /// mClampingConstraintMatrix and mUpperBoundConstraintMatrix depending on the
@@ -1117,8 +1117,12 @@ Eigen::Vector6s DifferentiableContactConstraint::getContactWorldForceGradient(
 {
   Eigen::Vector3s position = getContactWorldPosition();
   Eigen::Vector3s force = getContactWorldForceDirection();
-  Eigen::Vector3s forceGradient = getContactForceGradient(dof);
-  Eigen::Vector3s positionGradient = getContactPositionGradient(dof);
+  const Eigen::Matrix<s_t, 6, Eigen::Dynamic>& gradients
+      = getCachedContactGradients(dof->getSkeleton().get());
+  Eigen::Vector3s positionGradient
+      = gradients.block<3, 1>(0, dof->getIndexInSkeleton());
+  Eigen::Vector3s forceGradient
+      = gradients.block<3, 1>(3, dof->getIndexInSkeleton());
 
   Eigen::Vector6s result = Eigen::Vector6s::Zero();
   result.head<3>()
@@ -1127,6 +1131,27 @@ Eigen::Vector6s DifferentiableContactConstraint::getContactWorldForceGradient(
   return result;
 }
 
+//==============================================================================
+const Eigen::Matrix<s_t, 6, Eigen::Dynamic>&
+DifferentiableContactConstraint::getCachedContactGradients(
+    dynamics::Skeleton* skel)
+{
+  ContactGradients& entry = mContactGradientsCache[skel];
+  if (entry.skel.lock().get() != skel
+      || entry.gradients.cols() != skel->getNumDofs())
+  {
+    entry.skel = skel->getPtr();
+    entry.gradients.resize(6, skel->getNumDofs());
+    for (int i = 0; i < skel->getNumDofs(); i++)
+    {
+      dynamics::DegreeOfFreedom* dof = skel->getDof(i);
+      entry.gradients.block<3, 1>(0, i) = getContactPositionGradient(dof);
+      entry.gradients.block<3, 1>(3, i) = getContactForceGradient(dof);
+    }
+  }
+  return entry.gradients;
+}
+
 //==============================================================================
 EdgeData DifferentiableContactConstraint::getEdgeGradient(
     dynamics::DegreeOfFreedom* dof)
@@ -1372,11 +1397,13 @@ DifferentiableContactConstraint::getContactPositionJacobian(
     std::shared_ptr<simulation::World> world)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, world->getNumDofs());
-  int i = 0;
-  for (auto dof : world->getDofs())
+  int cursor = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
   {
-    jac.col(i) = getContactPositionGradient(dof);
-    i++;
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    jac.middleCols(cursor, skel->getNumDofs())
+        = getCachedContactGradients(skel).topRows<3>();
+    cursor += skel->getNumDofs();
   }
   return jac;
 }
@@ -1387,14 +1414,7 @@ math::LinearJacobian
 DifferentiableContactConstraint::getContactPositionJacobian(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
-  math::LinearJacobian jac = math::LinearJacobian::Zero(3, skel->getNumDofs());
-  int i = 0;
-  for (auto dof : skel->getDofs())
-  {
-    jac.col(i) = getContactPositionGradient(dof);
-    i++;
-  }
-  return jac;
+  return getCachedContactGradients(skel.get()).topRows<3>();
 }
 
 //==============================================================================
@@ -1404,13 +1424,14 @@ DifferentiableContactConstraint::getContactForceDirectionJacobian(
     std::shared_ptr<simulation::World> world)
 {
   math::LinearJacobian jac = math::LinearJacobian::Zero(3, world->getNumDofs());
-  int i = 0;
-  for (auto dof : world->getDofs())
+  int cursor = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
   {
-    jac.col(i) = getContactForceGradient(dof);
-    i++;
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    jac.middleCols(cursor, skel->getNumDofs())
+        = getCachedContactGradients(skel).bottomRows<3>();
+    cursor += skel->getNumDofs();
   }
-  assert(i == jac.cols());
   return jac;
 }
 
@@ -1420,14 +1441,7 @@ math::LinearJacobian
 DifferentiableContactConstraint::getContactForceDirectionJacobian(
     std::shared_ptr<dynamics::Skeleton> skel)
 {
-  math::LinearJacobian jac = math::LinearJacobian::Zero(3, skel->getNumDofs());
-  int i = 0;
-  for (auto dof : skel->getDofs())
-  {
-    jac.col(i) = getContactForceGradient(dof);
-    i++;
-  }
-  return jac;
+  return getCachedContactGradients(skel.get()).bottomRows<3>();
 }
 
 //==============================================================================
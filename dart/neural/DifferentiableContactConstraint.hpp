@@ -396,6 +396,23 @@ protected:
   bool mWorldConstraintJacCacheDirty;
   Eigen::MatrixXs mWorldConstraintJacCache;
 
+  /// This returns the gradients of the contact position (top three rows) and
+  /// the contact force direction (bottom three rows) with respect to each of
+  /// skel's DOFs, one column per DOF. These only depend on the positions this
+  /// constraint was created at, so we build them once per skeleton and then
+  /// every contact Jacobian we're asked for is assembled from the cache.
+  const Eigen::Matrix<s_t, 6, Eigen::Dynamic>& getCachedContactGradients(
+      dynamics::Skeleton* skel);
+
+  struct ContactGradients
+  {
+    /// This guards against a freed skeleton's address being reused
+    std::weak_ptr<dynamics::Skeleton> skel;
+    Eigen::Matrix<s_t, 6, Eigen::Dynamic> gradients;
+  };
+  std::unordered_map<const dynamics::Skeleton*, ContactGradients>
+      mContactGradientsCache;
+
   int mIndex;
 
   /// This allows us to locate this constraint in the world arrays. This value
@@ -97,6 +97,10 @@ Eigen::MatrixXs DifferentiableExternalForce::getJacobianOfTauWrt(
   }
   else if (wrt == WithRespectTo::GROUP_SCALES)
   {
+    // Get how every joint moves with every group scale in one pass, rather
+    // than once per (group scale, dof) pair
+    Eigen::MatrixXs jointMovement
+        = mSkel->getGroupScaleMovementOnJointsInWorldSpace();
     for (int col = 0; col < result.cols(); col++)
     {
       for (int i : activeDofs)
@@ -106,9 +110,8 @@ Eigen::MatrixXs DifferentiableExternalForce::getJacobianOfTauWrt(
             = DifferentiableContactConstraint::getWorldScrewAxisForForce(
                 screwDof);
         Eigen::Vector6s rotateWorldTwist = Eigen::Vector6s::Zero();
-        rotateWorldTwist.tail<3>()
-            = mSkel->getGroupScaleMovementOnJointInWorldSpace(
-                col, screwDof->getJoint()->getJointIndexInSkeleton());
+        rotateWorldTwist.tail<3>() = jointMovement.block<3, 1>(
+            screwDof->getJoint()->getJointIndexInSkeleton() * 3, col);
 
         Eigen::Vector6s grad = math::ad(rotateWorldTwist, axisWorldTwist);
         result(i, col) = grad.dot(worldWrench);
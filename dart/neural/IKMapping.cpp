@@ -1,5 +1,8 @@
 #include "dart/neural/IKMapping.hpp"
 
+#include <algorithm>
+
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Frame.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -89,10 +92,20 @@ void IKMapping::setPositions(
 {
   // Reset to 0, so that solutions are always deterministic even if IK is
   // under/over specified
-  world->setPositions(Eigen::VectorXs::Zero(world->getNumDofs()));
+  solvePositions(
+      world, positions, Eigen::VectorXs::Zero(world->getNumDofs()));
+}
+
+//==============================================================================
+void IKMapping::solvePositions(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::VectorXs& positions,
+    const Eigen::VectorXs& initialGuess)
+{
+  world->setPositions(initialGuess);
 
   math::solveIK(
-      Eigen::VectorXs::Zero(world->getNumDofs()),
+      initialGuess,
       world->getPositionUpperLimits(),
       world->getPositionLowerLimits(),
       positions.size(),
@@ -118,6 +131,102 @@ void IKMapping::setPositions(
       math::IKConfig().setMaxStepCount(500).setMaxRestarts(1));
 }
 
+//==============================================================================
+void IKMapping::mapTrajectory(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXs& realPoses,
+    const Eigen::MatrixXs& realVels,
+    const Eigen::MatrixXs& realForces,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> poses,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> vels,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> forces)
+{
+  assert(poses.cols() == realPoses.cols());
+  assert(vels.cols() == realPoses.cols());
+  assert(forces.cols() == realPoses.cols());
+
+  forEachTrajectoryChunk(
+      world,
+      realPoses.cols(),
+      [&](std::shared_ptr<simulation::World> fork, int start, int end) {
+        for (int i = start; i < end; i++)
+        {
+          fork->setPositions(realPoses.col(i));
+          fork->setVelocities(realVels.col(i));
+          fork->setControlForces(realForces.col(i));
+          getPositionsInPlace(fork, poses.col(i));
+          getVelocitiesInPlace(fork, vels.col(i));
+          getControlForcesInPlace(fork, forces.col(i));
+        }
+      });
+}
+
+//==============================================================================
+void IKMapping::unmapTrajectory(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXs& poses,
+    const Eigen::MatrixXs& vels,
+    const Eigen::MatrixXs& forces,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realPoses,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realVels,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realForces)
+{
+  assert(realPoses.cols() == poses.cols());
+  assert(realVels.cols() == poses.cols());
+  assert(realForces.cols() == poses.cols());
+
+  forEachTrajectoryChunk(
+      world,
+      poses.cols(),
+      [&](std::shared_ptr<simulation::World> fork, int start, int end) {
+        Eigen::VectorXs guess = Eigen::VectorXs::Zero(fork->getNumDofs());
+        for (int i = start; i < end; i++)
+        {
+          Eigen::VectorXs vel = vels.col(i);
+          Eigen::VectorXs force = forces.col(i);
+          solvePositions(fork, poses.col(i), guess);
+          guess = fork->getPositions();
+          setVelocities(fork, vel);
+          setControlForces(fork, force);
+          realPoses.col(i) = guess;
+          realVels.col(i) = fork->getVelocities();
+          realForces.col(i) = fork->getControlForces();
+        }
+      });
+}
+
+//==============================================================================
+void IKMapping::forEachTrajectoryChunk(
+    std::shared_ptr<simulation::World> world,
+    int steps,
+    const std::function<
+        void(std::shared_ptr<simulation::World> fork, int start, int end)>& fn)
+{
+  int concurrency = common::TaskScheduler::getGlobal().getMaxConcurrency();
+  int numChunks = std::min(steps, std::max(1, concurrency));
+  if (numChunks <= 0)
+    return;
+
+  // The forks are made (or recycled) up front, on this thread
+  if (mWorldForks.size() < numChunks)
+    mWorldForks.resize(numChunks);
+  for (int i = 0; i < numChunks; i++)
+    mWorldForks[i] = world->fork(mWorldForks[i]);
+
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(numChunks);
+  for (int i = 0; i < numChunks; i++)
+  {
+    int start = (int)((long)steps * i / numChunks);
+    int end = (int)((long)steps * (i + 1) / numChunks);
+    std::shared_ptr<simulation::World> fork = mWorldForks[i];
+    futures.push_back(
+        common::async([&fn, fork, start, end] { fn(fork, start, end); }));
+  }
+  for (auto& future : futures)
+    future.get();
+}
+
 //==============================================================================
 void IKMapping::setVelocities(
     std::shared_ptr<simulation::World> world,
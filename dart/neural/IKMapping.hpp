@@ -1,9 +1,11 @@
 #ifndef DART_NEURAL_IK_MAPPING_HPP_
 #define DART_NEURAL_IK_MAPPING_HPP_
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -91,6 +93,36 @@ public:
       std::shared_ptr<simulation::World> world,
       /* OUT */ Eigen::Ref<Eigen::VectorXs> masses) override;
 
+  /// This maps contiguous chunks of the trajectory concurrently, each on its
+  /// own fork of the world.
+  void mapTrajectory(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::MatrixXs& realPoses,
+      const Eigen::MatrixXs& realVels,
+      const Eigen::MatrixXs& realForces,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> poses,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> vels,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> forces) override;
+
+  /// This runs the IK for contiguous chunks of the trajectory concurrently,
+  /// each on its own fork of the world. Within a chunk, each timestep's IK is
+  /// warm started from the solution at the timestep before it, which is
+  /// usually only a few iterations away. Only the first timestep of each chunk
+  /// starts from zero the way setPositions() does, so when the IK is under
+  /// specified the solutions can differ a little from calling setPositions()
+  /// one timestep at a time.
+  ///
+  /// This isn't safe to call on the same IKMapping from several threads at
+  /// once, because the forks are reused between calls.
+  void unmapTrajectory(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::MatrixXs& poses,
+      const Eigen::MatrixXs& vels,
+      const Eigen::MatrixXs& forces,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realPoses,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realVels,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realForces) override;
+
   /// This gets a Jacobian relating the changes in the inner positions (the
   /// "real" positions) to the corresponding outer positions (the "mapped"
   /// positions)
@@ -172,10 +204,31 @@ protected:
   Eigen::MatrixXs bruteForceJacobianOfJacVelWrtPosition(
       std::shared_ptr<simulation::World> world);
 
+protected:
+  /// This runs the IK for setPositions(), starting from `initialGuess`
+  void solvePositions(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::VectorXs& positions,
+      const Eigen::VectorXs& initialGuess);
+
+  /// This splits `steps` timesteps into one contiguous chunk per worker
+  /// thread, and calls `fn(fork, start, end)` for each chunk concurrently on
+  /// its own fork of `world`
+  void forEachTrajectoryChunk(
+      std::shared_ptr<simulation::World> world,
+      int steps,
+      const std::function<
+          void(std::shared_ptr<simulation::World> fork, int start, int end)>&
+          fn);
+
   std::vector<IKMappingEntry> mEntries;
 
   int mMassDim;
   int mIKIterationLimit;
+
+  /// These are recycled between calls to mapTrajectory() and
+  /// unmapTrajectory(), see World::fork()
+  std::vector<std::shared_ptr<simulation::World>> mWorldForks;
 };
 
 } // namespace neural
@@ -9,7 +9,9 @@
 // Make production builds happy with asserts
 #define _unused(x) ((void)(x))
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_MAPPED_BACKPROP_SNAPSHOT ;
+#endif
 
 using namespace dart;
 using namespace performance;
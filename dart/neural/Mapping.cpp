@@ -223,6 +223,68 @@ Eigen::MatrixXs Mapping::finiteDifferenceRealPosToMappedVelJac(
   return result;
 }
 
+//==============================================================================
+/// This maps a whole trajectory of real states, one column per timestep,
+/// into this mapping's space. The world is restored when we're done.
+void Mapping::mapTrajectory(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXs& realPoses,
+    const Eigen::MatrixXs& realVels,
+    const Eigen::MatrixXs& realForces,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> poses,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> vels,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> forces)
+{
+  assert(poses.cols() == realPoses.cols());
+  assert(vels.cols() == realPoses.cols());
+  assert(forces.cols() == realPoses.cols());
+
+  RestorableSnapshot snapshot(world);
+  for (int i = 0; i < realPoses.cols(); i++)
+  {
+    world->setPositions(realPoses.col(i));
+    world->setVelocities(realVels.col(i));
+    world->setControlForces(realForces.col(i));
+    getPositionsInPlace(world, poses.col(i));
+    getVelocitiesInPlace(world, vels.col(i));
+    getControlForcesInPlace(world, forces.col(i));
+  }
+  snapshot.restore();
+}
+
+//==============================================================================
+/// This is the inverse of mapTrajectory(), and recovers the real states for
+/// every timestep of a trajectory in this mapping's space. The world is
+/// restored when we're done.
+void Mapping::unmapTrajectory(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::MatrixXs& poses,
+    const Eigen::MatrixXs& vels,
+    const Eigen::MatrixXs& forces,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realPoses,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realVels,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> realForces)
+{
+  assert(realPoses.cols() == poses.cols());
+  assert(realVels.cols() == poses.cols());
+  assert(realForces.cols() == poses.cols());
+
+  RestorableSnapshot snapshot(world);
+  for (int i = 0; i < poses.cols(); i++)
+  {
+    Eigen::VectorXs pos = poses.col(i);
+    Eigen::VectorXs vel = vels.col(i);
+    Eigen::VectorXs force = forces.col(i);
+    setPositions(world, pos);
+    setVelocities(world, vel);
+    setControlForces(world, force);
+    realPoses.col(i) = world->getPositions();
+    realVels.col(i) = world->getVelocities();
+    realForces.col(i) = world->getControlForces();
+  }
+  snapshot.restore();
+}
+
 //==============================================================================
 Eigen::VectorXs Mapping::getPositions(std::shared_ptr<simulation::World> world)
 {
@@ -62,6 +62,29 @@ public:
       /* OUT */ Eigen::Ref<Eigen::VectorXs> masses)
       = 0;
 
+  /// This maps a whole trajectory of real states, one column per timestep,
+  /// into this mapping's space. The world is restored when we're done.
+  virtual void mapTrajectory(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::MatrixXs& realPoses,
+      const Eigen::MatrixXs& realVels,
+      const Eigen::MatrixXs& realForces,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> poses,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> vels,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> forces);
+
+  /// This is the inverse of mapTrajectory(), and recovers the real states for
+  /// every timestep of a trajectory in this mapping's space. The world is
+  /// restored when we're done.
+  virtual void unmapTrajectory(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::MatrixXs& poses,
+      const Eigen::MatrixXs& vels,
+      const Eigen::MatrixXs& forces,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realPoses,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realVels,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> realForces);
+
   Eigen::VectorXs getPositions(std::shared_ptr<simulation::World> world);
   Eigen::VectorXs getVelocities(std::shared_ptr<simulation::World> world);
   Eigen::VectorXs getControlForces(std::shared_ptr<simulation::World> world);
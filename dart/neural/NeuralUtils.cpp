@@ -4,12 +4,15 @@
 #include <thread>
 
 #include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/Joint.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/MappedBackpropSnapshot.hpp"
 #include "dart/neural/Mapping.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/SnapshotPool.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
@@ -50,14 +53,29 @@ std::shared_ptr<BackpropSnapshot> forwardPass(
   world->getConstraintSolver()->setGradientEnabled(oldGradientEnabled);
 
   // Actually construct and return the snapshot
-  std::shared_ptr<BackpropSnapshot> snapshot
-      = std::make_shared<BackpropSnapshot>(
-          world,
-          preStepPosition,
-          preStepVelocity,
-          preStepTorques,
-          world->getLastPreConstraintVelocity(),
-          preStepLCPCache);
+  std::shared_ptr<BackpropSnapshot> snapshot;
+  if (world->getSnapshotPoolEnabled())
+  {
+    std::shared_ptr<SnapshotPool> pool = world->getSnapshotPool();
+    pool->setDimensions(world->getNumDofs(), world->getMassDims());
+    snapshot = pool->acquire(
+        world,
+        preStepPosition,
+        preStepVelocity,
+        preStepTorques,
+        world->getLastPreConstraintVelocity(),
+        preStepLCPCache);
+  }
+  else
+  {
+    snapshot = std::make_shared<BackpropSnapshot>(
+        world,
+        preStepPosition,
+        preStepVelocity,
+        preStepTorques,
+        world->getLastPreConstraintVelocity(),
+        preStepLCPCache);
+  }
 
   if (idempotent)
     restorableSnapshot->restore();
@@ -195,6 +213,121 @@ Eigen::MatrixXs jointVelToWorldLinearJacobian(
   return jac;
 }
 
+//==============================================================================
+/// This fills `block` with the world Jacobian of `node` with respect to each
+/// of the DOFs it depends on, in the order of getDependentGenCoordIndices().
+/// Position Jacobians match Skeleton::getWorldPositionJacobian(), and
+/// velocity Jacobians match Skeleton::getWorldJacobian().
+static void getNodeWorldJacobianBlock(
+    dynamics::BodyNode* node, bool position, Eigen::MatrixXs& block)
+{
+  if (!position)
+  {
+    block = node->getWorldJacobian();
+    return;
+  }
+
+  const std::vector<std::size_t>& dofs = node->getDependentGenCoordIndices();
+  const dynamics::Skeleton* skel = node->getSkeleton().get();
+  Eigen::Vector3s originalRotation
+      = math::logMap(node->getWorldTransform().linear());
+  Eigen::Vector3s origin = node->getWorldTransform().translation();
+  block.resize(6, dofs.size());
+  for (std::size_t i = 0; i < dofs.size(); i++)
+  {
+    const dynamics::DegreeOfFreedom* dof = skel->getDof(dofs[i]);
+    Eigen::Vector6s screw = dof->getJoint()->getWorldAxisScrewForPosition(
+        dof->getIndexInJoint());
+    screw.tail<3>() += screw.head<3>().cross(origin);
+    screw.head<3>()
+        = math::expMapNestedGradient(originalRotation, screw.head<3>());
+    block.col(i) = screw;
+  }
+}
+
+//==============================================================================
+Eigen::MatrixXs BlockedWorldJacobian::toDense() const
+{
+  Eigen::MatrixXs jac
+      = Eigen::MatrixXs::Zero(blocks.size() * rowsPerNode, numDofs);
+  for (std::size_t i = 0; i < blocks.size(); i++)
+  {
+    for (std::size_t j = 0; j < dofs[i].size(); j++)
+    {
+      jac.block(i * rowsPerNode, dofs[i][j], rowsPerNode, 1) = blocks[i].col(j);
+    }
+  }
+  return jac;
+}
+
+//==============================================================================
+Eigen::VectorXs BlockedWorldJacobian::multiply(const Eigen::VectorXs& x) const
+{
+  assert(x.size() == numDofs);
+  Eigen::VectorXs out = Eigen::VectorXs::Zero(blocks.size() * rowsPerNode);
+  for (std::size_t i = 0; i < blocks.size(); i++)
+  {
+    for (std::size_t j = 0; j < dofs[i].size(); j++)
+    {
+      out.segment(i * rowsPerNode, rowsPerNode)
+          += blocks[i].col(j) * x(dofs[i][j]);
+    }
+  }
+  return out;
+}
+
+//==============================================================================
+Eigen::VectorXs BlockedWorldJacobian::transposeMultiply(
+    const Eigen::VectorXs& y) const
+{
+  assert(y.size() == blocks.size() * rowsPerNode);
+  Eigen::VectorXs out = Eigen::VectorXs::Zero(numDofs);
+  for (std::size_t i = 0; i < blocks.size(); i++)
+  {
+    for (std::size_t j = 0; j < dofs[i].size(); j++)
+    {
+      out(dofs[i][j])
+          += blocks[i].col(j).dot(y.segment(i * rowsPerNode, rowsPerNode));
+    }
+  }
+  return out;
+}
+
+//==============================================================================
+BlockedWorldJacobian jointToWorldBlockedJacobian(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::vector<dynamics::BodyNode*>& nodes,
+    ConvertToSpace space)
+{
+  assert(
+      space == ConvertToSpace::POS_SPATIAL
+      || space == ConvertToSpace::POS_LINEAR
+      || space == ConvertToSpace::VEL_SPATIAL
+      || space == ConvertToSpace::VEL_LINEAR);
+  bool position = space == ConvertToSpace::POS_SPATIAL
+                  || space == ConvertToSpace::POS_LINEAR;
+  bool linear = space == ConvertToSpace::POS_LINEAR
+                || space == ConvertToSpace::VEL_LINEAR;
+
+  BlockedWorldJacobian jac;
+  jac.rowsPerNode = linear ? 3 : 6;
+  jac.numDofs = skel->getNumDofs();
+  jac.dofs.resize(nodes.size());
+  jac.blocks.resize(nodes.size());
+  for (std::size_t i = 0; i < nodes.size(); i++)
+  {
+    dynamics::BodyNode* node
+        = skel->getBodyNode(nodes[i]->getIndexInSkeleton());
+    jac.dofs[i] = node->getDependentGenCoordIndices();
+    getNodeWorldJacobianBlock(node, position, jac.blocks[i]);
+    if (linear)
+    {
+      jac.blocks[i] = jac.blocks[i].bottomRows<3>().eval();
+    }
+  }
+  return jac;
+}
+
 //==============================================================================
 Eigen::VectorXs skelConvertJointSpaceToWorldSpace(
     const std::shared_ptr<dynamics::Skeleton>& skel,
@@ -247,8 +380,9 @@ Eigen::VectorXs skelConvertJointSpaceToWorldSpace(
       || space == ConvertToSpace::COM_VEL_LINEAR
       || space == ConvertToSpace::COM_VEL_SPATIAL)
   {
-    Eigen::MatrixXs jac = jointVelToWorldSpatialJacobian(skel, nodes);
-    Eigen::VectorXs spatialVel = jac * jointValues;
+    Eigen::VectorXs spatialVel
+        = jointToWorldBlockedJacobian(skel, nodes, ConvertToSpace::VEL_SPATIAL)
+              .multiply(jointValues);
 
     if (space == ConvertToSpace::VEL_SPATIAL)
     {
@@ -303,6 +437,21 @@ Eigen::VectorXs skelBackpropWorldSpaceToJointSpace(
     ConvertToSpace space, /* This is the source space for our gradient */
     bool useIK)
 {
+  if (!useIK)
+  {
+    switch (space)
+    {
+      case ConvertToSpace::POS_LINEAR:
+      case ConvertToSpace::VEL_LINEAR:
+      case ConvertToSpace::POS_SPATIAL:
+      case ConvertToSpace::VEL_SPATIAL:
+        return skelBackpropWorldSpaceToJointSpaceFused(
+            skel, bodySpace, nodes, space);
+      default:
+        break;
+    }
+  }
+
   Eigen::MatrixXs jac;
   if (space == ConvertToSpace::POS_LINEAR)
   {
@@ -355,6 +504,43 @@ Eigen::VectorXs skelBackpropWorldSpaceToJointSpace(
   }
 }
 
+//==============================================================================
+Eigen::VectorXs skelBackpropWorldSpaceToJointSpaceFused(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const Eigen::VectorXs& bodySpace, /* This is the gradient in body space */
+    const std::vector<dynamics::BodyNode*>& nodes,
+    ConvertToSpace space /* This is the source space for our gradient */)
+{
+  bool position = space == ConvertToSpace::POS_SPATIAL
+                  || space == ConvertToSpace::POS_LINEAR;
+  bool linear = space == ConvertToSpace::POS_LINEAR
+                || space == ConvertToSpace::VEL_LINEAR;
+  if (!position && !linear && space != ConvertToSpace::VEL_SPATIAL)
+  {
+    // The COM Jacobians are only ever 3 or 6 rows, so there's nothing to save
+    return skelBackpropWorldSpaceToJointSpace(
+        skel, bodySpace, nodes, space, false);
+  }
+
+  int rowsPerNode = linear ? 3 : 6;
+  assert(bodySpace.size() == nodes.size() * rowsPerNode);
+  Eigen::VectorXs out = Eigen::VectorXs::Zero(skel->getNumDofs());
+  Eigen::MatrixXs block;
+  for (std::size_t i = 0; i < nodes.size(); i++)
+  {
+    dynamics::BodyNode* node
+        = skel->getBodyNode(nodes[i]->getIndexInSkeleton());
+    getNodeWorldJacobianBlock(node, position, block);
+    Eigen::VectorXs grad = bodySpace.segment(i * rowsPerNode, rowsPerNode);
+    const std::vector<std::size_t>& dofs = node->getDependentGenCoordIndices();
+    for (std::size_t j = 0; j < dofs.size(); j++)
+    {
+      out(dofs[j]) += block.col(j).tail(rowsPerNode).dot(grad);
+    }
+  }
+  return out;
+}
+
 //==============================================================================
 Eigen::MatrixXs convertJointSpaceToWorldSpace(
     const std::shared_ptr<simulation::World>& world,
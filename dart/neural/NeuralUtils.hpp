@@ -122,6 +122,38 @@ Eigen::MatrixXs jointVelToWorldLinearJacobian(
     const std::shared_ptr<dynamics::Skeleton>& skel,
     const std::vector<dynamics::BodyNode*>& nodes);
 
+/// This is one of the Jacobians above, stored one body at a time. Each body
+/// only depends on the DOFs of its ancestors, so block i is only as wide as
+/// nodes[i]->getNumDependentGenCoords(), and dofs[i] says which skeleton DOF
+/// each of its columns belongs to.
+struct BlockedWorldJacobian
+{
+  /// 6 for spatial Jacobians, 3 for linear ones
+  int rowsPerNode;
+  /// The number of columns of the equivalent dense Jacobian
+  int numDofs;
+  std::vector<std::vector<std::size_t>> dofs;
+  std::vector<Eigen::MatrixXs> blocks;
+
+  /// This builds the equivalent dense Jacobian
+  Eigen::MatrixXs toDense() const;
+
+  /// This computes J * x without building J
+  Eigen::VectorXs multiply(const Eigen::VectorXs& x) const;
+
+  /// This computes J^T * y without building J
+  Eigen::VectorXs transposeMultiply(const Eigen::VectorXs& y) const;
+};
+
+/// This computes the same Jacobian as jointPosToWorldSpatialJacobian(),
+/// jointPosToWorldLinearJacobian(), jointVelToWorldSpatialJacobian() or
+/// jointVelToWorldLinearJacobian(), depending on `space`, but in blocked form.
+/// `space` must be one of POS_SPATIAL, POS_LINEAR, VEL_SPATIAL or VEL_LINEAR.
+BlockedWorldJacobian jointToWorldBlockedJacobian(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const std::vector<dynamics::BodyNode*>& nodes,
+    ConvertToSpace space);
+
 /// Convert a set of joint positions to a vector of body positions in world
 /// space (expressed in log space).
 Eigen::VectorXs skelConvertJointSpaceToWorldSpace(
@@ -139,6 +171,16 @@ Eigen::VectorXs skelBackpropWorldSpaceToJointSpace(
     ConvertToSpace space, /* This is the source space for our gradient */
     bool useIK = true);
 
+/// This is the same as skelBackpropWorldSpaceToJointSpace() with
+/// `useIK = false`, but it walks the bodies one at a time and accumulates
+/// each body's contribution straight into the joint gradient, so no part of
+/// the Jacobian is ever stored.
+Eigen::VectorXs skelBackpropWorldSpaceToJointSpaceFused(
+    const std::shared_ptr<dynamics::Skeleton>& skel,
+    const Eigen::VectorXs& bodySpace, /* This is the gradient in body space */
+    const std::vector<dynamics::BodyNode*>& nodes,
+    ConvertToSpace space /* This is the source space for our gradient */);
+
 } // namespace neural
 } // namespace dart
 
@@ -15,36 +15,18 @@ namespace neural {
 RestorableSnapshot::RestorableSnapshot(std::shared_ptr<World> world)
 {
   mWorld = world;
-  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
-  {
-    mSkeletonConfigurations.push_back(world->getSkeleton(i)->getConfiguration(
-        Skeleton::ConfigFlags::CONFIG_ALL));
-  }
-  mLCPCache = world->getCachedLCPSolution();
+  mWorld->saveStateTo(mState);
 }
 
 void RestorableSnapshot::restore()
 {
-  for (std::size_t i = 0; i < mWorld->getNumSkeletons(); i++)
-  {
-    mWorld->getSkeleton(i)->setConfiguration(mSkeletonConfigurations[i]);
-  }
-  mWorld->setCachedLCPSolution(mLCPCache);
+  mWorld->loadStateFrom(mState);
 }
 
 bool RestorableSnapshot::isPreserved()
 {
-  if (mWorld->getCachedLCPSolution() != mLCPCache)
-    return false;
-  for (std::size_t i = 0; i < mWorld->getNumSkeletons(); i++)
-  {
-    dynamics::Skeleton::Configuration config
-        = mWorld->getSkeleton(i)->getConfiguration(
-            Skeleton::ConfigFlags::CONFIG_ALL);
-    if (mSkeletonConfigurations[i] != config)
-      return false;
-  }
-  return true;
+  mWorld->saveStateTo(mScratch);
+  return mScratch == mState;
 }
 
 } // namespace neural
@@ -26,8 +26,10 @@ public:
 
 private:
   std::shared_ptr<simulation::World> mWorld;
-  Eigen::VectorXs mLCPCache;
-  std::vector<dynamics::Skeleton::Configuration> mSkeletonConfigurations;
+  // This is the blob from World::saveStateTo()
+  Eigen::VectorXs mState;
+  // This is scratch space for isPreserved(), so checking doesn't allocate
+  Eigen::VectorXs mScratch;
 };
 
 } // namespace neural
@@ -0,0 +1,145 @@
+#include "dart/neural/SnapshotPool.hpp"
+
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+SnapshotPool::SnapshotPool(
+    std::size_t numDofs, std::size_t massDims, int maxPooled)
+  : mNumDofs(numDofs),
+    mMassDims(massDims),
+    mMaxPooled(maxPooled),
+    mNumAllocated(0)
+{
+}
+
+//==============================================================================
+SnapshotPool::~SnapshotPool()
+{
+  // Any snapshots still checked out hold a weak_ptr to us, so they'll just be
+  // freed normally when they're released.
+}
+
+//==============================================================================
+std::shared_ptr<BackpropSnapshot> SnapshotPool::acquire(
+    std::shared_ptr<simulation::World> world,
+    const Eigen::VectorXs& preStepPosition,
+    const Eigen::VectorXs& preStepVelocity,
+    const Eigen::VectorXs& preStepTorques,
+    const Eigen::VectorXs& preConstraintVelocities,
+    const Eigen::VectorXs& preStepLCPCache)
+{
+  std::unique_ptr<BackpropSnapshot> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFree.empty())
+    {
+      snapshot = std::move(mFree.back());
+      mFree.pop_back();
+    }
+    else
+    {
+      snapshot.reset(new BackpropSnapshot());
+      snapshot->reserveJacobians(mNumDofs, mMassDims);
+      mNumAllocated++;
+    }
+  }
+
+  snapshot->reset(
+      world,
+      preStepPosition,
+      preStepVelocity,
+      preStepTorques,
+      preConstraintVelocities,
+      preStepLCPCache);
+
+  std::weak_ptr<SnapshotPool> weakPool = shared_from_this();
+  return std::shared_ptr<BackpropSnapshot>(
+      snapshot.release(), [weakPool](BackpropSnapshot* ptr) {
+        std::shared_ptr<SnapshotPool> pool = weakPool.lock();
+        if (pool)
+        {
+          pool->release(ptr);
+        }
+        else
+        {
+          delete ptr;
+        }
+      });
+}
+
+//==============================================================================
+void SnapshotPool::reserve(std::size_t count)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  while (mFree.size() < count)
+  {
+    std::unique_ptr<BackpropSnapshot> snapshot(new BackpropSnapshot());
+    snapshot->reserveJacobians(mNumDofs, mMassDims);
+    mFree.push_back(std::move(snapshot));
+    mNumAllocated++;
+  }
+}
+
+//==============================================================================
+void SnapshotPool::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFree.clear();
+}
+
+//==============================================================================
+std::size_t SnapshotPool::getNumPooled()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFree.size();
+}
+
+//==============================================================================
+std::size_t SnapshotPool::getNumAllocated()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumAllocated;
+}
+
+//==============================================================================
+void SnapshotPool::setDimensions(std::size_t numDofs, std::size_t massDims)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (numDofs != mNumDofs || massDims != mMassDims)
+  {
+    mNumDofs = numDofs;
+    mMassDims = massDims;
+    mFree.clear();
+  }
+}
+
+//==============================================================================
+void SnapshotPool::release(BackpropSnapshot* snapshot)
+{
+  std::unique_ptr<BackpropSnapshot> owned(snapshot);
+  // Drop our references to the constrained groups right away, so that we're
+  // not keeping the last step's gradient matrices alive while pooled.
+  owned->mGradientMatrices.clear();
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mMaxPooled >= 0 && mFree.size() >= static_cast<std::size_t>(mMaxPooled))
+  {
+    // The pool is full, `owned` frees the snapshot on the way out
+    return;
+  }
+  // If the dimensions changed while this snapshot was checked out, its
+  // buffers are the wrong size to be worth recycling, so free it too
+  if (owned->mNumDOFs != mNumDofs
+      || static_cast<std::size_t>(owned->mCachedMassVel.cols()) != mMassDims)
+  {
+    return;
+  }
+  mFree.push_back(std::move(owned));
+}
+
+} // namespace neural
+} // namespace dart
@@ -0,0 +1,93 @@
+#ifndef DART_NEURAL_SNAPSHOT_POOL_HPP_
+#define DART_NEURAL_SNAPSHOT_POOL_HPP_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+class BackpropSnapshot;
+
+/// This hands out BackpropSnapshot objects that get recycled once every
+/// shared_ptr to them is released, instead of being freed. A recycled snapshot
+/// keeps all of its vectors and cached Jacobian buffers, so for long
+/// trajectories where the world dimensions don't change we stop paying for a
+/// fresh round of allocations on every timestep.
+///
+/// Each World owns one of these (see World::getSnapshotPool()), and
+/// forwardPass() draws from it when World::setSnapshotPoolEnabled(true) has
+/// been called.
+class SnapshotPool : public std::enable_shared_from_this<SnapshotPool>
+{
+public:
+  /// Snapshots handed out by this pool are preallocated for a world with
+  /// `numDofs` DOFs and `massDims` tunable mass dimensions. If more than
+  /// `maxPooled` snapshots are released back to us at once, the excess ones
+  /// are freed. A `maxPooled` of -1 means the pool is unbounded.
+  SnapshotPool(std::size_t numDofs, std::size_t massDims, int maxPooled = -1);
+
+  ~SnapshotPool();
+
+  /// This returns a snapshot from the pool (or a freshly allocated one, if the
+  /// pool is empty) initialized from the results of a forward pass. The
+  /// arguments have the same meaning as the BackpropSnapshot constructor.
+  std::shared_ptr<BackpropSnapshot> acquire(
+      std::shared_ptr<simulation::World> world,
+      const Eigen::VectorXs& preStepPosition,
+      const Eigen::VectorXs& preStepVelocity,
+      const Eigen::VectorXs& preStepTorques,
+      const Eigen::VectorXs& preConstraintVelocities,
+      const Eigen::VectorXs& preStepLCPCache);
+
+  /// This allocates snapshots until there are at least `count` sitting in the
+  /// pool ready to be handed out.
+  void reserve(std::size_t count);
+
+  /// This frees all the snapshots currently sitting in the pool. Snapshots
+  /// that are still checked out are unaffected, and will still be returned to
+  /// the pool when they're released.
+  void clear();
+
+  /// Returns the number of snapshots currently sitting in the pool, ready to
+  /// be handed out.
+  std::size_t getNumPooled();
+
+  /// Returns the number of snapshots this pool has allocated over its
+  /// lifetime. If this keeps growing over a long rollout, the caller is
+  /// holding on to snapshots and the pool isn't getting to recycle anything.
+  std::size_t getNumAllocated();
+
+  /// This changes the dimensions that newly allocated snapshots will be
+  /// preallocated for. If the dimensions changed, this also clears out any
+  /// pooled snapshots, since their buffers are the wrong size.
+  void setDimensions(std::size_t numDofs, std::size_t massDims);
+
+protected:
+  /// This is the deleter for all the shared_ptrs we hand out. It puts the
+  /// snapshot back in the pool, or frees it if the pool is full or the
+  /// snapshot was sized for different dimensions than the pool's current ones.
+  void release(BackpropSnapshot* snapshot);
+
+  std::mutex mMutex;
+  std::vector<std::unique_ptr<BackpropSnapshot>> mFree;
+  std::size_t mNumDofs;
+  std::size_t mMassDims;
+  int mMaxPooled;
+  std::size_t mNumAllocated;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
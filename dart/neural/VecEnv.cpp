@@ -0,0 +1,193 @@
+#include "dart/neural/VecEnv.hpp"
+
+#include <iostream>
+#include <limits>
+
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+VecEnv::VecEnv(
+    std::shared_ptr<simulation::World> world, int numEnvs, int numThreads)
+  : WorldBatch(world, numEnvs, numThreads),
+    mResetStates(world->getState()),
+    mNextResetState(0),
+    mMaxEpisodeSteps(0),
+    mStateLowerBounds(Eigen::VectorXs::Constant(
+        mStateSize, -std::numeric_limits<s_t>::infinity())),
+    mStateUpperBounds(Eigen::VectorXs::Constant(
+        mStateSize, std::numeric_limits<s_t>::infinity())),
+    mEpisodeSteps(Eigen::VectorXi::Zero(numEnvs)),
+    mTerminalObservations(RowMatrixXs::Zero(numEnvs, mStateSize))
+{
+}
+
+//==============================================================================
+int VecEnv::getNumEnvs() const
+{
+  return mWorlds.size();
+}
+
+//==============================================================================
+void VecEnv::setResetStates(const Eigen::MatrixXs& states)
+{
+  if (states.rows() != mStateSize || states.cols() == 0)
+  {
+    std::cerr << "VecEnv::setResetStates() called with states of incorrect "
+                 "size ("
+              << states.rows() << "x" << states.cols() << "), when it needs "
+              << mStateSize << " rows and at least one column. Ignoring call."
+              << std::endl;
+    return;
+  }
+  mResetStates = states;
+  mNextResetState = 0;
+}
+
+//==============================================================================
+void VecEnv::setMaxEpisodeSteps(int maxEpisodeSteps)
+{
+  mMaxEpisodeSteps = std::max(0, maxEpisodeSteps);
+}
+
+//==============================================================================
+void VecEnv::setStateBounds(
+    const Eigen::VectorXs& lower, const Eigen::VectorXs& upper)
+{
+  if (!checkSize("setStateBounds", "lower", lower.size(), 1, mStateSize, 1)
+      || !checkSize("setStateBounds", "upper", upper.size(), 1, mStateSize, 1))
+  {
+    return;
+  }
+  mStateLowerBounds = lower;
+  mStateUpperBounds = upper;
+}
+
+//==============================================================================
+void VecEnv::setDoneFn(
+    std::function<bool(int env, const Eigen::VectorXs& state)> fn)
+{
+  mDoneFn = fn;
+}
+
+//==============================================================================
+void VecEnv::reset(Eigen::Ref<RowMatrixXs> observations)
+{
+  if (!checkSize(
+          "reset",
+          "observations",
+          observations.rows(),
+          observations.cols(),
+          mWorlds.size(),
+          mStateSize))
+  {
+    return;
+  }
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    resetEnv(i);
+    observations.row(i) = mWorlds[i]->getState().transpose();
+  }
+}
+
+//==============================================================================
+void VecEnv::step(
+    const Eigen::Ref<const RowMatrixXs>& actions,
+    Eigen::Ref<RowMatrixXs> observations,
+    Eigen::Ref<Eigen::VectorXi> dones)
+{
+  if (!checkSize(
+          "step",
+          "actions",
+          actions.rows(),
+          actions.cols(),
+          mWorlds.size(),
+          mActionSize)
+      || !checkSize(
+          "step",
+          "observations",
+          observations.rows(),
+          observations.cols(),
+          mWorlds.size(),
+          mStateSize)
+      || !checkSize(
+          "step", "dones", dones.size(), 1, mWorlds.size(), 1))
+  {
+    return;
+  }
+
+  parallelForEachWorld([&](int i) {
+    std::shared_ptr<simulation::World>& world = mWorlds[i];
+    world->setAction(actions.row(i).transpose());
+    world->step();
+    Eigen::VectorXs state = world->getState();
+    mEpisodeSteps(i)++;
+    bool done
+        = (mMaxEpisodeSteps > 0 && mEpisodeSteps(i) >= mMaxEpisodeSteps)
+          || (state.array() < mStateLowerBounds.array()).any()
+          || (state.array() > mStateUpperBounds.array()).any()
+          || (mDoneFn && mDoneFn(i, state));
+    dones(i) = done ? 1 : 0;
+    if (done)
+    {
+      mTerminalObservations.row(i) = state.transpose();
+    }
+    observations.row(i) = state.transpose();
+  });
+
+  // We reset in order of environment index, so which reset state each
+  // environment gets doesn't depend on how the threads were scheduled
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    if (dones(i))
+    {
+      resetEnv(i);
+      observations.row(i) = mWorlds[i]->getState().transpose();
+    }
+  }
+}
+
+//==============================================================================
+const VecEnv::RowMatrixXs& VecEnv::getTerminalObservations() const
+{
+  return mTerminalObservations;
+}
+
+//==============================================================================
+const Eigen::VectorXi& VecEnv::getEpisodeSteps() const
+{
+  return mEpisodeSteps;
+}
+
+//==============================================================================
+void VecEnv::resetEnv(int env)
+{
+  mWorlds[env]->setState(mResetStates.col(mNextResetState));
+  mNextResetState = (mNextResetState + 1) % mResetStates.cols();
+  mEpisodeSteps(env) = 0;
+}
+
+//==============================================================================
+bool VecEnv::checkSize(
+    const std::string& fnName,
+    const std::string& bufferName,
+    int rows,
+    int cols,
+    int expectedRows,
+    int expectedCols) const
+{
+  if (rows != expectedRows || cols != expectedCols)
+  {
+    std::cerr << "VecEnv::" << fnName << "() called with " << bufferName
+              << " of incorrect size (" << rows << "x" << cols
+              << ") instead of (" << expectedRows << "x" << expectedCols
+              << "). Ignoring call." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace neural
+} // namespace dart
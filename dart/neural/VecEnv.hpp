@@ -0,0 +1,118 @@
+#ifndef DART_NEURAL_VEC_ENV_HPP_
+#define DART_NEURAL_VEC_ENV_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+#include "dart/neural/WorldBatch.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+/// This is a vectorized environment for RL training, in the style of a gym
+/// VecEnv. Each call to step() applies a whole batch of actions, steps every
+/// world in parallel, resets any environment whose episode just ended, and
+/// writes the observations into an array the caller owns, so Python only
+/// makes one call per batched step.
+///
+/// Unlike WorldBatch, actions and observations are laid out with one row per
+/// environment, so actions are (getNumEnvs() x getActionSize()) and
+/// observations are (getNumEnvs() x getStateSize()), both row-major. That's
+/// how numpy and RL libraries lay them out, so arrays from Python are read and
+/// written in place. Observations are the RL API state, [pos, vel].
+class VecEnv : public WorldBatch
+{
+public:
+  typedef Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      RowMatrixXs;
+
+  /// This creates `numEnvs` clones of `world`, all starting (and resetting)
+  /// to the state `world` is in now. If `numThreads` is <= 0, we use
+  /// std::thread::hardware_concurrency().
+  VecEnv(
+      std::shared_ptr<simulation::World> world,
+      int numEnvs,
+      int numThreads = -1);
+
+  /// Returns the number of environments, which is the same as getBatchSize()
+  int getNumEnvs() const;
+
+  /// This sets the states (one per column) that environments are reset to.
+  /// Each reset takes the next column in turn, wrapping around at the end, so
+  /// a single column always resets to the same state.
+  void setResetStates(const Eigen::MatrixXs& states);
+
+  /// An episode ends after this many steps. If this is 0 (the default),
+  /// episodes have no time limit.
+  void setMaxEpisodeSteps(int maxEpisodeSteps);
+
+  /// An episode also ends as soon as any entry of the state leaves
+  /// [lower, upper]. By default the state is unbounded.
+  void setStateBounds(
+      const Eigen::VectorXs& lower, const Eigen::VectorXs& upper);
+
+  /// This adds a custom test for the end of an episode, called with the index
+  /// of the environment and its state after every step. This gets called from
+  /// the worker threads, so it needs to be thread safe, and if it's written in
+  /// Python every call has to take the GIL.
+  void setDoneFn(std::function<bool(int env, const Eigen::VectorXs& state)> fn);
+
+  /// This resets every environment, and writes the first observations of the
+  /// new episodes into `observations`.
+  void reset(Eigen::Ref<RowMatrixXs> observations);
+
+  /// This applies each row of `actions` to its environment, steps them all in
+  /// parallel, and writes the observations into `observations` and whether
+  /// each episode ended into `dones`. Environments whose episodes ended are
+  /// reset before this returns, so their row of `observations` is the first
+  /// observation of their next episode, and the last observation of the
+  /// episode that ended is in getTerminalObservations().
+  void step(
+      const Eigen::Ref<const RowMatrixXs>& actions,
+      Eigen::Ref<RowMatrixXs> observations,
+      Eigen::Ref<Eigen::VectorXi> dones);
+
+  /// The last observation of every environment whose episode ended on the
+  /// most recent step(). Only the rows where `dones` was set are meaningful.
+  const RowMatrixXs& getTerminalObservations() const;
+
+  /// Returns how many steps each environment has taken in its current episode
+  const Eigen::VectorXi& getEpisodeSteps() const;
+
+protected:
+  /// This resets one environment to the next of the reset states
+  void resetEnv(int env);
+
+  /// This checks the size of a buffer passed in, and prints an error and
+  /// returns false if it doesn't match.
+  bool checkSize(
+      const std::string& fnName,
+      const std::string& bufferName,
+      int rows,
+      int cols,
+      int expectedRows,
+      int expectedCols) const;
+
+  Eigen::MatrixXs mResetStates;
+  int mNextResetState;
+  int mMaxEpisodeSteps;
+  Eigen::VectorXs mStateLowerBounds;
+  Eigen::VectorXs mStateUpperBounds;
+  std::function<bool(int env, const Eigen::VectorXs& state)> mDoneFn;
+  Eigen::VectorXi mEpisodeSteps;
+  RowMatrixXs mTerminalObservations;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -1,6 +1,8 @@
 #include "dart/neural/WithRespectTo.hpp"
 
+#include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/Geometry.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
@@ -27,6 +29,158 @@ WithRespectTo::~WithRespectTo()
 {
 }
 
+/// This returns J * dp for the inverse dynamics, by forming J
+Eigen::VectorXs WithRespectTo::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return skel->getJacobianOfID(ddq, this) * dp;
+}
+
+/// This returns J^T * v for the inverse dynamics, by forming J
+Eigen::VectorXs WithRespectTo::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return skel->getJacobianOfID(ddq, this).transpose() * v;
+}
+
+/// This is jvp() for every skeleton in the world, concatenated
+Eigen::VectorXs WithRespectTo::jvp(
+    simulation::World* world,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(world->getNumDofs());
+  int dofCursor = 0;
+  int wrtCursor = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    int dofs = skel->getNumDofs();
+    int skelDim = dim(skel);
+    if (skelDim > 0)
+    {
+      result.segment(dofCursor, dofs) = jvp(
+          skel,
+          ddq.segment(dofCursor, dofs),
+          dp.segment(wrtCursor, skelDim));
+    }
+    dofCursor += dofs;
+    wrtCursor += skelDim;
+  }
+  return result;
+}
+
+/// This is vjp() for every skeleton in the world, concatenated
+Eigen::VectorXs WithRespectTo::vjp(
+    simulation::World* world,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(dim(world));
+  int dofCursor = 0;
+  int wrtCursor = 0;
+  for (int i = 0; i < world->getNumSkeletons(); i++)
+  {
+    dynamics::Skeleton* skel = world->getSkeleton(i).get();
+    int dofs = skel->getNumDofs();
+    int skelDim = dim(skel);
+    if (skelDim > 0)
+    {
+      result.segment(wrtCursor, skelDim) = vjp(
+          skel, ddq.segment(dofCursor, dofs), v.segment(dofCursor, dofs));
+    }
+    dofCursor += dofs;
+    wrtCursor += skelDim;
+  }
+  return result;
+}
+
+/// By default, a WRT doesn't change any of the spatial tensors
+void WithRespectTo::forEachSpatialTensorGradient(
+    dynamics::Skeleton* /* skel */,
+    dynamics::BodyNode* /* body */,
+    const SpatialTensorGradientFn& /* fn */)
+{
+}
+
+/// This is J * dp for WRTs that only change the spatial tensors. Each body
+/// contributes J_b^T (dG (A_b - g_b) - dad(V_b, dG V_b)), where dG is the
+/// change in its spatial tensor along dp.
+Eigen::VectorXs WithRespectTo::inertialJvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  const Eigen::VectorXs oldAccelerations = skel->getAccelerations();
+  skel->setAccelerations(ddq);
+
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(skel->getNumDofs());
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(i);
+    Eigen::Matrix6s dG = Eigen::Matrix6s::Zero();
+    forEachSpatialTensorGradient(
+        skel, body, [&](int index, const Eigen::Matrix6s& grad) {
+          dG += dp(index) * grad;
+        });
+    if (dG.isZero(0))
+      continue;
+
+    const Eigen::Vector6s& V = body->getSpatialVelocity();
+    Eigen::Vector6s accMinusGravity = body->getSpatialAcceleration();
+    if (body->getGravityMode())
+    {
+      accMinusGravity.tail<3>()
+          -= body->getWorldTransform().linear().transpose()
+             * skel->getGravity();
+    }
+    const Eigen::Vector6s dF = dG * accMinusGravity - math::dad(V, dG * V);
+    result.noalias() += skel->getJacobian(body).transpose() * dF;
+  }
+
+  skel->setAccelerations(oldAccelerations);
+  return result;
+}
+
+/// This is J^T * v for WRTs that only change the spatial tensors. With
+/// a = J_b v, entry k picks up a^T dG_k (A_b - g_b) - ad(V_b, a)^T dG_k V_b
+/// from each body it touches.
+Eigen::VectorXs WithRespectTo::inertialVjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  const Eigen::VectorXs oldAccelerations = skel->getAccelerations();
+  skel->setAccelerations(ddq);
+
+  Eigen::VectorXs result = Eigen::VectorXs::Zero(dim(skel));
+  for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(i);
+    const Eigen::Vector6s& V = body->getSpatialVelocity();
+    Eigen::Vector6s accMinusGravity = body->getSpatialAcceleration();
+    if (body->getGravityMode())
+    {
+      accMinusGravity.tail<3>()
+          -= body->getWorldTransform().linear().transpose()
+             * skel->getGravity();
+    }
+    const Eigen::Vector6s a = skel->getJacobian(body) * v;
+    const Eigen::Vector6s adVa = math::ad(V, a);
+    forEachSpatialTensorGradient(
+        skel, body, [&](int index, const Eigen::Matrix6s& dG) {
+          result(index) += a.dot(dG * accMinusGravity) - adVa.dot(dG * V);
+        });
+  }
+
+  skel->setAccelerations(oldAccelerations);
+  return result;
+}
+
 /// Basic constructor
 WithRespectToPosition::WithRespectToPosition()
 {
@@ -338,6 +492,35 @@ Eigen::VectorXs WithRespectToGroupMasses::lowerBound(simulation::World* world)
   return world->getGroupMassesLowerBound();
 }
 
+/// This returns J * dp for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupMasses::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return inertialJvp(skel, ddq, dp);
+}
+
+/// This returns J^T * v for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupMasses::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return inertialVjp(skel, ddq, v);
+}
+
+/// Each group's mass only changes the bodies in that group
+void WithRespectToGroupMasses::forEachSpatialTensorGradient(
+    dynamics::Skeleton* skel,
+    dynamics::BodyNode* body,
+    const SpatialTensorGradientFn& fn)
+{
+  dynamics::Inertia inertia = body->getInertia();
+  fn(skel->getScaleGroupIndex(body),
+     inertia.getSpatialTensorGradientWrtMass());
+}
+
 /// Basic constructor
 WithRespectToLinearizedMasses::WithRespectToLinearizedMasses()
 {
@@ -403,6 +586,27 @@ Eigen::VectorXs WithRespectToLinearizedMasses::lowerBound(
   return world->getLinearizedMassesLowerBound();
 }
 
+/// This returns J * dp for the inverse dynamics, by mapping dp to group masses
+Eigen::VectorXs WithRespectToLinearizedMasses::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return WithRespectTo::GROUP_MASSES->jvp(
+      skel, ddq, skel->getGroupMassesJacobianWrtLinearizedMasses() * dp);
+}
+
+/// This returns J^T * v for the inverse dynamics, by mapping the group mass
+/// gradient back to linearized masses
+Eigen::VectorXs WithRespectToLinearizedMasses::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return skel->getGroupMassesJacobianWrtLinearizedMasses().transpose()
+         * WithRespectTo::GROUP_MASSES->vjp(skel, ddq, v);
+}
+
 /// Basic constructor
 WithRespectToGroupCOMs::WithRespectToGroupCOMs()
 {
@@ -466,6 +670,41 @@ Eigen::VectorXs WithRespectToGroupCOMs::lowerBound(simulation::World* world)
   return world->getGroupCOMLowerBound();
 }
 
+/// This returns J * dp for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupCOMs::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return inertialJvp(skel, ddq, dp);
+}
+
+/// This returns J^T * v for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupCOMs::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return inertialVjp(skel, ddq, v);
+}
+
+/// Each group's COM only changes the bodies in that group, mirrored by the
+/// body's axis flips
+void WithRespectToGroupCOMs::forEachSpatialTensorGradient(
+    dynamics::Skeleton* skel,
+    dynamics::BodyNode* body,
+    const SpatialTensorGradientFn& fn)
+{
+  dynamics::Inertia inertia = body->getInertia();
+  const int group = skel->getScaleGroupIndex(body);
+  const Eigen::Vector3s flips = skel->getScaleGroupFlips(body);
+  for (int axis = 0; axis < 3; axis++)
+  {
+    fn(group * 3 + axis,
+       flips(axis) * inertia.getSpatialTensorGradientWrtCOM(axis));
+  }
+}
+
 /// Basic constructor
 WithRespectToGroupInertias::WithRespectToGroupInertias()
 {
@@ -529,6 +768,47 @@ Eigen::VectorXs WithRespectToGroupInertias::lowerBound(simulation::World* world)
   return world->getGroupInertiasLowerBound();
 }
 
+/// This returns J * dp for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupInertias::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return inertialJvp(skel, ddq, dp);
+}
+
+/// This returns J^T * v for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToGroupInertias::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return inertialVjp(skel, ddq, v);
+}
+
+/// Each group's dims and Euler angles only change the bodies in that group
+void WithRespectToGroupInertias::forEachSpatialTensorGradient(
+    dynamics::Skeleton* skel,
+    dynamics::BodyNode* body,
+    const SpatialTensorGradientFn& fn)
+{
+  dynamics::Inertia inertia = body->getInertia();
+  const int group = skel->getScaleGroupIndex(body);
+  const Eigen::Vector3s flips = skel->getScaleGroupFlips(body);
+  for (int axis = 0; axis < 6; axis++)
+  {
+    // Flipping any other axis mirrors the rotation about this one
+    s_t flip = 1.0;
+    for (int other = 0; axis >= 3 && other < 3; other++)
+    {
+      if (other != axis - 3 && flips(other) == -1)
+        flip *= -1;
+    }
+    fn(group * 6 + axis,
+       flip * inertia.getSpatialTensorGradientWrtDimsAndEulerVector(axis));
+  }
+}
+
 /// Basic constructor
 WithRespectToForce::WithRespectToForce()
 {
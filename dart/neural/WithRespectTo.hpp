@@ -1,6 +1,7 @@
 #ifndef DART_NEURAL_WRT_HPP_
 #define DART_NEURAL_WRT_HPP_
 
+#include <functional>
 #include <memory>
 
 #include <Eigen/Dense>
@@ -14,7 +15,8 @@ class World;
 
 namespace dynamics {
 class Skeleton;
-}
+class BodyNode;
+} // namespace dynamics
 
 namespace neural {
 
@@ -62,6 +64,35 @@ public:
   /// world
   virtual Eigen::VectorXs lowerBound(simulation::World* world) = 0;
 
+  /// This returns J * dp, where J is the Jacobian of the skeleton's inverse
+  /// dynamics, M(q) * ddq + C(q, dq), with respect to this WRT. The default
+  /// forms J with Skeleton::getJacobianOfID(), and the inertial WRTs override
+  /// this to work one body at a time without ever forming J.
+  virtual Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp);
+
+  /// This returns J^T * v, for the same J as jvp(). This is all a loss
+  /// gradient needs, so for the inertial WRTs it's much cheaper than forming
+  /// J when there are lots of parameters.
+  virtual Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v);
+
+  /// This is jvp() for every skeleton in the world, concatenated
+  Eigen::VectorXs jvp(
+      simulation::World* world,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp);
+
+  /// This is vjp() for every skeleton in the world, concatenated
+  Eigen::VectorXs vjp(
+      simulation::World* world,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v);
+
   static WithRespectToPosition* POSITION;
   static WithRespectToVelocity* VELOCITY;
   static WithRespectToForce* FORCE;
@@ -71,6 +102,36 @@ public:
   static WithRespectToLinearizedMasses* LINEARIZED_MASSES;
   static WithRespectToGroupCOMs* GROUP_COMS;
   static WithRespectToGroupInertias* GROUP_INERTIAS;
+
+protected:
+  /// This gets called with the gradient of a body's spatial tensor, dG, with
+  /// respect to entry `index` of this WRT in the body's skeleton
+  using SpatialTensorGradientFn
+      = std::function<void(int index, const Eigen::Matrix6s& dG)>;
+
+  /// WRTs that only change the bodies' inertias override this to call `fn`
+  /// once for each entry that changes `body`'s spatial tensor. The default
+  /// doesn't call it at all.
+  virtual void forEachSpatialTensorGradient(
+      dynamics::Skeleton* skel,
+      dynamics::BodyNode* body,
+      const SpatialTensorGradientFn& fn);
+
+  /// These implement jvp() and vjp() on top of forEachSpatialTensorGradient().
+  /// The inverse dynamics are linear in the spatial tensor G of each body,
+  ///
+  ///   tau = sum_b J_b^T (G_b (A_b - g_b) - dad(V_b, G_b V_b))
+  ///
+  /// so we only ever need a 6x6 dG per body, and never a (dofs x dim) matrix.
+  Eigen::VectorXs inertialJvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp);
+
+  Eigen::VectorXs inertialVjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v);
 };
 
 class WithRespectToPosition : public WithRespectTo
@@ -246,6 +307,27 @@ public:
   /// This gives a vector of lower bound values for this WRT, given state in the
   /// world
   Eigen::VectorXs lowerBound(simulation::World* world) override;
+
+  using WithRespectTo::jvp;
+  using WithRespectTo::vjp;
+
+  /// This returns J * dp for the inverse dynamics, without forming J
+  Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp) override;
+
+  /// This returns J^T * v for the inverse dynamics, without forming J
+  Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v) override;
+
+protected:
+  void forEachSpatialTensorGradient(
+      dynamics::Skeleton* skel,
+      dynamics::BodyNode* body,
+      const SpatialTensorGradientFn& fn) override;
 };
 
 class WithRespectToLinearizedMasses : public WithRespectTo
@@ -281,6 +363,21 @@ public:
   /// This gives a vector of lower bound values for this WRT, given state in the
   /// world
   Eigen::VectorXs lowerBound(simulation::World* world) override;
+
+  using WithRespectTo::jvp;
+  using WithRespectTo::vjp;
+
+  /// This returns J * dp for the inverse dynamics, without forming J
+  Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp) override;
+
+  /// This returns J^T * v for the inverse dynamics, without forming J
+  Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v) override;
 };
 
 class WithRespectToGroupCOMs : public WithRespectTo
@@ -316,6 +413,27 @@ public:
   /// This gives a vector of lower bound values for this WRT, given state in the
   /// world
   Eigen::VectorXs lowerBound(simulation::World* world) override;
+
+  using WithRespectTo::jvp;
+  using WithRespectTo::vjp;
+
+  /// This returns J * dp for the inverse dynamics, without forming J
+  Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp) override;
+
+  /// This returns J^T * v for the inverse dynamics, without forming J
+  Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v) override;
+
+protected:
+  void forEachSpatialTensorGradient(
+      dynamics::Skeleton* skel,
+      dynamics::BodyNode* body,
+      const SpatialTensorGradientFn& fn) override;
 };
 
 class WithRespectToGroupInertias : public WithRespectTo
@@ -351,6 +469,27 @@ public:
   /// This gives a vector of lower bound values for this WRT, given state in the
   /// world
   Eigen::VectorXs lowerBound(simulation::World* world) override;
+
+  using WithRespectTo::jvp;
+  using WithRespectTo::vjp;
+
+  /// This returns J * dp for the inverse dynamics, without forming J
+  Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp) override;
+
+  /// This returns J^T * v for the inverse dynamics, without forming J
+  Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v) override;
+
+protected:
+  void forEachSpatialTensorGradient(
+      dynamics::Skeleton* skel,
+      dynamics::BodyNode* body,
+      const SpatialTensorGradientFn& fn) override;
 };
 
 class WithRespectToForce : public WithRespectTo
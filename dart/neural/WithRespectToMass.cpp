@@ -361,5 +361,87 @@ Eigen::VectorXs WithRespectToMass::lowerBound(simulation::World* /* world */)
   return mLowerBounds;
 }
 
+//==============================================================================
+/// This returns J * dp for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToMass::jvp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& dp)
+{
+  return inertialJvp(skel, ddq, dp);
+}
+
+//==============================================================================
+/// This returns J^T * v for the inverse dynamics, without forming J
+Eigen::VectorXs WithRespectToMass::vjp(
+    dynamics::Skeleton* skel,
+    const Eigen::VectorXs& ddq,
+    const Eigen::VectorXs& v)
+{
+  return inertialVjp(skel, ddq, v);
+}
+
+//==============================================================================
+/// This reports how each of the entries registered for `body` changes its
+/// spatial tensor
+void WithRespectToMass::forEachSpatialTensorGradient(
+    dynamics::Skeleton* skel,
+    dynamics::BodyNode* body,
+    const SpatialTensorGradientFn& fn)
+{
+  dynamics::Inertia inertia = body->getInertia();
+  int cursor = 0;
+  for (WrtMassBodyNodyEntry& entry : mEntries[skel->getName()])
+  {
+    if (entry.linkName == body->getName())
+    {
+      if (entry.type == INERTIA_MASS)
+      {
+        // BodyNode::setMass() keeps the implied dims, so the moment scales too
+        fn(cursor, inertia.getSpatialTensorGradientWrtMass());
+      }
+      else if (entry.type == INERTIA_COM)
+      {
+        for (int i = 0; i < 3; i++)
+          fn(cursor + i, inertia.getSpatialTensorGradientWrtCOM(i));
+      }
+      else if (entry.type == INERTIA_COM_MU)
+      {
+        Eigen::Vector3s beta = body->getBeta();
+        Eigen::Matrix6s dG = Eigen::Matrix6s::Zero();
+        for (int i = 0; i < 3; i++)
+          dG += beta(i) * inertia.getSpatialTensorGradientWrtCOM(i);
+        fn(cursor, dG);
+      }
+      else if (entry.type == INERTIA_DIAGONAL)
+      {
+        for (int i = 0; i < 3; i++)
+          fn(cursor + i, inertia.getSpatialTensorGradientWrtMomentVector(i));
+      }
+      else if (entry.type == INERTIA_OFF_DIAGONAL)
+      {
+        for (int i = 0; i < 3; i++)
+        {
+          fn(cursor + i,
+             inertia.getSpatialTensorGradientWrtMomentVector(3 + i));
+        }
+      }
+      else if (entry.type == INERTIA_FULL)
+      {
+        // Here the moment is set explicitly, so it doesn't scale with mass
+        fn(cursor, inertia.getSpatialTensorGradientWrtMass(false));
+        for (int i = 0; i < 3; i++)
+          fn(cursor + 1 + i, inertia.getSpatialTensorGradientWrtCOM(i));
+        for (int i = 0; i < 6; i++)
+        {
+          fn(cursor + 4 + i,
+             inertia.getSpatialTensorGradientWrtMomentVector(i));
+        }
+      }
+    }
+    cursor += entry.dim();
+  }
+}
+
 } // namespace neural
 } // namespace dart
\ No newline at end of file
@@ -96,7 +96,27 @@ public:
   /// world
   Eigen::VectorXs lowerBound(simulation::World* world) override;
 
+  using WithRespectTo::jvp;
+  using WithRespectTo::vjp;
+
+  /// This returns J * dp for the inverse dynamics, without forming J
+  Eigen::VectorXs jvp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& dp) override;
+
+  /// This returns J^T * v for the inverse dynamics, without forming J
+  Eigen::VectorXs vjp(
+      dynamics::Skeleton* skel,
+      const Eigen::VectorXs& ddq,
+      const Eigen::VectorXs& v) override;
+
 protected:
+  void forEachSpatialTensorGradient(
+      dynamics::Skeleton* skel,
+      dynamics::BodyNode* body,
+      const SpatialTensorGradientFn& fn) override;
+
   std::unordered_map<std::string, std::vector<WrtMassBodyNodyEntry>> mEntries;
   Eigen::VectorXs mUpperBounds;
   Eigen::VectorXs mLowerBounds;
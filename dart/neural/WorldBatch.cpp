@@ -0,0 +1,266 @@
+#include "dart/neural/WorldBatch.hpp"
+
+#include <future>
+#include <iostream>
+#include <thread>
+
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace neural {
+
+//==============================================================================
+WorldBatch::WorldBatch(
+    std::shared_ptr<simulation::World> world, int batchSize, int numThreads)
+  : mNumThreads(1),
+    mStateSize(world->getStateSize()),
+    mActionSize(world->getActionSize())
+{
+  setNumThreads(numThreads);
+  mWorlds.reserve(batchSize);
+  for (int i = 0; i < batchSize; i++)
+  {
+    mWorlds.push_back(world->clone());
+  }
+  mNextStates = Eigen::MatrixXs::Zero(mStateSize, batchSize);
+}
+
+//==============================================================================
+int WorldBatch::getBatchSize() const
+{
+  return mWorlds.size();
+}
+
+//==============================================================================
+int WorldBatch::getNumThreads() const
+{
+  return mNumThreads;
+}
+
+//==============================================================================
+void WorldBatch::setNumThreads(int numThreads)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  // hardware_concurrency() is allowed to return 0 if it can't tell
+  mNumThreads = std::max(numThreads, 1);
+}
+
+//==============================================================================
+int WorldBatch::getStateSize() const
+{
+  return mStateSize;
+}
+
+//==============================================================================
+int WorldBatch::getActionSize() const
+{
+  return mActionSize;
+}
+
+//==============================================================================
+std::shared_ptr<simulation::World> WorldBatch::getWorld(int index) const
+{
+  assert(index >= 0 && index < mWorlds.size());
+  return mWorlds[index];
+}
+
+//==============================================================================
+Eigen::MatrixXs WorldBatch::getStates() const
+{
+  Eigen::MatrixXs states = Eigen::MatrixXs::Zero(mStateSize, mWorlds.size());
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    states.col(i) = mWorlds[i]->getState();
+  }
+  return states;
+}
+
+//==============================================================================
+void WorldBatch::setStates(const Eigen::MatrixXs& states)
+{
+  if (states.rows() != mStateSize || states.cols() != mWorlds.size())
+  {
+    std::cerr << "WorldBatch::setStates() called with a matrix of incorrect "
+                 "size ("
+              << states.rows() << "x" << states.cols() << ") instead of ("
+              << mStateSize << "x" << mWorlds.size() << "). Ignoring call."
+              << std::endl;
+    return;
+  }
+  for (int i = 0; i < mWorlds.size(); i++)
+  {
+    mWorlds[i]->setState(states.col(i));
+  }
+}
+
+//==============================================================================
+std::vector<std::shared_ptr<BackpropSnapshot>> WorldBatch::forwardPass(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    bool idempotent)
+{
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+  if (!checkInputs("forwardPass", states, actions))
+  {
+    return snapshots;
+  }
+
+  snapshots.resize(mWorlds.size());
+  parallelForEachWorld([&](int i) {
+    std::shared_ptr<simulation::World>& world = mWorlds[i];
+    world->setState(states.col(i));
+    world->setAction(actions.col(i));
+    snapshots[i] = neural::forwardPass(world, idempotent);
+    mNextStates.col(i).head(mStateSize / 2)
+        = snapshots[i]->getPostStepPosition();
+    mNextStates.col(i).tail(mStateSize / 2)
+        = snapshots[i]->getPostStepVelocity();
+  });
+
+  return snapshots;
+}
+
+//==============================================================================
+std::shared_ptr<BatchSnapshot> WorldBatch::timestep(
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions,
+    bool idempotent)
+{
+  std::shared_ptr<BatchSnapshot> snapshot = std::make_shared<BatchSnapshot>();
+  snapshot->snapshots = forwardPass(states, actions, idempotent);
+  snapshot->nextStates = mNextStates;
+  return snapshot;
+}
+
+//==============================================================================
+BatchLossGradient WorldBatch::backprop(
+    const BatchSnapshot& snapshot, const Eigen::MatrixXs& lossWrtNextStates)
+{
+  BatchLossGradient grad;
+  grad.lossWrtStates = Eigen::MatrixXs::Zero(mStateSize, mWorlds.size());
+  grad.lossWrtActions = Eigen::MatrixXs::Zero(mActionSize, mWorlds.size());
+  if (snapshot.snapshots.size() != mWorlds.size())
+  {
+    std::cerr << "WorldBatch::backprop() called with a BatchSnapshot of "
+              << snapshot.snapshots.size() << " worlds, but the batch has "
+              << mWorlds.size() << ". Ignoring call." << std::endl;
+    return grad;
+  }
+  if (lossWrtNextStates.rows() != mStateSize
+      || lossWrtNextStates.cols() != mWorlds.size())
+  {
+    std::cerr << "WorldBatch::backprop() called with a lossWrtNextStates "
+              << "matrix of incorrect size (" << lossWrtNextStates.rows()
+              << "x" << lossWrtNextStates.cols() << ") instead of ("
+              << mStateSize << "x" << mWorlds.size() << "). Ignoring call."
+              << std::endl;
+    return grad;
+  }
+
+  parallelForEachWorld([&](int i) {
+    LossGradientHighLevelAPI worldGrad
+        = snapshot.snapshots[i]->backpropState(
+            mWorlds[i], lossWrtNextStates.col(i));
+    grad.lossWrtStates.col(i) = worldGrad.lossWrtState;
+    grad.lossWrtActions.col(i) = worldGrad.lossWrtAction;
+  });
+
+  return grad;
+}
+
+//==============================================================================
+const Eigen::MatrixXs& WorldBatch::step(
+    const Eigen::MatrixXs& states, const Eigen::MatrixXs& actions)
+{
+  if (!checkInputs("step", states, actions))
+  {
+    return mNextStates;
+  }
+
+  parallelForEachWorld([&](int i) {
+    std::shared_ptr<simulation::World>& world = mWorlds[i];
+    world->setState(states.col(i));
+    world->setAction(actions.col(i));
+    world->step();
+    mNextStates.col(i) = world->getState();
+  });
+
+  return mNextStates;
+}
+
+//==============================================================================
+const Eigen::MatrixXs& WorldBatch::getNextStates() const
+{
+  return mNextStates;
+}
+
+//==============================================================================
+bool WorldBatch::checkInputs(
+    const std::string& fnName,
+    const Eigen::MatrixXs& states,
+    const Eigen::MatrixXs& actions) const
+{
+  if (states.rows() != mStateSize || states.cols() != mWorlds.size())
+  {
+    std::cerr << "WorldBatch::" << fnName
+              << "() called with a states matrix of incorrect size ("
+              << states.rows() << "x" << states.cols() << ") instead of ("
+              << mStateSize << "x" << mWorlds.size() << "). Ignoring call."
+              << std::endl;
+    return false;
+  }
+  if (actions.rows() != mActionSize || actions.cols() != mWorlds.size())
+  {
+    std::cerr << "WorldBatch::" << fnName
+              << "() called with an actions matrix of incorrect size ("
+              << actions.rows() << "x" << actions.cols() << ") instead of ("
+              << mActionSize << "x" << mWorlds.size() << "). Ignoring call."
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+void WorldBatch::parallelForEachWorld(const std::function<void(int)>& fn)
+{
+  int batchSize = mWorlds.size();
+  int numChunks = std::min(mNumThreads, batchSize);
+  if (numChunks <= 1)
+  {
+    for (int i = 0; i < batchSize; i++)
+    {
+      fn(i);
+    }
+    return;
+  }
+
+  std::vector<std::future<void>> futures;
+  int chunkSize = batchSize / numChunks;
+  int remainder = batchSize % numChunks;
+  int cursor = 0;
+  for (int chunk = 0; chunk < numChunks; chunk++)
+  {
+    int start = cursor;
+    int end = start + chunkSize + (chunk < remainder ? 1 : 0);
+    cursor = end;
+    futures.push_back(std::async(std::launch::async, [&fn, start, end]() {
+      for (int i = start; i < end; i++)
+      {
+        fn(i);
+      }
+    }));
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+}
+
+} // namespace neural
+} // namespace dart
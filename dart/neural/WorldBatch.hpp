@@ -0,0 +1,144 @@
+#ifndef DART_NEURAL_WORLD_BATCH_HPP_
+#define DART_NEURAL_WORLD_BATCH_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace neural {
+
+class BackpropSnapshot;
+
+/// The snapshots from one call to WorldBatch::timestep(), kept together so
+/// that callers (like a PyTorch autograd function) only hold one object per
+/// batched step, rather than one per world.
+struct BatchSnapshot
+{
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots;
+  /// The stacked post-step states, one column per world
+  Eigen::MatrixXs nextStates;
+};
+
+/// The gradient of a loss with respect to the inputs of
+/// WorldBatch::timestep(), stacked the same way as the inputs
+struct BatchLossGradient
+{
+  Eigen::MatrixXs lossWrtStates;
+  Eigen::MatrixXs lossWrtActions;
+};
+
+/// This holds N independent copies of a World that all share the same skeleton
+/// topology, and steps them together on a pool of threads. This is meant for
+/// RL-style workloads, where we want to run many rollouts in parallel without
+/// paying for a Python loop over N separate World objects.
+///
+/// States and actions are passed in "stacked" form, with one column per world
+/// in the batch. States use the RL API layout, [pos, vel], so the matrix of
+/// states is (getStateSize() x getBatchSize()), and the matrix of actions is
+/// (getActionSize() x getBatchSize()).
+class WorldBatch
+{
+public:
+  /// This creates `batchSize` clones of `world`. The original world is never
+  /// stepped by the batch, it only serves as the template for the clones. If
+  /// `numThreads` is <= 0, we use std::thread::hardware_concurrency().
+  WorldBatch(
+      std::shared_ptr<simulation::World> world,
+      int batchSize,
+      int numThreads = -1);
+
+  /// Returns the number of worlds in this batch
+  int getBatchSize() const;
+
+  /// Returns the number of threads we split the batch across when stepping
+  int getNumThreads() const;
+
+  /// Sets the number of threads we split the batch across when stepping. If
+  /// `numThreads` is <= 0, we use std::thread::hardware_concurrency().
+  void setNumThreads(int numThreads);
+
+  /// Returns the size of the state vector for a single world in the batch
+  int getStateSize() const;
+
+  /// Returns the size of the action vector for a single world in the batch
+  int getActionSize() const;
+
+  /// Returns the world at `index`. This is the world you should pass to the
+  /// BackpropSnapshot returned by forwardPass() at the same index.
+  std::shared_ptr<simulation::World> getWorld(int index) const;
+
+  /// This reads the current state of every world, stacked as columns
+  Eigen::MatrixXs getStates() const;
+
+  /// This sets the current state of every world from stacked columns
+  void setStates(const Eigen::MatrixXs& states);
+
+  /// This sets the state and action for each world, takes a step (recording
+  /// gradient information), and returns one BackpropSnapshot per world. The
+  /// post-step states are available from getNextStates() when this returns.
+  std::vector<std::shared_ptr<BackpropSnapshot>> forwardPass(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      bool idempotent = false);
+
+  /// This sets the state and action for each world and takes a step, without
+  /// recording any gradient information. This returns the stacked post-step
+  /// states, which are also available from getNextStates().
+  const Eigen::MatrixXs& step(
+      const Eigen::MatrixXs& states, const Eigen::MatrixXs& actions);
+
+  /// This is the same as forwardPass(), except that it packs the snapshots and
+  /// post-step states into a single BatchSnapshot, which can later be passed
+  /// to backprop().
+  std::shared_ptr<BatchSnapshot> timestep(
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions,
+      bool idempotent = false);
+
+  /// This is the backward pass for timestep(). Given the gradient of a loss
+  /// with respect to the stacked post-step states, this computes the
+  /// vector-Jacobian products for every world in parallel, and returns the
+  /// gradient with respect to the stacked pre-step states and actions.
+  BatchLossGradient backprop(
+      const BatchSnapshot& snapshot, const Eigen::MatrixXs& lossWrtNextStates);
+
+  /// Returns the stacked states from after the last call to forwardPass(),
+  /// timestep() or step().
+  const Eigen::MatrixXs& getNextStates() const;
+
+protected:
+  /// This checks the dimensions of the inputs, and prints an error and returns
+  /// false if they don't match the batch.
+  bool checkInputs(
+      const std::string& fnName,
+      const Eigen::MatrixXs& states,
+      const Eigen::MatrixXs& actions) const;
+
+  /// This runs `fn(i)` for every world index i in [0, getBatchSize()), split
+  /// into contiguous chunks across our threads. Each world is only ever
+  /// touched by a single thread, so results are deterministic regardless of
+  /// the thread count.
+  void parallelForEachWorld(const std::function<void(int)>& fn);
+
+  std::vector<std::shared_ptr<simulation::World>> mWorlds;
+  int mNumThreads;
+  int mStateSize;
+  int mActionSize;
+  Eigen::MatrixXs mNextStates;
+};
+
+} // namespace neural
+} // namespace dart
+
+#endif
@@ -0,0 +1,51 @@
+#include "dart/performance/AllocationCounter.hpp"
+
+#ifdef DART_ENABLE_ALLOCATION_COUNTING
+
+#include <cstdlib>
+#include <new>
+
+namespace dart {
+namespace performance {
+
+namespace {
+
+// These need to be trivial, since operator new can run before and after
+// anything with a constructor or destructor
+thread_local uint64_t tNumAllocations = 0;
+thread_local uint64_t tNumBytes = 0;
+
+} // namespace
+
+//==============================================================================
+AllocationStats AllocationCounter::getThreadStats()
+{
+  AllocationStats stats;
+  stats.numAllocations = tNumAllocations;
+  stats.numBytes = tNumBytes;
+  return stats;
+}
+
+} // namespace performance
+} // namespace dart
+
+//==============================================================================
+// The default array, nothrow and sized forms all forward to these two, so
+// these are the only ones we need to replace
+void* operator new(std::size_t size)
+{
+  dart::performance::tNumAllocations++;
+  dart::performance::tNumBytes += size;
+  void* ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+#endif
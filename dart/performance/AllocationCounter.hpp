@@ -0,0 +1,65 @@
+#ifndef DART_PERFORMANCE_ALLOCATION_COUNTER_HPP_
+#define DART_PERFORMANCE_ALLOCATION_COUNTER_HPP_
+
+#include <cstdint>
+
+// Allocation counting is off unless the build defines
+// DART_ENABLE_ALLOCATION_COUNTING (CMake: DART_ENABLE_ALLOCATION_COUNTING=ON),
+// since it replaces the global operator new for the whole program.
+
+namespace dart {
+namespace performance {
+
+/// A count of heap allocations, and the total bytes they asked for
+struct AllocationStats
+{
+  uint64_t numAllocations = 0;
+  uint64_t numBytes = 0;
+
+  AllocationStats operator-(const AllocationStats& other) const
+  {
+    AllocationStats diff;
+    diff.numAllocations = numAllocations - other.numAllocations;
+    diff.numBytes = numBytes - other.numBytes;
+    return diff;
+  }
+};
+
+/// When allocation counting is built in, every call to the global operator
+/// new (which covers std containers, std::make_shared, and plain `new`) bumps
+/// a counter on the calling thread. Eigen's dynamic-size matrices call malloc
+/// directly, so they don't show up here.
+///
+/// PerformanceLog reads these counters at the start and end of every run, so
+/// finalized logs report allocations alongside time. To check an allocation
+/// budget by hand, take getThreadStats() before and after the code in question
+/// and subtract.
+class AllocationCounter
+{
+public:
+  /// Returns true if this build counts allocations. If not, every count is
+  /// zero.
+  static constexpr bool isEnabled()
+  {
+#ifdef DART_ENABLE_ALLOCATION_COUNTING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#ifdef DART_ENABLE_ALLOCATION_COUNTING
+  /// Returns the running total of allocations made on the calling thread
+  static AllocationStats getThreadStats();
+#else
+  static AllocationStats getThreadStats()
+  {
+    return AllocationStats();
+  }
+#endif
+};
+
+} // namespace performance
+} // namespace dart
+
+#endif
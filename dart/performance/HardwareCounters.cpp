@@ -0,0 +1,132 @@
+#include "dart/performance/HardwareCounters.hpp"
+
+#if defined(DART_ENABLE_HARDWARE_COUNTERS) && defined(__linux__)
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace dart {
+namespace performance {
+
+namespace {
+
+constexpr int kNumCounters = 3;
+
+/// The group of perf events for one thread. Counters the CPU doesn't support
+/// are left out of the group, and read as zero.
+struct ThreadCounterGroup
+{
+  ThreadCounterGroup() : leaderFd(-1), numOpen(0)
+  {
+    const uint64_t configs[kNumCounters]
+        = {PERF_COUNT_HW_INSTRUCTIONS,
+           PERF_COUNT_HW_CACHE_MISSES,
+           PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < kNumCounters; i++)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.disabled = leaderFd == -1 ? 1 : 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      const int fd = static_cast<int>(
+          syscall(__NR_perf_event_open, &attr, 0, -1, leaderFd, 0));
+      if (fd == -1)
+      {
+        // Without the leader there's no group to read
+        if (i == 0)
+          break;
+        continue;
+      }
+      if (leaderFd == -1)
+        leaderFd = fd;
+      else
+        fds[numOpen] = fd;
+      counterIndex[numOpen] = i;
+      numOpen++;
+    }
+
+    if (leaderFd == -1)
+    {
+      static std::atomic<bool> warned(false);
+      if (!warned.exchange(true))
+      {
+        std::cout << "HardwareCounters unable to open perf events ("
+                  << std::strerror(errno)
+                  << "), so hardware counts will be zero. Lowering "
+                  << "/proc/sys/kernel/perf_event_paranoid may help."
+                  << std::endl;
+      }
+      return;
+    }
+    fds[0] = leaderFd;
+    ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  ~ThreadCounterGroup()
+  {
+    for (int i = 0; i < numOpen; i++)
+      close(fds[i]);
+  }
+
+  int leaderFd;
+  int numOpen;
+  int fds[kNumCounters];
+
+  /// Which of the counters in HardwareCounterValues each open event is, in
+  /// the order the group reads them back
+  int counterIndex[kNumCounters];
+};
+
+ThreadCounterGroup& getThreadCounterGroup()
+{
+  thread_local ThreadCounterGroup group;
+  return group;
+}
+
+} // namespace
+
+//==============================================================================
+bool HardwareCounters::isAvailable()
+{
+  return getThreadCounterGroup().leaderFd != -1;
+}
+
+//==============================================================================
+HardwareCounterValues HardwareCounters::readThreadCounters()
+{
+  HardwareCounterValues values;
+  ThreadCounterGroup& group = getThreadCounterGroup();
+  if (group.leaderFd == -1)
+    return values;
+
+  // With PERF_FORMAT_GROUP, a read gives the number of events followed by
+  // each of their values
+  uint64_t buffer[1 + kNumCounters];
+  if (read(group.leaderFd, buffer, sizeof(buffer)) <= 0)
+    return values;
+
+  uint64_t* fields[kNumCounters]
+      = {&values.instructions, &values.cacheMisses, &values.branchMisses};
+  for (uint64_t i = 0; i < buffer[0] && i < kNumCounters; i++)
+    *fields[group.counterIndex[i]] = buffer[1 + i];
+  return values;
+}
+
+} // namespace performance
+} // namespace dart
+
+#endif
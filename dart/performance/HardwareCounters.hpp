@@ -0,0 +1,78 @@
+#ifndef DART_PERFORMANCE_HARDWARE_COUNTERS_HPP_
+#define DART_PERFORMANCE_HARDWARE_COUNTERS_HPP_
+
+#include <cstdint>
+
+// Hardware counters are off unless the build defines
+// DART_ENABLE_HARDWARE_COUNTERS (CMake: DART_ENABLE_HARDWARE_COUNTERS=ON),
+// since reading them costs a system call. They're only supported on Linux,
+// through perf_event_open().
+
+namespace dart {
+namespace performance {
+
+/// Counts from the CPU's performance monitoring unit
+struct HardwareCounterValues
+{
+  uint64_t instructions = 0;
+  uint64_t cacheMisses = 0;
+  uint64_t branchMisses = 0;
+
+  HardwareCounterValues operator-(const HardwareCounterValues& other) const
+  {
+    HardwareCounterValues diff;
+    diff.instructions = instructions - other.instructions;
+    diff.cacheMisses = cacheMisses - other.cacheMisses;
+    diff.branchMisses = branchMisses - other.branchMisses;
+    return diff;
+  }
+};
+
+/// When hardware counters are built in, every thread that reads them gets its
+/// own group of perf events, opened on the first read, counting retired
+/// instructions, last level cache misses and branch mispredictions in user
+/// space on that thread only.
+///
+/// PerformanceLog reads these at the start and end of every run, so finalized
+/// logs report them alongside time. Reading the counters costs a system call,
+/// so leave them out of builds where you only care about timings.
+class HardwareCounters
+{
+public:
+  /// Returns true if this build reads hardware counters. If not, every count
+  /// is zero.
+  static constexpr bool isEnabled()
+  {
+#if defined(DART_ENABLE_HARDWARE_COUNTERS) && defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#if defined(DART_ENABLE_HARDWARE_COUNTERS) && defined(__linux__)
+  /// Returns true if the kernel let us open counters on the calling thread.
+  /// It won't if /proc/sys/kernel/perf_event_paranoid is above 2, or if we're
+  /// in a VM that doesn't pass the PMU through. Counts are zero when this is
+  /// false.
+  static bool isAvailable();
+
+  /// Returns the running totals for the calling thread since its first read
+  static HardwareCounterValues readThreadCounters();
+#else
+  static bool isAvailable()
+  {
+    return false;
+  }
+
+  static HardwareCounterValues readThreadCounters()
+  {
+    return HardwareCounterValues();
+  }
+#endif
+};
+
+} // namespace performance
+} // namespace dart
+
+#endif
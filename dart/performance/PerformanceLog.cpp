@@ -1,11 +1,15 @@
 #include "dart/performance/PerformanceLog.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <ctime>
 #include <deque>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <mutex>
-#include <random>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -20,29 +24,79 @@ namespace dart {
 namespace performance {
 
 std::unordered_map<std::string, int> PerformanceLog::globalPerfStringIndex;
+std::vector<std::string> PerformanceLog::globalPerfStringReverseIndex;
 std::deque<PerformanceLog*> PerformanceLog::globalPerfLogsList;
-std::unordered_map<int, std::string>
-    PerformanceLog::globalPerfStringReverseIndex;
+std::unordered_map<int64_t, PerformanceLog*>
+    PerformanceLog::globalPerfLogsById;
 std::mutex PerformanceLog::globalPerfLogListMutex;
 
+namespace {
+
+/// Logs are stored in fixed-capacity blocks, which never reallocate, so the
+/// pointers we hand out stay valid as a buffer grows
+constexpr std::size_t kLogsPerBlock = 4096;
+
+struct ThreadLogBuffer
+{
+  int64_t index;
+  std::vector<std::vector<PerformanceLog>> blocks;
+  std::size_t size = 0;
+  /// Logs before this were cleared by the last initialize()
+  std::size_t firstLive = 0;
+  /// Names we've already interned, keyed on the address of the string we were
+  /// handed, with a copy of the string to guard against reused addresses
+  std::unordered_map<const char*, std::pair<int, std::string>> nameCache;
+};
+
+/// Buffers outlive their threads (worker threads routinely exit before
+/// anyone calls finalize()), so these are never freed
+std::vector<ThreadLogBuffer*> gThreadBuffers;
+std::mutex gThreadBuffersMutex;
+thread_local ThreadLogBuffer* tThreadBuffer = nullptr;
+
+ThreadLogBuffer* getThreadBuffer()
+{
+  if (tThreadBuffer == nullptr)
+  {
+    ThreadLogBuffer* buffer = new ThreadLogBuffer();
+    const std::lock_guard<std::mutex> lock(gThreadBuffersMutex);
+    buffer->index = gThreadBuffers.size();
+    gThreadBuffers.push_back(buffer);
+    tThreadBuffer = buffer;
+  }
+  return tThreadBuffer;
+}
+
+} // namespace
+
 //==============================================================================
 void PerformanceLog::initialize()
 {
-  globalPerfStringIndex = std::unordered_map<std::string, int>(30);
-  globalPerfLogsList = std::deque<PerformanceLog*>();
-  globalPerfStringReverseIndex = std::unordered_map<int, std::string>(30);
+  {
+    const std::lock_guard<std::mutex> lock(gThreadBuffersMutex);
+    for (ThreadLogBuffer* buffer : gThreadBuffers)
+    {
+      buffer->firstLive = buffer->size;
+    }
+  }
+  // Names are kept, since call sites cache their interned IDs
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
+  globalPerfLogsList.clear();
+  globalPerfLogsById.clear();
 }
 
 //==============================================================================
-int PerformanceLog::mapStringToIndex(const char* c_str)
+int PerformanceLog::internName(const char* c_str)
 {
   std::string str(c_str);
+  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
   // Key is not present
   auto value = PerformanceLog::globalPerfStringIndex.find(str);
   if (value == PerformanceLog::globalPerfStringIndex.end())
   {
-    int newKey = PerformanceLog::globalPerfStringIndex.size();
+    int newKey = PerformanceLog::globalPerfStringReverseIndex.size();
     PerformanceLog::globalPerfStringIndex[str] = newKey;
+    PerformanceLog::globalPerfStringReverseIndex.push_back(str);
     return newKey;
   }
   else
@@ -51,36 +105,101 @@ int PerformanceLog::mapStringToIndex(const char* c_str)
   }
 }
 
+//==============================================================================
+int PerformanceLog::mapStringToIndex(const char* c_str)
+{
+  ThreadLogBuffer* buffer = getThreadBuffer();
+  auto cached = buffer->nameCache.find(c_str);
+  if (cached != buffer->nameCache.end()
+      && std::strcmp(cached->second.second.c_str(), c_str) == 0)
+  {
+    return cached->second.first;
+  }
+  int key = internName(c_str);
+  buffer->nameCache[c_str] = std::make_pair(key, std::string(c_str));
+  return key;
+}
+
 //==============================================================================
 inline uint64_t getClock()
 {
 #ifdef HAVE_PERF_UTILS
   return PerfUtils::Cycles::rdtsc();
 #else
-  std::cout << "Trying to use PerformanceLog::getClock() on an unsupported architecture!" << std::endl;
-  return 0;
+  // Without PerfUtils we measure nanoseconds rather than cycles
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+//==============================================================================
+/// Converts a difference in getClock() to microseconds, the unit of Chrome
+/// traces
+static double clockToMicroseconds(uint64_t clocks)
+{
+#ifdef HAVE_PERF_UTILS
+  return PerfUtils::Cycles::toSeconds(clocks) * 1e6;
+#else
+  return static_cast<double>(clocks) / 1e3;
 #endif
 }
 
+//==============================================================================
+static std::string escapeJson(const std::string& str)
+{
+  std::string escaped;
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    if (static_cast<unsigned char>(c) < 0x20)
+      continue;
+    escaped += c;
+  }
+  return escaped;
+}
+
 //==============================================================================
 /// Default constructor
-PerformanceLog::PerformanceLog(int nameIndex, int parentId)
+PerformanceLog::PerformanceLog(int nameIndex, int64_t parentId)
   : mNameIndex(nameIndex),
     mStartClock(getClock()),
     mEndClock(0),
-    mId(rand()),
+    mStartAllocations(AllocationCounter::getThreadStats()),
+    mStartCounters(HardwareCounters::readThreadCounters()),
+    mId(-2),
     mParentId(parentId)
 {
 }
 
+//==============================================================================
+PerformanceLog* PerformanceLog::allocate(int nameIndex, int64_t parentId)
+{
+  ThreadLogBuffer* buffer = getThreadBuffer();
+  if (buffer->blocks.empty() || buffer->blocks.back().size() == kLogsPerBlock)
+  {
+    buffer->blocks.emplace_back();
+    buffer->blocks.back().reserve(kLogsPerBlock);
+  }
+  buffer->blocks.back().emplace_back(nameIndex, parentId);
+  PerformanceLog* log = &buffer->blocks.back().back();
+  log->mId = (buffer->index << 32) | static_cast<int64_t>(buffer->size);
+  buffer->size++;
+  SamplingProfiler::enterRegion(nameIndex);
+  return log;
+}
+
 //==============================================================================
 PerformanceLog* PerformanceLog::startRoot(char const* name)
 {
-  PerformanceLog* newRoot = new PerformanceLog(mapStringToIndex(name), -1);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(newRoot);
-  return newRoot;
+  return allocate(mapStringToIndex(name), -1);
+}
+
+//==============================================================================
+PerformanceLog* PerformanceLog::startRoot(int nameId)
+{
+  return allocate(nameId, -1);
 }
 
 //==============================================================================
@@ -89,11 +208,24 @@ PerformanceLog* PerformanceLog::startRoot(char const* name)
 std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
 PerformanceLog::finalize()
 {
-  // First we need to set up the reverse index so we can rapidly look up strings
-  globalPerfStringReverseIndex.clear();
-  for (auto pair : globalPerfStringIndex)
+  const std::lock_guard<std::mutex> namesLock(globalPerfLogListMutex);
+
+  // First we gather every thread's live logs into one list, and index them by
+  // ID so we can rapidly find parents
+  globalPerfLogsList.clear();
+  globalPerfLogsById.clear();
   {
-    globalPerfStringReverseIndex[pair.second] = pair.first;
+    const std::lock_guard<std::mutex> buffersLock(gThreadBuffersMutex);
+    for (ThreadLogBuffer* buffer : gThreadBuffers)
+    {
+      for (std::size_t i = buffer->firstLive; i < buffer->size; i++)
+      {
+        PerformanceLog* log
+            = &buffer->blocks[i / kLogsPerBlock][i % kLogsPerBlock];
+        globalPerfLogsList.push_back(log);
+        globalPerfLogsById[log->mId] = log;
+      }
+    }
   }
 
   // Next we need to look through for all the root names:
@@ -121,26 +253,115 @@ PerformanceLog::finalize()
 }
 
 //==============================================================================
-/// This checks if a given PerformanceLog object matches a stack of nameIds
-bool PerformanceLog::matches(std::vector<int> nameIdStack)
+/// This renders every finished log in the system as Chrome Trace Event JSON
+std::string PerformanceLog::toChromeTrace()
 {
-  if (nameIdStack[nameIdStack.size() - 1] != mNameIndex)
-    return false;
-  if (nameIdStack.size() == 1)
-    return true;
-  assert(mParentId != -1);
+  const std::lock_guard<std::mutex> namesLock(globalPerfLogListMutex);
+  const std::lock_guard<std::mutex> buffersLock(gThreadBuffersMutex);
 
-  std::vector<int> subStack = nameIdStack;
-  subStack.pop_back();
-  // Find parent and recurse
-  for (PerformanceLog* log : globalPerfLogsList)
+  // Timestamps are relative to the earliest log, to keep them readable
+  uint64_t firstClock = std::numeric_limits<uint64_t>::max();
+  for (ThreadLogBuffer* buffer : gThreadBuffers)
   {
-    if (log->mId == mParentId)
+    for (std::size_t i = buffer->firstLive; i < buffer->size; i++)
     {
-      return log->matches(subStack);
+      const PerformanceLog& log
+          = buffer->blocks[i / kLogsPerBlock][i % kLogsPerBlock];
+      firstClock = std::min(firstClock, log.mStartClock);
     }
   }
 
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(3);
+  stream << "{\"traceEvents\":[";
+  bool first = true;
+  for (ThreadLogBuffer* buffer : gThreadBuffers)
+  {
+    if (buffer->firstLive == buffer->size)
+      continue;
+    if (!first)
+      stream << ",";
+    first = false;
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+           << buffer->index << ",\"args\":{\"name\":\"thread "
+           << buffer->index << "\"}}";
+
+    for (std::size_t i = buffer->firstLive; i < buffer->size; i++)
+    {
+      const PerformanceLog& log
+          = buffer->blocks[i / kLogsPerBlock][i % kLogsPerBlock];
+      // Skip runs that never called end()
+      if (log.mEndClock < log.mStartClock)
+        continue;
+      stream << ",{\"name\":\""
+             << escapeJson(globalPerfStringReverseIndex[log.mNameIndex])
+             << "\",\"cat\":\"nimble\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+             << buffer->index
+             << ",\"ts\":" << clockToMicroseconds(log.mStartClock - firstClock)
+             << ",\"dur\":"
+             << clockToMicroseconds(log.mEndClock - log.mStartClock);
+      // Anything else we counted goes in the event's args, which the trace
+      // viewers show when you select it
+      std::stringstream args;
+      if (AllocationCounter::isEnabled())
+      {
+        const AllocationStats allocations
+            = log.mEndAllocations - log.mStartAllocations;
+        args << ",\"allocations\":" << allocations.numAllocations
+             << ",\"bytes\":" << allocations.numBytes;
+      }
+      if (HardwareCounters::isEnabled())
+      {
+        const HardwareCounterValues counters
+            = log.mEndCounters - log.mStartCounters;
+        args << ",\"instructions\":" << counters.instructions
+             << ",\"cache_misses\":" << counters.cacheMisses
+             << ",\"branch_misses\":" << counters.branchMisses;
+      }
+      if (args.tellp() > 0)
+        stream << ",\"args\":{" << args.str().substr(1) << "}";
+      stream << "}";
+    }
+  }
+  stream << "],\"displayTimeUnit\":\"ns\"}";
+  return stream.str();
+}
+
+//==============================================================================
+/// This writes toChromeTrace() to a file
+bool PerformanceLog::writeChromeTrace(const std::string& path)
+{
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cout << "PerformanceLog::writeChromeTrace() unable to open \"" << path
+              << "\" for writing" << std::endl;
+    return false;
+  }
+  file << toChromeTrace();
+  return file.good();
+}
+
+//==============================================================================
+/// This checks if a given PerformanceLog object matches a stack of nameIds
+bool PerformanceLog::matches(const std::vector<int>& nameIdStack)
+{
+  const PerformanceLog* log = this;
+  for (int i = nameIdStack.size() - 1; i >= 0; i--)
+  {
+    if (log->mNameIndex != nameIdStack[i])
+      return false;
+    if (i == 0)
+      return true;
+    assert(log->mParentId != -1);
+
+    // Find parent and keep walking up
+    auto parent = globalPerfLogsById.find(log->mParentId);
+    if (parent == globalPerfLogsById.end())
+      return false;
+    log = parent->second;
+  }
+
   return false;
 }
 
@@ -150,11 +371,13 @@ bool PerformanceLog::matches(std::vector<int> nameIdStack)
 /// objects into something sensible.
 PerformanceLog* PerformanceLog::startRun(char const* name)
 {
-  PerformanceLog* log = new PerformanceLog(mapStringToIndex(name), mId);
-  // Serialize our access to the log list
-  const std::lock_guard<std::mutex> lock(globalPerfLogListMutex);
-  globalPerfLogsList.push_back(log);
-  return log;
+  return allocate(mapStringToIndex(name), mId);
+}
+
+//==============================================================================
+PerformanceLog* PerformanceLog::startRun(int nameId)
+{
+  return allocate(nameId, mId);
 }
 
 //==============================================================================
@@ -162,21 +385,25 @@ PerformanceLog* PerformanceLog::startRun(char const* name)
 /// object.
 void PerformanceLog::end()
 {
+  mEndCounters = HardwareCounters::readThreadCounters();
   mEndClock = getClock();
+  mEndAllocations = AllocationCounter::getThreadStats();
+  SamplingProfiler::exitRegion(mNameIndex);
 }
 
 //==============================================================================
 /// This will look through the global static lists and recursively construct
 /// all the FinalizedPerformanceLogs to unify everything.
 std::shared_ptr<FinalizedPerformanceLog>
-FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
+FinalizedPerformanceLog::recursivelyConstruct(
+    const std::vector<int>& nameIdStack)
 {
   std::shared_ptr<FinalizedPerformanceLog> log
       = std::make_shared<FinalizedPerformanceLog>(
           PerformanceLog::globalPerfStringReverseIndex
               [nameIdStack[nameIdStack.size() - 1]]);
 
-  std::unordered_set<int> selfIds;
+  std::unordered_set<int64_t> selfIds;
 
   // Scan through once looking for instances of us
 
@@ -186,7 +413,10 @@ FinalizedPerformanceLog::recursivelyConstruct(std::vector<int> nameIdStack)
     if (rawLog->matches(nameIdStack))
     {
       uint64_t diff = rawLog->mEndClock - rawLog->mStartClock;
-      log->registerRun(diff);
+      log->registerRun(
+          diff,
+          rawLog->mEndAllocations - rawLog->mStartAllocations,
+          rawLog->mEndCounters - rawLog->mStartCounters);
       selfIds.insert(rawLog->mId);
     }
   }
@@ -241,9 +471,17 @@ void FinalizedPerformanceLog::setChild(
 }
 
 //==============================================================================
-void FinalizedPerformanceLog::registerRun(uint64_t duration)
+void FinalizedPerformanceLog::registerRun(
+    uint64_t duration,
+    AllocationStats allocations,
+    HardwareCounterValues counters)
 {
   mRuns.push_back(duration);
+  mAllocations.numAllocations += allocations.numAllocations;
+  mAllocations.numBytes += allocations.numBytes;
+  mCounters.instructions += counters.instructions;
+  mCounters.cacheMisses += counters.cacheMisses;
+  mCounters.branchMisses += counters.branchMisses;
 }
 
 //==============================================================================
@@ -270,6 +508,36 @@ uint64_t FinalizedPerformanceLog::getTotalRuntime()
   return sum;
 }
 
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getTotalAllocations()
+{
+  return mAllocations.numAllocations;
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getTotalAllocatedBytes()
+{
+  return mAllocations.numBytes;
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getTotalInstructions()
+{
+  return mCounters.instructions;
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getTotalCacheMisses()
+{
+  return mCounters.cacheMisses;
+}
+
+//==============================================================================
+uint64_t FinalizedPerformanceLog::getTotalBranchMisses()
+{
+  return mCounters.branchMisses;
+}
+
 //==============================================================================
 /// This will print the results in human readable format, which we can pipe to
 /// a file or to std::out
@@ -287,7 +555,7 @@ std::string FinalizedPerformanceLog::prettyPrint()
 std::string FinalizedPerformanceLog::toJson()
 {
   std::stringstream stream;
-  recursivePrettyPrint(0, getTotalRuntime(), static_cast<s_t>(1.0), stream);
+  recursiveToJson(stream);
   return stream.str();
 }
 
@@ -307,7 +575,19 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
 
   stream << (percentage * 100) << "%: " << mName << " (" << getNumRuns()
          << " runs at mean " << getMeanRuntime() << " cycles = " << totalCycles
-         << " total)\n";
+         << " total";
+  if (AllocationCounter::isEnabled())
+  {
+    stream << ", " << getTotalAllocations() << " allocations of "
+           << getTotalAllocatedBytes() << " bytes";
+  }
+  if (HardwareCounters::isEnabled())
+  {
+    stream << ", " << getTotalInstructions() << " instructions, "
+           << getTotalCacheMisses() << " cache misses, "
+           << getTotalBranchMisses() << " branch misses";
+  }
+  stream << ")\n";
 
   for (auto pair : mChildren)
   {
@@ -316,5 +596,35 @@ void FinalizedPerformanceLog::recursivePrettyPrint(
   }
 }
 
+//==============================================================================
+/// This writes us and our children as JSON to a stream
+void FinalizedPerformanceLog::recursiveToJson(std::stringstream& stream)
+{
+  stream << "{\"name\":\"" << escapeJson(mName)
+         << "\",\"numRuns\":" << getNumRuns()
+         << ",\"totalRuntime\":" << getTotalRuntime();
+  if (AllocationCounter::isEnabled())
+  {
+    stream << ",\"allocations\":" << getTotalAllocations()
+           << ",\"allocatedBytes\":" << getTotalAllocatedBytes();
+  }
+  if (HardwareCounters::isEnabled())
+  {
+    stream << ",\"instructions\":" << getTotalInstructions()
+           << ",\"cacheMisses\":" << getTotalCacheMisses()
+           << ",\"branchMisses\":" << getTotalBranchMisses();
+  }
+  stream << ",\"children\":[";
+  bool first = true;
+  for (auto pair : mChildren)
+  {
+    if (!first)
+      stream << ",";
+    first = false;
+    pair.second->recursiveToJson(stream);
+  }
+  stream << "]}";
+}
+
 } // namespace performance
 } // namespace dart
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef DART_PERFORMANCE_LOG_HPP_
 #define DART_PERFORMANCE_LOG_HPP_
 
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -10,9 +11,40 @@
 #include <vector>
 
 #include "dart/math/MathTypes.hpp"
-
-// Comment this out to disable performance logging in other parts of the code
+#include "dart/performance/AllocationCounter.hpp"
+#include "dart/performance/HardwareCounters.hpp"
+#include "dart/performance/SamplingProfiler.hpp"
+
+// Performance logging in other parts of the code is on unless the build
+// defines DART_DISABLE_PERFORMANCE_LOG (CMake: DART_ENABLE_PERFORMANCE_LOG=OFF),
+// in which case every instrumented call site compiles away.
+#ifndef DART_DISABLE_PERFORMANCE_LOG
 #define LOG_PERFORMANCE
+#endif
+
+#ifdef LOG_PERFORMANCE
+// Interns a string literal once per call site, so the hot path never hashes
+#define DART_PERF_NAME(name)                                                   \
+  ([]() -> int {                                                               \
+    static const int id                                                        \
+        = dart::performance::PerformanceLog::internName(name);                 \
+    return id;                                                                 \
+  }())
+// Starts a named child run of `parent`, or returns nullptr if parent is null
+#define DART_PERF_START_RUN(parent, name)                                      \
+  ((parent) == nullptr ? nullptr : (parent)->startRun(DART_PERF_NAME(name)))
+#define DART_PERF_END(log)                                                     \
+  do                                                                           \
+  {                                                                            \
+    if ((log) != nullptr)                                                      \
+      (log)->end();                                                            \
+  } while (0)
+#else
+#define DART_PERF_NAME(name) (-1)
+#define DART_PERF_START_RUN(parent, name)                                      \
+  ((void)(parent), static_cast<dart::performance::PerformanceLog*>(nullptr))
+#define DART_PERF_END(log) ((void)(log))
+#endif
 
 namespace dart {
 namespace performance {
@@ -23,7 +55,7 @@ public:
   /// This will look through the global static lists and recursively construct
   /// all the FinalizedPerformanceLogs to unify everything.
   static std::shared_ptr<FinalizedPerformanceLog> recursivelyConstruct(
-      std::vector<int> nameIdStack);
+      const std::vector<int>& nameIdStack);
 
   FinalizedPerformanceLog(const std::string& name);
 
@@ -32,7 +64,10 @@ public:
   void setChild(
       const std::string& name, std::shared_ptr<FinalizedPerformanceLog> child);
 
-  void registerRun(uint64_t duration);
+  void registerRun(
+      uint64_t duration,
+      AllocationStats allocations = AllocationStats(),
+      HardwareCounterValues counters = HardwareCounterValues());
 
   int getNumRuns();
 
@@ -40,12 +75,29 @@ public:
 
   uint64_t getTotalRuntime();
 
+  /// Returns the number of heap allocations made across all our runs (see
+  /// AllocationCounter), which is always zero unless the build counts them.
+  /// Like runtime, this includes the allocations of our children.
+  uint64_t getTotalAllocations();
+
+  /// Returns the number of bytes asked for by getTotalAllocations()
+  uint64_t getTotalAllocatedBytes();
+
+  /// Returns the hardware counts across all our runs (see HardwareCounters),
+  /// which are always zero unless the build reads them. Like runtime, these
+  /// include the counts of our children.
+  uint64_t getTotalInstructions();
+  uint64_t getTotalCacheMisses();
+  uint64_t getTotalBranchMisses();
+
   /// This will print the results in human readable format, which we can pipe to
   /// a file or to std::out
   std::string prettyPrint();
 
   /// This formats our results to JSON, which we can send to the browser to be
-  /// rendered.
+  /// rendered. Each log is an object with its name, number of runs, total
+  /// runtime, any allocation and hardware counts the build collects, and an
+  /// array of its children.
   std::string toJson();
 
 protected:
@@ -53,6 +105,8 @@ protected:
   std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       mChildren;
   std::vector<uint64_t> mRuns;
+  AllocationStats mAllocations;
+  HardwareCounterValues mCounters;
 
   /// This pretty prints to a stream
   void recursivePrettyPrint(
@@ -60,15 +114,19 @@ protected:
       long parentTotalCycles,
       s_t parentPercentage,
       std::stringstream& stream);
+
+  /// This writes us and our children as JSON to a stream
+  void recursiveToJson(std::stringstream& stream);
 };
 
 class PerformanceLog
 {
   friend class FinalizedPerformanceLog;
+  friend class SamplingProfiler;
 
 public:
   /// Default constructor
-  PerformanceLog(int nameIndex, int parentId);
+  PerformanceLog(int nameIndex, int64_t parentId);
 
   /// Disable the copy constructor
   // PerformanceLog(const PerformanceLog&) = delete;
@@ -76,29 +134,54 @@ public:
   /// This returns a new root PerformanceLog instance, which can spawn children
   static PerformanceLog* startRoot(char const* name);
 
+  /// Same as startRoot(name), but with a name already run through
+  /// internName() (see DART_PERF_NAME), which skips the name lookup.
+  static PerformanceLog* startRoot(int nameId);
+
   /// This looks through all the PerformanceLogs in the system and builds a
   /// report. This is not concerned about efficiency, and we attempt to offload
-  /// as much slowness from elsewhere into here as possible.
+  /// as much slowness from elsewhere into here as possible. This reads every
+  /// thread's buffer, so call it once the instrumented work has finished.
   static std::
       unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
       finalize();
 
+  /// This renders every finished log in the system as Chrome Trace Event
+  /// JSON, which chrome://tracing and ui.perfetto.dev can open as a timeline.
+  /// Each thread that logged gets its own track. Like finalize(), call this
+  /// once the instrumented work has finished.
+  static std::string toChromeTrace();
+
+  /// This writes toChromeTrace() to a file, returning false if we can't open
+  /// it.
+  static bool writeChromeTrace(const std::string& path);
+
   /// This checks if a given PerformanceLog object matches a stack of nameIds
-  bool matches(std::vector<int> nameIdStack);
+  bool matches(const std::vector<int>& nameIdStack);
 
   /// This starts a sub-run within this PerformanceLog, giving it a specific
   /// name. After the fact we can use these names to coalesce PerformanceLog
   /// objects into something sensible.
   PerformanceLog* startRun(char const* name);
 
+  /// Same as startRun(name), but with a name already run through
+  /// internName() (see DART_PERF_NAME), which skips the name lookup.
+  PerformanceLog* startRun(int nameId);
+
   /// This terminates the run that we're logging with this PerformanceLog
   /// object.
   void end();
 
   /// This needs to be called once at the beginning of execution, and if it's
-  /// called multiple times will clear previous logs.
+  /// called multiple times will clear previous logs. Logs that are still open
+  /// stay valid, they're just left out of the next finalize().
   static void initialize();
 
+  /// This returns the process-wide numerical key for a name, registering it
+  /// if we haven't seen it before. This takes a lock, so hot code should
+  /// cache the result, which is what DART_PERF_NAME does.
+  static int internName(const char* name);
+
 protected:
   /// Don't store a whole copy of the name, just a numerical key
   int mNameIndex;
@@ -109,17 +192,44 @@ protected:
   /// This is the clock when we called end()
   uint64_t mEndClock;
 
-  /// This is the ID which we'll use to reassemble the graph after the fact
-  int mId;
+  /// These are the calling thread's AllocationCounter totals at the start of
+  /// our existence and when we called end(). Only allocations made on the
+  /// thread that started us are counted, so work a run hands off to other
+  /// threads shows up in their runs instead.
+  AllocationStats mStartAllocations;
+  AllocationStats mEndAllocations;
+
+  /// These are the calling thread's HardwareCounters at the start of our
+  /// existence and when we called end(), counted on the same terms as
+  /// allocations
+  HardwareCounterValues mStartCounters;
+  HardwareCounterValues mEndCounters;
+
+  /// This is the ID which we'll use to reassemble the graph after the fact.
+  /// The high bits are the index of the thread buffer that owns us, the low
+  /// bits our slot in it, so IDs are unique without any shared counter.
+  int64_t mId;
 
   /// This is the parent's ID
-  int mParentId;
+  int64_t mParentId;
 
+  /// This constructs a new log in the calling thread's buffer. Each thread
+  /// only ever appends to its own buffer, so this never takes a lock after a
+  /// thread's first log.
+  static PerformanceLog* allocate(int nameIndex, int64_t parentId);
+
+  /// This maps a name to its key through a per-thread cache keyed on the
+  /// string's address, falling back to internName() on a miss.
   static int mapStringToIndex(const char* str);
 
+  /// These are only touched by internName() and finalize()
   static std::unordered_map<std::string, int> globalPerfStringIndex;
+  static std::vector<std::string> globalPerfStringReverseIndex;
+
+  /// These are snapshots of all the threads' buffers, built by finalize()
   static std::deque<PerformanceLog*> globalPerfLogsList;
-  static std::unordered_map<int, std::string> globalPerfStringReverseIndex;
+  static std::unordered_map<int64_t, PerformanceLog*> globalPerfLogsById;
+
   static std::mutex globalPerfLogListMutex;
 };
 
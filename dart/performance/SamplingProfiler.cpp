@@ -0,0 +1,488 @@
+#include "dart/performance/SamplingProfiler.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "dart/performance/PerformanceLog.hpp"
+
+namespace dart {
+namespace performance {
+
+namespace {
+
+/// Runs nested deeper than this are still tracked, but samples only record
+/// the outermost ones
+constexpr int kMaxRegionDepth = 32;
+
+/// This is how many threads we can track the open runs of at once. Threads
+/// that come after these are sampled as if they had no runs open.
+constexpr int kMaxThreads = 4096;
+
+/// This is how many distinct stacks we can count samples of
+constexpr int kMaxStacks = 4096;
+
+/// The runs open on a thread. Only the owning thread writes this, and the
+/// only other reader is the signal handler interrupting that same thread, so
+/// compiler fences are all the ordering we need.
+struct RegionStack
+{
+  volatile int depth = 0;
+  int nameIds[kMaxRegionDepth];
+};
+
+/// Maps a kernel thread ID to its RegionStack. Slots are claimed by writing
+/// the tid, and a thread that reuses the tid of one that exited takes over
+/// its slot.
+struct ThreadSlot
+{
+  std::atomic<pid_t> tid;
+  std::atomic<RegionStack*> stack;
+};
+
+ThreadSlot gThreads[kMaxThreads];
+
+/// The calling thread's RegionStack, which we empty when the thread exits,
+/// in case the handler finds it again through a reused tid
+struct RegionStackHandle
+{
+  RegionStack* stack = nullptr;
+
+  ~RegionStackHandle()
+  {
+    if (stack != nullptr)
+      stack->depth = 0;
+  }
+};
+
+thread_local RegionStackHandle tRegionStack;
+
+enum StackSlotState
+{
+  EMPTY = 0,
+  WRITING = 1,
+  READY = 2
+};
+
+/// One distinct stack, and the number of samples that landed in it
+struct StackSlot
+{
+  std::atomic<int> state;
+  int depth;
+  int nameIds[kMaxRegionDepth];
+  std::atomic<uint64_t> count;
+};
+
+/// This is allocated by the first start(), and never freed, since a signal
+/// can still be in flight after stop()
+std::atomic<StackSlot*> gStacks(nullptr);
+
+std::atomic<bool> gRunning(false);
+std::atomic<uint64_t> gNumSamples(0);
+std::atomic<uint64_t> gNumDropped(0);
+
+/// Guards start(), stop() and reading out the stacks
+std::mutex gControlMutex;
+struct sigaction gPreviousAction;
+
+pid_t getTid()
+{
+  return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+/// This finds the slot for `tid`, or returns -1 if it isn't registered
+int findThreadSlot(pid_t tid)
+{
+  for (int i = 0; i < kMaxThreads; i++)
+  {
+    const int slot = (static_cast<unsigned>(tid) + i) % kMaxThreads;
+    const pid_t slotTid = gThreads[slot].tid.load(std::memory_order_acquire);
+    if (slotTid == tid)
+      return slot;
+    if (slotTid == 0)
+      return -1;
+  }
+  return -1;
+}
+
+/// This creates the calling thread's RegionStack, and registers it so the
+/// signal handler can find it
+RegionStack* getRegionStack()
+{
+  if (tRegionStack.stack == nullptr)
+  {
+    // Stacks outlive their threads, since the handler may still be reading
+    // one when it exits, so these are never freed
+    RegionStack* stack = new RegionStack();
+    const pid_t tid = getTid();
+    for (int i = 0; i < kMaxThreads; i++)
+    {
+      const int slot = (static_cast<unsigned>(tid) + i) % kMaxThreads;
+      pid_t expected = 0;
+      if (gThreads[slot].tid.load(std::memory_order_acquire) == tid
+          || gThreads[slot].tid.compare_exchange_strong(
+              expected, tid, std::memory_order_acq_rel))
+      {
+        gThreads[slot].stack.store(stack, std::memory_order_release);
+        break;
+      }
+    }
+    tRegionStack.stack = stack;
+  }
+  return tRegionStack.stack;
+}
+
+uint64_t hashStack(const int* nameIds, int depth)
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < depth; i++)
+  {
+    hash ^= static_cast<uint64_t>(static_cast<unsigned>(nameIds[i]));
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/// This adds one sample of the stack `nameIds` to the table. It's called from
+/// the signal handler, possibly on several threads at once.
+void recordSample(const int* nameIds, int depth)
+{
+  StackSlot* stacks = gStacks.load(std::memory_order_acquire);
+  if (stacks == nullptr)
+    return;
+  gNumSamples.fetch_add(1, std::memory_order_relaxed);
+
+  const uint64_t hash = hashStack(nameIds, depth);
+  for (int i = 0; i < kMaxStacks; i++)
+  {
+    StackSlot& slot = stacks[(hash + i) % kMaxStacks];
+    int state = slot.state.load(std::memory_order_acquire);
+    if (state == EMPTY)
+    {
+      if (slot.state.compare_exchange_strong(
+              state, WRITING, std::memory_order_acq_rel))
+      {
+        slot.depth = depth;
+        std::copy(nameIds, nameIds + depth, slot.nameIds);
+        slot.count.store(1, std::memory_order_relaxed);
+        slot.state.store(READY, std::memory_order_release);
+        return;
+      }
+    }
+    // A slot that's being written right now is skipped, so the same stack can
+    // end up in two slots, which getFoldedStacks() merges
+    if (state == READY && slot.depth == depth
+        && std::equal(nameIds, nameIds + depth, slot.nameIds))
+    {
+      slot.count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  gNumDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void handleSample(int /* signal */, siginfo_t* /* info */, void* /* context */)
+{
+  if (!gRunning.load(std::memory_order_relaxed))
+    return;
+  // syscall() can set errno, which the code we interrupted may be reading
+  const int savedErrno = errno;
+
+  int nameIds[kMaxRegionDepth];
+  int depth = 0;
+  const int slot = findThreadSlot(getTid());
+  if (slot != -1)
+  {
+    const RegionStack* stack
+        = gThreads[slot].stack.load(std::memory_order_acquire);
+    if (stack != nullptr)
+    {
+      depth = std::min(static_cast<int>(stack->depth), kMaxRegionDepth);
+      std::atomic_signal_fence(std::memory_order_acquire);
+      std::copy(stack->nameIds, stack->nameIds + depth, nameIds);
+    }
+  }
+  recordSample(nameIds, depth);
+
+  errno = savedErrno;
+}
+
+/// This turns a run name into a frame of a folded stack, which can't contain
+/// the ";" that separates frames, or a newline
+std::string toFrame(const std::string& name)
+{
+  std::string frame = name;
+  std::replace(frame.begin(), frame.end(), ';', ':');
+  std::replace(frame.begin(), frame.end(), '\n', ' ');
+  return frame;
+}
+
+} // namespace
+
+//==============================================================================
+bool SamplingProfiler::start(int frequencyHz)
+{
+  const std::lock_guard<std::mutex> lock(gControlMutex);
+  if (gRunning.load())
+    return false;
+  if (frequencyHz <= 0)
+  {
+    std::cout << "SamplingProfiler::start() needs a positive frequency, got "
+              << frequencyHz << std::endl;
+    return false;
+  }
+  if (gStacks.load() == nullptr)
+    gStacks.store(new StackSlot[kMaxStacks]());
+
+  struct sigaction action;
+  action.sa_sigaction = &handleSample;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART | SA_SIGINFO;
+  if (sigaction(SIGPROF, &action, &gPreviousAction) != 0)
+  {
+    std::cout << "SamplingProfiler::start() unable to install a SIGPROF "
+              << "handler" << std::endl;
+    return false;
+  }
+
+  gRunning.store(true);
+  const long intervalMicros = std::max(1L, 1000000L / frequencyHz);
+  struct itimerval timer;
+  timer.it_interval.tv_sec = intervalMicros / 1000000;
+  timer.it_interval.tv_usec = intervalMicros % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+  {
+    std::cout << "SamplingProfiler::start() unable to start the profiling "
+              << "timer" << std::endl;
+    gRunning.store(false);
+    sigaction(SIGPROF, &gPreviousAction, nullptr);
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+void SamplingProfiler::stop()
+{
+  const std::lock_guard<std::mutex> lock(gControlMutex);
+  if (!gRunning.load())
+    return;
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = 0;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  gRunning.store(false);
+  // A SIGPROF can still be pending on some thread, so we leave our handler
+  // in place (it ignores signals once we've stopped) rather than restoring
+  // one that might kill the process
+}
+
+//==============================================================================
+bool SamplingProfiler::isRunning()
+{
+  return gRunning.load();
+}
+
+//==============================================================================
+void SamplingProfiler::clear()
+{
+  const std::lock_guard<std::mutex> lock(gControlMutex);
+  // Stacks stay in the table, since the handler may be writing to it, but
+  // getFoldedStacks() leaves out any that have no samples
+  StackSlot* stacks = gStacks.load();
+  if (stacks != nullptr)
+  {
+    for (int i = 0; i < kMaxStacks; i++)
+    {
+      stacks[i].count.store(0);
+    }
+  }
+  gNumSamples.store(0);
+  gNumDropped.store(0);
+}
+
+//==============================================================================
+std::string SamplingProfiler::getFoldedStacks()
+{
+  const std::lock_guard<std::mutex> lock(gControlMutex);
+  StackSlot* stacks = gStacks.load();
+  if (stacks == nullptr)
+    return "";
+
+  std::map<std::string, uint64_t> folded;
+  {
+    const std::lock_guard<std::mutex> namesLock(
+        PerformanceLog::globalPerfLogListMutex);
+    const std::vector<std::string>& names
+        = PerformanceLog::globalPerfStringReverseIndex;
+    for (int i = 0; i < kMaxStacks; i++)
+    {
+      const StackSlot& slot = stacks[i];
+      if (slot.state.load(std::memory_order_acquire) != READY)
+        continue;
+      const uint64_t count = slot.count.load();
+      if (count == 0)
+        continue;
+
+      std::string stack;
+      for (int j = 0; j < slot.depth; j++)
+      {
+        if (j > 0)
+          stack += ";";
+        const int nameId = slot.nameIds[j];
+        if (nameId >= 0 && nameId < static_cast<int>(names.size()))
+          stack += toFrame(names[nameId]);
+        else
+          stack += "[unknown]";
+      }
+      if (slot.depth == 0)
+        stack = "[no region]";
+      folded[stack] += count;
+    }
+  }
+
+  std::stringstream stream;
+  for (auto& pair : folded)
+  {
+    stream << pair.first << " " << pair.second << "\n";
+  }
+  return stream.str();
+}
+
+//==============================================================================
+uint64_t SamplingProfiler::getNumSamples()
+{
+  return gNumSamples.load();
+}
+
+//==============================================================================
+uint64_t SamplingProfiler::getNumDroppedSamples()
+{
+  return gNumDropped.load();
+}
+
+//==============================================================================
+void SamplingProfiler::enterRegion(int nameId)
+{
+  RegionStack* stack = getRegionStack();
+  const int depth = stack->depth;
+  if (depth < kMaxRegionDepth)
+    stack->nameIds[depth] = nameId;
+  // The name has to land before the handler can see the new depth
+  std::atomic_signal_fence(std::memory_order_release);
+  stack->depth = depth + 1;
+}
+
+//==============================================================================
+void SamplingProfiler::exitRegion(int nameId)
+{
+  RegionStack* stack = getRegionStack();
+  const int depth = stack->depth;
+  if (depth == 0)
+    return;
+  // Runs that end on a different thread than they started on, or out of
+  // order, would otherwise pop someone else's run
+  if (depth <= kMaxRegionDepth && stack->nameIds[depth - 1] != nameId)
+    return;
+  stack->depth = depth - 1;
+}
+
+} // namespace performance
+} // namespace dart
+
+#else
+
+namespace dart {
+namespace performance {
+
+//==============================================================================
+bool SamplingProfiler::start(int /* frequencyHz */)
+{
+  std::cout << "SamplingProfiler is only supported on Linux" << std::endl;
+  return false;
+}
+
+//==============================================================================
+void SamplingProfiler::stop()
+{
+}
+
+//==============================================================================
+bool SamplingProfiler::isRunning()
+{
+  return false;
+}
+
+//==============================================================================
+void SamplingProfiler::clear()
+{
+}
+
+//==============================================================================
+std::string SamplingProfiler::getFoldedStacks()
+{
+  return "";
+}
+
+//==============================================================================
+uint64_t SamplingProfiler::getNumSamples()
+{
+  return 0;
+}
+
+//==============================================================================
+uint64_t SamplingProfiler::getNumDroppedSamples()
+{
+  return 0;
+}
+
+//==============================================================================
+void SamplingProfiler::enterRegion(int /* nameId */)
+{
+}
+
+//==============================================================================
+void SamplingProfiler::exitRegion(int /* nameId */)
+{
+}
+
+} // namespace performance
+} // namespace dart
+
+#endif
+
+namespace dart {
+namespace performance {
+
+//==============================================================================
+bool SamplingProfiler::writeFoldedStacks(const std::string& path)
+{
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    std::cout << "SamplingProfiler::writeFoldedStacks() unable to open \""
+              << path << "\" for writing" << std::endl;
+    return false;
+  }
+  file << getFoldedStacks();
+  return file.good();
+}
+
+} // namespace performance
+} // namespace dart
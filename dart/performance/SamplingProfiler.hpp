@@ -0,0 +1,76 @@
+#ifndef DART_PERFORMANCE_SAMPLING_PROFILER_HPP_
+#define DART_PERFORMANCE_SAMPLING_PROFILER_HPP_
+
+#include <cstdint>
+#include <string>
+
+// The sampling profiler is only supported on Linux, where it's driven by
+// SIGPROF. Elsewhere start() returns false and nothing is ever sampled.
+
+namespace dart {
+namespace performance {
+
+/// This is a sampling profiler that can be switched on and off inside a
+/// running process, so we can profile a long running MPC or fitter without
+/// restarting it under perf.
+///
+/// While it's running, a SIGPROF timer interrupts whichever thread is using
+/// the CPU, at a fixed rate of CPU time summed over threads. Each sample is
+/// charged to the stack of PerformanceLog runs open on that thread when it
+/// was interrupted (or to "[no region]" if there were none), so the profile
+/// lines up with the names in PerformanceLog reports. The results come out as
+/// folded stacks, which flamegraph.pl and speedscope read directly.
+///
+/// Runs are only tracked on the thread that started them, so a run started
+/// on a worker thread under a parent from another thread shows up without its
+/// parent. The signal handler never allocates or takes a lock. Up to 4096
+/// distinct stacks are kept, and samples of any more are counted as dropped.
+///
+/// SIGPROF is also used by other profilers (like gperftools), so only run one
+/// at a time.
+class SamplingProfiler
+{
+public:
+  /// This starts sampling `frequencyHz` times per second of CPU time. Returns
+  /// false if the profiler is already running, or this platform doesn't
+  /// support it. Samples add to whatever's been collected since the last
+  /// clear().
+  static bool start(int frequencyHz = 99);
+
+  /// This stops sampling, keeping the samples collected so far
+  static void stop();
+
+  /// Returns true between start() and stop()
+  static bool isRunning();
+
+  /// This throws away every sample collected so far
+  static void clear();
+
+  /// This returns the samples collected so far as folded stacks: one line
+  /// per distinct stack, with the names of its runs from outermost to
+  /// innermost separated by ";", then a space and the number of samples.
+  static std::string getFoldedStacks();
+
+  /// This writes getFoldedStacks() to a file, returning false if we can't
+  /// open it
+  static bool writeFoldedStacks(const std::string& path);
+
+  /// Returns the number of samples collected since the last clear()
+  static uint64_t getNumSamples();
+
+  /// Returns the number of samples we threw away since the last clear(),
+  /// because we were already tracking as many distinct stacks as we can
+  static uint64_t getNumDroppedSamples();
+
+  /// These are called by PerformanceLog as runs start and end, to keep track
+  /// of the runs open on the calling thread. They're cheap, and run whether
+  /// or not we're sampling, so a profile started part way through a run
+  /// still sees it.
+  static void enterRegion(int nameId);
+  static void exitRegion(int nameId);
+};
+
+} // namespace performance
+} // namespace dart
+
+#endif
@@ -1,20 +1,95 @@
 #include "dart/proto/SerializeEigen.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
 namespace dart {
 namespace proto {
 
-void serializeVector(proto::VectorXs& proto, const Eigen::VectorXs& vec)
+namespace {
+
+bool isLittleEndian()
+{
+  const uint16_t one = 1;
+  return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+/// Protos store doubles little-endian, so big-endian hosts swap the bytes
+void swapToOrFromLittleEndian(char* bytes)
+{
+  if (!isLittleEndian())
+  {
+    std::reverse(bytes, bytes + sizeof(double));
+  }
+}
+
+/// This writes `count` scalars to `dst` as little-endian doubles
+void packDoubles(char* dst, const s_t* src, int count)
+{
+#if !defined(DART_USE_ARBITRARY_PRECISION) && !defined(DART_USE_FLOAT32)
+  if (isLittleEndian())
+  {
+    std::memcpy(dst, src, count * sizeof(double));
+    return;
+  }
+#endif
+  for (int i = 0; i < count; i++)
+  {
+    double value = static_cast<double>(src[i]);
+    char* bytes = dst + i * sizeof(double);
+    std::memcpy(bytes, &value, sizeof(double));
+    swapToOrFromLittleEndian(bytes);
+  }
+}
+
+/// This reads `count` little-endian doubles from `src` into `dst`
+void unpackDoubles(s_t* dst, const char* src, int count)
+{
+#if !defined(DART_USE_ARBITRARY_PRECISION) && !defined(DART_USE_FLOAT32)
+  if (isLittleEndian())
+  {
+    std::memcpy(dst, src, count * sizeof(double));
+    return;
+  }
+#endif
+  for (int i = 0; i < count; i++)
+  {
+    char bytes[sizeof(double)];
+    std::memcpy(bytes, src + i * sizeof(double), sizeof(double));
+    swapToOrFromLittleEndian(bytes);
+    double value;
+    std::memcpy(&value, bytes, sizeof(double));
+    dst[i] = static_cast<s_t>(value);
+  }
+}
+
+} // namespace
+
+void serializeVector(
+    proto::VectorXs& proto, const Eigen::Ref<const Eigen::VectorXs>& vec)
 {
   proto.set_size(vec.size());
-  for (int i = 0; i < vec.size(); i++)
+  proto.clear_values();
+  std::string* data = proto.mutable_data();
+  data->resize(vec.size() * sizeof(double));
+  if (vec.size() > 0)
   {
-    proto.add_values(static_cast<double>(vec(i)));
+    packDoubles(&(*data)[0], vec.data(), vec.size());
   }
 }
 
 Eigen::VectorXs deserializeVector(const proto::VectorXs& proto)
 {
   Eigen::VectorXs recovered = Eigen::VectorXs::Zero(proto.size());
+  if (proto.data().size() > 0)
+  {
+    assert(proto.data().size() == proto.size() * sizeof(double));
+    unpackDoubles(recovered.data(), proto.data().data(), proto.size());
+    return recovered;
+  }
   for (int i = 0; i < proto.size(); i++)
   {
     recovered(i) = static_cast<s_t>(proto.values(i));
@@ -22,15 +97,29 @@ Eigen::VectorXs deserializeVector(const proto::VectorXs& proto)
   return recovered;
 }
 
-void serializeMatrix(proto::MatrixXs& proto, const Eigen::MatrixXs& mat)
+void serializeMatrix(
+    proto::MatrixXs& proto, const Eigen::Ref<const Eigen::MatrixXs>& mat)
 {
   proto.set_rows(mat.rows());
   proto.set_cols(mat.cols());
-  for (int col = 0; col < mat.cols(); col++)
+  proto.clear_values();
+  std::string* data = proto.mutable_data();
+  data->resize(mat.size() * sizeof(double));
+  if (mat.size() == 0)
+    return;
+  if (mat.outerStride() == mat.rows())
   {
-    for (int row = 0; row < mat.rows(); row++)
+    packDoubles(&(*data)[0], mat.data(), mat.size());
+  }
+  else
+  {
+    // This is a block out of a bigger matrix, so copy a column at a time
+    for (int col = 0; col < mat.cols(); col++)
     {
-      proto.add_values(static_cast<double>(mat(row, col)));
+      packDoubles(
+          &(*data)[col * mat.rows() * sizeof(double)],
+          mat.col(col).data(),
+          mat.rows());
     }
   }
 }
@@ -38,6 +127,12 @@ void serializeMatrix(proto::MatrixXs& proto, const Eigen::MatrixXs& mat)
 Eigen::MatrixXs deserializeMatrix(const proto::MatrixXs& proto)
 {
   Eigen::MatrixXs recovered = Eigen::MatrixXs::Zero(proto.rows(), proto.cols());
+  if (proto.data().size() > 0)
+  {
+    assert(proto.data().size() == recovered.size() * sizeof(double));
+    unpackDoubles(recovered.data(), proto.data().data(), recovered.size());
+    return recovered;
+  }
   int cursor = 0;
   for (int col = 0; col < proto.cols(); col++)
   {
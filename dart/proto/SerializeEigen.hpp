@@ -9,10 +9,16 @@
 namespace dart {
 namespace proto {
 
-void serializeVector(proto::VectorXs& proto, const Eigen::VectorXs& vec);
+/// These write the values into the packed `data` field as raw little-endian
+/// doubles (a single memcpy when the layout allows it), overwriting whatever
+/// was there before. Reusing the same proto (or one allocated on an Arena)
+/// across calls reuses the underlying buffer.
+void serializeVector(
+    proto::VectorXs& proto, const Eigen::Ref<const Eigen::VectorXs>& vec);
 Eigen::VectorXs deserializeVector(const proto::VectorXs& proto);
 
-void serializeMatrix(proto::MatrixXs& proto, const Eigen::MatrixXs& mat);
+void serializeMatrix(
+    proto::MatrixXs& proto, const Eigen::Ref<const Eigen::MatrixXs>& mat);
 Eigen::MatrixXs deserializeMatrix(const proto::MatrixXs& proto);
 
 } // namespace proto
@@ -0,0 +1,168 @@
+#include "dart/realtime/ColumnarLog.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dart {
+namespace realtime {
+
+ColumnarLog::ColumnarLog(int dim, int initialCapacity)
+  : mDim(dim),
+    mValues(Eigen::MatrixXs::Zero(dim, std::max(1, initialCapacity))),
+    mTimes(std::max(1, initialCapacity), 0L),
+    mBegin(0),
+    mEnd(0)
+{
+}
+
+int ColumnarLog::getDim() const
+{
+  return mDim;
+}
+
+/// This returns the number of entries in the log
+int ColumnarLog::size() const
+{
+  return mEnd - mBegin;
+}
+
+bool ColumnarLog::empty() const
+{
+  return mEnd == mBegin;
+}
+
+/// This adds an entry. This is O(1) as long as `time` isn't earlier than the
+/// last entry, otherwise the later entries have to be shifted up to make room.
+void ColumnarLog::append(
+    long time, const Eigen::Ref<const Eigen::VectorXs>& value)
+{
+  assert(value.size() == mDim);
+  reserveOneMore();
+  int index = mEnd;
+  if (mEnd > mBegin && mTimes[mEnd - 1] > time)
+  {
+    index = mBegin + upperBound(time);
+    for (int i = mEnd; i > index; i--)
+    {
+      mValues.col(i) = mValues.col(i - 1);
+      mTimes[i] = mTimes[i - 1];
+    }
+  }
+  mValues.col(index) = value;
+  mTimes[index] = time;
+  mEnd++;
+}
+
+/// This overwrites the value of the last entry, which must exist
+void ColumnarLog::setLast(const Eigen::Ref<const Eigen::VectorXs>& value)
+{
+  assert(!empty());
+  mValues.col(mEnd - 1) = value;
+}
+
+long ColumnarLog::getTime(int index) const
+{
+  return mTimes[mBegin + index];
+}
+
+Eigen::Map<const Eigen::VectorXs> ColumnarLog::getValue(int index) const
+{
+  return Eigen::Map<const Eigen::VectorXs>(
+      mValues.data() + (std::size_t)(mBegin + index) * mDim, mDim);
+}
+
+/// This returns the last entry's value, which must exist
+Eigen::Map<const Eigen::VectorXs> ColumnarLog::getLast() const
+{
+  assert(!empty());
+  return getValue(size() - 1);
+}
+
+/// This returns a view of `count` consecutive entries' values, starting at
+/// `index`, as columns
+Eigen::Map<const Eigen::MatrixXs> ColumnarLog::getValues(
+    int index, int count) const
+{
+  assert(index >= 0 && count >= 0 && index + count <= size());
+  return Eigen::Map<const Eigen::MatrixXs>(
+      mValues.data() + (std::size_t)(mBegin + index) * mDim, mDim, count);
+}
+
+/// This returns a view of the times of `count` consecutive entries, starting
+/// at `index`
+Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>> ColumnarLog::getTimes(
+    int index, int count) const
+{
+  assert(index >= 0 && count >= 0 && index + count <= size());
+  return Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>>(
+      mTimes.data() + mBegin + index, count);
+}
+
+/// This returns the index of the first entry at or after `time`, or size() if
+/// there isn't one
+int ColumnarLog::lowerBound(long time) const
+{
+  return std::lower_bound(
+             mTimes.begin() + mBegin, mTimes.begin() + mEnd, time)
+         - (mTimes.begin() + mBegin);
+}
+
+/// This returns the index of the first entry strictly after `time`, or size()
+/// if there isn't one
+int ColumnarLog::upperBound(long time) const
+{
+  return std::upper_bound(
+             mTimes.begin() + mBegin, mTimes.begin() + mEnd, time)
+         - (mTimes.begin() + mBegin);
+}
+
+/// This drops the first `count` entries
+void ColumnarLog::discardFirst(int count)
+{
+  mBegin += std::max(0, std::min(count, size()));
+  if (mBegin == mEnd)
+  {
+    mBegin = 0;
+    mEnd = 0;
+  }
+}
+
+/// This drops every entry
+void ColumnarLog::clear()
+{
+  mBegin = 0;
+  mEnd = 0;
+}
+
+/// This makes sure there's room for one more entry at the back
+void ColumnarLog::reserveOneMore()
+{
+  int capacity = mTimes.size();
+  if (mEnd < capacity)
+    return;
+
+  int live = size();
+  if (live * 2 <= capacity)
+  {
+    // At least half of the storage is discarded entries at the front, so
+    // shifting the live ones down pays for itself before we're back here
+    mValues.leftCols(live) = mValues.middleCols(mBegin, live).eval();
+    std::copy(
+        mTimes.begin() + mBegin, mTimes.begin() + mEnd, mTimes.begin());
+  }
+  else
+  {
+    Eigen::MatrixXs grown = Eigen::MatrixXs::Zero(mDim, capacity * 2);
+    grown.leftCols(live) = mValues.middleCols(mBegin, live);
+    mValues.swap(grown);
+    std::vector<long> grownTimes(capacity * 2, 0L);
+    std::copy(
+        mTimes.begin() + mBegin, mTimes.begin() + mEnd, grownTimes.begin());
+    mTimes.swap(grownTimes);
+  }
+  mBegin = 0;
+  mEnd = live;
+}
+
+} // namespace realtime
+} // namespace dart
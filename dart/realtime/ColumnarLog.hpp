@@ -0,0 +1,90 @@
+#ifndef DART_REALTIME_COLUMNAR_LOG
+#define DART_REALTIME_COLUMNAR_LOG
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace realtime {
+
+/// This is the storage shared by the realtime logs: a sequence of timestamped
+/// vectors, sorted by time, stored column-by-column in a single matrix so
+/// that any run of consecutive entries can be viewed as an Eigen::Map without
+/// copying.
+///
+/// Entries are appended at the back and discarded from the front, like a
+/// ring buffer, except that live entries are always kept contiguous: when we
+/// run out of room at the back, the live entries are shifted down to reuse
+/// the discarded space (or the storage is doubled, if more than half of it is
+/// live). Both operations are amortized O(1), and finding entries by time is
+/// a binary search.
+class ColumnarLog
+{
+public:
+  ColumnarLog(int dim, int initialCapacity = 64);
+
+  int getDim() const;
+
+  /// This returns the number of entries in the log
+  int size() const;
+
+  bool empty() const;
+
+  /// This adds an entry. This is O(1) as long as `time` isn't earlier than
+  /// the last entry, otherwise the later entries have to be shifted up to
+  /// make room.
+  void append(long time, const Eigen::Ref<const Eigen::VectorXs>& value);
+
+  /// This overwrites the value of the last entry, which must exist
+  void setLast(const Eigen::Ref<const Eigen::VectorXs>& value);
+
+  long getTime(int index) const;
+
+  Eigen::Map<const Eigen::VectorXs> getValue(int index) const;
+
+  /// This returns the last entry's value, which must exist
+  Eigen::Map<const Eigen::VectorXs> getLast() const;
+
+  /// This returns a view of `count` consecutive entries' values, starting at
+  /// `index`, as columns. This is only valid until the next change to the log.
+  Eigen::Map<const Eigen::MatrixXs> getValues(int index, int count) const;
+
+  /// This returns a view of the times of `count` consecutive entries,
+  /// starting at `index`. This is only valid until the next change to the
+  /// log.
+  Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>> getTimes(
+      int index, int count) const;
+
+  /// This returns the index of the first entry at or after `time`, or size()
+  /// if there isn't one
+  int lowerBound(long time) const;
+
+  /// This returns the index of the first entry strictly after `time`, or
+  /// size() if there isn't one
+  int upperBound(long time) const;
+
+  /// This drops the first `count` entries
+  void discardFirst(int count);
+
+  /// This drops every entry
+  void clear();
+
+protected:
+  /// This makes sure there's room for one more entry at the back
+  void reserveOneMore();
+
+  int mDim;
+  // Live entries are the columns [mBegin, mEnd)
+  Eigen::MatrixXs mValues;
+  std::vector<long> mTimes;
+  int mBegin;
+  int mEnd;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -1,10 +1,12 @@
 #include "dart/realtime/ControlLog.hpp"
 
+#include <algorithm>
+
 namespace dart {
 namespace realtime {
 
 ControlLog::ControlLog(int dim, int millisPerStep)
-  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L)
+  : mDim(dim), mMillisPerStep(millisPerStep), mLogEnd(0L), mLog(dim)
 {
 }
 
@@ -15,7 +17,7 @@ void ControlLog::record(long time, Eigen::VectorXs control)
   if (mLog.size() == 0)
   {
     mLogStart = time;
-    mLog.push_back(control);
+    mLog.append(time, control);
   }
   else
   {
@@ -33,18 +35,18 @@ void ControlLog::record(long time, Eigen::VectorXs control)
     // haven't had time to run a full timestep since our last recorded value
     if (steps == 0)
     {
-      mLog[mLog.size() - 1] = control;
+      mLog.setLast(control);
       return;
     }
     // Otherwise, we need to extend the last recorded force until just before
     // this timestep, on the assumption that the motors have been executing that
     // command until they were updated.
-    Eigen::VectorXs last = mLog[mLog.size() - 1];
+    Eigen::VectorXs last = mLog.getLast();
     for (int i = 0; i < steps - 1; i++)
     {
-      mLog.push_back(last);
+      mLog.append(logEnd + (i + 1) * mMillisPerStep, last);
     }
-    mLog.push_back(control);
+    mLog.append(logEnd + steps * mMillisPerStep, control);
   }
 }
 
@@ -64,12 +66,12 @@ Eigen::VectorXs ControlLog::get(long time)
   int steps = (int)floor((s_t)(time - mLogStart) / mMillisPerStep);
   // If we're out of bounds in the past, extend our initial force
   if (steps <= 0)
-    return mLog[0];
+    return mLog.getValue(0);
   // If we're out of bounds in the future, extend our last force
   if (steps >= mLog.size())
-    return mLog[mLog.size() - 1];
+    return mLog.getLast();
   // Otherwise return the recorded force
-  return mLog[steps];
+  return mLog.getValue(steps);
 }
 
 void ControlLog::discardBefore(long time)
@@ -81,20 +83,14 @@ void ControlLog::discardBefore(long time)
   // known force
   if (discardSteps >= mLog.size())
   {
-    Eigen::VectorXs last = mLog[mLog.size() - 1];
+    Eigen::VectorXs last = mLog.getLast();
     mLog.clear();
-    mLog.push_back(last);
+    mLog.append(time, last);
     mLogStart = time;
     return;
   }
-  // Otherwise we're just snipping part of the log, so copy just the bit we care
-  // about, and throw away the rest
-  std::vector<Eigen::VectorXs> trimmedLog;
-  for (int i = discardSteps; i < mLog.size(); i++)
-  {
-    trimmedLog.push_back(mLog[i]);
-  }
-  mLog = trimmedLog;
+  // Otherwise we're just snipping part of the log, which doesn't copy anything
+  mLog.discardFirst(discardSteps);
   mLogStart += discardSteps * mMillisPerStep;
 }
 
@@ -103,15 +99,27 @@ void ControlLog::setMillisPerStep(int newMillisPerStep)
   int duration = mLog.size() * mMillisPerStep;
   int newSteps = (int)ceil((s_t)duration / newMillisPerStep);
 
-  std::vector<Eigen::VectorXs> newLog;
+  ColumnarLog newLog(mDim, std::max(1, newSteps));
   for (int i = 0; i < newSteps; i++)
   {
-    newLog.push_back(get(mLogStart + i * newMillisPerStep));
+    long time = mLogStart + i * newMillisPerStep;
+    newLog.append(time, get(time));
   }
 
   mMillisPerStep = newMillisPerStep;
   mLog = newLog;
 }
 
+/// This returns a view of the recorded controls for `steps` timesteps starting
+/// with the one that covers `time`, as columns, without copying
+Eigen::Map<const Eigen::MatrixXs> ControlLog::getRawWindow(
+    long time, int steps) const
+{
+  int first = (int)floor((s_t)(time - mLogStart) / mMillisPerStep);
+  int last = std::min(first + steps, mLog.size());
+  first = std::max(0, std::min(first, mLog.size()));
+  return mLog.getValues(first, std::max(0, last - first));
+}
+
 } // namespace realtime
 } // namespace dart
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnarLog.hpp"
 
 namespace dart {
 namespace realtime {
@@ -25,12 +26,20 @@ public:
 
   void setMillisPerStep(int millisPerStep);
 
+  /// This returns a view of the recorded controls for `steps` timesteps
+  /// starting with the one that covers `time`, as columns, without copying.
+  /// This is clipped to the part of the window we've actually recorded, and
+  /// is only valid until the next change to the log.
+  Eigen::Map<const Eigen::MatrixXs> getRawWindow(long time, int steps) const;
+
 protected:
   int mDim;
   int mMillisPerStep;
   long mLogStart;
   long mLogEnd;
-  std::vector<Eigen::VectorXs> mLog;
+  // Entry i is the control for the timestep starting at
+  // mLogStart + i * mMillisPerStep
+  ColumnarLog mLog;
 };
 
 } // namespace realtime
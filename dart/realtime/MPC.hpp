@@ -5,6 +5,7 @@
 
 #include <Eigen/Dense>
 
+#include "dart/realtime/RealTimeControlBuffer.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
 
 namespace dart {
@@ -26,6 +27,10 @@ public:
   /// This can be a negative number, if we've run past our plan.
   virtual long getRemainingPlanBufferMillis() = 0;
 
+  /// This returns timing counters for the getControlForce() calls made so far,
+  /// which is useful to check that the control loop is meeting its deadlines
+  virtual ControlReadStats getControlReadStats() = 0;
+
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
   /// is exactly following our simulation.
@@ -1,5 +1,8 @@
 #include "dart/realtime/MPCLocal.hpp"
 
+#include <mutex>
+
+#include <google/protobuf/arena.h>
 #include <google/protobuf/arena_impl.h>
 #include <grpcpp/ext/proto_server_reflection_plugin.h>
 #include <grpcpp/grpcpp.h>
@@ -9,10 +12,13 @@
 #include "dart/proto/SerializeEigen.hpp"
 #include "dart/realtime/Millis.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/SharedMemoryTransport.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/trajectory/ILQROptimizer.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/LossFn.hpp"
 #include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/SingleShot.hpp"
 #include "dart/trajectory/Solution.hpp"
 
 #include "signal.h"
@@ -37,7 +43,9 @@ MPCLocal::MPCLocal(
         world->getMasses()),
     mEnableLinesearch(true),
     mEnableOptimizationGuards(false),
+    mEnableWarmStart(true),
     mRecordIterations(false),
+    mIterationHistoryLength(100),
     mPlanningHorizonMillis(planningHorizonMillis),
     mMillisPerStep(1000 * world->getTimeStep()),
     mSteps((int)ceil((s_t)planningHorizonMillis / mMillisPerStep)),
@@ -58,7 +66,9 @@ MPCLocal::MPCLocal(const MPCLocal& mpc)
     mObservationLog(mpc.mObservationLog),
     mEnableLinesearch(mpc.mEnableLinesearch),
     mEnableOptimizationGuards(mpc.mEnableOptimizationGuards),
+    mEnableWarmStart(mpc.mEnableWarmStart),
     mRecordIterations(mpc.mRecordIterations),
+    mIterationHistoryLength(mpc.mIterationHistoryLength),
     mPlanningHorizonMillis(mpc.mPlanningHorizonMillis),
     mMillisPerStep(mpc.mMillisPerStep),
     mSteps(mpc.mSteps),
@@ -120,6 +130,13 @@ long MPCLocal::getRemainingPlanBufferMillis()
   return mBuffer.getPlanBufferMillisAfter(timeSinceEpochMillis());
 }
 
+/// This returns timing counters for the getControlForce() calls made so far,
+/// which is useful to check that the control loop is meeting its deadlines
+ControlReadStats MPCLocal::getControlReadStats()
+{
+  return mBuffer.getControlReadStats();
+}
+
 /// This can completely silence log output
 void MPCLocal::setSilent(bool silent)
 {
@@ -143,12 +160,22 @@ void MPCLocal::setEnableOptimizationGuards(bool enabled)
   mEnableOptimizationGuards = enabled;
 }
 
-/// Defaults to false. This records every iteration of IPOPT in the log, so we
-/// can debug it. This should only be used on MPCLocal that's running for a
-/// short time. Otherwise the log will grow without bound.
-void MPCLocal::setRecordIterations(bool enabled)
+/// This enables warm starting each replan from the last one. Defaults to
+/// true. When the plan is shifted forward in time, IPOPT restarts from the
+/// shifted solution and the last solve's (shifted) multipliers, rather than
+/// just the shifted solution, which usually takes fewer iterations.
+void MPCLocal::setEnableWarmStart(bool enabled)
+{
+  mEnableWarmStart = enabled;
+}
+
+/// Defaults to false. This records iterations of IPOPT in the log, so we can
+/// debug it. Only the most recent `historyLength` iterations are kept, so the
+/// log doesn't grow without bound on a long running MPCLocal.
+void MPCLocal::setRecordIterations(bool enabled, int historyLength)
 {
   mRecordIterations = enabled;
+  mIterationHistoryLength = historyLength;
 }
 
 /// This gets the current maximum number of iterations that IPOPT will be
@@ -213,7 +240,9 @@ void MPCLocal::optimizePlan(long startTime)
       ipoptOptimizer->setIterationLimit(mMaxIterations);
       ipoptOptimizer->setDisableLinesearch(!mEnableLinesearch);
       ipoptOptimizer->setRecordFullDebugInfo(false);
-      ipoptOptimizer->setRecordIterations(false);
+      ipoptOptimizer->setRecordIterations(mRecordIterations);
+      ipoptOptimizer->setHistoryConfig(
+          SolutionHistoryConfig().setKeepLast(mIterationHistoryLength));
       if (mSilent)
       {
         ipoptOptimizer->setSilenceOutput(true);
@@ -225,10 +254,19 @@ void MPCLocal::optimizePlan(long startTime)
 
     if (!mProblem || variableChange())
     {
-      std::shared_ptr<MultiShot> multishot = std::make_shared<MultiShot>(
-          worldClone, *mLoss.get(), mSteps, mShotLength, false);
-      multishot->setParallelOperationsEnabled(true);
-      mProblem = multishot;
+      if (std::dynamic_pointer_cast<ILQROptimizer>(mOptimizer))
+      {
+        // iLQR works on the whole horizon as a single shot, without knots
+        mProblem = std::make_shared<SingleShot>(
+            worldClone, *mLoss.get(), mSteps, false);
+      }
+      else
+      {
+        std::shared_ptr<MultiShot> multishot = std::make_shared<MultiShot>(
+            worldClone, *mLoss.get(), mSteps, mShotLength, false);
+        multishot->setParallelOperationsEnabled(true);
+        mProblem = multishot;
+      }
       mVarchange = false;
     }
 
@@ -252,7 +290,8 @@ void MPCLocal::optimizePlan(long startTime)
   }
   else
   {
-    std::shared_ptr<simulation::World> worldClone = mWorld->clone();
+    mWorldFork = mWorld->fork(mWorldFork);
+    std::shared_ptr<simulation::World> worldClone = mWorldFork;
     std::cout<<"Re-optimization stage "<<startTime<<std::endl;
     int diff = startTime - mLastOptimizedTime;
     int steps
@@ -274,13 +313,26 @@ void MPCLocal::optimizePlan(long startTime)
     mBuffer.estimateWorldStateAt(
         worldClone, &mObservationLog, roundedStartTime);
 
-    mProblem->advanceSteps(
+    Eigen::VectorXi shiftMapping = mProblem->advanceSteps(
         worldClone,
         worldClone->getPositions(),
         worldClone->getVelocities(),
         steps);
 
-    mSolution->reoptimize();
+    if (std::dynamic_pointer_cast<ILQROptimizer>(mOptimizer))
+    {
+      // There's no IPOPT state to reuse, but the shifted forces already in
+      // the problem are the warm start
+      mSolution = mOptimizer->optimize(mProblem.get(), mSolution);
+    }
+    else if (mEnableWarmStart)
+    {
+      mSolution->reoptimize(shiftMapping);
+    }
+    else
+    {
+      mSolution->reoptimize();
+    }
 
     // std::cout << "MPCLocal::optimizePlan() mBuffer.setControlForcePlan()" <<
     // std::endl;
@@ -412,6 +464,54 @@ void MPCLocal::serve(int port)
   server->Wait();
 }
 
+/// This serves an MPCRemote on the same host over `transport`, rather than
+/// gRPC. This call blocks until the remote calls setShutdown() on the
+/// transport.
+void MPCLocal::serveSharedMemory(
+    std::shared_ptr<SharedMemoryTransport> transport)
+{
+  registerReplanningListener(
+      [transport](
+          long startTime,
+          const trajectory::TrajectoryRollout* rollout,
+          long duration) {
+        transport->writePlan(
+            startTime, duration, rollout->getControlForcesConst());
+      });
+
+  while (!transport->isShutdown())
+  {
+    if (transport->isRunning() != mRunning)
+    {
+      if (mRunning)
+        stop();
+      else
+        start();
+    }
+    for (SharedMemoryObservation& observation :
+         transport->readObservations())
+    {
+      if (observation.isForce)
+      {
+        mBuffer.manuallyRecordObservedForce(
+            observation.time, observation.force);
+      }
+      else
+      {
+        recordGroundTruthState(
+            observation.time,
+            observation.pos,
+            observation.vel,
+            observation.mass);
+      }
+    }
+    // Polling this often costs a sliver of a core, and keeps observations
+    // from sitting in the ring for longer than a control tick
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+  stop();
+}
+
 ///////////////////////////////////////////////////////////////////////
 /// Implements the gRPC API
 ///////////////////////////////////////////////////////////////////////
@@ -446,16 +546,33 @@ grpc::Status RPCWrapperMPCLocal::ListenForUpdates(
     const proto::MPCListenForUpdatesRequest* /* request */,
     grpc::ServerWriter<proto::MPCListenForUpdatesReply>* writer)
 {
-  proto::MPCListenForUpdatesReply reply;
+  // Each reply is built on its own Arena, backed by a block we keep between
+  // replans (grown to fit the largest reply so far), so streaming rollouts at
+  // the control rate doesn't go through the heap for every message.
+  std::vector<char> arenaBlock(1 << 16);
   mLocal.registerReplanningListener(
       [&](long startTime,
           const trajectory::TrajectoryRollout* rollout,
           long duration) {
-        reply.mutable_rollout()->Clear();
-        rollout->serialize(*reply.mutable_rollout());
-        reply.set_starttime(startTime);
-        reply.set_replandurationmillis(duration);
-        writer->Write(reply);
+        google::protobuf::ArenaOptions options;
+        options.initial_block = arenaBlock.data();
+        options.initial_block_size = arenaBlock.size();
+        std::size_t spaceAllocated = 0;
+        {
+          google::protobuf::Arena arena(options);
+          proto::MPCListenForUpdatesReply* reply
+              = google::protobuf::Arena::CreateMessage<
+                  proto::MPCListenForUpdatesReply>(&arena);
+          rollout->serialize(*reply->mutable_rollout());
+          reply->set_starttime(startTime);
+          reply->set_replandurationmillis(duration);
+          writer->Write(*reply);
+          spaceAllocated = arena.SpaceAllocated();
+        }
+        if (spaceAllocated > arenaBlock.size())
+        {
+          arenaBlock.resize(spaceAllocated);
+        }
       });
 
   while (true)
@@ -491,6 +608,92 @@ grpc::Status RPCWrapperMPCLocal::ObserveForce(
   return grpc::Status::OK;
 }
 
+/// Remotely receive batches of observations, and send back plan updates, over a
+/// single long-lived stream
+grpc::Status RPCWrapperMPCLocal::Stream(
+    grpc::ServerContext* /* context */,
+    grpc::ServerReaderWriter<
+        proto::MPCPlanUpdate,
+        proto::MPCObservationBatch>* stream)
+{
+  proto::MPCObservationBatch batch;
+  if (!stream->Read(&batch))
+  {
+    return grpc::Status::OK;
+  }
+  bool sendRollouts = batch.sendrollouts();
+
+  // Listeners can't be unregistered, so the listener holds onto this and
+  // stops writing once we've returned and `stream` is gone
+  struct StreamState
+  {
+    std::mutex mutex;
+    bool open = true;
+  };
+  std::shared_ptr<StreamState> state = std::make_shared<StreamState>();
+  std::vector<char> arenaBlock(1 << 16);
+  mLocal.registerReplanningListener(
+      [state, stream, sendRollouts, arenaBlock](
+          long startTime,
+          const trajectory::TrajectoryRollout* rollout,
+          long duration) mutable {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->open)
+          return;
+        google::protobuf::ArenaOptions options;
+        options.initial_block = arenaBlock.data();
+        options.initial_block_size = arenaBlock.size();
+        std::size_t spaceAllocated = 0;
+        {
+          google::protobuf::Arena arena(options);
+          proto::MPCPlanUpdate* update
+              = google::protobuf::Arena::CreateMessage<proto::MPCPlanUpdate>(
+                  &arena);
+          update->set_starttime(startTime);
+          update->set_replandurationmillis(duration);
+          proto::serializeMatrix(
+              *update->mutable_controlforces(),
+              rollout->getControlForcesConst());
+          if (sendRollouts)
+          {
+            rollout->serialize(*update->mutable_rollout());
+          }
+          if (!stream->Write(*update))
+          {
+            state->open = false;
+          }
+          spaceAllocated = arena.SpaceAllocated();
+        }
+        if (spaceAllocated > arenaBlock.size())
+        {
+          arenaBlock.resize(spaceAllocated);
+        }
+      });
+
+  do
+  {
+    for (const proto::MPCRecordGroundTruthStateRequest& observation :
+         batch.states())
+    {
+      mLocal.recordGroundTruthState(
+          observation.time(),
+          deserializeVector(observation.pos()),
+          deserializeVector(observation.vel()),
+          deserializeVector(observation.mass()));
+    }
+    for (const proto::MPCObserveForceRequest& observation : batch.forces())
+    {
+      mLocal.mBuffer.manuallyRecordObservedForce(
+          observation.time(), deserializeVector(observation.force()));
+    }
+  } while (stream->Read(&batch));
+
+  // The client hung up
+  std::lock_guard<std::mutex> lock(state->mutex);
+  state->open = false;
+  return grpc::Status::OK;
+}
+
 /// This is the function for the optimization thread to run when we're live
 void MPCLocal::optimizationThreadLoop()
 {
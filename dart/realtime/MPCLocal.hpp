@@ -27,6 +27,8 @@ class TrajectoryRollout;
 
 namespace realtime {
 
+class SharedMemoryTransport;
+
 class MPCLocal final : public MPC
 {
 
@@ -48,7 +50,9 @@ public:
   void setLoss(std::shared_ptr<trajectory::LossFn> loss);
 
   /// This sets the optimizer that MPCLocal will use. This will override the
-  /// default optimizer. This should be called before start().
+  /// default optimizer. This should be called before start(). If this is an
+  /// ILQROptimizer, we plan with a SingleShot instead of a MultiShot, and
+  /// re-run it from the shifted plan each time we replan.
   void setOptimizer(std::shared_ptr<trajectory::Optimizer> optimizer);
 
   /// This returns the current optimizer that MPCLocal is using
@@ -69,6 +73,10 @@ public:
   /// This can be a negative number, if we've run past our plan.
   long getRemainingPlanBufferMillis() override;
 
+  /// This returns timing counters for the getControlForce() calls made so far,
+  /// which is useful to check that the control loop is meeting its deadlines
+  ControlReadStats getControlReadStats() override;
+
   /// This can completely silence log output
   void setSilent(bool silent);
 
@@ -83,10 +91,17 @@ public:
   /// the stability of solutions, but can lead to getting stuck in local minima.
   void setEnableOptimizationGuards(bool enabled);
 
-  /// Defaults to false. This records every iteration of IPOPT in the log, so we
-  /// can debug it. This should only be used on MPCLocal that's running for a
-  /// short time. Otherwise the log will grow without bound.
-  void setRecordIterations(bool enabled);
+  /// This enables warm starting each replan from the last one. Defaults to
+  /// true. When the plan is shifted forward in time, IPOPT restarts from the
+  /// shifted solution and the last solve's (shifted) multipliers, rather than
+  /// just the shifted solution, which usually takes fewer iterations.
+  void setEnableWarmStart(bool enabled);
+
+  /// Defaults to false. This records iterations of IPOPT in the log, so we
+  /// can debug it. Only the most recent `historyLength` iterations are kept,
+  /// so the log doesn't grow without bound on a long running MPCLocal. Pass
+  /// a `historyLength` <= 0 to keep every iteration.
+  void setRecordIterations(bool enabled, int historyLength = 100);
 
   /// This gets the current maximum number of iterations that IPOPT will be
   /// allowed to run during an optimization.
@@ -137,6 +152,12 @@ public:
   /// indefinitely, until the program is killed with Ctrl+C
   void serve(int port);
 
+  /// This serves an MPCRemote on the same host over `transport`, rather than
+  /// gRPC: we start and stop when the remote asks us to, pick up the
+  /// observations it records, and publish every new plan. This call blocks
+  /// until the remote calls setShutdown() on the transport.
+  void serveSharedMemory(std::shared_ptr<SharedMemoryTransport> transport);
+
   bool variableChange();
 
   void setMasschange(s_t mass);
@@ -151,13 +172,17 @@ protected:
 
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
+  // This is reused by every re-optimization, so we only copy state into it
+  std::shared_ptr<simulation::World> mWorldFork;
   std::shared_ptr<trajectory::LossFn> mLoss;
   ObservationLog mObservationLog;
 
   // Meta config
   bool mEnableLinesearch;
   bool mEnableOptimizationGuards;
+  bool mEnableWarmStart;
   bool mRecordIterations;
+  int mIterationHistoryLength;
 
   int mPlanningHorizonMillis;
   int mMillisPerStep;
@@ -221,6 +246,14 @@ public:
       const proto::MPCObserveForceRequest* request,
       proto::MPCObserveForceReply* reply) override;
 
+  /// Remotely receive batches of observations, and send back plan updates,
+  /// over a single long-lived stream
+  grpc::Status Stream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<
+          proto::MPCPlanUpdate,
+          proto::MPCObservationBatch>* stream) override;
+
 protected:
   MPCLocal& mLocal;
 };
@@ -1,5 +1,6 @@
 #include "dart/realtime/MPCRemote.hpp"
 
+#include <google/protobuf/arena.h>
 #include <grpcpp/grpcpp.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -21,20 +22,32 @@ MPCRemote::MPCRemote(
     mChannel(grpc::CreateChannel(
         host + ":" + std::to_string(port), grpc::InsecureChannelCredentials())),
     mStub(proto::MPCService::NewStub(mChannel)),
-    mBuffer(dofs, steps, millisPerStep)
+    mBuffer(dofs, steps, millisPerStep),
+    mUseStreaming(true)
 {
 }
 
 /// This forks the process, starts a server on another process, and connects
-/// to it
-MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
+/// to it over `transport`
+MPCRemote::MPCRemote(
+    MPCLocal& local, int /* ignored */, MPCTransport transport)
   : mRunning(false),
     mChannel(nullptr),
     mStub(nullptr),
     mBuffer(RealTimeControlBuffer(
-        local.mWorld->getNumDofs(), local.mSteps, local.mMillisPerStep))
+        local.mWorld->getNumDofs(), local.mSteps, local.mMillisPerStep)),
+    mUseStreaming(true)
 {
   int port = (rand() % 2000) + 2000;
+  if (transport == MPCTransport::SHARED_MEMORY)
+  {
+    // This has to be mapped before we fork, so both processes share it
+    mSharedMemory = SharedMemoryTransport::create(
+        "",
+        local.mWorld->getNumDofs(),
+        local.mSteps,
+        local.mWorld->getMassDims());
+  }
 
   int original_id = getpid();
   int child_id = fork();
@@ -57,7 +70,14 @@ MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
       }
     });
     // Start a server on this thread
-    local.serve(port);
+    if (mSharedMemory)
+    {
+      local.serveSharedMemory(mSharedMemory);
+    }
+    else
+    {
+      local.serve(port);
+    }
     // When we're done serving, kill this process
     exit(0);
   }
@@ -65,6 +85,8 @@ MPCRemote::MPCRemote(MPCLocal& local, int /* ignored */)
   else if (child_id > 0)
   {
     std::cout << "(MPC fork process id = " << child_id << ")" << std::endl;
+    if (mSharedMemory)
+      return;
 
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
@@ -90,12 +112,39 @@ long MPCRemote::getRemainingPlanBufferMillis()
   return mBuffer.getPlanBufferMillisAfter(timeSinceEpochMillis());
 }
 
+/// This returns timing counters for the getControlForce() calls made so far,
+/// which is useful to check that the control loop is meeting its deadlines
+ControlReadStats MPCRemote::getControlReadStats()
+{
+  return mBuffer.getControlReadStats();
+}
+
 /// This records the current state of the world based on some external sensing
 /// and inference. This resets the error in our model just assuming the world
 /// is exactly following our simulation.
 void MPCRemote::recordGroundTruthState(
     long time, Eigen::VectorXs pos, Eigen::VectorXs vel, Eigen::VectorXs mass)
 {
+  if (mSharedMemory)
+  {
+    mSharedMemory->writeState(time, pos, vel, mass);
+    return;
+  }
+  if (mStream)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mPendingMutex);
+      proto::MPCRecordGroundTruthStateRequest* observation
+          = mPendingBatch.add_states();
+      observation->set_time(time);
+      proto::serializeVector(*observation->mutable_pos(), pos);
+      proto::serializeVector(*observation->mutable_vel(), vel);
+      proto::serializeVector(*observation->mutable_mass(), mass);
+    }
+    mPendingCondition.notify_one();
+    return;
+  }
+
   // Context for the client. It could be used to convey extra information to
   // the server and/or tweak certain RPC behaviors.
   grpc::ClientContext context;
@@ -120,6 +169,35 @@ void MPCRemote::recordGroundTruthState(
   }
 }
 
+/// This records a force that was applied to the world at `time`, which the
+/// server uses to estimate the current state. This is only sent while we're
+/// streaming or using shared memory, and dropped otherwise.
+void MPCRemote::recordObservedForce(long time, Eigen::VectorXs force)
+{
+  if (mSharedMemory)
+  {
+    mSharedMemory->writeForce(time, force);
+    return;
+  }
+  if (!mStream)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    proto::MPCObserveForceRequest* observation = mPendingBatch.add_forces();
+    observation->set_time(time);
+    proto::serializeVector(*observation->mutable_force(), force);
+  }
+  mPendingCondition.notify_one();
+}
+
+/// Defaults to true. If this is true, start() opens a single long-lived stream
+/// to the server, which carries batched observations upstream and packed
+/// control force plans downstream. This should be called before start().
+void MPCRemote::setUseStreaming(bool useStreaming)
+{
+  mUseStreaming = useStreaming;
+}
+
 /// This starts our main thread and begins running optimizations
 void MPCRemote::start()
 {
@@ -127,6 +205,14 @@ void MPCRemote::start()
     return;
   mRunning = true;
 
+  if (mSharedMemory)
+  {
+    mSharedMemory->setRunning(true);
+    mUpdateListenerThread
+        = std::thread(&MPCRemote::sharedMemoryReaderLoop, this);
+    return;
+  }
+
   // Context for the client. It could be used to convey extra information to
   // the server and/or tweak certain RPC behaviors.
   grpc::ClientContext context;
@@ -146,6 +232,12 @@ void MPCRemote::start()
               << status.error_message() << std::endl;
   }
 
+  if (mUseStreaming)
+  {
+    startStreaming();
+    return;
+  }
+
   // Start a thread to listen for updates
   mUpdateListenerThread = std::thread([&]() {
     // Context for the client. It could be used to convey extra information to
@@ -158,18 +250,42 @@ void MPCRemote::start()
     std::unique_ptr<grpc::ClientReader<proto::MPCListenForUpdatesReply>> stream
         = mStub->ListenForUpdates(&context, request);
 
-    proto::MPCListenForUpdatesReply reply;
-    while (mRunning && stream->Read(&reply))
+    // Each reply is parsed onto its own Arena, backed by a block we keep
+    // between replies (grown to fit the largest reply so far), so reading
+    // the stream doesn't go through the heap for every message.
+    std::vector<char> arenaBlock(1 << 16);
+    while (mRunning)
     {
-      trajectory::TrajectoryRolloutReal rollout
-          = trajectory::TrajectoryRollout::deserialize(reply.rollout());
-
-      mBuffer.setControlForcePlan(
-          reply.starttime(), timeSinceEpochMillis(), rollout.getControlForcesConst());
-
-      for (auto listener : mReplannedListeners)
+      google::protobuf::ArenaOptions options;
+      options.initial_block = arenaBlock.data();
+      options.initial_block_size = arenaBlock.size();
+      std::size_t spaceAllocated = 0;
       {
-        listener(reply.starttime(), &rollout, reply.replandurationmillis());
+        google::protobuf::Arena arena(options);
+        proto::MPCListenForUpdatesReply* reply
+            = google::protobuf::Arena::CreateMessage<
+                proto::MPCListenForUpdatesReply>(&arena);
+        if (!stream->Read(reply))
+          break;
+
+        trajectory::TrajectoryRolloutReal rollout
+            = trajectory::TrajectoryRollout::deserialize(reply->rollout());
+
+        mBuffer.setControlForcePlan(
+            reply->starttime(),
+            timeSinceEpochMillis(),
+            rollout.getControlForcesConst());
+
+        for (auto listener : mReplannedListeners)
+        {
+          listener(
+              reply->starttime(), &rollout, reply->replandurationmillis());
+        }
+        spaceAllocated = arena.SpaceAllocated();
+      }
+      if (spaceAllocated > arenaBlock.size())
+      {
+        arenaBlock.resize(spaceAllocated);
       }
     }
   });
@@ -182,6 +298,13 @@ void MPCRemote::stop()
     return;
   mRunning = false;
 
+  if (mSharedMemory)
+  {
+    mSharedMemory->setRunning(false);
+    mUpdateListenerThread.join();
+    return;
+  }
+
   // Context for the client. It could be used to convey extra information to
   // the server and/or tweak certain RPC behaviors.
   grpc::ClientContext context;
@@ -200,6 +323,138 @@ void MPCRemote::stop()
     std::cout << "gRPC got error: " << status.error_code() << ": "
               << status.error_message() << std::endl;
   }
+
+  if (mStream)
+  {
+    // The writer flushes anything still pending and closes our side of the
+    // stream, and then the server hangs up, which ends the reader
+    mPendingCondition.notify_one();
+    mStreamWriterThread.join();
+    mUpdateListenerThread.join();
+    grpc::Status streamStatus = mStream->Finish();
+    if (!streamStatus.ok())
+    {
+      std::cout << "gRPC got error: " << streamStatus.error_code() << ": "
+                << streamStatus.error_message() << std::endl;
+    }
+    mStream.reset();
+    mStreamContext.reset();
+  }
+}
+
+/// This opens the stream, and starts the threads that write observations to it
+/// and read plans from it
+void MPCRemote::startStreaming()
+{
+  mStreamContext = std::make_unique<grpc::ClientContext>();
+  mStream = mStub->Stream(mStreamContext.get());
+
+  // The first batch tells the server whether we need whole rollouts, so send
+  // it right away rather than waiting for an observation
+  {
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    mPendingBatch.Clear();
+  }
+  proto::MPCObservationBatch first;
+  first.set_sendrollouts(!mReplannedListeners.empty());
+  mStream->Write(first);
+
+  mStreamWriterThread = std::thread(&MPCRemote::streamWriterLoop, this);
+  mUpdateListenerThread = std::thread(&MPCRemote::streamReaderLoop, this);
+}
+
+/// This writes batches of observations to the stream, as they come in, until
+/// we stop
+void MPCRemote::streamWriterLoop()
+{
+  proto::MPCObservationBatch batch;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mPendingMutex);
+      mPendingCondition.wait(lock, [this] {
+        return !mRunning || mPendingBatch.states_size() > 0
+               || mPendingBatch.forces_size() > 0;
+      });
+      // Everything that piled up while we were writing the last batch goes
+      // out together
+      batch.Clear();
+      batch.Swap(&mPendingBatch);
+    }
+    if (batch.states_size() > 0 || batch.forces_size() > 0)
+    {
+      if (!mStream->Write(batch))
+        break;
+    }
+    if (!mRunning)
+      break;
+  }
+  mStream->WritesDone();
+}
+
+/// This reads plan updates off the stream until the server hangs up
+void MPCRemote::streamReaderLoop()
+{
+  // Each update is parsed onto its own Arena, backed by a block we keep
+  // between updates, like the ListenForUpdates() reader
+  std::vector<char> arenaBlock(1 << 16);
+  while (true)
+  {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = arenaBlock.data();
+    options.initial_block_size = arenaBlock.size();
+    std::size_t spaceAllocated = 0;
+    {
+      google::protobuf::Arena arena(options);
+      proto::MPCPlanUpdate* update
+          = google::protobuf::Arena::CreateMessage<proto::MPCPlanUpdate>(
+              &arena);
+      if (!mStream->Read(update))
+        break;
+
+      mBuffer.setControlForcePlan(
+          update->starttime(),
+          timeSinceEpochMillis(),
+          proto::deserializeMatrix(update->controlforces()));
+
+      if (update->has_rollout())
+      {
+        trajectory::TrajectoryRolloutReal rollout
+            = trajectory::TrajectoryRollout::deserialize(update->rollout());
+        for (auto listener : mReplannedListeners)
+        {
+          listener(
+              update->starttime(), &rollout, update->replandurationmillis());
+        }
+      }
+      spaceAllocated = arena.SpaceAllocated();
+    }
+    if (spaceAllocated > arenaBlock.size())
+    {
+      arenaBlock.resize(spaceAllocated);
+    }
+  }
+}
+
+/// This polls the shared memory region for new plans until we stop
+void MPCRemote::sharedMemoryReaderLoop()
+{
+  uint64_t lastVersion = 0;
+  long startTime = 0;
+  long replanDurationMillis = 0;
+  Eigen::MatrixXs forces;
+  while (mRunning)
+  {
+    // Checking the version is a single atomic load, so we can afford to spin
+    // on it far faster than any replanning loop runs
+    if (mSharedMemory->getPlanVersion() != lastVersion)
+    {
+      lastVersion
+          = mSharedMemory->readPlan(startTime, replanDurationMillis, forces);
+      mBuffer.setControlForcePlan(startTime, timeSinceEpochMillis(), forces);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
 }
 
 /// This registers a listener to get called when we finish replanning
@@ -1,14 +1,17 @@
 #ifndef DART_MPC_REMOTE
 #define DART_MPC_REMOTE
 
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "dart/proto/MPC.grpc.pb.h"
 #include "dart/realtime/MPC.hpp"
 #include "dart/realtime/MPCLocal.hpp"
 #include "dart/realtime/RealTimeControlBuffer.hpp"
+#include "dart/realtime/SharedMemoryTransport.hpp"
 
 namespace grpc {
 class Channel;
@@ -18,6 +21,16 @@ namespace dart {
 
 namespace realtime {
 
+/// This is how an MPCRemote that forks its own MPCLocal talks to it
+enum class MPCTransport
+{
+  /// gRPC over localhost, exactly like talking to a server on another host
+  GRPC,
+  /// A mmap'd region shared between the two processes (see
+  /// SharedMemoryTransport), which skips serialization and the network stack
+  SHARED_MEMORY
+};
+
 class MPCRemote : public MPC
 {
 public:
@@ -30,8 +43,13 @@ public:
       int millisPerStep);
 
   /// This forks the process, starts a server on another process, and connects
-  /// to it
-  MPCRemote(MPCLocal& local, int ignored = 0);
+  /// to it over `transport`. With MPCTransport::SHARED_MEMORY, the
+  /// replanning listeners are never called, since whole rollouts don't fit
+  /// through the shared region, only control forces.
+  MPCRemote(
+      MPCLocal& local,
+      int ignored = 0,
+      MPCTransport transport = MPCTransport::GRPC);
 
   /// This gets the force to apply to the world at this instant. If we haven't
   /// computed anything for this instant yet, this just returns 0s.
@@ -41,6 +59,10 @@ public:
   /// This can be a negative number, if we've run past our plan.
   long getRemainingPlanBufferMillis() override;
 
+  /// This returns timing counters for the getControlForce() calls made so far,
+  /// which is useful to check that the control loop is meeting its deadlines
+  ControlReadStats getControlReadStats() override;
+
   /// This records the current state of the world based on some external sensing
   /// and inference. This resets the error in our model just assuming the world
   /// is exactly following our simulation.
@@ -50,6 +72,18 @@ public:
       Eigen::VectorXs vel,
       Eigen::VectorXs mass) override;
 
+  /// This records a force that was applied to the world at `time`, which the
+  /// server uses to estimate the current state. This is only sent while
+  /// we're streaming or using shared memory, and dropped otherwise.
+  void recordObservedForce(long time, Eigen::VectorXs force);
+
+  /// Defaults to true. If this is true, start() opens a single long-lived
+  /// stream to the server, which carries batched observations upstream and
+  /// packed control force plans downstream. Otherwise each observation is its
+  /// own RPC, and plans arrive as whole rollouts. This should be called
+  /// before start().
+  void setUseStreaming(bool useStreaming);
+
   /// This starts our main thread and begins running optimizations
   void start() override;
 
@@ -62,12 +96,41 @@ public:
           replanListener) override;
 
 protected:
+  /// This opens the stream, and starts the threads that write observations to
+  /// it and read plans from it
+  void startStreaming();
+
+  /// This writes batches of observations to the stream, as they come in,
+  /// until we stop
+  void streamWriterLoop();
+
+  /// This reads plan updates off the stream until the server hangs up
+  void streamReaderLoop();
+
+  /// This polls the shared memory region for new plans until we stop
+  void sharedMemoryReaderLoop();
+
   bool mRunning;
   std::shared_ptr<grpc::Channel> mChannel;
   std::unique_ptr<proto::MPCService::Stub> mStub;
   RealTimeControlBuffer mBuffer;
   std::thread mUpdateListenerThread;
 
+  bool mUseStreaming;
+  std::unique_ptr<grpc::ClientContext> mStreamContext;
+  std::unique_ptr<grpc::ClientReaderWriter<
+      proto::MPCObservationBatch,
+      proto::MPCPlanUpdate>>
+      mStream;
+  std::thread mStreamWriterThread;
+  // Observations that have come in since the last write to the stream
+  std::mutex mPendingMutex;
+  std::condition_variable mPendingCondition;
+  proto::MPCObservationBatch mPendingBatch;
+
+  // This is only set if we're talking to a forked MPCLocal over shared memory
+  std::shared_ptr<SharedMemoryTransport> mSharedMemory;
+
   // These are listeners that get called when we finish replanning
   std::vector<
       std::function<void(long, const trajectory::TrajectoryRollout*, long)>>
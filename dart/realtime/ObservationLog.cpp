@@ -1,5 +1,6 @@
 #include "dart/realtime/ObservationLog.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "dart/math/MathTypes.hpp"
@@ -17,9 +18,14 @@ ObservationLog::ObservationLog(
     Eigen::VectorXs initialPos,
     Eigen::VectorXs initialVel,
     Eigen::VectorXs initialMass)
-  : mDofs(initialPos.size()), mMassDim(initialMass.size()), mMass(initialMass)
+  : mDofs(initialPos.size()),
+    mMassDim(initialMass.size()),
+    mPositions(initialPos.size()),
+    mVelocities(initialVel.size()),
+    mMass(initialMass)
 {
-  mObservations.emplace_back(startTime, initialPos, initialVel);
+  mPositions.append(startTime, initialPos);
+  mVelocities.append(startTime, initialVel);
 }
 
 void ObservationLog::observe(
@@ -29,20 +35,25 @@ void ObservationLog::observe(
     // TODO(keenon): Support mass observations
     Eigen::VectorXs /* mass */)
 {
-  mObservations.emplace_back(time, pos, vel);
+  mPositions.append(time, pos);
+  mVelocities.append(time, vel);
 }
 
 Observation ObservationLog::getClosestObservationBefore(long time)
 {
-  for (int i = mObservations.size() - 1; i >= 0; i--)
+  int index = mPositions.upperBound(time) - 1;
+  if (index >= 0)
   {
-    if (mObservations[i].time <= time)
-      return mObservations[i];
+    return Observation(
+        mPositions.getTime(index),
+        mPositions.getValue(index),
+        mVelocities.getValue(index));
   }
   std::cout << "WARNING: Asked for an observation before our initialization. "
                "Returning our initialization"
             << std::endl;
-  return mObservations[0];
+  return Observation(
+      mPositions.getTime(0), mPositions.getValue(0), mVelocities.getValue(0));
 }
 
 Eigen::VectorXs ObservationLog::getMass()
@@ -52,24 +63,39 @@ Eigen::VectorXs ObservationLog::getMass()
 
 void ObservationLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
+  // We always keep the latest observation, even if it's before `time`, so
+  // there's something to estimate from
+  int discard = std::min(mPositions.lowerBound(time), mPositions.size() - 1);
+  mPositions.discardFirst(discard);
+  mVelocities.discardFirst(discard);
+}
 
-  std::vector<Observation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+/// This returns a view of every position observed at or after `start`, and
+/// before `end`, as columns, without copying
+Eigen::Map<const Eigen::MatrixXs> ObservationLog::getRawPositionsBetween(
+    long start, long end) const
+{
+  int first = mPositions.lowerBound(start);
+  int last = std::max(first, mPositions.lowerBound(end));
+  return mPositions.getValues(first, last - first);
+}
+
+/// This returns a view of the velocities that go with getRawPositionsBetween()
+Eigen::Map<const Eigen::MatrixXs> ObservationLog::getRawVelocitiesBetween(
+    long start, long end) const
+{
+  int first = mVelocities.lowerBound(start);
+  int last = std::max(first, mVelocities.lowerBound(end));
+  return mVelocities.getValues(first, last - first);
+}
+
+/// This returns a view of the times that go with getRawPositionsBetween()
+Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>>
+ObservationLog::getRawTimesBetween(long start, long end) const
+{
+  int first = mPositions.lowerBound(start);
+  int last = std::max(first, mPositions.lowerBound(end));
+  return mPositions.getTimes(first, last - first);
 }
 
 } // namespace realtime
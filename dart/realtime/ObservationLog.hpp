@@ -6,6 +6,8 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnarLog.hpp"
+
 namespace dart {
 namespace realtime {
 
@@ -39,10 +41,27 @@ public:
 
   void discardBefore(long time);
 
+  /// This returns a view of every position observed at or after `start`, and
+  /// before `end`, as columns, without copying. This is only valid until the
+  /// next change to the log.
+  Eigen::Map<const Eigen::MatrixXs> getRawPositionsBetween(
+      long start, long end) const;
+
+  /// This returns a view of the velocities that go with
+  /// getRawPositionsBetween()
+  Eigen::Map<const Eigen::MatrixXs> getRawVelocitiesBetween(
+      long start, long end) const;
+
+  /// This returns a view of the times that go with getRawPositionsBetween()
+  Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>> getRawTimesBetween(
+      long start, long end) const;
+
 protected:
   int mDofs;
   int mMassDim;
-  std::vector<Observation> mObservations;
+  // These always hold the same times, so indices line up between them
+  ColumnarLog mPositions;
+  ColumnarLog mVelocities;
   Eigen::VectorXs mMass;
 };
 
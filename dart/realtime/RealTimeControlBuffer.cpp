@@ -1,5 +1,8 @@
 #include "dart/realtime/RealTimeControlBuffer.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 #include "dart/simulation/World.hpp"
@@ -8,60 +11,140 @@ namespace dart {
 namespace realtime {
 
 RealTimeControlBuffer::RealTimeControlBuffer(
-    int forceDim, int steps, int millisPerStep)
+    int forceDim, int steps, int millisPerStep, int maxSteps)
   : mForceDim(forceDim),
     mNumSteps(steps),
+    mMaxSteps(std::max(steps, maxSteps)),
     mMillisPerStep(millisPerStep),
     mActiveBuffer(UNINITIALIZED),
-    mBufA(Eigen::MatrixXs::Zero(forceDim, steps)),
-    mBufB(Eigen::MatrixXs::Zero(forceDim, steps)),
+    mSequence(0),
+    mBufA({Eigen::MatrixXs::Zero(forceDim, mMaxSteps),
+           steps,
+           0L,
+           millisPerStep}),
+    mBufB({Eigen::MatrixXs::Zero(forceDim, mMaxSteps),
+           steps,
+           0L,
+           millisPerStep}),
     mControlLog(ControlLog(forceDim, millisPerStep))
 {
+  resetControlReadStats();
+}
+
+/// Copy constructor. This takes `other`'s write lock, so it must not be
+/// called from a thread that's mid-write on `other`.
+RealTimeControlBuffer::RealTimeControlBuffer(
+    const RealTimeControlBuffer& other)
+  : mForceDim(other.mForceDim),
+    mControlLog(other.mControlLog)
+{
+  std::lock_guard<std::mutex> lock(other.mWriteMutex);
+  mNumSteps = other.mNumSteps;
+  mMaxSteps = other.mMaxSteps;
+  mMillisPerStep = other.mMillisPerStep;
+  mActiveBuffer.store(other.mActiveBuffer.load());
+  mSequence.store(0);
+  mBufA = other.mBufA;
+  mBufB = other.mBufB;
+  mNumReads.store(other.mNumReads.load());
+  mNumRetries.store(other.mNumRetries.load());
+  mNumPlanUnderruns.store(other.mNumPlanUnderruns.load());
+  mMaxReadNanos.store(other.mMaxReadNanos.load());
+  mTotalReadNanos.store(other.mTotalReadNanos.load());
+  mMaxJitterMillis.store(other.mMaxJitterMillis.load());
+  mTotalJitterMillis.store(other.mTotalJitterMillis.load());
+  mLastReadTime.store(other.mLastReadTime.load());
 }
 
 /// Gets the force at a given timestep
 Eigen::VectorXs RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
 {
-  if (mActiveBuffer == UNINITIALIZED)
-  {
-    // Unitialized, default to no force
-    return Eigen::VectorXs::Zero(mForceDim);
-  }
-  int elapsed = time - mLastWroteBufferAt;
-  if (elapsed < 0)
-  {
-    // Asking for some time in the past, default to no force
-    return Eigen::VectorXs::Zero(mForceDim);
-  }
+  auto readStart = std::chrono::steady_clock::now();
 
-  int step = (int)floor((s_t)elapsed / mMillisPerStep);
-  if (step < mNumSteps)
+  Eigen::VectorXs force = Eigen::VectorXs::Zero(mForceDim);
+  bool outOfBounds = false;
+  int retries = 0;
+  while (true)
   {
-    if (mActiveBuffer == BUF_A)
+    unsigned long sequence;
+    BufferSwitchEnum active;
+    const ForcePlan& plan = beginRead(sequence, active);
+    outOfBounds = false;
+    force.setZero();
+    // Unitialized, or asking for some time in the past, both default to no
+    // force and don't get logged
+    long elapsed = time - plan.startAt;
+    if (active != UNINITIALIZED && elapsed >= 0)
     {
-      if (!dontLog)
-        mControlLog.record(time, mBufA.col(step));
-      return mBufA.col(step);
+      int step = (int)floor((s_t)elapsed / plan.millisPerStep);
+      if (step < getNumSteps(plan))
+      {
+        force = plan.forces.col(step);
+      }
+      else
+      {
+        // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
+        outOfBounds = true;
+      }
     }
-    else if (mActiveBuffer == BUF_B)
+    if (endRead(sequence))
     {
-      if (!dontLog)
-        mControlLog.record(time, mBufB.col(step));
-      return mBufB.col(step);
+      if (active == UNINITIALIZED || elapsed < 0)
+      {
+        return force;
+      }
+      break;
     }
-    else
-      assert(false && "Should never reach this point");
+    retries++;
   }
-  else
+
+  if (!dontLog)
   {
-    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
-    Eigen::VectorXs oob = Eigen::VectorXs::Zero(mForceDim);
-    if (!dontLog)
-      mControlLog.record(time, oob);
-    return oob;
+    mControlLog.record(time, force);
+    long readNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - readStart)
+                         .count();
+    recordRead(time, readNanos, retries, outOfBounds);
   }
-  // The code should never reach here, but it's here to keep the compiler happy
-  throw std::runtime_error{"Execution should never reach this point"};
+  return force;
+}
+
+/// This returns the timing counters for the control loop's reads since
+/// construction (or since the last resetControlReadStats())
+ControlReadStats RealTimeControlBuffer::getControlReadStats() const
+{
+  ControlReadStats stats;
+  stats.numReads = mNumReads.load(std::memory_order_relaxed);
+  stats.numRetries = mNumRetries.load(std::memory_order_relaxed);
+  stats.numPlanUnderruns = mNumPlanUnderruns.load(std::memory_order_relaxed);
+  stats.maxReadNanos = mMaxReadNanos.load(std::memory_order_relaxed);
+  stats.meanReadNanos
+      = stats.numReads > 0
+            ? (s_t)mTotalReadNanos.load(std::memory_order_relaxed)
+                  / stats.numReads
+            : 0.0;
+  stats.maxJitterMillis = mMaxJitterMillis.load(std::memory_order_relaxed);
+  // Jitter is measured between consecutive reads, so there's one fewer
+  // sample than there are reads
+  stats.meanJitterMillis
+      = stats.numReads > 1
+            ? (s_t)mTotalJitterMillis.load(std::memory_order_relaxed)
+                  / (stats.numReads - 1)
+            : 0.0;
+  return stats;
+}
+
+/// This zeros the timing counters
+void RealTimeControlBuffer::resetControlReadStats()
+{
+  mNumReads.store(0);
+  mNumRetries.store(0);
+  mNumPlanUnderruns.store(0);
+  mMaxReadNanos.store(0);
+  mTotalReadNanos.store(0);
+  mMaxJitterMillis.store(0);
+  mTotalJitterMillis.store(0);
+  mLastReadTime.store(0);
 }
 
 /// This gets planned forces starting at `start`, and continuing for the
@@ -71,42 +154,34 @@ Eigen::VectorXs RealTimeControlBuffer::getPlannedForce(long time, bool dontLog)
 void RealTimeControlBuffer::getPlannedForcesStartingAt(
     long start, Eigen::Ref<Eigen::MatrixXs> forcesOut)
 {
-  if (mActiveBuffer == UNINITIALIZED)
-  {
-    // Unitialized, default to 0
-    forcesOut.setZero();
-    return;
-  }
-  int elapsed = start - mLastWroteBufferAt;
-  if (elapsed < 0)
-  {
-    // Asking for some time in the past, default to 0
-    forcesOut.setZero();
-    return;
-  }
-  int startStep = (int)floor((s_t)elapsed / mMillisPerStep);
-  if (startStep < mNumSteps)
+  while (true)
   {
-    // Copy the appropriate block of our active buffer to the forcesOut block
-    if (mActiveBuffer == BUF_A)
+    unsigned long sequence;
+    BufferSwitchEnum active;
+    const ForcePlan& plan = beginRead(sequence, active);
+    long elapsed = start - plan.startAt;
+    int numSteps = getNumSteps(plan);
+    int startStep = (int)floor((s_t)elapsed / plan.millisPerStep);
+    if (active == UNINITIALIZED || elapsed < 0 || startStep >= numSteps)
     {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufA.block(0, startStep, mForceDim, mNumSteps - startStep);
+      // Unitialized or asking for some time in the past default to 0, as does
+      // walking off the end of the plan
+      forcesOut.setZero();
     }
-    else if (mActiveBuffer == BUF_B)
+    else
     {
-      forcesOut.block(0, 0, mForceDim, mNumSteps - startStep)
-          = mBufB.block(0, startStep, mForceDim, mNumSteps - startStep);
+      // Copy the appropriate block of our active buffer to the forcesOut block
+      int copySteps = std::min<int>(numSteps - startStep, forcesOut.cols());
+      forcesOut.block(0, 0, mForceDim, copySteps)
+          = plan.forces.block(0, startStep, mForceDim, copySteps);
+      // Zero out the remainder of the forcesOut block
+      forcesOut.block(0, copySteps, mForceDim, forcesOut.cols() - copySteps)
+          .setZero();
+    }
+    if (endRead(sequence))
+    {
+      return;
     }
-    else
-      assert(false && "Should never reach this point");
-    // Zero out the remainder of the forcesOut block
-    forcesOut.block(0, mNumSteps - startStep, mForceDim, startStep).setZero();
-  }
-  else
-  {
-    // std::cout << "WARNING: MPC isn't keeping up!" << std::endl;
-    forcesOut.setZero();
   }
 }
 
@@ -115,6 +190,12 @@ void RealTimeControlBuffer::getPlannedForcesStartingAt(
 void RealTimeControlBuffer::setControlForcePlan(
     long startAt, long now, Eigen::MatrixXs forces)
 {
+  std::lock_guard<std::mutex> lock(mWriteMutex);
+
+  // Only writers ever change these, and we hold the write lock
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  const ForcePlan& current = (active == BUF_A) ? mBufA : mBufB;
+
   if (startAt > now)
   {
     long padMillis = startAt - now;
@@ -126,18 +207,20 @@ void RealTimeControlBuffer::setControlForcePlan(
       return;
     }
     // Otherwise, we're going to copy part of the existing plan
-    int currentStep
-        = (int)floor((s_t)(now - mLastWroteBufferAt) / mMillisPerStep);
+    int currentStep = (int)floor((s_t)(now - current.startAt) / mMillisPerStep);
     int remainingSteps = mNumSteps - currentStep;
-    mLastWroteBufferAt = now;
+
+    ForcePlan& next = beginWrite();
+    next.startAt = now;
+    next.millisPerStep = mMillisPerStep;
 
     // If we've overflowed our old buffer, this is bad, but recoverable. We'll
     // just not copy anything from our old plan, since it's all in the past now
     // anyways.
     if (remainingSteps < 0)
     {
-      mBufA = forces;
-      mActiveBuffer = BUF_A;
+      copyIntoPlan(next, forces);
+      publishWrite();
       return;
     }
 
@@ -152,52 +235,28 @@ void RealTimeControlBuffer::setControlForcePlan(
     }
     assert(copySteps + zeroSteps + useSteps == mNumSteps);
 
-    if (mActiveBuffer == UNINITIALIZED)
-    {
-      mBufA.block(0, 0, mForceDim, copySteps).setZero();
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
-    }
-    else if (mActiveBuffer == BUF_B)
+    next.numSteps = mNumSteps;
+    if (active == UNINITIALIZED)
     {
-      mBufA.block(0, 0, mForceDim, copySteps)
-          = mBufB.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufA.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufA.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_A;
+      next.forces.block(0, 0, mForceDim, copySteps).setZero();
     }
-    else if (mActiveBuffer == BUF_A)
+    else
     {
-      mBufB.block(0, 0, mForceDim, copySteps)
-          = mBufA.block(0, mNumSteps - copySteps, mForceDim, copySteps);
-      mBufB.block(0, copySteps, mForceDim, zeroSteps).setZero();
-      mBufB.block(0, copySteps + zeroSteps, mForceDim, useSteps)
-          = forces.block(0, 0, mForceDim, useSteps);
-      mActiveBuffer = BUF_B;
+      next.forces.block(0, 0, mForceDim, copySteps) = current.forces.block(
+          0, current.numSteps - copySteps, mForceDim, copySteps);
     }
+    next.forces.block(0, copySteps, mForceDim, zeroSteps).setZero();
+    next.forces.block(0, copySteps + zeroSteps, mForceDim, useSteps)
+        = forces.block(0, 0, mForceDim, useSteps);
+    publishWrite();
   }
   else
   {
-    mLastWroteBufferAt = startAt;
-    if (mActiveBuffer == UNINITIALIZED || mActiveBuffer == BUF_B)
-    {
-      mBufA = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_A;
-    }
-    else
-    {
-      mBufB = forces;
-      // Crucial for lock-free behavior: copy the buffer BEFORE setting the
-      // active buffer. Not a huge deal if we're a bit off here in the
-      // optimizer, but not ideal.
-      mActiveBuffer = BUF_B;
-    }
+    ForcePlan& next = beginWrite();
+    next.startAt = startAt;
+    next.millisPerStep = mMillisPerStep;
+    copyIntoPlan(next, forces);
+    publishWrite();
   }
 }
 
@@ -251,14 +310,22 @@ void RealTimeControlBuffer::estimateWorldStateAt(
 /// optimization slower and still keep up with real life.
 void RealTimeControlBuffer::setMillisPerStep(int newMillisPerStep)
 {
+  std::lock_guard<std::mutex> lock(mWriteMutex);
   mControlLog.setMillisPerStep(newMillisPerStep);
-  if (mActiveBuffer == BUF_A)
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  if (active != UNINITIALIZED)
   {
-    rescaleBuffer(mBufA, mMillisPerStep, newMillisPerStep);
-  }
-  else if (mActiveBuffer == BUF_B)
-  {
-    rescaleBuffer(mBufB, mMillisPerStep, newMillisPerStep);
+    const ForcePlan& current = (active == BUF_A) ? mBufA : mBufB;
+    ForcePlan& next = beginWrite();
+    next.startAt = current.startAt;
+    next.millisPerStep = newMillisPerStep;
+    copyIntoPlan(
+        next,
+        rescaleBuffer(
+            current.forces.leftCols(current.numSteps),
+            mMillisPerStep,
+            newMillisPerStep));
+    publishWrite();
   }
   mMillisPerStep = newMillisPerStep;
 }
@@ -268,33 +335,55 @@ void RealTimeControlBuffer::setMillisPerStep(int newMillisPerStep)
 /// probably has a nonlinear effect on runtime.
 void RealTimeControlBuffer::setNumSteps(int newNumSteps)
 {
-  Eigen::MatrixXs newBuf = Eigen::MatrixXs::Zero(mForceDim, newNumSteps);
-
-  int minLen = newNumSteps;
-  if (mNumSteps < minLen)
-    minLen = mNumSteps;
-
-  if (mActiveBuffer == BUF_A)
+  std::lock_guard<std::mutex> lock(mWriteMutex);
+  if (newNumSteps > mMaxSteps)
   {
-    newBuf.block(0, 0, mForceDim, minLen)
-        = mBufA.block(0, 0, mForceDim, minLen);
+    std::cout << "RealTimeControlBuffer::setNumSteps() can't go past the "
+              << mMaxSteps << " steps allocated at construction, so we're "
+              << "using " << mMaxSteps << " instead of " << newNumSteps
+              << std::endl;
+    newNumSteps = mMaxSteps;
   }
-  else if (mActiveBuffer == BUF_B)
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  if (active != UNINITIALIZED)
   {
-    newBuf.block(0, 0, mForceDim, minLen)
-        = mBufB.block(0, 0, mForceDim, minLen);
+    const ForcePlan& current = (active == BUF_A) ? mBufA : mBufB;
+
+    int minLen = std::min(newNumSteps, current.numSteps);
+
+    ForcePlan& next = beginWrite();
+    next.startAt = current.startAt;
+    next.millisPerStep = current.millisPerStep;
+    next.forces.block(0, 0, mForceDim, minLen)
+        = current.forces.block(0, 0, mForceDim, minLen);
+    next.forces.block(0, minLen, mForceDim, newNumSteps - minLen).setZero();
+    next.numSteps = newNumSteps;
+    publishWrite();
   }
+  mNumSteps = newNumSteps;
+}
 
-  mBufA = newBuf;
-  mBufB = newBuf;
+/// This returns the most steps a plan can hold
+int RealTimeControlBuffer::getMaxSteps() const
+{
+  return mMaxSteps;
 }
 
 /// This returns the number of millis we have left in the plan after `time`.
 /// This can be a negative number.
 long RealTimeControlBuffer::getPlanBufferMillisAfter(long time)
 {
-  long planEnd = mLastWroteBufferAt + (mNumSteps * mMillisPerStep);
-  return planEnd - time;
+  while (true)
+  {
+    unsigned long sequence;
+    BufferSwitchEnum active;
+    const ForcePlan& plan = beginRead(sequence, active);
+    long planEnd = plan.startAt + (getNumSteps(plan) * plan.millisPerStep);
+    if (endRead(sequence))
+    {
+      return planEnd - time;
+    }
+  }
 }
 
 /// This is useful when we're replicating a log across a network boundary,
@@ -307,12 +396,12 @@ void RealTimeControlBuffer::manuallyRecordObservedForce(
 
 /// This is a helper to rescale the timestep size of a buffer while leaving
 /// the data otherwise unchanged.
-void RealTimeControlBuffer::rescaleBuffer(
-    Eigen::MatrixXs& buf, int oldMillisPerStep, int newMillisPerStep)
+Eigen::MatrixXs RealTimeControlBuffer::rescaleBuffer(
+    const Eigen::MatrixXs& buf, int oldMillisPerStep, int newMillisPerStep)
 {
   Eigen::MatrixXs newBuf = Eigen::MatrixXs::Zero(buf.rows(), buf.cols());
 
-  for (int i = mNumSteps - 1; i >= 0; i--)
+  for (int i = buf.cols() - 1; i >= 0; i--)
   {
     if (newMillisPerStep > oldMillisPerStep)
     {
@@ -332,7 +421,108 @@ void RealTimeControlBuffer::rescaleBuffer(
     }
   }
 
-  buf = newBuf;
+  return newBuf;
+}
+
+/// This returns the number of steps in `plan`, clamped to the space we have
+int RealTimeControlBuffer::getNumSteps(const ForcePlan& plan) const
+{
+  return std::max(0, std::min(plan.numSteps, mMaxSteps));
+}
+
+/// This must be called with mWriteMutex held. It copies as much of `forces`
+/// as fits into `plan`, in place.
+void RealTimeControlBuffer::copyIntoPlan(
+    ForcePlan& plan, const Eigen::MatrixXs& forces)
+{
+  assert(forces.rows() == mForceDim);
+  int steps = std::min<int>(forces.cols(), mMaxSteps);
+  plan.forces.block(0, 0, mForceDim, steps)
+      = forces.block(0, 0, mForceDim, steps);
+  plan.numSteps = steps;
+}
+
+/// This returns the active side (or the B side, if we haven't published
+/// anything yet, since the first write goes to A), and the sequence number a
+/// reader needs to validate its read afterwards.
+const RealTimeControlBuffer::ForcePlan& RealTimeControlBuffer::beginRead(
+    unsigned long& sequence, BufferSwitchEnum& active) const
+{
+  sequence = mSequence.load(std::memory_order_acquire);
+  active = mActiveBuffer.load(std::memory_order_acquire);
+  return (active == BUF_A) ? mBufA : mBufB;
+}
+
+/// This returns true if nothing a reader could have read since beginRead()
+/// returned `sequence` has been overwritten.
+bool RealTimeControlBuffer::endRead(unsigned long sequence) const
+{
+  std::atomic_thread_fence(std::memory_order_acquire);
+  unsigned long now = mSequence.load(std::memory_order_relaxed);
+  // Writers only touch the inactive side. If no write was underway when we
+  // started, the side we read can't be touched until the writer publishes
+  // the other side and then starts another write (3 increments later). If a
+  // write was underway, it's 2 increments until the writer finishes and
+  // starts writing the side that was active when we started.
+  return now - sequence < ((sequence & 1) ? 2UL : 3UL);
+}
+
+/// This must be called with mWriteMutex held. It returns the inactive side
+/// for writing, and tells readers a write is underway.
+RealTimeControlBuffer::ForcePlan& RealTimeControlBuffer::beginWrite()
+{
+  mSequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return (mActiveBuffer.load(std::memory_order_relaxed) == BUF_A) ? mBufB
+                                                                 : mBufA;
+}
+
+/// This must be called with mWriteMutex held. It makes the side returned
+/// by beginWrite() active.
+void RealTimeControlBuffer::publishWrite()
+{
+  BufferSwitchEnum active = mActiveBuffer.load(std::memory_order_relaxed);
+  mActiveBuffer.store(
+      (active == BUF_A) ? BUF_B : BUF_A, std::memory_order_release);
+  mSequence.fetch_add(1, std::memory_order_release);
+}
+
+/// This records timing counters for a read by the control loop
+void RealTimeControlBuffer::recordRead(
+    long time, long readNanos, int retries, bool underrun)
+{
+  // Only the control thread writes these, so plain load/store is enough
+  long numReads = mNumReads.load(std::memory_order_relaxed);
+  if (numReads > 0)
+  {
+    long sinceLastRead = time - mLastReadTime.load(std::memory_order_relaxed);
+    long jitter = std::abs(sinceLastRead - mMillisPerStep);
+    mTotalJitterMillis.store(
+        mTotalJitterMillis.load(std::memory_order_relaxed) + jitter,
+        std::memory_order_relaxed);
+    if (jitter > mMaxJitterMillis.load(std::memory_order_relaxed))
+    {
+      mMaxJitterMillis.store(jitter, std::memory_order_relaxed);
+    }
+  }
+  mLastReadTime.store(time, std::memory_order_relaxed);
+  mNumReads.store(numReads + 1, std::memory_order_relaxed);
+  mNumRetries.store(
+      mNumRetries.load(std::memory_order_relaxed) + retries,
+      std::memory_order_relaxed);
+  if (underrun)
+  {
+    mNumPlanUnderruns.store(
+        mNumPlanUnderruns.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+  mTotalReadNanos.store(
+      mTotalReadNanos.load(std::memory_order_relaxed) + readNanos,
+      std::memory_order_relaxed);
+  if (readNanos > mMaxReadNanos.load(std::memory_order_relaxed))
+  {
+    mMaxReadNanos.store(readNanos, std::memory_order_relaxed);
+  }
 }
 
 } // namespace realtime
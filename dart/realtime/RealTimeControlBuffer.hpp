@@ -1,7 +1,9 @@
 #ifndef DART_REALTIME_BUFFER
 #define DART_REALTIME_BUFFER
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -24,16 +26,62 @@ enum BufferSwitchEnum
   BUF_B
 };
 
+/// Timing counters for the reads made by the control loop (the calls to
+/// getPlannedForce() that aren't `dontLog`), so we can check that we're
+/// keeping up with our deadlines.
+struct ControlReadStats
+{
+  /// The number of reads
+  long numReads;
+  /// The number of times a read had to be retried, because the planner
+  /// published twice while we were reading
+  long numRetries;
+  /// The number of reads that ran off the end of the plan, and got 0 force
+  /// because MPC wasn't keeping up
+  long numPlanUnderruns;
+  /// The wall-clock time spent inside getPlannedForce()
+  long maxReadNanos;
+  s_t meanReadNanos;
+  /// The difference between the time elapsed between consecutive reads and
+  /// one timestep of the plan
+  long maxJitterMillis;
+  s_t meanJitterMillis;
+};
+
+/// The control thread reads from this buffer while an optimization thread
+/// writes new plans into it. Reads never block: the buffer is double
+/// buffered, writers only ever touch the inactive side, and a sequence
+/// counter lets readers detect the (rare) case where the writer published
+/// twice during a single read, in which case the read is retried. Writers
+/// are serialized against each other with a mutex that readers never touch.
+///
+/// Both sides are allocated once, at construction, with room for `maxSteps`
+/// steps, and every write copies into them in place. That way a reader that
+/// races a writer can read stale or torn values (which it then throws away),
+/// but never freed memory. Plans longer than `maxSteps` are cut short.
 class RealTimeControlBuffer
 {
 public:
-  RealTimeControlBuffer(int forceDim, int steps, int millisPerStep);
+  /// If `maxSteps` is less than `steps`, we make room for `steps` steps
+  RealTimeControlBuffer(
+      int forceDim, int steps, int millisPerStep, int maxSteps = -1);
+
+  /// Copy constructor. This takes `other`'s write lock, so it must not be
+  /// called from a thread that's mid-write on `other`.
+  RealTimeControlBuffer(const RealTimeControlBuffer& other);
 
   /// Gets the force at a given timestep. This HAS SIDE EFFECTS! We actually
   /// keep track of what forces were read, and assume that they're "immediately"
   /// applied to the real world after they're read.
   Eigen::VectorXs getPlannedForce(long time, bool dontLog = false);
 
+  /// This returns the timing counters for the control loop's reads since
+  /// construction (or since the last resetControlReadStats())
+  ControlReadStats getControlReadStats() const;
+
+  /// This zeros the timing counters
+  void resetControlReadStats();
+
   /// This gets planned forces starting at `start`, and continuing for the
   /// length of our buffer size `mSteps`. This is useful for initializing MPC
   /// runs. It supports walking off the end of known future, and assumes 0
@@ -59,9 +107,13 @@ public:
 
   /// This changes the number of steps. Fewer steps mean we can compute a buffer
   /// faster, but it also means we have less time to compute the buffer. This
-  /// probably has a nonlinear effect on runtime.
+  /// probably has a nonlinear effect on runtime. This can't go past
+  /// getMaxSteps().
   void setNumSteps(int numSteps);
 
+  /// This returns the most steps a plan can hold
+  int getMaxSteps() const;
+
   /// This returns the number of millis we have left in the plan after `time`.
   /// This can be a negative number.
   long getPlanBufferMillisAfter(long time);
@@ -71,31 +123,89 @@ public:
   void manuallyRecordObservedForce(long time, Eigen::VectorXs observation);
 
 protected:
+  /// One side of the double buffer. Each side carries its own timing, so a
+  /// reader only ever needs to look at the active side.
+  struct ForcePlan
+  {
+    /// This is always forceDim x maxSteps, and is never reallocated. Only the
+    /// first `numSteps` columns are part of the plan.
+    Eigen::MatrixXs forces;
+    int numSteps;
+    /// This is the time when this plan was written
+    long startAt;
+    int millisPerStep;
+  };
+
   int mForceDim;
   int mNumSteps;
+  int mMaxSteps;
   int mMillisPerStep;
 
   /// This is a helper to rescale the timestep size of a buffer while leaving
   /// the data otherwise unchanged.
-  void rescaleBuffer(
-      Eigen::MatrixXs& buf, int oldMillisPerStep, int newMillisPerStep);
+  Eigen::MatrixXs rescaleBuffer(
+      const Eigen::MatrixXs& buf, int oldMillisPerStep, int newMillisPerStep);
+
+  /// This returns the number of steps in `plan`. Readers can see a torn value
+  /// while racing a writer, so this is clamped to the space we actually have.
+  int getNumSteps(const ForcePlan& plan) const;
+
+  /// This must be called with mWriteMutex held. It copies as much of
+  /// `forces` as fits into `plan`, in place.
+  void copyIntoPlan(ForcePlan& plan, const Eigen::MatrixXs& forces);
+
+  /// This returns the active side (or the B side, if we haven't published
+  /// anything yet), and the sequence number a reader needs to validate its
+  /// read afterwards.
+  const ForcePlan& beginRead(
+      unsigned long& sequence, BufferSwitchEnum& active) const;
+
+  /// This returns true if nothing a reader could have read since beginRead()
+  /// returned `sequence` has been overwritten.
+  bool endRead(unsigned long sequence) const;
+
+  /// This must be called with mWriteMutex held. It returns the inactive side
+  /// for writing, and tells readers a write is underway.
+  ForcePlan& beginWrite();
+
+  /// This must be called with mWriteMutex held. It makes the side returned
+  /// by beginWrite() active.
+  void publishWrite();
+
+  /// This records timing counters for a read by the control loop
+  void recordRead(long time, long readNanos, int retries, bool underrun);
 
   /// This controls which of our buffers is currently active
-  BufferSwitchEnum mActiveBuffer;
+  std::atomic<BufferSwitchEnum> mActiveBuffer;
+
+  /// This is odd while a write is underway, and increments once when the
+  /// write starts and once when it's published
+  std::atomic<unsigned long> mSequence;
+
+  /// This serializes writers. The control thread never takes it.
+  mutable std::mutex mWriteMutex;
 
   /// This is the A buffer of forces
-  Eigen::MatrixXs mBufA;
+  ForcePlan mBufA;
 
   /// This is the B buffer of forces
-  Eigen::MatrixXs mBufB;
-
-  /// This is the time when the last buffer was written to
-  long mLastWroteBufferAt;
+  ForcePlan mBufB;
 
   /// This keeps a log of all the control outputs we send, so that we can get
   /// the current state on request, even if we last had an observation a while
   /// ago.
   ControlLog mControlLog;
+
+  /// Timing counters for the control loop's reads. These are only written by
+  /// the control thread, but can be read from anywhere.
+  std::atomic<long> mNumReads;
+  std::atomic<long> mNumRetries;
+  std::atomic<long> mNumPlanUnderruns;
+  std::atomic<long> mMaxReadNanos;
+  std::atomic<long> mTotalReadNanos;
+  std::atomic<long> mMaxJitterMillis;
+  std::atomic<long> mTotalJitterMillis;
+  std::atomic<long> mLastReadTime;
 };
 
 } // namespace realtime
@@ -1,7 +1,9 @@
 #include "dart/realtime/SSID.hpp"
 
+#include <algorithm>
 #include <thread>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/realtime/Millis.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
@@ -28,7 +30,8 @@ SSID::SSID(
     mPlanningHistoryMillis(planningHistoryMillis),
     mSensorDims(sensorDims),
     mControlLog(VectorLog(world->getNumDofs())),
-    mPlanningSteps(steps)
+    mPlanningSteps(steps),
+    mNumThreads(0)
 {
   for (int i = 0; i < mSensorDims.size(); i++)
   {
@@ -152,65 +155,74 @@ void SSID::stop()
 /// This runs inference to find mutable values, starting at `startTime`
 void SSID::runInference(long startTime)
 {
-  // registerLock();
   long startComputeWallTime = timeSinceEpochMillis();
 
-  int millisPerStep = static_cast<int>(ceil(mWorld->getTimeStep() * 1000.0));
-  int steps = static_cast<int>(
-      ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
+  int steps = prepareProblem(startTime);
 
-  if (!mProblem)
+  std::shared_ptr<simulation::World> world = mWorld;
+  std::shared_ptr<trajectory::Problem> problem = mProblem;
+  if (mMassHypotheses.size() == 1)
   {
-    std::shared_ptr<SingleShot> singleshot
-        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
-    // multishot->setParallelOperationsEnabled(true);
-    mProblem = singleshot;
+    mWorld->setMasses(mMassHypotheses[0]);
   }
-  // std::cout<<"Problem Created"<<std::endl;
-  //  Every turn, we need to pin all the forces
-  registerLock();
-  // Eigen::MatrixXs forceHistory = mControlLog.getValues(
-  //     startTime - mPlanningHistoryMillis, steps, millisPerStep);
-  Eigen::MatrixXs forceHistory
-      = mControlLog.getRecentValuesBefore(startTime, steps + 1);
-  for (int i = 0; i < steps; i++)
+  else if (mMassHypotheses.size() > 1)
   {
-    mProblem->pinForce(i, forceHistory.col(i));
+    // Each hypothesis gets its own world and problem clone, which inherit the
+    // pinned forces and sensor metadata we just set, so the logs are only
+    // read once no matter how many guesses we try
+    int numHypotheses = mMassHypotheses.size();
+    std::vector<std::shared_ptr<simulation::World>> worlds;
+    std::vector<std::shared_ptr<trajectory::Problem>> problems;
+    for (int i = 0; i < numHypotheses; i++)
+    {
+      worlds.push_back(forkWorld(i));
+      worlds[i]->setMasses(mMassHypotheses[i]);
+      problems.push_back(mProblem->clone(worlds[i]));
+    }
+
+    std::vector<s_t> losses(numHypotheses);
+    int numWorkers = getNumWorkers(numHypotheses);
+    std::vector<common::TaskFuture<void>> futures;
+    for (int worker = 0; worker < numWorkers; worker++)
+    {
+      futures.push_back(common::async([&, worker]() {
+        for (int i = worker; i < numHypotheses; i += numWorkers)
+        {
+          mOptimizer->optimize(problems[i].get());
+          losses[i] = problems[i]->getLoss(worlds[i]);
+        }
+      }));
+    }
+    for (auto& future : futures)
+    {
+      future.get();
+    }
+
+    int best = 0;
+    for (int i = 1; i < numHypotheses; i++)
+    {
+      if (losses[i] < losses[best])
+      {
+        best = i;
+      }
+    }
+    world = worlds[best];
+    problem = problems[best];
+    mWorld->setMasses(world->getMasses());
   }
-  // std::cout<<"ForcePinned"<<std::endl;
-  //  We also need to set all the sensor history into metadata
 
-  // Eigen::MatrixXs poseHistory = mSensorLogs[0].getValues(
-  //     startTime - mPlanningHistoryMillis, steps, millisPerStep);
-  // Eigen::MatrixXs velHistory = mSensorLogs[1].getValues(
-  //   startTime - mPlanningHistoryMillis, steps, millisPerStep
-  //  );
-  Eigen::MatrixXs poseHistory
-      = mSensorLogs[0].getRecentValuesBefore(startTime, steps + 1);
-  Eigen::MatrixXs velHistory
-      = mSensorLogs[1].getRecentValuesBefore(startTime, steps + 1);
-  registerUnlock();
-  // std::cout<<"In SSID Force Hist: \n"<<forceHistory<<"\nPos Hist:
-  // \n"<<poseHistory<<"\nVel Hist: \n"<<velHistory<<std::endl;
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities", velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  // TODO: Set initial velocity
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
-  // Then actually run the optimization
-  // std::cout<<"Ready to Optimize"<<std::endl;
-  mSolution = mOptimizer->optimize(mProblem.get());
-  // std::cout<<"Optimization End"<<std::endl;
+  if (problem == mProblem)
+  {
+    mSolution = mOptimizer->optimize(mProblem.get());
+  }
 
   long computeDurationWallTime = timeSinceEpochMillis() - startComputeWallTime;
 
-  const trajectory::TrajectoryRollout* cache
-      = mProblem->getRolloutCache(mWorld);
+  const trajectory::TrajectoryRollout* cache = problem->getRolloutCache(world);
 
   Eigen::VectorXs pos = cache->getPosesConst().col(steps - 1);
   Eigen::VectorXs vel = cache->getVelsConst().col(steps - 1);
-  Eigen::VectorXs mass = mWorld->getMasses();
+  Eigen::VectorXs mass = world->getMasses();
 
   for (auto listener : mInferListeners)
   {
@@ -221,62 +233,19 @@ void SSID::runInference(long startTime)
 Eigen::VectorXs SSID::runPlotting(
     long startTime, s_t upper, s_t lower, int samples)
 {
-  int millisPerStep = static_cast<int>(ceil(mWorld->getTimeStep() * 1000.0));
-  int steps = static_cast<int>(
-      ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
+  prepareProblem(startTime);
 
-  if (!mProblem)
+  if (upper == lower)
   {
-    std::shared_ptr<SingleShot> singleshot
-        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
-    mProblem = singleshot;
+    samples = 1;
   }
-
-  registerLock();
-  Eigen::MatrixXs forceHistory
-      = mControlLog.getRecentValuesBefore(startTime, steps + 1);
-  for (int i = 0; i < steps; i++)
-  {
-    mProblem->pinForce(i, forceHistory.col(i));
-  }
-
-  Eigen::MatrixXs poseHistory
-      = mSensorLogs[0].getRecentValuesBefore(startTime, steps + 1);
-  Eigen::MatrixXs velHistory
-      = mSensorLogs[1].getRecentValuesBefore(startTime, steps + 1);
-
-  registerUnlock();
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities", velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
-
-  Eigen::VectorXs losses;
-  if (upper != lower)
+  s_t epsilon = (upper - lower) / samples;
+  std::vector<Eigen::VectorXs> probes;
+  for (int i = 0; i < samples; i++)
   {
-    losses = Eigen::VectorXs::Zero(samples);
-    s_t epsilon = (upper - lower) / samples;
-    s_t probe = lower;
-    for (int i = 0; i < samples; i++)
-    {
-      mWorld->setMasses(Eigen::Vector1s(probe));
-      mProblem->resetDirty();
-      s_t loss = mProblem->getLoss(mWorld);
-      losses(i) = loss;
-      probe += epsilon;
-    }
-  }
-  else
-  {
-    losses = Eigen::VectorXs::Zero(1);
-    mWorld->setMasses(Eigen::Vector1s(lower));
-    mProblem->resetDirty();
-    s_t loss = mProblem->getLoss(mWorld);
-    losses(0) = loss;
+    probes.push_back(Eigen::Vector1s(lower + i * epsilon));
   }
-
-  return losses;
+  return evaluateMassGrid(probes);
 }
 
 Eigen::MatrixXs SSID::runPlotting2D(
@@ -287,40 +256,8 @@ Eigen::MatrixXs SSID::runPlotting2D(
     int y_samples,
     size_t rest_dim)
 {
-  int millisPerStep = static_cast<int>(ceil(mWorld->getTimeStep() * 1000.0));
-  int steps = static_cast<int>(
-      ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
-
-  if (!mProblem)
-  {
-    std::shared_ptr<SingleShot> singleshot
-        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
-    mProblem = singleshot;
-  }
-
-  registerLock();
-  Eigen::MatrixXs forceHistory
-      = mControlLog.getRecentValuesBefore(startTime, steps + 1);
-  for (int i = 0; i < steps; i++)
-  {
-    mProblem->pinForce(i, forceHistory.col(i));
-  }
-
-  Eigen::MatrixXs poseHistory
-      = mSensorLogs[0].getRecentValuesBefore(startTime, steps + 1);
-  Eigen::MatrixXs velHistory
-      = mSensorLogs[1].getRecentValuesBefore(startTime, steps + 1);
-
-  registerUnlock();
-  mProblem->setMetadata("forces", forceHistory);
-  mProblem->setMetadata("sensors", poseHistory);
-  mProblem->setMetadata("velocities", velHistory);
-  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
-  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
+  prepareProblem(startTime);
 
-  Eigen::MatrixXs losses = Eigen::MatrixXs::Zero(x_samples, y_samples);
-
-  Eigen::Vector3s probe = lower;
   assert(rest_dim < 3);
   size_t probe_dim_1;
   size_t probe_dim_2;
@@ -345,17 +282,25 @@ Eigen::MatrixXs SSID::runPlotting2D(
   s_t x_epsilon = (upper(probe_dim_1) - lower(probe_dim_1)) / x_samples;
   s_t y_epsilon = (upper(probe_dim_2) - lower(probe_dim_2)) / y_samples;
 
+  // Probes are laid out row-major, so sample (x_i, y_i) is at
+  // x_i * y_samples + y_i
+  std::vector<Eigen::VectorXs> probes;
   for (int x_i = 0; x_i < x_samples; x_i++)
   {
-    probe(probe_dim_2) = lower(probe_dim_2);
     for (int y_i = 0; y_i < y_samples; y_i++)
     {
-      mWorld->setMasses(probe);
-      mProblem->resetDirty();
-      losses(x_i, y_i) = mProblem->getLoss(mWorld);
-      probe(probe_dim_2) += y_epsilon;
+      Eigen::Vector3s probe = lower;
+      probe(probe_dim_1) += x_i * x_epsilon;
+      probe(probe_dim_2) += y_i * y_epsilon;
+      probes.push_back(probe);
     }
-    probe(probe_dim_1) += x_epsilon;
+  }
+  Eigen::VectorXs flatLosses = evaluateMassGrid(probes);
+
+  Eigen::MatrixXs losses = Eigen::MatrixXs::Zero(x_samples, y_samples);
+  for (int x_i = 0; x_i < x_samples; x_i++)
+  {
+    losses.row(x_i) = flatLosses.segment(x_i * y_samples, y_samples);
   }
   return losses;
 }
@@ -412,6 +357,115 @@ void SSID::optimizationThreadLoop()
   }
 }
 
+/// This sets how many worker threads multi-hypothesis inference and the
+/// plotting sweeps use
+void SSID::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+}
+
+/// This sets the initial mass guesses that runInference() starts from.
+void SSID::setMassHypotheses(std::vector<Eigen::VectorXs> hypotheses)
+{
+  mMassHypotheses = hypotheses;
+}
+
+/// This reads the recent history out of the logs and pins it into mProblem
+int SSID::prepareProblem(long startTime)
+{
+  int millisPerStep = static_cast<int>(ceil(mWorld->getTimeStep() * 1000.0));
+  int steps = static_cast<int>(
+      ceil(static_cast<s_t>(mPlanningHistoryMillis) / millisPerStep));
+
+  if (!mProblem)
+  {
+    std::shared_ptr<SingleShot> singleshot
+        = std::make_shared<SingleShot>(mWorld, *mLoss.get(), steps, false);
+    mProblem = singleshot;
+  }
+
+  //  Every turn, we need to pin all the forces
+  registerLock();
+  Eigen::MatrixXs forceHistory
+      = mControlLog.getRecentValuesBefore(startTime, steps + 1);
+  //  We also need to set all the sensor history into metadata
+  Eigen::MatrixXs poseHistory
+      = mSensorLogs[0].getRecentValuesBefore(startTime, steps + 1);
+  Eigen::MatrixXs velHistory
+      = mSensorLogs[1].getRecentValuesBefore(startTime, steps + 1);
+  registerUnlock();
+
+  for (int i = 0; i < steps; i++)
+  {
+    mProblem->pinForce(i, forceHistory.col(i));
+  }
+  mProblem->setMetadata("forces", forceHistory);
+  mProblem->setMetadata("sensors", poseHistory);
+  mProblem->setMetadata("velocities", velHistory);
+  mProblem->setStartPos(mInitialPosEstimator(poseHistory, startTime));
+  mProblem->setStartVel(mInitialVelEstimator(velHistory, startTime));
+  return steps;
+}
+
+/// This evaluates the loss of mProblem at each of the `probes` masses
+Eigen::VectorXs SSID::evaluateMassGrid(
+    const std::vector<Eigen::VectorXs>& probes)
+{
+  int numProbes = probes.size();
+  Eigen::VectorXs losses = Eigen::VectorXs::Zero(numProbes);
+  int numWorkers = getNumWorkers(numProbes);
+
+  std::vector<std::shared_ptr<simulation::World>> worlds;
+  std::vector<std::shared_ptr<trajectory::Problem>> problems;
+  for (int worker = 0; worker < numWorkers; worker++)
+  {
+    worlds.push_back(forkWorld(worker));
+    problems.push_back(mProblem->clone(worlds[worker]));
+  }
+
+  std::vector<common::TaskFuture<void>> futures;
+  for (int worker = 0; worker < numWorkers; worker++)
+  {
+    futures.push_back(common::async([&, worker]() {
+      simulation::World* world = worlds[worker].get();
+      trajectory::Problem* problem = problems[worker].get();
+      for (int i = worker; i < numProbes; i += numWorkers)
+      {
+        world->setMasses(probes[i]);
+        problem->resetDirty();
+        losses(i) = problem->getLoss(worlds[worker]);
+      }
+    }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+  return losses;
+}
+
+/// This returns how many workers to spread `numTasks` across
+int SSID::getNumWorkers(int numTasks)
+{
+  int numThreads = mNumThreads;
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  return std::max(1, std::min(numThreads, numTasks));
+}
+
+/// This returns a copy of mWorld for worker `slot`
+std::shared_ptr<simulation::World> SSID::forkWorld(std::size_t slot)
+{
+  if (mWorldForks.size() <= slot)
+  {
+    mWorldForks.resize(slot + 1);
+  }
+  mWorldForks[slot] = mWorld->fork(mWorldForks[slot]);
+  return mWorldForks[slot];
+}
+
 void SSID::attachMutex(std::mutex& mutex_lock)
 {
   mRegisterMutex = &mutex_lock;
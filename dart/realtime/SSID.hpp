@@ -4,6 +4,7 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 #include <Eigen/Dense>
 #include <iostream>
@@ -86,9 +87,23 @@ public:
   /// This stops our main thread, waits for it to finish, and then returns
   void stop();
 
-  /// This runs inference to find mutable values, starting at `startTime`
+  /// This runs inference to find mutable values, starting at `startTime`. If
+  /// more than one mass hypothesis has been set, each one is optimized from
+  /// its own clone of the world in parallel and the lowest loss result is
+  /// kept (and written back into our world).
   void runInference(long startTime);
 
+  /// This sets how many worker threads multi-hypothesis inference and the
+  /// plotting sweeps use. 0 (the default) means one per hardware thread.
+  void setNumThreads(int numThreads);
+
+  /// This sets the initial mass guesses that runInference() starts from. With
+  /// a single hypothesis the world is simply reset to it before optimizing.
+  /// Empty (the default) starts from the world's current masses. The
+  /// optimizer must be safe to call from several threads at once to use more
+  /// than one hypothesis.
+  void setMassHypotheses(std::vector<Eigen::VectorXs> hypotheses);
+
   Eigen::VectorXs runPlotting(long startTime, s_t upper, s_t lower, int samples);
 
   Eigen::MatrixXs runPlotting2D(long startTime, Eigen::Vector3s upper, Eigen::Vector3s lower, int x_samples, int y_samples, size_t rest_dim);
@@ -110,6 +125,24 @@ protected:
   /// This is the function for the optimization thread to run when we're live
   void optimizationThreadLoop();
 
+  /// This reads the last `steps` controls and sensor readings before
+  /// `startTime` out of the logs (under the register lock) and pins them into
+  /// mProblem, creating the default problem if we don't have one yet. Returns
+  /// the number of steps in the problem.
+  int prepareProblem(long startTime);
+
+  /// This evaluates the loss of mProblem with the world masses set to each of
+  /// `probes`, spreading the probes across a pool of workers that each own a
+  /// clone of the world and problem.
+  Eigen::VectorXs evaluateMassGrid(const std::vector<Eigen::VectorXs>& probes);
+
+  /// This returns how many workers to spread `numTasks` across
+  int getNumWorkers(int numTasks);
+
+  /// This returns a copy of mWorld for worker `slot`. The copies are kept
+  /// around between calls, so after the first one this only copies state.
+  std::shared_ptr<simulation::World> forkWorld(std::size_t slot);
+
   bool mRunning;
   std::shared_ptr<simulation::World> mWorld;
   std::shared_ptr<trajectory::LossFn> mLoss;
@@ -126,6 +159,9 @@ protected:
   std::mutex* mRegisterMutex;
   bool mLockRegistered = false;
   Eigen::VectorXs mParameters;
+  int mNumThreads;
+  std::vector<Eigen::VectorXs> mMassHypotheses;
+  std::vector<std::shared_ptr<simulation::World>> mWorldForks;
 
   // These are listeners that get called when we finish replanning
   std::vector<std::function<void(
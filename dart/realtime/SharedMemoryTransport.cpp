@@ -0,0 +1,434 @@
+#include "dart/realtime/SharedMemoryTransport.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dart {
+namespace realtime {
+
+namespace {
+// "NIMBLSHM", so open() can tell it's not mapping some other region
+constexpr uint64_t SHARED_MEMORY_MAGIC = 0x4e494d424c53484dULL;
+constexpr std::size_t CACHE_LINE = 64;
+
+std::size_t roundUpToCacheLine(std::size_t size)
+{
+  return (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+} // namespace
+
+/// This sits at the start of the region, followed by the plan data and then
+/// the observation slots. Everything in here must be safe to share between
+/// processes, so no pointers, and only lock-free atomics.
+struct SharedMemoryTransport::Header
+{
+  uint64_t magic;
+  int32_t dofs;
+  int32_t steps;
+  int32_t massDim;
+  int32_t capacity;
+  std::atomic<int32_t> running;
+  std::atomic<int32_t> shutdown;
+
+  // The plan seqlock. This is odd while a plan is being written.
+  alignas(CACHE_LINE) std::atomic<uint64_t> planSequence;
+  int64_t planStartTime;
+  int64_t planReplanDurationMillis;
+  int32_t planCols;
+
+  // The number of observations ever written, which is kept on its own cache
+  // line so the writer doesn't bounce the plan readers' lines
+  alignas(CACHE_LINE) std::atomic<uint64_t> writeIndex;
+};
+
+/// This sits at the start of each observation slot, followed by the data.
+/// The observation with index `i` lives in slot `i % capacity`, and that
+/// slot's sequence is 2i+1 while it's being written and 2i+2 once it's done.
+struct SharedMemoryTransport::SlotHeader
+{
+  std::atomic<uint64_t> sequence;
+  int32_t isForce;
+  int64_t time;
+};
+
+/// This creates a fresh region, big enough for plans of `dofs` x `steps`
+/// control forces and a ring of `capacity` observations. If `name` is empty,
+/// the region is anonymous, and can only be shared with processes we fork
+/// after this call. Otherwise it's a named POSIX shared memory object, which
+/// other processes can open().
+std::shared_ptr<SharedMemoryTransport> SharedMemoryTransport::create(
+    const std::string& name, int dofs, int steps, int massDim, int capacity)
+{
+  static_assert(
+      ATOMIC_LLONG_LOCK_FREE == 2,
+      "Shared memory needs lock-free 64 bit atomics");
+  std::size_t size = getRegionSize(dofs, steps, massDim, capacity);
+
+  void* region = MAP_FAILED;
+  if (name.empty())
+  {
+    region = mmap(
+        nullptr,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0);
+  }
+  else
+  {
+    int fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd == -1)
+    {
+      std::cout << "SharedMemoryTransport couldn't create \"" << name
+                << "\": " << std::strerror(errno) << std::endl;
+      return nullptr;
+    }
+    if (ftruncate(fd, size) == 0)
+    {
+      region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+  }
+  if (region == MAP_FAILED)
+  {
+    std::cout << "SharedMemoryTransport couldn't map " << size
+              << " bytes: " << std::strerror(errno) << std::endl;
+    if (!name.empty())
+      shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // Fresh mappings are zeroed, which is the state we want for everything
+  // except the header fields set here
+  Header* header = new (region) Header();
+  header->dofs = dofs;
+  header->steps = steps;
+  header->massDim = massDim;
+  header->capacity = capacity;
+  header->running.store(0);
+  header->shutdown.store(0);
+  header->planSequence.store(0);
+  header->planCols = 0;
+  header->writeIndex.store(0);
+  // Publish the magic last, so open() never sees a half-made header
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = SHARED_MEMORY_MAGIC;
+
+  return std::shared_ptr<SharedMemoryTransport>(
+      new SharedMemoryTransport(region, size, name, true));
+}
+
+/// This maps an existing named region, made by create() in another process.
+/// This returns nullptr if there's no region by that name.
+std::shared_ptr<SharedMemoryTransport> SharedMemoryTransport::open(
+    const std::string& name)
+{
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd == -1)
+    return nullptr;
+  struct stat info;
+  void* region = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size >= (off_t)sizeof(Header))
+  {
+    region = mmap(
+        nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (region == MAP_FAILED)
+    return nullptr;
+
+  Header* header = static_cast<Header*>(region);
+  std::size_t size = info.st_size;
+  if (header->magic != SHARED_MEMORY_MAGIC
+      || getRegionSize(
+             header->dofs, header->steps, header->massDim, header->capacity)
+             > size)
+  {
+    std::cout << "SharedMemoryTransport: \"" << name
+              << "\" isn't a transport region" << std::endl;
+    munmap(region, size);
+    return nullptr;
+  }
+  return std::shared_ptr<SharedMemoryTransport>(
+      new SharedMemoryTransport(region, size, name, false));
+}
+
+SharedMemoryTransport::SharedMemoryTransport(
+    void* region, std::size_t size, const std::string& name, bool owner)
+  : mRegion(region),
+    mSize(size),
+    mName(name),
+    mOwner(owner),
+    mHeader(static_cast<Header*>(region)),
+    mReadIndex(0),
+    mNumDropped(0)
+{
+  char* base = static_cast<char*>(region);
+  mPlanData = reinterpret_cast<s_t*>(
+      base + roundUpToCacheLine(sizeof(Header)));
+  mSlots = base + roundUpToCacheLine(sizeof(Header))
+           + roundUpToCacheLine(
+               sizeof(s_t) * mHeader->dofs * mHeader->steps);
+  mSlotStride = roundUpToCacheLine(
+      sizeof(SlotHeader)
+      + sizeof(s_t) * (2 * mHeader->dofs + mHeader->massDim));
+  // Start reading from wherever the writer has got to
+  mReadIndex = mHeader->writeIndex.load(std::memory_order_acquire);
+}
+
+SharedMemoryTransport::~SharedMemoryTransport()
+{
+  munmap(mRegion, mSize);
+  // Other processes keep their mappings, this just removes the name
+  if (mOwner && !mName.empty())
+    shm_unlink(mName.c_str());
+}
+
+int SharedMemoryTransport::getNumDofs() const
+{
+  return mHeader->dofs;
+}
+
+int SharedMemoryTransport::getNumSteps() const
+{
+  return mHeader->steps;
+}
+
+int SharedMemoryTransport::getMassDim() const
+{
+  return mHeader->massDim;
+}
+
+/// This publishes a new plan. This should only be called by one process.
+void SharedMemoryTransport::writePlan(
+    long startTime,
+    long replanDurationMillis,
+    const Eigen::Ref<const Eigen::MatrixXs>& forces)
+{
+  int dofs = mHeader->dofs;
+  int cols = std::min((int)forces.cols(), (int)mHeader->steps);
+  uint64_t sequence
+      = mHeader->planSequence.load(std::memory_order_relaxed);
+  mHeader->planSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  mHeader->planStartTime = startTime;
+  mHeader->planReplanDurationMillis = replanDurationMillis;
+  mHeader->planCols = cols;
+  Eigen::Map<Eigen::MatrixXs>(mPlanData, dofs, cols)
+      = forces.topLeftCorner(dofs, cols);
+
+  mHeader->planSequence.store(sequence + 2, std::memory_order_release);
+}
+
+/// This returns the version of the latest plan. This goes up every time a
+/// plan is published, and is 0 if no plan has been published yet.
+uint64_t SharedMemoryTransport::getPlanVersion() const
+{
+  return mHeader->planSequence.load(std::memory_order_acquire) / 2;
+}
+
+/// This copies out the latest plan. This returns the version of the plan we
+/// read, which is 0 (and leaves the outputs untouched) if there's no plan yet.
+uint64_t SharedMemoryTransport::readPlan(
+    long& startTime, long& replanDurationMillis, Eigen::MatrixXs& forces)
+{
+  int dofs = mHeader->dofs;
+  while (true)
+  {
+    uint64_t before = mHeader->planSequence.load(std::memory_order_acquire);
+    if (before == 0)
+      return 0;
+    if (before % 2 == 1)
+    {
+      // The writer is mid-plan, which only takes a copy's worth of time
+      continue;
+    }
+
+    long readStartTime = mHeader->planStartTime;
+    long readReplanDuration = mHeader->planReplanDurationMillis;
+    int cols = std::max(0, std::min(mHeader->planCols, mHeader->steps));
+    forces = Eigen::Map<const Eigen::MatrixXs>(mPlanData, dofs, cols);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mHeader->planSequence.load(std::memory_order_relaxed) == before)
+    {
+      startTime = readStartTime;
+      replanDurationMillis = readReplanDuration;
+      return before / 2;
+    }
+  }
+}
+
+/// This appends a ground truth state to the observation ring. This should
+/// only be called by one process.
+void SharedMemoryTransport::writeState(
+    long time,
+    const Eigen::VectorXs& pos,
+    const Eigen::VectorXs& vel,
+    const Eigen::VectorXs& mass)
+{
+  writeObservation(false, time, {&pos, &vel, &mass});
+}
+
+/// This appends an observed force to the observation ring. This should only
+/// be called by one process.
+void SharedMemoryTransport::writeForce(long time, const Eigen::VectorXs& force)
+{
+  writeObservation(true, time, {&force});
+}
+
+/// This returns every observation appended since the last call, oldest first,
+/// minus any that were overwritten before we got to them.
+std::vector<SharedMemoryObservation> SharedMemoryTransport::readObservations()
+{
+  std::vector<SharedMemoryObservation> observations;
+  const uint64_t capacity = mHeader->capacity;
+  const int dofs = mHeader->dofs;
+  const int massDim = mHeader->massDim;
+  uint64_t writeIndex = mHeader->writeIndex.load(std::memory_order_acquire);
+  // Anything more than a ring behind has already been overwritten
+  if (writeIndex - mReadIndex > capacity)
+  {
+    mNumDropped += writeIndex - capacity - mReadIndex;
+    mReadIndex = writeIndex - capacity;
+  }
+
+  for (uint64_t i = mReadIndex; i < writeIndex; i++)
+  {
+    SlotHeader* slot = getSlot(i);
+    const s_t* data = getSlotData(i);
+    uint64_t before = slot->sequence.load(std::memory_order_acquire);
+    if (before != 2 * i + 2)
+    {
+      // The writer has lapped us, and is already reusing this slot
+      mNumDropped++;
+      continue;
+    }
+
+    SharedMemoryObservation observation;
+    observation.isForce = slot->isForce != 0;
+    observation.time = slot->time;
+    if (observation.isForce)
+    {
+      observation.force = Eigen::Map<const Eigen::VectorXs>(data, dofs);
+    }
+    else
+    {
+      observation.pos = Eigen::Map<const Eigen::VectorXs>(data, dofs);
+      observation.vel = Eigen::Map<const Eigen::VectorXs>(data + dofs, dofs);
+      observation.mass
+          = Eigen::Map<const Eigen::VectorXs>(data + 2 * dofs, massDim);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot->sequence.load(std::memory_order_relaxed) != before)
+    {
+      mNumDropped++;
+      continue;
+    }
+    observations.push_back(std::move(observation));
+  }
+  mReadIndex = writeIndex;
+  return observations;
+}
+
+/// This returns how many observations readObservations() has had to skip
+/// because they were overwritten before they were read
+uint64_t SharedMemoryTransport::getNumDroppedObservations() const
+{
+  return mNumDropped;
+}
+
+/// The MPCRemote side sets this to ask the MPCLocal side to start or stop
+/// optimizing
+void SharedMemoryTransport::setRunning(bool running)
+{
+  mHeader->running.store(running ? 1 : 0, std::memory_order_release);
+}
+
+bool SharedMemoryTransport::isRunning() const
+{
+  return mHeader->running.load(std::memory_order_acquire) != 0;
+}
+
+/// The MPCRemote side sets this to ask the MPCLocal side to stop serving
+void SharedMemoryTransport::setShutdown()
+{
+  mHeader->shutdown.store(1, std::memory_order_release);
+}
+
+bool SharedMemoryTransport::isShutdown() const
+{
+  return mHeader->shutdown.load(std::memory_order_acquire) != 0;
+}
+
+/// This returns the header of the observation slot for the observation with
+/// this index
+SharedMemoryTransport::SlotHeader* SharedMemoryTransport::getSlot(
+    uint64_t index)
+{
+  return reinterpret_cast<SlotHeader*>(
+      mSlots + (index % mHeader->capacity) * mSlotStride);
+}
+
+/// This returns the data of the observation slot for the observation with
+/// this index
+s_t* SharedMemoryTransport::getSlotData(uint64_t index)
+{
+  return reinterpret_cast<s_t*>(
+      reinterpret_cast<char*>(getSlot(index)) + sizeof(SlotHeader));
+}
+
+/// This appends an observation to the ring, with `data` copied into its slot
+void SharedMemoryTransport::writeObservation(
+    bool isForce, long time, const std::vector<const Eigen::VectorXs*>& data)
+{
+  const int dofs = mHeader->dofs;
+  const int massDim = mHeader->massDim;
+  uint64_t index = mHeader->writeIndex.load(std::memory_order_relaxed);
+  SlotHeader* slot = getSlot(index);
+  s_t* slotData = getSlotData(index);
+
+  slot->sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->isForce = isForce ? 1 : 0;
+  slot->time = time;
+  // Each vector is copied into its fixed spot, truncated or zero padded to
+  // the size we were created with
+  const int sizes[3] = {dofs, dofs, massDim};
+  int offset = 0;
+  for (int i = 0; i < (int)data.size() && i < 3; i++)
+  {
+    int size = std::min(sizes[i], (int)data[i]->size());
+    std::memcpy(slotData + offset, data[i]->data(), sizeof(s_t) * size);
+    std::memset(slotData + offset + size, 0, sizeof(s_t) * (sizes[i] - size));
+    offset += sizes[i];
+  }
+
+  slot->sequence.store(2 * index + 2, std::memory_order_release);
+  mHeader->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+std::size_t SharedMemoryTransport::getRegionSize(
+    int dofs, int steps, int massDim, int capacity)
+{
+  return roundUpToCacheLine(sizeof(Header))
+         + roundUpToCacheLine(sizeof(s_t) * dofs * steps)
+         + roundUpToCacheLine(
+               sizeof(SlotHeader) + sizeof(s_t) * (2 * dofs + massDim))
+               * capacity;
+}
+
+} // namespace realtime
+} // namespace dart
@@ -0,0 +1,160 @@
+#ifndef DART_REALTIME_SHARED_MEMORY_TRANSPORT
+#define DART_REALTIME_SHARED_MEMORY_TRANSPORT
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace realtime {
+
+/// A single observation read off a SharedMemoryTransport. This is either a
+/// ground truth state (`pos`, `vel` and `mass` are set) or an observed force
+/// (`force` is set).
+struct SharedMemoryObservation
+{
+  bool isForce;
+  long time;
+  Eigen::VectorXs pos;
+  Eigen::VectorXs vel;
+  Eigen::VectorXs mass;
+  Eigen::VectorXs force;
+};
+
+/// This connects an MPCRemote and an MPCLocal running on the same host through
+/// a mmap'd region, rather than gRPC over localhost, so neither side has to
+/// serialize anything or go through the kernel to talk to the other.
+///
+/// The region holds the latest plan, which the MPCLocal side overwrites every
+/// time it replans, and a ring buffer of observations, which the MPCRemote
+/// side appends to. Both are versioned with seqlocks, so neither side ever
+/// blocks: readers copy out what they need and retry (or, for observations
+/// that have been lapped, skip) if a writer touched it in the meantime. There
+/// must only be one writer of each: one process publishing plans, and one
+/// recording observations.
+///
+/// If the ring buffer fills up faster than MPCLocal drains it, the oldest
+/// observations are overwritten, since newer observations are the ones that
+/// matter for planning.
+class SharedMemoryTransport
+{
+public:
+  /// This creates a fresh region, big enough for plans of `dofs` x `steps`
+  /// control forces and a ring of `capacity` observations. If `name` is empty,
+  /// the region is anonymous, and can only be shared with processes we fork
+  /// after this call. Otherwise it's a named POSIX shared memory object, which
+  /// other processes can open().
+  static std::shared_ptr<SharedMemoryTransport> create(
+      const std::string& name,
+      int dofs,
+      int steps,
+      int massDim,
+      int capacity = 256);
+
+  /// This maps an existing named region, made by create() in another process.
+  /// This returns nullptr if there's no region by that name.
+  static std::shared_ptr<SharedMemoryTransport> open(const std::string& name);
+
+  ~SharedMemoryTransport();
+
+  int getNumDofs() const;
+
+  int getNumSteps() const;
+
+  int getMassDim() const;
+
+  /// This publishes a new plan. This should only be called by one process.
+  void writePlan(
+      long startTime,
+      long replanDurationMillis,
+      const Eigen::Ref<const Eigen::MatrixXs>& forces);
+
+  /// This returns the version of the latest plan. This goes up every time a
+  /// plan is published, and is 0 if no plan has been published yet.
+  uint64_t getPlanVersion() const;
+
+  /// This copies out the latest plan. This returns the version of the plan we
+  /// read, which is 0 (and leaves the outputs untouched) if there's no plan
+  /// yet.
+  uint64_t readPlan(
+      long& startTime, long& replanDurationMillis, Eigen::MatrixXs& forces);
+
+  /// This appends a ground truth state to the observation ring. This should
+  /// only be called by one process.
+  void writeState(
+      long time,
+      const Eigen::VectorXs& pos,
+      const Eigen::VectorXs& vel,
+      const Eigen::VectorXs& mass);
+
+  /// This appends an observed force to the observation ring. This should only
+  /// be called by one process.
+  void writeForce(long time, const Eigen::VectorXs& force);
+
+  /// This returns every observation appended since the last call, oldest
+  /// first, minus any that were overwritten before we got to them.
+  std::vector<SharedMemoryObservation> readObservations();
+
+  /// This returns how many observations readObservations() has had to skip
+  /// because they were overwritten before they were read
+  uint64_t getNumDroppedObservations() const;
+
+  /// The MPCRemote side sets this to ask the MPCLocal side to start or stop
+  /// optimizing
+  void setRunning(bool running);
+
+  bool isRunning() const;
+
+  /// The MPCRemote side sets this to ask the MPCLocal side to stop serving
+  void setShutdown();
+
+  bool isShutdown() const;
+
+protected:
+  struct Header;
+  struct SlotHeader;
+
+  SharedMemoryTransport(
+      void* region, std::size_t size, const std::string& name, bool owner);
+
+  /// This returns the header of the observation slot for the observation
+  /// with this index
+  SlotHeader* getSlot(uint64_t index);
+
+  /// This returns the data of the observation slot for the observation with
+  /// this index
+  s_t* getSlotData(uint64_t index);
+
+  /// This appends an observation to the ring, with `data` copied into its
+  /// slot
+  void writeObservation(
+      bool isForce,
+      long time,
+      const std::vector<const Eigen::VectorXs*>& data);
+
+  static std::size_t getRegionSize(
+      int dofs, int steps, int massDim, int capacity);
+
+  void* mRegion;
+  std::size_t mSize;
+  std::string mName;
+  bool mOwner;
+  Header* mHeader;
+  s_t* mPlanData;
+  char* mSlots;
+  std::size_t mSlotStride;
+  // These are only touched by the single reader of observations
+  uint64_t mReadIndex;
+  uint64_t mNumDropped;
+};
+
+} // namespace realtime
+} // namespace dart
+
+#endif
@@ -1,13 +1,64 @@
 #include "dart/realtime/Ticker.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
 #include "dart/realtime/Millis.hpp"
 
 namespace dart {
 namespace realtime {
 
+namespace {
+/// This returns the monotonic clock in nanoseconds
+long monotonicNanos()
+{
+#if defined(__linux__)
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long)now.tv_sec * 1000000000L + now.tv_nsec;
+#else
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/// This sleeps until the monotonic clock reads `deadlineNanos`
+void sleepUntilNanos(long deadlineNanos)
+{
+#if defined(__linux__)
+  struct timespec deadline;
+  deadline.tv_sec = deadlineNanos / 1000000000L;
+  deadline.tv_nsec = deadlineNanos % 1000000000L;
+  // This returns early if we're interrupted by a signal
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr)
+         != 0)
+  {
+  }
+#else
+  std::this_thread::sleep_for(
+      std::chrono::nanoseconds(deadlineNanos - monotonicNanos()));
+#endif
+}
+} // namespace
+
 Ticker::Ticker(s_t secondsPerTick)
-  : mRunning(false), mSecondsPerTick(secondsPerTick)
+  : mRunning(false),
+    mSecondsPerTick(secondsPerTick),
+    mHighPrecision(false),
+    mSpinMicros(50),
+    mCpuAffinity(-1),
+    mRealtimePriority(0)
 {
+  resetTickLatenessStats();
 }
 
 Ticker::~Ticker()
@@ -31,6 +82,7 @@ void Ticker::start()
   if (mRunning)
     return;
   mRunning = true;
+  resetTickLatenessStats();
   mMainThread = new std::thread(&Ticker::mainLoop, this);
 }
 
@@ -56,10 +108,86 @@ bool Ticker::isRunning()
   return mRunning;
 }
 
+/// Defaults to false. If this is true, ticks are scheduled against absolute
+/// deadlines on the monotonic clock with nanosecond resolution. This should be
+/// called before start().
+void Ticker::setHighPrecision(bool highPrecision)
+{
+  mHighPrecision = highPrecision;
+}
+
+/// Defaults to 50. In high precision mode, we sleep until this many
+/// microseconds before each deadline, and then busy-wait the rest of the way.
+void Ticker::setSpinMicros(int spinMicros)
+{
+  mSpinMicros = spinMicros;
+}
+
+/// Defaults to -1, which lets the tick thread run on any CPU. Otherwise, the
+/// tick thread is pinned to this CPU when it starts.
+void Ticker::setCpuAffinity(int cpu)
+{
+  mCpuAffinity = cpu;
+}
+
+/// Defaults to 0, which runs the tick thread with the normal scheduler.
+/// Otherwise, the tick thread is scheduled SCHED_FIFO at this priority.
+void Ticker::setRealtimePriority(int priority)
+{
+  mRealtimePriority = priority;
+}
+
+/// This returns the lateness counters since the last start() (or the last
+/// resetTickLatenessStats())
+TickLatenessStats Ticker::getTickLatenessStats() const
+{
+  TickLatenessStats stats;
+  stats.numTicks = mNumTicks.load(std::memory_order_relaxed);
+  stats.numMissedTicks = mNumMissedTicks.load(std::memory_order_relaxed);
+  stats.maxLatenessNanos = mMaxLatenessNanos.load(std::memory_order_relaxed);
+  stats.meanLatenessNanos
+      = stats.numTicks > 0
+            ? (s_t)mTotalLatenessNanos.load(std::memory_order_relaxed)
+                  / stats.numTicks
+            : 0.0;
+  stats.latenessHistogram.resize(NUM_LATENESS_BUCKETS);
+  for (int i = 0; i < NUM_LATENESS_BUCKETS; i++)
+  {
+    stats.latenessHistogram[i]
+        = mLatenessHistogram[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+/// This zeros the lateness counters
+void Ticker::resetTickLatenessStats()
+{
+  mNumTicks.store(0);
+  mNumMissedTicks.store(0);
+  mMaxLatenessNanos.store(0);
+  mTotalLatenessNanos.store(0);
+  for (int i = 0; i < NUM_LATENESS_BUCKETS; i++)
+  {
+    mLatenessHistogram[i].store(0);
+  }
+}
+
 void Ticker::mainLoop()
 {
+  configureThread();
+  if (mHighPrecision)
+  {
+    highPrecisionLoop();
+    return;
+  }
+
+  auto scheduled = std::chrono::steady_clock::now();
   while (mRunning)
   {
+    recordLateness(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - scheduled)
+                       .count());
+
     int interval = (int)round(mSecondsPerTick * 1000);
     auto x = std::chrono::steady_clock::now()
              + std::chrono::milliseconds(interval);
@@ -69,7 +197,107 @@ void Ticker::mainLoop()
       listener(millis);
 
     std::this_thread::sleep_until(x);
+    scheduled = x;
+  }
+}
+
+/// This is the loop for high precision mode
+void Ticker::highPrecisionLoop()
+{
+  const long period = std::max(1L, (long)llround(mSecondsPerTick * 1e9));
+  const long spin = std::max(0L, (long)mSpinMicros * 1000);
+  long deadline = monotonicNanos();
+  while (mRunning)
+  {
+    // Sleep most of the way, then spin the rest, since the scheduler can take
+    // tens of microseconds to wake us up
+    if (deadline - spin > monotonicNanos())
+    {
+      sleepUntilNanos(deadline - spin);
+    }
+    long now = monotonicNanos();
+    while (now < deadline)
+    {
+      now = monotonicNanos();
+    }
+    recordLateness(now - deadline);
+
+    long millis = timeSinceEpochMillis();
+    for (auto listener : mListeners)
+      listener(millis);
+
+    // Deadlines are absolute, so time spent in the listeners doesn't push
+    // back later ticks. If we've already missed whole ticks, we skip them.
+    deadline += period;
+    now = monotonicNanos();
+    if (now > deadline)
+    {
+      long missed = (now - deadline) / period + 1;
+      deadline += missed * period;
+      mNumMissedTicks.fetch_add(missed, std::memory_order_relaxed);
+    }
+  }
+}
+
+/// This applies our CPU affinity and realtime priority to the calling thread
+void Ticker::configureThread()
+{
+#if defined(__linux__)
+  if (mCpuAffinity >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(mCpuAffinity, &cpus);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0)
+    {
+      std::cout << "Ticker couldn't pin its thread to CPU " << mCpuAffinity
+                << " (error " << result << ")" << std::endl;
+    }
+  }
+  if (mRealtimePriority > 0)
+  {
+    struct sched_param param;
+    param.sched_priority = mRealtimePriority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0)
+    {
+      std::cout << "Ticker couldn't switch its thread to SCHED_FIFO priority "
+                << mRealtimePriority << " (error " << result
+                << "), which usually needs root or CAP_SYS_NICE" << std::endl;
+    }
+  }
+#else
+  if (mCpuAffinity >= 0 || mRealtimePriority > 0)
+  {
+    std::cout << "Ticker only supports CPU pinning and realtime priority on "
+                 "Linux, ignoring them"
+              << std::endl;
+  }
+#endif
+}
+
+/// This folds how late a tick fired into the lateness counters
+void Ticker::recordLateness(long latenessNanos)
+{
+  if (latenessNanos < 0)
+    latenessNanos = 0;
+  mNumTicks.fetch_add(1, std::memory_order_relaxed);
+  mTotalLatenessNanos.fetch_add(latenessNanos, std::memory_order_relaxed);
+  // Only the tick thread writes this, so this doesn't race
+  if (latenessNanos > mMaxLatenessNanos.load(std::memory_order_relaxed))
+  {
+    mMaxLatenessNanos.store(latenessNanos, std::memory_order_relaxed);
+  }
+
+  long micros = latenessNanos / 1000;
+  int bucket = 0;
+  while (micros > 0 && bucket < NUM_LATENESS_BUCKETS - 1)
+  {
+    micros >>= 1;
+    bucket++;
   }
+  mLatenessHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
 }
 
 } // namespace realtime
@@ -1,6 +1,7 @@
 #ifndef DART_TICKER
 #define DART_TICKER
 
+#include <atomic>
 #include <functional>
 #include <thread>
 #include <vector>
@@ -10,6 +11,24 @@
 namespace dart {
 namespace realtime {
 
+/// Timing counters for how late each tick fired, relative to when it was
+/// scheduled, so we can check that the control loop is keeping to its rate.
+struct TickLatenessStats
+{
+  /// The number of ticks that fired
+  long numTicks;
+  /// The number of ticks that were skipped entirely, because a listener ran
+  /// long enough that we'd already missed them. This is only counted in high
+  /// precision mode, since the default mode never skips ticks.
+  long numMissedTicks;
+  long maxLatenessNanos;
+  s_t meanLatenessNanos;
+  /// Entry 0 counts ticks that fired less than 1us late, and entry i > 0
+  /// counts ticks that fired between 2^(i-1) and 2^i us late. The last entry
+  /// also counts everything later than that.
+  std::vector<long> latenessHistogram;
+};
+
 class Ticker
 {
 public:
@@ -24,13 +43,68 @@ public:
   void toggle();
   bool isRunning();
 
+  /// Defaults to false. If this is true, ticks are scheduled against absolute
+  /// deadlines on the monotonic clock with nanosecond resolution, so they
+  /// never drift however long the listeners take, and ticks we've fallen a
+  /// whole period behind on are skipped rather than fired back to back.
+  /// Otherwise, ticks are rounded to the nearest millisecond. This should be
+  /// called before start().
+  void setHighPrecision(bool highPrecision);
+
+  /// Defaults to 50. In high precision mode, we sleep until this many
+  /// microseconds before each deadline, and then busy-wait the rest of the
+  /// way, since waking from a sleep is rarely that precise.
+  void setSpinMicros(int spinMicros);
+
+  /// Defaults to -1, which lets the tick thread run on any CPU. Otherwise,
+  /// the tick thread is pinned to this CPU when it starts. This is only
+  /// supported on Linux.
+  void setCpuAffinity(int cpu);
+
+  /// Defaults to 0, which runs the tick thread with the normal scheduler.
+  /// Otherwise, the tick thread is scheduled SCHED_FIFO at this priority
+  /// (1-99) when it starts, which usually needs root or CAP_SYS_NICE. This is
+  /// only supported on Linux.
+  void setRealtimePriority(int priority);
+
+  /// This returns the lateness counters since the last start() (or the last
+  /// resetTickLatenessStats())
+  TickLatenessStats getTickLatenessStats() const;
+
+  /// This zeros the lateness counters
+  void resetTickLatenessStats();
+
 protected:
   void mainLoop();
+
+  /// This is the loop for high precision mode
+  void highPrecisionLoop();
+
+  /// This applies our CPU affinity and realtime priority to the calling
+  /// thread
+  void configureThread();
+
+  /// This folds how late a tick fired into the lateness counters
+  void recordLateness(long latenessNanos);
+
   bool mRunning;
 
   s_t mSecondsPerTick;
   std::thread* mMainThread;
   std::vector<std::function<void(long)>> mListeners;
+
+  bool mHighPrecision;
+  int mSpinMicros;
+  int mCpuAffinity;
+  int mRealtimePriority;
+
+  static constexpr int NUM_LATENESS_BUCKETS = 24;
+  // These are written by the tick thread and read from anywhere
+  std::atomic<long> mNumTicks;
+  std::atomic<long> mNumMissedTicks;
+  std::atomic<long> mMaxLatenessNanos;
+  std::atomic<long> mTotalLatenessNanos;
+  std::atomic<long> mLatenessHistogram[NUM_LATENESS_BUCKETS];
 };
 
 } // namespace realtime
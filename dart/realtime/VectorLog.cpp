@@ -1,5 +1,7 @@
 #include "dart/realtime/VectorLog.hpp"
 
+#include <algorithm>
+
 namespace dart {
 namespace realtime {
 
@@ -8,7 +10,8 @@ VectorObservation::VectorObservation(long time, Eigen::VectorXs value)
 {
 }
 
-VectorLog::VectorLog(int dim) : mDim(dim), mStartTime(0L)
+VectorLog::VectorLog(int dim)
+  : mDim(dim), mStartTime(0L), mObservations(dim)
 {
 }
 
@@ -17,20 +20,31 @@ void VectorLog::record(long time, Eigen::VectorXs val)
   if (mObservations.size() == 0)
     mStartTime = time;
   assert(val.size() == mDim);
-  mObservations.emplace_back(time, val);
+  mObservations.append(time, val);
 }
 
 // start = current - mInferenceHorizon
-Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
+Eigen::MatrixXs VectorLog::getValues(
+    long start, int steps, long millisPerStep) const
 {
   Eigen::MatrixXs observations = Eigen::MatrixXs::Zero(mDim, steps);
 
+  // Observations land on step ceil((time - start) / millisPerStep), so the
+  // ones before step 0 only matter for the last value before the window, and
+  // the ones after step (steps - 1) don't matter at all
+  int first = mObservations.upperBound(start - millisPerStep);
+  int last = mObservations.upperBound(start + (steps - 1) * millisPerStep);
+
   Eigen::VectorXs cursorValue = Eigen::VectorXs::Zero(mDim);
+  if (first > 0)
+  {
+    cursorValue = mObservations.getValue(first - 1);
+  }
   int cursorStep = 0;
-  for (const VectorObservation& obs : mObservations)
+  for (int i = first; i < last; i++)
   {
-    int step = static_cast<int>(
-        ceil(static_cast<s_t>(obs.time - start) / millisPerStep));
+    int step = static_cast<int>(ceil(
+        static_cast<s_t>(mObservations.getTime(i) - start) / millisPerStep));
     if (step > steps - 1)
       break;
     if (step >= cursorStep)
@@ -42,13 +56,13 @@ Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
         cursorStep++;
       }
       // Set the current value to the current state
-      cursorValue = obs.value;
+      cursorValue = mObservations.getValue(i);
       observations.col(step) = cursorValue;
       assert(cursorStep == step);
     }
     else
     {
-      cursorValue = obs.value;
+      cursorValue = mObservations.getValue(i);
     }
   }
   // Sweep the last cursor value forward to the end of the block
@@ -62,65 +76,51 @@ Eigen::MatrixXs VectorLog::getValues(long start, int steps, long millisPerStep)
   return observations;
 }
 // Assmue there are enough data prior to a particular time stamp
-Eigen::MatrixXs VectorLog::getRecentValuesBefore(long time, int steps)
+Eigen::MatrixXs VectorLog::getRecentValuesBefore(long time, int steps) const
 {
-  Eigen::MatrixXs observations = Eigen::MatrixXs::Zero(mDim,steps);
-  int cnt = 0;
-  for(int i=mObservations.size()-1;i>=0;i--)
-  {
-    if(mObservations[i].time<time)
-    {
-      cnt++;
-      observations.col(steps-cnt) = mObservations[i].value;
-      if(cnt >= steps)
-        break;
-    }
-  }
+  Eigen::MatrixXs observations = Eigen::MatrixXs::Zero(mDim, steps);
+  int end = mObservations.lowerBound(time);
+  int count = std::min(steps, end);
+  observations.rightCols(count) = mObservations.getValues(end - count, count);
   return observations;
 }
 
-int VectorLog::availableStepsBefore(long time)
+int VectorLog::availableStepsBefore(long time) const
 {
-  if(time - mStartTime<0)
+  if (time - mStartTime < 0)
   {
     return -1;
   }
-  for(int i= mObservations.size();i>0;i--)
-  {
-    if(mObservations[i-1].time<time)
-    {
-      return i;
-    }
-  }
-  // Should not reach here just to make compiler happy
-  return 0;
+  return mObservations.lowerBound(time);
 }
 
-long VectorLog::availableHistoryBefore(long time)
+long VectorLog::availableHistoryBefore(long time) const
 {
   return time - mStartTime;
 }
 
 void VectorLog::discardBefore(long time)
 {
-  int discardBeforeIndex = -1;
-  for (int i = mObservations.size() - 1; i >= 0; i--)
-  {
-    if (mObservations[i].time < time)
-    {
-      discardBeforeIndex = i;
-      break;
-    }
-  }
-  if (discardBeforeIndex == -1)
-    return;
+  mObservations.discardFirst(mObservations.lowerBound(time));
+}
 
-  std::vector<VectorObservation> newObservations;
-  for (int i = discardBeforeIndex + 1; i < mObservations.size(); i++)
-  {
-    newObservations.push_back(mObservations[i]);
-  }
-  mObservations = newObservations;
+/// This returns a view of every value recorded at or after `start`, and before
+/// `end`, as columns, without copying
+Eigen::Map<const Eigen::MatrixXs> VectorLog::getRawValuesBetween(
+    long start, long end) const
+{
+  int first = mObservations.lowerBound(start);
+  int last = std::max(first, mObservations.lowerBound(end));
+  return mObservations.getValues(first, last - first);
+}
+
+/// This returns a view of the times that go with getRawValuesBetween()
+Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>>
+VectorLog::getRawTimesBetween(long start, long end) const
+{
+  int first = mObservations.lowerBound(start);
+  int last = std::max(first, mObservations.lowerBound(end));
+  return mObservations.getTimes(first, last - first);
 }
 
 } // namespace realtime
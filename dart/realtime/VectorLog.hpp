@@ -6,6 +6,7 @@
 #include <Eigen/Dense>
 
 #include "dart/math/MathTypes.hpp"
+#include "dart/realtime/ColumnarLog.hpp"
 
 namespace dart {
 namespace realtime {
@@ -25,20 +26,30 @@ public:
 
   void record(long time, Eigen::VectorXs val);
 
-  Eigen::MatrixXs getValues(long start, int steps, long millisPerStep);
+  Eigen::MatrixXs getValues(long start, int steps, long millisPerStep) const;
 
-  Eigen::MatrixXs getRecentValuesBefore(long time, int steps);
+  Eigen::MatrixXs getRecentValuesBefore(long time, int steps) const;
 
   void discardBefore(long time);
 
-  long availableHistoryBefore(long time);
+  long availableHistoryBefore(long time) const;
 
-  int availableStepsBefore(long time);
+  int availableStepsBefore(long time) const;
+
+  /// This returns a view of every value recorded at or after `start`, and
+  /// before `end`, as columns, without copying. This is only valid until the
+  /// next change to the log.
+  Eigen::Map<const Eigen::MatrixXs> getRawValuesBetween(
+      long start, long end) const;
+
+  /// This returns a view of the times that go with getRawValuesBetween()
+  Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>> getRawTimesBetween(
+      long start, long end) const;
 
 protected:
   int mDim;
   long mStartTime;
-  std::vector<VectorObservation> mObservations;
+  ColumnarLog mObservations;
 };
 
 } // namespace realtime
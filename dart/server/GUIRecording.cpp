@@ -1,12 +1,17 @@
 #include "dart/server/GUIRecording.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 
 #include "stdio.h"
-// #include <google/protobuf/io/coded_stream.h>
-// #include <google/protobuf/io/zero_copy_stream_impl.h>
 
 namespace dart {
 
@@ -24,7 +29,12 @@ class TrajectoryRollout;
 
 namespace server {
 
-GUIRecording::GUIRecording()
+// Written at the start of every file from writeFramesChunked()
+#define CHUNKED_MAGIC "NGUIREC1"
+// Bytes per entry in the chunk index
+#define CHUNK_INDEX_ENTRY_SIZE 20
+
+GUIRecording::GUIRecording() : mKeyframeInterval(100)
 {
 }
 
@@ -34,7 +44,21 @@ GUIRecording::~GUIRecording()
 
 void GUIRecording::saveFrame()
 {
+  int frame = mFrames.size();
   mFrames.push_back(flushJson());
+  bool isKeyframe
+      = frame == 0
+        || (mKeyframeInterval > 0 && frame % mKeyframeInterval == 0);
+  if (isKeyframe)
+  {
+    // Concatenated protos merge, so this is a ClearAll followed by the full
+    // current state
+    proto::CommandList clearList;
+    clearList.add_command()->mutable_clear_all()->set_dummy(true);
+    const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+    mKeyframes.emplace_back(
+        frame, clearList.SerializeAsString() + getCurrentStateAsJson());
+  }
 }
 
 int GUIRecording::getNumFrames()
@@ -103,5 +127,151 @@ void GUIRecording::writeFrameJson(const std::string& path, int frame)
   jsonFile.close();
 }
 
+void GUIRecording::setKeyframeInterval(int frames)
+{
+  mKeyframeInterval = frames;
+}
+
+void GUIRecording::writeFramesChunked(const std::string& path)
+{
+  std::cout << "Saving chunked GUI Recording to file \"" << path << "\"..."
+            << std::endl;
+
+  // Compress each chunk into memory first, since the index needs their sizes
+  std::vector<std::string> chunks;
+  std::vector<int> firstFrames;
+  std::vector<int> numFrames;
+  for (int k = 0; k < mKeyframes.size(); k++)
+  {
+    int firstFrame = mKeyframes[k].first;
+    if (firstFrame >= mFrames.size())
+      break;
+    int endFrame = mFrames.size();
+    if (k + 1 < mKeyframes.size())
+      endFrame = std::min(endFrame, mKeyframes[k + 1].first);
+
+    chunks.emplace_back();
+    {
+      google::protobuf::io::StringOutputStream stringStream(&chunks.back());
+      google::protobuf::io::GzipOutputStream gzipStream(&stringStream);
+      {
+        google::protobuf::io::CodedOutputStream coded(&gzipStream);
+        const std::string& keyframe = mKeyframes[k].second;
+        coded.WriteLittleEndian32(keyframe.size());
+        coded.WriteRaw(keyframe.data(), keyframe.size());
+        for (int i = firstFrame + 1; i < endFrame; i++)
+        {
+          coded.WriteLittleEndian32(mFrames[i].size());
+          coded.WriteRaw(mFrames[i].data(), mFrames[i].size());
+        }
+      }
+      gzipStream.Close();
+    }
+    firstFrames.push_back(firstFrame);
+    numFrames.push_back(endFrame - firstFrame);
+  }
+
+  std::string header;
+  {
+    google::protobuf::io::StringOutputStream stringStream(&header);
+    google::protobuf::io::CodedOutputStream coded(&stringStream);
+    coded.WriteRaw(CHUNKED_MAGIC, 8);
+    coded.WriteLittleEndian32(mFrames.size());
+    coded.WriteLittleEndian32(chunks.size());
+    int64_t offset = 16 + CHUNK_INDEX_ENTRY_SIZE * chunks.size();
+    for (int k = 0; k < chunks.size(); k++)
+    {
+      coded.WriteLittleEndian32(firstFrames[k]);
+      coded.WriteLittleEndian32(numFrames[k]);
+      coded.WriteLittleEndian64(offset);
+      coded.WriteLittleEndian32(chunks[k].size());
+      offset += chunks[k].size();
+    }
+  }
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr)
+  {
+    std::cout << "ERROR: Could not open \"" << path << "\" for writing"
+              << std::endl;
+    return;
+  }
+  fwrite(header.data(), header.size(), 1, file);
+  for (const std::string& chunk : chunks)
+  {
+    fwrite(chunk.data(), chunk.size(), 1, file);
+  }
+  fclose(file);
+
+  std::cout << "Finished saving " << mFrames.size() << " frames in "
+            << chunks.size() << " chunks to \"" << path << "\"!" << std::endl;
+}
+
+std::string GUIRecording::readChunkedFrame(const std::string& path, int frame)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open())
+    return "";
+
+  char head[16];
+  if (!file.read(head, 16) || std::memcmp(head, CHUNKED_MAGIC, 8) != 0)
+    return "";
+  google::protobuf::uint32 totalFrames;
+  google::protobuf::uint32 numChunks;
+  google::protobuf::io::CodedInputStream::ReadLittleEndian32FromArray(
+      (const google::protobuf::uint8*)head + 8, &totalFrames);
+  google::protobuf::io::CodedInputStream::ReadLittleEndian32FromArray(
+      (const google::protobuf::uint8*)head + 12, &numChunks);
+  if (frame < 0 || frame >= (int)totalFrames)
+    return "";
+
+  std::string index(CHUNK_INDEX_ENTRY_SIZE * numChunks, '\0');
+  if (!file.read(&index[0], index.size()))
+    return "";
+  google::protobuf::io::CodedInputStream indexStream(
+      (const google::protobuf::uint8*)index.data(), index.size());
+  google::protobuf::uint32 firstFrame = 0;
+  google::protobuf::uint32 chunkFrames = 0;
+  google::protobuf::uint64 offset = 0;
+  google::protobuf::uint32 compressedSize = 0;
+  bool found = false;
+  for (int k = 0; k < numChunks; k++)
+  {
+    indexStream.ReadLittleEndian32(&firstFrame);
+    indexStream.ReadLittleEndian32(&chunkFrames);
+    indexStream.ReadLittleEndian64(&offset);
+    indexStream.ReadLittleEndian32(&compressedSize);
+    if (frame >= (int)firstFrame && frame < (int)(firstFrame + chunkFrames))
+    {
+      found = true;
+      break;
+    }
+  }
+  if (!found)
+    return "";
+
+  std::string compressed(compressedSize, '\0');
+  file.seekg(offset);
+  if (!file.read(&compressed[0], compressed.size()))
+    return "";
+
+  // Keyframe first, then the deltas up to and including `frame`
+  std::string result;
+  google::protobuf::io::ArrayInputStream arrayStream(
+      compressed.data(), compressed.size());
+  google::protobuf::io::GzipInputStream gzipStream(&arrayStream);
+  google::protobuf::io::CodedInputStream coded(&gzipStream);
+  coded.SetTotalBytesLimit(std::numeric_limits<int>::max());
+  for (int i = firstFrame; i <= frame; i++)
+  {
+    google::protobuf::uint32 size;
+    std::string record;
+    if (!coded.ReadLittleEndian32(&size) || !coded.ReadString(&record, size))
+      return "";
+    result += record;
+  }
+  return result;
+}
+
 } // namespace server
 } // namespace dart
\ No newline at end of file
@@ -52,8 +52,40 @@ public:
 
   void writeFrameJson(const std::string& path, int frame);
 
+  /// This sets how often saveFrame() also snapshots the full GUI state as a
+  /// keyframe. Keyframes are where chunks start in writeFramesChunked(), so
+  /// this trades file size against how much a viewer has to decode to seek.
+  /// Defaults to every 100 frames, and 0 means only frame 0 is a keyframe.
+  /// Frame 0 is always a keyframe.
+  void setKeyframeInterval(int frames);
+
+  /// This writes a chunked, gzip compressed recording with a seek index, so
+  /// a viewer can jump to any frame by reading one chunk instead of parsing
+  /// the whole file. The layout (all integers little-endian) is:
+  ///
+  ///   "NGUIREC1" (8 bytes)
+  ///   int32 numFrames, int32 numChunks
+  ///   numChunks x { int32 firstFrame, int32 numFrames,
+  ///                 int64 offset, int32 compressedSize }
+  ///   numChunks x gzip blobs
+  ///
+  /// Each chunk starts at a keyframe. Decompressed, a chunk is a series of
+  /// [int32 size][CommandList bytes] records: first the keyframe (a ClearAll
+  /// plus the full state as of `firstFrame`), then the deltas for each of the
+  /// following frames in the chunk, same as writeFramesJson().
+  void writeFramesChunked(const std::string& path);
+
+  /// This reads a file written by writeFramesChunked() and returns a single
+  /// serialized CommandList that takes an empty GUI to the state at `frame`,
+  /// reading only the chunk that contains it. Returns "" on errors.
+  static std::string readChunkedFrame(const std::string& path, int frame);
+
 protected:
   std::vector<std::string> mFrames;
+
+  int mKeyframeInterval;
+  // The frame index and full state snapshot for each keyframe, in order
+  std::vector<std::pair<int, std::string>> mKeyframes;
 };
 
 } // namespace server
@@ -1,8 +1,10 @@
 #include "dart/server/GUIStateMachine.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 
 #include <assimp/scene.h>
@@ -26,6 +28,7 @@
 #include "dart/math/MathTypes.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/proto/GUI.pb.h"
+#include "dart/server/MeshDecimation.hpp"
 #include "dart/server/RawJsonUtils.hpp"
 #include "dart/server/external/base64/base64.h"
 #include "dart/simulation/World.hpp"
@@ -33,12 +36,69 @@
 namespace dart {
 namespace server {
 
-GUIStateMachine::GUIStateMachine() : mMessagesQueued(0)
+namespace {
+
+// These caches are shared by every GUIStateMachine in the process, so
+// rendering many skeletons with the same meshes only loads and encodes each
+// asset once
+std::mutex gAssetCacheMutex;
+// Content hash -> geometry, for as long as some mesh is still using it
+std::unordered_map<
+    std::string,
+    std::weak_ptr<const GUIStateMachine::MeshGeometry>>
+    gGeometryByHash;
+// Mesh file path -> geometry loaded from it
+std::unordered_map<
+    std::string,
+    std::shared_ptr<const GUIStateMachine::MeshGeometry>>
+    gGeometryByPath;
+// Texture file path -> base64 data URL
+std::unordered_map<std::string, std::string> gTextureByPath;
+
+// We stop building levels of detail once they'd have fewer faces than this
+constexpr int kMinFacesPerLevelOfDetail = 64;
+// setMeshScreenSize() aims for one face per this many square pixels
+constexpr s_t kPixelsPerFace = 16;
+
+/// True if `a` and `b` differ by more than `epsilon` in any coordinate. With
+/// an epsilon of 0 this is the same as a != b.
+template <typename Vector>
+bool differsByMoreThan(const Vector& a, const Vector& b, s_t epsilon)
+{
+  return a != b && !((a - b).cwiseAbs().array() <= epsilon).all();
+}
+
+/// FNV-1a over raw bytes
+void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+} // namespace
+
+GUIStateMachine::GUIStateMachine()
+  : mQueueHead(nullptr),
+    mMessagesQueued(0),
+    mPackTransforms(false),
+    mMotionEpsilon(0),
+    mInitialMeshLevelOfDetail(0)
 {
 }
 
 GUIStateMachine::~GUIStateMachine()
 {
+  QueuedCommand* command = mQueueHead.exchange(nullptr);
+  while (command != nullptr)
+  {
+    QueuedCommand* next = command->next;
+    delete command;
+    command = next;
+  }
 }
 
 std::string GUIStateMachine::getCurrentStateAsJson()
@@ -56,9 +116,12 @@ std::string GUIStateMachine::getCurrentStateAsJson()
   {
     encodeCreateTexture(list, pair.second);
   }
+  std::unordered_set<std::string> encodedGeometries;
   for (auto pair : mMeshes)
   {
-    encodeCreateMesh(list, pair.second);
+    bool firstUse
+        = encodedGeometries.insert(pair.second.geometry->hash).second;
+    encodeCreateMesh(list, pair.second, firstUse);
   }
   for (auto pair : mSpheres)
   {
@@ -117,15 +180,30 @@ std::string GUIStateMachine::flushJson()
 {
   const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
 
-  mCommandList.SerializeToString(&mCommandListOutputBuffer);
-
-  // Reset
+  // Reset the count before draining, so anything pushed while we drain is
+  // still counted for the next flush
   mMessagesQueued = 0;
+  drainQueuedCommands();
+  encodePendingTransforms(mCommandList);
+  mCommandList.SerializeToString(&mCommandListOutputBuffer);
   mCommandList.Clear();
 
   return mCommandListOutputBuffer;
 }
 
+/// This switches position and rotation updates over to packed batches
+void GUIStateMachine::setPackedTransformsEnabled(bool enabled)
+{
+  mPackTransforms = enabled;
+}
+
+/// This sets how far a shape has to move before we send an update for it
+void GUIStateMachine::setMotionEpsilon(s_t epsilon)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+  mMotionEpsilon = epsilon;
+}
+
 /// This is a high-level command that creates/updates all the shapes in a
 /// world by calling the lower-level commands
 void GUIStateMachine::renderWorld(
@@ -274,6 +352,32 @@ void GUIStateMachine::renderSkeleton(
           layer);
     }
   }
+
+  // Skeletons loaded without their geometry (see
+  // OpenSimParser::parseOsimWithoutGeometry()) only load their meshes once
+  // we render them, so load any we're about to need all at once
+  std::vector<const dynamics::MeshShape*> pendingMeshes;
+  for (int j = 0; j < skel->getNumBodyNodes(); j++)
+  {
+    dynamics::BodyNode* node = skel->getBodyNode(j);
+    if (node == nullptr)
+      continue;
+    for (int k = 0; k < node->getNumShapeNodes(); k++)
+    {
+      dynamics::ShapeNode* shapeNode = node->getShapeNode(k);
+      const dynamics::Shape* shape = shapeNode->getShape().get();
+      if (shape != nullptr && shapeNode->hasVisualAspect()
+          && shape->getType() == dynamics::MeshShape::getStaticType())
+      {
+        const dynamics::MeshShape* meshShape
+            = static_cast<const dynamics::MeshShape*>(shape);
+        if (!meshShape->isMeshLoaded())
+          pendingMeshes.push_back(meshShape);
+      }
+    }
+  }
+  dynamics::MeshShape::resolvePendingMeshes(pendingMeshes);
+
   for (int j = 0; j < skel->getNumBodyNodes(); j++)
   {
     dynamics::BodyNode* node = skel->getBodyNode(j);
@@ -461,11 +565,14 @@ void GUIStateMachine::renderSkeleton(
 
           if (getObjectScale(shapeName) != scale)
             setObjectScale(shapeName, scale);
-          if (getObjectPosition(shapeName) != pos)
+          if (differsByMoreThan(
+                  getObjectPosition(shapeName), pos, mMotionEpsilon))
             setObjectPosition(shapeName, pos);
-          if (getObjectRotation(shapeName) != euler)
+          if (differsByMoreThan(
+                  getObjectRotation(shapeName), euler, mMotionEpsilon))
             setObjectRotation(shapeName, euler);
-          if (getObjectColor(shapeName) != color)
+          if (differsByMoreThan(
+                  getObjectColor(shapeName), color, mMotionEpsilon))
             setObjectColor(shapeName, color);
         }
       }
@@ -664,6 +771,7 @@ void GUIStateMachine::clear()
   mCapsules.clear();
   mLines.clear();
   mMeshes.clear();
+  mSentGeometries.clear();
   mText.clear();
   mButtons.clear();
   mSliders.clear();
@@ -831,17 +939,203 @@ void GUIStateMachine::createMesh(
     const std::string& layer,
     bool castShadows,
     bool receiveShadows)
+{
+  createMeshFromGeometry(
+      key,
+      getSharedGeometry(
+          vertices, vertexNormals, faces, uv, textures, textureStartIndices),
+      pos,
+      euler,
+      scale,
+      color,
+      layer,
+      castShadows,
+      receiveShadows);
+}
+
+/// This returns the shared MeshGeometry for this content
+std::shared_ptr<const GUIStateMachine::MeshGeometry>
+GUIStateMachine::getSharedGeometry(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3s>& vertexNormals,
+    const std::vector<Eigen::Vector3i>& faces,
+    const std::vector<Eigen::Vector2s>& uv,
+    const std::vector<std::string>& textures,
+    const std::vector<int>& textureStartIndices)
+{
+  std::shared_ptr<MeshGeometry> geometry = std::make_shared<MeshGeometry>();
+  proto::CreateMesh& encoded = geometry->encoded;
+  encoded.mutable_vertex()->Reserve(vertices.size() * 3);
+  for (const Eigen::Vector3s& vertex : vertices)
+  {
+    encoded.add_vertex((double)vertex(0));
+    encoded.add_vertex((double)vertex(1));
+    encoded.add_vertex((double)vertex(2));
+  }
+  encoded.mutable_vertex_normal()->Reserve(vertexNormals.size() * 3);
+  for (const Eigen::Vector3s& normal : vertexNormals)
+  {
+    encoded.add_vertex_normal((double)normal(0));
+    encoded.add_vertex_normal((double)normal(1));
+    encoded.add_vertex_normal((double)normal(2));
+  }
+  encoded.mutable_face()->Reserve(faces.size() * 3);
+  for (const Eigen::Vector3i& face : faces)
+  {
+    encoded.add_face(face(0));
+    encoded.add_face(face(1));
+    encoded.add_face(face(2));
+  }
+  encoded.mutable_uv()->Reserve(uv.size() * 2);
+  for (const Eigen::Vector2s& coord : uv)
+  {
+    encoded.add_uv((double)coord(0));
+    encoded.add_uv((double)coord(1));
+  }
+  geometry->textures = textures;
+  geometry->textureStartIndices = textureStartIndices;
+
+  // Hash the wire format, since that's what clients end up caching
+  uint64_t hash = 14695981039346656037ULL;
+  hashBytes(hash, encoded.vertex().data(), encoded.vertex_size() * 4);
+  hashBytes(
+      hash, encoded.vertex_normal().data(), encoded.vertex_normal_size() * 4);
+  hashBytes(hash, encoded.face().data(), encoded.face_size() * 4);
+  hashBytes(hash, encoded.uv().data(), encoded.uv_size() * 4);
+  for (int i = 0; i < textures.size(); i++)
+  {
+    hashBytes(hash, textures[i].data(), textures[i].size() + 1);
+    hashBytes(hash, &textureStartIndices[i], sizeof(int));
+  }
+  std::stringstream hashStream;
+  hashStream << "__geometry_" << std::hex << std::setw(16)
+             << std::setfill('0') << hash;
+  geometry->hash = hashStream.str();
+
+  const std::lock_guard<std::mutex> lock(gAssetCacheMutex);
+  std::shared_ptr<const MeshGeometry> existing
+      = gGeometryByHash[geometry->hash].lock();
+  if (existing)
+  {
+    return existing;
+  }
+  gGeometryByHash[geometry->hash] = geometry;
+  return geometry;
+}
+
+/// This returns `geometry` at a level of detail
+std::shared_ptr<const GUIStateMachine::MeshGeometry>
+GUIStateMachine::getLevelOfDetail(
+    const std::shared_ptr<const MeshGeometry>& geometry, int level)
+{
+  if (level <= 0)
+    return geometry;
+
+  {
+    const std::lock_guard<std::mutex> lock(gAssetCacheMutex);
+    if (geometry->levelsOfDetailBuilt)
+    {
+      const std::vector<std::shared_ptr<const MeshGeometry>>& levels
+          = geometry->levelsOfDetail;
+      if (levels.empty())
+        return geometry;
+      return levels[std::min<std::size_t>(level, levels.size()) - 1];
+    }
+  }
+
+  // Decimation is slow, so we build outside the lock. If two threads race
+  // here, one of them wastes its work, but they agree on the result.
+  std::vector<std::shared_ptr<const MeshGeometry>> levels;
+  const proto::CreateMesh& encoded = geometry->encoded;
+  if (geometry->textures.empty() && encoded.uv_size() == 0)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    for (int i = 0; i + 2 < encoded.vertex_size(); i += 3)
+    {
+      vertices.emplace_back(
+          encoded.vertex(i), encoded.vertex(i + 1), encoded.vertex(i + 2));
+    }
+    std::vector<Eigen::Vector3s> vertexNormals;
+    for (int i = 0; i + 2 < encoded.vertex_normal_size(); i += 3)
+    {
+      vertexNormals.emplace_back(
+          encoded.vertex_normal(i),
+          encoded.vertex_normal(i + 1),
+          encoded.vertex_normal(i + 2));
+    }
+    std::vector<Eigen::Vector3i> faces;
+    for (int i = 0; i + 2 < encoded.face_size(); i += 3)
+    {
+      faces.emplace_back(
+          encoded.face(i), encoded.face(i + 1), encoded.face(i + 2));
+    }
+
+    // Each level is decimated from the one before
+    while (static_cast<int>(faces.size()) / 4 >= kMinFacesPerLevelOfDetail)
+    {
+      std::vector<Eigen::Vector3i> decimatedFaces;
+      std::vector<int> vertexSources;
+      decimateMesh(
+          vertices, faces, faces.size() / 4, decimatedFaces, vertexSources);
+      // Stop if the decimation got stuck well short of its target
+      if (decimatedFaces.size() > faces.size() * 3 / 4)
+        break;
+
+      std::vector<Eigen::Vector3s> decimatedVertices;
+      std::vector<Eigen::Vector3s> decimatedNormals;
+      for (int source : vertexSources)
+      {
+        decimatedVertices.push_back(vertices[source]);
+        if (vertexNormals.size() == vertices.size())
+          decimatedNormals.push_back(vertexNormals[source]);
+      }
+      levels.push_back(getSharedGeometry(
+          decimatedVertices,
+          decimatedNormals,
+          decimatedFaces,
+          std::vector<Eigen::Vector2s>(),
+          std::vector<std::string>(),
+          std::vector<int>()));
+
+      vertices = decimatedVertices;
+      vertexNormals = decimatedNormals;
+      faces = decimatedFaces;
+    }
+  }
+
+  const std::lock_guard<std::mutex> lock(gAssetCacheMutex);
+  if (!geometry->levelsOfDetailBuilt)
+  {
+    geometry->levelsOfDetail = levels;
+    geometry->levelsOfDetailBuilt = true;
+  }
+  if (geometry->levelsOfDetail.empty())
+    return geometry;
+  return geometry->levelsOfDetail[std::min<std::size_t>(
+                                      level, geometry->levelsOfDetail.size())
+                                  - 1];
+}
+
+/// This creates a mesh from geometry that's already been built
+void GUIStateMachine::createMeshFromGeometry(
+    const std::string& key,
+    std::shared_ptr<const MeshGeometry> geometry,
+    const Eigen::Vector3s& pos,
+    const Eigen::Vector3s& euler,
+    const Eigen::Vector3s& scale,
+    const Eigen::Vector4s& color,
+    const std::string& layer,
+    bool castShadows,
+    bool receiveShadows)
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
   Mesh& mesh = mMeshes[key];
   mesh.key = key;
-  mesh.vertices = vertices;
-  mesh.vertexNormals = vertexNormals;
-  mesh.faces = faces;
-  mesh.uv = uv;
-  mesh.textures = textures;
-  mesh.textureStartIndices = textureStartIndices;
+  mesh.fullGeometry = geometry;
+  mesh.levelOfDetail = mInitialMeshLevelOfDetail;
+  geometry = getLevelOfDetail(geometry, mInitialMeshLevelOfDetail);
+  mesh.geometry = geometry;
   mesh.pos = pos;
   mesh.euler = euler;
   mesh.scale = scale;
@@ -850,8 +1144,9 @@ void GUIStateMachine::createMesh(
   mesh.castShadows = castShadows;
   mesh.receiveShadows = receiveShadows;
 
-  queueCommand([this, key](proto::CommandList& list) {
-    encodeCreateMesh(list, mMeshes[key]);
+  bool firstUse = mSentGeometries.insert(geometry->hash).second;
+  queueCommand([this, key, firstUse](proto::CommandList& list) {
+    encodeCreateMesh(list, mMeshes[key], firstUse);
   });
 }
 
@@ -871,83 +1166,103 @@ void GUIStateMachine::createMeshASSIMP(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
-  std::vector<Eigen::Vector3s> vertices;
-  std::vector<Eigen::Vector3s> vertexNormals;
-  std::vector<Eigen::Vector3i> faces;
-  std::vector<Eigen::Vector2s> uv;
-  std::vector<std::string> textures;
-  std::vector<int> textureStartIndices;
-
-  std::string currentTexturePath = "";
-
-  for (int i = 0; i < mesh->mNumMeshes; i++)
+  // Meshes loaded from files are only converted once per process
+  std::shared_ptr<const MeshGeometry> geometry;
+  if (meshPath != "")
   {
-    aiMesh* m = mesh->mMeshes[i];
-    aiMaterial* mtl = nullptr;
-    if (mesh->mMaterials != nullptr)
+    const std::lock_guard<std::mutex> cacheLock(gAssetCacheMutex);
+    auto cached = gGeometryByPath.find(meshPath);
+    if (cached != gGeometryByPath.end())
     {
-      mtl = mesh->mMaterials[m->mMaterialIndex];
+      geometry = cached->second;
     }
-    aiString path;
-    if (mtl != nullptr
-        && aiReturn_SUCCESS
-               == aiGetMaterialTexture(mtl, aiTextureType_DIFFUSE, 0, &path))
+  }
+
+  if (!geometry)
+  {
+    std::vector<Eigen::Vector3s> vertices;
+    std::vector<Eigen::Vector3s> vertexNormals;
+    std::vector<Eigen::Vector3i> faces;
+    std::vector<Eigen::Vector2s> uv;
+    std::vector<std::string> textures;
+    std::vector<int> textureStartIndices;
+
+    std::string currentTexturePath = "";
+
+    for (int i = 0; i < mesh->mNumMeshes; i++)
     {
-      std::string newTexturePath = std::string(path.C_Str());
-      if (newTexturePath != currentTexturePath)
+      aiMesh* m = mesh->mMeshes[i];
+      aiMaterial* mtl = nullptr;
+      if (mesh->mMaterials != nullptr)
+      {
+        mtl = mesh->mMaterials[m->mMaterialIndex];
+      }
+      aiString path;
+      if (mtl != nullptr
+          && aiReturn_SUCCESS
+                 == aiGetMaterialTexture(mtl, aiTextureType_DIFFUSE, 0, &path))
       {
-        currentTexturePath = newTexturePath;
-        textures.push_back(newTexturePath);
-        textureStartIndices.push_back(vertices.size());
-        if (mTextures.find(newTexturePath) == mTextures.end())
+        std::string newTexturePath = std::string(path.C_Str());
+        if (newTexturePath != currentTexturePath)
         {
-          boost::filesystem::path fullPath = boost::filesystem::canonical(
-              boost::filesystem::path(currentTexturePath),
-              boost::filesystem::path(
-                  meshPath.substr(0, meshPath.find_last_of("/"))));
-
-          createTextureFromFile(newTexturePath, std::string(fullPath.c_str()));
+          currentTexturePath = newTexturePath;
+          textures.push_back(newTexturePath);
+          textureStartIndices.push_back(vertices.size());
         }
       }
-    }
 
-    for (int j = 0; j < m->mNumVertices; j++)
-    {
-      vertices.emplace_back(
-          m->mVertices[j][0], m->mVertices[j][1], m->mVertices[j][2]);
-      if (m->mNormals != nullptr)
-      {
-        vertexNormals.emplace_back(
-            m->mNormals[j][0], m->mNormals[j][1], m->mNormals[j][2]);
-      }
-      if (m->mNumUVComponents[0] >= 2)
+      for (int j = 0; j < m->mNumVertices; j++)
       {
-        uv.emplace_back(m->mTextureCoords[0][j][0], m->mTextureCoords[0][j][1]);
+        vertices.emplace_back(
+            m->mVertices[j][0], m->mVertices[j][1], m->mVertices[j][2]);
+        if (m->mNormals != nullptr)
+        {
+          vertexNormals.emplace_back(
+              m->mNormals[j][0], m->mNormals[j][1], m->mNormals[j][2]);
+        }
+        if (m->mNumUVComponents[0] >= 2)
+        {
+          uv.emplace_back(
+              m->mTextureCoords[0][j][0], m->mTextureCoords[0][j][1]);
+        }
       }
-      /*
-      if (m->mNumUVComponents[0] == 2 && m->mTextureCoords[0][j][0])
+      for (int k = 0; k < m->mNumFaces; k++)
       {
+        assert(m->mFaces[k].mNumIndices == 3);
+        faces.emplace_back(
+            m->mFaces[k].mIndices[0],
+            m->mFaces[k].mIndices[1],
+            m->mFaces[k].mIndices[2]);
       }
-      */
     }
-    for (int k = 0; k < m->mNumFaces; k++)
+
+    geometry = getSharedGeometry(
+        vertices, vertexNormals, faces, uv, textures, textureStartIndices);
+    if (meshPath != "")
     {
-      assert(m->mFaces[k].mNumIndices == 3);
-      faces.emplace_back(
-          m->mFaces[k].mIndices[0],
-          m->mFaces[k].mIndices[1],
-          m->mFaces[k].mIndices[2]);
+      const std::lock_guard<std::mutex> cacheLock(gAssetCacheMutex);
+      gGeometryByPath[meshPath] = geometry;
     }
   }
 
-  createMesh(
+  // Textures still have to be registered with this GUI before the mesh that
+  // uses them
+  for (const std::string& texturePath : geometry->textures)
+  {
+    if (mTextures.find(texturePath) == mTextures.end())
+    {
+      boost::filesystem::path fullPath = boost::filesystem::canonical(
+          boost::filesystem::path(texturePath),
+          boost::filesystem::path(
+              meshPath.substr(0, meshPath.find_last_of("/"))));
+
+      createTextureFromFile(texturePath, std::string(fullPath.c_str()));
+    }
+  }
+
+  createMeshFromGeometry(
       key,
-      vertices,
-      vertexNormals,
-      faces,
-      uv,
-      textures,
-      textureStartIndices,
+      geometry,
       pos,
       euler,
       scale,
@@ -981,6 +1296,69 @@ void GUIStateMachine::createMeshFromShape(
       receiveShadows);
 }
 
+/// This sets the level of detail that new meshes are first sent at
+void GUIStateMachine::setInitialMeshLevelOfDetail(int level)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+  mInitialMeshLevelOfDetail = level;
+}
+
+/// This re-sends the mesh at `key` at a level of detail
+void GUIStateMachine::setMeshLevelOfDetail(const std::string& key, int level)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  auto it = mMeshes.find(key);
+  if (it == mMeshes.end())
+    return;
+  Mesh& mesh = it->second;
+  mesh.levelOfDetail = level;
+  std::shared_ptr<const MeshGeometry> geometry
+      = getLevelOfDetail(mesh.fullGeometry, level);
+  if (geometry == mesh.geometry)
+    return;
+  mesh.geometry = geometry;
+
+  bool firstUse = mSentGeometries.insert(geometry->hash).second;
+  queueCommand([this, key, firstUse](proto::CommandList& list) {
+    encodeCreateMesh(list, mMeshes[key], firstUse);
+  });
+}
+
+/// Returns the level of detail the mesh at `key` was last sent at
+int GUIStateMachine::getMeshLevelOfDetail(const std::string& key)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  auto it = mMeshes.find(key);
+  if (it == mMeshes.end())
+    return -1;
+  return it->second.levelOfDetail;
+}
+
+/// This picks a level of detail for the mesh at `key` from its size on screen
+void GUIStateMachine::setMeshScreenSize(const std::string& key, s_t pixels)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  auto it = mMeshes.find(key);
+  if (it == mMeshes.end())
+    return;
+  const s_t faceBudget = pixels * pixels / kPixelsPerFace;
+  int level = 0;
+  std::shared_ptr<const MeshGeometry> current = it->second.fullGeometry;
+  while (true)
+  {
+    std::shared_ptr<const MeshGeometry> next
+        = getLevelOfDetail(it->second.fullGeometry, level + 1);
+    if (next == current || next->encoded.face_size() / 3 < faceBudget)
+      break;
+    current = next;
+    level++;
+  }
+  setMeshLevelOfDetail(key, level);
+}
+
 /// This creates a texture object, to be sent to the web frontend
 void GUIStateMachine::createTexture(
     const std::string& key, const std::string& base64)
@@ -1004,13 +1382,28 @@ void GUIStateMachine::createTextureFromFile(
 {
   const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
 
-  std::ifstream in(path);
-  std::ostringstream sstr;
-  sstr << in.rdbuf();
+  // Each file is only read and encoded once per process
+  std::string base64;
+  {
+    const std::lock_guard<std::mutex> cacheLock(gAssetCacheMutex);
+    auto cached = gTextureByPath.find(path);
+    if (cached != gTextureByPath.end())
+    {
+      base64 = cached->second;
+    }
+  }
+  if (base64 == "")
+  {
+    std::ifstream in(path);
+    std::ostringstream sstr;
+    sstr << in.rdbuf();
+
+    std::string suffix = path.substr(path.find_last_of(".") + 1);
+    base64 = "data:image/" + suffix + ";base64, " + ::base64_encode(sstr.str());
 
-  std::string suffix = path.substr(path.find_last_of(".") + 1);
-  std::string base64
-      = "data:image/" + suffix + ";base64, " + ::base64_encode(sstr.str());
+    const std::lock_guard<std::mutex> cacheLock(gAssetCacheMutex);
+    gTextureByPath[path] = base64;
+  }
   createTexture(key, base64);
 }
 
@@ -1121,6 +1514,12 @@ void GUIStateMachine::setObjectPosition(
     mMeshes[key].pos = pos;
   }
 
+  if (mPackTransforms)
+  {
+    queuePackedTransform(false, key, pos);
+    return;
+  }
+
   queueCommand([&](proto::CommandList& list) {
     proto::Command* command = list.add_command();
     command->mutable_set_object_position()->set_key(getStringCode(key));
@@ -1149,6 +1548,12 @@ void GUIStateMachine::setObjectRotation(
     mMeshes[key].euler = euler;
   }
 
+  if (mPackTransforms)
+  {
+    queuePackedTransform(true, key, euler);
+    return;
+  }
+
   queueCommand([&](proto::CommandList& list) {
     proto::Command* command = list.add_command();
     command->mutable_set_object_rotation()->set_key(getStringCode(key));
@@ -1877,12 +2282,123 @@ std::string GUIStateMachine::getCodeString(int code)
 void GUIStateMachine::queueCommand(
     std::function<void(proto::CommandList&)> writeCommand)
 {
-  const std::lock_guard<std::recursive_mutex> lock(mProtoMutex);
+  QueuedCommand* command = new QueuedCommand();
+  command->isTransform = false;
+  writeCommand(command->list);
+  pushQueuedCommand(command);
+}
 
-  writeCommand(mCommandList);
+void GUIStateMachine::queuePackedTransform(
+    bool isRotation, const std::string& key, const Eigen::Vector3s& value)
+{
+  QueuedCommand* command = new QueuedCommand();
+  command->isTransform = true;
+  command->isRotation = isRotation;
+  command->key = getStringCode(key);
+  command->value[0] = (float)value(0);
+  command->value[1] = (float)value(1);
+  command->value[2] = (float)value(2);
+  pushQueuedCommand(command);
+}
+
+void GUIStateMachine::pushQueuedCommand(QueuedCommand* command)
+{
+  command->next = mQueueHead.load(std::memory_order_relaxed);
+  while (!mQueueHead.compare_exchange_weak(
+      command->next,
+      command,
+      std::memory_order_release,
+      std::memory_order_relaxed))
+    ;
   mMessagesQueued++;
 }
 
+void GUIStateMachine::drainQueuedCommands()
+{
+  QueuedCommand* head = mQueueHead.exchange(nullptr, std::memory_order_acquire);
+
+  // The stack hands commands back newest first, so reverse it into the order
+  // they were pushed
+  QueuedCommand* ordered = nullptr;
+  while (head != nullptr)
+  {
+    QueuedCommand* next = head->next;
+    head->next = ordered;
+    ordered = head;
+    head = next;
+  }
+
+  while (ordered != nullptr)
+  {
+    if (ordered->isTransform)
+    {
+      addPendingTransform(
+          ordered->isRotation ? mPendingRotations : mPendingPositions,
+          *ordered);
+    }
+    else
+    {
+      encodePendingTransforms(mCommandList);
+      for (int i = 0; i < ordered->list.command_size(); i++)
+      {
+        mCommandList.add_command()->Swap(ordered->list.mutable_command(i));
+      }
+    }
+    QueuedCommand* next = ordered->next;
+    delete ordered;
+    ordered = next;
+  }
+}
+
+void GUIStateMachine::addPendingTransform(
+    PackedTransforms& pending, const QueuedCommand& update)
+{
+  auto it = pending.index.find(update.key);
+  int offset;
+  if (it == pending.index.end())
+  {
+    pending.index[update.key] = pending.keys.size();
+    offset = pending.data.size();
+    pending.keys.push_back(update.key);
+    pending.data.resize(offset + 3);
+  }
+  else
+  {
+    offset = it->second * 3;
+  }
+  pending.data[offset] = update.value[0];
+  pending.data[offset + 1] = update.value[1];
+  pending.data[offset + 2] = update.value[2];
+}
+
+void GUIStateMachine::encodePendingTransforms(proto::CommandList& list)
+{
+  if (mPendingPositions.keys.size() > 0)
+  {
+    proto::SetObjectPositions* positions
+        = list.add_command()->mutable_set_object_positions();
+    positions->mutable_key()->Add(
+        mPendingPositions.keys.begin(), mPendingPositions.keys.end());
+    positions->mutable_data()->Add(
+        mPendingPositions.data.begin(), mPendingPositions.data.end());
+    mPendingPositions.keys.clear();
+    mPendingPositions.data.clear();
+    mPendingPositions.index.clear();
+  }
+  if (mPendingRotations.keys.size() > 0)
+  {
+    proto::SetObjectRotations* rotations
+        = list.add_command()->mutable_set_object_rotations();
+    rotations->mutable_key()->Add(
+        mPendingRotations.keys.begin(), mPendingRotations.keys.end());
+    rotations->mutable_data()->Add(
+        mPendingRotations.data.begin(), mPendingRotations.data.end());
+    mPendingRotations.keys.clear();
+    mPendingRotations.data.clear();
+    mPendingRotations.index.clear();
+  }
+}
+
 void GUIStateMachine::encodeSetFramesPerSecond(
     proto::CommandList& list, int framesPerSecond)
 {
@@ -1998,38 +2514,24 @@ void GUIStateMachine::encodeCreateLine(proto::CommandList& list, Line& line)
   }
 }
 
-void GUIStateMachine::encodeCreateMesh(proto::CommandList& list, Mesh& mesh)
+void GUIStateMachine::encodeCreateMesh(
+    proto::CommandList& list, Mesh& mesh, bool includeGeometry)
 {
   proto::Command* command = list.add_command();
   command->mutable_mesh()->set_key(getStringCode(mesh.key));
   command->mutable_mesh()->set_layer(getStringCode(mesh.layer));
-  for (Eigen::Vector3s& vertex : mesh.vertices)
-  {
-    command->mutable_mesh()->add_vertex((double)vertex(0));
-    command->mutable_mesh()->add_vertex((double)vertex(1));
-    command->mutable_mesh()->add_vertex((double)vertex(2));
-  }
-  for (Eigen::Vector3s& normal : mesh.vertexNormals)
-  {
-    command->mutable_mesh()->add_vertex_normal((double)normal(0));
-    command->mutable_mesh()->add_vertex_normal((double)normal(1));
-    command->mutable_mesh()->add_vertex_normal((double)normal(2));
-  }
-  for (Eigen::Vector3i& face : mesh.faces)
+  command->mutable_mesh()->set_geometry(getStringCode(mesh.geometry->hash));
+  if (includeGeometry)
   {
-    command->mutable_mesh()->add_face(face(0));
-    command->mutable_mesh()->add_face(face(1));
-    command->mutable_mesh()->add_face(face(2));
-  }
-  for (Eigen::Vector2s& uv : mesh.uv)
-  {
-    command->mutable_mesh()->add_uv((double)uv(0));
-    command->mutable_mesh()->add_uv((double)uv(1));
-  }
-  for (int i = 0; i < mesh.textures.size(); i++)
-  {
-    command->mutable_mesh()->add_texture(getStringCode(mesh.textures[i]));
-    command->mutable_mesh()->add_texture_start(mesh.textureStartIndices[i]);
+    const MeshGeometry& geometry = *mesh.geometry;
+    command->mutable_mesh()->MergeFrom(geometry.encoded);
+    for (int i = 0; i < geometry.textures.size(); i++)
+    {
+      command->mutable_mesh()->add_texture(
+          getStringCode(geometry.textures[i]));
+      command->mutable_mesh()->add_texture_start(
+          geometry.textureStartIndices[i]);
+    }
   }
   command->mutable_mesh()->add_data((double)mesh.scale(0));
   command->mutable_mesh()->add_data((double)mesh.scale(1));
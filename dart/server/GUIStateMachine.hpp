@@ -1,6 +1,7 @@
 #ifndef DART_GUI_STATE_MACHINE
 #define DART_GUI_STATE_MACHINE
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <memory>
@@ -54,6 +55,20 @@ public:
   /// This formats the latest set of commands as JSON, and clears the buffer
   std::string flushJson();
 
+  /// This switches setObjectPosition() and setObjectRotation() over to
+  /// batching consecutive updates into single packed SetObjectPositions /
+  /// SetObjectRotations commands, keeping only the latest value per object.
+  /// Older clients can't read the batched commands, so this is off by
+  /// default.
+  void setPackedTransformsEnabled(bool enabled);
+
+  /// This sets how far a shape has to move (in any coordinate of its position
+  /// or Euler angles) or change color before renderWorld() and
+  /// renderSkeleton() send an update for it. Smaller changes are held back,
+  /// and measured against the last value we sent, so slow drift still gets
+  /// sent once it adds up. The default, 0, sends every change.
+  void setMotionEpsilon(s_t epsilon);
+
   /// This is a high-level command that creates/updates all the shapes in a
   /// world by calling the lower-level commands
   void renderWorld(
@@ -179,6 +194,24 @@ public:
       const Eigen::Vector4s& color = Eigen::Vector4s(1.0, 0.5, 0.5, 1.0),
       const std::string& layer = "");
 
+  /// The vertex data for a mesh. These are immutable once built, and shared
+  /// (across every GUIStateMachine in the process) between all meshes with
+  /// identical content, so shared OpenSim geometry is stored and encoded once.
+  struct MeshGeometry
+  {
+    // Content hash of everything below
+    std::string hash;
+    // The vertex, vertex_normal, face and uv fields, already in wire format
+    proto::CreateMesh encoded;
+    std::vector<std::string> textures;
+    std::vector<int> textureStartIndices;
+    // Coarser versions of this geometry, built the first time someone asks
+    // for them (see getLevelOfDetail()). Entry i is level i + 1. These are
+    // guarded by the asset cache lock, since geometries are shared.
+    mutable std::vector<std::shared_ptr<const MeshGeometry>> levelsOfDetail;
+    mutable bool levelsOfDetailBuilt = false;
+  };
+
   /// This creates a mesh in the web GUI under a specified key, using raw shape
   /// data
   void createMesh(
@@ -224,6 +257,28 @@ public:
       bool castShadows = false,
       bool receiveShadows = false);
 
+  /// This sets the level of detail that new meshes are first sent at. Level 0
+  /// is the full mesh, and each level after that has about a quarter of the
+  /// faces of the one before. Sending meshes coarse and letting clients ask
+  /// for detail as they need it (see setMeshScreenSize()) cuts the load time
+  /// of scenes full of detailed meshes. The default is 0.
+  void setInitialMeshLevelOfDetail(int level);
+
+  /// This re-sends the mesh at `key` at a level of detail, clamped to the
+  /// levels its geometry has. Textured meshes only have level 0, since
+  /// decimating them would tear their UV seams.
+  void setMeshLevelOfDetail(const std::string& key, int level);
+
+  /// Returns the level of detail the mesh at `key` was last sent at, or -1 if
+  /// there's no such mesh
+  int getMeshLevelOfDetail(const std::string& key);
+
+  /// This picks the coarsest level of detail for the mesh at `key` that still
+  /// has about one face per 16 square pixels of the `pixels` across that it
+  /// spans on screen, and sends it if that's changed. Clients call this with
+  /// the "mesh_screen_size" message.
+  void setMeshScreenSize(const std::string& key, s_t pixels);
+
   /// This creates a texture object, to be sent to the web frontend
   void createTexture(const std::string& key, const std::string& base64);
 
@@ -407,13 +462,48 @@ public:
   std::string getCodeString(int code);
 
 protected:
-  // protects the buffered JSON message (mJson) from getting
-  // corrupted if we queue messages while trying to flush()
+  // protects the object state (mBoxes, mSpheres, etc) that we use to rebuild
+  // the GUI for newly connected clients. This is never held during network
+  // I/O or while serializing a flush.
   std::recursive_mutex globalMutex;
+
+  // Commands are encoded by the calling thread and pushed onto a lock-free
+  // stack, which flushJson() drains into mCommandList. Producers never wait
+  // on the flush.
+  struct QueuedCommand
+  {
+    proto::CommandList list;
+    // If set, this is a packed position (or rotation) update for `key`
+    // instead of `list`
+    bool isTransform;
+    bool isRotation;
+    int key;
+    float value[3];
+    QueuedCommand* next;
+  };
+  std::atomic<QueuedCommand*> mQueueHead;
+  std::atomic<int> mMessagesQueued;
+
+  // Only touched by whoever is flushing, under mProtoMutex
   std::recursive_mutex mProtoMutex;
-  int mMessagesQueued;
   proto::CommandList mCommandList;
   std::string mCommandListOutputBuffer;
+
+  // Position and rotation updates waiting to be packed into mCommandList. Any
+  // other command flushes these first, so ordering is preserved.
+  struct PackedTransforms
+  {
+    std::vector<int> keys;
+    // 3 floats per entry in `keys`
+    std::vector<float> data;
+    // Maps a key code to its index in `keys`
+    std::unordered_map<int, int> index;
+  };
+  std::atomic<bool> mPackTransforms;
+  s_t mMotionEpsilon;
+  int mInitialMeshLevelOfDetail;
+  PackedTransforms mPendingPositions;
+  PackedTransforms mPendingRotations;
   // This is a list of all the objects with mouse interaction enabled
   std::unordered_set<std::string> mDragEnabled;
   std::unordered_set<std::string> mTooltipEditable;
@@ -482,16 +572,42 @@ protected:
   };
   std::unordered_map<std::string, Tooltip> mTooltips;
 
+  /// This returns the shared MeshGeometry for this content, building it if
+  /// no live mesh has the same content yet
+  static std::shared_ptr<const MeshGeometry> getSharedGeometry(
+      const std::vector<Eigen::Vector3s>& vertices,
+      const std::vector<Eigen::Vector3s>& vertexNormals,
+      const std::vector<Eigen::Vector3i>& faces,
+      const std::vector<Eigen::Vector2s>& uv,
+      const std::vector<std::string>& textures,
+      const std::vector<int>& textureStartIndices);
+
+  /// This returns `geometry` at a level of detail, building and caching all
+  /// of its levels the first time any are asked for. Asking for a level past
+  /// the coarsest one returns the coarsest.
+  static std::shared_ptr<const MeshGeometry> getLevelOfDetail(
+      const std::shared_ptr<const MeshGeometry>& geometry, int level);
+
+  /// This creates a mesh from geometry that's already been built
+  void createMeshFromGeometry(
+      const std::string& key,
+      std::shared_ptr<const MeshGeometry> geometry,
+      const Eigen::Vector3s& pos,
+      const Eigen::Vector3s& euler,
+      const Eigen::Vector3s& scale,
+      const Eigen::Vector4s& color,
+      const std::string& layer,
+      bool castShadows,
+      bool receiveShadows);
+
   struct Mesh
   {
     std::string key;
     std::string layer;
-    std::vector<Eigen::Vector3s> vertices;
-    std::vector<Eigen::Vector3s> vertexNormals;
-    std::vector<Eigen::Vector3i> faces;
-    std::vector<Eigen::Vector2s> uv;
-    std::vector<std::string> textures;
-    std::vector<int> textureStartIndices;
+    // The geometry at the level of detail we last sent
+    std::shared_ptr<const MeshGeometry> geometry;
+    std::shared_ptr<const MeshGeometry> fullGeometry;
+    int levelOfDetail;
     Eigen::Vector3s pos;
     Eigen::Vector3s euler;
     Eigen::Vector3s scale;
@@ -500,6 +616,9 @@ protected:
     bool receiveShadows;
   };
   std::unordered_map<std::string, Mesh> mMeshes;
+  // Hashes of the geometries we've already queued in full since the last
+  // clear(), so later meshes can just reference them
+  std::unordered_set<std::string> mSentGeometries;
 
   struct Texture
   {
@@ -587,13 +706,22 @@ protected:
 
   void queueCommand(std::function<void(proto::CommandList&)> writeCommand);
 
+  void queuePackedTransform(
+      bool isRotation, const std::string& key, const Eigen::Vector3s& value);
+  void pushQueuedCommand(QueuedCommand* command);
+  void drainQueuedCommands();
+  void addPendingTransform(
+      PackedTransforms& pending, const QueuedCommand& update);
+  void encodePendingTransforms(proto::CommandList& list);
+
   void encodeSetFramesPerSecond(proto::CommandList& list, int framesPerSecond);
   void encodeCreateLayer(proto::CommandList& list, Layer& layer);
   void encodeCreateBox(proto::CommandList& list, Box& box);
   void encodeCreateSphere(proto::CommandList& list, Sphere& sphere);
   void encodeCreateCapsule(proto::CommandList& list, Capsule& capsule);
   void encodeCreateLine(proto::CommandList& list, Line& line);
-  void encodeCreateMesh(proto::CommandList& list, Mesh& mesh);
+  void encodeCreateMesh(
+      proto::CommandList& list, Mesh& mesh, bool includeGeometry);
   void encodeSetTooltip(proto::CommandList& list, Tooltip& tooltip);
   void encodeCreateTexture(proto::CommandList& list, Texture& texture);
   void encodeEnableDrag(proto::CommandList& list, const std::string& key);
@@ -1,483 +1,707 @@
-#include "dart/server/GUIWebsocketServer.hpp"
-
-#include <chrono>
-#include <fstream>
-#include <sstream>
-
-#include <assimp/scene.h>
-#include <boost/filesystem.hpp>
-
-#include "dart/collision/CollisionResult.hpp"
-#include "dart/common/Aspect.hpp"
-#include "dart/constraint/ConstraintSolver.hpp"
-#include "dart/dynamics/BodyNode.hpp"
-#include "dart/dynamics/BoxShape.hpp"
-#include "dart/dynamics/CapsuleShape.hpp"
-#include "dart/dynamics/MeshShape.hpp"
-#include "dart/dynamics/ShapeFrame.hpp"
-#include "dart/dynamics/ShapeNode.hpp"
-#include "dart/dynamics/Skeleton.hpp"
-#include "dart/dynamics/SphereShape.hpp"
-#include "dart/math/Geometry.hpp"
-#include "dart/neural/RestorableSnapshot.hpp"
-#include "dart/server/RawJsonUtils.hpp"
-#include "dart/server/external/base64/base64.h"
-#include "dart/simulation/World.hpp"
-
-namespace dart {
-namespace server {
-
-GUIWebsocketServer::GUIWebsocketServer()
-  : mPort(-1),
-    mServing(false),
-    mStartingServer(false),
-    mScreenSize(Eigen::Vector2i(680, 420))
-{
-}
-
-GUIWebsocketServer::~GUIWebsocketServer()
-{
-  {
-    const std::unique_lock<std::mutex> lock(this->mServingMutex);
-    if (!mServing)
-      return;
-  }
-  dterr << "GUIWebsocketServer is being deallocated while it's still "
-           "serving! The server will now terminate, and attempt to clean up. "
-           "If this was not intended "
-           "behavior, please keep a reference to the GUIWebsocketServer to "
-           "keep the server alive. If this was intended behavior, please "
-           "call "
-           "stopServing() on "
-           "the server before deallocating it."
-        << std::endl;
-  stopServing();
-}
-
-/// This is a non-blocking call to start a websocket server on a given port
-void GUIWebsocketServer::serve(int port)
-{
-  mPort = port;
-  // Register signal and signal handler
-  {
-    const std::unique_lock<std::mutex> lock(this->mServingMutex);
-    if (mServing || mStartingServer)
-    {
-      std::cout << "Errer in GUIWebsocketServer::serve()! Already serving. "
-                   "Ignoring request."
-                << std::endl;
-      return;
-    }
-    // We're not serving yet, but we are starting the server
-    mServing = false;
-    mStartingServer = true;
-  }
-  mServer = new WebsocketServer();
-
-  // Register our network callbacks, ensuring the logic is run on the main
-  // thread's event loop
-  mServer->connect([this](ClientConnection conn) {
-    {
-      // We don't need high throughput, so run everything through a global mutex
-      // to avoid data races
-      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-      // Send a hello message to the client
-      // mServer->send(conn) seems to break, cause conn appears to get cleaned
-      // up in race conditions (it's a weak pointer)
-
-      std::string jsonStr = getCurrentStateAsJson();
-      try
-      {
-        mServer->send(conn, base64_encode(jsonStr));
-      }
-      catch (...)
-      {
-        dterr << "GUIWebsocketServer caught an error broadcasting message \""
-              << jsonStr << "\"" << std::endl;
-      }
-      // mServer->broadcast("{\"type\": 1}");
-      /*
-      mServer->broadcast(
-          "{\"type\": \"init\", \"world\": " + mWorld->toJson() + "}");
-      */
-    }
-
-    // Don't hold the globalMutex when calling connection listeners, because
-    // that can lead to deadlocks if the connection listeners call out to Python
-    // (which tries to grab the GIL) while other Python code (holding the GIL)
-    // tries to grab the globalMutex.
-
-    for (auto listener : mConnectionListeners)
-    {
-      listener();
-    }
-  });
-
-  mServer->disconnect([this](ClientConnection /* conn */) {
-    std::clog << "Connection closed." << std::endl;
-    std::clog << "There are now " << mServer->numConnections()
-              << " open connections." << std::endl;
-  });
-  mServer->message([this](
-                       ClientConnection /* conn */, const Json::Value& args) {
-    if (args["type"].asString() == "keydown")
-    {
-      std::string key = args["key"].asString();
-      {
-        const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-        this->mKeysDown.insert(key);
-      }
-      for (auto listener : this->mKeydownListeners)
-      {
-        listener(key);
-      }
-    }
-    else if (args["type"].asString() == "keyup")
-    {
-      std::string key = args["key"].asString();
-      {
-        const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-        this->mKeysDown.erase(key);
-      }
-      for (auto listener : this->mKeyupListeners)
-      {
-        listener(key);
-      }
-    }
-    else if (args["type"].asString() == "button_click")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      if (mButtons.find(key) != mButtons.end())
-      {
-        mButtons[key].onClick();
-      }
-    }
-    else if (args["type"].asString() == "slider_set_value")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      s_t value = static_cast<s_t>(args["value"].asDouble());
-      if (mSliders.find(key) != mSliders.end())
-      {
-        mSliders[key].value = value;
-        mSliders[key].onChange(value);
-      }
-    }
-    else if (args["type"].asString() == "screen_resize")
-    {
-      Eigen::Vector2i size
-          = Eigen::Vector2i(args["size"][0].asInt(), args["size"][1].asInt());
-      mScreenSize = size;
-
-      for (auto handler : mScreenResizeListeners)
-      {
-        handler(size);
-      }
-    }
-    else if (args["type"].asString() == "drag")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      Eigen::Vector3s pos = Eigen::Vector3s(
-          static_cast<s_t>(args["pos"][0].asDouble()),
-          static_cast<s_t>(args["pos"][1].asDouble()),
-          static_cast<s_t>(args["pos"][2].asDouble()));
-
-      for (auto handler : mDragListeners[key])
-      {
-        handler(pos);
-      }
-    }
-    else if (args["type"].asString() == "drag_end")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      for (auto handler : mDragEndListeners[key])
-      {
-        handler();
-      }
-    }
-    else if (args["type"].asString() == "edit_tooltip")
-    {
-      std::string key = this->getCodeString(args["key"].asInt());
-      std::string tooltip = args["tooltip"].asString();
-
-      for (auto handler : mTooltipChangeListeners[key])
-      {
-        handler(tooltip);
-      }
-    }
-  });
-
-  // unblock signals in this thread
-  sigset_t sigset;
-  sigemptyset(&sigset);
-  sigaddset(&sigset, SIGINT);
-  sigaddset(&sigset, SIGTERM);
-  pthread_sigmask(SIG_UNBLOCK, &sigset, nullptr);
-
-  /*
-  // The signal set is used to register termination notifications
-  mSignalSet = new asio::signal_set(mServerEventLoop, SIGINT, SIGTERM);
-  // register the handle_stop callback
-  mSignalSet->async_wait([&](asio::error_code const& error, int signal_number) {
-    if (error == asio::error::operation_aborted)
-    {
-      std::cout << "Signal listener was terminated by asio" << std::endl;
-    }
-    else if (error)
-    {
-      std::cout << "Got an error registering termination signals: " << error
-                << std::endl;
-    }
-    else if (
-        signal_number == SIGINT || signal_number == SIGTERM
-        || signal_number == SIGQUIT)
-    {
-      std::cout << "Shutting down the server..." << std::endl;
-      stopServing();
-      mServerEventLoop.stop();
-      exit(signal_number);
-    }
-  });
-  */
-
-  // Start the networking thread
-  mServerThread = new std::thread([this, port]() {
-    /*
-    // block signals in this thread and subsequently
-    // spawned threads so they're guaranteed to go to the main thread
-    sigset_t sigset;
-    sigemptyset(&sigset);
-    sigaddset(&sigset, SIGINT);
-    sigaddset(&sigset, SIGTERM);
-    pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
-    */
-
-    std::cout << "GUIWebsocketServer will start serving a WebSocket server on "
-                 "ws://localhost:"
-              << port << std::endl;
-
-    // Note that we've started, but do it from within the server's event loop
-    // once the server has _actually_ started.
-    mServer->eventLoop.post([&]() {
-      {
-        const std::unique_lock<std::mutex> lock(this->mServingMutex);
-        mStartingServer = false;
-        mServing = true;
-        mServingConditionValue.notify_all();
-      }
-
-      // Start the flush thread
-      mFlushThread = new std::thread([this]() { this->flushThread(); });
-    });
-
-    bool success = mServer->run(port);
-    if (!success)
-    {
-      // This means we failed to bind to the port
-      stopServing();
-    }
-  });
-}
-
-/// This kills the server, if one was running
-void GUIWebsocketServer::stopServing()
-{
-  {
-    std::unique_lock<std::mutex> lock(this->mServingMutex);
-    if (mStartingServer)
-    {
-      std::cout << "GUIWebsocketServer called stopServing() while we're in the "
-                   "middle of booting "
-                   "the server. Waiting until booting finished..."
-                << std::endl;
-      mServingConditionValue.wait(lock, [&]() { return !mStartingServer; });
-      std::cout << "GUIWebsocketServer finished booting server, will now "
-                   "resume stopServing()."
-                << std::endl;
-    }
-    if (!mServing)
-      return;
-    mServing = false;
-  }
-  std::cout << "GUIWebsocketServer is shutting down the WebSocket server on "
-               "ws://localhost:"
-            << mPort << std::endl;
-  assert(mServer != nullptr);
-  mServer->stop();
-  assert(mServerThread != nullptr);
-  mServerThread->join();
-  delete mServer;
-  delete mServerThread;
-  assert(mFlushThread != nullptr);
-  mFlushThread->join();
-  delete mFlushThread;
-  mServer = nullptr;
-  mServerThread = nullptr;
-  mServingConditionValue.notify_all();
-  mFlushThread = nullptr;
-}
-
-/// Returns true if we're serving
-bool GUIWebsocketServer::isServing()
-{
-  return mServing;
-}
-
-/// This flushes at a fixed framerate, not too fast to overwhelm the web GUI
-void GUIWebsocketServer::flushThread()
-{
-  while (mServing)
-  {
-    flush();
-    // limit to sending updates at 50fps
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-  }
-}
-
-/// This sleeps until we're done serving, without busy-waiting in a loop. It
-/// wakes up occassionally to call the `checkForSignals` callback, where you
-/// can throw an exception to shut down the program.
-void GUIWebsocketServer::blockWhileServing(
-    std::function<void()> checkForSignals)
-{
-  std::unique_lock<std::mutex> lock(this->mServingMutex);
-  if (!mServing && !mStartingServer)
-    return;
-  while (true)
-  {
-    if (mServingConditionValue.wait_for(
-            lock, std::chrono::milliseconds(1000), [&]() {
-              return !mServing && !mStartingServer;
-            }))
-    {
-      // Our condition was met!
-      return;
-    }
-    else
-    {
-      // Wake up and check for signals
-      checkForSignals();
-    }
-  }
-}
-
-/// This adds a listener that will get called when someone connects to the
-/// server
-void GUIWebsocketServer::registerConnectionListener(
-    std::function<void()> listener)
-{
-  mConnectionListeners.push_back(listener);
-}
-
-/// This adds a listener that will get called when ctrl+C is pressed
-void GUIWebsocketServer::registerShutdownListener(
-    std::function<void()> listener)
-{
-  mShutdownListeners.push_back(listener);
-}
-
-/// This adds a listener that will get called when there is a key-down event
-/// on the web client
-void GUIWebsocketServer::registerKeydownListener(
-    std::function<void(std::string)> listener)
-{
-  mKeydownListeners.push_back(listener);
-}
-
-/// This adds a listener that will get called when there is a key-up event
-/// on the web client
-void GUIWebsocketServer::registerKeyupListener(
-    std::function<void(std::string)> listener)
-{
-  mKeyupListeners.push_back(listener);
-}
-
-/// Gets the set of all the keys currently being pressed
-const std::unordered_set<std::string>& GUIWebsocketServer::getKeysDown() const
-{
-  return mKeysDown;
-}
-
-/// Returns true if a key is currently being pressed
-bool GUIWebsocketServer::isKeyDown(const std::string& key) const
-{
-  return mKeysDown.find(key) != mKeysDown.end();
-}
-
-/// This sends the current list of commands to the web GUI
-void GUIWebsocketServer::flush()
-{
-  if (mServing && mMessagesQueued > 0)
-  {
-    std::string json = flushJson();
-    try
-    {
-      mServer->broadcast(base64_encode(json));
-    }
-    catch (...)
-    {
-      dterr << "GUIWebsocketServer caught an error broadcasting message \""
-            << json << "\"" << std::endl;
-    }
-  }
-}
-
-/// This completely resets the web GUI, deleting all objects, UI elements, and
-/// listeners
-void GUIWebsocketServer::clear()
-{
-  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-  GUIStateMachine::clear();
-  mScreenResizeListeners.clear();
-  mKeydownListeners.clear();
-  mShutdownListeners.clear();
-}
-
-/// This enables mouse events on an object (if they're not already), and calls
-/// "listener" whenever the object is dragged with the desired drag
-/// coordinates
-GUIWebsocketServer& GUIWebsocketServer::registerDragListener(
-    const std::string& key,
-    std::function<void(Eigen::Vector3s)> listener,
-    std::function<void()> endDrag)
-{
-  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-  setObjectDragEnabled(key);
-  mDragListeners[key].push_back(listener);
-  mDragEndListeners[key].push_back(endDrag);
-  return *this;
-}
-
-/// This enables the user to edit the tooltip on an object, and calls this
-/// listener when the tooltip changes.
-GUIWebsocketServer& GUIWebsocketServer::registerTooltipChangeListener(
-    const std::string& key, std::function<void(std::string)> listener)
-{
-  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-  setObjectTooltipEditable(key);
-  mTooltipChangeListeners[key].push_back(listener);
-  return *this;
-}
-
-/// This gets the current screen size
-Eigen::Vector2i GUIWebsocketServer::getScreenSize()
-{
-  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-  return mScreenSize;
-}
-
-/// This registers a callback to get called whenever the screen size changes.
-void GUIWebsocketServer::registerScreenResizeListener(
-    std::function<void(Eigen::Vector2i)> listener)
-{
-  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
-
-  mScreenResizeListeners.push_back(listener);
-}
-
-} // namespace server
+#include "dart/server/GUIWebsocketServer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include <assimp/scene.h>
+#include <boost/filesystem.hpp>
+
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/common/Aspect.hpp"
+#include "dart/constraint/ConstraintSolver.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/MeshShape.hpp"
+#include "dart/dynamics/ShapeFrame.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Geometry.hpp"
+#include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/performance/SamplingProfiler.hpp"
+#include "dart/server/RawJsonUtils.hpp"
+#include "dart/server/external/base64/base64.h"
+#include "dart/simulation/World.hpp"
+
+namespace dart {
+namespace server {
+
+GUIWebsocketServer::GUIWebsocketServer()
+  : mPort(-1),
+    mMaxBufferedBytes(16 * 1024 * 1024),
+    mServing(false),
+    mStartingServer(false),
+    mScreenSize(Eigen::Vector2i(680, 420)),
+    mServer(nullptr),
+    mPath("/"),
+    mHost(nullptr)
+{
+}
+
+GUIWebsocketServer::~GUIWebsocketServer()
+{
+  // Hosted scenes may outlive us, so they can't keep pointing back here
+  for (std::string path : getScenePaths())
+  {
+    stopServingScene(path);
+  }
+  {
+    const std::unique_lock<std::mutex> lock(this->mServingMutex);
+    if (!mServing)
+      return;
+  }
+  dterr << "GUIWebsocketServer is being deallocated while it's still "
+           "serving! The server will now terminate, and attempt to clean up. "
+           "If this was not intended "
+           "behavior, please keep a reference to the GUIWebsocketServer to "
+           "keep the server alive. If this was intended behavior, please "
+           "call "
+           "stopServing() on "
+           "the server before deallocating it."
+        << std::endl;
+  stopServing();
+}
+
+/// This is a non-blocking call to start a websocket server on a given port
+void GUIWebsocketServer::serve(int port)
+{
+  mPort = port;
+  // Register signal and signal handler
+  {
+    const std::unique_lock<std::mutex> lock(this->mServingMutex);
+    if (mServing || mStartingServer || mHost != nullptr)
+    {
+      std::cout << "Errer in GUIWebsocketServer::serve()! Already serving. "
+                   "Ignoring request."
+                << std::endl;
+      return;
+    }
+    // We're not serving yet, but we are starting the server
+    mServing = false;
+    mStartingServer = true;
+  }
+  mServer = new WebsocketServer();
+  mServer->setMaxBufferedBytes(mMaxBufferedBytes);
+
+  // Register our network callbacks, ensuring the logic is run on the main
+  // thread's event loop. Each client's events go to the scene hosted on its
+  // path, or to us if there isn't one.
+  mServer->connect([this](ClientConnection conn) {
+    std::shared_ptr<GUIWebsocketServer> scene
+        = getScene(mServer->getPath(conn));
+    if (!scene)
+    {
+      // Treat any path we don't host as ours, so we only broadcast to one path
+      mServer->setPath(conn, mPath);
+    }
+    (scene ? scene.get() : this)->handleConnect(mServer, conn);
+  });
+  mServer->disconnect([this](ClientConnection conn) {
+    std::shared_ptr<GUIWebsocketServer> scene
+        = getScene(mServer->getPath(conn));
+    (scene ? scene.get() : this)->handleDisconnect(mServer, conn);
+  });
+  mServer->message([this](ClientConnection conn, const Json::Value& args) {
+    std::shared_ptr<GUIWebsocketServer> scene
+        = getScene(mServer->getPath(conn));
+    (scene ? scene.get() : this)->handleMessage(mServer, conn, args);
+  });
+
+  // unblock signals in this thread
+  sigset_t sigset;
+  sigemptyset(&sigset);
+  sigaddset(&sigset, SIGINT);
+  sigaddset(&sigset, SIGTERM);
+  pthread_sigmask(SIG_UNBLOCK, &sigset, nullptr);
+
+  /*
+  // The signal set is used to register termination notifications
+  mSignalSet = new asio::signal_set(mServerEventLoop, SIGINT, SIGTERM);
+  // register the handle_stop callback
+  mSignalSet->async_wait([&](asio::error_code const& error, int signal_number) {
+    if (error == asio::error::operation_aborted)
+    {
+      std::cout << "Signal listener was terminated by asio" << std::endl;
+    }
+    else if (error)
+    {
+      std::cout << "Got an error registering termination signals: " << error
+                << std::endl;
+    }
+    else if (
+        signal_number == SIGINT || signal_number == SIGTERM
+        || signal_number == SIGQUIT)
+    {
+      std::cout << "Shutting down the server..." << std::endl;
+      stopServing();
+      mServerEventLoop.stop();
+      exit(signal_number);
+    }
+  });
+  */
+
+  // Start the networking thread
+  mServerThread = new std::thread([this, port]() {
+    /*
+    // block signals in this thread and subsequently
+    // spawned threads so they're guaranteed to go to the main thread
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
+    */
+
+    std::cout << "GUIWebsocketServer will start serving a WebSocket server on "
+                 "ws://localhost:"
+              << port << std::endl;
+
+    // Note that we've started, but do it from within the server's event loop
+    // once the server has _actually_ started.
+    mServer->eventLoop.post([&]() {
+      {
+        const std::unique_lock<std::mutex> lock(this->mServingMutex);
+        mStartingServer = false;
+        mServing = true;
+        mServingConditionValue.notify_all();
+      }
+      {
+        const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+        for (auto& pair : mScenes)
+        {
+          pair.second->setHostedState(mServer, true);
+        }
+      }
+
+      // Start the flush thread
+      mFlushThread = new std::thread([this]() { this->flushThread(); });
+    });
+
+    bool success = mServer->run(port);
+    if (!success)
+    {
+      // This means we failed to bind to the port
+      stopServing();
+    }
+  });
+}
+
+/// This kills the server, if one was running
+void GUIWebsocketServer::stopServing()
+{
+  if (mHost != nullptr)
+  {
+    mHost->stopServingScene(mPath);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(this->mServingMutex);
+    if (mStartingServer)
+    {
+      std::cout << "GUIWebsocketServer called stopServing() while we're in the "
+                   "middle of booting "
+                   "the server. Waiting until booting finished..."
+                << std::endl;
+      mServingConditionValue.wait(lock, [&]() { return !mStartingServer; });
+      std::cout << "GUIWebsocketServer finished booting server, will now "
+                   "resume stopServing()."
+                << std::endl;
+    }
+    if (!mServing)
+      return;
+    mServing = false;
+  }
+  {
+    // Our scenes stay hosted, and start serving again if we do
+    const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+    for (auto& pair : mScenes)
+    {
+      pair.second->setHostedState(nullptr, false);
+    }
+  }
+  std::cout << "GUIWebsocketServer is shutting down the WebSocket server on "
+               "ws://localhost:"
+            << mPort << std::endl;
+  assert(mServer != nullptr);
+  mServer->stop();
+  assert(mServerThread != nullptr);
+  mServerThread->join();
+  delete mServer;
+  delete mServerThread;
+  assert(mFlushThread != nullptr);
+  mFlushThread->join();
+  delete mFlushThread;
+  mServer = nullptr;
+  mServerThread = nullptr;
+  mServingConditionValue.notify_all();
+  mFlushThread = nullptr;
+}
+
+/// Returns true if we're serving
+bool GUIWebsocketServer::isServing()
+{
+  return mServing;
+}
+
+/// This serves `scene` to clients that connect on the URL path `path`,
+/// through this server's port
+void GUIWebsocketServer::serveScene(
+    const std::string& path, std::shared_ptr<GUIWebsocketServer> scene)
+{
+  if (path.empty() || path[0] != '/' || path == mPath || scene.get() == this)
+  {
+    dterr << "GUIWebsocketServer::serveScene() can't serve a scene on path \""
+          << path << "\". Paths must start with a \"/\", and can't be \""
+          << mPath << "\". Ignoring request." << std::endl;
+    return;
+  }
+  {
+    const std::unique_lock<std::mutex> lock(scene->mServingMutex);
+    if (scene->mServing || scene->mStartingServer || scene->mHost != nullptr)
+    {
+      dterr << "GUIWebsocketServer::serveScene() was passed a scene that's "
+               "already serving. Ignoring request."
+            << std::endl;
+      return;
+    }
+  }
+  stopServingScene(path);
+
+  bool serving;
+  {
+    const std::unique_lock<std::mutex> lock(this->mServingMutex);
+    serving = mServing;
+  }
+  const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+  scene->mHost = this;
+  scene->mPath = path;
+  scene->setHostedState(mServer, serving);
+  mScenes[path] = scene;
+}
+
+/// This stops serving the scene on `path`
+void GUIWebsocketServer::stopServingScene(const std::string& path)
+{
+  std::shared_ptr<GUIWebsocketServer> scene;
+  {
+    const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+    auto it = mScenes.find(path);
+    if (it == mScenes.end())
+      return;
+    scene = it->second;
+    mScenes.erase(it);
+  }
+  scene->setHostedState(nullptr, false);
+  scene->mHost = nullptr;
+  scene->mPath = "/";
+}
+
+/// This returns the paths of all the scenes this server is hosting
+std::vector<std::string> GUIWebsocketServer::getScenePaths()
+{
+  const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+  std::vector<std::string> paths;
+  for (auto& pair : mScenes)
+  {
+    paths.push_back(pair.first);
+  }
+  return paths;
+}
+
+/// This returns the scene hosted on `path`, or nullptr if there isn't one
+std::shared_ptr<GUIWebsocketServer> GUIWebsocketServer::getScene(
+    const std::string& path)
+{
+  const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+  auto it = mScenes.find(path);
+  if (it == mScenes.end())
+    return nullptr;
+  return it->second;
+}
+
+/// This is called on a hosted scene whenever its host starts or stops serving
+void GUIWebsocketServer::setHostedState(WebsocketServer* server, bool serving)
+{
+  const std::unique_lock<std::mutex> lock(this->mServingMutex);
+  mServer = server;
+  mServing = serving;
+  mServingConditionValue.notify_all();
+}
+
+/// This handles a client connecting on our path
+void GUIWebsocketServer::handleConnect(
+    WebsocketServer* server, ClientConnection conn)
+{
+  // Snapshot the current state under the globalMutex, but send it without
+  // holding the lock, so threads queueing render commands never wait on a
+  // slow client
+  std::string jsonStr;
+  {
+    const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+    jsonStr = getCurrentStateAsJson();
+  }
+
+  // The new client hasn't told us whether it can read packed transforms
+  // yet, so fall back to the per-object commands until it does
+  setPackedTransformsEnabled(false);
+
+  // Send a hello message to the client
+  // mServer->send(conn) seems to break, cause conn appears to get cleaned
+  // up in race conditions (it's a weak pointer)
+  try
+  {
+    server->send(conn, base64_encode(jsonStr));
+  }
+  catch (...)
+  {
+    dterr << "GUIWebsocketServer caught an error broadcasting message \""
+          << jsonStr << "\"" << std::endl;
+  }
+
+  // Don't hold the globalMutex when calling connection listeners, because
+  // that can lead to deadlocks if the connection listeners call out to Python
+  // (which tries to grab the GIL) while other Python code (holding the GIL)
+  // tries to grab the globalMutex.
+
+  for (auto listener : mConnectionListeners)
+  {
+    listener();
+  }
+}
+
+/// This handles a client disconnecting from our path
+void GUIWebsocketServer::handleDisconnect(
+    WebsocketServer* server, ClientConnection /* conn */)
+{
+  std::clog << "Connection closed." << std::endl;
+  std::clog << "There are now " << server->numConnections(mPath)
+            << " open connections." << std::endl;
+  setPackedTransformsEnabled(server->allClientsAcceptBinary(mPath));
+}
+
+/// This handles a message from a client on our path
+void GUIWebsocketServer::handleMessage(
+    WebsocketServer* server, ClientConnection conn, const Json::Value& args)
+{
+  if (args["type"].asString() == "client_capabilities")
+  {
+    // Clients that can decode raw proto frames get binary websocket frames
+    // and packed transform updates, instead of base64 text
+    server->setAcceptsBinary(conn, args["binary"].asBool());
+    setPackedTransformsEnabled(server->allClientsAcceptBinary(mPath));
+  }
+  else if (args["type"].asString() == "keydown")
+  {
+    std::string key = args["key"].asString();
+    {
+      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+      this->mKeysDown.insert(key);
+    }
+    for (auto listener : this->mKeydownListeners)
+    {
+      listener(key);
+    }
+  }
+  else if (args["type"].asString() == "keyup")
+  {
+    std::string key = args["key"].asString();
+    {
+      const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+      this->mKeysDown.erase(key);
+    }
+    for (auto listener : this->mKeyupListeners)
+    {
+      listener(key);
+    }
+  }
+  else if (args["type"].asString() == "button_click")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    if (mButtons.find(key) != mButtons.end())
+    {
+      mButtons[key].onClick();
+    }
+  }
+  else if (args["type"].asString() == "slider_set_value")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    s_t value = static_cast<s_t>(args["value"].asDouble());
+    if (mSliders.find(key) != mSliders.end())
+    {
+      mSliders[key].value = value;
+      mSliders[key].onChange(value);
+    }
+  }
+  else if (args["type"].asString() == "screen_resize")
+  {
+    Eigen::Vector2i size
+        = Eigen::Vector2i(args["size"][0].asInt(), args["size"][1].asInt());
+    mScreenSize = size;
+
+    for (auto handler : mScreenResizeListeners)
+    {
+      handler(size);
+    }
+  }
+  else if (args["type"].asString() == "drag")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    Eigen::Vector3s pos = Eigen::Vector3s(
+        static_cast<s_t>(args["pos"][0].asDouble()),
+        static_cast<s_t>(args["pos"][1].asDouble()),
+        static_cast<s_t>(args["pos"][2].asDouble()));
+
+    for (auto handler : mDragListeners[key])
+    {
+      handler(pos);
+    }
+  }
+  else if (args["type"].asString() == "drag_end")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    for (auto handler : mDragEndListeners[key])
+    {
+      handler();
+    }
+  }
+  else if (args["type"].asString() == "mesh_screen_size")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    setMeshScreenSize(key, static_cast<s_t>(args["pixels"].asDouble()));
+  }
+  else if (args["type"].asString() == "edit_tooltip")
+  {
+    std::string key = this->getCodeString(args["key"].asInt());
+    std::string tooltip = args["tooltip"].asString();
+
+    for (auto handler : mTooltipChangeListeners[key])
+    {
+      handler(tooltip);
+    }
+  }
+  else if (args["type"].asString() == "start_profiler")
+  {
+    int frequency = args.isMember("frequency") ? args["frequency"].asInt() : 99;
+    performance::SamplingProfiler::clear();
+    performance::SamplingProfiler::start(frequency);
+  }
+  else if (args["type"].asString() == "stop_profiler")
+  {
+    performance::SamplingProfiler::stop();
+    Json::Value profile;
+    profile["folded"] = performance::SamplingProfiler::getFoldedStacks();
+    profile["samples"] = static_cast<Json::UInt64>(
+        performance::SamplingProfiler::getNumSamples());
+    profile["dropped"] = static_cast<Json::UInt64>(
+        performance::SamplingProfiler::getNumDroppedSamples());
+    server->sendJsonObject(conn, "profile", profile);
+  }
+}
+
+/// This flushes at a fixed framerate, not too fast to overwhelm the web GUI
+void GUIWebsocketServer::flushThread()
+{
+  while (mServing)
+  {
+    flush();
+    std::vector<std::shared_ptr<GUIWebsocketServer>> scenes;
+    {
+      const std::lock_guard<std::mutex> lock(this->mScenesMutex);
+      for (auto& pair : mScenes)
+      {
+        scenes.push_back(pair.second);
+      }
+    }
+    for (auto& scene : scenes)
+    {
+      scene->flush();
+    }
+    // limit to sending updates at 50fps
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+}
+
+/// This sleeps until we're done serving, without busy-waiting in a loop. It
+/// wakes up occassionally to call the `checkForSignals` callback, where you
+/// can throw an exception to shut down the program.
+void GUIWebsocketServer::blockWhileServing(
+    std::function<void()> checkForSignals)
+{
+  std::unique_lock<std::mutex> lock(this->mServingMutex);
+  if (!mServing && !mStartingServer)
+    return;
+  while (true)
+  {
+    if (mServingConditionValue.wait_for(
+            lock, std::chrono::milliseconds(1000), [&]() {
+              return !mServing && !mStartingServer;
+            }))
+    {
+      // Our condition was met!
+      return;
+    }
+    else
+    {
+      // Wake up and check for signals
+      checkForSignals();
+    }
+  }
+}
+
+/// This adds a listener that will get called when someone connects to the
+/// server
+void GUIWebsocketServer::registerConnectionListener(
+    std::function<void()> listener)
+{
+  mConnectionListeners.push_back(listener);
+}
+
+/// This adds a listener that will get called when ctrl+C is pressed
+void GUIWebsocketServer::registerShutdownListener(
+    std::function<void()> listener)
+{
+  mShutdownListeners.push_back(listener);
+}
+
+/// This adds a listener that will get called when there is a key-down event
+/// on the web client
+void GUIWebsocketServer::registerKeydownListener(
+    std::function<void(std::string)> listener)
+{
+  mKeydownListeners.push_back(listener);
+}
+
+/// This adds a listener that will get called when there is a key-up event
+/// on the web client
+void GUIWebsocketServer::registerKeyupListener(
+    std::function<void(std::string)> listener)
+{
+  mKeyupListeners.push_back(listener);
+}
+
+/// Gets the set of all the keys currently being pressed
+const std::unordered_set<std::string>& GUIWebsocketServer::getKeysDown() const
+{
+  return mKeysDown;
+}
+
+/// Returns true if a key is currently being pressed
+bool GUIWebsocketServer::isKeyDown(const std::string& key) const
+{
+  return mKeysDown.find(key) != mKeysDown.end();
+}
+
+/// This sends the current list of commands to the web GUI
+void GUIWebsocketServer::flush()
+{
+  if (mServing && mMessagesQueued > 0)
+  {
+    std::string json = flushJson();
+    try
+    {
+      mServer->broadcastBinary(
+          json,
+          [](const std::string& data) { return base64_encode(data); },
+          [this]() {
+            // Concatenated protos merge, so this is a ClearAll followed by
+            // the full current state
+            proto::CommandList clearList;
+            clearList.add_command()->mutable_clear_all()->set_dummy(true);
+            const std::lock_guard<std::recursive_mutex> lock(
+                this->globalMutex);
+            return clearList.SerializeAsString() + getCurrentStateAsJson();
+          },
+          mPath);
+    }
+    catch (...)
+    {
+      dterr << "GUIWebsocketServer caught an error broadcasting message \""
+            << json << "\"" << std::endl;
+    }
+  }
+}
+
+/// This sets how many bytes can be queued up for a single client before we
+/// start dropping frames for it
+void GUIWebsocketServer::setMaxBufferedBytesPerClient(size_t maxBufferedBytes)
+{
+  mMaxBufferedBytes = maxBufferedBytes;
+  // Hosted scenes share their host's limit
+  if (mServer != nullptr && mHost == nullptr)
+  {
+    mServer->setMaxBufferedBytes(maxBufferedBytes);
+  }
+}
+
+/// This returns the outbound queue stats for each connected client
+std::vector<WebsocketServer::ConnectionStats>
+GUIWebsocketServer::getConnectionStats()
+{
+  if (mServer == nullptr)
+  {
+    return std::vector<WebsocketServer::ConnectionStats>();
+  }
+  return mServer->getConnectionStats(mPath);
+}
+
+/// This completely resets the web GUI, deleting all objects, UI elements, and
+/// listeners
+void GUIWebsocketServer::clear()
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  GUIStateMachine::clear();
+  mScreenResizeListeners.clear();
+  mKeydownListeners.clear();
+  mShutdownListeners.clear();
+}
+
+/// This enables mouse events on an object (if they're not already), and calls
+/// "listener" whenever the object is dragged with the desired drag
+/// coordinates
+GUIWebsocketServer& GUIWebsocketServer::registerDragListener(
+    const std::string& key,
+    std::function<void(Eigen::Vector3s)> listener,
+    std::function<void()> endDrag)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  setObjectDragEnabled(key);
+  mDragListeners[key].push_back(listener);
+  mDragEndListeners[key].push_back(endDrag);
+  return *this;
+}
+
+/// This enables the user to edit the tooltip on an object, and calls this
+/// listener when the tooltip changes.
+GUIWebsocketServer& GUIWebsocketServer::registerTooltipChangeListener(
+    const std::string& key, std::function<void(std::string)> listener)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  setObjectTooltipEditable(key);
+  mTooltipChangeListeners[key].push_back(listener);
+  return *this;
+}
+
+/// This gets the current screen size
+Eigen::Vector2i GUIWebsocketServer::getScreenSize()
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  return mScreenSize;
+}
+
+/// This registers a callback to get called whenever the screen size changes.
+void GUIWebsocketServer::registerScreenResizeListener(
+    std::function<void(Eigen::Vector2i)> listener)
+{
+  const std::lock_guard<std::recursive_mutex> lock(this->globalMutex);
+
+  mScreenResizeListeners.push_back(listener);
+}
+
+} // namespace server
 } // namespace dart
\ No newline at end of file
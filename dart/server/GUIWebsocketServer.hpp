@@ -3,6 +3,7 @@
 
 #include <condition_variable>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -56,7 +57,28 @@ public:
   /// Returns true if we're serving
   bool isServing();
 
-  /// This flushes at a fixed framerate, not too fast to overwhelm the web GUI
+  /// This serves `scene` to clients that connect on the URL path `path` (for
+  /// example "/subject12"), through this server's port. Every hosted scene
+  /// shares this server's socket, event loop thread and flush thread, so
+  /// serving more scenes doesn't cost any more threads or sockets. Clients on
+  /// any other path get this server's own scene.
+  ///
+  /// `scene` must not be serving on its own port. It counts as serving
+  /// whenever this server is, and this keeps a reference to it until
+  /// stopServingScene() is called (or `scene->stopServing()`, which does the
+  /// same thing). Scenes can be added and removed while serving.
+  void serveScene(
+      const std::string& path, std::shared_ptr<GUIWebsocketServer> scene);
+
+  /// This stops serving the scene on `path`. Clients still connected on that
+  /// path stop getting updates.
+  void stopServingScene(const std::string& path);
+
+  /// This returns the paths of all the scenes this server is hosting
+  std::vector<std::string> getScenePaths();
+
+  /// This flushes at a fixed framerate, not too fast to overwhelm the web GUI.
+  /// That includes every scene we're hosting.
   void flushThread();
 
   /// This sleeps until we're done serving, without busy-waiting in a loop. It
@@ -88,6 +110,17 @@ public:
   /// This sends the current list of commands to the web GUI
   void flush();
 
+  /// This sets how many bytes can be queued up waiting to be sent to a single
+  /// client before we start dropping frames for it. A client that falls
+  /// behind gets a full copy of the latest state once it catches up, instead
+  /// of the frames it missed. 0 means unlimited. Defaults to 16MB. Hosted
+  /// scenes (see serveScene()) use their host's limit.
+  void setMaxBufferedBytesPerClient(size_t maxBufferedBytes);
+
+  /// This returns the outbound queue depth and dropped frame count for each
+  /// connected client
+  std::vector<WebsocketServer::ConnectionStats> getConnectionStats();
+
   /// This completely resets the web GUI, deleting all objects, UI elements, and
   /// listeners
   void clear() override;
@@ -114,7 +147,27 @@ public:
       std::function<void(Eigen::Vector2i)> listener);
 
 protected:
+  /// These handle client events for this scene. When we're serving, the
+  /// server routes each client's events to the scene for its path.
+  ///
+  /// Besides GUI events, clients can profile the process we're in: a
+  /// "start_profiler" message (with an optional "frequency" in Hz) clears and
+  /// starts the SamplingProfiler, and "stop_profiler" stops it and replies
+  /// with a "profile" message holding the folded stacks.
+  void handleConnect(WebsocketServer* server, ClientConnection conn);
+  void handleDisconnect(WebsocketServer* server, ClientConnection conn);
+  void handleMessage(
+      WebsocketServer* server, ClientConnection conn, const Json::Value& args);
+
+  /// This returns the scene hosted on `path`, or nullptr if there isn't one
+  std::shared_ptr<GUIWebsocketServer> getScene(const std::string& path);
+
+  /// This is called on a hosted scene whenever its host starts or stops
+  /// serving, to share (or drop) the host's server
+  void setHostedState(WebsocketServer* server, bool serving);
+
   int mPort;
+  size_t mMaxBufferedBytes;
   bool mServing;
   bool mStartingServer;
   Eigen::Vector2i mScreenSize;
@@ -125,6 +178,15 @@ protected:
   std::mutex mServingMutex;
   std::condition_variable mServingConditionValue;
 
+  /// The path our clients are connected on. This is "/" unless we're a scene
+  /// hosted by another server.
+  std::string mPath;
+  /// The server hosting us, if we're a hosted scene
+  GUIWebsocketServer* mHost;
+  /// The scenes we're hosting, by path
+  std::map<std::string, std::shared_ptr<GUIWebsocketServer>> mScenes;
+  std::mutex mScenesMutex;
+
   // Listeners
   std::vector<std::function<void()>> mConnectionListeners;
   std::vector<std::function<void()>> mShutdownListeners;
@@ -0,0 +1,207 @@
+#include "dart/server/MeshDecimation.hpp"
+
+#include <functional>
+#include <queue>
+
+namespace dart {
+namespace server {
+
+namespace {
+
+/// A candidate collapse of `from` into `to`. The versions are those of the two
+/// vertices when we computed the cost, so we can tell when it's gone stale.
+struct Collapse
+{
+  s_t cost;
+  int from;
+  int to;
+  int fromVersion;
+  int toVersion;
+
+  bool operator>(const Collapse& other) const
+  {
+    return cost > other.cost;
+  }
+};
+
+} // namespace
+
+//==============================================================================
+void decimateMesh(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3i>& faces,
+    int targetNumFaces,
+    std::vector<Eigen::Vector3i>& decimatedFaces,
+    std::vector<int>& vertexSources)
+{
+  const int numVertices = vertices.size();
+  std::vector<Eigen::Vector3i> currentFaces = faces;
+  std::vector<bool> faceAlive(faces.size(), true);
+  std::vector<bool> vertexAlive(numVertices, true);
+  std::vector<int> versions(numVertices, 0);
+  std::vector<std::vector<int>> vertexFaces(numVertices);
+  std::vector<Eigen::Matrix4s> quadrics(numVertices, Eigen::Matrix4s::Zero());
+
+  // Every vertex starts with the sum of the squared distances to the planes of
+  // its faces, weighted by their area
+  int numFaces = 0;
+  for (std::size_t i = 0; i < faces.size(); i++)
+  {
+    const Eigen::Vector3i& face = faces[i];
+    if ((face.array() < 0).any() || (face.array() >= numVertices).any())
+    {
+      faceAlive[i] = false;
+      continue;
+    }
+    numFaces++;
+    for (int j = 0; j < 3; j++)
+      vertexFaces[face(j)].push_back(i);
+
+    Eigen::Vector3s normal = (vertices[face(1)] - vertices[face(0)])
+                                 .cross(vertices[face(2)] - vertices[face(0)]);
+    const s_t doubleArea = normal.norm();
+    if (doubleArea == 0)
+      continue;
+    normal /= doubleArea;
+    Eigen::Vector4s plane;
+    plane.head<3>() = normal;
+    plane(3) = -normal.dot(vertices[face(0)]);
+    const Eigen::Matrix4s quadric
+        = 0.5 * doubleArea * plane * plane.transpose();
+    for (int j = 0; j < 3; j++)
+      quadrics[face(j)] += quadric;
+  }
+
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>
+      queue;
+  auto pushCollapse = [&](int from, int to) {
+    Eigen::Vector4s position;
+    position.head<3>() = vertices[to];
+    position(3) = 1;
+    const s_t cost = position.dot((quadrics[from] + quadrics[to]) * position);
+    queue.push(Collapse{cost, from, to, versions[from], versions[to]});
+  };
+  for (std::size_t i = 0; i < faces.size(); i++)
+  {
+    if (!faceAlive[i])
+      continue;
+    for (int j = 0; j < 3; j++)
+    {
+      pushCollapse(faces[i](j), faces[i]((j + 1) % 3));
+      pushCollapse(faces[i]((j + 1) % 3), faces[i](j));
+    }
+  }
+
+  while (numFaces > targetNumFaces && !queue.empty())
+  {
+    const Collapse collapse = queue.top();
+    queue.pop();
+    const int from = collapse.from;
+    const int to = collapse.to;
+    if (!vertexAlive[from] || !vertexAlive[to]
+        || versions[from] != collapse.fromVersion
+        || versions[to] != collapse.toVersion)
+    {
+      continue;
+    }
+
+    // Earlier collapses can separate the two ends, and we only collapse edges
+    // that still exist, and that don't turn any face over
+    bool adjacent = false;
+    bool flips = false;
+    for (int faceIndex : vertexFaces[from])
+    {
+      if (!faceAlive[faceIndex])
+        continue;
+      const Eigen::Vector3i& face = currentFaces[faceIndex];
+      if ((face.array() == to).any())
+      {
+        adjacent = true;
+        continue;
+      }
+      Eigen::Vector3s corners[3];
+      for (int j = 0; j < 3; j++)
+        corners[j] = vertices[face(j)];
+      const Eigen::Vector3s before
+          = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+      for (int j = 0; j < 3; j++)
+      {
+        if (face(j) == from)
+          corners[j] = vertices[to];
+      }
+      const Eigen::Vector3s after
+          = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+      if (before.dot(after) <= 0)
+      {
+        flips = true;
+        break;
+      }
+    }
+    if (!adjacent || flips)
+      continue;
+
+    // Faces along the edge disappear, and the rest move over to `to`
+    for (int faceIndex : vertexFaces[from])
+    {
+      if (!faceAlive[faceIndex])
+        continue;
+      Eigen::Vector3i& face = currentFaces[faceIndex];
+      if ((face.array() == to).any())
+      {
+        faceAlive[faceIndex] = false;
+        numFaces--;
+        continue;
+      }
+      for (int j = 0; j < 3; j++)
+      {
+        if (face(j) == from)
+          face(j) = to;
+      }
+      vertexFaces[to].push_back(faceIndex);
+    }
+    vertexAlive[from] = false;
+    vertexFaces[from].clear();
+    quadrics[to] += quadrics[from];
+    versions[to]++;
+
+    // Every edge touching `to` has a new cost now
+    for (int faceIndex : vertexFaces[to])
+    {
+      if (!faceAlive[faceIndex])
+        continue;
+      for (int j = 0; j < 3; j++)
+      {
+        const int neighbor = currentFaces[faceIndex](j);
+        if (neighbor == to)
+          continue;
+        pushCollapse(to, neighbor);
+        pushCollapse(neighbor, to);
+      }
+    }
+  }
+
+  // Compact the vertices that are still in use
+  decimatedFaces.clear();
+  vertexSources.clear();
+  std::vector<int> newIndices(numVertices, -1);
+  for (std::size_t i = 0; i < currentFaces.size(); i++)
+  {
+    if (!faceAlive[i])
+      continue;
+    Eigen::Vector3i face;
+    for (int j = 0; j < 3; j++)
+    {
+      int& newIndex = newIndices[currentFaces[i](j)];
+      if (newIndex == -1)
+      {
+        newIndex = vertexSources.size();
+        vertexSources.push_back(currentFaces[i](j));
+      }
+      face(j) = newIndex;
+    }
+    decimatedFaces.push_back(face);
+  }
+}
+
+} // namespace server
+} // namespace dart
@@ -0,0 +1,33 @@
+#ifndef DART_SERVER_MESH_DECIMATION_HPP_
+#define DART_SERVER_MESH_DECIMATION_HPP_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/math/MathTypes.hpp"
+
+namespace dart {
+namespace server {
+
+/// This simplifies a triangle mesh down to about `targetNumFaces` faces, by
+/// repeatedly collapsing whichever edge adds the least quadric error (Garland
+/// and Heckbert, 1997). Each collapse merges one end of an edge into the
+/// other, so every vertex that survives is one of the originals.
+///
+/// `decimatedFaces` index into the surviving vertices, and `vertexSources`
+/// gives the index in `vertices` of each of those, so callers can carry
+/// normals or other per-vertex data across. Collapses that would flip a face
+/// over are skipped, so if nothing else is safe to collapse we stop short of
+/// the target.
+void decimateMesh(
+    const std::vector<Eigen::Vector3s>& vertices,
+    const std::vector<Eigen::Vector3i>& faces,
+    int targetNumFaces,
+    std::vector<Eigen::Vector3i>& decimatedFaces,
+    std::vector<int>& vertexSources);
+
+} // namespace server
+} // namespace dart
+
+#endif
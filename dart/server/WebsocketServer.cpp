@@ -29,7 +29,8 @@ string WebsocketServer::stringifyJson(const Json::Value& val)
   return Json::writeString(wbuilder, val);
 }
 
-WebsocketServer::WebsocketServer() : mRunning(false)
+WebsocketServer::WebsocketServer()
+  : mRunning(false), maxBufferedBytes(16 * 1024 * 1024)
 {
   // Wire up our event handlers
   this->endpoint.set_open_handler(
@@ -102,13 +103,38 @@ void WebsocketServer::stop()
   this->endpoint.stop();
 }
 
-size_t WebsocketServer::numConnections()
+size_t WebsocketServer::numConnections(const string& path)
 {
   // Prevent concurrent access to the list of open connections from multiple
   // threads
   std::lock_guard<std::mutex> lock(this->connectionListMutex);
 
-  return this->openConnections.size();
+  if (path.empty())
+    return this->openConnections.size();
+  size_t count = 0;
+  for (auto conn : this->openConnections)
+  {
+    if (this->connectionStates[conn].path == path)
+      count++;
+  }
+  return count;
+}
+
+string WebsocketServer::getPath(ClientConnection conn)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  auto it = this->connectionStates.find(conn);
+  if (it == this->connectionStates.end())
+    return "";
+  return it->second.path;
+}
+
+void WebsocketServer::setPath(ClientConnection conn, const string& path)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  this->connectionStates[conn].path = path;
 }
 
 void WebsocketServer::sendJsonObject(
@@ -174,6 +200,149 @@ void WebsocketServer::broadcast(const string& message)
   }
 }
 
+void WebsocketServer::setAcceptsBinary(
+    ClientConnection conn, bool acceptsBinary)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  this->connectionStates[conn].acceptsBinary = acceptsBinary;
+}
+
+bool WebsocketServer::allClientsAcceptBinary(const string& path)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  bool anyClients = false;
+  for (auto conn : this->openConnections)
+  {
+    const ConnectionState& state = this->connectionStates[conn];
+    if (!path.empty() && state.path != path)
+      continue;
+    if (!state.acceptsBinary)
+      return false;
+    anyClients = true;
+  }
+  return anyClients;
+}
+
+// Broadcast a frame to every client that isn't backed up, in binary where
+// the client accepts it
+void WebsocketServer::broadcastBinary(
+    const string& data,
+    const std::function<string(const string&)>& encodeText,
+    const std::function<string()>& makeResync,
+    const string& path)
+{
+  // Prevent concurrent access to the list of open connections from multiple
+  // threads
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  // Each of these is built at most once per broadcast, and only if a client
+  // needs it
+  string text;
+  string resync;
+  string resyncText;
+  bool textReady = false;
+  bool resyncReady = false;
+  bool resyncTextReady = false;
+
+  for (auto conn : this->openConnections)
+  {
+    ConnectionState& state = this->connectionStates[conn];
+    if (!path.empty() && state.path != path)
+      continue;
+    websocketpp::lib::error_code error;
+    WebsocketEndpoint::connection_ptr connection
+        = this->endpoint.get_con_from_hdl(conn, error);
+    if (error)
+      continue;
+
+    if (this->maxBufferedBytes > 0
+        && connection->get_buffered_amount() > this->maxBufferedBytes)
+    {
+      // This client can't keep up, so skip it until its queue drains
+      state.lagging = true;
+      state.droppedFrames++;
+      continue;
+    }
+
+    const string* payload = &data;
+    if (state.lagging)
+    {
+      if (!resyncReady)
+      {
+        resync = makeResync();
+        resyncReady = true;
+      }
+      payload = &resync;
+      state.lagging = false;
+    }
+
+    if (state.acceptsBinary)
+    {
+      try
+      {
+        this->endpoint.send(
+            conn, *payload, websocketpp::frame::opcode::binary);
+      }
+      catch (websocketpp::exception const& e)
+      {
+        dterr << e.what() << std::endl;
+        dterr << "Exception thrown from endpoint.send(). Continuing."
+              << std::endl;
+      }
+    }
+    else if (payload == &resync)
+    {
+      if (!resyncTextReady)
+      {
+        resyncText = encodeText(resync);
+        resyncTextReady = true;
+      }
+      this->send(conn, resyncText);
+    }
+    else
+    {
+      if (!textReady)
+      {
+        text = encodeText(data);
+        textReady = true;
+      }
+      this->send(conn, text);
+    }
+  }
+}
+
+void WebsocketServer::setMaxBufferedBytes(size_t maxBufferedBytes)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  this->maxBufferedBytes = maxBufferedBytes;
+}
+
+vector<WebsocketServer::ConnectionStats> WebsocketServer::getConnectionStats(
+    const string& path)
+{
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+
+  vector<ConnectionStats> stats;
+  for (auto conn : this->openConnections)
+  {
+    if (!path.empty() && this->connectionStates[conn].path != path)
+      continue;
+    ConnectionStats connStats;
+    websocketpp::lib::error_code error;
+    WebsocketEndpoint::connection_ptr connection
+        = this->endpoint.get_con_from_hdl(conn, error);
+    connStats.bufferedBytes = error ? 0 : connection->get_buffered_amount();
+    const ConnectionState& state = this->connectionStates[conn];
+    connStats.droppedFrames = state.droppedFrames;
+    connStats.lagging = state.lagging;
+    stats.push_back(connStats);
+  }
+  return stats;
+}
+
 void WebsocketServer::onOpen(ClientConnection conn)
 {
   {
@@ -183,6 +352,17 @@ void WebsocketServer::onOpen(ClientConnection conn)
 
     // Add the connection handle to our list of open connections
     this->openConnections.push_back(conn);
+
+    // Remember which path the client asked for, without the query string
+    websocketpp::lib::error_code error;
+    WebsocketEndpoint::connection_ptr connection
+        = this->endpoint.get_con_from_hdl(conn, error);
+    if (!error)
+    {
+      string resource = connection->get_resource();
+      this->connectionStates[conn].path
+          = resource.substr(0, resource.find('?'));
+    }
   }
 
   // Invoke any registered handlers
@@ -227,11 +407,15 @@ void WebsocketServer::onClose(ClientConnection conn)
         std::distance(openConnections.begin(), newEnd));
   }
 
-  // Invoke any registered handlers
+  // Invoke any registered handlers. We keep the connection's state until
+  // they're done, so they can still look up which path it was on.
   for (auto handler : this->disconnectHandlers)
   {
     handler(conn);
   }
+
+  std::lock_guard<std::mutex> lock(this->connectionListMutex);
+  this->connectionStates.erase(conn);
 }
 
 void WebsocketServer::onMessage(
@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -27,8 +28,17 @@ public:
   bool run(int port);
   void stop();
 
-  // Returns the number of currently connected clients
-  size_t numConnections();
+  // Returns the number of currently connected clients. If `path` isn't empty,
+  // this only counts clients connected on that path.
+  size_t numConnections(const string& path = "");
+
+  // Returns the URL path (without any query string) that a client connected
+  // on, or an empty string if the client isn't connected
+  string getPath(ClientConnection conn);
+
+  // Changes the path a client is treated as connected on, which is what
+  // broadcasts filtered by path look at
+  void setPath(ClientConnection conn, const string& path);
 
   // Registers a callback for when a client connects
   template <typename CallbackTy>
@@ -77,6 +87,48 @@ public:
   // Broadcast a raw text message to all clients
   void broadcast(const string& message);
 
+  // Records whether a client has told us it can read binary frames
+  void setAcceptsBinary(ClientConnection conn, bool acceptsBinary);
+
+  // Returns true if there's at least one client, and every connected client
+  // can read binary frames. If `path` isn't empty, this only looks at clients
+  // connected on that path.
+  bool allClientsAcceptBinary(const string& path = "");
+
+  // Broadcasts a frame of state updates. `data` goes out as a binary frame to
+  // every client that accepts binary frames, and `encodeText(data)` as a text
+  // frame to the rest.
+  //
+  // Clients with more than the max buffered bytes already waiting to be sent
+  // skip this frame. Since frames are deltas, the next frame such a client
+  // does receive is `makeResync()` instead, which must rebuild the latest
+  // state from scratch. Both callbacks are only called if needed.
+  //
+  // If `path` isn't empty, this only goes to clients connected on that path.
+  void broadcastBinary(
+      const string& data,
+      const std::function<string(const string&)>& encodeText,
+      const std::function<string()>& makeResync,
+      const string& path = "");
+
+  // Sets how many bytes may be waiting to go out to a single client before
+  // broadcastBinary() starts dropping frames for it. 0 means unlimited.
+  void setMaxBufferedBytes(size_t maxBufferedBytes);
+
+  struct ConnectionStats
+  {
+    // Bytes queued in websocketpp waiting to be written to the socket
+    size_t bufferedBytes;
+    // Frames skipped because the client was behind
+    long droppedFrames;
+    // True if the client is waiting for a resync
+    bool lagging;
+  };
+
+  // Returns the outbound queue stats for each open connection. If `path` isn't
+  // empty, this only returns clients connected on that path.
+  vector<ConnectionStats> getConnectionStats(const string& path = "");
+
 protected:
   static Json::Value parseJson(const string& json);
   static string stringifyJson(const Json::Value& val);
@@ -93,6 +145,17 @@ public:
 protected:
   WebsocketEndpoint endpoint;
   vector<ClientConnection> openConnections;
+
+  struct ConnectionState
+  {
+    bool acceptsBinary = false;
+    bool lagging = false;
+    long droppedFrames = 0;
+    string path;
+  };
+  std::map<ClientConnection, ConnectionState, std::owner_less<ClientConnection>>
+      connectionStates;
+  size_t maxBufferedBytes;
   std::mutex connectionListMutex;
   asio::signal_set* mSignalSet;
 
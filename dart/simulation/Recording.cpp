@@ -38,8 +38,11 @@
 
 #include "dart/simulation/Recording.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 
+#include "dart/common/Console.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 
 namespace dart {
@@ -47,6 +50,14 @@ namespace simulation {
 
 //==============================================================================
 Recording::Recording(const std::vector<dynamics::SkeletonPtr>& _skeletons)
+  : mCapacity(0),
+    mUseFloat32(false),
+    mHead(0),
+    mSize(0),
+    mNumEvicted(0),
+    mSpillBytes(0),
+    mSpillWriting(false),
+    mStopSpilling(false)
 {
   for (std::size_t i = 0; i < _skeletons.size(); i++)
     mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumDofs());
@@ -54,6 +65,14 @@ Recording::Recording(const std::vector<dynamics::SkeletonPtr>& _skeletons)
 
 //==============================================================================
 Recording::Recording(const std::vector<int>& _skelDofs)
+  : mCapacity(0),
+    mUseFloat32(false),
+    mHead(0),
+    mSize(0),
+    mNumEvicted(0),
+    mSpillBytes(0),
+    mSpillWriting(false),
+    mStopSpilling(false)
 {
   for (std::size_t i = 0; i < _skelDofs.size(); i++)
     mNumGenCoordsForSkeletons.push_back(_skelDofs[i]);
@@ -62,12 +81,17 @@ Recording::Recording(const std::vector<int>& _skelDofs)
 //==============================================================================
 Recording::~Recording()
 {
+  // This writes out anything still queued before the thread exits
+  mSpillPath.clear();
+  resetSpillFile();
 }
 
 //==============================================================================
 int Recording::getNumFrames() const
 {
-  return mBakedStates.size();
+  if (mSpillPath.empty())
+    return mSize;
+  return mNumEvicted + mSize;
 }
 
 //==============================================================================
@@ -85,10 +109,12 @@ int Recording::getNumDofs(int _skelIdx) const
 //==============================================================================
 int Recording::getNumContacts(int _frameIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return (mBakedStates[_frameIdx].size() - totalDofs) / 6;
+  int slot = getSlot(_frameIdx);
+  if (slot == -1)
+    return (readSpilledState(_frameIdx).size() - getTotalDofs()) / 6;
+  if (mUseFloat32)
+    return mContactsFloat[slot].size() / 6;
+  return mContacts[slot].size() / 6;
 }
 
 //==============================================================================
@@ -97,7 +123,17 @@ Eigen::VectorXs Recording::getConfig(int _frameIdx, int _skelIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(index, getNumDofs(_skelIdx));
+
+  int slot = getSlot(_frameIdx);
+  if (slot == -1)
+    return readSpilledState(_frameIdx).segment(index, getNumDofs(_skelIdx));
+  if (mUseFloat32)
+  {
+    return mConfigsFloat.col(slot)
+        .segment(index, getNumDofs(_skelIdx))
+        .cast<s_t>();
+  }
+  return mConfigs.col(slot).segment(index, getNumDofs(_skelIdx));
 }
 
 //==============================================================================
@@ -106,36 +142,120 @@ s_t Recording::getGenCoord(int _frameIdx, int _skelIdx, int _dofIdx) const
   int index = 0;
   for (int i = 0; i < _skelIdx; i++)
     index += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx][index + _dofIdx];
+
+  int slot = getSlot(_frameIdx);
+  if (slot == -1)
+    return readSpilledState(_frameIdx)(index + _dofIdx);
+  if (mUseFloat32)
+    return mConfigsFloat(index + _dofIdx, slot);
+  return mConfigs(index + _dofIdx, slot);
 }
 
 //==============================================================================
 Eigen::Vector3s Recording::getContactPoint(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6, 3);
+  return getState(_frameIdx).segment<3>(getTotalDofs() + _contactIdx * 6);
 }
 
 //==============================================================================
 Eigen::Vector3s Recording::getContactForce(int _frameIdx, int _contactIdx) const
 {
-  int totalDofs = 0;
-  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
-    totalDofs += mNumGenCoordsForSkeletons[i];
-  return mBakedStates[_frameIdx].segment(totalDofs + _contactIdx * 6 + 3, 3);
+  return getState(_frameIdx).segment<3>(getTotalDofs() + _contactIdx * 6 + 3);
 }
 
 //==============================================================================
-void Recording::clear() {
-  mBakedStates.clear();
+Eigen::VectorXs Recording::getDofHistory(int _skelIdx, int _dofIdx) const
+{
+  int index = _dofIdx;
+  for (int i = 0; i < _skelIdx; i++)
+    index += mNumGenCoordsForSkeletons[i];
+
+  Eigen::VectorXs history = Eigen::VectorXs::Zero(mSize);
+  if (mSize == 0)
+    return history;
+  int slots = mUseFloat32 ? mConfigsFloat.cols() : mConfigs.cols();
+  int firstRun = std::min(mSize, slots - mHead);
+  if (mUseFloat32)
+  {
+    history.head(firstRun)
+        = mConfigsFloat.row(index).segment(mHead, firstRun).cast<s_t>();
+    history.tail(mSize - firstRun)
+        = mConfigsFloat.row(index).head(mSize - firstRun).cast<s_t>();
+  }
+  else
+  {
+    history.head(firstRun) = mConfigs.row(index).segment(mHead, firstRun);
+    history.tail(mSize - firstRun)
+        = mConfigs.row(index).head(mSize - firstRun);
+  }
+  return history;
+}
+
+//==============================================================================
+void Recording::clear()
+{
+  mHead = 0;
+  mSize = 0;
+  mNumEvicted = 0;
+  resetSpillFile();
 }
 
 //==============================================================================
 void Recording::addState(const Eigen::VectorXs& _state)
 {
-  mBakedStates.push_back(_state);
+  int dofs = getTotalDofs();
+  assert(_state.size() >= dofs);
+  assert((_state.size() - dofs) % 6 == 0);
+
+  int slots = mUseFloat32 ? mConfigsFloat.cols() : mConfigs.cols();
+  if (mCapacity > 0)
+  {
+    if (slots != mCapacity)
+    {
+      resizeStorage(mCapacity);
+      slots = mCapacity;
+    }
+    if (mSize == mCapacity)
+    {
+      // Evict the oldest frame
+      if (!mSpillPath.empty())
+      {
+        Eigen::VectorXs evicted = getSlotState(mHead);
+        mSpillOffsets.push_back(mSpillBytes);
+        mSpillBytes += sizeof(std::int32_t)
+                       + evicted.size()
+                             * (mUseFloat32 ? sizeof(float) : sizeof(double));
+        {
+          std::lock_guard<std::mutex> lock(mSpillMutex);
+          mSpillQueue.push_back(std::move(evicted));
+        }
+        mSpillChanged.notify_all();
+      }
+      mHead = (mHead + 1) % mCapacity;
+      mSize--;
+      mNumEvicted++;
+    }
+  }
+  else if (mSize == slots)
+  {
+    // Without a capacity we never evict, so mHead stays at 0 and we can just
+    // grow the storage geometrically
+    slots = std::max(16, slots * 2);
+    resizeStorage(slots);
+  }
+
+  int slot = (mHead + mSize) % slots;
+  if (mUseFloat32)
+  {
+    mConfigsFloat.col(slot) = _state.head(dofs).cast<float>();
+    mContactsFloat[slot] = _state.tail(_state.size() - dofs).cast<float>();
+  }
+  else
+  {
+    mConfigs.col(slot) = _state.head(dofs);
+    mContacts[slot] = _state.tail(_state.size() - dofs);
+  }
+  mSize++;
 }
 
 //==============================================================================
@@ -145,8 +265,237 @@ void Recording::updateNumGenCoords(
   mNumGenCoordsForSkeletons.clear();
   for (std::size_t i = 0; i < _skeletons.size(); ++i)
     mNumGenCoordsForSkeletons.push_back(_skeletons[i]->getNumDofs());
+  resizeStorage(0);
+  clear();
+}
+
+//==============================================================================
+void Recording::setCapacity(int _frames)
+{
+  mCapacity = std::max(0, _frames);
+  resizeStorage(0);
+  clear();
+}
+
+//==============================================================================
+int Recording::getCapacity() const
+{
+  return mCapacity;
+}
+
+//==============================================================================
+void Recording::setUseFloat32(bool _useFloat32)
+{
+  resizeStorage(0);
+  mUseFloat32 = _useFloat32;
+  clear();
+}
+
+//==============================================================================
+bool Recording::getUseFloat32() const
+{
+  return mUseFloat32;
+}
+
+//==============================================================================
+void Recording::setSpillFile(const std::string& _path)
+{
+  mSpillPath = _path;
+  clear();
+}
+
+//==============================================================================
+void Recording::flushSpillFile() const
+{
+  std::unique_lock<std::mutex> lock(mSpillMutex);
+  mSpillChanged.wait(
+      lock, [this] { return mSpillQueue.empty() && !mSpillWriting; });
+}
+
+//==============================================================================
+int Recording::getTotalDofs() const
+{
+  int totalDofs = 0;
+  for (std::size_t i = 0; i < mNumGenCoordsForSkeletons.size(); i++)
+    totalDofs += mNumGenCoordsForSkeletons[i];
+  return totalDofs;
+}
+
+//==============================================================================
+int Recording::getSlot(int _frameIdx) const
+{
+  assert(_frameIdx >= 0 && _frameIdx < getNumFrames());
+  // Dropped frames don't count towards the frame indices, spilled ones do
+  int inMemory = mSpillPath.empty() ? _frameIdx : _frameIdx - mNumEvicted;
+  if (inMemory < 0)
+    return -1;
+  int slots = mUseFloat32 ? mConfigsFloat.cols() : mConfigs.cols();
+  return (mHead + inMemory) % slots;
+}
+
+//==============================================================================
+Eigen::VectorXs Recording::getState(int _frameIdx) const
+{
+  int slot = getSlot(_frameIdx);
+  if (slot == -1)
+    return readSpilledState(_frameIdx);
+  return getSlotState(slot);
+}
+
+//==============================================================================
+Eigen::VectorXs Recording::getSlotState(int _slot) const
+{
+  int dofs = getTotalDofs();
+  if (mUseFloat32)
+  {
+    Eigen::VectorXs state(dofs + mContactsFloat[_slot].size());
+    state.head(dofs) = mConfigsFloat.col(_slot).cast<s_t>();
+    state.tail(mContactsFloat[_slot].size())
+        = mContactsFloat[_slot].cast<s_t>();
+    return state;
+  }
+  Eigen::VectorXs state(dofs + mContacts[_slot].size());
+  state.head(dofs) = mConfigs.col(_slot);
+  state.tail(mContacts[_slot].size()) = mContacts[_slot];
+  return state;
+}
+
+//==============================================================================
+Eigen::VectorXs Recording::readSpilledState(int _frameIdx) const
+{
+  flushSpillFile();
+
+  std::ifstream in(mSpillPath, std::ios::binary);
+  in.seekg(mSpillOffsets[_frameIdx]);
+  std::int32_t numContacts = 0;
+  in.read(reinterpret_cast<char*>(&numContacts), sizeof(numContacts));
+  int size = getTotalDofs() + 6 * numContacts;
+
+  Eigen::VectorXs state;
+  if (mUseFloat32)
+  {
+    Eigen::VectorXf values(size);
+    in.read(reinterpret_cast<char*>(values.data()), size * sizeof(float));
+    state = values.cast<s_t>();
+  }
+  else
+  {
+    Eigen::VectorXd values(size);
+    in.read(reinterpret_cast<char*>(values.data()), size * sizeof(double));
+    state = values.cast<s_t>();
+  }
+  if (!in)
+  {
+    dterr << "[Recording::readSpilledState] Failed to read frame " << _frameIdx
+          << " from \"" << mSpillPath << "\"\n";
+  }
+  return state;
+}
+
+//==============================================================================
+void Recording::resizeStorage(int _slots)
+{
+  int dofs = _slots == 0 ? 0 : getTotalDofs();
+  if (mUseFloat32)
+  {
+    mConfigsFloat.conservativeResize(dofs, _slots);
+    mContactsFloat.resize(_slots);
+  }
+  else
+  {
+    mConfigs.conservativeResize(dofs, _slots);
+    mContacts.resize(_slots);
+  }
+}
+
+//==============================================================================
+void Recording::resetSpillFile()
+{
+  if (mSpillThread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mSpillMutex);
+      mStopSpilling = true;
+    }
+    mSpillChanged.notify_all();
+    mSpillThread.join();
+  }
+  mSpillQueue.clear();
+  mSpillWriting = false;
+  mStopSpilling = false;
+  if (mSpillStream.is_open())
+    mSpillStream.close();
+  mSpillOffsets.clear();
+  mSpillBytes = 0;
+
+  if (mSpillPath.empty())
+    return;
+
+  mSpillStream.open(mSpillPath, std::ios::binary | std::ios::trunc);
+  if (!mSpillStream)
+  {
+    dterr << "[Recording::setSpillFile] Failed to open \"" << mSpillPath
+          << "\" for writing, so evicted frames will be dropped.\n";
+    mSpillPath.clear();
+    return;
+  }
+  std::int32_t header[2];
+  header[0] = mUseFloat32 ? sizeof(float) : sizeof(double);
+  header[1] = getTotalDofs();
+  mSpillStream.write("DARTREC1", 8);
+  mSpillStream.write(reinterpret_cast<const char*>(header), sizeof(header));
+  mSpillStream.flush();
+  mSpillBytes = 8 + sizeof(header);
+
+  // The thread gets its own copy of the settings, so that changing them
+  // doesn't race with frames that are still being written
+  mSpillThread = std::thread(
+      &Recording::spillLoop, this, mUseFloat32, getTotalDofs());
+}
+
+//==============================================================================
+void Recording::spillLoop(bool _useFloat32, int _dofs)
+{
+  std::unique_lock<std::mutex> lock(mSpillMutex);
+  while (true)
+  {
+    mSpillChanged.wait(
+        lock, [this] { return mStopSpilling || !mSpillQueue.empty(); });
+    if (mSpillQueue.empty())
+      return;
+
+    Eigen::VectorXs state = std::move(mSpillQueue.front());
+    mSpillQueue.pop_front();
+    mSpillWriting = true;
+    lock.unlock();
+
+    std::int32_t numContacts = (state.size() - _dofs) / 6;
+    mSpillStream.write(
+        reinterpret_cast<const char*>(&numContacts), sizeof(numContacts));
+    if (_useFloat32)
+    {
+      Eigen::VectorXf values = state.cast<float>();
+      mSpillStream.write(
+          reinterpret_cast<const char*>(values.data()),
+          values.size() * sizeof(float));
+    }
+    else
+    {
+      Eigen::VectorXd values = state.cast<double>();
+      mSpillStream.write(
+          reinterpret_cast<const char*>(values.data()),
+          values.size() * sizeof(double));
+    }
+
+    lock.lock();
+    mSpillWriting = false;
+    if (mSpillQueue.empty())
+    {
+      mSpillStream.flush();
+      mSpillChanged.notify_all();
+    }
+  }
 }
 
 }  // namespace simulation
 }  // namespace dart
-
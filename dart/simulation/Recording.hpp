@@ -39,6 +39,12 @@
 #ifndef DART_SIMULATION_RECORDING_HPP_
 #define DART_SIMULATION_RECORDING_HPP_
 
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -54,6 +60,12 @@ class Skeleton;
 namespace simulation {
 
 /// \brief class Recording
+///
+/// Frames are kept in a ring buffer, with each DOF's history stored
+/// contiguously. By default the buffer grows without bound, like it always
+/// has. Once a capacity is set, adding a frame to a full buffer evicts the
+/// oldest frame. Evicted frames are either dropped, or handed to a background
+/// thread that appends them to a spill file, where they stay readable.
 class Recording
 {
 public:
@@ -63,10 +75,14 @@ public:
   /// \brief Create Recording with a list of number of dofs
   explicit Recording(const std::vector<int>& _skelDofs);
 
+  Recording(const Recording&) = delete;
+  Recording& operator=(const Recording&) = delete;
+
   /// \brief Destructor
   virtual ~Recording();
 
-  /// \brief Get number of frames
+  /// \brief Get number of frames. This counts spilled frames, but not frames
+  /// that were evicted and dropped.
   int getNumFrames() const;
 
   /// \brief Get number of skeletons
@@ -95,21 +111,119 @@ public:
   /// _frameIdx
   Eigen::Vector3s getContactForce(int _frameIdx, int _contactIdx) const;
 
-  /// \brief Clear the saved histories
-  void clear();  
+  /// \brief Get the history of a single DOF over the frames still in memory,
+  /// oldest first. The ring buffer can wrap, so this is at most two
+  /// contiguous runs of memory.
+  Eigen::VectorXs getDofHistory(int _skelIdx, int _dofIdx) const;
+
+  /// \brief Clear the saved histories, including the spill file
+  void clear();
 
   /// \brief Add state
   void addState(const Eigen::VectorXs& _state);
 
-  /// \brief Update list for number of generalized coordinates
+  /// \brief Update list for number of generalized coordinates. This clears
+  /// the recording.
   void updateNumGenCoords(const std::vector<dynamics::SkeletonPtr>& _skeletons);
 
+  /// \brief Keep at most _frames frames in memory, or 0 to never evict
+  /// anything. This clears the recording.
+  void setCapacity(int _frames);
+
+  /// \brief Get the maximum number of frames kept in memory, or 0 if the
+  /// recording grows without bound
+  int getCapacity() const;
+
+  /// \brief Store the frames as single precision floats, in memory and in
+  /// the spill file. This halves the memory, but loses precision. This clears
+  /// the recording.
+  void setUseFloat32(bool _useFloat32);
+
+  /// \brief Returns true if the frames are stored as single precision floats
+  bool getUseFloat32() const;
+
+  /// \brief Append frames evicted from the ring buffer to the file at _path,
+  /// instead of dropping them, or pass an empty string to stop spilling. The
+  /// file starts with the header "DARTREC1", then the value size in bytes and
+  /// the total number of DOFs as int32s. Each frame is then an int32 contact
+  /// count followed by the DOF values and six values per contact. This clears
+  /// the recording.
+  void setSpillFile(const std::string& _path);
+
+  /// \brief Blocks until every evicted frame has been written to the spill
+  /// file
+  void flushSpillFile() const;
+
 private:
-  /// \brief Baked states
-  std::vector<Eigen::VectorXs> mBakedStates;
+  /// \brief Returns the total number of DOFs across skeletons
+  int getTotalDofs() const;
+
+  /// \brief Returns the ring buffer slot holding frame _frameIdx, or -1 if
+  /// that frame has been spilled to disk
+  int getSlot(int _frameIdx) const;
+
+  /// \brief Returns the full state of frame _frameIdx, wherever it lives
+  Eigen::VectorXs getState(int _frameIdx) const;
+
+  /// \brief Returns the full state stored in a ring buffer slot
+  Eigen::VectorXs getSlotState(int _slot) const;
+
+  /// \brief Reads the full state of a spilled frame back from disk
+  Eigen::VectorXs readSpilledState(int _frameIdx) const;
+
+  /// \brief Resizes the in-memory storage to hold _slots frames
+  void resizeStorage(int _slots);
+
+  /// \brief Stops the spill thread, and truncates the spill file
+  void resetSpillFile();
+
+  /// \brief The body of the background thread that writes the spill file
+  void spillLoop(bool _useFloat32, int _dofs);
 
   /// \brief Number of generalized coordinates for skeletons
   std::vector<int> mNumGenCoordsForSkeletons;
+
+  /// \brief The maximum number of frames in memory, or 0 for no limit
+  int mCapacity;
+
+  /// \brief If true, frames are kept in mConfigsFloat and mContactsFloat
+  bool mUseFloat32;
+
+  /// \brief One row per DOF and one column per ring buffer slot, so each
+  /// DOF's history is contiguous
+  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      mConfigs;
+  Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      mConfigsFloat;
+
+  /// \brief The contact points and forces for each ring buffer slot
+  std::vector<Eigen::VectorXs> mContacts;
+  std::vector<Eigen::VectorXf> mContactsFloat;
+
+  /// \brief The slot holding the oldest frame in memory
+  int mHead;
+
+  /// \brief The number of frames in memory
+  int mSize;
+
+  /// \brief The number of frames that have been evicted from memory
+  int mNumEvicted;
+
+  /// \brief The spill file, or empty if evicted frames are dropped
+  std::string mSpillPath;
+
+  /// \brief The byte offset of each spilled frame in the spill file, which
+  /// lets us seek straight to any frame
+  std::vector<std::streamoff> mSpillOffsets;
+  std::streamoff mSpillBytes;
+
+  std::thread mSpillThread;
+  mutable std::mutex mSpillMutex;
+  mutable std::condition_variable mSpillChanged;
+  std::deque<Eigen::VectorXs> mSpillQueue;
+  std::ofstream mSpillStream;
+  bool mSpillWriting;
+  bool mStopSpilling;
 };
 
 }  // namespace simulation
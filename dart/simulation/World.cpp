@@ -39,13 +39,16 @@
 #include "dart/simulation/World.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "dart/collision/CollisionGroup.hpp"
 #include "dart/common/Console.hpp"
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 #include "dart/constraint/ConstrainedGroup.hpp"
 #include "dart/dynamics/BoxShape.hpp"
@@ -55,12 +58,25 @@
 #include "dart/neural/ConstrainedGroupGradientMatrices.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/SnapshotPool.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/server/RawJsonUtils.hpp"
 
 namespace dart {
 namespace simulation {
 
+namespace {
+
+/// A monotonic clock, in nanoseconds, for the step timing counters
+uint64_t getStepClock()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
 //==============================================================================
 std::shared_ptr<World> World::create(const std::string& name)
 {
@@ -82,17 +98,32 @@ World::World(const std::string& _name)
     mParallelVelocityAndPositionUpdates(
         true), // TODO(keenon): We should fix our backprop to somehow achieve
                // the best of both worlds here
+    mParallelSkeletonUpdatesEnabled(false),
+    mSleepingEnabled(false),
+    mSleepVelocityThreshold(1e-3),
+    mSleepSteps(60),
+    mStepsAtRestVersion(0),
     mFallbackConstraintForceMixingConstant(1e-4),
     mContactClippingDepth(0.03),
+    mMaxNumContactsPerPair(0),
+    mContinuousCollisionEnabled(false),
+    mCompliantContactEnabled(false),
+    mCompliantContactStiffness(
+        constraint::CompliantContact::Option().mStiffness),
+    mCompliantContactDamping(constraint::CompliantContact::Option().mDamping),
     mPenetrationCorrectionEnabled(false),
     mWrtMass(std::make_shared<neural::WithRespectToMass>()),
     mUseFDOverride(false),
     mSlowDebugResultsAgainstFD(false),
     mConstraintEngineFn([this](bool _resetCommand) {
       return runLcpConstraintEngine(_resetCommand);
-    })
+    }),
+    mSnapshotPoolEnabled(false),
+    mNumFDThreads(1),
+    mSkeletonsVersion(0)
 {
   mIndices.push_back(0);
+  resetInertiaCache();
 
   auto solver = std::make_unique<constraint::BoxedLcpConstraintSolver>();
   setConstraintSolver(std::move(solver));
@@ -120,9 +151,19 @@ WorldPtr World::clone() const
   worldClone->setFallbackConstraintForceMixingConstant(
       mFallbackConstraintForceMixingConstant);
   worldClone->setContactClippingDepth(mContactClippingDepth);
+  worldClone->setMaxNumContactsPerPair(mMaxNumContactsPerPair);
+  worldClone->setContinuousCollisionEnabled(mContinuousCollisionEnabled);
+  worldClone->setCompliantContactEnabled(mCompliantContactEnabled);
+  worldClone->setCompliantContactStiffness(mCompliantContactStiffness);
+  worldClone->setCompliantContactDamping(mCompliantContactDamping);
   worldClone->setPenetrationCorrectionEnabled(mPenetrationCorrectionEnabled);
   worldClone->setParallelVelocityAndPositionUpdates(
       mParallelVelocityAndPositionUpdates);
+  worldClone->setParallelSkeletonUpdatesEnabled(
+      mParallelSkeletonUpdatesEnabled);
+  worldClone->setSleepingEnabled(mSleepingEnabled);
+  worldClone->setSleepVelocityThreshold(mSleepVelocityThreshold);
+  worldClone->setSleepSteps(mSleepSteps);
 
   // Copy the WithRespectToMass pointer, so we have the same object
   worldClone->mWrtMass = mWrtMass;
@@ -168,9 +209,88 @@ WorldPtr World::clone() const
   // Ensure that the action mapping for the RL-style API is preserved
   worldClone->setActionSpace(mActionSpace);
 
+  // The clone gets its own (empty) pool, since snapshots are tied to a world
+  worldClone->setSnapshotPoolEnabled(mSnapshotPoolEnabled);
+  worldClone->setNumFDThreads(mNumFDThreads);
+
   return worldClone;
 }
 
+//==============================================================================
+WorldPtr World::fork(const WorldPtr& recycled) const
+{
+  if (recycled && recycled.get() != this && copyStateInto(*recycled))
+    return recycled;
+  return clone();
+}
+
+//==============================================================================
+bool World::copyStateInto(World& target) const
+{
+  // Check that everything lines up before we touch anything
+  if (target.mSkeletons.size() != mSkeletons.size()
+      || target.mSimpleFrames.size() != mSimpleFrames.size())
+    return false;
+  for (std::size_t i = 0; i < mSkeletons.size(); ++i)
+  {
+    const dynamics::SkeletonPtr& from = mSkeletons[i];
+    const dynamics::SkeletonPtr& to = target.mSkeletons[i];
+    if (from->getName() != to->getName()
+        || from->getNumBodyNodes() != to->getNumBodyNodes()
+        || from->getNumDofs() != to->getNumDofs())
+      return false;
+  }
+  for (std::size_t i = 0; i < mSimpleFrames.size(); ++i)
+  {
+    if (mSimpleFrames[i]->getName() != target.mSimpleFrames[i]->getName())
+      return false;
+  }
+
+  target.setGravity(mGravity);
+  target.setTimeStep(mTimeStep);
+  target.mTime = mTime;
+  target.mFrame = mFrame;
+  target.setActionSpace(mActionSpace);
+
+  for (std::size_t i = 0; i < mSkeletons.size(); ++i)
+  {
+    const dynamics::SkeletonPtr& from = mSkeletons[i];
+    const dynamics::SkeletonPtr& to = target.mSkeletons[i];
+
+    // Scales move the joint offsets and the inertia, so they go first
+    to->setBodyScales(from->getBodyScales());
+    to->setLinkMasses(from->getLinkMasses());
+    to->setLinkCOMs(from->getLinkCOMs());
+    to->setLinkMOIs(from->getLinkMOIs());
+    to->setLinkBetas(from->getLinkBetas());
+
+    to->setPositionUpperLimits(from->getPositionUpperLimits());
+    to->setPositionLowerLimits(from->getPositionLowerLimits());
+    to->setVelocityUpperLimits(from->getVelocityUpperLimits());
+    to->setVelocityLowerLimits(from->getVelocityLowerLimits());
+    to->setControlForceUpperLimits(from->getControlForceUpperLimits());
+    to->setControlForceLowerLimits(from->getControlForceLowerLimits());
+
+    to->setPositions(from->getPositions());
+    to->setVelocities(from->getVelocities());
+    to->setAccelerations(from->getAccelerations());
+    to->setControlForces(from->getControlForces());
+    for (std::size_t j = 0; j < from->getNumBodyNodes(); ++j)
+    {
+      to->getBodyNode(j)->setExtWrench(
+          from->getBodyNode(j)->getExternalForceLocal());
+    }
+  }
+
+  for (std::size_t i = 0; i < mSimpleFrames.size(); ++i)
+  {
+    target.mSimpleFrames[i]->setRelativeTransform(
+        mSimpleFrames[i]->getRelativeTransform());
+  }
+
+  return true;
+}
+
 //==============================================================================
 void World::setTimeStep(s_t _timeStep)
 {
@@ -207,30 +327,35 @@ void World::reset()
 void World::integrateVelocities()
 {
   // Integrate velocity for unconstrained skeletons
-  for (auto& skel : mSkeletons)
-  {
+  forEachSkeleton([this](std::size_t i) {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
     if (!skel->isMobile())
-      continue;
+      return;
 
     skel->computeForwardDynamics();
     skel->integrateVelocities(mTimeStep);
-  }
+  });
 }
 
 //==============================================================================
 void World::step(bool _resetCommand)
 {
+  const uint64_t stepStart = getStepClock();
+  const bool sleeping
+      = mSleepingEnabled && !mConstraintSolver->getGradientEnabled();
+  wakeDisturbedSkeletons(sleeping);
   Eigen::VectorXs initialVelocity = getVelocities();
 
   // Integrate velocity for unconstrained skeletons
-  for (auto& skel : mSkeletons)
-  {
-    if (!skel->isMobile())
-      continue;
+  forEachSkeleton([this](std::size_t i) {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
+    if (!skel->isMobile() || skel->isAsleep())
+      return;
 
     skel->computeForwardDynamics();
     skel->integrateVelocities(mTimeStep);
-  }
+  });
+  mStepTimings.velocityIntegrationNs += getStepClock() - stepStart;
 
   // Record the unconstrained velocities, cause we need them for backprop
   if (mConstraintSolver->getGradientEnabled())
@@ -242,15 +367,52 @@ void World::step(bool _resetCommand)
   mConstraintSolver->setPenetrationCorrectionEnabled(
       mPenetrationCorrectionEnabled);
   mConstraintSolver->setContactClippingDepth(mContactClippingDepth);
+  mConstraintSolver->setMaxNumContactsPerPair(mMaxNumContactsPerPair);
+  mConstraintSolver->setContinuousCollisionTimeStep(
+      mContinuousCollisionEnabled ? mTimeStep : 0.0);
+  mConstraintSolver->setCompliantContactEnabled(mCompliantContactEnabled);
+  constraint::CompliantContact::Option compliantContactOption
+      = mConstraintSolver->getCompliantContactOption();
+  compliantContactOption.mStiffness = mCompliantContactStiffness;
+  compliantContactOption.mDamping = mCompliantContactDamping;
+  mConstraintSolver->setCompliantContactOption(compliantContactOption);
   mConstraintSolver->setFallbackConstraintForceMixingConstant(
       mFallbackConstraintForceMixingConstant);
   runConstraintEngine(_resetCommand);
 
   // Integrate positions forward
+  const uint64_t positionStart = getStepClock();
   integratePositions(initialVelocity);
+  const uint64_t stepEnd = getStepClock();
+  mStepTimings.positionIntegrationNs += stepEnd - positionStart;
+
+  if (sleeping)
+    sleepRestingSkeletons();
 
   mTime += mTimeStep;
   mFrame++;
+
+  mStepTimings.totalNs += stepEnd - stepStart;
+  mStepTimings.numSteps++;
+}
+
+//==============================================================================
+StepTimings World::getStepTimings() const
+{
+  StepTimings timings = mStepTimings;
+  const constraint::ConstraintSolverTimings& solverTimings
+      = mConstraintSolver->getTimings();
+  timings.collisionDetectionNs = solverTimings.collisionDetectionNs;
+  timings.lcpConstructionNs = solverTimings.lcpConstructionNs;
+  timings.lcpSolveNs = solverTimings.lcpSolveNs;
+  return timings;
+}
+
+//==============================================================================
+void World::resetStepTimings()
+{
+  mStepTimings = StepTimings();
+  mConstraintSolver->resetTimings();
 }
 
 //==============================================================================
@@ -282,14 +444,17 @@ void World::replaceConstraintEngineFn(const constraintEngineFnType& engineFn)
 //==============================================================================
 void World::integrateVelocitiesFromImpulses(bool _resetCommand)
 {
+  const uint64_t start = getStepClock();
   // Compute velocity changes given constraint impulses
-  for (auto& skel : mSkeletons)
-  {
+  forEachSkeleton([this, _resetCommand](std::size_t i) {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
     if (!skel->isMobile())
-      continue;
+      return;
 
     if (skel->isImpulseApplied())
     {
+      // Something awake ran into this skeleton
+      skel->setAsleep(false);
       skel->computeImpulseForwardDynamics();
       skel->setImpulseApplied(false);
     }
@@ -300,15 +465,17 @@ void World::integrateVelocitiesFromImpulses(bool _resetCommand)
       skel->clearExternalForces();
       skel->resetCommands();
     }
-  }
+  });
+  mStepTimings.velocityIntegrationNs += getStepClock() - start;
 }
 
 //==============================================================================
-void World::integratePositions(Eigen::VectorXs initialVelocity)
+void World::integratePositions(const Eigen::VectorXs& initialVelocity)
 {
-  int cursor = 0;
-  for (auto& skel : mSkeletons)
-  {
+  forEachSkeleton([this, &initialVelocity](std::size_t i) {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
+    if (skel->isAsleep())
+      return;
     if (mParallelVelocityAndPositionUpdates)
     {
       // <Nimble>: This is an easier way to compute gradients for. We update
@@ -316,9 +483,8 @@ void World::integratePositions(Eigen::VectorXs initialVelocity)
       int dofs = skel->getNumDofs();
       skel->setPositions(skel->integratePositionsExplicit(
           skel->getPositions(),
-          initialVelocity.segment(cursor, dofs),
+          initialVelocity.segment(mIndices[i], dofs),
           mTimeStep));
-      cursor += dofs;
       // </Nimble>: Integrate positions before velocity changes, instead of
       // after
     }
@@ -329,6 +495,89 @@ void World::integratePositions(Eigen::VectorXs initialVelocity)
       skel->integratePositions(mTimeStep);
       // </Nimble>
     }
+  });
+}
+
+//==============================================================================
+void World::forEachSkeleton(const std::function<void(std::size_t)>& fn)
+{
+  if (!mParallelSkeletonUpdatesEnabled || mSkeletons.size() < 2)
+  {
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+      fn(i);
+    return;
+  }
+
+  std::vector<common::TaskFuture<void>> futures;
+  futures.reserve(mSkeletons.size());
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    futures.push_back(common::async([&fn, i] { fn(i); }));
+  for (auto& future : futures)
+    future.get();
+}
+
+//==============================================================================
+void World::wakeDisturbedSkeletons(bool sleeping)
+{
+  // The counters are by index, so start over whenever a Skeleton is added or
+  // removed, even if that leaves the count unchanged
+  if (mStepsAtRest.size() != mSkeletons.size()
+      || mStepsAtRestVersion != mSkeletonsVersion)
+  {
+    mStepsAtRest.assign(mSkeletons.size(), 0);
+    mSleepPositions.assign(mSkeletons.size(), Eigen::VectorXs());
+    mStepsAtRestVersion = mSkeletonsVersion;
+  }
+
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
+    if (!skel->isAsleep())
+      continue;
+
+    // A Skeleton put to sleep by hand, or before the counters were reset,
+    // hasn't had its positions recorded yet
+    if (mSleepPositions[i].size() != skel->getNumDofs())
+      mSleepPositions[i] = skel->getPositions();
+
+    bool disturbed = !sleeping || skel->getPositions() != mSleepPositions[i]
+                     || !skel->getVelocities().isZero(0)
+                     || !skel->getControlForces().isZero(0)
+                     || !skel->getCommands().isZero(0);
+    for (std::size_t j = 0; !disturbed && j < skel->getNumBodyNodes(); j++)
+    {
+      disturbed = !skel->getBodyNode(j)->getExternalForceLocal().isZero(0);
+    }
+    if (disturbed)
+    {
+      skel->setAsleep(false);
+      mStepsAtRest[i] = 0;
+    }
+  }
+}
+
+//==============================================================================
+void World::sleepRestingSkeletons()
+{
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    const dynamics::SkeletonPtr& skel = mSkeletons[i];
+    if (!skel->isMobile() || skel->isAsleep() || skel->getNumDofs() == 0)
+      continue;
+
+    if (skel->getVelocities().cwiseAbs().maxCoeff() >= mSleepVelocityThreshold)
+    {
+      mStepsAtRest[i] = 0;
+      continue;
+    }
+    mStepsAtRest[i]++;
+    if (mStepsAtRest[i] >= mSleepSteps)
+    {
+      skel->setVelocities(Eigen::VectorXs::Zero(skel->getNumDofs()));
+      skel->setAsleep(true);
+      mSleepPositions[i] = skel->getPositions();
+      mStepsAtRest[i] = 0;
+    }
   }
 }
 
@@ -356,6 +605,54 @@ bool World::getParallelVelocityAndPositionUpdates()
   return mParallelVelocityAndPositionUpdates;
 }
 
+//==============================================================================
+void World::setParallelSkeletonUpdatesEnabled(bool enable)
+{
+  mParallelSkeletonUpdatesEnabled = enable;
+}
+
+//==============================================================================
+bool World::getParallelSkeletonUpdatesEnabled() const
+{
+  return mParallelSkeletonUpdatesEnabled;
+}
+
+//==============================================================================
+void World::setSleepingEnabled(bool enable)
+{
+  mSleepingEnabled = enable;
+}
+
+//==============================================================================
+bool World::getSleepingEnabled() const
+{
+  return mSleepingEnabled;
+}
+
+//==============================================================================
+void World::setSleepVelocityThreshold(s_t threshold)
+{
+  mSleepVelocityThreshold = threshold;
+}
+
+//==============================================================================
+s_t World::getSleepVelocityThreshold() const
+{
+  return mSleepVelocityThreshold;
+}
+
+//==============================================================================
+void World::setSleepSteps(int steps)
+{
+  mSleepSteps = steps;
+}
+
+//==============================================================================
+int World::getSleepSteps() const
+{
+  return mSleepSteps;
+}
+
 //==============================================================================
 void World::setPenetrationCorrectionEnabled(bool enable)
 {
@@ -392,6 +689,66 @@ s_t World::getContactClippingDepth()
   return mContactClippingDepth;
 }
 
+//==============================================================================
+void World::setMaxNumContactsPerPair(std::size_t maxNumContacts)
+{
+  mMaxNumContactsPerPair = maxNumContacts;
+}
+
+//==============================================================================
+std::size_t World::getMaxNumContactsPerPair()
+{
+  return mMaxNumContactsPerPair;
+}
+
+//==============================================================================
+void World::setContinuousCollisionEnabled(bool enable)
+{
+  mContinuousCollisionEnabled = enable;
+}
+
+//==============================================================================
+bool World::getContinuousCollisionEnabled()
+{
+  return mContinuousCollisionEnabled;
+}
+
+//==============================================================================
+void World::setCompliantContactEnabled(bool enable)
+{
+  mCompliantContactEnabled = enable;
+}
+
+//==============================================================================
+bool World::getCompliantContactEnabled()
+{
+  return mCompliantContactEnabled;
+}
+
+//==============================================================================
+void World::setCompliantContactStiffness(s_t stiffness)
+{
+  mCompliantContactStiffness = stiffness;
+}
+
+//==============================================================================
+s_t World::getCompliantContactStiffness()
+{
+  return mCompliantContactStiffness;
+}
+
+//==============================================================================
+void World::setCompliantContactDamping(s_t damping)
+{
+  mCompliantContactDamping = damping;
+}
+
+//==============================================================================
+s_t World::getCompliantContactDamping()
+{
+  return mCompliantContactDamping;
+}
+
 //==============================================================================
 std::shared_ptr<neural::WithRespectToMass> World::getWrtMass()
 {
@@ -530,6 +887,48 @@ std::string World::positionsToJson()
   return json.str();
 }
 
+//==============================================================================
+std::string World::positionsToJson(s_t epsilon)
+{
+  std::stringstream json;
+
+  json << "{";
+
+  bool first = true;
+  for (dynamics::BodyNode* bodyNode : getAllBodyNodes())
+  {
+    std::string name
+        = bodyNode->getSkeleton()->getName() + "." + bodyNode->getName();
+    const Eigen::Isometry3s& bodyTransform = bodyNode->getWorldTransform();
+    Eigen::Vector6s position;
+    position.head<3>() = bodyTransform.translation();
+    position.tail<3>() = math::matrixToEulerXYZ(bodyTransform.linear());
+
+    auto last = mLastJsonPositions.find(name);
+    if (last != mLastJsonPositions.end()
+        && (last->second - position).cwiseAbs().maxCoeff() <= epsilon)
+    {
+      continue;
+    }
+    mLastJsonPositions[name] = position;
+
+    if (!first)
+      json << ",";
+    first = false;
+    json << "\"" << name << "\": {";
+    json << "\"pos\":";
+    vec3ToJson(json, position.head<3>());
+    json << ",";
+    json << "\"angle\":";
+    vec3ToJson(json, position.tail<3>());
+    json << "}";
+  }
+
+  json << "}";
+
+  return json.str();
+}
+
 //==============================================================================
 /// This returns the colors as a JSON blob that can be rendered if we
 /// already have the original world loaded. Good for real-time viewing.
@@ -580,6 +979,61 @@ std::string World::colorsToJson()
   return json.str();
 }
 
+//==============================================================================
+std::string World::colorsToJson(s_t epsilon)
+{
+  std::stringstream json;
+
+  json << "{";
+
+  bool first = true;
+  for (dynamics::BodyNode* bodyNode : getAllBodyNodes())
+  {
+    std::string name
+        = bodyNode->getSkeleton()->getName() + "." + bodyNode->getName();
+    const std::vector<dynamics::ShapeNode*> visualShapeNodes
+        = bodyNode->getShapeNodesWith<dynamics::VisualAspect>();
+    Eigen::VectorXs colors(visualShapeNodes.size() * 3);
+    for (int j = 0; j < visualShapeNodes.size(); j++)
+    {
+      colors.segment<3>(j * 3)
+          = visualShapeNodes[j]->getVisualAspect(false)->getColor();
+    }
+
+    auto last = mLastJsonColors.find(name);
+    if (last != mLastJsonColors.end() && last->second.size() == colors.size()
+        && (colors.size() == 0
+            || (last->second - colors).cwiseAbs().maxCoeff() <= epsilon))
+    {
+      continue;
+    }
+    mLastJsonColors[name] = colors;
+
+    if (!first)
+      json << ",";
+    first = false;
+    json << "\"" << name << "\": [";
+    for (int j = 0; j < visualShapeNodes.size(); j++)
+    {
+      if (j > 0)
+        json << ",";
+      vec3ToJson(json, colors.segment<3>(j * 3));
+    }
+    json << "]";
+  }
+
+  json << "}";
+
+  return json.str();
+}
+
+//==============================================================================
+void World::resetJsonDiffs()
+{
+  mLastJsonPositions.clear();
+  mLastJsonColors.clear();
+}
+
 //==============================================================================
 /// This gets the cached LCP solution, which is useful to be able to get/set
 /// because it can effect the forward solutions of physics problems because of
@@ -634,6 +1088,49 @@ void World::DisableWrtMass()
   mWrtMass = nullptr;
 }
 
+//==============================================================================
+void World::setSnapshotPoolEnabled(bool enabled)
+{
+  mSnapshotPoolEnabled = enabled;
+}
+
+//==============================================================================
+bool World::getSnapshotPoolEnabled()
+{
+  return mSnapshotPoolEnabled;
+}
+
+//==============================================================================
+std::shared_ptr<neural::SnapshotPool> World::getSnapshotPool()
+{
+  if (!mSnapshotPool)
+  {
+    mSnapshotPool
+        = std::make_shared<neural::SnapshotPool>(getNumDofs(), getMassDims());
+  }
+  return mSnapshotPool;
+}
+
+//==============================================================================
+/// This sets the number of threads BackpropSnapshot uses to compute Jacobians
+/// by finite differencing. If `numThreads` is <= 0, we use
+/// std::thread::hardware_concurrency().
+void World::setNumFDThreads(int numThreads)
+{
+  if (numThreads <= 0)
+  {
+    numThreads = std::thread::hardware_concurrency();
+  }
+  // hardware_concurrency() is allowed to return 0 if it can't tell
+  mNumFDThreads = std::max(numThreads, 1);
+}
+
+//==============================================================================
+int World::getNumFDThreads()
+{
+  return mNumFDThreads;
+}
+
 //==============================================================================
 int World::getSimFrames() const
 {
@@ -765,6 +1262,7 @@ std::string World::addSkeleton(const dynamics::SkeletonPtr& _skeleton)
 
   mSkeletons.push_back(_skeleton);
   mMapForSkeletons[_skeleton] = _skeleton;
+  mSkeletonsVersion++;
 
   mNameConnectionsForSkeletons.push_back(_skeleton->onNameChanged.connect(
       [=](dynamics::ConstMetaSkeletonPtr skel,
@@ -836,6 +1334,7 @@ void World::removeSkeleton(const dynamics::SkeletonPtr& _skeleton)
   mSkeletons.erase(
       remove(mSkeletons.begin(), mSkeletons.end(), _skeleton),
       mSkeletons.end());
+  mSkeletonsVersion++;
 
   // Disconnect the name change monitor
   mNameConnectionsForSkeletons[index].disconnect();
@@ -1062,17 +1561,19 @@ size_t World::getLinkMassesDims()
   return mass_dim;
 }
 
-Eigen::VectorXs World::getLinkMasses()
+const Eigen::VectorXs& World::getLinkMasses()
 {
-  Eigen::VectorXs masses = Eigen::VectorXs::Zero(getLinkMassesDims());
-  size_t cur = 0;
-  for (size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    size_t mdim = mSkeletons[i]->getLinkMassesDims();
-    masses.segment(cur, mdim) = mSkeletons[i]->getLinkMasses();
-    cur += mdim;
-  }
-  return masses;
+  return getCachedInertiaVector(LINK_MASSES, [this]() {
+    Eigen::VectorXs masses = Eigen::VectorXs::Zero(getLinkMassesDims());
+    size_t cur = 0;
+    for (size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      size_t mdim = mSkeletons[i]->getLinkMassesDims();
+      masses.segment(cur, mdim) = mSkeletons[i]->getLinkMasses();
+      cur += mdim;
+    }
+    return masses;
+  });
 }
 
 Eigen::VectorXs World::getLinkMUs()
@@ -1088,30 +1589,34 @@ Eigen::VectorXs World::getLinkMUs()
   return mus;
 }
 
-Eigen::VectorXs World::getLinkCOMs()
+const Eigen::VectorXs& World::getLinkCOMs()
 {
-  Eigen::VectorXs coms = Eigen::VectorXs::Zero(3 * getLinkMassesDims());
-  size_t cursor = 0;
-  for (size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    Eigen::VectorXs skel_coms = mSkeletons[i]->getLinkCOMs();
-    coms.segment(cursor, skel_coms.size());
-    cursor += skel_coms.size();
-  }
-  return coms;
+  return getCachedInertiaVector(LINK_COMS, [this]() {
+    Eigen::VectorXs coms = Eigen::VectorXs::Zero(3 * getLinkMassesDims());
+    size_t cursor = 0;
+    for (size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      Eigen::VectorXs skel_coms = mSkeletons[i]->getLinkCOMs();
+      coms.segment(cursor, skel_coms.size()) = skel_coms;
+      cursor += skel_coms.size();
+    }
+    return coms;
+  });
 }
 
-Eigen::VectorXs World::getLinkMOIs()
+const Eigen::VectorXs& World::getLinkMOIs()
 {
-  Eigen::VectorXs mois = Eigen::VectorXs::Zero(6 * getLinkMassesDims());
-  size_t cursor = 0;
-  for (size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    Eigen::VectorXs skel_mois = mSkeletons[i]->getLinkMOIs();
-    mois.segment(cursor, skel_mois.size());
-    cursor += skel_mois.size();
-  }
-  return mois;
+  return getCachedInertiaVector(LINK_MOIS, [this]() {
+    Eigen::VectorXs mois = Eigen::VectorXs::Zero(6 * getLinkMassesDims());
+    size_t cursor = 0;
+    for (size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      Eigen::VectorXs skel_mois = mSkeletons[i]->getLinkMOIs();
+      mois.segment(cursor, skel_mois.size()) = skel_mois;
+      cursor += skel_mois.size();
+    }
+    return mois;
+  });
 }
 
 s_t World::getLinkMassIndex(size_t index)
@@ -1183,56 +1688,112 @@ Eigen::Vector6s World::getLinkMOIIndex(size_t index)
 Eigen::VectorXs World::getPositions()
 {
   Eigen::VectorXs positions = Eigen::VectorXs(mDofs);
+  getPositionsInto(positions);
+  return positions;
+}
+
+//==============================================================================
+void World::getPositionsInto(Eigen::Ref<Eigen::VectorXs> out)
+{
+  if (static_cast<std::size_t>(out.size()) != mDofs)
+  {
+    dterr << "[World::getPositionsInto] Output has size (" << out.size()
+          << "), but the world has " << mDofs << " DOFs. Nothing will be "
+          << "written!\n";
+    assert(false);
+    return;
+  }
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
     std::size_t dofs = mSkeletons[i]->getNumDofs();
-    positions.segment(cursor, dofs) = mSkeletons[i]->getPositions();
+    mSkeletons[i]->getPositionsInto(out.segment(cursor, dofs));
     cursor += dofs;
   }
-  return positions;
 }
 
 //==============================================================================
 Eigen::VectorXs World::getVelocities()
 {
   Eigen::VectorXs velocities = Eigen::VectorXs(mDofs);
+  getVelocitiesInto(velocities);
+  return velocities;
+}
+
+//==============================================================================
+void World::getVelocitiesInto(Eigen::Ref<Eigen::VectorXs> out)
+{
+  if (static_cast<std::size_t>(out.size()) != mDofs)
+  {
+    dterr << "[World::getVelocitiesInto] Output has size (" << out.size()
+          << "), but the world has " << mDofs << " DOFs. Nothing will be "
+          << "written!\n";
+    assert(false);
+    return;
+  }
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
     std::size_t dofs = mSkeletons[i]->getNumDofs();
-    velocities.segment(cursor, dofs) = mSkeletons[i]->getVelocities();
+    mSkeletons[i]->getVelocitiesInto(out.segment(cursor, dofs));
     cursor += dofs;
   }
-  return velocities;
 }
 
 //==============================================================================
 Eigen::VectorXs World::getAccelerations()
 {
-  Eigen::VectorXs velocities = Eigen::VectorXs(mDofs);
+  Eigen::VectorXs accelerations = Eigen::VectorXs(mDofs);
+  getAccelerationsInto(accelerations);
+  return accelerations;
+}
+
+//==============================================================================
+void World::getAccelerationsInto(Eigen::Ref<Eigen::VectorXs> out)
+{
+  if (static_cast<std::size_t>(out.size()) != mDofs)
+  {
+    dterr << "[World::getAccelerationsInto] Output has size (" << out.size()
+          << "), but the world has " << mDofs << " DOFs. Nothing will be "
+          << "written!\n";
+    assert(false);
+    return;
+  }
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
     std::size_t dofs = mSkeletons[i]->getNumDofs();
-    velocities.segment(cursor, dofs) = mSkeletons[i]->getAccelerations();
+    mSkeletons[i]->getAccelerationsInto(out.segment(cursor, dofs));
     cursor += dofs;
   }
-  return velocities;
 }
 
 //==============================================================================
 Eigen::VectorXs World::getControlForces()
 {
   Eigen::VectorXs forces = Eigen::VectorXs(mDofs);
+  getControlForcesInto(forces);
+  return forces;
+}
+
+//==============================================================================
+void World::getControlForcesInto(Eigen::Ref<Eigen::VectorXs> out)
+{
+  if (static_cast<std::size_t>(out.size()) != mDofs)
+  {
+    dterr << "[World::getControlForcesInto] Output has size (" << out.size()
+          << "), but the world has " << mDofs << " DOFs. Nothing will be "
+          << "written!\n";
+    assert(false);
+    return;
+  }
   std::size_t cursor = 0;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
     std::size_t dofs = mSkeletons[i]->getNumDofs();
-    forces.segment(cursor, dofs) = mSkeletons[i]->getControlForces();
+    mSkeletons[i]->getControlForcesInto(out.segment(cursor, dofs));
     cursor += dofs;
   }
-  return forces;
 }
 
 //==============================================================================
@@ -1279,17 +1840,19 @@ Eigen::VectorXs World::getGroupScales()
 
 //==============================================================================
 /// This gets the masses of each scale group, concatenated
-Eigen::VectorXs World::getGroupMasses()
+const Eigen::VectorXs& World::getGroupMasses()
 {
-  Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
-    scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMasses();
-    cursor += dofs;
-  }
-  return scales;
+  return getCachedInertiaVector(GROUP_MASSES, [this]() {
+    Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
+      scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMasses();
+      cursor += dofs;
+    }
+    return scales;
+  });
 }
 
 //==============================================================================
@@ -1307,32 +1870,36 @@ void World::setGroupMasses(Eigen::VectorXs masses)
 
 //==============================================================================
 /// This gets the upper bound for each group's mass, concatenated
-Eigen::VectorXs World::getGroupMassesUpperBound()
+const Eigen::VectorXs& World::getGroupMassesUpperBound()
 {
-  Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
-    scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMassesUpperBound();
-    cursor += dofs;
-  }
-  return scales;
+  return getCachedInertiaVector(GROUP_MASSES_UPPER_BOUND, [this]() {
+    Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
+      scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMassesUpperBound();
+      cursor += dofs;
+    }
+    return scales;
+  });
 }
 
 //==============================================================================
 /// This gets the lower bound for each group's mass, concatenated
-Eigen::VectorXs World::getGroupMassesLowerBound()
+const Eigen::VectorXs& World::getGroupMassesLowerBound()
 {
-  Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
-    scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMassesLowerBound();
-    cursor += dofs;
-  }
-  return scales;
+  return getCachedInertiaVector(GROUP_MASSES_LOWER_BOUND, [this]() {
+    Eigen::VectorXs scales = Eigen::VectorXs(getNumScaleGroups());
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups();
+      scales.segment(cursor, dofs) = mSkeletons[i]->getGroupMassesLowerBound();
+      cursor += dofs;
+    }
+    return scales;
+  });
 }
 
 //==============================================================================
@@ -1400,47 +1967,53 @@ Eigen::VectorXs World::getLinearizedMassesLowerBound()
 
 //==============================================================================
 /// This gets the COMs of each scale group, concatenated
-Eigen::VectorXs World::getGroupCOMs()
+const Eigen::VectorXs& World::getGroupCOMs()
 {
-  Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
-    coms.segment(cursor, dofs) = mSkeletons[i]->getGroupCOMs();
-    cursor += dofs;
-  }
-  return coms;
+  return getCachedInertiaVector(GROUP_COMS, [this]() {
+    Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
+      coms.segment(cursor, dofs) = mSkeletons[i]->getGroupCOMs();
+      cursor += dofs;
+    }
+    return coms;
+  });
 }
 
 //==============================================================================
 /// This gets the upper bound for each axis of each group's COM, concatenated
-Eigen::VectorXs World::getGroupCOMUpperBound()
+const Eigen::VectorXs& World::getGroupCOMUpperBound()
 {
-  Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
-    coms.segment(cursor, dofs) = mSkeletons[i]->getGroupCOMUpperBound();
-    cursor += dofs;
-  }
-  return coms;
+  return getCachedInertiaVector(GROUP_COMS_UPPER_BOUND, [this]() {
+    Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
+      coms.segment(cursor, dofs) = mSkeletons[i]->getGroupCOMUpperBound();
+      cursor += dofs;
+    }
+    return coms;
+  });
 }
 
 //==============================================================================
 /// This gets the lower bound for each axis of each group's COM, concatenated
-Eigen::VectorXs World::getGroupCOMLowerBound()
+const Eigen::VectorXs& World::getGroupCOMLowerBound()
 {
-  Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
-    coms.segment(cursor, dofs) = mSkeletons[i]->getGroupScalesLowerBound();
-    cursor += dofs;
-  }
-  return coms;
+  return getCachedInertiaVector(GROUP_COMS_LOWER_BOUND, [this]() {
+    Eigen::VectorXs coms = Eigen::VectorXs(getNumScaleGroups() * 3);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
+      coms.segment(cursor, dofs) = mSkeletons[i]->getGroupCOMLowerBound();
+      cursor += dofs;
+    }
+    return coms;
+  });
 }
 
 //==============================================================================
@@ -1451,24 +2024,26 @@ void World::setGroupCOMs(Eigen::VectorXs coms)
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
     std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 3;
-    mSkeletons[i]->setGroupMasses(coms.segment(cursor, dofs));
+    mSkeletons[i]->setGroupCOMs(coms.segment(cursor, dofs));
     cursor += dofs;
   }
 }
 
 //==============================================================================
 /// This gets the Inertias of each scale group (the 6 vector), concatenated
-Eigen::VectorXs World::getGroupInertias()
+const Eigen::VectorXs& World::getGroupInertias()
 {
-  Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
-  std::size_t cursor = 0;
-  for (std::size_t i = 0; i < mSkeletons.size(); i++)
-  {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
-    inertias.segment(cursor, dofs) = mSkeletons[i]->getGroupInertias();
-    cursor += dofs;
-  }
-  return inertias;
+  return getCachedInertiaVector(GROUP_INERTIAS, [this]() {
+    Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
+      inertias.segment(cursor, dofs) = mSkeletons[i]->getGroupInertias();
+      cursor += dofs;
+    }
+    return inertias;
+  });
 }
 
 //==============================================================================
@@ -1487,35 +2062,87 @@ void World::setGroupInertias(Eigen::VectorXs inertias)
 //==============================================================================
 /// This gets the upper bound for each axis of each group's inertias,
 /// concatenated
-Eigen::VectorXs World::getGroupInertiasUpperBound()
+const Eigen::VectorXs& World::getGroupInertiasUpperBound()
 {
-  Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
-  std::size_t cursor = 0;
+  return getCachedInertiaVector(GROUP_INERTIAS_UPPER_BOUND, [this]() {
+    Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
+      inertias.segment(cursor, dofs)
+          = mSkeletons[i]->getGroupInertiasUpperBound();
+      cursor += dofs;
+    }
+    return inertias;
+  });
+}
+
+//==============================================================================
+/// This gets the lower bound for each axis of each group's inertias,
+/// concatenated
+const Eigen::VectorXs& World::getGroupInertiasLowerBound()
+{
+  return getCachedInertiaVector(GROUP_INERTIAS_LOWER_BOUND, [this]() {
+    Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
+    std::size_t cursor = 0;
+    for (std::size_t i = 0; i < mSkeletons.size(); i++)
+    {
+      std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
+      inertias.segment(cursor, dofs)
+          = mSkeletons[i]->getGroupInertiasLowerBound();
+      cursor += dofs;
+    }
+    return inertias;
+  });
+}
+
+//==============================================================================
+const Eigen::VectorXs& World::getCachedInertiaVector(
+    InertiaVector vector, const std::function<Eigen::VectorXs()>& assemble)
+{
+  if (!isInertiaCacheCurrent())
+    resetInertiaCache();
+  if (!mInertiaVectorCached[vector])
+  {
+    Eigen::VectorXs assembled = assemble();
+    // Assembling the group vectors can create the scale groups, which makes
+    // everything else we've cached stale
+    if (!isInertiaCacheCurrent())
+      resetInertiaCache();
+    mInertiaVectors[vector] = std::move(assembled);
+    mInertiaVectorCached[vector] = true;
+  }
+  return mInertiaVectors[vector];
+}
+
+//==============================================================================
+bool World::isInertiaCacheCurrent() const
+{
+  if (mInertiaCacheVersions.size() != mSkeletons.size() + 1
+      || mInertiaCacheVersions[0] != mSkeletonsVersion)
+    return false;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
-    inertias.segment(cursor, dofs)
-        = mSkeletons[i]->getGroupInertiasUpperBound();
-    cursor += dofs;
+    if (mInertiaCacheVersions[i + 1] != mSkeletons[i]->getInertiaVersion())
+      return false;
   }
-  return inertias;
+  return true;
 }
 
 //==============================================================================
-/// This gets the lower bound for each axis of each group's inertias,
-/// concatenated
-Eigen::VectorXs World::getGroupInertiasLowerBound()
+void World::resetInertiaCache()
 {
-  Eigen::VectorXs inertias = Eigen::VectorXs(getNumScaleGroups() * 6);
-  std::size_t cursor = 0;
+  mInertiaCacheVersions.resize(mSkeletons.size() + 1);
+  mInertiaCacheVersions[0] = mSkeletonsVersion;
   for (std::size_t i = 0; i < mSkeletons.size(); i++)
   {
-    std::size_t dofs = mSkeletons[i]->getNumScaleGroups() * 6;
-    inertias.segment(cursor, dofs)
-        = mSkeletons[i]->getGroupInertiasLowerBound();
-    cursor += dofs;
+    mInertiaCacheVersions[i + 1] = mSkeletons[i]->getInertiaVersion();
+  }
+  for (int i = 0; i < NUM_INERTIA_VECTORS; i++)
+  {
+    mInertiaVectorCached[i] = false;
   }
-  return inertias;
 }
 
 //==============================================================================
@@ -2000,6 +2627,94 @@ Eigen::MatrixXs World::getInvMassMatrix()
   return invMassMatrix;
 }
 
+//==============================================================================
+/// This stacks sparse per-skeleton matrices along the diagonal
+static Eigen::SparseMatrix<s_t> concatenateBlockDiagonal(
+    const std::vector<Eigen::SparseMatrix<s_t>>& blocks, std::size_t size)
+{
+  std::vector<Eigen::Triplet<s_t>> triplets;
+  std::size_t nonZeros = 0;
+  for (const Eigen::SparseMatrix<s_t>& block : blocks)
+  {
+    nonZeros += block.nonZeros();
+  }
+  triplets.reserve(nonZeros);
+
+  std::size_t cursor = 0;
+  for (const Eigen::SparseMatrix<s_t>& block : blocks)
+  {
+    for (int k = 0; k < block.outerSize(); ++k)
+    {
+      for (Eigen::SparseMatrix<s_t>::InnerIterator it(block, k); it; ++it)
+      {
+        triplets.emplace_back(
+            cursor + it.row(), cursor + it.col(), it.value());
+      }
+    }
+    cursor += block.rows();
+  }
+
+  Eigen::SparseMatrix<s_t> result(size, size);
+  result.setFromTriplets(triplets.begin(), triplets.end());
+  return result;
+}
+
+//==============================================================================
+Eigen::SparseMatrix<s_t> World::getSparseMassMatrix()
+{
+  std::vector<Eigen::SparseMatrix<s_t>> blocks;
+  blocks.reserve(mSkeletons.size());
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    blocks.push_back(mSkeletons[i]->getSparseMassMatrix());
+  }
+  return concatenateBlockDiagonal(blocks, mDofs);
+}
+
+//==============================================================================
+Eigen::SparseMatrix<s_t> World::getSparseInvMassMatrix()
+{
+  std::vector<Eigen::SparseMatrix<s_t>> blocks;
+  blocks.reserve(mSkeletons.size());
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    blocks.push_back(mSkeletons[i]->getSparseInvMassMatrix());
+  }
+  return concatenateBlockDiagonal(blocks, mDofs);
+}
+
+//==============================================================================
+Eigen::VectorXs World::multiplyByImplicitMassMatrix(const Eigen::VectorXs& x)
+{
+  Eigen::VectorXs result = x;
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    std::size_t dofs = mSkeletons[i]->getNumDofs();
+    result.segment(cursor, dofs)
+        = mSkeletons[i]->multiplyByImplicitMassMatrix(x.segment(cursor, dofs));
+    cursor += dofs;
+  }
+  return result;
+}
+
+//==============================================================================
+Eigen::VectorXs World::multiplyByImplicitInvMassMatrix(
+    const Eigen::VectorXs& x)
+{
+  Eigen::VectorXs result = x;
+  std::size_t cursor = 0;
+  for (std::size_t i = 0; i < mSkeletons.size(); i++)
+  {
+    std::size_t dofs = mSkeletons[i]->getNumDofs();
+    result.segment(cursor, dofs)
+        = mSkeletons[i]->multiplyByImplicitInvMassMatrix(
+            x.segment(cursor, dofs));
+    cursor += dofs;
+  }
+  return result;
+}
+
 //==============================================================================
 // This sets all the positions of the joints to within their limit range, if
 // they're currently outside it.
@@ -2046,6 +2761,117 @@ Eigen::VectorXs World::getState()
   return state;
 }
 
+//==============================================================================
+// This writes everything that changes when we step() into one contiguous
+// buffer, laid out as [dofs, bodies, time, frame, pos, vel, acc, control
+// forces, commands, external forces, LCP cache size, LCP cache]
+void World::saveStateTo(Eigen::VectorXs& buffer)
+{
+  const Eigen::VectorXs lcpCache = mConstraintSolver->getCachedLCPSolution();
+  const int dofs = getNumDofs();
+  int bodies = 0;
+  for (const auto& skel : mSkeletons)
+    bodies += skel->getNumBodyNodes();
+
+  const int size = 5 + 5 * dofs + 6 * bodies + lcpCache.size();
+  if (buffer.size() != size)
+    buffer.resize(size);
+
+  buffer(0) = dofs;
+  buffer(1) = bodies;
+  buffer(2) = mTime;
+  buffer(3) = mFrame;
+  int cursor = 4;
+  for (const auto& skel : mSkeletons)
+  {
+    const int n = skel->getNumDofs();
+    skel->getPositionsInto(buffer.segment(cursor, n));
+    skel->getVelocitiesInto(buffer.segment(cursor + dofs, n));
+    skel->getAccelerationsInto(buffer.segment(cursor + 2 * dofs, n));
+    skel->getControlForcesInto(buffer.segment(cursor + 3 * dofs, n));
+    for (int j = 0; j < n; j++)
+      buffer(cursor + 4 * dofs + j) = skel->getCommand(j);
+    cursor += n;
+  }
+  cursor = 4 + 5 * dofs;
+  for (const auto& skel : mSkeletons)
+  {
+    for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+    {
+      buffer.segment<6>(cursor) = skel->getBodyNode(i)->getExternalForceLocal();
+      cursor += 6;
+    }
+  }
+  buffer(cursor) = lcpCache.size();
+  buffer.tail(lcpCache.size()) = lcpCache;
+}
+
+//==============================================================================
+// This restores a buffer written by saveStateTo(), only touching the values
+// that actually changed
+bool World::loadStateFrom(const Eigen::VectorXs& buffer)
+{
+  const int dofs = getNumDofs();
+  int bodies = 0;
+  for (const auto& skel : mSkeletons)
+    bodies += skel->getNumBodyNodes();
+
+  const int lcpCursor = 4 + 5 * dofs + 6 * bodies;
+  if (buffer.size() <= lcpCursor || buffer(0) != dofs || buffer(1) != bodies
+      || buffer(lcpCursor) != buffer.size() - lcpCursor - 1)
+  {
+    dterr << "[World::loadStateFrom] The buffer doesn't match this World, "
+          << "ignoring it.\n";
+    return false;
+  }
+
+  mTime = buffer(2);
+  mFrame = static_cast<int>(buffer(3));
+  int cursor = 4;
+  for (const auto& skel : mSkeletons)
+  {
+    const int n = skel->getNumDofs();
+    // This is true if any of the `n` values starting at `start` don't match
+    // what `get` returns for the corresponding DOF
+    auto changed = [&](int start, const auto& get) {
+      for (int j = 0; j < n; j++)
+      {
+        if (get(j) != buffer(start + j))
+          return true;
+      }
+      return false;
+    };
+
+    if (changed(cursor, [&](int j) { return skel->getPosition(j); }))
+      skel->setPositions(buffer.segment(cursor, n));
+    if (changed(cursor + dofs, [&](int j) { return skel->getVelocity(j); }))
+      skel->setVelocities(buffer.segment(cursor + dofs, n));
+    if (changed(
+            cursor + 2 * dofs, [&](int j) { return skel->getAcceleration(j); }))
+      skel->setAccelerations(buffer.segment(cursor + 2 * dofs, n));
+    if (changed(
+            cursor + 3 * dofs, [&](int j) { return skel->getControlForce(j); }))
+      skel->setControlForces(buffer.segment(cursor + 3 * dofs, n));
+    if (changed(cursor + 4 * dofs, [&](int j) { return skel->getCommand(j); }))
+      skel->setCommands(buffer.segment(cursor + 4 * dofs, n));
+    cursor += n;
+  }
+  cursor = 4 + 5 * dofs;
+  for (const auto& skel : mSkeletons)
+  {
+    for (std::size_t i = 0; i < skel->getNumBodyNodes(); i++)
+    {
+      dynamics::BodyNode* body = skel->getBodyNode(i);
+      if (body->getExternalForceLocal() != buffer.segment<6>(cursor))
+        body->setExtWrench(buffer.segment<6>(cursor));
+      cursor += 6;
+    }
+  }
+  mConstraintSolver->setCachedLCPSolution(
+      buffer.tail(buffer.size() - cursor - 1));
+  return true;
+}
+
 //==============================================================================
 // The action dim is given by the size of the action mapping. This defaults to a
 // 1-1 map onto control forces, but can be configured to be just a subset of the
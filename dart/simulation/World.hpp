@@ -39,11 +39,14 @@
 #ifndef DART_SIMULATION_WORLD_HPP_
 #define DART_SIMULATION_WORLD_HPP_
 
+#include <functional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 
 #include "dart/collision/CollisionOption.hpp"
 #include "dart/common/NameManager.hpp"
@@ -79,12 +82,27 @@ class CollisionResult;
 namespace neural {
 class WithRespectToMass;
 class BackpropSnapshot;
+class SnapshotPool;
 } // namespace neural
 
 namespace simulation {
 
 DART_COMMON_DECLARE_SHARED_WEAK(World)
 
+/// Cumulative wall-clock time World::step() has spent in each phase, in
+/// nanoseconds, since the last World::resetStepTimings()
+struct StepTimings
+{
+  long numSteps = 0;
+  uint64_t totalNs = 0;
+  uint64_t collisionDetectionNs = 0;
+  uint64_t lcpConstructionNs = 0;
+  uint64_t lcpSolveNs = 0;
+  /// Unconstrained forward dynamics, plus applying constraint impulses
+  uint64_t velocityIntegrationNs = 0;
+  uint64_t positionIntegrationNs = 0;
+};
+
 /// class World
 class World : public virtual common::Subject,
               public std::enable_shared_from_this<World>
@@ -116,6 +134,30 @@ public:
   /// by this World will be copied over.
   std::shared_ptr<World> clone() const;
 
+  /// Returns a World with the same state as this one, for rolling out many
+  /// futures from the same starting point. If `recycled` came from an
+  /// earlier clone() or fork() of this World, this only copies the mutable
+  /// state over into `recycled` (see copyStateInto()) and returns it, which
+  /// costs about as much as copying the state vectors. Otherwise, or if
+  /// `recycled` is null, this falls back to clone(). Shapes and meshes are
+  /// already shared between clones, so what a fork saves is rebuilding the
+  /// Skeletons and collision objects.
+  ///
+  /// Structural edits made to this World after `recycled` was created (adding
+  /// or removing bodies, changing joint or shape properties) are NOT carried
+  /// over, so call clone() again after making any.
+  std::shared_ptr<World> fork(
+      const std::shared_ptr<World>& recycled = nullptr) const;
+
+  /// This copies the mutable state of this World into `target`, which must
+  /// have the same structure (usually because it was created with clone()).
+  /// That's the time, gravity and time step, each Skeleton's positions,
+  /// velocities, accelerations, control forces, external forces, limits,
+  /// body scales and inertia, and the transforms of the SimpleFrames. Returns
+  /// false, without touching `target`, if the Skeletons or SimpleFrames don't
+  /// line up.
+  bool copyStateInto(World& target) const;
+
   //--------------------------------------------------------------------------
   // Properties
   //--------------------------------------------------------------------------
@@ -232,18 +274,34 @@ public:
   /// as a single vector
   Eigen::VectorXs getPositions();
 
+  /// Same as getPositions(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getPositionsInto(Eigen::Ref<Eigen::VectorXs> out);
+
   /// Gets the velocity of all the skeletons in the world concatenated together
   /// as a single vector
   Eigen::VectorXs getVelocities();
 
+  /// Same as getVelocities(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getVelocitiesInto(Eigen::Ref<Eigen::VectorXs> out);
+
   /// Gets the acceleration of all the skeletons in the world concatenated
   /// together as a single vector
   Eigen::VectorXs getAccelerations();
 
+  /// Same as getAccelerations(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getAccelerationsInto(Eigen::Ref<Eigen::VectorXs> out);
+
   /// Gets the torques of all the skeletons in the world concatenated together
   /// as a single vector
   Eigen::VectorXs getControlForces();
 
+  /// Same as getControlForces(), but writes into an existing vector of
+  /// getNumDofs() entries instead of allocating a new one
+  void getControlForcesInto(Eigen::Ref<Eigen::VectorXs> out);
+
   /// Gets the dimension of the group scales for all skeletons in the world
   /// concatenated together as a single vector
   int getGroupScaleDim();
@@ -256,17 +314,22 @@ public:
   /// as a single vector
   Eigen::VectorXs getGroupScales();
 
-  /// This gets the masses of each scale group, concatenated
-  Eigen::VectorXs getGroupMasses();
+  /// This gets the masses of each scale group, concatenated.
+  ///
+  /// This, and the other getters for the masses, COMs and inertias of the
+  /// scale groups and links (and their bounds), return a vector that's cached
+  /// until some Skeleton's Skeleton::getInertiaVersion() changes, or a
+  /// Skeleton is added or removed. The reference is only good until then.
+  const Eigen::VectorXs& getGroupMasses();
 
   /// This sets the masses of each scale group, concatenated
   void setGroupMasses(Eigen::VectorXs masses);
 
   /// This gets the upper bound for each group's mass, concatenated
-  Eigen::VectorXs getGroupMassesUpperBound();
+  const Eigen::VectorXs& getGroupMassesUpperBound();
 
   /// This gets the lower bound for each group's mass, concatenated
-  Eigen::VectorXs getGroupMassesLowerBound();
+  const Eigen::VectorXs& getGroupMassesLowerBound();
 
   /// This gets the masses of each scale group, concatenated
   Eigen::VectorXs getLinearizedMasses();
@@ -281,30 +344,30 @@ public:
   Eigen::VectorXs getLinearizedMassesLowerBound();
 
   /// This gets the COMs of each scale group, concatenated
-  Eigen::VectorXs getGroupCOMs();
+  const Eigen::VectorXs& getGroupCOMs();
 
   /// This gets the upper bound for each axis of each group's COM, concatenated
-  Eigen::VectorXs getGroupCOMUpperBound();
+  const Eigen::VectorXs& getGroupCOMUpperBound();
 
   /// This gets the lower bound for each axis of each group's COM, concatenated
-  Eigen::VectorXs getGroupCOMLowerBound();
+  const Eigen::VectorXs& getGroupCOMLowerBound();
 
   /// This sets the COMs of each scale group, concatenated
   void setGroupCOMs(Eigen::VectorXs coms);
 
   /// This gets the Inertias of each scale group (the 6 vector), concatenated
-  Eigen::VectorXs getGroupInertias();
+  const Eigen::VectorXs& getGroupInertias();
 
   /// This sets the Inertias of each scale group (the 6 vector), concatenated
   void setGroupInertias(Eigen::VectorXs inertias);
 
   /// This gets the upper bound for each axis of each group's inertias,
   /// concatenated
-  Eigen::VectorXs getGroupInertiasUpperBound();
+  const Eigen::VectorXs& getGroupInertiasUpperBound();
 
   /// This gets the lower bound for each axis of each group's inertias,
   /// concatenated
-  Eigen::VectorXs getGroupInertiasLowerBound();
+  const Eigen::VectorXs& getGroupInertiasLowerBound();
 
   /// Gets the masses of all the nodes in the world concatenated together as a
   /// single vector
@@ -369,13 +432,13 @@ public:
 
   s_t getLinkMUIndex(size_t index);
 
-  Eigen::VectorXs getLinkCOMs();
+  const Eigen::VectorXs& getLinkCOMs();
 
   Eigen::Vector3s getLinkCOMIndex(size_t index);
 
   // This gets all the inertia moment-of-inertia paremeters for all the links in
   // all the skeletons in this world concatenated together
-  Eigen::VectorXs getLinkMOIs();
+  const Eigen::VectorXs& getLinkMOIs();
 
   Eigen::Vector6s getLinkMOIIndex(size_t index);
 
@@ -387,7 +450,7 @@ public:
 
   // This returns a vector of all the link masses for all the skeletons in the
   // world concatenated into a flat vector.
-  Eigen::VectorXs getLinkMasses();
+  const Eigen::VectorXs& getLinkMasses();
 
   s_t getLinkMassIndex(size_t index);
 
@@ -467,6 +530,24 @@ public:
   /// block-diagonal concatenation of each skeleton's inverse mass matrix.
   Eigen::MatrixXs getInvMassMatrix();
 
+  /// This is the same as getMassMatrix(), except that it returns a sparse
+  /// matrix, built from each skeleton's Skeleton::getSparseMassMatrix(). For
+  /// worlds with many skeletons, or large branching skeletons, this avoids
+  /// storing the O(n^2) zeros of the dense version.
+  Eigen::SparseMatrix<s_t> getSparseMassMatrix();
+
+  /// This is the same as getInvMassMatrix(), except that it returns a sparse
+  /// matrix, built from each skeleton's Skeleton::getSparseInvMassMatrix().
+  Eigen::SparseMatrix<s_t> getSparseInvMassMatrix();
+
+  /// This returns M*x, without explicitly forming M. This is O(n) in the
+  /// number of DOFs, using each skeleton's implicit multiply.
+  Eigen::VectorXs multiplyByImplicitMassMatrix(const Eigen::VectorXs& x);
+
+  /// This returns Minv*x, without explicitly forming Minv. This is O(n) in the
+  /// number of DOFs, using each skeleton's implicit multiply.
+  Eigen::VectorXs multiplyByImplicitInvMassMatrix(const Eigen::VectorXs& x);
+
   void clampPositionsToLimits();
   //--------------------------------------------------------------------------
   // High Level ("Reinforcement Learning style") API
@@ -487,6 +568,20 @@ public:
   // This return the concatenation of [pos, vel]
   Eigen::VectorXs getState();
 
+  // This writes everything that changes when we step() into one contiguous
+  // buffer: the time, the positions, velocities, accelerations, control
+  // forces and commands, the external forces on each body, and the cached LCP
+  // solution we warm start from. `buffer` is only resized if it's the wrong
+  // size, so it can be reused. Masses, scales and other parameters are not
+  // included. The contacts themselves aren't either, because we
+  // always collide again at the start of step().
+  void saveStateTo(Eigen::VectorXs& buffer);
+  // This restores a buffer written by saveStateTo(). It only touches the
+  // Skeletons whose values actually changed, so that their cached kinematics
+  // and dynamics survive. Returns false, and leaves the World alone, if the
+  // buffer came from a World with different DOFs or bodies.
+  bool loadStateFrom(const Eigen::VectorXs& buffer);
+
   // The action dim is given by the size of the action mapping. This defaults to
   // a 1-1 map onto control forces, but can be configured to be just a subset of
   // the control forces, if there are several DOFs that are uncontrolled.
@@ -558,6 +653,14 @@ public:
   /// command after simulation step.
   void step(bool _resetCommand = true);
 
+  /// Returns how long step() has spent in each phase since the last
+  /// resetStepTimings(). These counters are always on, since they cost a
+  /// handful of clock reads per step.
+  StepTimings getStepTimings() const;
+
+  /// Zeros the counters returned by getStepTimings()
+  void resetStepTimings();
+
   /// Integrate non-constraint forces.
   void integrateVelocities();
 
@@ -575,7 +678,21 @@ public:
   void integrateVelocitiesFromImpulses(bool _resetCommand = true);
 
   /// Integrate positions.
-  void integratePositions(Eigen::VectorXs initialVelocity);
+  void integratePositions(const Eigen::VectorXs& initialVelocity);
+
+  /// This runs fn(i) for the index of every Skeleton, either in order on the
+  /// calling thread or as tasks on the shared pool, depending on
+  /// setParallelSkeletonUpdatesEnabled()
+  void forEachSkeleton(const std::function<void(std::size_t)>& fn);
+
+  /// This wakes every sleeping Skeleton that has a velocity, a joint force or
+  /// an external force on it, or that's been moved since it fell asleep. If
+  /// `sleeping` is false, this wakes every sleeping Skeleton.
+  void wakeDisturbedSkeletons(bool sleeping);
+
+  /// This puts every Skeleton that's been at rest for getSleepSteps() steps to
+  /// sleep
+  void sleepRestingSkeletons();
 
   /// Set current time
   void setTime(s_t _time);
@@ -641,6 +758,45 @@ public:
 
   bool getParallelVelocityAndPositionUpdates();
 
+  /// When this is enabled, step() runs the unconstrained forward dynamics, the
+  /// velocity updates from constraint impulses and the position integration of
+  /// each Skeleton as its own task on the shared common::TaskScheduler pool.
+  /// Skeletons only interact through the constraint solver, which still runs
+  /// on the calling thread, so the results are identical either way. This
+  /// pays off for worlds with lots of Skeletons. False by default.
+  void setParallelSkeletonUpdatesEnabled(bool enable);
+
+  bool getParallelSkeletonUpdatesEnabled() const;
+
+  /// When this is enabled, a mobile Skeleton whose velocities all stay below
+  /// getSleepVelocityThreshold() for getSleepSteps() steps in a row is put to
+  /// sleep (see Skeleton::setAsleep()). step() skips the forward dynamics and
+  /// integration of sleeping Skeletons, and collision detection skips pairs
+  /// where neither side is an awake, mobile Skeleton. A sleeping Skeleton
+  /// wakes up as soon as it gets a contact impulse from an awake one, a joint
+  /// force, an external force, a nonzero velocity or new positions (from
+  /// setPositions(), FreeJoint::setTransform(), etc). Taking away whatever it's
+  /// resting on doesn't wake it, so call Skeleton::setAsleep(false) if you do
+  /// that.
+  ///
+  /// Sleeping changes the dynamics, so it's never used while the constraint
+  /// solver has gradients enabled. False by default.
+  void setSleepingEnabled(bool enable);
+
+  bool getSleepingEnabled() const;
+
+  /// Sets the largest absolute velocity (on any DOF) that counts as at rest.
+  /// Defaults to 1e-3.
+  void setSleepVelocityThreshold(s_t threshold);
+
+  s_t getSleepVelocityThreshold() const;
+
+  /// Sets how many steps in a row a Skeleton has to be at rest before it's
+  /// put to sleep. Defaults to 60.
+  void setSleepSteps(int steps);
+
+  int getSleepSteps() const;
+
   /// True by default. Sets whether or not to apply artifical "penetration
   /// correction" forces to objects that inter-penetrate.
   void setPenetrationCorrectionEnabled(bool enable);
@@ -672,6 +828,51 @@ public:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t getContactClippingDepth();
 
+  /// If this is non-zero, we keep at most this many contacts between each pair
+  /// of colliding shapes, picking the ones that cover the most area. This
+  /// keeps the LCP (and the cost of backprop through it) bounded when meshes
+  /// or boxes rest flat on each other. The default is 0, which keeps every
+  /// contact.
+  void setMaxNumContactsPerPair(std::size_t maxNumContacts);
+
+  /// Returns the most contacts we keep between each pair of colliding shapes,
+  /// or 0 if we keep every contact
+  std::size_t getMaxNumContactsPerPair();
+
+  /// False by default. If this is true, collision detection also looks one
+  /// timestep ahead, and adds contacts for spheres, capsules and boxes that
+  /// would otherwise pass through each other during the step. This lets thin
+  /// or fast objects run at a larger timestep without tunneling. See
+  /// collision::CollisionOption::continuousCollisionTimeStep.
+  void setContinuousCollisionEnabled(bool enable);
+
+  bool getContinuousCollisionEnabled();
+
+  /// False by default. If this is true, contacts between rigid bodies push
+  /// back with a closed-form spring-damper force (see
+  /// constraint::CompliantContact), rather than being solved as hard
+  /// constraints in the LCP. This lets bodies inter-penetrate a little, but
+  /// each contact costs a constant amount to compute and differentiate, and
+  /// the gradients are smooth, which is often a better trade for training
+  /// controllers. Gradients flow through the compliant contact forces in
+  /// neural::BackpropSnapshot.
+  void setCompliantContactEnabled(bool enable);
+
+  bool getCompliantContactEnabled();
+
+  /// Sets the spring constant for compliant contacts, in N/m of penetration.
+  /// Stiffer contacts penetrate less, but need a smaller timestep to stay
+  /// stable.
+  void setCompliantContactStiffness(s_t stiffness);
+
+  s_t getCompliantContactStiffness();
+
+  /// Sets the damping constant for compliant contacts, in N/(m/s) of
+  /// approach velocity
+  void setCompliantContactDamping(s_t damping);
+
+  s_t getCompliantContactDamping();
+
   /// This returns the object that we're using to keep track of which objects in
   /// the world need gradients through which kinds of mass.
   std::shared_ptr<neural::WithRespectToMass> getWrtMass();
@@ -687,6 +888,23 @@ public:
   /// already have the original world loaded. Good for real-time viewing.
   std::string colorsToJson();
 
+  /// This is the same as positionsToJson(), except that it only includes the
+  /// bodies whose position or Euler angles have moved by more than `epsilon`
+  /// since the last time this sent them. That keeps streaming cost in line
+  /// with how much is moving, rather than with how big the scene is. The
+  /// first call after a reset sends every body.
+  std::string positionsToJson(s_t epsilon);
+
+  /// This is the same as colorsToJson(), except that it only includes the
+  /// bodies with a color that's changed by more than `epsilon` since the last
+  /// time this sent them. The first call after a reset sends every body.
+  std::string colorsToJson(s_t epsilon);
+
+  /// This forgets what positionsToJson(epsilon) and colorsToJson(epsilon)
+  /// have sent, so the next calls send everything. Call this when a new
+  /// viewer connects.
+  void resetJsonDiffs();
+
   /// This gets the cached LCP solution, which is useful to be able to get/set
   /// because it can effect the forward solutions of physics problems because of
   /// our optimistic LCP-stabilization-to-acceptance approach.
@@ -714,6 +932,27 @@ public:
 
   void DisableWrtMass();
 
+  /// If this is true, neural::forwardPass() draws its BackpropSnapshots from
+  /// this World's SnapshotPool, and they get recycled once they're released,
+  /// instead of being allocated from scratch on every step. False by default.
+  void setSnapshotPoolEnabled(bool enabled);
+
+  bool getSnapshotPoolEnabled();
+
+  /// This returns the pool of BackpropSnapshots owned by this World, creating
+  /// it if necessary.
+  std::shared_ptr<neural::SnapshotPool> getSnapshotPool();
+
+  /// This sets the number of threads BackpropSnapshot uses to compute
+  /// Jacobians by finite differencing (see setUseFDOverride()), each
+  /// perturbing its own clone of this World. The default of 1 perturbs this
+  /// World directly on the calling thread. If `numThreads` is <= 0, we use
+  /// std::thread::hardware_concurrency(). Results are identical regardless of
+  /// the number of threads.
+  void setNumFDThreads(int numThreads);
+
+  int getNumFDThreads();
+
 protected:
   /// If this is true, we use finite-differencing to compute all of the
   /// requested Jacobians. This override can be useful to verify if there's a
@@ -784,6 +1023,10 @@ protected:
   /// Current simulation frame number
   int mFrame;
 
+  /// The parts of StepTimings that World::step() measures itself, the rest
+  /// come from the constraint solver
+  StepTimings mStepTimings;
+
   /// Constraint solver
   std::unique_ptr<constraint::ConstraintSolver> mConstraintSolver;
 
@@ -804,6 +1047,24 @@ protected:
   /// environments. True by default.
   bool mParallelVelocityAndPositionUpdates;
 
+  /// True if step() should update each Skeleton on its own task. See
+  /// setParallelSkeletonUpdatesEnabled().
+  bool mParallelSkeletonUpdatesEnabled;
+
+  /// See setSleepingEnabled()
+  bool mSleepingEnabled;
+  s_t mSleepVelocityThreshold;
+  int mSleepSteps;
+
+  /// How many steps in a row each Skeleton has been at rest, by index
+  std::vector<int> mStepsAtRest;
+
+  /// The positions each sleeping Skeleton fell asleep at, by index
+  std::vector<Eigen::VectorXs> mSleepPositions;
+
+  /// mSkeletonsVersion as of the last time mStepsAtRest was reset
+  std::size_t mStepsAtRestVersion;
+
   /// True if we want to enable artificial penetration correction forces
   bool mPenetrationCorrectionEnabled;
 
@@ -825,6 +1086,23 @@ protected:
   /// impossibly deep inter-penetration during multiple shooting optimization.
   s_t mContactClippingDepth;
 
+  /// The most contacts we keep between each pair of colliding shapes, or 0 to
+  /// keep every contact
+  std::size_t mMaxNumContactsPerPair;
+
+  /// True if collision detection looks one timestep ahead for tunneling
+  bool mContinuousCollisionEnabled;
+
+  /// True if rigid contacts are resolved with spring-damper forces, rather
+  /// than the LCP
+  bool mCompliantContactEnabled;
+
+  /// The spring constant for compliant contacts
+  s_t mCompliantContactStiffness;
+
+  /// The damping constant for compliant contacts
+  s_t mCompliantContactDamping;
+
   //--------------------------------------------------------------------------
   // Signals
   //--------------------------------------------------------------------------
@@ -845,11 +1123,67 @@ protected:
   /// necessary
   std::shared_ptr<neural::BackpropSnapshot> getCachedBackpropSnapshot();
 
+  /// True if forwardPass() should draw snapshots from mSnapshotPool
+  bool mSnapshotPoolEnabled;
+
+  /// The pool of recycled snapshots, created lazily by getSnapshotPool()
+  std::shared_ptr<neural::SnapshotPool> mSnapshotPool;
+
+  /// The number of threads to split finite differenced columns across
+  int mNumFDThreads;
+
+  /// The last positions and Euler angles, and the last colors, that
+  /// positionsToJson(epsilon) and colorsToJson(epsilon) sent for each body,
+  /// keyed by the same "skel.node" names they use in the JSON
+  std::unordered_map<std::string, Eigen::Vector6s> mLastJsonPositions;
+  std::unordered_map<std::string, Eigen::VectorXs> mLastJsonColors;
+
   std::shared_ptr<neural::BackpropSnapshot> mCachedSnapshotPtr;
   Eigen::VectorXs mCachedSnapshotPos;
   Eigen::VectorXs mCachedSnapshotVel;
   Eigen::VectorXs mCachedSnapshotForce;
 
+  /// The vectors that getGroupMasses(), getLinkMasses() and friends cache
+  enum InertiaVector
+  {
+    LINK_MASSES = 0,
+    LINK_COMS,
+    LINK_MOIS,
+    GROUP_MASSES,
+    GROUP_MASSES_UPPER_BOUND,
+    GROUP_MASSES_LOWER_BOUND,
+    GROUP_COMS,
+    GROUP_COMS_UPPER_BOUND,
+    GROUP_COMS_LOWER_BOUND,
+    GROUP_INERTIAS,
+    GROUP_INERTIAS_UPPER_BOUND,
+    GROUP_INERTIAS_LOWER_BOUND,
+    NUM_INERTIA_VECTORS
+  };
+
+  /// This returns the cached copy of `vector`, first filling it from
+  /// `assemble` if it isn't cached, or the cache has gone stale
+  const Eigen::VectorXs& getCachedInertiaVector(
+      InertiaVector vector, const std::function<Eigen::VectorXs()>& assemble);
+
+  /// Returns true if no Skeleton's inertia has changed, and no Skeleton has
+  /// been added or removed, since resetInertiaCache()
+  bool isInertiaCacheCurrent() const;
+
+  /// This throws away every cached inertia vector, and records the current
+  /// versions
+  void resetInertiaCache();
+
+  /// This counts calls to addSkeleton() and removeSkeleton()
+  std::size_t mSkeletonsVersion;
+
+  /// mSkeletonsVersion, followed by Skeleton::getInertiaVersion() for every
+  /// Skeleton, as of the last resetInertiaCache()
+  std::vector<std::size_t> mInertiaCacheVersions;
+
+  Eigen::VectorXs mInertiaVectors[NUM_INERTIA_VECTORS];
+  bool mInertiaVectorCached[NUM_INERTIA_VECTORS];
+
 public:
   //--------------------------------------------------------------------------
   // Slot registers
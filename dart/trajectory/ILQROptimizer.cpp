@@ -0,0 +1,445 @@
+#include "dart/trajectory/ILQROptimizer.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "dart/common/Console.hpp"
+#include "dart/common/TaskScheduler.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/SingleShot.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+
+using namespace dart;
+using namespace simulation;
+using namespace neural;
+
+namespace dart {
+namespace trajectory {
+
+namespace {
+
+/// How much we scale the regularization by when we raise or lower it, and the
+/// range we keep it in
+const s_t REGULARIZATION_FACTOR = 10.0;
+const s_t MIN_REGULARIZATION = 1e-8;
+const s_t MAX_REGULARIZATION = 1e10;
+
+} // namespace
+
+//==============================================================================
+ILQROptimizer::ILQROptimizer()
+  : mIterationLimit(100),
+    mTolerance(1e-7),
+    mLineSearchCandidates(8),
+    mNumThreads(0),
+    mRegularization(1e-6),
+    mFiniteDifferenceStep(1e-6),
+    mSilent(false),
+    mShot(nullptr)
+{
+}
+
+//==============================================================================
+std::shared_ptr<Solution> ILQROptimizer::optimize(
+    Problem* problem, std::shared_ptr<Solution> reuseRecord)
+{
+  std::shared_ptr<Solution> record
+      = reuseRecord ? reuseRecord : std::make_shared<Solution>();
+
+  mShot = dynamic_cast<SingleShot*>(problem);
+  if (mShot == nullptr)
+  {
+    dterr << "ILQROptimizer only supports SingleShot problems. Leaving the "
+          << "problem as it is.\n";
+    return record;
+  }
+  if (problem->getMappings().size() != 1 || !problem->hasMapping("identity"))
+  {
+    dterr << "ILQROptimizer only supports problems with just the "
+          << "\"identity\" mapping. Leaving the problem as it is.\n";
+    return record;
+  }
+
+  std::shared_ptr<World> world = problem->mWorld;
+  const int dofs = world->getNumDofs();
+  const int steps = problem->getNumSteps();
+
+  int numThreads = mNumThreads;
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  const int numCandidates = std::max(1, mLineSearchCandidates);
+  const int poolSize
+      = std::max(1, std::min(numThreads, std::max(numCandidates, steps)));
+  mWorlds.clear();
+  for (int i = 0; i < poolSize; i++)
+  {
+    mWorlds.push_back(world->clone());
+  }
+
+  mForceUpperLimits = world->getControlForceUpperLimits();
+  mForceLowerLimits = world->getControlForceLowerLimits();
+  mPinned.resize(steps);
+  Rollout nominal;
+  nominal.states = Eigen::MatrixXs::Zero(2 * dofs, steps + 1);
+  nominal.states.col(0).head(dofs) = mShot->getStartPos();
+  nominal.states.col(0).tail(dofs) = mShot->getStartVel();
+  nominal.forces
+      = problem->getRolloutCache(world)->getControlForcesConst("identity");
+  for (int t = 0; t < steps; t++)
+  {
+    mPinned[t] = mShot->isForcePinned(t);
+    if (mPinned[t])
+    {
+      nominal.forces.col(t) = mShot->getPinnedForce(t);
+    }
+  }
+  mWorlds[0]->setCachedLCPSolution(world->getCachedLCPSolution());
+  simulate(mWorlds[0], nullptr, 0.0, nominal);
+  nominal.loss = getLoss(problem, nominal);
+
+  std::vector<Rollout> candidates(numCandidates);
+  s_t regularization = mRegularization;
+  bool converged = false;
+  bool nominalChanged = true;
+  for (int i = 0; i < mIterationLimit; i++)
+  {
+    if (!mSilent)
+    {
+      std::cout << "Iter " << i << ": " << nominal.loss << std::endl;
+    }
+
+    // If the last line search failed we're still at the same trajectory, and
+    // only need to redo the backward pass with more regularization
+    if (nominalChanged)
+    {
+      linearize(nominal);
+      quadratizeLoss(problem, nominal);
+      nominalChanged = false;
+    }
+
+    while (!backwardPass(regularization))
+    {
+      regularization *= REGULARIZATION_FACTOR;
+      if (regularization > MAX_REGULARIZATION)
+        break;
+    }
+    if (regularization > MAX_REGULARIZATION)
+    {
+      if (!mSilent)
+      {
+        std::cout << "Regularization exceeded its limit, stopping."
+                  << std::endl;
+      }
+      break;
+    }
+
+    // Roll out every step size in parallel, each candidate on whichever world
+    // its index lands on, and then evaluate the losses on this thread
+    std::vector<common::TaskFuture<void>> futures;
+    for (int worker = 0; worker < poolSize && worker < numCandidates; worker++)
+    {
+      futures.push_back(common::async([&, worker]() {
+        for (int k = worker; k < numCandidates; k += poolSize)
+        {
+          const s_t alpha = 1.0 / (s_t)(1 << std::min(k, 30));
+          mWorlds[worker]->setCachedLCPSolution(nominal.lcpCaches[0]);
+          simulate(mWorlds[worker], &nominal, alpha, candidates[k]);
+        }
+      }));
+    }
+    for (auto& future : futures)
+    {
+      future.get();
+    }
+    int best = 0;
+    for (int k = 0; k < numCandidates; k++)
+    {
+      candidates[k].loss = getLoss(problem, candidates[k]);
+      if (candidates[k].loss < candidates[best].loss)
+        best = k;
+    }
+
+    if (candidates[best].loss >= nominal.loss)
+    {
+      regularization *= REGULARIZATION_FACTOR;
+      if (regularization > MAX_REGULARIZATION)
+      {
+        if (!mSilent)
+        {
+          std::cout << "Line search found no improvement, converged."
+                    << std::endl;
+        }
+        converged = true;
+        break;
+      }
+      continue;
+    }
+
+    const s_t improvement = nominal.loss - candidates[best].loss;
+    std::swap(nominal, candidates[best]);
+    nominalChanged = true;
+    regularization
+        = std::max(MIN_REGULARIZATION, regularization / REGULARIZATION_FACTOR);
+    mShot->setControlForcesRaw(nominal.forces);
+
+    bool keepGoing = true;
+    for (auto callback : mIntermediateCallbacks)
+    {
+      if (!callback(problem, i, nominal.loss, 0.0))
+        keepGoing = false;
+    }
+    if (!keepGoing)
+      break;
+
+    if (improvement < mTolerance)
+    {
+      if (!mSilent)
+      {
+        std::cout << "Improvement less than tolerance, converged."
+                  << std::endl;
+      }
+      converged = true;
+      break;
+    }
+  }
+
+  mShot->setControlForcesRaw(nominal.forces);
+  record->setSuccess(converged);
+
+  mWorlds.clear();
+  mShot = nullptr;
+  return record;
+}
+
+//==============================================================================
+void ILQROptimizer::simulate(
+    std::shared_ptr<simulation::World> world,
+    const Rollout* nominal,
+    s_t alpha,
+    /* OUT */ Rollout& rollout)
+{
+  const int dofs = world->getNumDofs();
+  const int steps = mPinned.size();
+  if (nominal != nullptr)
+  {
+    rollout.states = nominal->states;
+    rollout.forces = nominal->forces;
+  }
+  rollout.lcpCaches.resize(steps);
+
+  world->setPositions(rollout.states.col(0).head(dofs));
+  world->setVelocities(rollout.states.col(0).tail(dofs));
+  for (int t = 0; t < steps; t++)
+  {
+    if (nominal != nullptr && !mPinned[t])
+    {
+      Eigen::VectorXs force = nominal->forces.col(t)
+                              + alpha * mFeedforward.col(t)
+                              + mFeedback[t]
+                                    * (rollout.states.col(t)
+                                       - nominal->states.col(t));
+      rollout.forces.col(t)
+          = force.cwiseMax(mForceLowerLimits).cwiseMin(mForceUpperLimits);
+    }
+    rollout.lcpCaches[t] = world->getCachedLCPSolution();
+    world->setControlForces(rollout.forces.col(t));
+    // We step through forwardPass(), rather than World::step(), so that we
+    // take exactly the same steps as the shot does when it computes its loss
+    forwardPass(world);
+    rollout.states.col(t + 1).head(dofs) = world->getPositions();
+    rollout.states.col(t + 1).tail(dofs) = world->getVelocities();
+  }
+}
+
+//==============================================================================
+s_t ILQROptimizer::getLoss(Problem* problem, const Rollout& rollout)
+{
+  const int dofs = rollout.forces.rows();
+  const int steps = rollout.forces.cols();
+  TrajectoryRolloutReal trajectory(problem);
+  trajectory.getPoses() = rollout.states.block(0, 1, dofs, steps);
+  trajectory.getVels() = rollout.states.block(dofs, 1, dofs, steps);
+  trajectory.getControlForces() = rollout.forces;
+  trajectory.getMasses() = problem->mWorld->getMasses();
+  return problem->mLoss.getLoss(&trajectory);
+}
+
+//==============================================================================
+void ILQROptimizer::linearize(const Rollout& rollout)
+{
+  const int dofs = rollout.forces.rows();
+  const int steps = rollout.forces.cols();
+  mStateJacs.resize(steps);
+  mForceVelJacs.resize(steps);
+
+  // Each thread re-simulates its own stretch of the trajectory, starting from
+  // the state and LCP warm start we recorded on the way through, so that each
+  // snapshot's Jacobians get computed on the world that took the step
+  const int numThreads = std::min((int)mWorlds.size(), steps);
+  std::vector<common::TaskFuture<void>> futures;
+  for (int thread = 0; thread < numThreads; thread++)
+  {
+    const int start = (steps * thread) / numThreads;
+    const int end = (steps * (thread + 1)) / numThreads;
+    std::shared_ptr<World> world = mWorlds[thread];
+    futures.push_back(common::async([&, start, end, world]() {
+      world->setCachedLCPSolution(rollout.lcpCaches[start]);
+      for (int t = start; t < end; t++)
+      {
+        world->setPositions(rollout.states.col(t).head(dofs));
+        world->setVelocities(rollout.states.col(t).tail(dofs));
+        world->setControlForces(rollout.forces.col(t));
+        std::shared_ptr<BackpropSnapshot> snapshot = forwardPass(world);
+        // The Jacobians expect the world to be in the state before the step
+        world->setPositions(rollout.states.col(t).head(dofs));
+        world->setVelocities(rollout.states.col(t).tail(dofs));
+        mStateJacs[t] = snapshot->getStateJacobian(world);
+        mForceVelJacs[t] = snapshot->getControlForceVelJacobian(world);
+      }
+    }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+}
+
+//==============================================================================
+void ILQROptimizer::quadratizeLoss(Problem* problem, const Rollout& rollout)
+{
+  const int dofs = rollout.forces.rows();
+  const int steps = rollout.forces.cols();
+
+  TrajectoryRolloutReal trajectory(problem);
+  TrajectoryRolloutReal grad(problem);
+  trajectory.getPoses() = rollout.states.block(0, 1, dofs, steps);
+  trajectory.getVels() = rollout.states.block(dofs, 1, dofs, steps);
+  trajectory.getControlForces() = rollout.forces;
+  trajectory.getMasses() = problem->mWorld->getMasses();
+  std::vector<Eigen::MatrixXs> hessians;
+  problem->mLoss.getLossGradientAndTimestepHessians(
+      &trajectory, &grad, hessians, mFiniteDifferenceStep);
+
+  // Rollout column t is the state after step t, which is state t + 1 here
+  mLossWrtStates = Eigen::MatrixXs::Zero(2 * dofs, steps + 1);
+  mLossWrtStates.block(0, 1, dofs, steps) = grad.getPosesConst();
+  mLossWrtStates.block(dofs, 1, dofs, steps) = grad.getVelsConst();
+  mLossWrtForces = grad.getControlForcesConst();
+  mLossStateHessians.assign(
+      steps + 1, Eigen::MatrixXs::Zero(2 * dofs, 2 * dofs));
+  mLossForceHessians.resize(steps);
+  for (int t = 0; t < steps; t++)
+  {
+    mLossStateHessians[t + 1] = hessians[t].topLeftCorner(2 * dofs, 2 * dofs);
+    mLossForceHessians[t] = hessians[t].bottomRightCorner(dofs, dofs);
+  }
+}
+
+//==============================================================================
+bool ILQROptimizer::backwardPass(s_t regularization)
+{
+  const int steps = mStateJacs.size();
+  const int dofs = mLossWrtForces.rows();
+  mFeedforward = Eigen::MatrixXs::Zero(dofs, steps);
+  mFeedback.assign(steps, Eigen::MatrixXs::Zero(dofs, 2 * dofs));
+
+  Eigen::VectorXs valueGrad = mLossWrtStates.col(steps);
+  Eigen::MatrixXs valueHessian = mLossStateHessians[steps];
+  for (int t = steps - 1; t >= 0; t--)
+  {
+    const Eigen::MatrixXs& A = mStateJacs[t];
+    // The force Jacobian is zero on the position rows, so we only ever need
+    // the velocity rows of the value function terms it multiplies
+    const Eigen::MatrixXs& B = mForceVelJacs[t];
+
+    const Eigen::MatrixXs hessianA = valueHessian * A;
+    const Eigen::VectorXs Qx
+        = mLossWrtStates.col(t) + A.transpose() * valueGrad;
+    const Eigen::VectorXs Qu
+        = mLossWrtForces.col(t) + B.transpose() * valueGrad.tail(dofs);
+    const Eigen::MatrixXs Qxx
+        = mLossStateHessians[t] + A.transpose() * hessianA;
+    const Eigen::MatrixXs Qux = B.transpose() * hessianA.bottomRows(dofs);
+    const Eigen::MatrixXs Quu
+        = mLossForceHessians[t]
+          + B.transpose() * valueHessian.bottomRightCorner(dofs, dofs) * B;
+
+    if (mPinned[t])
+    {
+      valueGrad = Qx;
+      valueHessian = Qxx;
+      continue;
+    }
+
+    Eigen::LLT<Eigen::MatrixXs> llt(
+        Quu + regularization * Eigen::MatrixXs::Identity(dofs, dofs));
+    if (llt.info() != Eigen::Success)
+    {
+      return false;
+    }
+    const Eigen::VectorXs k = -llt.solve(Qu);
+    const Eigen::MatrixXs K = -llt.solve(Qux);
+    mFeedforward.col(t) = k;
+    mFeedback[t] = K;
+
+    // These use the unregularized Quu, so the value function stays true to
+    // the quadratic model even while we're taking cautious steps
+    valueGrad = Qx + K.transpose() * (Quu * k) + K.transpose() * Qu
+                + Qux.transpose() * k;
+    valueHessian = Qxx + K.transpose() * Quu * K + K.transpose() * Qux
+                   + Qux.transpose() * K;
+    valueHessian = 0.5 * (valueHessian + valueHessian.transpose()).eval();
+  }
+  return true;
+}
+
+//==============================================================================
+void ILQROptimizer::setIterationLimit(int iterationLimit)
+{
+  mIterationLimit = iterationLimit;
+}
+
+//==============================================================================
+void ILQROptimizer::setTolerance(s_t tolerance)
+{
+  mTolerance = tolerance;
+}
+
+//==============================================================================
+void ILQROptimizer::setLineSearchCandidates(int numCandidates)
+{
+  mLineSearchCandidates = numCandidates;
+}
+
+//==============================================================================
+void ILQROptimizer::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+}
+
+//==============================================================================
+void ILQROptimizer::setRegularization(s_t regularization)
+{
+  mRegularization = regularization;
+}
+
+//==============================================================================
+void ILQROptimizer::setFiniteDifferenceStep(s_t eps)
+{
+  mFiniteDifferenceStep = eps;
+}
+
+//==============================================================================
+void ILQROptimizer::setSilenceOutput(bool silent)
+{
+  mSilent = silent;
+}
+
+} // namespace trajectory
+} // namespace dart
@@ -0,0 +1,161 @@
+#ifndef DART_TRAJECTORY_ILQR_OPTIMIZER_HPP_
+#define DART_TRAJECTORY_ILQR_OPTIMIZER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "dart/trajectory/Optimizer.hpp"
+#include "dart/trajectory/Problem.hpp"
+#include "dart/trajectory/Solution.hpp"
+#include "dart/trajectory/TrajectoryConstants.hpp"
+
+namespace dart {
+
+namespace simulation {
+class World;
+}
+
+namespace trajectory {
+
+class SingleShot;
+
+/*
+ * This is iterative LQR (DDP without the second order dynamics terms) for
+ * SingleShot problems. Each iteration linearizes the dynamics around the
+ * current trajectory using the state and control force Jacobians of each
+ * BackpropSnapshot, fits a quadratic to the loss at each timestep, and runs a
+ * Riccati backward pass to get a feedforward step and feedback gains for every
+ * timestep. A forward pass then rolls out several step sizes along those gains
+ * at once, each on its own world, and keeps the best. Every part of an
+ * iteration is linear in the number of timesteps.
+ *
+ * A LossFn only gives us a gradient, so we get the loss Hessian by finite
+ * differencing the gradient, nudging the same coordinate at every timestep at
+ * once. That's (3 * dofs) extra loss evaluations per iteration, made in a
+ * single batch, and it's exact for losses that are a sum over timesteps (like
+ * all the built-in LossFn's). Any coupling between timesteps is ignored.
+ *
+ * The start state, the masses and any pinned forces are held fixed, and only
+ * the "identity" mapping is supported.
+ */
+class ILQROptimizer : public Optimizer
+{
+public:
+  ILQROptimizer();
+
+  virtual ~ILQROptimizer() = default;
+
+  /// This optimizes the control forces of `problem`, which must be a
+  /// SingleShot. Calling this again on the same problem (for example after
+  /// Problem::advanceSteps()) warm starts from the forces already in it.
+  std::shared_ptr<Solution> optimize(
+      Problem* problem, std::shared_ptr<Solution> reuseRecord = nullptr)
+      override;
+
+  void setIterationLimit(int iterationLimit);
+
+  /// We stop once an iteration improves the loss by less than this
+  void setTolerance(s_t tolerance);
+
+  /// Each forward pass tries this many step sizes (1, then 1/2, then 1/4,
+  /// ...) in parallel, and keeps whichever gives the lowest loss. Defaults to
+  /// 8.
+  void setLineSearchCandidates(int numCandidates);
+
+  /// This sets how many threads run the line search rollouts and linearize
+  /// the dynamics. If this is <= 0, we use one thread per hardware core.
+  /// Defaults to 0.
+  void setNumThreads(int numThreads);
+
+  /// This is the starting value of the Levenberg-Marquardt term added to the
+  /// control Hessian. We raise it by 10x whenever a backward pass hits a
+  /// Hessian that isn't positive definite, or no step size improves the loss,
+  /// and lower it by 10x after every successful step. Defaults to 1e-6.
+  void setRegularization(s_t regularization);
+
+  /// This is how far we nudge each coordinate when finite differencing the
+  /// loss gradient. Defaults to 1e-6.
+  void setFiniteDifferenceStep(s_t eps);
+
+  /// If true, we don't print progress on every iteration
+  void setSilenceOutput(bool silent);
+
+protected:
+  /// A rollout of the shot, along with the LCP warm starts the world used on
+  /// every step, so that any stretch of it can be re-simulated exactly
+  struct Rollout
+  {
+    /// (2 * dofs) x (steps + 1), with the start state in the first column
+    Eigen::MatrixXs states;
+    /// dofs x steps
+    Eigen::MatrixXs forces;
+    std::vector<Eigen::VectorXs> lcpCaches;
+    s_t loss;
+  };
+
+  /// This simulates `rollout` forward from the start of the shot on `world`,
+  /// applying forces along the current gains with step size `alpha` around
+  /// `nominal`. If `nominal` is null, this just applies `rollout.forces`.
+  void simulate(
+      std::shared_ptr<simulation::World> world,
+      const Rollout* nominal,
+      s_t alpha,
+      /* OUT */ Rollout& rollout);
+
+  /// This evaluates the loss of `rollout` on `problem`
+  s_t getLoss(Problem* problem, const Rollout& rollout);
+
+  /// This fills mStateJacs and mForceVelJacs along `rollout`, re-simulating
+  /// a contiguous stretch of it on each of the worlds in mWorlds.
+  void linearize(const Rollout& rollout);
+
+  /// This fills the per-timestep loss gradients and Hessians along `rollout`
+  void quadratizeLoss(Problem* problem, const Rollout& rollout);
+
+  /// This runs the Riccati recursion to fill mFeedforward and mFeedback.
+  /// Returns false if the regularized control Hessian wasn't positive definite
+  /// at some timestep.
+  bool backwardPass(s_t regularization);
+
+  int mIterationLimit;
+  s_t mTolerance;
+  int mLineSearchCandidates;
+  int mNumThreads;
+  s_t mRegularization;
+  s_t mFiniteDifferenceStep;
+  bool mSilent;
+
+  /// The shot being optimized, and which of its timesteps have pinned forces
+  SingleShot* mShot;
+  std::vector<bool> mPinned;
+  Eigen::VectorXs mForceUpperLimits;
+  Eigen::VectorXs mForceLowerLimits;
+
+  /// Clones of the shot's world, one per thread. These are created once per
+  /// optimize() call and reused on every iteration.
+  std::vector<std::shared_ptr<simulation::World>> mWorlds;
+
+  /// The dynamics around the current trajectory. Control forces only move the
+  /// velocities directly, so for each step we only keep that block.
+  std::vector<Eigen::MatrixXs> mStateJacs;
+  std::vector<Eigen::MatrixXs> mForceVelJacs;
+
+  /// The loss around the current trajectory. The state terms are indexed from
+  /// 0 (the start state) to steps, and the force terms from 0 to steps - 1.
+  Eigen::MatrixXs mLossWrtStates;
+  Eigen::MatrixXs mLossWrtForces;
+  std::vector<Eigen::MatrixXs> mLossStateHessians;
+  std::vector<Eigen::MatrixXs> mLossForceHessians;
+
+  /// The result of the backward pass: the step at timestep t is
+  /// mFeedforward.col(t) + mFeedback[t] * (x_t - nominal x_t)
+  Eigen::MatrixXs mFeedforward;
+  std::vector<Eigen::MatrixXs> mFeedback;
+};
+
+} // namespace trajectory
+} // namespace dart
+
+#endif
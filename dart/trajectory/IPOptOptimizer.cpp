@@ -9,7 +9,9 @@
 #include "dart/performance/PerformanceLog.hpp"
 #include "dart/trajectory/IPOptShotWrapper.hpp"
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_IPOPT
+#endif
 
 using namespace dart;
 using namespace simulation;
@@ -33,7 +35,8 @@ IPOptOptimizer::IPOptOptimizer()
     mSuppressOutput(false),
     mSilenceOutput(false),
     mDisableLinesearch(false),
-    mRecordIterations(true)
+    mRecordIterations(true),
+    mGaussNewtonHessian(false)
 {
 }
 
@@ -55,8 +58,12 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       "linear_solver",
       "mumps"); // ma27, ma55, ma77, ma86, ma97, parsido, wsmp, mumps, custom
 
+  bool gaussNewtonHessian
+      = mGaussNewtonHessian
+        && shot->getNumberNonZeroGaussNewtonHessian(shot->mWorld) > 0;
   app->Options()->SetStringValue(
-      "hessian_approximation", "limited-memory"); // limited-memory, exacty
+      "hessian_approximation",
+      gaussNewtonHessian ? "exact" : "limited-memory");
 
   /*
   app->Options()->SetStringValue(
@@ -99,6 +106,7 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
 
   std::shared_ptr<Solution> record
       = reuseRecord ? reuseRecord : std::make_shared<Solution>();
+  record->setHistoryConfig(mHistoryConfig);
   if (mRecordPerfLog)
     record->startPerfLog();
 
@@ -123,7 +131,8 @@ std::shared_ptr<Solution> IPOptOptimizer::optimize(
       mRecoverBest,
       mRecordFullDebugInfo,
       mSuppressOutput && !mSilenceOutput,
-      mRecordIterations);
+      mRecordIterations,
+      gaussNewtonHessian);
   for (auto& callback : mIntermediateCallbacks)
   {
     problem->registerIntermediateCallback(callback);
@@ -225,5 +234,19 @@ void IPOptOptimizer::setRecordIterations(bool recordIterations)
   mRecordIterations = recordIterations;
 }
 
+//==============================================================================
+void IPOptOptimizer::setGaussNewtonHessian(bool gaussNewtonHessian)
+{
+  mGaussNewtonHessian = gaussNewtonHessian;
+}
+
+//==============================================================================
+/// This sets how much history the Solutions we produce keep, when we're
+/// recording iterations or full debug info
+void IPOptOptimizer::setHistoryConfig(const SolutionHistoryConfig& config)
+{
+  mHistoryConfig = config;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
@@ -61,6 +61,17 @@ public:
 
   void setRecordIterations(bool recordIterations);
 
+  /// If true, we give IPOPT the Gauss-Newton approximation to the Hessian of
+  /// the loss, built from the Jacobians of each timestep, instead of having it
+  /// run limited-memory quasi-Newton. Each iteration costs more, but on long
+  /// horizons it takes far fewer of them. Problems that can't supply the
+  /// Hessian fall back to limited-memory. Defaults to false.
+  void setGaussNewtonHessian(bool gaussNewtonHessian);
+
+  /// This sets how much history the Solutions we produce keep, when we're
+  /// recording iterations or full debug info
+  void setHistoryConfig(const SolutionHistoryConfig& config);
+
 protected:
   int mIterationLimit;
   s_t mTolerance;
@@ -74,6 +85,8 @@ protected:
   bool mSilenceOutput;
   bool mDisableLinesearch;
   bool mRecordIterations;
+  bool mGaussNewtonHessian;
+  SolutionHistoryConfig mHistoryConfig;
 };
 
 } // namespace trajectory
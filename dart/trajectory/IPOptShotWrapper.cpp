@@ -15,7 +15,9 @@
 // Make production builds happy with asserts
 #define _unused(x) ((void)(x))
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_IPOPT
+#endif
 
 using namespace dart;
 using namespace simulation;
@@ -33,7 +35,8 @@ IPOptShotWrapper::IPOptShotWrapper(
     bool recoverBest,
     bool recordFullDebugInfo,
     bool printIterations,
-    bool recordIterations)
+    bool recordIterations,
+    bool gaussNewtonHessian)
   : mWrapped(wrapped),
     mRecord(record),
     mRecoverBest(recoverBest),
@@ -43,6 +46,7 @@ IPOptShotWrapper::IPOptShotWrapper(
     mBestFeasibleObjectiveValue(std::numeric_limits<double>::infinity()),
     mBestFeasibleState(Eigen::VectorXd::Zero(0)),
     mPrintIterations(printIterations),
+    mGaussNewtonHessian(gaussNewtonHessian),
     mLastTimestep(timeSinceEpochMillis()),
     mNewXs(0),
     mFCalls(0),
@@ -80,8 +84,14 @@ bool IPOptShotWrapper::get_nlp_info(
   // Set the number of entries in the constraint Jacobian
   nnz_jac_g = mWrapped->getNumberNonZeroJacobian(mWrapped->mWorld);
 
-  // Set the number of entries in the Hessian
-  nnz_h_lag = n * n;
+  // Unless we're supplying the Gauss-Newton Hessian, IPOPT runs with a
+  // limited-memory approximation and never calls eval_h(), so don't claim a
+  // dense n x n one. That count grows quadratically with the horizon, and
+  // overflows an Ipopt::Index for long trajectories.
+  nnz_h_lag = mGaussNewtonHessian
+                  ? mWrapped->getNumberNonZeroGaussNewtonHessian(
+                      mWrapped->mWorld)
+                  : 0;
 
   // use the C style indexing (0-based)
   index_style = Ipopt::TNLP::C_STYLE;
@@ -534,12 +544,16 @@ bool IPOptShotWrapper::eval_jac_g(
       }
       std::cout << "Jac eval " << mRecord->getSparseJacobians().size()
                 << std::endl;
+      // Skip the copy if the record is just going to drop it
+      if (mRecord->getHistoryConfig().recordSparseJacobians)
+      {
 #ifdef DART_USE_ARBITRARY_PRECISION
-      Eigen::VectorXs sparse_s = sparse.cast<s_t>();
-      mRecord->registerSparseJac(sparse_s);
+        Eigen::VectorXs sparse_s = sparse.cast<s_t>();
+        mRecord->registerSparseJac(sparse_s);
 #else
-      mRecord->registerSparseJac(sparse);
+        mRecord->registerSparseJac(sparse);
 #endif
+      }
     }
 
     /*
@@ -569,36 +583,77 @@ bool IPOptShotWrapper::eval_jac_g(
 
 //==============================================================================
 bool IPOptShotWrapper::eval_h(
-    Ipopt::Index /* _n */,
-    const Ipopt::Number* /* _x */,
-    bool /* _new_x */,
-    Ipopt::Number /* _obj_factor */,
+    Ipopt::Index _n,
+    const Ipopt::Number* _x,
+    bool _new_x,
+    Ipopt::Number _obj_factor,
     Ipopt::Index /* _m */,
     const Ipopt::Number* /* _lambda */,
     bool /* _new_lambda */,
-    Ipopt::Index /* _nele_hess */,
-    Ipopt::Index* /* _iRow */,
-    Ipopt::Index* /* _jCol */,
-    Ipopt::Number* /* _values */)
+    Ipopt::Index _nele_hess,
+    Ipopt::Index* _iRow,
+    Ipopt::Index* _jCol,
+    Ipopt::Number* _values)
 {
-  // TODO(JS): Not implemented yet.
-  std::cout << "[IPOptShotWrapper::eval_h] Not implemented yet.\n";
+  if (!mGaussNewtonHessian)
+  {
+    std::cout << "[IPOptShotWrapper::eval_h] Only the Gauss-Newton Hessian is "
+                 "implemented.\n";
+    return false;
+  }
 
-  /*
-  return TNLP::eval_h(
-      _n,
-      _x,
-      _new_x,
-      _obj_factor,
-      _m,
-      _lambda,
-      _new_lambda,
-      _nele_hess,
-      _iRow,
-      _jCol,
-      _values);
-      */
-  return false;
+  PerformanceLog* perflog = nullptr;
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (mRecord->getPerfLog() != nullptr)
+  {
+    perflog = mRecord->getPerfLog()->startRun("IPOptShotWrapper.eval_h");
+  }
+#endif
+
+  // This is the Gauss-Newton Hessian of the loss alone. The constraints are
+  // the knot points, whose curvature comes from the second derivatives of the
+  // dynamics, which Gauss-Newton drops anyway, so the multipliers are unused.
+  if (nullptr == _values)
+  {
+    assert(
+        _nele_hess
+        == mWrapped->getNumberNonZeroGaussNewtonHessian(mWrapped->mWorld));
+    Eigen::Map<Eigen::VectorXi> rows(_iRow, _nele_hess);
+    Eigen::Map<Eigen::VectorXi> cols(_jCol, _nele_hess);
+    mWrapped->getGaussNewtonHessianStructure(
+        mWrapped->mWorld, rows, cols, perflog);
+  }
+  else
+  {
+    if (_new_x && _n > 0)
+    {
+      Eigen::Map<const Eigen::VectorXd> flat(_x, _n);
+#ifdef DART_USE_ARBITRARY_PRECISION
+      Eigen::VectorXs flat_s = flat.cast<s_t>();
+      mWrapped->unflatten(mWrapped->mWorld, flat_s, perflog);
+#else
+      mWrapped->unflatten(mWrapped->mWorld, flat, perflog);
+#endif
+    }
+    Eigen::Map<Eigen::VectorXd> sparse(_values, _nele_hess);
+#ifdef DART_USE_ARBITRARY_PRECISION
+    Eigen::VectorXs sparse_s(_nele_hess);
+    mWrapped->getSparseGaussNewtonHessian(mWrapped->mWorld, sparse_s, perflog);
+    sparse = sparse_s.cast<double>();
+#else
+    mWrapped->getSparseGaussNewtonHessian(mWrapped->mWorld, sparse, perflog);
+#endif
+    sparse *= _obj_factor;
+  }
+
+#ifdef LOG_PERFORMANCE_IPOPT
+  if (perflog != nullptr)
+  {
+    perflog->end();
+  }
+#endif
+
+  return true;
 }
 
 //==============================================================================
@@ -773,6 +828,39 @@ void IPOptShotWrapper::prep_for_reoptimize()
   mBestIter = -1;
 }
 
+/// This moves the bound multipliers saved from the last solve to follow a
+/// shift of the problem, as returned by Problem::advanceSteps(). Variables
+/// with no predecessor get IPOPT's default initial bound multiplier. The
+/// constraint multipliers are left in place, since shifting doesn't move
+/// the knot points. This returns false (and changes nothing) if we don't
+/// have multipliers saved for a problem of this size.
+bool IPOptShotWrapper::shift_saved_multipliers(const Eigen::VectorXi& mapping)
+{
+  int n = mWrapped->getFlatProblemDim(mWrapped->mWorld);
+  int m = mWrapped->getConstraintDim();
+  if (mapping.size() != n || mSaved_zL.size() != n || mSaved_zU.size() != n
+      || mSaved_lambda.size() != m)
+  {
+    return false;
+  }
+
+  // This matches IPOPT's "bound_mult_init_val" default
+  const double defaultBoundMult = 1.0;
+  Eigen::VectorXd shifted_zL = Eigen::VectorXd::Constant(n, defaultBoundMult);
+  Eigen::VectorXd shifted_zU = Eigen::VectorXd::Constant(n, defaultBoundMult);
+  for (int i = 0; i < n; i++)
+  {
+    if (mapping(i) >= 0)
+    {
+      shifted_zL(i) = mSaved_zL(mapping(i));
+      shifted_zU(i) = mSaved_zU(mapping(i));
+    }
+  }
+  mSaved_zL = shifted_zL;
+  mSaved_zU = shifted_zU;
+  return true;
+}
+
 /// This records a single call of eval_f(). If this returns false, then we
 /// need to terminate this call to eval_f().
 bool IPOptShotWrapper::can_eval_f(bool new_x)
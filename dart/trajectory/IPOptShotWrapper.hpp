@@ -36,7 +36,8 @@ public:
       bool recoverBest = true,
       bool recordFullDebugInfo = false,
       bool printIterations = false,
-      bool recordIterations = true);
+      bool recordIterations = true,
+      bool gaussNewtonHessian = false);
 
   /// Destructor
   ~IPOptShotWrapper();
@@ -157,6 +158,14 @@ public:
   /// This gets called when we're about to repoptimize, to let us reset values.
   void prep_for_reoptimize();
 
+  /// This moves the bound multipliers saved from the last solve to follow a
+  /// shift of the problem, as returned by Problem::advanceSteps(). Variables
+  /// with no predecessor get IPOPT's default initial bound multiplier. The
+  /// constraint multipliers are left in place, since shifting doesn't move
+  /// the knot points. This returns false (and changes nothing) if we don't
+  /// have multipliers saved for a problem of this size.
+  bool shift_saved_multipliers(const Eigen::VectorXi& mapping);
+
   /// This records a single call of eval_f(). If this returns false, then we
   /// need to terminate this call to eval_f().
   bool can_eval_f(bool new_x);
@@ -197,6 +206,8 @@ private:
   double mBestFeasibleObjectiveValue;
   Eigen::VectorXd mBestFeasibleState;
   bool mPrintIterations;
+  // If true, eval_h() supplies the Gauss-Newton Hessian of the loss
+  bool mGaussNewtonHessian;
   long mLastTimestep;
 
   int mNewXs;
@@ -2,7 +2,9 @@
 
 #include "dart/utils/tl_optional.hpp"
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_LOSS_FN
+#endif
 
 using namespace dart;
 
@@ -13,6 +15,7 @@ namespace trajectory {
 LossFn::LossFn()
   : mLoss(tl::nullopt),
     mLossAndGrad(tl::nullopt),
+    mBatchLossAndGrad(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -22,6 +25,7 @@ LossFn::LossFn()
 LossFn::LossFn(TrajectoryLossFn loss)
   : mLoss(loss),
     mLossAndGrad(tl::nullopt),
+    mBatchLossAndGrad(tl::nullopt),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -31,6 +35,17 @@ LossFn::LossFn(TrajectoryLossFn loss)
 LossFn::LossFn(TrajectoryLossFn loss, TrajectoryLossFnAndGrad lossAndGrad)
   : mLoss(loss),
     mLossAndGrad(lossAndGrad),
+    mBatchLossAndGrad(tl::nullopt),
+    mLowerBound(-std::numeric_limits<s_t>::infinity()),
+    mUpperBound(std::numeric_limits<s_t>::infinity())
+{
+}
+
+//==============================================================================
+LossFn::LossFn(TrajectoryBatchLossFnAndGrad batchLossAndGrad)
+  : mLoss(tl::nullopt),
+    mLossAndGrad(tl::nullopt),
+    mBatchLossAndGrad(batchLossAndGrad),
     mLowerBound(-std::numeric_limits<s_t>::infinity()),
     mUpperBound(std::numeric_limits<s_t>::infinity())
 {
@@ -41,6 +56,104 @@ LossFn::~LossFn()
 {
 }
 
+namespace {
+
+//==============================================================================
+/// The built-in losses only touch one mapping, so everything else in the
+/// gradient needs to be cleared first
+void zeroGradient(TrajectoryRollout* gradWrtRollout)
+{
+  for (const std::string& key : gradWrtRollout->getMappings())
+  {
+    gradWrtRollout->getPoses(key).setZero();
+    gradWrtRollout->getVels(key).setZero();
+    gradWrtRollout->getControlForces(key).setZero();
+  }
+  gradWrtRollout->getMasses().setZero();
+}
+
+} // namespace
+
+//==============================================================================
+/// This is sum_t weight * ||pos_t - targetPoses_t||^2, over every timestep
+LossFn LossFn::quadraticTracking(
+    Eigen::MatrixXs targetPoses, s_t weight, const std::string& mapping)
+{
+  TrajectoryLossFn loss
+      = [targetPoses, weight, mapping](const TrajectoryRollout* rollout) {
+          return weight
+                 * (rollout->getPosesConst(mapping) - targetPoses)
+                       .squaredNorm();
+        };
+  TrajectoryLossFnAndGrad lossAndGrad =
+      [targetPoses, weight, mapping](
+          const TrajectoryRollout* rollout,
+          /* OUT */ TrajectoryRollout* gradWrtRollout) {
+        Eigen::MatrixXs diff = rollout->getPosesConst(mapping) - targetPoses;
+        zeroGradient(gradWrtRollout);
+        gradWrtRollout->getPoses(mapping) = 2 * weight * diff;
+        return weight * diff.squaredNorm();
+      };
+  return LossFn(loss, lossAndGrad);
+}
+
+//==============================================================================
+/// This is posWeight * ||pos_end - targetPos||^2 + velWeight * ||vel_end -
+/// targetVel||^2, on the last timestep only
+LossFn LossFn::finalState(
+    Eigen::VectorXs targetPos,
+    Eigen::VectorXs targetVel,
+    s_t posWeight,
+    s_t velWeight,
+    const std::string& mapping)
+{
+  TrajectoryLossFn loss = [targetPos, targetVel, posWeight, velWeight, mapping](
+                              const TrajectoryRollout* rollout) {
+    int last = rollout->getPosesConst(mapping).cols() - 1;
+    return posWeight
+               * (rollout->getPosesConst(mapping).col(last) - targetPos)
+                     .squaredNorm()
+           + velWeight
+                 * (rollout->getVelsConst(mapping).col(last) - targetVel)
+                       .squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossAndGrad =
+      [targetPos, targetVel, posWeight, velWeight, mapping](
+          const TrajectoryRollout* rollout,
+          /* OUT */ TrajectoryRollout* gradWrtRollout) {
+        int last = rollout->getPosesConst(mapping).cols() - 1;
+        Eigen::VectorXs posDiff
+            = rollout->getPosesConst(mapping).col(last) - targetPos;
+        Eigen::VectorXs velDiff
+            = rollout->getVelsConst(mapping).col(last) - targetVel;
+        zeroGradient(gradWrtRollout);
+        gradWrtRollout->getPoses(mapping).col(last) = 2 * posWeight * posDiff;
+        gradWrtRollout->getVels(mapping).col(last) = 2 * velWeight * velDiff;
+        return posWeight * posDiff.squaredNorm()
+               + velWeight * velDiff.squaredNorm();
+      };
+  return LossFn(loss, lossAndGrad);
+}
+
+//==============================================================================
+/// This is sum_t weight * ||force_t||^2, over every timestep
+LossFn LossFn::controlEffort(s_t weight, const std::string& mapping)
+{
+  TrajectoryLossFn loss = [weight, mapping](const TrajectoryRollout* rollout) {
+    return weight * rollout->getControlForcesConst(mapping).squaredNorm();
+  };
+  TrajectoryLossFnAndGrad lossAndGrad
+      = [weight, mapping](
+            const TrajectoryRollout* rollout,
+            /* OUT */ TrajectoryRollout* gradWrtRollout) {
+          zeroGradient(gradWrtRollout);
+          gradWrtRollout->getControlForces(mapping)
+              = 2 * weight * rollout->getControlForcesConst(mapping);
+          return weight * rollout->getControlForcesConst(mapping).squaredNorm();
+        };
+  return LossFn(loss, lossAndGrad);
+}
+
 //==============================================================================
 s_t LossFn::getLoss(
     const TrajectoryRollout* rollout, PerformanceLog* perflog)
@@ -59,6 +172,15 @@ s_t LossFn::getLoss(
   {
     loss = mLoss.value()(rollout);
   }
+  else if (mBatchLossAndGrad)
+  {
+    // A batched loss always produces gradients too, so give it somewhere to
+    // put them
+    TrajectoryRolloutReal scratchGrad = TrajectoryRolloutReal(rollout);
+    Eigen::VectorXs losses = Eigen::VectorXs::Zero(1);
+    mBatchLossAndGrad.value()({rollout}, losses, {&scratchGrad});
+    loss = losses(0);
+  }
 
 #ifdef LOG_PERFORMANCE_LOSS_FN
   if (thisLog != nullptr)
@@ -90,6 +212,12 @@ s_t LossFn::getLossAndGradient(
   {
     loss = mLossAndGrad.value()(rollout, gradWrtRollout);
   }
+  else if (mBatchLossAndGrad)
+  {
+    Eigen::VectorXs losses = Eigen::VectorXs::Zero(1);
+    mBatchLossAndGrad.value()({rollout}, losses, {gradWrtRollout});
+    loss = losses(0);
+  }
   else if (mLoss)
   {
     TrajectoryRolloutReal rolloutCopy = TrajectoryRolloutReal(rollout);
@@ -186,6 +314,138 @@ s_t LossFn::getLossAndGradient(
   return loss;
 }
 
+//==============================================================================
+/// This evaluates a whole batch of rollouts at once, returning their losses
+/// and writing their gradients into `gradWrtRollouts`
+Eigen::VectorXs LossFn::getLossesAndGradients(
+    const std::vector<const TrajectoryRollout*>& rollouts,
+    /* OUT */ const std::vector<TrajectoryRollout*>& gradWrtRollouts,
+    PerformanceLog* perflog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (perflog != nullptr)
+  {
+    thisLog = perflog->startRun("LossFn.getLossesAndGradients");
+  }
+#endif
+
+  assert(rollouts.size() == gradWrtRollouts.size());
+  Eigen::VectorXs losses = Eigen::VectorXs::Zero(rollouts.size());
+
+  if (mBatchLossAndGrad)
+  {
+    mBatchLossAndGrad.value()(rollouts, losses, gradWrtRollouts);
+  }
+  else
+  {
+    for (int i = 0; i < rollouts.size(); i++)
+    {
+      losses(i)
+          = getLossAndGradient(rollouts[i], gradWrtRollouts[i], thisLog);
+    }
+  }
+
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return losses;
+}
+
+//==============================================================================
+/// This gets the loss and its gradient, along with a Hessian for every
+/// timestep of the loss wrt (pos, vel, force) in `mapping`
+s_t LossFn::getLossGradientAndTimestepHessians(
+    const TrajectoryRollout* rollout,
+    /* OUT */ TrajectoryRollout* gradWrtRollout,
+    /* OUT */ std::vector<Eigen::MatrixXs>& hessians,
+    s_t eps,
+    const std::string& mapping,
+    PerformanceLog* perflog)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (perflog != nullptr)
+  {
+    thisLog = perflog->startRun("LossFn.getLossGradientAndTimestepHessians");
+  }
+#endif
+
+  const int posDim = rollout->getPosesConst(mapping).rows();
+  const int velDim = rollout->getVelsConst(mapping).rows();
+  const int forceDim = rollout->getControlForcesConst(mapping).rows();
+  const int dims = posDim + velDim + forceDim;
+  const int steps = rollout->getPosesConst(mapping).cols();
+
+  // The first rollout is the nominal one, whose gradient goes straight into
+  // `gradWrtRollout`, and each of the others nudges one coordinate by `eps` on
+  // every timestep at once
+  std::vector<TrajectoryRolloutReal> nudged;
+  std::vector<TrajectoryRolloutReal> nudgedGrads;
+  nudged.reserve(dims);
+  nudgedGrads.reserve(dims);
+  std::vector<const TrajectoryRollout*> rollouts{rollout};
+  std::vector<TrajectoryRollout*> grads{gradWrtRollout};
+  for (int dim = 0; dim < dims; dim++)
+  {
+    nudged.emplace_back(rollout);
+    nudgedGrads.emplace_back(rollout);
+    TrajectoryRolloutReal& trajectory = nudged.back();
+    if (dim < posDim)
+      trajectory.getPoses(mapping).row(dim).array() += eps;
+    else if (dim < posDim + velDim)
+      trajectory.getVels(mapping).row(dim - posDim).array() += eps;
+    else
+      trajectory.getControlForces(mapping)
+          .row(dim - posDim - velDim)
+          .array()
+          += eps;
+    rollouts.push_back(&trajectory);
+    grads.push_back(&nudgedGrads.back());
+  }
+  for (TrajectoryRollout* grad : grads)
+  {
+    zeroGradient(grad);
+  }
+  Eigen::VectorXs losses = getLossesAndGradients(rollouts, grads, thisLog);
+
+  hessians.assign(steps, Eigen::MatrixXs::Zero(dims, dims));
+  for (int dim = 0; dim < dims; dim++)
+  {
+    const TrajectoryRollout* grad = grads[dim + 1];
+    for (int t = 0; t < steps; t++)
+    {
+      Eigen::Ref<Eigen::VectorXs> col = hessians[t].col(dim);
+      col.head(posDim) = grad->getPosesConst(mapping).col(t)
+                         - gradWrtRollout->getPosesConst(mapping).col(t);
+      col.segment(posDim, velDim)
+          = grad->getVelsConst(mapping).col(t)
+            - gradWrtRollout->getVelsConst(mapping).col(t);
+      col.tail(forceDim)
+          = grad->getControlForcesConst(mapping).col(t)
+            - gradWrtRollout->getControlForcesConst(mapping).col(t);
+      col /= eps;
+    }
+  }
+  for (Eigen::MatrixXs& hessian : hessians)
+  {
+    hessian = 0.5 * (hessian + hessian.transpose()).eval();
+  }
+
+#ifdef LOG_PERFORMANCE_LOSS_FN
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+
+  return losses(0);
+}
+
 //==============================================================================
 /// If this LossFn is being used as a constraint, this gets the lower bound
 /// it's allowed to reach
@@ -2,6 +2,8 @@
 #define DART_TRAJECTORY_LOSS_FUNCTION_HPP_
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -24,6 +26,16 @@ typedef std::function<s_t(
     /* OUT */ TrajectoryRollout* gradWrtRollout)>
     TrajectoryLossFnAndGrad;
 
+/// This evaluates a whole stack of rollouts in one call, writing each loss into
+/// `losses` and each gradient into the corresponding `gradWrtRollouts` entry.
+/// Going through this once per batch, rather than once per rollout, is much
+/// cheaper when the loss lives on the other side of a language boundary.
+typedef std::function<void(
+    const std::vector<const TrajectoryRollout*>& rollouts,
+    /* OUT */ Eigen::Ref<Eigen::VectorXs> losses,
+    /* OUT */ const std::vector<TrajectoryRollout*>& gradWrtRollouts)>
+    TrajectoryBatchLossFnAndGrad;
+
 class LossFn
 {
 public:
@@ -33,8 +45,30 @@ public:
 
   LossFn(TrajectoryLossFn loss, TrajectoryLossFnAndGrad lossAndGrad);
 
+  LossFn(TrajectoryBatchLossFnAndGrad batchLossAndGrad);
+
   virtual ~LossFn();
 
+  /// This is sum_t weight * ||pos_t - targetPoses_t||^2, over every timestep.
+  /// `targetPoses` has one column per timestep.
+  static LossFn quadraticTracking(
+      Eigen::MatrixXs targetPoses,
+      s_t weight = 1.0,
+      const std::string& mapping = "identity");
+
+  /// This is posWeight * ||pos_end - targetPos||^2 + velWeight * ||vel_end -
+  /// targetVel||^2, on the last timestep only
+  static LossFn finalState(
+      Eigen::VectorXs targetPos,
+      Eigen::VectorXs targetVel,
+      s_t posWeight = 1.0,
+      s_t velWeight = 1.0,
+      const std::string& mapping = "identity");
+
+  /// This is sum_t weight * ||force_t||^2, over every timestep
+  static LossFn controlEffort(
+      s_t weight = 1.0, const std::string& mapping = "identity");
+
   virtual s_t getLoss(
       const TrajectoryRollout* rollout, PerformanceLog* perflog = nullptr);
 
@@ -43,6 +77,30 @@ public:
       /* OUT */ TrajectoryRollout* gradWrtRollout,
       PerformanceLog* perflog = nullptr);
 
+  /// This evaluates a whole batch of rollouts at once, returning their losses
+  /// and writing their gradients into `gradWrtRollouts`. If we were built with
+  /// a batched loss, this is a single call to it, otherwise it falls back to
+  /// getLossAndGradient() on each rollout in turn.
+  virtual Eigen::VectorXs getLossesAndGradients(
+      const std::vector<const TrajectoryRollout*>& rollouts,
+      /* OUT */ const std::vector<TrajectoryRollout*>& gradWrtRollouts,
+      PerformanceLog* perflog = nullptr);
+
+  /// This gets the loss and its gradient, along with a Hessian for every
+  /// timestep t of the loss wrt (pos_t, vel_t, force_t) in `mapping`, stacked
+  /// in that order. We get these by finite differencing the gradient, nudging
+  /// the same coordinate at every timestep at once, so it's one batch of
+  /// (posDim + velDim + forceDim + 1) evaluations. That's exact for losses
+  /// that are a sum over timesteps (like all the built-in LossFn's), but any
+  /// coupling between timesteps is dropped.
+  s_t getLossGradientAndTimestepHessians(
+      const TrajectoryRollout* rollout,
+      /* OUT */ TrajectoryRollout* gradWrtRollout,
+      /* OUT */ std::vector<Eigen::MatrixXs>& hessians,
+      s_t eps = 1e-6,
+      const std::string& mapping = "identity",
+      PerformanceLog* perflog = nullptr);
+
   /// If this LossFn is being used as a constraint, this gets the lower bound
   /// it's allowed to reach
   s_t getLowerBound() const;
@@ -62,6 +120,7 @@ public:
 protected:
   tl::optional<TrajectoryLossFn> mLoss;
   tl::optional<TrajectoryLossFnAndGrad> mLossAndGrad;
+  tl::optional<TrajectoryBatchLossFnAndGrad> mBatchLossAndGrad;
   // If this loss function is being used as a constraint, this is the lower
   // bound it's allowed to reach
   s_t mLowerBound;
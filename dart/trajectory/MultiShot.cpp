@@ -1,8 +1,8 @@
 #include "dart/trajectory/MultiShot.hpp"
 
-#include <future>
 #include <vector>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -17,7 +17,9 @@ using namespace dynamics;
 using namespace simulation;
 using namespace neural;
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_MULTI_SHOT
+#endif
 
 namespace dart {
 namespace trajectory {
@@ -53,6 +55,30 @@ MultiShot::~MultiShot()
   // std::cout << "Freeing MultiShot: " << this << std::endl;
 }
 
+//==============================================================================
+/// This returns an independent copy of this problem, running on `world`.
+/// Every shot is cloned too, and if parallel operations are enabled the copy
+/// gets its own set of per-shot worlds.
+std::shared_ptr<Problem> MultiShot::clone(
+    std::shared_ptr<simulation::World> world) const
+{
+  std::shared_ptr<MultiShot> copy = std::make_shared<MultiShot>(*this);
+  copy->mWorld = world;
+  copy->mRolloutCache = nullptr;
+  copy->mGradWrtRolloutCache = nullptr;
+  copy->mRolloutCacheDirty = true;
+  for (int i = 0; i < copy->mShots.size(); i++)
+  {
+    copy->mShots[i]
+        = std::static_pointer_cast<SingleShot>(mShots[i]->clone(world));
+  }
+  if (mParallelOperationsEnabled)
+  {
+    copy->setParallelOperationsEnabled(true);
+  }
+  return copy;
+}
+
 //==============================================================================
 void MultiShot::setParallelOperationsEnabled(bool enabled)
 {
@@ -63,11 +89,17 @@ void MultiShot::setParallelOperationsEnabled(bool enabled)
     // call this (at least prior to Eigen 3.3)
     Eigen::initParallel();
 
+    // Each shot gets its own world, cloned once up front and kept for the life
+    // of the problem, so no evaluation ever has to clone (or share) a world.
+    // The shots are run as tasks on the global TaskScheduler, so there's no
+    // per-evaluation thread creation either.
     mParallelWorlds.clear();
     for (int i = 0; i < mShots.size(); i++)
     {
       mParallelWorlds.push_back(mWorld->clone());
     }
+    mParallelJacStatic.resize(mShots.size());
+    mParallelJacDynamic.resize(mShots.size());
   }
 }
 
@@ -182,22 +214,18 @@ void MultiShot::computeConstraints(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<common::TaskFuture<void>> futures;
     for (int i = 1; i < mShots.size(); i++)
     {
-      futures.push_back(std::async(
-          &MultiShot::asyncPartComputeConstraints,
-          this,
-          i,
-          mParallelWorlds[i],
-          constraints,
-          cursor,
-          thisLog));
+      futures.push_back(common::async([&, i, cursor] {
+        asyncPartComputeConstraints(
+            i, mParallelWorlds[i], constraints, cursor, thisLog);
+      }));
       cursor += getRepresentationStateSize();
     }
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
     }
   }
   else
@@ -512,23 +540,27 @@ void MultiShot::backpropJacobian(
   int stateDim = getRepresentationStateSize();
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<common::TaskFuture<void>> futures;
     for (int i = 1; i < mShots.size(); i++)
     {
       int dynamicDim = mShots[i - 1]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          jacStatic,
-          jacDynamic,
-          rowCursor,
-          colCursor,
-          thisLog));
+      futures.push_back(common::async([&, i, rowCursor, colCursor] {
+        asyncPartBackpropJacobian(
+            i,
+            mParallelWorlds[i],
+            jacStatic,
+            jacDynamic,
+            rowCursor,
+            colCursor,
+            thisLog);
+      }));
       colCursor += dynamicDim;
       rowCursor += stateDim;
     }
+    for (int i = 0; i < futures.size(); i++)
+    {
+      futures[i].get();
+    }
   }
   else
   {
@@ -767,29 +799,29 @@ void MultiShot::getSparseJacobian(
 
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
+    std::vector<common::TaskFuture<void>> futures;
     for (int i = 1; i < mShots.size(); i++)
     {
       int dimStatic = mShots[i - 1]->getFlatStaticProblemDim(world);
       int dimDynamic = mShots[i - 1]->getFlatDynamicProblemDim(world);
 
-      futures.push_back(std::async(
-          &MultiShot::asyncPartGetSparseJacobian,
-          this,
-          i,
-          mParallelWorlds[i],
-          sparseStatic,
-          sparseDynamic,
-          cursorStatic,
-          cursorDynamic,
-          thisLog));
+      futures.push_back(common::async([&, i, cursorStatic, cursorDynamic] {
+        asyncPartGetSparseJacobian(
+            i,
+            mParallelWorlds[i],
+            sparseStatic,
+            sparseDynamic,
+            cursorStatic,
+            cursorDynamic,
+            thisLog);
+      }));
 
       cursorDynamic += (dimDynamic + 1) * stateDim;
       cursorStatic += dimStatic * stateDim;
     }
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
     }
   }
   else
@@ -838,6 +870,115 @@ void MultiShot::getSparseJacobian(
 #endif
 }
 
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton Hessian
+int MultiShot::getNumberNonZeroGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world)
+{
+  int nnzh = 0;
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    nnzh += shot->getNumberNonZeroGaussNewtonHessian(world);
+  }
+  return nnzh;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian
+void MultiShot::getGaussNewtonHessianStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* /* log */)
+{
+  int cursor = 0;
+  int offset = getFlatStaticProblemDim(world);
+  for (const std::shared_ptr<SingleShot>& shot : mShots)
+  {
+    int dim = shot->getFlatDynamicProblemDim(world);
+    for (int row = 0; row < dim; row++)
+    {
+      for (int col = 0; col <= row; col++)
+      {
+        rows(cursor) = offset + row;
+        cols(cursor) = offset + col;
+        cursor++;
+      }
+    }
+    offset += dim;
+  }
+  assert(cursor == rows.size());
+}
+
+//==============================================================================
+/// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+/// vector
+void MultiShot::getSparseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("MultiShot.getSparseGaussNewtonHessian");
+  }
+#endif
+
+  std::vector<Eigen::MatrixXs> lossHessians;
+  getLossTimestepHessians(world, lossHessians, thisLog);
+
+  // Each shot writes its own block, starting at `cursor` in `sparse`
+  auto writeShot = [&](int index,
+                       std::shared_ptr<simulation::World> shotWorld,
+                       int cursor,
+                       int firstTimestep) {
+    int dim = mShots[index]->getFlatDynamicProblemDim(shotWorld);
+    Eigen::MatrixXs hessian(dim, dim);
+    mShots[index]->getDenseGaussNewtonHessian(
+        shotWorld, lossHessians, firstTimestep, hessian, thisLog);
+    for (int row = 0; row < dim; row++)
+    {
+      sparse.segment(cursor, row + 1) = hessian.row(row).head(row + 1);
+      cursor += row + 1;
+    }
+  };
+
+  int cursor = 0;
+  int cursorSteps = 0;
+  std::vector<common::TaskFuture<void>> futures;
+  for (int i = 0; i < mShots.size(); i++)
+  {
+    if (mParallelOperationsEnabled)
+    {
+      futures.push_back(common::async([&, i, cursor, cursorSteps] {
+        writeShot(i, mParallelWorlds[i], cursor, cursorSteps);
+      }));
+    }
+    else
+    {
+      writeShot(i, world, cursor, cursorSteps);
+    }
+    cursor += mShots[i]->getNumberNonZeroGaussNewtonHessian(world);
+    cursorSteps += mShots[i]->getNumSteps();
+  }
+  for (int i = 0; i < futures.size(); i++)
+  {
+    futures[i].get();
+  }
+  assert(cursor == sparse.size());
+
+#ifdef LOG_PERFORMANCE_MULTI_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This writes the Jacobian to a sparse vector
 void MultiShot::asyncPartGetSparseJacobian(
@@ -854,9 +995,14 @@ void MultiShot::asyncPartGetSparseJacobian(
   int dimStatic = mShots[index - 1]->getFlatStaticProblemDim(world);
   int dimDynamic = mShots[index - 1]->getFlatDynamicProblemDim(world);
 
-  // Get the dense Jacobians for static and dynamic regions
-  Eigen::MatrixXs jacStatic = Eigen::MatrixXs::Zero(stateDim, dimStatic);
-  Eigen::MatrixXs jacDynamic = Eigen::MatrixXs::Zero(stateDim, dimDynamic);
+  // Get the dense Jacobians for static and dynamic regions. The scratch
+  // matrices belong to this shot, and are reused from one call to the next.
+  Eigen::MatrixXs& jacStatic = mParallelJacStatic[index];
+  Eigen::MatrixXs& jacDynamic = mParallelJacDynamic[index];
+  jacStatic.resize(stateDim, dimStatic);
+  jacStatic.setZero();
+  jacDynamic.resize(stateDim, dimDynamic);
+  jacDynamic.setZero();
   mShots[index - 1]->backpropJacobianOfFinalState(
       world, jacStatic, jacDynamic, log);
 
@@ -930,24 +1076,19 @@ void MultiShot::getStates(
   {
     if (mParallelOperationsEnabled)
     {
-      std::vector<std::future<void>> futures;
+      std::vector<common::TaskFuture<void>> futures;
       for (int i = 0; i < mShots.size(); i++)
       {
         int steps = mShots[i]->getNumSteps();
-        futures.push_back(std::async(
-            &MultiShot::asyncPartGetStates,
-            this,
-            i,
-            mParallelWorlds[i],
-            rollout,
-            cursor,
-            steps,
-            thisLog));
+        futures.push_back(common::async([&, i, cursor, steps] {
+          asyncPartGetStates(
+              i, mParallelWorlds[i], rollout, cursor, steps, thisLog);
+        }));
         cursor += steps;
       }
       for (int i = 0; i < futures.size(); i++)
       {
-        futures[i].wait();
+        futures[i].get();
       }
     }
     else
@@ -1072,16 +1213,25 @@ Eigen::VectorXi MultiShot::advanceSteps(
     Eigen::VectorXs startVel,
     int steps)
 {
-  Eigen::VectorXi mapping = Eigen::VectorXi::Zero(getFlatProblemDim(world));
+  Eigen::VectorXi mapping
+      = Eigen::VectorXi::Constant(getFlatProblemDim(world), -1);
+  int staticDim = getFlatStaticProblemDim(world);
+  for (int i = 0; i < staticDim; i++)
+  {
+    mapping(i) = i;
+  }
 
   RestorableSnapshot snapshot(world);
 
   const TrajectoryRollout* rollout = getRolloutCache(world);
 
   int cursor = 0;
+  int flatCursor = staticDim;
   for (int i = 0; i < mShots.size(); i++)
   {
     int len = mShots[i]->getNumSteps();
+    int dim = mShots[i]->getFlatDynamicProblemDim(world);
+    Eigen::VectorXi shotMapping;
 
     // The first shot is a special case, we assume that it's getting its
     // projection of current state from a more reliable source than our
@@ -1090,7 +1240,7 @@ Eigen::VectorXi MultiShot::advanceSteps(
 
     if (i == 0)
     {
-      mShots[i]->advanceSteps(world, startPos, startVel, steps);
+      shotMapping = mShots[i]->advanceSteps(world, startPos, startVel, steps);
     }
     else
     {
@@ -1109,13 +1259,27 @@ Eigen::VectorXi MultiShot::advanceSteps(
         }
         world->step();
       }
-      mShots[i]->advanceSteps(
+      shotMapping = mShots[i]->advanceSteps(
           world, world->getPositions(), world->getVelocities(), steps);
     }
 
+    // Each shot maps within its own flat problem (static values, then its
+    // dynamic values), so move its dynamic indices over to where they sit in
+    // ours
+    for (int j = 0; j < dim; j++)
+    {
+      int old = shotMapping(staticDim + j);
+      if (old >= 0)
+      {
+        mapping(flatCursor + j) = flatCursor + (old - staticDim);
+      }
+    }
+
     cursor += len;
+    flatCursor += dim;
   }
   snapshot.restore();
+  mRolloutCacheDirty = true;
 
   return mapping;
 }
@@ -1244,31 +1408,36 @@ void MultiShot::backpropGradientWrt(
   int cursorSteps = 0;
   if (mParallelOperationsEnabled)
   {
-    std::vector<std::future<void>> futures;
-    Eigen::VectorXs gradStaticScratch
-        = Eigen::VectorXs::Zero(gradStatic.size() * mShots.size());
+    std::vector<common::TaskFuture<void>> futures;
+    // Each shot gets its own segment of the scratch buffer, which we keep
+    // around between calls
+    Eigen::VectorXs& gradStaticScratch = mParallelGradStaticScratch;
+    gradStaticScratch.resize(gradStatic.size() * mShots.size());
+    gradStaticScratch.setZero();
     for (int i = 0; i < mShots.size(); i++)
     {
       int steps = mShots[i]->getNumSteps();
       int dynamicDim = mShots[i]->getFlatDynamicProblemDim(world);
-      futures.push_back(std::async(
-          &MultiShot::asyncPartBackpropGradientWrt,
-          this,
-          i,
-          mParallelWorlds[i],
-          gradWrtRollout,
-          gradStaticScratch.segment(i * gradStatic.size(), gradStatic.size()),
-          gradDynamic,
-          cursorDynamicDims,
-          cursorSteps,
-          thisLog));
+      futures.push_back(
+          common::async([&, i, cursorDynamicDims, cursorSteps] {
+            asyncPartBackpropGradientWrt(
+                i,
+                mParallelWorlds[i],
+                gradWrtRollout,
+                gradStaticScratch.segment(
+                    i * gradStatic.size(), gradStatic.size()),
+                gradDynamic,
+                cursorDynamicDims,
+                cursorSteps,
+                thisLog);
+          }));
       cursorSteps += steps;
       cursorDynamicDims += dynamicDim;
     }
     gradStatic.setZero();
     for (int i = 0; i < futures.size(); i++)
     {
-      futures[i].wait();
+      futures[i].get();
       gradStatic += gradStaticScratch.segment(
           i * gradStatic.size(), gradStatic.size());
     }
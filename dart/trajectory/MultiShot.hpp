@@ -34,6 +34,12 @@ public:
   /// Destructor
   virtual ~MultiShot() override;
 
+  /// This returns an independent copy of this problem, running on `world`.
+  /// Every shot is cloned too, and if parallel operations are enabled the copy
+  /// gets its own set of per-shot worlds.
+  std::shared_ptr<Problem> clone(
+      std::shared_ptr<simulation::World> world) const override;
+
   /// If TRUE, this will use multiple independent threads to compute each
   /// SingleShot's values internally. Currently defaults to FALSE. This should
   /// be considered EXPERIMENTAL! Expect bugs.
@@ -197,7 +203,10 @@ public:
 
   /// This moves the trajectory forward in time, setting the starting point to
   /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// padding the remainder with 0s. This returns, for each index of the new
+  /// flat problem, the index that value held in the flat problem before the
+  /// shift, or -1 if it's new padding. That's what lets a re-solve warm start
+  /// its multipliers from the last solve.
   Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -269,6 +278,27 @@ public:
       int cursorDynamic,
       PerformanceLog* log = nullptr);
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian. Each shot only depends on its own variables, so
+  /// this is a dense block per shot along the diagonal.
+  int getNumberNonZeroGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world) override;
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian
+  void getGaussNewtonHessianStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr) override;
+
+  /// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+  /// vector
+  void getSparseGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXs> sparse,
+      PerformanceLog* log = nullptr) override;
+
   /// This returns the snapshots from a fresh unroll
   std::vector<neural::MappedBackpropSnapshotPtr> getSnapshots(
       std::shared_ptr<simulation::World> world,
@@ -281,6 +311,10 @@ public:
 private:
   std::vector<std::shared_ptr<SingleShot>> mShots;
   std::vector<simulation::WorldPtr> mParallelWorlds;
+  // Per-shot scratch space for parallel operations, reused across calls
+  std::vector<Eigen::MatrixXs> mParallelJacStatic;
+  std::vector<Eigen::MatrixXs> mParallelJacDynamic;
+  Eigen::VectorXs mParallelGradStaticScratch;
   int mShotLength;
   bool mParallelOperationsEnabled;
 };
@@ -11,7 +11,9 @@
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/simulation/World.hpp"
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_PROBLEM
+#endif
 
 namespace dart {
 namespace trajectory {
@@ -745,6 +747,68 @@ void Problem::getSparseJacobian(
       log);
 }
 
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton approximation to the Hessian of the loss
+int Problem::getNumberNonZeroGaussNewtonHessian(
+    std::shared_ptr<simulation::World> /* world */)
+{
+  return 0;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian
+void Problem::getGaussNewtonHessianStructure(
+    std::shared_ptr<simulation::World> /* world */,
+    Eigen::Ref<Eigen::VectorXi> /* rows */,
+    Eigen::Ref<Eigen::VectorXi> /* cols */,
+    PerformanceLog* /* log */)
+{
+}
+
+//==============================================================================
+/// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+/// vector
+void Problem::getSparseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> /* world */,
+    Eigen::Ref<Eigen::VectorXs> /* sparse */,
+    PerformanceLog* /* log */)
+{
+}
+
+//==============================================================================
+/// This gets the Hessian of the loss at every timestep of the current
+/// rollout, wrt (pos, vel, force) in the "identity" mapping
+void Problem::getLossTimestepHessians(
+    std::shared_ptr<simulation::World> world,
+    /* OUT */ std::vector<Eigen::MatrixXs>& hessians,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("Problem.getLossTimestepHessians");
+  }
+#endif
+
+  mLoss.getLossGradientAndTimestepHessians(
+      getRolloutCache(world, thisLog),
+      /* OUT */ getGradientWrtRolloutCache(world, thisLog),
+      /* OUT */ hessians,
+      1e-6,
+      "identity",
+      thisLog);
+
+#ifdef LOG_PERFORMANCE_PROBLEM
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This computes the gradient in the flat problem space, automatically
 /// computing the gradients of the loss function as part of the call
@@ -967,20 +1031,29 @@ Eigen::VectorXi Problem::updateWithForces(
   neural::RestorableSnapshot snapshot(world);
   TrajectoryRollout* rollout = getRolloutCache(world, thisLog)->copy();
 
+  // Record the real states first, and then convert the whole trajectory into
+  // each mapping at once, so mappings can batch (and parallelize) the work
+  int dofs = world->getNumDofs();
+  Eigen::MatrixXs realPoses = Eigen::MatrixXs::Zero(dofs, mSteps);
+  Eigen::MatrixXs realVels = Eigen::MatrixXs::Zero(dofs, mSteps);
   for (int i = 0; i < mSteps; i++)
   {
     world->setControlForces(forces.col(i));
-    for (std::string mapping : rollout->getMappings())
-    {
-      mMappings[mapping]->getPositionsInPlace(
-          world, rollout->getPoses(mapping).col(i));
-      mMappings[mapping]->getVelocitiesInPlace(
-          world, rollout->getVels(mapping).col(i));
-      mMappings[mapping]->getControlForcesInPlace(
-          world, rollout->getControlForces(mapping).col(i));
-    }
+    realPoses.col(i) = world->getPositions();
+    realVels.col(i) = world->getVelocities();
     world->step();
   }
+  for (std::string mapping : rollout->getMappings())
+  {
+    mMappings[mapping]->mapTrajectory(
+        world,
+        realPoses,
+        realVels,
+        forces,
+        rollout->getPoses(mapping),
+        rollout->getVels(mapping),
+        rollout->getControlForces(mapping));
+  }
 
   setStates(world, rollout, thisLog);
 
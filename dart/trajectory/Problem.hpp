@@ -29,6 +29,8 @@ class Problem
 {
 public:
   friend class IPOptShotWrapper;
+  friend class IPOptOptimizer;
+  friend class ILQROptimizer;
   friend class SGDOptimizer;
 
   /// Default constructor
@@ -37,6 +39,13 @@ public:
   /// Abstract destructor
   virtual ~Problem();
 
+  /// This returns an independent copy of this problem (same loss, mappings,
+  /// constraints, metadata and current decision variables) that simulates on
+  /// `world` instead of the original world. Caches are not shared, so the
+  /// copy can be evaluated on another thread alongside the original.
+  virtual std::shared_ptr<Problem> clone(
+      std::shared_ptr<simulation::World> world) const = 0;
+
   /// This prevents a force from changing in optimization, keeping it fixed at a
   /// specified value.
   virtual void pinForce(int time, Eigen::VectorXs value) = 0;
@@ -210,7 +219,10 @@ public:
 
   /// This moves the trajectory forward in time, setting the starting point to
   /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// padding the remainder with 0s. This returns, for each index of the new
+  /// flat problem, the index that value held in the flat problem before the
+  /// shift, or -1 if it's new padding. That's what lets a re-solve warm start
+  /// its multipliers from the last solve.
   virtual Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -292,6 +304,27 @@ public:
       Eigen::Ref<Eigen::VectorXs> sparse,
       PerformanceLog* log = nullptr);
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton approximation to the Hessian of the loss. This is 0 for
+  /// problems that can't supply one.
+  virtual int getNumberNonZeroGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world);
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian
+  virtual void getGaussNewtonHessianStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr);
+
+  /// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+  /// vector, in the same order as getGaussNewtonHessianStructure()
+  virtual void getSparseGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXs> sparse,
+      PerformanceLog* log = nullptr);
+
   /// This returns the snapshots from a fresh unroll
   virtual std::vector<neural::MappedBackpropSnapshotPtr> getSnapshots(
       std::shared_ptr<simulation::World> world, PerformanceLog* log = nullptr)
@@ -399,6 +432,14 @@ protected:
       TimestepJacobians& thisTimestep,
       PerformanceLog* log = nullptr);
 
+  /// This gets the Hessian of the loss at every timestep of the current
+  /// rollout, wrt (pos, vel, force) in the "identity" mapping. See
+  /// LossFn::getLossGradientAndTimestepHessians().
+  void getLossTimestepHessians(
+      std::shared_ptr<simulation::World> world,
+      /* OUT */ std::vector<Eigen::MatrixXs>& hessians,
+      PerformanceLog* log = nullptr);
+
   /// This returns the initial guess for the values of X when running an
   /// optimization
   virtual void getInitialGuess(
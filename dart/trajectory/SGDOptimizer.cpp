@@ -1,8 +1,15 @@
 #include "dart/trajectory/SGDOptimizer.hpp"
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 
+#include "dart/common/TaskScheduler.hpp"
+#include "dart/simulation/World.hpp"
+
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_SGD
+#endif
 
 using namespace dart;
 using namespace simulation;
@@ -13,7 +20,11 @@ namespace trajectory {
 
 //==============================================================================
 SGDOptimizer::SGDOptimizer()
-  : mIterationLimit(100), mTolerance(0), mLearningRate(1e-2)
+  : mIterationLimit(100),
+    mTolerance(0),
+    mLearningRate(1e-2),
+    mLineSearchCandidates(1),
+    mNumThreads(0)
 {
 }
 
@@ -30,6 +41,27 @@ std::shared_ptr<Solution> SGDOptimizer::optimize(
   shot->flatten(shot->mWorld, x);
   s_t loss = shot->getLoss(shot->mWorld);
 
+  // Build the pool of problem clones for the line search up front, so each
+  // iteration only has to unflatten and roll out
+  mCandidateProblems.clear();
+  std::vector<Eigen::VectorXs> candidates;
+  std::vector<s_t> candidateLosses;
+  if (mLineSearchCandidates > 1)
+  {
+    int numThreads = mNumThreads;
+    if (numThreads <= 0)
+    {
+      numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    int poolSize = std::min(numThreads, mLineSearchCandidates);
+    for (int i = 0; i < poolSize; i++)
+    {
+      mCandidateProblems.push_back(shot->clone(shot->mWorld->clone()));
+    }
+    candidates.resize(mLineSearchCandidates);
+    candidateLosses.resize(mLineSearchCandidates);
+  }
+
   for (int i = 0; i < mIterationLimit; i++)
   {
     s_t newLoss = shot->getLoss(shot->mWorld);
@@ -43,7 +75,27 @@ std::shared_ptr<Solution> SGDOptimizer::optimize(
     std::cout << "Iter " << i << ": " << newLoss << std::endl;
     shot->getGradientWrtRolloutCache(shot->mWorld);
     shot->backpropGradient(shot->mWorld, grad);
-    x -= grad * mLearningRate;
+    if (mCandidateProblems.size() > 0)
+    {
+      s_t stepSize = mLearningRate;
+      for (int k = 0; k < candidates.size(); k++)
+      {
+        candidates[k] = x - grad * stepSize;
+        stepSize *= 0.5;
+      }
+      int best = pickBestCandidate(candidates, candidateLosses);
+      if (candidateLosses[best] >= loss)
+      {
+        std::cout << "Line search found no improvement, converged."
+                  << std::endl;
+        break;
+      }
+      x = candidates[best];
+    }
+    else
+    {
+      x -= grad * mLearningRate;
+    }
     shot->unflatten(shot->mWorld, x);
 
     for (auto callback : mIntermediateCallbacks)
@@ -52,9 +104,44 @@ std::shared_ptr<Solution> SGDOptimizer::optimize(
     }
   }
 
+  mCandidateProblems.clear();
   return record;
 }
 
+//==============================================================================
+int SGDOptimizer::pickBestCandidate(
+    const std::vector<Eigen::VectorXs>& candidates,
+    /* OUT */ std::vector<s_t>& losses)
+{
+  int poolSize = mCandidateProblems.size();
+  std::vector<common::TaskFuture<void>> futures;
+  for (int worker = 0; worker < poolSize; worker++)
+  {
+    futures.push_back(common::async([&, worker]() {
+      Problem* problem = mCandidateProblems[worker].get();
+      for (int k = worker; k < candidates.size(); k += poolSize)
+      {
+        problem->unflatten(problem->mWorld, candidates[k]);
+        losses[k] = problem->getLoss(problem->mWorld);
+      }
+    }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  int best = 0;
+  for (int k = 1; k < losses.size(); k++)
+  {
+    if (losses[k] < losses[best])
+    {
+      best = k;
+    }
+  }
+  return best;
+}
+
 //==============================================================================
 void SGDOptimizer::setIterationLimit(int iterationLimit)
 {
@@ -73,5 +160,17 @@ void SGDOptimizer::setLearningRate(s_t learningRate)
   mLearningRate = learningRate;
 }
 
+//==============================================================================
+void SGDOptimizer::setLineSearchCandidates(int numCandidates)
+{
+  mLineSearchCandidates = numCandidates;
+}
+
+//==============================================================================
+void SGDOptimizer::setNumThreads(int numThreads)
+{
+  mNumThreads = numThreads;
+}
+
 } // namespace trajectory
 } // namespace dart
\ No newline at end of file
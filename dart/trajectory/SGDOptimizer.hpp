@@ -41,10 +41,35 @@ public:
 
   void setLearningRate(s_t learningRate);
 
+  /// If this is greater than 1, each iteration tries `numCandidates` step
+  /// sizes (the learning rate, then half of it, then a quarter, ...) and takes
+  /// whichever step gives the lowest loss. Candidates are evaluated in
+  /// parallel, each on its own clone of the problem and world. If no
+  /// candidate improves the loss, optimization stops. Defaults to 1, which is
+  /// plain fixed-step gradient descent.
+  void setLineSearchCandidates(int numCandidates);
+
+  /// This sets how many threads evaluate line search candidates. If this is
+  /// <= 0, we use one thread per hardware core. Defaults to 0.
+  void setNumThreads(int numThreads);
+
 protected:
+  /// This evaluates the loss at each of `candidates`, spreading the work over
+  /// mCandidateProblems, and returns the index of the lowest loss (ties go to
+  /// the larger step).
+  int pickBestCandidate(
+      const std::vector<Eigen::VectorXs>& candidates,
+      /* OUT */ std::vector<s_t>& losses);
+
   int mIterationLimit;
   s_t mTolerance;
   s_t mLearningRate;
+  int mLineSearchCandidates;
+  int mNumThreads;
+
+  /// Clones of the problem being optimized, each on its own world. These are
+  /// created once per optimize() call and reused on every iteration.
+  std::vector<std::shared_ptr<Problem>> mCandidateProblems;
 };
 
 } // namespace trajectory
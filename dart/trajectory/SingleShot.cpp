@@ -1,7 +1,9 @@
 #include "dart/trajectory/SingleShot.hpp"
 
+#include <algorithm>
 #include <vector>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
 #include "dart/neural/NeuralUtils.hpp"
@@ -16,7 +18,9 @@ using namespace dynamics;
 using namespace simulation;
 using namespace neural;
 
+#ifdef LOG_PERFORMANCE
 #define LOG_PERFORMANCE_SINGLE_SHOT
+#endif
 
 namespace dart {
 namespace trajectory {
@@ -35,6 +39,13 @@ SingleShot::SingleShot(
   assert(steps > 0);
   mForces = Eigen::MatrixXs::Zero(world->getNumDofs(), steps);
   mSnapshotsCacheDirty = true;
+  mCheckpointInterval = 0;
+  mSegmentCacheStart = -1;
+  mPararealSegments = 1;
+  mPararealCoarseStepRatio = 10;
+  mPararealTolerance = 1e-8;
+  mPararealMaxIterations = 0;
+  mLastPararealIterations = 0;
   mPinnedForces = Eigen::MatrixXs::Zero(world->getNumDofs(), steps);
   for (int i = 0; i < steps; i++)
   {
@@ -48,6 +59,30 @@ SingleShot::~SingleShot()
   // std::cout << "Freeing SingleShot: " << this << std::endl;
 }
 
+//==============================================================================
+/// This returns an independent copy of this shot, running on `world`
+std::shared_ptr<Problem> SingleShot::clone(
+    std::shared_ptr<simulation::World> world) const
+{
+  std::shared_ptr<SingleShot> copy = std::make_shared<SingleShot>(*this);
+  copy->mWorld = world;
+  // Drop everything we simulated on the original world, so the copy never
+  // touches (or shares) our caches
+  copy->mRolloutCache = nullptr;
+  copy->mGradWrtRolloutCache = nullptr;
+  copy->mSnapshotsCache.clear();
+  copy->mCheckpoints.clear();
+  copy->mSegmentCache.clear();
+  copy->mSegmentCacheStart = -1;
+  copy->mPararealWorlds.clear();
+  for (int i = 0; i < mPararealWorlds.size(); i++)
+  {
+    copy->mPararealWorlds.push_back(world->clone());
+  }
+  copy->resetDirty();
+  return copy;
+}
+
 //==============================================================================
 /// This prevents a force from changing in optimization, keeping it fixed at a
 /// specified value.
@@ -64,6 +99,13 @@ Eigen::Ref<Eigen::VectorXs> SingleShot::getPinnedForce(int time)
   return mPinnedForces.col(time);
 }
 
+//==============================================================================
+/// This returns true if the force at this timestep has been pinned
+bool SingleShot::isForcePinned(int time) const
+{
+  return mForcesPinned[time];
+}
+
 //==============================================================================
 /// Returns the length of the flattened problem state
 int SingleShot::getFlatDynamicProblemDim(
@@ -379,8 +421,7 @@ void SingleShot::backpropJacobianOfFinalState(
 
   Problem::initializeStaticJacobianOfFinalState(world, jacStatic, thisLog);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  refreshSnapshotsCache(world, thisLog);
 
   int posDim = world->getNumDofs();
   int velDim = world->getNumDofs();
@@ -408,7 +449,7 @@ void SingleShot::backpropJacobianOfFinalState(
   int cursorDynamic = getFlatDynamicProblemDim(world);
   for (int i = mSteps - 1; i >= 0; i--)
   {
-    MappedBackpropSnapshotPtr ptr = snapshots[i];
+    MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
     TimestepJacobians thisTimestep;
 
     world->setPositions(ptr->getPreStepPosition());
@@ -562,9 +603,7 @@ void SingleShot::backpropGradientWrt(
   _unused(staticDims);
   assert(gradDynamic.size() == dynamicDims);
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
-  assert(snapshots.size() == mSteps);
+  refreshSnapshotsCache(world, thisLog);
 
   LossGradient nextTimestep;
   nextTimestep.lossWrtPosition = Eigen::VectorXs::Zero(world->getNumDofs());
@@ -595,7 +634,7 @@ void SingleShot::backpropGradientWrt(
     mappedLosses["identity"].lossWrtVelocity += nextTimestep.lossWrtVelocity;
 
     LossGradient thisTimestep;
-    snapshots[i]->backprop(
+    getSnapshot(world, i, thisLog)->backprop(
         world,
         thisTimestep,
         mappedLosses,
@@ -630,6 +669,168 @@ void SingleShot::backpropGradientWrt(
 #endif
 }
 
+//==============================================================================
+/// This gets the number of non-zero entries in the lower triangle of the
+/// Gauss-Newton Hessian
+int SingleShot::getNumberNonZeroGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world)
+{
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  return dynamicDim * (dynamicDim + 1) / 2;
+}
+
+//==============================================================================
+/// This gets the structure of the non-zero entries in the lower triangle of
+/// the Gauss-Newton Hessian
+void SingleShot::getGaussNewtonHessianStructure(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXi> rows,
+    Eigen::Ref<Eigen::VectorXi> cols,
+    PerformanceLog* /* log */)
+{
+  int staticDim = getFlatStaticProblemDim(world);
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  int cursor = 0;
+  for (int row = 0; row < dynamicDim; row++)
+  {
+    for (int col = 0; col <= row; col++)
+    {
+      rows(cursor) = staticDim + row;
+      cols(cursor) = staticDim + col;
+      cursor++;
+    }
+  }
+  assert(cursor == rows.size());
+}
+
+//==============================================================================
+/// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+/// vector
+void SingleShot::getSparseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    Eigen::Ref<Eigen::VectorXs> sparse,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.getSparseGaussNewtonHessian");
+  }
+#endif
+
+  std::vector<Eigen::MatrixXs> lossHessians;
+  getLossTimestepHessians(world, lossHessians, thisLog);
+
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  Eigen::MatrixXs hessian(dynamicDim, dynamicDim);
+  getDenseGaussNewtonHessian(world, lossHessians, 0, hessian, thisLog);
+
+  int cursor = 0;
+  for (int row = 0; row < dynamicDim; row++)
+  {
+    sparse.segment(cursor, row + 1) = hessian.row(row).head(row + 1);
+    cursor += row + 1;
+  }
+  assert(cursor == sparse.size());
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This fills the lower triangle of `hessian` with J^T H J over our dynamic
+/// variables
+void SingleShot::getDenseGaussNewtonHessian(
+    std::shared_ptr<simulation::World> world,
+    const std::vector<Eigen::MatrixXs>& lossHessians,
+    int firstTimestep,
+    /* OUT */ Eigen::Ref<Eigen::MatrixXs> hessian,
+    PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.getDenseGaussNewtonHessian");
+  }
+#endif
+
+  refreshSnapshotsCache(world, thisLog);
+
+  int dofs = world->getNumDofs();
+  int stateDim = 2 * dofs;
+  int startDim = mTuneStartingState ? stateDim : 0;
+  int dynamicDim = getFlatDynamicProblemDim(world);
+  assert(hessian.rows() == dynamicDim && hessian.cols() == dynamicDim);
+  hessian.setZero();
+
+  // This is the Jacobian of the state after each step wrt our dynamic
+  // variables. Forces only reach the states after they're applied, so the
+  // state after step i only depends on the first (startDim + (i + 1) * dofs)
+  // variables, and we only ever multiply through that many columns.
+  Eigen::MatrixXs stateJac = Eigen::MatrixXs::Zero(stateDim, dynamicDim);
+  if (mTuneStartingState)
+  {
+    stateJac.leftCols(stateDim).setIdentity();
+  }
+  Eigen::MatrixXs stepJac = Eigen::MatrixXs::Zero(stateDim, stateDim);
+
+  RestorableSnapshot restoreSnapshot(world);
+
+  for (int i = 0; i < mSteps; i++)
+  {
+    MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
+
+    world->setPositions(ptr->getPreStepPosition());
+    world->setVelocities(ptr->getPreStepVelocity());
+    world->setControlForces(ptr->getPreStepTorques());
+    world->setCachedLCPSolution(ptr->getPreStepLCPCache());
+
+    stepJac.block(0, 0, dofs, dofs) = ptr->getPosPosJacobian(world, thisLog);
+    stepJac.block(0, dofs, dofs, dofs) = ptr->getVelPosJacobian(world, thisLog);
+    stepJac.block(dofs, 0, dofs, dofs) = ptr->getPosVelJacobian(world, thisLog);
+    stepJac.block(dofs, dofs, dofs, dofs)
+        = ptr->getVelVelJacobian(world, thisLog);
+
+    int forceCol = startDim + i * dofs;
+    int active = forceCol + dofs;
+    stateJac.leftCols(forceCol) = stepJac * stateJac.leftCols(forceCol);
+    stateJac.block(dofs, forceCol, dofs, dofs)
+        = ptr->getControlForceVelJacobian(world, thisLog);
+
+    const Eigen::MatrixXs& lossHessian = lossHessians[firstTimestep + i];
+    const auto stateHessian = lossHessian.topLeftCorner(stateDim, stateDim);
+    const auto crossHessian = lossHessian.topRightCorner(stateDim, dofs);
+    const auto forceHessian = lossHessian.bottomRightCorner(dofs, dofs);
+    const auto jac = stateJac.leftCols(active);
+
+    Eigen::MatrixXs stateHessianJac = stateHessian * jac;
+    hessian.topLeftCorner(active, active)
+        .triangularView<Eigen::Lower>()
+        += jac.transpose() * stateHessianJac;
+    // The cross terms only land in the rows and columns of this step's force,
+    // so we add the rows, which cover the lower triangle
+    Eigen::MatrixXs cross = jac.transpose() * crossHessian;
+    hessian.block(forceCol, 0, dofs, active) += cross.transpose();
+    hessian.block(forceCol, forceCol, dofs, dofs)
+        += cross.bottomRows(dofs) + forceHessian;
+  }
+
+  restoreSnapshot.restore();
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
+#endif
+}
+
 //==============================================================================
 /// This returns the snapshots from a fresh unroll
 std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
@@ -643,29 +844,114 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
   }
 #endif
 
-  if (mSnapshotsCacheDirty)
+  refreshSnapshotsCache(world, thisLog);
+
+  std::vector<MappedBackpropSnapshotPtr> snapshots;
+  if (mCheckpointInterval > 0)
   {
-    PerformanceLog* refreshLog = nullptr;
-#ifdef LOG_PERFORMANCE_SINGLE_SHOT
-    if (thisLog != nullptr)
+    // The caller asked for everything, so there's no way around holding every
+    // snapshot in memory here, but we don't keep them around afterwards
+    snapshots.reserve(mSteps);
+    for (int i = 0; i < mSteps; i++)
     {
-      refreshLog = thisLog->startRun("SingleShot.getSnapshots#refreshCache");
+      snapshots.push_back(getSnapshot(world, i, thisLog));
     }
+  }
+  else
+  {
+    snapshots = mSnapshotsCache;
+  }
+
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (thisLog != nullptr)
+  {
+    thisLog->end();
+  }
 #endif
-    RestorableSnapshot snapshot(world);
+  return snapshots;
+}
 
-    mSnapshotsCache.clear();
-    mSnapshotsCache.reserve(mSteps);
+//==============================================================================
+/// This keeps only every `interval`-th world state, and re-simulates the rest
+/// during backprop. 0 keeps every snapshot.
+void SingleShot::setCheckpointInterval(int interval)
+{
+  mCheckpointInterval = std::max(0, interval);
+  mSnapshotsCacheDirty = true;
+  mSnapshotsCache.clear();
+  mCheckpoints.clear();
+  mSegmentCache.clear();
+  mSegmentCacheStart = -1;
+}
 
-    world->setPositions(mStartPos);
-    world->setVelocities(mStartVel);
+//==============================================================================
+/// This switches the forward rollout over to parareal
+void SingleShot::setParareal(
+    int numSegments, int coarseStepRatio, s_t tolerance, int maxIterations)
+{
+  mPararealSegments = std::max(1, std::min(numSegments, mSteps));
+  mPararealCoarseStepRatio = std::max(1, coarseStepRatio);
+  mPararealTolerance = tolerance;
+  mPararealMaxIterations = maxIterations;
+  mLastPararealIterations = 0;
+  mSnapshotsCacheDirty = true;
+  mRolloutCacheDirty = true;
 
-    for (int i = 0; i < mSteps; i++)
+  // Each segment gets its own world, cloned once up front, like
+  // MultiShot::setParallelOperationsEnabled()
+  mPararealWorlds.clear();
+  if (mPararealSegments > 1)
+  {
+    Eigen::initParallel();
+    for (int i = 0; i < mPararealSegments; i++)
     {
-      world->setControlForces(mForces.col(i));
-      mSnapshotsCache.push_back(mappedForwardPass(world, mMappings));
+      mPararealWorlds.push_back(mWorld->clone());
     }
+  }
+}
+
+//==============================================================================
+/// This returns how many parareal iterations the last rollout took
+int SingleShot::getLastPararealIterations() const
+{
+  return mLastPararealIterations;
+}
 
+//==============================================================================
+/// This returns the checkpoint interval, or 0 if we're keeping every snapshot
+int SingleShot::getCheckpointInterval() const
+{
+  return mCheckpointInterval;
+}
+
+//==============================================================================
+/// This re-runs the forward pass, if the cached snapshots (or checkpoints)
+/// are stale
+void SingleShot::refreshSnapshotsCache(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  if (!mSnapshotsCacheDirty)
+  {
+    return;
+  }
+
+  PerformanceLog* refreshLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    refreshLog = log->startRun("SingleShot.getSnapshots#refreshCache");
+  }
+#endif
+  RestorableSnapshot snapshot(world);
+
+  mSnapshotsCache.clear();
+  mCheckpoints.clear();
+  mSegmentCache.clear();
+  mSegmentCacheStart = -1;
+  mLastPararealIterations = 0;
+  if (mPararealSegments > 1 && mCheckpointInterval == 0)
+  {
+    refreshSnapshotsCacheParareal(world, refreshLog);
     snapshot.restore();
     mSnapshotsCacheDirty = false;
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
@@ -674,7 +960,250 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
       refreshLog->end();
     }
 #endif
+    return;
   }
+  if (mCheckpointInterval > 0)
+  {
+    mCheckpoints.reserve((mSteps + mCheckpointInterval - 1)
+                         / mCheckpointInterval);
+  }
+  else
+  {
+    mSnapshotsCache.reserve(mSteps);
+  }
+
+  world->setPositions(mStartPos);
+  world->setVelocities(mStartVel);
+
+  for (int i = 0; i < mSteps; i++)
+  {
+    if (mCheckpointInterval > 0 && i % mCheckpointInterval == 0)
+    {
+      Checkpoint checkpoint;
+      checkpoint.pos = world->getPositions();
+      checkpoint.vel = world->getVelocities();
+      checkpoint.lcpCache = world->getCachedLCPSolution();
+      mCheckpoints.push_back(checkpoint);
+    }
+    world->setControlForces(mForces.col(i));
+    // We still take a full mapped forward pass when checkpointing, even though
+    // we throw away the snapshot, so that the states we checkpoint are exactly
+    // the ones a non-checkpointed unroll would see
+    MappedBackpropSnapshotPtr ptr = mappedForwardPass(world, mMappings);
+    if (mCheckpointInterval == 0)
+    {
+      mSnapshotsCache.push_back(ptr);
+    }
+  }
+  if (mCheckpointInterval > 0)
+  {
+    mCheckpointFinalState
+        = Eigen::VectorXs::Zero(getRepresentationStateSize());
+    mCheckpointFinalState.segment(0, world->getNumDofs())
+        = world->getPositions();
+    mCheckpointFinalState.segment(world->getNumDofs(), world->getNumDofs())
+        = world->getVelocities();
+  }
+
+  snapshot.restore();
+  mSnapshotsCacheDirty = false;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (refreshLog != nullptr)
+  {
+    refreshLog->end();
+  }
+#endif
+}
+
+//==============================================================================
+/// This returns the snapshot at `step`, re-simulating its segment from the
+/// nearest checkpoint if we need to
+MappedBackpropSnapshotPtr SingleShot::getSnapshot(
+    std::shared_ptr<simulation::World> world, int step, PerformanceLog* log)
+{
+  refreshSnapshotsCache(world, log);
+  assert(step >= 0 && step < mSteps);
+  if (mCheckpointInterval == 0)
+  {
+    return mSnapshotsCache[step];
+  }
+
+  int segmentStart = (step / mCheckpointInterval) * mCheckpointInterval;
+  if (segmentStart != mSegmentCacheStart)
+  {
+    PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+    if (log != nullptr)
+    {
+      thisLog = log->startRun("SingleShot.getSnapshot#resimulateSegment");
+    }
+#endif
+    RestorableSnapshot snapshot(world);
+
+    // Drop the old segment before we build the new one, so we never hold two
+    mSegmentCache.clear();
+    const Checkpoint& checkpoint
+        = mCheckpoints[segmentStart / mCheckpointInterval];
+    world->setPositions(checkpoint.pos);
+    world->setVelocities(checkpoint.vel);
+    world->setCachedLCPSolution(checkpoint.lcpCache);
+    int segmentEnd = std::min(mSteps, segmentStart + mCheckpointInterval);
+    for (int i = segmentStart; i < segmentEnd; i++)
+    {
+      world->setControlForces(mForces.col(i));
+      mSegmentCache.push_back(mappedForwardPass(world, mMappings));
+    }
+    mSegmentCacheStart = segmentStart;
+
+    snapshot.restore();
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+    if (thisLog != nullptr)
+    {
+      thisLog->end();
+    }
+#endif
+  }
+  return mSegmentCache[step - segmentStart];
+}
+
+//==============================================================================
+/// This fills mSnapshotsCache with a parareal rollout
+void SingleShot::refreshSnapshotsCacheParareal(
+    std::shared_ptr<simulation::World> world, PerformanceLog* log)
+{
+  PerformanceLog* thisLog = nullptr;
+#ifdef LOG_PERFORMANCE_SINGLE_SHOT
+  if (log != nullptr)
+  {
+    thisLog = log->startRun("SingleShot.refreshSnapshotsCacheParareal");
+  }
+#endif
+
+  const int dofs = world->getNumDofs();
+  const int numSegments = mPararealSegments;
+  const s_t dt = world->getTimeStep();
+  std::vector<int> segmentStarts(numSegments + 1);
+  for (int j = 0; j <= numSegments; j++)
+  {
+    segmentStarts[j] = (int)(((long)j * mSteps) / numSegments);
+  }
+
+  // The guessed (pos, vel) and LCP warm start at the start of each segment
+  std::vector<Eigen::VectorXs> starts(numSegments);
+  std::vector<Eigen::VectorXs> startLCPCaches(
+      numSegments, world->getCachedLCPSolution());
+  // Where the coarse and fine passes ended up, from those starts
+  std::vector<Eigen::VectorXs> coarseEnds(numSegments);
+  std::vector<Eigen::VectorXs> fineEnds(numSegments);
+  std::vector<Eigen::VectorXs> fineLCPCaches(numSegments);
+
+  // This runs the coarse pass over a segment, on `world`. Each coarse step
+  // applies the average of the forces over the steps it covers.
+  auto coarse = [&](int segment, const Eigen::VectorXs& state) {
+    world->setPositions(state.head(dofs));
+    world->setVelocities(state.tail(dofs));
+    for (int i = segmentStarts[segment]; i < segmentStarts[segment + 1];
+         i += mPararealCoarseStepRatio)
+    {
+      int len = std::min(
+          mPararealCoarseStepRatio, segmentStarts[segment + 1] - i);
+      world->setTimeStep(dt * len);
+      world->setControlForces(mForces.middleCols(i, len).rowwise().mean());
+      world->step();
+    }
+    world->setTimeStep(dt);
+    Eigen::VectorXs end(2 * dofs);
+    end.head(dofs) = world->getPositions();
+    end.tail(dofs) = world->getVelocities();
+    return end;
+  };
+
+  // This runs the real forward pass over a segment on its own world, keeping
+  // every snapshot. Segments write disjoint parts of mSnapshotsCache, so these
+  // can all run at once.
+  Eigen::VectorXs masses = world->getMasses();
+  bool copyMasses = world->getMassDims() > 0;
+  mSnapshotsCache.resize(mSteps);
+  auto fine = [&](int segment) {
+    std::shared_ptr<simulation::World> segmentWorld = mPararealWorlds[segment];
+    segmentWorld->setTimeStep(dt);
+    if (copyMasses)
+    {
+      segmentWorld->setMasses(masses);
+    }
+    segmentWorld->setPositions(starts[segment].head(dofs));
+    segmentWorld->setVelocities(starts[segment].tail(dofs));
+    segmentWorld->setCachedLCPSolution(startLCPCaches[segment]);
+    for (int i = segmentStarts[segment]; i < segmentStarts[segment + 1]; i++)
+    {
+      segmentWorld->setControlForces(mForces.col(i));
+      mSnapshotsCache[i] = mappedForwardPass(segmentWorld, mMappings);
+    }
+    fineEnds[segment] = Eigen::VectorXs(2 * dofs);
+    fineEnds[segment].head(dofs) = segmentWorld->getPositions();
+    fineEnds[segment].tail(dofs) = segmentWorld->getVelocities();
+    fineLCPCaches[segment] = segmentWorld->getCachedLCPSolution();
+  };
+
+  starts[0] = Eigen::VectorXs(2 * dofs);
+  starts[0].head(dofs) = mStartPos;
+  starts[0].tail(dofs) = mStartVel;
+  for (int j = 0; j < numSegments; j++)
+  {
+    coarseEnds[j] = coarse(j, starts[j]);
+    if (j + 1 < numSegments)
+    {
+      starts[j + 1] = coarseEnds[j];
+    }
+  }
+
+  int maxIterations = numSegments;
+  if (mPararealMaxIterations > 0)
+  {
+    maxIterations = std::min(maxIterations, mPararealMaxIterations);
+  }
+  // The segments before `exact` start from the same state the serial rollout
+  // would, so once they've had a fine pass we never need to redo them
+  int exact = 1;
+  int iterations = 0;
+  while (true)
+  {
+    std::vector<common::TaskFuture<void>> futures;
+    for (int j = exact - 1; j < numSegments; j++)
+    {
+      futures.push_back(common::async([&, j] { fine(j); }));
+    }
+    for (int j = 0; j < futures.size(); j++)
+    {
+      futures[j].get();
+    }
+    iterations++;
+    if (exact == numSegments || iterations >= maxIterations)
+    {
+      break;
+    }
+
+    // Correct the guesses, with the coarse pass from each new guess plus the
+    // difference between the fine and coarse passes from the old one
+    s_t change = 0.0;
+    for (int j = exact - 1; j + 1 < numSegments; j++)
+    {
+      Eigen::VectorXs coarseEnd
+          = j == exact - 1 ? coarseEnds[j] : coarse(j, starts[j]);
+      Eigen::VectorXs next = coarseEnd + fineEnds[j] - coarseEnds[j];
+      coarseEnds[j] = coarseEnd;
+      change = std::max(
+          change, (s_t)(next - starts[j + 1]).lpNorm<Eigen::Infinity>());
+      starts[j + 1] = next;
+      startLCPCaches[j + 1] = fineLCPCaches[j];
+    }
+    exact++;
+    if (change <= mPararealTolerance)
+    {
+      break;
+    }
+  }
+  mLastPararealIterations = iterations;
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -682,7 +1211,6 @@ std::vector<MappedBackpropSnapshotPtr> SingleShot::getSnapshots(
     thisLog->end();
   }
 #endif
-  return mSnapshotsCache;
 }
 
 //==============================================================================
@@ -701,8 +1229,7 @@ void SingleShot::getStates(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  refreshSnapshotsCache(world, thisLog);
 
   for (std::string key : rollout->getMappings())
   {
@@ -714,9 +1241,10 @@ void SingleShot::getStates(
     assert(rollout->getControlForces(key).rows() == mMappings[key]->getControlForceDim());
     for (int i = 0; i < mSteps; i++)
     {
-      rollout->getPoses(key).col(i) = snapshots[i]->getPostStepPosition(key);
-      rollout->getVels(key).col(i) = snapshots[i]->getPostStepVelocity(key);
-      rollout->getControlForces(key).col(i) = snapshots[i]->getPreStepTorques(key);
+      MappedBackpropSnapshotPtr ptr = getSnapshot(world, i, thisLog);
+      rollout->getPoses(key).col(i) = ptr->getPostStepPosition(key);
+      rollout->getVels(key).col(i) = ptr->getPostStepVelocity(key);
+      rollout->getControlForces(key).col(i) = ptr->getPreStepTorques(key);
     }
   }
   assert(rollout->getMasses().size() == world->getMassDims());
@@ -776,6 +1304,8 @@ void SingleShot::setControlForcesRaw(
 #endif
 
   mForces = forces;
+  mRolloutCacheDirty = true;
+  mSnapshotsCacheDirty = true;
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
@@ -795,7 +1325,29 @@ Eigen::VectorXi SingleShot::advanceSteps(
     Eigen::VectorXs startVel,
     int steps)
 {
-  Eigen::VectorXi mapping = Eigen::VectorXi::Zero(getFlatProblemDim(world));
+  Eigen::VectorXi mapping
+      = Eigen::VectorXi::Constant(getFlatProblemDim(world), -1);
+
+  // The static values and the start state don't move, they just get new
+  // values
+  int cursor = getFlatStaticProblemDim(world);
+  if (mTuneStartingState)
+  {
+    cursor += world->getNumDofs() * 2;
+  }
+  for (int i = 0; i < cursor; i++)
+  {
+    mapping(i) = i;
+  }
+  // Forces come from `steps` columns later
+  int forceDim = mForces.rows();
+  for (int t = 0; t < mSteps - steps; t++)
+  {
+    for (int j = 0; j < forceDim; j++)
+    {
+      mapping(cursor + t * forceDim + j) = cursor + (t + steps) * forceDim + j;
+    }
+  }
 
   mStartPos = startPos;
   mStartVel = startVel;
@@ -807,6 +1359,8 @@ Eigen::VectorXi SingleShot::advanceSteps(
         = mForces.block(0, steps, mForces.rows(), mSteps - steps);
   }
   mForces = newForces;
+  mSnapshotsCacheDirty = true;
+  mRolloutCacheDirty = true;
 
   return mapping;
 }
@@ -864,14 +1418,21 @@ Eigen::VectorXs SingleShot::getFinalState(
   }
 #endif
 
-  std::vector<MappedBackpropSnapshotPtr> snapshots
-      = getSnapshots(world, thisLog);
+  refreshSnapshotsCache(world, thisLog);
 
   Eigen::VectorXs state = Eigen::VectorXs::Zero(getRepresentationStateSize());
-  state.segment(0, world->getNumDofs())
-      = snapshots[snapshots.size() - 1]->getPostStepPosition("identity");
-  state.segment(world->getNumDofs(), world->getNumDofs())
-      = snapshots[snapshots.size() - 1]->getPostStepVelocity("identity");
+  if (mCheckpointInterval > 0)
+  {
+    // We recorded this on the forward pass, so we don't need to re-simulate
+    state = mCheckpointFinalState;
+  }
+  else
+  {
+    state.segment(0, world->getNumDofs())
+        = mSnapshotsCache[mSteps - 1]->getPostStepPosition("identity");
+    state.segment(world->getNumDofs(), world->getNumDofs())
+        = mSnapshotsCache[mSteps - 1]->getPostStepVelocity("identity");
+  }
 
 #ifdef LOG_PERFORMANCE_SINGLE_SHOT
   if (thisLog != nullptr)
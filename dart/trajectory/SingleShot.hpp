@@ -35,6 +35,10 @@ public:
   /// Destructor
   virtual ~SingleShot() override;
 
+  /// This returns an independent copy of this shot, running on `world`
+  std::shared_ptr<Problem> clone(
+      std::shared_ptr<simulation::World> world) const override;
+
   /// This prevents a force from changing in optimization, keeping it fixed at a
   /// specified value.
   void pinForce(int time, Eigen::VectorXs value) override;
@@ -42,6 +46,10 @@ public:
   /// This returns the pinned force value at this timestep.
   Eigen::Ref<Eigen::VectorXs> getPinnedForce(int time) override;
 
+  /// This returns true if the force at this timestep has been pinned with
+  /// pinForce()
+  bool isForcePinned(int time) const;
+
   /// Returns the length of the flattened problem state
   int getFlatDynamicProblemDim(
       std::shared_ptr<simulation::World> world) const override;
@@ -116,6 +124,45 @@ public:
       std::shared_ptr<simulation::World> world,
       PerformanceLog* log = nullptr) override;
 
+  /// By default we keep a BackpropSnapshot for every timestep of the rollout,
+  /// which can use a lot of memory on long trajectories. Setting this to
+  /// `interval` > 0 instead only keeps the world state every `interval` steps,
+  /// and re-simulates one `interval` long segment at a time during backprop.
+  /// That costs roughly one extra forward pass per gradient, and peak memory
+  /// is about (steps / interval) states + `interval` snapshots, which is
+  /// smallest at `interval` = sqrt(steps). Setting this to 0 goes back to
+  /// keeping every snapshot.
+  void setCheckpointInterval(int interval);
+
+  /// This returns the checkpoint interval, or 0 if we're keeping every
+  /// snapshot. See setCheckpointInterval().
+  int getCheckpointInterval() const;
+
+  /// This switches the forward rollout over to parareal, which spreads a long
+  /// horizon over several cores. The steps are split into `numSegments`
+  /// segments, and a coarse pass (taking steps `coarseStepRatio` times longer
+  /// than the world's timestep) guesses the state at the start of each one.
+  /// Then we repeatedly simulate every segment in parallel at the real
+  /// timestep from its guessed start, and correct the guesses with a serial
+  /// coarse pass, until no guess moves by more than `tolerance`. After k
+  /// iterations the first k segments are exact, so this never takes more than
+  /// `numSegments` iterations, and `maxIterations` > 0 caps it lower.
+  ///
+  /// The rollout matches the serial one to within `tolerance`, and it only
+  /// beats it on wall-clock time if the coarse pass is a good enough predictor
+  /// to converge in far fewer than `numSegments` iterations. This is ignored
+  /// while checkpointing (see setCheckpointInterval()). Setting `numSegments`
+  /// <= 1 goes back to the serial rollout.
+  void setParareal(
+      int numSegments,
+      int coarseStepRatio = 10,
+      s_t tolerance = 1e-8,
+      int maxIterations = 0);
+
+  /// This returns how many parareal iterations the last rollout took, or 0 if
+  /// it wasn't run with parareal
+  int getLastPararealIterations() const;
+
   /// This populates the passed in matrices with the values from this trajectory
   void getStates(
       std::shared_ptr<simulation::World> world,
@@ -135,7 +182,10 @@ public:
 
   /// This moves the trajectory forward in time, setting the starting point to
   /// the new given starting point, and shifting the forces over by `steps`,
-  /// padding the remainder with 0s
+  /// padding the remainder with 0s. This returns, for each index of the new
+  /// flat problem, the index that value held in the flat problem before the
+  /// shift, or -1 if it's new padding. That's what lets a re-solve warm start
+  /// its multipliers from the last solve.
   Eigen::VectorXi advanceSteps(
       std::shared_ptr<simulation::World> world,
       Eigen::VectorXs startPos,
@@ -170,6 +220,27 @@ public:
   std::string getFlatDimName(
       std::shared_ptr<simulation::World> world, int dim) override;
 
+  /// This gets the number of non-zero entries in the lower triangle of the
+  /// Gauss-Newton Hessian. Every force affects every later state, so this is
+  /// dense over the dynamic variables.
+  int getNumberNonZeroGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world) override;
+
+  /// This gets the structure of the non-zero entries in the lower triangle of
+  /// the Gauss-Newton Hessian
+  void getGaussNewtonHessianStructure(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXi> rows,
+      Eigen::Ref<Eigen::VectorXi> cols,
+      PerformanceLog* log = nullptr) override;
+
+  /// This writes the lower triangle of the Gauss-Newton Hessian to a sparse
+  /// vector
+  void getSparseGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      Eigen::Ref<Eigen::VectorXs> sparse,
+      PerformanceLog* log = nullptr) override;
+
   //////////////////////////////////////////////////////////////////////////////
   // For Testing
   //////////////////////////////////////////////////////////////////////////////
@@ -197,8 +268,59 @@ private:
   std::vector<bool> mForcesPinned;
   Eigen::MatrixXs mPinnedForces;
 
+  /// This re-runs the forward pass, if the cached snapshots (or checkpoints)
+  /// are stale
+  void refreshSnapshotsCache(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log);
+
+  /// This returns the snapshot at `step`. If we're checkpointing, this
+  /// re-simulates the segment containing `step` from its checkpoint, unless
+  /// that's the segment we most recently re-simulated, so iterating over the
+  /// steps in order (forwards or backwards) only simulates each segment once.
+  neural::MappedBackpropSnapshotPtr getSnapshot(
+      std::shared_ptr<simulation::World> world,
+      int step,
+      PerformanceLog* log = nullptr);
+
+  /// This fills the lower triangle of `hessian` with J^T H J, where J is the
+  /// Jacobian of each timestep's (pos, vel, force) wrt our dynamic variables,
+  /// and H is that timestep's loss Hessian, read from `lossHessians` starting
+  /// at `firstTimestep`. The masses are left out.
+  void getDenseGaussNewtonHessian(
+      std::shared_ptr<simulation::World> world,
+      const std::vector<Eigen::MatrixXs>& lossHessians,
+      int firstTimestep,
+      /* OUT */ Eigen::Ref<Eigen::MatrixXs> hessian,
+      PerformanceLog* log = nullptr);
+
+  /// This fills mSnapshotsCache with a parareal rollout. See setParareal().
+  void refreshSnapshotsCacheParareal(
+      std::shared_ptr<simulation::World> world, PerformanceLog* log);
+
   bool mSnapshotsCacheDirty;
   std::vector<neural::MappedBackpropSnapshotPtr> mSnapshotsCache;
+
+  int mPararealSegments;
+  int mPararealCoarseStepRatio;
+  s_t mPararealTolerance;
+  int mPararealMaxIterations;
+  int mLastPararealIterations;
+  /// One world per segment, cloned when parareal is turned on
+  std::vector<std::shared_ptr<simulation::World>> mPararealWorlds;
+
+  /// The world state at the start of a checkpointed segment
+  struct Checkpoint
+  {
+    Eigen::VectorXs pos;
+    Eigen::VectorXs vel;
+    Eigen::VectorXs lcpCache;
+  };
+
+  int mCheckpointInterval;
+  std::vector<Checkpoint> mCheckpoints;
+  Eigen::VectorXs mCheckpointFinalState;
+  int mSegmentCacheStart;
+  std::vector<neural::MappedBackpropSnapshotPtr> mSegmentCache;
 };
 
 } // namespace trajectory
@@ -1,9 +1,12 @@
 #include "dart/trajectory/Solution.hpp"
 
+#include <cstdint>
 #include <sstream>
 #include <unordered_map>
 #include <vector>
 
+#include <zlib.h>
+
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/ShapeNode.hpp"
@@ -19,8 +22,173 @@ namespace dart {
 namespace trajectory {
 
 //==============================================================================
-Solution::Solution() : mSuccess(false), mPerfLog(nullptr)
+SolutionHistoryConfig::SolutionHistoryConfig()
+  : keepLast(0), keepEvery(1), recordSparseJacobians(false), spillPath("")
+{
+}
+
+//==============================================================================
+SolutionHistoryConfig& SolutionHistoryConfig::setKeepLast(int v)
+{
+  keepLast = v;
+  return *this;
+}
+
+//==============================================================================
+SolutionHistoryConfig& SolutionHistoryConfig::setKeepEvery(int v)
+{
+  keepEvery = v;
+  return *this;
+}
+
+//==============================================================================
+SolutionHistoryConfig& SolutionHistoryConfig::setRecordSparseJacobians(bool v)
+{
+  recordSparseJacobians = v;
+  return *this;
+}
+
+//==============================================================================
+SolutionHistoryConfig& SolutionHistoryConfig::setSpillPath(
+    const std::string& v)
 {
+  spillPath = v;
+  return *this;
+}
+
+//==============================================================================
+Solution::Solution()
+  : mSuccess(false),
+    mNumIterationsRegistered(0),
+    mNumRegistered{0, 0, 0, 0, 0},
+    mPerfLog(nullptr)
+{
+}
+
+//==============================================================================
+/// This sets how much history we keep. This should be set before optimization
+/// starts.
+void Solution::setHistoryConfig(const SolutionHistoryConfig& config)
+{
+  mHistoryConfig = config;
+}
+
+//==============================================================================
+/// This returns how much history we keep
+const SolutionHistoryConfig& Solution::getHistoryConfig() const
+{
+  return mHistoryConfig;
+}
+
+//==============================================================================
+/// This reads back the entries of type `type` that were spilled to the log at
+/// `path`, paired with the (0-indexed) order in which they were registered.
+std::vector<std::pair<int, Eigen::VectorXs>> Solution::loadSpilledHistory(
+    const std::string& path, HistoryType type)
+{
+  std::vector<std::pair<int, Eigen::VectorXs>> entries;
+  gzFile file = gzopen(path.c_str(), "rb");
+  if (file == nullptr)
+  {
+    return entries;
+  }
+  int32_t header[3];
+  while (gzread(file, header, sizeof(header)) == sizeof(header))
+  {
+    Eigen::VectorXd entry(header[2]);
+    int bytes = header[2] * sizeof(double);
+    if (gzread(file, entry.data(), bytes) != bytes)
+    {
+      std::cout << "Solution::loadSpilledHistory() found a truncated entry in "
+                << path << ", stopping there" << std::endl;
+      break;
+    }
+    if (header[0] == type)
+    {
+      entries.emplace_back(header[1], entry.cast<s_t>());
+    }
+  }
+  gzclose(file);
+  return entries;
+}
+
+//==============================================================================
+/// This applies our SolutionHistoryConfig to a single new entry, and returns
+/// true if it should be kept.
+bool Solution::shouldRecord(int& count)
+{
+  int index = count++;
+  return mHistoryConfig.keepEvery <= 1
+         || index % mHistoryConfig.keepEvery == 0;
+}
+
+//==============================================================================
+/// This appends a single entry to our spilled history log
+void Solution::spill(HistoryType type, int index, const Eigen::VectorXs& entry)
+{
+  // gzip files can be concatenated, so it's safe to open the log fresh for
+  // every append, which also means the log on disk is always complete
+  gzFile file = gzopen(mHistoryConfig.spillPath.c_str(), "ab");
+  if (file == nullptr)
+  {
+    std::cout << "Solution failed to open " << mHistoryConfig.spillPath
+              << " to spill history to, dropping the entry" << std::endl;
+    return;
+  }
+  int32_t header[3] = {(int32_t)type, (int32_t)index, (int32_t)entry.size()};
+  Eigen::VectorXd asDouble = entry.cast<double>();
+  gzwrite(file, header, sizeof(header));
+  gzwrite(file, asDouble.data(), asDouble.size() * sizeof(double));
+  gzclose(file);
+}
+
+//==============================================================================
+static Eigen::VectorXs historyEntryToVector(const Eigen::VectorXs& entry)
+{
+  return entry;
+}
+
+//==============================================================================
+static Eigen::VectorXs historyEntryToVector(s_t entry)
+{
+  return Eigen::VectorXs::Constant(1, entry);
+}
+
+//==============================================================================
+/// This appends `entry` to `history`, if our SolutionHistoryConfig says to
+/// keep it, and then evicts (and possibly spills) the oldest entries until
+/// `history` fits within `keepLast`.
+template <typename T>
+void Solution::recordHistory(
+    std::vector<T>& history, HistoryType type, const T& entry)
+{
+  int index = mNumRegistered[type];
+  if (!shouldRecord(mNumRegistered[type]))
+  {
+    return;
+  }
+  history.push_back(entry);
+  mIndicesInMemory[type].push_back(index);
+
+  int keepLast = mHistoryConfig.keepLast;
+  if (keepLast > 0 && history.size() > keepLast)
+  {
+    int numToEvict = history.size() - keepLast;
+    if (!mHistoryConfig.spillPath.empty())
+    {
+      for (int i = 0; i < numToEvict; i++)
+      {
+        spill(
+            type,
+            mIndicesInMemory[type][i],
+            historyEntryToVector(history[i]));
+      }
+    }
+    history.erase(history.begin(), history.begin() + numToEvict);
+    mIndicesInMemory[type].erase(
+        mIndicesInMemory[type].begin(),
+        mIndicesInMemory[type].begin() + numToEvict);
+  }
 }
 
 //==============================================================================
@@ -112,6 +280,29 @@ void Solution::reoptimize()
   this->registerForReoptimization(mIpopt, mIpoptProblem);
 }
 
+//==============================================================================
+/// This will attempt to run another round of optimization after the problem
+/// has been shifted forward in time by Problem::advanceSteps(), which
+/// returned `shiftMapping`. This warm starts IPOPT from the shifted primal
+/// and the last solve's multipliers, moved to follow the shift. If we don't
+/// have multipliers to warm start from, this is the same as reoptimize().
+void Solution::reoptimize(const Eigen::VectorXi& shiftMapping)
+{
+  if (!mIpoptProblem->shift_saved_multipliers(shiftMapping))
+  {
+    reoptimize();
+    return;
+  }
+
+  // The shifted solution is already close to optimal, so don't let IPOPT push
+  // it (or its multipliers) far back into the interior of the bounds
+  mIpopt->Options()->SetStringValue("warm_start_init_point", "yes");
+  mIpopt->Options()->SetNumericValue("warm_start_bound_push", 1e-6);
+  mIpopt->Options()->SetNumericValue("warm_start_mult_bound_push", 1e-6);
+  reoptimize();
+  mIpopt->Options()->SetStringValue("warm_start_init_point", "no");
+}
+
 //==============================================================================
 void Solution::setSuccess(bool success)
 {
@@ -129,7 +320,16 @@ void Solution::registerIteration(
     s_t loss,
     s_t constraintViolation)
 {
+  if (!shouldRecord(mNumIterationsRegistered))
+  {
+    return;
+  }
   mSteps.emplace_back(index, rollout, loss, constraintViolation);
+  int keepLast = mHistoryConfig.keepLast;
+  if (keepLast > 0 && mSteps.size() > keepLast)
+  {
+    mSteps.erase(mSteps.begin(), mSteps.end() - keepLast);
+  }
 }
 
 //==============================================================================
@@ -137,7 +337,7 @@ void Solution::registerIteration(
 /// x that we receive during optimization
 void Solution::registerX(Eigen::VectorXs x)
 {
-  mXs.push_back(x);
+  recordHistory(mXs, X, x);
 }
 
 //==============================================================================
@@ -145,7 +345,7 @@ void Solution::registerX(Eigen::VectorXs x)
 /// loss evaluation that we produce during optimization
 void Solution::registerLoss(s_t loss)
 {
-  mLosses.push_back(loss);
+  recordHistory(mLosses, LOSS, loss);
 }
 
 //==============================================================================
@@ -153,7 +353,7 @@ void Solution::registerLoss(s_t loss)
 /// gradient that we produce during optimization
 void Solution::registerGradient(Eigen::VectorXs grad)
 {
-  mGradients.push_back(grad);
+  recordHistory(mGradients, GRADIENT, grad);
 }
 
 //==============================================================================
@@ -161,7 +361,7 @@ void Solution::registerGradient(Eigen::VectorXs grad)
 /// constraint value that we produce during optimization
 void Solution::registerConstraintValues(Eigen::VectorXs g)
 {
-  mConstraintValues.push_back(g);
+  recordHistory(mConstraintValues, CONSTRAINT_VALUES, g);
 }
 
 //==============================================================================
@@ -169,7 +369,11 @@ void Solution::registerConstraintValues(Eigen::VectorXs g)
 /// jacobian that we produce during optimization
 void Solution::registerSparseJac(Eigen::VectorXs jac)
 {
-  mSparseJacobians.push_back(jac);
+  if (!mHistoryConfig.recordSparseJacobians)
+  {
+    return;
+  }
+  recordHistory(mSparseJacobians, SPARSE_JACOBIAN, jac);
 }
 
 //==============================================================================
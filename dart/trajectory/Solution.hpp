@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <coin/IpIpoptApplication.hpp>
@@ -44,11 +45,61 @@ struct OptimizationStep
   }
 };
 
+/// This controls how much of its history a Solution keeps. Long MPC sessions
+/// and large problems can otherwise accumulate gigabytes of iterations.
+struct SolutionHistoryConfig
+{
+  SolutionHistoryConfig();
+
+  SolutionHistoryConfig& setKeepLast(int v);
+  SolutionHistoryConfig& setKeepEvery(int v);
+  SolutionHistoryConfig& setRecordSparseJacobians(bool v);
+  SolutionHistoryConfig& setSpillPath(const std::string& v);
+
+  // If this is > 0, only the most recent `keepLast` entries of each history
+  // (iterations, x's, losses, etc) are kept in memory
+  int keepLast;
+  // Only every `keepEvery`-th entry of each history is recorded at all
+  int keepEvery;
+  // Sparse Jacobians are by far the largest entries, so they aren't recorded
+  // unless this is set, even when recording full debug info
+  bool recordSparseJacobians;
+  // If this is non-empty, the x's, losses, gradients, constraint values and
+  // sparse Jacobians that `keepLast` evicts from memory get appended to a
+  // gzip-compressed log at this path, which Solution::loadSpilledHistory()
+  // can read back. Iterations are dropped, since their rollouts are large.
+  std::string spillPath;
+};
+
 class Solution
 {
 public:
+  /// The different histories we can record, which tag the entries in a
+  /// spilled history log
+  enum HistoryType
+  {
+    X = 0,
+    LOSS = 1,
+    GRADIENT = 2,
+    CONSTRAINT_VALUES = 3,
+    SPARSE_JACOBIAN = 4
+  };
+
   Solution();
 
+  /// This sets how much history we keep. This should be set before
+  /// optimization starts.
+  void setHistoryConfig(const SolutionHistoryConfig& config);
+
+  /// This returns how much history we keep
+  const SolutionHistoryConfig& getHistoryConfig() const;
+
+  /// This reads back the entries of type `type` that were spilled to the log
+  /// at `path`, paired with the (0-indexed) order in which they were
+  /// registered. Losses come back as vectors of length 1.
+  static std::vector<std::pair<int, Eigen::VectorXs>> loadSpilledHistory(
+      const std::string& path, HistoryType type);
+
   /// After optimization, register whether IPOPT thought it was a success
   void setSuccess(bool success);
 
@@ -76,7 +127,8 @@ public:
   void registerConstraintValues(Eigen::VectorXs g);
 
   /// This only gets called if we're saving full debug info, but it stores every
-  /// jacobian that we produce during optimization
+  /// jacobian that we produce during optimization. These are large, so they're
+  /// dropped unless SolutionHistoryConfig::recordSparseJacobians is set.
   void registerSparseJac(Eigen::VectorXs jac);
 
   /// Returns the number of steps that were registered
@@ -125,8 +177,38 @@ public:
   /// This will attempt to run another round of optimization.
   void reoptimize();
 
+  /// This will attempt to run another round of optimization after the problem
+  /// has been shifted forward in time by Problem::advanceSteps(), which
+  /// returned `shiftMapping`. This warm starts IPOPT from the shifted primal
+  /// and the last solve's multipliers, moved to follow the shift. If we don't
+  /// have multipliers to warm start from, this is the same as reoptimize().
+  void reoptimize(const Eigen::VectorXi& shiftMapping);
+
 protected:
+  /// This applies our SolutionHistoryConfig to a single new entry, and
+  /// returns true if it should be kept. `count` is the number of entries of
+  /// this kind that have been registered so far, and gets incremented.
+  bool shouldRecord(int& count);
+
+  /// This appends `entry` to `history`, if our SolutionHistoryConfig says to
+  /// keep it, and then evicts (and possibly spills) the oldest entries until
+  /// `history` fits within `keepLast`.
+  template <typename T>
+  void recordHistory(
+      std::vector<T>& history, HistoryType type, const T& entry);
+
+  /// This appends a single entry to our spilled history log
+  void spill(HistoryType type, int index, const Eigen::VectorXs& entry);
+
   bool mSuccess;
+  SolutionHistoryConfig mHistoryConfig;
+  int mNumIterationsRegistered;
+  // How many entries of each HistoryType have been registered, including ones
+  // that were skipped or evicted
+  int mNumRegistered[5];
+  // The registration index of each entry still in memory, for each
+  // HistoryType, so that spilled entries can be labeled with their index
+  std::vector<int> mIndicesInMemory[5];
   std::vector<OptimizationStep> mSteps;
   performance::PerformanceLog* mPerfLog;
   std::vector<Eigen::VectorXs> mXs;
@@ -134,7 +134,7 @@ void TrajectoryRollout::serialize(proto::TrajectoryRollout& proto) const
         (*proto.mutable_force())[mapping], getControlForcesConst(mapping));
   }
   proto::serializeVector(*proto.mutable_mass(), getMassesConst());
-  for (auto pair : getMetadataMap())
+  for (const auto& pair : getMetadataMap())
   {
     proto::serializeMatrix(
         (*proto.mutable_metadata())[pair.first], pair.second);
@@ -405,6 +405,152 @@ void TrajectoryRolloutReal::setMetadata(
   mMetadata[key] = value;
 }
 
+//==============================================================================
+/// Wraps the buffers for every mapping
+TrajectoryRolloutMap::TrajectoryRolloutMap(
+    const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>> pos,
+    const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>> vel,
+    const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>> force,
+    Eigen::Ref<Eigen::VectorXs> mass,
+    const std::unordered_map<std::string, Eigen::MatrixXs> metadata)
+  : mMasses(mass.data(), mass.size()), mMetadata(metadata)
+{
+  for (auto pair : pos)
+  {
+    mMappings.push_back(pair.first);
+  }
+  for (const std::string& mapping : mMappings)
+  {
+    assert(pos.at(mapping).cols() == vel.at(mapping).cols());
+    assert(pos.at(mapping).cols() == force.at(mapping).cols());
+    mPoses.emplace(mapping, toMap(pos.at(mapping)));
+    mVels.emplace(mapping, toMap(vel.at(mapping)));
+    mForces.emplace(mapping, toMap(force.at(mapping)));
+  }
+}
+
+//==============================================================================
+/// Wraps the buffers for just the "identity" mapping
+TrajectoryRolloutMap::TrajectoryRolloutMap(
+    Eigen::Ref<Eigen::MatrixXs> pos,
+    Eigen::Ref<Eigen::MatrixXs> vel,
+    Eigen::Ref<Eigen::MatrixXs> force,
+    Eigen::Ref<Eigen::VectorXs> mass,
+    const std::unordered_map<std::string, Eigen::MatrixXs> metadata)
+  : mMasses(mass.data(), mass.size()), mMetadata(metadata)
+{
+  assert(pos.cols() == vel.cols());
+  assert(pos.cols() == force.cols());
+  mMappings.push_back("identity");
+  mPoses.emplace("identity", toMap(pos));
+  mVels.emplace("identity", toMap(vel));
+  mForces.emplace("identity", toMap(force));
+}
+
+//==============================================================================
+/// This points a Map at the same memory as `buffer`, keeping its stride, so
+/// that we can hold on to it after the Ref goes away
+TrajectoryRolloutMap::MatrixMap TrajectoryRolloutMap::toMap(
+    Eigen::Ref<Eigen::MatrixXs> buffer)
+{
+  return MatrixMap(
+      buffer.data(),
+      buffer.rows(),
+      buffer.cols(),
+      Eigen::OuterStride<>(buffer.outerStride()));
+}
+
+//==============================================================================
+const std::vector<std::string>& TrajectoryRolloutMap::getMappings() const
+{
+  return mMappings;
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutMap::getPoses(
+    const std::string& mapping)
+{
+  return mPoses.at(mapping);
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutMap::getVels(
+    const std::string& mapping)
+{
+  return mVels.at(mapping);
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::MatrixXs> TrajectoryRolloutMap::getControlForces(
+    const std::string& mapping)
+{
+  return mForces.at(mapping);
+}
+
+//==============================================================================
+Eigen::Ref<Eigen::VectorXs> TrajectoryRolloutMap::getMasses()
+{
+  return mMasses;
+}
+
+//==============================================================================
+const Eigen::Ref<const Eigen::MatrixXs> TrajectoryRolloutMap::getPosesConst(
+    const std::string& mapping) const
+{
+  return mPoses.at(mapping);
+}
+
+//==============================================================================
+const Eigen::Ref<const Eigen::MatrixXs> TrajectoryRolloutMap::getVelsConst(
+    const std::string& mapping) const
+{
+  return mVels.at(mapping);
+}
+
+//==============================================================================
+const Eigen::Ref<const Eigen::MatrixXs>
+TrajectoryRolloutMap::getControlForcesConst(const std::string& mapping) const
+{
+  return mForces.at(mapping);
+}
+
+//==============================================================================
+const Eigen::Ref<const Eigen::VectorXs> TrajectoryRolloutMap::getMassesConst()
+    const
+{
+  return mMasses;
+}
+
+//==============================================================================
+const std::unordered_map<std::string, Eigen::MatrixXs>&
+TrajectoryRolloutMap::getMetadataMap() const
+{
+  return mMetadata;
+}
+
+//==============================================================================
+Eigen::MatrixXs TrajectoryRolloutMap::getMetadata(const std::string& key) const
+{
+  if (mMetadata.find(key) == mMetadata.end())
+  {
+    std::cout << "Warning: Asking TrajectoryRollout for metadata key \"" << key
+              << "\" that doesn't exist! Keys that do exist:" << std::endl;
+    for (auto pair : mMetadata)
+    {
+      std::cout << "   - \"" << pair.first << "\"" << std::endl;
+    }
+    return Eigen::MatrixXs::Zero(0, 0);
+  }
+  return mMetadata.at(key);
+}
+
+//==============================================================================
+void TrajectoryRolloutMap::setMetadata(
+    const std::string& key, Eigen::MatrixXs value)
+{
+  mMetadata[key] = value;
+}
+
 //==============================================================================
 /// Slice constructor
 TrajectoryRolloutRef::TrajectoryRolloutRef(
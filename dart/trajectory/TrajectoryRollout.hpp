@@ -22,6 +22,7 @@ namespace trajectory {
 
 class Problem;
 class TrajectoryRolloutReal;
+class TrajectoryRolloutMap;
 class TrajectoryRolloutRef;
 class TrajectoryRolloutConstRef;
 
@@ -147,6 +148,68 @@ protected:
   std::vector<std::string> mMappings;
 };
 
+/// This is a rollout over memory that someone else owns (for example, numpy
+/// or torch buffers), so that callers can read and write trajectories in place
+/// without copying them in and out on every iteration. The buffers must be
+/// column-major, and must outlive this object.
+class TrajectoryRolloutMap : public TrajectoryRollout
+{
+public:
+  /// Wraps the buffers for every mapping. `pos`, `vel` and `force` must all
+  /// have the same keys.
+  TrajectoryRolloutMap(
+      const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>> pos,
+      const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>> vel,
+      const std::unordered_map<std::string, Eigen::Ref<Eigen::MatrixXs>>
+          force,
+      Eigen::Ref<Eigen::VectorXs> mass,
+      const std::unordered_map<std::string, Eigen::MatrixXs> metadata
+      = std::unordered_map<std::string, Eigen::MatrixXs>());
+
+  /// Wraps the buffers for just the "identity" mapping
+  TrajectoryRolloutMap(
+      Eigen::Ref<Eigen::MatrixXs> pos,
+      Eigen::Ref<Eigen::MatrixXs> vel,
+      Eigen::Ref<Eigen::MatrixXs> force,
+      Eigen::Ref<Eigen::VectorXs> mass,
+      const std::unordered_map<std::string, Eigen::MatrixXs> metadata
+      = std::unordered_map<std::string, Eigen::MatrixXs>());
+
+  const std::vector<std::string>& getMappings() const override;
+  Eigen::Ref<Eigen::MatrixXs> getPoses(
+      const std::string& mapping = "identity") override;
+  Eigen::Ref<Eigen::MatrixXs> getVels(
+      const std::string& mapping = "identity") override;
+  Eigen::Ref<Eigen::MatrixXs> getControlForces(
+      const std::string& mapping = "identity") override;
+  Eigen::Ref<Eigen::VectorXs> getMasses() override;
+  const Eigen::Ref<const Eigen::MatrixXs> getPosesConst(
+      const std::string& mapping = "identity") const override;
+  const Eigen::Ref<const Eigen::MatrixXs> getVelsConst(
+      const std::string& mapping = "identity") const override;
+  const Eigen::Ref<const Eigen::MatrixXs> getControlForcesConst(
+      const std::string& mapping = "identity") const override;
+  const Eigen::Ref<const Eigen::VectorXs> getMassesConst() const override;
+
+  virtual const std::unordered_map<std::string, Eigen::MatrixXs>&
+  getMetadataMap() const override;
+  virtual Eigen::MatrixXs getMetadata(const std::string& key) const override;
+  virtual void setMetadata(
+      const std::string& key, Eigen::MatrixXs value) override;
+
+protected:
+  using MatrixMap = Eigen::Map<Eigen::MatrixXs, 0, Eigen::OuterStride<>>;
+
+  static MatrixMap toMap(Eigen::Ref<Eigen::MatrixXs> buffer);
+
+  std::unordered_map<std::string, MatrixMap> mPoses;
+  std::unordered_map<std::string, MatrixMap> mVels;
+  std::unordered_map<std::string, MatrixMap> mForces;
+  Eigen::Map<Eigen::VectorXs> mMasses;
+  std::unordered_map<std::string, Eigen::MatrixXs> mMetadata;
+  std::vector<std::string> mMappings;
+};
+
 class TrajectoryRolloutRef : public TrajectoryRollout
 {
 public:
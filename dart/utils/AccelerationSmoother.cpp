@@ -1,12 +1,20 @@
 #include "AccelerationSmoother.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 // #include <Eigen/Core>
 // #include <Eigen/Dense>
 #include <Eigen/IterativeLinearSolvers>
 // #include <unsupported/Eigen/IterativeSolvers>
 
+#include "dart/common/TaskScheduler.hpp"
 #include "dart/math/MathTypes.hpp"
 
 namespace dart {
@@ -57,14 +65,11 @@ AccelerationSmoother::AccelerationSmoother(
     mB_sparse.makeCompressed();
     if (!mUseIterativeSolver)
     {
-      mB_sparseSolver.analyzePattern(mB_sparse);
-      mB_sparseSolver.factorize(mB_sparse);
-      if (mB_sparseSolver.info() != Eigen::Success)
-      {
-        std::cout << "mB_sparseSolver.factorize(mB_sparse) error: "
-                  << mB_sparseSolver.lastErrorMessage() << std::endl;
-      }
-      assert(mB_sparseSolver.info() == Eigen::Success);
+      // The normal equations of mB_sparse are banded, so rather than a sparse
+      // QR of mB_sparse we use a banded LDL^T, which depends only on the
+      // length and smoothing weight and can be shared between smoothers
+      mBandedFactorization
+          = BandedFactorization::getCached(mTimesteps, mSmoothingWeight);
     }
   }
   else
@@ -93,56 +98,329 @@ AccelerationSmoother::AccelerationSmoother(
  * columns, and each column represents a complete joint configuration at that
  * timestep.
  */
-Eigen::MatrixXs AccelerationSmoother::smooth(Eigen::MatrixXs series)
+Eigen::MatrixXs AccelerationSmoother::smooth(
+    Eigen::MatrixXs series, int numThreads)
 {
   assert(series.cols() == mTimesteps);
 
   Eigen::MatrixXs smoothed = Eigen::MatrixXs::Zero(series.rows(), mTimesteps);
 
-  for (int row = 0; row < series.rows(); row++)
+  // The iterative solvers only depend on mB, so they're set up once here and
+  // shared (read-only) by every row
+  std::shared_ptr<
+      Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>>>
+      sparseCG;
+  std::shared_ptr<Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs>>
+      denseCG;
+  if (mUseIterativeSolver)
   {
-    Eigen::VectorXs c = Eigen::VectorXs::Zero(mSmoothedTimesteps + mTimesteps);
-    c.segment(mSmoothedTimesteps, mTimesteps)
-        = mRegularizationWeight * series.row(row);
-    if (mUseIterativeSolver)
+    if (mUseSparse)
+    {
+      sparseCG = std::make_shared<
+          Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>>>();
+      sparseCG->compute(mB_sparse);
+      sparseCG->setTolerance(1e-12);
+      sparseCG->setMaxIterations(10000);
+    }
+    else
+    {
+      denseCG = std::make_shared<
+          Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs>>();
+      denseCG->compute(mB);
+      denseCG->setTolerance(1e-12);
+      denseCG->setMaxIterations(10000);
+    }
+  }
+
+  // Each thread takes a contiguous range of rows (DOFs), and only writes those
+  // rows of `smoothed`
+  auto smoothRows = [&](int startRow, int numRows) {
+    if (mUseSparse && !mUseIterativeSolver)
     {
-      if (mUseSparse)
+      // This solves every row at once, as one multi-right-hand-side solve
+      smoothed.middleRows(startRow, numRows)
+          = series.middleRows(startRow, numRows);
+      mBandedFactorization->solveRowsInPlace(
+          smoothed.middleRows(startRow, numRows));
+      return;
+    }
+
+    for (int row = startRow; row < startRow + numRows; row++)
+    {
+      Eigen::VectorXs c
+          = Eigen::VectorXs::Zero(mSmoothedTimesteps + mTimesteps);
+      c.segment(mSmoothedTimesteps, mTimesteps)
+          = mRegularizationWeight * series.row(row);
+      if (mUseIterativeSolver)
       {
-        Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> solver;
-        solver.compute(mB_sparse);
-        solver.setTolerance(1e-12);
-        solver.setMaxIterations(10000);
-        smoothed.row(row) = solver.solveWithGuess(c, series.row(row))
-                            * (1.0 / mRegularizationWeight);
+        if (mUseSparse)
+        {
+          smoothed.row(row) = sparseCG->solveWithGuess(c, series.row(row))
+                              * (1.0 / mRegularizationWeight);
+        }
+        else
+        {
+          smoothed.row(row) = denseCG->solveWithGuess(c, series.row(row))
+                              * (1.0 / mRegularizationWeight);
+        }
       }
       else
       {
-        Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> cg;
-        cg.compute(mB);
-        cg.setTolerance(1e-12);
-        cg.setMaxIterations(10000);
-        smoothed.row(row) = cg.solveWithGuess(c, series.row(row))
-                            * (1.0 / mRegularizationWeight);
+        smoothed.row(row)
+            = mFactoredB.solve(c) * (1.0 / mRegularizationWeight);
       }
     }
-    else
+  };
+
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::max(1, std::min(numThreads, (int)series.rows()));
+  if (numThreads == 1)
+  {
+    smoothRows(0, series.rows());
+    return smoothed;
+  }
+
+  std::vector<common::TaskFuture<void>> futures;
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    const int startRow = (series.rows() * threadIdx) / numThreads;
+    const int endRow = (series.rows() * (threadIdx + 1)) / numThreads;
+    futures.push_back(common::async(
+        [&smoothRows, startRow, endRow] {
+          smoothRows(startRow, endRow - startRow);
+        }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  return smoothed;
+};
+
+/**
+ * This smooths a series of any length in overlapping windows, so the working
+ * memory of the solver is bounded by `windowSize` rather than by the length of
+ * the series.
+ */
+Eigen::MatrixXs AccelerationSmoother::smoothWindowed(
+    const Eigen::MatrixXs& series,
+    s_t smoothingWeight,
+    s_t regularizationWeight,
+    int windowSize,
+    int overlap,
+    int numThreads)
+{
+  // smooth() scales the regularization out of its answer, so this only needs
+  // the smoothing weight
+  (void)regularizationWeight;
+
+  const int timesteps = series.cols();
+  Eigen::MatrixXs smoothed = Eigen::MatrixXs::Zero(series.rows(), timesteps);
+  if (timesteps == 0)
+  {
+    return smoothed;
+  }
+
+  windowSize = std::max(1, windowSize);
+  if (overlap < 0)
+  {
+    // The influence of a sample dies off over a distance that grows like the
+    // sixth root of smoothingWeight^2. This leaves an error below 1e-12.
+    overlap = (int)std::ceil(
+        50 * std::max(1.0, std::cbrt((double)abs(smoothingWeight))));
+  }
+
+  const int numWindows = (timesteps + windowSize - 1) / windowSize;
+  auto paddedStart = [&](int window) {
+    return std::max(0, window * windowSize - overlap);
+  };
+  auto paddedEnd = [&](int window) {
+    return std::min(timesteps, (window + 1) * windowSize + overlap);
+  };
+
+  // Most windows are the same length, so there are only a handful of distinct
+  // factorizations to compute
+  std::map<int, std::shared_ptr<const BandedFactorization>> factorizations;
+  for (int window = 0; window < numWindows; window++)
+  {
+    int length = paddedEnd(window) - paddedStart(window);
+    if (factorizations.count(length) == 0)
     {
-      // Eigen::VectorXs deltas = mB.completeOrthogonalDecomposition().solve(c);
-      if (mUseSparse)
+      factorizations[length]
+          = BandedFactorization::getCached(length, smoothingWeight);
+    }
+  }
+
+  if (numThreads <= 0)
+  {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numThreads = std::min(numThreads, numWindows);
+
+  // Each thread takes a contiguous range of windows, and only writes the core
+  // (unpadded) columns of its own windows
+  std::vector<common::TaskFuture<void>> futures;
+  for (int threadIdx = 0; threadIdx < numThreads; threadIdx++)
+  {
+    const int firstWindow = (numWindows * threadIdx) / numThreads;
+    const int lastWindow = (numWindows * (threadIdx + 1)) / numThreads;
+    futures.push_back(common::async([&, firstWindow, lastWindow] {
+      for (int window = firstWindow; window < lastWindow; window++)
       {
-        smoothed.row(row)
-            = mB_sparseSolver.solve(c) * (1.0 / mRegularizationWeight);
-        assert(mB_sparseSolver.info() == Eigen::Success);
+        int start = paddedStart(window);
+        int length = paddedEnd(window) - start;
+        Eigen::MatrixXs block = series.middleCols(start, length);
+        factorizations.at(length)->solveRowsInPlace(block);
+
+        int coreStart = window * windowSize;
+        int coreLength
+            = std::min(timesteps, coreStart + windowSize) - coreStart;
+        smoothed.middleCols(coreStart, coreLength)
+            = block.middleCols(coreStart - start, coreLength);
       }
-      else
+    }));
+  }
+  for (auto& future : futures)
+  {
+    future.get();
+  }
+
+  return smoothed;
+}
+
+/**
+ * This factors (I + smoothingWeight^2 * D^T D), where D takes third
+ * differences, without ever forming it as a full matrix.
+ */
+AccelerationSmoother::BandedFactorization::BandedFactorization(
+    int timesteps, s_t smoothingWeight)
+  : mTimesteps(timesteps)
+{
+  Eigen::Vector4s stamp;
+  stamp << -1, 3, -3, 1;
+  stamp *= smoothingWeight;
+
+  // A(k, i) holds the entry of the matrix at (i, i - k)
+  Eigen::Matrix<s_t, 4, Eigen::Dynamic> A
+      = Eigen::Matrix<s_t, 4, Eigen::Dynamic>::Zero(4, timesteps);
+  A.row(0).setOnes();
+  for (int row = 0; row + 3 < timesteps; row++)
+  {
+    for (int a = 0; a < 4; a++)
+    {
+      for (int b = 0; b <= a; b++)
       {
-        smoothed.row(row) = mFactoredB.solve(c) * (1.0 / mRegularizationWeight);
+        A(a - b, row + a) += stamp(a) * stamp(b);
       }
     }
   }
 
-  return smoothed;
-};
+  mD = Eigen::VectorXs::Zero(timesteps);
+  mL = Eigen::Matrix<s_t, 3, Eigen::Dynamic>::Zero(3, timesteps);
+  for (int i = 0; i < timesteps; i++)
+  {
+    // Fill in the row of L from the outside of the band in, since each entry
+    // depends on the ones further from the diagonal
+    for (int k = std::min(3, i); k >= 1; k--)
+    {
+      int j = i - k;
+      s_t sum = A(k, i);
+      for (int m = std::max(0, i - 3); m < j; m++)
+      {
+        sum -= mL(i - m - 1, i) * mL(j - m - 1, j) * mD(m);
+      }
+      mL(k - 1, i) = sum / mD(j);
+    }
+    s_t diagonal = A(0, i);
+    for (int k = 1; k <= std::min(3, i); k++)
+    {
+      diagonal -= mL(k - 1, i) * mL(k - 1, i) * mD(i - k);
+    }
+    mD(i) = diagonal;
+  }
+}
+
+/**
+ * This returns the factorization for these settings, computing it only if it
+ * isn't already in the process-wide cache
+ */
+std::shared_ptr<const AccelerationSmoother::BandedFactorization>
+AccelerationSmoother::BandedFactorization::getCached(
+    int timesteps, s_t smoothingWeight)
+{
+  // We smooth thousands of trials with the same settings, so the cache only
+  // needs to hold the few distinct lengths in flight at once. Past that, the
+  // oldest entries get dropped.
+  static std::mutex cacheMutex;
+  static std::map<
+      std::pair<int, double>,
+      std::shared_ptr<const BandedFactorization>>
+      cache;
+  static std::deque<std::pair<int, double>> insertionOrder;
+  const std::size_t maxCacheSize = 64;
+
+  std::pair<int, double> key(timesteps, (double)smoothingWeight);
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+      return it->second;
+    }
+  }
+
+  // Factor outside the lock, so other threads aren't held up. If two threads
+  // race to factor the same settings, they get identical results.
+  std::shared_ptr<const BandedFactorization> factorization
+      = std::make_shared<const BandedFactorization>(
+          timesteps, smoothingWeight);
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (cache.emplace(key, factorization).second)
+  {
+    insertionOrder.push_back(key);
+    while (insertionOrder.size() > maxCacheSize)
+    {
+      cache.erase(insertionOrder.front());
+      insertionOrder.pop_front();
+    }
+  }
+  return factorization;
+}
+
+/**
+ * This overwrites each row of `rows` with the solution for that row
+ */
+void AccelerationSmoother::BandedFactorization::solveRowsInPlace(
+    Eigen::Ref<Eigen::MatrixXs> rows) const
+{
+  assert(rows.cols() == mTimesteps);
+  // Solve L z = y
+  for (int i = 1; i < mTimesteps; i++)
+  {
+    for (int k = 1; k <= std::min(3, i); k++)
+    {
+      rows.col(i) -= mL(k - 1, i) * rows.col(i - k);
+    }
+  }
+  // Solve D w = z
+  for (int i = 0; i < mTimesteps; i++)
+  {
+    rows.col(i) /= mD(i);
+  }
+  // Solve L^T x = w
+  for (int i = mTimesteps - 2; i >= 0; i--)
+  {
+    for (int k = 1; k <= std::min(3, mTimesteps - 1 - i); k++)
+    {
+      rows.col(i) -= mL(k - 1, i + k) * rows.col(i + k);
+    }
+  }
+}
 
 /**
  * This computes the squared loss for this smoother, given a time series and a
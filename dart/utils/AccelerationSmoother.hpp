@@ -1,6 +1,8 @@
 #ifndef UTILS_PATH_SMOOTHER
 #define UTILS_PATH_SMOOTHER
 
+#include <memory>
+
 #include <Eigen/Sparse>
 #include <Eigen/SparseQR>
 
@@ -15,6 +17,10 @@ public:
   /**
    * Create (and pre-factor) a smoother that can remove the "jerk" from a time
    * seriese of data.
+   *
+   * With `useSparse` and without `useIterativeSolver`, the factorization is
+   * shared with every other smoother of the same length and smoothing weight
+   * in the process, so building many identical smoothers only factors once.
    */
   AccelerationSmoother(
       int timesteps,
@@ -32,8 +38,32 @@ public:
    * This method assumes that the `series` matrix has `mTimesteps` number of
    * columns, and each column represents a complete joint configuration at that
    * timestep.
+   *
+   * The rows are independent, so they get split across up to `numThreads`
+   * threads (<= 0 means one per hardware thread).
    */
-  Eigen::MatrixXs smooth(Eigen::MatrixXs series);
+  Eigen::MatrixXs smooth(Eigen::MatrixXs series, int numThreads = 1);
+
+  /**
+   * This smooths a series of any length in overlapping windows, so the working
+   * memory of the solver is bounded by `windowSize` rather than by the length
+   * of the series. Each window is padded with `overlap` extra timesteps on
+   * each side, which are solved and then thrown away. A sample's influence on
+   * the smoothed result decays exponentially with distance, so given enough
+   * overlap this matches smooth() on the whole series to within numerical
+   * precision. An `overlap` < 0 picks one automatically from the smoothing
+   * weight. The windows are solved in parallel on up to `numThreads` threads
+   * (<= 0 means one per hardware thread).
+   *
+   * Unlike smooth(), `series` can have any number of columns.
+   */
+  static Eigen::MatrixXs smoothWindowed(
+      const Eigen::MatrixXs& series,
+      s_t smoothingWeight,
+      s_t regularizationWeight,
+      int windowSize = 2000,
+      int overlap = -1,
+      int numThreads = -1);
 
   /**
    * This computes the squared loss for this smoother, given a time series and a
@@ -51,6 +81,31 @@ public:
   void debugTimeSeries(Eigen::VectorXs series);
 
 private:
+  /**
+   * smooth() finds the x minimizing |smoothingWeight * D x|^2 + |x - series|^2
+   * (per row), where D takes third differences. The normal equations for that
+   * are (I + smoothingWeight^2 * D^T D) x = series, which is symmetric positive
+   * definite with only 3 diagonals on either side. This is the banded LDL^T
+   * factorization of that matrix, which takes O(timesteps) time and memory.
+   */
+  struct BandedFactorization
+  {
+    BandedFactorization(int timesteps, s_t smoothingWeight);
+
+    /// This overwrites each row of `rows` with the solution for that row
+    void solveRowsInPlace(Eigen::Ref<Eigen::MatrixXs> rows) const;
+
+    /// This returns the factorization for these settings, computing it only
+    /// if it isn't already in the process-wide cache
+    static std::shared_ptr<const BandedFactorization> getCached(
+        int timesteps, s_t smoothingWeight);
+
+    int mTimesteps;
+    Eigen::VectorXs mD;
+    // mL(k - 1, i) holds the entry of L at (i, i - k)
+    Eigen::Matrix<s_t, 3, Eigen::Dynamic> mL;
+  };
+
   int mTimesteps;
   int mSmoothedTimesteps;
   s_t mSmoothingWeight;
@@ -61,8 +116,7 @@ private:
   Eigen::HouseholderQR<Eigen::MatrixXs> mFactoredB;
 
   Eigen::SparseMatrix<s_t> mB_sparse;
-  Eigen::SparseQR<Eigen::SparseMatrix<s_t>, Eigen::NaturalOrdering<int>>
-      mB_sparseSolver;
+  std::shared_ptr<const BandedFactorization> mBandedFactorization;
 };
 
 } // namespace utils
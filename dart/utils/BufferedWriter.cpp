@@ -0,0 +1,272 @@
+#include "dart/utils/BufferedWriter.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#include "dart/common/Console.hpp"
+#include "dart/common/TaskScheduler.hpp"
+
+namespace dart {
+namespace utils {
+
+namespace {
+
+/// This appends the shortest text that reads back as exactly `value`
+template <typename T>
+void appendFloat(std::string& out, T value)
+{
+  // Enough for any float or double in shortest or %.17g form
+  char buffer[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  std::to_chars_result result
+      = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr - buffer);
+#else
+  // Without a floating point to_chars(), we look for the smallest precision
+  // that round trips
+  int length = 0;
+  for (int precision = 6; precision <= 17; precision++)
+  {
+    length = std::snprintf(
+        buffer, sizeof(buffer), "%.*g", precision, (double)value);
+    if (precision == 17 || (T)std::strtod(buffer, nullptr) == value)
+      break;
+  }
+  out.append(buffer, length);
+#endif
+}
+
+/// This appends `value` in base 10
+template <typename T>
+void appendInteger(std::string& out, T value)
+{
+  char buffer[24];
+#if __has_include(<charconv>)
+  std::to_chars_result result
+      = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr - buffer);
+#else
+  out += std::to_string(value);
+#endif
+}
+
+} // namespace
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(std::string_view text)
+{
+  mText.append(text.data(), text.size());
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(const char* text)
+{
+  mText.append(text);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(const std::string& text)
+{
+  mText.append(text);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(char c)
+{
+  mText.push_back(c);
+  return *this;
+}
+
+//==============================================================================
+/// Like iostreams, bools are written as 0 or 1
+TextBuffer& TextBuffer::operator<<(bool value)
+{
+  mText.push_back(value ? '1' : '0');
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(int value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(long value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(long long value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(unsigned int value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(unsigned long value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(unsigned long long value)
+{
+  appendInteger(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(float value)
+{
+  appendFloat(mText, value);
+  return *this;
+}
+
+//==============================================================================
+TextBuffer& TextBuffer::operator<<(double value)
+{
+  appendFloat(mText, value);
+  return *this;
+}
+
+//==============================================================================
+const std::string& TextBuffer::str() const
+{
+  return mText;
+}
+
+//==============================================================================
+std::size_t TextBuffer::size() const
+{
+  return mText.size();
+}
+
+//==============================================================================
+void TextBuffer::clear()
+{
+  mText.clear();
+}
+
+//==============================================================================
+BufferedWriter::BufferedWriter(const std::string& path, std::size_t bufferSize)
+  : mFile(std::fopen(path.c_str(), "wb")), mBufferSize(bufferSize)
+{
+  if (mFile == nullptr)
+  {
+    dterr << "[BufferedWriter] Unable to open [" << path
+          << "] for writing. Nothing will be written.\n";
+  }
+}
+
+//==============================================================================
+BufferedWriter::~BufferedWriter()
+{
+  close();
+}
+
+//==============================================================================
+bool BufferedWriter::isOpen() const
+{
+  return mFile != nullptr;
+}
+
+//==============================================================================
+void BufferedWriter::writeRows(
+    int numRows,
+    const std::function<void(int row, TextBuffer& out)>& formatRow,
+    int numThreads)
+{
+  if (numThreads <= 0)
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  const int numChunks = (numRows + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK;
+  numThreads = std::max(1, std::min(numThreads, numChunks));
+
+  if (numThreads == 1)
+  {
+    for (int row = 0; row < numRows; row++)
+    {
+      formatRow(row, mBuffer);
+      if (mBuffer.size() >= mBufferSize)
+        flush();
+    }
+    return;
+  }
+
+  // Each thread formats one chunk at a time into its own buffer, and we write
+  // the buffers out in order once the whole round of chunks is done, so we
+  // never hold more than `numThreads` chunks at once
+  std::vector<TextBuffer> chunks(numThreads);
+  for (int firstChunk = 0; firstChunk < numChunks; firstChunk += numThreads)
+  {
+    const int roundChunks = std::min(numThreads, numChunks - firstChunk);
+    std::vector<common::TaskFuture<void>> futures;
+    for (int i = 0; i < roundChunks; i++)
+    {
+      const int start = (firstChunk + i) * ROWS_PER_CHUNK;
+      const int end = std::min(numRows, start + ROWS_PER_CHUNK);
+      TextBuffer* chunk = &chunks[i];
+      futures.push_back(common::async([&formatRow, chunk, start, end] {
+        for (int row = start; row < end; row++)
+        {
+          formatRow(row, *chunk);
+        }
+      }));
+    }
+    for (auto& future : futures)
+    {
+      future.get();
+    }
+    for (int i = 0; i < roundChunks; i++)
+    {
+      mBuffer << chunks[i].str();
+      chunks[i].clear();
+      if (mBuffer.size() >= mBufferSize)
+        flush();
+    }
+  }
+}
+
+//==============================================================================
+void BufferedWriter::flush()
+{
+  if (mFile != nullptr && mBuffer.size() > 0)
+  {
+    std::fwrite(mBuffer.str().data(), 1, mBuffer.size(), mFile);
+  }
+  mBuffer.clear();
+}
+
+//==============================================================================
+void BufferedWriter::close()
+{
+  flush();
+  if (mFile != nullptr)
+  {
+    std::fclose(mFile);
+    mFile = nullptr;
+  }
+}
+
+} // namespace utils
+} // namespace dart
@@ -0,0 +1,101 @@
+#ifndef DART_UTILS_BUFFEREDWRITER_HPP_
+#define DART_UTILS_BUFFEREDWRITER_HPP_
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace dart {
+namespace utils {
+
+/// A block of text that numbers can be appended to quickly. Floating point
+/// values are written in the shortest form that reads back to the same value,
+/// rather than iostream's default of 6 significant digits.
+class TextBuffer
+{
+public:
+  TextBuffer& operator<<(std::string_view text);
+  TextBuffer& operator<<(const char* text);
+  TextBuffer& operator<<(const std::string& text);
+  TextBuffer& operator<<(char c);
+  TextBuffer& operator<<(bool value);
+  TextBuffer& operator<<(int value);
+  TextBuffer& operator<<(long value);
+  TextBuffer& operator<<(long long value);
+  TextBuffer& operator<<(unsigned int value);
+  TextBuffer& operator<<(unsigned long value);
+  TextBuffer& operator<<(unsigned long long value);
+  TextBuffer& operator<<(float value);
+  TextBuffer& operator<<(double value);
+
+  /// The text appended so far
+  const std::string& str() const;
+
+  std::size_t size() const;
+
+  void clear();
+
+protected:
+  std::string mText;
+};
+
+/// This writes a text file through a large in-memory buffer, only going out
+/// to the file once `bufferSize` bytes have built up. It's used with `<<`
+/// like a std::ofstream, but formats numbers with TextBuffer.
+class BufferedWriter
+{
+public:
+  /// The rows of a table are formatted in chunks of this many, which is also
+  /// how many rows each thread takes at a time in writeRows()
+  static constexpr int ROWS_PER_CHUNK = 1024;
+
+  explicit BufferedWriter(
+      const std::string& path, std::size_t bufferSize = 1 << 22);
+
+  /// This flushes anything left in the buffer, and closes the file
+  ~BufferedWriter();
+
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  /// Returns false if the file couldn't be opened, in which case everything
+  /// written is dropped
+  bool isOpen() const;
+
+  template <typename T>
+  BufferedWriter& operator<<(const T& value)
+  {
+    mBuffer << value;
+    if (mBuffer.size() >= mBufferSize)
+      flush();
+    return *this;
+  }
+
+  /// This writes `numRows` rows of a table, calling `formatRow(row, out)` to
+  /// append each row (including its newline) onto `out`. Rows are formatted
+  /// in chunks of ROWS_PER_CHUNK, spread over `numThreads` threads (or one per
+  /// core, if that's 0 or less), and always written out in order.
+  /// `formatRow` must be safe to call from several threads at once.
+  void writeRows(
+      int numRows,
+      const std::function<void(int row, TextBuffer& out)>& formatRow,
+      int numThreads = 1);
+
+  /// This writes out everything in the buffer
+  void flush();
+
+  /// This flushes the buffer and closes the file. Nothing more can be written
+  /// after this.
+  void close();
+
+protected:
+  std::FILE* mFile;
+  TextBuffer mBuffer;
+  std::size_t mBufferSize;
+};
+
+} // namespace utils
+} // namespace dart
+
+#endif // #ifndef DART_UTILS_BUFFEREDWRITER_HPP_
@@ -34,6 +34,7 @@
 
 #include <cstring>
 #include <cstdio>
+#include <vector>
 
 ///////////////////////////////////////////////////////////////////////
 //  C3D file reader and writer
@@ -134,16 +135,22 @@ bool loadC3DFile(const char* _fileName, std::vector<std::vector<Eigen::Vector3s>
     else
         iRecSize = sizeof(c3d_frameSI) + ( hdr.a_channels * hdr.a_frames * sizeof(short));
 
+    // read the whole point block in one go, rather than a record at a time
+    std::vector<char> data((std::size_t)numFrames * numMarkers * iRecSize);
+    if (data.size() > 0 && fread(data.data(), data.size(), 1, file) != 1)
+    {
+        fclose(file);
+        return false;
+    }
+    fclose(file);
+
     for (int i = 0; i < numFrames; i++) {
         _pointData[i].resize(numMarkers);
         for (int j = 0; j < numMarkers; j++) {
-            if (!fread(buf, iRecSize, 1, file))
-            {
-                fclose(file);
-                return false;
-            }
+            const char* rec
+                = data.data() + ((std::size_t)i * numMarkers + j) * iRecSize;
             if (c3dScale < 0) {
-                memcpy(&frame, buf, sizeof(frame));
+                memcpy(&frame, rec, sizeof(frame));
                 if(bDecFmt){
                     frame.y = convertDecToFloat((char*)&frame.y);
                     frame.z = convertDecToFloat((char*)&frame.z);
@@ -153,7 +160,7 @@ bool loadC3DFile(const char* _fileName, std::vector<std::vector<Eigen::Vector3s>
                 v[1] = frame.z / 1000.0;
                 v[2] = frame.x / 1000.0;
             } else {
-                memcpy(&frameSI, buf, sizeof(frameSI));
+                memcpy(&frameSI, rec, sizeof(frameSI));
                 if (bDecFmt) {
                     frameSI.y = (short)convertDecToFloat((char*)&frameSI.y);
                     frameSI.z = (short)convertDecToFloat((char*)&frameSI.z);
@@ -166,7 +173,6 @@ bool loadC3DFile(const char* _fileName, std::vector<std::vector<Eigen::Vector3s>
             _pointData[i][j] = v;
         }
     }
-    fclose(file);
 
     //const char *pch = strrchr(_fileName, '\\');  //clip leading path
     //if (pch)
@@ -1,5 +1,24 @@
 #include "dart/utils/CSVParser.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DART_CSVPARSER_HAS_MMAP
+#endif
+
+#include "dart/common/Console.hpp"
 #include "dart/common/Uri.hpp"
 #include "dart/math/MathTypes.hpp"
 #include "dart/math/SimmSpline.hpp"
@@ -91,6 +110,273 @@ std::vector<std::map<std::string, std::string>> parseFile(
   return values;
 };
 
+//==============================================================================
+MappedFile::MappedFile(
+    const common::Uri& uri, const common::ResourceRetrieverPtr& nullOrRetriever)
+  : mData(nullptr), mSize(0), mMapped(false)
+{
+  const common::ResourceRetrieverPtr retriever
+      = ensureRetriever(nullOrRetriever);
+
+#ifdef DART_CSVPARSER_HAS_MMAP
+  const std::string path = retriever->getFilePath(uri);
+  if (!path.empty())
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd != -1)
+    {
+      struct stat info;
+      // Empty files can't be mapped, so those go through readAll() below
+      if (fstat(fd, &info) == 0 && info.st_size > 0)
+      {
+        void* mapped = mmap(
+            nullptr, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+          madvise(mapped, (std::size_t)info.st_size, MADV_SEQUENTIAL);
+          mData = static_cast<const char*>(mapped);
+          mSize = (std::size_t)info.st_size;
+          mMapped = true;
+        }
+      }
+      close(fd);
+      if (mMapped)
+        return;
+    }
+  }
+#endif
+
+  mCopy = retriever->readAll(uri);
+  mData = mCopy.data();
+  mSize = mCopy.size();
+}
+
+//==============================================================================
+MappedFile::~MappedFile()
+{
+#ifdef DART_CSVPARSER_HAS_MMAP
+  if (mMapped)
+    munmap(const_cast<char*>(mData), mSize);
+#endif
+}
+
+//==============================================================================
+std::string_view MappedFile::getContents() const
+{
+  return std::string_view(mData, mSize);
+}
+
+//==============================================================================
+bool MappedFile::isMemoryMapped() const
+{
+  return mMapped;
+}
+
+//==============================================================================
+/// This parses the number at the start of `token`, like atof() does
+double parseNumber(std::string_view token)
+{
+  const char* begin = token.data();
+  const char* end = begin + token.size();
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  // atof() allows a leading '+', but from_chars() doesn't
+  if (end - begin > 1 && *begin == '+' && begin[1] != '-' && begin[1] != '+')
+    begin++;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  double value = 0.0;
+  std::from_chars_result result = std::from_chars(begin, end, value);
+  if (result.ec != std::errc::result_out_of_range)
+    return value;
+#endif
+
+  // Either there's no from_chars() for doubles on this platform, or the value
+  // is out of range and we want atof()'s answer for it. Numbers are short, so
+  // a fixed buffer is plenty.
+  char buffer[128];
+  const std::size_t length
+      = std::min<std::size_t>(end - begin, sizeof(buffer) - 1);
+  std::memcpy(buffer, begin, length);
+  buffer[length] = '\0';
+  return std::strtod(buffer, nullptr);
+}
+
+//==============================================================================
+namespace {
+
+/// This calls `onToken(index, token)` for every token in `line`, stopping
+/// early if `onToken` returns false
+template <typename OnToken>
+void forEachToken(
+    std::string_view line,
+    const std::string& delimiters,
+    bool mergeDelimiters,
+    OnToken onToken)
+{
+  int index = 0;
+  std::size_t start = 0;
+  if (mergeDelimiters)
+  {
+    start = line.find_first_not_of(delimiters);
+    while (start != std::string_view::npos)
+    {
+      std::size_t end = line.find_first_of(delimiters, start);
+      if (!onToken(index, line.substr(start, end - start)))
+        return;
+      if (end == std::string_view::npos)
+        return;
+      start = line.find_first_not_of(delimiters, end);
+      index++;
+    }
+  }
+  else
+  {
+    while (true)
+    {
+      std::size_t end = line.find_first_of(delimiters, start);
+      if (!onToken(index, line.substr(start, end - start)))
+        return;
+      if (end == std::string_view::npos)
+        return;
+      start = end + 1;
+      index++;
+    }
+  }
+}
+
+} // namespace
+
+//==============================================================================
+std::vector<std::string> streamNumericTable(
+    const common::Uri& uri,
+    const NumericTableOptions& options,
+    const RowCallback& callback,
+    const common::ResourceRetrieverPtr& retriever)
+{
+  const MappedFile file(uri, retriever);
+  const std::string_view content = file.getContents();
+
+  std::size_t cursor = 0;
+  auto nextLine = [&](std::string_view& line) {
+    if (cursor >= content.size())
+      return false;
+    std::size_t end = content.find('\n', cursor);
+    if (end == std::string_view::npos)
+      end = content.size();
+    line = content.substr(cursor, end - cursor);
+    cursor = end + 1;
+    // Trim '\r', in case this file was saved on a Windows machine
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    return true;
+  };
+
+  std::string_view line;
+  if (!options.endOfHeader.empty())
+  {
+    while (nextLine(line))
+    {
+      if (line.substr(0, options.endOfHeader.size()) == options.endOfHeader)
+        break;
+    }
+  }
+  for (int i = 0; i < options.skipLines; i++)
+    nextLine(line);
+  if (!nextLine(line))
+    return std::vector<std::string>();
+
+  std::vector<std::string> fileColumns;
+  forEachToken(
+      line,
+      options.delimiters,
+      options.mergeDelimiters,
+      [&](int, std::string_view token) {
+        fileColumns.emplace_back(token);
+        return true;
+      });
+
+  // Work out where each column of the file goes in the output, if anywhere
+  std::vector<std::string> names;
+  std::vector<int> columnToOutput(fileColumns.size(), -1);
+  if (options.columns.empty())
+  {
+    names = fileColumns;
+    for (int i = 0; i < fileColumns.size(); i++)
+      columnToOutput[i] = i;
+  }
+  else
+  {
+    names = options.columns;
+    for (int j = 0; j < names.size(); j++)
+    {
+      auto it = std::find(fileColumns.begin(), fileColumns.end(), names[j]);
+      if (it == fileColumns.end())
+      {
+        dtwarn << "[CSVParser::streamNumericTable] Column \"" << names[j]
+               << "\" isn't in " << uri.toString() << ", so it'll be NaN.\n";
+        continue;
+      }
+      columnToOutput[it - fileColumns.begin()] = j;
+    }
+  }
+  // We can stop splitting a line once we're past the last column we want
+  int lastColumn = -1;
+  for (int i = 0; i < columnToOutput.size(); i++)
+  {
+    if (columnToOutput[i] != -1)
+      lastColumn = i;
+  }
+
+  Eigen::VectorXs values(names.size());
+  int row = 0;
+  while (nextLine(line))
+  {
+    if (line.find_first_not_of(" \t") == std::string_view::npos)
+      continue;
+    values.setConstant(std::numeric_limits<s_t>::quiet_NaN());
+    forEachToken(
+        line,
+        options.delimiters,
+        options.mergeDelimiters,
+        [&](int index, std::string_view token) {
+          if (index > lastColumn)
+            return false;
+          if (columnToOutput[index] != -1)
+            values(columnToOutput[index]) = parseNumber(token);
+          return true;
+        });
+    if (!callback(row, values))
+      break;
+    row++;
+  }
+
+  return names;
+}
+
+//==============================================================================
+NumericTable readNumericTable(
+    const common::Uri& uri,
+    const NumericTableOptions& options,
+    const common::ResourceRetrieverPtr& retriever)
+{
+  std::vector<Eigen::VectorXs> rows;
+  NumericTable table;
+  table.columnNames = streamNumericTable(
+      uri,
+      options,
+      [&](int, const Eigen::VectorXs& values) {
+        rows.push_back(values);
+        return true;
+      },
+      retriever);
+
+  table.values = Eigen::MatrixXs::Zero(rows.size(), table.columnNames.size());
+  for (int i = 0; i < rows.size(); i++)
+    table.values.row(i) = rows[i].transpose();
+  return table;
+}
+
 } // namespace CSVParser
 
 } // namespace utils
@@ -1,12 +1,15 @@
 #ifndef DART_UTILS_CSVPARSER_HPP_
 #define DART_UTILS_CSVPARSER_HPP_
 
+#include <functional>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "dart/common/LocalResourceRetriever.hpp"
 #include "dart/common/Uri.hpp"
+#include "dart/math/MathTypes.hpp"
 #include "dart/simulation/World.hpp"
 
 namespace dart {
@@ -20,6 +23,91 @@ std::vector<std::map<std::string, std::string>> parseFile(
     const common::Uri& uri,
     const common::ResourceRetrieverPtr& retriever = nullptr);
 
+/// A read-only view of the whole contents of a file. Files that resolve to a
+/// local path are memory-mapped, so pages are only read from disk as the
+/// parser reaches them, and nothing is copied. Anything else (or any platform
+/// without mmap) falls back to ResourceRetriever::readAll().
+class MappedFile
+{
+public:
+  MappedFile(
+      const common::Uri& uri,
+      const common::ResourceRetrieverPtr& retriever = nullptr);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /// This is only valid for as long as the MappedFile is alive
+  std::string_view getContents() const;
+
+  /// Returns true if the contents are mapped, rather than copied into memory
+  bool isMemoryMapped() const;
+
+protected:
+  const char* mData;
+  std::size_t mSize;
+  bool mMapped;
+  std::string mCopy;
+};
+
+/// This parses the number at the start of `token`, like atof() does, but
+/// without needing a null-terminated copy of the token. Returns 0 if `token`
+/// doesn't start with a number.
+double parseNumber(std::string_view token);
+
+struct NumericTableOptions
+{
+  /// Any one of these characters separates two values
+  std::string delimiters = ",";
+
+  /// If true, a run of delimiters counts as a single one, which is what you
+  /// want for whitespace separated files like *.mot and *.trc
+  bool mergeDelimiters = false;
+
+  /// If this is not empty, every line up to and including the first one that
+  /// starts with this is skipped, like the "endheader" line in *.mot files
+  std::string endOfHeader = "";
+
+  /// The number of lines to skip (after the header) before the line with the
+  /// column names
+  int skipLines = 0;
+
+  /// The names of the columns to read, in the order they should be returned.
+  /// Leave this empty to read every column. Columns that aren't in the file
+  /// are read as NaN.
+  std::vector<std::string> columns;
+};
+
+/// This gets called once for each row of a numeric table, with the values of
+/// the requested columns. Return false to stop reading early.
+typedef std::function<bool(int row, const Eigen::VectorXs& values)>
+    RowCallback;
+
+/// This streams a table of numbers with a single line of column names, like a
+/// CSV or *.mot file, one row at a time, without ever holding more than one
+/// row in memory. It returns the names of the columns in the order they're
+/// passed to `callback`. Values that are missing from a row are NaN.
+std::vector<std::string> streamNumericTable(
+    const common::Uri& uri,
+    const NumericTableOptions& options,
+    const RowCallback& callback,
+    const common::ResourceRetrieverPtr& retriever = nullptr);
+
+struct NumericTable
+{
+  std::vector<std::string> columnNames;
+  /// One row per line of the file, and one column per entry in columnNames
+  Eigen::MatrixXs values;
+};
+
+/// This reads a whole table of numbers with streamNumericTable()
+NumericTable readNumericTable(
+    const common::Uri& uri,
+    const NumericTableOptions& options = NumericTableOptions(),
+    const common::ResourceRetrieverPtr& retriever = nullptr);
+
 } // namespace CSVParser
 
 } // namespace utils
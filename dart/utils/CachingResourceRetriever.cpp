@@ -0,0 +1,348 @@
+#include "dart/utils/CachingResourceRetriever.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+#include "dart/common/Console.hpp"
+
+namespace dart {
+namespace utils {
+
+namespace {
+
+//==============================================================================
+/// A Resource that reads from contents we already have in memory. Several of
+/// these can share the same contents.
+class MemoryResource : public virtual common::Resource
+{
+public:
+  explicit MemoryResource(std::shared_ptr<const std::string> contents)
+    : mContents(std::move(contents)), mPosition(0)
+  {
+  }
+
+  std::size_t getSize() override
+  {
+    return mContents->size();
+  }
+
+  std::size_t tell() override
+  {
+    return mPosition;
+  }
+
+  bool seek(ptrdiff_t offset, SeekType origin) override
+  {
+    ptrdiff_t base = 0;
+    if (origin == SEEKTYPE_CUR)
+      base = mPosition;
+    else if (origin == SEEKTYPE_END)
+      base = mContents->size();
+
+    const ptrdiff_t position = base + offset;
+    if (position < 0 || position > static_cast<ptrdiff_t>(mContents->size()))
+      return false;
+
+    mPosition = position;
+    return true;
+  }
+
+  std::size_t read(void* buffer, std::size_t size, std::size_t count) override
+  {
+    if (size == 0)
+      return 0;
+
+    // Like fread, we only read whole elements
+    const std::size_t available = mContents->size() - mPosition;
+    count = std::min(count, available / size);
+    std::memcpy(buffer, mContents->data() + mPosition, size * count);
+    mPosition += size * count;
+    return count;
+  }
+
+  std::string readAll() override
+  {
+    return *mContents;
+  }
+
+private:
+  std::shared_ptr<const std::string> mContents;
+
+  std::size_t mPosition;
+};
+
+} // anonymous namespace
+
+//==============================================================================
+CachingResourceRetriever::CachingResourceRetriever(
+    const common::ResourceRetrieverPtr& retriever,
+    std::size_t memoryBudget,
+    const std::string& diskCacheDirectory)
+  : mRetriever(retriever),
+    mMemoryBudget(memoryBudget),
+    mDiskCacheDirectory(diskCacheDirectory),
+    mMemoryUsage(0),
+    mNumHits(0),
+    mNumMisses(0)
+{
+  if (!mDiskCacheDirectory.empty())
+  {
+    boost::system::error_code error;
+    boost::filesystem::create_directories(mDiskCacheDirectory, error);
+    if (error)
+    {
+      dtwarn << "[CachingResourceRetriever] Failed to create the disk cache "
+             << "directory [" << mDiskCacheDirectory << "]: "
+             << error.message() << ". Only caching in memory.\n";
+      mDiskCacheDirectory.clear();
+    }
+  }
+}
+
+//==============================================================================
+bool CachingResourceRetriever::exists(const common::Uri& uri)
+{
+  const std::string key = uri.toString();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mExists.find(key);
+    if (it != mExists.end())
+      return it->second;
+    if (mMemory.find(key) != mMemory.end())
+      return true;
+  }
+
+  const bool result = mRetriever->exists(uri);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mExists[key] = result;
+  return result;
+}
+
+//==============================================================================
+common::ResourcePtr CachingResourceRetriever::retrieve(const common::Uri& uri)
+{
+  Contents contents = getContents(uri);
+  if (!contents)
+    return nullptr;
+
+  return std::make_shared<MemoryResource>(std::move(contents));
+}
+
+//==============================================================================
+std::string CachingResourceRetriever::readAll(const common::Uri& uri)
+{
+  Contents contents = getContents(uri);
+  if (!contents)
+  {
+    throw std::runtime_error(
+        "Failed to retrieve the resource at '" + uri.toString() + "'.");
+  }
+
+  return *contents;
+}
+
+//==============================================================================
+std::string CachingResourceRetriever::getFilePath(const common::Uri& uri)
+{
+  const std::string key = uri.toString();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mFilePaths.find(key);
+    if (it != mFilePaths.end())
+      return it->second;
+  }
+
+  const std::string path = mRetriever->getFilePath(uri);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mFilePaths[key] = path;
+  return path;
+}
+
+//==============================================================================
+void CachingResourceRetriever::clear()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mMemory.clear();
+  mRecentlyUsed.clear();
+  mMemoryUsage = 0;
+  mExists.clear();
+  mFilePaths.clear();
+}
+
+//==============================================================================
+std::size_t CachingResourceRetriever::getMemoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mMemoryUsage;
+}
+
+//==============================================================================
+std::size_t CachingResourceRetriever::getNumHits() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumHits;
+}
+
+//==============================================================================
+std::size_t CachingResourceRetriever::getNumMisses() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mNumMisses;
+}
+
+//==============================================================================
+CachingResourceRetriever::Contents CachingResourceRetriever::getContents(
+    const common::Uri& uri)
+{
+  const std::string key = uri.toString();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto it = mMemory.find(key);
+    if (it != mMemory.end())
+    {
+      mRecentlyUsed.splice(
+          mRecentlyUsed.begin(), mRecentlyUsed, it->second.recentlyUsed);
+      mNumHits++;
+      return it->second.contents;
+    }
+  }
+
+  // We don't hold the lock while reading, so other threads can keep hitting
+  // the cache. If two threads miss on the same URI at once, they'll both
+  // read it, which is wasteful but harmless.
+  bool hit = true;
+  Contents contents = readFromDisk(key);
+  if (!contents)
+  {
+    hit = false;
+    const common::ResourcePtr resource = mRetriever->retrieve(uri);
+    if (!resource)
+      return nullptr;
+
+    contents = std::make_shared<const std::string>(resource->readAll());
+    writeToDisk(key, *contents);
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (hit)
+    mNumHits++;
+  else
+    mNumMisses++;
+  mExists[key] = true;
+  addToMemory(key, contents);
+  return contents;
+}
+
+//==============================================================================
+void CachingResourceRetriever::addToMemory(
+    const std::string& key, const Contents& contents)
+{
+  const auto existing = mMemory.find(key);
+  if (existing != mMemory.end())
+  {
+    mMemoryUsage -= existing->second.contents->size();
+    mRecentlyUsed.erase(existing->second.recentlyUsed);
+    mMemory.erase(existing);
+  }
+
+  // Something that would push everything else out isn't worth keeping
+  if (contents->size() > mMemoryBudget)
+    return;
+
+  while (mMemoryUsage + contents->size() > mMemoryBudget)
+  {
+    const auto oldest = mMemory.find(mRecentlyUsed.back());
+    mMemoryUsage -= oldest->second.contents->size();
+    mMemory.erase(oldest);
+    mRecentlyUsed.pop_back();
+  }
+
+  mRecentlyUsed.push_front(key);
+  mMemory[key] = MemoryEntry{contents, mRecentlyUsed.begin()};
+  mMemoryUsage += contents->size();
+}
+
+//==============================================================================
+std::string CachingResourceRetriever::getDiskCachePath(
+    const std::string& key) const
+{
+  // 64 bit FNV-1a, which (unlike std::hash) is the same from one build to the
+  // next, so other processes can find what we write
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (const char c : key)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  std::stringstream ss;
+  ss << mDiskCacheDirectory << "/" << std::hex << std::setw(16)
+     << std::setfill('0') << hash;
+  return ss.str();
+}
+
+//==============================================================================
+CachingResourceRetriever::Contents CachingResourceRetriever::readFromDisk(
+    const std::string& key) const
+{
+  if (mDiskCacheDirectory.empty())
+    return nullptr;
+
+  std::ifstream file(getDiskCachePath(key), std::ios::binary);
+  if (!file)
+    return nullptr;
+
+  // Every file starts with the URI it holds, so a hash collision can't hand
+  // back the wrong contents
+  std::string storedKey;
+  if (!std::getline(file, storedKey) || storedKey != key)
+    return nullptr;
+
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return std::make_shared<const std::string>(contents.str());
+}
+
+//==============================================================================
+void CachingResourceRetriever::writeToDisk(
+    const std::string& key, const std::string& contents) const
+{
+  // A key with a newline in it can't be written on the first line
+  if (mDiskCacheDirectory.empty() || key.find('\n') != std::string::npos)
+    return;
+
+  // Write to a temporary file and then rename it, so another process reading
+  // the same directory never sees a partial file
+  const std::string path = getDiskCachePath(key);
+  std::random_device random;
+  const std::string tempPath = path + ".tmp" + std::to_string(random());
+  {
+    std::ofstream file(tempPath, std::ios::binary);
+    file << key << '\n';
+    file.write(contents.data(), contents.size());
+    if (!file)
+    {
+      dtwarn << "[CachingResourceRetriever] Failed to write [" << tempPath
+             << "] to the disk cache.\n";
+      file.close();
+      std::remove(tempPath.c_str());
+      return;
+    }
+  }
+
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    std::remove(tempPath.c_str());
+}
+
+} // namespace utils
+} // namespace dart
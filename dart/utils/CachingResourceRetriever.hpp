@@ -0,0 +1,135 @@
+#ifndef DART_UTILS_CACHINGRESOURCERETRIEVER_HPP_
+#define DART_UTILS_CACHINGRESOURCERETRIEVER_HPP_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "dart/common/ResourceRetriever.hpp"
+
+namespace dart {
+namespace utils {
+
+/// CachingResourceRetriever wraps another ResourceRetriever, and remembers
+/// what it returns. That's meant for loading the same models and meshes over
+/// and over (for example, once per worker on a cluster), where re-reading
+/// them from network storage can dominate startup.
+///
+/// There are two tiers. The contents of every resource we retrieve are kept
+/// in memory, least recently used first out, up to a budget in bytes. If you
+/// also give a disk cache directory, contents are written there too, and
+/// read back from there after they've been evicted from memory, or by a
+/// later process that points at the same directory. The answers to exists()
+/// and getFilePath() are memoized per URI as well, which saves the wrapped
+/// retrievers from resolving the same URIs (package:// lookups, for example)
+/// again.
+///
+/// The cache assumes resources don't change underneath it. Call clear() if
+/// they do. The disk tier is never cleared by this class, so delete the
+/// directory to invalidate it. All methods are safe to call from several
+/// threads at once.
+class CachingResourceRetriever : public virtual common::ResourceRetriever
+{
+public:
+  /// Cache what `retriever` returns, keeping up to `memoryBudget` bytes of
+  /// contents in memory. If `diskCacheDirectory` isn't empty, contents are
+  /// also stored on disk in that directory, which gets created if it doesn't
+  /// exist.
+  explicit CachingResourceRetriever(
+      const common::ResourceRetrieverPtr& retriever,
+      std::size_t memoryBudget = 256 * 1024 * 1024,
+      const std::string& diskCacheDirectory = "");
+
+  virtual ~CachingResourceRetriever() = default;
+
+  // Documentation inherited.
+  bool exists(const common::Uri& uri) override;
+
+  /// Returns a resource reading from the cached contents of `uri`, fetching
+  /// them from the wrapped retriever on a miss. Failures aren't cached.
+  common::ResourcePtr retrieve(const common::Uri& uri) override;
+
+  // Documentation inherited.
+  std::string readAll(const common::Uri& uri) override;
+
+  // Documentation inherited.
+  std::string getFilePath(const common::Uri& uri) override;
+
+  /// Forget everything cached in memory, including memoized exists() and
+  /// getFilePath() answers. This leaves the disk tier alone.
+  void clear();
+
+  /// Returns how many bytes of contents are cached in memory
+  std::size_t getMemoryUsage() const;
+
+  /// Returns the number of retrieve() and readAll() calls that found their
+  /// contents in memory or on disk, rather than going to the wrapped retriever
+  std::size_t getNumHits() const;
+
+  /// Returns the number of retrieve() and readAll() calls that had to go to
+  /// the wrapped retriever
+  std::size_t getNumMisses() const;
+
+protected:
+  using Contents = std::shared_ptr<const std::string>;
+
+  struct MemoryEntry
+  {
+    Contents contents;
+
+    /// Where this entry's key is in mRecentlyUsed
+    std::list<std::string>::iterator recentlyUsed;
+  };
+
+  /// Returns the contents of `uri`, from whichever tier has them, or nullptr
+  /// if the wrapped retriever can't retrieve it
+  Contents getContents(const common::Uri& uri);
+
+  /// Put `contents` in the memory tier under `key`, evicting the least
+  /// recently used entries to stay within budget. The caller must hold
+  /// mMutex.
+  void addToMemory(const std::string& key, const Contents& contents);
+
+  /// Returns the file in the disk cache that holds the contents for `key`
+  std::string getDiskCachePath(const std::string& key) const;
+
+  /// Returns the contents stored on disk for `key`, or nullptr if there
+  /// aren't any
+  Contents readFromDisk(const std::string& key) const;
+
+  /// Store `contents` on disk for `key`. Failing to is only a warning.
+  void writeToDisk(const std::string& key, const std::string& contents) const;
+
+  common::ResourceRetrieverPtr mRetriever;
+
+  std::size_t mMemoryBudget;
+
+  std::string mDiskCacheDirectory;
+
+  /// Guards everything below
+  mutable std::mutex mMutex;
+
+  std::unordered_map<std::string, MemoryEntry> mMemory;
+
+  /// The keys of mMemory, most recently used first
+  std::list<std::string> mRecentlyUsed;
+
+  std::size_t mMemoryUsage;
+
+  std::unordered_map<std::string, bool> mExists;
+
+  std::unordered_map<std::string, std::string> mFilePaths;
+
+  std::size_t mNumHits;
+
+  std::size_t mNumMisses;
+};
+
+using CachingResourceRetrieverPtr = std::shared_ptr<CachingResourceRetriever>;
+
+} // namespace utils
+} // namespace dart
+
+#endif // ifndef DART_UTILS_CACHINGRESOURCERETRIEVER_HPP_
@@ -1,12 +1,16 @@
 #include "dart/utils/MJCFExporter.hpp"
 
-#include <fstream>
+#include <cstdio>
+#include <cstring>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <Eigen/Dense>
 #include <Eigen/StdVector>
 #include <tinyxml2.h>
 
+#include "dart/common/Console.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/BoxShape.hpp"
@@ -36,40 +40,139 @@ std::string writeVec3(Eigen::Vector3s vec)
 }
 
 //==============================================================================
+/// This returns the name of the <mesh> asset for `meshShape`, which is the
+/// mesh's path after "Geometry/", without any extensions
+std::string getMeshAssetName(dynamics::MeshShape* meshShape)
+{
+  std::string meshName = meshShape->getMeshPath();
+  int geometryStart = meshName.find("Geometry/");
+  if (geometryStart != std::string::npos)
+  {
+    meshName = meshName.substr(geometryStart + strlen("Geometry/"));
+  }
+  if (meshName.find(".") != std::string::npos)
+  {
+    meshName = meshName.substr(0, meshName.find("."));
+  }
+  return meshName;
+}
+
+//==============================================================================
+/// This writes a <mesh> asset for every MeshShape on the bodies under
+/// `joint`, in the same order recursivelyWriteJointAndBody() writes the
+/// <geom>s that use them. This only needs each mesh's path and scale, so the
+/// meshes never have to be loaded.
+void recursivelyWriteMeshAssets(
+    tinyxml2::XMLPrinter& printer, dynamics::Joint* joint)
+{
+  dynamics::BodyNode* body = joint->getChildBodyNode();
+  for (int i = 0; i < body->getNumShapeNodes(); i++)
+  {
+    dynamics::Shape* shape = body->getShapeNode(i)->getShape().get();
+    if (shape->getType() == "MeshShape")
+    {
+      dynamics::MeshShape* meshShape
+          = dynamic_cast<dynamics::MeshShape*>(shape);
+      std::string meshName = getMeshAssetName(meshShape);
+      printer.OpenElement("mesh");
+      printer.PushAttribute("name", meshName.c_str());
+      printer.PushAttribute("file", (meshName + ".vtp.ply.stl").c_str());
+      printer.PushAttribute("scale", writeVec3(meshShape->getScale()).c_str());
+      printer.CloseElement();
+    }
+  }
+
+  for (int i = 0; i < body->getNumChildJoints(); i++)
+  {
+    recursivelyWriteMeshAssets(printer, body->getChildJoint(i));
+  }
+}
+
+//==============================================================================
+/// This opens a <joint> for a single hinge or slide DOF of `joint`, leaving
+/// it open so the caller can add attributes before closing it
+void openDofJoint(
+    tinyxml2::XMLPrinter& printer,
+    dynamics::Joint* joint,
+    const std::string& name,
+    const char* type,
+    const Eigen::Vector3s& axis,
+    s_t lowerLimit,
+    s_t upperLimit)
+{
+  printer.OpenElement("joint");
+  printer.PushAttribute(
+      "pos",
+      writeVec3(joint->getTransformFromChildBodyNode().translation()).c_str());
+  printer.PushAttribute("name", name.c_str());
+  printer.PushAttribute("type", type);
+  printer.PushAttribute(
+      "axis",
+      writeVec3(joint->getTransformFromChildBodyNode().linear() * axis)
+          .c_str());
+  if (upperLimit > lowerLimit)
+  {
+    printer.PushAttribute("limited", "true");
+    printer.PushAttribute(
+        "range",
+        (std::to_string((double)lowerLimit) + " "
+         + std::to_string((double)upperLimit))
+            .c_str());
+  }
+}
+
+//==============================================================================
+/// This writes the <body> for the child of `joint`, and everything under it.
+/// Motors have to go in a separate <actuator> element after the <worldbody>,
+/// so this just appends the names of the DOFs that need them to `motors`.
 void recursivelyWriteJointAndBody(
-    tinyxml2::XMLDocument& xmlDoc,
-    tinyxml2::XMLElement* assetXml,
-    tinyxml2::XMLElement* actuatorsXml,
-    tinyxml2::XMLElement* elem,
+    tinyxml2::XMLPrinter& printer,
+    std::vector<std::string>& motors,
     dynamics::Joint* joint,
     bool isRoot)
 {
-  using namespace tinyxml2;
-  (void)elem;
-  (void)joint;
-
   dynamics::BodyNode* body = joint->getChildBodyNode();
 
-  XMLElement* bodyXml = xmlDoc.NewElement("body");
-  bodyXml->SetAttribute("name", body->getName().c_str());
-  bodyXml->SetAttribute(
+  printer.OpenElement("body");
+  printer.PushAttribute("name", body->getName().c_str());
+  printer.PushAttribute(
       "pos", writeVec3(joint->getRelativeTransform().translation()).c_str());
   Eigen::Matrix3s R = Eigen::Matrix3s::Identity();
   if (isRoot)
   {
     R = math::eulerXYZToMatrix(Eigen::Vector3s::UnitX() * M_PI / 2);
   }
-  bodyXml->SetAttribute(
+  printer.PushAttribute(
       "euler",
       writeVec3(
           math::matrixToEulerXYZ(R * joint->getRelativeTransform().linear()))
           .c_str());
 
-  XMLElement* inertiaXml = xmlDoc.NewElement("inertial");
-  inertiaXml->SetAttribute("pos", writeVec3(body->getLocalCOM()).c_str());
-  inertiaXml->SetAttribute(
+  // A root EulerJoint's DOFs go before everything else in the body, last DOF
+  // first
+  const bool isRootEuler
+      = isRoot && joint->getType() == dynamics::EulerJoint::getStaticType();
+  if (isRootEuler)
+  {
+    dynamics::EulerJoint* euler = static_cast<dynamics::EulerJoint*>(joint);
+    for (int i = 2; i >= 0; i--)
+    {
+      openDofJoint(
+          printer,
+          joint,
+          joint->getDofName(i),
+          "hinge",
+          euler->getAxis(i),
+          euler->getPositionLowerLimit(i),
+          euler->getPositionUpperLimit(i));
+      printer.CloseElement();
+    }
+  }
+
+  printer.OpenElement("inertial");
+  printer.PushAttribute("pos", writeVec3(body->getLocalCOM()).c_str());
+  printer.PushAttribute(
       "mass", std::to_string((double)body->getMass()).c_str());
-  // dart::dynamics::Inertia inertia = body->getInertia();
   s_t i_xx = 0;
   s_t i_xy = 0;
   s_t i_xz = 0;
@@ -78,222 +181,140 @@ void recursivelyWriteJointAndBody(
   s_t i_zz = 0;
   body->getMomentOfInertia(i_xx, i_yy, i_zz, i_xy, i_xz, i_yz);
   // M(1,1), M(2,2), M(3,3), M(1,2), M(1,3), M(2,3)
-  inertiaXml->SetAttribute(
+  printer.PushAttribute(
       "fullinertia",
       (std::to_string((double)i_xx) + " " + std::to_string((double)i_yy) + " "
        + std::to_string((double)i_zz) + " " + std::to_string((double)i_xy) + " "
        + std::to_string((double)i_xz) + " " + std::to_string((double)i_yz))
           .c_str());
-  bodyXml->InsertEndChild(inertiaXml);
+  printer.CloseElement();
 
   if (isRoot)
   {
-    /*
-    <camera name="side" pos="0 -4 2" xyaxes="1 0 0 0 1 2" mode="trackcom"/>
-    <camera name="back" pos="-4 0 2" xyaxes="0 -1 0 1 0 2" mode="trackcom"/>
-    */
-    XMLElement* sideCamera = xmlDoc.NewElement("camera");
-    sideCamera->SetAttribute("name", "side");
-    sideCamera->SetAttribute("pos", "0 -.1 4.7");
-    sideCamera->SetAttribute("euler", "0 0 0");
-    sideCamera->SetAttribute("mode", "trackcom");
-    bodyXml->InsertEndChild(sideCamera);
-
-    XMLElement* backCamera = xmlDoc.NewElement("camera");
-    backCamera->SetAttribute("name", "back");
-    backCamera->SetAttribute("pos", "-4.7 -.1 0");
-    backCamera->SetAttribute("euler", "0 -1.570796325 0");
-    backCamera->SetAttribute("mode", "trackcom");
-    bodyXml->InsertEndChild(backCamera);
+    printer.OpenElement("camera");
+    printer.PushAttribute("name", "side");
+    printer.PushAttribute("pos", "0 -.1 4.7");
+    printer.PushAttribute("euler", "0 0 0");
+    printer.PushAttribute("mode", "trackcom");
+    printer.CloseElement();
+
+    printer.OpenElement("camera");
+    printer.PushAttribute("name", "back");
+    printer.PushAttribute("pos", "-4.7 -.1 0");
+    printer.PushAttribute("euler", "0 -1.570796325 0");
+    printer.PushAttribute("mode", "trackcom");
+    printer.CloseElement();
   }
 
   if (joint->getType() == dynamics::RevoluteJoint::getStaticType())
   {
     dynamics::RevoluteJoint* revolute
         = static_cast<dynamics::RevoluteJoint*>(joint);
-    (void)revolute;
 
     // If the upper limit == the lower limit, then we're a locked joint, and we
     // can express that in MuJoCo by just not including the joint at all.
     if (revolute->getPositionUpperLimit(0)
         != revolute->getPositionLowerLimit(0))
     {
-      XMLElement* motor = xmlDoc.NewElement("motor");
-      actuatorsXml->InsertEndChild(motor);
-      motor->SetAttribute("gear", "100");
-      motor->SetAttribute("joint", joint->getDofName(0).c_str());
-      motor->SetAttribute("name", joint->getDofName(0).c_str());
-
-      XMLElement* jointXml = xmlDoc.NewElement("joint");
-      bodyXml->InsertEndChild(jointXml);
-      jointXml->SetAttribute(
-          "pos",
-          writeVec3(joint->getTransformFromChildBodyNode().translation())
-              .c_str());
-      jointXml->SetAttribute("name", joint->getDofName(0).c_str());
-      jointXml->SetAttribute("type", "hinge");
-      jointXml->SetAttribute(
-          "axis",
-          writeVec3(
-              joint->getTransformFromChildBodyNode().linear()
-              * revolute->getAxis())
-              .c_str());
-      if (revolute->getPositionUpperLimit(0)
-          > revolute->getPositionLowerLimit(0))
-      {
-        jointXml->SetAttribute("limited", "true");
-        jointXml->SetAttribute(
-            "range",
-            (std::to_string((double)revolute->getPositionLowerLimit(0)) + " "
-             + std::to_string((double)revolute->getPositionUpperLimit(0)))
-                .c_str());
-      }
-      else
+      motors.push_back(joint->getDofName(0));
+
+      s_t lower = revolute->getPositionLowerLimit(0);
+      s_t upper = revolute->getPositionUpperLimit(0);
+      if (upper < lower)
       {
         std::cout << "Joint " << revolute->getName()
-                  << " had backwards joints limits: "
-                  << revolute->getPositionLowerLimit(0) << " "
-                  << revolute->getPositionUpperLimit(0) << std::endl;
-        jointXml->SetAttribute("limited", "true");
-        jointXml->SetAttribute(
-            "range",
-            (std::to_string((double)revolute->getPositionUpperLimit(0)) + " "
-             + std::to_string((double)revolute->getPositionLowerLimit(0)))
-                .c_str());
+                  << " had backwards joints limits: " << lower << " " << upper
+                  << std::endl;
+        std::swap(lower, upper);
       }
+      openDofJoint(
+          printer,
+          joint,
+          joint->getDofName(0),
+          "hinge",
+          revolute->getAxis(),
+          lower,
+          upper);
+      printer.CloseElement();
     }
   }
   else if (joint->getType() == dynamics::UniversalJoint::getStaticType())
   {
     dynamics::UniversalJoint* universal
         = static_cast<dynamics::UniversalJoint*>(joint);
-    (void)universal;
 
     for (int i = 0; i < 2; i++)
     {
       if (universal->getPositionUpperLimit(i)
           != universal->getPositionLowerLimit(i))
       {
-        XMLElement* motor = xmlDoc.NewElement("motor");
-        actuatorsXml->InsertEndChild(motor);
-        motor->SetAttribute("gear", "100");
-        motor->SetAttribute("joint", joint->getDofName(i).c_str());
-        motor->SetAttribute("name", joint->getDofName(i).c_str());
-
-        XMLElement* jointXml = xmlDoc.NewElement("joint");
-        bodyXml->InsertEndChild(jointXml);
-        jointXml->SetAttribute(
-            "pos",
-            writeVec3(joint->getTransformFromChildBodyNode().translation())
-                .c_str());
-        jointXml->SetAttribute("name", joint->getDofName(0).c_str());
-        jointXml->SetAttribute("type", "hinge");
-        jointXml->SetAttribute(
-            "axis",
-            writeVec3(
-                joint->getTransformFromChildBodyNode().linear()
-                * (i == 0 ? universal->getAxis1() : universal->getAxis2()))
-                .c_str());
-        if (universal->getPositionUpperLimit(i)
-            > universal->getPositionLowerLimit(i))
-        {
-          jointXml->SetAttribute("limited", "true");
-          jointXml->SetAttribute(
-              "range",
-              (std::to_string((double)universal->getPositionLowerLimit(i)) + " "
-               + std::to_string((double)universal->getPositionUpperLimit(i)))
-                  .c_str());
-        }
+        motors.push_back(joint->getDofName(i));
+
+        openDofJoint(
+            printer,
+            joint,
+            joint->getDofName(0),
+            "hinge",
+            i == 0 ? universal->getAxis1() : universal->getAxis2(),
+            universal->getPositionLowerLimit(i),
+            universal->getPositionUpperLimit(i));
+        printer.CloseElement();
       }
     }
   }
   else if (joint->getType() == dynamics::BallJoint::getStaticType())
   {
-    dynamics::BallJoint* ball = static_cast<dynamics::BallJoint*>(joint);
-    (void)ball;
-    XMLElement* jointXml = xmlDoc.NewElement("joint");
-    bodyXml->InsertEndChild(jointXml);
-    jointXml->SetAttribute(
+    printer.OpenElement("joint");
+    printer.PushAttribute(
         "pos",
         writeVec3(joint->getTransformFromChildBodyNode().translation())
             .c_str());
-    jointXml->SetAttribute("name", joint->getName().c_str());
-    jointXml->SetAttribute("type", "ball");
+    printer.PushAttribute("name", joint->getName().c_str());
+    printer.PushAttribute("type", "ball");
+    printer.CloseElement();
   }
   else if (joint->getType() == dynamics::EulerJoint::getStaticType())
   {
     dynamics::EulerJoint* euler = static_cast<dynamics::EulerJoint*>(joint);
-    (void)euler;
 
     for (int i = 0; i < 3; i++)
     {
-      XMLElement* motor = xmlDoc.NewElement("motor");
-      actuatorsXml->InsertEndChild(motor);
-      motor->SetAttribute("gear", "100");
-      motor->SetAttribute("joint", joint->getDofName(i).c_str());
-      motor->SetAttribute("name", joint->getDofName(i).c_str());
-
-      XMLElement* jointX = xmlDoc.NewElement("joint");
-      if (isRoot)
-      {
-        bodyXml->InsertFirstChild(jointX);
-      }
-      else
-      {
-        bodyXml->InsertEndChild(jointX);
-      }
-      jointX->SetAttribute(
-          "pos",
-          writeVec3(joint->getTransformFromChildBodyNode().translation())
-              .c_str());
-      jointX->SetAttribute("name", joint->getDofName(i).c_str());
-      jointX->SetAttribute("type", "hinge");
-      jointX->SetAttribute(
-          "axis",
-          writeVec3(
-              joint->getTransformFromChildBodyNode().linear()
-              * euler->getAxis(i))
-              .c_str());
-      if (euler->getPositionUpperLimit(i) > euler->getPositionLowerLimit(i))
-      {
-        jointX->SetAttribute("limited", "true");
-        jointX->SetAttribute(
-            "range",
-            (std::to_string((double)euler->getPositionLowerLimit(i)) + " "
-             + std::to_string((double)euler->getPositionUpperLimit(i)))
-                .c_str());
-      }
+      motors.push_back(joint->getDofName(i));
+
+      // We already wrote these at the start of the body
+      if (isRootEuler)
+        continue;
+
+      openDofJoint(
+          printer,
+          joint,
+          joint->getDofName(i),
+          "hinge",
+          euler->getAxis(i),
+          euler->getPositionLowerLimit(i),
+          euler->getPositionUpperLimit(i));
+      printer.CloseElement();
     }
   }
   else if (joint->getType() == dynamics::FreeJoint::getStaticType())
   {
-    dynamics::FreeJoint* freeJoint = static_cast<dynamics::FreeJoint*>(joint);
-    (void)freeJoint;
-    XMLElement* jointXml = xmlDoc.NewElement("joint");
-    bodyXml->InsertEndChild(jointXml);
-    jointXml->SetAttribute(
+    printer.OpenElement("joint");
+    printer.PushAttribute(
         "pos",
         writeVec3(joint->getTransformFromChildBodyNode().translation())
             .c_str());
-    jointXml->SetAttribute("name", joint->getName().c_str());
-    jointXml->SetAttribute("type", "free");
-    jointXml->SetAttribute("stiffness", "0");
-    jointXml->SetAttribute("damping", "0");
-    jointXml->SetAttribute("frictionloss", "0");
-    jointXml->SetAttribute("armature", "0");
-    // damping="0" stiffness="0" armature="0"
-    if (isRoot)
-    {
-      jointXml->SetAttribute("damping", "0");
-      jointXml->SetAttribute("stiffness", "0");
-      jointXml->SetAttribute("armature", "0");
-    }
+    printer.PushAttribute("name", joint->getName().c_str());
+    printer.PushAttribute("type", "free");
+    printer.PushAttribute("stiffness", "0");
+    printer.PushAttribute("damping", "0");
+    printer.PushAttribute("frictionloss", "0");
+    printer.PushAttribute("armature", "0");
+    printer.CloseElement();
   }
   else if (joint->getType() == dynamics::EulerFreeJoint::getStaticType())
   {
     dynamics::EulerFreeJoint* eulerFreeJoint
         = static_cast<dynamics::EulerFreeJoint*>(joint);
-    (void)eulerFreeJoint;
     for (int j = 0; j < 6; j++)
     {
       int i = j;
@@ -309,45 +330,25 @@ void recursivelyWriteJointAndBody(
       }
       if (!isRoot)
       {
-        XMLElement* motor = xmlDoc.NewElement("motor");
-        actuatorsXml->InsertEndChild(motor);
-        motor->SetAttribute("gear", "100");
-        motor->SetAttribute("joint", joint->getDofName(i).c_str());
-        motor->SetAttribute("name", joint->getDofName(i).c_str());
+        motors.push_back(joint->getDofName(i));
       }
 
-      XMLElement* jointX = xmlDoc.NewElement("joint");
-      bodyXml->InsertEndChild(jointX);
-      jointX->SetAttribute(
-          "pos",
-          writeVec3(joint->getTransformFromChildBodyNode().translation())
-              .c_str());
-      jointX->SetAttribute("name", joint->getDofName(i).c_str());
-      jointX->SetAttribute("type", i < 3 ? "hinge" : "slide");
-      jointX->SetAttribute(
-          "axis",
-          writeVec3(
-              joint->getTransformFromChildBodyNode().linear()
-              * eulerFreeJoint->getAxis(i))
-              .c_str());
-      if (eulerFreeJoint->getPositionUpperLimit(i)
-          > eulerFreeJoint->getPositionLowerLimit(i))
-      {
-        jointX->SetAttribute("limited", "true");
-        jointX->SetAttribute(
-            "range",
-            (std::to_string((double)eulerFreeJoint->getPositionLowerLimit(i))
-             + " "
-             + std::to_string((double)eulerFreeJoint->getPositionUpperLimit(i)))
-                .c_str());
-      }
+      openDofJoint(
+          printer,
+          joint,
+          joint->getDofName(i),
+          i < 3 ? "hinge" : "slide",
+          eulerFreeJoint->getAxis(i),
+          eulerFreeJoint->getPositionLowerLimit(i),
+          eulerFreeJoint->getPositionUpperLimit(i));
       // damping="0" stiffness="0" armature="0"
       if (isRoot)
       {
-        jointX->SetAttribute("damping", "0");
-        jointX->SetAttribute("stiffness", "0");
-        jointX->SetAttribute("armature", "0");
+        printer.PushAttribute("damping", "0");
+        printer.PushAttribute("stiffness", "0");
+        printer.PushAttribute("armature", "0");
       }
+      printer.CloseElement();
     }
   }
   else
@@ -360,12 +361,11 @@ void recursivelyWriteJointAndBody(
     dynamics::ShapeNode* shapeNode = body->getShapeNode(i);
     dynamics::Shape* shape = shapeNode->getShape().get();
 
-    XMLElement* geomXml = xmlDoc.NewElement("geom");
-    bodyXml->InsertEndChild(geomXml);
-    geomXml->SetAttribute("name", shapeNode->getName().c_str());
-    geomXml->SetAttribute(
+    printer.OpenElement("geom");
+    printer.PushAttribute("name", shapeNode->getName().c_str());
+    printer.PushAttribute(
         "pos", writeVec3(shapeNode->getRelativeTranslation()).c_str());
-    geomXml->SetAttribute(
+    printer.PushAttribute(
         "euler",
         writeVec3(math::matrixToEulerXYZ(shapeNode->getRelativeRotation()))
             .c_str());
@@ -375,214 +375,181 @@ void recursivelyWriteJointAndBody(
     {
       dynamics::BoxShape* boxShape = dynamic_cast<dynamics::BoxShape*>(shape);
 
-      geomXml->SetAttribute("type", "box");
-      geomXml->SetAttribute("size", writeVec3(boxShape->getSize()).c_str());
+      printer.PushAttribute("type", "box");
+      printer.PushAttribute("size", writeVec3(boxShape->getSize()).c_str());
     }
     else if (shape->getType() == "MeshShape")
     {
-      dynamics::MeshShape* meshShape
-          = dynamic_cast<dynamics::MeshShape*>(shape);
-      std::string meshAbsolutePath = meshShape->getMeshPath();
-      int geometryStart = meshAbsolutePath.find("Geometry/");
-      if (geometryStart != std::string::npos)
-      {
-        meshAbsolutePath
-            = meshAbsolutePath.substr(geometryStart + strlen("Geometry/"));
-      }
-
-      std::string meshName = meshAbsolutePath;
-      if (meshName.find(".") != std::string::npos)
-      {
-        meshName = meshName.substr(0, meshName.find("."));
-      }
-
-      geomXml->SetAttribute("type", "mesh");
-      geomXml->SetAttribute("mesh", meshName.c_str());
-
-      XMLElement* meshXml = xmlDoc.NewElement("mesh");
-      meshXml->SetAttribute("name", meshName.c_str());
-      meshXml->SetAttribute("file", (meshName + ".vtp.ply.stl").c_str());
-      meshXml->SetAttribute("scale", writeVec3(meshShape->getScale()).c_str());
-      assetXml->InsertEndChild(meshXml);
+      // The matching <mesh> asset was written by recursivelyWriteMeshAssets()
+      printer.PushAttribute("type", "mesh");
+      printer.PushAttribute(
+          "mesh",
+          getMeshAssetName(dynamic_cast<dynamics::MeshShape*>(shape)).c_str());
     }
     else if (shape->getType() == "SphereShape")
     {
       dynamics::SphereShape* sphereShape
           = dynamic_cast<dynamics::SphereShape*>(shape);
 
-      geomXml->SetAttribute("type", "sphere");
-      geomXml->SetAttribute("size", (double)sphereShape->getRadius());
+      printer.PushAttribute("type", "sphere");
+      printer.PushAttribute("size", (double)sphereShape->getRadius());
     }
     else if (shape->getType() == "CapsuleShape")
     {
       dynamics::CapsuleShape* capsuleShape
           = dynamic_cast<dynamics::CapsuleShape*>(shape);
 
-      geomXml->SetAttribute("type", "capsule");
-      geomXml->SetAttribute(
+      printer.PushAttribute("type", "capsule");
+      printer.PushAttribute(
           "size",
           (std::to_string((double)capsuleShape->getRadius()) + " "
            + std::to_string((double)capsuleShape->getHeight()))
               .c_str());
     }
-    else if (
-        shape->getType() == "EllipsoidShape"
-        && dynamic_cast<dynamics::EllipsoidShape*>(shape)->isSphere())
-    {
-      // Ignore
-    }
     else
     {
       // Ignore
     }
+    printer.CloseElement();
   }
 
   for (int i = 0; i < body->getNumChildJoints(); i++)
   {
     recursivelyWriteJointAndBody(
-        xmlDoc, assetXml, actuatorsXml, bodyXml, body->getChildJoint(i), false);
+        printer, motors, body->getChildJoint(i), false);
   }
 
-  elem->InsertEndChild(bodyXml);
+  printer.CloseElement();
+}
+
+//==============================================================================
+/// This opens an element called `name`, sets each of `attributes` on it in
+/// order, and closes it again
+void writeElement(
+    tinyxml2::XMLPrinter& printer,
+    const char* name,
+    const std::vector<std::pair<const char*, const char*>>& attributes)
+{
+  printer.OpenElement(name);
+  for (const auto& attribute : attributes)
+  {
+    printer.PushAttribute(attribute.first, attribute.second);
+  }
+  printer.CloseElement();
 }
 
 //==============================================================================
+/// This writes `skel` to `path` as it goes, rather than building the whole
+/// document in memory first. The only things we hold on to are the names of
+/// the DOFs that need motors.
 void MJCFExporter::writeSkeleton(
     const std::string& path, std::shared_ptr<dynamics::Skeleton> skel)
 {
-  (void)path;
-  (void)skel;
+  std::FILE* file = std::fopen(path.c_str(), "w");
+  if (file == nullptr)
+  {
+    dterr << "[MJCFExporter] Unable to open [" << path
+          << "] for writing. Nothing will be written.\n";
+    return;
+  }
+  std::cout << "Saving MJCF file to " << path << std::endl;
 
   Eigen::VectorXs originalPos = skel->getPositions();
   skel->setPositions(Eigen::VectorXs::Zero(originalPos.size()));
 
-  using namespace tinyxml2;
-
-  tinyxml2::XMLDocument xmlDoc;
-
-  XMLElement* mujoco = xmlDoc.NewElement("mujoco");
-  xmlDoc.InsertFirstChild(mujoco);
+  tinyxml2::XMLPrinter printer(file);
+  printer.OpenElement("mujoco");
 
   // Set some global values
 
-  XMLElement* compiler = xmlDoc.NewElement("compiler");
-  compiler->SetAttribute("angle", "radian");
-  compiler->SetAttribute("coordinate", "local");
-  compiler->SetAttribute("meshdir", "Geometry/");
-  compiler->SetAttribute("inertiafromgeom", "auto");
-  compiler->SetAttribute("balanceinertia", "true");
-  compiler->SetAttribute("boundmass", "0.001");
-  compiler->SetAttribute("boundinertia", "0.001");
-  mujoco->InsertFirstChild(compiler);
-
-  XMLElement* defaultXml = xmlDoc.NewElement("default");
-  mujoco->InsertEndChild(defaultXml);
-
-  XMLElement* defaultGeom = xmlDoc.NewElement("geom");
-  defaultGeom->SetAttribute(
-      "conaffinity", "0"); // Disable all collisions between meshes
-  defaultGeom->SetAttribute("rgba", "0.7 0.5 .3 1");
-  defaultGeom->SetAttribute("margin", "0.001");
-  defaultXml->InsertEndChild(defaultGeom);
-
-  XMLElement* defaultSite = xmlDoc.NewElement("site");
-  defaultSite->SetAttribute("rgba", "0.7 0.5 0.3 1");
-  defaultXml->InsertEndChild(defaultSite);
-
-  XMLElement* defaultJoint = xmlDoc.NewElement("joint");
-  defaultJoint->SetAttribute("limited", "true");
-  defaultJoint->SetAttribute("damping", "0.5");
-  defaultJoint->SetAttribute("armature", "0.1");
-  defaultJoint->SetAttribute("stiffness", "2");
-  defaultXml->InsertEndChild(defaultJoint);
-
-  XMLElement* defaultMotor = xmlDoc.NewElement("motor");
-  defaultMotor->SetAttribute("ctrllimited", "true");
-  defaultMotor->SetAttribute("ctrlrange", "-1 1");
-  defaultXml->InsertEndChild(defaultMotor);
-
-  XMLElement* option = xmlDoc.NewElement("option");
-  option->SetAttribute("timestep", "0.01");
-  mujoco->InsertEndChild(option);
-
-  XMLElement* size = xmlDoc.NewElement("size");
-  size->SetAttribute("njmax", "1000");
-  size->SetAttribute("nconmax", "400");
-  size->SetAttribute("nuser_jnt", "1");
-  mujoco->InsertEndChild(size);
-
-  // <option timestep="0.01"/>
-  // <size njmax="1000" nconmax="400" nuser_jnt="1"/>
-
-  XMLElement* assetXml = xmlDoc.NewElement("asset");
-  mujoco->InsertEndChild(assetXml);
-  // clang-format off
-  /*
-  <asset>
-        <texture builtin="gradient" height="100" rgb1=".4 .5 .6" rgb2="0 0 0" type="skybox" width="100"/>
-        <texture builtin="flat" height="1278" mark="cross" markrgb="1 1 1" name="texgeom" random="0.01" rgb1="0.8 0.6 0.4" rgb2="0.8 0.6 0.4" type="cube" width="127"/>
-        <texture name="grid" type="2d" builtin="checker" rgb1=".1 .2 .3" rgb2=".2 .3 .4" width="300" height="300" mark="edge" markrgb=".2 .3 .4"/>
-        <material name="MatPlane" reflectance="0.2" texrepeat="1 1" texuniform="true" texture="grid"/>
-        <material name="geom" texture="texgeom" texuniform="true"/>
-  */
-  // clang-format on
-  XMLElement* skyboxTexture = xmlDoc.NewElement("texture");
-  skyboxTexture->SetAttribute("name", "skybox");
-  skyboxTexture->SetAttribute("builtin", "gradient");
-  skyboxTexture->SetAttribute("height", "100");
-  skyboxTexture->SetAttribute("rgb1", ".4 .5 .6");
-  skyboxTexture->SetAttribute("rgb2", "0 0 0");
-  skyboxTexture->SetAttribute("type", "skybox");
-  skyboxTexture->SetAttribute("width", "100");
-  assetXml->InsertEndChild(skyboxTexture);
-  XMLElement* flatTexture = xmlDoc.NewElement("texture");
-  flatTexture->SetAttribute("name", "flat");
-  flatTexture->SetAttribute("builtin", "flat");
-  flatTexture->SetAttribute("height", "1278");
-  flatTexture->SetAttribute("mark", "cross");
-  flatTexture->SetAttribute("markrgb", "1 1 1");
-  flatTexture->SetAttribute("name", "texgeom");
-  flatTexture->SetAttribute("random", "0.01");
-  flatTexture->SetAttribute("rgb1", "0.8 0.6 0.4");
-  flatTexture->SetAttribute("rgb2", "0.8 0.6 0.4");
-  flatTexture->SetAttribute("type", "cube");
-  flatTexture->SetAttribute("width", "127");
-  assetXml->InsertEndChild(flatTexture);
-  XMLElement* gridTexture = xmlDoc.NewElement("texture");
-  gridTexture->SetAttribute("name", "grid");
-  gridTexture->SetAttribute("type", "2d");
-  gridTexture->SetAttribute("builtin", "checker");
-  gridTexture->SetAttribute("rgb1", ".1 .2 .3");
-  gridTexture->SetAttribute("rgb2", ".1 .2 .3");
-  gridTexture->SetAttribute("width", "300");
-  gridTexture->SetAttribute("height", "300");
-  gridTexture->SetAttribute("mark", "edge");
-  gridTexture->SetAttribute("markrgb", ".2 .3 .4");
-  assetXml->InsertEndChild(gridTexture);
-  XMLElement* gridMaterial = xmlDoc.NewElement("material");
-  gridMaterial->SetAttribute("name", "MatPlane");
-  gridMaterial->SetAttribute("reflectance", "0.2");
-  gridMaterial->SetAttribute("texrepeat", "1 1");
-  gridMaterial->SetAttribute("texuniform", "true");
-  gridMaterial->SetAttribute("texture", "grid");
-  assetXml->InsertEndChild(gridMaterial);
-  XMLElement* geomMaterial = xmlDoc.NewElement("material");
-  geomMaterial->SetAttribute("name", "geom");
-  geomMaterial->SetAttribute("texture", "texgeom");
-  geomMaterial->SetAttribute("texuniform", "true");
-  assetXml->InsertEndChild(geomMaterial);
-
-  XMLElement* worldbody = xmlDoc.NewElement("worldbody");
-  mujoco->InsertEndChild(worldbody);
-
-  /*
-  <geom condim="3" friction="1 .1 .1" material="MatPlane" name="floor" pos="0 0
-  0" rgba="0.8 0.9 0.8 1" size="50 50 0.2" type="plane"/> <light cutoff="100"
-  diffuse="1 1 1" dir="-0 0 -1.3" directional="true" exponent="1" pos="0 0 1.3"
-  specular=".1 .1 .1"/>
-  */
-
-  worldbody->InsertNewComment(
+  writeElement(
+      printer,
+      "compiler",
+      {{"angle", "radian"},
+       {"coordinate", "local"},
+       {"meshdir", "Geometry/"},
+       {"inertiafromgeom", "auto"},
+       {"balanceinertia", "true"},
+       {"boundmass", "0.001"},
+       {"boundinertia", "0.001"}});
+
+  printer.OpenElement("default");
+  // conaffinity="0" disables all collisions between meshes
+  writeElement(
+      printer,
+      "geom",
+      {{"conaffinity", "0"}, {"rgba", "0.7 0.5 .3 1"}, {"margin", "0.001"}});
+  writeElement(printer, "site", {{"rgba", "0.7 0.5 0.3 1"}});
+  writeElement(
+      printer,
+      "joint",
+      {{"limited", "true"},
+       {"damping", "0.5"},
+       {"armature", "0.1"},
+       {"stiffness", "2"}});
+  writeElement(
+      printer, "motor", {{"ctrllimited", "true"}, {"ctrlrange", "-1 1"}});
+  printer.CloseElement();
+
+  writeElement(printer, "option", {{"timestep", "0.01"}});
+  writeElement(
+      printer,
+      "size",
+      {{"njmax", "1000"}, {"nconmax", "400"}, {"nuser_jnt", "1"}});
+
+  printer.OpenElement("asset");
+  writeElement(
+      printer,
+      "texture",
+      {{"name", "skybox"},
+       {"builtin", "gradient"},
+       {"height", "100"},
+       {"rgb1", ".4 .5 .6"},
+       {"rgb2", "0 0 0"},
+       {"type", "skybox"},
+       {"width", "100"}});
+  writeElement(
+      printer,
+      "texture",
+      {{"name", "texgeom"},
+       {"builtin", "flat"},
+       {"height", "1278"},
+       {"mark", "cross"},
+       {"markrgb", "1 1 1"},
+       {"random", "0.01"},
+       {"rgb1", "0.8 0.6 0.4"},
+       {"rgb2", "0.8 0.6 0.4"},
+       {"type", "cube"},
+       {"width", "127"}});
+  writeElement(
+      printer,
+      "texture",
+      {{"name", "grid"},
+       {"type", "2d"},
+       {"builtin", "checker"},
+       {"rgb1", ".1 .2 .3"},
+       {"rgb2", ".1 .2 .3"},
+       {"width", "300"},
+       {"height", "300"},
+       {"mark", "edge"},
+       {"markrgb", ".2 .3 .4"}});
+  writeElement(
+      printer,
+      "material",
+      {{"name", "MatPlane"},
+       {"reflectance", "0.2"},
+       {"texrepeat", "1 1"},
+       {"texuniform", "true"},
+       {"texture", "grid"}});
+  writeElement(
+      printer,
+      "material",
+      {{"name", "geom"}, {"texture", "texgeom"}, {"texuniform", "true"}});
+  recursivelyWriteMeshAssets(printer, skel->getRootJoint());
+  printer.CloseElement();
+
+  printer.OpenElement("worldbody");
+  printer.PushComment(
       "\n"
       "        <body name=\"treadmill\" pos=\"0 0 0\">\n"
       "            <geom pos=\"0 0 .2\" friction=\"1 .1 .1\"  "
@@ -593,36 +560,44 @@ void MJCFExporter::writeSkeleton(
       "0 0\" range=\"-100 100\" type=\"slide\"/>\n"
       "        </body>\n"
       "        ");
+  writeElement(
+      printer,
+      "geom",
+      {{"condim", "3"},
+       {"friction", "1 .1 .1"},
+       {"material", "MatPlane"},
+       {"name", "floor"},
+       {"pos", "0 0 0"},
+       {"rgba", "0.8 0.9 0.8 1"},
+       {"size", "50 50 0.2"},
+       {"type", "plane"}});
+  writeElement(
+      printer,
+      "light",
+      {{"cutoff", "100"},
+       {"diffuse", "1 1 1"},
+       {"dir", "0 0 -1.3"},
+       {"directional", "true"},
+       {"exponent", "1"},
+       {"pos", "0 0 1.3"},
+       {"specular", ".1 .1 .1"}});
+
+  std::vector<std::string> motors;
+  recursivelyWriteJointAndBody(printer, motors, skel->getRootJoint(), true);
+  printer.CloseElement();
+
+  printer.OpenElement("actuator");
+  for (const std::string& motor : motors)
+  {
+    writeElement(
+        printer,
+        "motor",
+        {{"gear", "100"}, {"joint", motor.c_str()}, {"name", motor.c_str()}});
+  }
+  printer.CloseElement();
 
-  XMLElement* floor = xmlDoc.NewElement("geom");
-  floor->SetAttribute("condim", "3");
-  floor->SetAttribute("friction", "1 .1 .1");
-  floor->SetAttribute("material", "MatPlane");
-  floor->SetAttribute("name", "floor");
-  floor->SetAttribute("pos", "0 0 0");
-  floor->SetAttribute("rgba", "0.8 0.9 0.8 1");
-  floor->SetAttribute("size", "50 50 0.2");
-  floor->SetAttribute("type", "plane");
-  worldbody->InsertEndChild(floor);
-
-  XMLElement* light = xmlDoc.NewElement("light");
-  light->SetAttribute("cutoff", "100");
-  light->SetAttribute("diffuse", "1 1 1");
-  light->SetAttribute("dir", "0 0 -1.3");
-  light->SetAttribute("directional", "true");
-  light->SetAttribute("exponent", "1");
-  light->SetAttribute("pos", "0 0 1.3");
-  light->SetAttribute("specular", ".1 .1 .1");
-  worldbody->InsertEndChild(light);
-
-  XMLElement* actuators = xmlDoc.NewElement("actuator");
-  mujoco->InsertEndChild(actuators);
-
-  recursivelyWriteJointAndBody(
-      xmlDoc, assetXml, actuators, worldbody, skel->getRootJoint(), true);
-
-  std::cout << "Saving MJCF file to " << path << std::endl;
-  xmlDoc.SaveFile(path.c_str());
+  printer.CloseElement();
+  std::fclose(file);
 
   skel->setPositions(originalPos);
 };
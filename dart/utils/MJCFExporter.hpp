@@ -13,6 +13,10 @@ namespace utils {
 class MJCFExporter
 {
 public:
+  /// This writes `skel` to `path` as a MuJoCo MJCF file. The file is written
+  /// out as we walk the skeleton, rather than built up in memory first, and
+  /// meshes are written as references to their files, so they never need to
+  /// be loaded.
   static void writeSkeleton(
       const std::string& path, std::shared_ptr<dynamics::Skeleton> skel);
 };
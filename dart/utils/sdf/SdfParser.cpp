@@ -195,6 +195,9 @@ void readAspects(
     const common::Uri& baseUri,
     const common::ResourceRetrieverPtr& retriever);
 
+std::vector<std::string> collectMeshUris(
+    tinyxml2::XMLElement* skeletonElement, const common::Uri& baseUri);
+
 JointMap readAllJoints(
     tinyxml2::XMLElement* skeletonElement,
     const Eigen::Isometry3s& skeletonFrame,
@@ -1473,6 +1476,10 @@ void readAspects(
     const common::Uri& baseUri,
     const common::ResourceRetrieverPtr& retriever)
 {
+  // Load all the meshes at once, so readShape() finds them already loaded
+  const dynamics::MeshPrefetch prefetch(
+      collectMeshUris(skeletonElement, baseUri), retriever);
+
   ElementEnumerator xmlBodies(skeletonElement, "link");
   while (xmlBodies.next())
   {
@@ -1494,6 +1501,38 @@ void readAspects(
   }
 }
 
+//==============================================================================
+std::vector<std::string> collectMeshUris(
+    tinyxml2::XMLElement* skeletonElement, const common::Uri& baseUri)
+{
+  std::vector<std::string> uris;
+  ElementEnumerator xmlBodies(skeletonElement, "link");
+  while (xmlBodies.next())
+  {
+    for (const char* shapeType : {"visual", "collision"})
+    {
+      ElementEnumerator shapes(xmlBodies.get(), shapeType);
+      while (shapes.next())
+      {
+        // readShape() warns about anything missing here
+        tinyxml2::XMLElement* geometryElement
+            = getElement(shapes.get(), "geometry");
+        if (geometryElement == nullptr
+            || !hasElement(geometryElement, "mesh"))
+          continue;
+
+        tinyxml2::XMLElement* meshEle = getElement(geometryElement, "mesh");
+        if (!hasElement(meshEle, "uri"))
+          continue;
+
+        uris.push_back(common::Uri::getRelativeUri(
+            baseUri, getValueString(meshEle, "uri")));
+      }
+    }
+  }
+  return uris;
+}
+
 //==============================================================================
 JointMap readAllJoints(
     tinyxml2::XMLElement* _skeletonElement,
@@ -202,6 +202,10 @@ dynamics::SkeletonPtr DartLoader::modelInterfaceToSkeleton(
 {
   dynamics::SkeletonPtr skeleton = dynamics::Skeleton::create(model->getName());
 
+  // Load all the meshes at once, so createShape() finds them already loaded
+  const dynamics::MeshPrefetch prefetch(
+      collectMeshUris(model, baseUri), resourceRetriever);
+
   dynamics::BodyNode* rootNode = nullptr;
   const urdf::Link* root = model->getRoot().get();
 
@@ -621,6 +625,31 @@ bool DartLoader::createShapeNodes(
   return true;
 }
 
+//==============================================================================
+std::vector<std::string> DartLoader::collectMeshUris(
+    const urdf::ModelInterface* model, const common::Uri& baseUri)
+{
+  std::vector<std::string> uris;
+  const auto addMesh = [&](const urdf::Geometry* geometry) {
+    const urdf::Mesh* mesh = dynamic_cast<const urdf::Mesh*>(geometry);
+    common::Uri absoluteUri;
+    // createShape() warns about the URIs that don't resolve
+    if (mesh && absoluteUri.fromRelativeUri(baseUri, mesh->filename))
+      uris.push_back(absoluteUri.toString());
+  };
+
+  std::vector<urdf_shared_ptr<urdf::Link>> links;
+  model->getLinks(links);
+  for (const auto& link : links)
+  {
+    for (const auto& visual : link->visual_array)
+      addMesh(visual->geometry.get());
+    for (const auto& collision : link->collision_array)
+      addMesh(collision->geometry.get());
+  }
+  return uris;
+}
+
 /**
  * @function createShape
  */
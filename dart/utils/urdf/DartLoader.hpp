@@ -150,6 +150,12 @@ private:
       const common::Uri& _baseUri,
       const common::ResourceRetrieverPtr& _resourceRetriever);
 
+    /// Returns the resolved URIs of every mesh in the model, so they can be
+    /// loaded in parallel before we create any shapes
+    static std::vector<std::string> collectMeshUris(
+      const urdf::ModelInterface* model,
+      const common::Uri& baseUri);
+
     static dynamics::BodyNode* createDartJointAndNode(
       const urdf::Joint* _jt,
       const dynamics::BodyNode::Properties& _body,
@@ -98,6 +98,12 @@ void Anthropometrics(py::module& m)
           &dart::biomechanics::Anthropometrics::getLogPDF,
           ::py::arg("skel"),
           ::py::arg("normalized") = true)
+      .def(
+          "getLogPDFBatch",
+          &dart::biomechanics::Anthropometrics::getLogPDFBatch,
+          ::py::arg("skel"),
+          ::py::arg("groupScales"),
+          ::py::arg("normalized") = true)
       .def(
           "getGradientOfLogPDFWrtBodyScales",
           &dart::biomechanics::Anthropometrics::
@@ -73,7 +73,8 @@ void BatchGaitInverseDynamics(py::module& m)
               double,
               double,
               double,
-              double>(),
+              double,
+              int>(),
           ::py::arg("skeleton"),
           ::py::arg("poses"),
           ::py::arg("groundContactBodies"),
@@ -84,10 +85,14 @@ void BatchGaitInverseDynamics(py::module& m)
           ::py::arg("minTorqueWeight") = 1.0,
           ::py::arg("prevContactWeight") = 0.1,
           ::py::arg("blendWeight") = 1.0,
-          ::py::arg("blendSteepness") = 10.0)
+          ::py::arg("blendSteepness") = 10.0,
+          ::py::arg("numThreads") = 1)
       .def(
           "numTimesteps",
           &dart::biomechanics::BatchGaitInverseDynamics::numTimesteps)
+      .def(
+          "numContactBodies",
+          &dart::biomechanics::BatchGaitInverseDynamics::numContactBodies)
       .def(
           "getSectionForTimestep",
           &dart::biomechanics::BatchGaitInverseDynamics::getSectionForTimestep,
@@ -102,6 +107,25 @@ void BatchGaitInverseDynamics(py::module& m)
           &dart::biomechanics::BatchGaitInverseDynamics::
               getContactWrenchesAtTimestep,
           ::py::arg("timestep"))
+      .def(
+          "getContactWrenchesAtTimestepMatrix",
+          +[](dart::biomechanics::BatchGaitInverseDynamics* self,
+              int timestep) -> Eigen::MatrixXs {
+            Eigen::MatrixXs wrenches
+                = Eigen::MatrixXs::Zero(6, self->numContactBodies());
+            self->getContactWrenchesAtTimestepInto(timestep, wrenches);
+            return wrenches;
+          },
+          ::py::arg("timestep"))
+      .def(
+          "getContactWrenches",
+          +[](dart::biomechanics::BatchGaitInverseDynamics* self)
+              -> Eigen::MatrixXs {
+            Eigen::MatrixXs wrenches = Eigen::MatrixXs::Zero(
+                6 * self->numContactBodies(), self->numTimesteps());
+            self->getContactWrenchesInto(wrenches);
+            return wrenches;
+          })
       .def(
           "debugLilypadToGUI",
           &dart::biomechanics::BatchGaitInverseDynamics::debugLilypadToGUI,
@@ -63,6 +63,13 @@ void C3DLoader(py::module& m)
   ::py::class_<dart::biomechanics::C3DLoader>(m, "C3DLoader")
       .def_static(
           "loadC3D", &dart::biomechanics::C3DLoader::loadC3D, ::py::arg("uri"))
+      .def_static(
+          "loadC3DBatch",
+          &dart::biomechanics::C3DLoader::loadC3DBatch,
+          ::py::arg("uris"),
+          ::py::arg("numThreads") = -1,
+          ::py::arg("fixupFlips") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def_static(
           "fixupMarkerFlips",
           &dart::biomechanics::C3DLoader::fixupMarkerFlips,
@@ -17,6 +17,33 @@ namespace python {
 
 void DynamicsFitter(py::module& m)
 {
+  ::py::class_<dart::biomechanics::ResidualTrajectory>(m, "ResidualTrajectory")
+      .def_readwrite("taus", &dart::biomechanics::ResidualTrajectory::taus)
+      .def_readwrite(
+          "residuals", &dart::biomechanics::ResidualTrajectory::residuals)
+      .def_readwrite(
+          "residualNorms",
+          &dart::biomechanics::ResidualTrajectory::residualNorms)
+      .def_readwrite(
+          "residualJacobiansWrtPos",
+          &dart::biomechanics::ResidualTrajectory::residualJacobiansWrtPos)
+      .def_readwrite(
+          "residualJacobiansWrtVel",
+          &dart::biomechanics::ResidualTrajectory::residualJacobiansWrtVel)
+      .def_readwrite(
+          "residualJacobiansWrtAcc",
+          &dart::biomechanics::ResidualTrajectory::residualJacobiansWrtAcc)
+      .def_readwrite(
+          "residualNormGradientsWrtPos",
+          &dart::biomechanics::ResidualTrajectory::residualNormGradientsWrtPos)
+      .def_readwrite(
+          "residualNormGradientsWrtVel",
+          &dart::biomechanics::ResidualTrajectory::residualNormGradientsWrtVel)
+      .def_readwrite(
+          "residualNormGradientsWrtAcc",
+          &dart::biomechanics::ResidualTrajectory::
+              residualNormGradientsWrtAcc);
+
   ::py::class_<dart::biomechanics::ResidualForceHelper>(
       m, "ResidualForceHelper")
       .def(
@@ -39,6 +66,18 @@ void DynamicsFitter(py::module& m)
           ::py::arg("forcesConcat"),
           ::py::arg("torquesMultiple"),
           ::py::arg("useL1") = false)
+      .def(
+          "calculateResidualTrajectory",
+          &dart::biomechanics::ResidualForceHelper::calculateResidualTrajectory,
+          ::py::arg("qs"),
+          ::py::arg("dqs"),
+          ::py::arg("ddqs"),
+          ::py::arg("forces"),
+          ::py::arg("torquesMultiple"),
+          ::py::arg("useL1") = false,
+          ::py::arg("computeJacobians") = true,
+          ::py::arg("numThreads") = 1,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "calculateResidualJacobianWrt",
           &dart::biomechanics::ResidualForceHelper::
@@ -47,7 +86,8 @@ void DynamicsFitter(py::module& m)
           ::py::arg("dq"),
           ::py::arg("ddq"),
           ::py::arg("forcesConcat"),
-          ::py::arg("wrt"))
+          ::py::arg("wrt"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "calculateResidualNormGradientWrt",
           &dart::biomechanics::ResidualForceHelper::
@@ -472,7 +512,8 @@ protected:
           ::py::arg("forcePlateTrials"),
           ::py::arg("poseTrials"),
           ::py::arg("framesPerSecond"),
-          ::py::arg("markerObservationTrials"))
+          ::py::arg("markerObservationTrials"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def_static(
           "createInitialization",
           +[](std::shared_ptr<dynamics::Skeleton> skel,
@@ -501,7 +542,8 @@ protected:
           ::py::arg("grfNodes"),
           ::py::arg("forcePlateTrials"),
           ::py::arg("framesPerSecond"),
-          ::py::arg("markerObservationTrials"))
+          ::py::arg("markerObservationTrials"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "comPositions",
           &dart::biomechanics::DynamicsFitter::comPositions,
@@ -526,15 +568,18 @@ protected:
       .def(
           "estimateFootGroundContacts",
           &dart::biomechanics::DynamicsFitter::estimateFootGroundContacts,
-          ::py::arg("init"))
+          ::py::arg("init"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "smoothAccelerations",
           &dart::biomechanics::DynamicsFitter::smoothAccelerations,
-          ::py::arg("init"))
+          ::py::arg("init"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "optimizeMarkerOffsets",
           &dart::biomechanics::DynamicsFitter::optimizeMarkerOffsets,
-          ::py::arg("init"))
+          ::py::arg("init"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "applyInitToSkeleton",
           &dart::biomechanics::DynamicsFitter::applyInitToSkeleton,
@@ -558,14 +603,16 @@ protected:
           ::py::arg("maxTrialsToSolveMassOver") = 4,
           ::py::arg("detectExternalForce") = true,
           ::py::arg("driftCorrectionBlurRadius") = 250,
-          ::py::arg("driftCorrectionBlurInterval") = 250)
+          ::py::arg("driftCorrectionBlurInterval") = 250,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "multimassZeroLinearResidualsOnCOMTrajectory",
           &dart::biomechanics::DynamicsFitter::
               multimassZeroLinearResidualsOnCOMTrajectory,
           ::py::arg("init"),
           ::py::arg("maxTrialsToSolveMassOver") = 4,
-          ::py::arg("boundPush") = 0.01)
+          ::py::arg("boundPush") = 0.01,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "zeroLinearResidualsAndOptimizeAngular",
           &dart::biomechanics::DynamicsFitter::
@@ -586,7 +633,8 @@ protected:
           ::py::arg("commitCopDriftCompensation") = false,
           ::py::arg("detectUnmeasuredTorque") = true,
           ::py::arg("avgPositionChangeThreshold") = 0.08,
-          ::py::arg("avgAngularChangeThreshold") = 0.15)
+          ::py::arg("avgAngularChangeThreshold") = 0.15,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "timeSyncTrialGRF",
           &dart::biomechanics::DynamicsFitter::timeSyncTrialGRF,
@@ -600,7 +648,32 @@ protected:
           ::py::arg("regularizeLinearResiduals") = 0.5,
           ::py::arg("regularizeAngularResiduals") = 0.5,
           ::py::arg("regularizeCopDriftCompensation") = 1.0,
-          ::py::arg("maxBuckets") = 20)
+          ::py::arg("maxBuckets") = 20,
+          ::py::arg("fineShiftRadius") = 2,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "timeSyncTrialsGRF",
+          &dart::biomechanics::DynamicsFitter::timeSyncTrialsGRF,
+          ::py::arg("init"),
+          ::py::arg("trials"),
+          ::py::arg("useReactionWheels") = false,
+          ::py::arg("maxShiftGRF") = 4,
+          ::py::arg("iterationsPerShift") = 20,
+          ::py::arg("weightLinear") = 1.0,
+          ::py::arg("weightAngular") = 1.0,
+          ::py::arg("regularizeLinearResiduals") = 0.5,
+          ::py::arg("regularizeAngularResiduals") = 0.5,
+          ::py::arg("regularizeCopDriftCompensation") = 1.0,
+          ::py::arg("maxBuckets") = 20,
+          ::py::arg("fineShiftRadius") = 2,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "estimateGRFShift",
+          &dart::biomechanics::DynamicsFitter::estimateGRFShift,
+          ::py::arg("init"),
+          ::py::arg("trial"),
+          ::py::arg("maxShiftGRF") = 4,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "timeSyncAndInitializePipeline",
           &dart::biomechanics::DynamicsFitter::timeSyncAndInitializePipeline,
@@ -618,7 +691,8 @@ protected:
           ::py::arg("maxBuckets") = 100,
           ::py::arg("detectUnmeasuredTorque") = true,
           ::py::arg("avgPositionChangeThreshold") = 0.08,
-          ::py::arg("avgAngularChangeThreshold") = 0.15)
+          ::py::arg("avgAngularChangeThreshold") = 0.15,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "optimizeSpatialResidualsOnCOMTrajectory",
           &dart::biomechanics::DynamicsFitter::
@@ -631,47 +705,57 @@ protected:
           ::py::arg("weightAngular") = 2.0,
           ::py::arg("weightLastFewTimesteps") = 5.0,
           ::py::arg("offsetRegularization") = 0.001,
-          ::py::arg("regularizeResiduals") = true)
+          ::py::arg("regularizeResiduals") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "recalibrateForcePlates",
           &dart::biomechanics::DynamicsFitter::recalibrateForcePlatesOffset,
           ::py::arg("init"),
           ::py::arg("trial"),
-          ::py::arg("maxMovement") = 0.03)
+          ::py::arg("maxMovement") = 0.03,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "scaleLinkMassesFromGravity",
           &dart::biomechanics::DynamicsFitter::scaleLinkMassesFromGravity,
-          ::py::arg("init"))
+          ::py::arg("init"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "estimateLinkMassesFromAcceleration",
           &dart::biomechanics::DynamicsFitter::
               estimateLinkMassesFromAcceleration,
           ::py::arg("init"),
-          ::py::arg("regularizationWeight") = 50.0)
+          ::py::arg("regularizationWeight") = 50.0,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runIPOPTOptimization",
           &dart::biomechanics::DynamicsFitter::runIPOPTOptimization,
           ::py::arg("init"),
-          ::py::arg("config"))
+          ::py::arg("config"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runConstrainedSGDOptimization",
           &dart::biomechanics::DynamicsFitter::runConstrainedSGDOptimization,
           ::py::arg("init"),
-          ::py::arg("config"))
+          ::py::arg("config"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runUnconstrainedSGDOptimization",
           &dart::biomechanics::DynamicsFitter::runUnconstrainedSGDOptimization,
           ::py::arg("init"),
-          ::py::arg("config"))
+          ::py::arg("config"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "computePerfectGRFs",
           &dart::biomechanics::DynamicsFitter::computePerfectGRFs,
-          ::py::arg("init"))
+          ::py::arg("init"),
+          ::py::arg("numThreads") = -1,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "computeInverseDynamics",
           &dart::biomechanics::DynamicsFitter::computeInverseDynamics,
           ::py::arg("init"),
-          ::py::arg("trial"))
+          ::py::arg("trial"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "checkPhysicalConsistency",
           &dart::biomechanics::DynamicsFitter::checkPhysicalConsistency,
@@ -758,7 +842,8 @@ protected:
           ::py::arg("path"),
           ::py::arg("init"),
           ::py::arg("trialIndex"),
-          ::py::arg("useAdjustedGRFs") = false)
+          ::py::arg("useAdjustedGRFs") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "writeSubjectOnDisk",
           &dart::biomechanics::DynamicsFitter::writeSubjectOnDisk,
@@ -768,7 +853,8 @@ protected:
           ::py::arg("useAdjustedGRFs") = false,
           ::py::arg("trialNames") = std::vector<std::string>(),
           ::py::arg("href") = "",
-          ::py::arg("notes") = "")
+          ::py::arg("notes") = "",
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setTolerance",
           &dart::biomechanics::DynamicsFitter::setTolerance,
@@ -796,6 +882,10 @@ protected:
       .def(
           "setDisableLinesearch",
           &dart::biomechanics::DynamicsFitter::setDisableLinesearch,
+          ::py::arg("value"))
+      .def(
+          "setUseExactHessian",
+          &dart::biomechanics::DynamicsFitter::setUseExactHessian,
           ::py::arg("value"));
 }
 
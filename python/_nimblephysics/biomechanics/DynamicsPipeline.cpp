@@ -0,0 +1,68 @@
+#include "dart/biomechanics/DynamicsPipeline.hpp"
+
+#include <memory>
+
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void DynamicsPipeline(py::module& m)
+{
+  ::py::class_<
+      dart::biomechanics::DynamicsPipeline,
+      std::shared_ptr<dart::biomechanics::DynamicsPipeline>>(
+      m, "DynamicsPipeline")
+      .def(
+          ::py::init<std::shared_ptr<dynamics::Skeleton>, std::string>(),
+          ::py::arg("skel"),
+          ::py::arg("checkpointPath"))
+      .def(
+          "addStage",
+          &dart::biomechanics::DynamicsPipeline::addStage,
+          ::py::arg("name"),
+          ::py::arg("stage"),
+          "This adds a stage to the end of the pipeline. Stage names are what "
+          "the checkpoint records, so they must be unique, and stable between "
+          "runs.")
+      .def(
+          "run",
+          &dart::biomechanics::DynamicsPipeline::run,
+          ::py::arg("init"),
+          "This runs every stage that hasn't already finished, checkpointing "
+          "after each one, and returns the final initialization. If there's a "
+          "checkpoint from an earlier run of the same stages, :code:`init` is "
+          "ignored and the fit resumes from the checkpoint instead.")
+      .def(
+          "getCompletedStages",
+          &dart::biomechanics::DynamicsPipeline::getCompletedStages)
+      .def_static(
+          "saveCheckpoint",
+          &dart::biomechanics::DynamicsPipeline::saveCheckpoint,
+          ::py::arg("path"),
+          ::py::arg("skel"),
+          ::py::arg("init"),
+          ::py::arg("completedStages"))
+      .def_static(
+          "loadCheckpoint",
+          [](const std::string& path,
+             std::shared_ptr<dynamics::Skeleton> skel) {
+            std::vector<std::string> completedStages;
+            std::shared_ptr<dart::biomechanics::DynamicsInitialization> init
+                = dart::biomechanics::DynamicsPipeline::loadCheckpoint(
+                    path, skel, &completedStages);
+            return std::make_pair(init, completedStages);
+          },
+          ::py::arg("path"),
+          ::py::arg("skel"),
+          "This reads a checkpoint file from :code:`saveCheckpoint()`, and "
+          "returns the initialization (or None) and the finished stages");
+}
+
+} // namespace python
+} // namespace dart
@@ -67,11 +67,15 @@ void IKErrorReport(py::module& m)
               std::shared_ptr<dynamics::Skeleton>,
               dynamics::MarkerMap,
               Eigen::MatrixXs,
-              std::vector<std::map<std::string, Eigen::Vector3s>>>(),
+              std::vector<std::map<std::string, Eigen::Vector3s>>,
+              std::shared_ptr<biomechanics::Anthropometrics>,
+              int>(),
           ::py::arg("skeleton"),
           ::py::arg("markers"),
           ::py::arg("poses"),
-          ::py::arg("observations"))
+          ::py::arg("observations"),
+          ::py::arg("anthropometrics") = nullptr,
+          ::py::arg("numThreads") = -1)
       .def(
           "printReport",
           &dart::biomechanics::IKErrorReport::printReport,
@@ -241,6 +241,17 @@ void MarkerFitter(py::module& m)
             (a "warp"), in parallel, using the first timestep of the warp as the
             initialization for the whole warp. Defaults to False.
           )pydoc")
+      .def(
+          "setWarmStartIK",
+          &dart::biomechanics::MarkerFitter::setWarmStartIK,
+          ::py::arg("warmStart"),
+          R"pydoc(If True, fitTrajectory() seeds each timestep's IK by extrapolating the
+            velocity of the last two solutions. Any timestep that still finishes
+            above the satisfactory loss gets re-solved with random restarts.
+            Combined with setParallelIKWarps(), the trajectory is split into
+            contiguous blocks that are each warm-started, in parallel. Defaults
+            to False.
+          )pydoc")
       .def(
           "setMaxMarkerOffset",
           &dart::biomechanics::MarkerFitter::setMaxMarkerOffset,
@@ -257,6 +268,12 @@ void MarkerFitter(py::module& m)
           "setIterationLimit",
           &dart::biomechanics::MarkerFitter::setIterationLimit,
           ::py::arg("iters"))
+      .def(
+          "setAdaptiveBilevelSampling",
+          &dart::biomechanics::MarkerFitter::setAdaptiveBilevelSampling,
+          ::py::arg("adaptive"),
+          ::py::arg("initialSamples") = 20,
+          ::py::arg("tolerance") = 1e-3)
       .def(
           "setAnthropometricPrior",
           &dart::biomechanics::MarkerFitter::setAnthropometricPrior,
@@ -280,20 +297,39 @@ void MarkerFitter(py::module& m)
           &dart::biomechanics::MarkerFitter::getInitialization,
           ::py::arg("markerObservations"),
           ::py::arg("newClip"),
-          ::py::arg("params") = dart::biomechanics::InitialMarkerFitParams())
+          ::py::arg("params") = dart::biomechanics::InitialMarkerFitParams(),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "findJointCenters",
           &dart::biomechanics::MarkerFitter::findJointCenters,
           ::py::arg("initializations"),
           ::py::arg("newClip"),
-          ::py::arg("markerObservations"))
+          ::py::arg("markerObservations"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "optimizeBilevel",
           &dart::biomechanics::MarkerFitter::optimizeBilevel,
           ::py::arg("markerObservations"),
           ::py::arg("initialization"),
           ::py::arg("numSamples"),
-          ::py::arg("applyInnerProblemGradientConstraints") = true)
+          ::py::arg("applyInnerProblemGradientConstraints") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "optimizeBilevelOnTimesteps",
+          &dart::biomechanics::MarkerFitter::optimizeBilevelOnTimesteps,
+          ::py::arg("markerObservations"),
+          ::py::arg("initialization"),
+          ::py::arg("sampleIndices"),
+          ::py::arg("applyInnerProblemGradientConstraints") = true,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "optimizeBilevelAdaptively",
+          &dart::biomechanics::MarkerFitter::optimizeBilevelAdaptively,
+          ::py::arg("markerObservations"),
+          ::py::arg("initialization"),
+          ::py::arg("maxSamples"),
+          ::py::arg("applyInnerProblemGradientConstraints") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "checkForEnoughMarkers",
           &dart::biomechanics::MarkerFitter::checkForEnoughMarkers,
@@ -302,19 +338,22 @@ void MarkerFitter(py::module& m)
           "generateDataErrorsReport",
           &dart::biomechanics::MarkerFitter::generateDataErrorsReport,
           ::py::arg("markerObservations"),
-          ::py::arg("dt"))
+          ::py::arg("dt"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "checkForFlippedMarkers",
           &dart::biomechanics::MarkerFitter::checkForFlippedMarkers,
           ::py::arg("markerObservations"),
           ::py::arg("init"),
-          ::py::arg("report"))
+          ::py::arg("report"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runMultiTrialKinematicsPipeline",
           &dart::biomechanics::MarkerFitter::runMultiTrialKinematicsPipeline,
           ::py::arg("markerTrials"),
           ::py::arg("params"),
-          ::py::arg("numSamples") = 50)
+          ::py::arg("numSamples") = 50,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runKinematicsPipeline",
           &dart::biomechanics::MarkerFitter::runKinematicsPipeline,
@@ -322,12 +361,14 @@ void MarkerFitter(py::module& m)
           ::py::arg("newClip"),
           ::py::arg("params"),
           ::py::arg("numSamples") = 20,
-          ::py::arg("skipFinalIK") = false)
+          ::py::arg("skipFinalIK") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "runPrescaledPipeline",
           &dart::biomechanics::MarkerFitter::runPrescaledPipeline,
           ::py::arg("markerObservations"),
-          ::py::arg("params"))
+          ::py::arg("params"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setMinJointVarianceCutoff",
           &dart::biomechanics::MarkerFitter::setMinJointVarianceCutoff,
@@ -401,6 +442,12 @@ void MarkerFitter(py::module& m)
           &dart::biomechanics::MarkerFitter::pickSubset,
           ::py::arg("markerObservations"),
           ::py::arg("subsetSize"))
+      .def_static(
+          "pickInformativeTimesteps",
+          &dart::biomechanics::MarkerFitter::pickInformativeTimesteps,
+          ::py::arg("poses"),
+          ::py::arg("numSamples"),
+          ::py::arg("alreadyPicked") = std::vector<int>())
       .def(
           "setMarkerIsTracking",
           &dart::biomechanics::MarkerFitter::setMarkerIsTracking,
@@ -420,7 +467,8 @@ void MarkerFitter(py::module& m)
       .def(
           "autorotateC3D",
           &dart::biomechanics::MarkerFitter::autorotateC3D,
-          ::py::arg("c3d"))
+          ::py::arg("c3d"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def("getNumMarkers", &dart::biomechanics::MarkerFitter::getNumMarkers);
 }
 
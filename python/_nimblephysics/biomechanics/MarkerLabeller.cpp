@@ -51,7 +51,8 @@ void MarkerLabeller(py::module& m)
       .def(
           "guessJointLocations",
           &dart::biomechanics::MarkerLabeller::guessJointLocations,
-          ::py::arg("pointClouds"))
+          ::py::arg("pointClouds"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setSkeleton",
           &dart::biomechanics::MarkerLabeller::setSkeleton,
@@ -60,7 +61,8 @@ void MarkerLabeller(py::module& m)
           "labelPointClouds",
           &dart::biomechanics::MarkerLabeller::labelPointClouds,
           ::py::arg("pointClouds"),
-          ::py::arg("mergeMarkersThreshold") = 0.01)
+          ::py::arg("mergeMarkersThreshold") = 0.01,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "matchUpJointToSkeletonJoint",
           &dart::biomechanics::MarkerLabeller::matchUpJointToSkeletonJoint,
@@ -70,7 +72,8 @@ void MarkerLabeller(py::module& m)
           "evaluate",
           &dart::biomechanics::MarkerLabeller::evaluate,
           ::py::arg("markerOffsets"),
-          ::py::arg("labeledPointClouds"));
+          ::py::arg("labeledPointClouds"),
+          ::py::call_guard<py::gil_scoped_release>());
 
   ::py::class_<
       dart::biomechanics::MarkerLabellerMock,
@@ -89,6 +92,42 @@ void MarkerLabeller(py::module& m)
               std::function<std::vector<std::map<std::string, Eigen::Vector3s>>(
                   const std::vector<std::vector<Eigen::Vector3s>>&)>>(),
           ::py::arg("jointCenterPredictor"));
+
+  ::py::class_<dart::biomechanics::StreamingMarkerLabeller>(
+      m, "StreamingMarkerLabeller")
+      .def(
+          ::py::init<
+              dart::biomechanics::MarkerLabeller&,
+              int,
+              int,
+              double,
+              int,
+              double>(),
+          ::py::arg("labeller"),
+          ::py::arg("latency") = 30,
+          ::py::arg("lookback") = 120,
+          ::py::arg("mergeDistance") = 0.01,
+          ::py::arg("mergeFrames") = 5,
+          ::py::arg("mergeMarkersThreshold") = 0.01,
+          ::py::keep_alive<1, 2>())
+      .def(
+          "pushFrame",
+          &dart::biomechanics::StreamingMarkerLabeller::pushFrame,
+          ::py::arg("pointCloud"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "flush",
+          &dart::biomechanics::StreamingMarkerLabeller::flush,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "getMarkerOffsets",
+          &dart::biomechanics::StreamingMarkerLabeller::getMarkerOffsets)
+      .def(
+          "getNumTraces",
+          &dart::biomechanics::StreamingMarkerLabeller::getNumTraces)
+      .def(
+          "getNumBufferedFrames",
+          &dart::biomechanics::StreamingMarkerLabeller::getNumBufferedFrames);
 }
 
 } // namespace python
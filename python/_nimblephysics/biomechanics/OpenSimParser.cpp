@@ -109,6 +109,32 @@ void OpenSimParser(py::module& m)
       },
       ::py::arg("path"));
 
+  sm.def(
+      "parseOsimWithoutGeometry",
+      +[](const std::string& path) {
+        return dart::biomechanics::OpenSimParser::parseOsimWithoutGeometry(
+            path);
+      },
+      ::py::arg("path"),
+      "This loads a model like :code:`parseOsim()`, but leaves its meshes "
+      "unloaded until something needs them, like rendering the model to the "
+      "GUI. The fitters never use the meshes, so this is the fast way to "
+      "load a model that's only going to be fit.");
+
+  sm.def(
+      "setParsedModelCacheEnabled",
+      &dart::biomechanics::OpenSimParser::setParsedModelCacheEnabled,
+      ::py::arg("enabled"),
+      "This turns the in-memory cache of parsed models used by "
+      ":code:`parseOsim()` on or off. It's on by default. Turning it off "
+      "also clears it.");
+
+  sm.def(
+      "clearParsedModelCache",
+      &dart::biomechanics::OpenSimParser::clearParsedModelCache,
+      "This drops every model in the in-memory cache of parsed models used "
+      "by :code:`parseOsim()`.");
+
   sm.def(
       "saveOsimScalingXMLFile",
       +[](const std::string& subjectName,
@@ -310,18 +336,45 @@ void OpenSimParser(py::module& m)
       ::py::arg("path"),
       ::py::arg("targetFramesPerSecond") = 100);
 
+  sm.def(
+      "loadTRCBatch",
+      +[](const std::vector<std::string>& paths, int numThreads) {
+        std::vector<common::Uri> uris(paths.begin(), paths.end());
+        return dart::biomechanics::OpenSimParser::loadTRCBatch(
+            uris, numThreads);
+      },
+      ::py::arg("paths"),
+      ::py::arg("numThreads") = -1,
+      ::py::call_guard<py::gil_scoped_release>());
+
+  sm.def(
+      "loadGRFBatch",
+      +[](const std::vector<std::string>& paths,
+          int targetFramesPerSecond,
+          int numThreads) {
+        std::vector<common::Uri> uris(paths.begin(), paths.end());
+        return dart::biomechanics::OpenSimParser::loadGRFBatch(
+            uris, targetFramesPerSecond, numThreads);
+      },
+      ::py::arg("paths"),
+      ::py::arg("targetFramesPerSecond") = 100,
+      ::py::arg("numThreads") = -1,
+      ::py::call_guard<py::gil_scoped_release>());
+
   sm.def(
       "saveTRC",
       +[](const std::string& outputPath,
           const std::vector<double>& timestamps,
           const std::vector<std::map<std::string, Eigen::Vector3s>>&
-              markerTimesteps) {
+              markerTimesteps,
+          int numThreads) {
         return dart::biomechanics::OpenSimParser::saveTRC(
-            outputPath, timestamps, markerTimesteps);
+            outputPath, timestamps, markerTimesteps, numThreads);
       },
       ::py::arg("path"),
       ::py::arg("timestamps"),
-      ::py::arg("markerTimestamps"));
+      ::py::arg("markerTimestamps"),
+      ::py::arg("numThreads") = -1);
 
   sm.def(
       "loadMot",
@@ -348,35 +401,45 @@ void OpenSimParser(py::module& m)
       +[](std::shared_ptr<dynamics::Skeleton> skel,
           const std::string& path,
           const std::vector<double>& timestamps,
-          const Eigen::MatrixXs& poses) {
+          const Eigen::MatrixXs& poses,
+          int numThreads) {
         return dart::biomechanics::OpenSimParser::saveMot(
-            skel, path, timestamps, poses);
+            skel, path, timestamps, poses, numThreads);
       },
       ::py::arg("skel"),
       ::py::arg("path"),
       ::py::arg("timestamps"),
-      ::py::arg("poses"));
+      ::py::arg("poses"),
+      ::py::arg("numThreads") = -1);
 
   sm.def(
       "saveRawGRFMot",
       +[](const std::string& outputPath,
           const std::vector<double>& timestamps,
-          const std::vector<biomechanics::ForcePlate> forcePlates) {
+          const std::vector<biomechanics::ForcePlate> forcePlates,
+          int numThreads) {
         return dart::biomechanics::OpenSimParser::saveRawGRFMot(
-            outputPath, timestamps, forcePlates);
+            outputPath, timestamps, forcePlates, numThreads);
       },
       ::py::arg("outputPath"),
       ::py::arg("timestamps"),
-      ::py::arg("forcePlates"));
+      ::py::arg("forcePlates"),
+      ::py::arg("numThreads") = -1);
   sm.def(
       "saveProcessedGRFMot",
       +[](const std::string& outputPath,
           const std::vector<double>& timestamps,
           const std::vector<dynamics::BodyNode*> bodyNodes,
           s_t groundLevel,
-          const Eigen::MatrixXs wrenches) {
+          const Eigen::MatrixXs wrenches,
+          int numThreads) {
         return dart::biomechanics::OpenSimParser::saveProcessedGRFMot(
-            outputPath, timestamps, bodyNodes, groundLevel, wrenches);
+            outputPath,
+            timestamps,
+            bodyNodes,
+            groundLevel,
+            wrenches,
+            numThreads);
       },
       ::py::arg("outputPath"),
       ::py::arg("timestamps"),
@@ -389,14 +452,16 @@ void OpenSimParser(py::module& m)
       +[](std::shared_ptr<dynamics::Skeleton> skel,
           const std::string& outputPath,
           const std::vector<double>& timestamps,
-          const Eigen::MatrixXs torques) {
+          const Eigen::MatrixXs torques,
+          int numThreads) {
         return dart::biomechanics::OpenSimParser::saveIDMot(
-            skel, outputPath, timestamps, torques);
+            skel, outputPath, timestamps, torques, numThreads);
       },
       ::py::arg("skel"),
       ::py::arg("outputPath"),
       ::py::arg("timestamps"),
-      ::py::arg("forcePlates"));
+      ::py::arg("forcePlates"),
+      ::py::arg("numThreads") = -1);
 
   sm.def(
       "getScaleAndMarkerOffsets",
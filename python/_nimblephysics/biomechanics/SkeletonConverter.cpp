@@ -101,6 +101,20 @@ void SkeletonConverter(py::module& m)
           ::py::arg("leastSquaresDamping") = 0.01,
           ::py::arg("lineSearch") = true,
           ::py::arg("logIKOutput") = false)
+      .def(
+          "convertMotionParallel",
+          &dart::biomechanics::SkeletonConverter::convertMotionParallel,
+          ::py::arg("targetMotion"),
+          ::py::arg("chunkSize") = 50,
+          ::py::arg("numThreads") = -1,
+          ::py::arg("useLinearization") = false,
+          ::py::arg("linearizationTolerance") = 1e-4,
+          ::py::arg("logProgress") = true,
+          ::py::arg("convergenceThreshold") = 1e-7,
+          ::py::arg("maxStepCount") = 100,
+          ::py::arg("leastSquaresDamping") = 0.01,
+          ::py::arg("lineSearch") = true,
+          ::py::arg("logIKOutput") = false)
       .def(
           "getSourceJointWorldPositions",
           &dart::biomechanics::SkeletonConverter::getSourceJointWorldPositions)
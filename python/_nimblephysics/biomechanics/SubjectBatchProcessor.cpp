@@ -0,0 +1,104 @@
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+
+#include <memory>
+
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SubjectBatchProcessor(py::module& m)
+{
+  ::py::class_<dart::biomechanics::SubjectBatchJob>(m, "SubjectBatchJob")
+      .def(::py::init<>())
+      .def_readwrite("name", &dart::biomechanics::SubjectBatchJob::name)
+      .def_readwrite(
+          "osimPath", &dart::biomechanics::SubjectBatchJob::osimPath)
+      .def_readwrite(
+          "markerTrials", &dart::biomechanics::SubjectBatchJob::markerTrials)
+      .def_readwrite(
+          "markerFitParams",
+          &dart::biomechanics::SubjectBatchJob::markerFitParams)
+      .def_readwrite(
+          "numBilevelSamples",
+          &dart::biomechanics::SubjectBatchJob::numBilevelSamples)
+      .def_readwrite(
+          "memoryBytes", &dart::biomechanics::SubjectBatchJob::memoryBytes)
+      .def_readwrite(
+          "configureFitter",
+          &dart::biomechanics::SubjectBatchJob::configureFitter)
+      .def_readwrite(
+          "onKinematicsFinished",
+          &dart::biomechanics::SubjectBatchJob::onKinematicsFinished);
+
+  ::py::class_<dart::biomechanics::SubjectBatchProgress>(
+      m, "SubjectBatchProgress")
+      .def_readonly(
+          "numQueued", &dart::biomechanics::SubjectBatchProgress::numQueued)
+      .def_readonly(
+          "numRunning", &dart::biomechanics::SubjectBatchProgress::numRunning)
+      .def_readonly(
+          "numSucceeded",
+          &dart::biomechanics::SubjectBatchProgress::numSucceeded)
+      .def_readonly(
+          "numFailed", &dart::biomechanics::SubjectBatchProgress::numFailed)
+      .def_readonly(
+          "memoryInUseBytes",
+          &dart::biomechanics::SubjectBatchProgress::memoryInUseBytes)
+      .def_readonly(
+          "elapsedSeconds",
+          &dart::biomechanics::SubjectBatchProgress::elapsedSeconds)
+      .def_readonly(
+          "meanSecondsPerSubject",
+          &dart::biomechanics::SubjectBatchProgress::meanSecondsPerSubject)
+      .def_readonly(
+          "jobName", &dart::biomechanics::SubjectBatchProgress::jobName)
+      .def_readonly(
+          "jobStatus", &dart::biomechanics::SubjectBatchProgress::jobStatus)
+      .def_readonly(
+          "jobError", &dart::biomechanics::SubjectBatchProgress::jobError)
+      .def_readonly(
+          "jobSeconds", &dart::biomechanics::SubjectBatchProgress::jobSeconds);
+
+  ::py::class_<
+      dart::biomechanics::SubjectBatchProcessor,
+      std::shared_ptr<dart::biomechanics::SubjectBatchProcessor>>(
+      m, "SubjectBatchProcessor")
+      .def(
+          ::py::init<int, std::size_t>(),
+          ::py::arg("maxConcurrentSubjects") = -1,
+          ::py::arg("memoryBudgetBytes") = 0)
+      .def(
+          "enqueue",
+          &dart::biomechanics::SubjectBatchProcessor::enqueue,
+          ::py::arg("job"),
+          "This adds a job to the back of the queue, and starts it right away "
+          "if there's room")
+      .def(
+          "waitForAll",
+          &dart::biomechanics::SubjectBatchProcessor::waitForAll,
+          "This blocks until the queue is empty and nothing is running",
+          ::py::call_guard<py::gil_scoped_release>())
+      .def(
+          "setProgressCallback",
+          &dart::biomechanics::SubjectBatchProcessor::setProgressCallback,
+          ::py::arg("callback"),
+          "This sets a function to call with a fresh "
+          ":code:`SubjectBatchProgress` every time a subject starts or stops")
+      .def(
+          "getProgress",
+          &dart::biomechanics::SubjectBatchProcessor::getProgress,
+          "This returns a snapshot of the current state of the batch")
+      .def_static(
+          "estimateMemoryBytes",
+          &dart::biomechanics::SubjectBatchProcessor::estimateMemoryBytes,
+          ::py::arg("job"));
+}
+
+} // namespace python
+} // namespace dart
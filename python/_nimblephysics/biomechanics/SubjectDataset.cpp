@@ -0,0 +1,183 @@
+#include "dart/biomechanics/SharedChunkCache.hpp"
+#include "dart/biomechanics/SubjectDataset.hpp"
+
+#include <memory>
+
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SubjectDataset(py::module& m)
+{
+  auto sharedChunkCache
+      = ::py::class_<
+            dart::biomechanics::SharedChunkCache,
+            std::shared_ptr<dart::biomechanics::SharedChunkCache>>(
+            m, "SharedChunkCache")
+            .def(
+                ::py::init<const std::string&, std::size_t, std::size_t>(),
+                ::py::arg("name"),
+                ::py::arg("sizeBytes") = (std::size_t)1 << 30,
+                ::py::arg("slotBytes") = (std::size_t)1 << 20)
+            .def_static(
+                "unlink",
+                &dart::biomechanics::SharedChunkCache::unlink,
+                ::py::arg("name"),
+                "This removes the shared memory segment called :code:`name`. "
+                "Processes that already have it open keep using it, and it's "
+                "freed once they've all closed it.")
+            .def(
+                "isOpen",
+                &dart::biomechanics::SharedChunkCache::isOpen,
+                "Returns false if the segment couldn't be opened")
+            .def(
+                "getNumSlots",
+                &dart::biomechanics::SharedChunkCache::getNumSlots,
+                "This returns the number of slots in the segment")
+            .def(
+                "getSlotBytes",
+                &dart::biomechanics::SharedChunkCache::getSlotBytes,
+                "This returns the largest number of bytes a single chunk can "
+                "take up")
+            .def(
+                "getNumHits",
+                &dart::biomechanics::SharedChunkCache::getNumHits,
+                "This returns the number of lookups that found their chunk, "
+                "summed over every process using the segment")
+            .def(
+                "getNumMisses",
+                &dart::biomechanics::SharedChunkCache::getNumMisses,
+                "This returns the number of lookups that didn't find their "
+                "chunk, summed over every process using the segment");
+  sharedChunkCache.doc() = R"doc(
+        This is a cache of decoded chunks in a named POSIX shared memory segment, which every process on the
+        machine that opens the same name shares. Create one in each DataLoader worker (for example in
+        :code:`worker_init_fn`) and pass it to :code:`SubjectDataset.setSharedCache()`, so each chunk only gets
+        decoded once per machine. Call :code:`SharedChunkCache.unlink()` from the main process when you're done.
+      )doc";
+
+  auto subjectDataset
+      = ::py::class_<
+            dart::biomechanics::SubjectDataset,
+            std::shared_ptr<dart::biomechanics::SubjectDataset>>(
+            m, "SubjectDataset")
+            .def(
+                ::py::init<
+                    const std::vector<std::string>&,
+                    int,
+                    const std::vector<std::string>&,
+                    int,
+                    std::size_t>(),
+                ::py::arg("paths"),
+                ::py::arg("windowLen"),
+                ::py::arg("channels"),
+                ::py::arg("numThreads") = 4,
+                ::py::arg("cacheBudgetBytes") = 256 * 1024 * 1024)
+            .def(
+                "getNumSubjects",
+                &dart::biomechanics::SubjectDataset::getNumSubjects,
+                "This returns the number of subject files in the dataset")
+            .def(
+                "getSubject",
+                &dart::biomechanics::SubjectDataset::getSubject,
+                ::py::arg("subject"),
+                "This returns the :code:`SubjectOnDisk` for a subject, opening "
+                "its file first if this is the first time anyone has asked "
+                "for it.")
+            .def(
+                "prefetch",
+                &dart::biomechanics::SubjectDataset::prefetch,
+                ::py::arg("requests"),
+                "This queues up windows to read and decode on the background "
+                "threads. Requests for data that's already cached or on its "
+                "way are cheap no-ops.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "readWindow",
+                &dart::biomechanics::SubjectDataset::readWindow,
+                ::py::arg("request"),
+                "This returns one (channelDim x windowLen) array per channel, "
+                "in the order the dataset was made with. Anything not already "
+                "cached is read right away, and anything a background thread "
+                "is part way through reading is waited for. Windows that run "
+                "off the end of their trial are padded with zeros. On OOB "
+                "access, prints an error and returns an empty list.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "clearPrefetchQueue",
+                &dart::biomechanics::SubjectDataset::clearPrefetchQueue,
+                "This drops everything still waiting in the prefetch queue")
+            .def(
+                "getChannelStats",
+                &dart::biomechanics::SubjectDataset::getChannelStats,
+                ::py::arg("numThreads") = -1,
+                "This returns a :code:`ChannelStats` for each of the "
+                "dataset's channels, merged over every frame of every "
+                "subject. Files with stored statistics only have their "
+                "headers read.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "getShuffledIndex",
+                &dart::biomechanics::SubjectDataset::getShuffledIndex,
+                ::py::arg("seed"),
+                ::py::arg("stride") = 1,
+                ::py::arg("skipProbablyMissingGRF") = false,
+                ::py::arg("numThreads") = -1,
+                "This returns a :code:`WindowRequest` for every "
+                ":code:`stride`th frame of every trial of every subject, "
+                "shuffled with :code:`seed`. Only the headers and trial "
+                "metadata are read.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "setSharedCache",
+                &dart::biomechanics::SubjectDataset::setSharedCache,
+                ::py::arg("cache"),
+                "This sets a :code:`SharedChunkCache` shared with other "
+                "processes, which gets checked for chunks before reading them "
+                "off disk, and gets every chunk we do read off disk. Pass "
+                ":code:`None` to stop using it.")
+            .def(
+                "getCacheSizeBytes",
+                &dart::biomechanics::SubjectDataset::getCacheSizeBytes,
+                "This returns the number of bytes of decoded data in the cache")
+            .def(
+                "getNumCacheHits",
+                &dart::biomechanics::SubjectDataset::getNumCacheHits,
+                "This returns the number of chunks :code:`readWindow()` found "
+                "already cached")
+            .def(
+                "getNumCacheMisses",
+                &dart::biomechanics::SubjectDataset::getNumCacheMisses,
+                "This returns the number of chunks :code:`readWindow()` had to "
+                "wait for, or read itself");
+  subjectDataset.doc() = R"doc(
+        This is a view of lots of SubjectOnDisk files at once, built for random access training. Submit the
+        windows you're going to want next with :code:`prefetch()`, and background threads read and decode them
+        ahead of time, into an LRU cache with a byte budget, so :code:`readWindow()` (hopefully) doesn't have to
+        wait on the disk.
+      )doc";
+
+  ::py::class_<dart::biomechanics::SubjectDataset::WindowRequest>(
+      subjectDataset, "WindowRequest")
+      .def(
+          ::py::init<int, int, int>(),
+          ::py::arg("subject") = 0,
+          ::py::arg("trial") = 0,
+          ::py::arg("startFrame") = 0)
+      .def_readwrite(
+          "subject",
+          &dart::biomechanics::SubjectDataset::WindowRequest::subject)
+      .def_readwrite(
+          "trial", &dart::biomechanics::SubjectDataset::WindowRequest::trial)
+      .def_readwrite(
+          "startFrame",
+          &dart::biomechanics::SubjectDataset::WindowRequest::startFrame);
+}
+
+} // namespace python
+} // namespace dart
@@ -8,6 +8,7 @@
 #include <dart/dynamics/Skeleton.hpp>
 #include <dart/simulation/World.hpp>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -113,6 +114,192 @@ Note that these are specified in the local body frame, acting on the body at its
         This is for doing ML and large-scale data analysis. This is a single frame of data, returned in a list by :code:`SubjectOnDisk.readFrames()`, which contains everything needed to reconstruct all the dynamics of a snapshot in time.
       )doc";
 
+  auto frameView
+      = ::py::class_<dart::biomechanics::FrameView>(m, "FrameView")
+            .def_readonly(
+                "trial",
+                &dart::biomechanics::FrameView::trial,
+                "The index of the trial in the containing SubjectOnDisk.")
+            .def_readonly(
+                "t",
+                &dart::biomechanics::FrameView::t,
+                "The frame number in this trial.")
+            .def_readonly(
+                "probablyMissingGRF",
+                &dart::biomechanics::FrameView::probablyMissingGRF,
+                "This is true if this frame probably has unmeasured forces "
+                "acting on the body. See :code:`Frame.probablyMissingGRF`.")
+            .def_readonly(
+                "dt",
+                &dart::biomechanics::FrameView::dt,
+                "This is the size of the simulation timestep at this frame.")
+            .def_readonly(
+                "pos",
+                &dart::biomechanics::FrameView::pos,
+                "The joint positions on this frame, as a read-only array.")
+            .def_readonly(
+                "vel",
+                &dart::biomechanics::FrameView::vel,
+                "The joint velocities on this frame, as a read-only array.")
+            .def_readonly(
+                "acc",
+                &dart::biomechanics::FrameView::acc,
+                "The joint accelerations on this frame, as a read-only array.")
+            .def_readonly(
+                "tau",
+                &dart::biomechanics::FrameView::tau,
+                "The joint control forces on this frame, as a read-only array.")
+            .def_readonly(
+                "groundContactWrenches",
+                &dart::biomechanics::FrameView::groundContactWrenches,
+                "A 6 x (num contact bodies) read-only array, with one body "
+                "wrench per column, in the order of "
+                ":code:`SubjectOnDisk.getContactBodies()`.")
+            .def_readonly(
+                "groundContactCenterOfPressure",
+                &dart::biomechanics::FrameView::groundContactCenterOfPressure,
+                "A 3 x (num contact bodies) read-only array, with one world "
+                "center of pressure per column.")
+            .def_readonly(
+                "groundContactTorque",
+                &dart::biomechanics::FrameView::groundContactTorque,
+                "A 3 x (num contact bodies) read-only array, with one world "
+                "ground-reaction torque per column.")
+            .def_readonly(
+                "groundContactForce",
+                &dart::biomechanics::FrameView::groundContactForce,
+                "A 3 x (num contact bodies) read-only array, with one world "
+                "ground-reaction force per column.")
+            .def_readonly(
+                "customValues",
+                &dart::biomechanics::FrameView::customValues,
+                "A list of read-only arrays, in the order of "
+                ":code:`SubjectOnDisk.getCustomValues()`.");
+  frameView.doc() = R"doc(
+        This is a read-only view of a single frame, returned in a list by :code:`SubjectOnDisk.readFrameViews()`. 
+        All of the arrays on this object point straight into a memory-mapped copy of the file, so nothing gets copied. 
+        The file stays mapped as long as any of these views, or any arrays taken from them, are alive.
+      )doc";
+
+  auto frameBatch
+      = ::py::class_<
+            dart::biomechanics::FrameBatch,
+            std::shared_ptr<dart::biomechanics::FrameBatch>>(m, "FrameBatch")
+            .def_readonly(
+                "trial",
+                &dart::biomechanics::FrameBatch::trial,
+                "The index of the trial in the containing SubjectOnDisk.")
+            .def_readonly(
+                "startFrame",
+                &dart::biomechanics::FrameBatch::startFrame,
+                "The frame number in this trial of the first row.")
+            .def_readonly(
+                "numFrames",
+                &dart::biomechanics::FrameBatch::numFrames,
+                "The number of frames (rows) in this batch.")
+            .def_readonly(
+                "dt",
+                &dart::biomechanics::FrameBatch::dt,
+                "This is the size of the simulation timestep in this trial.")
+            .def_readonly(
+                "probablyMissingGRF",
+                &dart::biomechanics::FrameBatch::probablyMissingGRF,
+                "One entry per frame, true if that frame probably has "
+                "unmeasured forces acting on the body. See "
+                ":code:`Frame.probablyMissingGRF`.")
+            .def_readonly(
+                "pos",
+                &dart::biomechanics::FrameBatch::pos,
+                "A (num frames) x (num dofs) array of joint positions.")
+            .def_readonly(
+                "vel",
+                &dart::biomechanics::FrameBatch::vel,
+                "A (num frames) x (num dofs) array of joint velocities.")
+            .def_readonly(
+                "acc",
+                &dart::biomechanics::FrameBatch::acc,
+                "A (num frames) x (num dofs) array of joint accelerations.")
+            .def_readonly(
+                "tau",
+                &dart::biomechanics::FrameBatch::tau,
+                "A (num frames) x (num dofs) array of joint control forces.")
+            .def_readonly(
+                "groundContactWrenches",
+                &dart::biomechanics::FrameBatch::groundContactWrenches,
+                "A (num frames) x (6 * num contact bodies) array, with the "
+                "body wrenches in the order of :code:`groundContactBodies`.")
+            .def_readonly(
+                "groundContactCenterOfPressure",
+                &dart::biomechanics::FrameBatch::groundContactCenterOfPressure,
+                "A (num frames) x (3 * num contact bodies) array of world "
+                "centers of pressure.")
+            .def_readonly(
+                "groundContactTorque",
+                &dart::biomechanics::FrameBatch::groundContactTorque,
+                "A (num frames) x (3 * num contact bodies) array of world "
+                "ground-reaction torques.")
+            .def_readonly(
+                "groundContactForce",
+                &dart::biomechanics::FrameBatch::groundContactForce,
+                "A (num frames) x (3 * num contact bodies) array of world "
+                "ground-reaction forces.")
+            .def_readonly(
+                "groundContactBodies",
+                &dart::biomechanics::FrameBatch::groundContactBodies,
+                "The names of the ground contact bodies, in column order.")
+            .def_readonly(
+                "customValueNames",
+                &dart::biomechanics::FrameBatch::customValueNames,
+                "The names of the entries in :code:`customValues`.")
+            .def_readonly(
+                "customValues",
+                &dart::biomechanics::FrameBatch::customValues,
+                "A list of (num frames) x (dim) arrays, in the order of "
+                ":code:`customValueNames`.");
+  frameBatch.doc() = R"doc(
+        This is a structure-of-arrays version of a run of frames from a single trial, returned by :code:`SubjectOnDisk.readFrameBatch()`. 
+        Each channel is one contiguous NumPy array with one row per frame, and the channel arrays are read-only views into this object, so they aren't copied on access.
+      )doc";
+
+  auto channelStats
+      = ::py::class_<dart::biomechanics::ChannelStats>(m, "ChannelStats")
+            .def(::py::init<int>(), ::py::arg("dim") = 0)
+            .def_readwrite(
+                "count",
+                &dart::biomechanics::ChannelStats::count,
+                "The number of values seen in each dimension.")
+            .def_readwrite(
+                "mean",
+                &dart::biomechanics::ChannelStats::mean,
+                "The mean of each dimension.")
+            .def_readwrite(
+                "m2",
+                &dart::biomechanics::ChannelStats::m2,
+                "The sum of the squared differences from the mean in each "
+                "dimension.")
+            .def(
+                "addFrames",
+                &dart::biomechanics::ChannelStats::addFrames,
+                ::py::arg("frames"),
+                "This adds a (dim x numFrames) block of frames.")
+            .def(
+                "merge",
+                &dart::biomechanics::ChannelStats::merge,
+                ::py::arg("other"),
+                "This adds in statistics gathered over other frames.")
+            .def(
+                "getVariance",
+                &dart::biomechanics::ChannelStats::getVariance,
+                "This returns the variance of each dimension.")
+            .def(
+                "getStd",
+                &dart::biomechanics::ChannelStats::getStd,
+                "This returns the standard deviation of each dimension.");
+  channelStats.doc() = R"doc(
+        These are running statistics of each dimension of one channel, which can be merged across trials and
+        files without going back to the frames. Values that aren't finite are left out.
+      )doc";
+
   auto subjectOnDisk
       = ::py::class_<
             dart::biomechanics::SubjectOnDisk,
@@ -132,7 +319,8 @@ Note that these are specified in the local body frame, acting on the body at its
                 "save space. If you do not pass in :code:`geometryFolder`, "
                 "expect to get warnings about being unable to load meshes, and "
                 "expect that your skeleton will not display if you attempt to "
-                "visualize it.")
+                "visualize it.",
+                ::py::call_guard<py::gil_scoped_release>())
             .def(
                 "readFrames",
                 &dart::biomechanics::SubjectOnDisk::readFrames,
@@ -146,7 +334,168 @@ Note that these are specified in the local body frame, acting on the body at its
                 ":code:`readFrames()` to construct a training batch, then "
                 "immediately allow the frames to go out of scope and be "
                 "released after the batch backpropagates gradient and loss."
-                " On OOB access, prints an error and returns an empty vector.")
+                " On OOB access, prints an error and returns an empty vector.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "readFrameViews",
+                &dart::biomechanics::SubjectOnDisk::readFrameViews,
+                ::py::arg("trial"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead") = 1,
+                "This is the zero-copy version of :code:`readFrames()`. The "
+                "first call memory-maps the file, and after that this just "
+                "returns :code:`FrameView` objects that point into the "
+                "mapping, without copying any frame data. On OOB access, "
+                "prints an error and returns an empty vector.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "readFrameBatch",
+                &dart::biomechanics::SubjectOnDisk::readFrameBatch,
+                ::py::arg("trial"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead") = 1,
+                "This reads the same data as :code:`readFrames()`, but as a "
+                "single :code:`FrameBatch` with one [frames x dim] array per "
+                "channel, which is much cheaper to turn into a training batch "
+                "than a list of :code:`Frame` objects. On OOB access, prints "
+                "an error and returns an empty batch.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "readFrameArrays",
+                +[](dart::biomechanics::SubjectOnDisk* self,
+                    int trial,
+                    int startFrame,
+                    int numFramesToRead) -> ::py::dict {
+                  std::vector<dart::biomechanics::FrameView> views
+                      = self->readFrameViews(
+                          trial, startFrame, numFramesToRead);
+                  ::py::dict result;
+                  if (views.size() == 0)
+                  {
+                    return result;
+                  }
+
+                  // Consecutive frames sit a fixed number of bytes apart on
+                  // disk, so each field across all the frames is one strided
+                  // array into the mapping. The capsule keeps the file mapped
+                  // for as long as any of the arrays are alive.
+                  ::py::capsule base(
+                      new std::shared_ptr<const char>(views[0].mapping),
+                      [](void* ptr) {
+                        delete static_cast<std::shared_ptr<const char>*>(ptr);
+                      });
+                  const ::py::ssize_t numFrames = views.size();
+                  const ::py::ssize_t numDofs = self->getNumDofs();
+                  const std::vector<::py::ssize_t> shape{numFrames, numDofs};
+                  const std::vector<::py::ssize_t> strides{
+                      self->getFrameSizeBytes(), sizeof(double)};
+                  auto makeArray = [&](const double* data) {
+                    ::py::array_t<double> array(shape, strides, data, base);
+                    // The mapping is read-only
+                    array.attr("setflags")(::py::arg("write") = false);
+                    return array;
+                  };
+                  result["pos"] = makeArray(views[0].pos.data());
+                  result["vel"] = makeArray(views[0].vel.data());
+                  result["acc"] = makeArray(views[0].acc.data());
+                  result["tau"] = makeArray(views[0].tau.data());
+                  return result;
+                },
+                ::py::arg("trial"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead") = 1,
+                "This reads a run of frames as a dictionary of read-only "
+                "(numFrames x numDofs) arrays, with keys :code:`pos`, "
+                ":code:`vel`, :code:`acc` and :code:`tau`. The arrays are "
+                "strided views straight into a memory-mapped copy of the "
+                "file, so nothing gets copied, which makes this the fastest "
+                "way to feed training batches to a data loader. On OOB "
+                "access, prints an error and returns an empty dictionary.")
+            .def(
+                "readChannelWindow",
+                &dart::biomechanics::SubjectOnDisk::readChannelWindow,
+                ::py::arg("trial"),
+                ::py::arg("startFrame"),
+                ::py::arg("numFramesToRead"),
+                ::py::arg("channels"),
+                "This reads just the requested channels for a run of frames, "
+                "and returns one (channelDim x numFrames) array per channel, "
+                "in the order asked for. The channels are :code:`pos`, "
+                ":code:`vel`, :code:`acc`, :code:`tau`, "
+                ":code:`groundContactWrenches`, "
+                ":code:`groundContactCopTorqueForce`, and any of the names "
+                "from :code:`getCustomValues()`. On version 2 files this only "
+                "reads the bytes of the channels asked for. On OOB access or "
+                "an unknown channel, prints an error and returns an empty "
+                "list.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "readWindowsBatch",
+                +[](dart::biomechanics::SubjectOnDisk* self,
+                    const std::vector<std::pair<int, int>>& requests,
+                    int windowLen,
+                    const std::vector<std::string>& channels,
+                    int numThreads) -> ::py::dict {
+                  // Allocate the whole batch up front, then fill it in
+                  // without holding the GIL
+                  std::vector<::py::array_t<double>> arrays;
+                  std::vector<double*> outputs;
+                  for (const std::string& channel : channels)
+                  {
+                    arrays.emplace_back(std::vector<::py::ssize_t>{
+                        (::py::ssize_t)requests.size(),
+                        windowLen,
+                        self->getChannelDim(channel)});
+                    outputs.push_back(arrays.back().mutable_data());
+                  }
+                  bool success;
+                  {
+                    ::py::gil_scoped_release release;
+                    success = self->readWindowsBatch(
+                        requests, windowLen, channels, outputs, numThreads);
+                  }
+                  ::py::dict result;
+                  if (!success)
+                  {
+                    return result;
+                  }
+                  for (int i = 0; i < channels.size(); i++)
+                  {
+                    result[::py::str(channels[i])] = arrays[i];
+                  }
+                  return result;
+                },
+                ::py::arg("requests"),
+                ::py::arg("windowLen"),
+                ::py::arg("channels"),
+                ::py::arg("numThreads") = -1,
+                "This reads a whole minibatch of windows in one call. Each "
+                "request is a :code:`(trial, startFrame)` pair, and this "
+                "returns a dictionary from each of :code:`channels` (named as "
+                "in :code:`readChannelWindow()`) to a (batch x windowLen x "
+                "channelDim) array. The windows are read and decoded across "
+                ":code:`numThreads` threads (values <= 0 mean use all the "
+                "hardware threads). Windows that run off the end of their "
+                "trial are padded with zeros. On OOB access or an unknown "
+                "channel, prints an error and returns an empty dictionary.")
+            .def(
+                "getChannelStats",
+                &dart::biomechanics::SubjectOnDisk::getChannelStats,
+                ::py::arg("channel"),
+                "This returns the statistics of the named channel over every "
+                "frame of every trial. Files written with "
+                ":code:`SubjectWriter` store these, so this only reads a few "
+                "bytes. For other files, the first call reads every frame.",
+                ::py::call_guard<py::gil_scoped_release>())
+            .def(
+                "hasStoredChannelStats",
+                &dart::biomechanics::SubjectOnDisk::hasStoredChannelStats,
+                "This returns true if this file has channel statistics stored "
+                "in it.")
+            .def(
+                "getFormatVersion",
+                &dart::biomechanics::SubjectOnDisk::getFormatVersion,
+                "This returns the version of the binary format of this file.")
             .def_static(
                 "writeSubject",
                 &dart::biomechanics::SubjectOnDisk::writeSubject,
@@ -177,8 +526,15 @@ Note that these are specified in the local body frame, acting on the body at its
                 ::py::arg("trialNames") = std::vector<std::string>(),
                 ::py::arg("sourceHref") = "",
                 ::py::arg("notes") = "",
+                ::py::arg("formatVersion") = 1,
                 "This writes a subject out to disk in a compressed and "
-                "random-seekable binary format.")
+                "random-seekable binary format. Version 1 stores whole frames "
+                "one after another, which :code:`readFrameViews()` needs. "
+                "Version 2 stores each channel in compressed chunks of about "
+                "a second each, which is smaller, and much faster to read a "
+                "few channels at a time from with "
+                ":code:`readChannelWindow()`.",
+                ::py::call_guard<py::gil_scoped_release>())
             .def(
                 "getNumDofs",
                 &dart::biomechanics::SubjectOnDisk::getNumDofs,
@@ -249,6 +605,50 @@ Note that these are specified in the local body frame, acting on the body at its
         until asked for. That way we can instantiate thousands of these in memory,
         and not worry about OOM'ing a machine.
       )doc";
+
+  ::py::class_<
+      dart::biomechanics::SubjectWriter,
+      std::shared_ptr<dart::biomechanics::SubjectWriter>>(m, "SubjectWriter")
+      .def(
+          ::py::init<
+              const std::string&,
+              const std::string&,
+              const std::vector<std::string>&,
+              const std::vector<std::string>&,
+              const std::vector<int>&,
+              const std::string&,
+              const std::string&>(),
+          ::py::arg("outputPath"),
+          ::py::arg("openSimFilePath"),
+          ::py::arg("groundForceBodies"),
+          ::py::arg("customValueNames"),
+          ::py::arg("customValueDims"),
+          ::py::arg("sourceHref") = "",
+          ::py::arg("notes") = "")
+      .def(
+          "startTrial",
+          &dart::biomechanics::SubjectWriter::startTrial,
+          ::py::arg("name"),
+          ::py::arg("timestep"),
+          "This starts a new trial, finishing off the previous one (if any).")
+      .def(
+          "appendFrame",
+          &dart::biomechanics::SubjectWriter::appendFrame,
+          ::py::arg("pos"),
+          ::py::arg("vel"),
+          ::py::arg("acc"),
+          ::py::arg("tau"),
+          ::py::arg("groundBodyWrenches"),
+          ::py::arg("groundBodyCopTorqueForce"),
+          ::py::arg("customValues"),
+          ::py::arg("probablyMissingGRF"),
+          "This adds a frame to the end of the current trial. Frames with "
+          "the wrong sizes are skipped, and this returns False.")
+      .def(
+          "close",
+          &dart::biomechanics::SubjectWriter::close,
+          "This writes out the metadata and closes the file. Calling this "
+          "more than once is harmless.");
 }
 
 } // namespace python
@@ -53,6 +53,9 @@ void IKErrorReport(py::module& sm);
 void Anthropometrics(py::module& sm);
 void C3DLoader(py::module& sm);
 void SubjectOnDisk(py::module& sm);
+void SubjectDataset(py::module& sm);
+void SubjectBatchProcessor(py::module& sm);
+void DynamicsPipeline(py::module& sm);
 
 void dart_biomechanics(py::module& m)
 {
@@ -75,6 +78,9 @@ void dart_biomechanics(py::module& m)
   MarkerLabeller(sm);
   IKErrorReport(sm);
   SubjectOnDisk(sm);
+  SubjectDataset(sm);
+  SubjectBatchProcessor(sm);
+  DynamicsPipeline(sm);
 }
 
 } // namespace python
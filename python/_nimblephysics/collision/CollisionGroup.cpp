@@ -54,7 +54,10 @@ void CollisionGroup(py::module& m)
           &dart::collision::DistanceOption::enableNearestPoints)
       .def_readwrite(
           "distanceLowerBound",
-          &dart::collision::DistanceOption::distanceLowerBound);
+          &dart::collision::DistanceOption::distanceLowerBound)
+      .def_readwrite(
+          "distanceUpperBound",
+          &dart::collision::DistanceOption::distanceUpperBound);
 
   ::py::class_<dart::collision::DistanceResult>(m, "DistanceResult")
       .def_readwrite(
@@ -99,6 +102,22 @@ void CollisionGroup(py::module& m)
       .def("clear", &dart::collision::RaycastResult::clear)
       .def_readwrite("mRayHits", &dart::collision::RaycastResult::mRayHits);
 
+  ::py::class_<dart::collision::RaycastBatchResult>(m, "RaycastBatchResult")
+      .def(::py::init<>())
+      .def("getNumHits", &dart::collision::RaycastBatchResult::getNumHits)
+      .def_readwrite(
+          "mDistances",
+          &dart::collision::RaycastBatchResult::mDistances,
+          "The distance to the closest hit of each ray, or infinity on a miss")
+      .def_readwrite(
+          "mNormals",
+          &dart::collision::RaycastBatchResult::mNormals,
+          "The (Nx3) world normal at the closest hit of each ray")
+      .def_readwrite(
+          "mPoints",
+          &dart::collision::RaycastBatchResult::mPoints,
+          "The (Nx3) world point of the closest hit of each ray");
+
   ::py::class_<
       dart::collision::CollisionGroup,
       std::shared_ptr<dart::collision::CollisionGroup>>(m, "CollisionGroup")
@@ -254,6 +273,23 @@ void CollisionGroup(py::module& m)
           ::py::arg("to_point"),
           ::py::arg("option"),
           ::py::arg("result"))
+      .def(
+          "raycastBatch",
+          +[](dart::collision::CollisionGroup* self,
+              const Eigen::MatrixXs& origins,
+              const Eigen::MatrixXs& directions)
+              -> dart::collision::RaycastBatchResult {
+            dart::collision::RaycastBatchResult result;
+            self->raycastBatch(
+                origins,
+                directions,
+                dart::collision::RaycastOption(),
+                &result);
+            return result;
+          },
+          ::py::arg("origins"),
+          ::py::arg("directions"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setAutomaticUpdate",
           +[](dart::collision::CollisionGroup* self) {
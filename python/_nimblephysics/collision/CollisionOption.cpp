@@ -64,6 +64,12 @@ void CollisionOption(py::module& m)
           "enableContact", &dart::collision::CollisionOption::enableContact)
       .def_readwrite(
           "maxNumContacts", &dart::collision::CollisionOption::maxNumContacts)
+      .def_readwrite(
+          "maxNumContactsPerPair",
+          &dart::collision::CollisionOption::maxNumContactsPerPair)
+      .def_readwrite(
+          "continuousCollisionTimeStep",
+          &dart::collision::CollisionOption::continuousCollisionTimeStep)
       .def_readwrite(
           "collisionFilter",
           &dart::collision::CollisionOption::collisionFilter);
@@ -0,0 +1,28 @@
+#include <dart/common/TaskScheduler.hpp>
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void TaskScheduler(py::module& m)
+{
+  m.def(
+      "setMaxConcurrency",
+      &dart::common::TaskScheduler::setGlobalMaxConcurrency,
+      ::py::arg("maxConcurrency"),
+      "This sets the number of threads in the pool shared by all of the "
+      "library's parallel code (marker fitting, dynamics fitting, etc), which "
+      "caps how many threads will run at once. Values <= 0 mean use all the "
+      "hardware threads. This shouldn't be called while anything is running "
+      "on the pool.");
+  m.def(
+      "getMaxConcurrency",
+      &dart::common::TaskScheduler::getGlobalMaxConcurrency,
+      "This returns the number of threads in the pool shared by all of the "
+      "library's parallel code.");
+}
+
+} // namespace python
+} // namespace dart
@@ -41,6 +41,7 @@ void Observer(py::module& sm);
 void Subject(py::module& sm);
 void Uri(py::module& sm);
 void Composite(py::module& sm);
+void TaskScheduler(py::module& sm);
 
 void dart_common(py::module& m)
 {
@@ -50,6 +51,7 @@ void dart_common(py::module& m)
   Subject(sm);
   Uri(sm);
   Composite(sm);
+  TaskScheduler(sm);
 }
 
 } // namespace python
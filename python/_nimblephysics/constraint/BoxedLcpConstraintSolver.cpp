@@ -77,6 +77,61 @@ void BoxedLcpConstraintSolver(py::module& m)
           +[](dart::constraint::BoxedLcpConstraintSolver* self) {
             return self->makeHyperAccurateAndVerySlow();
           })
+      .def(
+          "setJacobianAssemblyEnabled",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setJacobianAssemblyEnabled(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getJacobianAssemblyEnabled",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getJacobianAssemblyEnabled();
+          })
+      .def(
+          "setSmallLcpSolverEnabled",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setSmallLcpSolverEnabled(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getSmallLcpSolverEnabled",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getSmallLcpSolverEnabled();
+          })
+      .def(
+          "setIterativeRefinementEnabled",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setIterativeRefinementEnabled(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getIterativeRefinementEnabled",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getIterativeRefinementEnabled();
+          })
+      .def(
+          "setContactWarmStartEnabled",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, bool enabled) {
+            self->setContactWarmStartEnabled(enabled);
+          },
+          ::py::arg("enabled"))
+      .def(
+          "getContactWarmStartEnabled",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> bool {
+            return self->getContactWarmStartEnabled();
+          })
+      .def(
+          "setContactWarmStartRadius",
+          +[](dart::constraint::BoxedLcpConstraintSolver* self, s_t radius) {
+            self->setContactWarmStartRadius(radius);
+          },
+          ::py::arg("radius"))
+      .def(
+          "getContactWarmStartRadius",
+          +[](const dart::constraint::BoxedLcpConstraintSolver* self) -> s_t {
+            return self->getContactWarmStartRadius();
+          })
       .def(
           "buildLcpInputs",
           +[](dart::constraint::BoxedLcpConstraintSolver* self,
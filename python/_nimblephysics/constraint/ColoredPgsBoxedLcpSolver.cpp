@@ -0,0 +1,82 @@
+#include <dart/constraint/ColoredPgsBoxedLcpSolver.hpp>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void ColoredPgsBoxedLcpSolver(py::module& m)
+{
+  ::py::class_<dart::constraint::ColoredPgsBoxedLcpSolver::Option>(
+      m, "ColoredPgsBoxedLcpSolverOption")
+      .def(
+          ::py::init<int, s_t, s_t, int>(),
+          ::py::arg("maxIteration") = 50,
+          ::py::arg("tolerance") = 1e-6,
+          ::py::arg("epsilonForDivision") = 1e-9,
+          ::py::arg("numThreads") = 1)
+      .def_readwrite(
+          "mMaxIteration",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::Option::mMaxIteration)
+      .def_readwrite(
+          "mTolerance",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::Option::mTolerance)
+      .def_readwrite(
+          "mEpsilonForDivision",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::Option::
+              mEpsilonForDivision)
+      .def_readwrite(
+          "mNumThreads",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::Option::mNumThreads);
+
+  ::py::class_<
+      dart::constraint::ColoredPgsBoxedLcpSolver,
+      dart::constraint::BoxedLcpSolver,
+      std::shared_ptr<dart::constraint::ColoredPgsBoxedLcpSolver>>(
+      m, "ColoredPgsBoxedLcpSolver")
+      .def(
+          ::py::init<
+              const dart::constraint::ColoredPgsBoxedLcpSolver::Option&>(),
+          ::py::arg("option")
+          = dart::constraint::ColoredPgsBoxedLcpSolver::Option())
+      .def(
+          "getType",
+          +[](const dart::constraint::ColoredPgsBoxedLcpSolver* self)
+              -> const std::string& { return self->getType(); },
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "setOption",
+          +[](dart::constraint::ColoredPgsBoxedLcpSolver* self,
+              const dart::constraint::ColoredPgsBoxedLcpSolver::Option&
+                  option) { self->setOption(option); },
+          ::py::arg("option"))
+      .def(
+          "getOption",
+          +[](dart::constraint::ColoredPgsBoxedLcpSolver* self)
+              -> const dart::constraint::ColoredPgsBoxedLcpSolver::Option& {
+            return self->getOption();
+          })
+      .def(
+          "getLastNumIterations",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::getLastNumIterations)
+      .def(
+          "getLastResidual",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::getLastResidual)
+      .def(
+          "getLastResidualHistory",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::getLastResidualHistory)
+      .def(
+          "getLastNumColors",
+          &dart::constraint::ColoredPgsBoxedLcpSolver::getLastNumColors)
+      .def_static(
+          "getStaticType",
+          +[]() -> const std::string& {
+            return dart::constraint::ColoredPgsBoxedLcpSolver::getStaticType();
+          },
+          ::py::return_value_policy::reference_internal);
+}
+
+} // namespace python
+} // namespace dart
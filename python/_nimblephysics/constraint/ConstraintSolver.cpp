@@ -187,6 +187,22 @@ void ConstraintSolver(py::module& m)
               -> std::vector<constraint::ConstrainedGroup> {
             return self->getConstrainedGroups();
           })
+      .def(
+          "getNumConstrainedGroupRebuilds",
+          +[](const dart::constraint::ConstraintSolver* self) -> std::size_t {
+            return self->getNumConstrainedGroupRebuilds();
+          })
+      .def(
+          "setNumGroupSolverThreads",
+          +[](dart::constraint::ConstraintSolver* self, int numThreads) {
+            self->setNumGroupSolverThreads(numThreads);
+          },
+          ::py::arg("numThreads"))
+      .def(
+          "getNumGroupSolverThreads",
+          +[](const dart::constraint::ConstraintSolver* self) -> int {
+            return self->getNumGroupSolverThreads();
+          })
       .def(
           "buildConstrainedGroups",
           +[](dart::constraint::ConstraintSolver* self) {
@@ -74,6 +74,19 @@ void DantzigBoxedLcpSolver(py::module& m)
           ::py::arg("hi"),
           ::py::arg("findex"),
           ::py::arg("earlyTermination"))
+      .def(
+          "setWarmStartEnabled",
+          &dart::constraint::DantzigBoxedLcpSolver::setWarmStartEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getWarmStartEnabled",
+          &dart::constraint::DantzigBoxedLcpSolver::getWarmStartEnabled)
+      .def(
+          "getNumSolves",
+          &dart::constraint::DantzigBoxedLcpSolver::getNumSolves)
+      .def(
+          "getNumWarmStarts",
+          &dart::constraint::DantzigBoxedLcpSolver::getNumWarmStarts)
       .def_static(
           "getStaticType",
           +[]() -> const std::string& {
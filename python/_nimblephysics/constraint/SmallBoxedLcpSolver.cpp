@@ -0,0 +1,66 @@
+#include <dart/constraint/SmallBoxedLcpSolver.hpp>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void SmallBoxedLcpSolver(py::module& m)
+{
+  ::py::class_<dart::constraint::SmallBoxedLcpSolver::Option>(
+      m, "SmallBoxedLcpSolverOption")
+      .def(
+          ::py::init<int, s_t>(),
+          ::py::arg("maxIteration") = 10,
+          ::py::arg("tolerance") = 1e-9)
+      .def_readwrite(
+          "mMaxIteration",
+          &dart::constraint::SmallBoxedLcpSolver::Option::mMaxIteration)
+      .def_readwrite(
+          "mTolerance",
+          &dart::constraint::SmallBoxedLcpSolver::Option::mTolerance);
+
+  ::py::class_<
+      dart::constraint::SmallBoxedLcpSolver,
+      dart::constraint::BoxedLcpSolver,
+      std::shared_ptr<dart::constraint::SmallBoxedLcpSolver>>(
+      m, "SmallBoxedLcpSolver")
+      .def(
+          ::py::init<const dart::constraint::SmallBoxedLcpSolver::Option&>(),
+          ::py::arg("option") = dart::constraint::SmallBoxedLcpSolver::Option())
+      .def(
+          "getType",
+          +[](const dart::constraint::SmallBoxedLcpSolver* self)
+              -> const std::string& { return self->getType(); },
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "setOption",
+          +[](dart::constraint::SmallBoxedLcpSolver* self,
+              const dart::constraint::SmallBoxedLcpSolver::Option& option) {
+            self->setOption(option);
+          },
+          ::py::arg("option"))
+      .def(
+          "getOption",
+          +[](dart::constraint::SmallBoxedLcpSolver* self)
+              -> const dart::constraint::SmallBoxedLcpSolver::Option& {
+            return self->getOption();
+          })
+      .def(
+          "getLastNumIterations",
+          &dart::constraint::SmallBoxedLcpSolver::getLastNumIterations)
+      .def_static(
+          "getMaxDimension",
+          &dart::constraint::SmallBoxedLcpSolver::getMaxDimension)
+      .def_static(
+          "getStaticType",
+          +[]() -> const std::string& {
+            return dart::constraint::SmallBoxedLcpSolver::getStaticType();
+          },
+          ::py::return_value_policy::reference_internal);
+}
+
+} // namespace python
+} // namespace dart
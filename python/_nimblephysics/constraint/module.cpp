@@ -45,6 +45,8 @@ void JointCoulombFrictionConstraint(py::module& sm);
 void BoxedLcpSolver(py::module& sm);
 void DantzigBoxedLcpSolver(py::module& sm);
 void PgsBoxedLcpSolver(py::module& sm);
+void ColoredPgsBoxedLcpSolver(py::module& sm);
+void SmallBoxedLcpSolver(py::module& sm);
 
 void ConstraintSolver(py::module& sm);
 void BoxedLcpConstraintSolver(py::module& sm);
@@ -70,6 +72,8 @@ void dart_constraint(py::module& m)
   BoxedLcpSolver(sm);
   DantzigBoxedLcpSolver(sm);
   PgsBoxedLcpSolver(sm);
+  ColoredPgsBoxedLcpSolver(sm);
+  SmallBoxedLcpSolver(sm);
 
   ConstraintSolver(sm);
   BoxedLcpConstraintSolver(sm);
@@ -109,6 +109,25 @@ void JacobianNode(py::module& m)
             return self->getWorldJacobian(_offset);
           },
           ::py::arg("offset"))
+      .def(
+          "getJacobianView",
+          +[](const dart::dynamics::JacobianNode* self)
+              -> const dart::math::Jacobian& { return self->getJacobian(); },
+          ::py::return_value_policy::reference_internal,
+          "Returns a read-only view onto this node's cached Jacobian, in its "
+          "own frame, instead of a copy. The view holds the values from this "
+          "call, and is only refreshed by calling this again after changing "
+          "the state. It must not be used after the number of DOFs changes, "
+          "or once the Skeleton is gone.")
+      .def(
+          "getWorldJacobianView",
+          +[](const dart::dynamics::JacobianNode* self)
+              -> const dart::math::Jacobian& {
+            return self->getWorldJacobian();
+          },
+          ::py::return_value_policy::reference_internal,
+          "Same as :code:`getJacobianView()`, but for the Jacobian in world "
+          "coordinates.")
       .def(
           "getLinearJacobian",
           +[](const dart::dynamics::JacobianNode* self)
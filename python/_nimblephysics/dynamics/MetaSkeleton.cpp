@@ -325,6 +325,34 @@ void MetaSkeleton(
             return self->getPositions(_indices);
           },
           ::py::arg("indices"))
+      .def(
+          "getPositionsInto",
+          &dart::dynamics::MetaSkeleton::getPositionsInto,
+          ::py::arg("out"),
+          "Writes the positions into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getVelocitiesInto",
+          &dart::dynamics::MetaSkeleton::getVelocitiesInto,
+          ::py::arg("out"),
+          "Writes the velocities into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getAccelerationsInto",
+          &dart::dynamics::MetaSkeleton::getAccelerationsInto,
+          ::py::arg("out"),
+          "Writes the accelerations into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getControlForcesInto",
+          &dart::dynamics::MetaSkeleton::getControlForcesInto,
+          ::py::arg("out"),
+          "Writes the control forces into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
       .def(
           "resetPositions",
           +[](dart::dynamics::MetaSkeleton* self) { self->resetPositions(); })
@@ -464,10 +464,34 @@ void Shape(py::module& m)
           +[]() -> const std::string& {
             return dart::dynamics::MeshShape::getStaticType();
           },
-          ::py::return_value_policy::reference_internal);
+          ::py::return_value_policy::reference_internal)
+      .def(
+          "isMeshLoaded",
+          &dart::dynamics::MeshShape::isMeshLoaded,
+          ::py::call_guard<py::gil_scoped_release>())
+      .def_static(
+          "setDefaultLoadingMode",
+          &dart::dynamics::MeshShape::setDefaultLoadingMode,
+          ::py::arg("mode"))
+      .def_static(
+          "getDefaultLoadingMode",
+          &dart::dynamics::MeshShape::getDefaultLoadingMode)
+      .def_static(
+          "setMeshRegistryEnabled",
+          &dart::dynamics::MeshShape::setMeshRegistryEnabled,
+          ::py::arg("enabled"))
+      .def_static(
+          "getNumRegisteredMeshes",
+          &dart::dynamics::MeshShape::getNumRegisteredMeshes);
 
   auto attr = m.attr("MeshShape");
 
+  ::py::enum_<dart::dynamics::MeshShape::LoadingMode>(attr, "LoadingMode")
+      .value("EAGER", dart::dynamics::MeshShape::LoadingMode::EAGER)
+      .value("LAZY", dart::dynamics::MeshShape::LoadingMode::LAZY)
+      .value("ASYNC", dart::dynamics::MeshShape::LoadingMode::ASYNC)
+      .export_values();
+
   ::py::enum_<dart::dynamics::MeshShape::ColorMode>(attr, "ColorMode")
       .value(
           "MATERIAL_COLOR",
@@ -265,6 +265,26 @@ void ShapeFrame(py::module& m)
           "isCollidable",
           +[](const dart::dynamics::CollisionAspect* self) -> bool {
             return self->isCollidable();
+          })
+      .def(
+          "setCollisionLayers",
+          +[](dart::dynamics::CollisionAspect* self,
+              const std::uint32_t& value) { self->setCollisionLayers(value); },
+          ::py::arg("value"))
+      .def(
+          "getCollisionLayers",
+          +[](const dart::dynamics::CollisionAspect* self) -> std::uint32_t {
+            return self->getCollisionLayers();
+          })
+      .def(
+          "setCollisionMask",
+          +[](dart::dynamics::CollisionAspect* self,
+              const std::uint32_t& value) { self->setCollisionMask(value); },
+          ::py::arg("value"))
+      .def(
+          "getCollisionMask",
+          +[](const dart::dynamics::CollisionAspect* self) -> std::uint32_t {
+            return self->getCollisionMask();
           });
 
   ::py::class_<dart::dynamics::detail::DynamicsAspectProperties>(
@@ -291,6 +291,47 @@ void Skeleton(
             return self->cloneSkeleton(cloneName);
           },
           ::py::arg("cloneName"))
+      .def(
+          "serialize",
+          +[](const dart::dynamics::Skeleton* self,
+              const dart::dynamics::MarkerMap& markers) -> ::py::bytes {
+            std::string bytes;
+            {
+              ::py::gil_scoped_release release;
+              bytes = self->serialize(markers);
+            }
+            return ::py::bytes(bytes);
+          },
+          ::py::arg("markers") = dart::dynamics::MarkerMap(),
+          "This encodes the Skeleton, and any of the passed in markers that "
+          "are attached to it, into a compact binary form that "
+          ":code:`Skeleton.deserialize()` can load much faster than any of "
+          "the text formats. Returns empty bytes on failure.")
+      .def_static(
+          "deserialize",
+          +[](const std::string& bytes) -> dart::dynamics::SkeletonPtr {
+            ::py::gil_scoped_release release;
+            return dart::dynamics::Skeleton::deserialize(bytes);
+          },
+          ::py::arg("bytes"),
+          "This builds a new Skeleton from the output of "
+          ":code:`Skeleton.serialize()`, loading meshes from local files. "
+          "Returns None on failure.")
+      .def_static(
+          "deserializeWithMarkers",
+          +[](const std::string& bytes)
+              -> std::pair<
+                  dart::dynamics::SkeletonPtr,
+                  dart::dynamics::MarkerMap> {
+            ::py::gil_scoped_release release;
+            dart::dynamics::MarkerMap markers;
+            dart::dynamics::SkeletonPtr skel
+                = dart::dynamics::Skeleton::deserialize(bytes, &markers);
+            return std::make_pair(skel, markers);
+          },
+          ::py::arg("bytes"),
+          "This is :code:`Skeleton.deserialize()`, but also returns the "
+          "serialized markers, attached to the new Skeleton.")
       .def(
           "simplifySkeleton",
           +[](const dart::dynamics::Skeleton* self,
@@ -445,6 +486,17 @@ void Skeleton(
           +[](const dart::dynamics::Skeleton* self) -> bool {
             return self->isMobile();
           })
+      .def(
+          "setAsleep",
+          +[](dart::dynamics::Skeleton* self, bool asleep) -> void {
+            return self->setAsleep(asleep);
+          },
+          ::py::arg("asleep"))
+      .def(
+          "isAsleep",
+          +[](const dart::dynamics::Skeleton* self) -> bool {
+            return self->isAsleep();
+          })
       .def(
           "setTimeStep",
           +[](dart::dynamics::Skeleton* self, s_t _timeStep) -> void {
@@ -886,6 +938,9 @@ void Skeleton(
           ::py::arg("scales"),
           ::py::arg("silentlyClamp") = false)
       .def("getGroupScales", &dart::dynamics::Skeleton::getGroupScales)
+      .def(
+          "getKinematicsVersion",
+          &dart::dynamics::Skeleton::getKinematicsVersion)
       .def(
           "setGroupMasses",
           &dart::dynamics::Skeleton::setGroupMasses,
@@ -951,6 +1006,27 @@ void Skeleton(
           "getMarkerWorldPositions",
           &dart::dynamics::Skeleton::getMarkerWorldPositions,
           ::py::arg("markers"))
+      .def(
+          "getMarkerWorldPositionsBatch",
+          &dart::dynamics::Skeleton::getMarkerWorldPositionsBatch,
+          ::py::arg("poses"),
+          ::py::arg("markers"),
+          ::py::arg("numThreads") = -1)
+      .def(
+          "getMarkerAverageErrorBatch",
+          +[](dart::dynamics::Skeleton* self,
+              const Eigen::MatrixXs& poses,
+              const dart::dynamics::MarkerMap& markers,
+              const std::vector<std::map<std::string, Eigen::Vector3s>>&
+                  observations,
+              int numThreads) -> s_t {
+            return self->getMarkerAverageErrorBatch(
+                poses, markers, observations, numThreads);
+          },
+          ::py::arg("poses"),
+          ::py::arg("markers"),
+          ::py::arg("observations"),
+          ::py::arg("numThreads") = -1)
       .def(
           "getMarkerMapWorldPositions",
           &dart::dynamics::Skeleton::getMarkerMapWorldPositions,
@@ -1186,6 +1262,14 @@ void Skeleton(
           ::py::arg("withExternalForces"),
           ::py::arg("withDampingForces"),
           ::py::arg("withSpringForces"))
+      .def(
+          "computeInverseDynamicsBatch",
+          &dart::dynamics::Skeleton::computeInverseDynamicsBatch,
+          ::py::arg("poses"),
+          ::py::arg("vels"),
+          ::py::arg("accs"),
+          ::py::arg("externalWrenches") = Eigen::MatrixXs::Zero(0, 0),
+          ::py::arg("numThreads") = -1)
       .def(
           "clearConstraintImpulses",
           +[](dart::dynamics::Skeleton* self) -> void {
@@ -1546,6 +1630,17 @@ void Skeleton(
           +[](const dart::dynamics::Skeleton* self) -> const Eigen::MatrixXs& {
             return self->getMassMatrix();
           })
+      .def(
+          "getMassMatrixView",
+          +[](const dart::dynamics::Skeleton* self) -> const Eigen::MatrixXs& {
+            return self->getMassMatrix();
+          },
+          ::py::return_value_policy::reference_internal,
+          "Same as :code:`getMassMatrix()`, but returns a read-only view onto "
+          "the Skeleton's cache instead of a copy. The view holds the values "
+          "from this call, and is only refreshed by calling this again after "
+          "changing the state. It must not be used after the number of DOFs "
+          "changes, or once the Skeleton is gone.")
       .def(
           "getAugMassMatrix",
           +[](const dart::dynamics::Skeleton* self,
@@ -1601,6 +1696,15 @@ void Skeleton(
           +[](dart::dynamics::Skeleton* self) -> const Eigen::VectorXs& {
             return self->getCoriolisAndGravityForces();
           })
+      .def(
+          "getCoriolisAndGravityForcesView",
+          +[](dart::dynamics::Skeleton* self) -> const Eigen::VectorXs& {
+            return self->getCoriolisAndGravityForces();
+          },
+          ::py::return_value_policy::reference_internal,
+          "Same as :code:`getCoriolisAndGravityForces()`, but returns a "
+          "read-only view onto the Skeleton's cache instead of a copy, with "
+          "the same lifetime rules as :code:`getMassMatrixView()`.")
       .def(
           "getExternalForces",
           +[](dart::dynamics::Skeleton* self,
@@ -62,6 +62,9 @@ void MultivariateGaussian(py::module& m)
       .def(
           "getLogNormalizationConstant",
           &dart::math::MultivariateGaussian::getLogNormalizationConstant)
+      .def(
+          "getLogDeterminant",
+          &dart::math::MultivariateGaussian::getLogDeterminant)
       .def(
           "getMean",
           &dart::math::MultivariateGaussian::getMean,
@@ -87,6 +90,15 @@ void MultivariateGaussian(py::module& m)
           "computeLogPDFGrad",
           &dart::math::MultivariateGaussian::computeLogPDFGrad,
           ::py::arg("x"))
+      .def(
+          "computeLogPDFBatch",
+          &dart::math::MultivariateGaussian::computeLogPDFBatch,
+          ::py::arg("xs"),
+          ::py::arg("normalized") = true)
+      .def(
+          "computeLogPDFGradBatch",
+          &dart::math::MultivariateGaussian::computeLogPDFGradBatch,
+          ::py::arg("xs"))
       .def(
           "getVariableNameAtIndex",
           &dart::math::MultivariateGaussian::getVariableNameAtIndex,
@@ -48,7 +48,22 @@ void PerformanceLog(py::module& m)
       .def(
           "prettyPrint",
           &dart::performance::FinalizedPerformanceLog::prettyPrint)
-      .def("toJson", &dart::performance::FinalizedPerformanceLog::toJson);
+      .def("toJson", &dart::performance::FinalizedPerformanceLog::toJson)
+      .def(
+          "getTotalAllocations",
+          &dart::performance::FinalizedPerformanceLog::getTotalAllocations)
+      .def(
+          "getTotalAllocatedBytes",
+          &dart::performance::FinalizedPerformanceLog::getTotalAllocatedBytes)
+      .def(
+          "getTotalInstructions",
+          &dart::performance::FinalizedPerformanceLog::getTotalInstructions)
+      .def(
+          "getTotalCacheMisses",
+          &dart::performance::FinalizedPerformanceLog::getTotalCacheMisses)
+      .def(
+          "getTotalBranchMisses",
+          &dart::performance::FinalizedPerformanceLog::getTotalBranchMisses);
 
   ::py::class_<dart::performance::PerformanceLog>(m, "PerformanceLog")
       .def(
@@ -58,7 +73,13 @@ void PerformanceLog(py::module& m)
                   std::string,
                   std::shared_ptr<dart::performance::FinalizedPerformanceLog>> {
             return self->finalize();
-          });
+          })
+      .def_static(
+          "toChromeTrace", &dart::performance::PerformanceLog::toChromeTrace)
+      .def_static(
+          "writeChromeTrace",
+          &dart::performance::PerformanceLog::writeChromeTrace,
+          ::py::arg("path"));
 }
 
 } // namespace python
@@ -40,6 +40,7 @@ namespace dart {
 namespace python {
 
 void PerformanceLog(py::module& sm);
+void SamplingProfiler(py::module& sm);
 
 void dart_performance(py::module& m)
 {
@@ -50,6 +51,7 @@ void dart_performance(py::module& m)
         "optimization work.";
 
   PerformanceLog(sm);
+  SamplingProfiler(sm);
 }
 
 } // namespace python
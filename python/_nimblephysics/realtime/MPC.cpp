@@ -46,11 +46,31 @@ namespace python {
 
 void MPC(py::module& m)
 {
+  ::py::class_<dart::realtime::ControlReadStats>(m, "ControlReadStats")
+      .def_readonly("numReads", &dart::realtime::ControlReadStats::numReads)
+      .def_readonly(
+          "numRetries", &dart::realtime::ControlReadStats::numRetries)
+      .def_readonly(
+          "numPlanUnderruns",
+          &dart::realtime::ControlReadStats::numPlanUnderruns)
+      .def_readonly(
+          "maxReadNanos", &dart::realtime::ControlReadStats::maxReadNanos)
+      .def_readonly(
+          "meanReadNanos", &dart::realtime::ControlReadStats::meanReadNanos)
+      .def_readonly(
+          "maxJitterMillis",
+          &dart::realtime::ControlReadStats::maxJitterMillis)
+      .def_readonly(
+          "meanJitterMillis",
+          &dart::realtime::ControlReadStats::meanJitterMillis);
+
   ::py::class_<dart::realtime::MPC, std::shared_ptr<dart::realtime::MPC>>(
       m, "MPC")
       .def(
           "getRemainingPlanBufferMillis",
           &dart::realtime::MPC::getRemainingPlanBufferMillis)
+      .def(
+          "getControlReadStats", &dart::realtime::MPC::getControlReadStats)
       .def(
           "recordGroundTruthState",
           &dart::realtime::MPC::recordGroundTruthState,
@@ -85,10 +85,15 @@ void MPCLocal(py::module& m)
           "setEnableOptimizationGuards",
           &dart::realtime::MPCLocal::setEnableOptimizationGuards,
           ::py::arg("enabled"))
+      .def(
+          "setEnableWarmStart",
+          &dart::realtime::MPCLocal::setEnableWarmStart,
+          ::py::arg("enabled"))
       .def(
           "setRecordIterations",
           &dart::realtime::MPCLocal::setRecordIterations,
-          ::py::arg("enabled"))
+          ::py::arg("enabled"),
+          ::py::arg("historyLength") = 100)
       .def("getMaxIterations", &dart::realtime::MPCLocal::getMaxIterations)
       .def(
           "setMaxIterations",
@@ -47,6 +47,10 @@ namespace python {
 
 void MPCRemote(py::module& m)
 {
+  ::py::enum_<dart::realtime::MPCTransport>(m, "MPCTransport")
+      .value("GRPC", dart::realtime::MPCTransport::GRPC)
+      .value("SHARED_MEMORY", dart::realtime::MPCTransport::SHARED_MEMORY);
+
   ::py::class_<
       dart::realtime::MPCRemote,
       dart::realtime::MPC,
@@ -59,9 +63,13 @@ void MPCRemote(py::module& m)
           ::py::arg("steps"),
           ::py::arg("millisPerStep"))
       .def(
-          ::py::init<dart::realtime::MPCLocal&, int>(),
+          ::py::init<
+              dart::realtime::MPCLocal&,
+              int,
+              dart::realtime::MPCTransport>(),
           ::py::arg("local"),
-          ::py::arg("ignored") = 0)
+          ::py::arg("ignored") = 0,
+          ::py::arg("transport") = dart::realtime::MPCTransport::GRPC)
       .def(
           "getRemainingPlanBufferMillis",
           &dart::realtime::MPCRemote::getRemainingPlanBufferMillis)
@@ -79,6 +87,15 @@ void MPCRemote(py::module& m)
           ::py::arg("vel"),
           ::py::arg("mass"))
       .def("getControlForce", &dart::realtime::MPCRemote::getControlForce, ::py::arg("now"))
+      .def(
+          "recordObservedForce",
+          &dart::realtime::MPCRemote::recordObservedForce,
+          ::py::arg("time"),
+          ::py::arg("force"))
+      .def(
+          "setUseStreaming",
+          &dart::realtime::MPCRemote::setUseStreaming,
+          ::py::arg("useStreaming"))
       .def(
           "start",
           &dart::realtime::MPCRemote::start,
@@ -38,6 +38,7 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -101,6 +102,14 @@ void SSID(py::module& m)
           "runInference",
           &dart::realtime::SSID::runInference,
           ::py::arg("startTime"))
+      .def(
+          "setNumThreads",
+          &dart::realtime::SSID::setNumThreads,
+          ::py::arg("numThreads"))
+      .def(
+          "setMassHypotheses",
+          &dart::realtime::SSID::setMassHypotheses,
+          ::py::arg("hypotheses"))
       .def(
           "registerInferListener",
           &dart::realtime::SSID::registerInferListener,
@@ -4,6 +4,7 @@
 #include <dart/realtime/Ticker.hpp>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -12,6 +13,20 @@ namespace python {
 
 void Ticker(py::module& m)
 {
+  ::py::class_<dart::realtime::TickLatenessStats>(m, "TickLatenessStats")
+      .def_readonly("numTicks", &dart::realtime::TickLatenessStats::numTicks)
+      .def_readonly(
+          "numMissedTicks", &dart::realtime::TickLatenessStats::numMissedTicks)
+      .def_readonly(
+          "maxLatenessNanos",
+          &dart::realtime::TickLatenessStats::maxLatenessNanos)
+      .def_readonly(
+          "meanLatenessNanos",
+          &dart::realtime::TickLatenessStats::meanLatenessNanos)
+      .def_readonly(
+          "latenessHistogram",
+          &dart::realtime::TickLatenessStats::latenessHistogram);
+
   ::py::class_<dart::realtime::Ticker, std::shared_ptr<dart::realtime::Ticker>>(
       m, "Ticker")
       .def(::py::init<s_t>(), ::py::arg("secondsPerTick"))
@@ -55,7 +70,29 @@ void Ticker(py::module& m)
           &dart::realtime::Ticker::start,
           ::py::call_guard<py::gil_scoped_release>())
       .def("stop", &dart::realtime::Ticker::stop)
-      .def("clear", &dart::realtime::Ticker::clear);
+      .def("clear", &dart::realtime::Ticker::clear)
+      .def(
+          "setHighPrecision",
+          &dart::realtime::Ticker::setHighPrecision,
+          ::py::arg("highPrecision"))
+      .def(
+          "setSpinMicros",
+          &dart::realtime::Ticker::setSpinMicros,
+          ::py::arg("spinMicros"))
+      .def(
+          "setCpuAffinity",
+          &dart::realtime::Ticker::setCpuAffinity,
+          ::py::arg("cpu"))
+      .def(
+          "setRealtimePriority",
+          &dart::realtime::Ticker::setRealtimePriority,
+          ::py::arg("priority"))
+      .def(
+          "getTickLatenessStats",
+          &dart::realtime::Ticker::getTickLatenessStats)
+      .def(
+          "resetTickLatenessStats",
+          &dart::realtime::Ticker::resetTickLatenessStats);
 }
 
 } // namespace python
@@ -69,6 +69,22 @@ void GUIRecording(py::module& m)
           "writeFrameJson",
           &dart::server::GUIRecording::writeFrameJson,
           ::py::arg("path"),
+          ::py::arg("frame"))
+      .def(
+          "setKeyframeInterval",
+          &dart::server::GUIRecording::setKeyframeInterval,
+          ::py::arg("frames"))
+      .def(
+          "writeFramesChunked",
+          &dart::server::GUIRecording::writeFramesChunked,
+          ::py::arg("path"))
+      .def_static(
+          "readChunkedFrame",
+          [](const std::string& path, int frame) {
+            return ::py::bytes(
+                dart::server::GUIRecording::readChunkedFrame(path, frame));
+          },
+          ::py::arg("path"),
           ::py::arg("frame"));
 }
 
@@ -145,6 +145,24 @@ void GUIStateMachine(py::module& m)
           &dart::server::GUIStateMachine::setObjectScale,
           ::py::arg("key"),
           ::py::arg("scale"))
+      .def(
+          "setInitialMeshLevelOfDetail",
+          &dart::server::GUIStateMachine::setInitialMeshLevelOfDetail,
+          ::py::arg("level"))
+      .def(
+          "setMeshLevelOfDetail",
+          &dart::server::GUIStateMachine::setMeshLevelOfDetail,
+          ::py::arg("key"),
+          ::py::arg("level"))
+      .def(
+          "getMeshLevelOfDetail",
+          &dart::server::GUIStateMachine::getMeshLevelOfDetail,
+          ::py::arg("key"))
+      .def(
+          "setMeshScreenSize",
+          &dart::server::GUIStateMachine::setMeshScreenSize,
+          ::py::arg("key"),
+          ::py::arg("pixels"))
       .def(
           "setObjectTooltip",
           &dart::server::GUIStateMachine::setObjectTooltip,
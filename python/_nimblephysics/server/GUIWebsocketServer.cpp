@@ -45,6 +45,13 @@ namespace python {
 
 void GUIWebsocketServer(py::module& m)
 {
+  ::py::class_<WebsocketServer::ConnectionStats>(m, "ConnectionStats")
+      .def_readonly(
+          "bufferedBytes", &WebsocketServer::ConnectionStats::bufferedBytes)
+      .def_readonly(
+          "droppedFrames", &WebsocketServer::ConnectionStats::droppedFrames)
+      .def_readonly("lagging", &WebsocketServer::ConnectionStats::lagging);
+
   ::py::class_<
       dart::server::GUIWebsocketServer,
       dart::server::GUIStateMachine,
@@ -73,6 +80,16 @@ void GUIWebsocketServer(py::module& m)
           },
           ::py::call_guard<py::gil_scoped_release>())
       .def("isServing", &dart::server::GUIWebsocketServer::isServing)
+      .def(
+          "serveScene",
+          &dart::server::GUIWebsocketServer::serveScene,
+          ::py::arg("path"),
+          ::py::arg("scene"))
+      .def(
+          "stopServingScene",
+          &dart::server::GUIWebsocketServer::stopServingScene,
+          ::py::arg("path"))
+      .def("getScenePaths", &dart::server::GUIWebsocketServer::getScenePaths)
       .def("getScreenSize", &dart::server::GUIWebsocketServer::getScreenSize)
       .def("getKeysDown", &dart::server::GUIWebsocketServer::getKeysDown)
       .def(
@@ -81,6 +98,13 @@ void GUIWebsocketServer(py::module& m)
           ::py::arg("key"))
       .def("clear", &dart::server::GUIWebsocketServer::clear)
       .def("flush", &dart::server::GUIWebsocketServer::flush)
+      .def(
+          "setMaxBufferedBytesPerClient",
+          &dart::server::GUIWebsocketServer::setMaxBufferedBytesPerClient,
+          ::py::arg("maxBufferedBytes"))
+      .def(
+          "getConnectionStats",
+          &dart::server::GUIWebsocketServer::getConnectionStats)
       .def(
           "registerConnectionListener",
           &dart::server::GUIWebsocketServer::registerConnectionListener,
@@ -66,52 +66,62 @@ void BackpropSnapshot(py::module& m)
           ::py::arg("thisTimestepLoss"),
           ::py::arg("nextTimestepLoss"),
           ::py::arg("perfLog") = nullptr,
-          ::py::arg("exploreAlternateStrategies") = false)
+          ::py::arg("exploreAlternateStrategies") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "backpropState",
           &dart::neural::BackpropSnapshot::backpropState,
           ::py::arg("world"),
           ::py::arg("nextTimestepStateLossGrad"),
           ::py::arg("perfLog") = nullptr,
-          ::py::arg("exploreAlternateStrategies") = false)
+          ::py::arg("exploreAlternateStrategies") = false,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelVelJacobian",
           &dart::neural::BackpropSnapshot::getVelVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getControlForceVelJacobian",
           &dart::neural::BackpropSnapshot::getControlForceVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosPosJacobian",
           &dart::neural::BackpropSnapshot::getPosPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getVelPosJacobian",
           &dart::neural::BackpropSnapshot::getVelPosJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPosVelJacobian",
           &dart::neural::BackpropSnapshot::getPosVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getMassVelJacobian",
           &dart::neural::BackpropSnapshot::getMassVelJacobian,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getStateJacobian",
           &dart::neural::BackpropSnapshot::getStateJacobian,
-          ::py::arg("world"))
+          ::py::arg("world"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getActionJacobian",
           &dart::neural::BackpropSnapshot::getActionJacobian,
-          ::py::arg("world"))
+          ::py::arg("world"),
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getPreStepPosition",
           &dart::neural::BackpropSnapshot::getPreStepPosition)
@@ -137,29 +147,34 @@ void BackpropSnapshot(py::module& m)
           "finiteDifferenceVelVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelVelJacobian,
           ::py::arg("world"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceForceVelJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceForceVelJacobian,
           ::py::arg("world"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferencePosPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferencePosPosJacobian,
           ::py::arg("world"),
           ::py::arg("subdivisions"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "finiteDifferenceVelPosJacobian",
           &dart::neural::BackpropSnapshot::finiteDifferenceVelPosJacobian,
           ::py::arg("world"),
           ::py::arg("subdivisions"),
-          ::py::arg("useRidders") = true)
+          ::py::arg("useRidders") = true,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "benchmarkJacobians",
           &dart::neural::BackpropSnapshot::benchmarkJacobians,
           ::py::arg("world"),
-          ::py::arg("numSamples"));
+          ::py::arg("numSamples"),
+          ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
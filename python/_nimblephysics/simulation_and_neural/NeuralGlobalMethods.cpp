@@ -50,13 +50,15 @@ void NeuralGlobalMethods(py::module& m)
       "forwardPass",
       &dart::neural::forwardPass,
       ::py::arg("world"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "mappedForwardPass",
       &dart::neural::mappedForwardPass,
       ::py::arg("world"),
       ::py::arg("mappings"),
-      ::py::arg("idempotent") = false);
+      ::py::arg("idempotent") = false,
+      ::py::call_guard<py::gil_scoped_release>());
   m.def(
       "convertJointSpaceToWorldSpace",
       &dart::neural::convertJointSpaceToWorldSpace,
@@ -67,7 +69,8 @@ void NeuralGlobalMethods(py::module& m)
       ::py::arg("backprop") = false,
       ::py::arg("useIK") = true,
       "Convert a set of joint positions to a vector of body positions in world "
-      "space (expressed in log space).");
+      "space (expressed in log space).",
+      ::py::call_guard<py::gil_scoped_release>());
 }
 
 } // namespace python
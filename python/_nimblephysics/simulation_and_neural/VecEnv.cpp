@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <dart/neural/VecEnv.hpp>
+#include <dart/neural/WorldBatch.hpp>
+#include <dart/simulation/World.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void VecEnv(py::module& m)
+{
+  ::py::class_<
+      dart::neural::VecEnv,
+      std::shared_ptr<dart::neural::VecEnv>,
+      dart::neural::WorldBatch>(m, "VecEnv")
+      .def(
+          ::py::init<std::shared_ptr<simulation::World>, int, int>(),
+          ::py::arg("world"),
+          ::py::arg("numEnvs"),
+          ::py::arg("numThreads") = -1)
+      .def("getNumEnvs", &dart::neural::VecEnv::getNumEnvs)
+      .def(
+          "setResetStates",
+          &dart::neural::VecEnv::setResetStates,
+          ::py::arg("states"))
+      .def(
+          "setMaxEpisodeSteps",
+          &dart::neural::VecEnv::setMaxEpisodeSteps,
+          ::py::arg("maxEpisodeSteps"))
+      .def(
+          "setStateBounds",
+          &dart::neural::VecEnv::setStateBounds,
+          ::py::arg("lower"),
+          ::py::arg("upper"))
+      .def(
+          "setDoneFn",
+          &dart::neural::VecEnv::setDoneFn,
+          ::py::arg("fn"))
+      .def(
+          "reset",
+          &dart::neural::VecEnv::reset,
+          ::py::arg("observations").noconvert())
+      .def(
+          "step",
+          &dart::neural::VecEnv::step,
+          ::py::arg("actions"),
+          ::py::arg("observations").noconvert(),
+          ::py::arg("dones").noconvert(),
+          ::py::call_guard<::py::gil_scoped_release>())
+      .def(
+          "getTerminalObservations",
+          &dart::neural::VecEnv::getTerminalObservations,
+          ::py::return_value_policy::copy)
+      .def(
+          "getEpisodeSteps",
+          &dart::neural::VecEnv::getEpisodeSteps,
+          ::py::return_value_policy::copy);
+}
+
+} // namespace python
+} // namespace dart
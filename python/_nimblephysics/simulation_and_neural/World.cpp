@@ -52,7 +52,23 @@ void World(
         dart::simulation::World,
         std::shared_ptr<dart::simulation::World>>& world)
 {
-  (void)m;
+  ::py::class_<dart::simulation::StepTimings>(m, "StepTimings")
+      .def_readonly("numSteps", &dart::simulation::StepTimings::numSteps)
+      .def_readonly("totalNs", &dart::simulation::StepTimings::totalNs)
+      .def_readonly(
+          "collisionDetectionNs",
+          &dart::simulation::StepTimings::collisionDetectionNs)
+      .def_readonly(
+          "lcpConstructionNs",
+          &dart::simulation::StepTimings::lcpConstructionNs)
+      .def_readonly("lcpSolveNs", &dart::simulation::StepTimings::lcpSolveNs)
+      .def_readonly(
+          "velocityIntegrationNs",
+          &dart::simulation::StepTimings::velocityIntegrationNs)
+      .def_readonly(
+          "positionIntegrationNs",
+          &dart::simulation::StepTimings::positionIntegrationNs);
+
   world.def(::py::init<>())
       .def(::py::init<const std::string&>(), ::py::arg("name"))
       .def(::py::init(+[]() -> dart::simulation::WorldPtr {
@@ -68,6 +84,21 @@ void World(
               -> std::shared_ptr<dart::simulation::World> {
             return self->clone();
           })
+      .def(
+          "fork",
+          +[](const dart::simulation::World* self,
+              std::shared_ptr<dart::simulation::World> recycled)
+              -> std::shared_ptr<dart::simulation::World> {
+            return self->fork(recycled);
+          },
+          ::py::arg("recycled") = nullptr)
+      .def(
+          "copyStateInto",
+          +[](const dart::simulation::World* self,
+              dart::simulation::World* target) -> bool {
+            return self->copyStateInto(*target);
+          },
+          ::py::arg("target"))
       .def(
           "setName",
           +[](dart::simulation::World* self, const std::string& _newName)
@@ -255,13 +286,17 @@ void World(
           +[](dart::simulation::World* self) -> void { return self->reset(); })
       .def(
           "step",
-          +[](dart::simulation::World* self) -> void { return self->step(); })
+          +[](dart::simulation::World* self) -> void { return self->step(); },
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "step",
           +[](dart::simulation::World* self, bool _resetCommand) -> void {
             return self->step(_resetCommand);
           },
-          ::py::arg("resetCommand"))
+          ::py::arg("resetCommand"),
+          ::py::call_guard<py::gil_scoped_release>())
+      .def("getStepTimings", &dart::simulation::World::getStepTimings)
+      .def("resetStepTimings", &dart::simulation::World::resetStepTimings)
       .def(
           "integratePositions",
           +[](dart::simulation::World* self, Eigen::VectorXs initialVelocity)
@@ -335,6 +370,34 @@ void World(
           +[](dart::simulation::World* self) -> Eigen::VectorXs {
             return self->getVelocities();
           })
+      .def(
+          "getPositionsInto",
+          &dart::simulation::World::getPositionsInto,
+          ::py::arg("out"),
+          "Writes the positions into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getVelocitiesInto",
+          &dart::simulation::World::getVelocitiesInto,
+          ::py::arg("out"),
+          "Writes the velocities into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getAccelerationsInto",
+          &dart::simulation::World::getAccelerationsInto,
+          ::py::arg("out"),
+          "Writes the accelerations into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
+      .def(
+          "getControlForcesInto",
+          &dart::simulation::World::getControlForcesInto,
+          ::py::arg("out"),
+          "Writes the control forces into :code:`out`, a writeable contiguous "
+          "float64 array of :code:`getNumDofs()` entries, instead of "
+          "allocating a new array.")
       .def(
           "getControlForces",
           +[](dart::simulation::World* self) -> Eigen::VectorXs {
@@ -453,6 +516,24 @@ void World(
           +[](dart::simulation::World* self) -> Eigen::MatrixXs {
             return self->getInvMassMatrix();
           })
+      .def(
+          "getSparseMassMatrix",
+          +[](dart::simulation::World* self) -> Eigen::SparseMatrix<s_t> {
+            return self->getSparseMassMatrix();
+          })
+      .def(
+          "getSparseInvMassMatrix",
+          +[](dart::simulation::World* self) -> Eigen::SparseMatrix<s_t> {
+            return self->getSparseInvMassMatrix();
+          })
+      .def(
+          "multiplyByImplicitMassMatrix",
+          &dart::simulation::World::multiplyByImplicitMassMatrix,
+          ::py::arg("x"))
+      .def(
+          "multiplyByImplicitInvMassMatrix",
+          &dart::simulation::World::multiplyByImplicitInvMassMatrix,
+          ::py::arg("x"))
       .def(
           "getParallelVelocityAndPositionUpdates",
           &dart::simulation::World::getParallelVelocityAndPositionUpdates)
@@ -460,6 +541,31 @@ void World(
           "setParallelVelocityAndPositionUpdates",
           &dart::simulation::World::setParallelVelocityAndPositionUpdates,
           ::py::arg("enabled"))
+      .def(
+          "getParallelSkeletonUpdatesEnabled",
+          &dart::simulation::World::getParallelSkeletonUpdatesEnabled)
+      .def(
+          "setParallelSkeletonUpdatesEnabled",
+          &dart::simulation::World::setParallelSkeletonUpdatesEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getSleepingEnabled", &dart::simulation::World::getSleepingEnabled)
+      .def(
+          "setSleepingEnabled",
+          &dart::simulation::World::setSleepingEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getSleepVelocityThreshold",
+          &dart::simulation::World::getSleepVelocityThreshold)
+      .def(
+          "setSleepVelocityThreshold",
+          &dart::simulation::World::setSleepVelocityThreshold,
+          ::py::arg("threshold"))
+      .def("getSleepSteps", &dart::simulation::World::getSleepSteps)
+      .def(
+          "setSleepSteps",
+          &dart::simulation::World::setSleepSteps,
+          ::py::arg("steps"))
       .def(
           "getPenetrationCorrectionEnabled",
           &dart::simulation::World::getPenetrationCorrectionEnabled)
@@ -470,6 +576,41 @@ void World(
       .def(
           "getContactClippingDepth",
           &dart::simulation::World::getContactClippingDepth)
+      .def(
+          "getMaxNumContactsPerPair",
+          &dart::simulation::World::getMaxNumContactsPerPair)
+      .def(
+          "setMaxNumContactsPerPair",
+          &dart::simulation::World::setMaxNumContactsPerPair,
+          ::py::arg("maxNumContacts"))
+      .def(
+          "getContinuousCollisionEnabled",
+          &dart::simulation::World::getContinuousCollisionEnabled)
+      .def(
+          "setContinuousCollisionEnabled",
+          &dart::simulation::World::setContinuousCollisionEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getCompliantContactEnabled",
+          &dart::simulation::World::getCompliantContactEnabled)
+      .def(
+          "setCompliantContactEnabled",
+          &dart::simulation::World::setCompliantContactEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getCompliantContactStiffness",
+          &dart::simulation::World::getCompliantContactStiffness)
+      .def(
+          "setCompliantContactStiffness",
+          &dart::simulation::World::setCompliantContactStiffness,
+          ::py::arg("stiffness"))
+      .def(
+          "getCompliantContactDamping",
+          &dart::simulation::World::getCompliantContactDamping)
+      .def(
+          "setCompliantContactDamping",
+          &dart::simulation::World::setCompliantContactDamping,
+          ::py::arg("damping"))
       .def(
           "getFallbackConstraintForceMixingConstant",
           &dart::simulation::World::getFallbackConstraintForceMixingConstant)
@@ -479,13 +620,46 @@ void World(
           ::py::arg("constant") = 1e-3)
       .def("getWrtMass", &dart::simulation::World::getWrtMass)
       .def("toJson", &dart::simulation::World::toJson)
-      .def("positionsToJson", &dart::simulation::World::positionsToJson)
-      .def("colorsToJson", &dart::simulation::World::colorsToJson)
+      .def(
+          "positionsToJson",
+          +[](dart::simulation::World* self) -> std::string {
+            return self->positionsToJson();
+          })
+      .def(
+          "positionsToJson",
+          +[](dart::simulation::World* self, s_t epsilon) -> std::string {
+            return self->positionsToJson(epsilon);
+          },
+          ::py::arg("epsilon"))
+      .def(
+          "colorsToJson",
+          +[](dart::simulation::World* self) -> std::string {
+            return self->colorsToJson();
+          })
+      .def(
+          "colorsToJson",
+          +[](dart::simulation::World* self, s_t epsilon) -> std::string {
+            return self->colorsToJson(epsilon);
+          },
+          ::py::arg("epsilon"))
+      .def("resetJsonDiffs", &dart::simulation::World::resetJsonDiffs)
       .def(
           "setUseFDOverride",
           &dart::simulation::World::setUseFDOverride,
           ::py::arg("useFDOverride"))
       .def("getUseFDOverride", &dart::simulation::World::getUseFDOverride)
+      .def(
+          "setSnapshotPoolEnabled",
+          &dart::simulation::World::setSnapshotPoolEnabled,
+          ::py::arg("enabled"))
+      .def(
+          "getSnapshotPoolEnabled",
+          &dart::simulation::World::getSnapshotPoolEnabled)
+      .def(
+          "setNumFDThreads",
+          &dart::simulation::World::setNumFDThreads,
+          ::py::arg("numThreads"))
+      .def("getNumFDThreads", &dart::simulation::World::getNumFDThreads)
       .def(
           "getCachedLCPSolution",
           &dart::simulation::World::getCachedLCPSolution)
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <dart/neural/BackpropSnapshot.hpp>
+#include <dart/neural/WorldBatch.hpp>
+#include <dart/simulation/World.hpp>
+#include <pybind11/eigen.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+namespace dart {
+namespace python {
+
+void WorldBatch(py::module& m)
+{
+  ::py::class_<
+      dart::neural::BatchSnapshot,
+      std::shared_ptr<dart::neural::BatchSnapshot>>(m, "BatchSnapshot")
+      .def_readonly("nextStates", &dart::neural::BatchSnapshot::nextStates);
+
+  ::py::class_<dart::neural::BatchLossGradient>(m, "BatchLossGradient")
+      .def_readonly(
+          "lossWrtStates", &dart::neural::BatchLossGradient::lossWrtStates)
+      .def_readonly(
+          "lossWrtActions", &dart::neural::BatchLossGradient::lossWrtActions);
+
+  ::py::class_<
+      dart::neural::WorldBatch,
+      std::shared_ptr<dart::neural::WorldBatch>>(m, "WorldBatch")
+      .def(
+          ::py::init<std::shared_ptr<simulation::World>, int, int>(),
+          ::py::arg("world"),
+          ::py::arg("batchSize"),
+          ::py::arg("numThreads") = -1)
+      .def("getBatchSize", &dart::neural::WorldBatch::getBatchSize)
+      .def("getNumThreads", &dart::neural::WorldBatch::getNumThreads)
+      .def(
+          "setNumThreads",
+          &dart::neural::WorldBatch::setNumThreads,
+          ::py::arg("numThreads"))
+      .def("getStateSize", &dart::neural::WorldBatch::getStateSize)
+      .def("getActionSize", &dart::neural::WorldBatch::getActionSize)
+      .def(
+          "getWorld", &dart::neural::WorldBatch::getWorld, ::py::arg("index"))
+      .def("getStates", &dart::neural::WorldBatch::getStates)
+      .def(
+          "setStates",
+          &dart::neural::WorldBatch::setStates,
+          ::py::arg("states"))
+      .def(
+          "forwardPass",
+          &dart::neural::WorldBatch::forwardPass,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<::py::gil_scoped_release>())
+      .def(
+          "timestep",
+          &dart::neural::WorldBatch::timestep,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::arg("idempotent") = false,
+          ::py::call_guard<::py::gil_scoped_release>())
+      .def(
+          "backprop",
+          &dart::neural::WorldBatch::backprop,
+          ::py::arg("snapshot"),
+          ::py::arg("lossWrtNextStates"),
+          ::py::call_guard<::py::gil_scoped_release>())
+      .def(
+          "step",
+          &dart::neural::WorldBatch::step,
+          ::py::arg("states"),
+          ::py::arg("actions"),
+          ::py::return_value_policy::copy,
+          ::py::call_guard<::py::gil_scoped_release>())
+      .def(
+          "getNextStates",
+          &dart::neural::WorldBatch::getNextStates,
+          ::py::return_value_policy::copy);
+}
+
+} // namespace python
+} // namespace dart
@@ -51,6 +51,8 @@ void IKMapping(py::module& sm);
 void IdentityMapping(py::module& sm);
 void BackpropSnapshot(py::module& sm);
 void MappedBackpropSnapshot(py::module& sm);
+void WorldBatch(py::module& sm);
+void VecEnv(py::module& sm);
 
 // Simulation
 void World(
@@ -80,6 +82,8 @@ void dart_simulation_and_neural(py::module& m)
   IdentityMapping(neural);
   BackpropSnapshot(neural);
   MappedBackpropSnapshot(neural);
+  WorldBatch(neural);
+  VecEnv(neural);
   NeuralGlobalMethods(neural);
 
   World(simulation, world);
@@ -96,7 +96,15 @@ void IPOptOptimizer(py::module& m)
       .def(
           "setRecordIterations",
           &dart::trajectory::IPOptOptimizer::setRecordIterations,
-          ::py::arg("recordIterations") = true);
+          ::py::arg("recordIterations") = true)
+      .def(
+          "setGaussNewtonHessian",
+          &dart::trajectory::IPOptOptimizer::setGaussNewtonHessian,
+          ::py::arg("gaussNewtonHessian") = true)
+      .def(
+          "setHistoryConfig",
+          &dart::trajectory::IPOptOptimizer::setHistoryConfig,
+          ::py::arg("config"));
   /*
   .def(
       "registerIntermediateCallback",
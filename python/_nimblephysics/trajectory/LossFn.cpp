@@ -36,6 +36,7 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 namespace py = pybind11;
 
@@ -55,6 +56,46 @@ void LossFn(py::module& m)
               dart::trajectory::TrajectoryLossFnAndGrad>(),
           ::py::arg("loss"),
           ::py::arg("lossFnAndGrad"))
+      .def_static(
+          "batched",
+          [](std::function<Eigen::VectorXs(
+                 const std::vector<const dart::trajectory::TrajectoryRollout*>&,
+                 const std::vector<dart::trajectory::TrajectoryRollout*>&)>
+                 batchLossAndGrad) {
+            // Python can't write into the `losses` vector in place, so it
+            // returns the losses instead
+            return dart::trajectory::LossFn(
+                dart::trajectory::TrajectoryBatchLossFnAndGrad(
+                    [batchLossAndGrad](
+                        const std::vector<
+                            const dart::trajectory::TrajectoryRollout*>&
+                            rollouts,
+                        Eigen::Ref<Eigen::VectorXs> losses,
+                        const std::vector<dart::trajectory::TrajectoryRollout*>&
+                            gradWrtRollouts) {
+                      losses = batchLossAndGrad(rollouts, gradWrtRollouts);
+                    }));
+          },
+          ::py::arg("lossesAndGradients"))
+      .def_static(
+          "quadraticTracking",
+          &dart::trajectory::LossFn::quadraticTracking,
+          ::py::arg("targetPoses"),
+          ::py::arg("weight") = 1.0,
+          ::py::arg("mapping") = "identity")
+      .def_static(
+          "finalState",
+          &dart::trajectory::LossFn::finalState,
+          ::py::arg("targetPos"),
+          ::py::arg("targetVel"),
+          ::py::arg("posWeight") = 1.0,
+          ::py::arg("velWeight") = 1.0,
+          ::py::arg("mapping") = "identity")
+      .def_static(
+          "controlEffort",
+          &dart::trajectory::LossFn::controlEffort,
+          ::py::arg("weight") = 1.0,
+          ::py::arg("mapping") = "identity")
       .def(
           "getLoss",
           &dart::trajectory::LossFn::getLoss,
@@ -66,6 +107,12 @@ void LossFn(py::module& m)
           ::py::arg("rollout"),
           ::py::arg("gradWrtRollout"),
           ::py::arg("perfLog") = nullptr)
+      .def(
+          "getLossesAndGradients",
+          &dart::trajectory::LossFn::getLossesAndGradients,
+          ::py::arg("rollouts"),
+          ::py::arg("gradWrtRollouts"),
+          ::py::arg("perfLog") = nullptr)
       .def(
           "setUpperBound",
           &dart::trajectory::LossFn::setUpperBound,
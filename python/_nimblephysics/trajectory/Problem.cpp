@@ -280,7 +280,8 @@ void Problem(py::module& m)
           "getFinalState",
           &dart::trajectory::Problem::getFinalState,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def("getNumSteps", &dart::trajectory::Problem::getNumSteps)
       .def(
           "getFlatDimName",
@@ -291,14 +292,16 @@ void Problem(py::module& m)
           "getLoss",
           &dart::trajectory::Problem::getLoss,
           ::py::arg("world"),
-          ::py::arg("perfLog") = nullptr)
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "getRolloutCache",
           &dart::trajectory::Problem::getRolloutCache,
           ::py::arg("world"),
           ::py::arg("perfLog") = nullptr,
           ::py::arg("useKnots") = true,
-          ::py::return_value_policy::reference)
+          ::py::return_value_policy::reference,
+          ::py::call_guard<py::gil_scoped_release>())
       .def(
           "setStates",
           &dart::trajectory::Problem::setStates,
@@ -315,7 +318,8 @@ void Problem(py::module& m)
           &dart::trajectory::Problem::updateWithForces,
           ::py::arg("world"),
           ::py::arg("forces"),
-          ::py::arg("perfLog") = nullptr);
+          ::py::arg("perfLog") = nullptr,
+          ::py::call_guard<py::gil_scoped_release>());
   /*
 .def(
   "getRepresentation",
@@ -355,27 +359,32 @@ void Problem(py::module& m)
   "computeConstraints",
   &dart::trajectory::Problem::computeConstraints,
   ::py::arg("world"),
-  ::py::arg("constraints"))
+  ::py::arg("constraints"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "backpropJacobian",
   &dart::trajectory::Problem::backpropJacobian,
   ::py::arg("world"),
-  ::py::arg("jac"))
+  ::py::arg("jac"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "backpropGradient",
   &dart::trajectory::Problem::backpropGradient,
   ::py::arg("world"),
-  ::py::arg("grad"))
+  ::py::arg("grad"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "getLoss",
   &dart::trajectory::Problem::getLoss,
-  ::py::arg("world"))
+  ::py::arg("world"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "backpropGradientWrt",
   &dart::trajectory::Problem::backpropGradientWrt,
   ::py::arg("world"),
   ::py::arg("gradWrtRollout"),
-  ::py::arg("grad"))
+  ::py::arg("grad"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "getStates",
   &dart::trajectory::Problem::getStates,
@@ -387,7 +396,8 @@ void Problem(py::module& m)
   "getGradientWrtRolloutCache",
   &dart::trajectory::Problem::getGradientWrtRolloutCache,
   ::py::arg("world"),
-  ::py::arg("useKnots") = true)
+  ::py::arg("useKnots") = true,
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "getNumberNonZeroJacobian",
   &dart::trajectory::Problem::getNumberNonZeroJacobian)
@@ -399,26 +409,31 @@ void Problem(py::module& m)
 .def(
   "getSparseJacobian",
   &dart::trajectory::Problem::getSparseJacobian,
-  ::py::arg("sparse"))
+  ::py::arg("sparse"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "finiteDifferenceJacobian",
   &dart::trajectory::Problem::finiteDifferenceJacobian,
   ::py::arg("world"),
-  ::py::arg("jac"))
+  ::py::arg("jac"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "finiteDifferenceGradient",
   &dart::trajectory::Problem::finiteDifferenceGradient,
   ::py::arg("world"),
-  ::py::arg("grad"))
+  ::py::arg("grad"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "backpropStartStateJacobians",
   &dart::trajectory::Problem::backpropStartStateJacobians,
-  ::py::arg("world"))
+  ::py::arg("world"),
+  ::py::call_guard<py::gil_scoped_release>())
 .def(
   "finiteDifferenceStartStateJacobians",
   &dart::trajectory::Problem::finiteDifferenceStartStateJacobians,
   ::py::arg("world"),
-  ::py::arg("EPS"));
+  ::py::arg("EPS"),
+  ::py::call_guard<py::gil_scoped_release>());
   */
 }
 
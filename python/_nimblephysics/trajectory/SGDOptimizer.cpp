@@ -68,7 +68,15 @@ void SGDOptimizer(py::module& m)
       .def(
           "setLearningRate",
           &dart::trajectory::SGDOptimizer::setLearningRate,
-          ::py::arg("learningRate") = 0.1);
+          ::py::arg("learningRate") = 0.1)
+      .def(
+          "setLineSearchCandidates",
+          &dart::trajectory::SGDOptimizer::setLineSearchCandidates,
+          ::py::arg("numCandidates"))
+      .def(
+          "setNumThreads",
+          &dart::trajectory::SGDOptimizer::setNumThreads,
+          ::py::arg("numThreads"));
   /*
   .def(
       "registerIntermediateCallback",
@@ -54,7 +54,24 @@ void SingleShot(py::module& m)
           ::py::arg("world"),
           ::py::arg("loss"),
           ::py::arg("steps"),
-          ::py::arg("tuneStartingState") = false);
+          ::py::arg("tuneStartingState") = false)
+      .def(
+          "setCheckpointInterval",
+          &dart::trajectory::SingleShot::setCheckpointInterval,
+          ::py::arg("interval"))
+      .def(
+          "getCheckpointInterval",
+          &dart::trajectory::SingleShot::getCheckpointInterval)
+      .def(
+          "setParareal",
+          &dart::trajectory::SingleShot::setParareal,
+          ::py::arg("numSegments"),
+          ::py::arg("coarseStepRatio") = 10,
+          ::py::arg("tolerance") = 1e-8,
+          ::py::arg("maxIterations") = 0)
+      .def(
+          "getLastPararealIterations",
+          &dart::trajectory::SingleShot::getLastPararealIterations);
 }
 
 } // namespace python
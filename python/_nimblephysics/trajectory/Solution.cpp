@@ -32,6 +32,7 @@
 
 #include <dart/simulation/World.hpp>
 #include <dart/trajectory/Solution.hpp>
+#include <pybind11/eigen.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -50,10 +51,48 @@ void Solution(py::module& m)
           "constraintViolation",
           &dart::trajectory::OptimizationStep::constraintViolation);
 
+  ::py::class_<dart::trajectory::SolutionHistoryConfig>(
+      m, "SolutionHistoryConfig")
+      .def(::py::init<>())
+      .def_readwrite(
+          "keepLast", &dart::trajectory::SolutionHistoryConfig::keepLast)
+      .def_readwrite(
+          "keepEvery", &dart::trajectory::SolutionHistoryConfig::keepEvery)
+      .def_readwrite(
+          "recordSparseJacobians",
+          &dart::trajectory::SolutionHistoryConfig::recordSparseJacobians)
+      .def_readwrite(
+          "spillPath", &dart::trajectory::SolutionHistoryConfig::spillPath);
+
   ::py::class_<
       dart::trajectory::Solution,
-      std::shared_ptr<dart::trajectory::Solution>>(m, "Solution")
+      std::shared_ptr<dart::trajectory::Solution>>
+      solution(m, "Solution");
+
+  ::py::enum_<dart::trajectory::Solution::HistoryType>(solution, "HistoryType")
+      .value("X", dart::trajectory::Solution::HistoryType::X)
+      .value("LOSS", dart::trajectory::Solution::HistoryType::LOSS)
+      .value("GRADIENT", dart::trajectory::Solution::HistoryType::GRADIENT)
+      .value(
+          "CONSTRAINT_VALUES",
+          dart::trajectory::Solution::HistoryType::CONSTRAINT_VALUES)
+      .value(
+          "SPARSE_JACOBIAN",
+          dart::trajectory::Solution::HistoryType::SPARSE_JACOBIAN);
+
+  solution
       .def("toJson", &dart::trajectory::Solution::toJson, ::py::arg("world"))
+      .def(
+          "setHistoryConfig",
+          &dart::trajectory::Solution::setHistoryConfig,
+          ::py::arg("config"))
+      .def(
+          "getHistoryConfig", &dart::trajectory::Solution::getHistoryConfig)
+      .def_static(
+          "loadSpilledHistory",
+          &dart::trajectory::Solution::loadSpilledHistory,
+          ::py::arg("path"),
+          ::py::arg("type"))
       .def("getNumSteps", &dart::trajectory::Solution::getNumSteps)
       .def(
           "getStep",
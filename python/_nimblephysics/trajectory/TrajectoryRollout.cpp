@@ -75,6 +75,30 @@ void TrajectoryRollout(py::module& m)
           "copy",
           &dart::trajectory::TrajectoryRollout::copy,
           ::py::return_value_policy::automatic);
+
+  // The arrays passed in here must be float64 and column-major (Fortran
+  // order), or pybind11 will refuse to bind them rather than silently copy.
+  // The rollout keeps them alive, and reads and writes them in place.
+  ::py::class_<
+      dart::trajectory::TrajectoryRolloutMap,
+      dart::trajectory::TrajectoryRollout>(m, "TrajectoryRolloutMap")
+      .def(
+          ::py::init<
+              Eigen::Ref<Eigen::MatrixXs>,
+              Eigen::Ref<Eigen::MatrixXs>,
+              Eigen::Ref<Eigen::MatrixXs>,
+              Eigen::Ref<Eigen::VectorXs>,
+              const std::unordered_map<std::string, Eigen::MatrixXs>>(),
+          ::py::arg("poses"),
+          ::py::arg("vels"),
+          ::py::arg("forces"),
+          ::py::arg("masses"),
+          ::py::arg("metadata")
+          = std::unordered_map<std::string, Eigen::MatrixXs>(),
+          ::py::keep_alive<1, 2>(),
+          ::py::keep_alive<1, 3>(),
+          ::py::keep_alive<1, 4>(),
+          ::py::keep_alive<1, 5>());
 }
 
 } // namespace python
@@ -42,6 +42,7 @@ namespace python {
 void Optimizer(py::module& sm);
 void IPOptOptimizer(py::module& sm);
 void SGDOptimizer(py::module& sm);
+void ILQROptimizer(py::module& sm);
 void LossFn(py::module& sm);
 void Problem(py::module& sm);
 void MultiShot(py::module& sm);
@@ -64,6 +65,7 @@ void dart_trajectory(py::module& m)
   Optimizer(sm);
   IPOptOptimizer(sm);
   SGDOptimizer(sm);
+  ILQROptimizer(sm);
   MultiShot(sm);
   SingleShot(sm);
 }
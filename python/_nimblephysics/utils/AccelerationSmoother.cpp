@@ -52,7 +52,17 @@ void AccelerationSmoother(py::module& m)
       .def(
           "smooth",
           &dart::utils::AccelerationSmoother::smooth,
-          ::py::arg("series"))
+          ::py::arg("series"),
+          ::py::arg("numThreads") = 1)
+      .def_static(
+          "smoothWindowed",
+          &dart::utils::AccelerationSmoother::smoothWindowed,
+          ::py::arg("series"),
+          ::py::arg("smoothingWeight"),
+          ::py::arg("regularizationWeight"),
+          ::py::arg("windowSize") = 2000,
+          ::py::arg("overlap") = -1,
+          ::py::arg("numThreads") = -1)
       .def(
           "debugTimeSeries",
           &dart::utils::AccelerationSmoother::debugTimeSeries,
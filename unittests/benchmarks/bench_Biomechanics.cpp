@@ -0,0 +1,379 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <boost/filesystem.hpp>
+
+#include "dart/biomechanics/C3DLoader.hpp"
+#include "dart/biomechanics/DynamicsFitter.hpp"
+#include "dart/biomechanics/ForcePlate.hpp"
+#include "dart/biomechanics/MarkerFitter.hpp"
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/SubjectOnDisk.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+// These benchmarks time each stage of the biomechanics pipeline on short
+// windows of real data, and report throughput in frames of input per second,
+// so that numbers from stages that run on different amounts of data line up.
+// The pipeline stages are slow enough that each iteration rebuilds its inputs
+// from scratch with the timer paused, and runs exactly once.
+//
+// Kinematics runs on a generic Rajagopal 2015 model with a C3D recorded with
+// its marker set. Dynamics needs force plate data, so it runs on the Sprinter
+// model, starting from its IK results rather than from a kinematics fit, so
+// that it doesn't depend on how well kinematics happened to converge.
+
+static const char* RAJAGOPAL_OSIM
+    = "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim";
+static const char* KINEMATICS_OSIM
+    = "dart://sample/osim/welk002/unscaled_generic.osim";
+static const char* KINEMATICS_C3D = "dart://sample/osim/welk002/markers.c3d";
+static const char* DYNAMICS_OSIM
+    = "dart://sample/grf/Sprinter/Models/optimized_scale_and_markers.osim";
+static const char* DYNAMICS_C3D
+    = "dart://sample/grf/Sprinter/C3D/JA1Gait35.c3d";
+static const char* DYNAMICS_MOT
+    = "dart://sample/grf/Sprinter/IK/JA1Gait35_ik.mot";
+
+static const int NUM_KINEMATICS_FRAMES = 50;
+static const int NUM_DYNAMICS_FRAMES = 50;
+// This skips the start of the Sprinter trial, where the subject is standing
+static const int DYNAMICS_START_FRAME = 87;
+static const int NUM_BILEVEL_SAMPLES = 10;
+
+//==============================================================================
+static void setFramesPerSecond(benchmark::State& state, int numFrames)
+{
+  state.counters["frames_per_second"] = benchmark::Counter(
+      static_cast<double>(numFrames) * state.iterations(),
+      benchmark::Counter::kIsRate);
+}
+
+//==============================================================================
+static std::vector<std::map<std::string, Eigen::Vector3s>> getMarkerWindow(
+    const C3D& c3d, int start, int numFrames)
+{
+  return std::vector<std::map<std::string, Eigen::Vector3s>>(
+      c3d.markerTimesteps.begin() + start,
+      c3d.markerTimesteps.begin() + start + numFrames);
+}
+
+//==============================================================================
+static std::vector<bool> getNewClip(int numFrames)
+{
+  std::vector<bool> newClip(numFrames, false);
+  newClip[0] = true;
+  return newClip;
+}
+
+//==============================================================================
+struct KinematicsInputs
+{
+  OpenSimFile osim;
+  std::shared_ptr<MarkerFitter> fitter;
+  std::vector<std::map<std::string, Eigen::Vector3s>> markers;
+  std::vector<bool> newClip;
+};
+
+//==============================================================================
+static KinematicsInputs createKinematicsInputs()
+{
+  static const C3D c3d = C3DLoader::loadC3D(KINEMATICS_C3D);
+
+  KinematicsInputs inputs;
+  inputs.osim = OpenSimParser::parseOsim(KINEMATICS_OSIM);
+  inputs.osim.skeleton->autogroupSymmetricSuffixes();
+  inputs.osim.skeleton->setScaleGroupUniformScaling(
+      inputs.osim.skeleton->getBodyNode("hand_r"));
+
+  inputs.fitter = std::make_shared<MarkerFitter>(
+      inputs.osim.skeleton, inputs.osim.markersMap);
+  inputs.fitter->setInitialIKSatisfactoryLoss(0.05);
+  inputs.fitter->setInitialIKMaxRestarts(50);
+  inputs.fitter->setIterationLimit(100);
+  inputs.fitter->setTriadsToTracking();
+
+  inputs.markers = getMarkerWindow(c3d, 0, NUM_KINEMATICS_FRAMES);
+  inputs.newClip = getNewClip(NUM_KINEMATICS_FRAMES);
+  return inputs;
+}
+
+//==============================================================================
+struct DynamicsInputs
+{
+  OpenSimFile osim;
+  std::shared_ptr<DynamicsInitialization> init;
+  std::shared_ptr<DynamicsFitter> fitter;
+};
+
+//==============================================================================
+static DynamicsInputs createDynamicsInputs()
+{
+  static const C3D c3d = C3DLoader::loadC3D(DYNAMICS_C3D);
+
+  DynamicsInputs inputs;
+  inputs.osim = OpenSimParser::parseOsim(DYNAMICS_OSIM);
+  std::shared_ptr<dynamics::Skeleton> skel = inputs.osim.skeleton;
+  skel->autogroupSymmetricSuffixes();
+  skel->autodetectScaleGroupAxisFlips(2);
+  skel->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  OpenSimMot mot = OpenSimParser::loadMot(skel, DYNAMICS_MOT);
+  Eigen::MatrixXs poses = mot.poses.block(
+      0, DYNAMICS_START_FRAME, mot.poses.rows(), NUM_DYNAMICS_FRAMES);
+
+  std::vector<ForcePlate> forcePlates;
+  for (const ForcePlate& plate : c3d.forcePlates)
+  {
+    ForcePlate trimmed;
+    trimmed.worldOrigin = plate.worldOrigin;
+    trimmed.corners = plate.corners;
+    const int end = DYNAMICS_START_FRAME + NUM_DYNAMICS_FRAMES;
+    trimmed.centersOfPressure.assign(
+        plate.centersOfPressure.begin() + DYNAMICS_START_FRAME,
+        plate.centersOfPressure.begin() + end);
+    trimmed.forces.assign(
+        plate.forces.begin() + DYNAMICS_START_FRAME,
+        plate.forces.begin() + end);
+    trimmed.moments.assign(
+        plate.moments.begin() + DYNAMICS_START_FRAME,
+        plate.moments.begin() + end);
+    forcePlates.push_back(trimmed);
+  }
+
+  std::vector<dynamics::BodyNode*> footNodes;
+  footNodes.push_back(skel->getBodyNode("calcn_r"));
+  footNodes.push_back(skel->getBodyNode("calcn_l"));
+
+  inputs.init = DynamicsFitter::createInitialization(
+      skel,
+      inputs.osim.markersMap,
+      inputs.osim.trackingMarkers,
+      footNodes,
+      {forcePlates},
+      {poses},
+      {c3d.framesPerSecond},
+      {getMarkerWindow(c3d, DYNAMICS_START_FRAME, NUM_DYNAMICS_FRAMES)});
+
+  inputs.fitter = std::make_shared<DynamicsFitter>(
+      skel, inputs.init->grfBodyNodes, inputs.init->trackingMarkers);
+  inputs.fitter->estimateFootGroundContacts(inputs.init);
+  return inputs;
+}
+
+//==============================================================================
+static void BM_OpenSimParser_ParseOsim(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    OpenSimFile osim = OpenSimParser::parseOsim(RAJAGOPAL_OSIM);
+    benchmark::DoNotOptimize(osim.skeleton);
+  }
+}
+BENCHMARK(BM_OpenSimParser_ParseOsim)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+static void BM_C3DLoader_LoadC3D(benchmark::State& state)
+{
+  int numFrames = 0;
+  for (auto _ : state)
+  {
+    C3D c3d = C3DLoader::loadC3D(DYNAMICS_C3D);
+    numFrames = c3d.markerTimesteps.size();
+    benchmark::DoNotOptimize(c3d.markerTimesteps);
+  }
+  setFramesPerSecond(state, numFrames);
+}
+BENCHMARK(BM_C3DLoader_LoadC3D)->Unit(benchmark::kMillisecond);
+
+//==============================================================================
+static void BM_MarkerFitter_RunKinematicsPipeline(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    KinematicsInputs inputs = createKinematicsInputs();
+    state.ResumeTiming();
+
+    MarkerInitialization result = inputs.fitter->runKinematicsPipeline(
+        inputs.markers,
+        inputs.newClip,
+        InitialMarkerFitParams(),
+        NUM_BILEVEL_SAMPLES);
+    benchmark::DoNotOptimize(result.poses);
+  }
+  setFramesPerSecond(state, NUM_KINEMATICS_FRAMES);
+}
+BENCHMARK(BM_MarkerFitter_RunKinematicsPipeline)
+    ->Unit(benchmark::kSecond)
+    ->Iterations(1)
+    ->UseRealTime();
+
+//==============================================================================
+static void BM_MarkerFitter_OptimizeBilevel(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    KinematicsInputs inputs = createKinematicsInputs();
+    MarkerInitialization init = inputs.fitter->getInitialization(
+        inputs.markers, inputs.newClip, InitialMarkerFitParams());
+    inputs.fitter->findJointCenters(init, inputs.newClip, inputs.markers);
+    inputs.fitter->findAllJointAxis(init, inputs.newClip, inputs.markers);
+    inputs.fitter->computeJointConfidences(init, inputs.markers);
+    state.ResumeTiming();
+
+    std::shared_ptr<BilevelFitResult> result
+        = inputs.fitter->optimizeBilevel(
+            inputs.markers, init, NUM_BILEVEL_SAMPLES);
+    benchmark::DoNotOptimize(result);
+  }
+  setFramesPerSecond(state, NUM_KINEMATICS_FRAMES);
+}
+BENCHMARK(BM_MarkerFitter_OptimizeBilevel)
+    ->Unit(benchmark::kSecond)
+    ->Iterations(1)
+    ->UseRealTime();
+
+//==============================================================================
+static void BM_DynamicsFitter_TimeSyncAndInitializePipeline(
+    benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    DynamicsInputs inputs = createDynamicsInputs();
+    state.ResumeTiming();
+
+    bool success = inputs.fitter->timeSyncAndInitializePipeline(inputs.init);
+    benchmark::DoNotOptimize(success);
+  }
+  setFramesPerSecond(state, NUM_DYNAMICS_FRAMES);
+}
+BENCHMARK(BM_DynamicsFitter_TimeSyncAndInitializePipeline)
+    ->Unit(benchmark::kSecond)
+    ->Iterations(1)
+    ->UseRealTime();
+
+//==============================================================================
+static void BM_DynamicsFitter_RunIPOPTOptimization(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    DynamicsInputs inputs = createDynamicsInputs();
+    inputs.fitter->setIterationLimit(50);
+    inputs.fitter->setSilenceOutput(true);
+    state.ResumeTiming();
+
+    inputs.fitter->runIPOPTOptimization(
+        inputs.init,
+        DynamicsFitProblemConfig(inputs.osim.skeleton)
+            .setDefaults(true)
+            .setIncludePoses(true));
+  }
+  setFramesPerSecond(state, NUM_DYNAMICS_FRAMES);
+}
+BENCHMARK(BM_DynamicsFitter_RunIPOPTOptimization)
+    ->Unit(benchmark::kSecond)
+    ->Iterations(1)
+    ->UseRealTime();
+
+//==============================================================================
+/// This writes the Sprinter window out as a subject in `formatVersion`, once
+/// per version, and returns the path to it
+static std::string getSubjectPath(int formatVersion)
+{
+  static std::map<int, std::string> paths;
+  auto existing = paths.find(formatVersion);
+  if (existing != paths.end())
+    return existing->second;
+
+  DynamicsInputs inputs = createDynamicsInputs();
+  const Eigen::MatrixXs& poses = inputs.init->poseTrials[0];
+  const int numFrames = poses.cols();
+
+  std::vector<Eigen::MatrixXs> poseTrials{poses};
+  std::vector<Eigen::MatrixXs> velTrials{
+      Eigen::MatrixXs::Random(poses.rows(), numFrames)};
+  std::vector<Eigen::MatrixXs> accTrials{
+      Eigen::MatrixXs::Random(poses.rows(), numFrames)};
+  std::vector<Eigen::MatrixXs> tauTrials{
+      Eigen::MatrixXs::Random(poses.rows(), numFrames)};
+  std::vector<std::vector<bool>> probablyMissingGRF{
+      std::vector<bool>(numFrames, false)};
+  std::vector<std::string> groundForceBodies{"calcn_r", "calcn_l"};
+  std::vector<Eigen::MatrixXs> wrenchTrials{
+      Eigen::MatrixXs::Random(6 * groundForceBodies.size(), numFrames)};
+  std::vector<Eigen::MatrixXs> copTorqueForceTrials{
+      Eigen::MatrixXs::Random(9 * groundForceBodies.size(), numFrames)};
+  std::vector<std::string> customValueNames;
+  std::vector<std::vector<Eigen::MatrixXs>> customValues{
+      std::vector<Eigen::MatrixXs>()};
+
+  const std::string path
+      = (boost::filesystem::temp_directory_path()
+         / ("bench_Biomechanics_v" + std::to_string(formatVersion) + ".b3d"))
+            .string();
+  SubjectOnDisk::writeSubject(
+      path,
+      DYNAMICS_OSIM,
+      {inputs.init->trialTimesteps[0]},
+      poseTrials,
+      velTrials,
+      accTrials,
+      probablyMissingGRF,
+      tauTrials,
+      groundForceBodies,
+      wrenchTrials,
+      copTorqueForceTrials,
+      customValueNames,
+      customValues,
+      {"sprinter"},
+      "",
+      "",
+      formatVersion);
+
+  paths[formatVersion] = path;
+  return path;
+}
+
+//==============================================================================
+static void BM_SubjectOnDisk_ReadFrames(benchmark::State& state)
+{
+  const int formatVersion = state.range(0);
+  const int numFramesToRead = state.range(1);
+  SubjectOnDisk subject(getSubjectPath(formatVersion));
+  const int trialLength = subject.getTrialLength(0);
+  state.SetLabel("v" + std::to_string(formatVersion));
+
+  int start = 0;
+  for (auto _ : state)
+  {
+    std::vector<std::shared_ptr<Frame>> frames
+        = subject.readFrames(0, start, numFramesToRead);
+    benchmark::DoNotOptimize(frames);
+    start = (start + numFramesToRead) % (trialLength - numFramesToRead + 1);
+  }
+  setFramesPerSecond(state, numFramesToRead);
+}
+
+//==============================================================================
+static void registerReadSizes(benchmark::internal::Benchmark* b)
+{
+  for (int formatVersion : {1, 2})
+  {
+    for (int numFramesToRead : {1, 10, NUM_DYNAMICS_FRAMES})
+    {
+      b->Args({formatVersion, numFramesToRead});
+    }
+  }
+}
+BENCHMARK(BM_SubjectOnDisk_ReadFrames)->Apply(registerReadSizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,386 @@
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <assimp/scene.h>
+#include <benchmark/benchmark.h>
+
+#include "dart/collision/CollisionGroup.hpp"
+#include "dart/collision/CollisionOption.hpp"
+#include "dart/collision/CollisionResult.hpp"
+#include "dart/collision/dart/DARTCollide.hpp"
+#include "dart/collision/dart/DARTCollisionDetector.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/CapsuleShape.hpp"
+#include "dart/dynamics/SimpleFrame.hpp"
+#include "dart/dynamics/SphereShape.hpp"
+#include "dart/math/Constants.hpp"
+#include "dart/math/Geometry.hpp"
+#include "dart/math/Random.hpp"
+
+using namespace dart;
+using namespace collision;
+using namespace dynamics;
+
+// These time each of the narrowphase routines in DARTCollide.cpp on its own,
+// one benchmark per pair of shape types, with mesh pairs run over a range of
+// vertex counts. Every pair is posed so the shapes overlap, since that's the
+// expensive path. Then there's a scene benchmark that times a whole
+// CollisionGroup::collide() on 10 to 10k objects at a fixed density, which is
+// mostly broadphase cost once the scene gets large.
+
+enum PrimitivePair
+{
+  PAIR_BOX_BOX = 0,
+  PAIR_BOX_SPHERE = 1,
+  PAIR_SPHERE_SPHERE = 2,
+  PAIR_CAPSULE_CAPSULE = 3,
+  PAIR_BOX_CAPSULE = 4,
+  PAIR_SPHERE_CAPSULE = 5,
+  PAIR_BOX_BOX_AS_MESH = 6,
+  NUM_PRIMITIVE_PAIRS = 7
+};
+
+static const char* getPrimitivePairName(int pair)
+{
+  switch (pair)
+  {
+    case PAIR_BOX_BOX:
+      return "box-box";
+    case PAIR_BOX_SPHERE:
+      return "box-sphere";
+    case PAIR_SPHERE_SPHERE:
+      return "sphere-sphere";
+    case PAIR_CAPSULE_CAPSULE:
+      return "capsule-capsule";
+    case PAIR_BOX_CAPSULE:
+      return "box-capsule";
+    case PAIR_SPHERE_CAPSULE:
+      return "sphere-capsule";
+    case PAIR_BOX_BOX_AS_MESH:
+      return "box-box (as mesh)";
+  }
+  return "unknown";
+}
+
+enum MeshPair
+{
+  MESH_BOX = 0,
+  MESH_SPHERE = 1,
+  MESH_CAPSULE = 2,
+  MESH_MESH = 3,
+  NUM_MESH_PAIRS = 4
+};
+
+static const char* getMeshPairName(int pair)
+{
+  switch (pair)
+  {
+    case MESH_BOX:
+      return "mesh-box";
+    case MESH_SPHERE:
+      return "mesh-sphere";
+    case MESH_CAPSULE:
+      return "mesh-capsule";
+    case MESH_MESH:
+      return "mesh-mesh";
+  }
+  return "unknown";
+}
+
+// Every shape fits in a unit cube centered on its origin
+static const Eigen::Vector3s BOX_SIZE = Eigen::Vector3s::Ones();
+static const s_t RADIUS = 0.5;
+static const s_t CAPSULE_HEIGHT = 1.0;
+
+//==============================================================================
+/// The first shape of every pair sits at the origin, and the second sits here,
+/// close enough to overlap whatever the shapes are, and turned so that no
+/// faces line up
+static Eigen::Isometry3s getOverlappingTransform()
+{
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0.1, 0.15, 0.9);
+  T.linear() = Eigen::AngleAxis_s(0.3, Eigen::Vector3s(1, 1, 0).normalized())
+                   .toRotationMatrix();
+  return T;
+}
+
+//==============================================================================
+/// Returns a UV sphere of diameter 1 with `numRings` rings of `numRings`
+/// vertices each, plus the two poles
+static std::shared_ptr<aiScene> createSphereMesh(int numRings)
+{
+  aiMesh* mesh = new aiMesh;
+  mesh->mNumVertices = numRings * numRings + 2;
+  mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+  mesh->mVertices[0].Set(0, 0, static_cast<float>(RADIUS));
+  mesh->mVertices[1].Set(0, 0, static_cast<float>(-RADIUS));
+  for (int ring = 0; ring < numRings; ring++)
+  {
+    const s_t phi = math::constantsd::pi() * (ring + 1) / (numRings + 1);
+    for (int i = 0; i < numRings; i++)
+    {
+      const s_t theta = 2 * math::constantsd::pi() * i / numRings;
+      mesh->mVertices[2 + ring * numRings + i].Set(
+          static_cast<float>(RADIUS * sin(phi) * cos(theta)),
+          static_cast<float>(RADIUS * sin(phi) * sin(theta)),
+          static_cast<float>(RADIUS * cos(phi)));
+    }
+  }
+
+  // Caps at both poles, and two triangles per quad in between
+  std::vector<std::array<unsigned int, 3>> faces;
+  for (int i = 0; i < numRings; i++)
+  {
+    const unsigned int next = (i + 1) % numRings;
+    faces.push_back({0u, 2u + i, 2u + next});
+    const unsigned int last = 2 + (numRings - 1) * numRings;
+    faces.push_back({1u, last + next, last + i});
+    for (int ring = 0; ring + 1 < numRings; ring++)
+    {
+      const unsigned int a = 2 + ring * numRings + i;
+      const unsigned int b = 2 + ring * numRings + next;
+      faces.push_back({a, a + numRings, b});
+      faces.push_back({b, a + numRings, b + numRings});
+    }
+  }
+  mesh->mNumFaces = faces.size();
+  mesh->mFaces = new aiFace[faces.size()];
+  for (std::size_t i = 0; i < faces.size(); i++)
+  {
+    mesh->mFaces[i].mNumIndices = 3;
+    mesh->mFaces[i].mIndices = new unsigned int[3];
+    for (int j = 0; j < 3; j++)
+      mesh->mFaces[i].mIndices[j] = faces[i][j];
+  }
+
+  std::shared_ptr<aiScene> scene = std::make_shared<aiScene>();
+  scene->mNumMeshes = 1;
+  scene->mMeshes = new aiMesh*[1];
+  scene->mMeshes[0] = mesh;
+  return scene;
+}
+
+//==============================================================================
+static void BM_CollidePrimitives(benchmark::State& state)
+{
+  const int pair = state.range(0);
+  state.SetLabel(getPrimitivePairName(pair));
+
+  const Eigen::Isometry3s T0 = Eigen::Isometry3s::Identity();
+  const Eigen::Isometry3s T1 = getOverlappingTransform();
+  CollisionOption option(true, 100u, nullptr);
+  CollisionResult result;
+  int numContacts = 0;
+
+  for (auto _ : state)
+  {
+    result.clear();
+    switch (pair)
+    {
+      case PAIR_BOX_BOX:
+        numContacts = collideBoxBox(
+            nullptr, nullptr, BOX_SIZE, T0, BOX_SIZE, T1, option, result);
+        break;
+      case PAIR_BOX_SPHERE:
+        numContacts = collideBoxSphere(
+            nullptr, nullptr, BOX_SIZE, T0, RADIUS, T1, option, result);
+        break;
+      case PAIR_SPHERE_SPHERE:
+        numContacts = collideSphereSphere(
+            nullptr, nullptr, RADIUS, T0, RADIUS, T1, option, result);
+        break;
+      case PAIR_CAPSULE_CAPSULE:
+        numContacts = collideCapsuleCapsule(
+            nullptr,
+            nullptr,
+            CAPSULE_HEIGHT,
+            RADIUS,
+            T0,
+            CAPSULE_HEIGHT,
+            RADIUS,
+            T1,
+            option,
+            result);
+        break;
+      case PAIR_BOX_CAPSULE:
+        numContacts = collideBoxCapsule(
+            nullptr,
+            nullptr,
+            BOX_SIZE,
+            T0,
+            CAPSULE_HEIGHT,
+            RADIUS,
+            T1,
+            option,
+            result);
+        break;
+      case PAIR_SPHERE_CAPSULE:
+        numContacts = collideSphereCapsule(
+            nullptr,
+            nullptr,
+            RADIUS,
+            T0,
+            CAPSULE_HEIGHT,
+            RADIUS,
+            T1,
+            option,
+            result);
+        break;
+      case PAIR_BOX_BOX_AS_MESH:
+        numContacts = collideBoxBoxAsMesh(
+            nullptr, nullptr, BOX_SIZE, T0, BOX_SIZE, T1, option, result);
+        break;
+    }
+    benchmark::DoNotOptimize(numContacts);
+  }
+  state.counters["contacts"] = numContacts;
+}
+BENCHMARK(BM_CollidePrimitives)->DenseRange(0, NUM_PRIMITIVE_PAIRS - 1);
+
+//==============================================================================
+static void BM_CollideMesh(benchmark::State& state)
+{
+  const int pair = state.range(0);
+  std::shared_ptr<aiScene> mesh = createSphereMesh(state.range(1));
+  state.SetLabel(
+      std::string(getMeshPairName(pair)) + " ("
+      + std::to_string(mesh->mMeshes[0]->mNumVertices) + " vertices)");
+
+  const Eigen::Vector3s scale = Eigen::Vector3s::Ones();
+  const Eigen::Isometry3s T0 = Eigen::Isometry3s::Identity();
+  const Eigen::Isometry3s T1 = getOverlappingTransform();
+  CollisionOption option(true, 100u, nullptr);
+  CollisionResult result;
+  int numContacts = 0;
+
+  for (auto _ : state)
+  {
+    result.clear();
+    switch (pair)
+    {
+      case MESH_BOX:
+        numContacts = collideMeshBox(
+            nullptr,
+            nullptr,
+            mesh.get(),
+            scale,
+            T0,
+            BOX_SIZE,
+            T1,
+            option,
+            result);
+        break;
+      case MESH_SPHERE:
+        numContacts = collideMeshSphere(
+            nullptr,
+            nullptr,
+            mesh.get(),
+            scale,
+            T0,
+            RADIUS,
+            T1,
+            option,
+            result);
+        break;
+      case MESH_CAPSULE:
+        numContacts = collideMeshCapsule(
+            nullptr,
+            nullptr,
+            mesh.get(),
+            scale,
+            T0,
+            CAPSULE_HEIGHT,
+            RADIUS,
+            T1,
+            option,
+            result);
+        break;
+      case MESH_MESH:
+        numContacts = collideMeshMesh(
+            nullptr,
+            nullptr,
+            mesh.get(),
+            scale,
+            T0,
+            mesh.get(),
+            scale,
+            T1,
+            option,
+            result);
+        break;
+    }
+    benchmark::DoNotOptimize(numContacts);
+  }
+  state.counters["contacts"] = numContacts;
+}
+
+static void registerMeshPairs(benchmark::internal::Benchmark* b)
+{
+  for (int pair = 0; pair < NUM_MESH_PAIRS; pair++)
+  {
+    // 6, 18, 66, 258 and 1026 vertices
+    for (int numRings : {2, 4, 8, 16, 32})
+    {
+      b->Args({pair, numRings});
+    }
+  }
+}
+BENCHMARK(BM_CollideMesh)->Apply(registerMeshPairs);
+
+//==============================================================================
+/// This times a whole collision check on a scene of `state.range(0)` boxes,
+/// spheres and capsules, scattered at random (but the same every run) through
+/// a cube sized so that the number of objects per unit volume stays the same
+/// as the scene grows. That keeps the number of touching pairs proportional to
+/// the number of objects, so anything that grows faster is broadphase.
+static void BM_CollideScene(benchmark::State& state)
+{
+  const int numObjects = state.range(0);
+  math::Random::setSeed(42);
+
+  std::vector<ShapePtr> shapes{std::make_shared<BoxShape>(BOX_SIZE),
+                               std::make_shared<SphereShape>(RADIUS),
+                               std::make_shared<CapsuleShape>(
+                                   RADIUS, CAPSULE_HEIGHT)};
+
+  const s_t halfWidth = 1.5 * std::cbrt(static_cast<s_t>(numObjects));
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  auto detector = DARTCollisionDetector::create();
+  auto group = detector->createCollisionGroup();
+  for (int i = 0; i < numObjects; i++)
+  {
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = math::Random::uniform<Eigen::Vector3s>(
+        Eigen::Vector3s::Constant(-halfWidth),
+        Eigen::Vector3s::Constant(halfWidth));
+    T.linear() = math::expMapRot(math::Random::uniform<Eigen::Vector3s>(
+        -math::constantsd::pi(), math::constantsd::pi()));
+
+    auto frame = std::make_shared<SimpleFrame>(
+        Frame::World(), "object_" + std::to_string(i), T);
+    frame->setShape(shapes[i % shapes.size()]);
+    group->addShapeFrame(frame.get());
+    frames.push_back(frame);
+  }
+
+  CollisionOption option(true, 1000000u, nullptr);
+  CollisionResult result;
+  for (auto _ : state)
+  {
+    result.clear();
+    group->collide(option, &result);
+    benchmark::DoNotOptimize(result.getNumContacts());
+  }
+  state.counters["contacts"] = result.getNumContacts();
+  state.SetItemsProcessed(state.iterations() * numObjects);
+}
+BENCHMARK(BM_CollideScene)
+    ->RangeMultiplier(10)
+    ->Range(10, 10000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,153 @@
+#include <benchmark/benchmark.h>
+
+#include "dart/dynamics/ConstantCurveJoint.hpp"
+#include "dart/dynamics/EllipsoidJoint.hpp"
+#include "dart/dynamics/ScapulathoracicJoint.hpp"
+#include "dart/math/Geometry.hpp"
+#include "dart/math/MathTypes.hpp"
+
+using namespace dart;
+using namespace dynamics;
+
+// These time the relative Jacobian of the joints we use to model spines and
+// shoulders, comparing the single-pass time derivative against summing up the
+// per-DOF position derivatives, which is what we used to do.
+
+//==============================================================================
+template <typename JointType>
+static void setUpJoint(JointType& joint)
+{
+  Eigen::Isometry3s transformFromParent = Eigen::Isometry3s::Identity();
+  transformFromParent.translation() = Eigen::Vector3s(-0.02, -0.0173, 0.07);
+  transformFromParent.linear()
+      = math::eulerXYZToMatrix(Eigen::Vector3s(0, -0.87, 0));
+  joint.setTransformFromParentBodyNode(transformFromParent);
+  Eigen::Isometry3s transformFromChild = Eigen::Isometry3s::Identity();
+  transformFromChild.translation()
+      = Eigen::Vector3s(-0.05982, -0.03904, -0.056);
+  transformFromChild.linear()
+      = math::eulerXYZToMatrix(Eigen::Vector3s(-0.5181, -1.1416, -0.2854));
+  joint.setTransformFromChildBodyNode(transformFromChild);
+
+  joint.setPositions(Eigen::VectorXs::Random(joint.getNumDofs()));
+  joint.setVelocities(Eigen::VectorXs::Random(joint.getNumDofs()));
+}
+
+//==============================================================================
+template <typename JointType>
+static void benchJacobian(benchmark::State& state, JointType& joint)
+{
+  const auto pos = joint.getPositionsStatic();
+  for (auto _ : state)
+  {
+    auto J = joint.getRelativeJacobianStatic(pos);
+    benchmark::DoNotOptimize(J);
+  }
+}
+
+//==============================================================================
+template <typename JointType>
+static void benchTimeDeriv(benchmark::State& state, JointType& joint)
+{
+  const auto pos = joint.getPositionsStatic();
+  const auto vel = joint.getVelocitiesStatic();
+  for (auto _ : state)
+  {
+    auto dJ = joint.getRelativeJacobianTimeDerivStatic(pos, vel);
+    benchmark::DoNotOptimize(dJ);
+  }
+}
+
+//==============================================================================
+template <typename JointType>
+static void benchTimeDerivPerDof(benchmark::State& state, JointType& joint)
+{
+  const auto vel = joint.getVelocitiesStatic();
+  for (auto _ : state)
+  {
+    auto dJ = joint.getRelativeJacobianDerivWrtPositionStatic(0);
+    dJ *= vel(0);
+    for (int i = 1; i < vel.size(); i++)
+    {
+      dJ += joint.getRelativeJacobianDerivWrtPositionStatic(i) * vel(i);
+    }
+    benchmark::DoNotOptimize(dJ);
+  }
+}
+
+//==============================================================================
+static void BM_ConstantCurve_Jacobian(benchmark::State& state)
+{
+  ConstantCurveJoint joint{ConstantCurveJoint::Properties()};
+  setUpJoint(joint);
+  benchJacobian(state, joint);
+}
+BENCHMARK(BM_ConstantCurve_Jacobian);
+
+static void BM_ConstantCurve_TimeDeriv(benchmark::State& state)
+{
+  ConstantCurveJoint joint{ConstantCurveJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDeriv(state, joint);
+}
+BENCHMARK(BM_ConstantCurve_TimeDeriv);
+
+static void BM_ConstantCurve_TimeDerivPerDof(benchmark::State& state)
+{
+  ConstantCurveJoint joint{ConstantCurveJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDerivPerDof(state, joint);
+}
+BENCHMARK(BM_ConstantCurve_TimeDerivPerDof);
+
+//==============================================================================
+static void BM_Ellipsoid_Jacobian(benchmark::State& state)
+{
+  EllipsoidJoint joint{EllipsoidJoint::Properties()};
+  setUpJoint(joint);
+  benchJacobian(state, joint);
+}
+BENCHMARK(BM_Ellipsoid_Jacobian);
+
+static void BM_Ellipsoid_TimeDeriv(benchmark::State& state)
+{
+  EllipsoidJoint joint{EllipsoidJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDeriv(state, joint);
+}
+BENCHMARK(BM_Ellipsoid_TimeDeriv);
+
+static void BM_Ellipsoid_TimeDerivPerDof(benchmark::State& state)
+{
+  EllipsoidJoint joint{EllipsoidJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDerivPerDof(state, joint);
+}
+BENCHMARK(BM_Ellipsoid_TimeDerivPerDof);
+
+//==============================================================================
+static void BM_Scapulathoracic_Jacobian(benchmark::State& state)
+{
+  ScapulathoracicJoint joint{ScapulathoracicJoint::Properties()};
+  setUpJoint(joint);
+  benchJacobian(state, joint);
+}
+BENCHMARK(BM_Scapulathoracic_Jacobian);
+
+static void BM_Scapulathoracic_TimeDeriv(benchmark::State& state)
+{
+  ScapulathoracicJoint joint{ScapulathoracicJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDeriv(state, joint);
+}
+BENCHMARK(BM_Scapulathoracic_TimeDeriv);
+
+static void BM_Scapulathoracic_TimeDerivPerDof(benchmark::State& state)
+{
+  ScapulathoracicJoint joint{ScapulathoracicJoint::Properties()};
+  setUpJoint(joint);
+  benchTimeDerivPerDof(state, joint);
+}
+BENCHMARK(BM_Scapulathoracic_TimeDerivPerDof);
+
+BENCHMARK_MAIN();
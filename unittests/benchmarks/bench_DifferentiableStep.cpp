@@ -0,0 +1,272 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/TranslationalJoint2D.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/Constants.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/simulation/World.hpp"
+#include "dart/trajectory/LossFn.hpp"
+#include "dart/trajectory/MultiShot.hpp"
+#include "dart/trajectory/Problem.hpp"
+#include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/UniversalLoader.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace simulation;
+using namespace neural;
+using namespace trajectory;
+
+// These benchmarks cover a full differentiable step: World::step(), the
+// forward pass plus BackpropSnapshot::backprop(), and MultiShot gradient
+// evaluation, on a handful of standard models. Each benchmark takes the model
+// as its first argument, so results across models line up in the output.
+
+enum BenchmarkModel
+{
+  CARTPOLE = 0,
+  KR5 = 1,
+  ATLAS = 2,
+  HALF_CHEETAH = 3,
+  RAJAGOPAL = 4
+};
+
+static const char* getModelName(int model)
+{
+  switch (model)
+  {
+    case CARTPOLE:
+      return "cartpole";
+    case KR5:
+      return "KR5";
+    case ATLAS:
+      return "atlas";
+    case HALF_CHEETAH:
+      return "half_cheetah";
+    case RAJAGOPAL:
+      return "rajagopal";
+  }
+  return "unknown";
+}
+
+static WorldPtr createCartpoleWorld()
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3s(1, 0, 0));
+  std::shared_ptr<BoxShape> sledShapeBox(
+      new BoxShape(Eigen::Vector3s(0.05, 0.25, 0.05)));
+  sledPair.second->createShapeNodeWith<VisualAspect>(sledShapeBox);
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  std::shared_ptr<BoxShape> armShapeBox(
+      new BoxShape(Eigen::Vector3s(0.05, 0.25, 0.05)));
+  armPair.second->createShapeNodeWith<VisualAspect>(armShapeBox);
+
+  Eigen::Isometry3s armOffset = Eigen::Isometry3s::Identity();
+  armOffset.translation() = Eigen::Vector3s(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+
+  world->addSkeleton(cartpole);
+
+  cartpole->setControlForceUpperLimit(0, 1000);
+  cartpole->setControlForceLowerLimit(0, -1000);
+  cartpole->setControlForceUpperLimit(1, 0);
+  cartpole->setControlForceLowerLimit(1, 0);
+  cartpole->setPosition(1, 15.0 / 180.0 * 3.1415);
+
+  return world;
+}
+
+static WorldPtr createModelWorld(int model)
+{
+  if (model == CARTPOLE)
+  {
+    return createCartpoleWorld();
+  }
+  if (model == HALF_CHEETAH)
+  {
+    WorldPtr world = dart::utils::UniversalLoader::loadWorld(
+        "dart://sample/skel/half_cheetah.skel");
+    world->setPositions(Eigen::VectorXs::Zero(world->getNumDofs()));
+    world->setVelocities(Eigen::VectorXs::Zero(world->getNumDofs()));
+    return world;
+  }
+
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0.0, -9.81, 0.0));
+  if (model == KR5)
+  {
+    dart::utils::UniversalLoader::loadSkeleton(
+        world.get(), "dart://sample/urdf/KR5/KR5 sixx R650.urdf");
+  }
+  else if (model == ATLAS)
+  {
+    std::shared_ptr<dynamics::Skeleton> atlas
+        = dart::utils::UniversalLoader::loadSkeleton(
+            world.get(), "dart://sample/sdf/atlas/atlas_v3_no_head.sdf");
+    dart::utils::UniversalLoader::loadSkeleton(
+        world.get(), "dart://sample/sdf/atlas/ground.urdf");
+    atlas->setPosition(0, -0.5 * dart::math::constantsd::pi());
+    atlas->setPosition(4, -0.01);
+  }
+  else if (model == RAJAGOPAL)
+  {
+    std::shared_ptr<dynamics::Skeleton> osim
+        = biomechanics::OpenSimParser::parseOsim(
+              "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+              .skeleton;
+    world->addSkeleton(osim);
+  }
+  return world;
+}
+
+static void registerModels(benchmark::internal::Benchmark* b)
+{
+  for (int model = CARTPOLE; model <= RAJAGOPAL; model++)
+  {
+    b->Arg(model);
+  }
+}
+
+/// This creates `numBoxes` free-floating 2D boxes resting on a floor, each far
+/// enough from the others that it lands in its own constrained group. This
+/// lets us scale the number of contacts independently of the model.
+static WorldPtr createBoxesOnFloorWorld(int numBoxes)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorJointPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3s floorOffset = Eigen::Isometry3s::Identity();
+  floorOffset.translation() = Eigen::Vector3s(0, -0.5, 0);
+  floorJointPair.first->setTransformFromParentBodyNode(floorOffset);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3s(3.0 * numBoxes + 2.0, 1.0, 1.0)));
+  floorJointPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  world->addSkeleton(floor);
+
+  for (int i = 0; i < numBoxes; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<TranslationalJoint2D*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+    pair.first->setXYPlane();
+    std::shared_ptr<BoxShape> boxShape(
+        new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+    world->addSkeleton(box);
+    box->setPositions(Eigen::Vector2s(3.0 * i - 1.5 * numBoxes, 0.499));
+  }
+
+  return world;
+}
+
+static void runForwardBackprop(WorldPtr world, benchmark::State& state)
+{
+  LossGradient nextTimestepLoss;
+  nextTimestepLoss.lossWrtPosition = Eigen::VectorXs::Ones(world->getNumDofs());
+  nextTimestepLoss.lossWrtVelocity = Eigen::VectorXs::Ones(world->getNumDofs());
+  nextTimestepLoss.lossWrtTorque = Eigen::VectorXs::Zero(world->getNumDofs());
+  nextTimestepLoss.lossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+  LossGradient thisTimestepLoss;
+
+  for (auto _ : state)
+  {
+    std::shared_ptr<BackpropSnapshot> snapshot
+        = neural::forwardPass(world, true);
+    snapshot->backprop(world, thisTimestepLoss, nextTimestepLoss);
+    benchmark::DoNotOptimize(thisTimestepLoss.lossWrtTorque.data());
+  }
+}
+
+static void BM_WorldStep(benchmark::State& state)
+{
+  WorldPtr world = createModelWorld(state.range(0));
+  state.SetLabel(
+      std::string(getModelName(state.range(0))) + " ("
+      + std::to_string(world->getNumDofs()) + " dofs)");
+  Eigen::VectorXs positions = world->getPositions();
+  Eigen::VectorXs velocities = world->getVelocities();
+
+  for (auto _ : state)
+  {
+    world->setPositions(positions);
+    world->setVelocities(velocities);
+    world->step();
+  }
+}
+BENCHMARK(BM_WorldStep)->Apply(registerModels);
+
+static void BM_ForwardBackprop(benchmark::State& state)
+{
+  WorldPtr world = createModelWorld(state.range(0));
+  state.SetLabel(
+      std::string(getModelName(state.range(0))) + " ("
+      + std::to_string(world->getNumDofs()) + " dofs)");
+  runForwardBackprop(world, state);
+}
+BENCHMARK(BM_ForwardBackprop)->Apply(registerModels);
+
+static void BM_ForwardBackprop_Contacts(benchmark::State& state)
+{
+  WorldPtr world = createBoxesOnFloorWorld(state.range(0));
+  std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(world, true);
+  state.SetLabel(
+      std::to_string(snapshot->getNumClamping()) + " clamping contacts");
+  runForwardBackprop(world, state);
+}
+BENCHMARK(BM_ForwardBackprop_Contacts)->RangeMultiplier(2)->Range(1, 32);
+
+static void BM_MultiShotGradient(benchmark::State& state)
+{
+  WorldPtr world = createModelWorld(state.range(0));
+  state.SetLabel(
+      std::string(getModelName(state.range(0))) + " ("
+      + std::to_string(world->getNumDofs()) + " dofs)");
+
+  TrajectoryLossFn loss = [](const TrajectoryRollout* rollout) {
+    return rollout->getPosesConst().squaredNorm()
+           + rollout->getControlForcesConst().squaredNorm();
+  };
+  LossFn lossFn(loss);
+  MultiShot shot(world, lossFn, 50, 10, false);
+  // MultiShot hides the public flatten()/unflatten() overloads
+  Problem& problem = shot;
+
+  Eigen::VectorXs flat = Eigen::VectorXs::Zero(shot.getFlatProblemDim(world));
+  problem.flatten(world, flat);
+  Eigen::VectorXs grad = Eigen::VectorXs::Zero(shot.getFlatProblemDim(world));
+  for (auto _ : state)
+  {
+    // Unflattening marks all the cached snapshots dirty, so each iteration
+    // pays for the forward passes as well as the backprop
+    problem.unflatten(world, flat);
+    shot.backpropGradient(world, grad);
+    benchmark::DoNotOptimize(grad.data());
+  }
+}
+BENCHMARK(BM_MultiShotGradient)->Apply(registerModels);
+
+BENCHMARK_MAIN();
@@ -9,6 +9,7 @@
 #include "dart/collision/Contact.hpp"
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/SimpleFeatherstoneBatch.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
@@ -142,4 +143,32 @@ static void BM_20_Joint_Simple_Featherstone(benchmark::State& state)
 }
 BENCHMARK(BM_20_Joint_Simple_Featherstone);
 
+static void BM_20_Joint_Simple_Featherstone_Batch(benchmark::State& state)
+{
+  SkeletonPtr arm = createMultiarmRobot(20, 0.2);
+  SimpleFeatherstone simple;
+  simple.populateFromSkeleton(arm);
+  SimpleFeatherstoneBatch batch(simple);
+
+  const int batchSize = state.range(0);
+  Eigen::MatrixXs pos = arm->getPositions().replicate(1, batchSize);
+  Eigen::MatrixXs vel = arm->getVelocities().replicate(1, batchSize);
+  Eigen::MatrixXs force = arm->getControlForces().replicate(1, batchSize);
+  Eigen::MatrixXs accel = Eigen::MatrixXs::Zero(simple.len(), batchSize);
+
+  s_t dt = 0.001;
+  for (auto _ : state)
+  {
+    batch.forwardDynamics(pos, vel, force, accel);
+    pos += vel * dt;
+    vel += accel * dt;
+  }
+  // Report throughput per environment, so this lines up with the scalar
+  // benchmark above
+  state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_20_Joint_Simple_Featherstone_Batch)
+    ->RangeMultiplier(4)
+    ->Range(1, 1024);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dart/math/Geometry.hpp"
+#include "dart/math/MathTypes.hpp"
+
+using namespace dart;
+using namespace math;
+
+// These compare the batched SE(3) kernels in Geometry.hpp against calling the
+// scalar versions once per element, over a batch about the size of a full
+// body model.
+
+static const int BATCH_SIZE = 256;
+
+//==============================================================================
+static void BM_ExpMap_Scalar(benchmark::State& state)
+{
+  TwistBatch twists = TwistBatch::Random(BATCH_SIZE, 6);
+  std::vector<Eigen::Isometry3s> out(BATCH_SIZE);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < BATCH_SIZE; i++)
+      out[i] = expMap(twists.row(i).transpose());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_ExpMap_Scalar);
+
+static void BM_ExpMap_Batch(benchmark::State& state)
+{
+  TwistBatch twists = TwistBatch::Random(BATCH_SIZE, 6);
+  TransformBatch out;
+  for (auto _ : state)
+  {
+    expMapBatch(twists, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_ExpMap_Batch);
+
+//==============================================================================
+static void BM_EulerXYZ_Scalar(benchmark::State& state)
+{
+  Vector3Batch angles = Vector3Batch::Random(BATCH_SIZE, 3);
+  std::vector<Eigen::Matrix3s> out(BATCH_SIZE);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < BATCH_SIZE; i++)
+      out[i] = eulerXYZToMatrix(angles.row(i).transpose());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_EulerXYZ_Scalar);
+
+static void BM_EulerXYZ_Batch(benchmark::State& state)
+{
+  Vector3Batch angles = Vector3Batch::Random(BATCH_SIZE, 3);
+  RotationBatch out;
+  for (auto _ : state)
+  {
+    eulerXYZToMatrixBatch(angles, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_EulerXYZ_Batch);
+
+//==============================================================================
+static void BM_AdT_Scalar(benchmark::State& state)
+{
+  TwistBatch twists = TwistBatch::Random(BATCH_SIZE, 6);
+  std::vector<Eigen::Isometry3s> transforms(BATCH_SIZE);
+  for (int i = 0; i < BATCH_SIZE; i++)
+    transforms[i] = expMap(Eigen::Vector6s::Random());
+  std::vector<Eigen::Vector6s> out(BATCH_SIZE);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < BATCH_SIZE; i++)
+      out[i] = AdT(transforms[i], twists.row(i).transpose());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_AdT_Scalar);
+
+static void BM_AdT_Batch(benchmark::State& state)
+{
+  TwistBatch twists = TwistBatch::Random(BATCH_SIZE, 6);
+  TransformBatch transforms;
+  expMapBatch(TwistBatch::Random(BATCH_SIZE, 6), transforms);
+  TwistBatch out;
+  for (auto _ : state)
+  {
+    AdTBatch(transforms, twists, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_AdT_Batch);
+
+//==============================================================================
+static void BM_Ad_Scalar(benchmark::State& state)
+{
+  TwistBatch X = TwistBatch::Random(BATCH_SIZE, 6);
+  TwistBatch Y = TwistBatch::Random(BATCH_SIZE, 6);
+  std::vector<Eigen::Vector6s> out(BATCH_SIZE);
+  for (auto _ : state)
+  {
+    for (int i = 0; i < BATCH_SIZE; i++)
+      out[i] = ad(X.row(i).transpose(), Y.row(i).transpose());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_Ad_Scalar);
+
+static void BM_Ad_Batch(benchmark::State& state)
+{
+  TwistBatch X = TwistBatch::Random(BATCH_SIZE, 6);
+  TwistBatch Y = TwistBatch::Random(BATCH_SIZE, 6);
+  TwistBatch out;
+  for (auto _ : state)
+  {
+    adBatch(X, Y, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_Ad_Batch);
+
+BENCHMARK_MAIN();
@@ -1266,4 +1266,134 @@ TEST(GRADIENTS, END_SPHERE_FACE_MESH)
 {
   testBoxCapsuleCollision(false, true, 4);
 }
-#endif
\ No newline at end of file
+#endif
+/**
+ * This sets up a sphere (or a capsule) colliding with a heightmap shaped like
+ * a pyramid, with its peak in the middle. Type 1 hits one of the faces, type 2
+ * hits the ridge along one of the diagonals, type 3 hits the peak, and type 4
+ * lays a capsule across the peak, so that the contact is on the middle of the
+ * capsule rather than one of the end caps.
+ */
+void testHeightmapCollision(int type)
+{
+  s_t radius = 0.25;
+  s_t penetrationDepth = 2e-3;
+
+  // The heightmap's Z axis points along world Y, to keep the contact normals
+  // well clear of the Unit Z singularity in the friction cone
+  Eigen::Isometry3s T1 = Eigen::Isometry3s::Identity();
+  T1.linear() = math::eulerXYZToMatrix(Eigen::Vector3s(-M_PI / 2, 0, 0));
+
+  // The peak is at (0, 0, 0.5), and the corners are at height 0
+  std::shared_ptr<HeightmapShaped> heightmapShape
+      = std::make_shared<HeightmapShaped>();
+  HeightmapShaped::HeightField heights
+      = HeightmapShaped::HeightField::Zero(3, 3);
+  heights(1, 1) = 0.5;
+  heightmapShape->setHeightField(heights);
+
+  Eigen::Vector3s localCenter;
+  if (type == 1)
+  {
+    // The centroid of the face from (-1, 1) to (-1, 0) to the peak
+    Eigen::Vector3s normal = Eigen::Vector3s(-0.5, 0, 1).normalized();
+    localCenter = Eigen::Vector3s(-2.0 / 3, 1.0 / 3, 1.0 / 6)
+                  + normal * (radius - penetrationDepth);
+  }
+  else if (type == 2)
+  {
+    // The middle of the ridge from (-1, 1) to the peak
+    Eigen::Vector3s normal = Eigen::Vector3s(-0.5, 0.5, 2).normalized();
+    localCenter = Eigen::Vector3s(-0.5, 0.5, 0.25)
+                  + normal * (radius - penetrationDepth);
+  }
+  else
+  {
+    // Slightly off to the side of the peak
+    Eigen::Vector3s normal = Eigen::Vector3s(0.1, 0.2, 1).normalized();
+    localCenter
+        = Eigen::Vector3s(0, 0, 0.5) + normal * (radius - penetrationDepth);
+  }
+
+  Eigen::Isometry3s T2 = Eigen::Isometry3s::Identity();
+  T2.translation() = T1 * localCenter;
+  if (type == 4)
+  {
+    // Lay the capsule along the heightmap's X axis
+    T2.linear()
+        = T1.linear()
+          * math::eulerXYZToMatrix(Eigen::Vector3s(0, M_PI / 2, 0));
+  }
+
+  // World
+  WorldPtr world = World::create();
+  auto collision_detector
+      = collision::CollisionDetector::getFactory()->create("dart");
+  world->getConstraintSolver()->setCollisionDetector(collision_detector);
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr heightmap = Skeleton::create("heightmap");
+  std::pair<FreeJoint*, BodyNode*> heightmapPair
+      = heightmap->createJointAndBodyNodePair<FreeJoint>();
+  heightmapPair.first->setTransformFromParentBodyNode(T1);
+  heightmapPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      heightmapShape);
+
+  SkeletonPtr sphere = Skeleton::create("sphere");
+  std::pair<FreeJoint*, BodyNode*> spherePair
+      = sphere->createJointAndBodyNodePair<FreeJoint>();
+  std::shared_ptr<Shape> sphereShape;
+  if (type == 4)
+    sphereShape = std::make_shared<CapsuleShape>(radius, 1.0);
+  else
+    sphereShape = std::make_shared<SphereShape>(radius);
+  spherePair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      sphereShape);
+  spherePair.first->setTransformFromParentBodyNode(T2);
+
+  world->addSkeleton(heightmap);
+  world->addSkeleton(sphere);
+
+  Eigen::VectorXs vels = Eigen::VectorXs::Zero(world->getNumDofs());
+  // Set the vel of the Y translation of the sphere, into the heightmap
+  vels(10) = -0.01;
+  world->setVelocities(vels);
+
+  EXPECT_TRUE(verifyAnalyticalJacobians(world));
+  EXPECT_TRUE(verifyVelGradients(world, vels));
+  EXPECT_TRUE(verifyWrtMass(world));
+
+  //////////////////////////////////////////////////
+  // Try it in reverse skeleton order, to flip collision type enums
+  //////////////////////////////////////////////////
+
+  world->removeAllSkeletons();
+  world->addSkeleton(sphere);
+  world->addSkeleton(heightmap);
+
+  EXPECT_TRUE(verifyAnalyticalJacobians(world));
+  EXPECT_TRUE(verifyVelGradients(world, vels));
+  EXPECT_TRUE(verifyWrtMass(world));
+}
+
+#ifdef ALL_TESTS
+TEST(GRADIENTS, SPHERE_HEIGHTMAP_FACE)
+{
+  testHeightmapCollision(1);
+}
+
+TEST(GRADIENTS, SPHERE_HEIGHTMAP_EDGE)
+{
+  testHeightmapCollision(2);
+}
+
+TEST(GRADIENTS, SPHERE_HEIGHTMAP_VERTEX)
+{
+  testHeightmapCollision(3);
+}
+
+TEST(GRADIENTS, CAPSULE_MIDDLE_HEIGHTMAP_VERTEX)
+{
+  testHeightmapCollision(4);
+}
+#endif
@@ -878,6 +878,45 @@ TEST_F(Collision, Filter)
   auto dart = DARTCollisionDetector::create();
   testFilter(dart);
 }
+
+//==============================================================================
+TEST_F(Collision, CollisionLayersAndMasks)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto shape = std::make_shared<BoxShape>(Eigen::Vector3s(1, 1, 1));
+  auto frame1 = SimpleFrame::createShared(Frame::World());
+  frame1->setShape(shape);
+  auto frame2 = SimpleFrame::createShared(Frame::World());
+  frame2->setShape(shape);
+  frame2->setTranslation(Eigen::Vector3s(0.5, 0, 0));
+  CollisionAspect* aspect1 = frame1->createCollisionAspect();
+  CollisionAspect* aspect2 = frame2->createCollisionAspect();
+
+  auto group = cd->createCollisionGroup(frame1.get(), frame2.get());
+  auto group1 = cd->createCollisionGroup(frame1.get());
+  auto group2 = cd->createCollisionGroup(frame2.get());
+
+  // By default, everything is on layer 0, and collides with every layer
+  EXPECT_EQ(1u, aspect1->getCollisionLayers());
+  EXPECT_TRUE(group->collide());
+  EXPECT_TRUE(group1->collide(group2.get()));
+
+  // Something on layer 1 that only collides with layer 1
+  aspect2->setCollisionLayers(0x2u);
+  aspect2->setCollisionMask(0x2u);
+  EXPECT_FALSE(group->collide());
+  EXPECT_FALSE(group1->collide(group2.get()));
+
+  aspect2->setCollisionMask(0x3u);
+  EXPECT_TRUE(group->collide());
+  EXPECT_TRUE(group1->collide(group2.get()));
+
+  // Both objects have to collide with the other one's layers
+  aspect1->setCollisionMask(0x1u);
+  EXPECT_FALSE(group->collide());
+  EXPECT_FALSE(group1->collide(group2.get()));
+}
 #endif
 
 //==============================================================================
@@ -1072,4 +1111,517 @@ TEST_F(Collision, Factory)
   EXPECT_TRUE(!collision::CollisionDetector::getFactory()->canCreate("ode"));
 #endif
 }
-#endif
\ No newline at end of file
+#endif
+
+//==============================================================================
+#ifdef ALL_TESTS
+TEST_F(Collision, BroadphaseMatchesPairwise)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A jumble of boxes and spheres, close enough together that some of them
+  // overlap and most of them don't
+  srand(42);
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  for (int i = 0; i < 40; i++)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    if (i % 2 == 0)
+      frame->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 0.5, 1)));
+    else
+      frame->setShape(std::make_shared<SphereShape>(0.4));
+    frames.push_back(frame);
+  }
+
+  auto group = cd->createCollisionGroup();
+  for (auto& frame : frames)
+    group->addShapeFrame(frame.get());
+
+  collision::CollisionOption option;
+  option.maxNumContacts = 100000u;
+
+  for (int step = 0; step < 3; step++)
+  {
+    // Move everything a bit, so later steps exercise re-sorting
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+      Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+      T.translation() = Eigen::Vector3s::Random() * 4.0;
+      T.linear() = math::expMapRot(Eigen::Vector3s::Random());
+      frames[i]->setRelativeTransform(T);
+    }
+
+    collision::CollisionResult result;
+    group->collide(option, &result);
+
+    // Count the contacts by checking every pair on its own
+    std::size_t pairwiseContacts = 0;
+    for (std::size_t i = 0; i < frames.size(); i++)
+    {
+      for (std::size_t j = i + 1; j < frames.size(); j++)
+      {
+        auto pairGroup
+            = cd->createCollisionGroup(frames[i].get(), frames[j].get());
+        collision::CollisionResult pairResult;
+        pairGroup->collide(option, &pairResult);
+        pairwiseContacts += pairResult.getNumContacts();
+      }
+    }
+
+    EXPECT_TRUE(result.getNumContacts() > 0u);
+    EXPECT_EQ(pairwiseContacts, result.getNumContacts());
+  }
+}
+
+//==============================================================================
+TEST_F(Collision, ContactCacheReusesRestingContacts)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto ground = SimpleFrame::createShared(Frame::World());
+  ground->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(10, 1, 10)));
+  auto box = SimpleFrame::createShared(Frame::World());
+  box->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 1, 1)));
+  box->setTranslation(Eigen::Vector3s(0, 0.99, 0));
+
+  auto group = cd->createCollisionGroup(ground.get(), box.get());
+  auto dartGroup = static_cast<DARTCollisionGroup*>(group.get());
+  ContactCache& cache = dartGroup->getContactCache();
+
+  collision::CollisionOption option;
+  collision::CollisionResult first;
+  group->collide(option, &first);
+  EXPECT_TRUE(first.getNumContacts() > 0u);
+  EXPECT_EQ(1u, cache.getNumEntries());
+  EXPECT_EQ(0u, cache.getNumReusedManifolds());
+
+  // Nothing moved, so we get exactly the same contacts back without running
+  // the narrowphase
+  collision::CollisionResult second;
+  group->collide(option, &second);
+  EXPECT_EQ(1u, cache.getNumReusedManifolds());
+  ASSERT_EQ(first.getNumContacts(), second.getNumContacts());
+  for (std::size_t i = 0; i < first.getNumContacts(); i++)
+  {
+    EXPECT_EQ(first.getContact(i).point, second.getContact(i).point);
+    EXPECT_EQ(first.getContact(i).normal, second.getContact(i).normal);
+  }
+
+  // Once the box moves, we have to run the narrowphase again
+  box->setTranslation(Eigen::Vector3s(0.1, 0.98, 0));
+  collision::CollisionResult third;
+  group->collide(option, &third);
+  EXPECT_EQ(1u, cache.getNumReusedManifolds());
+  EXPECT_TRUE(third.getNumContacts() > 0u);
+
+  // Unless it only moved a little, and we've said that's ok
+  cache.setManifoldReuseTolerance(1e-3);
+  group->collide(option, &third);
+  box->setTranslation(Eigen::Vector3s(0.1005, 0.98, 0));
+  collision::CollisionResult fourth;
+  group->collide(option, &fourth);
+  EXPECT_EQ(2u, cache.getNumReusedManifolds());
+  EXPECT_EQ(third.getNumContacts(), fourth.getNumContacts());
+
+  // Resizing a shape throws out the old contacts
+  std::static_pointer_cast<BoxShape>(box->getShape())
+      ->setSize(Eigen::Vector3s(1, 1.2, 1));
+  collision::CollisionResult fifth;
+  group->collide(option, &fifth);
+  EXPECT_EQ(2u, cache.getNumReusedManifolds());
+
+  // Copies keep the settings, but not the entries
+  ContactCache copy(cache);
+  EXPECT_EQ(0u, copy.getNumEntries());
+  EXPECT_EQ(cache.getManifoldReuseTolerance(), copy.getManifoldReuseTolerance());
+
+  group->removeShapeFrame(box.get());
+  EXPECT_EQ(0u, cache.getNumEntries());
+}
+
+//==============================================================================
+TEST_F(Collision, ParallelNarrowphaseMatchesSerial)
+{
+  auto serialCd = DARTCollisionDetector::create();
+  auto parallelCd = DARTCollisionDetector::create();
+  parallelCd->setNumCollisionThreads(4);
+  EXPECT_EQ(1, serialCd->getNumCollisionThreads());
+  EXPECT_EQ(4, parallelCd->getNumCollisionThreads());
+
+  // Enough overlapping shapes that the parallel detector actually splits the
+  // pairs across threads
+  srand(7);
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  for (int i = 0; i < 120; i++)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    if (i % 3 == 0)
+      frame->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 0.5, 1)));
+    else if (i % 3 == 1)
+      frame->setShape(std::make_shared<SphereShape>(0.5));
+    else
+      frame->setShape(std::make_shared<CapsuleShape>(0.3, 0.8));
+    frames.push_back(frame);
+  }
+
+  auto serialGroup = serialCd->createCollisionGroup();
+  auto parallelGroup = parallelCd->createCollisionGroup();
+  for (auto& frame : frames)
+  {
+    serialGroup->addShapeFrame(frame.get());
+    parallelGroup->addShapeFrame(frame.get());
+  }
+
+  collision::CollisionOption option;
+  option.maxNumContacts = 100000u;
+
+  for (int step = 0; step < 3; step++)
+  {
+    for (auto& frame : frames)
+    {
+      Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+      T.translation() = Eigen::Vector3s::Random() * 3.0;
+      T.linear() = math::expMapRot(Eigen::Vector3s::Random());
+      frame->setRelativeTransform(T);
+    }
+
+    collision::CollisionResult serialResult;
+    collision::CollisionResult parallelResult;
+    serialGroup->collide(option, &serialResult);
+    parallelGroup->collide(option, &parallelResult);
+
+    EXPECT_TRUE(serialResult.getNumContacts() > 0u);
+    ASSERT_EQ(serialResult.getNumContacts(), parallelResult.getNumContacts());
+    for (std::size_t i = 0; i < serialResult.getNumContacts(); i++)
+    {
+      const auto& a = serialResult.getContact(i);
+      const auto& b = parallelResult.getContact(i);
+      EXPECT_EQ(
+          a.collisionObject1->getShapeFrame(),
+          b.collisionObject1->getShapeFrame());
+      EXPECT_EQ(
+          a.collisionObject2->getShapeFrame(),
+          b.collisionObject2->getShapeFrame());
+      EXPECT_EQ(a.point, b.point);
+      EXPECT_EQ(a.normal, b.normal);
+      EXPECT_EQ(a.penetrationDepth, b.penetrationDepth);
+    }
+
+    // The binary check agrees too
+    EXPECT_EQ(serialGroup->collide(), parallelGroup->collide());
+  }
+}
+
+//==============================================================================
+TEST_F(Collision, ReduceContactsKeepsCorners)
+{
+  // A 5x5 grid of contacts on the ground, with the deepest one in the middle
+  std::vector<collision::Contact> contacts;
+  for (int x = -2; x <= 2; x++)
+  {
+    for (int z = -2; z <= 2; z++)
+    {
+      collision::Contact contact;
+      contact.point = Eigen::Vector3s(x * 0.1, 0, z * 0.1);
+      contact.normal = Eigen::Vector3s::UnitY();
+      contact.penetrationDepth = (x == 0 && z == 0) ? 0.02 : 0.01;
+      contacts.push_back(contact);
+    }
+  }
+
+  auto reduced = collision::reduceContacts(contacts, 4);
+  ASSERT_EQ(4u, reduced.size());
+  // We keep the deepest contact, and then the three corners that span the
+  // most area with it
+  int numCorners = 0;
+  bool keptDeepest = false;
+  for (const auto& contact : reduced)
+  {
+    if (contact.penetrationDepth == 0.02)
+      keptDeepest = true;
+    if (std::abs(std::abs(contact.point(0)) - 0.2) < 1e-12
+        && std::abs(std::abs(contact.point(2)) - 0.2) < 1e-12)
+      numCorners++;
+  }
+  EXPECT_TRUE(keptDeepest);
+  EXPECT_EQ(3, numCorners);
+
+  // Contacts that are all on top of each other collapse to just one
+  std::vector<collision::Contact> stacked(10, contacts[0]);
+  EXPECT_EQ(1u, collision::reduceContacts(stacked, 4).size());
+
+  // Asking for at least as many as we have keeps everything, in order
+  auto all = collision::reduceContacts(contacts, 100);
+  ASSERT_EQ(contacts.size(), all.size());
+  for (std::size_t i = 0; i < all.size(); i++)
+    EXPECT_EQ(contacts[i].point, all[i].point);
+
+  // Resting a box on the ground, the collision option caps the contacts
+  auto cd = DARTCollisionDetector::create();
+  auto ground = SimpleFrame::createShared(Frame::World());
+  ground->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(10, 1, 10)));
+  auto box = SimpleFrame::createShared(Frame::World());
+  box->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 1, 1)));
+  box->setTranslation(Eigen::Vector3s(0, 0.99, 0));
+  auto group = cd->createCollisionGroup(ground.get(), box.get());
+
+  collision::CollisionOption option;
+  collision::CollisionResult full;
+  group->collide(option, &full);
+
+  option.maxNumContactsPerPair = 2u;
+  collision::CollisionResult capped;
+  group->collide(option, &capped);
+  EXPECT_TRUE(capped.getNumContacts() > 0u);
+  EXPECT_TRUE(capped.getNumContacts() <= 2u);
+  EXPECT_TRUE(capped.getNumContacts() <= full.getNumContacts());
+}
+
+//==============================================================================
+TEST_F(Collision, HeightmapPrimitives)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A flat 2m x 2m terrain with 10cm cells and a 5cm bump in the middle
+  auto terrainShape = std::make_shared<HeightmapShapef>();
+  HeightmapShapef::HeightField heights
+      = HeightmapShapef::HeightField::Zero(21, 21);
+  heights(10, 10) = 0.05f;
+  terrainShape->setHeightField(heights);
+  terrainShape->setScale(Eigen::Vector3f(0.1f, 0.1f, 1.0f));
+  auto terrain = SimpleFrame::createShared(Frame::World());
+  terrain->setShape(terrainShape);
+
+  auto other = SimpleFrame::createShared(Frame::World());
+  auto group = cd->createCollisionGroup(terrain.get(), other.get());
+  collision::CollisionOption option;
+  // Let deep contacts through, so we can check the depth of a sphere whose
+  // center is under the surface
+  option.contactClippingDepth = 0.5;
+  collision::CollisionResult result;
+
+  auto expectPushedUp = [&](const collision::Contact& contact, s_t depth) {
+    // The normal pushes the first object away from the second
+    const s_t sign = contact.collisionObject1->getShapeFrame() == other.get()
+                         ? 1.0
+                         : -1.0;
+    const Eigen::Vector3s up = Eigen::Vector3s::UnitZ();
+    EXPECT_TRUE(equals(Eigen::Vector3s(sign * contact.normal), up));
+    EXPECT_NEAR(depth, contact.penetrationDepth, 1e-6);
+  };
+
+  // A sphere resting on the flat part
+  other->setShape(std::make_shared<SphereShape>(0.1));
+  other->setTranslation(Eigen::Vector3s(0.53, -0.27, 0.09));
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(1u, result.getNumContacts());
+  expectPushedUp(result.getContact(0), 0.01);
+
+  // ... on top of the bump
+  result.clear();
+  other->setTranslation(Eigen::Vector3s(0, 0, 0.13));
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(1u, result.getNumContacts());
+  expectPushedUp(result.getContact(0), 0.02);
+
+  // ... sunk below the surface, right over a grid vertex
+  result.clear();
+  other->setTranslation(Eigen::Vector3s(0.3, 0, -0.05));
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(1u, result.getNumContacts());
+  expectPushedUp(result.getContact(0), 0.15);
+
+  // ... and clear of the terrain, or off the edge of it
+  result.clear();
+  other->setTranslation(Eigen::Vector3s(0.53, -0.27, 0.11));
+  EXPECT_FALSE(group->collide(option, &result));
+  other->setTranslation(Eigen::Vector3s(3, 0, 0));
+  EXPECT_FALSE(group->collide(option, &result));
+
+  // A box resting on the flat part only touches at its four bottom corners
+  other->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(0.2, 0.2, 0.2)));
+  other->setTranslation(Eigen::Vector3s(-0.25, -0.25, 0.09));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(4u, result.getNumContacts());
+  for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    expectPushedUp(result.getContact(i), 0.01);
+
+  // On top of the bump, the tip of the bump pokes into the bottom face
+  other->setTranslation(Eigen::Vector3s(0, 0, 0.11));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  bool foundBump = false;
+  for (std::size_t i = 0; i < result.getNumContacts(); i++)
+  {
+    const collision::Contact& contact = result.getContact(i);
+    if (std::abs(contact.penetrationDepth - 0.04) < 1e-6)
+    {
+      foundBump = true;
+      expectPushedUp(contact, 0.04);
+    }
+  }
+  EXPECT_TRUE(foundBump);
+
+  // A capsule lying flat touches all along its length
+  other->setShape(std::make_shared<CapsuleShape>(0.05, 0.4));
+  other->setTransform(Eigen::Isometry3s::Identity());
+  other->setRotation(math::eulerXYZToMatrix(Eigen::Vector3s(0, M_PI / 2, 0)));
+  other->setTranslation(Eigen::Vector3s(0.5, 0.5, 0.04));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_TRUE(result.getNumContacts() >= 2u);
+  for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    expectPushedUp(result.getContact(i), 0.01);
+}
+
+//==============================================================================
+TEST_F(Collision, PointCloudPrimitives)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A 1m x 1m floor of points 5cm apart, each a ball 2cm across
+  auto cloudShape = std::make_shared<PointCloudShape>(0.02);
+  for (int i = -10; i <= 10; i++)
+  {
+    for (int j = -10; j <= 10; j++)
+      cloudShape->addPoint(Eigen::Vector3s(i * 0.05, j * 0.05, 0));
+  }
+  auto cloud = SimpleFrame::createShared(Frame::World());
+  cloud->setShape(cloudShape);
+
+  auto other = SimpleFrame::createShared(Frame::World());
+  auto group = cd->createCollisionGroup(cloud.get(), other.get());
+  collision::CollisionOption option;
+  collision::CollisionResult result;
+
+  // A sphere right over a point only touches that point
+  other->setShape(std::make_shared<SphereShape>(0.1));
+  other->setTranslation(Eigen::Vector3s(0.1, -0.2, 0.105));
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(1u, result.getNumContacts());
+  EXPECT_NEAR(0.005, result.getContact(0).penetrationDepth, 1e-6);
+  EXPECT_NEAR(1.0, std::abs(result.getContact(0).normal.z()), 1e-6);
+
+  // A box resting on the floor touches every point under it
+  other->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(0.2, 0.2, 0.2)));
+  other->setTranslation(Eigen::Vector3s(0.01, 0.01, 0.105));
+  result.clear();
+  EXPECT_TRUE(group->collide(option, &result));
+  EXPECT_EQ(16u, result.getNumContacts());
+  for (std::size_t i = 0; i < result.getNumContacts(); i++)
+    EXPECT_NEAR(0.005, result.getContact(i).penetrationDepth, 1e-6);
+
+  // Nothing touches once it's lifted clear, or moved off the edge
+  result.clear();
+  other->setTranslation(Eigen::Vector3s(0.01, 0.01, 0.12));
+  EXPECT_FALSE(group->collide(option, &result));
+  other->setTranslation(Eigen::Vector3s(2, 0, 0.105));
+  EXPECT_FALSE(group->collide(option, &result));
+}
+
+//==============================================================================
+TEST_F(Collision, ContinuousCollisionCatchesTunneling)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  // A thin plate, and a small sphere moving fast enough to pass all the way
+  // through it in a single step
+  auto plate = SimpleFrame::createShared(Frame::World());
+  plate->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 0.01, 1)));
+  auto sphere = SimpleFrame::createShared(Frame::World());
+  sphere->setShape(std::make_shared<SphereShape>(0.05));
+  sphere->setTranslation(Eigen::Vector3s(0.1, 0.2, 0));
+  sphere->setClassicDerivatives(Eigen::Vector3s(0, -30, 0));
+
+  auto group = cd->createCollisionGroup(plate.get(), sphere.get());
+  const s_t timeStep = 0.01;
+
+  // Right now, they're nowhere near each other
+  collision::CollisionOption option;
+  collision::CollisionResult discrete;
+  EXPECT_FALSE(group->collide(option, &discrete));
+
+  option.continuousCollisionTimeStep = timeStep;
+  collision::CollisionResult result;
+  EXPECT_TRUE(group->collide(option, &result));
+  ASSERT_EQ(1u, result.getNumContacts());
+  const collision::Contact& contact = result.getContact(0);
+
+  // The normal pushes the sphere back up, and the depth is the gap between
+  // the bottom of the sphere and the top of the plate
+  const s_t up
+      = contact.collisionObject1->getShapeFrame() == sphere.get() ? 1 : -1;
+  EXPECT_TRUE(equals(
+      contact.normal, Eigen::Vector3s(0, up, 0), static_cast<s_t>(1e-6)));
+  EXPECT_NEAR(-0.145, contact.penetrationDepth, 1e-3);
+  EXPECT_NEAR(0.1, contact.point(0), 1e-3);
+  EXPECT_NEAR(0.0775, contact.point(1), 1e-3);
+
+  // A quarter of the time step isn't long enough to reach the plate
+  option.continuousCollisionTimeStep = timeStep / 4;
+  EXPECT_FALSE(group->collide(option, &result));
+
+  // Neither is moving away from it
+  option.continuousCollisionTimeStep = timeStep;
+  sphere->setClassicDerivatives(Eigen::Vector3s(0, 30, 0));
+  EXPECT_FALSE(group->collide(option, &result));
+}
+
+//==============================================================================
+TEST_F(Collision, DartDistance)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  auto box = SimpleFrame::createShared(Frame::World());
+  box->setShape(std::make_shared<BoxShape>(Eigen::Vector3s(1, 1, 1)));
+  auto sphere = SimpleFrame::createShared(Frame::World());
+  sphere->setShape(std::make_shared<SphereShape>(0.5));
+  sphere->setTranslation(Eigen::Vector3s(2, 0, 0));
+  auto farSphere = SimpleFrame::createShared(Frame::World());
+  farSphere->setShape(std::make_shared<SphereShape>(0.5));
+  farSphere->setTranslation(Eigen::Vector3s(10, 0, 0));
+
+  auto group
+      = cd->createCollisionGroup(box.get(), sphere.get(), farSphere.get());
+
+  collision::DistanceOption option;
+  option.enableNearestPoints = true;
+  collision::DistanceResult result;
+
+  // The second query starts from the closest features the first one found,
+  // and should land on the same answer
+  for (int i = 0; i < 2; i++)
+  {
+    EXPECT_NEAR(1.0, group->distance(option, &result), 1e-6);
+    ASSERT_TRUE(result.found());
+    EXPECT_NEAR(1.0, result.unclampedMinDistance, 1e-6);
+    const bool boxFirst = result.shapeFrame1 == box.get();
+    EXPECT_EQ(boxFirst ? sphere.get() : box.get(), result.shapeFrame2);
+    const Eigen::Vector3s& onBox
+        = boxFirst ? result.nearestPoint1 : result.nearestPoint2;
+    const Eigen::Vector3s& onSphere
+        = boxFirst ? result.nearestPoint2 : result.nearestPoint1;
+    EXPECT_TRUE(equals(
+        onBox, Eigen::Vector3s(0.5, 0, 0), static_cast<s_t>(1e-6)));
+    EXPECT_TRUE(equals(
+        onSphere, Eigen::Vector3s(1.5, 0, 0), static_cast<s_t>(1e-6)));
+  }
+
+  // Nothing is within the upper bound
+  option.distanceUpperBound = 0.5;
+  EXPECT_NEAR(0.0, group->distance(option, &result), 1e-6);
+  EXPECT_FALSE(result.found());
+
+  // Once the sphere sinks into the box, the distance is minus the
+  // penetration depth, which the lower bound clamps
+  option.distanceUpperBound = std::numeric_limits<s_t>::infinity();
+  sphere->setTranslation(Eigen::Vector3s(0.9, 0, 0));
+  EXPECT_NEAR(0.0, group->distance(option, &result), 1e-6);
+  ASSERT_TRUE(result.found());
+  EXPECT_NEAR(-0.1, result.unclampedMinDistance, 1e-6);
+
+  option.distanceLowerBound = -std::numeric_limits<double>::infinity();
+  EXPECT_NEAR(-0.1, group->distance(option, &result), 1e-6);
+}
+#endif
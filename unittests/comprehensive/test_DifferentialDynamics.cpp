@@ -636,6 +636,38 @@ x);
                  << std::endl;
           }
         }
+
+        // Test the recursive derivative of forward dynamics against the matrix
+        // path (and finite differences, for position, like the test above)
+        {
+          Eigen::MatrixXs DFD_Dq_recursive
+              = skel->getJacobianOfFD_ID(neural::WithRespectTo::POSITION);
+          EXPECT_TRUE(equals(
+              DFD_Dq_recursive,
+              skel->getJacobianOfFD(neural::WithRespectTo::POSITION),
+              abs_tol_invM,
+              rel_tol_invM));
+          EXPECT_TRUE(equals(
+              DFD_Dq_recursive,
+              skel->finiteDifferenceJacobianOfFD(
+                  neural::WithRespectTo::POSITION),
+              abs_tol_invM,
+              rel_tol_invM));
+
+          Eigen::MatrixXs DFD_Ddq_recursive
+              = skel->getJacobianOfFD_ID(neural::WithRespectTo::VELOCITY);
+          EXPECT_TRUE(equals(
+              DFD_Ddq_recursive,
+              skel->getJacobianOfFD(neural::WithRespectTo::VELOCITY),
+              abs_tol_invM,
+              rel_tol_invM));
+
+          EXPECT_TRUE(equals(
+              skel->getJacobianOfFD_ID(neural::WithRespectTo::FORCE),
+              Eigen::MatrixXs(skel->getInvMassMatrix()),
+              abs_tol_invM,
+              rel_tol_invM));
+        }
       }
     }
   }
@@ -10,6 +10,7 @@
 
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/proto/GUI.pb.h"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIRecording.hpp"
 
@@ -117,3 +118,34 @@ TEST(RECORDING, GUI_SERVER)
   // recording.saveFramesJson("./atlas_recording.json");
 }
 #endif
+
+#ifdef ALL_TESTS
+TEST(RECORDING, CHUNKED_SEEK)
+{
+  GUIRecording recording;
+  recording.setKeyframeInterval(10);
+  recording.createBox(
+      "box",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  for (int i = 0; i < 25; i++)
+  {
+    recording.setObjectPosition("box", Eigen::Vector3s::UnitX() * i);
+    recording.saveFrame();
+  }
+  recording.writeFramesChunked("./chunked_recording.bin");
+
+  // Seeking to frame 13 should decode the keyframe at 10 plus frames 11-13,
+  // and leave the box where frame 13 put it
+  proto::CommandList list;
+  EXPECT_TRUE(list.ParseFromString(
+      GUIRecording::readChunkedFrame("./chunked_recording.bin", 13)));
+  EXPECT_TRUE(list.command(0).has_clear_all());
+  const proto::Command& last = list.command(list.command_size() - 1);
+  ASSERT_TRUE(last.has_set_object_position());
+  EXPECT_EQ(13.0f, last.set_object_position().data(0));
+
+  EXPECT_EQ("", GUIRecording::readChunkedFrame("./chunked_recording.bin", 25));
+}
+#endif
@@ -42,6 +42,7 @@
 
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/proto/GUI.pb.h"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
 
@@ -312,4 +313,244 @@ TEST(REALTIME, GUI_SERVER_2)
 
   server.blockWhileServing();
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, GUI_SERVER_HOSTED_SCENES)
+{
+  GUIWebsocketServer host;
+  std::shared_ptr<GUIWebsocketServer> sceneA
+      = std::make_shared<GUIWebsocketServer>();
+  std::shared_ptr<GUIWebsocketServer> sceneB
+      = std::make_shared<GUIWebsocketServer>();
+
+  // Scenes can be added before the host starts, and only serve once it does
+  host.serveScene("/a", sceneA);
+  EXPECT_FALSE(sceneA->isServing());
+  host.serve(8071);
+  for (int i = 0; i < 100 && !host.isServing(); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(host.isServing());
+  EXPECT_TRUE(sceneA->isServing());
+
+  host.serveScene("/b", sceneB);
+  EXPECT_TRUE(sceneB->isServing());
+  EXPECT_EQ(host.getScenePaths(), std::vector<std::string>({"/a", "/b"}));
+
+  // A hosted scene can't also serve on its own port, and the host's own path
+  // can't be taken
+  sceneA->serve(8072);
+  host.serveScene("/", std::make_shared<GUIWebsocketServer>());
+  EXPECT_EQ(host.getScenePaths().size(), 2);
+
+  sceneA->createBox(
+      "box",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector4s(1, 0, 0, 1));
+  EXPECT_EQ(sceneA->getConnectionStats().size(), 0);
+
+  // Stopping a hosted scene just detaches it
+  sceneA->stopServing();
+  EXPECT_FALSE(sceneA->isServing());
+  EXPECT_TRUE(host.isServing());
+  EXPECT_EQ(host.getScenePaths(), std::vector<std::string>({"/b"}));
+
+  host.stopServing();
+  EXPECT_FALSE(sceneB->isServing());
+  host.stopServingScene("/b");
+  EXPECT_EQ(host.getScenePaths().size(), 0);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(GUI_STATE_MACHINE, PACKED_TRANSFORMS)
+{
+  GUIStateMachine gui;
+  gui.createBox(
+      "box1",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  gui.createBox(
+      "box2",
+      Eigen::Vector3s::Ones(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  gui.flushJson();
+
+  gui.setPackedTransformsEnabled(true);
+  gui.setObjectPosition("box1", Eigen::Vector3s(1, 2, 3));
+  gui.setObjectRotation("box1", Eigen::Vector3s(0.1, 0.2, 0.3));
+  gui.setObjectPosition("box2", Eigen::Vector3s(4, 5, 6));
+  // Repeated updates to the same object overwrite the pending value
+  gui.setObjectPosition("box1", Eigen::Vector3s(7, 8, 9));
+  // Any other command flushes the pending transforms ahead of it
+  gui.setObjectColor("box1", Eigen::Vector4s(1, 0, 0, 1));
+  gui.setObjectPosition("box2", Eigen::Vector3s(10, 11, 12));
+
+  proto::CommandList list;
+  EXPECT_TRUE(list.ParseFromString(gui.flushJson()));
+  ASSERT_EQ(4, list.command_size());
+
+  const proto::SetObjectPositions& positions
+      = list.command(0).set_object_positions();
+  ASSERT_EQ(2, positions.key_size());
+  EXPECT_EQ(gui.getStringCode("box1"), positions.key(0));
+  EXPECT_EQ(gui.getStringCode("box2"), positions.key(1));
+  ASSERT_EQ(6, positions.data_size());
+  EXPECT_EQ(7.0f, positions.data(0));
+  EXPECT_EQ(9.0f, positions.data(2));
+  EXPECT_EQ(4.0f, positions.data(3));
+
+  const proto::SetObjectRotations& rotations
+      = list.command(1).set_object_rotations();
+  ASSERT_EQ(1, rotations.key_size());
+  EXPECT_EQ(0.2f, rotations.data(1));
+
+  EXPECT_TRUE(list.command(2).has_set_object_color());
+  EXPECT_EQ(10.0f, list.command(3).set_object_positions().data(0));
+
+  // The state machine still tracks the latest pose for reconnecting clients
+  EXPECT_EQ(Eigen::Vector3s(7, 8, 9), gui.getObjectPosition("box1"));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(GUI_STATE_MACHINE, SHARED_MESH_GEOMETRY)
+{
+  std::vector<Eigen::Vector3s> vertices;
+  vertices.push_back(Eigen::Vector3s(0, 0, 0));
+  vertices.push_back(Eigen::Vector3s(1, 0, 0));
+  vertices.push_back(Eigen::Vector3s(0, 1, 0));
+  std::vector<Eigen::Vector3s> normals(3, Eigen::Vector3s::UnitZ());
+  std::vector<Eigen::Vector3i> faces;
+  faces.push_back(Eigen::Vector3i(0, 1, 2));
+  std::vector<Eigen::Vector2s> uv;
+  std::vector<std::string> textures;
+  std::vector<int> textureStartIndices;
+
+  GUIStateMachine gui;
+  gui.createMesh(
+      "mesh1",
+      vertices,
+      normals,
+      faces,
+      uv,
+      textures,
+      textureStartIndices,
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+  gui.createMesh(
+      "mesh2",
+      vertices,
+      normals,
+      faces,
+      uv,
+      textures,
+      textureStartIndices,
+      Eigen::Vector3s::UnitX(),
+      Eigen::Vector3s::Zero());
+
+  proto::CommandList list;
+  EXPECT_TRUE(list.ParseFromString(gui.flushJson()));
+  ASSERT_EQ(2, list.command_size());
+  const proto::CreateMesh& first = list.command(0).mesh();
+  const proto::CreateMesh& second = list.command(1).mesh();
+  // Only the first mesh carries the vertex data, the second references it
+  EXPECT_EQ(first.geometry(), second.geometry());
+  EXPECT_EQ(9, first.vertex_size());
+  EXPECT_EQ(0, second.vertex_size());
+  EXPECT_EQ(0, second.face_size());
+
+  // A reconnecting client gets the geometry exactly once in the snapshot
+  proto::CommandList snapshot;
+  EXPECT_TRUE(snapshot.ParseFromString(gui.getCurrentStateAsJson()));
+  int withVertices = 0;
+  for (int i = 0; i < snapshot.command_size(); i++)
+  {
+    if (snapshot.command(i).has_mesh()
+        && snapshot.command(i).mesh().vertex_size() > 0)
+      withVertices++;
+  }
+  EXPECT_EQ(1, withVertices);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(GUI_STATE_MACHINE, MESH_LEVELS_OF_DETAIL)
+{
+  // A UV sphere with 32 rings of 32 vertices, which has 2048 faces
+  const int n = 32;
+  std::vector<Eigen::Vector3s> vertices;
+  vertices.push_back(Eigen::Vector3s::UnitZ());
+  vertices.push_back(-Eigen::Vector3s::UnitZ());
+  for (int ring = 0; ring < n; ring++)
+  {
+    const s_t phi = M_PI * (ring + 1) / (n + 1);
+    for (int i = 0; i < n; i++)
+    {
+      const s_t theta = 2 * M_PI * i / n;
+      vertices.push_back(Eigen::Vector3s(
+          sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi)));
+    }
+  }
+  std::vector<Eigen::Vector3i> faces;
+  for (int i = 0; i < n; i++)
+  {
+    const int next = (i + 1) % n;
+    const int last = 2 + (n - 1) * n;
+    faces.push_back(Eigen::Vector3i(0, 2 + i, 2 + next));
+    faces.push_back(Eigen::Vector3i(1, last + next, last + i));
+    for (int ring = 0; ring + 1 < n; ring++)
+    {
+      const int a = 2 + ring * n + i;
+      const int b = 2 + ring * n + next;
+      faces.push_back(Eigen::Vector3i(a, a + n, b));
+      faces.push_back(Eigen::Vector3i(b, a + n, b + n));
+    }
+  }
+
+  GUIStateMachine gui;
+  gui.setInitialMeshLevelOfDetail(2);
+  gui.createMesh(
+      "sphere",
+      vertices,
+      vertices,
+      faces,
+      std::vector<Eigen::Vector2s>(),
+      std::vector<std::string>(),
+      std::vector<int>(),
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::Zero());
+
+  proto::CommandList list;
+  EXPECT_TRUE(list.ParseFromString(gui.flushJson()));
+  ASSERT_EQ(1, list.command_size());
+  const int numFaces = list.command(0).mesh().face_size() / 3;
+  EXPECT_LE(numFaces, faces.size() / 16);
+  EXPECT_GE(numFaces, faces.size() / 32);
+  EXPECT_EQ(
+      list.command(0).mesh().vertex_size(),
+      list.command(0).mesh().vertex_normal_size());
+
+  // A mesh that's big on screen gets sent in full
+  gui.setMeshScreenSize("sphere", 1000);
+  EXPECT_EQ(0, gui.getMeshLevelOfDetail("sphere"));
+  list.Clear();
+  EXPECT_TRUE(list.ParseFromString(gui.flushJson()));
+  ASSERT_EQ(1, list.command_size());
+  EXPECT_EQ(3 * (int)faces.size(), list.command(0).mesh().face_size());
+
+  // A tiny one drops to the coarsest level, and asking again sends nothing
+  gui.setMeshScreenSize("sphere", 1);
+  EXPECT_GT(gui.getMeshLevelOfDetail("sphere"), 0);
+  gui.setMeshScreenSize("sphere", 1);
+  list.Clear();
+  EXPECT_TRUE(list.ParseFromString(gui.flushJson()));
+  EXPECT_EQ(1, list.command_size());
+}
+#endif
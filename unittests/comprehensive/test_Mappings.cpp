@@ -357,4 +357,65 @@ TEST(GRADIENTS, WORLD_SPACE_BOXES_FREE_JOINT)
 {
   testWorldSpaceWithBoxes(2);
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(GRADIENTS, IK_MAPPING_TRAJECTORY_BATCH)
+{
+  WorldPtr world = World::create();
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint*, BodyNode*> boxJointPair
+      = box->createJointAndBodyNodePair<TranslationalJoint>(nullptr);
+  Eigen::Isometry3s fromChild = Eigen::Isometry3s::Identity();
+  fromChild.translation() = Eigen::Vector3s(0.1, 0.2, 0.3);
+  boxJointPair.first->setTransformFromChildBodyNode(fromChild);
+  world->addSkeleton(box);
+
+  std::shared_ptr<IKMapping> mapping = std::make_shared<IKMapping>(world);
+  mapping->addLinearBodyNode(boxJointPair.second);
+
+  int steps = 10;
+  Eigen::MatrixXs realPoses = Eigen::MatrixXs::Random(3, steps);
+  Eigen::MatrixXs realVels = Eigen::MatrixXs::Random(3, steps);
+  Eigen::MatrixXs realForces = Eigen::MatrixXs::Random(3, steps);
+  Eigen::VectorXs originalPos = world->getPositions();
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(3, steps);
+  Eigen::MatrixXs vels = Eigen::MatrixXs::Zero(3, steps);
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(3, steps);
+  mapping->mapTrajectory(
+      world, realPoses, realVels, realForces, poses, vels, forces);
+  EXPECT_EQ(world->getPositions(), originalPos);
+
+  // The batch should agree with mapping each timestep on its own
+  for (int i = 0; i < steps; i++)
+  {
+    world->setPositions(realPoses.col(i));
+    world->setVelocities(realVels.col(i));
+    world->setControlForces(realForces.col(i));
+    Eigen::VectorXs pos = poses.col(i);
+    Eigen::VectorXs vel = vels.col(i);
+    Eigen::VectorXs force = forces.col(i);
+    EXPECT_TRUE(equals(mapping->getPositions(world), pos, 1e-12));
+    EXPECT_TRUE(equals(mapping->getVelocities(world), vel, 1e-12));
+    EXPECT_TRUE(equals(mapping->getControlForces(world), force, 1e-12));
+  }
+  world->setPositions(originalPos);
+
+  // This IK is fully specified, so going back should recover the real states
+  Eigen::MatrixXs recoveredPoses = Eigen::MatrixXs::Zero(3, steps);
+  Eigen::MatrixXs recoveredVels = Eigen::MatrixXs::Zero(3, steps);
+  Eigen::MatrixXs recoveredForces = Eigen::MatrixXs::Zero(3, steps);
+  mapping->unmapTrajectory(
+      world,
+      poses,
+      vels,
+      forces,
+      recoveredPoses,
+      recoveredVels,
+      recoveredForces);
+  EXPECT_EQ(world->getPositions(), originalPos);
+  EXPECT_TRUE(equals(recoveredPoses, realPoses, 1e-8));
+  EXPECT_TRUE(equals(recoveredVels, realVels, 1e-8));
+  EXPECT_TRUE(equals(recoveredForces, realForces, 1e-8));
+}
+#endif
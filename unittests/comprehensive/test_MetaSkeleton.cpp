@@ -37,7 +37,10 @@
 #include "dart/common/sub_ptr.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/utils/SkelParser.hpp"
+#include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/IndexPlan.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/simulation/World.hpp"
@@ -835,3 +838,58 @@ TEST(MetaSkeleton, CloneReferentialSkeletons)
       branch->cloneMetaSkeleton());
   testReferentialSkeletonClone(branch, branchClone);
 }
+
+//==============================================================================
+TEST(MetaSkeleton, IndexPlanMatchesIndices)
+{
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* bn = skel->createJointAndBodyNodePair<FreeJoint>().second;
+  bn = skel->createJointAndBodyNodePair<BallJoint>(bn).second;
+  skel->createJointAndBodyNodePair<RevoluteJoint>(bn);
+
+  // Whole joints, partial joints, out of order DOFs and repeats
+  const std::vector<std::size_t> indices{0, 1, 2, 3, 4, 5, 7, 8, 9, 6, 1};
+  IndexPlan plan(skel.get(), indices);
+  EXPECT_EQ(plan.getNumDofs(), indices.size());
+  EXPECT_EQ(plan.getNumRuns(), 5u);
+
+  Eigen::VectorXs positions = Eigen::VectorXs::Random(skel->getNumDofs());
+  skel->setPositions(positions);
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setAccelerations(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setControlForces(Eigen::VectorXs::Random(skel->getNumDofs()));
+
+  EXPECT_TRUE(skel->getPositions(plan) == skel->getPositions(indices));
+  EXPECT_TRUE(skel->getVelocities(plan) == skel->getVelocities(indices));
+  EXPECT_TRUE(skel->getAccelerations(plan) == skel->getAccelerations(indices));
+  EXPECT_TRUE(
+      skel->getControlForces(plan) == skel->getControlForces(indices));
+
+  // Leave out the repeated DOF, since which write wins is up to the order
+  const std::vector<std::size_t> unique(indices.begin(), indices.end() - 1);
+  IndexPlan uniquePlan(skel.get(), unique);
+  const Eigen::VectorXs values = Eigen::VectorXs::Random(unique.size());
+
+  skel->setPositions(positions);
+  skel->setPositions(unique, values);
+  const Eigen::VectorXs expected = skel->getPositions();
+  skel->setPositions(positions);
+  skel->setPositions(uniquePlan, values);
+  EXPECT_TRUE(equals(skel->getPositions(), expected));
+
+  skel->setVelocities(uniquePlan, values);
+  EXPECT_TRUE(skel->getVelocities(unique) == values);
+  skel->setAccelerations(uniquePlan, values);
+  EXPECT_TRUE(skel->getAccelerations(unique) == values);
+  skel->setControlForces(uniquePlan, values);
+  EXPECT_TRUE(skel->getControlForces(unique) == values);
+
+  // Plans work the same on ReferentialSkeletons
+  GroupPtr group = Group::create(
+      "group",
+      std::vector<DegreeOfFreedom*>{
+          skel->getDof(0), skel->getDof(1), skel->getDof(9)});
+  IndexPlan groupPlan(group.get(), {0, 1, 2});
+  EXPECT_EQ(groupPlan.getNumRuns(), 2u);
+  EXPECT_TRUE(group->getPositions(groupPlan) == group->getPositions());
+}
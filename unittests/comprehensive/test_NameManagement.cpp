@@ -253,6 +253,35 @@ TEST(NameManagement, Regression554)
   EXPECT_TRUE( test_mgr.getObject("2") == int2 );
 }
 
+//==============================================================================
+TEST(NameManagement, ManyDuplicates)
+{
+  dart::common::NameManager< std::shared_ptr<int> > test_mgr("test", "name");
+
+  std::vector<std::shared_ptr<int>> ints;
+  for (int i = 0; i < 500; ++i)
+  {
+    ints.push_back(std::make_shared<int>(i));
+    test_mgr.issueNewNameAndAdd("robot", ints.back());
+  }
+  EXPECT_TRUE( test_mgr.getObject("robot") == ints[0] );
+  EXPECT_TRUE( test_mgr.getObject("robot(499)") == ints[499] );
+  EXPECT_EQ( test_mgr.issueNewName("robot"), "robot(500)" );
+
+  // A removed number gets issued again before any new ones
+  test_mgr.removeObject(ints[7]);
+  std::shared_ptr<int> another(new int(7));
+  EXPECT_EQ( test_mgr.issueNewNameAndAdd("robot", another), "robot(7)" );
+  EXPECT_EQ( test_mgr.issueNewName("robot"), "robot(500)" );
+
+  // Numbered names added by hand are skipped over
+  test_mgr.addName("robot(500)", std::make_shared<int>(500));
+  EXPECT_EQ( test_mgr.issueNewName("robot"), "robot(501)" );
+
+  EXPECT_TRUE( test_mgr.setPattern("%d-%s") );
+  EXPECT_EQ( test_mgr.issueNewName("robot"), "1-robot" );
+}
+
 //==============================================================================
 TEST(NameManagement, WorldSkeletons)
 {
@@ -52,6 +52,8 @@
 #include "dart/neural/NeuralConstants.hpp"
 #include "dart/neural/NeuralUtils.hpp"
 #include "dart/neural/RestorableSnapshot.hpp"
+#include "dart/neural/VecEnv.hpp"
+#include "dart/neural/WorldBatch.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
@@ -820,4 +822,328 @@ TEST(TRAJECTORY, JUMP_WORM)
       std::cout << "Off on force-vel Jac at step " << i << std::endl;
     }
   }
-}
\ No newline at end of file
+}
+
+TEST(WORLD_BATCH, MATCHES_SERIAL_FORWARD_PASS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  pair.second->setMass(1.0);
+  world->addSkeleton(box);
+
+  const int BATCH = 7;
+  WorldBatch batch(world, BATCH, 3);
+  EXPECT_EQ(batch.getBatchSize(), BATCH);
+  EXPECT_EQ(batch.getNumThreads(), 3);
+
+  Eigen::MatrixXs states
+      = Eigen::MatrixXs::Random(batch.getStateSize(), BATCH);
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(batch.getActionSize(), BATCH);
+
+  std::vector<std::shared_ptr<BackpropSnapshot>> snapshots
+      = batch.forwardPass(states, actions);
+  EXPECT_EQ(snapshots.size(), BATCH);
+  Eigen::MatrixXs nextStates = batch.getNextStates();
+
+  for (int i = 0; i < BATCH; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setState(states.col(i));
+    serial->setAction(actions.col(i));
+    std::shared_ptr<BackpropSnapshot> serialSnapshot
+        = neural::forwardPass(serial);
+    EXPECT_TRUE(equals(
+        (Eigen::VectorXs)nextStates.col(i), serial->getState(), 0.0));
+    EXPECT_TRUE(equals(
+        snapshots[i]->getVelVelJacobian(batch.getWorld(i)),
+        serialSnapshot->getVelVelJacobian(serial),
+        0.0));
+  }
+
+  // Stepping without snapshots should land in the same place
+  Eigen::MatrixXs steppedStates = batch.step(states, actions);
+  EXPECT_TRUE(equals(steppedStates, nextStates, 0.0));
+}
+
+TEST(WORLD_BATCH, BATCHED_BACKPROP_MATCHES_SERIAL)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  pair.first->setDampingCoefficient(0, 0.3);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  pair.second->setMass(2.0);
+  world->addSkeleton(box);
+
+  const int BATCH = 5;
+  WorldBatch batch(world, BATCH, 2);
+
+  Eigen::MatrixXs states
+      = Eigen::MatrixXs::Random(batch.getStateSize(), BATCH);
+  Eigen::MatrixXs actions
+      = Eigen::MatrixXs::Random(batch.getActionSize(), BATCH);
+  Eigen::MatrixXs lossWrtNextStates
+      = Eigen::MatrixXs::Random(batch.getStateSize(), BATCH);
+
+  std::shared_ptr<BatchSnapshot> snapshot = batch.timestep(states, actions);
+  EXPECT_EQ(snapshot->snapshots.size(), BATCH);
+  EXPECT_TRUE(equals(snapshot->nextStates, batch.getNextStates(), 0.0));
+
+  BatchLossGradient grad = batch.backprop(*snapshot, lossWrtNextStates);
+  ASSERT_EQ(grad.lossWrtStates.cols(), BATCH);
+  ASSERT_EQ(grad.lossWrtActions.cols(), BATCH);
+
+  for (int i = 0; i < BATCH; i++)
+  {
+    WorldPtr serial = world->clone();
+    serial->setState(states.col(i));
+    serial->setAction(actions.col(i));
+    std::shared_ptr<BackpropSnapshot> serialSnapshot
+        = neural::forwardPass(serial);
+    LossGradientHighLevelAPI serialGrad = serialSnapshot->backpropState(
+        serial, lossWrtNextStates.col(i));
+    EXPECT_TRUE(equals(
+        (Eigen::VectorXs)grad.lossWrtStates.col(i),
+        serialGrad.lossWrtState,
+        0.0));
+    EXPECT_TRUE(equals(
+        (Eigen::VectorXs)grad.lossWrtActions.col(i),
+        serialGrad.lossWrtAction,
+        0.0));
+  }
+}
+
+TEST(BACKPROP_SNAPSHOT, DEMAND_DRIVEN_BACKPROP_MATCHES_FULL)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  pair.first->setDampingCoefficient(0, 0.3);
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  pair.second->setMass(2.0);
+  world->addSkeleton(box);
+
+  world->setPositions(Eigen::Vector2s(0.1, 2.0));
+  world->setVelocities(Eigen::Vector2s(0.5, -0.3));
+  world->setControlForces(Eigen::Vector2s(1.0, 3.0));
+
+  std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(world);
+
+  LossGradient nextLoss;
+  nextLoss.lossWrtPosition = Eigen::VectorXs::Random(world->getNumDofs());
+  nextLoss.lossWrtVelocity = Eigen::VectorXs::Random(world->getNumDofs());
+  nextLoss.lossWrtTorque = Eigen::VectorXs::Zero(world->getNumDofs());
+  nextLoss.lossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+
+  // The reference answer, from the dense Jacobians
+  LossGradient full;
+  full.lossWrtPosition
+      = snapshot->getPosPosJacobian(world).transpose()
+            * nextLoss.lossWrtPosition
+        + snapshot->getPosVelJacobian(world).transpose()
+              * nextLoss.lossWrtVelocity;
+  full.lossWrtVelocity
+      = snapshot->getVelPosJacobian(world).transpose()
+            * nextLoss.lossWrtPosition
+        + snapshot->getVelVelJacobian(world).transpose()
+              * nextLoss.lossWrtVelocity;
+  full.lossWrtTorque = snapshot->getControlForceVelJacobian(world).transpose()
+                       * nextLoss.lossWrtVelocity;
+
+  std::vector<WithRespectTo*> wrts;
+  wrts.push_back(WithRespectTo::VELOCITY);
+  wrts.push_back(WithRespectTo::FORCE);
+  LossGradient partial;
+  snapshot->backpropWrt(world, partial, nextLoss, wrts);
+
+  EXPECT_TRUE(equals(partial.lossWrtVelocity, full.lossWrtVelocity, 1e-10));
+  EXPECT_TRUE(equals(partial.lossWrtTorque, full.lossWrtTorque, 1e-10));
+  // We didn't ask for position, so it should be left as zeros
+  EXPECT_TRUE(partial.lossWrtPosition.isZero());
+
+  // Asking for position on its own should match as well
+  wrts.clear();
+  wrts.push_back(WithRespectTo::POSITION);
+  snapshot->backpropWrt(world, partial, nextLoss, wrts);
+  EXPECT_TRUE(equals(partial.lossWrtPosition, full.lossWrtPosition, 1e-10));
+}
+
+TEST(BACKPROP_SNAPSHOT, PARALLEL_GROUP_BACKPROP_IS_DETERMINISTIC)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  std::pair<WeldJoint*, BodyNode*> floorJointPair
+      = floor->createJointAndBodyNodePair<WeldJoint>(nullptr);
+  Eigen::Isometry3s floorOffset = Eigen::Isometry3s::Identity();
+  floorOffset.translation() = Eigen::Vector3s(0, -0.5, 0);
+  floorJointPair.first->setTransformFromParentBodyNode(floorOffset);
+  std::shared_ptr<BoxShape> floorShape(
+      new BoxShape(Eigen::Vector3s(20.0, 1.0, 1.0)));
+  floorJointPair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(
+      floorShape);
+  world->addSkeleton(floor);
+
+  // Several boxes resting on the floor, far enough apart that each one ends up
+  // in its own constrained group
+  const int NUM_BOXES = 5;
+  for (int i = 0; i < NUM_BOXES; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<TranslationalJoint2D*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+    pair.first->setXYPlane();
+    std::shared_ptr<BoxShape> boxShape(
+        new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+    pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+    pair.second->setMass(1.0 + i);
+    world->addSkeleton(box);
+    box->setPositions(Eigen::Vector2s(3.0 * i - 6.0, 0.499));
+  }
+
+  std::shared_ptr<BackpropSnapshot> snapshot = neural::forwardPass(world);
+  EXPECT_GT(snapshot->getNumClamping(), 0);
+
+  LossGradient nextLoss;
+  nextLoss.lossWrtPosition = Eigen::VectorXs::Random(world->getNumDofs());
+  nextLoss.lossWrtVelocity = Eigen::VectorXs::Random(world->getNumDofs());
+  nextLoss.lossWrtTorque = Eigen::VectorXs::Zero(world->getNumDofs());
+  nextLoss.lossWrtMass = Eigen::VectorXs::Zero(world->getMassDims());
+
+  world->getConstraintSolver()->setNumGroupSolverThreads(1);
+  LossGradient serial;
+  snapshot->backprop(world, serial, nextLoss, nullptr, true);
+
+  world->getConstraintSolver()->setNumGroupSolverThreads(3);
+  LossGradient parallel;
+  snapshot->backprop(world, parallel, nextLoss, nullptr, true);
+
+  EXPECT_TRUE(equals(parallel.lossWrtPosition, serial.lossWrtPosition, 0.0));
+  EXPECT_TRUE(equals(parallel.lossWrtVelocity, serial.lossWrtVelocity, 0.0));
+  EXPECT_TRUE(equals(parallel.lossWrtTorque, serial.lossWrtTorque, 0.0));
+
+  // The groups' gradient matrices are built during the forward pass, so a
+  // snapshot from a parallel solve should backprop to the same answer. Both
+  // passes start from the same state, including the LCP warm start.
+  Eigen::VectorXs lcpCache = world->getCachedLCPSolution();
+  world->setPositions(snapshot->getPreStepPosition());
+  world->setVelocities(snapshot->getPreStepVelocity());
+  std::shared_ptr<BackpropSnapshot> parallelSnapshot
+      = neural::forwardPass(world);
+  LossGradient parallelForward;
+  parallelSnapshot->backprop(world, parallelForward, nextLoss);
+
+  world->getConstraintSolver()->setNumGroupSolverThreads(1);
+  world->setPositions(snapshot->getPreStepPosition());
+  world->setVelocities(snapshot->getPreStepVelocity());
+  world->setCachedLCPSolution(lcpCache);
+  std::shared_ptr<BackpropSnapshot> serialSnapshot
+      = neural::forwardPass(world);
+  LossGradient serialForward;
+  serialSnapshot->backprop(world, serialForward, nextLoss);
+
+  EXPECT_TRUE(equals(
+      parallelForward.lossWrtPosition, serialForward.lossWrtPosition, 0.0));
+  EXPECT_TRUE(equals(
+      parallelForward.lossWrtVelocity, serialForward.lossWrtVelocity, 0.0));
+  EXPECT_TRUE(
+      equals(parallelForward.lossWrtTorque, serialForward.lossWrtTorque, 0.0));
+}
+
+TEST(VEC_ENV, STEP_MATCHES_SERIAL_AND_AUTO_RESETS)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr box = Skeleton::create("box");
+  std::pair<TranslationalJoint2D*, BodyNode*> pair
+      = box->createJointAndBodyNodePair<TranslationalJoint2D>(nullptr);
+  pair.first->setXYPlane();
+  std::shared_ptr<BoxShape> boxShape(
+      new BoxShape(Eigen::Vector3s(1.0, 1.0, 1.0)));
+  pair.second->createShapeNodeWith<VisualAspect, CollisionAspect>(boxShape);
+  pair.second->setMass(1.0);
+  world->addSkeleton(box);
+
+  const int ENVS = 5;
+  const int STEPS = 3;
+  VecEnv env(world, ENVS, 2);
+  EXPECT_EQ(env.getNumEnvs(), ENVS);
+
+  Eigen::MatrixXs resetStates
+      = Eigen::MatrixXs::Random(env.getStateSize(), ENVS);
+  env.setResetStates(resetStates);
+  env.setMaxEpisodeSteps(STEPS);
+
+  VecEnv::RowMatrixXs observations(ENVS, env.getStateSize());
+  Eigen::VectorXi dones(ENVS);
+  env.reset(observations);
+
+  std::vector<WorldPtr> serial;
+  for (int i = 0; i < ENVS; i++)
+  {
+    EXPECT_TRUE(equals(
+        (Eigen::VectorXs)observations.row(i).transpose(),
+        (Eigen::VectorXs)resetStates.col(i),
+        0.0));
+    serial.push_back(world->clone());
+    serial[i]->setState(resetStates.col(i));
+  }
+
+  for (int t = 0; t < STEPS; t++)
+  {
+    VecEnv::RowMatrixXs actions
+        = VecEnv::RowMatrixXs::Random(ENVS, env.getActionSize());
+    env.step(actions, observations, dones);
+    for (int i = 0; i < ENVS; i++)
+    {
+      serial[i]->setAction(actions.row(i).transpose());
+      serial[i]->step();
+      if (t < STEPS - 1)
+      {
+        EXPECT_EQ(dones(i), 0);
+        EXPECT_TRUE(equals(
+            (Eigen::VectorXs)observations.row(i).transpose(),
+            serial[i]->getState(),
+            0.0));
+      }
+      else
+      {
+        // The time limit ends every episode at once, and each environment
+        // gets the next reset state in turn, which wraps back to the first
+        EXPECT_EQ(dones(i), 1);
+        EXPECT_TRUE(equals(
+            (Eigen::VectorXs)env.getTerminalObservations().row(i).transpose(),
+            serial[i]->getState(),
+            0.0));
+        EXPECT_TRUE(equals(
+            (Eigen::VectorXs)observations.row(i).transpose(),
+            (Eigen::VectorXs)resetStates.col(i),
+            0.0));
+        EXPECT_EQ(env.getEpisodeSteps()(i), 0);
+      }
+    }
+  }
+}
@@ -34,8 +34,10 @@
 #include <iostream>
 #include <thread>
 
+#include <google/protobuf/arena.h>
 #include <gtest/gtest.h>
 
+#include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/collision/CollisionObject.hpp"
 #include "dart/collision/Contact.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -63,6 +65,7 @@
 #include "dart/trajectory/Solution.hpp"
 #include "dart/trajectory/TrajectoryConstants.hpp"
 #include "dart/trajectory/TrajectoryRollout.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
 
 #include "GradientTestUtils.hpp"
 #include "TestHelpers.hpp"
@@ -97,6 +100,48 @@ TEST(PROTO, SERIALIZE_MATRIX)
   EXPECT_TRUE(equals(original, recovered, 0.0));
 }
 
+TEST(PROTO, SERIALIZE_MATRIX_BLOCK)
+{
+  // A block has an outer stride that doesn't match its rows, so this packs a
+  // column at a time
+  Eigen::MatrixXs parent = Eigen::MatrixXs::Random(10, 5);
+  proto::MatrixXs proto;
+  serializeMatrix(proto, parent.block(2, 1, 6, 3));
+  EXPECT_EQ(proto.data().size(), 6 * 3 * sizeof(double));
+  Eigen::MatrixXs recovered = deserializeMatrix(proto);
+
+  Eigen::MatrixXs block = parent.block(2, 1, 6, 3);
+  EXPECT_TRUE(equals(block, recovered, 0.0));
+
+  // Reserializing overwrites the old contents
+  Eigen::MatrixXs smaller = Eigen::MatrixXs::Random(2, 2);
+  serializeMatrix(proto, smaller);
+  EXPECT_TRUE(equals(smaller, deserializeMatrix(proto), 0.0));
+}
+
+TEST(PROTO, DESERIALIZE_LEGACY_VALUES)
+{
+  // Messages from before the packed `data` field still decode
+  Eigen::MatrixXs original = Eigen::MatrixXs::Random(3, 4);
+  proto::MatrixXs matrixProto;
+  matrixProto.set_rows(3);
+  matrixProto.set_cols(4);
+  for (int i = 0; i < original.size(); i++)
+  {
+    matrixProto.add_values(static_cast<double>(original.data()[i]));
+  }
+  EXPECT_TRUE(equals(original, deserializeMatrix(matrixProto), 0.0));
+
+  Eigen::VectorXs originalVec = Eigen::VectorXs::Random(4);
+  proto::VectorXs vectorProto;
+  vectorProto.set_size(4);
+  for (int i = 0; i < originalVec.size(); i++)
+  {
+    vectorProto.add_values(static_cast<double>(originalVec(i)));
+  }
+  EXPECT_TRUE(equals(originalVec, deserializeVector(vectorProto), 0.0));
+}
+
 TEST(PROTO, SERIALIZE_ROLLOUT)
 {
   int dofs = 5;
@@ -156,4 +201,194 @@ TEST(PROTO, SERIALIZE_ROLLOUT)
       equals(rollout.getMetadata("2"), recovered.getMetadata("2"), 0.0));
   EXPECT_TRUE(
       equals(rollout.getMetadata("3"), recovered.getMetadata("3"), 0.0));
-}
\ No newline at end of file
+}
+
+TEST(PROTO, SERIALIZE_ROLLOUT_ON_ARENA)
+{
+  int dofs = 5;
+  int steps = 10;
+
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  Eigen::VectorXs mass = Eigen::VectorXs::Random(dofs);
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+
+  pos["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  vel["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  force["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  metadata["1"] = Eigen::MatrixXs::Random(dofs, steps);
+
+  TrajectoryRolloutReal rollout
+      = TrajectoryRolloutReal(pos, vel, force, mass, metadata);
+
+  // This is how the MPC stream uses arenas: build the message on one, send
+  // the bytes, and parse them into a message on another
+  google::protobuf::Arena sendArena;
+  proto::TrajectoryRollout* sent
+      = google::protobuf::Arena::CreateMessage<proto::TrajectoryRollout>(
+          &sendArena);
+  rollout.serialize(*sent);
+  std::string bytes = sent->SerializeAsString();
+
+  google::protobuf::Arena receiveArena;
+  proto::TrajectoryRollout* received
+      = google::protobuf::Arena::CreateMessage<proto::TrajectoryRollout>(
+          &receiveArena);
+  ASSERT_TRUE(received->ParseFromString(bytes));
+
+  TrajectoryRolloutReal recovered
+      = trajectory::TrajectoryRollout::deserialize(*received);
+
+  EXPECT_TRUE(equals(rollout.getMassesConst(), recovered.getMassesConst()));
+  EXPECT_TRUE(equals(
+      rollout.getPosesConst("identity"),
+      recovered.getPosesConst("identity"),
+      0.0));
+  EXPECT_TRUE(equals(
+      rollout.getVelsConst("identity"),
+      recovered.getVelsConst("identity"),
+      0.0));
+  EXPECT_TRUE(equals(
+      rollout.getControlForcesConst("identity"),
+      recovered.getControlForcesConst("identity"),
+      0.0));
+  EXPECT_TRUE(
+      equals(rollout.getMetadata("1"), recovered.getMetadata("1"), 0.0));
+}
+
+/// This rewrites a matrix proto the way it was encoded before the packed
+/// `data` field existed, with only `values` set
+void convertToLegacyValues(proto::MatrixXs& matrixProto)
+{
+  Eigen::MatrixXs matrix = deserializeMatrix(matrixProto);
+  matrixProto.clear_data();
+  matrixProto.clear_values();
+  for (int i = 0; i < matrix.size(); i++)
+  {
+    matrixProto.add_values(static_cast<double>(matrix.data()[i]));
+  }
+}
+
+TEST(PROTO, DESERIALIZE_LEGACY_ROLLOUT)
+{
+  int dofs = 5;
+  int steps = 10;
+
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  Eigen::VectorXs mass = Eigen::VectorXs::Random(dofs);
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+
+  pos["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  vel["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  force["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  metadata["1"] = Eigen::MatrixXs::Random(dofs, steps);
+
+  TrajectoryRolloutReal rollout
+      = TrajectoryRolloutReal(pos, vel, force, mass, metadata);
+
+  proto::TrajectoryRollout proto;
+  rollout.serialize(proto);
+
+  // Rewrite the whole message in the old format, and send it over the wire
+  convertToLegacyValues((*proto.mutable_pos())["identity"]);
+  convertToLegacyValues((*proto.mutable_vel())["identity"]);
+  convertToLegacyValues((*proto.mutable_force())["identity"]);
+  convertToLegacyValues((*proto.mutable_metadata())["1"]);
+  proto.mutable_mass()->clear_data();
+  for (int i = 0; i < mass.size(); i++)
+  {
+    proto.mutable_mass()->add_values(static_cast<double>(mass(i)));
+  }
+  EXPECT_EQ(proto.pos().at("identity").data().size(), 0);
+  EXPECT_EQ(proto.mass().data().size(), 0);
+
+  proto::TrajectoryRollout legacy;
+  ASSERT_TRUE(legacy.ParseFromString(proto.SerializeAsString()));
+
+  TrajectoryRolloutReal recovered
+      = trajectory::TrajectoryRollout::deserialize(legacy);
+
+  EXPECT_TRUE(equals(rollout.getMassesConst(), recovered.getMassesConst()));
+  EXPECT_TRUE(equals(
+      rollout.getPosesConst("identity"),
+      recovered.getPosesConst("identity"),
+      0.0));
+  EXPECT_TRUE(equals(
+      rollout.getVelsConst("identity"),
+      recovered.getVelsConst("identity"),
+      0.0));
+  EXPECT_TRUE(equals(
+      rollout.getControlForcesConst("identity"),
+      recovered.getControlForcesConst("identity"),
+      0.0));
+  EXPECT_TRUE(
+      equals(rollout.getMetadata("1"), recovered.getMetadata("1"), 0.0));
+}
+
+TEST(PROTO, SERIALIZE_SKELETON)
+{
+  biomechanics::OpenSimFile file = biomechanics::OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> skel = file.skeleton;
+  skel->autogroupSymmetricSuffixes();
+  skel->setBodyScales(
+      skel->getBodyScales()
+      + Eigen::VectorXs::Random(skel->getBodyScales().size()) * 0.05);
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()) * 0.1);
+
+  std::string bytes = skel->serialize(file.markersMap);
+  EXPECT_TRUE(bytes.size() > 0);
+
+  dynamics::MarkerMap markers;
+  std::shared_ptr<dynamics::Skeleton> recovered
+      = dynamics::Skeleton::deserialize(
+          bytes, &markers, utils::DartResourceRetriever::create());
+  ASSERT_TRUE(recovered != nullptr);
+
+  EXPECT_EQ(skel->getNumBodyNodes(), recovered->getNumBodyNodes());
+  EXPECT_EQ(skel->getNumDofs(), recovered->getNumDofs());
+  EXPECT_EQ(skel->getNumScaleGroups(), recovered->getNumScaleGroups());
+  EXPECT_TRUE(equals(skel->getBodyScales(), recovered->getBodyScales(), 0.0));
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    EXPECT_EQ(
+        skel->getBodyNode(i)->getName(), recovered->getBodyNode(i)->getName());
+    EXPECT_EQ(
+        skel->getBodyNode(i)->getNumShapeNodes(),
+        recovered->getBodyNode(i)->getNumShapeNodes());
+  }
+  for (int i = 0; i < skel->getNumDofs(); i++)
+  {
+    EXPECT_EQ(skel->getDof(i)->getName(), recovered->getDof(i)->getName());
+  }
+
+  // The kinematics and dynamics should match, away from where we saved them
+  for (int trial = 0; trial < 5; trial++)
+  {
+    Eigen::VectorXs pos = Eigen::VectorXs::Random(skel->getNumDofs()) * 0.3;
+    skel->setPositions(pos);
+    recovered->setPositions(pos);
+    for (int i = 0; i < skel->getNumBodyNodes(); i++)
+    {
+      EXPECT_TRUE(equals(
+          skel->getBodyNode(i)->getWorldTransform().matrix(),
+          recovered->getBodyNode(i)->getWorldTransform().matrix(),
+          1e-12));
+    }
+    EXPECT_TRUE(
+        equals(skel->getMassMatrix(), recovered->getMassMatrix(), 1e-12));
+  }
+
+  EXPECT_EQ(file.markersMap.size(), markers.size());
+  for (auto& pair : file.markersMap)
+  {
+    ASSERT_TRUE(markers.count(pair.first) > 0);
+    EXPECT_EQ(
+        pair.second.first->getName(), markers[pair.first].first->getName());
+    EXPECT_EQ(recovered.get(), markers[pair.first].first->getSkeleton().get());
+    EXPECT_TRUE(equals(pair.second.second, markers[pair.first].second, 0.0));
+  }
+}
@@ -43,18 +43,16 @@ using namespace dart;
 //==============================================================================
 void testBasicInterface(const std::shared_ptr<CollisionDetector>& cd)
 {
+  if (cd->getType() != DARTCollisionDetector::getStaticType()
 #if HAVE_BULLET
-  if (cd->getType() != collision::BulletCollisionDetector::getStaticType())
+      && cd->getType() != collision::BulletCollisionDetector::getStaticType()
+#endif
+  )
   {
-    dtwarn << "Aborting test: distance check is not supported by "
-           << cd->getType() << ".\n";
+    dtwarn << "Aborting test: raycast is not supported by " << cd->getType()
+           << ".\n";
     return;
   }
-#else
-  dtwarn << "Aborting test: distance check is not supported by "
-         << cd->getType() << ".\n";
-  return;
-#endif
 
   auto simpleFrame1 = SimpleFrame::createShared(Frame::World());
 
@@ -130,18 +128,16 @@ TEST(Distance, testBasicInterface)
 //==============================================================================
 void testOptions(const std::shared_ptr<CollisionDetector>& cd)
 {
+  if (cd->getType() != DARTCollisionDetector::getStaticType()
 #if HAVE_BULLET
-  if (cd->getType() != collision::BulletCollisionDetector::getStaticType())
+      && cd->getType() != collision::BulletCollisionDetector::getStaticType()
+#endif
+  )
   {
-    dtwarn << "Aborting test: distance check is not supported by "
-           << cd->getType() << ".\n";
+    dtwarn << "Aborting test: raycast is not supported by " << cd->getType()
+           << ".\n";
     return;
   }
-#else
-  dtwarn << "Aborting test: distance check is not supported by "
-         << cd->getType() << ".\n";
-  return;
-#endif
 
   auto simpleFrame1 = SimpleFrame::createShared(Frame::World());
   auto shape1 = std::make_shared<SphereShape>(1.0);
@@ -208,3 +204,146 @@ TEST(Distance, testOptions)
   auto dart = DARTCollisionDetector::create();
   testOptions(dart);
 }
+
+//==============================================================================
+TEST(Raycast, BatchMatchesSingleRays)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  std::vector<std::shared_ptr<SimpleFrame>> frames;
+  std::vector<ShapePtr> shapes;
+  shapes.push_back(std::make_shared<BoxShape>(Eigen::Vector3s(1, 0.5, 2)));
+  shapes.push_back(std::make_shared<SphereShape>(0.7));
+  shapes.push_back(std::make_shared<CapsuleShape>(0.3, 1.0));
+  shapes.push_back(
+      std::make_shared<EllipsoidShape>(Eigen::Vector3s(0.5, 1.0, 1.5)));
+  srand(42);
+  for (int i = 0; i < 12; i++)
+  {
+    auto frame = SimpleFrame::createShared(Frame::World());
+    frame->setShape(shapes[i % shapes.size()]);
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s::Random() * 3;
+    T.linear() = math::expMapRot(Eigen::Vector3s::Random());
+    frame->setRelativeTransform(T);
+    frames.push_back(frame);
+  }
+  auto group = cd->createCollisionGroup();
+  for (auto& frame : frames)
+    group->addShapeFrame(frame.get());
+
+  const int numRays = 2000;
+  Eigen::MatrixXs origins = Eigen::MatrixXs::Random(numRays, 3) * 6;
+  Eigen::MatrixXs directions = Eigen::MatrixXs::Random(numRays, 3) * 8;
+
+  collision::RaycastBatchResult batch;
+  cd->setNumRaycastThreads(4);
+  std::size_t numHits = group->raycastBatch(
+      origins, directions, collision::RaycastOption(), &batch);
+  EXPECT_TRUE(numHits > 0u);
+  EXPECT_EQ(numHits, batch.getNumHits());
+
+  std::size_t numSingleHits = 0;
+  for (int i = 0; i < numRays; i++)
+  {
+    const Eigen::Vector3s from = origins.row(i).transpose();
+    const Eigen::Vector3s to = from + directions.row(i).transpose();
+    collision::RaycastResult single;
+    if (!group->raycast(from, to, collision::RaycastOption(), &single))
+    {
+      EXPECT_EQ(batch.mCollisionObjects[i], nullptr);
+      EXPECT_TRUE(std::isinf(batch.mDistances(i)));
+      continue;
+    }
+    numSingleHits++;
+    const RayHit& hit = single.mRayHits[0];
+    EXPECT_EQ(batch.mCollisionObjects[i], hit.mCollisionObject);
+    EXPECT_NEAR(
+        batch.mDistances(i), hit.mFraction * directions.row(i).norm(), 1e-12);
+    EXPECT_TRUE(equals(
+        Eigen::Vector3s(batch.mNormals.row(i).transpose()), hit.mNormal));
+    EXPECT_TRUE(equals(
+        Eigen::Vector3s(batch.mPoints.row(i).transpose()), hit.mPoint));
+
+    // The hit point should be on the surface of the object, with the normal
+    // facing back along the ray
+    EXPECT_TRUE(hit.mNormal.dot(to - from) <= 0);
+    EXPECT_NEAR(hit.mNormal.norm(), 1.0, 1e-9);
+  }
+  EXPECT_EQ(numSingleHits, numHits);
+
+  // Splitting the batch over a different number of threads doesn't change
+  // anything
+  collision::RaycastBatchResult serial;
+  cd->setNumRaycastThreads(1);
+  group->raycastBatch(origins, directions, collision::RaycastOption(), &serial);
+  EXPECT_TRUE(equals(batch.mNormals, serial.mNormals));
+  EXPECT_EQ(batch.mCollisionObjects, serial.mCollisionObjects);
+}
+
+//==============================================================================
+TEST(Raycast, PointCloudMatchesBruteForce)
+{
+  auto cd = DARTCollisionDetector::create();
+
+  srand(7);
+  const s_t radius = 0.03;
+  auto cloud = std::make_shared<PointCloudShape>(2 * radius);
+  cloud->setIndexVoxelSize(0.25);
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 2000; i++)
+    points.push_back(Eigen::Vector3s::Random());
+  // The index is updated both ways points can come in
+  cloud->setPoint(std::vector<Eigen::Vector3s>(
+      points.begin(), points.begin() + points.size() / 2));
+  for (std::size_t i = points.size() / 2; i < points.size(); i++)
+    cloud->addPoint(points[i]);
+
+  auto frame = SimpleFrame::createShared(Frame::World());
+  frame->setShape(cloud);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0.5, -0.2, 0.1);
+  T.linear() = math::expMapRot(Eigen::Vector3s(0.3, -0.4, 0.2));
+  frame->setRelativeTransform(T);
+  auto group = cd->createCollisionGroup(frame.get());
+
+  int numHits = 0;
+  for (int i = 0; i < 500; i++)
+  {
+    const Eigen::Vector3s from = Eigen::Vector3s::Random() * 2.5;
+    const Eigen::Vector3s to = Eigen::Vector3s::Random() * 2.5;
+
+    // Test every point
+    bool expectHit = false;
+    s_t expectFraction = 1.0;
+    const Eigen::Vector3s d = to - from;
+    for (const Eigen::Vector3s& point : points)
+    {
+      const Eigen::Vector3s a = from - T * point;
+      const s_t B = 2 * a.dot(d);
+      const s_t C = a.dot(a) - radius * radius;
+      const s_t discriminant = B * B - 4 * d.dot(d) * C;
+      if (C <= 0 || discriminant < 0)
+        continue;
+      const s_t t = (-B - std::sqrt(discriminant)) / (2 * d.dot(d));
+      if (t >= 0 && t <= expectFraction)
+      {
+        expectHit = true;
+        expectFraction = t;
+      }
+    }
+
+    collision::RaycastResult result;
+    const bool hit
+        = group->raycast(from, to, collision::RaycastOption(), &result);
+    ASSERT_EQ(expectHit, hit);
+    if (!hit)
+      continue;
+    numHits++;
+    const RayHit& rayHit = result.mRayHits[0];
+    EXPECT_NEAR(expectFraction, rayHit.mFraction, 1e-9);
+    EXPECT_TRUE(rayHit.mNormal.dot(d) <= 0);
+    EXPECT_NEAR(rayHit.mNormal.norm(), 1.0, 1e-9);
+  }
+  EXPECT_TRUE(numHits > 50);
+}
@@ -1113,6 +1113,85 @@ TEST(REALTIME, CARTPOLE_PLOT)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, CARTPOLE_PARALLEL_PLOT)
+{
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+  world->setTimeStep(1.0 / 100);
+
+  SkeletonPtr cartpole = Skeleton::create("cartpole");
+  std::pair<PrismaticJoint*, BodyNode*> sledPair
+      = cartpole->createJointAndBodyNodePair<PrismaticJoint>(nullptr);
+  sledPair.first->setAxis(Eigen::Vector3s(1, 0, 0));
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = cartpole->createJointAndBodyNodePair<RevoluteJoint>(sledPair.second);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  Eigen::Isometry3s armOffset = Eigen::Isometry3s::Identity();
+  armOffset.translation() = Eigen::Vector3s(0, -0.5, 0);
+  armPair.first->setTransformFromChildBodyNode(armOffset);
+  world->addSkeleton(cartpole);
+  cartpole->setPosition(1, 15.0 / 180.0 * 3.1415);
+
+  world->tuneMass(
+      armPair.second,
+      WrtMassBodyNodeEntryType::INERTIA_MASS,
+      Eigen::VectorXs::Ones(1) * 5.0,
+      Eigen::VectorXs::Ones(1) * 0.2);
+  armPair.second->setMass(2.0);
+
+  int millisPerTimestep = world->getTimeStep() * 1000;
+  int steps = 5;
+  Eigen::VectorXs sensorDims = Eigen::VectorXs::Zero(2);
+  sensorDims(0) = world->getNumDofs();
+  sensorDims(1) = world->getNumDofs();
+  SSID ssid = SSID(
+      world,
+      getSSIDPosLoss(),
+      steps * millisPerTimestep,
+      sensorDims,
+      steps);
+  ssid.setInitialPosEstimator(
+      [](Eigen::MatrixXs sensors, long) { return sensors.col(0); });
+  ssid.setInitialVelEstimator(
+      [](Eigen::MatrixXs sensors, long) { return sensors.col(0); });
+
+  long time = 0;
+  for (int i = 0; i < 20; i++)
+  {
+    time = i * millisPerTimestep;
+    Eigen::VectorXs forces = Eigen::VectorXs::Ones(world->getNumDofs());
+    world->setControlForces(forces);
+    world->step();
+    ssid.registerControls(time, forces);
+    ssid.registerSensors(time, world->getPositions(), 0);
+    ssid.registerSensors(time, world->getVelocities(), 1);
+  }
+
+  // The parallel sweep should match a single worker exactly
+  ssid.setNumThreads(1);
+  Eigen::VectorXs serial = ssid.runPlotting(time, 5.0, 0.2, 32);
+  ssid.setNumThreads(4);
+  Eigen::VectorXs parallel = ssid.runPlotting(time, 5.0, 0.2, 32);
+  EXPECT_TRUE(equals(serial, parallel, 0));
+
+  // The sweep no longer touches the original world
+  EXPECT_EQ(2.0, armPair.second->getMass());
+
+  // Multi-hypothesis inference should write the winning mass, which stays
+  // inside the tuned bounds, back into the world
+  std::vector<Eigen::VectorXs> hypotheses;
+  hypotheses.push_back(Eigen::VectorXs::Ones(1) * 0.5);
+  hypotheses.push_back(Eigen::VectorXs::Ones(1) * 1.5);
+  hypotheses.push_back(Eigen::VectorXs::Ones(1) * 4.0);
+  ssid.setMassHypotheses(hypotheses);
+  ssid.runInference(time);
+  s_t recovered = armPair.second->getMass();
+  EXPECT_GE(recovered, 0.2);
+  EXPECT_LE(recovered, 5.0);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CARTPOLE_MU_PLOT)
 {
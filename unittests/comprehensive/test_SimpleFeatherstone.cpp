@@ -7,6 +7,7 @@
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/SimpleFeatherstone.hpp"
+#include "dart/dynamics/SimpleFeatherstoneBatch.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/neural/BackpropSnapshot.hpp"
@@ -142,6 +143,103 @@ TEST(FEATHERSTONE, LINK_5)
 }
 #endif
 
+TEST(FEATHERSTONE, ANALYTICAL_DERIVATIVES_MATCH_FD)
+{
+  SkeletonPtr skel = createMultiarmRobot(5, 0.2);
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(skel);
+  int n = simple.len();
+
+  Eigen::VectorXs pos = Eigen::VectorXs::Random(n);
+  Eigen::VectorXs vel = Eigen::VectorXs::Random(n);
+  Eigen::VectorXs force = Eigen::VectorXs::Random(n);
+  Eigen::VectorXs accel = Eigen::VectorXs::Zero(n);
+
+  // Inverse dynamics should exactly undo forward dynamics
+  simple.forwardDynamics(pos.data(), vel.data(), force.data(), accel.data());
+  Eigen::VectorXs recoveredForce = Eigen::VectorXs::Zero(n);
+  simple.inverseDynamics(
+      pos.data(), vel.data(), accel.data(), recoveredForce.data());
+  EXPECT_TRUE(equals(recoveredForce, force, 1e-10));
+
+  Eigen::MatrixXs accWrtPos;
+  Eigen::MatrixXs accWrtVel;
+  Eigen::MatrixXs accWrtForce;
+  simple.forwardDynamicsDerivatives(
+      pos.data(), vel.data(), force.data(), accWrtPos, accWrtVel, accWrtForce);
+
+  const s_t EPS = 1e-6;
+  Eigen::MatrixXs fdWrtPos = Eigen::MatrixXs::Zero(n, n);
+  Eigen::MatrixXs fdWrtVel = Eigen::MatrixXs::Zero(n, n);
+  Eigen::MatrixXs fdWrtForce = Eigen::MatrixXs::Zero(n, n);
+  Eigen::VectorXs plus = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs minus = Eigen::VectorXs::Zero(n);
+  for (int k = 0; k < n; k++)
+  {
+    Eigen::VectorXs perturbed = pos;
+    perturbed(k) += EPS;
+    simple.forwardDynamics(
+        perturbed.data(), vel.data(), force.data(), plus.data());
+    perturbed(k) -= 2 * EPS;
+    simple.forwardDynamics(
+        perturbed.data(), vel.data(), force.data(), minus.data());
+    fdWrtPos.col(k) = (plus - minus) / (2 * EPS);
+
+    perturbed = vel;
+    perturbed(k) += EPS;
+    simple.forwardDynamics(
+        pos.data(), perturbed.data(), force.data(), plus.data());
+    perturbed(k) -= 2 * EPS;
+    simple.forwardDynamics(
+        pos.data(), perturbed.data(), force.data(), minus.data());
+    fdWrtVel.col(k) = (plus - minus) / (2 * EPS);
+
+    perturbed = force;
+    perturbed(k) += EPS;
+    simple.forwardDynamics(
+        pos.data(), vel.data(), perturbed.data(), plus.data());
+    perturbed(k) -= 2 * EPS;
+    simple.forwardDynamics(
+        pos.data(), vel.data(), perturbed.data(), minus.data());
+    fdWrtForce.col(k) = (plus - minus) / (2 * EPS);
+  }
+
+  EXPECT_TRUE(equals(accWrtPos, fdWrtPos, 1e-7));
+  EXPECT_TRUE(equals(accWrtVel, fdWrtVel, 1e-7));
+  EXPECT_TRUE(equals(accWrtForce, fdWrtForce, 1e-7));
+}
+
+TEST(FEATHERSTONE, BATCH_MATCHES_SCALAR)
+{
+  SkeletonPtr skel = createMultiarmRobot(5, 0.2);
+  dynamics::SimpleFeatherstone simple;
+  simple.populateFromSkeleton(skel);
+  dynamics::SimpleFeatherstoneBatch batch(simple);
+  int n = simple.len();
+  EXPECT_EQ(n, batch.len());
+
+  // Pick a batch size that isn't a multiple of any SIMD width
+  const int batchSize = 13;
+  Eigen::MatrixXs pos = Eigen::MatrixXs::Random(n, batchSize) * 3;
+  Eigen::MatrixXs vel = Eigen::MatrixXs::Random(n, batchSize);
+  Eigen::MatrixXs force = Eigen::MatrixXs::Random(n, batchSize);
+  Eigen::MatrixXs accel;
+  batch.forwardDynamics(pos, vel, force, accel);
+  EXPECT_EQ(n, accel.rows());
+  EXPECT_EQ(batchSize, accel.cols());
+
+  for (int i = 0; i < batchSize; i++)
+  {
+    Eigen::VectorXs p = pos.col(i);
+    Eigen::VectorXs v = vel.col(i);
+    Eigen::VectorXs f = force.col(i);
+    Eigen::VectorXs expected = Eigen::VectorXs::Zero(n);
+    simple.forwardDynamics(p.data(), v.data(), f.data(), expected.data());
+    Eigen::VectorXs actual = accel.col(i);
+    EXPECT_TRUE(equals(actual, expected, 1e-10));
+  }
+}
+
 /*
 template <class ConfigSpaceT>
 void GenericJoint<ConfigSpaceT>::addChildArtInertiaImplicitToDynamic(
@@ -36,8 +36,11 @@
 
 #include "dart/common/sub_ptr.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/KinematicTape.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/SkeletonClonePool.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/simulation/World.hpp"
 #include "dart/utils/SkelParser.hpp"
@@ -1050,4 +1053,448 @@ TEST(Skeleton, MultiTreeRobotImplicitMass)
   boxBody->setMass(2);
 
   EXPECT_TRUE(verifyImplicitMass(multiRootRobot));
-}
\ No newline at end of file
+}
+
+TEST(Skeleton, PartialMassMatrixUpdatesMatchFull)
+{
+  // A chain with two extra branches hanging off of the second link, so that
+  // changes to one branch leave some of the mass matrix columns untouched
+  SkeletonPtr robot = createMultiarmRobot(4, 0.2);
+  for (int branch = 0; branch < 2; branch++)
+  {
+    BodyNode* parent = robot->getBodyNode(1);
+    for (int i = 0; i < 2; i++)
+    {
+      std::pair<RevoluteJoint*, BodyNode*> pair
+          = robot->createJointAndBodyNodePair<RevoluteJoint>(parent);
+      pair.first->setAxis(branch == 0 ? Vector3s::UnitX() : Vector3s::UnitZ());
+      Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+      offset.translation() = Vector3s(branch == 0 ? 0.5 : -0.5, 0.3, 0.2);
+      pair.first->setTransformFromParentBodyNode(offset);
+      pair.second->setMass(0.5 + i);
+      parent = pair.second;
+    }
+  }
+  robot->setPositions(Eigen::VectorXs::Random(robot->getNumDofs()));
+
+  auto expectMatchesFreshCopy = [&]() {
+    SkeletonPtr copy = robot->cloneSkeleton();
+    copy->setPositions(robot->getPositions());
+    EXPECT_TRUE(equals(robot->getMassMatrix(), copy->getMassMatrix(), 1e-12));
+    EXPECT_TRUE(
+        equals(robot->getAugMassMatrix(), copy->getAugMassMatrix(), 1e-12));
+  };
+
+  // Compute everything once so that the caches are clean
+  expectMatchesFreshCopy();
+
+  // Move the leaf of the first branch
+  robot->getDof(5)->setPosition(robot->getDof(5)->getPosition() + 0.5);
+  expectMatchesFreshCopy();
+
+  // Move the joints in both branches, before reading the mass matrix again
+  robot->getDof(4)->setPosition(robot->getDof(4)->getPosition() - 0.3);
+  robot->getDof(7)->setPosition(robot->getDof(7)->getPosition() + 0.2);
+  expectMatchesFreshCopy();
+
+  // Change the mass of a body on the chain
+  robot->getBodyNode(3)->setMass(3.0);
+  expectMatchesFreshCopy();
+
+  // Move the root
+  robot->getDof(0)->setPosition(robot->getDof(0)->getPosition() + 1.0);
+  expectMatchesFreshCopy();
+}
+
+TEST(Skeleton, ParallelTreesMatchSerial)
+{
+  // Eight independent trees, each a floating base with a short arm
+  SkeletonPtr robot = Skeleton::create();
+  for (int tree = 0; tree < 8; tree++)
+  {
+    BodyNode* parent
+        = robot->createJointAndBodyNodePair<FreeJoint>(nullptr).second;
+    parent->setMass(1.0 + tree);
+    for (int i = 0; i < 3; i++)
+    {
+      std::pair<RevoluteJoint*, BodyNode*> pair
+          = robot->createJointAndBodyNodePair<RevoluteJoint>(parent);
+      pair.first->setAxis(i % 2 == 0 ? Vector3s::UnitX() : Vector3s::UnitY());
+      Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+      offset.translation() = Vector3s(0.1, 0.3, 0.2 * tree);
+      pair.first->setTransformFromParentBodyNode(offset);
+      pair.second->setMass(0.5 + i);
+      parent = pair.second;
+    }
+  }
+  ASSERT_EQ(8u, robot->getNumTrees());
+
+  SkeletonPtr parallel = robot->cloneSkeleton();
+  parallel->setNumTreeThreads(4);
+  EXPECT_EQ(4, parallel->getNumTreeThreads());
+  EXPECT_EQ(1, robot->getNumTreeThreads());
+
+  const Eigen::VectorXs positions
+      = Eigen::VectorXs::Random(robot->getNumDofs());
+  const Eigen::VectorXs velocities
+      = Eigen::VectorXs::Random(robot->getNumDofs());
+  const Eigen::VectorXs accelerations
+      = Eigen::VectorXs::Random(robot->getNumDofs());
+  const Eigen::VectorXs forces = Eigen::VectorXs::Random(robot->getNumDofs());
+  for (const SkeletonPtr& skel : {robot, parallel})
+  {
+    skel->setPositions(positions);
+    skel->setVelocities(velocities);
+    skel->setAccelerations(accelerations);
+    skel->setControlForces(forces);
+  }
+
+  // Each tree is computed the same way on either Skeleton, so these should
+  // match exactly
+  EXPECT_EQ(robot->getMassMatrix(), parallel->getMassMatrix());
+  EXPECT_EQ(robot->getAugMassMatrix(), parallel->getAugMassMatrix());
+  EXPECT_EQ(robot->getInvMassMatrix(), parallel->getInvMassMatrix());
+  EXPECT_EQ(robot->getInvAugMassMatrix(), parallel->getInvAugMassMatrix());
+  EXPECT_EQ(robot->getCoriolisForces(), parallel->getCoriolisForces());
+  EXPECT_EQ(
+      robot->getCoriolisAndGravityForces(),
+      parallel->getCoriolisAndGravityForces());
+
+  // Building the mass matrices mustn't leave the state any different
+  EXPECT_EQ(accelerations, parallel->getAccelerations());
+  EXPECT_EQ(forces, parallel->getControlForces());
+
+  robot->computeForwardDynamics();
+  parallel->computeForwardDynamics();
+  EXPECT_EQ(robot->getAccelerations(), parallel->getAccelerations());
+}
+
+TEST(Skeleton, JointsAtPositionLimits)
+{
+  SkeletonPtr robot = createMultiarmRobot(4, 0.2);
+  for (std::size_t i = 0; i < robot->getNumDofs(); i++)
+  {
+    robot->getDof(i)->setPositionLowerLimit(-1.0);
+    robot->getDof(i)->setPositionUpperLimit(1.0);
+  }
+  robot->setPositions(Eigen::VectorXs::Zero(robot->getNumDofs()));
+
+  std::vector<Joint*> joints;
+
+  // Nothing enforces its limits yet
+  robot->getDof(2)->setPosition(1.5);
+  robot->getJointsAtPositionLimits(joints);
+  EXPECT_TRUE(joints.empty());
+
+  for (std::size_t i = 0; i < robot->getNumJoints(); i++)
+    robot->getJoint(i)->setPositionLimitEnforced(true);
+  robot->getJointsAtPositionLimits(joints);
+  ASSERT_EQ(joints.size(), 1);
+  EXPECT_EQ(joints[0], robot->getDof(2)->getJoint());
+
+  // Being exactly at a limit counts, same as in JointLimitConstraint
+  robot->getDof(0)->setPosition(-1.0);
+  robot->getJointsAtPositionLimits(joints);
+  ASSERT_EQ(joints.size(), 2);
+  EXPECT_EQ(joints[0], robot->getDof(0)->getJoint());
+  EXPECT_EQ(joints[1], robot->getDof(2)->getJoint());
+
+  // Changing the limits or turning enforcement off is picked up
+  robot->getDof(2)->setPositionUpperLimit(2.0);
+  robot->getJoint(0)->setPositionLimitEnforced(false);
+  robot->getJointsAtPositionLimits(joints);
+  EXPECT_TRUE(joints.empty());
+}
+
+TEST(Skeleton, ClonePoolRecyclesAndSyncs)
+{
+  SkeletonPtr robot = createMultiarmRobot(5, 0.2);
+  std::shared_ptr<SkeletonClonePool> pool
+      = std::make_shared<SkeletonClonePool>(robot);
+
+  robot->setPositions(Eigen::VectorXs::Random(robot->getNumDofs()));
+  robot->setVelocities(Eigen::VectorXs::Random(robot->getNumDofs()));
+  robot->getBodyNode(2)->setMass(3.0);
+
+  Skeleton* firstClone = nullptr;
+  {
+    SkeletonPtr clone = pool->acquire();
+    firstClone = clone.get();
+    EXPECT_NE(robot.get(), clone.get());
+    EXPECT_TRUE(equals(clone->getPositions(), robot->getPositions()));
+    EXPECT_TRUE(equals(clone->getVelocities(), robot->getVelocities()));
+    EXPECT_EQ(3.0, clone->getBodyNode(2)->getMass());
+    // BodyNodes on the clone need to be able to find their Skeleton
+    EXPECT_EQ(clone.get(), clone->getBodyNode(4)->getSkeleton().get());
+
+    // Re-posing the clone leaves the source alone
+    clone->setPositions(Eigen::VectorXs::Zero(robot->getNumDofs()));
+    EXPECT_FALSE(equals(clone->getPositions(), robot->getPositions()));
+    EXPECT_EQ(0, pool->getNumPooled());
+  }
+  EXPECT_EQ(1, pool->getNumPooled());
+  EXPECT_EQ(1, pool->getNumAllocated());
+
+  // The next acquire() hands back the same clone, now synced to the source's
+  // current state
+  robot->setPositions(Eigen::VectorXs::Random(robot->getNumDofs()));
+  robot->getBodyNode(2)->setMass(1.5);
+  SkeletonPtr recycled = pool->acquire();
+  EXPECT_EQ(firstClone, recycled.get());
+  EXPECT_EQ(1, pool->getNumAllocated());
+  EXPECT_TRUE(equals(recycled->getPositions(), robot->getPositions()));
+  EXPECT_EQ(1.5, recycled->getBodyNode(2)->getMass());
+  EXPECT_TRUE(equals(recycled->getMassMatrix(), robot->getMassMatrix(), 1e-12));
+
+  // Clones checked out at the same time are distinct
+  SkeletonPtr other = pool->acquire();
+  EXPECT_NE(recycled.get(), other.get());
+  EXPECT_EQ(2, pool->getNumAllocated());
+}
+
+TEST(Skeleton, InverseDynamicsBatchMatchesPerTimestep)
+{
+  SkeletonPtr robot = createMultiarmRobot(5, 0.2);
+  const int dofs = robot->getNumDofs();
+  const int numBodies = robot->getNumBodyNodes();
+  const int numTimesteps = 17;
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Random(dofs, numTimesteps);
+  Eigen::MatrixXs vels = Eigen::MatrixXs::Random(dofs, numTimesteps);
+  Eigen::MatrixXs accs = Eigen::MatrixXs::Random(dofs, numTimesteps);
+
+  // Push on each body with a pure force, through a point given in world
+  // coordinates, and pass the batch the equivalent world wrench
+  std::vector<Eigen::Vector3s> forces;
+  std::vector<Eigen::Vector3s> points;
+  Eigen::MatrixXs wrenches = Eigen::MatrixXs::Zero(numBodies * 6, numTimesteps);
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    for (int i = 0; i < numBodies; i++)
+    {
+      forces.push_back(Eigen::Vector3s::Random());
+      points.push_back(Eigen::Vector3s::Random());
+      wrenches.block<3, 1>(i * 6, t) = points.back().cross(forces.back());
+      wrenches.block<3, 1>(i * 6 + 3, t) = forces.back();
+    }
+  }
+
+  Eigen::VectorXs originalPos = robot->getPositions();
+  Eigen::MatrixXs taus = robot->computeInverseDynamicsBatch(poses, vels, accs);
+  Eigen::MatrixXs tausWithWrenches
+      = robot->computeInverseDynamicsBatch(poses, vels, accs, wrenches, 4);
+  EXPECT_TRUE(equals(robot->getPositions(), originalPos));
+
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    robot->setPositions(poses.col(t));
+    robot->setVelocities(vels.col(t));
+    robot->setAccelerations(accs.col(t));
+    Eigen::VectorXs expected = robot->getMassMatrix() * accs.col(t)
+                               + robot->getCoriolisAndGravityForces();
+    EXPECT_TRUE(equals(Eigen::VectorXs(taus.col(t)), expected, 1e-9));
+
+    for (int i = 0; i < numBodies; i++)
+    {
+      robot->getBodyNode(i)->setExtForce(
+          forces[t * numBodies + i], points[t * numBodies + i], false, false);
+    }
+    robot->computeInverseDynamics(true);
+    EXPECT_TRUE(equals(
+        Eigen::VectorXs(tausWithWrenches.col(t)),
+        robot->getControlForces(),
+        1e-9));
+    robot->clearExternalForces();
+  }
+}
+
+TEST(Skeleton, MarkerWorldPositionsBatchMatchesPerTimestep)
+{
+  SkeletonPtr robot = createMultiarmRobot(5, 0.2);
+  const int dofs = robot->getNumDofs();
+  const int numTimesteps = 13;
+
+  MarkerMap markerMap;
+  for (int i = 0; i < robot->getNumBodyNodes(); i++)
+  {
+    markerMap["marker_" + std::to_string(i)] = std::make_pair(
+        robot->getBodyNode(i), Eigen::Vector3s(Eigen::Vector3s::Random()));
+  }
+  std::vector<std::pair<BodyNode*, Eigen::Vector3s>> markers;
+  for (auto& pair : markerMap)
+    markers.push_back(pair.second);
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Random(dofs, numTimesteps);
+
+  // Every other marker goes missing on every third timestep
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations;
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    std::map<std::string, Eigen::Vector3s> observed;
+    int i = 0;
+    for (auto& pair : markerMap)
+    {
+      if (t % 3 != 0 || i % 2 == 0)
+        observed[pair.first] = Eigen::Vector3s::Random();
+      i++;
+    }
+    observations.push_back(observed);
+  }
+
+  Eigen::VectorXs originalPos = robot->getPositions();
+  Eigen::MatrixXs positions
+      = robot->getMarkerWorldPositionsBatch(poses, markers);
+  Eigen::MatrixXs threadedPositions
+      = robot->getMarkerWorldPositionsBatch(poses, markers, 4);
+  int numObserved = 0;
+  s_t averageError = robot->getMarkerAverageErrorBatch(
+      poses, markerMap, observations, 4, &numObserved);
+  EXPECT_TRUE(equals(robot->getPositions(), originalPos));
+
+  s_t errorSum = 0;
+  int count = 0;
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    robot->setPositions(poses.col(t));
+    Eigen::VectorXs expected = robot->getMarkerWorldPositions(markers);
+    EXPECT_TRUE(equals(Eigen::VectorXs(positions.col(t)), expected));
+    EXPECT_TRUE(equals(Eigen::VectorXs(threadedPositions.col(t)), expected));
+
+    auto worldMarkers = robot->getMarkerMapWorldPositions(markerMap);
+    for (auto& pair : observations[t])
+    {
+      errorSum += (pair.second - worldMarkers[pair.first]).norm();
+      count++;
+    }
+  }
+  EXPECT_EQ(count, numObserved);
+  EXPECT_NEAR(errorSum / count, averageError, 1e-12);
+}
+
+//==============================================================================
+TEST(Skeleton, KinematicTapeMatchesSkeleton)
+{
+  SkeletonPtr skel = Skeleton::create();
+  BodyNode* root = skel->createJointAndBodyNodePair<FreeJoint>().second;
+  std::vector<BodyNode*> parents;
+  parents.push_back(root);
+  for (int i = 0; i < 8; i++)
+  {
+    BodyNode* parent = parents[i / 2];
+    Joint* joint;
+    BodyNode* child;
+    switch (i % 4)
+    {
+      case 0:
+        std::tie(joint, child)
+            = skel->createJointAndBodyNodePair<RevoluteJoint>(parent);
+        static_cast<RevoluteJoint*>(joint)->setAxis(
+            Eigen::Vector3s::Random().normalized());
+        break;
+      case 1:
+        std::tie(joint, child)
+            = skel->createJointAndBodyNodePair<PrismaticJoint>(parent);
+        static_cast<PrismaticJoint*>(joint)->setAxis(
+            Eigen::Vector3s::Random().normalized());
+        break;
+      case 2:
+        std::tie(joint, child)
+            = skel->createJointAndBodyNodePair<BallJoint>(parent);
+        break;
+      default:
+        std::tie(joint, child)
+            = skel->createJointAndBodyNodePair<WeldJoint>(parent);
+        break;
+    }
+    joint->setTransformFromParentBodyNode(
+        math::expMap(Eigen::Vector6s::Random()));
+    joint->setTransformFromChildBodyNode(
+        math::expMap(Eigen::Vector6s::Random()));
+    parents.push_back(child);
+  }
+
+  KinematicTape tape(skel.get());
+  EXPECT_EQ(tape.getNumDofs(), skel->getNumDofs());
+  EXPECT_EQ(tape.getNumBodyNodes(), skel->getNumBodyNodes());
+
+  Eigen::VectorXs originalPos = skel->getPositions();
+  for (int trial = 0; trial < 5; trial++)
+  {
+    Eigen::VectorXs pos = Eigen::VectorXs::Random(skel->getNumDofs());
+    tape.evaluate(pos);
+    EXPECT_TRUE(equals(skel->getPositions(), originalPos));
+
+    skel->setPositions(pos);
+    for (int i = 0; i < skel->getNumBodyNodes(); i++)
+    {
+      BodyNode* body = skel->getBodyNode(i);
+      EXPECT_TRUE(equals(
+          tape.getWorldTransform(i).matrix(),
+          body->getWorldTransform().matrix(),
+          1e-10));
+
+      Eigen::Vector3s offset = Eigen::Vector3s::Random();
+      math::Jacobian expected = skel->getWorldJacobian(body, offset);
+      math::Jacobian jac = tape.getWorldJacobian(i, offset);
+      EXPECT_TRUE(equals(jac, expected, 1e-10));
+    }
+    skel->setPositions(originalPos);
+  }
+
+  SkeletonPtr clone = skel->cloneSkeleton();
+  tape.syncToSkeleton(clone.get());
+  EXPECT_TRUE(equals(clone->getPositions(), tape.getPositions()));
+  skel->setPositions(tape.getPositions());
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    EXPECT_TRUE(equals(
+        clone->getBodyNode(i)->getWorldTransform().matrix(),
+        skel->getBodyNode(i)->getWorldTransform().matrix(),
+        1e-10));
+  }
+}
+
+//==============================================================================
+TEST(Skeleton, BatchedPositionUpdatesDirtyEveryBody)
+{
+  SkeletonPtr robot = createMultiarmRobot(4, 0.3);
+  robot->getRootJoint()->setPositions(
+      Eigen::VectorXs::Random(robot->getRootJoint()->getNumDofs()));
+
+  for (int trial = 0; trial < 3; trial++)
+  {
+    // Read everything first, so every cached value is clean before we move
+    for (std::size_t i = 0; i < robot->getNumBodyNodes(); i++)
+      robot->getBodyNode(i)->getWorldTransform();
+    robot->getMassMatrix();
+
+    Eigen::VectorXs pos = Eigen::VectorXs::Random(robot->getNumDofs());
+    if (trial == 2)
+    {
+      std::vector<std::size_t> indices;
+      for (std::size_t i = 0; i < robot->getNumDofs(); i += 2)
+        indices.push_back(i);
+      robot->setPositions(indices, pos.head(indices.size()));
+    }
+    else if (trial == 1)
+    {
+      // The batching also applies when we go through a MetaSkeleton pointer
+      MetaSkeletonPtr meta = robot;
+      meta->setPositions(pos);
+    }
+    else
+    {
+      robot->setPositions(pos);
+    }
+
+    SkeletonPtr fresh = robot->cloneSkeleton();
+    fresh->setPositions(robot->getPositions());
+    for (std::size_t i = 0; i < robot->getNumBodyNodes(); i++)
+    {
+      EXPECT_TRUE(equals(
+          robot->getBodyNode(i)->getWorldTransform().matrix(),
+          fresh->getBodyNode(i)->getWorldTransform().matrix()));
+    }
+    EXPECT_TRUE(equals(robot->getMassMatrix(), fresh->getMassMatrix()));
+  }
+}
@@ -37,6 +37,7 @@
 #include <gtest/gtest.h>
 
 #include "dart/common/Console.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
 #include "dart/dynamics/PointMass.hpp"
 #include "dart/dynamics/Skeleton.hpp"
@@ -459,3 +460,70 @@ TEST_F(SoftDynamicsTest, compareEquationsOfMotion)
   //    compareEquationsOfMotion(getList()[i]);
   //  }
 }
+
+//==============================================================================
+TEST(SoftDynamics, ParallelPointMassUpdatesMatchSerial)
+{
+  std::vector<dynamics::SkeletonPtr> skeletons;
+  for (int numThreads : {1, 4})
+  {
+    dynamics::SkeletonPtr skel = dynamics::Skeleton::create();
+    // A 12x12x12 box has 728 point masses on its surface, which is plenty to
+    // split across threads
+    dynamics::SoftBodyNode::Properties properties(
+        dynamics::BodyNode::Properties(),
+        dynamics::SoftBodyNodeHelper::makeBoxProperties(
+            Vector3s::Ones(),
+            Isometry3s::Identity(),
+            Vector3i(12, 12, 12),
+            10.0));
+    dynamics::SoftBodyNode* soft
+        = skel->createJointAndBodyNodePair<
+                  dynamics::FreeJoint,
+                  dynamics::SoftBodyNode>(
+                  nullptr, dynamics::FreeJoint::Properties(), properties)
+              .second;
+    soft->setNumPointMassThreads(numThreads);
+    skeletons.push_back(skel);
+  }
+
+  srand(0);
+  const VectorXs positions = VectorXs::Random(6);
+  const VectorXs velocities = VectorXs::Random(6);
+  const std::size_t numPointMasses
+      = skeletons[0]->getSoftBodyNode(0)->getNumPointMasses();
+  std::vector<Vector3s> pointPositions;
+  std::vector<Vector3s> pointVelocities;
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    pointPositions.push_back(0.01 * Vector3s::Random());
+    pointVelocities.push_back(0.1 * Vector3s::Random());
+  }
+
+  for (const dynamics::SkeletonPtr& skel : skeletons)
+  {
+    skel->setPositions(positions);
+    skel->setVelocities(velocities);
+    dynamics::SoftBodyNode* soft = skel->getSoftBodyNode(0);
+    for (std::size_t i = 0; i < numPointMasses; ++i)
+    {
+      soft->getPointMass(i)->setPositions(pointPositions[i]);
+      soft->getPointMass(i)->setVelocities(pointVelocities[i]);
+    }
+    skel->computeForwardDynamics();
+  }
+
+  // Every point mass only writes to itself, and the body sums them up in the
+  // same order either way, so the results should match exactly
+  EXPECT_EQ(skeletons[0]->getAccelerations(), skeletons[1]->getAccelerations());
+  for (std::size_t i = 0; i < numPointMasses; ++i)
+  {
+    EXPECT_EQ(
+        skeletons[0]->getSoftBodyNode(0)->getPointMass(i)->getAccelerations(),
+        skeletons[1]->getSoftBodyNode(0)->getPointMass(i)->getAccelerations());
+  }
+
+  for (const dynamics::SkeletonPtr& skel : skeletons)
+    skel->computeInverseDynamics();
+  EXPECT_EQ(skeletons[0]->getControlForces(), skeletons[1]->getControlForces());
+}
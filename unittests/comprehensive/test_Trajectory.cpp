@@ -53,9 +53,11 @@
 #include "dart/neural/RestorableSnapshot.hpp"
 #include "dart/neural/WithRespectToMass.hpp"
 #include "dart/simulation/World.hpp"
+#include "dart/trajectory/ILQROptimizer.hpp"
 #include "dart/trajectory/IPOptOptimizer.hpp"
 #include "dart/trajectory/MultiShot.hpp"
 #include "dart/trajectory/Problem.hpp"
+#include "dart/trajectory/SGDOptimizer.hpp"
 #include "dart/trajectory/SingleShot.hpp"
 #include "dart/trajectory/Solution.hpp"
 #include "dart/trajectory/TrajectoryConstants.hpp"
@@ -203,6 +205,494 @@ TEST(TRAJECTORY, TWO_LINK)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, CHECKPOINTED_SINGLE_SHOT)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+
+  std::pair<RevoluteJoint*, BodyNode*> elbowPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  Eigen::Isometry3s elbowOffset = Eigen::Isometry3s::Identity();
+  elbowOffset.translation() = Eigen::Vector3s(0, 1.0, 0);
+  elbowPair.first->setTransformFromParentBodyNode(elbowOffset);
+
+  world->addSkeleton(arm);
+
+  arm->setPosition(0, 15.0 / 180.0 * 3.1415);
+
+  int steps = 40;
+  SingleShot full(world, LossFn(), steps, true);
+  SingleShot checkpointed(world, LossFn(), steps, true);
+  // Deliberately pick an interval that doesn't divide the trajectory evenly
+  checkpointed.setCheckpointInterval(7);
+  EXPECT_EQ(checkpointed.getCheckpointInterval(), 7);
+
+  srand(42);
+  Eigen::VectorXs flat
+      = Eigen::VectorXs::Random(full.getFlatProblemDim(world)) * 0.1;
+  full.unflatten(world, flat);
+  checkpointed.unflatten(world, flat);
+
+  EXPECT_TRUE(equals(
+      full.getFinalState(world), checkpointed.getFinalState(world), 0));
+
+  int stateSize = world->getNumDofs() * 2;
+  int dim = full.getFlatProblemDim(world);
+  Eigen::MatrixXs fullJac = Eigen::MatrixXs::Zero(stateSize, dim);
+  full.backpropJacobianOfFinalState(world, fullJac);
+  Eigen::MatrixXs checkpointedJac = Eigen::MatrixXs::Zero(stateSize, dim);
+  checkpointed.backpropJacobianOfFinalState(world, checkpointedJac);
+  EXPECT_TRUE(equals(fullJac, checkpointedJac, 0));
+
+  TrajectoryRolloutReal fullRollout = TrajectoryRolloutReal(&full);
+  full.getStates(world, &fullRollout);
+  TrajectoryRolloutReal checkpointedRollout
+      = TrajectoryRolloutReal(&checkpointed);
+  checkpointed.getStates(world, &checkpointedRollout);
+  EXPECT_TRUE(
+      equals(fullRollout.getPoses(), checkpointedRollout.getPoses(), 0));
+  EXPECT_TRUE(equals(fullRollout.getVels(), checkpointedRollout.getVels(), 0));
+
+  TrajectoryRolloutReal gradWrtRollout = TrajectoryRolloutReal(&full);
+  gradWrtRollout.getPoses().setRandom();
+  gradWrtRollout.getVels().setRandom();
+  gradWrtRollout.getControlForces().setRandom();
+  int staticDim = full.getFlatStaticProblemDim(world);
+  int dynamicDim = full.getFlatDynamicProblemDim(world);
+  Eigen::VectorXs fullGradStatic = Eigen::VectorXs::Zero(staticDim);
+  Eigen::VectorXs fullGradDynamic = Eigen::VectorXs::Zero(dynamicDim);
+  full.backpropGradientWrt(
+      world, &gradWrtRollout, fullGradStatic, fullGradDynamic);
+  Eigen::VectorXs checkpointedGradStatic = Eigen::VectorXs::Zero(staticDim);
+  Eigen::VectorXs checkpointedGradDynamic = Eigen::VectorXs::Zero(dynamicDim);
+  checkpointed.backpropGradientWrt(
+      world, &gradWrtRollout, checkpointedGradStatic, checkpointedGradDynamic);
+  EXPECT_TRUE(equals(fullGradStatic, checkpointedGradStatic, 0));
+  EXPECT_TRUE(equals(fullGradDynamic, checkpointedGradDynamic, 0));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ROLLOUT_MAP_WRITES_IN_PLACE)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr spinner = Skeleton::create("spinner");
+
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = spinner->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+
+  world->addSkeleton(spinner);
+
+  spinner->setPosition(0, 15.0 / 180.0 * 3.1415);
+
+  int steps = 10;
+  SingleShot shot(world, LossFn(), steps, true);
+
+  TrajectoryRolloutReal real = TrajectoryRolloutReal(&shot);
+  shot.getStates(world, &real);
+
+  // These stand in for buffers owned by someone else, like numpy arrays
+  int dofs = world->getNumDofs();
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::MatrixXs vels = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Zero(dofs, steps);
+  Eigen::VectorXs masses = Eigen::VectorXs::Zero(world->getMassDims());
+  TrajectoryRolloutMap mapped(poses, vels, forces, masses);
+  shot.getStates(world, &mapped);
+
+  EXPECT_TRUE(equals(real.getPoses(), poses, 0));
+  EXPECT_TRUE(equals(real.getVels(), vels, 0));
+  EXPECT_TRUE(equals(real.getControlForces(), forces, 0));
+
+  // Writes through the rollout land in the original buffers
+  mapped.getPoses().setConstant(3.0);
+  EXPECT_TRUE(equals(poses, Eigen::MatrixXs::Constant(dofs, steps, 3.0), 0));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, BUILTIN_LOSSES_MATCH_FINITE_DIFFERENCES)
+{
+  int dofs = 3;
+  int steps = 6;
+  std::unordered_map<std::string, Eigen::MatrixXs> pos;
+  std::unordered_map<std::string, Eigen::MatrixXs> vel;
+  std::unordered_map<std::string, Eigen::MatrixXs> force;
+  pos["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  vel["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  force["identity"] = Eigen::MatrixXs::Random(dofs, steps);
+  std::unordered_map<std::string, Eigen::MatrixXs> metadata;
+  TrajectoryRolloutReal rollout(
+      pos, vel, force, Eigen::VectorXs::Random(2), metadata);
+
+  std::vector<LossFn> losses;
+  losses.push_back(
+      LossFn::quadraticTracking(Eigen::MatrixXs::Random(dofs, steps), 0.5));
+  losses.push_back(LossFn::finalState(
+      Eigen::VectorXs::Random(dofs), Eigen::VectorXs::Random(dofs), 2.0, 3.0));
+  losses.push_back(LossFn::controlEffort(0.1));
+
+  for (LossFn& loss : losses)
+  {
+    // The analytical gradient, from the compiled loss
+    TrajectoryRolloutReal analytical = TrajectoryRolloutReal(&rollout);
+    s_t analyticalLoss = loss.getLossAndGradient(&rollout, &analytical);
+    EXPECT_NEAR(analyticalLoss, loss.getLoss(&rollout), 1e-12);
+
+    // Wrapping just the loss forces LossFn to finite difference it
+    TrajectoryLossFn lossOnly
+        = [&loss](const TrajectoryRollout* r) { return loss.getLoss(r); };
+    LossFn finiteDifferenced(lossOnly);
+    TrajectoryRolloutReal fd = TrajectoryRolloutReal(&rollout);
+    finiteDifferenced.getLossAndGradient(&rollout, &fd);
+
+    EXPECT_TRUE(equals(analytical.getPoses(), fd.getPoses(), 1e-6));
+    EXPECT_TRUE(equals(analytical.getVels(), fd.getVels(), 1e-6));
+    EXPECT_TRUE(
+        equals(analytical.getControlForces(), fd.getControlForces(), 1e-6));
+    EXPECT_TRUE(equals(analytical.getMasses(), fd.getMasses(), 1e-6));
+
+    // Batches that fall back to one rollout at a time give the same answer
+    TrajectoryRolloutReal batchGrad = TrajectoryRolloutReal(&rollout);
+    Eigen::VectorXs batchLosses
+        = loss.getLossesAndGradients({&rollout, &rollout}, {&fd, &batchGrad});
+    EXPECT_NEAR(batchLosses(0), analyticalLoss, 1e-12);
+    EXPECT_NEAR(batchLosses(1), analyticalLoss, 1e-12);
+    EXPECT_TRUE(equals(analytical.getPoses(), batchGrad.getPoses(), 0));
+  }
+
+  // A batched loss is called once for the whole stack
+  int numCalls = 0;
+  LossFn batched(TrajectoryBatchLossFnAndGrad(
+      [&numCalls](
+          const std::vector<const TrajectoryRollout*>& rollouts,
+          Eigen::Ref<Eigen::VectorXs> out,
+          const std::vector<TrajectoryRollout*>& grads) {
+        numCalls++;
+        for (int i = 0; i < rollouts.size(); i++)
+        {
+          out(i) = rollouts[i]->getPosesConst().sum();
+          grads[i]->getPoses().setOnes();
+        }
+      }));
+  TrajectoryRolloutReal gradA = TrajectoryRolloutReal(&rollout);
+  TrajectoryRolloutReal gradB = TrajectoryRolloutReal(&rollout);
+  Eigen::VectorXs batchedLosses = batched.getLossesAndGradients(
+      {&rollout, &rollout}, {&gradA, &gradB});
+  EXPECT_EQ(numCalls, 1);
+  EXPECT_NEAR(batchedLosses(1), rollout.getPoses().sum(), 1e-12);
+  EXPECT_NEAR(batched.getLoss(&rollout), rollout.getPoses().sum(), 1e-12);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ADVANCE_STEPS_MAPPING)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> elbowPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  Eigen::Isometry3s elbowOffset = Eigen::Isometry3s::Identity();
+  elbowOffset.translation() = Eigen::Vector3s(0, 1.0, 0);
+  elbowPair.first->setTransformFromParentBodyNode(elbowOffset);
+  world->addSkeleton(arm);
+
+  int steps = 12;
+  int shotLength = 4;
+  int advance = 3;
+  MultiShot shot(world, LossFn(), steps, shotLength, false);
+  int dim = shot.getFlatProblemDim(world);
+  srand(42);
+  shot.unflatten(world, Eigen::VectorXs::Random(dim));
+  Eigen::VectorXs before = Eigen::VectorXs::Zero(dim);
+  shot.flatten(world, before);
+
+  Eigen::VectorXi mapping = shot.advanceSteps(
+      world, world->getPositions(), world->getVelocities(), advance);
+  Eigen::VectorXs after = Eigen::VectorXs::Zero(dim);
+  shot.flatten(world, after);
+
+  ASSERT_EQ(mapping.size(), dim);
+  int numNew = 0;
+  for (int i = 0; i < dim; i++)
+  {
+    if (mapping(i) < 0)
+    {
+      // Padding is new, and zero
+      numNew++;
+      EXPECT_EQ(after(i), 0);
+    }
+    else if (mapping(i) != i)
+    {
+      // Forces moved over from later in the same shot
+      EXPECT_EQ(after(i), before(mapping(i)));
+    }
+  }
+  // Each shot pads `advance` steps of forces at its end
+  EXPECT_EQ(numNew, (steps / shotLength) * advance * world->getNumDofs());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, SGD_PARALLEL_LINE_SEARCH)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  world->addSkeleton(arm);
+
+  int steps = 12;
+  LossFn loss = LossFn::finalState(
+      Eigen::VectorXs::Ones(1), Eigen::VectorXs::Zero(1), 1.0, 0.1);
+
+  // A clone on another world computes the same loss, without touching ours
+  MultiShot shot(world, loss, steps, 4, false);
+  WorldPtr cloneWorld = world->clone();
+  std::shared_ptr<Problem> clone = shot.clone(cloneWorld);
+  EXPECT_NEAR(shot.getLoss(world), clone->getLoss(cloneWorld), 1e-12);
+
+  s_t startLoss = shot.getLoss(world);
+  std::vector<s_t> losses;
+  SGDOptimizer optimizer;
+  optimizer.setIterationLimit(20);
+  optimizer.setLearningRate(10.0);
+  optimizer.setLineSearchCandidates(6);
+  optimizer.setNumThreads(3);
+  optimizer.registerIntermediateCallback(
+      [&losses](Problem*, int, s_t primal, s_t) {
+        losses.push_back(primal);
+        return true;
+      });
+  optimizer.optimize(&shot);
+
+  // The line search never accepts a step that makes things worse
+  EXPECT_LT(shot.getLoss(world), startLoss);
+  for (int i = 1; i < losses.size(); i++)
+  {
+    EXPECT_LE(losses[i], losses[i - 1]);
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, ILQR_REACHES_TARGET)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> forearmPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  forearmPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  world->addSkeleton(arm);
+
+  int steps = 20;
+  Eigen::VectorXs targetPos = Eigen::VectorXs::Ones(2);
+  LossFn finalState
+      = LossFn::finalState(targetPos, Eigen::VectorXs::Zero(2), 1.0, 0.1);
+  LossFn effort = LossFn::controlEffort(1e-6);
+  LossFn loss(
+      [&](const TrajectoryRollout* rollout) {
+        return finalState.getLoss(rollout) + effort.getLoss(rollout);
+      },
+      [&](const TrajectoryRollout* rollout,
+          TrajectoryRollout* gradWrtRollout) {
+        TrajectoryRolloutReal effortGrad(gradWrtRollout);
+        s_t value = finalState.getLossAndGradient(rollout, gradWrtRollout)
+                    + effort.getLossAndGradient(rollout, &effortGrad);
+        gradWrtRollout->getControlForces() += effortGrad.getControlForces();
+        return value;
+      });
+
+  SingleShot shot(world, loss, steps, false);
+  // A pinned force stays exactly where it is
+  Eigen::VectorXs pinned = Eigen::VectorXs::Zero(2);
+  pinned(0) = 0.5;
+  shot.pinForce(3, pinned);
+
+  s_t startLoss = shot.getLoss(world);
+  std::vector<s_t> losses;
+  ILQROptimizer optimizer;
+  optimizer.setIterationLimit(30);
+  optimizer.setLineSearchCandidates(6);
+  optimizer.setNumThreads(3);
+  optimizer.setSilenceOutput(true);
+  optimizer.registerIntermediateCallback(
+      [&losses](Problem*, int, s_t primal, s_t) {
+        losses.push_back(primal);
+        return true;
+      });
+  optimizer.optimize(&shot);
+
+  // Every accepted step improves the loss, and the loss we report matches what
+  // the shot computes from the forces we leave in it
+  ASSERT_GT(losses.size(), 0);
+  for (int i = 1; i < losses.size(); i++)
+  {
+    EXPECT_LE(losses[i], losses[i - 1]);
+  }
+  s_t endLoss = shot.getLoss(world);
+  EXPECT_NEAR(endLoss, losses.back(), 1e-8);
+  EXPECT_LT(endLoss, 1e-2 * startLoss);
+  Eigen::VectorXs forceAtPin
+      = shot.getRolloutCache(world)->getControlForcesConst().col(3);
+  EXPECT_TRUE(equals(forceAtPin, pinned));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, GAUSS_NEWTON_HESSIAN)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> forearmPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  forearmPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  world->addSkeleton(arm);
+
+  int steps = 8;
+  LossFn loss = LossFn::finalState(
+      Eigen::VectorXs::Ones(2), Eigen::VectorXs::Zero(2), 1.0, 0.5);
+
+  // The loss is quadratic in the final state, so the Gauss-Newton Hessian of a
+  // SingleShot is exactly J^T H J, with J the Jacobian of the final state
+  SingleShot shot(world, loss, steps, true);
+  int dim = shot.getFlatProblemDim(world);
+  Eigen::VectorXs flat = Eigen::VectorXs::Random(dim) * 0.1;
+  shot.Problem::unflatten(world, flat);
+  Eigen::MatrixXs jac = Eigen::MatrixXs::Zero(4, dim);
+  shot.backpropJacobianOfFinalState(world, jac);
+  Eigen::Vector4s lossHessian(2.0, 2.0, 1.0, 1.0);
+  Eigen::MatrixXs expected
+      = jac.transpose() * lossHessian.asDiagonal() * jac;
+
+  int nnzh = shot.getNumberNonZeroGaussNewtonHessian(world);
+  EXPECT_EQ(nnzh, dim * (dim + 1) / 2);
+  Eigen::VectorXi rows = Eigen::VectorXi::Zero(nnzh);
+  Eigen::VectorXi cols = Eigen::VectorXi::Zero(nnzh);
+  Eigen::VectorXs sparse = Eigen::VectorXs::Zero(nnzh);
+  shot.getGaussNewtonHessianStructure(world, rows, cols);
+  shot.getSparseGaussNewtonHessian(world, sparse);
+  Eigen::MatrixXs hessian = Eigen::MatrixXs::Zero(dim, dim);
+  for (int i = 0; i < nnzh; i++)
+  {
+    EXPECT_GE(rows(i), cols(i));
+    hessian(rows(i), cols(i)) = sparse(i);
+    hessian(cols(i), rows(i)) = sparse(i);
+  }
+  EXPECT_TRUE(equals(hessian, expected, 1e-6));
+
+  // A MultiShot gets one block per shot, and with only the final state in the
+  // loss, only the last shot's block is non-zero
+  MultiShot multi(world, loss, steps, 4, true);
+  dim = multi.getFlatProblemDim(world);
+  flat = Eigen::VectorXs::Random(dim) * 0.1;
+  multi.Problem::unflatten(world, flat);
+  int shotDim = dim / 2;
+  nnzh = multi.getNumberNonZeroGaussNewtonHessian(world);
+  EXPECT_EQ(nnzh, shotDim * (shotDim + 1));
+  rows = Eigen::VectorXi::Zero(nnzh);
+  cols = Eigen::VectorXi::Zero(nnzh);
+  sparse = Eigen::VectorXs::Zero(nnzh);
+  multi.getGaussNewtonHessianStructure(world, rows, cols);
+  multi.getSparseGaussNewtonHessian(world, sparse);
+  for (int i = 0; i < nnzh; i++)
+  {
+    EXPECT_EQ(rows(i) / shotDim, cols(i) / shotDim);
+    if (rows(i) < shotDim)
+    {
+      EXPECT_EQ(sparse(i), 0.0);
+    }
+  }
+  EXPECT_GT(sparse.tail(nnzh / 2).norm(), 0.0);
+
+  s_t startLoss = multi.getLoss(world);
+  IPOptOptimizer optimizer;
+  optimizer.setIterationLimit(50);
+  optimizer.setGaussNewtonHessian(true);
+  optimizer.setSilenceOutput(true);
+  optimizer.optimize(&multi);
+  EXPECT_LT(multi.getLoss(world), startLoss);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(TRAJECTORY, PARAREAL_MATCHES_SERIAL)
+{
+  // World
+  WorldPtr world = World::create();
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr arm = Skeleton::create("arm");
+  std::pair<RevoluteJoint*, BodyNode*> armPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(nullptr);
+  armPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  std::pair<RevoluteJoint*, BodyNode*> forearmPair
+      = arm->createJointAndBodyNodePair<RevoluteJoint>(armPair.second);
+  forearmPair.first->setAxis(Eigen::Vector3s(0, 0, 1));
+  world->addSkeleton(arm);
+
+  int steps = 60;
+  SingleShot serial(world, LossFn(), steps);
+  Eigen::VectorXs flat
+      = Eigen::VectorXs::Random(serial.getFlatProblemDim(world)) * 0.1;
+  serial.Problem::unflatten(world, flat);
+  SingleShot parareal(world, LossFn(), steps);
+  parareal.Problem::unflatten(world, flat);
+  parareal.setParareal(6, 5, 1e-10);
+
+  const TrajectoryRollout* expected = serial.getRolloutCache(world);
+  const TrajectoryRollout* actual = parareal.getRolloutCache(world);
+  EXPECT_GT(parareal.getLastPararealIterations(), 0);
+  EXPECT_LE(parareal.getLastPararealIterations(), 6);
+  EXPECT_TRUE(
+      equals(actual->getPosesConst(), expected->getPosesConst(), 1e-8));
+  EXPECT_TRUE(equals(actual->getVelsConst(), expected->getVelsConst(), 1e-8));
+  EXPECT_TRUE(equals(
+      parareal.getFinalState(world), serial.getFinalState(world), 1e-8));
+
+  // Capping the iterations at the number of segments is always exact
+  parareal.setParareal(6, 5, 0.0, 6);
+  actual = parareal.getRolloutCache(world);
+  EXPECT_EQ(parareal.getLastPararealIterations(), 6);
+  EXPECT_TRUE(
+      equals(actual->getPosesConst(), expected->getPosesConst(), 1e-12));
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(TRAJECTORY, PRISMATIC)
 {
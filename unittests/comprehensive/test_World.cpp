@@ -37,6 +37,8 @@
 #include "dart/math/Geometry.hpp"
 #include "dart/utils/SkelParser.hpp"
 #include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/BoxShape.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/collision/collision.hpp"
@@ -48,6 +50,9 @@
 #include "dart/constraint/BoxedLcpConstraintSolver.hpp"
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
+#include "dart/neural/BackpropSnapshot.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+#include "dart/neural/SnapshotPool.hpp"
 
 using namespace dart;
 using namespace math;
@@ -378,3 +383,575 @@ TEST(World, SetNewConstraintSolver)
   EXPECT_TRUE(world->getConstraintSolver()->getSkeletons().size() == 1);
   EXPECT_TRUE(world->getConstraintSolver()->getConstraints().size() == 1);
 }
+
+//==============================================================================
+TEST(World, SnapshotPoolRecyclesSnapshots)
+{
+  WorldPtr world = World::create();
+  world->addSkeleton(createThreeLinkRobot(
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_X,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Y,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Z,
+      false,
+      false));
+  WorldPtr unpooled = world->clone();
+  world->setSnapshotPoolEnabled(true);
+
+  std::shared_ptr<neural::SnapshotPool> pool = world->getSnapshotPool();
+  for (int i = 0; i < 10; i++)
+  {
+    std::shared_ptr<neural::BackpropSnapshot> pooledSnapshot
+        = neural::forwardPass(world);
+    std::shared_ptr<neural::BackpropSnapshot> freshSnapshot
+        = neural::forwardPass(unpooled);
+
+    EXPECT_TRUE(equals(
+        pooledSnapshot->getPostStepVelocity(),
+        freshSnapshot->getPostStepVelocity(),
+        0.0));
+
+    world->setPositions(pooledSnapshot->getPreStepPosition());
+    world->setVelocities(pooledSnapshot->getPreStepVelocity());
+    unpooled->setPositions(freshSnapshot->getPreStepPosition());
+    unpooled->setVelocities(freshSnapshot->getPreStepVelocity());
+    EXPECT_TRUE(equals(
+        pooledSnapshot->getVelVelJacobian(world),
+        freshSnapshot->getVelVelJacobian(unpooled),
+        0.0));
+    EXPECT_TRUE(equals(
+        pooledSnapshot->getPosVelJacobian(world),
+        freshSnapshot->getPosVelJacobian(unpooled),
+        0.0));
+    EXPECT_TRUE(equals(
+        pooledSnapshot->getControlForceVelJacobian(world),
+        freshSnapshot->getControlForceVelJacobian(unpooled),
+        0.0));
+    world->setPositions(pooledSnapshot->getPostStepPosition());
+    world->setVelocities(pooledSnapshot->getPostStepVelocity());
+    unpooled->setPositions(freshSnapshot->getPostStepPosition());
+    unpooled->setVelocities(freshSnapshot->getPostStepVelocity());
+  }
+
+  // We only ever held one snapshot at a time, so it should have been recycled
+  EXPECT_EQ(pool->getNumAllocated(), 1);
+  EXPECT_EQ(pool->getNumPooled(), 1);
+}
+
+//==============================================================================
+TEST(World, SnapshotPoolDropsSnapshotsOfTheWrongSize)
+{
+  WorldPtr world = World::create();
+  SkeletonPtr robot = createThreeLinkRobot(
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_X,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Y,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Z,
+      false,
+      false);
+  world->addSkeleton(robot);
+  world->setSnapshotPoolEnabled(true);
+  std::shared_ptr<neural::SnapshotPool> pool = world->getSnapshotPool();
+
+  std::shared_ptr<neural::BackpropSnapshot> oldSnapshot
+      = neural::forwardPass(world);
+
+  // Growing the world while the old snapshot is still checked out means it
+  // comes back sized for the wrong number of DOFs
+  world->addSkeleton(robot->cloneSkeleton("second_robot"));
+  std::shared_ptr<neural::BackpropSnapshot> newSnapshot
+      = neural::forwardPass(world);
+
+  oldSnapshot.reset();
+  EXPECT_EQ(pool->getNumPooled(), 0);
+  newSnapshot.reset();
+  EXPECT_EQ(pool->getNumPooled(), 1);
+}
+
+//==============================================================================
+TEST(World, SparseMassMatrixMatchesDense)
+{
+  WorldPtr world = World::create();
+
+  // A root with two branches, so the mass matrix has structural zeros between
+  // the branches
+  SkeletonPtr branching = Skeleton::create("branching");
+  std::pair<RevoluteJoint*, BodyNode*> rootPair
+      = branching->createJointAndBodyNodePair<RevoluteJoint>();
+  rootPair.first->setAxis(Eigen::Vector3s::UnitZ());
+  for (int branch = 0; branch < 2; branch++)
+  {
+    BodyNode* parent = rootPair.second;
+    for (int i = 0; i < 2; i++)
+    {
+      std::pair<RevoluteJoint*, BodyNode*> pair
+          = parent->createChildJointAndBodyNodePair<RevoluteJoint>();
+      pair.first->setAxis(
+          branch == 0 ? Eigen::Vector3s::UnitX() : Eigen::Vector3s::UnitY());
+      Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+      offset.translation() = Eigen::Vector3s(branch == 0 ? 0.5 : -0.5, 0, 0);
+      pair.first->setTransformFromParentBodyNode(offset);
+      parent = pair.second;
+    }
+  }
+  world->addSkeleton(branching);
+  world->addSkeleton(createThreeLinkRobot(
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_X,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Y,
+      Eigen::Vector3s(1.0, 1.0, 1.0),
+      DOF_Z,
+      false,
+      false));
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+
+  Eigen::MatrixXs denseM = world->getMassMatrix();
+  Eigen::MatrixXs denseMinv = world->getInvMassMatrix();
+  Eigen::SparseMatrix<s_t> sparseM = world->getSparseMassMatrix();
+  Eigen::SparseMatrix<s_t> sparseMinv = world->getSparseInvMassMatrix();
+
+  EXPECT_TRUE(equals(Eigen::MatrixXs(sparseM), denseM, 1e-12));
+  EXPECT_TRUE(equals(Eigen::MatrixXs(sparseMinv), denseMinv, 1e-12));
+  // The two branches don't couple, and neither do the two skeletons
+  EXPECT_LT(sparseM.nonZeros(), denseM.size());
+
+  Eigen::VectorXs x = Eigen::VectorXs::Random(world->getNumDofs());
+  Eigen::VectorXs Mx = denseM * x;
+  Eigen::VectorXs MinvX = denseMinv * x;
+  EXPECT_TRUE(equals(world->multiplyByImplicitMassMatrix(x), Mx, 1e-9));
+  EXPECT_TRUE(equals(world->multiplyByImplicitInvMassMatrix(x), MinvX, 1e-9));
+}
+
+//==============================================================================
+WorldPtr createBoxStackWorld()
+{
+  WorldPtr world = World::create();
+  world->getConstraintSolver()->setCollisionDetector(
+      collision::CollisionDetector::getFactory()->create("dart"));
+  world->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  SkeletonPtr floor = Skeleton::create("floor");
+  BodyNode* floorBody
+      = floor->createJointAndBodyNodePair<RevoluteJoint>().second;
+  floorBody->createShapeNodeWith<CollisionAspect>(
+      std::make_shared<BoxShape>(Eigen::Vector3s(10.0, 1.0, 10.0)));
+  floor->setMobile(false);
+  world->addSkeleton(floor);
+
+  // Two boxes stacked on the floor, each slightly penetrating the one below
+  for (int i = 0; i < 2; i++)
+  {
+    SkeletonPtr box = Skeleton::create("box_" + std::to_string(i));
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>();
+    pair.second->createShapeNodeWith<CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(1.0, 1.0, 1.0)));
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s(0.1 * i, 0.99 + 0.99 * i, 0);
+    pair.first->setTransformFromChildBodyNode(T);
+    world->addSkeleton(box);
+  }
+
+  return world;
+}
+
+//==============================================================================
+TEST(World, JacobianLcpAssemblyMatchesImpulseTests)
+{
+  WorldPtr impulseWorld = createBoxStackWorld();
+  WorldPtr jacobianWorld = createBoxStackWorld();
+  constraint::BoxedLcpConstraintSolver* solver
+      = static_cast<constraint::BoxedLcpConstraintSolver*>(
+          jacobianWorld->getConstraintSolver());
+  EXPECT_FALSE(solver->getJacobianAssemblyEnabled());
+  solver->setJacobianAssemblyEnabled(true);
+
+  for (int i = 0; i < 10; i++)
+  {
+    std::shared_ptr<neural::BackpropSnapshot> impulseSnapshot
+        = neural::forwardPass(impulseWorld);
+    std::shared_ptr<neural::BackpropSnapshot> jacobianSnapshot
+        = neural::forwardPass(jacobianWorld);
+
+    EXPECT_TRUE(equals(
+        impulseSnapshot->getPostStepVelocity(),
+        jacobianSnapshot->getPostStepVelocity(),
+        1e-8));
+
+    impulseWorld->setPositions(impulseSnapshot->getPreStepPosition());
+    impulseWorld->setVelocities(impulseSnapshot->getPreStepVelocity());
+    jacobianWorld->setPositions(jacobianSnapshot->getPreStepPosition());
+    jacobianWorld->setVelocities(jacobianSnapshot->getPreStepVelocity());
+    EXPECT_TRUE(equals(
+        impulseSnapshot->getVelVelJacobian(impulseWorld),
+        jacobianSnapshot->getVelVelJacobian(jacobianWorld),
+        1e-8));
+    impulseWorld->setPositions(impulseSnapshot->getPostStepPosition());
+    impulseWorld->setVelocities(impulseSnapshot->getPostStepVelocity());
+    jacobianWorld->setPositions(jacobianSnapshot->getPostStepPosition());
+    jacobianWorld->setVelocities(jacobianSnapshot->getPostStepVelocity());
+  }
+}
+
+//==============================================================================
+TEST(World, ContactWarmStartSurvivesContactChurn)
+{
+  WorldPtr coldWorld = createBoxStackWorld();
+  WorldPtr warmWorld = createBoxStackWorld();
+  constraint::BoxedLcpConstraintSolver* solver
+      = static_cast<constraint::BoxedLcpConstraintSolver*>(
+          warmWorld->getConstraintSolver());
+  EXPECT_FALSE(solver->getContactWarmStartEnabled());
+  solver->setContactWarmStartEnabled(true);
+
+  // Drop a third box from above, so contacts come and go while the stack
+  // stays in touch
+  for (WorldPtr world : {coldWorld, warmWorld})
+  {
+    SkeletonPtr box = Skeleton::create("falling_box");
+    std::pair<FreeJoint*, BodyNode*> pair
+        = box->createJointAndBodyNodePair<FreeJoint>();
+    pair.second->createShapeNodeWith<CollisionAspect>(
+        std::make_shared<BoxShape>(Eigen::Vector3s(1.0, 1.0, 1.0)));
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s(-0.2, 3.2, 0);
+    pair.first->setTransformFromChildBodyNode(T);
+    world->addSkeleton(box);
+  }
+
+  // Warm starting only changes where the LCP solver starts, so the stack
+  // should end up in the same place
+  for (int i = 0; i < 200; i++)
+  {
+    coldWorld->step();
+    warmWorld->step();
+  }
+  EXPECT_TRUE(
+      equals(coldWorld->getPositions(), warmWorld->getPositions(), 1e-3));
+  EXPECT_TRUE(
+      equals(coldWorld->getVelocities(), warmWorld->getVelocities(), 1e-2));
+}
+
+//==============================================================================
+TEST(World, ParallelSkeletonUpdatesMatchSerial)
+{
+  for (bool parallelPosAndVel : {true, false})
+  {
+    WorldPtr serialWorld = createBoxStackWorld();
+    WorldPtr parallelWorld = createBoxStackWorld();
+    EXPECT_FALSE(parallelWorld->getParallelSkeletonUpdatesEnabled());
+    parallelWorld->setParallelSkeletonUpdatesEnabled(true);
+    EXPECT_TRUE(parallelWorld->clone()->getParallelSkeletonUpdatesEnabled());
+    serialWorld->setParallelVelocityAndPositionUpdates(parallelPosAndVel);
+    parallelWorld->setParallelVelocityAndPositionUpdates(parallelPosAndVel);
+
+    for (int i = 0; i < 20; i++)
+    {
+      serialWorld->step();
+      parallelWorld->step();
+      EXPECT_TRUE(equals(
+          serialWorld->getPositions(), parallelWorld->getPositions(), 0.0));
+      EXPECT_TRUE(equals(
+          serialWorld->getVelocities(), parallelWorld->getVelocities(), 0.0));
+    }
+  }
+}
+
+//==============================================================================
+TEST(World, SleepingSkeletons)
+{
+  WorldPtr world = createBoxStackWorld();
+  EXPECT_FALSE(world->getSleepingEnabled());
+  world->setSleepingEnabled(true);
+  world->setSleepSteps(10);
+  world->setSleepVelocityThreshold(1e-2);
+  EXPECT_TRUE(world->clone()->getSleepingEnabled());
+
+  // Let the stack settle until both boxes fall asleep
+  SkeletonPtr bottom = world->getSkeleton("box_0");
+  SkeletonPtr top = world->getSkeleton("box_1");
+  for (int i = 0; i < 2000 && !(bottom->isAsleep() && top->isAsleep()); i++)
+  {
+    world->step();
+  }
+  ASSERT_TRUE(bottom->isAsleep());
+  ASSERT_TRUE(top->isAsleep());
+
+  // Sleeping boxes don't move at all
+  Eigen::VectorXs positions = world->getPositions();
+  for (int i = 0; i < 10; i++)
+  {
+    world->step();
+  }
+  EXPECT_TRUE(equals(world->getPositions(), positions, 0.0));
+  EXPECT_TRUE(world->getVelocities().isZero(0));
+
+  // Pushing the top box wakes it, and it pushes the bottom box awake too
+  top->getBodyNode(0)->addExtForce(Eigen::Vector3s(0, -200, 0));
+  world->step();
+  EXPECT_FALSE(top->isAsleep());
+  EXPECT_FALSE(bottom->isAsleep());
+
+  // Nothing sleeps while gradients are on
+  for (int i = 0; i < 2000 && !top->isAsleep(); i++)
+  {
+    world->step();
+  }
+  ASSERT_TRUE(top->isAsleep());
+  world->getConstraintSolver()->setGradientEnabled(true);
+  world->step();
+  EXPECT_FALSE(top->isAsleep());
+  EXPECT_FALSE(bottom->isAsleep());
+}
+
+//==============================================================================
+TEST(World, SleepingSkeletonsWakeWhenMoved)
+{
+  WorldPtr world = createBoxStackWorld();
+  world->setSleepingEnabled(true);
+  world->setSleepSteps(10);
+  world->setSleepVelocityThreshold(1e-2);
+
+  SkeletonPtr bottom = world->getSkeleton("box_0");
+  SkeletonPtr top = world->getSkeleton("box_1");
+  for (int i = 0; i < 2000 && !(bottom->isAsleep() && top->isAsleep()); i++)
+  {
+    world->step();
+  }
+  ASSERT_TRUE(bottom->isAsleep());
+  ASSERT_TRUE(top->isAsleep());
+
+  // Lifting the top box wakes it, so it falls back down
+  FreeJoint* joint = static_cast<FreeJoint*>(top->getRootJoint());
+  Eigen::Isometry3s T = top->getBodyNode(0)->getWorldTransform();
+  T.translation()(1) += 1.0;
+  joint->setTransform(T);
+  world->step();
+  EXPECT_FALSE(top->isAsleep());
+  EXPECT_TRUE(bottom->isAsleep());
+  EXPECT_LT(
+      top->getBodyNode(0)->getWorldTransform().translation()(1),
+      T.translation()(1));
+}
+
+//==============================================================================
+TEST(World, StepTimings)
+{
+  auto world = createWorld();
+  for (int i = 0; i < 10; i++)
+    world->step();
+
+  StepTimings timings = world->getStepTimings();
+  EXPECT_EQ(timings.numSteps, 10);
+  EXPECT_GT(timings.totalNs, 0u);
+  EXPECT_GT(timings.collisionDetectionNs, 0u);
+  EXPECT_GT(timings.velocityIntegrationNs, 0u);
+  // Every phase happens inside step()
+  EXPECT_LE(
+      timings.collisionDetectionNs + timings.lcpConstructionNs
+          + timings.lcpSolveNs + timings.velocityIntegrationNs
+          + timings.positionIntegrationNs,
+      timings.totalNs);
+
+  world->resetStepTimings();
+  timings = world->getStepTimings();
+  EXPECT_EQ(timings.numSteps, 0);
+  EXPECT_EQ(timings.totalNs, 0u);
+  EXPECT_EQ(timings.collisionDetectionNs, 0u);
+}
+
+//==============================================================================
+TEST(World, GetStateInto)
+{
+  auto world = createWorld();
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+
+  Eigen::VectorXs out = Eigen::VectorXs::Zero(world->getNumDofs());
+  world->getPositionsInto(out);
+  EXPECT_TRUE(equals(out, world->getPositions(), 0.0));
+  world->getVelocitiesInto(out);
+  EXPECT_TRUE(equals(out, world->getVelocities(), 0.0));
+
+  // Writing into a slice of a bigger buffer works too
+  Eigen::VectorXs state = Eigen::VectorXs::Zero(world->getNumDofs() * 2);
+  world->getPositionsInto(state.head(world->getNumDofs()));
+  world->getVelocitiesInto(state.tail(world->getNumDofs()));
+  EXPECT_TRUE(equals(state, world->getState(), 0.0));
+
+  SkeletonPtr skel = world->getSkeleton(0);
+  Eigen::VectorXs skelOut = Eigen::VectorXs::Zero(skel->getNumDofs());
+  skel->getPositionsInto(skelOut);
+  EXPECT_TRUE(equals(skelOut, skel->getPositions(), 0.0));
+}
+
+//==============================================================================
+TEST(World, ForkReusesMatchingClone)
+{
+  WorldPtr world = createBoxStackWorld();
+  WorldPtr fork = world->fork();
+  ASSERT_NE(fork, world);
+
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setControlForces(Eigen::VectorXs::Random(world->getNumDofs()));
+  world->setLinkMasses(world->getLinkMasses() * 1.5);
+  for (int i = 0; i < 3; i++)
+    world->step();
+
+  // The second fork only copies state into the first one
+  WorldPtr refork = world->fork(fork);
+  EXPECT_EQ(refork, fork);
+  EXPECT_EQ(refork->getTime(), world->getTime());
+  EXPECT_TRUE(equals(refork->getPositions(), world->getPositions(), 0.0));
+  EXPECT_TRUE(equals(refork->getVelocities(), world->getVelocities(), 0.0));
+  EXPECT_TRUE(
+      equals(refork->getControlForces(), world->getControlForces(), 0.0));
+  EXPECT_TRUE(equals(refork->getLinkMasses(), world->getLinkMasses(), 0.0));
+
+  // So it steps exactly like a fresh clone does
+  WorldPtr clone = world->clone();
+  refork->step();
+  clone->step();
+  EXPECT_TRUE(equals(refork->getPositions(), clone->getPositions(), 0.0));
+  EXPECT_TRUE(equals(refork->getVelocities(), clone->getVelocities(), 0.0));
+
+  // A world with a different structure gets replaced by a real clone
+  WorldPtr other = World::create();
+  WorldPtr otherFork = world->fork(other);
+  EXPECT_NE(otherFork, other);
+  EXPECT_FALSE(world->copyStateInto(*other));
+  EXPECT_EQ(otherFork->getNumDofs(), world->getNumDofs());
+}
+
+//==============================================================================
+TEST(World, SaveAndLoadStateBlob)
+{
+  WorldPtr world = createBoxStackWorld();
+  world->setVelocities(Eigen::VectorXs::Random(world->getNumDofs()));
+  for (int i = 0; i < 3; i++)
+    world->step();
+
+  Eigen::VectorXs blob;
+  world->saveStateTo(blob);
+  Eigen::VectorXs pos = world->getPositions();
+  Eigen::VectorXs vel = world->getVelocities();
+  Eigen::VectorXs lcpCache = world->getCachedLCPSolution();
+  s_t time = world->getTime();
+
+  world->step();
+  Eigen::VectorXs nextPos = world->getPositions();
+  Eigen::VectorXs nextVel = world->getVelocities();
+  for (int i = 0; i < 3; i++)
+    world->step();
+
+  EXPECT_TRUE(world->loadStateFrom(blob));
+  EXPECT_EQ(world->getTime(), time);
+  EXPECT_TRUE(equals(world->getPositions(), pos, 0.0));
+  EXPECT_TRUE(equals(world->getVelocities(), vel, 0.0));
+  EXPECT_TRUE(equals(world->getCachedLCPSolution(), lcpCache, 0.0));
+
+  // Stepping from the restored state lands exactly where it did the first time
+  world->step();
+  EXPECT_TRUE(equals(world->getPositions(), nextPos, 0.0));
+  EXPECT_TRUE(equals(world->getVelocities(), nextVel, 0.0));
+
+  // Saving into the same buffer again reuses it
+  const s_t* data = blob.data();
+  world->loadStateFrom(blob);
+  world->saveStateTo(blob);
+  EXPECT_EQ(blob.data(), data);
+
+  // A blob from a different World is rejected
+  WorldPtr other = World::create();
+  EXPECT_FALSE(other->loadStateFrom(blob));
+}
+
+//==============================================================================
+TEST(World, IncrementalPositionsToJson)
+{
+  WorldPtr world = createBoxStackWorld();
+
+  // The first call sends everything
+  std::string json = world->positionsToJson(1e-3);
+  EXPECT_NE(json.find("\"floor."), std::string::npos);
+  EXPECT_NE(json.find("\"box_0."), std::string::npos);
+  EXPECT_NE(json.find("\"box_1."), std::string::npos);
+  EXPECT_EQ(world->positionsToJson(1e-3), "{}");
+
+  SkeletonPtr box = world->getSkeleton("box_1");
+  Eigen::VectorXs pos = box->getPositions();
+  pos(3) += 0.1;
+  box->setPositions(pos);
+  json = world->positionsToJson(1e-3);
+  EXPECT_EQ(json.find("\"box_0."), std::string::npos);
+  EXPECT_NE(json.find("\"box_1."), std::string::npos);
+
+  // Small moves are held back until they add up past epsilon
+  for (int i = 0; i < 4; i++)
+  {
+    pos(3) += 3e-4;
+    box->setPositions(pos);
+    EXPECT_EQ(world->positionsToJson(1e-3) == "{}", i < 3);
+  }
+
+  EXPECT_NE(world->colorsToJson(1e-3).find("\"box_0."), std::string::npos);
+  EXPECT_EQ(world->colorsToJson(1e-3), "{}");
+
+  world->resetJsonDiffs();
+  EXPECT_EQ(world->positionsToJson(1e-3), world->positionsToJson());
+}
+
+//==============================================================================
+TEST(World, CachedInertiaVectors)
+{
+  WorldPtr world = createBoxStackWorld();
+
+  // Nothing changed, so we get the same vector back without reassembling it
+  const Eigen::VectorXs& masses = world->getLinkMasses();
+  EXPECT_EQ(&masses, &world->getLinkMasses());
+  Eigen::VectorXs expected = masses;
+
+  // Moving things around doesn't touch the cache
+  world->setPositions(Eigen::VectorXs::Random(world->getNumDofs()));
+  EXPECT_EQ(&masses, &world->getLinkMasses());
+  EXPECT_TRUE(equals(world->getLinkMasses(), expected, 0.0));
+
+  // Setting a mass straight on a BodyNode is noticed
+  SkeletonPtr box = world->getSkeleton("box_1");
+  BodyNode* node = box->getBodyNode(0);
+  node->setMass(node->getMass() * 2);
+  std::size_t index = 0;
+  for (std::size_t i = 0; i < world->getNumSkeletons(); i++)
+  {
+    if (world->getSkeleton(i) == box)
+      break;
+    index += world->getSkeleton(i)->getNumBodyNodes();
+  }
+  expected(index) *= 2;
+  EXPECT_TRUE(equals(world->getLinkMasses(), expected, 0.0));
+
+  // So are changes to the COMs and inertias
+  Eigen::Vector3s com = node->getLocalCOM() + Eigen::Vector3s::UnitX() * 0.1;
+  node->setLocalCOM(com);
+  EXPECT_TRUE(equals(
+      Eigen::VectorXs(world->getLinkCOMs().segment<3>(3 * index)),
+      Eigen::VectorXs(com),
+      0.0));
+  Eigen::VectorXs groupMasses = world->getGroupMasses();
+  world->setGroupMasses(groupMasses * 3);
+  EXPECT_TRUE(equals(
+      world->getGroupMasses(), Eigen::VectorXs(groupMasses * 3), 1e-12));
+
+  // As are skeletons coming and going
+  std::size_t numBodies = world->getLinkMasses().size();
+  world->removeSkeleton(box);
+  EXPECT_EQ(
+      world->getLinkMasses().size(),
+      numBodies - (int)box->getNumBodyNodes());
+}
@@ -85,4 +85,49 @@ TEST(ACCEL_SMOOTHER, HUGE_TRAJECTORY)
   std::cout << "Diff: " << (smoothedIterative - smoothedSparse).squaredNorm()
             << std::endl;
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(ACCEL_SMOOTHER, WINDOWED_MATCHES_FULL)
+{
+  int dofs = 3;
+  int timesteps = 1000;
+  Eigen::MatrixXs data = Eigen::MatrixXs::Random(dofs, timesteps);
+
+  AccelerationSmoother smoother(timesteps, 1, 0.05, true, false);
+  Eigen::MatrixXs smoothed = smoother.smooth(data);
+
+  // Deliberately pick a window size that doesn't divide the series evenly
+  Eigen::MatrixXs windowed
+      = AccelerationSmoother::smoothWindowed(data, 1, 0.05, 170);
+  EXPECT_EQ(windowed.cols(), timesteps);
+  EXPECT_TRUE(equals(smoothed, windowed, 1e-8));
+
+  // One window bigger than the whole series is just a direct solve
+  Eigen::MatrixXs oneWindow
+      = AccelerationSmoother::smoothWindowed(data, 1, 0.05, 5000);
+  EXPECT_TRUE(equals(smoothed, oneWindow, 1e-8));
+}
+#endif
+
+
+#ifdef ALL_TESTS
+TEST(ACCEL_SMOOTHER, THREADED_CACHED_MATCHES_DENSE)
+{
+  int dofs = 7;
+  int timesteps = 50;
+  Eigen::MatrixXs data = Eigen::MatrixXs::Random(dofs, timesteps);
+
+  AccelerationSmoother smootherDense(timesteps, 1, 0.05, false, false);
+  Eigen::MatrixXs smoothedDense = smootherDense.smooth(data);
+
+  // Two smoothers with the same settings share one factorization
+  AccelerationSmoother smootherSparse(timesteps, 1, 0.05, true, false);
+  AccelerationSmoother smootherSparseAgain(timesteps, 1, 0.05, true, false);
+  EXPECT_TRUE(equals(smoothedDense, smootherSparse.smooth(data, 1), 1e-8));
+  EXPECT_TRUE(
+      equals(smoothedDense, smootherSparseAgain.smooth(data, 3), 1e-8));
+  EXPECT_TRUE(
+      equals(smoothedDense, smootherSparseAgain.smooth(data, -1), 1e-8));
+}
+#endif
@@ -101,6 +101,123 @@ TEST(ANTHROPOMETRICS, LOAD)
 }
 // #endif
 
+// #ifdef ALL_TESTS
+TEST(ANTHROPOMETRICS, BATCHED_MEASURE_MATCHES_PER_METRIC)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  std::shared_ptr<dynamics::Skeleton> skel = file.skeleton;
+  skel->autogroupSymmetricSuffixes();
+
+  srand(42);
+  Eigen::VectorXs bentPose = skel->getRandomPose();
+  Eigen::VectorXs shortPose = Eigen::VectorXs::Ones(5) * 0.2;
+
+  // A mix of metrics in the current pose, in explicit poses, and inheriting
+  // the pose of the metric before them
+  std::vector<AnthroMetric> metrics;
+  metrics.emplace_back(
+      "thigh",
+      Eigen::VectorXs::Zero(0),
+      "femur_r",
+      Eigen::Vector3s(0.0, 0.1, 0.0),
+      "tibia_r",
+      Eigen::Vector3s(0.0, -0.1, 0.0));
+  metrics.emplace_back(
+      "arm",
+      bentPose,
+      "humerus_rv",
+      Eigen::Vector3s(0.01, 0.0, 0.0),
+      "radius_rv",
+      Eigen::Vector3s(0.0, -0.05, 0.0));
+  metrics.emplace_back(
+      "arm_height",
+      Eigen::VectorXs::Zero(0),
+      "humerus_rv",
+      Eigen::Vector3s::Zero(),
+      "radius_rv",
+      Eigen::Vector3s::Zero(),
+      Eigen::Vector3s::UnitY());
+  metrics.emplace_back(
+      "leg",
+      shortPose,
+      "femur_r",
+      Eigen::Vector3s::Zero(),
+      "tibia_r",
+      Eigen::Vector3s(0.0, -0.3, 0.0),
+      Eigen::Vector3s::UnitY());
+  metrics.emplace_back(
+      "leg_again",
+      bentPose,
+      "femur_l",
+      Eigen::Vector3s::Zero(),
+      "tibia_l",
+      Eigen::Vector3s(0.0, -0.3, 0.0));
+  metrics.emplace_back(
+      "missing",
+      Eigen::VectorXs::Zero(0),
+      "no_such_mesh",
+      Eigen::Vector3s::Zero(),
+      "tibia_l",
+      Eigen::Vector3s::Zero());
+
+  Anthropometrics anthro;
+  std::vector<std::string> names;
+  for (AnthroMetric& metric : metrics)
+  {
+    anthro.addMetric(
+        metric.name,
+        metric.bodyPose,
+        metric.meshA,
+        metric.offsetA,
+        metric.meshB,
+        metric.offsetB,
+        metric.axis);
+    names.push_back(metric.name);
+  }
+  Eigen::VectorXs mu = Eigen::VectorXs::Random(names.size());
+  anthro.setDistribution(std::make_shared<MultivariateGaussian>(
+      names, mu, Eigen::MatrixXs::Identity(names.size(), names.size())));
+
+  Eigen::VectorXs pos = skel->getRandomPose();
+  skel->setPositions(pos);
+  Eigen::VectorXs scales = skel->getGroupScales();
+  scales += Eigen::VectorXs::Random(scales.size()) * 0.1;
+  skel->setGroupScales(scales);
+
+  // Measure each metric on its own, posing the skeleton for each one
+  std::map<std::string, s_t> expected;
+  for (int i = 0; i < metrics.size(); i++)
+  {
+    anthro.setSkelToMetricPose(skel, metrics[i]);
+    auto markers = anthro.getMarkers(skel, metrics[i]);
+    if (markers.first.first == nullptr || markers.second.first == nullptr)
+    {
+      expected[metrics[i].name] = mu(i);
+    }
+    else if (metrics[i].axis == Eigen::Vector3s::Zero())
+    {
+      expected[metrics[i].name]
+          = skel->getDistanceInWorldSpace(markers.first, markers.second);
+    }
+    else
+    {
+      expected[metrics[i].name] = skel->getDistanceAlongAxis(
+          markers.first, markers.second, metrics[i].axis);
+    }
+  }
+  skel->setPositions(pos);
+
+  std::map<std::string, s_t> batched = anthro.measure(skel);
+  EXPECT_TRUE(skel->getPositions() == pos);
+  EXPECT_EQ(batched.size(), expected.size());
+  for (auto pair : expected)
+  {
+    EXPECT_NEAR(batched[pair.first], pair.second, 1e-12);
+  }
+}
+// #endif
+
 #ifdef BLOCKING_GUI_TEST
 // #ifdef ALL_TESTS
 TEST(ANTHROPOMETRICS, GUI)
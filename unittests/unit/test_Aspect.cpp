@@ -845,6 +845,33 @@ TEST(Aspect, Duplication)
   EXPECT_EQ(state.IntAspect::State::val, 456);
 }
 
+TEST(Aspect, LookupAfterMatching)
+{
+  Composite comp1, comp2;
+
+  // comp2 sees these types in a different order than comp1 does
+  comp2.createAspect<CharAspect>();
+  comp1.createAspect<IntAspect>();
+  comp1.createAspect<CharAspect>();
+
+  comp2.matchAspects(&comp1);
+  EXPECT_FALSE(comp2.get<IntAspect>() == nullptr);
+  EXPECT_FALSE(comp2.get<CharAspect>() == nullptr);
+  EXPECT_TRUE(comp2.get<FloatAspect>() == nullptr);
+  EXPECT_FALSE(comp2.get<IntAspect>() == comp1.get<IntAspect>());
+
+  std::unique_ptr<IntAspect> released = comp2.releaseAspect<IntAspect>();
+  EXPECT_FALSE(released == nullptr);
+  EXPECT_FALSE(comp2.has<IntAspect>());
+
+  comp2.set<IntAspect>(std::move(released));
+  EXPECT_TRUE(comp2.has<IntAspect>());
+
+  comp2.removeAspect<CharAspect>();
+  EXPECT_FALSE(comp2.has<CharAspect>());
+  EXPECT_TRUE(comp1.has<CharAspect>());
+}
+
 TEST(Aspect, Embedded)
 {
   EmbeddedStateComposite s;
@@ -161,4 +161,119 @@ TEST(C3D, MAPPING_STR_MORE_TARGET)
     std::string t = std::to_string(mapVec[i]);
     EXPECT_EQ(mapStr[s], t);
   }
-}
\ No newline at end of file
+}
+// This is the original dense greedy matcher, kept here as a reference for the
+// sparse one
+Eigen::VectorXi referenceGreedyAssignment(const Eigen::MatrixXs& weights)
+{
+  std::vector<int> rows;
+  std::vector<int> cols;
+  for (int i = 0; i < weights.rows(); i++)
+    rows.push_back(i);
+  for (int i = 0; i < weights.cols(); i++)
+    cols.push_back(i);
+
+  Eigen::VectorXi mapping = -1 * Eigen::VectorXi::Ones(weights.rows());
+  while (rows.size() > 0 && cols.size() > 0)
+  {
+    int maxRow = -1;
+    int maxCol = -1;
+    s_t maxScore = -1 * std::numeric_limits<double>::infinity();
+    for (int row = 0; row < rows.size(); row++)
+    {
+      for (int col = 0; col < cols.size(); col++)
+      {
+        s_t score = weights(rows[row], cols[col]);
+        if (score > maxScore)
+        {
+          maxScore = score;
+          maxRow = row;
+          maxCol = col;
+        }
+      }
+    }
+    if (maxRow == -1 || maxCol == -1)
+      break;
+    mapping(rows[maxRow]) = cols[maxCol];
+    rows.erase(rows.begin() + maxRow);
+    cols.erase(cols.begin() + maxCol);
+  }
+  return mapping;
+}
+
+TEST(C3D, SPARSE_MATCHES_DENSE_GREEDY)
+{
+  srand(42);
+  for (int trial = 0; trial < 20; trial++)
+  {
+    int rows = 1 + rand() % 12;
+    int cols = 1 + rand() % 12;
+    // Round the weights so there are plenty of ties, and knock out some
+    // entries entirely
+    Eigen::MatrixXs weights
+        = (Eigen::MatrixXs::Random(rows, cols) * 3).array().round().matrix();
+    for (int i = 0; i < rows; i++)
+    {
+      for (int j = 0; j < cols; j++)
+      {
+        if (rand() % 4 == 0)
+        {
+          weights(i, j) = -1 * std::numeric_limits<double>::infinity();
+        }
+      }
+    }
+    Eigen::VectorXi expected = referenceGreedyAssignment(weights);
+    Eigen::VectorXi actual
+        = math::AssignmentMatcher::assignRowsToColumns(weights);
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+TEST(C3D, GATED_DISTANCE_BATCH)
+{
+  srand(42);
+  std::vector<math::SparseAssignmentProblem> problems;
+  std::vector<Eigen::MatrixXs> denseWeights;
+  const s_t maxDistance = 0.3;
+  for (int frame = 0; frame < 10; frame++)
+  {
+    std::vector<Eigen::Vector3s> rowPoints;
+    std::vector<Eigen::Vector3s> colPoints;
+    for (int i = 0; i < 40; i++)
+    {
+      rowPoints.push_back(Eigen::Vector3s::Random());
+      colPoints.push_back(
+          rowPoints.back() + Eigen::Vector3s::Random() * maxDistance);
+    }
+    problems.push_back(math::AssignmentMatcher::createGatedDistanceProblem(
+        rowPoints, colPoints, maxDistance));
+
+    // This is how the trace builders compute their weights
+    Eigen::MatrixXs weights(rowPoints.size(), colPoints.size());
+    for (int i = 0; i < rowPoints.size(); i++)
+    {
+      for (int j = 0; j < colPoints.size(); j++)
+      {
+        s_t dist = (rowPoints[i] - colPoints[j]).norm();
+        weights(i, j) = dist > maxDistance
+                            ? -1 * std::numeric_limits<double>::infinity()
+                            : 1.0 / dist;
+      }
+    }
+    denseWeights.push_back(weights);
+    EXPECT_EQ(
+        (weights.array() > -1 * std::numeric_limits<double>::infinity())
+            .count(),
+        problems.back().weights.size());
+  }
+
+  std::vector<Eigen::VectorXi> results
+      = math::AssignmentMatcher::assignRowsToColumnsBatch(problems, 4);
+  ASSERT_EQ(results.size(), problems.size());
+  for (int frame = 0; frame < problems.size(); frame++)
+  {
+    EXPECT_EQ(
+        results[frame],
+        math::AssignmentMatcher::assignRowsToColumns(denseWeights[frame]));
+  }
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/NeuralUtils.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace neural;
+
+//==============================================================================
+template <typename JointType>
+BodyNode* addBody(const SkeletonPtr& skel, BodyNode* parent)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0, 0.3, 0.1);
+  pair.first->setTransformFromParentBodyNode(T);
+  pair.second->setMass(1.0);
+  return pair.second;
+}
+
+//==============================================================================
+// Two branches off a floating base, so most bodies don't depend on most DOFs
+SkeletonPtr createBranchingSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("branching");
+  BodyNode* root = addBody<FreeJoint>(skel, nullptr);
+  BodyNode* arm = addBody<RevoluteJoint>(skel, root);
+  addBody<BallJoint>(skel, arm);
+  BodyNode* leg = addBody<PrismaticJoint>(skel, root);
+  addBody<RevoluteJoint>(skel, leg);
+
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  return skel;
+}
+
+//==============================================================================
+TEST(BlockedWorldJacobian, MATCHES_DENSE_JACOBIANS)
+{
+  SkeletonPtr skel = createBranchingSkeleton();
+  std::vector<BodyNode*> nodes = skel->getBodyNodes();
+
+  std::vector<ConvertToSpace> spaces{ConvertToSpace::POS_SPATIAL,
+                                     ConvertToSpace::POS_LINEAR,
+                                     ConvertToSpace::VEL_SPATIAL,
+                                     ConvertToSpace::VEL_LINEAR};
+  std::vector<Eigen::MatrixXs> dense{
+      jointPosToWorldSpatialJacobian(skel, nodes),
+      jointPosToWorldLinearJacobian(skel, nodes),
+      jointVelToWorldSpatialJacobian(skel, nodes),
+      jointVelToWorldLinearJacobian(skel, nodes)};
+
+  for (std::size_t i = 0; i < spaces.size(); i++)
+  {
+    BlockedWorldJacobian blocked
+        = jointToWorldBlockedJacobian(skel, nodes, spaces[i]);
+    EXPECT_TRUE(equals(blocked.toDense(), dense[i], 1e-12));
+
+    Eigen::VectorXs x = Eigen::VectorXs::Random(skel->getNumDofs());
+    Eigen::VectorXs product = dense[i] * x;
+    EXPECT_TRUE(equals(blocked.multiply(x), product, 1e-12));
+
+    Eigen::VectorXs y = Eigen::VectorXs::Random(dense[i].rows());
+    Eigen::VectorXs expected = dense[i].transpose() * y;
+    EXPECT_TRUE(equals(blocked.transposeMultiply(y), expected, 1e-12));
+    EXPECT_TRUE(equals(
+        skelBackpropWorldSpaceToJointSpaceFused(skel, y, nodes, spaces[i]),
+        expected,
+        1e-12));
+  }
+}
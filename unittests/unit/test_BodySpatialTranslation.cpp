@@ -277,4 +277,86 @@ TEST(BODY_SPATIAL_TRANSLATION, RAJAGOPAL)
 
   EXPECT_TRUE(verifySpatialJacobians(skel));
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(BODY_SPATIAL_TRANSLATION, BODY_POSITIONS_OVER_TRAJECTORY)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  auto pelvis = skel->createJointAndBodyNodePair<dynamics::EulerFreeJoint>();
+  dynamics::BodyNode* parent = pelvis.second;
+  std::vector<const dynamics::BodyNode*> feet;
+  for (int leg = 0; leg < 2; leg++)
+  {
+    parent = pelvis.second;
+    for (int i = 0; i < 3; i++)
+    {
+      auto pair
+          = skel->createJointAndBodyNodePair<dynamics::RevoluteJoint>(parent);
+      Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+      T.translation() = Eigen::Vector3s::Random();
+      pair.first->setTransformFromParentBodyNode(T);
+      pair.first->setAxis(Eigen::Vector3s::Random().normalized());
+      parent = pair.second;
+    }
+    feet.push_back(parent);
+  }
+  // Ask for a body and one of its ancestors, out of order
+  feet.push_back(pelvis.second->getChildBodyNode(0));
+
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Random(skel->getNumDofs(), 5);
+  Eigen::VectorXs originalPositions = skel->getPositions();
+  Eigen::MatrixXs positions
+      = skel->getBodyWorldPositionsOverTrajectory(feet, poses);
+  EXPECT_TRUE(equals(skel->getPositions(), originalPositions, 0));
+
+  for (int t = 0; t < poses.cols(); t++)
+  {
+    skel->setPositions(poses.col(t));
+    for (int b = 0; b < feet.size(); b++)
+    {
+      Eigen::Vector3s expected = feet[b]->getWorldTransform().translation();
+      Eigen::Vector3s actual = positions.block<3, 1>(b * 3, t);
+      EXPECT_TRUE(equals(actual, expected, 1e-12));
+    }
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(BODY_SPATIAL_TRANSLATION, MOVING_VERTICES)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  auto root = skel->createJointAndBodyNodePair<dynamics::EulerFreeJoint>();
+  auto pair
+      = skel->createJointAndBodyNodePair<dynamics::RevoluteJoint>(root.second);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0.1, -0.3, 0.2);
+  pair.first->setTransformFromParentBodyNode(T);
+
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setAccelerations(Eigen::VectorXs::Random(skel->getNumDofs()));
+
+  std::vector<Eigen::Vector3s> localVertices;
+  for (int i = 0; i < 4; i++)
+  {
+    localVertices.push_back(Eigen::Vector3s::Random());
+  }
+  std::vector<dynamics::BodyNode::MovingVertex> vertices
+      = pair.second->getMovingVerticesInWorldSpace(localVertices, 7);
+  ASSERT_EQ(vertices.size(), localVertices.size());
+  for (int i = 0; i < localVertices.size(); i++)
+  {
+    const Eigen::Vector3s& local = localVertices[i];
+    Eigen::Vector3s pos = pair.second->getWorldTransform() * local;
+    Eigen::Vector3s vel = pair.second->getLinearVelocity(
+        local, dynamics::Frame::World(), dynamics::Frame::World());
+    Eigen::Vector3s accel = pair.second->getLinearAcceleration(
+        local, dynamics::Frame::World(), dynamics::Frame::World());
+    EXPECT_TRUE(equals(vertices[i].pos, pos, 1e-12));
+    EXPECT_TRUE(equals(vertices[i].vel, vel, 1e-12));
+    EXPECT_TRUE(equals(vertices[i].accel, accel, 1e-12));
+    EXPECT_EQ(vertices[i].timestep, 7);
+  }
+}
+#endif
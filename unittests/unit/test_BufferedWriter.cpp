@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2011-2019, The DART development contributors
+ * All rights reserved.
+ *
+ * The list of contributors can be found at:
+ *   https://github.com/dartsim/dart/blob/master/LICENSE
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "dart/utils/BufferedWriter.hpp"
+#include "dart/utils/CSVParser.hpp"
+
+using namespace dart;
+using namespace utils;
+
+namespace {
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream in(path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+} // namespace
+
+//==============================================================================
+TEST(BufferedWriter, FORMATTING)
+{
+  TextBuffer buffer;
+  buffer << "a" << ',' << std::string("b") << ',' << 12 << ',' << -7L << ','
+         << true << ',' << 2.5 << ',' << 1e-300 << ',' << 0.1f;
+  EXPECT_EQ(buffer.str(), "a,b,12,-7,1,2.5,1e-300,0.1");
+
+  // Doubles come back exactly, unlike the default 6 digits of a std::ofstream
+  TextBuffer exact;
+  exact << (0.1 + 0.2);
+  EXPECT_EQ(CSVParser::parseNumber(exact.str()), 0.1 + 0.2);
+}
+
+//==============================================================================
+TEST(BufferedWriter, PARALLEL_ROWS_MATCH_SERIAL)
+{
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::string serialPath
+      = (dir / "test_BufferedWriter_serial.csv").string();
+  const std::string parallelPath
+      = (dir / "test_BufferedWriter_parallel.csv").string();
+
+  const int numRows = 3 * BufferedWriter::ROWS_PER_CHUNK + 17;
+  auto formatRow = [](int row, TextBuffer& out) {
+    out << row << "," << row / 7.0 << "\n";
+  };
+
+  {
+    // A tiny buffer, so we flush many times along the way
+    BufferedWriter serial(serialPath, 64);
+    ASSERT_TRUE(serial.isOpen());
+    serial << "row,value\n";
+    serial.writeRows(numRows, formatRow, 1);
+  }
+  {
+    BufferedWriter parallel(parallelPath);
+    parallel << "row,value\n";
+    parallel.writeRows(numRows, formatRow, 4);
+  }
+
+  const std::string serial = readFile(serialPath);
+  EXPECT_EQ(serial, readFile(parallelPath));
+
+  CSVParser::NumericTableOptions options;
+  CSVParser::NumericTable table
+      = CSVParser::readNumericTable(serialPath, options);
+  ASSERT_EQ(table.values.rows(), numRows);
+  for (int row = 0; row < numRows; row++)
+  {
+    EXPECT_EQ(table.values(row, 0), row);
+    EXPECT_EQ(table.values(row, 1), row / 7.0);
+  }
+}
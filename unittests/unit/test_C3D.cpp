@@ -6,6 +6,7 @@
 #include <gtest/gtest.h>
 #include <math.h>
 
+#include "dart/biomechanics/C3DForcePlatforms.hpp"
 #include "dart/biomechanics/C3DLoader.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/common/LocalResourceRetriever.hpp"
@@ -74,4 +75,238 @@ TEST(C3D, LOAD)
   server->renderBasis(1.0);
   biomechanics::C3DLoader::debugToGUI(c3d, server);
 }
-#endif
\ No newline at end of file
+#endif
+TEST(C3D, LOAD_BATCH)
+{
+  std::vector<std::string> c3dFiles{
+      "dart://sample/c3d/JA1Gait35.c3d", "dart://sample/c3d/JA1Gait35.c3d"};
+  std::vector<biomechanics::C3D> c3ds
+      = biomechanics::C3DLoader::loadC3DBatch(c3dFiles, 2);
+  biomechanics::C3D serial
+      = biomechanics::C3DLoader::loadC3D("dart://sample/c3d/JA1Gait35.c3d");
+  biomechanics::C3DLoader::fixupMarkerFlips(&serial);
+
+  ASSERT_EQ(c3ds.size(), c3dFiles.size());
+  for (biomechanics::C3D& c3d : c3ds)
+  {
+    EXPECT_EQ(c3d.markers, serial.markers);
+    ASSERT_EQ(c3d.markerTimesteps.size(), serial.markerTimesteps.size());
+    for (int i = 0; i < serial.markerTimesteps.size(); i++)
+    {
+      ASSERT_EQ(
+          c3d.markerTimesteps[i].size(), serial.markerTimesteps[i].size());
+      for (auto& pair : serial.markerTimesteps[i])
+      {
+        EXPECT_TRUE(equals(c3d.markerTimesteps[i][pair.first], pair.second));
+      }
+    }
+  }
+
+  std::vector<common::Uri> trcFiles{
+      "dart://sample/osim/Sprinter/run0900cms.trc",
+      "dart://sample/osim/Sprinter/run0900cms.trc"};
+  std::vector<biomechanics::OpenSimTRC> trcs
+      = biomechanics::OpenSimParser::loadTRCBatch(trcFiles, 2);
+  biomechanics::OpenSimTRC serialTrc = biomechanics::OpenSimParser::loadTRC(
+      "dart://sample/osim/Sprinter/run0900cms.trc");
+  ASSERT_EQ(trcs.size(), trcFiles.size());
+  for (biomechanics::OpenSimTRC& trc : trcs)
+  {
+    EXPECT_EQ(trc.timestamps, serialTrc.timestamps);
+    EXPECT_EQ(trc.markerTimesteps.size(), serialTrc.markerTimesteps.size());
+  }
+}
+
+namespace {
+
+/// This exposes the platform's reference frame, so the test can redo the
+/// per-frame computation by hand
+class InspectableForcePlatform : public biomechanics::ForcePlatform
+{
+public:
+  InspectableForcePlatform(
+      size_t idx, const ezc3d::c3d& c3d, int convention, size_t downsample)
+    : ForcePlatform(idx, c3d, convention, downsample)
+  {
+  }
+
+  const Eigen::Matrix3s& refFrame() const
+  {
+    return _refFrame;
+  }
+};
+
+/// This is the frame-by-frame force platform computation that
+/// ForcePlatform::processAnalogs() replaced, kept as a reference
+void perFrameForcePlatform(
+    const InspectableForcePlatform& pf,
+    size_t idx,
+    const ezc3d::c3d& c3d,
+    int convention,
+    std::vector<Eigen::Vector3s>& F,
+    std::vector<Eigen::Vector3s>& M,
+    std::vector<Eigen::Vector3s>& CoP,
+    std::vector<Eigen::Vector3s>& Tz)
+{
+  const ezc3d::ParametersNS::GroupNS::Group& groupFP(
+      c3d.parameters().group("FORCE_PLATFORM"));
+  const size_t type = pf.type();
+  const size_t nChannels = type == 3 ? 8 : 6;
+  const std::vector<size_t>& dimensions(
+      groupFP.parameter("CHANNEL").dimension());
+  const std::vector<int>& allChannelIdx(
+      groupFP.parameter("CHANNEL").valuesAsInt());
+  std::vector<size_t> channelIdx(nChannels);
+  for (size_t i = 0; i < nChannels; ++i)
+  {
+    channelIdx[i] = allChannelIdx[idx * dimensions[0] + i] - 1;
+  }
+
+  const Eigen::Matrix3s& refFrame = pf.refFrame();
+  const Eigen::Vector3s& origin = pf.origin();
+  const Eigen::Vector3s& meanCorners = pf.meanCorners();
+  for (const auto& frame : c3d.data().frames())
+  {
+    for (size_t i = 0; i < frame.analogs().nbSubframes(); ++i)
+    {
+      const auto& subframe(frame.analogs().subframe(i));
+      s_t ch[8];
+      for (size_t j = 0; j < nChannels; ++j)
+      {
+        ch[j] = subframe.channel(channelIdx[j]).data();
+      }
+      if (type == 1)
+      {
+        Eigen::Vector3s force = refFrame * Eigen::Vector3s(ch[0], ch[1], ch[2]);
+        Eigen::Vector3s cop = refFrame * Eigen::Vector3s(ch[3], ch[4], 0);
+        Eigen::Vector3s tz = refFrame * Eigen::Vector3s(0, 0, ch[5]);
+        F.push_back(force);
+        M.push_back(force.cross(cop) - tz);
+        CoP.push_back(cop + meanCorners);
+        Tz.push_back(tz);
+        continue;
+      }
+
+      Eigen::Vector3s forceRaw;
+      Eigen::Vector3s momentRaw;
+      if (type == 3)
+      {
+        forceRaw(0) = ch[0] + ch[1];
+        forceRaw(1) = ch[2] + ch[3];
+        forceRaw(2) = ch[4] + ch[5] + ch[6] + ch[7];
+        momentRaw(0) = origin(1) * (ch[4] + ch[5] - ch[6] - ch[7]);
+        momentRaw(1) = origin(0) * (ch[5] + ch[6] - ch[4] - ch[7]);
+        momentRaw(2)
+            = origin(1) * (ch[1] - ch[0]) + origin(0) * (ch[2] - ch[3]);
+        momentRaw += forceRaw.cross(Eigen::Vector3s(0, 0, origin(2)));
+      }
+      else
+      {
+        Eigen::Vector6s dataRaw;
+        dataRaw << ch[0], ch[1], ch[2], ch[3], ch[4], ch[5];
+        if (type == 4)
+        {
+          dataRaw = pf.calMatrix() * dataRaw;
+        }
+        forceRaw = dataRaw.head<3>();
+        momentRaw = dataRaw.tail<3>();
+        if (convention == 1)
+        {
+          momentRaw += forceRaw.cross(origin);
+        }
+      }
+      F.push_back(refFrame * forceRaw);
+      M.push_back(refFrame * momentRaw);
+
+      Eigen::Vector3s copRaw(
+          -momentRaw(1) / forceRaw(2), momentRaw(0) / forceRaw(2), 0);
+      Eigen::Vector3s originNoVertical = origin;
+      originNoVertical(2) = 0.0;
+      if (convention == 0)
+      {
+        CoP.push_back(refFrame * (copRaw + originNoVertical) + meanCorners);
+      }
+      else
+      {
+        CoP.push_back(refFrame * copRaw + meanCorners);
+      }
+      Tz.push_back(refFrame * (momentRaw - forceRaw.cross(-1 * copRaw)));
+    }
+  }
+}
+
+/// This checks row `row` of `batch` against `expected`. Frames with no
+/// vertical force have an undefined CoP, so those only need to be non-finite
+/// on both sides.
+bool rowMatches(
+    const math::Vector3Batch& batch,
+    Eigen::Index row,
+    const Eigen::Vector3s& expected)
+{
+  for (int k = 0; k < 3; k++)
+  {
+    s_t actual = batch(row, k);
+    if (!std::isfinite(expected(k)))
+    {
+      if (std::isfinite(actual))
+      {
+        return false;
+      }
+      continue;
+    }
+    if (std::abs(actual - expected(k)) > 1e-9 * (1.0 + std::abs(expected(k))))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TEST(C3D, FORCE_PLATFORMS_MATCH_PER_FRAME)
+{
+  std::string path = utils::DartResourceRetriever::create()->getFilePath(
+      "dart://sample/c3d/JA1Gait35.c3d");
+  ezc3d::c3d c3d(path);
+  const size_t analogsPerFrame = c3d.header().nbAnalogByFrame();
+  const size_t numPlatforms = c3d.parameters()
+                                  .group("FORCE_PLATFORM")
+                                  .parameter("USED")
+                                  .valuesAsInt()[0];
+  ASSERT_GT(numPlatforms, 0u);
+
+  for (int convention = 0; convention < 2; convention++)
+  {
+    for (size_t idx = 0; idx < numPlatforms; idx++)
+    {
+      InspectableForcePlatform full(idx, c3d, convention, 1);
+      InspectableForcePlatform downsampled(
+          idx, c3d, convention, analogsPerFrame);
+
+      std::vector<Eigen::Vector3s> F, M, CoP, Tz;
+      perFrameForcePlatform(full, idx, c3d, convention, F, M, CoP, Tz);
+
+      ASSERT_EQ(full.nbFrames(), F.size());
+      for (size_t t = 0; t < F.size(); t++)
+      {
+        EXPECT_TRUE(rowMatches(full.forces(), t, F[t]));
+        EXPECT_TRUE(rowMatches(full.moments(), t, M[t]));
+        EXPECT_TRUE(rowMatches(full.CoP(), t, CoP[t]));
+        EXPECT_TRUE(rowMatches(full.Tz(), t, Tz[t]));
+      }
+
+      // The downsampled platform should keep the first analog subframe of
+      // each marker frame, which is what C3DLoader reads
+      ASSERT_EQ(downsampled.nbFrames(), c3d.header().nbFrames());
+      for (size_t t = 0; t < downsampled.nbFrames(); t++)
+      {
+        size_t frame = t * analogsPerFrame;
+        EXPECT_TRUE(rowMatches(downsampled.forces(), t, F[frame]));
+        EXPECT_TRUE(rowMatches(downsampled.moments(), t, M[frame]));
+        EXPECT_TRUE(rowMatches(downsampled.CoP(), t, CoP[frame]));
+        EXPECT_TRUE(rowMatches(downsampled.Tz(), t, Tz[frame]));
+      }
+    }
+  }
+}
@@ -30,6 +30,9 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <tuple>
 
 #include <gtest/gtest.h>
@@ -56,3 +59,73 @@ TEST(CSVParser, BASICS)
     }
   }
 }
+
+//==============================================================================
+TEST(CSVParser, PARSE_NUMBER)
+{
+  EXPECT_EQ(CSVParser::parseNumber("1.5"), 1.5);
+  EXPECT_EQ(CSVParser::parseNumber("+2"), 2.0);
+  EXPECT_EQ(CSVParser::parseNumber("-3e2"), -300.0);
+  EXPECT_EQ(CSVParser::parseNumber("4.25\t5"), 4.25);
+  EXPECT_EQ(CSVParser::parseNumber("abc"), 0.0);
+  EXPECT_EQ(CSVParser::parseNumber(""), 0.0);
+  EXPECT_TRUE(std::isnan(CSVParser::parseNumber("NaN")));
+  EXPECT_EQ(CSVParser::parseNumber("0.1"), atof("0.1"));
+}
+
+//==============================================================================
+TEST(CSVParser, NUMERIC_TABLE)
+{
+  const std::string path
+      = (std::filesystem::temp_directory_path() / "test_CSVParser_numeric.mot")
+            .string();
+  {
+    std::ofstream out(path);
+    out << "grf\nversion=1\nendheader\r\n";
+    out << "time\tground_force_vx\tground_force_vy\tground_force_vz\r\n";
+    out << "0.0\t1\t2\t3\r\n";
+    out << "0.5\t4 \t5\t6\r\n";
+    out << "\n";
+    out << "1.0\t7\t8\r\n";
+  }
+
+  CSVParser::NumericTableOptions options;
+  options.delimiters = " \t";
+  options.mergeDelimiters = true;
+  options.endOfHeader = "endheader";
+
+  CSVParser::NumericTable all = CSVParser::readNumericTable(path, options);
+  ASSERT_EQ(all.columnNames.size(), 4);
+  EXPECT_EQ(all.columnNames[3], "ground_force_vz");
+  ASSERT_EQ(all.values.rows(), 3);
+  EXPECT_EQ(all.values(1, 0), 0.5);
+  EXPECT_EQ(all.values(1, 1), 4.0);
+  EXPECT_EQ(all.values(1, 3), 6.0);
+  // The last row is missing a value
+  EXPECT_TRUE(std::isnan(all.values(2, 3)));
+
+  options.columns.push_back("ground_force_vy");
+  options.columns.push_back("time");
+  options.columns.push_back("not_a_column");
+  CSVParser::NumericTable projected
+      = CSVParser::readNumericTable(path, options);
+  ASSERT_EQ(projected.values.cols(), 3);
+  EXPECT_EQ(projected.values(0, 0), 2.0);
+  EXPECT_EQ(projected.values(2, 1), 1.0);
+  EXPECT_TRUE(std::isnan(projected.values(0, 2)));
+
+  // Stopping early
+  int numRows = 0;
+  CSVParser::streamNumericTable(
+      path, options, [&](int row, const Eigen::VectorXs& values) {
+        EXPECT_EQ(row, numRows);
+        EXPECT_EQ(values.size(), 3);
+        numRows++;
+        return row < 1;
+      });
+  EXPECT_EQ(numRows, 2);
+
+  CSVParser::MappedFile file(path);
+  EXPECT_TRUE(file.isMemoryMapped());
+  EXPECT_EQ(file.getContents().substr(0, 4), "grf\n");
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "dart/utils/CachingResourceRetriever.hpp"
+
+using dart::common::ResourcePtr;
+using dart::common::ResourceRetriever;
+using dart::common::Uri;
+using dart::utils::CachingResourceRetriever;
+
+namespace {
+
+/// Serves resources out of a map, and counts how often it's asked for them
+struct CountingResourceRetriever : public ResourceRetriever
+{
+  bool exists(const Uri& uri) override
+  {
+    mNumExists++;
+    return mFiles.count(uri.toString()) > 0;
+  }
+
+  ResourcePtr retrieve(const Uri& uri) override
+  {
+    mNumRetrieves++;
+    const auto it = mFiles.find(uri.toString());
+    if (it == mFiles.end())
+      return nullptr;
+
+    mResource = std::make_shared<StringResource>(it->second);
+    return mResource;
+  }
+
+  struct StringResource : public dart::common::Resource
+  {
+    explicit StringResource(const std::string& contents)
+      : mContents(contents), mPosition(0)
+    {
+    }
+
+    std::size_t getSize() override
+    {
+      return mContents.size();
+    }
+
+    std::size_t tell() override
+    {
+      return mPosition;
+    }
+
+    bool seek(ptrdiff_t offset, SeekType /*origin*/) override
+    {
+      mPosition = offset;
+      return true;
+    }
+
+    std::size_t read(void* buffer, std::size_t size, std::size_t count) override
+    {
+      const std::size_t n
+          = std::min(count, (mContents.size() - mPosition) / size);
+      mContents.copy(static_cast<char*>(buffer), n * size, mPosition);
+      mPosition += n * size;
+      return n;
+    }
+
+    std::string mContents;
+    std::size_t mPosition;
+  };
+
+  std::map<std::string, std::string> mFiles;
+  ResourcePtr mResource;
+  int mNumExists = 0;
+  int mNumRetrieves = 0;
+};
+
+} // anonymous namespace
+
+//==============================================================================
+TEST(CachingResourceRetriever, RetrievesEachResourceOnce)
+{
+  auto inner = std::make_shared<CountingResourceRetriever>();
+  inner->mFiles["file:///a.txt"] = "hello";
+  CachingResourceRetriever retriever(inner);
+
+  const Uri uri = Uri::createFromString("file:///a.txt");
+  EXPECT_EQ(retriever.readAll(uri), "hello");
+  EXPECT_EQ(retriever.readAll(uri), "hello");
+
+  ResourcePtr resource = retriever.retrieve(uri);
+  ASSERT_TRUE(resource != nullptr);
+  EXPECT_EQ(resource->getSize(), 5u);
+  char buffer[3];
+  EXPECT_TRUE(resource->seek(2, dart::common::Resource::SEEKTYPE_SET));
+  EXPECT_EQ(resource->read(buffer, 1, 3), 3u);
+  EXPECT_EQ(std::string(buffer, 3), "llo");
+  EXPECT_EQ(resource->read(buffer, 1, 3), 0u);
+
+  EXPECT_EQ(inner->mNumRetrieves, 1);
+  EXPECT_EQ(retriever.getNumMisses(), 1u);
+  EXPECT_EQ(retriever.getNumHits(), 2u);
+
+  EXPECT_TRUE(retriever.exists(uri));
+  EXPECT_FALSE(retriever.exists(Uri::createFromString("file:///b.txt")));
+  EXPECT_FALSE(retriever.exists(Uri::createFromString("file:///b.txt")));
+  EXPECT_EQ(inner->mNumExists, 1);
+
+  // Failures aren't cached
+  EXPECT_TRUE(retriever.retrieve(Uri::createFromString("file:///b.txt"))
+              == nullptr);
+  inner->mFiles["file:///b.txt"] = "world";
+  EXPECT_EQ(retriever.readAll(Uri::createFromString("file:///b.txt")), "world");
+}
+
+//==============================================================================
+TEST(CachingResourceRetriever, EvictsLeastRecentlyUsed)
+{
+  auto inner = std::make_shared<CountingResourceRetriever>();
+  inner->mFiles["file:///a"] = "aaaa";
+  inner->mFiles["file:///b"] = "bbbb";
+  inner->mFiles["file:///c"] = "cccc";
+  inner->mFiles["file:///big"] = std::string(100, 'x');
+  CachingResourceRetriever retriever(inner, 8);
+
+  retriever.readAll(Uri::createFromString("file:///a"));
+  retriever.readAll(Uri::createFromString("file:///b"));
+  retriever.readAll(Uri::createFromString("file:///a"));
+  EXPECT_EQ(retriever.getMemoryUsage(), 8u);
+
+  // This pushes out b, which was used longest ago
+  retriever.readAll(Uri::createFromString("file:///c"));
+  EXPECT_EQ(retriever.getMemoryUsage(), 8u);
+  EXPECT_EQ(inner->mNumRetrieves, 3);
+  retriever.readAll(Uri::createFromString("file:///a"));
+  EXPECT_EQ(inner->mNumRetrieves, 3);
+  retriever.readAll(Uri::createFromString("file:///b"));
+  EXPECT_EQ(inner->mNumRetrieves, 4);
+
+  // Anything over budget isn't kept at all
+  retriever.readAll(Uri::createFromString("file:///big"));
+  EXPECT_EQ(retriever.getMemoryUsage(), 8u);
+
+  retriever.clear();
+  EXPECT_EQ(retriever.getMemoryUsage(), 0u);
+}
+
+//==============================================================================
+TEST(CachingResourceRetriever, DiskCacheOutlivesMemory)
+{
+  const std::string directory
+      = (boost::filesystem::temp_directory_path()
+         / boost::filesystem::unique_path())
+            .string();
+
+  auto inner = std::make_shared<CountingResourceRetriever>();
+  inner->mFiles["file:///a"] = std::string("binary\n\0data", 12);
+  {
+    CachingResourceRetriever retriever(inner, 0, directory);
+    EXPECT_EQ(
+        retriever.readAll(Uri::createFromString("file:///a")).size(), 12u);
+  }
+
+  // A new cache pointing at the same directory doesn't need the inner
+  // retriever anymore
+  CachingResourceRetriever retriever(inner, 1024, directory);
+  inner->mFiles.clear();
+  EXPECT_EQ(
+      retriever.readAll(Uri::createFromString("file:///a")),
+      std::string("binary\n\0data", 12));
+  EXPECT_EQ(inner->mNumRetrieves, 1);
+  EXPECT_EQ(retriever.getNumHits(), 1u);
+
+  boost::filesystem::remove_all(directory);
+}
@@ -127,6 +127,25 @@ bool verifyConstantCurveJoint(
     return false;
   }
 
+  // The single-pass time derivative should match summing up the per-DOF
+  // position derivatives
+  math::Jacobian dj_dt_sum = math::Jacobian::Zero(6, shoulder->getNumDofs());
+  for (int i = 0; i < shoulder->getNumDofs(); i++)
+  {
+    dj_dt_sum += shoulder->getRelativeJacobianDerivWrtPositionStatic(i)
+                 * shoulder->getVelocity(i);
+  }
+  if (!equals(dj_dt, dj_dt_sum, TEST_THRESHOLD))
+  {
+    std::cout << "relativeJacobianTimeDeriv vs sum of position derivs: "
+              << std::endl;
+    std::cout << "Analytical dj_dt: " << std::endl << dj_dt << std::endl;
+    std::cout << "Summed dj_dt: " << std::endl << dj_dt_sum << std::endl;
+    std::cout << "Diff: " << std::endl << dj_dt - dj_dt_sum << std::endl;
+    EXPECT_TRUE(equals(dj_dt, dj_dt_sum, TEST_THRESHOLD));
+    return false;
+  }
+
   for (int i = 0; i < shoulder->getNumDofs(); i++)
   {
     ////////////////////////////////////////////////////////////////////////////////
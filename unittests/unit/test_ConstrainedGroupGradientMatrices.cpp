@@ -125,4 +125,35 @@ TEST(ConstrainedGroupGradientMatrices, SIMPLE_MERGE)
   Eigen::VectorXs newACols(2);
   newACols << 1.0, 1.0;
   EXPECT_TRUE(equals(newACols, matrices.mAColNorms));
-}
\ No newline at end of file
+}
+TEST(ConstrainedGroupGradientMatrices, REUSE_FACTORED_Q)
+{
+  ConstrainedGroupGradientMatrices matrices(2, 2, 0.001);
+
+  Eigen::MatrixXs Q(2, 2);
+  Q << 2.0, 0.5, 0.5, 1.0;
+  Eigen::VectorXs b(2);
+  b << 1.0, -1.0;
+
+  auto first = matrices.getFactoredQ(Q);
+  auto second = matrices.getFactoredQ(Q);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(matrices.getNumQFactorizations(), 1u);
+  EXPECT_EQ(matrices.getNumQFactorizationReuses(), 1u);
+  EXPECT_TRUE(equals(Eigen::VectorXs(Q * second->solve(b)), b));
+
+  // Any change to Q means we have to refactor, but the old factorization
+  // stays valid for anyone still holding it
+  Eigen::MatrixXs Q2 = Q;
+  Q2(1, 1) += 1e-9;
+  auto third = matrices.getFactoredQ(Q2);
+  EXPECT_NE(first.get(), third.get());
+  EXPECT_EQ(matrices.getNumQFactorizations(), 2u);
+  EXPECT_TRUE(equals(Eigen::VectorXs(Q * first->solve(b)), b));
+  EXPECT_TRUE(equals(Eigen::VectorXs(Q2 * third->solve(b)), b));
+
+  // Different sizes never match
+  Eigen::MatrixXs Q3 = Eigen::MatrixXs::Identity(3, 3);
+  matrices.getFactoredQ(Q3);
+  EXPECT_EQ(matrices.getNumQFactorizations(), 3u);
+}
@@ -81,3 +81,98 @@ TEST(ConstraintSolver, SIMPLE)
   skel->computeImpulseForwardDynamics();
   EXPECT_TRUE(box->getRelativeSpatialVelocity()[4] >= 0);
 }
+
+TEST(ConstraintSolver, REUSES_STABLE_GROUPS)
+{
+  // Load a world where a cube is colliding with the ground.
+  std::shared_ptr<simulation::World> world
+      = dart::utils::UniversalLoader::loadWorld(
+          "dart://sample/skel/test/colliding_cube.skel");
+  auto solver = world->getConstraintSolver();
+
+  solver->updateConstraints();
+  solver->buildConstrainedGroups();
+  std::size_t numGroups = solver->getNumConstrainedGroups();
+  EXPECT_TRUE(numGroups > 0);
+  EXPECT_EQ(solver->getNumConstrainedGroupRebuilds(), 1u);
+
+  // The cube is still resting on the ground, so the same skeletons are
+  // grouped together, and the groups shouldn't be rebuilt
+  for (int i = 0; i < 5; i++)
+  {
+    solver->updateConstraints();
+    solver->buildConstrainedGroups();
+    EXPECT_EQ(solver->getNumConstrainedGroups(), numGroups);
+    for (const auto& group : solver->getConstrainedGroups())
+    {
+      EXPECT_TRUE(group.getNumConstraints() > 0);
+    }
+  }
+  EXPECT_EQ(solver->getNumConstrainedGroupRebuilds(), 1u);
+}
+
+TEST(ConstraintSolver, PARALLEL_GROUPS_MATCH_SEQUENTIAL)
+{
+  // Load two copies of a world where a cube is colliding with the ground, and
+  // add a second cube to each, far enough from the first that they end up in
+  // separate constrained groups
+  std::vector<std::shared_ptr<simulation::World>> worlds;
+  for (int i = 0; i < 2; i++)
+  {
+    std::shared_ptr<simulation::World> world
+        = dart::utils::UniversalLoader::loadWorld(
+            "dart://sample/skel/test/colliding_cube.skel");
+    auto skel = world->getSkeleton("box skeleton");
+    auto otherSkel = skel->cloneSkeleton("other box skeleton");
+    otherSkel->setPosition(3, skel->getPosition(3) + 0.5);
+    world->addSkeleton(otherSkel);
+    worlds.push_back(world);
+  }
+  worlds[1]->getConstraintSolver()->setNumGroupSolverThreads(2);
+  EXPECT_EQ(worlds[1]->getConstraintSolver()->getNumGroupSolverThreads(), 2);
+
+  for (int step = 0; step < 5; step++)
+  {
+    for (auto& world : worlds)
+    {
+      world->step();
+      EXPECT_EQ(world->getConstraintSolver()->getNumConstrainedGroups(), 2u);
+    }
+    Eigen::VectorXs posDiff
+        = worlds[0]->getPositions() - worlds[1]->getPositions();
+    Eigen::VectorXs velDiff
+        = worlds[0]->getVelocities() - worlds[1]->getVelocities();
+    EXPECT_TRUE(posDiff.norm() < 1e-12);
+    EXPECT_TRUE(velDiff.norm() < 1e-12);
+  }
+}
+
+TEST(ConstraintSolver, COMPLIANT_CONTACTS_SKIP_LCP)
+{
+  // Load a world where a cube is colliding with the ground.
+  std::shared_ptr<simulation::World> world
+      = dart::utils::UniversalLoader::loadWorld(
+          "dart://sample/skel/test/colliding_cube.skel");
+  world->setCompliantContactEnabled(true);
+  EXPECT_TRUE(world->getCompliantContactEnabled());
+  auto skel = world->getSkeleton("box skeleton");
+  auto box = skel->getBodyNode("box");
+  s_t startHeight = box->getWorldTransform().translation()(1);
+
+  for (int step = 0; step < 300; step++)
+  {
+    world->step();
+  }
+
+  // The ground pushes back on the cube with springs, rather than through the
+  // LCP, so the cube settles just slightly into the ground
+  auto solver = world->getConstraintSolver();
+  EXPECT_TRUE(solver->getLastCollisionResult().getNumContacts() > 0);
+  EXPECT_TRUE(solver->getCompliantContacts().size() > 0);
+  for (const auto& contact : solver->getCompliantContacts())
+  {
+    EXPECT_TRUE(contact.getForce().dot(contact.getNormal()) >= 0);
+  }
+  EXPECT_TRUE(box->getWorldTransform().translation()(1) > startHeight - 0.01);
+  EXPECT_TRUE(skel->getVelocities().norm() < 1e-1);
+}
@@ -0,0 +1,96 @@
+#include <complex>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+
+#include "dart/math/CrossCorrelation.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+
+//==============================================================================
+TEST(CrossCorrelation, FFT_MATCHES_DFT)
+{
+  const int n = 16;
+  std::vector<std::complex<s_t>> data;
+  for (int i = 0; i < n; i++)
+  {
+    data.emplace_back(std::sin(0.3 * i) + 0.1 * i, std::cos(1.7 * i));
+  }
+  std::vector<std::complex<s_t>> transformed = data;
+  math::CrossCorrelation::fft(transformed);
+
+  const s_t pi = 3.14159265358979323846;
+  for (int k = 0; k < n; k++)
+  {
+    std::complex<s_t> expected(0, 0);
+    for (int i = 0; i < n; i++)
+    {
+      s_t angle = -2 * pi * k * i / n;
+      expected += data[i] * std::complex<s_t>(std::cos(angle), std::sin(angle));
+    }
+    EXPECT_NEAR(transformed[k].real(), expected.real(), 1e-9);
+    EXPECT_NEAR(transformed[k].imag(), expected.imag(), 1e-9);
+  }
+
+  math::CrossCorrelation::fft(transformed, true);
+  for (int i = 0; i < n; i++)
+  {
+    EXPECT_NEAR(transformed[i].real(), data[i].real(), 1e-9);
+    EXPECT_NEAR(transformed[i].imag(), data[i].imag(), 1e-9);
+  }
+}
+
+//==============================================================================
+TEST(CrossCorrelation, MATCHES_BRUTE_FORCE)
+{
+  Eigen::MatrixXs a = Eigen::MatrixXs::Random(3, 37);
+  Eigen::MatrixXs b = Eigen::MatrixXs::Random(3, 29);
+  const int maxLag = 6;
+  Eigen::VectorXs correlation
+      = math::CrossCorrelation::crossCorrelate(a, b, maxLag);
+
+  Eigen::VectorXs expected = Eigen::VectorXs::Zero(2 * maxLag + 1);
+  for (int lag = -maxLag; lag <= maxLag; lag++)
+  {
+    int overlap = 0;
+    for (int t = 0; t < a.cols(); t++)
+    {
+      if (t - lag < 0 || t - lag >= b.cols())
+        continue;
+      expected(lag + maxLag) += a.col(t).dot(b.col(t - lag));
+      overlap++;
+    }
+    expected(lag + maxLag) /= overlap;
+  }
+  EXPECT_TRUE(equals(correlation, expected, 1e-9));
+}
+
+//==============================================================================
+TEST(CrossCorrelation, FINDS_SHIFT)
+{
+  auto sample = [](int t) {
+    // A constant offset, which shouldn't affect the match
+    return Eigen::Vector2s(
+        700 + 100 * std::sin(0.11 * t) + 30 * std::sin(0.37 * t),
+        20 * std::cos(0.23 * t));
+  };
+  Eigen::MatrixXs signal = Eigen::MatrixXs::Zero(2, 200);
+  for (int t = 0; t < signal.cols(); t++)
+  {
+    signal.col(t) = sample(t);
+  }
+
+  for (int shift = -4; shift <= 4; shift++)
+  {
+    Eigen::MatrixXs delayed = Eigen::MatrixXs::Zero(2, 200);
+    for (int t = 0; t < delayed.cols(); t++)
+    {
+      delayed.col(t) = sample(t - shift);
+    }
+    // `signal` needs to be shifted forward by `shift` to match `delayed`
+    EXPECT_EQ(math::CrossCorrelation::findBestLag(delayed, signal, 8), shift);
+  }
+}
@@ -4,8 +4,12 @@
 #include <gtest/gtest.h>
 
 #include "dart/dart.hpp"
+#include "dart/math/CompiledCustomFunction.hpp"
+#include "dart/math/ConstantFunction.hpp"
 #include "dart/math/LinearFunction.hpp"
 #include "dart/math/MathTypes.hpp"
+#include "dart/math/PiecewiseLinearFunction.hpp"
+#include "dart/math/PolynomialFunction.hpp"
 #include "dart/math/SimmSpline.hpp"
 
 #include "TestHelpers.hpp"
@@ -42,4 +46,52 @@ TEST(CustomFunction, BASIC)
   EXPECT_EQ(fn->calcValue(0.0), 0.0);
   EXPECT_EQ(fn->calcValue(1.0), 1.0);
   EXPECT_EQ(fn->calcValue(2.0), 2.0);
-}
\ No newline at end of file
+}
+//==============================================================================
+void expectCompiledMatches(const CustomFunction& fn, s_t lower, s_t upper)
+{
+  std::shared_ptr<CompiledCustomFunction> compiled
+      = CompiledCustomFunction::compile(fn);
+  ASSERT_TRUE(compiled != nullptr);
+  for (int i = 0; i <= 200; i++)
+  {
+    s_t x = lower + (upper - lower) * i / 200.0;
+    Eigen::Vector4s all = compiled->calcValueAndDerivatives(x);
+    EXPECT_NEAR(compiled->calcValue(x), fn.calcValue(x), 1e-10);
+    EXPECT_NEAR(all(0), fn.calcValue(x), 1e-10);
+    for (int order = 1; order <= 3; order++)
+    {
+      EXPECT_NEAR(
+          compiled->calcDerivative(order, x),
+          fn.calcDerivative(order, x),
+          1e-9);
+      EXPECT_NEAR(all(order), fn.calcDerivative(order, x), 1e-9);
+    }
+  }
+}
+
+//==============================================================================
+TEST(CustomFunction, COMPILED)
+{
+  std::vector<s_t> xs{-2.0, -1.0, -0.3, 0.5, 1.0, 2.2, 3.0};
+  std::vector<s_t> ys{0.1, 0.5, -0.2, 0.3, 0.9, 0.4, 0.0};
+
+  // Go past both ends, to check the extrapolation too
+  expectCompiledMatches(SimmSpline(xs, ys), -3.0, 4.0);
+  expectCompiledMatches(
+      SimmSpline(std::vector<s_t>{0.0, 1.0}, std::vector<s_t>{1.0, 3.0}),
+      -1.0,
+      2.0);
+  expectCompiledMatches(PiecewiseLinearFunction(xs, ys), -3.0, 4.0);
+  expectCompiledMatches(
+      PolynomialFunction(std::vector<s_t>{0.1, -0.5, 0.25, 0.03, -0.01}),
+      -3.0,
+      3.0);
+  expectCompiledMatches(LinearFunction(2.0, -1.0), -3.0, 3.0);
+  expectCompiledMatches(ConstantFunction(0.7), -3.0, 3.0);
+
+  std::shared_ptr<CompiledCustomFunction> spline
+      = CompiledCustomFunction::compile(SimmSpline(xs, ys));
+  EXPECT_EQ(spline->getNumSegments(), (int)xs.size());
+  EXPECT_EQ(spline->getDegree(), 3);
+}
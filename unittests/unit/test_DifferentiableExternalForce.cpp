@@ -125,8 +125,11 @@ bool testGroupScaleMoveBody(std::shared_ptr<dynamics::Skeleton> skel, int body)
         = skel->finiteDifferenceGroupScaleMovementOnBodyInWorldSpace(col, body);
     Eigen::Vector3s normal
         = skel->getGroupScaleMovementOnBodyInWorldSpace(col, body);
+    Eigen::Vector3s batch
+        = skel->getGroupScaleMovementOnBodiesInWorldSpace().block<3, 1>(
+            body * 3, col);
 
-    if (!equals(fd, normal, 1e-8))
+    if (!equals(fd, normal, 1e-8) || !equals(batch, normal, 1e-12))
     {
       std::cout << "Gradient of world pos of body "
                 << skel->getBodyNode(body)->getName()
@@ -135,6 +138,7 @@ bool testGroupScaleMoveBody(std::shared_ptr<dynamics::Skeleton> skel, int body)
                 << " didn't equal analytical!" << std::endl;
       std::cout << "Analytical: " << normal << std::endl;
       std::cout << "FD: " << fd << std::endl;
+      std::cout << "Batch: " << batch << std::endl;
       std::cout << "Diff: " << fd - normal << std::endl;
       return false;
     }
@@ -153,8 +157,11 @@ bool testBodyScaleJointJacobians(
             col, joint);
     Eigen::Vector3s normal
         = skel->getGroupScaleMovementOnJointInWorldSpace(col, joint);
+    Eigen::Vector3s batch
+        = skel->getGroupScaleMovementOnJointsInWorldSpace().block<3, 1>(
+            joint * 3, col);
 
-    if (!equals(fd, normal, 1e-8))
+    if (!equals(fd, normal, 1e-8) || !equals(batch, normal, 1e-12))
     {
       std::cout << "Gradient of world pos of joint "
                 << skel->getJoint(joint)->getName()
@@ -163,6 +170,7 @@ bool testBodyScaleJointJacobians(
                 << " didn't equal analytical!" << std::endl;
       std::cout << "Analytical: " << normal << std::endl;
       std::cout << "FD: " << fd << std::endl;
+      std::cout << "Batch: " << batch << std::endl;
       std::cout << "Diff: " << fd - normal << std::endl;
       return false;
     }
@@ -0,0 +1,129 @@
+#include <cstddef>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/DegreeOfFreedom.hpp"
+#include "dart/dynamics/EulerJoint.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/PrismaticJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/TranslationalJoint.hpp"
+#include "dart/dynamics/UniversalJoint.hpp"
+#include "dart/dynamics/WeldJoint.hpp"
+
+using namespace dart;
+using namespace dynamics;
+
+// Eigen and the STL both get their memory from malloc(), so on glibc we count
+// heap allocations by interposing the allocator for this test binary. Debug
+// builds run extra checks that allocate, so we only count in release builds.
+#if defined(__GLIBC__) && defined(NDEBUG)
+
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* __libc_calloc(std::size_t num, std::size_t size);
+extern "C" void* __libc_realloc(void* ptr, std::size_t size);
+
+static bool gCountAllocations = false;
+static long gNumAllocations = 0;
+
+extern "C" void* malloc(std::size_t size)
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t num, std::size_t size)
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_calloc(num, size);
+}
+
+extern "C" void* realloc(void* ptr, std::size_t size)
+{
+  if (gCountAllocations)
+    gNumAllocations++;
+  return __libc_realloc(ptr, size);
+}
+
+//==============================================================================
+template <typename JointType>
+BodyNode* addBody(const SkeletonPtr& skel, BodyNode* parent)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0, 0.3, 0.1);
+  pair.first->setTransformFromParentBodyNode(T);
+  pair.second->setMass(1.0);
+  return pair.second;
+}
+
+//==============================================================================
+SkeletonPtr createMixedSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("mixed");
+  BodyNode* root = addBody<FreeJoint>(skel, nullptr);
+  BodyNode* arm = addBody<RevoluteJoint>(skel, root);
+  addBody<BallJoint>(skel, arm);
+  BodyNode* leg = addBody<EulerJoint>(skel, root);
+  addBody<PrismaticJoint>(skel, leg);
+  addBody<UniversalJoint>(skel, leg);
+  addBody<TranslationalJoint>(skel, leg);
+  addBody<WeldJoint>(skel, leg);
+
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setControlForces(Eigen::VectorXs::Random(skel->getNumDofs()));
+  return skel;
+}
+
+//==============================================================================
+// This is the per-Skeleton work that World::step() does: unconstrained forward
+// dynamics, an impulse solve, and the two integration steps.
+void stepSkeleton(const SkeletonPtr& skel)
+{
+  skel->computeForwardDynamics();
+  skel->integrateVelocities(0.001);
+  skel->clearConstraintImpulses();
+  skel->getBodyNode(2)->setConstraintImpulse(Eigen::Vector6s::Ones());
+  skel->computeImpulseForwardDynamics();
+  skel->integratePositions(0.001);
+}
+
+//==============================================================================
+TEST(DynamicsAllocations, STEP_DOES_NOT_ALLOCATE_ONCE_WARM)
+{
+  SkeletonPtr skel = createMixedSkeleton();
+
+  // The first few steps are allowed to size the caches
+  for (int i = 0; i < 3; i++)
+  {
+    stepSkeleton(skel);
+    skel->getCoriolisAndGravityForces();
+  }
+
+  gNumAllocations = 0;
+  gCountAllocations = true;
+  for (int i = 0; i < 10; i++)
+  {
+    stepSkeleton(skel);
+  }
+  gCountAllocations = false;
+  EXPECT_EQ(gNumAllocations, 0);
+
+  // Moving the root dirties the Coriolis and gravity forces of every body,
+  // which then get rebuilt in place
+  DegreeOfFreedom* rootDof = skel->getDof(0);
+  gNumAllocations = 0;
+  gCountAllocations = true;
+  rootDof->setPosition(rootDof->getPosition() + 0.01);
+  skel->getCoriolisAndGravityForces();
+  gCountAllocations = false;
+  EXPECT_EQ(gNumAllocations, 0);
+}
+
+#endif
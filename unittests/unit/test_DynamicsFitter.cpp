@@ -4223,6 +4223,86 @@ TEST(DynamicsFitter, ID_EQNS)
 }
 #endif
 
+#ifdef JACOBIAN_TESTS
+TEST(DynamicsFitter, RESIDUAL_TRAJECTORY_MATCHES_PER_TIMESTEP)
+{
+  OpenSimFile file = OpenSimParser::parseOsim(
+      "dart://sample/grf/Subject4/Models/optimized_scale_and_markers.osim");
+  srand(42);
+  std::shared_ptr<dynamics::Skeleton> skel = file.skeleton;
+  const int dofs = skel->getNumDofs();
+  const int numTimesteps = 5;
+
+  std::vector<int> forceBodies;
+  forceBodies.push_back(skel->getBodyNode("calcn_r")->getIndexInSkeleton());
+  forceBodies.push_back(skel->getBodyNode("calcn_l")->getIndexInSkeleton());
+  ResidualForceHelper helper(skel, forceBodies);
+
+  Eigen::MatrixXs qs = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+  Eigen::MatrixXs dqs = Eigen::MatrixXs::Zero(dofs, numTimesteps);
+  Eigen::MatrixXs ddqs = Eigen::MatrixXs::Random(dofs, numTimesteps);
+  Eigen::MatrixXs forces = Eigen::MatrixXs::Random(12, numTimesteps) * 1000;
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    qs.col(t) = skel->getRandomPose();
+    dqs.col(t) = skel->getRandomVelocity();
+  }
+
+  for (bool useL1 : {false, true})
+  {
+    for (int numThreads : {1, 3})
+    {
+      ResidualTrajectory trajectory = helper.calculateResidualTrajectory(
+          qs, dqs, ddqs, forces, 2.0, useL1, true, numThreads);
+      for (int t = 0; t < numTimesteps; t++)
+      {
+        EXPECT_TRUE(equals(
+            Eigen::VectorXs(trajectory.taus.col(t)),
+            helper.calculateInverseDynamics(
+                qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t)),
+            1e-9));
+        EXPECT_NEAR(
+            trajectory.residualNorms(t),
+            helper.calculateResidualNorm(
+                qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t), 2.0, useL1),
+            1e-9);
+
+        std::vector<neural::WithRespectTo*> wrts;
+        wrts.push_back(WithRespectTo::POSITION);
+        wrts.push_back(WithRespectTo::VELOCITY);
+        wrts.push_back(WithRespectTo::ACCELERATION);
+        std::vector<Eigen::MatrixXs*> jacs;
+        jacs.push_back(&trajectory.residualJacobiansWrtPos);
+        jacs.push_back(&trajectory.residualJacobiansWrtVel);
+        jacs.push_back(&trajectory.residualJacobiansWrtAcc);
+        std::vector<Eigen::MatrixXs*> grads;
+        grads.push_back(&trajectory.residualNormGradientsWrtPos);
+        grads.push_back(&trajectory.residualNormGradientsWrtVel);
+        grads.push_back(&trajectory.residualNormGradientsWrtAcc);
+        for (int i = 0; i < wrts.size(); i++)
+        {
+          Eigen::MatrixXs jac = helper.calculateResidualJacobianWrt(
+              qs.col(t), dqs.col(t), ddqs.col(t), forces.col(t), wrts[i]);
+          EXPECT_TRUE(equals(
+              Eigen::MatrixXs(jacs[i]->block(0, t * dofs, 6, dofs)),
+              jac,
+              1e-9));
+          Eigen::VectorXs grad = helper.calculateResidualNormGradientWrt(
+              qs.col(t),
+              dqs.col(t),
+              ddqs.col(t),
+              forces.col(t),
+              wrts[i],
+              2.0,
+              useL1);
+          EXPECT_TRUE(equals(Eigen::VectorXs(grads[i]->col(t)), grad, 1e-9));
+        }
+      }
+    }
+  }
+}
+#endif
+
 #ifdef JACOBIAN_TESTS
 TEST(DynamicsFitter, ROOT_JACS)
 {
@@ -4914,6 +4994,160 @@ TEST(DynamicsFitter, FIT_PROBLEM_GRAD_SPATIAL_ACC_REG)
 }
 #endif
 
+#ifdef JACOBIAN_TESTS
+TEST(DynamicsFitter, FIT_PROBLEM_SPARSE_HESSIAN)
+{
+  std::vector<std::string> motFiles;
+  std::vector<std::string> c3dFiles;
+  std::vector<std::string> trcFiles;
+  std::vector<std::string> grfFiles;
+
+  motFiles.push_back("dart://sample/grf/Subject4/IK/walking1_ik.mot");
+  trcFiles.push_back("dart://sample/grf/Subject4/MarkerData/walking1.trc");
+  grfFiles.push_back("dart://sample/grf/Subject4/ID/walking1_grf.mot");
+
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/grf/Subject4/Models/"
+      "optimized_scale_and_markers.osim");
+
+  std::vector<std::string> footNames;
+  footNames.push_back("calcn_r");
+  footNames.push_back("calcn_l");
+
+  std::shared_ptr<DynamicsInitialization> init = createInitialization(
+      standard.skeleton,
+      standard.markersMap,
+      standard.trackingMarkers,
+      footNames,
+      motFiles,
+      c3dFiles,
+      trcFiles,
+      grfFiles,
+      12);
+
+  DynamicsFitProblemConfig config(standard.skeleton);
+  config.setResidualWeight(1.0);
+  config.setMarkerWeight(1.0);
+  config.setMaxBlockSize(4);
+
+  config.setIncludeMasses(true);
+  config.setIncludePoses(true);
+
+  DynamicsFitProblem problem(
+      init, standard.skeleton, standard.trackingMarkers, config);
+
+  std::cout << "Problem dim: " << problem.getProblemSize() << std::endl;
+
+  Eigen::VectorXs x = problem.flatten();
+  std::vector<std::tuple<int, int, s_t>> sparse
+      = problem.computeSparseHessian(x);
+  std::vector<std::pair<int, int>> structure
+      = problem.getSparseHessianStructure();
+  EXPECT_EQ(sparse.size(), problem.getSparseHessianNonZeros());
+  EXPECT_EQ(sparse.size(), structure.size());
+
+  Eigen::MatrixXs fd = problem.finiteDifferenceHessian(x, false);
+  Eigen::MatrixXs analytical = Eigen::MatrixXs::Zero(fd.rows(), fd.cols());
+  for (int i = 0; i < sparse.size(); i++)
+  {
+    EXPECT_EQ(std::get<0>(sparse[i]), structure[i].first);
+    EXPECT_EQ(std::get<1>(sparse[i]), structure[i].second);
+    EXPECT_GE(std::get<0>(sparse[i]), std::get<1>(sparse[i]));
+    analytical(std::get<0>(sparse[i]), std::get<1>(sparse[i]))
+        = std::get<2>(sparse[i]);
+  }
+  // Comparing the whole lower triangle also checks that everything left out
+  // of the sparsity pattern is zero
+  Eigen::MatrixXs fdLower = fd.triangularView<Eigen::Lower>();
+
+  if (!equals(fdLower, analytical, 1e-5))
+  {
+    std::cout << "Sparse Hessian of DynamicsFitProblem not equal!" << std::endl;
+    std::cout << "Max diff: " << (fdLower - analytical).cwiseAbs().maxCoeff()
+              << std::endl;
+    EXPECT_TRUE(equals(fdLower, analytical, 1e-5));
+    return;
+  }
+}
+#endif
+
+#ifdef JACOBIAN_TESTS
+TEST(DynamicsFitter, FIT_PROBLEM_RESET_MATCHES_FRESH)
+{
+  std::vector<std::string> motFiles;
+  std::vector<std::string> c3dFiles;
+  std::vector<std::string> trcFiles;
+  std::vector<std::string> grfFiles;
+
+  motFiles.push_back("dart://sample/grf/Subject4/IK/walking1_ik.mot");
+  trcFiles.push_back("dart://sample/grf/Subject4/MarkerData/walking1.trc");
+  grfFiles.push_back("dart://sample/grf/Subject4/ID/walking1_grf.mot");
+
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/grf/Subject4/Models/"
+      "optimized_scale_and_markers.osim");
+
+  std::vector<std::string> footNames;
+  footNames.push_back("calcn_r");
+  footNames.push_back("calcn_l");
+
+  std::shared_ptr<DynamicsInitialization> init = createInitialization(
+      standard.skeleton,
+      standard.markersMap,
+      standard.trackingMarkers,
+      footNames,
+      motFiles,
+      c3dFiles,
+      trcFiles,
+      grfFiles,
+      12);
+
+  DynamicsFitProblemConfig config(standard.skeleton);
+  config.setResidualWeight(1.0);
+  config.setMarkerWeight(1.0);
+  config.setMaxBlockSize(4);
+  config.setIncludeMasses(true);
+  config.setIncludePoses(true);
+  config.setIncludeMarkerOffsets(true);
+
+  DynamicsFitProblem problem(
+      init, standard.skeleton, standard.trackingMarkers, config);
+
+  // Changing weights keeps the structure, changing variables doesn't
+  DynamicsFitProblemConfig reweighted = config;
+  reweighted.setResidualWeight(2.0);
+  reweighted.setMarkerWeight(0.5);
+  EXPECT_TRUE(problem.hasSameStructure(init, reweighted));
+  DynamicsFitProblemConfig withCOMs = config;
+  withCOMs.setIncludeCOMs(true);
+  EXPECT_FALSE(problem.hasSameStructure(init, withCOMs));
+  DynamicsFitProblemConfig smallerBlocks = config;
+  smallerBlocks.setMaxBlockSize(3);
+  EXPECT_FALSE(problem.hasSameStructure(init, smallerBlocks));
+
+  // Move the starting point, as a previous stage of optimization would
+  srand(42);
+  init->poseTrials[0] += Eigen::MatrixXs::Random(
+                             init->poseTrials[0].rows(),
+                             init->poseTrials[0].cols())
+                         * 0.01;
+  for (auto& pair : init->updatedMarkerMap)
+  {
+    pair.second.second += Eigen::Vector3s::Random() * 0.01;
+  }
+
+  problem.resetFromInit(reweighted);
+  DynamicsFitProblem fresh(
+      init, standard.skeleton, standard.trackingMarkers, reweighted);
+
+  Eigen::VectorXs x = problem.flatten();
+  EXPECT_TRUE(equals(x, fresh.flatten(), 0));
+  EXPECT_NEAR(problem.computeLoss(x), fresh.computeLoss(x), 1e-12);
+  EXPECT_TRUE(
+      equals(problem.computeGradient(x), fresh.computeGradient(x), 1e-12));
+}
+#endif
+
 #ifdef JACOBIAN_TESTS
 TEST(DynamicsFitter, FIT_PROBLEM_GRAD_MARKERS_L2)
 {
@@ -6571,4 +6805,313 @@ TEST(DynamicsFitter, MARKERS_TO_DYNAMICS_MARILYN_BUG)
       0,
       true);
 }
-#endif
\ No newline at end of file
+#endif
+//==============================================================================
+std::shared_ptr<DynamicsInitialization> createTwoFootInit(
+    std::shared_ptr<dynamics::Skeleton> skel, int numTimesteps)
+{
+  std::shared_ptr<DynamicsInitialization> init
+      = std::make_shared<DynamicsInitialization>();
+  init->trialTimesteps.push_back(0.01);
+  init->groundHeight.push_back(0.0);
+
+  Eigen::MatrixXs poses
+      = Eigen::MatrixXs::Zero(skel->getNumDofs(), numTimesteps);
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    for (int i = 0; i < skel->getNumDofs(); i++)
+    {
+      poses(i, t) = 0.3 * sin(0.05 * t * (i + 1) + i);
+    }
+  }
+  init->poseTrials.push_back(poses);
+
+  init->grfBodyNodes.push_back(skel->getBodyNode("left"));
+  init->grfBodyNodes.push_back(skel->getBodyNode("right"));
+  for (dynamics::BodyNode* body : init->grfBodyNodes)
+  {
+    init->grfBodyIndices.push_back(body->getIndexInSkeleton());
+  }
+  init->grfTrials.push_back(Eigen::MatrixXs::Zero(12, numTimesteps));
+
+  // Two plates, one under each foot, with gaps in the contact
+  std::vector<ForcePlate> plates;
+  std::vector<std::vector<int>> assigned;
+  std::vector<std::vector<bool>> active(numTimesteps);
+  for (int i = 0; i < 2; i++)
+  {
+    ForcePlate plate;
+    for (int t = 0; t < numTimesteps; t++)
+    {
+      bool inContact = ((t / 7) + i) % 3 != 0;
+      plate.forces.push_back(
+          inContact ? Eigen::Vector3s(5 * i, 300 + t, -2)
+                    : Eigen::Vector3s::Zero());
+      plate.moments.push_back(Eigen::Vector3s(0, 0.1 * t, 0));
+      plate.centersOfPressure.push_back(
+          Eigen::Vector3s(0.01 * t, 0, i == 0 ? -0.1 : 0.1));
+      active[t].push_back(inContact);
+    }
+    plates.push_back(plate);
+    assigned.push_back(std::vector<int>(numTimesteps, -1));
+  }
+  init->forcePlateTrials.push_back(plates);
+  init->forcePlatesAssignedToContactBody.push_back(assigned);
+  init->grfBodyForceActive.push_back(active);
+  return init;
+}
+
+//==============================================================================
+TEST(DynamicsFitter, PARALLEL_GRFS_MATCH_SERIAL)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  auto pelvis = skel->createJointAndBodyNodePair<dynamics::FreeJoint>();
+  pelvis.second->setName("pelvis");
+  for (std::string name : {"left", "right"})
+  {
+    auto leg = skel->createJointAndBodyNodePair<dynamics::BallJoint>(
+        pelvis.second);
+    leg.second->setName(name);
+    Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+    offset.translation()
+        = Eigen::Vector3s(0, -0.8, name == "left" ? -0.1 : 0.1);
+    leg.first->setTransformFromParentBodyNode(offset);
+    leg.second->setMass(5.0);
+  }
+
+  const int numTimesteps = 40;
+  std::shared_ptr<DynamicsInitialization> init
+      = createTwoFootInit(skel, numTimesteps);
+  DynamicsFitter fitter(skel, init->grfBodyNodes, {});
+
+  DynamicsFitter::recomputeGRFs(init, skel, 0, 1);
+  Eigen::MatrixXs serialGRFs = init->grfTrials[0];
+  std::vector<std::vector<int>> serialAssignments
+      = init->forcePlatesAssignedToContactBody[0];
+  DynamicsFitter::recomputeGRFs(init, skel, 0, 4);
+  EXPECT_TRUE(equals(init->grfTrials[0], serialGRFs, 0));
+  EXPECT_EQ(init->forcePlatesAssignedToContactBody[0], serialAssignments);
+
+  fitter.computePerfectGRFs(init, 1);
+  Eigen::MatrixXs serialTorques = init->perfectTorques[0];
+  Eigen::MatrixXs serialPerfectGRFs = init->perfectGrfTrials[0];
+  Eigen::MatrixXs serialCopWrenches = init->perfectGrfAsCopTorqueForces[0];
+  std::vector<ForcePlate> serialPlates = init->perfectForcePlateTrials[0];
+  const s_t* torqueBuffer = init->perfectTorques[0].data();
+
+  fitter.computePerfectGRFs(init, 4);
+  // The second call reuses the buffers from the first
+  EXPECT_EQ(init->perfectTorques[0].data(), torqueBuffer);
+  EXPECT_TRUE(equals(init->perfectTorques[0], serialTorques, 0));
+  EXPECT_TRUE(equals(init->perfectGrfTrials[0], serialPerfectGRFs, 0));
+  EXPECT_TRUE(
+      equals(init->perfectGrfAsCopTorqueForces[0], serialCopWrenches, 0));
+  ASSERT_EQ(init->perfectForcePlateTrials[0].size(), serialPlates.size());
+  for (int i = 0; i < serialPlates.size(); i++)
+  {
+    const ForcePlate& plate = init->perfectForcePlateTrials[0][i];
+    ASSERT_EQ(plate.forces.size(), numTimesteps - 1);
+    for (int t = 0; t < numTimesteps - 1; t++)
+    {
+      EXPECT_EQ(plate.forces[t], serialPlates[i].forces[t]);
+      EXPECT_EQ(plate.moments[t], serialPlates[i].moments[t]);
+      EXPECT_EQ(
+          plate.centersOfPressure[t], serialPlates[i].centersOfPressure[t]);
+    }
+  }
+}
+
+//==============================================================================
+// This is the dense formulation zeroLinearResidualsOnCOMTrajectory() used to
+// build, with the missing step columns placed after the force plate columns
+Eigen::MatrixXs denseCOMTrajectoryLinearMap(
+    s_t dt,
+    const std::vector<Eigen::Vector3s>& grfs,
+    const std::vector<ForcePlate>& forcePlates,
+    const std::vector<int>& missingStepIndices,
+    const std::vector<int>& missingStepMappings,
+    int numMissingSteps,
+    s_t regularizeForcePlateRotations,
+    s_t regularizeUnobservedTimesteps)
+{
+  const int numTimesteps = grfs.size();
+  const int numForcePlates = forcePlates.size();
+  Eigen::MatrixXs map = Eigen::MatrixXs::Zero(
+      numTimesteps * 3 + (numForcePlates * 3) + (numMissingSteps * 3),
+      6 + (numForcePlates * 3) + (numMissingSteps * 3) + 1);
+  const int massCol = map.cols() - 1;
+
+  Eigen::Vector3s forceVelocity = Eigen::Vector3s::Zero();
+  Eigen::Vector3s forceOffset = Eigen::Vector3s::Zero();
+  std::vector<Eigen::Vector3s> forcePlateVelocity(
+      numForcePlates, Eigen::Vector3s::Zero());
+  std::vector<Eigen::Vector3s> forcePlateOffset(
+      numForcePlates, Eigen::Vector3s::Zero());
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    map.block<3, 3>(t * 3, 0) = Eigen::Matrix3s::Identity();
+    map.block<3, 3>(t * 3, 3) = Eigen::Matrix3s::Identity() * t * dt;
+    for (int f = 0; f < numForcePlates; f++)
+    {
+      for (int axis = 0; axis < 3; axis++)
+      {
+        map.block<3, 1>(t * 3, 6 + f * 3 + axis)
+            = forcePlateOffset[f].cross(Eigen::Vector3s::Unit(axis));
+      }
+    }
+    map.block<3, 1>(t * 3, massCol) = forceOffset;
+    for (int j = 0; j < missingStepIndices.size(); j++)
+    {
+      int missingIndex = missingStepIndices[j];
+      if (missingIndex >= t)
+        break;
+      int col = 6 + numForcePlates * 3 + missingStepMappings[j] * 3;
+      map.block<3, 3>(t * 3, col)
+          = Eigen::Matrix3s::Identity() * dt * (t - missingIndex);
+    }
+
+    forceVelocity += grfs[t] * dt;
+    forceOffset += forceVelocity * dt;
+    for (int f = 0; f < numForcePlates; f++)
+    {
+      forcePlateVelocity[f] += forcePlates[f].forces[t] * dt;
+      forcePlateOffset[f] += forcePlateVelocity[f] * dt;
+    }
+  }
+  for (int j = 0; j < numForcePlates * 3; j++)
+  {
+    map(numTimesteps * 3 + j, 6 + j)
+        = regularizeForcePlateRotations * numTimesteps;
+  }
+  for (int j = 0; j < numMissingSteps * 3; j++)
+  {
+    map(numTimesteps * 3 + numForcePlates * 3 + j, 6 + numForcePlates * 3 + j)
+        = regularizeUnobservedTimesteps;
+  }
+  return map;
+}
+
+//==============================================================================
+TEST(DynamicsFitter, COM_TRAJECTORY_SPARSE_MAP_MATCHES_DENSE)
+{
+  srand(42);
+  const int numTimesteps = 40;
+  const s_t dt = 0.01;
+
+  std::vector<Eigen::Vector3s> grfs;
+  std::vector<ForcePlate> plates(2);
+  for (int t = 0; t < numTimesteps; t++)
+  {
+    Eigen::Vector3s total = Eigen::Vector3s::Zero();
+    for (ForcePlate& plate : plates)
+    {
+      plate.forces.push_back(Eigen::Vector3s::Random() * 100);
+      total += plate.forces.back();
+    }
+    grfs.push_back(total);
+  }
+
+  // More missing steps than buckets, so some buckets share several steps
+  std::vector<int> missingStepIndices = {5, 12, 13, 14, 30};
+  const int numMissingSteps = 3;
+  std::vector<int> missingStepMappings
+      = math::getConsolidatedMapping(missingStepIndices, numMissingSteps);
+
+  Eigen::SparseMatrix<s_t> sparse = DynamicsFitter::getCOMTrajectoryLinearMap(
+      dt,
+      grfs,
+      plates,
+      missingStepIndices,
+      missingStepMappings,
+      numMissingSteps,
+      10.0,
+      0.1);
+  Eigen::MatrixXs dense = denseCOMTrajectoryLinearMap(
+      dt,
+      grfs,
+      plates,
+      missingStepIndices,
+      missingStepMappings,
+      numMissingSteps,
+      10.0,
+      0.1);
+  EXPECT_TRUE(equals(Eigen::MatrixXs(sparse), dense, 0.0));
+
+  Eigen::VectorXs target = Eigen::VectorXs::Random(dense.rows());
+
+  Eigen::LeastSquaresConjugateGradient<Eigen::SparseMatrix<s_t>> sparseSolver;
+  sparseSolver.setTolerance(1e-9);
+  sparseSolver.setMaxIterations(200);
+  sparseSolver.compute(sparse);
+  Eigen::VectorXs sparseResult = sparseSolver.solve(target);
+
+  Eigen::LeastSquaresConjugateGradient<Eigen::MatrixXs> denseSolver;
+  denseSolver.setTolerance(1e-9);
+  denseSolver.setMaxIterations(200);
+  denseSolver.compute(dense);
+  Eigen::VectorXs denseResult = denseSolver.solve(target);
+
+  // Both solves stop at the same tolerance, but they sum their products in a
+  // different order, so they only agree to about the solver tolerance
+  EXPECT_TRUE(equals(sparseResult, denseResult, 1e-6));
+  Eigen::VectorXs directResult = dense.householderQr().solve(target);
+  EXPECT_TRUE(equals(sparseResult, directResult, 1e-6));
+}
+
+//==============================================================================
+TEST(DynamicsFitter, FIT_PROBLEM_PARALLEL_LOSS_INDEPENDENT_OF_THREADS)
+{
+  std::vector<std::string> motFiles;
+  std::vector<std::string> c3dFiles;
+  std::vector<std::string> trcFiles;
+  std::vector<std::string> grfFiles;
+
+  motFiles.push_back("dart://sample/grf/Subject4/IK/walking1_ik.mot");
+  trcFiles.push_back("dart://sample/grf/Subject4/MarkerData/walking1.trc");
+  grfFiles.push_back("dart://sample/grf/Subject4/ID/walking1_grf.mot");
+
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/grf/Subject4/Models/"
+      "optimized_scale_and_markers.osim");
+
+  std::vector<std::string> footNames;
+  footNames.push_back("calcn_r");
+  footNames.push_back("calcn_l");
+
+  std::shared_ptr<DynamicsInitialization> init = createInitialization(
+      standard.skeleton,
+      standard.markersMap,
+      standard.trackingMarkers,
+      footNames,
+      motFiles,
+      c3dFiles,
+      trcFiles,
+      grfFiles,
+      20);
+
+  // Uneven blocks, so the threads don't all get the same amount of work
+  DynamicsFitProblemConfig config(standard.skeleton);
+  config.setResidualWeight(1.0);
+  config.setMarkerWeight(1.0);
+  config.setMaxBlockSize(6);
+  config.setIncludeMasses(true);
+  config.setIncludePoses(true);
+  config.setIncludeMarkerOffsets(true);
+  config.setNumThreads(1);
+  DynamicsFitProblem serial(
+      init, standard.skeleton, standard.trackingMarkers, config);
+
+  config.setNumThreads(3);
+  DynamicsFitProblem parallel(
+      init, standard.skeleton, standard.trackingMarkers, config);
+
+  srand(42);
+  Eigen::VectorXs x = serial.flatten();
+  x += Eigen::VectorXs::Random(x.size()) * 0.01;
+
+  EXPECT_EQ(serial.computeLossParallel(x), parallel.computeLossParallel(x));
+  EXPECT_TRUE(equals(
+      serial.computeGradientParallel(x),
+      parallel.computeGradientParallel(x),
+      0));
+}
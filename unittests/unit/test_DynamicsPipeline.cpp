@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/DynamicsPipeline.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+using namespace dynamics;
+
+//==============================================================================
+std::shared_ptr<Skeleton> createLeg()
+{
+  std::shared_ptr<Skeleton> skel = Skeleton::create("leg");
+  auto pelvis = skel->createJointAndBodyNodePair<FreeJoint>();
+  pelvis.second->setName("pelvis");
+  pelvis.first->setName("ground_pelvis");
+  auto femur = skel->createJointAndBodyNodePair<RevoluteJoint>(pelvis.second);
+  femur.second->setName("femur");
+  femur.first->setName("hip");
+  auto tibia = skel->createJointAndBodyNodePair<RevoluteJoint>(femur.second);
+  tibia.second->setName("tibia");
+  tibia.first->setName("knee");
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    skel->getBodyNode(i)->setMass(1.0 + i);
+  }
+  return skel;
+}
+
+//==============================================================================
+std::shared_ptr<DynamicsInitialization> createInit(
+    std::shared_ptr<Skeleton> skel)
+{
+  std::shared_ptr<DynamicsInitialization> init
+      = std::make_shared<DynamicsInitialization>();
+
+  ForcePlate plate;
+  plate.worldOrigin = Eigen::Vector3s(1, 2, 3);
+  plate.corners.push_back(Eigen::Vector3s::Random());
+  plate.corners.push_back(Eigen::Vector3s::Random());
+  plate.forces.push_back(Eigen::Vector3s::Random());
+  init->forcePlateTrials.push_back({plate});
+  init->trialTimesteps.push_back(0.01);
+
+  std::map<std::string, Eigen::Vector3s> markers;
+  markers["RKNE"] = Eigen::Vector3s::Random();
+  markers["RANK"] = Eigen::Vector3s::Random();
+  init->markerObservationTrials.push_back({markers, markers});
+
+  init->poseTrials.push_back(Eigen::MatrixXs::Random(skel->getNumDofs(), 2));
+  init->grfTrials.push_back(Eigen::MatrixXs::Random(6, 2));
+  init->grfBodyIndices.push_back(2);
+  init->grfBodyNodes.push_back(skel->getBodyNode("tibia"));
+  init->contactBodies.push_back({skel->getBodyNode("tibia")});
+  init->flatGround.push_back(true);
+  init->groundHeight.push_back(-0.5);
+  init->grfBodyForceActive.push_back({{true, false}});
+  init->grfBodyContactSphereRadius.push_back({{0.1, 0.2}});
+  init->probablyMissingGRF.push_back({false, true});
+  init->forcePlatesAssignedToContactBody.push_back({{0, -1}});
+  init->defaultForcePlateCorners.push_back(plate.corners);
+
+  init->bodyMasses = skel->getLinkMasses();
+  init->bodyCom = Eigen::Matrix<s_t, 3, Eigen::Dynamic>::Random(3, 3);
+  init->groupScales = skel->getGroupScales();
+  init->markerOffsets["RKNE"] = Eigen::Vector3s::Random();
+  init->trackingMarkers.push_back("RKNE");
+  init->joints.push_back(skel->getJoint("knee"));
+  init->jointsAdjacentMarkers.push_back({"RKNE", "RANK"});
+  init->jointCenters.push_back(Eigen::MatrixXs::Random(3, 2));
+  init->updatedMarkerMap["RKNE"]
+      = std::make_pair(skel->getBodyNode("femur"), Eigen::Vector3s::Random());
+  init->regularizePosesTo = init->poseTrials;
+  init->regularizeGroupMassesTo = Eigen::VectorXs::Random(3);
+  return init;
+}
+
+//==============================================================================
+TEST(DynamicsPipeline, SERIALIZATION_ROUND_TRIP)
+{
+  std::shared_ptr<Skeleton> skel = createLeg();
+  std::shared_ptr<DynamicsInitialization> init = createInit(skel);
+
+  proto::DynamicsInitialization proto;
+  DynamicsPipeline::serializeInitialization(proto, skel, init, {"first"});
+
+  // Mess up the Skeleton, which the checkpoint should restore
+  Eigen::VectorXs masses = skel->getLinkMasses();
+  skel->setLinkMasses(Eigen::VectorXs::Ones(skel->getNumBodyNodes()) * 7);
+
+  std::vector<std::string> stages;
+  std::shared_ptr<DynamicsInitialization> recovered
+      = DynamicsPipeline::deserializeInitialization(proto, skel, &stages);
+  ASSERT_NE(recovered, nullptr);
+  EXPECT_EQ(stages, std::vector<std::string>({"first"}));
+  EXPECT_TRUE(equals(skel->getLinkMasses(), masses, 0));
+
+  ASSERT_EQ(recovered->forcePlateTrials.size(), 1);
+  const ForcePlate& plate = recovered->forcePlateTrials[0][0];
+  EXPECT_TRUE(equals(plate.worldOrigin, Eigen::Vector3s(1, 2, 3), 0));
+  ASSERT_EQ(plate.corners.size(), 2);
+  EXPECT_TRUE(
+      equals(plate.corners[1], init->forcePlateTrials[0][0].corners[1], 0));
+  EXPECT_EQ(plate.centersOfPressure.size(), 0);
+  EXPECT_EQ(recovered->markerObservationTrials, init->markerObservationTrials);
+  EXPECT_TRUE(equals(recovered->poseTrials[0], init->poseTrials[0], 0));
+  EXPECT_TRUE(equals(recovered->bodyCom, init->bodyCom, 0));
+  EXPECT_EQ(recovered->grfBodyNodes, init->grfBodyNodes);
+  EXPECT_EQ(recovered->contactBodies, init->contactBodies);
+  EXPECT_EQ(recovered->joints, init->joints);
+  EXPECT_EQ(recovered->flatGround, init->flatGround);
+  EXPECT_EQ(recovered->grfBodyForceActive, init->grfBodyForceActive);
+  EXPECT_EQ(
+      recovered->grfBodyContactSphereRadius, init->grfBodyContactSphereRadius);
+  EXPECT_EQ(recovered->probablyMissingGRF, init->probablyMissingGRF);
+  EXPECT_EQ(
+      recovered->forcePlatesAssignedToContactBody,
+      init->forcePlatesAssignedToContactBody);
+  EXPECT_EQ(recovered->markerOffsets, init->markerOffsets);
+  EXPECT_EQ(recovered->jointsAdjacentMarkers, init->jointsAdjacentMarkers);
+  EXPECT_EQ(recovered->updatedMarkerMap, init->updatedMarkerMap);
+  EXPECT_TRUE(equals(
+      recovered->regularizeGroupMassesTo, init->regularizeGroupMassesTo, 0));
+
+  // A Skeleton without the right bodies can't load the checkpoint
+  std::shared_ptr<Skeleton> other = createLeg();
+  other->getBodyNode("tibia")->setName("shank");
+  EXPECT_EQ(DynamicsPipeline::deserializeInitialization(proto, other), nullptr);
+}
+
+//==============================================================================
+TEST(DynamicsPipeline, RESUMES_AFTER_FAILED_STAGE)
+{
+  std::string path = "./dynamics_pipeline_checkpoint.bin";
+  std::remove(path.c_str());
+
+  std::shared_ptr<Skeleton> skel = createLeg();
+  std::shared_ptr<DynamicsInitialization> init = createInit(skel);
+
+  int firstRuns = 0;
+  int secondRuns = 0;
+  bool failSecond = true;
+  auto buildPipeline = [&](DynamicsPipeline& pipeline) {
+    pipeline.addStage(
+        "first", [&](std::shared_ptr<DynamicsInitialization> stageInit) {
+          firstRuns++;
+          stageInit->poseTrials[0].setConstant(0.25);
+          skel->setLinkMasses(Eigen::VectorXs::Ones(3) * 5);
+        });
+    pipeline.addStage(
+        "second", [&](std::shared_ptr<DynamicsInitialization> stageInit) {
+          secondRuns++;
+          if (failSecond)
+          {
+            throw std::runtime_error("Out of time");
+          }
+          stageInit->poseTrials[0] *= 2;
+        });
+  };
+
+  {
+    DynamicsPipeline pipeline(skel, path);
+    buildPipeline(pipeline);
+    EXPECT_THROW(pipeline.run(init), std::runtime_error);
+    EXPECT_EQ(pipeline.getCompletedStages(), std::vector<std::string>{"first"});
+  }
+
+  // Start again, as if in a fresh process, with the original state
+  skel = createLeg();
+  init = createInit(skel);
+  failSecond = false;
+  {
+    DynamicsPipeline pipeline(skel, path);
+    buildPipeline(pipeline);
+    std::shared_ptr<DynamicsInitialization> result = pipeline.run(init);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(firstRuns, 1);
+    EXPECT_EQ(secondRuns, 2);
+    Eigen::MatrixXs expectedPoses
+        = Eigen::MatrixXs::Constant(skel->getNumDofs(), 2, 0.5);
+    EXPECT_TRUE(equals(result->poseTrials[0], expectedPoses, 0));
+    Eigen::VectorXs expectedMasses = Eigen::VectorXs::Ones(3) * 5;
+    EXPECT_TRUE(equals(skel->getLinkMasses(), expectedMasses, 0));
+    EXPECT_EQ(
+        pipeline.getCompletedStages(),
+        std::vector<std::string>({"first", "second"}));
+  }
+
+  // A pipeline with different stages ignores the checkpoint
+  {
+    DynamicsPipeline pipeline(skel, path);
+    pipeline.addStage("other", [](std::shared_ptr<DynamicsInitialization>) {});
+    std::shared_ptr<DynamicsInitialization> fresh = createInit(skel);
+    EXPECT_EQ(pipeline.run(fresh), fresh);
+  }
+
+  std::remove(path.c_str());
+}
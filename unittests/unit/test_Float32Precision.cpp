@@ -0,0 +1,88 @@
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/MathTypes.hpp"
+
+using namespace dart;
+using namespace dynamics;
+
+// This is only built against dart-float32, so these check that single
+// precision is good enough for the dynamics that RL rollouts lean on.
+static_assert(
+    std::is_same<s_t, float>::value, "This test needs DART_USE_FLOAT32");
+
+//==============================================================================
+template <typename JointType>
+BodyNode* addBody(const SkeletonPtr& skel, BodyNode* parent)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0, 0.3, 0.1);
+  pair.first->setTransformFromParentBodyNode(T);
+  pair.second->setMass(1.0);
+  return pair.second;
+}
+
+//==============================================================================
+SkeletonPtr createArm()
+{
+  SkeletonPtr skel = Skeleton::create("arm");
+  BodyNode* root = addBody<FreeJoint>(skel, nullptr);
+  BodyNode* upper = addBody<BallJoint>(skel, root);
+  BodyNode* lower = addBody<RevoluteJoint>(skel, upper);
+  addBody<RevoluteJoint>(skel, lower);
+
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()) * 0.5);
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  return skel;
+}
+
+//==============================================================================
+TEST(Float32Precision, MASS_MATRIX_INVERSE)
+{
+  SkeletonPtr skel = createArm();
+  const int dofs = skel->getNumDofs();
+
+  Eigen::MatrixXs product = skel->getMassMatrix() * skel->getInvMassMatrix();
+  EXPECT_TRUE(product.isApprox(Eigen::MatrixXs::Identity(dofs, dofs), 1e-3));
+}
+
+//==============================================================================
+TEST(Float32Precision, INVERSE_DYNAMICS_ROUND_TRIP)
+{
+  SkeletonPtr skel = createArm();
+  const int dofs = skel->getNumDofs();
+
+  Eigen::VectorXs tau = Eigen::VectorXs::Random(dofs);
+  skel->setControlForces(tau);
+  skel->computeForwardDynamics();
+  Eigen::VectorXs acc = skel->getAccelerations();
+
+  skel->setAccelerations(acc);
+  skel->computeInverseDynamics();
+  Eigen::VectorXs recovered = skel->getControlForces();
+
+  EXPECT_LT((recovered - tau).cwiseAbs().maxCoeff(), 1e-3);
+}
+
+//==============================================================================
+TEST(Float32Precision, ROLLOUT_STAYS_FINITE)
+{
+  SkeletonPtr skel = createArm();
+  skel->setGravity(Eigen::Vector3s(0, -9.81, 0));
+
+  for (int i = 0; i < 1000; i++)
+  {
+    skel->computeForwardDynamics();
+    skel->integrateVelocities(0.001);
+    skel->integratePositions(0.001);
+  }
+  EXPECT_TRUE(skel->getPositions().allFinite());
+  EXPECT_TRUE(skel->getVelocities().allFinite());
+}
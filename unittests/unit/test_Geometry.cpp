@@ -36,11 +36,13 @@
 
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/MultiSphereConvexHullShape.hpp"
 #include "dart/dynamics/PrismaticJoint.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/dynamics/TranslationalJoint.hpp"
 #include "dart/dynamics/WeldJoint.hpp"
+#include "dart/math/ConvexHull.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
 #include "dart/simulation/World.hpp"
@@ -1248,3 +1250,193 @@ TEST(LIE_GROUP_OPERATORS, ADJOINT_MAPPINGS)
   }
 }
 #endif
+
+#ifdef ALL_TESTS
+TEST(LIE_GROUP_OPERATORS, BATCHED_KERNELS)
+{
+  const int n = 101;
+  TwistBatch twists = TwistBatch::Random(n, 6);
+  TwistBatch others = TwistBatch::Random(n, 6);
+  Vector3Batch angles = Vector3Batch::Random(n, 3);
+  // Make sure we hit the small-angle branches too
+  twists.row(0).head<3>().setZero();
+  twists.row(1).head<3>() *= 1e-9;
+  angles.row(0).setZero();
+
+  TransformBatch transforms;
+  expMapBatch(twists, transforms);
+  TransformBatch dartTransforms;
+  expMapDartBatch(twists, dartTransforms);
+  RotationBatch rotations;
+  expAngularBatch(angles, rotations);
+  RotationBatch euler;
+  eulerXYZToMatrixBatch(angles, euler);
+  std::vector<RotationBatch> eulerGrads(3);
+  for (int k = 0; k < 3; k++)
+    eulerXYZToMatrixGradBatch(angles, k, eulerGrads[k]);
+  TwistBatch adT;
+  AdTBatch(transforms, others, adT);
+  TwistBatch dAdTs;
+  dAdTBatch(transforms, others, dAdTs);
+  TwistBatch ads;
+  adBatch(twists, others, ads);
+
+  for (int i = 0; i < n; i++)
+  {
+    const Eigen::Vector6s S = twists.row(i).transpose();
+    const Eigen::Vector6s V = others.row(i).transpose();
+    const Eigen::Vector3s angle = angles.row(i).transpose();
+    const Eigen::Isometry3s T = expMap(S);
+
+    EXPECT_TRUE(equals(
+        T.matrix(), getBatchTransform(transforms, i).matrix(), 1e-12));
+    EXPECT_TRUE(equals(
+        expMapDart(S).matrix(),
+        getBatchTransform(dartTransforms, i).matrix(),
+        1e-12));
+
+    Eigen::Matrix3s R = Eigen::Map<const Eigen::Matrix3s>(
+        Eigen::Matrix<s_t, 9, 1>(rotations.row(i).transpose()).data());
+    EXPECT_TRUE(equals(Eigen::Matrix3s(expAngular(angle).linear()), R, 1e-12));
+    R = Eigen::Map<const Eigen::Matrix3s>(
+        Eigen::Matrix<s_t, 9, 1>(euler.row(i).transpose()).data());
+    EXPECT_TRUE(equals(eulerXYZToMatrix(angle), R, 1e-12));
+    for (int k = 0; k < 3; k++)
+    {
+      R = Eigen::Map<const Eigen::Matrix3s>(
+          Eigen::Matrix<s_t, 9, 1>(eulerGrads[k].row(i).transpose()).data());
+      EXPECT_TRUE(equals(eulerXYZToMatrixGrad(angle, k), R, 1e-12));
+    }
+
+    EXPECT_TRUE(equals(AdT(T, V), Eigen::Vector6s(adT.row(i)), 1e-12));
+    EXPECT_TRUE(equals(dAdT(T, V), Eigen::Vector6s(dAdTs.row(i)), 1e-12));
+    EXPECT_TRUE(equals(ad(S, V), Eigen::Vector6s(ads.row(i)), 1e-12));
+  }
+
+  // Round trip through the batch layout
+  TransformBatch copy(n, 12);
+  for (int i = 0; i < n; i++)
+    setBatchTransform(copy, i, getBatchTransform(transforms, i));
+  EXPECT_TRUE(equals(transforms, copy, 0.0));
+
+  // The outputs may alias the inputs
+  TwistBatch aliased = others;
+  AdTBatch(transforms, aliased, aliased);
+  EXPECT_TRUE(equals(adT, aliased, 0.0));
+  aliased = others;
+  dAdTBatch(transforms, aliased, aliased);
+  EXPECT_TRUE(equals(dAdTs, aliased, 0.0));
+  aliased = twists;
+  adBatch(aliased, others, aliased);
+  EXPECT_TRUE(equals(ads, aliased, 0.0));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(CONVEX_HULL, SUPPORT_MATCHES_BRUTE_FORCE)
+{
+  srand(7);
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 2000; i++)
+  {
+    Eigen::Vector3s point = Eigen::Vector3s::Random();
+    // Put half the points on a sphere, so they all end up on the hull, and
+    // the other half inside it
+    if (i % 2 == 0)
+      point.normalize();
+    else
+      point *= 0.5;
+    points.push_back(point);
+    // Meshes repeat their vertices a lot
+    points.push_back(point);
+  }
+
+  ConvexHull hull(points);
+  EXPECT_FALSE(hull.isDegenerate());
+  EXPECT_EQ(1000u, hull.getVertices().size());
+  // Euler's formula for a closed triangulated surface
+  EXPECT_EQ(2 * hull.getVertices().size() - 4, hull.getFaces().size());
+
+  int hint = -1;
+  for (int i = 0; i < 500; i++)
+  {
+    Eigen::Vector3s dir = Eigen::Vector3s::Random();
+    s_t bestDot = -std::numeric_limits<s_t>::infinity();
+    for (const Eigen::Vector3s& point : points)
+      bestDot = std::max(bestDot, point.dot(dir));
+
+    EXPECT_NEAR(bestDot, hull.getSupport(dir).dot(dir), 1e-12);
+    hint = hull.getSupportIndex(dir, hint);
+    EXPECT_NEAR(bestDot, hull.getVertices()[hint].dot(dir), 1e-12);
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(CONVEX_HULL, FLAT_POINTS_FALL_BACK_TO_BRUTE_FORCE)
+{
+  std::vector<Eigen::Vector3s> points;
+  for (int i = 0; i < 100; i++)
+  {
+    Eigen::Vector3s point = Eigen::Vector3s::Random();
+    point(2) = 0;
+    points.push_back(point);
+  }
+
+  ConvexHull hull(points);
+  EXPECT_TRUE(hull.isDegenerate());
+  EXPECT_EQ(0u, hull.getFaces().size());
+
+  for (int i = 0; i < 100; i++)
+  {
+    Eigen::Vector3s dir = Eigen::Vector3s::Random();
+    s_t bestDot = -std::numeric_limits<s_t>::infinity();
+    for (const Eigen::Vector3s& point : points)
+      bestDot = std::max(bestDot, point.dot(dir));
+    EXPECT_EQ(bestDot, hull.getSupport(dir).dot(dir));
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(CONVEX_HULL, MULTI_SPHERE_SUPPORT)
+{
+  MultiSphereConvexHullShape::Spheres spheres;
+  for (int i = 0; i < 300; i++)
+  {
+    // Mix spheres on the outside with bigger and smaller ones inside, and
+    // repeat some centers with a different radius
+    Eigen::Vector3s center = Eigen::Vector3s::Random();
+    if (i % 3 == 0)
+      center.normalize();
+    s_t radius = 0.05 + 0.1 * (i % 7);
+    spheres.emplace_back(radius, center);
+    if (i % 10 == 0)
+      spheres.emplace_back(radius * 2, center);
+  }
+  MultiSphereConvexHullShape shape(spheres);
+
+  int hint = -1;
+  for (int i = 0; i < 500; i++)
+  {
+    Eigen::Vector3s dir = Eigen::Vector3s::Random();
+    s_t best = -std::numeric_limits<s_t>::infinity();
+    for (const auto& sphere : spheres)
+      best = std::max(best, sphere.second.dot(dir) + sphere.first * dir.norm());
+
+    EXPECT_NEAR(best, shape.getSupport(dir).dot(dir), 1e-12);
+    hint = shape.getSupportSphereIndex(dir, hint);
+    const auto& sphere = shape.getSpheres()[hint];
+    EXPECT_NEAR(
+        best, sphere.second.dot(dir) + sphere.first * dir.norm(), 1e-12);
+  }
+
+  // Changing the spheres throws out the cached hull
+  shape.addSphere(10.0, Eigen::Vector3s::Zero());
+  EXPECT_EQ(
+      static_cast<int>(spheres.size()),
+      shape.getSupportSphereIndex(Eigen::Vector3s::UnitX(), hint));
+  EXPECT_TRUE(shape.getSupport(Eigen::Vector3s::UnitY())
+                  .isApprox(Eigen::Vector3s(0, 10, 0)));
+}
+#endif
@@ -146,4 +146,77 @@ TEST(MarkerFitter, EVAL_PERFORMANCE)
   // report.saveCSVMarkerErrorReport("./test.csv");
 }
 // #endif
-// #endif
\ No newline at end of file
+// #endif
+
+//==============================================================================
+TEST(IKErrorReport, PARALLEL_MATCHES_SERIAL)
+{
+  OpenSimFile scaled = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/Rajagopal_scaled.osim");
+  OpenSimTRC markerTrajectories = OpenSimParser::loadTRC(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603.trc");
+  OpenSimMot mot = OpenSimParser::loadMot(
+      scaled.skeleton,
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603_ik.mot");
+
+  const int numTimesteps = 50;
+  std::vector<std::map<std::string, Eigen::Vector3s>> observations(
+      markerTrajectories.markerTimesteps.begin(),
+      markerTrajectories.markerTimesteps.begin() + numTimesteps);
+  Eigen::MatrixXs poses = mot.poses.leftCols(numTimesteps);
+
+  IKErrorReport serial(
+      scaled.skeleton, scaled.markersMap, poses, observations, nullptr, 1);
+  IKErrorReport parallel(
+      scaled.skeleton, scaled.markersMap, poses, observations, nullptr, 4);
+
+  // The thread count shouldn't change anything
+  EXPECT_EQ(serial.worstMarkers, parallel.worstMarkers);
+  EXPECT_EQ(serial.sumSquaredError, parallel.sumSquaredError);
+  EXPECT_EQ(serial.rootMeanSquaredError, parallel.rootMeanSquaredError);
+  EXPECT_EQ(serial.maxError, parallel.maxError);
+  EXPECT_EQ(
+      serial.averageRootMeanSquaredError, parallel.averageRootMeanSquaredError);
+  EXPECT_EQ(serial.averageSumSquaredError, parallel.averageSumSquaredError);
+  EXPECT_EQ(serial.averageMaxError, parallel.averageMaxError);
+  EXPECT_EQ(serial.markerNames, parallel.markerNames);
+  EXPECT_EQ(serial.numMarkerObservations, parallel.numMarkerObservations);
+  EXPECT_EQ(serial.rmseMarkerErrors, parallel.rmseMarkerErrors);
+  EXPECT_EQ(serial.markerErrorTimesteps, parallel.markerErrorTimesteps);
+
+  // Recompute the errors one timestep at a time, the way the report used to
+  std::map<std::string, s_t> totalSquaredErrors;
+  std::map<std::string, int> counts;
+  for (int i = 0; i < numTimesteps; i++)
+  {
+    scaled.skeleton->setPositions(poses.col(i));
+    std::map<std::string, Eigen::Vector3s> worldMarkers
+        = scaled.skeleton->getMarkerMapWorldPositions(scaled.markersMap);
+    s_t sumSquaredError = 0.0;
+    s_t maxError = 0.0;
+    for (auto& pair : observations[i])
+    {
+      if (worldMarkers.count(pair.first) == 0)
+      {
+        continue;
+      }
+      Eigen::Vector3s diff = pair.second - worldMarkers[pair.first];
+      sumSquaredError += diff.squaredNorm();
+      maxError = std::max(maxError, diff.norm());
+      totalSquaredErrors[pair.first] += diff.squaredNorm();
+      counts[pair.first]++;
+    }
+    EXPECT_NEAR(parallel.sumSquaredError[i], sumSquaredError, 1e-10);
+    EXPECT_NEAR(parallel.maxError[i], maxError, 1e-10);
+  }
+  for (auto& pair : counts)
+  {
+    EXPECT_EQ(parallel.numMarkerObservations[pair.first], pair.second);
+    EXPECT_NEAR(
+        parallel.rmseMarkerErrors[pair.first],
+        sqrt(totalSquaredErrors[pair.first] / pair.second),
+        1e-10);
+  }
+}
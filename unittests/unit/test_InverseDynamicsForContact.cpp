@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include "dart/biomechanics/BatchGaitInverseDynamics.hpp"
 #include "dart/dart.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/MathTypes.hpp"
@@ -455,6 +456,87 @@ TEST(INV_DYN_FOR_CONTACT, TEST_MULTI_CONTACT_MULTI_TIMESTEP_PREV_FORCE)
 }
 #endif
 
+//==============================================================================
+#ifdef ALL_TESTS
+TEST(INV_DYN_FOR_CONTACT, BATCH_GAIT_THREADED_MATCHES_SERIAL)
+{
+  std::shared_ptr<simulation::World> world = simulation::World::create();
+  std::shared_ptr<dynamics::Skeleton> skel = UniversalLoader::loadSkeleton(
+      world.get(), "dart://sample/sdf/atlas/atlas_v3_no_head.sdf");
+
+  int numTimesteps = 30;
+
+  srand(42);
+  Eigen::MatrixXs poses
+      = Eigen::MatrixXs::Zero(skel->getNumDofs(), numTimesteps);
+  for (int i = 1; i < poses.cols(); i++)
+  {
+    poses.col(i) = poses.col(i - 1)
+                   + Eigen::VectorXs::Random(skel->getNumDofs()) * 0.001;
+  }
+
+  std::vector<const dynamics::BodyNode*> nodes;
+  nodes.push_back(skel->getBodyNode("l_foot"));
+  nodes.push_back(skel->getBodyNode("r_foot"));
+
+  // Short sections, so there are several for the threads to split up
+  int maxSectionLength = 4;
+  biomechanics::BatchGaitInverseDynamics serial(
+      skel,
+      poses,
+      nodes,
+      Eigen::Vector3s::UnitY(),
+      0.1,
+      maxSectionLength,
+      1.0,
+      1.0,
+      0.1,
+      1.0,
+      10.0,
+      1);
+  biomechanics::BatchGaitInverseDynamics threaded(
+      skel,
+      poses,
+      nodes,
+      Eigen::Vector3s::UnitY(),
+      0.1,
+      maxSectionLength,
+      1.0,
+      1.0,
+      0.1,
+      1.0,
+      10.0,
+      4);
+
+  int numCompared = 0;
+  for (int t = 0; t < serial.numTimesteps(); t++)
+  {
+    // The last section is never recorded, so its timesteps have no wrenches
+    std::vector<Eigen::Vector6s> serialWrenches;
+    try
+    {
+      serialWrenches = serial.getContactWrenchesAtTimestep(t);
+    }
+    catch (const char*)
+    {
+      continue;
+    }
+    EXPECT_EQ(
+        serial.getContactBodiesAtTimestep(t),
+        threaded.getContactBodiesAtTimestep(t));
+    std::vector<Eigen::Vector6s> threadedWrenches
+        = threaded.getContactWrenchesAtTimestep(t);
+    ASSERT_EQ(serialWrenches.size(), threadedWrenches.size());
+    for (int i = 0; i < serialWrenches.size(); i++)
+    {
+      EXPECT_TRUE(equals(serialWrenches[i], threadedWrenches[i], 0.0));
+    }
+    numCompared++;
+  }
+  EXPECT_GT(numCompared, 2 * maxSectionLength);
+}
+#endif
+
 //==============================================================================
 #ifdef ALL_TESTS
 TEST(INV_DYN_FOR_CONTACT, EXPLORE_RECOVER_CENTER_OF_PRESSURE)
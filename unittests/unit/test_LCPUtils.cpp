@@ -35,9 +35,11 @@
 #include <Eigen/Dense>
 #include <gtest/gtest.h>
 
+#include "dart/constraint/ColoredPgsBoxedLcpSolver.hpp"
 #include "dart/constraint/DantzigBoxedLcpSolver.hpp"
 #include "dart/constraint/LCPUtils.hpp"
 #include "dart/constraint/PgsBoxedLcpSolver.hpp"
+#include "dart/constraint/SmallBoxedLcpSolver.hpp"
 #include "dart/external/odelcpsolver/lcp.h"
 
 #include "TestHelpers.hpp"
@@ -757,4 +759,398 @@ TEST(LCP_UTILS, BLOCK_SYMMETRIC_CASE)
   std::cout << "filtered x:" << std::endl << fx << std::endl;
   std::cout << "A * fx:" << std::endl << A * fx << std::endl;
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, DANTZIG_WARM_START)
+{
+  // A box resting on its four bottom corners. Each contact has a normal row
+  // (y) and two friction rows (x and z).
+  const int n = 12;
+  Eigen::Vector3s corners[4] = {Eigen::Vector3s(0.5, -0.5, 0.5),
+                                Eigen::Vector3s(-0.5, -0.5, 0.5),
+                                Eigen::Vector3s(0.5, -0.5, -0.5),
+                                Eigen::Vector3s(-0.5, -0.5, -0.5)};
+  Eigen::Vector3s dirs[3] = {Eigen::Vector3s::UnitY(),
+                             Eigen::Vector3s::UnitX(),
+                             Eigen::Vector3s::UnitZ()};
+  Eigen::MatrixXs J(n, 6);
+  for (int c = 0; c < 4; c++)
+  {
+    for (int d = 0; d < 3; d++)
+    {
+      J.block<1, 3>(3 * c + d, 0) = corners[c].cross(dirs[d]).transpose();
+      J.block<1, 3>(3 * c + d, 3) = dirs[d].transpose();
+    }
+  }
+  Eigen::VectorXs invMass = Eigen::VectorXs::Ones(6);
+  invMass.head<3>() *= 6;
+  Eigen::MatrixXs A = J * invMass.asDiagonal() * J.transpose();
+
+  Eigen::VectorXs lo(n);
+  Eigen::VectorXs hi(n);
+  Eigen::VectorXi fIndex(n);
+  for (int c = 0; c < 4; c++)
+  {
+    lo.segment<3>(3 * c) << 0, -0.5, -0.5;
+    hi.segment<3>(3 * c) << std::numeric_limits<s_t>::infinity(), 0.5, 0.5;
+    fIndex.segment<3>(3 * c) << -1, 3 * c, 3 * c;
+  }
+  Eigen::VectorXs fallingVel = Eigen::VectorXs::Zero(6);
+  fallingVel(4) = -0.1;
+
+  DantzigBoxedLcpSolver solver;
+  EXPECT_TRUE(solver.getWarmStartEnabled());
+  Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+  const int numSteps = 20;
+  for (int step = 0; step < numSteps; step++)
+  {
+    const Eigen::VectorXs b = -J * fallingVel * (1.0 + 0.01 * step);
+
+    // The solver overwrites everything we pass in, so we pass in copies
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+        paddedA = Eigen::MatrixXs::Zero(n, dPAD(n));
+    paddedA.block(0, 0, n, n) = A;
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    EXPECT_TRUE(solver.solve(
+        n,
+        paddedA.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    EXPECT_TRUE(LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+  }
+
+  // Only the first step has to pivot. After that, the contacts stay in the
+  // same state from one step to the next.
+  EXPECT_EQ(numSteps, solver.getNumSolves());
+  EXPECT_EQ(numSteps - 1, solver.getNumWarmStarts());
+
+  // A guess with the wrong clamping set falls back to pivoting
+  x.setZero();
+  x(1) = 0.5;
+  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> paddedA
+      = Eigen::MatrixXs::Zero(n, dPAD(n));
+  paddedA.block(0, 0, n, n) = A;
+  const Eigen::VectorXs b = -J * fallingVel;
+  Eigen::VectorXs bCopy = b;
+  Eigen::VectorXs loCopy = lo;
+  Eigen::VectorXs hiCopy = hi;
+  Eigen::VectorXi fIndexCopy = fIndex;
+  EXPECT_TRUE(solver.solve(
+      n,
+      paddedA.data(),
+      x.data(),
+      bCopy.data(),
+      0,
+      loCopy.data(),
+      hiCopy.data(),
+      fIndexCopy.data(),
+      false));
+  EXPECT_EQ(numSteps - 1, solver.getNumWarmStarts());
+  EXPECT_TRUE(LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, COLORED_PGS_MATCHES_ACROSS_THREADS)
+{
+  // Lots of boxes, each resting on its four bottom corners. The boxes don't
+  // touch each other, so their rows of A don't couple.
+  const int numBoxes = 128;
+  const int rowsPerBox = 12;
+  const int n = numBoxes * rowsPerBox;
+  Eigen::Vector3s corners[4] = {Eigen::Vector3s(0.5, -0.5, 0.5),
+                                Eigen::Vector3s(-0.5, -0.5, 0.5),
+                                Eigen::Vector3s(0.5, -0.5, -0.5),
+                                Eigen::Vector3s(-0.5, -0.5, -0.5)};
+  Eigen::Vector3s dirs[3] = {Eigen::Vector3s::UnitY(),
+                             Eigen::Vector3s::UnitX(),
+                             Eigen::Vector3s::UnitZ()};
+  Eigen::MatrixXs J(rowsPerBox, 6);
+  for (int c = 0; c < 4; c++)
+  {
+    for (int d = 0; d < 3; d++)
+    {
+      J.block<1, 3>(3 * c + d, 0) = corners[c].cross(dirs[d]).transpose();
+      J.block<1, 3>(3 * c + d, 3) = dirs[d].transpose();
+    }
+  }
+  Eigen::VectorXs invMass = Eigen::VectorXs::Ones(6);
+  invMass.head<3>() *= 6;
+  Eigen::MatrixXs boxA = J * invMass.asDiagonal() * J.transpose();
+
+  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> A
+      = Eigen::MatrixXs::Zero(n, dPAD(n));
+  Eigen::VectorXs b(n);
+  Eigen::VectorXs lo(n);
+  Eigen::VectorXs hi(n);
+  Eigen::VectorXi fIndex(n);
+  std::vector<Eigen::VectorXs> boxVels;
+  for (int box = 0; box < numBoxes; box++)
+  {
+    const int offset = box * rowsPerBox;
+    A.block(offset, offset, rowsPerBox, rowsPerBox) = boxA;
+    Eigen::VectorXs vel = Eigen::VectorXs::Zero(6);
+    vel(4) = -0.1 * (1 + box % 5);
+    vel(3) = 0.01 * (box % 3);
+    boxVels.push_back(vel);
+    b.segment(offset, rowsPerBox) = -J * vel;
+    for (int c = 0; c < 4; c++)
+    {
+      const int row = offset + 3 * c;
+      lo.segment<3>(row) << 0, -0.5, -0.5;
+      hi.segment<3>(row) << std::numeric_limits<s_t>::infinity(), 0.5, 0.5;
+      fIndex.segment<3>(row) << -1, row, row;
+    }
+  }
+
+  ColoredPgsBoxedLcpSolver::Option option(200, 1e-10);
+  ColoredPgsBoxedLcpSolver serial(option);
+  option.mNumThreads = 4;
+  ColoredPgsBoxedLcpSolver parallel(option);
+
+  Eigen::VectorXs serialX = Eigen::VectorXs::Zero(n);
+  Eigen::VectorXs parallelX = Eigen::VectorXs::Zero(n);
+  for (ColoredPgsBoxedLcpSolver* solver : {&serial, &parallel})
+  {
+    Eigen::VectorXs& x = solver == &serial ? serialX : parallelX;
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ACopy
+        = A;
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    EXPECT_TRUE(solver->solve(
+        n,
+        ACopy.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    // Each box's four contacts all touch each other, and nothing else
+    EXPECT_EQ(4, solver->getLastNumColors());
+    EXPECT_LE(solver->getLastResidual(), 1e-10);
+    EXPECT_EQ(
+        solver->getLastNumIterations(),
+        (int)solver->getLastResidualHistory().size());
+  }
+
+  // Blocks of the same color are independent, so threading can't change the
+  // answer at all
+  EXPECT_EQ(serial.getLastNumIterations(), parallel.getLastNumIterations());
+  EXPECT_TRUE(serialX == parallelX);
+
+  // Every box should come to a stop against the ground
+  for (int box = 0; box < numBoxes; box++)
+  {
+    Eigen::VectorXs postVel
+        = boxVels[box]
+          + invMass.asDiagonal() * J.transpose()
+                * serialX.segment(box * rowsPerBox, rowsPerBox);
+    EXPECT_LT(postVel.norm(), 1e-6);
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, SMALL_SOLVER_FINDS_VALID_SOLUTIONS)
+{
+  // A box resting on its four bottom corners, so A is only semidefinite,
+  // pushed sideways by different amounts so that it sticks, or slides
+  const int n = 12;
+  Eigen::Vector3s corners[4] = {Eigen::Vector3s(0.5, -0.5, 0.5),
+                                Eigen::Vector3s(-0.5, -0.5, -0.5),
+                                Eigen::Vector3s(0.5, -0.5, -0.5),
+                                Eigen::Vector3s(-0.5, -0.5, 0.5)};
+  Eigen::Vector3s dirs[3] = {Eigen::Vector3s::UnitY(),
+                             Eigen::Vector3s::UnitX(),
+                             Eigen::Vector3s::UnitZ()};
+  Eigen::MatrixXs J(n, 6);
+  for (int c = 0; c < 4; c++)
+  {
+    for (int d = 0; d < 3; d++)
+    {
+      J.block<1, 3>(3 * c + d, 0) = corners[c].cross(dirs[d]).transpose();
+      J.block<1, 3>(3 * c + d, 3) = dirs[d].transpose();
+    }
+  }
+  Eigen::VectorXs invMass = Eigen::VectorXs::Ones(6);
+  invMass.head<3>() *= 6;
+  Eigen::MatrixXs A = J * invMass.asDiagonal() * J.transpose();
+
+  Eigen::VectorXs lo(n);
+  Eigen::VectorXs hi(n);
+  Eigen::VectorXi fIndex(n);
+  for (int c = 0; c < 4; c++)
+  {
+    const int row = 3 * c;
+    lo.segment<3>(row) << 0, -0.5, -0.5;
+    hi.segment<3>(row) << std::numeric_limits<s_t>::infinity(), 0.5, 0.5;
+    fIndex.segment<3>(row) << -1, row, row;
+  }
+
+  SmallBoxedLcpSolver solver;
+  for (s_t sideways : {0.0, 0.1, 0.2})
+  {
+    Eigen::VectorXs vel = Eigen::VectorXs::Zero(6);
+    vel(4) = -0.3;
+    vel(3) = sideways;
+    Eigen::VectorXs b = -J * vel;
+
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> APadded
+        = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    EXPECT_TRUE(solver.solve(
+        n,
+        APadded.data(),
+        x.data(),
+        bCopy.data(),
+        0,
+        loCopy.data(),
+        hiCopy.data(),
+        fIndexCopy.data(),
+        false));
+    EXPECT_TRUE(
+        LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+    EXPECT_LE(solver.getLastNumIterations(), solver.getOption().mMaxIteration);
+
+    // The box should never keep moving into the ground
+    Eigen::VectorXs postVel = vel + invMass.asDiagonal() * J.transpose() * x;
+    EXPECT_GE(postVel(4), -1e-9);
+  }
+
+  // Anything past the size limit is left for a general solver
+  const int bigN = SmallBoxedLcpSolver::getMaxDimension() + 1;
+  Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> bigA
+      = Eigen::MatrixXs::Identity(bigN, dPAD(bigN));
+  Eigen::VectorXs bigX = Eigen::VectorXs::Zero(bigN);
+  Eigen::VectorXs bigB = Eigen::VectorXs::Ones(bigN);
+  Eigen::VectorXs bigLo = Eigen::VectorXs::Zero(bigN);
+  Eigen::VectorXs bigHi = Eigen::VectorXs::Ones(bigN) * 10;
+  Eigen::VectorXi bigFIndex = Eigen::VectorXi::Ones(bigN) * -1;
+  EXPECT_FALSE(solver.solve(
+      bigN,
+      bigA.data(),
+      bigX.data(),
+      bigB.data(),
+      0,
+      bigLo.data(),
+      bigHi.data(),
+      bigFIndex.data(),
+      false));
+  EXPECT_TRUE(bigX.isZero());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(LCP_UTILS, ITERATIVE_REFINEMENT_REDUCES_RESIDUAL)
+{
+  // Three contacts, each with a normal row and two friction rows, on random
+  // but well conditioned dynamics
+  srand(42);
+  const int numContacts = 3;
+  const int n = 3 * numContacts;
+  Eigen::VectorXs lo(n);
+  Eigen::VectorXs hi(n);
+  Eigen::VectorXi fIndex(n);
+  for (int c = 0; c < numContacts; c++)
+  {
+    const int row = 3 * c;
+    lo.segment<3>(row) << 0, -0.5, -0.5;
+    hi.segment<3>(row) << std::numeric_limits<s_t>::infinity(), 0.5, 0.5;
+    fIndex.segment<3>(row) << -1, row, row;
+  }
+
+  DantzigBoxedLcpSolver solver;
+  solver.setWarmStartEnabled(false);
+  int numRefined = 0;
+  const int numTrials = 20;
+  for (int trial = 0; trial < numTrials; trial++)
+  {
+    Eigen::MatrixXs J = Eigen::MatrixXs::Random(n, n + 2);
+    Eigen::MatrixXs A
+        = J * J.transpose() + Eigen::MatrixXs::Identity(n, n) * n;
+    Eigen::VectorXs b = Eigen::VectorXs::Random(n) * 10;
+    for (int c = 0; c < numContacts; c++)
+    {
+      b(3 * c) = abs(b(3 * c));
+    }
+
+    Eigen::Matrix<s_t, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> APadded
+        = Eigen::MatrixXs::Zero(n, dPAD(n));
+    APadded.block(0, 0, n, n) = A;
+    Eigen::VectorXs bCopy = b;
+    Eigen::VectorXs loCopy = lo;
+    Eigen::VectorXs hiCopy = hi;
+    Eigen::VectorXi fIndexCopy = fIndex;
+    Eigen::VectorXs x = Eigen::VectorXs::Zero(n);
+    if (!solver.solve(
+            n,
+            APadded.data(),
+            x.data(),
+            bCopy.data(),
+            0,
+            loCopy.data(),
+            hiCopy.data(),
+            fIndexCopy.data(),
+            false))
+    {
+      continue;
+    }
+    // Pretend we got this from a sloppy solver
+    x += Eigen::VectorXs::Random(n) * 1e-7;
+
+    const Eigen::VectorXs original = x;
+    if (LCPUtils::refineSolution(A, x, b, hi, lo, fIndex))
+    {
+      numRefined++;
+      EXPECT_TRUE(
+          LCPUtils::isLCPSolutionValid(A, x, b, hi, lo, fIndex, false));
+      // Every clamping row should now be satisfied to round-off
+      Eigen::VectorXs w = A * x - b;
+      for (int i = 0; i < n; i++)
+      {
+        s_t bound = fIndex(i) == -1 ? 0 : hi(i) * x(fIndex(i));
+        if (abs(x(i)) > 1e-9 && abs(abs(x(i)) - bound) > 1e-9)
+        {
+          EXPECT_LT(abs(w(i)), 1e-12);
+        }
+      }
+    }
+    else
+    {
+      EXPECT_TRUE(original == x);
+    }
+  }
+  EXPECT_GT(numRefined, numTrials / 2);
+
+  // If the forces we take as clamping would end up outside their bounds, we
+  // can't refine the guess, so it gets left alone
+  Eigen::MatrixXs A = Eigen::MatrixXs::Identity(1, 1);
+  Eigen::VectorXs b = Eigen::VectorXs::Constant(1, 2);
+  Eigen::VectorXs x = Eigen::VectorXs::Constant(1, 2);
+  EXPECT_FALSE(LCPUtils::refineSolution(
+      A,
+      x,
+      b,
+      Eigen::VectorXs::Ones(1),
+      Eigen::VectorXs::Zero(1),
+      Eigen::VectorXi::Constant(1, -1)));
+  EXPECT_EQ(2, x(0));
+}
+#endif
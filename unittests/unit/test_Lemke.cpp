@@ -180,6 +180,73 @@ TEST(Lemke, Lemke_12D)
   EXPECT_TRUE(dart::lcpsolver::validate(A,(*f),b));
 }
 
+//==============================================================================
+TEST(Lemke, LemkeSolver_WarmStart)
+{
+  Eigen::MatrixXs A(4, 4);
+  A <<
+           3.999,0.9985, 1.001,    -2,
+          0.9985, 3.998,    -2,0.9995,
+           1.001,    -2, 4.002, 1.001,
+              -2,0.9995, 1.001, 4.001;
+  Eigen::VectorXs b(4);
+  b <<
+           -0.01008,
+          -0.009494,
+           -0.07234,
+           -0.07177;
+
+  dart::lcpsolver::LemkeSolver solver;
+  Eigen::VectorXs f;
+  EXPECT_EQ(solver.solve(A, b, &f), 0);
+  EXPECT_TRUE(dart::lcpsolver::validate(A, f, b));
+  EXPECT_GT(solver.getLastNumPivots(), 0);
+  EXPECT_EQ(solver.getNumWarmStarts(), 0u);
+
+  // The same answer as a cold start
+  Eigen::VectorXs coldF;
+  EXPECT_EQ(dart::lcpsolver::Lemke(A, b, &coldF), 0);
+  EXPECT_TRUE(f.isApprox(coldF));
+
+  // Nudging b doesn't change which constraints are active, so the last basis
+  // solves the new problem without any pivots
+  for (int i = 0; i < 5; i++)
+  {
+    b *= 1.01;
+    EXPECT_EQ(solver.solve(A, b, &f), 0);
+    EXPECT_TRUE(dart::lcpsolver::validate(A, f, b));
+    EXPECT_EQ(solver.getLastNumPivots(), 0);
+  }
+  EXPECT_EQ(solver.getNumWarmStarts(), 5u);
+
+  // Without warm starting, we pivot from scratch every time
+  solver.setWarmStartEnabled(false);
+  EXPECT_EQ(solver.solve(A, b, &f), 0);
+  EXPECT_TRUE(dart::lcpsolver::validate(A, f, b));
+  EXPECT_GT(solver.getLastNumPivots(), 0);
+  EXPECT_EQ(solver.getNumWarmStarts(), 5u);
+}
+
+//==============================================================================
+TEST(Lemke, LemkeSolver_SingularWarmStart)
+{
+  Eigen::MatrixXs A = 2 * Eigen::MatrixXs::Identity(3, 3);
+  Eigen::VectorXs b = -Eigen::VectorXs::Ones(3);
+
+  dart::lcpsolver::LemkeSolver solver;
+  Eigen::VectorXs f;
+  EXPECT_EQ(solver.solve(A, b, &f), 0);
+  EXPECT_TRUE(dart::lcpsolver::validate(A, f, b));
+
+  // Every z was basic, and the first two columns of this A are the same, so
+  // the last basis is singular here. We have to notice, and pivot from scratch.
+  A.setOnes();
+  A(2, 2) = 3;
+  EXPECT_EQ(solver.solve(A, b, &f), 0);
+  EXPECT_TRUE(dart::lcpsolver::validate(A, f, b));
+  EXPECT_EQ(solver.getNumWarmStarts(), 0u);
+}
+
 //==============================================================================
 int main(int argc, char* argv[])
 {
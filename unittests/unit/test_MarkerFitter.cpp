@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -23,6 +25,7 @@
 #include "dart/dynamics/BodyNode.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/IKSolver.hpp"
@@ -158,6 +161,23 @@ bool testFitterGradients(
     return false;
   }
 
+  Eigen::MatrixXs markerErrorJacWrtJoints_sparse
+      = fitter.getSparseMarkerErrorJacobianWrtJoints(
+          skel, markers, sparsityMap);
+  if (!equals(
+          markerErrorJacWrtJoints_sparse, markerErrorJacWrtJoints, THRESHOLD))
+  {
+    std::cout << "Error on sparse marker error jac wrt joints" << std::endl
+              << "Sparse:" << std::endl
+              << markerErrorJacWrtJoints_sparse << std::endl
+              << "Dense:" << std::endl
+              << markerErrorJacWrtJoints << std::endl
+              << "Diff:" << std::endl
+              << markerErrorJacWrtJoints_sparse - markerErrorJacWrtJoints
+              << std::endl;
+    return false;
+  }
+
   Eigen::MatrixXs gradWrtJointsJacWrtJoints
       = fitter.getIKLossGradientWrtJointsJacobianWrtJoints(
           skel,
@@ -255,6 +275,27 @@ bool testFitterGradients(
     return false;
   }
 
+  Eigen::MatrixXs markerErrorJacWrtMarkerOffsets_sparse
+      = fitter.getSparseMarkerErrorJacobianWrtMarkerOffsets(
+          skel, markers, sparsityMap);
+  if (!equals(
+          markerErrorJacWrtMarkerOffsets_sparse,
+          markerErrorJacWrtMarkerOffsets,
+          THRESHOLD))
+  {
+    std::cout << "Error on sparse marker error jac wrt marker offsets"
+              << std::endl
+              << "Sparse:" << std::endl
+              << markerErrorJacWrtMarkerOffsets_sparse << std::endl
+              << "Dense:" << std::endl
+              << markerErrorJacWrtMarkerOffsets << std::endl
+              << "Diff:" << std::endl
+              << markerErrorJacWrtMarkerOffsets_sparse
+                     - markerErrorJacWrtMarkerOffsets
+              << std::endl;
+    return false;
+  }
+
   Eigen::MatrixXs gradWrtJointsJacWrtMarkerOffsets
       = fitter.getIKLossGradientWrtJointsJacobianWrtMarkerOffsets(
           skel,
@@ -482,6 +523,36 @@ bool testBilevelFitProblemGradients(
     return false;
   }
 
+  // The sparse Jacobian we hand to IPOPT should match the dense one exactly,
+  // and every non-zero of the dense one should be in the sparsity pattern
+  Eigen::MatrixXs jac_sparse = problem.getSparseConstraintsJacobian(x);
+  if (!equals(jac_sparse, jac, 1e-12))
+  {
+    std::cout << "Error on BilevelFitProblem sparse constraint jac"
+              << std::endl
+              << "Diff:" << std::endl
+              << jac_sparse - jac << std::endl;
+    return false;
+  }
+  Eigen::MatrixXs pattern = Eigen::MatrixXs::Zero(jac.rows(), jac.cols());
+  for (auto entry : problem.getConstraintsJacobianSparsity())
+  {
+    pattern(entry.first, entry.second) += 1.0;
+  }
+  for (int row = 0; row < jac.rows(); row++)
+  {
+    for (int col = 0; col < jac.cols(); col++)
+    {
+      if (pattern(row, col) > 1.0
+          || (pattern(row, col) == 0.0 && jac(row, col) != 0.0))
+      {
+        std::cout << "Error on BilevelFitProblem constraint jac sparsity, at ("
+                  << row << ", " << col << ")" << std::endl;
+        return false;
+      }
+    }
+  }
+
   return true;
 }
 
@@ -3212,6 +3283,269 @@ TEST(MarkerFitter, AXIS_FIT_GRAD)
 }
 #endif
 
+#ifdef FUNCTIONAL_TESTS
+template <typename JointType>
+dynamics::BodyNode* addLeg(
+    std::shared_ptr<dynamics::Skeleton> skel,
+    dynamics::BodyNode* parent,
+    std::string name)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  pair.first->setName(name + "_joint");
+  pair.second->setName(name);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0, -0.4, 0.05);
+  pair.first->setTransformFromParentBodyNode(T);
+  return pair.second;
+}
+
+TEST(MarkerFitter, JOINT_FIT_SYNTHETIC_GRAD)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  dynamics::BodyNode* pelvis
+      = addLeg<dynamics::FreeJoint>(skel, nullptr, "pelvis");
+  dynamics::BodyNode* thigh
+      = addLeg<dynamics::BallJoint>(skel, pelvis, "thigh");
+  addLeg<dynamics::RevoluteJoint>(skel, thigh, "shank");
+
+  dynamics::MarkerMap markers;
+  markers["a"] = std::make_pair(pelvis, Eigen::Vector3s(0.1, 0.0, 0.05));
+  markers["b"] = std::make_pair(pelvis, Eigen::Vector3s(-0.1, -0.2, 0.0));
+  markers["c"] = std::make_pair(thigh, Eigen::Vector3s(0.05, -0.1, 0.1));
+  markers["d"] = std::make_pair(thigh, Eigen::Vector3s(-0.05, -0.3, -0.05));
+  markers["e"] = std::make_pair(thigh, Eigen::Vector3s(0.08, -0.2, -0.08));
+  MarkerFitter fitter(skel, markers);
+
+  // Swing the hip around, with some dropped markers and a clip boundary
+  srand(42);
+  const int timesteps = 40;
+  std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations;
+  std::vector<bool> newClip;
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(skel->getNumDofs(), timesteps);
+  for (int t = 0; t < timesteps; t++)
+  {
+    poses.block<3, 1>(0, t) = Eigen::Vector3s(0.1, 0.2, 0.05) * sin(t * 0.1);
+    poses(3, t) = 0.01 * t;
+    poses.block<3, 1>(6, t) = Eigen::Vector3s(
+        0.8 * sin(t * 0.3), 0.5 * cos(t * 0.2), 0.3 * sin(t * 0.5));
+    skel->setPositions(poses.col(t));
+    std::map<std::string, Eigen::Vector3s> observation;
+    for (auto& pair : markers)
+    {
+      if ((t + pair.first[0]) % 7 == 0)
+        continue;
+      observation[pair.first]
+          = pair.second.first->getWorldTransform() * pair.second.second
+            + Eigen::Vector3s::Random() * 0.002;
+    }
+    markerObservations.push_back(observation);
+    newClip.push_back(t == 20);
+  }
+  Eigen::MatrixXs ikPoses
+      = poses + Eigen::MatrixXs::Random(poses.rows(), timesteps) * 0.05;
+
+  for (int stride : {1, 3})
+  {
+    fitter.setJointFitFrameStride(stride);
+
+    Eigen::MatrixXs centers = Eigen::MatrixXs::Zero(3, timesteps);
+    SphereFitJointCenterProblem sphereProblem(
+        &fitter,
+        markerObservations,
+        ikPoses,
+        skel->getJoint("thigh_joint"),
+        newClip,
+        centers);
+    Eigen::VectorXs analytical = sphereProblem.getGradient();
+    Eigen::VectorXs bruteForce = sphereProblem.finiteDifferenceGradient();
+    EXPECT_TRUE(equals(analytical, bruteForce, 1e-8));
+
+    Eigen::MatrixXs axis = Eigen::MatrixXs::Zero(6, timesteps);
+    CylinderFitJointAxisProblem cylinderProblem(
+        &fitter,
+        markerObservations,
+        ikPoses,
+        skel->getJoint("shank_joint"),
+        Eigen::MatrixXs::Random(3, timesteps),
+        newClip,
+        axis);
+    analytical = cylinderProblem.getGradient();
+    bruteForce = cylinderProblem.finiteDifferenceGradient();
+    EXPECT_TRUE(equals(analytical, bruteForce, 1e-7));
+  }
+}
+#endif
+
+#ifdef FUNCTIONAL_TESTS
+TEST(MarkerFitter, JOINT_FIT_GAUSS_NEWTON)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  dynamics::BodyNode* pelvis
+      = addLeg<dynamics::FreeJoint>(skel, nullptr, "pelvis");
+  dynamics::BodyNode* thigh
+      = addLeg<dynamics::BallJoint>(skel, pelvis, "thigh");
+
+  dynamics::MarkerMap markers;
+  markers["a"] = std::make_pair(pelvis, Eigen::Vector3s(0.1, 0.0, 0.05));
+  markers["b"] = std::make_pair(pelvis, Eigen::Vector3s(-0.1, -0.2, 0.0));
+  markers["c"] = std::make_pair(thigh, Eigen::Vector3s(0.05, -0.1, 0.1));
+  markers["d"] = std::make_pair(thigh, Eigen::Vector3s(-0.05, -0.3, -0.05));
+  MarkerFitter fitter(skel, markers);
+
+  srand(42);
+  const int timesteps = 30;
+  std::vector<std::map<std::string, Eigen::Vector3s>> markerObservations;
+  std::vector<bool> newClip;
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(skel->getNumDofs(), timesteps);
+  for (int t = 0; t < timesteps; t++)
+  {
+    poses.block<3, 1>(0, t) = Eigen::Vector3s(0.1, 0.2, 0.05) * sin(t * 0.1);
+    poses.block<3, 1>(6, t) = Eigen::Vector3s(
+        0.8 * sin(t * 0.3), 0.5 * cos(t * 0.2), 0.3 * sin(t * 0.5));
+    skel->setPositions(poses.col(t));
+    std::map<std::string, Eigen::Vector3s> observation;
+    for (auto& pair : markers)
+    {
+      observation[pair.first]
+          = pair.second.first->getWorldTransform() * pair.second.second
+            + Eigen::Vector3s::Random() * 0.002;
+    }
+    markerObservations.push_back(observation);
+    newClip.push_back(false);
+  }
+  Eigen::MatrixXs ikPoses
+      = poses + Eigen::MatrixXs::Random(poses.rows(), timesteps) * 0.05;
+
+  std::vector<s_t> losses;
+  for (bool useGaussNewton : {false, true})
+  {
+    fitter.setJointFitUseGaussNewton(useGaussNewton);
+    Eigen::MatrixXs centers = Eigen::MatrixXs::Zero(3, timesteps);
+    std::shared_ptr<SphereFitJointCenterProblem> problem
+        = std::make_shared<SphereFitJointCenterProblem>(
+            &fitter,
+            markerObservations,
+            ikPoses,
+            skel->getJoint("thigh_joint"),
+            newClip,
+            centers);
+    if (useGaussNewton)
+    {
+      // A single undamped step shouldn't be worse than where we started
+      s_t startLoss = problem->getLoss();
+      Eigen::VectorXs x = problem->flatten();
+      problem->unflatten(x + problem->getGaussNewtonStep(1e-6));
+      EXPECT_LE(problem->getLoss(), startLoss);
+      problem->unflatten(x);
+    }
+    fitter.findJointCenter(problem);
+    losses.push_back(problem->getLoss());
+  }
+
+  // Gauss-Newton should land at least as low as SGD
+  EXPECT_LE(losses[1], losses[0] * (1.0 + 1e-3) + 1e-10);
+}
+#endif
+
+#ifdef FUNCTIONAL_TESTS
+TEST(MarkerFitter, PICK_INFORMATIVE_TIMESTEPS)
+{
+  // Ten copies each of three distinct poses, shuffled together
+  Eigen::MatrixXs distinct = Eigen::MatrixXs::Zero(2, 3);
+  distinct.col(1) = Eigen::Vector2s(1.0, 0.0);
+  distinct.col(2) = Eigen::Vector2s(0.0, 1.0);
+  Eigen::MatrixXs poses = Eigen::MatrixXs::Zero(2, 30);
+  for (int t = 0; t < 30; t++)
+  {
+    poses.col(t) = distinct.col((t * 7) % 3);
+  }
+
+  // Three picks should cover all three poses, rather than duplicating any
+  std::vector<int> picked = MarkerFitter::pickInformativeTimesteps(poses, 3);
+  ASSERT_EQ(picked.size(), 3);
+  std::set<int> covered;
+  for (int t : picked)
+  {
+    covered.insert((t * 7) % 3);
+  }
+  EXPECT_EQ(covered.size(), 3);
+  EXPECT_TRUE(std::is_sorted(picked.begin(), picked.end()));
+
+  // Growing the set never returns timesteps we already have
+  std::vector<int> added
+      = MarkerFitter::pickInformativeTimesteps(poses, 27, picked);
+  EXPECT_EQ(added.size(), 27);
+  std::set<int> all(picked.begin(), picked.end());
+  all.insert(added.begin(), added.end());
+  EXPECT_EQ(all.size(), 30);
+
+  // We can't pick more timesteps than there are
+  added = MarkerFitter::pickInformativeTimesteps(
+      poses, 10, std::vector<int>(all.begin(), all.end()));
+  EXPECT_EQ(added.size(), 0);
+}
+#endif
+
+#ifdef FUNCTIONAL_TESTS
+TEST(MarkerFitter, MARKER_EVALUATION_CACHE_TRACKS_SKELETON)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  dynamics::BodyNode* pelvis
+      = addLeg<dynamics::FreeJoint>(skel, nullptr, "pelvis");
+  dynamics::BodyNode* thigh
+      = addLeg<dynamics::BallJoint>(skel, pelvis, "thigh");
+
+  dynamics::MarkerMap markerMap;
+  markerMap["a"] = std::make_pair(pelvis, Eigen::Vector3s(0.1, 0.0, 0.05));
+  markerMap["b"] = std::make_pair(thigh, Eigen::Vector3s(0.05, -0.1, 0.1));
+  MarkerFitter fitter(skel, markerMap);
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  std::vector<std::pair<int, Eigen::Vector3s>> observed;
+  for (auto& pair : markerMap)
+  {
+    observed.emplace_back(markers.size(), Eigen::Vector3s::Random());
+    markers.push_back(pair.second);
+  }
+  Eigen::VectorXs goal = Eigen::VectorXs::Zero(markers.size() * 3);
+  for (auto& pair : observed)
+  {
+    goal.segment<3>(pair.first * 3) = pair.second;
+  }
+
+  // Every evaluation has to match a fresh one, even though the loss and the
+  // gradient at the same point share their kinematics
+  for (int i = 0; i < 3; i++)
+  {
+    std::size_t version = skel->getKinematicsVersion();
+    if (i == 1)
+    {
+      skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+    }
+    else if (i == 2)
+    {
+      skel->setGroupScales(
+          Eigen::VectorXs::Ones(skel->getGroupScaleDim()) * 1.1);
+    }
+    if (i > 0)
+    {
+      EXPECT_NE(version, skel->getKinematicsVersion());
+    }
+
+    Eigen::VectorXs error = fitter.getMarkerError(skel, markers, observed);
+    Eigen::VectorXs expectedError
+        = skel->getMarkerWorldPositions(markers) - goal;
+    EXPECT_TRUE(equals(error, expectedError, 1e-12));
+    Eigen::VectorXs grad
+        = fitter.getMarkerLossGradientWrtJoints(skel, markers, error);
+    Eigen::VectorXs expected
+        = skel->getMarkerWorldPositionsJacobianWrtJointPositions(markers)
+              .transpose()
+          * error;
+    EXPECT_TRUE(equals(grad, expected, 1e-12));
+  }
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(MarkerFitter, FULL_KINEMATIC_STACK)
 {
@@ -7581,4 +7915,119 @@ TEST(MarkerFitter, EVAL_PERFORMANCE)
             << groupScaleCols << std::endl;
 }
 #endif
+
+#ifdef ALL_TESTS
+TEST(MarkerFitter, GROUP_SCALE_JACOBIANS_MATCH_BODY_SCALES)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+  osim->autogroupSymmetricSuffixes();
+
+  srand(42);
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (int i = 0; i < osim->getNumBodyNodes(); i++)
+  {
+    markers.emplace_back(osim->getBodyNode(i), Eigen::Vector3s::Random());
+  }
+  std::vector<dynamics::Joint*> joints;
+  for (int i = 0; i < osim->getNumJoints(); i++)
+  {
+    joints.push_back(osim->getJoint(i));
+  }
+
+  for (int trial = 0; trial < 5; trial++)
+  {
+    osim->setPositions(osim->getRandomPose());
+    osim->setGroupScales(
+        Eigen::VectorXs::Ones(osim->getGroupScaleDim())
+        + 0.1 * Eigen::VectorXs::Random(osim->getGroupScaleDim()));
+
+    Eigen::MatrixXs markerJac
+        = osim->getMarkerWorldPositionsJacobianWrtGroupScales(markers);
+    Eigen::MatrixXs markerJacFromBodies
+        = osim->convertBodyScalesJacobianToGroupScales(
+            osim->getMarkerWorldPositionsJacobianWrtBodyScales(markers));
+    EXPECT_TRUE(equals(markerJac, markerJacFromBodies, 1e-12));
+
+    Eigen::MatrixXs jointJac
+        = osim->getJointWorldPositionsJacobianWrtGroupScales(joints);
+    Eigen::MatrixXs jointJacFromBodies
+        = osim->convertBodyScalesJacobianToGroupScales(
+            osim->getJointWorldPositionsJacobianWrtBodyScales(joints));
+    EXPECT_TRUE(equals(jointJac, jointJacFromBodies, 1e-12));
+
+    Eigen::MatrixXs bodyMovement
+        = osim->getGroupScaleMovementOnBodiesInWorldSpace();
+    Eigen::MatrixXs jointMovement
+        = osim->getGroupScaleMovementOnJointsInWorldSpace();
+    for (int col = 0; col < osim->getGroupScaleDim(); col++)
+    {
+      for (int i = 0; i < osim->getNumBodyNodes(); i++)
+      {
+        Eigen::Vector3s expected
+            = osim->getGroupScaleMovementOnBodyInWorldSpace(col, i);
+        EXPECT_TRUE(equals(
+            Eigen::Vector3s(bodyMovement.block<3, 1>(i * 3, col)),
+            expected,
+            1e-12));
+      }
+      for (int i = 0; i < osim->getNumJoints(); i++)
+      {
+        Eigen::Vector3s expected
+            = osim->getGroupScaleMovementOnJointInWorldSpace(col, i);
+        EXPECT_TRUE(equals(
+            Eigen::Vector3s(jointMovement.block<3, 1>(i * 3, col)),
+            expected,
+            1e-12));
+      }
+    }
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(MarkerFitter, MARKER_JACOBIAN_SHARES_BODY_SCREWS)
+{
+  std::shared_ptr<dynamics::Skeleton> osim
+      = OpenSimParser::parseOsim(
+            "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim")
+            .skeleton;
+
+  // Put several markers on every body, in a shuffled order, so markers that
+  // share a body aren't next to each other
+  srand(42);
+  std::vector<std::pair<dynamics::BodyNode*, Eigen::Vector3s>> markers;
+  for (int copy = 0; copy < 3; copy++)
+  {
+    for (int i = osim->getNumBodyNodes() - 1; i >= 0; i--)
+    {
+      markers.emplace_back(osim->getBodyNode(i), Eigen::Vector3s::Random());
+    }
+  }
+
+  for (int trial = 0; trial < 5; trial++)
+  {
+    osim->setPositions(osim->getRandomPose());
+    osim->setBodyScales(
+        Eigen::VectorXs::Ones(osim->getNumBodyNodes() * 3)
+        + 0.1 * Eigen::VectorXs::Random(osim->getNumBodyNodes() * 3));
+
+    Eigen::MatrixXs jac
+        = osim->getMarkerWorldPositionsJacobianWrtJointPositions(markers);
+    for (int i = 0; i < markers.size(); i++)
+    {
+      math::Jacobian bodyJac = osim->getWorldPositionJacobian(
+          markers[i].first,
+          markers[i].first->getScale().cwiseProduct(markers[i].second));
+      Eigen::MatrixXs expected = bodyJac.block(3, 0, 3, bodyJac.cols());
+      EXPECT_TRUE(equals(
+          Eigen::MatrixXs(jac.block(i * 3, 0, 3, jac.cols())),
+          expected,
+          1e-12));
+    }
+  }
+}
+#endif
 // #endif
\ No newline at end of file
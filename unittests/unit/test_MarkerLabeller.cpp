@@ -67,4 +67,84 @@ TEST(LABELLER, RECREATE_LABELS)
 
   labeller.evaluate(markerStringMap, markersOverTime);
 }
-#endif
\ No newline at end of file
+#endif
+#ifdef ALL_TESTS
+TEST(LABELLER, STREAMING_LABELS)
+{
+  OpenSimFile scaled = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/Rajagopal_scaled.osim");
+  OpenSimMot mot = OpenSimParser::loadMot(
+      scaled.skeleton,
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "S01DN603_ik.mot");
+  Eigen::MatrixXs poses = mot.poses;
+
+  std::vector<std::vector<std::string>> namesOverTime;
+  std::vector<std::vector<Eigen::Vector3s>> pointClouds;
+  std::vector<std::map<std::string, Eigen::Vector3s>> jointsOverTime;
+
+  const int numFrames = 100;
+  for (int i = 0; i < numFrames; i++)
+  {
+    scaled.skeleton->setPositions(poses.col(i));
+    namesOverTime.emplace_back();
+    pointClouds.emplace_back();
+    for (auto& pair :
+         scaled.skeleton->getMarkerMapWorldPositions(scaled.markersMap))
+    {
+      namesOverTime.back().push_back(pair.first);
+      pointClouds.back().push_back(pair.second);
+    }
+    jointsOverTime.push_back(scaled.skeleton->getJointWorldPositionsMap());
+  }
+
+  biomechanics::MarkerLabellerMock labeller
+      = biomechanics::MarkerLabellerMock();
+  labeller.setSkeleton(scaled.skeleton);
+  for (int i = 0; i < scaled.skeleton->getNumJoints(); i++)
+  {
+    std::string jointName = scaled.skeleton->getJoint(i)->getName();
+    labeller.matchUpJointToSkeletonJoint(jointName, jointName);
+  }
+  labeller.setMockJointLocations(jointsOverTime);
+
+  const int latency = 10;
+  const int lookback = 30;
+  biomechanics::StreamingMarkerLabeller stream(labeller, latency, lookback);
+
+  std::vector<std::map<std::string, Eigen::Vector3s>> labelled;
+  for (int i = 0; i < numFrames; i++)
+  {
+    std::vector<std::map<std::string, Eigen::Vector3s>> frames
+        = stream.pushFrame(pointClouds[i]);
+    // Labels come out a fixed number of frames after they go in
+    EXPECT_EQ(frames.size(), i < latency ? 0 : 1);
+    labelled.insert(labelled.end(), frames.begin(), frames.end());
+    EXPECT_LE(stream.getNumBufferedFrames(), lookback);
+  }
+  std::vector<std::map<std::string, Eigen::Vector3s>> rest = stream.flush();
+  labelled.insert(labelled.end(), rest.begin(), rest.end());
+  EXPECT_EQ(labelled.size(), numFrames);
+
+  // No markers drop out, so every point should keep the same label the whole
+  // way through
+  std::map<std::string, std::string> labelForMarker;
+  for (int t = 0; t < numFrames; t++)
+  {
+    EXPECT_EQ(labelled[t].size(), pointClouds[t].size());
+    for (auto& pair : labelled[t])
+    {
+      for (int i = 0; i < pointClouds[t].size(); i++)
+      {
+        if (pointClouds[t][i] != pair.second)
+          continue;
+        const std::string& name = namesOverTime[t][i];
+        if (labelForMarker.count(name) == 0)
+          labelForMarker[name] = pair.first;
+        EXPECT_EQ(labelForMarker[name], pair.first);
+      }
+    }
+  }
+  EXPECT_EQ(stream.getMarkerOffsets().size(), labelForMarker.size());
+}
+#endif
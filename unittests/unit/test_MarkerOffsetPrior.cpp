@@ -1,4 +1,5 @@
 #include <algorithm> // std::sort
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -41,4 +42,48 @@ TEST(MARKER_PRIOR, BASIC_GUI)
   prior.debugToGUI(server);
   server->blockWhileServing();
 }
-#endif
\ No newline at end of file
+#endif
+
+#ifdef ALL_TESTS
+TEST(MARKER_PRIOR, NEAREST_PRIOR_MARKER)
+{
+  OpenSimFile standard = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015_v3_scaled/"
+      "Rajagopal2015_passiveCal_hipAbdMoved.osim");
+
+  MarkerOffsetPrior prior(standard.skeleton, standard.markersMap);
+
+  srand(42);
+  for (int i = 0; i < standard.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = standard.skeleton->getBodyNode(i);
+    for (int q = 0; q < 20; q++)
+    {
+      Eigen::Vector3s query = Eigen::Vector3s::Random() * 0.2;
+
+      // Check against a brute force scan over the markers on this body
+      std::string expectedName = "";
+      s_t expectedDist = std::numeric_limits<s_t>::infinity();
+      for (auto& pair : standard.markersMap)
+      {
+        if (pair.second.first != body)
+          continue;
+        s_t dist = (pair.second.second - query).norm();
+        if (dist < expectedDist)
+        {
+          expectedDist = dist;
+          expectedName = pair.first;
+        }
+      }
+
+      std::pair<std::string, s_t> nearest
+          = prior.getNearestPriorMarker(body, query);
+      EXPECT_EQ(expectedName, nearest.first);
+      if (expectedName != "")
+      {
+        EXPECT_NEAR(expectedDist, nearest.second, 1e-12);
+      }
+    }
+  }
+}
+#endif
@@ -1,4 +1,5 @@
 #include <algorithm> // std::sort
+#include <random>
 #include <vector>
 
 #include <Eigen/Dense>
@@ -62,6 +63,47 @@ TEST(LABELLER, MAKE_TRACES_MULTIPLE)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(LABELLER, MAKE_TRACES_MANY_MARKERS)
+{
+  // A big grid of markers all drifting the same way, listed in a different
+  // order every frame, so traces have to be matched by position
+  const int numMarkers = 150;
+  const int numFrames = 200;
+  std::vector<std::vector<Eigen::Vector3s>> rawPoints;
+  std::vector<int> order;
+  for (int m = 0; m < numMarkers; m++)
+  {
+    order.push_back(m);
+  }
+  std::mt19937 rng(42);
+  for (int t = 0; t < numFrames; t++)
+  {
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<Eigen::Vector3s> pointCloud;
+    for (int m : order)
+    {
+      pointCloud.push_back(Eigen::Vector3s(
+          (m % 10) * 0.05, (m / 10) * 0.05 + t * 0.002, 0.001 * t));
+    }
+    rawPoints.push_back(pointCloud);
+  }
+
+  std::vector<biomechanics::MarkerTrace> traces
+      = biomechanics::MarkerTrace::createRawTraces(rawPoints);
+
+  ASSERT_EQ(traces.size(), numMarkers);
+  for (auto& trace : traces)
+  {
+    EXPECT_EQ(trace.mPoints.size(), numFrames);
+    for (int i = 1; i < trace.mPoints.size(); i++)
+    {
+      EXPECT_DOUBLE_EQ(trace.mPoints[i](0), trace.mPoints[0](0));
+    }
+  }
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(LABELLER, TRACE_VARIANCE)
 {
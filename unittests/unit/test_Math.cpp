@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <iostream>
 
 #include <gtest/gtest.h>
@@ -37,8 +38,10 @@
 #include "dart/common/Timer.hpp"
 #include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/math/FiniteDifference.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/math/Helpers.hpp"
+#include "dart/math/IKSolver.hpp"
 #include "dart/simulation/World.hpp"
 
 #include "TestHelpers.hpp"
@@ -1439,3 +1442,136 @@ TEST(MATH, PerformanceComparisonOfAdTJac)
   // Note: The best function for dynamic size Jacobian is AdTJac2, and the best
   //       function for fixed size Jacobian is AdTJac3
 }
+
+//==============================================================================
+// This is x^2 = 4 in one variable. Starting from x = 0 the Jacobian is zero,
+// so only the random restarts can find either root.
+IKCallbacks createSquareRootIKCallbacks(
+    std::shared_ptr<Eigen::VectorXs> state, std::atomic<int>& restartCount)
+{
+  IKCallbacks callbacks;
+  callbacks.setPosAndClamp = [state](const Eigen::VectorXs& pos, bool clamp) {
+    *state = pos;
+    if (clamp)
+    {
+      (*state)(0) = std::max((s_t)-5, std::min((s_t)5, (*state)(0)));
+    }
+    return *state;
+  };
+  callbacks.eval = [state](
+                       Eigen::Ref<Eigen::VectorXs> diff,
+                       Eigen::Ref<Eigen::MatrixXs> jac) {
+    diff(0) = (*state)(0) * (*state)(0) - 4;
+    jac(0, 0) = 2 * (*state)(0);
+  };
+  callbacks.getRandomRestart
+      = [&restartCount](Eigen::Ref<Eigen::VectorXs> pos) {
+          restartCount++;
+          pos = Eigen::VectorXs::Random(1) * 5;
+        };
+  return callbacks;
+}
+
+//==============================================================================
+TEST(MATH, PARALLEL_IK_RESTARTS)
+{
+  std::atomic<int> restartCount(0);
+  std::vector<std::shared_ptr<Eigen::VectorXs>> states;
+  auto createCallbacks = [&](int worker) {
+    EXPECT_EQ(worker, states.size());
+    states.push_back(std::make_shared<Eigen::VectorXs>(Eigen::VectorXs(1)));
+    return createSquareRootIKCallbacks(states.back(), restartCount);
+  };
+
+  const int maxRestarts = 50;
+  s_t loss = solveIKParallel(
+      Eigen::VectorXs::Zero(1),
+      Eigen::VectorXs::Ones(1) * 5,
+      Eigen::VectorXs::Ones(1) * -5,
+      1,
+      createCallbacks,
+      4,
+      IKConfig()
+          .setMaxRestarts(maxRestarts)
+          .setLossLowerBound(1e-8)
+          .setStartClamped(true));
+
+  EXPECT_EQ(4, states.size());
+  EXPECT_LE(loss, 1e-8);
+  // The final refinement leaves worker 0 posed at one of the roots
+  EXPECT_NEAR(2.0, std::abs((*states[0])(0)), 1e-4);
+  // Once a restart hits the lower bound, the others get cancelled rather than
+  // all running to completion
+  EXPECT_LT(restartCount.load(), maxRestarts - 1);
+}
+
+//==============================================================================
+/// Makes getPerturbed functions that each perturb their own copy of some
+/// state, the way callers perturbing a cloned World do
+struct PerturbedStateFactory
+{
+  std::function<bool(s_t, int, Eigen::VectorXs&)> operator()()
+  {
+    auto state = std::make_shared<Eigen::VectorXs>(x);
+    return [this, state](s_t eps, int dof, Eigen::VectorXs& perturbed) {
+      *state = x;
+      (*state)(dof) += eps;
+      perturbed = Eigen::VectorXs(3);
+      perturbed(0) = sin((*state)(0)) * (*state)(1);
+      perturbed(1) = exp((*state)(1) * (*state)(2));
+      perturbed(2) = (*state).squaredNorm();
+      return !rejectLargeSteps || abs(eps) < 1e-5;
+    };
+  }
+
+  Eigen::VectorXs x = Eigen::Vector4s(0.3, -0.2, 0.7, 1.1);
+  bool rejectLargeSteps = false;
+};
+
+//==============================================================================
+TEST(MATH, PARALLEL_FINITE_DIFFERENCE)
+{
+  PerturbedStateFactory factory;
+
+  for (bool useRidders : {false, true})
+  {
+    const s_t eps = useRidders ? 1e-4 : 1e-7;
+    Eigen::MatrixXs serial(3, 4);
+    finiteDifference(factory(), serial, eps, useRidders);
+
+    for (int numThreads : {1, 2, 3, 4, 8})
+    {
+      Eigen::MatrixXs parallel(3, 4);
+      parallelFiniteDifference(
+          std::ref(factory), parallel, eps, useRidders, numThreads);
+      EXPECT_TRUE(parallel == serial);
+    }
+  }
+
+  // Central differences shrink rejected steps per column, so this matches too
+  factory.rejectLargeSteps = true;
+  Eigen::MatrixXs serial(3, 4);
+  finiteDifference(factory(), serial, 1e-4, false);
+  Eigen::MatrixXs parallel(3, 4);
+  parallelFiniteDifference(std::ref(factory), parallel, 1e-4, false, 4);
+  EXPECT_TRUE(parallel == serial);
+}
+
+//==============================================================================
+TEST(MATH, PARALLEL_FINITE_DIFFERENCE_RETHROWS)
+{
+  Eigen::MatrixXs result(1, 8);
+  EXPECT_THROW(
+      parallelFiniteDifference(
+          []() {
+            return [](s_t /*eps*/, int dof, Eigen::VectorXs& perturbed) {
+              perturbed = Eigen::VectorXs::Zero(1);
+              return dof != 5;
+            };
+          },
+          result,
+          1e-7,
+          false,
+          4),
+      non_differentiable_point_exception);
+}
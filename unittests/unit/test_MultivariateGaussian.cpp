@@ -170,4 +170,99 @@ TEST(MultivariateGaussian, OBSERVE)
   EXPECT_EQ(conditioned->getCov().rows(), conditioned->getMu().size());
 
   conditioned->debugToStdout();
-}
\ No newline at end of file
+}
+//==============================================================================
+TEST(MultivariateGaussian, BATCH_MATCHES_EXPLICIT_INVERSE)
+{
+  srand(42);
+  const int n = 6;
+  std::vector<std::string> names;
+  for (int i = 0; i < n; i++)
+  {
+    names.push_back("var" + std::to_string(i));
+  }
+  Eigen::MatrixXs A = Eigen::MatrixXs::Random(n, n);
+  Eigen::MatrixXs cov
+      = A * A.transpose() + Eigen::MatrixXs::Identity(n, n) * 0.1;
+  Eigen::VectorXs mu = Eigen::VectorXs::Random(n);
+  MultivariateGaussian gauss(names, mu, cov);
+
+  s_t logDet = log(cov.determinant());
+  EXPECT_NEAR(gauss.getLogDeterminant(), logDet, 1e-10);
+  s_t logNormalization = -0.5 * logDet - 0.5 * n * log(2 * M_PI);
+  EXPECT_NEAR(gauss.getLogNormalizationConstant(), logNormalization, 1e-10);
+
+  Eigen::MatrixXs covInv = cov.inverse();
+  Eigen::MatrixXs xs = Eigen::MatrixXs::Random(n, 10);
+  Eigen::VectorXs logPDFs = gauss.computeLogPDFBatch(xs);
+  Eigen::VectorXs unnormalizedLogPDFs = gauss.computeLogPDFBatch(xs, false);
+  Eigen::MatrixXs grads = gauss.computeLogPDFGradBatch(xs);
+  for (int i = 0; i < xs.cols(); i++)
+  {
+    Eigen::VectorXs diff = xs.col(i) - mu;
+    s_t expected = logNormalization - 0.5 * diff.dot(covInv * diff);
+    EXPECT_NEAR(gauss.computeLogPDF(xs.col(i)), expected, 1e-9);
+    EXPECT_NEAR(logPDFs(i), expected, 1e-9);
+    EXPECT_NEAR(unnormalizedLogPDFs(i), expected - logNormalization, 1e-9);
+
+    Eigen::VectorXs expectedGrad = -covInv * diff;
+    Eigen::VectorXs grad = grads.col(i);
+    EXPECT_TRUE(equals(grad, expectedGrad, 1e-9));
+    EXPECT_TRUE(equals(gauss.computeLogPDFGrad(xs.col(i)), expectedGrad, 1e-9));
+  }
+}
+
+//==============================================================================
+TEST(MultivariateGaussian, CACHED_CONDITIONING_MATCHES_FRESH)
+{
+  srand(42);
+  const int n = 6;
+  std::vector<std::string> names;
+  for (int i = 0; i < n; i++)
+  {
+    names.push_back("var" + std::to_string(i));
+  }
+  Eigen::MatrixXs A = Eigen::MatrixXs::Random(n, n);
+  Eigen::MatrixXs cov
+      = A * A.transpose() + Eigen::MatrixXs::Identity(n, n) * 0.1;
+  Eigen::VectorXs mu = Eigen::VectorXs::Random(n);
+  MultivariateGaussian gauss(names, mu, cov);
+
+  std::vector<int> observed = {1, 4};
+  std::vector<int> unobserved = {0, 2, 3, 5};
+  Eigen::MatrixXs cov_12 = gauss.getCovSubset(unobserved, observed);
+  Eigen::MatrixXs cov_22_inv = gauss.getCovSubset(observed, observed).inverse();
+  Eigen::MatrixXs expectedCov = gauss.getCovSubset(unobserved, unobserved)
+                                - cov_12 * cov_22_inv * cov_12.transpose();
+
+  // Condition on the same variables several times with different values, so
+  // that all but the first call hit the cache
+  for (int trial = 0; trial < 3; trial++)
+  {
+    std::map<std::string, s_t> observedValues;
+    Eigen::VectorXs x = Eigen::VectorXs::Random(observed.size());
+    for (int i = 0; i < observed.size(); i++)
+    {
+      observedValues[names[observed[i]]] = x(i);
+    }
+    Eigen::VectorXs expectedMu
+        = gauss.getMuSubset(unobserved)
+          + cov_12 * cov_22_inv * (x - gauss.getMuSubset(observed));
+    MultivariateGaussian expected(
+        gauss.condition(observedValues)->getVariableNames(),
+        expectedMu,
+        expectedCov);
+
+    std::shared_ptr<MultivariateGaussian> conditioned
+        = gauss.condition(observedValues);
+    EXPECT_TRUE(equals(conditioned->getMu(), expectedMu, 1e-9));
+    EXPECT_TRUE(equals(conditioned->getCov(), expectedCov, 1e-9));
+    EXPECT_NEAR(
+        conditioned->getLogNormalizationConstant(),
+        expected.getLogNormalizationConstant(),
+        1e-9);
+    Eigen::VectorXs y = Eigen::VectorXs::Random(unobserved.size());
+    EXPECT_NEAR(
+        conditioned->computeLogPDF(y), expected.computeLogPDF(y), 1e-9);
+  }
+}
@@ -1,4 +1,6 @@
+#include <functional>
 #include <memory>
+#include <set>
 #include <utility>
 
 #include <gtest/gtest.h>
@@ -8,10 +10,12 @@
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
 #include "dart/dynamics/EulerFreeJoint.hpp"
+#include "dart/dynamics/MeshShape.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/MathTypes.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
+#include "dart/utils/DartResourceRetriever.hpp"
 #include "dart/utils/MJCFExporter.hpp"
 #include "dart/utils/sdf/SdfParser.hpp"
 #include "dart/utils/urdf/DartLoader.hpp"
@@ -45,6 +49,271 @@ TEST(OpenSimParser, LOAD_FBLS_MODEL)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(OpenSimParser, PARSED_MODEL_CACHE)
+{
+  OpenSimParser::clearParsedModelCache();
+  auto original = OpenSimParser::parseOsim(
+      "dart://sample/osim/MichaelTest/results/Models/autoscaled.osim");
+  auto cached = OpenSimParser::parseOsim(
+      "dart://sample/osim/MichaelTest/results/Models/autoscaled.osim");
+
+  EXPECT_NE(original.skeleton, cached.skeleton);
+  EXPECT_EQ(original.skeleton->getNumDofs(), cached.skeleton->getNumDofs());
+  EXPECT_EQ(
+      original.skeleton->getNumBodyNodes(),
+      cached.skeleton->getNumBodyNodes());
+  EXPECT_TRUE(equals(
+      original.skeleton->getPositions(), cached.skeleton->getPositions()));
+  EXPECT_EQ(original.markersMap.size(), cached.markersMap.size());
+  for (auto& pair : cached.markersMap)
+  {
+    EXPECT_EQ(cached.skeleton.get(), pair.second.first->getSkeleton().get());
+    EXPECT_TRUE(
+        equals(original.markersMap[pair.first].second, pair.second.second));
+  }
+
+  // Scaling the clone shouldn't touch the shapes of any other copy
+  Eigen::VectorXs scales = cached.skeleton->getBodyScales();
+  cached.skeleton->setBodyScales(scales * 1.1);
+  auto again = OpenSimParser::parseOsim(
+      "dart://sample/osim/MichaelTest/results/Models/autoscaled.osim");
+  for (int i = 0; i < again.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = again.skeleton->getBodyNode(i);
+    dynamics::BodyNode* originalBody = original.skeleton->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      EXPECT_TRUE(equals(
+          body->getShapeNode(j)->getShape()->getBoundingBox().getMax(),
+          originalBody->getShapeNode(j)->getShape()->getBoundingBox().getMax(),
+          1e-12));
+    }
+  }
+}
+#endif
+
+#ifdef ALL_TESTS
+dynamics::MeshShape* getFirstMeshShape(dynamics::SkeletonPtr skel)
+{
+  for (int i = 0; i < skel->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = skel->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      auto* mesh = dynamic_cast<dynamics::MeshShape*>(
+          body->getShapeNode(j)->getShape().get());
+      if (mesh != nullptr)
+        return mesh;
+    }
+  }
+  return nullptr;
+}
+
+TEST(OpenSimParser, SHARED_MESH_REGISTRY)
+{
+  // Make sure each parse goes all the way down to loading the meshes
+  OpenSimParser::setParsedModelCacheEnabled(false);
+
+  auto first = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  auto second = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  dynamics::MeshShape* firstMesh = getFirstMeshShape(first.skeleton);
+  dynamics::MeshShape* secondMesh = getFirstMeshShape(second.skeleton);
+  ASSERT_NE(firstMesh, nullptr);
+  ASSERT_NE(secondMesh, nullptr);
+  EXPECT_NE(firstMesh, secondMesh);
+  EXPECT_EQ(firstMesh->getMesh(), secondMesh->getMesh());
+  EXPECT_GT(dynamics::MeshShape::getNumRegisteredMeshes(), 0u);
+
+  dynamics::MeshShape::setDefaultLoadingMode(dynamics::MeshShape::LAZY);
+  auto lazy = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  dynamics::MeshShape::setDefaultLoadingMode(dynamics::MeshShape::EAGER);
+  dynamics::MeshShape* lazyMesh = getFirstMeshShape(lazy.skeleton);
+  ASSERT_NE(lazyMesh, nullptr);
+  EXPECT_FALSE(lazyMesh->isMeshLoaded());
+  EXPECT_EQ(lazyMesh->getMeshUri(), firstMesh->getMeshUri());
+  EXPECT_EQ(lazyMesh->getMesh(), firstMesh->getMesh());
+  EXPECT_TRUE(lazyMesh->isMeshLoaded());
+
+  dynamics::MeshShape::setDefaultLoadingMode(dynamics::MeshShape::ASYNC);
+  auto async = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  dynamics::MeshShape::setDefaultLoadingMode(dynamics::MeshShape::EAGER);
+  dynamics::MeshShape* asyncMesh = getFirstMeshShape(async.skeleton);
+  ASSERT_NE(asyncMesh, nullptr);
+  EXPECT_EQ(asyncMesh->getMesh(), firstMesh->getMesh());
+  EXPECT_TRUE(equals(
+      asyncMesh->getBoundingBox().getMax(),
+      firstMesh->getBoundingBox().getMax()));
+
+  OpenSimParser::setParsedModelCacheEnabled(true);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(OpenSimParser, PARSE_WITHOUT_GEOMETRY)
+{
+  auto file = OpenSimParser::parseOsimWithoutGeometry(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  EXPECT_EQ(
+      dynamics::MeshShape::getDefaultLoadingMode(), dynamics::MeshShape::EAGER);
+  ASSERT_NE(file.skeleton, nullptr);
+
+  std::vector<const dynamics::MeshShape*> meshes;
+  for (int i = 0; i < file.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = file.skeleton->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      auto* mesh = dynamic_cast<dynamics::MeshShape*>(
+          body->getShapeNode(j)->getShape().get());
+      if (mesh == nullptr)
+        continue;
+      EXPECT_FALSE(mesh->isMeshLoaded());
+      EXPECT_NE(mesh->getMeshUri(), "");
+      meshes.push_back(mesh);
+    }
+  }
+  EXPECT_GT(meshes.size(), 0u);
+
+  // Loading the geometry later gets the same meshes a full parse would
+  dynamics::MeshShape::resolvePendingMeshes(meshes);
+  auto full = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  dynamics::MeshShape* fullMesh = getFirstMeshShape(full.skeleton);
+  ASSERT_NE(fullMesh, nullptr);
+  for (const dynamics::MeshShape* mesh : meshes)
+  {
+    EXPECT_TRUE(mesh->isMeshLoaded());
+    EXPECT_NE(mesh->getMesh(), nullptr);
+  }
+  EXPECT_EQ(meshes[0]->getMeshUri(), fullMesh->getMeshUri());
+  EXPECT_EQ(meshes[0]->getMesh(), fullMesh->getMesh());
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(OpenSimParser, PREFETCHED_MESHES)
+{
+  OpenSimParser::setParsedModelCacheEnabled(false);
+
+  // With the registry off, the meshes are still loaded up front in parallel,
+  // but every shape must end up with its own copy, like a serial load
+  dynamics::MeshShape::setMeshRegistryEnabled(false);
+  auto file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  dynamics::MeshShape::setMeshRegistryEnabled(true);
+  std::set<const aiScene*> scenes;
+  int numMeshes = 0;
+  for (int i = 0; i < file.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = file.skeleton->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      auto* mesh = dynamic_cast<dynamics::MeshShape*>(
+          body->getShapeNode(j)->getShape().get());
+      if (mesh == nullptr)
+        continue;
+      EXPECT_TRUE(mesh->isMeshLoaded());
+      EXPECT_NE(mesh->getMesh(), nullptr);
+      scenes.insert(mesh->getMesh());
+      numMeshes++;
+    }
+  }
+  EXPECT_GT(numMeshes, 0);
+  EXPECT_EQ(static_cast<int>(scenes.size()), numMeshes);
+
+  // loadMeshes() keeps the order it was given, with nullptr for failures
+  const std::string uri = getFirstMeshShape(file.skeleton)->getMeshUri();
+  auto meshes = dynamics::MeshShape::loadMeshes(
+      {uri, "dart://sample/osim/does_not_exist.ply", uri},
+      utils::DartResourceRetriever::create());
+  ASSERT_EQ(meshes.size(), 3u);
+  EXPECT_NE(meshes[0], nullptr);
+  EXPECT_EQ(meshes[1], nullptr);
+  EXPECT_EQ(meshes[0], meshes[2]);
+
+  OpenSimParser::setParsedModelCacheEnabled(true);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(OpenSimParser, CONVERT_TO_MJCF_REFERENCES_MESHES)
+{
+  auto file = OpenSimParser::parseOsim(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+  {
+    dynamics::MeshShape::ScopedLoadingMode lazy(dynamics::MeshShape::LAZY);
+    EXPECT_EQ(
+        dynamics::MeshShape::getDefaultLoadingMode(),
+        dynamics::MeshShape::LAZY);
+    // The cache already has an eagerly loaded copy of this model, but it
+    // still has to hand back one with lazy meshes
+    auto lazyFile = OpenSimParser::parseOsim(
+        "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim");
+    dynamics::MeshShape* lazyMesh = getFirstMeshShape(lazyFile.skeleton);
+    ASSERT_NE(lazyMesh, nullptr);
+    EXPECT_FALSE(lazyMesh->isMeshLoaded());
+  }
+  EXPECT_EQ(
+      dynamics::MeshShape::getDefaultLoadingMode(), dynamics::MeshShape::EAGER);
+  EXPECT_TRUE(getFirstMeshShape(file.skeleton)->isMeshLoaded());
+
+  int numMeshes = 0;
+  for (int i = 0; i < file.skeleton->getNumBodyNodes(); i++)
+  {
+    dynamics::BodyNode* body = file.skeleton->getBodyNode(i);
+    for (int j = 0; j < body->getNumShapeNodes(); j++)
+    {
+      if (body->getShapeNode(j)->getShape()->getType() == "MeshShape")
+        numMeshes++;
+    }
+  }
+
+  std::map<std::string, std::string> mergeBodiesInto;
+  EXPECT_TRUE(OpenSimParser::convertOsimToMJCF(
+      "dart://sample/osim/Rajagopal2015/Rajagopal2015.osim",
+      "./Rajagopal2015.mjcf",
+      mergeBodiesInto));
+
+  // Every body and mesh should have made it into the streamed file
+  tinyxml2::XMLDocument doc;
+  ASSERT_EQ(doc.LoadFile("./Rajagopal2015.mjcf"), tinyxml2::XML_SUCCESS);
+  tinyxml2::XMLElement* mujoco = doc.FirstChildElement("mujoco");
+  ASSERT_NE(mujoco, nullptr);
+
+  int numMeshAssets = 0;
+  for (tinyxml2::XMLElement* mesh
+       = mujoco->FirstChildElement("asset")->FirstChildElement("mesh");
+       mesh != nullptr;
+       mesh = mesh->NextSiblingElement("mesh"))
+  {
+    numMeshAssets++;
+  }
+  EXPECT_EQ(numMeshAssets, numMeshes);
+
+  int numBodies = 0;
+  std::function<void(tinyxml2::XMLElement*)> countBodies
+      = [&](tinyxml2::XMLElement* parent) {
+          for (tinyxml2::XMLElement* body = parent->FirstChildElement("body");
+               body != nullptr;
+               body = body->NextSiblingElement("body"))
+          {
+            numBodies++;
+            countBodies(body);
+          }
+        };
+  countBodies(mujoco->FirstChildElement("worldbody"));
+  EXPECT_EQ(numBodies, file.skeleton->getNumBodyNodes());
+  EXPECT_NE(
+      mujoco->FirstChildElement("actuator")->FirstChildElement("motor"),
+      nullptr);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(OpenSimParser, CONVERT_TO_SDF)
 {
@@ -30,7 +30,11 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <ctime>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #ifdef HAVE_PERF_UTILS
 
@@ -38,6 +42,7 @@
 #include <gtest/gtest.h>
 
 #include "dart/performance/PerformanceLog.hpp"
+#include "dart/performance/SamplingProfiler.hpp"
 
 using namespace dart;
 using namespace dart::performance;
@@ -98,4 +103,182 @@ TEST(PERFORMANCE, NESTED)
   std::cout << finalizedRoot->prettyPrint() << std::endl;
 }
 
+#ifdef LOG_PERFORMANCE
+TEST(PERFORMANCE, MULTITHREADED)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([root]() {
+      for (int i = 0; i < 1000; i++)
+      {
+        PerformanceLog* child = DART_PERF_START_RUN(root, "child");
+        PerformanceLog* grandchild = child->startRun("grandchild");
+        grandchild->end();
+        DART_PERF_END(child);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  std::shared_ptr<FinalizedPerformanceLog> child
+      = finalizedRoots["root"]->getChild("child");
+  EXPECT_EQ(child->getNumRuns(), 4000);
+  EXPECT_EQ(child->getChild("grandchild")->getNumRuns(), 4000);
+}
+
+TEST(PERFORMANCE, INTERNED_NAMES)
+{
+  EXPECT_EQ(DART_PERF_NAME("interned"), PerformanceLog::internName("interned"));
+
+  // Logs from before initialize() are dropped, open ones stay usable
+  PerformanceLog* stale = PerformanceLog::startRoot("stale");
+  PerformanceLog::initialize();
+  stale->end();
+  PerformanceLog* root = PerformanceLog::startRoot(DART_PERF_NAME("fresh"));
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  EXPECT_EQ(finalizedRoots.size(), 1);
+  EXPECT_EQ(finalizedRoots["fresh"]->getNumRuns(), 1);
+}
+
+TEST(PERFORMANCE, CHROME_TRACE)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  std::thread worker([root]() {
+    for (int i = 0; i < 3; i++)
+      root->startRun("child")->end();
+  });
+  worker.join();
+  // Runs that are still open are left out
+  root->startRun("unfinished");
+  root->end();
+
+  std::string trace = PerformanceLog::toChromeTrace();
+  EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+  int numEvents = 0;
+  for (std::size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos;
+       pos = trace.find("\"ph\":\"X\"", pos + 1))
+    numEvents++;
+  EXPECT_EQ(4, numEvents);
+  EXPECT_EQ(std::string::npos, trace.find("unfinished"));
+}
+
+TEST(PERFORMANCE, ALLOCATION_COUNTS)
+{
+  std::vector<std::unique_ptr<int64_t>> values;
+  values.reserve(10);
+
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  PerformanceLog* child = root->startRun("allocating");
+  for (int i = 0; i < 10; i++)
+    values.emplace_back(new int64_t(i));
+  child->end();
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  std::shared_ptr<FinalizedPerformanceLog> finalizedChild
+      = finalizedRoots["root"]->getChild("allocating");
+  if (AllocationCounter::isEnabled())
+  {
+    EXPECT_EQ(finalizedChild->getTotalAllocations(), 10u);
+    EXPECT_EQ(finalizedChild->getTotalAllocatedBytes(), 10 * sizeof(int64_t));
+    EXPECT_GE(finalizedRoots["root"]->getTotalAllocations(), 10u);
+  }
+  else
+  {
+    EXPECT_EQ(finalizedChild->getTotalAllocations(), 0u);
+  }
+}
+
+TEST(PERFORMANCE, HARDWARE_COUNTERS)
+{
+  PerformanceLog::initialize();
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  PerformanceLog* child = root->startRun("looping");
+  volatile int64_t sum = 0;
+  for (int i = 0; i < 100000; i++)
+    sum = sum + i;
+  child->end();
+  root->end();
+
+  std::unordered_map<std::string, std::shared_ptr<FinalizedPerformanceLog>>
+      finalizedRoots = PerformanceLog::finalize();
+  std::shared_ptr<FinalizedPerformanceLog> finalizedRoot
+      = finalizedRoots["root"];
+  if (HardwareCounters::isAvailable())
+  {
+    EXPECT_GE(finalizedRoot->getChild("looping")->getTotalInstructions(), 1e5);
+    EXPECT_GE(
+        finalizedRoot->getTotalInstructions(),
+        finalizedRoot->getChild("looping")->getTotalInstructions());
+  }
+  else
+  {
+    EXPECT_EQ(finalizedRoot->getTotalInstructions(), 0u);
+  }
+
+  std::string json = finalizedRoot->toJson();
+  EXPECT_EQ(0u, json.find("{\"name\":\"root\",\"numRuns\":1,"));
+  EXPECT_NE(
+      std::string::npos, json.find("\"children\":[{\"name\":\"looping\""));
+  EXPECT_EQ(
+      HardwareCounters::isEnabled(),
+      json.find("instructions") != std::string::npos);
+}
+
+#ifdef __linux__
+TEST(PERFORMANCE, SAMPLING_PROFILER)
+{
+  PerformanceLog::initialize();
+  SamplingProfiler::clear();
+  EXPECT_TRUE(SamplingProfiler::start(1000));
+  EXPECT_TRUE(SamplingProfiler::isRunning());
+  EXPECT_FALSE(SamplingProfiler::start(1000));
+
+  // Burn about half a second of CPU inside a nested run. The timer only
+  // fires as often as the kernel ticks, so we may get far fewer than 500
+  // samples.
+  PerformanceLog* root = PerformanceLog::startRoot("root");
+  PerformanceLog* child = root->startRun("spinning");
+  volatile int64_t sum = 0;
+  std::clock_t start = std::clock();
+  while (std::clock() - start < CLOCKS_PER_SEC / 2)
+  {
+    for (int i = 0; i < 10000; i++)
+      sum = sum + i;
+  }
+  child->end();
+  root->end();
+
+  SamplingProfiler::stop();
+  EXPECT_FALSE(SamplingProfiler::isRunning());
+  EXPECT_GT(SamplingProfiler::getNumSamples(), 10u);
+  EXPECT_EQ(SamplingProfiler::getNumDroppedSamples(), 0u);
+
+  std::string folded = SamplingProfiler::getFoldedStacks();
+  std::cout << folded;
+  EXPECT_NE(std::string::npos, folded.find("root;spinning "));
+
+  SamplingProfiler::clear();
+  EXPECT_EQ(SamplingProfiler::getNumSamples(), 0u);
+  EXPECT_EQ(SamplingProfiler::getFoldedStacks(), "");
+}
+#endif
+
+#endif
+
 #endif
\ No newline at end of file
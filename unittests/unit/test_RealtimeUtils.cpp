@@ -30,6 +30,7 @@
  *   POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -197,6 +198,38 @@ TEST(REALTIME, CONTROL_LOG_GET_EMPTY)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, VECTOR_LOG_LONG_SESSION)
+{
+  int dim = 2;
+  VectorLog log = VectorLog(dim);
+  // Enough records and discards to make the log compact and grow its storage
+  for (int i = 0; i < 1000; i++)
+  {
+    log.record(i * 3L, Eigen::VectorXs::Ones(dim) * i);
+    if (i % 97 == 0)
+      log.discardBefore(i * 3L - 100);
+  }
+
+  Eigen::Map<const Eigen::MatrixXs> values
+      = log.getRawValuesBetween(2900L, 2950L);
+  Eigen::Map<const Eigen::Matrix<long, Eigen::Dynamic, 1>> times
+      = log.getRawTimesBetween(2900L, 2950L);
+  ASSERT_EQ(values.cols(), 17);
+  ASSERT_EQ(times.size(), 17);
+  for (int i = 0; i < times.size(); i++)
+  {
+    EXPECT_EQ(times(i), 2901L + i * 3);
+    EXPECT_DOUBLE_EQ(static_cast<double>(values(1, i)), 967.0 + i);
+  }
+
+  Eigen::MatrixXs recent = log.getRecentValuesBefore(2997L, 4);
+  EXPECT_DOUBLE_EQ(static_cast<double>(recent(0, 0)), 995.0);
+  EXPECT_DOUBLE_EQ(static_cast<double>(recent(0, 3)), 998.0);
+  EXPECT_EQ(log.availableStepsBefore(2997L), 62);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_BUFFER)
 {
@@ -439,6 +472,125 @@ TEST(REALTIME, CONTROL_BUFFER_PLAN)
 }
 #endif
 
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_BUFFER_READ_STATS)
+{
+  int forceDim = 3;
+  int steps = 10;
+  int dt = 5;
+  RealTimeControlBuffer buffer = RealTimeControlBuffer(forceDim, steps, dt);
+
+  buffer.setControlForcePlan(0L, 0L, Eigen::MatrixXs::Ones(forceDim, steps));
+  buffer.getPlannedForce(0L);
+  buffer.getPlannedForce(5L);
+  // This read is 3ms late
+  buffer.getPlannedForce(13L);
+  // This read is 1ms early
+  buffer.getPlannedForce(17L);
+  // This runs off the end of the plan
+  buffer.getPlannedForce(50L);
+  // Reads that aren't logged aren't counted
+  buffer.getPlannedForce(20L, true);
+
+  ControlReadStats stats = buffer.getControlReadStats();
+  EXPECT_EQ(stats.numReads, 5);
+  EXPECT_EQ(stats.numPlanUnderruns, 1);
+  EXPECT_EQ(stats.maxJitterMillis, 28);
+  EXPECT_DOUBLE_EQ(static_cast<double>(stats.meanJitterMillis), 32.0 / 4);
+  EXPECT_GE(stats.maxReadNanos, 0);
+
+  buffer.resetControlReadStats();
+  EXPECT_EQ(buffer.getControlReadStats().numReads, 0);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_BUFFER_CONCURRENT_READS)
+{
+  int forceDim = 50;
+  int steps = 10;
+  int dt = 5;
+  RealTimeControlBuffer buffer = RealTimeControlBuffer(forceDim, steps, dt);
+
+  // Every plan we publish is constant, so a read that saw half of one plan
+  // and half of another would show up as a force that isn't constant
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int i = 1; i <= 2000; i++)
+    {
+      buffer.setControlForcePlan(
+          0L, 0L, Eigen::MatrixXs::Constant(forceDim, steps, i));
+    }
+    done = true;
+  });
+
+  // These reads go back and forth in time, so we don't log them
+  long time = 0;
+  while (!done)
+  {
+    Eigen::VectorXs force = buffer.getPlannedForce(time % (steps * dt), true);
+    EXPECT_EQ(force.minCoeff(), force.maxCoeff());
+    time++;
+  }
+  writer.join();
+
+  EXPECT_DOUBLE_EQ(
+      static_cast<double>(buffer.getPlannedForce(0L, true)(0)), 2000);
+}
+#endif
+
+#ifdef ALL_TESTS
+TEST(REALTIME, CONTROL_BUFFER_CONCURRENT_RESIZE)
+{
+  int forceDim = 20;
+  int steps = 10;
+  int maxSteps = 40;
+  int dt = 5;
+  RealTimeControlBuffer buffer
+      = RealTimeControlBuffer(forceDim, steps, dt, maxSteps);
+  EXPECT_EQ(buffer.getMaxSteps(), maxSteps);
+
+  // The writer keeps changing the length of the plan, both by publishing
+  // plans of different lengths and with setNumSteps(), while we read. None of
+  // this should ever reallocate under the reader.
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int i = 1; i <= 2000; i++)
+    {
+      int len = 1 + (i * 7) % maxSteps;
+      buffer.setControlForcePlan(
+          0L, 0L, Eigen::MatrixXs::Constant(forceDim, len, i));
+      buffer.setNumSteps(1 + (i * 13) % maxSteps);
+    }
+    done = true;
+  });
+
+  long time = 0;
+  Eigen::MatrixXs forcesOut = Eigen::MatrixXs::Zero(forceDim, steps);
+  while (!done)
+  {
+    Eigen::VectorXs force
+        = buffer.getPlannedForce(time % (maxSteps * dt), true);
+    EXPECT_EQ(force.minCoeff(), force.maxCoeff());
+    buffer.getPlannedForcesStartingAt(time % (maxSteps * dt), forcesOut);
+    for (int col = 0; col < forcesOut.cols(); col++)
+    {
+      EXPECT_EQ(forcesOut.col(col).minCoeff(), forcesOut.col(col).maxCoeff());
+    }
+    buffer.getPlanBufferMillisAfter(time % (maxSteps * dt));
+    time++;
+  }
+  writer.join();
+
+  // Plans longer than the capacity get cut short
+  buffer.setControlForcePlan(
+      0L, 0L, Eigen::MatrixXs::Constant(forceDim, maxSteps + 10, 3.0));
+  EXPECT_EQ(buffer.getPlanBufferMillisAfter(0L), maxSteps * dt);
+  buffer.setNumSteps(maxSteps + 10);
+  EXPECT_EQ(buffer.getPlanBufferMillisAfter(0L), maxSteps * dt);
+}
+#endif
+
 #ifdef ALL_TESTS
 TEST(REALTIME, CONTROL_BUFFER_ESTIMATE)
 {
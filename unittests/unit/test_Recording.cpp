@@ -0,0 +1,116 @@
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "dart/simulation/Recording.hpp"
+
+using namespace dart;
+using namespace simulation;
+
+//==============================================================================
+// Each frame has two skeletons, with 2 and 3 DOFs, and then frame % 3
+// contacts
+Eigen::VectorXs makeState(int frame)
+{
+  int numContacts = frame % 3;
+  Eigen::VectorXs state(5 + 6 * numContacts);
+  for (int i = 0; i < state.size(); i++)
+    state(i) = frame * 100 + i + 0.25;
+  return state;
+}
+
+//==============================================================================
+void expectFrame(const Recording& recording, int index, int frame)
+{
+  Eigen::VectorXs state = makeState(frame);
+  EXPECT_EQ(recording.getNumContacts(index), frame % 3);
+  EXPECT_EQ(recording.getConfig(index, 0), state.head(2));
+  EXPECT_EQ(recording.getConfig(index, 1), state.segment(2, 3));
+  EXPECT_EQ(recording.getGenCoord(index, 1, 2), state(4));
+  for (int c = 0; c < frame % 3; c++)
+  {
+    EXPECT_EQ(recording.getContactPoint(index, c), state.segment<3>(5 + 6 * c));
+    EXPECT_EQ(
+        recording.getContactForce(index, c), state.segment<3>(8 + 6 * c));
+  }
+}
+
+//==============================================================================
+TEST(Recording, GROWS_WITHOUT_CAPACITY)
+{
+  Recording recording(std::vector<int>{2, 3});
+  for (int frame = 0; frame < 40; frame++)
+    recording.addState(makeState(frame));
+
+  EXPECT_EQ(recording.getNumFrames(), 40);
+  for (int frame = 0; frame < 40; frame++)
+    expectFrame(recording, frame, frame);
+
+  Eigen::VectorXs history = recording.getDofHistory(1, 0);
+  ASSERT_EQ(history.size(), 40);
+  for (int frame = 0; frame < 40; frame++)
+    EXPECT_EQ(history(frame), makeState(frame)(2));
+
+  recording.clear();
+  EXPECT_EQ(recording.getNumFrames(), 0);
+}
+
+//==============================================================================
+TEST(Recording, RING_BUFFER_DROPS_OLDEST)
+{
+  Recording recording(std::vector<int>{2, 3});
+  recording.setCapacity(8);
+  for (int frame = 0; frame < 21; frame++)
+    recording.addState(makeState(frame));
+
+  // Only the last 8 frames are left, and they're re-indexed from 0
+  EXPECT_EQ(recording.getNumFrames(), 8);
+  for (int i = 0; i < 8; i++)
+    expectFrame(recording, i, 13 + i);
+
+  Eigen::VectorXs history = recording.getDofHistory(0, 1);
+  ASSERT_EQ(history.size(), 8);
+  for (int i = 0; i < 8; i++)
+    EXPECT_EQ(history(i), makeState(13 + i)(1));
+}
+
+//==============================================================================
+TEST(Recording, FLOAT32_QUANTIZATION)
+{
+  Recording recording(std::vector<int>{2, 3});
+  recording.setUseFloat32(true);
+  recording.setCapacity(4);
+  EXPECT_TRUE(recording.getUseFloat32());
+  for (int frame = 0; frame < 6; frame++)
+    recording.addState(makeState(frame));
+
+  // These values are all exactly representable as floats
+  EXPECT_EQ(recording.getNumFrames(), 4);
+  for (int i = 0; i < 4; i++)
+    expectFrame(recording, i, 2 + i);
+}
+
+//==============================================================================
+TEST(Recording, SPILLS_EVICTED_FRAMES_TO_DISK)
+{
+  for (bool useFloat32 : {false, true})
+  {
+    std::string path = ::testing::TempDir() + "test_Recording_spill.rec";
+    {
+      Recording recording(std::vector<int>{2, 3});
+      recording.setUseFloat32(useFloat32);
+      recording.setCapacity(5);
+      recording.setSpillFile(path);
+      for (int frame = 0; frame < 23; frame++)
+        recording.addState(makeState(frame));
+
+      // Spilled frames keep their indices, and read back from disk
+      EXPECT_EQ(recording.getNumFrames(), 23);
+      for (int frame = 0; frame < 23; frame++)
+        expectFrame(recording, frame, frame);
+      EXPECT_EQ(recording.getDofHistory(0, 0).size(), 5);
+    }
+    std::remove(path.c_str());
+  }
+}
@@ -3,9 +3,12 @@
 #include "dart/biomechanics/OpenSimParser.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
 #include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BoxShape.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
+#include "dart/dynamics/ShapeNode.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/realtime/Ticker.hpp"
 #include "dart/server/GUIWebsocketServer.hpp"
@@ -53,4 +56,47 @@ TEST(Scaling, SCALE_BODY_NODES)
 
   server.blockWhileServing();
 }
-#endif
\ No newline at end of file
+#endif
+TEST(Scaling, GROUP_SCALES_ONLY_UPDATE_CHANGED_BODIES)
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create();
+  dynamics::BodyNode* parent = nullptr;
+  std::vector<std::shared_ptr<dynamics::BoxShape>> boxes;
+  for (int i = 0; i < 3; i++)
+  {
+    auto pair = skel->createJointAndBodyNodePair<dynamics::RevoluteJoint>(
+        parent);
+    Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+    T.translation() = Eigen::Vector3s(0, 0.5, 0);
+    pair.first->setTransformFromParentBodyNode(T);
+    dynamics::ShapeNode* shapeNode
+        = pair.second->createShapeNodeWith<dynamics::VisualAspect>(
+            std::make_shared<dynamics::BoxShape>(Eigen::Vector3s::Ones()));
+    boxes.push_back(std::static_pointer_cast<dynamics::BoxShape>(
+        shapeNode->getShape()));
+    parent = pair.second;
+  }
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+
+  Eigen::VectorXs scales = skel->getGroupScales();
+  std::vector<std::size_t> versions;
+  for (auto& box : boxes)
+    versions.push_back(box->getVersion());
+
+  // Setting the same scales again shouldn't touch anything
+  skel->setGroupScales(scales);
+  for (int i = 0; i < 3; i++)
+    EXPECT_EQ(boxes[i]->getVersion(), versions[i]);
+
+  // Scaling the middle body only reshapes the middle body, but still moves
+  // everything downstream of it
+  Eigen::Isometry3s tipBefore = skel->getBodyNode(2)->getWorldTransform();
+  scales.segment<3>(3) = Eigen::Vector3s(1.1, 1.2, 1.3);
+  skel->setGroupScales(scales);
+  EXPECT_EQ(boxes[0]->getVersion(), versions[0]);
+  EXPECT_NE(boxes[1]->getVersion(), versions[1]);
+  EXPECT_EQ(boxes[2]->getVersion(), versions[2]);
+  EXPECT_TRUE(boxes[1]->getSize().isApprox(Eigen::Vector3s(1.1, 1.2, 1.3)));
+  EXPECT_FALSE(skel->getBodyNode(2)->getWorldTransform().isApprox(tipBefore));
+  EXPECT_TRUE(scales.isApprox(skel->getGroupScales()));
+}
@@ -0,0 +1,99 @@
+#include <string>
+
+#include <Eigen/Dense>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "dart/realtime/SharedMemoryTransport.hpp"
+
+using namespace dart;
+using namespace realtime;
+
+//==============================================================================
+TEST(SharedMemoryTransport, PLAN_ROUND_TRIP)
+{
+  std::string name = "/nimble_test_" + std::to_string(getpid());
+  std::shared_ptr<SharedMemoryTransport> writer
+      = SharedMemoryTransport::create(name, 3, 5, 2);
+  ASSERT_NE(writer, nullptr);
+  std::shared_ptr<SharedMemoryTransport> reader
+      = SharedMemoryTransport::open(name);
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(reader->getNumDofs(), 3);
+  EXPECT_EQ(reader->getNumSteps(), 5);
+  EXPECT_EQ(reader->getMassDim(), 2);
+
+  long startTime = -1;
+  long duration = -1;
+  Eigen::MatrixXs forces;
+  EXPECT_EQ(reader->readPlan(startTime, duration, forces), 0u);
+
+  Eigen::MatrixXs plan = Eigen::MatrixXs::Random(3, 5);
+  writer->writePlan(1234, 56, plan);
+  EXPECT_EQ(reader->getPlanVersion(), 1u);
+  EXPECT_EQ(reader->readPlan(startTime, duration, forces), 1u);
+  EXPECT_EQ(startTime, 1234);
+  EXPECT_EQ(duration, 56);
+  ASSERT_EQ(forces.rows(), 3);
+  ASSERT_EQ(forces.cols(), 5);
+  for (int i = 0; i < forces.size(); i++)
+  {
+    EXPECT_EQ(forces(i), plan(i));
+  }
+
+  writer->setRunning(true);
+  EXPECT_TRUE(reader->isRunning());
+  reader->setShutdown();
+  EXPECT_TRUE(writer->isShutdown());
+}
+
+//==============================================================================
+TEST(SharedMemoryTransport, RING_KEEPS_NEWEST)
+{
+  std::shared_ptr<SharedMemoryTransport> transport
+      = SharedMemoryTransport::create("", 2, 4, 1, 4);
+  ASSERT_NE(transport, nullptr);
+
+  for (int i = 0; i < 10; i++)
+  {
+    if (i % 2 == 0)
+    {
+      transport->writeState(
+          i,
+          Eigen::VectorXs::Constant(2, i),
+          Eigen::VectorXs::Constant(2, -i),
+          Eigen::VectorXs::Constant(1, 2 * i));
+    }
+    else
+    {
+      transport->writeForce(i, Eigen::VectorXs::Constant(2, 3 * i));
+    }
+  }
+
+  // Only the last 4 fit in the ring
+  std::vector<SharedMemoryObservation> observations
+      = transport->readObservations();
+  ASSERT_EQ(observations.size(), 4u);
+  EXPECT_EQ(transport->getNumDroppedObservations(), 6u);
+  for (int i = 0; i < 4; i++)
+  {
+    const SharedMemoryObservation& observation = observations[i];
+    long time = 6 + i;
+    EXPECT_EQ(observation.time, time);
+    EXPECT_EQ(observation.isForce, time % 2 == 1);
+    if (observation.isForce)
+    {
+      EXPECT_EQ(observation.force(1), 3 * time);
+    }
+    else
+    {
+      EXPECT_EQ(observation.pos(0), time);
+      EXPECT_EQ(observation.vel(1), -time);
+      EXPECT_EQ(observation.mass(0), 2 * time);
+    }
+  }
+
+  EXPECT_EQ(transport->readObservations().size(), 0u);
+  transport->writeForce(10, Eigen::VectorXs::Zero(2));
+  EXPECT_EQ(transport->readObservations().size(), 1u);
+}
@@ -5,6 +5,7 @@
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/FreeJoint.hpp"
 #include "dart/dynamics/Joint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
 #include "dart/dynamics/Skeleton.hpp"
 #include "dart/math/Geometry.hpp"
 #include "dart/realtime/Ticker.hpp"
@@ -1040,4 +1041,65 @@ TEST(SkeletonConverter, RAJAGOPAL)
   server->blockWhileServing();
   */
 }
-#endif
\ No newline at end of file
+#endif
+//==============================================================================
+std::shared_ptr<dynamics::Skeleton> createArm()
+{
+  std::shared_ptr<dynamics::Skeleton> skel = dynamics::Skeleton::create("arm");
+  auto root = skel->createJointAndBodyNodePair<dynamics::FreeJoint>();
+  dynamics::BodyNode* parent = root.second;
+  for (int i = 0; i < 3; i++)
+  {
+    auto pair = skel->createJointAndBodyNodePair<dynamics::RevoluteJoint>(
+        parent);
+    pair.first->setAxis(Eigen::Vector3s::Unit(i % 2 == 0 ? 0 : 2));
+    Eigen::Isometry3s offset = Eigen::Isometry3s::Identity();
+    offset.translation() = Eigen::Vector3s(0, 0.3, 0.05 * i);
+    pair.first->setTransformFromParentBodyNode(offset);
+    parent = pair.second;
+  }
+  return skel;
+}
+
+//==============================================================================
+TEST(SkeletonConverter, PARALLEL_CONVERT_MOTION)
+{
+  std::shared_ptr<dynamics::Skeleton> source = createArm();
+  std::shared_ptr<dynamics::Skeleton> target = createArm();
+  SkeletonConverter converter(source, target);
+  for (int i = 0; i < source->getNumJoints(); i++)
+  {
+    converter.linkJoints(source->getJoint(i), target->getJoint(i));
+  }
+  converter.createVirtualMarkers();
+
+  const int numFrames = 23;
+  Eigen::MatrixXs motion
+      = Eigen::MatrixXs::Zero(target->getNumDofs(), numFrames);
+  for (int t = 0; t < numFrames; t++)
+  {
+    for (int i = 0; i < target->getNumDofs(); i++)
+    {
+      motion(i, t) = 0.3 * sin(0.05 * t * (i + 1) + i);
+    }
+  }
+
+  Eigen::MatrixXs serial = converter.convertMotion(motion, false);
+  Eigen::MatrixXs parallel
+      = converter.convertMotionParallel(motion, 5, 3, false, 1e-4, false);
+  Eigen::MatrixXs linearized
+      = converter.convertMotionParallel(motion, 5, 3, true, 1e-4, false);
+
+  // The skeletons are identical, so a good fit recovers the original motion.
+  // The linearized conversion skips IK on some frames, so it's looser.
+  for (int t = 0; t < numFrames; t++)
+  {
+    Eigen::VectorXs expected = motion.col(t);
+    Eigen::VectorXs serialCol = serial.col(t);
+    Eigen::VectorXs parallelCol = parallel.col(t);
+    Eigen::VectorXs linearizedCol = linearized.col(t);
+    EXPECT_TRUE(equals(serialCol, expected, 1e-3));
+    EXPECT_TRUE(equals(parallelCol, expected, 1e-3));
+    EXPECT_TRUE(equals(linearizedCol, expected, 1e-1));
+  }
+}
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/trajectory/Solution.hpp"
+
+using namespace dart;
+using namespace trajectory;
+
+//==============================================================================
+TEST(SolutionHistory, DEFAULTS_KEEP_EVERYTHING_BUT_JACOBIANS)
+{
+  Solution solution;
+  for (int i = 0; i < 5; i++)
+  {
+    solution.registerX(Eigen::VectorXs::Constant(3, i));
+    solution.registerLoss(i);
+    solution.registerSparseJac(Eigen::VectorXs::Constant(10, i));
+  }
+  EXPECT_EQ(solution.getXs().size(), 5);
+  EXPECT_EQ(solution.getLosses().size(), 5);
+  EXPECT_EQ(solution.getSparseJacobians().size(), 0);
+
+  solution.setHistoryConfig(
+      SolutionHistoryConfig().setRecordSparseJacobians(true));
+  solution.registerSparseJac(Eigen::VectorXs::Constant(10, 5));
+  EXPECT_EQ(solution.getSparseJacobians().size(), 1);
+}
+
+//==============================================================================
+TEST(SolutionHistory, KEEP_LAST_AND_SPILL)
+{
+  std::string path = "./solution_history_spill.gz";
+  std::remove(path.c_str());
+
+  Solution solution;
+  solution.setHistoryConfig(SolutionHistoryConfig()
+                                .setKeepLast(3)
+                                .setKeepEvery(2)
+                                .setSpillPath(path));
+  for (int i = 0; i < 10; i++)
+  {
+    solution.registerX(Eigen::VectorXs::Constant(3, i));
+    solution.registerLoss(i * 0.5);
+  }
+
+  // Every other entry is kept, and only the last 3 of those stay in memory
+  ASSERT_EQ(solution.getXs().size(), 3);
+  EXPECT_EQ(solution.getXs()[0](0), 4);
+  EXPECT_EQ(solution.getXs()[2](0), 8);
+  ASSERT_EQ(solution.getLosses().size(), 3);
+  EXPECT_EQ(solution.getLosses()[0], 2.0);
+
+  // The evicted entries went to disk, in order
+  std::vector<std::pair<int, Eigen::VectorXs>> spilledXs
+      = Solution::loadSpilledHistory(path, Solution::X);
+  ASSERT_EQ(spilledXs.size(), 2);
+  EXPECT_EQ(spilledXs[0].first, 0);
+  EXPECT_EQ(spilledXs[1].first, 2);
+  ASSERT_EQ(spilledXs[1].second.size(), 3);
+  EXPECT_EQ(spilledXs[1].second(0), 2);
+  std::vector<std::pair<int, Eigen::VectorXs>> spilledLosses
+      = Solution::loadSpilledHistory(path, Solution::LOSS);
+  ASSERT_EQ(spilledLosses.size(), 2);
+  EXPECT_EQ(spilledLosses[1].first, 2);
+  ASSERT_EQ(spilledLosses[1].second.size(), 1);
+  EXPECT_EQ(spilledLosses[1].second(0), 1.0);
+  EXPECT_EQ(Solution::loadSpilledHistory(path, Solution::GRADIENT).size(), 0);
+
+  std::remove(path.c_str());
+}
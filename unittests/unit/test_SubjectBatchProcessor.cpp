@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/biomechanics/SubjectBatchProcessor.hpp"
+#include "dart/common/TaskScheduler.hpp"
+
+using namespace dart;
+using namespace biomechanics;
+
+//==============================================================================
+// This stands in for the real pipeline, and keeps track of how much was
+// running at once
+class FakeBatchProcessor : public SubjectBatchProcessor
+{
+public:
+  FakeBatchProcessor(int maxConcurrentSubjects, std::size_t memoryBudgetBytes)
+    : SubjectBatchProcessor(maxConcurrentSubjects, memoryBudgetBytes),
+      mRunning(0),
+      mMaxRunning(0),
+      mMemory(0),
+      mMaxMemory(0)
+  {
+  }
+
+  ~FakeBatchProcessor()
+  {
+    waitForAll();
+  }
+
+  int mRunning;
+  int mMaxRunning;
+  std::size_t mMemory;
+  std::size_t mMaxMemory;
+  std::vector<std::string> mRan;
+
+protected:
+  void runJob(SubjectBatchJob& job) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mFakeMutex);
+      mRunning++;
+      mMemory += job.memoryBytes;
+      mMaxRunning = std::max(mMaxRunning, mRunning);
+      mMaxMemory = std::max(mMaxMemory, mMemory);
+      mRan.push_back(job.name);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    {
+      std::lock_guard<std::mutex> lock(mFakeMutex);
+      mRunning--;
+      mMemory -= job.memoryBytes;
+    }
+    if (job.name == "bad")
+    {
+      throw std::runtime_error("bad subject");
+    }
+  }
+
+  std::mutex mFakeMutex;
+};
+
+//==============================================================================
+SubjectBatchJob makeJob(std::string name, std::size_t memoryBytes)
+{
+  SubjectBatchJob job;
+  job.name = name;
+  job.memoryBytes = memoryBytes;
+  return job;
+}
+
+//==============================================================================
+TEST(SubjectBatchProcessor, RESPECTS_ADMISSION_LIMITS)
+{
+  common::TaskScheduler::setGlobalMaxConcurrency(8);
+
+  FakeBatchProcessor processor(3, 100);
+  std::vector<SubjectBatchProgress> updates;
+  std::mutex updatesMutex;
+  processor.setProgressCallback([&](const SubjectBatchProgress& progress) {
+    std::lock_guard<std::mutex> lock(updatesMutex);
+    updates.push_back(progress);
+  });
+
+  for (int i = 0; i < 10; i++)
+  {
+    processor.enqueue(makeJob("small_" + std::to_string(i), 30));
+  }
+  processor.enqueue(makeJob("bad", 30));
+  // Bigger than the whole budget, so this has to run on its own
+  processor.enqueue(makeJob("huge", 500));
+  processor.waitForAll();
+
+  EXPECT_EQ(processor.mRan.size(), 12);
+  EXPECT_LE(processor.mMaxRunning, 3);
+  EXPECT_GT(processor.mMaxRunning, 1);
+  // The only time we go over budget is the huge job, alone
+  EXPECT_EQ(processor.mMaxMemory, 500);
+
+  SubjectBatchProgress progress = processor.getProgress();
+  EXPECT_EQ(progress.numQueued, 0);
+  EXPECT_EQ(progress.numRunning, 0);
+  EXPECT_EQ(progress.numSucceeded, 11);
+  EXPECT_EQ(progress.numFailed, 1);
+  EXPECT_EQ(progress.memoryInUseBytes, 0);
+  EXPECT_GT(progress.meanSecondsPerSubject, 0);
+
+  // One update when each job starts, and one when it stops
+  std::lock_guard<std::mutex> lock(updatesMutex);
+  EXPECT_EQ(updates.size(), 24);
+  int numFailedUpdates = 0;
+  for (const SubjectBatchProgress& update : updates)
+  {
+    EXPECT_LE(update.memoryInUseBytes, 500);
+    if (update.jobStatus == "failed")
+    {
+      numFailedUpdates++;
+      EXPECT_EQ(update.jobName, "bad");
+      EXPECT_EQ(update.jobError, "bad subject");
+    }
+  }
+  EXPECT_EQ(numFailedUpdates, 1);
+}
+
+//==============================================================================
+TEST(SubjectBatchProcessor, ESTIMATES_MEMORY)
+{
+  SubjectBatchJob small;
+  small.markerTrials.resize(1);
+  small.markerTrials[0].resize(10);
+  SubjectBatchJob big;
+  big.markerTrials.resize(2);
+  for (auto& trial : big.markerTrials)
+  {
+    trial.resize(100);
+    for (auto& timestep : trial)
+    {
+      timestep["marker"] = Eigen::Vector3s::Zero();
+    }
+  }
+  EXPECT_GT(
+      SubjectBatchProcessor::estimateMemoryBytes(big),
+      SubjectBatchProcessor::estimateMemoryBytes(small));
+}
@@ -1,5 +1,7 @@
 #include <memory>
+#include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -10,7 +12,9 @@
 #include "dart/biomechanics/MarkerFitter.hpp"
 #include "dart/biomechanics/MarkerFixer.hpp"
 #include "dart/biomechanics/OpenSimParser.hpp"
+#include "dart/biomechanics/SharedChunkCache.hpp"
 #include "dart/biomechanics/SkeletonConverter.hpp"
+#include "dart/biomechanics/SubjectDataset.hpp"
 #include "dart/biomechanics/SubjectOnDisk.hpp"
 #include "dart/dynamics/BallJoint.hpp"
 #include "dart/dynamics/BodyNode.hpp"
@@ -51,7 +55,8 @@ bool testWriteSubjectToDisk(
     std::vector<std::string> motFiles,
     std::vector<std::string> grfFiles,
     int limitTrialSizes = -1,
-    int trialStartOffset = 0)
+    int trialStartOffset = 0,
+    int formatVersion = 1)
 {
   srand(42);
 
@@ -184,13 +189,19 @@ bool testWriteSubjectToDisk(
       customValueTrials,
       trialNames,
       originalHref,
-      originalNotes);
+      originalNotes,
+      formatVersion);
 
   ////////////////////////////////////////
   // Test reading the subject back in
   ////////////////////////////////////////
 
   SubjectOnDisk subject(outputFilePath);
+  if (subject.getFormatVersion() != formatVersion)
+  {
+    std::cout << "Failed to recover format version!" << std::endl;
+    return false;
+  }
 
   std::shared_ptr<dynamics::Skeleton> skel = subject.readSkel(
       "dart://sample/osim/OpenCapTest/Subject4/Models/Geometry/");
@@ -229,6 +240,93 @@ bool testWriteSubjectToDisk(
     std::vector<std::shared_ptr<biomechanics::Frame>> readResult
         = subject.readFrames(trial, frame, 5);
 
+    // Reading just a couple of channels should see exactly the same data
+    std::vector<Eigen::MatrixXd> window = subject.readChannelWindow(
+        trial, frame, 5, {"pos", "groundContactWrenches", "exo_tau"});
+    if (window.size() != 3 || window[0].cols() != readResult.size())
+    {
+      std::cout << "Channel window has the wrong shape" << std::endl;
+      return false;
+    }
+    for (int f = 0; f < readResult.size(); f++)
+    {
+      Eigen::VectorXd wrenches(6 * readResult[f]->groundContactWrenches.size());
+      for (int b = 0; b < readResult[f]->groundContactWrenches.size(); b++)
+      {
+        wrenches.segment<6>(b * 6)
+            = readResult[f]->groundContactWrenches[b].second;
+      }
+      if (window[0].col(f) != readResult[f]->pos
+          || window[1].col(f) != wrenches
+          || window[2].col(f) != readResult[f]->customValues[0].second)
+      {
+        std::cout << "Channel window doesn't match frame" << std::endl;
+        return false;
+      }
+    }
+
+    // Version 2 files are compressed, so there's nothing to map views into
+    std::vector<biomechanics::FrameView> views
+        = subject.readFrameViews(trial, frame, 5);
+    if (formatVersion != 1)
+    {
+      if (views.size() != 0)
+      {
+        std::cout << "Got frame views from a compressed file" << std::endl;
+        return false;
+      }
+    }
+    else if (views.size() != readResult.size())
+    {
+      std::cout << "Frame views have the wrong length" << std::endl;
+      return false;
+    }
+    for (int f = 0; f < views.size(); f++)
+    {
+      std::shared_ptr<biomechanics::Frame>& copy = readResult[f];
+      biomechanics::FrameView& view = views[f];
+      if (view.trial != copy->trial || view.t != copy->t
+          || view.dt != copy->dt
+          || view.probablyMissingGRF != copy->probablyMissingGRF
+          || view.pos != copy->pos || view.vel != copy->vel
+          || view.acc != copy->acc || view.tau != copy->tau)
+      {
+        std::cout << "Frame view doesn't match frame" << std::endl;
+        return false;
+      }
+      for (int b = 0; b < copy->groundContactWrenches.size(); b++)
+      {
+        if (view.groundContactWrenches.col(b)
+                != copy->groundContactWrenches[b].second
+            || view.groundContactCenterOfPressure.col(b)
+                   != copy->groundContactCenterOfPressure[b].second
+            || view.groundContactTorque.col(b)
+                   != copy->groundContactTorque[b].second
+            || view.groundContactForce.col(b)
+                   != copy->groundContactForce[b].second)
+        {
+          std::cout << "Frame view GRF doesn't match frame" << std::endl;
+          return false;
+        }
+      }
+      for (int b = 0; b < copy->customValues.size(); b++)
+      {
+        if (view.customValues[b] != copy->customValues[b].second)
+        {
+          std::cout << "Frame view custom value doesn't match frame"
+                    << std::endl;
+          return false;
+        }
+      }
+      if (f > 0
+          && (const char*)view.pos.data() - (const char*)views[f - 1].pos.data()
+                 != subject.getFrameSizeBytes())
+      {
+        std::cout << "Frame views aren't evenly strided" << std::endl;
+        return false;
+      }
+    }
+
     for (auto& frame : readResult)
     {
       std::cout << "Checking frame " << frame->trial << ":" << frame->t
@@ -323,6 +421,103 @@ bool testWriteSubjectToDisk(
     }
   }
 
+  // A batch of windows, including one that runs off the end of its trial,
+  // should match reading each window on its own, across threads
+  std::vector<std::pair<int, int>> requests;
+  for (int i = 0; i < 20; i++)
+  {
+    int trial = rand() % subject.getNumTrials();
+    requests.emplace_back(trial, rand() % subject.getTrialLength(trial));
+  }
+  requests.emplace_back(0, subject.getTrialLength(0) - 3);
+  const int windowLen = 10;
+  std::vector<std::string> channels{"pos", "groundContactCopTorqueForce"};
+  std::vector<Eigen::VectorXd> batch;
+  std::vector<double*> outputs;
+  for (const std::string& channel : channels)
+  {
+    batch.push_back(Eigen::VectorXd::Constant(
+        requests.size() * windowLen * subject.getChannelDim(channel), -1));
+    outputs.push_back(batch.back().data());
+  }
+  if (!subject.readWindowsBatch(requests, windowLen, channels, outputs, 4))
+  {
+    std::cout << "Failed to read a batch of windows" << std::endl;
+    return false;
+  }
+  for (int r = 0; r < requests.size(); r++)
+  {
+    std::vector<Eigen::MatrixXd> window = subject.readChannelWindow(
+        requests[r].first, requests[r].second, windowLen, channels);
+    for (int k = 0; k < channels.size(); k++)
+    {
+      const int dim = window[k].rows();
+      Eigen::MatrixXd expected = Eigen::MatrixXd::Zero(dim, windowLen);
+      expected.leftCols(window[k].cols()) = window[k];
+      Eigen::Map<Eigen::MatrixXd> batched(
+          batch[k].data() + r * windowLen * dim, dim, windowLen);
+      if (batched != expected)
+      {
+        std::cout << "Batched window doesn't match window" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  // A FrameBatch should have one row per frame that readFrames() returns,
+  // including when the batch runs off the end of the trial
+  for (int trial = 0; trial < subject.getNumTrials(); trial++)
+  {
+    const int start = std::max(0, subject.getTrialLength(trial) - 5);
+    std::shared_ptr<FrameBatch> frameBatch
+        = subject.readFrameBatch(trial, start, 10);
+    std::vector<std::shared_ptr<Frame>> frames
+        = subject.readFrames(trial, start, 10);
+    if (frameBatch->numFrames != frames.size()
+        || frameBatch->pos.rows() != frames.size())
+    {
+      std::cout << "FrameBatch has the wrong number of frames" << std::endl;
+      return false;
+    }
+    for (int i = 0; i < frames.size(); i++)
+    {
+      std::shared_ptr<Frame> frame = frames[i];
+      if (frameBatch->probablyMissingGRF(i) != frame->probablyMissingGRF
+          || frameBatch->pos.row(i).transpose() != frame->pos
+          || frameBatch->vel.row(i).transpose() != frame->vel
+          || frameBatch->acc.row(i).transpose() != frame->acc
+          || frameBatch->tau.row(i).transpose() != frame->tau)
+      {
+        std::cout << "FrameBatch doesn't match frames" << std::endl;
+        return false;
+      }
+      for (int b = 0; b < frame->groundContactWrenches.size(); b++)
+      {
+        if (frameBatch->groundContactWrenches.block<1, 6>(i, b * 6).transpose()
+                != frame->groundContactWrenches[b].second
+            || frameBatch->groundContactForce.block<1, 3>(i, b * 3).transpose()
+                   != frame->groundContactForce[b].second
+            || frameBatch->groundContactCenterOfPressure
+                       .block<1, 3>(i, b * 3)
+                       .transpose()
+                   != frame->groundContactCenterOfPressure[b].second)
+        {
+          std::cout << "FrameBatch contact doesn't match frames" << std::endl;
+          return false;
+        }
+      }
+      for (int b = 0; b < frame->customValues.size(); b++)
+      {
+        if (frameBatch->customValues[b].row(i).transpose()
+            != frame->customValues[b].second)
+        {
+          std::cout << "FrameBatch custom value doesn't match" << std::endl;
+          return false;
+        }
+      }
+    }
+  }
+
   return true;
 }
 
@@ -355,4 +550,339 @@ TEST(SubjectOnDisk, WRITE_THEN_READ)
       "unscaled_generic.osim",
       motFiles,
       grfFiles));
-}
\ No newline at end of file
+}
+TEST(SubjectOnDisk, WRITE_THEN_READ_V2)
+{
+  std::vector<std::string> trialNames;
+  trialNames.push_back("DJ5");
+  trialNames.push_back("walking2");
+
+  std::vector<std::string> motFiles;
+  std::vector<std::string> grfFiles;
+
+  for (std::string& name : trialNames)
+  {
+    motFiles.push_back(
+        "dart://sample/grf/OpenCapUnfiltered/IK/" + name + "_ik.mot");
+    grfFiles.push_back(
+        "dart://sample/grf/OpenCapUnfiltered/ID/" + name + "_grf.mot");
+  }
+
+  std::string path = "./testSubjectV2.bin";
+
+  EXPECT_TRUE(testWriteSubjectToDisk(
+      path,
+      "dart://sample/osim/OpenCapTest/Subject4/Models/"
+      "unscaled_generic.osim",
+      motFiles,
+      grfFiles,
+      -1,
+      0,
+      2));
+}
+
+TEST(SubjectOnDisk, DATASET_PREFETCH)
+{
+  std::vector<std::string> motFiles;
+  std::vector<std::string> grfFiles;
+  motFiles.push_back("dart://sample/grf/OpenCapUnfiltered/IK/DJ5_ik.mot");
+  grfFiles.push_back("dart://sample/grf/OpenCapUnfiltered/ID/DJ5_grf.mot");
+
+  std::string path = "./testSubjectDataset.bin";
+  EXPECT_TRUE(testWriteSubjectToDisk(
+      path,
+      "dart://sample/osim/OpenCapTest/Subject4/Models/"
+      "unscaled_generic.osim",
+      motFiles,
+      grfFiles,
+      -1,
+      0,
+      2));
+
+  SubjectOnDisk subject(path);
+  std::vector<std::string> channels{"pos", "groundContactWrenches"};
+  const int windowLen = 50;
+  std::vector<std::string> paths{path, path};
+  // Make the cache small enough to only hold a few chunks, so it has to evict
+  const std::size_t chunkBytes = subject.getChunkFrames(0)
+                                 * (subject.getNumDofs() + 12) * sizeof(double);
+  const std::size_t budget = 3 * chunkBytes;
+  SubjectDataset dataset(paths, windowLen, channels, 2, budget);
+
+  std::vector<SubjectDataset::WindowRequest> requests;
+  for (int i = 0; i < 30; i++)
+  {
+    requests.emplace_back(
+        rand() % 2, 0, rand() % subject.getTrialLength(0));
+  }
+  dataset.prefetch(requests);
+
+  for (SubjectDataset::WindowRequest& request : requests)
+  {
+    std::vector<Eigen::MatrixXd> window = dataset.readWindow(request);
+    std::vector<Eigen::MatrixXd> expected = subject.readChannelWindow(
+        request.trial, request.startFrame, windowLen, channels);
+    ASSERT_EQ(window.size(), channels.size());
+    for (int k = 0; k < channels.size(); k++)
+    {
+      EXPECT_EQ(window[k].cols(), windowLen);
+      EXPECT_TRUE(window[k].leftCols(expected[k].cols()) == expected[k]);
+      EXPECT_TRUE(window[k].rightCols(windowLen - expected[k].cols()).isZero());
+    }
+  }
+  EXPECT_GT(dataset.getNumCacheHits() + dataset.getNumCacheMisses(), 0);
+  EXPECT_LE(dataset.getCacheSizeBytes(), budget);
+}
+
+TEST(SubjectOnDisk, DATASET_SHARED_CACHE)
+{
+  std::vector<std::string> motFiles;
+  std::vector<std::string> grfFiles;
+  motFiles.push_back("dart://sample/grf/OpenCapUnfiltered/IK/DJ5_ik.mot");
+  grfFiles.push_back("dart://sample/grf/OpenCapUnfiltered/ID/DJ5_grf.mot");
+
+  std::string path = "./testSubjectSharedCache.bin";
+  EXPECT_TRUE(testWriteSubjectToDisk(
+      path,
+      "dart://sample/osim/OpenCapTest/Subject4/Models/"
+      "unscaled_generic.osim",
+      motFiles,
+      grfFiles,
+      -1,
+      0,
+      2));
+
+  // Two datasets opening the same segment stand in for two worker processes
+  const std::string name = "/nimble_test_shared_chunk_cache";
+  SharedChunkCache::unlink(name);
+  std::shared_ptr<SharedChunkCache> first
+      = std::make_shared<SharedChunkCache>(name, 16 << 20, 1 << 20);
+  std::shared_ptr<SharedChunkCache> second
+      = std::make_shared<SharedChunkCache>(name);
+  ASSERT_TRUE(first->isOpen());
+  ASSERT_TRUE(second->isOpen());
+  EXPECT_EQ(second->getNumSlots(), first->getNumSlots());
+
+  std::vector<std::string> channels{"pos", "groundContactWrenches"};
+  const int windowLen = 50;
+  std::vector<std::string> paths{path};
+  SubjectDataset writer(paths, windowLen, channels, 1);
+  SubjectDataset reader(paths, windowLen, channels, 1);
+  writer.setSharedCache(first);
+  reader.setSharedCache(second);
+
+  SubjectOnDisk subject(path);
+  for (int startFrame = 0; startFrame < subject.getTrialLength(0);
+       startFrame += windowLen)
+  {
+    SubjectDataset::WindowRequest request(0, 0, startFrame);
+    std::vector<Eigen::MatrixXd> written = writer.readWindow(request);
+    const uint64_t hits = first->getNumHits();
+    std::vector<Eigen::MatrixXd> read = reader.readWindow(request);
+    // Everything the reader needed was already decoded by the writer
+    EXPECT_GT(first->getNumHits(), hits);
+    ASSERT_EQ(read.size(), written.size());
+    for (int k = 0; k < read.size(); k++)
+    {
+      EXPECT_TRUE(read[k] == written[k]);
+    }
+  }
+
+  EXPECT_TRUE(SharedChunkCache::unlink(name));
+}
+
+TEST(SubjectOnDisk, STREAMING_WRITER)
+{
+  std::vector<std::string> groundForceBodies{"calcn_r", "calcn_l"};
+  std::vector<std::string> customValueNames{"exo_tau"};
+  std::vector<int> customValueDims{3};
+  std::vector<int> trialLengths{250, 0, 117};
+  const int dofs = 5;
+
+  std::string path = "./testSubjectStreaming.bin";
+  std::vector<std::vector<biomechanics::Frame>> written;
+  {
+    SubjectWriter writer(
+        path,
+        "dart://sample/osim/OpenCapTest/Subject4/Models/"
+        "unscaled_generic.osim",
+        groundForceBodies,
+        customValueNames,
+        customValueDims,
+        "href",
+        "notes");
+
+    for (int trial = 0; trial < trialLengths.size(); trial++)
+    {
+      writer.startTrial("trial_" + std::to_string(trial), 0.01);
+      written.emplace_back();
+      for (int t = 0; t < trialLengths[trial]; t++)
+      {
+        biomechanics::Frame frame;
+        frame.pos = Eigen::VectorXd::Random(dofs);
+        frame.vel = Eigen::VectorXd::Random(dofs);
+        frame.acc = Eigen::VectorXd::Random(dofs);
+        frame.tau = Eigen::VectorXd::Random(dofs);
+        frame.probablyMissingGRF = t % 10 == 0;
+        Eigen::VectorXs wrenches = Eigen::VectorXs::Random(12);
+        Eigen::VectorXs copTorqueForce = Eigen::VectorXs::Random(18);
+        std::vector<Eigen::VectorXs> custom{Eigen::VectorXs::Random(3)};
+        EXPECT_TRUE(writer.appendFrame(
+            frame.pos,
+            frame.vel,
+            frame.acc,
+            frame.tau,
+            wrenches,
+            copTorqueForce,
+            custom,
+            frame.probablyMissingGRF));
+        for (int b = 0; b < 2; b++)
+        {
+          frame.groundContactWrenches.emplace_back(
+              groundForceBodies[b], wrenches.segment<6>(b * 6));
+          frame.groundContactForce.emplace_back(
+              groundForceBodies[b], copTorqueForce.segment<3>(b * 9 + 6));
+        }
+        frame.customValues.emplace_back("exo_tau", custom[0]);
+        written.back().push_back(frame);
+      }
+      // Frames with the wrong sizes get skipped
+      EXPECT_FALSE(writer.appendFrame(
+          Eigen::VectorXs::Zero(dofs + 1),
+          Eigen::VectorXs::Zero(dofs),
+          Eigen::VectorXs::Zero(dofs),
+          Eigen::VectorXs::Zero(dofs),
+          Eigen::VectorXs::Zero(12),
+          Eigen::VectorXs::Zero(18),
+          {Eigen::VectorXs::Zero(3)},
+          false));
+    }
+    writer.close();
+  }
+
+  SubjectOnDisk subject(path);
+  EXPECT_EQ(subject.getFormatVersion(), 2);
+  EXPECT_EQ(subject.getNumDofs(), dofs);
+  EXPECT_EQ(subject.getNumTrials(), trialLengths.size());
+  EXPECT_EQ(subject.getHref(), "href");
+  EXPECT_EQ(subject.getNotes(), "notes");
+  for (int trial = 0; trial < trialLengths.size(); trial++)
+  {
+    EXPECT_EQ(subject.getTrialLength(trial), trialLengths[trial]);
+    EXPECT_EQ(subject.getTrialName(trial), "trial_" + std::to_string(trial));
+    std::vector<std::shared_ptr<biomechanics::Frame>> frames
+        = subject.readFrames(trial, 0, trialLengths[trial]);
+    ASSERT_EQ(frames.size(), trialLengths[trial]);
+    for (int t = 0; t < frames.size(); t++)
+    {
+      biomechanics::Frame& original = written[trial][t];
+      EXPECT_TRUE(frames[t]->pos == original.pos);
+      EXPECT_TRUE(frames[t]->vel == original.vel);
+      EXPECT_TRUE(frames[t]->acc == original.acc);
+      EXPECT_TRUE(frames[t]->tau == original.tau);
+      EXPECT_EQ(frames[t]->probablyMissingGRF, original.probablyMissingGRF);
+      for (int b = 0; b < 2; b++)
+      {
+        EXPECT_TRUE(
+            frames[t]->groundContactWrenches[b].second
+            == original.groundContactWrenches[b].second);
+        EXPECT_TRUE(
+            frames[t]->groundContactForce[b].second
+            == original.groundContactForce[b].second);
+      }
+      EXPECT_TRUE(
+          frames[t]->customValues[0].second
+          == original.customValues[0].second);
+    }
+  }
+}
+
+TEST(SubjectOnDisk, CHANNEL_STATS_AND_SHUFFLED_INDEX)
+{
+  std::vector<std::string> groundForceBodies;
+  std::vector<std::string> customValueNames;
+  std::vector<int> customValueDims;
+  std::vector<int> trialLengths{150, 80};
+  const int dofs = 4;
+
+  std::string path = "./testSubjectStats.bin";
+  Eigen::MatrixXd allPoses(dofs, 150 + 80);
+  {
+    SubjectWriter writer(
+        path,
+        "dart://sample/osim/OpenCapTest/Subject4/Models/"
+        "unscaled_generic.osim",
+        groundForceBodies,
+        customValueNames,
+        customValueDims);
+    int frame = 0;
+    for (int trial = 0; trial < trialLengths.size(); trial++)
+    {
+      writer.startTrial("trial_" + std::to_string(trial), 0.01);
+      for (int t = 0; t < trialLengths[trial]; t++)
+      {
+        Eigen::VectorXs pos = Eigen::VectorXs::Random(dofs)
+                              + Eigen::VectorXs::Constant(dofs, 3);
+        allPoses.col(frame++) = pos;
+        EXPECT_TRUE(writer.appendFrame(
+            pos,
+            Eigen::VectorXs::Zero(dofs),
+            Eigen::VectorXs::Zero(dofs),
+            Eigen::VectorXs::Zero(dofs),
+            Eigen::VectorXs::Zero(0),
+            Eigen::VectorXs::Zero(0),
+            std::vector<Eigen::VectorXs>(),
+            t % 10 == 0));
+      }
+    }
+    writer.close();
+  }
+
+  SubjectOnDisk subject(path);
+  EXPECT_TRUE(subject.hasStoredChannelStats());
+  ChannelStats stats = subject.getChannelStats("pos");
+  Eigen::VectorXd mean = allPoses.rowwise().mean();
+  Eigen::VectorXd variance
+      = (allPoses.colwise() - mean).array().square().rowwise().mean();
+  EXPECT_TRUE(stats.count == Eigen::VectorXd::Constant(dofs, 230));
+  EXPECT_TRUE(equals(stats.mean, mean, 1e-12));
+  EXPECT_TRUE(equals(stats.getVariance(), variance, 1e-12));
+  EXPECT_EQ(subject.getChannelStats("not_a_channel").count.size(), 0);
+
+  // Merging the same file twice gives the same mean and variance
+  std::vector<std::string> paths{path, path};
+  std::vector<std::string> channels{"pos", "vel"};
+  SubjectDataset dataset(paths, 10, channels, 1);
+  std::vector<ChannelStats> merged = dataset.getChannelStats(2);
+  ASSERT_EQ(merged.size(), 2);
+  EXPECT_TRUE(merged[0].count == Eigen::VectorXd::Constant(dofs, 460));
+  EXPECT_TRUE(equals(merged[0].mean, mean, 1e-12));
+  EXPECT_TRUE(equals(merged[0].getVariance(), variance, 1e-12));
+  EXPECT_TRUE(merged[1].getStd().isZero());
+
+  std::vector<SubjectDataset::WindowRequest> index
+      = dataset.getShuffledIndex(42);
+  EXPECT_EQ(index.size(), 460);
+  std::vector<SubjectDataset::WindowRequest> again
+      = dataset.getShuffledIndex(42);
+  ASSERT_EQ(again.size(), index.size());
+  std::set<std::tuple<int, int, int>> seen;
+  for (int i = 0; i < index.size(); i++)
+  {
+    EXPECT_EQ(index[i].subject, again[i].subject);
+    EXPECT_EQ(index[i].trial, again[i].trial);
+    EXPECT_EQ(index[i].startFrame, again[i].startFrame);
+    seen.emplace(index[i].subject, index[i].trial, index[i].startFrame);
+  }
+  EXPECT_EQ(seen.size(), index.size());
+
+  // Every 10th frame is flagged as missing GRF, so with a stride of 5 only
+  // the odd multiples of 5 are left
+  std::vector<SubjectDataset::WindowRequest> strided
+      = dataset.getShuffledIndex(7, 5, true);
+  EXPECT_EQ(strided.size(), 2 * (15 + 8));
+  for (const SubjectDataset::WindowRequest& request : strided)
+  {
+    EXPECT_EQ(request.startFrame % 10, 5);
+  }
+}
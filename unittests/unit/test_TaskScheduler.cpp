@@ -0,0 +1,92 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dart/common/TaskScheduler.hpp"
+
+using namespace dart;
+
+//==============================================================================
+int parallelFib(common::TaskScheduler& scheduler, int n)
+{
+  if (n < 12)
+  {
+    if (n < 2)
+    {
+      return n;
+    }
+    return parallelFib(scheduler, n - 1) + parallelFib(scheduler, n - 2);
+  }
+  common::TaskFuture<int> a = scheduler.async(
+      [&scheduler, n]() { return parallelFib(scheduler, n - 1); });
+  int b = parallelFib(scheduler, n - 2);
+  return a.get() + b;
+}
+
+//==============================================================================
+TEST(TaskScheduler, NESTED_TASKS_DONT_DEADLOCK)
+{
+  // Far more nested waits than there are threads, which would deadlock a
+  // plain thread pool
+  common::TaskScheduler scheduler(2);
+  EXPECT_EQ(parallelFib(scheduler, 22), 17711);
+
+  std::vector<common::TaskFuture<int>> outer;
+  for (int i = 0; i < 50; i++)
+  {
+    outer.push_back(scheduler.async([&scheduler, i]() {
+      std::vector<common::TaskFuture<int>> inner;
+      for (int j = 0; j < 20; j++)
+      {
+        inner.push_back(scheduler.async([i, j]() { return i * j; }));
+      }
+      int total = 0;
+      for (int j = 0; j < inner.size(); j++)
+      {
+        total += inner[j].get();
+      }
+      return total;
+    }));
+  }
+  for (int i = 0; i < outer.size(); i++)
+  {
+    EXPECT_EQ(outer[i].get(), i * 190);
+  }
+}
+
+//==============================================================================
+int addThree(int a, const std::vector<int>& b, std::unique_ptr<int> c)
+{
+  return a + b.size() + *c;
+}
+
+//==============================================================================
+TEST(TaskScheduler, ARGUMENTS_AND_EXCEPTIONS)
+{
+  std::vector<int> b{1, 2, 3};
+  common::TaskFuture<int> sum
+      = common::async(addThree, 4, b, std::unique_ptr<int>(new int(10)));
+  EXPECT_EQ(sum.get(), 17);
+
+  int x = 0;
+  common::TaskFuture<void> assign
+      = common::async([](int& out) { out = 5; }, std::ref(x));
+  assign.get();
+  EXPECT_EQ(x, 5);
+
+  common::TaskFuture<int> throws
+      = common::async([]() -> int { throw std::runtime_error("oops"); });
+  EXPECT_THROW(throws.get(), std::runtime_error);
+}
+
+//==============================================================================
+TEST(TaskScheduler, RESIZE)
+{
+  common::TaskScheduler scheduler(3);
+  EXPECT_EQ(scheduler.getMaxConcurrency(), 3);
+  scheduler.setMaxConcurrency(1);
+  EXPECT_EQ(scheduler.getMaxConcurrency(), 1);
+  EXPECT_EQ(parallelFib(scheduler, 18), 2584);
+}
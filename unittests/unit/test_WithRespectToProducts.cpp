@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include "dart/dynamics/BallJoint.hpp"
+#include "dart/dynamics/BodyNode.hpp"
+#include "dart/dynamics/FreeJoint.hpp"
+#include "dart/dynamics/RevoluteJoint.hpp"
+#include "dart/dynamics/Skeleton.hpp"
+#include "dart/neural/WithRespectTo.hpp"
+#include "dart/neural/WithRespectToMass.hpp"
+
+#include "TestHelpers.hpp"
+
+using namespace dart;
+using namespace dynamics;
+using namespace neural;
+
+//==============================================================================
+template <typename JointType>
+BodyNode* addBody(const SkeletonPtr& skel, BodyNode* parent, s_t mass)
+{
+  auto pair = skel->createJointAndBodyNodePair<JointType>(parent);
+  Eigen::Isometry3s T = Eigen::Isometry3s::Identity();
+  T.translation() = Eigen::Vector3s(0.1, 0.3, -0.2);
+  pair.first->setTransformFromParentBodyNode(T);
+  pair.second->setInertia(
+      dynamics::Inertia(mass, 0.05, -0.1, 0.02, 0.3, 0.2, 0.25, 0.01, 0.02, -0.01));
+  return pair.second;
+}
+
+//==============================================================================
+SkeletonPtr createSkeleton()
+{
+  SkeletonPtr skel = Skeleton::create("arm");
+  BodyNode* root = addBody<FreeJoint>(skel, nullptr, 2.0);
+  BodyNode* upper = addBody<RevoluteJoint>(skel, root, 1.5);
+  addBody<BallJoint>(skel, upper, 0.7);
+  addBody<RevoluteJoint>(skel, root, 1.1);
+
+  skel->setPositions(Eigen::VectorXs::Random(skel->getNumDofs()));
+  skel->setVelocities(Eigen::VectorXs::Random(skel->getNumDofs()));
+  return skel;
+}
+
+//==============================================================================
+// This checks vjp() and jvp() against `dense`, the full Jacobian of the inverse
+// dynamics at `ddq`
+void expectProductsMatchJacobian(
+    const SkeletonPtr& skel,
+    WithRespectTo* wrt,
+    const Eigen::VectorXs& ddq,
+    const Eigen::MatrixXs& dense,
+    s_t threshold)
+{
+  Eigen::VectorXs v = Eigen::VectorXs::Random(skel->getNumDofs());
+  Eigen::VectorXs dp = Eigen::VectorXs::Random(wrt->dim(skel.get()));
+
+  Eigen::VectorXs oldAccelerations = skel->getAccelerations();
+  Eigen::VectorXs vjp = wrt->vjp(skel.get(), ddq, v);
+  Eigen::VectorXs jvp = wrt->jvp(skel.get(), ddq, dp);
+  // The products leave the skeleton's accelerations alone
+  EXPECT_TRUE(equals(skel->getAccelerations(), oldAccelerations, 0.0));
+
+  Eigen::VectorXs expectedVjp = dense.transpose() * v;
+  Eigen::VectorXs expectedJvp = dense * dp;
+  EXPECT_TRUE(equals(vjp, expectedVjp, threshold));
+  EXPECT_TRUE(equals(jvp, expectedJvp, threshold));
+}
+
+//==============================================================================
+TEST(WithRespectToProducts, GROUP_PARAMETERS_MATCH_DENSE_JACOBIAN)
+{
+  SkeletonPtr skel = createSkeleton();
+  Eigen::VectorXs ddq = Eigen::VectorXs::Random(skel->getNumDofs());
+  for (WithRespectTo* wrt : std::vector<WithRespectTo*>{
+           WithRespectTo::GROUP_MASSES,
+           WithRespectTo::LINEARIZED_MASSES,
+           WithRespectTo::GROUP_COMS,
+           WithRespectTo::GROUP_INERTIAS})
+  {
+    Eigen::MatrixXs dense = skel->getJacobianOfID(ddq, wrt);
+    expectProductsMatchJacobian(skel, wrt, ddq, dense, 1e-8);
+  }
+}
+
+//==============================================================================
+TEST(WithRespectToProducts, REGISTERED_MASSES_MATCH_FINITE_DIFFERENCES)
+{
+  SkeletonPtr skel = createSkeleton();
+  WithRespectToMass wrt;
+  Eigen::VectorXs bound1 = Eigen::VectorXs::Constant(1, 10);
+  Eigen::VectorXs bound3 = Eigen::VectorXs::Constant(3, 10);
+  Eigen::VectorXs bound10 = Eigen::VectorXs::Constant(10, 10);
+  wrt.registerNode(skel->getBodyNode(0), INERTIA_MASS, bound1, -bound1);
+  wrt.registerNode(skel->getBodyNode(1), INERTIA_COM, bound3, -bound3);
+  wrt.registerNode(skel->getBodyNode(1), INERTIA_DIAGONAL, bound3, -bound3);
+  wrt.registerNode(skel->getBodyNode(2), INERTIA_OFF_DIAGONAL, bound3, -bound3);
+  wrt.registerNode(skel->getBodyNode(3), INERTIA_FULL, bound10, -bound10);
+
+  // The dense Jacobian falls back to finite differences for this WRT
+  Eigen::VectorXs ddq = Eigen::VectorXs::Random(skel->getNumDofs());
+  Eigen::MatrixXs fd = skel->getJacobianOfID(ddq, &wrt);
+  expectProductsMatchJacobian(skel, &wrt, ddq, fd, 1e-6);
+}